@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2015-2020, NVIDIA CORPORATION.  All rights reserved.
+ * Copyright (c) 2015-2021, NVIDIA CORPORATION.  All rights reserved.
  *
  * This software is licensed under the terms of the GNU General Public
  * License version 2, as published by the Free Software Foundation, and
@@ -199,11 +199,22 @@ int vblk_ioctl(struct block_device *bdev, fmode_t mode,
 	int ret;
 	struct vblk_dev *vblkdev = bdev->bd_disk->private_data;
 
+	/*
+	 * SCSI commands are tagged like any other block request, each one
+	 * gets its own vsc request and mempool slot for its whole lifetime,
+	 * so they can be outstanding up to the queue depth of the server.
+	 */
+	if (cmd == SG_IO)
+		return vblk_submit_ioctl_req(bdev, cmd, (void __user *)arg);
+
+	/*
+	 * MMC command sequences and UFS queries act on device state shared
+	 * by all of them, the native drivers serialize those as well.
+	 */
 	mutex_lock(&vblkdev->ioctl_lock);
 	switch (cmd) {
 	case MMC_IOC_MULTI_CMD:
 	case MMC_IOC_CMD:
-	case SG_IO:
 		ret = vblk_submit_ioctl_req(bdev, cmd,
 			(void __user *)arg);
 		break;
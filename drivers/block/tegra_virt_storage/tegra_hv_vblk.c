@@ -40,35 +40,21 @@
 #include <linux/dma-mapping.h>
 #include <asm/cacheflush.h>
 #include <linux/version.h>
+#include <linux/sizes.h>
 #include "tegra_vblk.h"
 
 static int vblk_major;
 
-/**
- * vblk_get_req: Get a handle to free vsc request.
+/*
+ * The data of a request is copied through the mempool. Large I/O is
+ * split into requests of at most this size, so that the copy of one
+ * chunk overlaps with the server processing the previous one instead
+ * of the whole transfer being copied before the server sees any of it.
  */
-static struct vsc_request *vblk_get_req(struct vblk_dev *vblkdev)
-{
-	struct vsc_request *req = NULL;
-	unsigned long bit;
-
-	mutex_lock(&vblkdev->req_lock);
-
-	if (vblkdev->queue_state != VBLK_QUEUE_ACTIVE)
-		goto exit;
-
-	bit = find_first_zero_bit(vblkdev->pending_reqs, vblkdev->max_requests);
-	if (bit < vblkdev->max_requests) {
-		req = &vblkdev->reqs[bit];
-		req->vs_req.req_id = bit;
-		set_bit(bit, vblkdev->pending_reqs);
-		vblkdev->inflight_reqs++;
-	}
-
-exit:
-	mutex_unlock(&vblkdev->req_lock);
-	return req;
-}
+static unsigned int max_io_chunk_kb = 128;
+module_param(max_io_chunk_kb, uint, 0444);
+MODULE_PARM_DESC(max_io_chunk_kb,
+	"Split I/O larger than this into pipelined requests, 0 for the server limit");
 
 static struct vsc_request *vblk_get_req_by_sr_num(struct vblk_dev *vblkdev,
 		uint32_t num)
@@ -78,68 +64,18 @@ static struct vsc_request *vblk_get_req_by_sr_num(struct vblk_dev *vblkdev,
 	if (num >= vblkdev->max_requests)
 		return NULL;
 
-	mutex_lock(&vblkdev->req_lock);
+	/* Assuming serial number is same as the tag of the request */
 	req = &vblkdev->reqs[num];
-	if (test_bit(req->id, vblkdev->pending_reqs) == 0) {
+	if (req->req == NULL) {
 		dev_err(vblkdev->device,
 			"sr_num: Request index %d is not active!\n",
 			req->id);
 		req = NULL;
 	}
-	mutex_unlock(&vblkdev->req_lock);
 
-	/* Assuming serial number is same as index into request array */
 	return req;
 }
 
-/**
- * vblk_put_req: Free an active vsc request.
- */
-static void vblk_put_req(struct vsc_request *req)
-{
-	struct vblk_dev *vblkdev;
-
-	vblkdev = req->vblkdev;
-	if (vblkdev == NULL) {
-		pr_err("Request %d does not have valid vblkdev!\n",
-				req->id);
-		return;
-	}
-
-	if (req->id >= vblkdev->max_requests) {
-		dev_err(vblkdev->device, "Request Index %d out of range!\n",
-				req->id);
-		return;
-	}
-
-	mutex_lock(&vblkdev->req_lock);
-	if (req != &vblkdev->reqs[req->id]) {
-		dev_err(vblkdev->device,
-			"Request Index %d does not match with the request!\n",
-				req->id);
-		goto exit;
-	}
-
-	if (test_bit(req->id, vblkdev->pending_reqs) == 0) {
-		dev_err(vblkdev->device,
-			"Request index %d is not active!\n",
-			req->id);
-	} else {
-		clear_bit(req->id, vblkdev->pending_reqs);
-		memset(&req->vs_req, 0, sizeof(struct vs_request));
-		req->req = NULL;
-		memset(&req->iter, 0, sizeof(struct req_iterator));
-		vblkdev->inflight_reqs--;
-
-		if ((vblkdev->inflight_reqs == 0) &&
-			(vblkdev->queue_state == VBLK_QUEUE_SUSPENDED)) {
-			complete(&vblkdev->req_queue_empty);
-		}
-	}
-exit:
-	mutex_unlock(&vblkdev->req_lock);
-}
-
 static int vblk_send_config_cmd(struct vblk_dev *vblkdev)
 {
 	struct vs_request *vs_req;
@@ -223,26 +159,29 @@ static void req_error_handler(struct vblk_dev *vblkdev, struct request *breq)
 		(blk_rq_pos(breq) * (uint64_t)SECTOR_SIZE),
 		(uint64_t)req_op(breq),
 		blk_rq_bytes(breq));
+}
 
-	blk_end_request_all(breq, -EIO);
+static void vblk_end_request(struct request *breq, int error)
+{
+#if LINUX_VERSION_CODE >= KERNEL_VERSION(4,14,0)
+	blk_mq_end_request(breq, errno_to_blk_status(error));
+#else
+	blk_mq_end_request(breq, error);
+#endif
 }
 
 /**
- * complete_bio_req: Complete a bio request after server is
- *		done processing the request.
+ * complete_bio_req: Pick up the response of the server for a request
+ *		and hand the request over to the blk-mq completion.
  */
 
 static bool complete_bio_req(struct vblk_dev *vblkdev)
 {
 	int status = 0;
-	struct bio_vec bvec;
-	size_t size;
-	size_t total_size = 0;
 	struct vsc_request *vsc_req = NULL;
 	struct vs_request *vs_req;
 	struct vs_request *req_resp;
 	struct request *bio_req;
-	void *buffer;
 
 	if (!tegra_hv_ivc_can_read(vblkdev->ivck))
 		goto no_valid_io;
@@ -270,87 +209,26 @@ static bool complete_bio_req(struct vblk_dev *vblkdev)
 	bio_req = vsc_req->req;
 	vs_req = &vsc_req->vs_req;
 
-	if ((bio_req != NULL) && (status == 0)) {
+	if (status != 0) {
+		status = -EIO;
 #if LINUX_VERSION_CODE >= KERNEL_VERSION(4,14,0)
-		if (req_op(bio_req) == REQ_OP_DRV_IN) {
+	} else if (req_op(bio_req) == REQ_OP_DRV_IN) {
 #else
-		if (bio_req->cmd_type == REQ_TYPE_DRV_PRIV) {
+	} else if (bio_req->cmd_type == REQ_TYPE_DRV_PRIV) {
 #endif
-			if (req_resp->blkdev_resp.ioctl_resp.status != 0) {
-				dev_err(vblkdev->device,
-					"IOCTL request failed!\n");
-				req_error_handler(vblkdev, bio_req);
-				goto put_req;
-			}
-
-			if (vblk_complete_ioctl_req(vblkdev, vsc_req)) {
-				req_error_handler(vblkdev, bio_req);
-			} else {
-				if (blk_end_request(bio_req, 0, 0)) {
-					dev_err(vblkdev->device,
-						"Error completing private request!\n");
-				}
-			}
-		} else {
-			if (req_resp->blkdev_resp.blk_resp.status != 0) {
-				req_error_handler(vblkdev, bio_req);
-				goto put_req;
-			}
-
-			if (req_op(bio_req) != REQ_OP_FLUSH) {
-				if (vs_req->blkdev_req.blk_req.num_blks !=
-						req_resp->blkdev_resp.blk_resp.num_blks) {
-					req_error_handler(vblkdev, bio_req);
-					goto put_req;
-				}
-			}
-
-			if (req_op(bio_req) == REQ_OP_READ) {
-				rq_for_each_segment(bvec, bio_req,
-					vsc_req->iter) {
-					size = bvec.bv_len;
-					buffer = page_address(bvec.bv_page) +
-						bvec.bv_offset;
-
-					if ((total_size + size) >
-						(vs_req->blkdev_req.blk_req.num_blks *
-						vblkdev->config.blk_config.hardblk_size))
-					{
-						size =
-						(vs_req->blkdev_req.blk_req.num_blks *
-						vblkdev->config.blk_config.hardblk_size) -
-							total_size;
-					}
-					memcpy(buffer,
-						vsc_req->mempool_virt +
-						total_size,
-						size);
-
-					total_size += size;
-					if (total_size ==
-						(vs_req->blkdev_req.blk_req.num_blks *
-						vblkdev->config.blk_config.hardblk_size))
-						break;
-				}
-			}
-
-			if (blk_end_request(bio_req, 0,
-				vs_req->blkdev_req.blk_req.num_blks *
-					vblkdev->config.blk_config.hardblk_size)) {
-				dev_err(vblkdev->device,
-					"Error completing fs request!\n");
-			}
+		if (req_resp->blkdev_resp.ioctl_resp.status != 0) {
+			dev_err(vblkdev->device,
+				"IOCTL request failed!\n");
+			status = -EIO;
 		}
-	} else if ((bio_req != NULL) && (status != 0)) {
-		req_error_handler(vblkdev, bio_req);
-	} else {
-		dev_err(vblkdev->device,
-			"VSC request %d has null bio request!\n",
-			vsc_req->id);
+	} else if (req_resp->blkdev_resp.blk_resp.status != 0) {
+		status = -EIO;
+	} else if ((req_op(bio_req) != REQ_OP_FLUSH) &&
+		(vs_req->blkdev_req.blk_req.num_blks !=
+			req_resp->blkdev_resp.blk_resp.num_blks)) {
+		status = -EIO;
 	}
-
-put_req:
-	vblk_put_req(vsc_req);
+	vsc_req->status = status;
 
 advance_frame:
 	if (tegra_hv_ivc_read_advance(vblkdev->ivck)) {
@@ -358,12 +236,86 @@ advance_frame:
 			"Couldn't increment read frame pointer!\n");
 	}
 
+	/* The response frame is released, the data stays in the mempool */
+	if (vsc_req != NULL) {
+#if LINUX_VERSION_CODE >= KERNEL_VERSION(4,14,0)
+		blk_mq_complete_request(vsc_req->req);
+#else
+		blk_mq_complete_request(vsc_req->req, vsc_req->status);
+#endif
+	}
+
 	return true;
 
 no_valid_io:
 	return false;
 }
 
+/**
+ * vblk_complete_rq: Complete a request after server is
+ *		done processing it, runs in softirq context.
+ */
+static void vblk_complete_rq(struct request *bio_req)
+{
+	struct vblk_dev *vblkdev = bio_req->q->queuedata;
+	struct vsc_request *vsc_req = &vblkdev->reqs[bio_req->tag];
+	struct vs_request *vs_req = &vsc_req->vs_req;
+	struct req_iterator iter;
+	struct bio_vec bvec;
+	size_t size;
+	size_t total_size = 0;
+	void *buffer;
+	int status = vsc_req->status;
+
+	if (status != 0)
+		goto end_req;
+
+#if LINUX_VERSION_CODE >= KERNEL_VERSION(4,14,0)
+	if (req_op(bio_req) == REQ_OP_DRV_IN) {
+#else
+	if (bio_req->cmd_type == REQ_TYPE_DRV_PRIV) {
+#endif
+		if (vblk_complete_ioctl_req(vblkdev, vsc_req))
+			status = -EIO;
+	} else if (req_op(bio_req) == REQ_OP_READ) {
+		rq_for_each_segment(bvec, bio_req, iter) {
+			size = bvec.bv_len;
+			buffer = page_address(bvec.bv_page) +
+				bvec.bv_offset;
+
+			if ((total_size + size) >
+				(vs_req->blkdev_req.blk_req.num_blks *
+				vblkdev->config.blk_config.hardblk_size))
+			{
+				size =
+				(vs_req->blkdev_req.blk_req.num_blks *
+				vblkdev->config.blk_config.hardblk_size) -
+					total_size;
+			}
+			memcpy(buffer,
+				vsc_req->mempool_virt +
+				total_size,
+				size);
+
+			total_size += size;
+			if (total_size ==
+				(vs_req->blkdev_req.blk_req.num_blks *
+				vblkdev->config.blk_config.hardblk_size))
+				break;
+		}
+	}
+
+end_req:
+	if (status != 0)
+		req_error_handler(vblkdev, bio_req);
+
+	memset(&vsc_req->vs_req, 0, sizeof(struct vs_request));
+	vsc_req->ioctl_req = NULL;
+	vsc_req->req = NULL;
+
+	vblk_end_request(bio_req, status);
+}
+
 static bool bio_req_sanity_check(struct vblk_dev *vblkdev,
 		struct request *bio_req,
 		struct vsc_request *vsc_req)
@@ -404,40 +356,24 @@ static bool bio_req_sanity_check(struct vblk_dev *vblkdev,
 }
 
 /**
- * submit_bio_req: Fetch a bio request and submit it to
- * server for processing.
+ * prep_bio_req: Fill in the vsc request of the tag for a block request.
  */
-static bool submit_bio_req(struct vblk_dev *vblkdev)
+static bool prep_bio_req(struct vblk_dev *vblkdev,
+		struct request *bio_req,
+		struct vsc_request *vsc_req)
 {
-	struct vsc_request *vsc_req = NULL;
-	struct request *bio_req = NULL;
 	struct vs_request *vs_req;
+	struct req_iterator iter;
 	struct bio_vec bvec;
 	size_t size;
 	size_t total_size = 0;
 	void *buffer;
 
-	if (!tegra_hv_ivc_can_write(vblkdev->ivck))
-		goto bio_exit;
-
-	if (vblkdev->queue == NULL)
-		goto bio_exit;
-
-	vsc_req = vblk_get_req(vblkdev);
-	if (vsc_req == NULL)
-		goto bio_exit;
-
-	spin_lock(vblkdev->queue->queue_lock);
-	bio_req = blk_fetch_request(vblkdev->queue);
-	spin_unlock(vblkdev->queue->queue_lock);
-
-	if (bio_req == NULL)
-		goto bio_exit;
-
-	vsc_req->req = bio_req;
 	vs_req = &vsc_req->vs_req;
+	memset(vs_req, 0, sizeof(struct vs_request));
 
 	vs_req->type = VS_DATA_REQ;
+	vs_req->req_id = vsc_req->id;
 #if LINUX_VERSION_CODE >= KERNEL_VERSION(4,14,0)
 	if (req_op(bio_req) != REQ_OP_DRV_IN) {
 #else
@@ -452,17 +388,16 @@ static bool submit_bio_req(struct vblk_dev *vblkdev)
 		} else {
 			dev_err(vblkdev->device,
 				"Request direction is not read/write!\n");
-			goto bio_exit;
+			return false;
 		}
 
-		vsc_req->iter.bio = NULL;
 		if (req_op(bio_req) == REQ_OP_FLUSH) {
 			vs_req->blkdev_req.blk_req.blk_offset = 0;
 			vs_req->blkdev_req.blk_req.num_blks =
 				vblkdev->config.blk_config.num_blks;
 		} else {
 			if (!bio_req_sanity_check(vblkdev, bio_req, vsc_req)) {
-				goto bio_exit;
+				return false;
 			}
 
 			vs_req->blkdev_req.blk_req.blk_offset = ((blk_rq_pos(bio_req) *
@@ -476,7 +411,7 @@ static bool submit_bio_req(struct vblk_dev *vblkdev)
 		}
 
 		if (req_op(bio_req) == REQ_OP_WRITE) {
-			rq_for_each_segment(bvec, bio_req, vsc_req->iter) {
+			rq_for_each_segment(bvec, bio_req, iter) {
 				size = bvec.bv_len;
 				buffer = page_address(bvec.bv_page) +
 						bvec.bv_offset;
@@ -505,59 +440,71 @@ static bool submit_bio_req(struct vblk_dev *vblkdev)
 			vsc_req)) {
 			dev_err(vblkdev->device,
 				"Failed to prepare ioctl request!\n");
-			goto bio_exit;
+			return false;
 		}
 	}
 
-	if (!tegra_hv_ivc_write(vblkdev->ivck, vs_req,
-				sizeof(struct vs_request))) {
-		dev_err(vblkdev->device,
-			"Request Id %d IVC write failed!\n",
-				vsc_req->id);
-		goto bio_exit;
-	}
-
 	return true;
-
-bio_exit:
-	if (vsc_req != NULL) {
-		vblk_put_req(vsc_req);
-	}
-
-	if (bio_req != NULL) {
-		req_error_handler(vblkdev, bio_req);
-		return true;
-	}
-
-	return false;
 }
 
-static void vblk_request_work(struct work_struct *ws)
+/**
+ * vblk_queue_rq: Submit a block request to the server. The tag of
+ * the request picks its vsc request and mempool slot, so the queue
+ * depth of the tag set is the number of vsc requests.
+ */
+static vblk_mq_status_t vblk_queue_rq(struct blk_mq_hw_ctx *hctx,
+		const struct blk_mq_queue_data *bd)
 {
-	struct vblk_dev *vblkdev =
-		container_of(ws, struct vblk_dev, work);
-	bool req_submitted, req_completed;
+	struct vblk_dev *vblkdev = hctx->queue->queuedata;
+	struct request *bio_req = bd->rq;
+	struct vsc_request *vsc_req;
+	unsigned long flags;
 
-	if (tegra_hv_ivc_channel_notified(vblkdev->ivck) != 0)
-		return;
+	if ((bio_req->tag < 0) ||
+		((uint32_t)bio_req->tag >= vblkdev->max_requests)) {
+		dev_err(vblkdev->device, "Request tag %d out of range!\n",
+			bio_req->tag);
+		return VBLK_MQ_RQ_ERROR;
+	}
+	vsc_req = &vblkdev->reqs[bio_req->tag];
 
-	req_submitted = true;
-	req_completed = true;
-	while (req_submitted || req_completed) {
-		req_completed = complete_bio_req(vblkdev);
+	blk_mq_start_request(bio_req);
 
-		req_submitted = submit_bio_req(vblkdev);
+	if (!prep_bio_req(vblkdev, bio_req, vsc_req)) {
+		req_error_handler(vblkdev, bio_req);
+		return VBLK_MQ_RQ_ERROR;
 	}
-}
 
-/* The simple form of the request function. */
-static void vblk_request(struct request_queue *q)
-{
-	struct vblk_dev *vblkdev = q->queuedata;
+	spin_lock_irqsave(&vblkdev->ivc_lock, flags);
+	/* restarted by the IVC interrupt once a frame is free again */
+	if ((tegra_hv_ivc_channel_notified(vblkdev->ivck) != 0) ||
+		!tegra_hv_ivc_can_write(vblkdev->ivck)) {
+		blk_mq_stop_hw_queue(hctx);
+		spin_unlock_irqrestore(&vblkdev->ivc_lock, flags);
+		return VBLK_MQ_RQ_BUSY;
+	}
 
-	queue_work_on(WORK_CPU_UNBOUND, vblkdev->wq, &vblkdev->work);
+	vsc_req->req = bio_req;
+	if (tegra_hv_ivc_write(vblkdev->ivck, &vsc_req->vs_req,
+				sizeof(struct vs_request)) < 0) {
+		vsc_req->req = NULL;
+		spin_unlock_irqrestore(&vblkdev->ivc_lock, flags);
+		dev_err(vblkdev->device,
+			"Request Id %d IVC write failed!\n",
+				vsc_req->id);
+		req_error_handler(vblkdev, bio_req);
+		return VBLK_MQ_RQ_ERROR;
+	}
+	spin_unlock_irqrestore(&vblkdev->ivc_lock, flags);
+
+	return VBLK_MQ_RQ_OK;
 }
 
+static struct blk_mq_ops vblk_mq_ops = {
+	.queue_rq	= vblk_queue_rq,
+	.complete	= vblk_complete_rq,
+};
+
 /* Open and release */
 static int vblk_open(struct block_device *device, fmode_t mode)
 {
@@ -602,6 +549,27 @@ const struct block_device_operations vblk_ops = {
 	.ioctl           = vblk_ioctl
 };
 
+/*
+ * Largest request sent to the server. The mempool slot of a request
+ * stays max_io_bytes so that ioctls can still use all of it.
+ */
+static uint32_t vblk_io_chunk_bytes(struct vblk_dev *vblkdev,
+		uint32_t max_io_bytes)
+{
+	uint32_t hardblk_size = vblkdev->config.blk_config.hardblk_size;
+	uint32_t chunk;
+
+	if (max_io_chunk_kb == 0 ||
+		max_io_chunk_kb >= (max_io_bytes / SZ_1K))
+		return max_io_bytes;
+
+	chunk = rounddown(max_io_chunk_kb * SZ_1K, hardblk_size);
+	if (chunk < PAGE_SIZE || chunk < hardblk_size)
+		return max_io_bytes;
+
+	return chunk;
+}
+
 /* Set up virtual device. */
 static void setup_device(struct vblk_dev *vblkdev)
 {
@@ -615,26 +583,9 @@ static void setup_device(struct vblk_dev *vblkdev)
 			vblkdev->config.blk_config.hardblk_size;
 
 	spin_lock_init(&vblkdev->lock);
-	spin_lock_init(&vblkdev->queue_lock);
+	spin_lock_init(&vblkdev->ivc_lock);
 	mutex_init(&vblkdev->ioctl_lock);
 
-	vblkdev->queue = blk_init_queue(vblk_request, &vblkdev->queue_lock);
-	if (vblkdev->queue == NULL) {
-		dev_err(vblkdev->device, "failed to init blk queue\n");
-		return;
-	}
-
-	vblkdev->queue->queuedata = vblkdev;
-
-	blk_queue_logical_block_size(vblkdev->queue,
-		vblkdev->config.blk_config.hardblk_size);
-	blk_queue_physical_block_size(vblkdev->queue,
-		vblkdev->config.blk_config.hardblk_size);
-
-	if (vblkdev->config.blk_config.req_ops_supported & VS_BLK_FLUSH_OP_F) {
-		blk_queue_write_cache(vblkdev->queue, true, false);
-	}
-
 	if (vblkdev->config.blk_config.max_read_blks_per_io !=
 		vblkdev->config.blk_config.max_write_blks_per_io) {
 		dev_err(vblkdev->device,
@@ -699,10 +650,42 @@ static void setup_device(struct vblk_dev *vblkdev)
 			"maximum requests set to 0!\n");
 		return;
 	}
-	mutex_init(&vblkdev->req_lock);
-
 	vblkdev->max_requests = max_requests;
-	blk_queue_max_hw_sectors(vblkdev->queue, max_io_bytes / SECTOR_SIZE);
+
+	/* One hardware queue for the IVC channel, a tag per vsc request */
+	vblkdev->tag_set.ops = &vblk_mq_ops;
+	vblkdev->tag_set.nr_hw_queues = 1;
+	vblkdev->tag_set.queue_depth = max_requests;
+	vblkdev->tag_set.numa_node = NUMA_NO_NODE;
+	vblkdev->tag_set.flags = BLK_MQ_F_SHOULD_MERGE;
+	vblkdev->tag_set.driver_data = vblkdev;
+
+	if (blk_mq_alloc_tag_set(&vblkdev->tag_set)) {
+		dev_err(vblkdev->device, "failed to alloc blk-mq tag set\n");
+		return;
+	}
+
+	vblkdev->queue = blk_mq_init_queue(&vblkdev->tag_set);
+	if (IS_ERR(vblkdev->queue)) {
+		dev_err(vblkdev->device, "failed to init blk queue\n");
+		vblkdev->queue = NULL;
+		blk_mq_free_tag_set(&vblkdev->tag_set);
+		return;
+	}
+
+	vblkdev->queue->queuedata = vblkdev;
+
+	blk_queue_logical_block_size(vblkdev->queue,
+		vblkdev->config.blk_config.hardblk_size);
+	blk_queue_physical_block_size(vblkdev->queue,
+		vblkdev->config.blk_config.hardblk_size);
+
+	if (vblkdev->config.blk_config.req_ops_supported & VS_BLK_FLUSH_OP_F) {
+		blk_queue_write_cache(vblkdev->queue, true, false);
+	}
+
+	blk_queue_max_hw_sectors(vblkdev->queue,
+		vblk_io_chunk_bytes(vblkdev, max_io_bytes) / SECTOR_SIZE);
 	queue_flag_set_unlocked(QUEUE_FLAG_NONROT, vblkdev->queue);
 
 	/* And the gendisk structure. */
@@ -751,10 +734,28 @@ static irqreturn_t ivc_irq_handler(int irq, void *data)
 {
 	struct vblk_dev *vblkdev = (struct vblk_dev *)data;
 
-	if (vblkdev->initialized)
-		queue_work_on(WORK_CPU_UNBOUND, vblkdev->wq, &vblkdev->work);
-	else
+	if (!vblkdev->initialized) {
 		schedule_work(&vblkdev->init);
+		return IRQ_HANDLED;
+	}
+
+	if (vblkdev->queue == NULL)
+		return IRQ_HANDLED;
+
+	spin_lock(&vblkdev->ivc_lock);
+	if (tegra_hv_ivc_channel_notified(vblkdev->ivck) != 0) {
+		spin_unlock(&vblkdev->ivc_lock);
+		return IRQ_HANDLED;
+	}
+	spin_unlock(&vblkdev->ivc_lock);
+
+	while (complete_bio_req(vblkdev))
+		;
+
+	/* frames were released, restart a queue stopped on a full channel */
+	spin_lock(&vblkdev->ivc_lock);
+	blk_mq_start_stopped_hw_queues(vblkdev->queue, true);
+	spin_unlock(&vblkdev->ivc_lock);
 
 	return IRQ_HANDLED;
 }
@@ -841,40 +842,24 @@ static int tegra_hv_vblk_probe(struct platform_device *pdev)
 
 	vblkdev->initialized = false;
 
-	vblkdev->wq = alloc_workqueue("vblk_req_wq%d",
-		WQ_UNBOUND | WQ_MEM_RECLAIM,
-		1, vblkdev->devnum);
-	if (vblkdev->wq == NULL) {
-		dev_err(dev, "Failed to allocate workqueue\n");
-		ret = -ENOMEM;
-		goto free_mempool;
-	}
-
-	init_completion(&vblkdev->req_queue_empty);
-	vblkdev->queue_state = VBLK_QUEUE_ACTIVE;
-
 	INIT_WORK(&vblkdev->init, vblk_init_device);
-	INIT_WORK(&vblkdev->work, vblk_request_work);
 
 	if (devm_request_irq(vblkdev->device, vblkdev->ivck->irq,
 		ivc_irq_handler, 0, "vblk", vblkdev)) {
 		dev_err(dev, "Failed to request irq %d\n", vblkdev->ivck->irq);
 		ret = -EINVAL;
-		goto free_wq;
+		goto free_mempool;
 	}
 
 	tegra_hv_ivc_channel_reset(vblkdev->ivck);
 	if (vblk_send_config_cmd(vblkdev)) {
 		dev_err(dev, "Failed to send config cmd\n");
 		ret = -EACCES;
-		goto free_wq;
+		goto free_mempool;
 	}
 
 	return 0;
 
-free_wq:
-	destroy_workqueue(vblkdev->wq);
-
 free_mempool:
 	tegra_hv_mempool_unreserve(vblkdev->ivmk);
 
@@ -894,10 +879,11 @@ static int tegra_hv_vblk_remove(struct platform_device *pdev)
 		put_disk(vblkdev->gd);
 	}
 
-	if (vblkdev->queue)
+	if (vblkdev->queue) {
 		blk_cleanup_queue(vblkdev->queue);
+		blk_mq_free_tag_set(&vblkdev->tag_set);
+	}
 
-	destroy_workqueue(vblkdev->wq);
 	tegra_hv_ivc_unreserve(vblkdev->ivck);
 	tegra_hv_mempool_unreserve(vblkdev->ivmk);
 
@@ -925,26 +911,12 @@ static void vblk_exit(void)
 static int tegra_hv_vblk_suspend(struct device *dev)
 {
 	struct vblk_dev *vblkdev = dev_get_drvdata(dev);
-	unsigned long flags;
 
 	if (vblkdev->queue) {
-		spin_lock_irqsave(vblkdev->queue->queue_lock, flags);
-		blk_stop_queue(vblkdev->queue);
-		spin_unlock_irqrestore(vblkdev->queue->queue_lock, flags);
-
-		mutex_lock(&vblkdev->req_lock);
-		vblkdev->queue_state = VBLK_QUEUE_SUSPENDED;
-
-		/* Mark the queue as empty if inflight requests are 0 */
-		if (vblkdev->inflight_reqs == 0)
-			complete(&vblkdev->req_queue_empty);
-		mutex_unlock(&vblkdev->req_lock);
-
-		wait_for_completion(&vblkdev->req_queue_empty);
+		/* Wait for the inflight requests, new ones are held back */
+		blk_mq_freeze_queue(vblkdev->queue);
 		disable_irq(vblkdev->ivck->irq);
 
-		flush_workqueue(vblkdev->wq);
-
 		/* Reset the channel */
 		tegra_hv_ivc_channel_reset(vblkdev->ivck);
 	}
@@ -955,21 +927,13 @@ static int tegra_hv_vblk_suspend(struct device *dev)
 static int tegra_hv_vblk_resume(struct device *dev)
 {
 	struct vblk_dev *vblkdev = dev_get_drvdata(dev);
-	unsigned long flags;
 
 	if (vblkdev->queue) {
-		mutex_lock(&vblkdev->req_lock);
-		vblkdev->queue_state = VBLK_QUEUE_ACTIVE;
-		reinit_completion(&vblkdev->req_queue_empty);
-		mutex_unlock(&vblkdev->req_lock);
-
 		enable_irq(vblkdev->ivck->irq);
 
-		spin_lock_irqsave(vblkdev->queue->queue_lock, flags);
-		blk_start_queue(vblkdev->queue);
-		spin_unlock_irqrestore(vblkdev->queue->queue_lock, flags);
-
-		queue_work_on(WORK_CPU_UNBOUND, vblkdev->wq, &vblkdev->work);
+		/* requests wait in blk-mq until the channel reset is done */
+		blk_mq_unfreeze_queue(vblkdev->queue);
+		blk_mq_start_stopped_hw_queues(vblkdev->queue, true);
 	}
 
 	return 0;
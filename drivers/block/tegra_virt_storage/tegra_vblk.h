@@ -17,10 +17,12 @@
 
 #include <linux/genhd.h>
 #include <linux/blkdev.h>
+#include <linux/blk-mq.h>
 #include <linux/bio.h>
 #include <linux/tegra-ivc.h>
 #include <linux/workqueue.h>
 #include <linux/mutex.h>
+#include <linux/version.h>
 #include <tegra_virt_storage_spec.h>
 
 #define DRV_NAME "tegra_hv_vblk"
@@ -35,16 +37,32 @@
 
 #define MAX_VSC_REQS 32
 
+#if LINUX_VERSION_CODE >= KERNEL_VERSION(4,14,0)
+#define VBLK_MQ_RQ_OK		BLK_STS_OK
+#define VBLK_MQ_RQ_BUSY		BLK_STS_RESOURCE
+#define VBLK_MQ_RQ_ERROR	BLK_STS_IOERR
+typedef blk_status_t vblk_mq_status_t;
+#else
+#define VBLK_MQ_RQ_OK		BLK_MQ_RQ_QUEUE_OK
+#define VBLK_MQ_RQ_BUSY		BLK_MQ_RQ_QUEUE_BUSY
+#define VBLK_MQ_RQ_ERROR	BLK_MQ_RQ_QUEUE_ERROR
+typedef int vblk_mq_status_t;
+#endif
+
 struct vblk_ioctl_req {
 	uint32_t ioctl_id;
 	void *ioctl_buf;
 	uint32_t ioctl_len;
 };
 
+/*
+ * Indexed by the blk-mq tag of the request, each one owns a fixed
+ * slot of the mempool.
+ */
 struct vsc_request {
 	struct vs_request vs_req;
-	struct request *req;
-	struct req_iterator iter;
+	struct request *req;             /* NULL when the tag is idle */
+	int status;                      /* Response status, 0 or -EIO */
 	struct vblk_ioctl_req *ioctl_req;
 	void *mempool_virt;
 	uint32_t mempool_offset;
@@ -53,12 +71,6 @@ struct vsc_request {
 	struct vblk_dev* vblkdev;
 };
 
-enum vblk_queue_state {
-	VBLK_UNKNOWN,
-	VBLK_QUEUE_SUSPENDED,
-	VBLK_QUEUE_ACTIVE,
-};
-
 /*
 * The drvdata of virtual device.
 */
@@ -69,6 +81,7 @@ struct vblk_dev {
 	short media_change;              /* Flag a media change? */
 	spinlock_t lock;                 /* For mutual exclusion */
 	struct request_queue *queue;     /* The device request queue */
+	struct blk_mq_tag_set tag_set;
 	struct gendisk *gd;              /* The gendisk structure */
 	uint32_t ivc_id;
 	uint32_t ivm_id;
@@ -77,19 +90,12 @@ struct vblk_dev {
 	uint32_t devnum;
 	bool initialized;
 	struct work_struct init;
-	struct work_struct work;
-	struct workqueue_struct *wq;
 	struct device *device;
 	void *shared_buffer;
 	struct mutex ioctl_lock;
-	spinlock_t queue_lock;
+	spinlock_t ivc_lock;             /* IVC tx side and channel state */
 	struct vsc_request reqs[MAX_VSC_REQS];
-	DECLARE_BITMAP(pending_reqs, MAX_VSC_REQS);
-	uint32_t inflight_reqs;
 	uint32_t max_requests;
-	struct mutex req_lock;
-	enum vblk_queue_state queue_state;
-	struct completion req_queue_empty;
 };
 
 int vblk_complete_ioctl_req(struct vblk_dev *vblkdev,
@@ -28,17 +28,28 @@
 #include "clk-tegra-bpmp.h"
 #include "clk-mrq.h"
 
+#define BPMP_CLK_ROUND_CACHE	4
+
 /**
  * struct tegra_bpmp_clk
  *
  * @hw:		handle between common and hardware-specific interfaces
  * @clk_num:	bpmp clk identifier
+ * @round_cache: last MRQ_CLK_ROUND_RATE results, for the parent rate they
+ *		were computed at. Used and updated with the clk prepare lock
+ *		held, like all determine_rate calls.
  */
 struct tegra_clk_bpmp {
 	struct clk_hw	hw;
 	int		clk_num;
 	int		num_parents;
 	int		parent;
+	struct {
+		unsigned long	req;
+		unsigned long	parent_rate;
+		unsigned long	rate;
+	} round_cache[BPMP_CLK_ROUND_CACHE];
+	unsigned int	round_next;
 	int		parent_ids[0];
 };
 
@@ -176,8 +187,12 @@ static int clk_bpmp_set_parent(struct clk_hw *hw, u8 index)
 	*((u32 *)&req->args[0]) = bpmp_clk->parent_ids[index];
 
 	err = bpmp_send_clk_message(req, sizeof(req_d), reply, sizeof(reply));
-	if (!err)
+	if (!err) {
 		bpmp_clk->parent = bpmp_clk->parent_ids[index];
+		/* rounding depends on the parent */
+		memset(bpmp_clk->round_cache, 0,
+		       sizeof(bpmp_clk->round_cache));
+	}
 
 	return err;
 }
@@ -205,18 +220,32 @@ static int clk_bpmp_determine_rate(struct clk_hw *hw,
 				    struct clk_rate_request *rate_req)
 {
 	struct tegra_clk_bpmp *bpmp_clk = to_clk_bpmp(hw);
-	int err;
+	int err, i;
 	s64 reply_val;
 	unsigned long rate;
 	u8 req_d[16], reply[8];
 	struct bpmp_clk_req *req = (struct bpmp_clk_req *)&req_d[0];
 
 	rate = min(max(rate_req->rate, rate_req->min_rate), rate_req->max_rate);
-
-	req->cmd = BPMP_CLK_CMD(MRQ_CLK_ROUND_RATE, bpmp_clk->clk_num);
 	if (rate > S64_MAX)
 		rate = S64_MAX;
 
+	/*
+	 * Governors round the same few rates over and over, each one a BPMP
+	 * round trip. The result only changes with the parent rate.
+	 */
+	for (i = 0; i < BPMP_CLK_ROUND_CACHE; i++) {
+		if (bpmp_clk->round_cache[i].rate &&
+		    bpmp_clk->round_cache[i].req == rate &&
+		    bpmp_clk->round_cache[i].parent_rate ==
+		    rate_req->best_parent_rate) {
+			rate_req->rate = bpmp_clk->round_cache[i].rate;
+			return 0;
+		}
+	}
+
+	req->cmd = BPMP_CLK_CMD(MRQ_CLK_ROUND_RATE, bpmp_clk->clk_num);
+
 	*((s64 *)&req->args[4]) = rate;
 	err = bpmp_send_clk_message(req, sizeof(req_d), reply, sizeof(reply));
 
@@ -228,6 +257,11 @@ static int clk_bpmp_determine_rate(struct clk_hw *hw,
 	if (reply_val < 0)
 		return (int)reply_val;
 
+	i = bpmp_clk->round_next++ % BPMP_CLK_ROUND_CACHE;
+	bpmp_clk->round_cache[i].req = rate;
+	bpmp_clk->round_cache[i].parent_rate = rate_req->best_parent_rate;
+	bpmp_clk->round_cache[i].rate = (unsigned long)reply_val;
+
 	rate_req->rate = (unsigned long)reply_val;
 
 	return 0;
@@ -18,6 +18,7 @@
 #include <asm/smp_plat.h>
 #include <asm/cpu.h>
 #include <linux/io.h>
+#include <linux/irq_work.h>
 #include <linux/debugfs.h>
 #include <linux/seq_file.h>
 #include <linux/uaccess.h>
@@ -36,6 +37,7 @@
 #include <linux/tegra-mce.h>
 #include <linux/version.h>
 #include <linux/pm_qos.h>
+#include <linux/perf_event.h>
 #include <linux/workqueue.h>
 #include <linux/tegra-cpufreq.h>
 #include "cpufreq_cpu_emc_table.h"
@@ -49,6 +51,11 @@
 #define REF_CLK_MHZ		408 /* 408 MHz */
 #define US_DELAY		500
 #define US_DELAY_MIN		2
+#define FREQ_SAMPLE_MS		20 /* period of the per cluster freq sampler */
+/* backend stall % of cycles between which the emc floor scales 0-100% */
+#define MEM_BOUND_LOW_PCT	10
+#define MEM_BOUND_HIGH_PCT	30
+#define ARMV8_STALL_BACKEND	0x24
 #define CPUFREQ_TBL_STEP_HZ	(50 * KHZ_TO_HZ * KHZ_TO_HZ)
 
 #define LOOP_FOR_EACH_CLUSTER(cl)	for (cl = 0; \
@@ -62,6 +69,19 @@ static int cpufreq_single_policy;
 static enum cpuhp_state hp_online;
 static uint32_t latest_freq_req[NR_CPUS];
 
+/* latest fast switch ndiv request of each cpu, and the work writing it */
+static DEFINE_PER_CPU(uint64_t, fast_ndiv);
+static DEFINE_PER_CPU(struct irq_work, fast_ndiv_work);
+
+/* core PMU counters of the memory bound emc bias, see tegra_emc_bias() */
+struct mem_bound_ctr {
+	struct perf_event *stall;
+	struct perf_event *cycles;
+	uint64_t last_stall;
+	uint64_t last_cycles;
+};
+static DEFINE_PER_CPU(struct mem_bound_ctr, mem_bound_ctr);
+
 enum cluster {
 	CLUSTER0,
 	CLUSTER1,
@@ -83,12 +103,28 @@ struct per_cluster_data {
 	struct cpumask cpu_mask;
 	struct cc3_params cc3;
 	uint8_t configured;
+	struct delayed_work sample_work;
+	uint32_t sample_cpu; /* cpu the last counters were read on */
+	uint64_t sample_feedback; /* ref and core clk counters read then */
+	uint32_t est_freq; /* KHz, estimated from the last two samples */
+	unsigned long est_jiffies;
+	/* emc floor update for fast switch, which can't take bwmgr lock */
+	uint32_t fast_freq;
+	struct irq_work emc_irq_work;
+	struct work_struct emc_work;
+	uint32_t emc_cpu_freq; /* last cluster freq the emc floor is for */
+	uint32_t emc_bias_pct; /* % of the table emc floor requested */
 };
 
 struct tegra_cpufreq_data {
 	struct per_cluster_data pcluster[MAX_CLUSTERS];
 	struct mutex mlock; /* lock protecting cc3 params */
 	uint32_t freq_compute_delay; /* delay in reading clock counters */
+	uint32_t freq_sample_ms; /* freq sampler period, 0 disables it */
+	struct mutex bias_lock; /* lock protecting the mem_bound counters */
+	bool emc_bias; /* scale emc floor by memory boundedness */
+	uint32_t mem_bound_low_pct;
+	uint32_t mem_bound_high_pct;
 };
 
 static struct tegra_cpufreq_data tfreq_data;
@@ -228,22 +264,245 @@ err_out:
 	return (unsigned int) (rate_mhz * 1000); /* in KHz */
 }
 
+static void set_cpufreq_to_emcfreq(enum cluster cl, uint32_t cluster_freq);
+
+/*
+ * Memory bound emc bias. The cpu to emc table gives the emc floor a
+ * cluster needs at a freq in the worst case, when its workload is memory
+ * bound. With emc_bias on, the sampler measures the share of cycles the
+ * cluster's cores spent stalled on the memory side (ARMv8 STALL_BACKEND)
+ * over each period. The table floor is requested in full at or above
+ * mem_bound_high_pct, not at all at or below mem_bound_low_pct, and in
+ * proportion between them. Call with bias_lock held.
+ */
+static void tegra_emc_bias(struct per_cluster_data *pcl)
+{
+	uint64_t stall = 0, cycles = 0, enabled, running, val;
+	struct mem_bound_ctr *ctr;
+	uint32_t pct, lo, hi, bias;
+	int cpu;
+
+	for_each_cpu_and(cpu, &pcl->cpu_mask, cpu_online_mask) {
+		ctr = &per_cpu(mem_bound_ctr, cpu);
+		if (!ctr->stall || !ctr->cycles)
+			continue;
+
+		val = perf_event_read_value(ctr->stall, &enabled, &running);
+		stall += val - ctr->last_stall;
+		ctr->last_stall = val;
+		val = perf_event_read_value(ctr->cycles, &enabled, &running);
+		cycles += val - ctr->last_cycles;
+		ctr->last_cycles = val;
+	}
+
+	if (!cycles)
+		return;
+
+	pct = div64_u64(stall * 100, cycles);
+	lo = tfreq_data.mem_bound_low_pct;
+	hi = tfreq_data.mem_bound_high_pct;
+	if (pct <= lo)
+		bias = 0;
+	else if (pct >= hi)
+		bias = 100;
+	else
+		bias = (pct - lo) * 100 / (hi - lo);
+
+	if (bias != pcl->emc_bias_pct) {
+		pcl->emc_bias_pct = bias;
+		if (pcl->bwmgr && pcl->emc_cpu_freq)
+			set_cpufreq_to_emcfreq(pcl - tfreq_data.pcluster,
+					       pcl->emc_cpu_freq);
+	}
+}
+
+static void tegra_emc_bias_release(void)
+{
+	struct mem_bound_ctr *ctr;
+	int cpu;
+
+	for_each_possible_cpu(cpu) {
+		ctr = &per_cpu(mem_bound_ctr, cpu);
+		if (ctr->stall)
+			perf_event_release_kernel(ctr->stall);
+		if (ctr->cycles)
+			perf_event_release_kernel(ctr->cycles);
+		memset(ctr, 0, sizeof(*ctr));
+	}
+}
+
+static int tegra_emc_bias_enable(bool enable)
+{
+	struct perf_event_attr attr = {
+		.size = sizeof(attr),
+		.pinned = 1,
+	};
+	struct mem_bound_ctr *ctr;
+	enum cluster cl;
+	int cpu, ret = 0;
+
+	mutex_lock(&tfreq_data.bias_lock);
+	if (enable == tfreq_data.emc_bias)
+		goto out;
+
+	if (!enable) {
+		tfreq_data.emc_bias = false;
+		tegra_emc_bias_release();
+		/* back to the plain table floor */
+		LOOP_FOR_EACH_CLUSTER(cl) {
+			struct per_cluster_data *pcl = &tfreq_data.pcluster[cl];
+
+			pcl->emc_bias_pct = 100;
+			if (pcl->configured && pcl->bwmgr && pcl->emc_cpu_freq)
+				set_cpufreq_to_emcfreq(cl, pcl->emc_cpu_freq);
+		}
+		goto out;
+	}
+
+	get_online_cpus();
+	for_each_online_cpu(cpu) {
+		ctr = &per_cpu(mem_bound_ctr, cpu);
+
+		attr.type = PERF_TYPE_RAW;
+		attr.config = ARMV8_STALL_BACKEND;
+		ctr->stall = perf_event_create_kernel_counter(&attr, cpu,
+							      NULL, NULL, NULL);
+		attr.type = PERF_TYPE_HARDWARE;
+		attr.config = PERF_COUNT_HW_CPU_CYCLES;
+		ctr->cycles = perf_event_create_kernel_counter(&attr, cpu,
+							       NULL, NULL, NULL);
+		if (IS_ERR(ctr->stall) || IS_ERR(ctr->cycles)) {
+			ret = IS_ERR(ctr->stall) ? PTR_ERR(ctr->stall) :
+				PTR_ERR(ctr->cycles);
+			if (!IS_ERR(ctr->stall))
+				perf_event_release_kernel(ctr->stall);
+			if (!IS_ERR(ctr->cycles))
+				perf_event_release_kernel(ctr->cycles);
+			ctr->stall = NULL;
+			ctr->cycles = NULL;
+			break;
+		}
+	}
+	put_online_cpus();
+
+	if (ret) {
+		pr_err("cpufreq: failed to create pmu counters: %d\n", ret);
+		tegra_emc_bias_release();
+		goto out;
+	}
+	tfreq_data.emc_bias = true;
+out:
+	mutex_unlock(&tfreq_data.bias_lock);
+	return ret;
+}
+
+/*
+ * Per cluster freq sampler. The clk counters are free running, so instead
+ * of reading them twice around a delay, read them once per period on a
+ * cpu of the cluster and estimate the freq over the whole period. Readers
+ * then get the last estimate without any cross cpu call.
+ */
+static void tegra_freq_sample(struct work_struct *work)
+{
+	struct per_cluster_data *pcl = container_of(to_delayed_work(work),
+				struct per_cluster_data, sample_work);
+	uint32_t delta_ccnt, delta_refcnt;
+	uint64_t val;
+	uint32_t cpu, next;
+
+	cpu = get_cpu();
+	val = read_freq_feedback();
+	put_cpu();
+
+	/* counters are per cpu, only a delta on the same cpu means anything */
+	if (cpumask_test_cpu(cpu, &pcl->cpu_mask) && cpu == pcl->sample_cpu &&
+	    pcl->sample_feedback) {
+		delta_refcnt = (uint32_t)val -
+			(uint32_t)pcl->sample_feedback;
+		delta_ccnt = (uint32_t)(val >> 32) -
+			(uint32_t)(pcl->sample_feedback >> 32);
+		if (delta_refcnt && delta_ccnt) {
+			WRITE_ONCE(pcl->est_freq, (uint32_t)(((unsigned long)
+				delta_ccnt * REF_CLK_MHZ) / delta_refcnt) * 1000);
+			WRITE_ONCE(pcl->est_jiffies, jiffies);
+		}
+	}
+	pcl->sample_cpu = cpu;
+	pcl->sample_feedback = val;
+
+	mutex_lock(&tfreq_data.bias_lock);
+	if (tfreq_data.emc_bias)
+		tegra_emc_bias(pcl);
+	mutex_unlock(&tfreq_data.bias_lock);
+
+	if (!tfreq_data.freq_sample_ms)
+		return;
+
+	next = cpumask_test_cpu(cpu, &pcl->cpu_mask) && cpu_online(cpu) ? cpu :
+		cpumask_any_and(&pcl->cpu_mask, cpu_online_mask);
+	if (next >= nr_cpu_ids)
+		next = WORK_CPU_UNBOUND;
+	queue_delayed_work_on(next, system_wq, &pcl->sample_work,
+			      msecs_to_jiffies(tfreq_data.freq_sample_ms));
+}
+
+/* Last estimate of the sampler, if it is recent enough, otherwise 0 */
+static unsigned int tegra194_sampled_speed(uint32_t cpu)
+{
+	struct per_cluster_data *pcl =
+		&tfreq_data.pcluster[get_cpu_cluster(cpu)];
+	uint32_t ms = tfreq_data.freq_sample_ms;
+	unsigned long since = READ_ONCE(pcl->est_jiffies);
+
+	if (!ms || time_after(jiffies, since + msecs_to_jiffies(2 * ms)))
+		return 0;
+
+	return READ_ONCE(pcl->est_freq);
+}
+
+static void tegra_freq_sampler_start(void)
+{
+	enum cluster cl;
+	uint32_t cpu;
+
+	LOOP_FOR_EACH_CLUSTER(cl) {
+		if (!tfreq_data.pcluster[cl].configured)
+			continue;
+		cpu = cpumask_any_and(&tfreq_data.pcluster[cl].cpu_mask,
+				      cpu_online_mask);
+		queue_delayed_work_on(cpu < nr_cpu_ids ? cpu : WORK_CPU_UNBOUND,
+				      system_wq,
+				      &tfreq_data.pcluster[cl].sample_work, 0);
+	}
+}
+
 static unsigned int tegra194_get_speed(uint32_t cpu)
 {
+	unsigned int freq = tegra194_sampled_speed(cpu);
+
+	if (freq)
+		return freq;
 	return tegra194_get_speed_common(cpu, tfreq_data.freq_compute_delay);
 }
 
 static unsigned int tegra194_fast_get_speed(uint32_t cpu)
 {
+	unsigned int freq = tegra194_sampled_speed(cpu);
+
+	if (freq)
+		return freq;
 	return tegra194_get_speed_common(cpu, US_DELAY_MIN);
 }
 
 /* Set emc clock by referring cpu_to_emc freq mapping */
 static void set_cpufreq_to_emcfreq(enum cluster cl, uint32_t cluster_freq)
 {
+	struct per_cluster_data *pcl = &tfreq_data.pcluster[cl];
 	unsigned long emc_freq;
 
+	pcl->emc_cpu_freq = cluster_freq;
 	emc_freq = tegra_cpu_to_emc_freq(cluster_freq, cpu_emc_map_ptr);
+	emc_freq = emc_freq * READ_ONCE(pcl->emc_bias_pct) / 100;
 
 	tegra_bwmgr_set_emc(tfreq_data.pcluster[cl].bwmgr,
 		emc_freq * KHZ_TO_HZ, TEGRA_BWMGR_SET_EMC_FLOOR);
@@ -302,6 +561,85 @@ static void tegra_update_cpu_speed(uint32_t rate, uint8_t cpu)
 	smp_call_function_single(cpu, write_ndiv_request, &val, 1);
 }
 
+/* Write the latest fast switch request of this cpu */
+static void tegra_fast_ndiv_work(struct irq_work *work)
+{
+	uint64_t val = READ_ONCE(*this_cpu_ptr(&fast_ndiv));
+
+	write_ndiv_request(&val);
+}
+
+static void tegra_fast_emc_work(struct work_struct *work)
+{
+	struct per_cluster_data *pcl = container_of(work,
+				struct per_cluster_data, emc_work);
+
+	set_cpufreq_to_emcfreq(pcl - tfreq_data.pcluster,
+			       READ_ONCE(pcl->fast_freq));
+}
+
+static void tegra_fast_emc_irq_work(struct irq_work *work)
+{
+	struct per_cluster_data *pcl = container_of(work,
+				struct per_cluster_data, emc_irq_work);
+
+	schedule_work(&pcl->emc_work);
+}
+
+/**
+ * tegra194_fast_switch - Request freq from scheduler context
+ * @policy - cpufreq policy per cpu
+ * @target_freq - in kHz
+ *
+ * The ndiv request of the calling cpu is written right away. The other
+ * cpus of the policy write theirs from an irq_work, which only runs once
+ * for any number of requests made before it does, and so does the emc
+ * floor update through a work. Returns the freq requested.
+ */
+static unsigned int tegra194_fast_switch(struct cpufreq_policy *policy,
+					 unsigned int target_freq)
+{
+	struct cpufreq_frequency_table *ftbl;
+	struct mrq_cpu_ndiv_limits_response *nltbl;
+	struct per_cluster_data *pcl;
+	uint32_t tgt_freq;
+	uint64_t val;
+	int cpu, this_cpu, index;
+
+	index = cpufreq_frequency_table_target(policy, target_freq,
+					       CPUFREQ_RELATION_L);
+	if (index < 0)
+		return 0;
+
+	ftbl = get_freqtable(policy->cpu);
+	tgt_freq = ftbl[index].frequency;
+	pcl = &tfreq_data.pcluster[get_cpu_cluster(policy->cpu)];
+	nltbl = &pcl->ndiv_limits_tbl;
+	if (!nltbl->ref_clk_hz)
+		return 0;
+
+	val = clamp_ndiv(nltbl, map_freq_to_ndiv(nltbl, tgt_freq));
+
+	for_each_cpu(cpu, policy->related_cpus)
+		latest_freq_req[cpu] = tgt_freq;
+
+	this_cpu = smp_processor_id();
+	for_each_cpu(cpu, policy->cpus) {
+		WRITE_ONCE(per_cpu(fast_ndiv, cpu), val);
+		if (cpu == this_cpu)
+			write_ndiv_request(&val);
+		else
+			irq_work_queue_on(&per_cpu(fast_ndiv_work, cpu), cpu);
+	}
+
+	if (pcl->bwmgr) {
+		WRITE_ONCE(pcl->fast_freq, tgt_freq);
+		irq_work_queue(&pcl->emc_irq_work);
+	}
+
+	return tgt_freq;
+}
+
 /**
  * tegra194_set_speed - Request freq to be set for policy->cpu
  * @policy - cpufreq policy per cpu
@@ -431,13 +769,90 @@ static int set_delay(void *data, u64 val)
 DEFINE_SIMPLE_ATTRIBUTE(freq_compute_fops, get_delay, set_delay,
 	"%llu\n");
 
+static int get_sample_ms(void *data, u64 *val)
+{
+	*val = tfreq_data.freq_sample_ms;
+
+	return 0;
+}
+
+/*
+ * Period of the freq sampler, which is also the window cpufreq_get()
+ * averages the freq over. 0 stops it, and cpufreq_get() then measures
+ * over freq_compute_delay again.
+ */
+static int set_sample_ms(void *data, u64 val)
+{
+	uint32_t old = tfreq_data.freq_sample_ms;
+
+	if (tegra_hypervisor_mode || val > MSEC_PER_SEC)
+		return -EINVAL;
+
+	tfreq_data.freq_sample_ms = val;
+	if (val && !old)
+		tegra_freq_sampler_start();
+
+	return 0;
+}
+DEFINE_SIMPLE_ATTRIBUTE(freq_sample_fops, get_sample_ms, set_sample_ms,
+	"%llu\n");
+
+static int get_emc_bias(void *data, u64 *val)
+{
+	*val = tfreq_data.emc_bias;
+
+	return 0;
+}
+
+/* Needs the freq sampler running, it is what measures the stalls */
+static int set_emc_bias(void *data, u64 val)
+{
+	if (tegra_hypervisor_mode)
+		return -EINVAL;
+
+	return tegra_emc_bias_enable(!!val);
+}
+DEFINE_SIMPLE_ATTRIBUTE(emc_bias_fops, get_emc_bias, set_emc_bias,
+	"%llu\n");
+
+static int get_mem_bound_pct(void *data, u64 *val)
+{
+	*val = *(uint32_t *)data;
+
+	return 0;
+}
+
+static int set_mem_bound_pct(void *data, u64 val)
+{
+	uint32_t lo = tfreq_data.mem_bound_low_pct;
+	uint32_t hi = tfreq_data.mem_bound_high_pct;
+
+	if (data == &tfreq_data.mem_bound_low_pct)
+		lo = val;
+	else
+		hi = val;
+
+	if (val > 100 || lo >= hi)
+		return -EINVAL;
+
+	mutex_lock(&tfreq_data.bias_lock);
+	tfreq_data.mem_bound_low_pct = lo;
+	tfreq_data.mem_bound_high_pct = hi;
+	mutex_unlock(&tfreq_data.bias_lock);
+
+	return 0;
+}
+DEFINE_SIMPLE_ATTRIBUTE(mem_bound_pct_fops, get_mem_bound_pct,
+	set_mem_bound_pct, "%llu\n");
+
 static int freq_get(void *data, u64 *val)
 {
 	uint64_t cpu = (uint64_t)data;
 
 	get_online_cpus();
 	if (cpu_online(cpu))
-		*val = tegra194_get_speed(cpu);
+		*val = tegra194_get_speed_common(cpu,
+				tfreq_data.freq_compute_delay);
 	else
 		*val = 0LL;
 	put_online_cpus();
@@ -676,6 +1091,30 @@ static int __init tegra_cpufreq_debug_init(void)
 					&freq_compute_fops))
 		goto err_out;
 
+	if (!debugfs_create_file("freq_sample_ms", RW_MODE,
+				 tegra_cpufreq_debugfs_root,
+					NULL,
+					&freq_sample_fops))
+		goto err_out;
+
+	if (!debugfs_create_file("emc_mem_bias", RW_MODE,
+				 tegra_cpufreq_debugfs_root,
+					NULL,
+					&emc_bias_fops))
+		goto err_out;
+
+	if (!debugfs_create_file("mem_bound_low_pct", RW_MODE,
+				 tegra_cpufreq_debugfs_root,
+					&tfreq_data.mem_bound_low_pct,
+					&mem_bound_pct_fops))
+		goto err_out;
+
+	if (!debugfs_create_file("mem_bound_high_pct", RW_MODE,
+				 tegra_cpufreq_debugfs_root,
+					&tfreq_data.mem_bound_high_pct,
+					&mem_bound_pct_fops))
+		goto err_out;
+
 	if (!tegra_debugfs_create_cpu_emc_map(tegra_cpufreq_debugfs_root,
 					cpu_emc_map_ptr))
 		goto err_out;
@@ -721,6 +1160,8 @@ static int tegra194_cpufreq_init(struct cpufreq_policy *policy)
 
 	policy->suspend_freq = policy->max;
 	policy->cur = tegra194_fast_get_speed(policy->cpu); /* boot freq */
+	/* the hypervisor cpufreq server has to be called from process ctx */
+	policy->fast_switch_possible = !tegra_hypervisor_mode;
 
 	cl = get_cpu_cluster(policy->cpu);
 
@@ -757,6 +1198,7 @@ static struct cpufreq_driver tegra_cpufreq_driver = {
 				CPUFREQ_NEED_INITIAL_FREQ_CHECK,
 	.verify = cpufreq_generic_frequency_table_verify,
 	.target_index = tegra194_set_speed,
+	.fast_switch = tegra194_fast_switch,
 	.get = tegra194_get_speed,
 	.init = tegra194_cpufreq_init,
 	.exit = tegra194_cpufreq_exit,
@@ -868,10 +1310,16 @@ static void free_resources(void)
 {
 	enum cluster cl;
 
+	tegra_emc_bias_enable(false);
+
 	LOOP_FOR_EACH_CLUSTER(cl) {
 		if (!tfreq_data.pcluster[cl].configured)
 			continue;
 
+		cancel_delayed_work_sync(&tfreq_data.pcluster[cl].sample_work);
+		irq_work_sync(&tfreq_data.pcluster[cl].emc_irq_work);
+		cancel_work_sync(&tfreq_data.pcluster[cl].emc_work);
+
 		/* free table */
 		kfree(tfreq_data.pcluster[cl].clft);
 
@@ -1110,13 +1558,28 @@ static int __init tegra194_cpufreq_probe(struct platform_device *pdev)
 	cpufreq_single_policy = tegra_cpufreq_single_policy(dn);
 
 	mutex_init(&tfreq_data.mlock);
+	mutex_init(&tfreq_data.bias_lock);
 	tfreq_data.freq_compute_delay = US_DELAY;
+	tfreq_data.mem_bound_low_pct = MEM_BOUND_LOW_PCT;
+	tfreq_data.mem_bound_high_pct = MEM_BOUND_HIGH_PCT;
 	tegra_hypervisor_mode = is_tegra_hypervisor_mode();
 
 	for_each_possible_cpu(cpu) {
 		cl = get_cpu_cluster(cpu);
-		if (!tfreq_data.pcluster[cl].configured)
+		if (!tfreq_data.pcluster[cl].configured) {
 			tfreq_data.pcluster[cl].configured = 1;
+			tfreq_data.pcluster[cl].emc_bias_pct = 100;
+			/* deferrable, not to wake up idle cpus just for it */
+			INIT_DEFERRABLE_WORK(
+				&tfreq_data.pcluster[cl].sample_work,
+				tegra_freq_sample);
+			init_irq_work(&tfreq_data.pcluster[cl].emc_irq_work,
+				      tegra_fast_emc_irq_work);
+			INIT_WORK(&tfreq_data.pcluster[cl].emc_work,
+				  tegra_fast_emc_work);
+		}
+		init_irq_work(&per_cpu(fast_ndiv_work, cpu),
+			      tegra_fast_ndiv_work);
 	}
 
 	set_cpu_mask();
@@ -1162,6 +1625,11 @@ static int __init tegra194_cpufreq_probe(struct platform_device *pdev)
 
 	init_latest_freq_req();
 
+	if (!tegra_hypervisor_mode) {
+		tfreq_data.freq_sample_ms = FREQ_SAMPLE_MS;
+		tegra_freq_sampler_start();
+	}
+
 	ret = cpufreq_register_driver(&tegra_cpufreq_driver);
 	if (ret)
 		goto err_free_res;
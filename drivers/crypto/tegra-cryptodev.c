@@ -26,6 +26,11 @@
 #include <linux/kernel.h>
 #include <linux/slab.h>
 #include <linux/fs.h>
+#include <linux/mm.h>
+#include <linux/poll.h>
+#include <linux/list.h>
+#include <linux/spinlock.h>
+#include <linux/wait.h>
 #include <linux/miscdevice.h>
 #include <linux/crypto.h>
 #include <linux/scatterlist.h>
@@ -78,6 +83,32 @@ struct tegra_crypto_ctx {
 	int use_ssk;
 	bool skip_exit;
 	struct mutex lock;
+	/* TEGRA_CRYPTO_IOCTL_ASYNC_* state */
+	struct crypto_skcipher *async_tfm;
+	struct mutex async_lock;	/* setup and submission */
+	spinlock_t async_done_lock;	/* protects async_done */
+	struct list_head async_done;
+	wait_queue_head_t async_wq;
+	atomic_t async_inflight;	/* submitted, not reaped yet */
+};
+
+struct tegra_crypt_async_job {
+	struct list_head node;
+	struct tegra_crypto_ctx *ctx;
+	struct skcipher_request *req;
+	u64 user_data;
+	int status;
+	u8 iv[TEGRA_CRYPTO_IV_SIZE];
+	struct page **src_pages;
+	struct page **dst_pages;
+	int src_npages;
+	int dst_npages;
+	struct sg_table src_sgt;
+	struct sg_table dst_sgt;
+};
+
+static const char * const aes_algo[TEGRA_CRYPTO_MAX] = {
+	"ecb(aes)", "cbc(aes)", "ofb(aes)", "ctr(aes)", "xts(aes)"
 };
 
 struct tegra_crypto_completion {
@@ -167,11 +198,363 @@ static int tegra_crypto_dev_open(struct inode *inode, struct file *filp)
 		return ret;
 	}
 	mutex_init(&ctx->lock);
+	mutex_init(&ctx->async_lock);
+	spin_lock_init(&ctx->async_done_lock);
+	INIT_LIST_HEAD(&ctx->async_done);
+	init_waitqueue_head(&ctx->async_wq);
+	atomic_set(&ctx->async_inflight, 0);
 
 	filp->private_data = ctx;
 	return ret;
 }
 
+static void tegra_crypt_async_unpin(struct page **pages, int npages,
+				    bool dirty)
+{
+	int i;
+
+	for (i = 0; i < npages; i++) {
+		if (dirty)
+			set_page_dirty_lock(pages[i]);
+		put_page(pages[i]);
+	}
+	kfree(pages);
+}
+
+static int tegra_crypt_async_pin(u64 uaddr, u32 size, bool write,
+				 struct page ***pagesp, int *npagesp,
+				 struct sg_table *sgt)
+{
+	unsigned long offset = uaddr & ~PAGE_MASK;
+	int npages = DIV_ROUND_UP(offset + size, PAGE_SIZE);
+	struct page **pages;
+	int pinned, ret;
+
+	pages = kcalloc(npages, sizeof(*pages), GFP_KERNEL);
+	if (!pages)
+		return -ENOMEM;
+
+	pinned = get_user_pages_fast(uaddr & PAGE_MASK, npages, write, pages);
+	if (pinned != npages) {
+		ret = pinned < 0 ? pinned : -EFAULT;
+		tegra_crypt_async_unpin(pages, max(pinned, 0), false);
+		return ret;
+	}
+
+	ret = sg_alloc_table_from_pages(sgt, pages, npages, offset, size,
+					GFP_KERNEL);
+	if (ret) {
+		tegra_crypt_async_unpin(pages, npages, false);
+		return ret;
+	}
+
+	*pagesp = pages;
+	*npagesp = npages;
+	return 0;
+}
+
+static void tegra_crypt_async_free_job(struct tegra_crypt_async_job *job)
+{
+	if (job->src_pages) {
+		sg_free_table(&job->src_sgt);
+		tegra_crypt_async_unpin(job->src_pages, job->src_npages, false);
+	}
+	sg_free_table(&job->dst_sgt);
+	tegra_crypt_async_unpin(job->dst_pages, job->dst_npages,
+				job->status == 0);
+	skcipher_request_free(job->req);
+	kfree(job);
+}
+
+/* May run in interrupt context, pages are released when reaped */
+static void tegra_crypt_async_complete(struct crypto_async_request *areq,
+				       int err)
+{
+	struct tegra_crypt_async_job *job = areq->data;
+	struct tegra_crypto_ctx *ctx = job->ctx;
+	unsigned long flags;
+
+	if (err == -EINPROGRESS)
+		return;
+
+	job->status = err;
+	spin_lock_irqsave(&ctx->async_done_lock, flags);
+	list_add_tail(&job->node, &ctx->async_done);
+	spin_unlock_irqrestore(&ctx->async_done_lock, flags);
+	wake_up_interruptible(&ctx->async_wq);
+}
+
+static struct tegra_crypt_async_job *tegra_crypt_async_pop(
+	struct tegra_crypto_ctx *ctx)
+{
+	struct tegra_crypt_async_job *job;
+	unsigned long flags;
+
+	spin_lock_irqsave(&ctx->async_done_lock, flags);
+	job = list_first_entry_or_null(&ctx->async_done,
+				       struct tegra_crypt_async_job, node);
+	if (job)
+		list_del(&job->node);
+	spin_unlock_irqrestore(&ctx->async_done_lock, flags);
+
+	return job;
+}
+
+static bool tegra_crypt_async_ready(struct tegra_crypto_ctx *ctx)
+{
+	return !list_empty(&ctx->async_done) ||
+		!atomic_read(&ctx->async_inflight);
+}
+
+/* Waits for every operation in flight and drops the completions */
+static void tegra_crypt_async_drain(struct tegra_crypto_ctx *ctx)
+{
+	struct tegra_crypt_async_job *job;
+
+	while (atomic_read(&ctx->async_inflight)) {
+		wait_event(ctx->async_wq, !list_empty(&ctx->async_done));
+		while ((job = tegra_crypt_async_pop(ctx)) != NULL) {
+			tegra_crypt_async_free_job(job);
+			atomic_dec(&ctx->async_inflight);
+		}
+	}
+}
+
+static int tegra_crypt_async_setup(struct tegra_crypto_ctx *ctx,
+				   struct tegra_crypt_async_setup *setup)
+{
+	struct crypto_skcipher *tfm;
+	const char *algo;
+	int ret;
+
+	if (setup->op >= TEGRA_CRYPTO_MAX)
+		return -EINVAL;
+	setup->op = array_index_nospec(setup->op, TEGRA_CRYPTO_MAX);
+
+	if (((setup->keylen &
+		CRYPTO_KEY_LEN_MASK) != TEGRA_CRYPTO_KEY_128_SIZE) &&
+		((setup->keylen &
+		CRYPTO_KEY_LEN_MASK) != TEGRA_CRYPTO_KEY_192_SIZE) &&
+		((setup->keylen &
+		CRYPTO_KEY_LEN_MASK) != TEGRA_CRYPTO_KEY_256_SIZE) &&
+		((setup->keylen &
+		CRYPTO_KEY_LEN_MASK) != TEGRA_CRYPTO_KEY_512_SIZE)) {
+		pr_err("async setup keylen invalid");
+		return -EINVAL;
+	}
+
+	mutex_lock(&ctx->async_lock);
+	if (atomic_read(&ctx->async_inflight)) {
+		ret = -EBUSY;
+		goto out;
+	}
+
+	tfm = crypto_alloc_skcipher(aes_algo[setup->op],
+		CRYPTO_ALG_TYPE_ABLKCIPHER | CRYPTO_ALG_ASYNC, 0);
+	if (IS_ERR(tfm)) {
+		pr_err("Failed to load transform for %s: %ld\n",
+			aes_algo[setup->op], PTR_ERR(tfm));
+		ret = PTR_ERR(tfm);
+		goto out;
+	}
+
+	/* Null key is only allowed in SE driver */
+	algo = crypto_tfm_alg_driver_name(crypto_skcipher_tfm(tfm));
+	if (!algo || !strstr(algo, "tegra")) {
+		ret = -EINVAL;
+		goto free_tfm;
+	}
+
+	crypto_skcipher_clear_flags(tfm, ~0);
+	ret = crypto_skcipher_setkey(tfm, ctx->use_ssk ? NULL : setup->key,
+				     setup->keylen);
+	if (ret < 0) {
+		pr_err("setkey failed");
+		goto free_tfm;
+	}
+
+	if (ctx->async_tfm)
+		crypto_free_skcipher(ctx->async_tfm);
+	ctx->async_tfm = tfm;
+	goto out;
+
+free_tfm:
+	crypto_free_skcipher(tfm);
+out:
+	mutex_unlock(&ctx->async_lock);
+	return ret;
+}
+
+static int tegra_crypt_async_submit(struct tegra_crypto_ctx *ctx,
+				    struct tegra_crypt_async_op *op)
+{
+	struct tegra_crypt_async_job *job;
+	struct scatterlist *src;
+	int ret;
+
+	if (!op->size || op->size > TEGRA_CRYPTO_ASYNC_MAX_SIZE)
+		return -EINVAL;
+
+	mutex_lock(&ctx->async_lock);
+	if (!ctx->async_tfm) {
+		ret = -EINVAL;
+		goto unlock;
+	}
+
+	if (!atomic_add_unless(&ctx->async_inflight, 1,
+			       TEGRA_CRYPTO_ASYNC_MAX_INFLIGHT)) {
+		ret = -EAGAIN;
+		goto unlock;
+	}
+
+	job = kzalloc(sizeof(*job), GFP_KERNEL);
+	if (!job) {
+		ret = -ENOMEM;
+		goto dec_inflight;
+	}
+	job->ctx = ctx;
+	job->user_data = op->user_data;
+	memcpy(job->iv, op->iv, sizeof(job->iv));
+
+	job->req = skcipher_request_alloc(ctx->async_tfm, GFP_KERNEL);
+	if (!job->req) {
+		ret = -ENOMEM;
+		goto free_job;
+	}
+
+	ret = tegra_crypt_async_pin(op->dst, op->size, true, &job->dst_pages,
+				    &job->dst_npages, &job->dst_sgt);
+	if (ret)
+		goto free_req;
+
+	if (op->src != op->dst) {
+		ret = tegra_crypt_async_pin(op->src, op->size, false,
+					    &job->src_pages, &job->src_npages,
+					    &job->src_sgt);
+		if (ret)
+			goto unpin_dst;
+		src = job->src_sgt.sgl;
+	} else {
+		src = job->dst_sgt.sgl;
+	}
+
+	skcipher_request_set_callback(job->req, CRYPTO_TFM_REQ_MAY_BACKLOG,
+		tegra_crypt_async_complete, job);
+	skcipher_request_set_crypt(job->req, src, job->dst_sgt.sgl, op->size,
+				   job->iv);
+
+	ret = op->encrypt ?
+		crypto_skcipher_encrypt(job->req) :
+		crypto_skcipher_decrypt(job->req);
+	/* errors and synchronous completions also go through the ring */
+	if (ret != -EINPROGRESS && ret != -EBUSY)
+		tegra_crypt_async_complete(&job->req->base, ret);
+
+	mutex_unlock(&ctx->async_lock);
+	return 0;
+
+unpin_dst:
+	sg_free_table(&job->dst_sgt);
+	tegra_crypt_async_unpin(job->dst_pages, job->dst_npages, false);
+free_req:
+	skcipher_request_free(job->req);
+free_job:
+	kfree(job);
+dec_inflight:
+	atomic_dec(&ctx->async_inflight);
+unlock:
+	mutex_unlock(&ctx->async_lock);
+	return ret;
+}
+
+static int tegra_crypt_async_reap(struct tegra_crypto_ctx *ctx,
+				  struct tegra_crypt_async_reap *reap)
+{
+	struct tegra_crypt_async_completion *comp;
+	struct tegra_crypt_async_job *job;
+	u32 max = min_t(u32, reap->max, TEGRA_CRYPTO_ASYNC_MAX_INFLIGHT);
+	int ret = 0;
+
+	reap->count = 0;
+	if (!max)
+		return -EINVAL;
+
+	if (!(reap->flags & TEGRA_CRYPTO_ASYNC_NONBLOCK)) {
+		ret = wait_event_interruptible(ctx->async_wq,
+					       tegra_crypt_async_ready(ctx));
+		if (ret)
+			return ret;
+	}
+
+	comp = kcalloc(max, sizeof(*comp), GFP_KERNEL);
+	if (!comp)
+		return -ENOMEM;
+
+	while (reap->count < max && (job = tegra_crypt_async_pop(ctx))) {
+		comp[reap->count].user_data = job->user_data;
+		comp[reap->count].status = job->status;
+		reap->count++;
+		tegra_crypt_async_free_job(job);
+		atomic_dec(&ctx->async_inflight);
+	}
+
+	if (reap->count && copy_to_user((void __user *)(uintptr_t)
+			reap->completions, comp, reap->count * sizeof(*comp)))
+		ret = -EFAULT;
+
+	kfree(comp);
+	return ret;
+}
+
+/* Not serialized by ctx->lock, so that REAP can wait for SUBMIT */
+static long tegra_crypt_async_ioctl(struct tegra_crypto_ctx *ctx,
+				    unsigned int ioctl_num, unsigned long arg)
+{
+	struct tegra_crypt_async_setup setup;
+	struct tegra_crypt_async_op op;
+	struct tegra_crypt_async_reap reap;
+	int ret;
+
+	switch (ioctl_num) {
+	case TEGRA_CRYPTO_IOCTL_ASYNC_SETUP:
+		if (copy_from_user(&setup, (void __user *)arg, sizeof(setup)))
+			return -EFAULT;
+		ret = tegra_crypt_async_setup(ctx, &setup);
+		memzero_explicit(&setup, sizeof(setup));
+		return ret;
+
+	case TEGRA_CRYPTO_IOCTL_ASYNC_SUBMIT:
+		if (copy_from_user(&op, (void __user *)arg, sizeof(op)))
+			return -EFAULT;
+		return tegra_crypt_async_submit(ctx, &op);
+
+	case TEGRA_CRYPTO_IOCTL_ASYNC_REAP:
+		if (copy_from_user(&reap, (void __user *)arg, sizeof(reap)))
+			return -EFAULT;
+		ret = tegra_crypt_async_reap(ctx, &reap);
+		if (copy_to_user((void __user *)arg, &reap, sizeof(reap)))
+			return -EFAULT;
+		return ret;
+	}
+
+	return -EINVAL;
+}
+
+static unsigned int tegra_crypto_dev_poll(struct file *filp,
+					  struct poll_table_struct *wait)
+{
+	struct tegra_crypto_ctx *ctx = filp->private_data;
+
+	if (!ctx)
+		return POLLERR;
+
+	poll_wait(filp, &ctx->async_wq, wait);
+	if (!list_empty(&ctx->async_done))
+		return POLLIN | POLLRDNORM;
+
+	return 0;
+}
+
 static int tegra_crypto_dev_release(struct inode *inode, struct file *filp)
 {
 	struct tegra_crypto_ctx *ctx = filp->private_data;
@@ -185,6 +568,10 @@ static int tegra_crypto_dev_release(struct inode *inode, struct file *filp)
 	static struct crypto_skcipher *store_tfm[
 					TEGRA_CRYPTO_AES_TEST_KEYSLOTS];
 
+	tegra_crypt_async_drain(ctx);
+	if (ctx->async_tfm)
+		crypto_free_skcipher(ctx->async_tfm);
+
 	/* Only when skip_exit is false, the concerned tfm is freed,
 	 * else it is just saved in store_tfm that is freed later
 	 */
@@ -205,6 +592,7 @@ static int tegra_crypto_dev_release(struct inode *inode, struct file *filp)
 		tfm_index = 0;
 	}
 out:
+	mutex_destroy(&ctx->async_lock);
 	mutex_destroy(&ctx->lock);
 	kfree(ctx);
 	filp->private_data = NULL;
@@ -234,8 +622,6 @@ static int process_crypt_req(struct file *filp, struct tegra_crypto_ctx *ctx,
 	unsigned long total = 0;
 	const u8 *key = NULL;
 	struct tegra_crypto_completion tcrypt_complete;
-	char aes_algo[5][10] = {"ecb(aes)", "cbc(aes)", "ofb(aes)", "ctr(aes)",
-				"xts(aes)"};
 	const char *algo;
 
 	if (crypt_req->op != TEGRA_CRYPTO_CBC) {
@@ -1481,6 +1867,11 @@ static long tegra_crypto_dev_ioctl(struct file *filp,
 		return -EPERM;
 	}
 
+	if (ioctl_num == TEGRA_CRYPTO_IOCTL_ASYNC_SETUP ||
+	    ioctl_num == TEGRA_CRYPTO_IOCTL_ASYNC_SUBMIT ||
+	    ioctl_num == TEGRA_CRYPTO_IOCTL_ASYNC_REAP)
+		return tegra_crypt_async_ioctl(ctx, ioctl_num, arg);
+
 	mutex_lock(&ctx->lock);
 
 	switch (ioctl_num) {
@@ -1902,6 +2293,7 @@ static const struct file_operations tegra_crypto_fops = {
 	.open = tegra_crypto_dev_open,
 	.release = tegra_crypto_dev_release,
 	.unlocked_ioctl = tegra_crypto_dev_ioctl,
+	.poll = tegra_crypto_dev_poll,
 #ifdef CONFIG_COMPAT
 	.compat_ioctl =  tegra_crypto_dev_ioctl,
 #endif
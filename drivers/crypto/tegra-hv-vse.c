@@ -124,6 +124,8 @@ struct tegra_virtual_se_dev {
 	int req_cnt;
 	struct ablkcipher_request *reqs[TEGRA_HV_VSE_MAX_TASKS_PER_SUBMIT];
 	atomic_t ivc_count;
+	/* Woken up when a SHA command completes */
+	wait_queue_head_t ivc_wq;
 	int gather_buf_sz;
 	/* Engine id */
 	unsigned int engine_id;
@@ -717,15 +719,25 @@ static int tegra_hv_vse_send_sha_data(struct tegra_virtual_se_dev *se_dev,
 	vse_thread_start = true;
 	init_completion(&priv->alg_complete);
 
+	/*
+	 * Each SHA command carries the intermediate hash of its request, so
+	 * commands of different requests can be outstanding with the server
+	 * at the same time. Only the submission is serialized.
+	 */
+	wait_event(se_dev->ivc_wq, atomic_add_unless(&se_dev->ivc_count, 1,
+			TEGRA_HV_VSE_NUM_SERVER_REQ));
+
 	mutex_lock(&se_dev->server_lock);
 	/* Return error if engine is in suspended state */
 	if (atomic_read(&se_dev->se_suspended)) {
+		mutex_unlock(&se_dev->server_lock);
 		err = -ENODEV;
 		goto exit;
 	}
 
 	err = tegra_hv_vse_send_ivc(se_dev, pivck, ivc_req_msg,
 			sizeof(struct tegra_virtual_se_ivc_msg_t));
+	mutex_unlock(&se_dev->server_lock);
 	if (err)
 		goto exit;
 
@@ -736,7 +748,8 @@ static int tegra_hv_vse_send_sha_data(struct tegra_virtual_se_dev *se_dev,
 		err = -ETIMEDOUT;
 	}
 exit:
-	mutex_unlock(&se_dev->server_lock);
+	atomic_dec(&se_dev->ivc_count);
+	wake_up(&se_dev->ivc_wq);
 	devm_kfree(se_dev->dev, priv);
 
 	return err;
@@ -1267,14 +1280,10 @@ static int tegra_hv_vse_sha_update(struct ahash_request *req)
 		return -EINVAL;
 	}
 
-	mutex_lock(&se_dev->mtx);
-
 	ret = tegra_hv_vse_sha_op(req, false, false);
 	if (ret)
 		dev_err(se_dev->dev, "tegra_se_sha_update failed - %d\n", ret);
 
-	mutex_unlock(&se_dev->mtx);
-
 	return ret;
 }
 
@@ -1300,14 +1309,10 @@ static int tegra_hv_vse_sha_finup(struct ahash_request *req)
 		return -EINVAL;
 	}
 
-	mutex_lock(&se_dev->mtx);
-
 	ret = tegra_hv_vse_sha_op(req, true, true);
 	if (ret)
 		dev_err(se_dev->dev, "tegra_se_sha_finup failed - %d\n", ret);
 
-	mutex_unlock(&se_dev->mtx);
-
 	tegra_hv_vse_sha_req_deinit(req);
 
 	return ret;
@@ -1335,13 +1340,11 @@ static int tegra_hv_vse_sha_final(struct ahash_request *req)
 		return -EINVAL;
 	}
 
-	mutex_lock(&se_dev->mtx);
 	/* Do not process data in given request */
 	ret = tegra_hv_vse_sha_op(req, true, false);
 	if (ret)
 		dev_err(se_dev->dev, "tegra_se_sha_final failed - %d\n", ret);
 
-	mutex_unlock(&se_dev->mtx);
 	tegra_hv_vse_sha_req_deinit(req);
 
 	return ret;
@@ -1367,11 +1370,9 @@ static int tegra_hv_vse_sha_digest(struct ahash_request *req)
 		return ret;
 	}
 
-	mutex_lock(&se_dev->mtx);
 	ret = tegra_hv_vse_sha_op(req, true, true);
 	if (ret)
 		dev_err(se_dev->dev, "tegra_se_sha_digest failed - %d\n", ret);
-	mutex_unlock(&se_dev->mtx);
 
 	tegra_hv_vse_sha_req_deinit(req);
 
@@ -3843,6 +3844,9 @@ static int tegra_hv_vse_probe(struct platform_device *pdev)
 	}
 
 	if (engine_id == VIRTUAL_SE_SHA) {
+		atomic_set(&se_dev->ivc_count, 0);
+		init_waitqueue_head(&se_dev->ivc_wq);
+
 		for (i = 0; i < ARRAY_SIZE(sha_algs); i++) {
 			err = crypto_register_ahash(&sha_algs[i]);
 			if (err) {
@@ -3896,6 +3900,12 @@ static void tegra_hv_vse_shutdown(struct platform_device *pdev)
 			usleep_range(8, 10);
 	}
 
+	if (se_dev->engine_id == VIRTUAL_SE_SHA) {
+		/* SHA commands are outstanding without the server lock */
+		while (atomic_read(&se_dev->ivc_count) != 0)
+			usleep_range(8, 10);
+	}
+
 	/* Wait for  SE server to be free*/
 	while (mutex_is_locked(&se_dev->server_lock))
 		usleep_range(8, 10);
@@ -68,6 +68,9 @@
 
 #define ECDSA_USE_SHAMIRS_TRICK		1
 
+/* Curves whose Montgomery precomputation is kept around */
+#define PKA1_PRECOMP_CACHE_SIZE		8
+
 enum tegra_se_pka_mod_type {
 	MOD_MULT,
 	MOD_ADD,
@@ -133,6 +136,16 @@ struct tegra_se_elp_chipdata {
 	bool weierstrass;
 };
 
+/* Montgomery values M and R2 of a modulus, computed once per curve */
+struct tegra_se_pka1_precomp_entry {
+	bool valid;
+	u32 op_mode;
+	u32 size;
+	u32 modulus[ECC_MAX_WORDS];
+	u32 m[ECC_MAX_WORDS];
+	u32 r2[ECC_MAX_WORDS];
+};
+
 struct tegra_se_elp_dev {
 	struct device *dev;
 	void __iomem *io_reg[2];
@@ -144,6 +157,9 @@ struct tegra_se_elp_dev {
 	u32 *rdata;
 	/* Mutex lock to protect HW */
 	struct mutex hw_lock;
+	/* Protected by hw_lock */
+	struct tegra_se_pka1_precomp_entry precomp[PKA1_PRECOMP_CACHE_SIZE];
+	unsigned int precomp_next;
 };
 
 static struct tegra_se_elp_dev *elp_dev;
@@ -2045,11 +2061,59 @@ exit:
 	return ret;
 }
 
-int tegra_se_pka1_ecc_op(struct tegra_se_pka1_ecc_request *req)
+static bool tegra_se_pka1_ecc_need_precomp(struct tegra_se_pka1_ecc_request *req)
 {
-	struct tegra_se_elp_dev *se_dev;
-	int ret;
+	return !(req->op_mode == SE_ELP_OP_MODE_ECC521 ||
+		 req->type == C25519_POINT_MUL ||
+		 req->type == ED25519_POINT_MUL ||
+		 req->type == ED25519_SHAMIR_TRICK);
+}
+
+/*
+ * M and R2 depend on the curve modulus only, so they are computed once per
+ * curve and copied into the following requests. Must be called with
+ * hw_lock and the PKA1 mutex held.
+ */
+static int tegra_se_pka1_ecc_get_precomp(struct tegra_se_pka1_ecc_request *req)
+{
+	struct tegra_se_elp_dev *se_dev = req->se_dev;
+	struct tegra_se_pka1_precomp_entry *entry;
+	int i, ret;
+
+	if (!tegra_se_pka1_ecc_need_precomp(req))
+		return 0;
+
+	for (i = 0; i < PKA1_PRECOMP_CACHE_SIZE; i++) {
+		entry = &se_dev->precomp[i];
+		if (entry->valid && entry->op_mode == req->op_mode &&
+		    entry->size == req->size &&
+		    !memcmp(entry->modulus, req->modulus, req->size)) {
+			memcpy(req->m, entry->m, req->size);
+			memcpy(req->r2, entry->r2, req->size);
+			return 0;
+		}
+	}
+
+	ret = tegra_se_pka1_get_precomp(NULL, req, NULL);
+	if (ret)
+		return ret;
+
+	entry = &se_dev->precomp[se_dev->precomp_next];
+	se_dev->precomp_next = (se_dev->precomp_next + 1) %
+				PKA1_PRECOMP_CACHE_SIZE;
+
+	entry->op_mode = req->op_mode;
+	entry->size = req->size;
+	memcpy(entry->modulus, req->modulus, req->size);
+	memcpy(entry->m, req->m, req->size);
+	memcpy(entry->r2, req->r2, req->size);
+	entry->valid = true;
 
+	return 0;
+}
+
+static int tegra_se_pka1_ecc_check(struct tegra_se_pka1_ecc_request *req)
+{
 	if (!req) {
 		pr_err("Invalid ECC request\n");
 		return -EINVAL;
@@ -2060,11 +2124,38 @@ int tegra_se_pka1_ecc_op(struct tegra_se_pka1_ecc_request *req)
 		return -EDOM;
 	}
 
-	ret = tegra_se_pka1_ecc_init(req);
-	if (ret)
-		return ret;
+	return 0;
+}
+
+/*
+ * Runs @nreqs ECC requests back to back, with the SE clock and the PKA1
+ * mutex held once for the whole batch. Returns 0 if all the requests
+ * succeeded; the requests after the first failing one are not run.
+ */
+int tegra_se_pka1_ecc_op_batch(struct tegra_se_pka1_ecc_request *reqs,
+			       unsigned int nreqs)
+{
+	struct tegra_se_elp_dev *se_dev = elp_dev;
+	unsigned int i;
+	int ret;
+
+	if (!reqs || !nreqs) {
+		pr_err("Invalid ECC request\n");
+		return -EINVAL;
+	}
+
+	for (i = 0; i < nreqs; i++) {
+		ret = tegra_se_pka1_ecc_check(&reqs[i]);
+		if (ret)
+			return ret;
+	}
+
+	for (i = 0; i < nreqs; i++) {
+		ret = tegra_se_pka1_ecc_init(&reqs[i]);
+		if (ret)
+			goto free_reqs;
+	}
 
-	se_dev = req->se_dev;
 	mutex_lock(&se_dev->hw_lock);
 	ret = clk_prepare_enable(se_dev->c);
 	if (ret) {
@@ -2078,21 +2169,37 @@ int tegra_se_pka1_ecc_op(struct tegra_se_pka1_ecc_request *req)
 		goto clk_dis;
 	}
 
-	ret = tegra_se_pka1_get_precomp(NULL, req, NULL);
-	if (ret)
-		goto exit;
+	for (i = 0; i < nreqs; i++) {
+		/* the watchdog covers one operation, not the whole batch */
+		tegra_se_restart_pka1_mutex_wdt(se_dev);
+
+		ret = tegra_se_pka1_ecc_get_precomp(&reqs[i]);
+		if (ret)
+			break;
+
+		ret = tegra_se_pka1_ecc_do(&reqs[i]);
+		if (ret)
+			break;
+	}
 
-	ret = tegra_se_pka1_ecc_do(req);
-exit:
 	tegra_se_release_pka1_mutex(se_dev);
 clk_dis:
 	clk_disable_unprepare(se_dev->c);
 ecc_exit:
 	mutex_unlock(&se_dev->hw_lock);
-	tegra_se_pka1_ecc_exit(req);
+	i = nreqs;
+free_reqs:
+	while (i--)
+		tegra_se_pka1_ecc_exit(&reqs[i]);
 
 	return ret;
 }
+EXPORT_SYMBOL(tegra_se_pka1_ecc_op_batch);
+
+int tegra_se_pka1_ecc_op(struct tegra_se_pka1_ecc_request *req)
+{
+	return tegra_se_pka1_ecc_op_batch(req, 1);
+}
 EXPORT_SYMBOL(tegra_se_pka1_ecc_op);
 
 static int tegra_se_pka1_mod_op(struct tegra_se_pka1_mod_request *req)
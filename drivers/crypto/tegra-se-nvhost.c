@@ -42,6 +42,7 @@
 #include <crypto/internal/hash.h>
 #include <crypto/internal/akcipher.h>
 #include <crypto/sha.h>
+#include <crypto/skcipher.h>
 #include <linux/tegra_pm_domains.h>
 #include <crypto/internal/kpp.h>
 #include <crypto/kpp.h>
@@ -49,6 +50,7 @@
 #include <linux/version.h>
 #include <linux/pm_qos.h>
 #include <linux/jiffies.h>
+#include <linux/wait.h>
 #include <linux/platform/tegra/emc_bwmgr.h>
 
 #include "tegra-se-nvhost.h"
@@ -139,6 +141,10 @@ struct tegra_se_dev {
 	struct tegra_se_rsa_slot *rsa_slot_list; /* rsa key slot pointer */
 	struct tegra_se_cmdbuf *cmdbuf_addr_list;
 	unsigned int cmdbuf_list_entry;
+	/* Woken up when a cmdbuf or an AES buffer is released */
+	wait_queue_head_t free_wq;
+	/* AES submits whose completion callback did not run yet */
+	atomic_t aes_inflight;
 	struct tegra_se_chipdata *chipdata; /* chip specific data */
 	u32 *src_ll_buf;	/* pointer to source linked list buffer */
 	dma_addr_t src_ll_buf_adr; /* Source linked list buffer dma address */
@@ -198,6 +204,7 @@ struct tegra_se_req_context {
 	u32 config;
 	u32 crypto_config;
 	struct tegra_se_dev *se_dev;
+	struct tegra_se_slot *slot; /* Key slot used until completion */
 };
 
 struct tegra_se_priv_data {
@@ -227,7 +234,9 @@ struct tegra_se_aes_context {
 	u32 keylen;	/* key length in bits */
 	u32 op_mode;	/* AES operation mode */
 	bool is_key_in_mem; /* Whether key is in memory */
-	u8 key[64]; /* To store key if is_key_in_mem set */
+	u8 key[64]; /* To store key, reloaded if the slot got reused */
+	struct crypto_skcipher *fallback; /* CPU cipher for small requests */
+	bool use_fallback; /* Whether fallback holds the same key */
 };
 
 /* Security Engine random number generator context */
@@ -285,6 +294,8 @@ struct tegra_se_slot {
 	struct list_head node;
 	u8 slot_num;	/* Key slot number */
 	bool available; /* Tells whether key slot is free to use */
+	void *owner;	/* AES context whose key is in the slot */
+	unsigned int users; /* Requests in flight using the slot */
 };
 
 static struct tegra_se_slot ssk_slot = {
@@ -333,6 +344,30 @@ static unsigned int boost_cpu_freq;
 module_param(boost_cpu_freq, uint, S_IRUGO | S_IWUSR);
 MODULE_PARM_DESC(boost_cpu_freq, "CPU frequency (in MHz) to boost");
 
+/* One cmdbuf is left for key and IV updates by default */
+static unsigned int max_inflight = SE_MAX_SUBMIT_CHAIN_SZ - 1;
+module_param(max_inflight, uint, S_IRUGO | S_IWUSR);
+MODULE_PARM_DESC(max_inflight, "Max AES submits in flight per SE");
+
+/* Below this size, the CPU is done before the SE job is even submitted */
+static unsigned int fallback_threshold = 256;
+module_param(fallback_threshold, uint, S_IRUGO | S_IWUSR);
+MODULE_PARM_DESC(fallback_threshold,
+		 "AES requests smaller than this (in bytes) run on the CPU");
+
+/* AES key slot cache statistics, protected by key_slot_lock */
+static unsigned long keyslot_hits;
+module_param(keyslot_hits, ulong, S_IRUGO);
+MODULE_PARM_DESC(keyslot_hits, "AES requests finding their key loaded");
+
+static unsigned long keyslot_misses;
+module_param(keyslot_misses, ulong, S_IRUGO);
+MODULE_PARM_DESC(keyslot_misses, "AES requests reloading their key");
+
+static unsigned long keyslot_evictions;
+module_param(keyslot_evictions, ulong, S_IRUGO);
+MODULE_PARM_DESC(keyslot_evictions, "AES keys evicted from their key slot");
+
 static void tegra_se_restore_cpu_freq_fn(struct work_struct *work)
 {
 	struct tegra_se_dev *se_dev = container_of(
@@ -467,6 +502,80 @@ static struct tegra_se_slot *tegra_se_alloc_key_slot(void)
 	return found ? slot : NULL;
 }
 
+static bool tegra_se_is_pool_slot(struct tegra_se_slot *slot)
+{
+	return slot && slot != &ssk_slot && slot != &keymem_slot &&
+	       slot != &srk_slot && slot != &pre_allocated_slot;
+}
+
+/*
+ * Returns the key slot holding the key of @ctx. If the key is not loaded,
+ * a free slot is taken or the least recently used idle one is evicted, and
+ * *loaded is set to false. The key_slot list is kept in LRU order.
+ * Called with key_slot_lock held.
+ */
+static struct tegra_se_slot *__tegra_se_get_aes_key_slot(
+		struct tegra_se_aes_context *ctx, bool *loaded)
+{
+	struct tegra_se_slot *slot = ctx->slot;
+
+	if (tegra_se_is_pool_slot(slot) && slot->owner == ctx) {
+		*loaded = true;
+		goto out;
+	}
+
+	*loaded = false;
+	list_for_each_entry(slot, &key_slot, node) {
+		if (slot->available &&
+		    (slot->slot_num != pre_allocated_slot.slot_num)) {
+			slot->available = false;
+			goto claim;
+		}
+	}
+
+	list_for_each_entry(slot, &key_slot, node) {
+		if (slot->owner && !slot->users &&
+		    (slot->slot_num != pre_allocated_slot.slot_num)) {
+			keyslot_evictions++;
+			goto claim;
+		}
+	}
+
+	return NULL;
+claim:
+	slot->owner = ctx;
+	ctx->slot = slot;
+out:
+	list_move_tail(&slot->node, &key_slot);
+	return slot;
+}
+
+static void tegra_se_put_aes_key_slot(struct tegra_se_aes_context *ctx)
+{
+	struct tegra_se_slot *slot = ctx->slot;
+
+	spin_lock(&key_slot_lock);
+	/* the slot may have been given to another context meanwhile */
+	if (tegra_se_is_pool_slot(slot) && slot->owner == ctx) {
+		slot->owner = NULL;
+		slot->available = true;
+	}
+	spin_unlock(&key_slot_lock);
+
+	ctx->slot = NULL;
+}
+
+static void tegra_se_aes_release_req_slot(struct tegra_se_req_context *req_ctx)
+{
+	if (!req_ctx->slot)
+		return;
+
+	spin_lock(&key_slot_lock);
+	req_ctx->slot->users--;
+	spin_unlock(&key_slot_lock);
+	req_ctx->slot = NULL;
+}
+
 static int tegra_init_key_slot(struct tegra_se_dev *se_dev)
 {
 	int i;
@@ -782,6 +891,7 @@ static void tegra_se_aes_complete_callback(void *priv, int nr_completed)
 	atomic_set(&se_dev->cmdbuf_addr_list[priv_data->cmdbuf_node].free, 1);
 
 	if (!priv_data->req_cnt) {
+		wake_up(&se_dev->free_wq);
 		devm_kfree(se_dev->dev, priv_data);
 		return;
 	}
@@ -809,6 +919,7 @@ static void tegra_se_aes_complete_callback(void *priv, int nr_completed)
 					    req->nbytes);
 
 		buf += req->nbytes;
+		tegra_se_aes_release_req_slot(ablkcipher_request_ctx(req));
 		req->base.complete(&req->base, 0);
 	}
 
@@ -825,6 +936,8 @@ static void tegra_se_aes_complete_callback(void *priv, int nr_completed)
 		atomic_set(&se_dev->aes_buf_stat[priv_data->aesbuf_entry], 1);
 	}
 
+	atomic_dec(&se_dev->aes_inflight);
+	wake_up(&se_dev->free_wq);
 	devm_kfree(se_dev->dev, priv_data);
 }
 
@@ -973,9 +1086,11 @@ static int tegra_se_channel_submit_gather(struct tegra_se_dev *se_dev,
 			se_dev->pdev, job->sp->id, job->sp->fence,
 			(u32)MAX_SCHEDULE_TIMEOUT, NULL, NULL);
 
-		if (se_dev->cmdbuf_addr_list)
+		if (se_dev->cmdbuf_addr_list) {
 			atomic_set(&se_dev->cmdbuf_addr_list[
 				   se_dev->cmdbuf_list_entry].free, 1);
+			wake_up(&se_dev->free_wq);
+		}
 	}
 
 	se_dev->req_cnt = 0;
@@ -1484,6 +1599,23 @@ static int tegra_map_sg(struct device *dev, struct scatterlist *sg,
 	return ret;
 }
 
+static bool tegra_se_claim_aes_buf(struct tegra_se_dev *se_dev,
+				   unsigned int *index)
+{
+	unsigned int i, idx = se_dev->aesbuf_entry + 1;
+
+	for (i = 0; i < SE_MAX_AESBUF_ALLOC; i++, idx++) {
+		idx = idx % SE_MAX_AESBUF_ALLOC;
+		if (atomic_cmpxchg(&se_dev->aes_buf_stat[idx], 1, 0) == 1) {
+			se_dev->aesbuf_entry = idx;
+			*index = idx;
+			return true;
+		}
+	}
+
+	return false;
+}
+
 static int tegra_se_setup_ablk_req(struct tegra_se_dev *se_dev)
 {
 	struct ablkcipher_request *req;
@@ -1504,19 +1636,10 @@ static int tegra_se_setup_ablk_req(struct tegra_se_dev *se_dev)
 			return -ENOMEM;
 		buf = se_dev->aes_buf;
 	} else {
-		index = se_dev->aesbuf_entry + 1;
-		for (i = 0; i < SE_MAX_AESBUF_TIMEOUT; i++, index++) {
-			index = index % SE_MAX_AESBUF_ALLOC;
-			if (atomic_read(&se_dev->aes_buf_stat[index])) {
-				se_dev->aesbuf_entry = index;
-				atomic_set(&se_dev->aes_buf_stat[index], 0);
-				break;
-			}
-			if (i % SE_MAX_AESBUF_ALLOC == 0)
-				udelay(SE_WAIT_UDELAY);
-		}
-
-		if (i == SE_MAX_AESBUF_TIMEOUT) {
+		if (!wait_event_timeout(se_dev->free_wq,
+				tegra_se_claim_aes_buf(se_dev, &index),
+				usecs_to_jiffies(SE_MAX_AESBUF_TIMEOUT /
+					SE_MAX_AESBUF_ALLOC * SE_WAIT_UDELAY))) {
 			pr_err("aes_buffer not available\n");
 			return -ETIMEDOUT;
 		}
@@ -1568,6 +1691,39 @@ static int tegra_se_setup_ablk_req(struct tegra_se_dev *se_dev)
 	return 0;
 }
 
+/*
+ * Adds the key of @aes_ctx for @slot_num to the cmdbuf. The _IN_MEM table
+ * types only write the key table, the cmdbuf is submitted with the request.
+ */
+static int tegra_se_aes_load_key(struct tegra_se_dev *se_dev,
+				 struct tegra_se_aes_context *aes_ctx,
+				 struct crypto_ablkcipher *tfm, u8 slot_num,
+				 u32 *cpuvaddr, dma_addr_t iova)
+{
+	u32 keylen;
+	int ret;
+
+	if (strcmp(crypto_tfm_alg_name(&tfm->base), "xts(aes)"))
+		return tegra_se_send_key_data(
+			se_dev, aes_ctx->key, aes_ctx->keylen, slot_num,
+			SE_KEY_TABLE_TYPE_KEY_IN_MEM, se_dev->opcode_addr,
+			cpuvaddr, iova, AES_CB);
+
+	keylen = aes_ctx->keylen / 2;
+	ret = tegra_se_send_key_data(se_dev, aes_ctx->key, keylen, slot_num,
+				     SE_KEY_TABLE_TYPE_XTS_KEY1_IN_MEM,
+				     se_dev->opcode_addr, cpuvaddr, iova,
+				     AES_CB);
+	if (ret)
+		return ret;
+
+	return tegra_se_send_key_data(se_dev, aes_ctx->key + keylen, keylen,
+				      slot_num,
+				      SE_KEY_TABLE_TYPE_XTS_KEY2_IN_MEM,
+				      se_dev->opcode_addr, cpuvaddr, iova,
+				      AES_CB);
+}
+
 static int tegra_se_prepare_cmdbuf(struct tegra_se_dev *se_dev,
 				   u32 *cpuvaddr, dma_addr_t iova)
 {
@@ -1576,55 +1732,50 @@ static int tegra_se_prepare_cmdbuf(struct tegra_se_dev *se_dev,
 	struct ablkcipher_request *req;
 	struct tegra_se_req_context *req_ctx;
 	struct crypto_ablkcipher *tfm;
-	u32 keylen;
+	struct tegra_se_slot *slot;
+	bool loaded;
 
 	for (i = 0; i < se_dev->req_cnt; i++) {
 		req = se_dev->reqs[i];
 		tfm = crypto_ablkcipher_reqtfm(req);
 		aes_ctx = crypto_ablkcipher_ctx(tfm);
+		req_ctx = ablkcipher_request_ctx(req);
 		/* Ensure there is valid slot info */
-		if (!aes_ctx->slot) {
+		if (!aes_ctx->slot && !aes_ctx->keylen) {
 			dev_err(se_dev->dev, "Invalid AES Ctx Slot\n");
 			return -EINVAL;
 		}
 
-		if (aes_ctx->is_key_in_mem) {
-			if (strcmp(crypto_tfm_alg_name(&tfm->base),
-					       "xts(aes)")) {
-				ret = tegra_se_send_key_data(
-					se_dev, aes_ctx->key, aes_ctx->keylen,
-					aes_ctx->slot->slot_num,
-					SE_KEY_TABLE_TYPE_KEY_IN_MEM,
-					se_dev->opcode_addr, cpuvaddr, iova,
-					AES_CB);
-			} else {
-				keylen = aes_ctx->keylen / 2;
-				ret = tegra_se_send_key_data(se_dev,
-					aes_ctx->key, keylen,
-					aes_ctx->slot->slot_num,
-					SE_KEY_TABLE_TYPE_XTS_KEY1_IN_MEM,
-					se_dev->opcode_addr, cpuvaddr, iova,
-					AES_CB);
-				if (ret) {
-					dev_err(se_dev->dev, "Error in setting Key\n");
-					goto out;
-				}
-
-				ret = tegra_se_send_key_data(se_dev,
-					aes_ctx->key + keylen, keylen,
-					aes_ctx->slot->slot_num,
-					SE_KEY_TABLE_TYPE_XTS_KEY2_IN_MEM,
-					se_dev->opcode_addr, cpuvaddr, iova,
-					AES_CB);
+		slot = aes_ctx->slot;
+		loaded = !aes_ctx->is_key_in_mem;
+		if (!slot || tegra_se_is_pool_slot(slot)) {
+			spin_lock(&key_slot_lock);
+			slot = __tegra_se_get_aes_key_slot(aes_ctx, &loaded);
+			if (slot) {
+				slot->users++;
+				req_ctx->slot = slot;
 			}
+			if (loaded)
+				keyslot_hits++;
+			else
+				keyslot_misses++;
+			spin_unlock(&key_slot_lock);
+
+			/* all slots busy, load the key for this request only */
+			if (!slot)
+				slot = &keymem_slot;
+		}
+
+		if (!loaded) {
+			ret = tegra_se_aes_load_key(se_dev, aes_ctx, tfm,
+						    slot->slot_num, cpuvaddr,
+						    iova);
 			if (ret) {
 				dev_err(se_dev->dev, "Error in setting Key\n");
 				goto out;
 			}
 		}
 
-		req_ctx = ablkcipher_request_ctx(req);
-
 		if (req->info) {
 			if (req_ctx->op_mode == SE_AES_OP_MODE_CTR ||
 			    req_ctx->op_mode == SE_AES_OP_MODE_XTS) {
@@ -1634,7 +1785,7 @@ static int tegra_se_prepare_cmdbuf(struct tegra_se_dev *se_dev,
 			} else {
 				ret = tegra_se_send_key_data(
 				se_dev, req->info, TEGRA_SE_AES_IV_SIZE,
-				aes_ctx->slot->slot_num,
+				slot->slot_num,
 				SE_KEY_TABLE_TYPE_UPDTDIV, se_dev->opcode_addr,
 				cpuvaddr, iova, AES_CB);
 			}
@@ -1649,7 +1800,7 @@ static int tegra_se_prepare_cmdbuf(struct tegra_se_dev *se_dev,
 		req_ctx->crypto_config = tegra_se_get_crypto_config(
 						se_dev, req_ctx->op_mode,
 						req_ctx->encrypt,
-						aes_ctx->slot->slot_num, false);
+						slot->slot_num, false);
 
 		tegra_se_send_data(se_dev, req_ctx, req, req->nbytes,
 				   se_dev->opcode_addr, cpuvaddr);
@@ -1659,22 +1810,50 @@ out:
 	return ret;
 }
 
-static int tegra_se_get_free_cmdbuf(struct tegra_se_dev *se_dev)
+static bool tegra_se_claim_cmdbuf(struct tegra_se_dev *se_dev,
+				  unsigned int *index)
 {
-	int i = 0;
-	unsigned int index = se_dev->cmdbuf_list_entry + 1;
-
-	for (i = 0; i < SE_MAX_CMDBUF_TIMEOUT; i++, index++) {
-		index = index % SE_MAX_SUBMIT_CHAIN_SZ;
-		if (atomic_read(&se_dev->cmdbuf_addr_list[index].free)) {
-			atomic_set(&se_dev->cmdbuf_addr_list[index].free, 0);
-			break;
+	unsigned int i, idx = se_dev->cmdbuf_list_entry + 1;
+
+	for (i = 0; i < SE_MAX_SUBMIT_CHAIN_SZ; i++, idx++) {
+		idx = idx % SE_MAX_SUBMIT_CHAIN_SZ;
+		if (atomic_cmpxchg(&se_dev->cmdbuf_addr_list[idx].free,
+				   1, 0) == 1) {
+			*index = idx;
+			return true;
 		}
-		if (i % SE_MAX_SUBMIT_CHAIN_SZ == 0)
-			udelay(SE_WAIT_UDELAY);
 	}
 
-	return (i == SE_MAX_CMDBUF_TIMEOUT) ? -ENOMEM : index;
+	return false;
+}
+
+/*
+ * Cmdbufs are released by the completion callbacks of the submits in
+ * flight, sleep until one of them runs instead of polling.
+ */
+static int tegra_se_get_free_cmdbuf(struct tegra_se_dev *se_dev)
+{
+	unsigned int index = 0;
+
+	if (!wait_event_timeout(se_dev->free_wq,
+			tegra_se_claim_cmdbuf(se_dev, &index),
+			usecs_to_jiffies(SE_MAX_CMDBUF_TIMEOUT /
+				SE_MAX_SUBMIT_CHAIN_SZ * SE_WAIT_UDELAY)))
+		return -ENOMEM;
+
+	return index;
+}
+
+static inline unsigned int tegra_se_max_inflight(void)
+{
+	return clamp_t(unsigned int, READ_ONCE(max_inflight), 1,
+		       SE_MAX_SUBMIT_CHAIN_SZ);
+}
+
+static bool tegra_se_start_inflight(struct tegra_se_dev *se_dev)
+{
+	return atomic_add_unless(&se_dev->aes_inflight, 1,
+				 tegra_se_max_inflight());
 }
 
 static void tegra_se_process_new_req(struct tegra_se_dev *se_dev)
@@ -1687,6 +1866,19 @@ static void tegra_se_process_new_req(struct tegra_se_dev *se_dev)
 
 	tegra_se_boost_cpu_freq(se_dev);
 
+	/*
+	 * Completion is reported from the syncpoint interrupt, so the
+	 * next batch is prepared while up to max_inflight others run.
+	 */
+	if (!wait_event_timeout(se_dev->free_wq,
+			tegra_se_start_inflight(se_dev),
+			usecs_to_jiffies(SE_MAX_CMDBUF_TIMEOUT /
+				SE_MAX_SUBMIT_CHAIN_SZ * SE_WAIT_UDELAY))) {
+		dev_err(se_dev->dev, "Too many submits in flight\n");
+		err = -EBUSY;
+		goto mem_out;
+	}
+
 	for (i = 0; i < se_dev->req_cnt; i++) {
 		req = se_dev->reqs[i];
 		if (req->nbytes != SE_STATIC_MEM_ALLOC_BUFSZ) {
@@ -1697,7 +1889,7 @@ static void tegra_se_process_new_req(struct tegra_se_dev *se_dev)
 
 	err = tegra_se_setup_ablk_req(se_dev);
 	if (err)
-		goto mem_out;
+		goto inflight_out;
 
 	err = tegra_se_get_free_cmdbuf(se_dev);
 	if (err < 0) {
@@ -1727,9 +1919,13 @@ cmdbuf_out:
 index_out:
 	dma_unmap_sg(se_dev->dev, &se_dev->sg, 1, DMA_BIDIRECTIONAL);
 	kfree(se_dev->aes_buf);
+inflight_out:
+	atomic_dec(&se_dev->aes_inflight);
+	wake_up(&se_dev->free_wq);
 mem_out:
 	for (i = 0; i < se_dev->req_cnt; i++) {
 		req = se_dev->reqs[i];
+		tegra_se_aes_release_req_slot(ablkcipher_request_ctx(req));
 		req->base.complete(&req->base, err);
 	}
 	se_dev->req_cnt = 0;
@@ -1781,11 +1977,43 @@ static void tegra_se_work_handler(struct work_struct *work)
 	mutex_unlock(&se_dev->mtx);
 }
 
+static int tegra_se_aes_fallback(struct ablkcipher_request *req, bool encrypt)
+{
+	struct tegra_se_aes_context *ctx =
+		crypto_ablkcipher_ctx(crypto_ablkcipher_reqtfm(req));
+	SKCIPHER_REQUEST_ON_STACK(subreq, ctx->fallback);
+	int err;
+
+	skcipher_request_set_tfm(subreq, ctx->fallback);
+	skcipher_request_set_callback(subreq, req->base.flags, NULL, NULL);
+	skcipher_request_set_crypt(subreq, req->src, req->dst, req->nbytes,
+				   req->info);
+	if (encrypt)
+		err = crypto_skcipher_encrypt(subreq);
+	else
+		err = crypto_skcipher_decrypt(subreq);
+	skcipher_request_zero(subreq);
+
+	return err;
+}
+
 static int tegra_se_aes_queue_req(struct tegra_se_dev *se_dev,
 				  struct ablkcipher_request *req)
 {
+	struct tegra_se_req_context *req_ctx = ablkcipher_request_ctx(req);
+	struct tegra_se_aes_context *ctx =
+		crypto_ablkcipher_ctx(crypto_ablkcipher_reqtfm(req));
 	int err = 0;
 
+	/*
+	 * Small requests are dominated by the cmdbuf setup and the syncpoint
+	 * interrupt, run them synchronously on the CPU when the key allows.
+	 */
+	if (ctx->use_fallback && req->nbytes < READ_ONCE(fallback_threshold))
+		return tegra_se_aes_fallback(req, req_ctx->encrypt);
+
+	req_ctx->slot = NULL;
+
 	mutex_lock(&se_dev->lock);
 	err = ablkcipher_enqueue_request(&se_dev->queue, req);
 
@@ -1935,6 +2163,18 @@ static void tegra_se_init_aesbuf(struct tegra_se_dev *se_dev)
 	}
 }
 
+static void tegra_se_aes_set_fallback_key(struct tegra_se_aes_context *ctx,
+					  const u8 *key, u32 keylen)
+{
+	ctx->use_fallback = false;
+	if (!ctx->fallback)
+		return;
+
+	crypto_skcipher_clear_flags(ctx->fallback, CRYPTO_TFM_REQ_MASK);
+	if (!crypto_skcipher_setkey(ctx->fallback, key, keylen))
+		ctx->use_fallback = true;
+}
+
 static int tegra_se_aes_setkey(struct crypto_ablkcipher *tfm,
 			       const u8 *key, u32 keylen)
 {
@@ -1946,6 +2186,7 @@ static int tegra_se_aes_setkey(struct crypto_ablkcipher *tfm,
 	unsigned int index = 0;
 	u32 *cpuvaddr = NULL;
 	dma_addr_t iova = 0;
+	bool loaded, same_key;
 
 	se_dev = se_devices[SE_AES];
 
@@ -1954,6 +2195,8 @@ static int tegra_se_aes_setkey(struct crypto_ablkcipher *tfm,
 		return -EINVAL;
 	}
 	ctx->se_dev = se_dev;
+	/* key slot references cannot be used by the CPU */
+	ctx->use_fallback = false;
 
 	if (((keylen & SE_KEY_LEN_MASK) != TEGRA_SE_KEY_128_SIZE) &&
 	    ((keylen & SE_KEY_LEN_MASK) != TEGRA_SE_KEY_192_SIZE) &&
@@ -1964,29 +2207,40 @@ static int tegra_se_aes_setkey(struct crypto_ablkcipher *tfm,
 	}
 
 	if ((keylen >> SE_MAGIC_PATTERN_OFFSET) == SE_STORE_KEY_IN_MEM) {
+		tegra_se_put_aes_key_slot(ctx);
 		ctx->is_key_in_mem = true;
 		ctx->keylen = (keylen & SE_KEY_LEN_MASK);
 		ctx->slot = &keymem_slot;
 		memcpy(ctx->key, key, ctx->keylen);
+		tegra_se_aes_set_fallback_key(ctx, key, ctx->keylen);
 		return 0;
 	}
 	ctx->is_key_in_mem = false;
 
 	mutex_lock(&se_dev->mtx);
 	if (key) {
-		if (!ctx->slot ||
-		    (ctx->slot &&
-		     ctx->slot->slot_num == ssk_slot.slot_num)) {
-			pslot = tegra_se_alloc_key_slot();
-			if (!pslot) {
-				dev_err(se_dev->dev, "no free key slot\n");
-				mutex_unlock(&se_dev->mtx);
-				return -ENOMEM;
-			}
-			ctx->slot = pslot;
-		}
+		same_key = ctx->keylen == keylen &&
+			   !memcmp(ctx->key, key, keylen);
+		if (!tegra_se_is_pool_slot(ctx->slot))
+			ctx->slot = NULL;
+		memcpy(ctx->key, key, keylen);
 		ctx->keylen = keylen;
+
+		spin_lock(&key_slot_lock);
+		pslot = __tegra_se_get_aes_key_slot(ctx, &loaded);
+		spin_unlock(&key_slot_lock);
+		if (!pslot) {
+			/* every slot is busy, the first request loads the key */
+			ctx->slot = NULL;
+			tegra_se_aes_set_fallback_key(ctx, key, ctx->keylen);
+			goto out;
+		}
+		if (loaded && same_key) {
+			tegra_se_aes_set_fallback_key(ctx, key, ctx->keylen);
+			goto out;
+		}
 	} else if ((keylen >> SE_MAGIC_PATTERN_OFFSET) == SE_MAGIC_PATTERN) {
+		tegra_se_put_aes_key_slot(ctx);
 		ctx->slot = &pre_allocated_slot;
 		spin_lock(&key_slot_lock);
 		pre_allocated_slot.slot_num =
@@ -1995,7 +2249,7 @@ static int tegra_se_aes_setkey(struct crypto_ablkcipher *tfm,
 		ctx->keylen = (keylen & SE_KEY_LEN_MASK);
 		goto out;
 	} else {
-		tegra_se_free_key_slot(ctx->slot);
+		tegra_se_put_aes_key_slot(ctx);
 		ctx->slot = &ssk_slot;
 		ctx->keylen = AES_KEYSIZE_128;
 		goto out;
@@ -2038,7 +2292,9 @@ static int tegra_se_aes_setkey(struct crypto_ablkcipher *tfm,
 	}
 keyslt_free:
 	if (ret)
-		tegra_se_free_key_slot(ctx->slot);
+		tegra_se_put_aes_key_slot(ctx);
+	else
+		tegra_se_aes_set_fallback_key(ctx, key, ctx->keylen);
 out:
 	mutex_unlock(&se_dev->mtx);
 
@@ -2047,8 +2303,18 @@ out:
 
 static int tegra_se_aes_cra_init(struct crypto_tfm *tfm)
 {
+	struct tegra_se_aes_context *ctx = crypto_tfm_ctx(tfm);
+
 	tfm->crt_ablkcipher.reqsize = sizeof(struct tegra_se_req_context);
 
+	/* Optional, not every mode has a CPU implementation */
+	ctx->fallback = crypto_alloc_skcipher(crypto_tfm_alg_name(tfm), 0,
+					      CRYPTO_ALG_ASYNC |
+					      CRYPTO_ALG_NEED_FALLBACK);
+	if (IS_ERR(ctx->fallback))
+		ctx->fallback = NULL;
+	ctx->use_fallback = false;
+
 	return 0;
 }
 
@@ -2056,8 +2322,12 @@ static void tegra_se_aes_cra_exit(struct crypto_tfm *tfm)
 {
 	struct tegra_se_aes_context *ctx = crypto_tfm_ctx(tfm);
 
-	tegra_se_free_key_slot(ctx->slot);
-	ctx->slot = NULL;
+	tegra_se_put_aes_key_slot(ctx);
+	memzero_explicit(ctx->key, sizeof(ctx->key));
+
+	if (ctx->fallback)
+		crypto_free_skcipher(ctx->fallback);
+	ctx->fallback = NULL;
 }
 
 static int tegra_se_rng_drbg_init(struct crypto_tfm *tfm)
@@ -3824,7 +4094,8 @@ static struct crypto_alg aes_algs[] = {
 		.cra_name = "xts(aes)",
 		.cra_driver_name = "xts-aes-tegra",
 		.cra_priority = 300,
-		.cra_flags = CRYPTO_ALG_TYPE_ABLKCIPHER | CRYPTO_ALG_ASYNC,
+		.cra_flags = CRYPTO_ALG_TYPE_ABLKCIPHER | CRYPTO_ALG_ASYNC |
+			     CRYPTO_ALG_NEED_FALLBACK,
 		.cra_blocksize = TEGRA_SE_AES_BLOCK_SIZE,
 		.cra_ctxsize  = sizeof(struct tegra_se_aes_context),
 		.cra_alignmask = 0,
@@ -3844,7 +4115,8 @@ static struct crypto_alg aes_algs[] = {
 		.cra_name = "cbc(aes)",
 		.cra_driver_name = "cbc-aes-tegra",
 		.cra_priority = 300,
-		.cra_flags = CRYPTO_ALG_TYPE_ABLKCIPHER | CRYPTO_ALG_ASYNC,
+		.cra_flags = CRYPTO_ALG_TYPE_ABLKCIPHER | CRYPTO_ALG_ASYNC |
+			     CRYPTO_ALG_NEED_FALLBACK,
 		.cra_blocksize = TEGRA_SE_AES_BLOCK_SIZE,
 		.cra_ctxsize  = sizeof(struct tegra_se_aes_context),
 		.cra_alignmask = 0,
@@ -3864,7 +4136,8 @@ static struct crypto_alg aes_algs[] = {
 		.cra_name = "ecb(aes)",
 		.cra_driver_name = "ecb-aes-tegra",
 		.cra_priority = 300,
-		.cra_flags = CRYPTO_ALG_TYPE_ABLKCIPHER | CRYPTO_ALG_ASYNC,
+		.cra_flags = CRYPTO_ALG_TYPE_ABLKCIPHER | CRYPTO_ALG_ASYNC |
+			     CRYPTO_ALG_NEED_FALLBACK,
 		.cra_blocksize = TEGRA_SE_AES_BLOCK_SIZE,
 		.cra_ctxsize  = sizeof(struct tegra_se_aes_context),
 		.cra_alignmask = 0,
@@ -3884,7 +4157,8 @@ static struct crypto_alg aes_algs[] = {
 		.cra_name = "ctr(aes)",
 		.cra_driver_name = "ctr-aes-tegra",
 		.cra_priority = 300,
-		.cra_flags = CRYPTO_ALG_TYPE_ABLKCIPHER | CRYPTO_ALG_ASYNC,
+		.cra_flags = CRYPTO_ALG_TYPE_ABLKCIPHER | CRYPTO_ALG_ASYNC |
+			     CRYPTO_ALG_NEED_FALLBACK,
 		.cra_blocksize = TEGRA_SE_AES_BLOCK_SIZE,
 		.cra_ctxsize  = sizeof(struct tegra_se_aes_context),
 		.cra_alignmask = 0,
@@ -3905,7 +4179,8 @@ static struct crypto_alg aes_algs[] = {
 		.cra_name = "ofb(aes)",
 		.cra_driver_name = "ofb-aes-tegra",
 		.cra_priority = 300,
-		.cra_flags = CRYPTO_ALG_TYPE_ABLKCIPHER | CRYPTO_ALG_ASYNC,
+		.cra_flags = CRYPTO_ALG_TYPE_ABLKCIPHER | CRYPTO_ALG_ASYNC |
+			     CRYPTO_ALG_NEED_FALLBACK,
 		.cra_blocksize = TEGRA_SE_AES_BLOCK_SIZE,
 		.cra_ctxsize  = sizeof(struct tegra_se_aes_context),
 		.cra_alignmask = 0,
@@ -4239,6 +4514,8 @@ static int tegra_se_probe(struct platform_device *pdev)
 
 	mutex_init(&se_dev->lock);
 	crypto_init_queue(&se_dev->queue, TEGRA_SE_CRYPTO_QUEUE_LENGTH);
+	init_waitqueue_head(&se_dev->free_wq);
+	atomic_set(&se_dev->aes_inflight, 0);
 
 	se_dev->dev = &pdev->dev;
 	se_dev->pdev = pdev;
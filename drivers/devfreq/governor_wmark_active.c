@@ -30,7 +30,11 @@ struct wmark_gov_param {
 	unsigned int		load_target;
 	unsigned int		load_max;
 	unsigned int		smooth;
+	unsigned int		smooth_up;
+	unsigned int		up_steps;
+	unsigned int		down_steps;
 	bool			freq_boost_en;
+	bool			burst_en;
 };
 
 struct wmark_gov_info {
@@ -46,6 +50,10 @@ struct wmark_gov_info {
 	struct kobj_attribute	load_max_attr;
 	struct kobj_attribute	smooth_attr;
 	struct kobj_attribute	freq_boost_en_attr;
+	struct kobj_attribute	smooth_up_attr;
+	struct kobj_attribute	up_steps_attr;
+	struct kobj_attribute	down_steps_attr;
+	struct kobj_attribute	burst_en_attr;
 
 	spinlock_t		param_lock;
 
@@ -104,6 +112,38 @@ static unsigned long freqlist_round(struct wmark_gov_info *wmarkinfo,
 	return wmarkinfo->freqlist[pos];
 }
 
+/*
+ * freqlist_limit - Limit a frequency change to a number of table steps
+ *     @curr_freq: frequency we are changing from
+ *     @freq: frequency we would like to change to
+ *     @up_steps, @down_steps: maximum steps up and down, 0 if unlimited
+ */
+static unsigned long freqlist_limit(struct wmark_gov_info *wmarkinfo,
+				    unsigned long curr_freq,
+				    unsigned long freq,
+				    unsigned int up_steps,
+				    unsigned int down_steps)
+{
+	int i, pos;
+
+	up_steps = min_t(unsigned int, up_steps, wmarkinfo->freq_count);
+	down_steps = min_t(unsigned int, down_steps, wmarkinfo->freq_count);
+
+	for (i = 0; i < wmarkinfo->freq_count - 1; i++)
+		if (wmarkinfo->freqlist[i] >= curr_freq)
+			break;
+
+	if (freq > curr_freq && up_steps) {
+		pos = min_t(int, wmarkinfo->freq_count - 1, i + up_steps);
+		freq = min(freq, wmarkinfo->freqlist[pos]);
+	} else if (freq < curr_freq && down_steps) {
+		pos = max_t(int, 0, i - (int)down_steps);
+		freq = max(freq, wmarkinfo->freqlist[pos]);
+	}
+
+	return freq;
+}
+
 
  /*
   * update_watermarks - Re-estimate low and high watermarks
@@ -173,6 +213,8 @@ static int devfreq_watermark_target_freq(struct devfreq *df,
 	s64 dt = ktime_us_delta(current_time, wmarkinfo->last_frequency_update);
 	int err;
 	unsigned long flags;
+	unsigned int smooth;
+	bool burst;
 
 	struct wmark_gov_param param;
 
@@ -215,17 +257,34 @@ static int devfreq_watermark_target_freq(struct devfreq *df,
 		ideal_freq = freqlist_round(wmarkinfo, ideal_freq);
 	}
 
-	/* update average target frequency */
-	wmarkinfo->average_target_freq =
-		(param.smooth * wmarkinfo->average_target_freq +
-		 ideal_freq) / (param.smooth + 1);
+	/* a burst needs more than one step up at once. go there directly
+	 * instead of ramping through the average, a frame paced engine
+	 * would miss its deadline on the way up. */
+	burst = param.burst_en &&
+		ideal_freq > freqlist_up(wmarkinfo, dev_stat.current_frequency);
+
+	if (burst) {
+		wmarkinfo->average_target_freq = ideal_freq;
+	} else {
+		/* update average target frequency, ramp up and down can
+		 * be smoothed differently */
+		smooth = ideal_freq > wmarkinfo->average_target_freq ?
+			param.smooth_up : param.smooth;
+		wmarkinfo->average_target_freq =
+			(smooth * wmarkinfo->average_target_freq +
+			 ideal_freq) / (smooth + 1);
+	}
 
 	/* do not scale too often */
-	if (dt < param.block_window)
+	if (!burst && dt < param.block_window)
 		return 0;
 
 	/* update the frequency */
 	*freq = freqlist_round(wmarkinfo, wmarkinfo->average_target_freq);
+	if (!burst)
+		*freq = freqlist_limit(wmarkinfo, dev_stat.current_frequency,
+				       *freq, param.up_steps,
+				       param.down_steps);
 
 	/* check if frequency actually got updated */
 	if (*freq == dev_stat.current_frequency)
@@ -457,6 +516,182 @@ static ssize_t freq_boost_en_store(struct kobject *kobj,
 	return count;
 }
 
+static ssize_t smooth_up_show(struct kobject *kobj,
+					struct kobj_attribute *attr,
+					char *buf)
+{
+	struct wmark_gov_info *wmarkinfo = NULL;
+	ssize_t res;
+	unsigned int val;
+	unsigned long flags;
+
+	wmarkinfo = container_of(attr,
+			struct wmark_gov_info,
+			smooth_up_attr);
+
+	spin_lock_irqsave(&wmarkinfo->param_lock, flags);
+	val = wmarkinfo->param.smooth_up;
+	spin_unlock_irqrestore(&wmarkinfo->param_lock, flags);
+
+	res = snprintf(buf, PAGE_SIZE, "%u\n", val);
+
+	return res;
+}
+
+static ssize_t smooth_up_store(struct kobject *kobj,
+					struct kobj_attribute *attr,
+					const char *buf, size_t count)
+{
+	struct wmark_gov_info *wmarkinfo = NULL;
+	unsigned long val = 0;
+	unsigned long flags;
+
+	wmarkinfo = container_of(attr,
+			struct wmark_gov_info,
+			smooth_up_attr);
+
+	if (kstrtoul(buf, 10, &val) < 0)
+		return -EINVAL;
+
+	spin_lock_irqsave(&wmarkinfo->param_lock, flags);
+	wmarkinfo->param.smooth_up = val;
+	spin_unlock_irqrestore(&wmarkinfo->param_lock, flags);
+
+	return count;
+}
+
+static ssize_t up_steps_show(struct kobject *kobj,
+					struct kobj_attribute *attr,
+					char *buf)
+{
+	struct wmark_gov_info *wmarkinfo = NULL;
+	ssize_t res;
+	unsigned int val;
+	unsigned long flags;
+
+	wmarkinfo = container_of(attr,
+			struct wmark_gov_info,
+			up_steps_attr);
+
+	spin_lock_irqsave(&wmarkinfo->param_lock, flags);
+	val = wmarkinfo->param.up_steps;
+	spin_unlock_irqrestore(&wmarkinfo->param_lock, flags);
+
+	res = snprintf(buf, PAGE_SIZE, "%u\n", val);
+
+	return res;
+}
+
+static ssize_t up_steps_store(struct kobject *kobj,
+					struct kobj_attribute *attr,
+					const char *buf, size_t count)
+{
+	struct wmark_gov_info *wmarkinfo = NULL;
+	unsigned long val = 0;
+	unsigned long flags;
+
+	wmarkinfo = container_of(attr,
+			struct wmark_gov_info,
+			up_steps_attr);
+
+	if (kstrtoul(buf, 10, &val) < 0)
+		return -EINVAL;
+
+	spin_lock_irqsave(&wmarkinfo->param_lock, flags);
+	wmarkinfo->param.up_steps = val;
+	spin_unlock_irqrestore(&wmarkinfo->param_lock, flags);
+
+	return count;
+}
+
+static ssize_t down_steps_show(struct kobject *kobj,
+					struct kobj_attribute *attr,
+					char *buf)
+{
+	struct wmark_gov_info *wmarkinfo = NULL;
+	ssize_t res;
+	unsigned int val;
+	unsigned long flags;
+
+	wmarkinfo = container_of(attr,
+			struct wmark_gov_info,
+			down_steps_attr);
+
+	spin_lock_irqsave(&wmarkinfo->param_lock, flags);
+	val = wmarkinfo->param.down_steps;
+	spin_unlock_irqrestore(&wmarkinfo->param_lock, flags);
+
+	res = snprintf(buf, PAGE_SIZE, "%u\n", val);
+
+	return res;
+}
+
+static ssize_t down_steps_store(struct kobject *kobj,
+					struct kobj_attribute *attr,
+					const char *buf, size_t count)
+{
+	struct wmark_gov_info *wmarkinfo = NULL;
+	unsigned long val = 0;
+	unsigned long flags;
+
+	wmarkinfo = container_of(attr,
+			struct wmark_gov_info,
+			down_steps_attr);
+
+	if (kstrtoul(buf, 10, &val) < 0)
+		return -EINVAL;
+
+	spin_lock_irqsave(&wmarkinfo->param_lock, flags);
+	wmarkinfo->param.down_steps = val;
+	spin_unlock_irqrestore(&wmarkinfo->param_lock, flags);
+
+	return count;
+}
+
+static ssize_t burst_en_show(struct kobject *kobj,
+					struct kobj_attribute *attr,
+					char *buf)
+{
+	struct wmark_gov_info *wmarkinfo = NULL;
+	ssize_t res;
+	bool val;
+	unsigned long flags;
+
+	wmarkinfo = container_of(attr,
+			struct wmark_gov_info,
+			burst_en_attr);
+
+	spin_lock_irqsave(&wmarkinfo->param_lock, flags);
+	val = wmarkinfo->param.burst_en;
+	spin_unlock_irqrestore(&wmarkinfo->param_lock, flags);
+
+	res = snprintf(buf, PAGE_SIZE, "%d\n", val);
+
+	return res;
+}
+
+static ssize_t burst_en_store(struct kobject *kobj,
+					struct kobj_attribute *attr,
+					const char *buf, size_t count)
+{
+	struct wmark_gov_info *wmarkinfo = NULL;
+	unsigned long val = 0;
+	unsigned long flags;
+
+	wmarkinfo = container_of(attr,
+			struct wmark_gov_info,
+			burst_en_attr);
+
+	if (kstrtoul(buf, 10, &val) < 0)
+		return -EINVAL;
+
+	spin_lock_irqsave(&wmarkinfo->param_lock, flags);
+	wmarkinfo->param.burst_en = !!val;
+	spin_unlock_irqrestore(&wmarkinfo->param_lock, flags);
+
+	return count;
+}
+
 #define INIT_SYSFS_ATTR_RW(sysfs_name) \
 	do { \
 		attr->attr.name = #sysfs_name; \
@@ -501,8 +736,40 @@ static int devfreq_watermark_debug_start(struct devfreq *df)
 	if (sysfs_create_file(&df->dev.parent->kobj, &attr->attr))
 		goto err_create_freq_boost_en_sysfs_entry;
 
+	attr = &wmarkinfo->smooth_up_attr;
+	INIT_SYSFS_ATTR_RW(smooth_up);
+	if (sysfs_create_file(&df->dev.parent->kobj, &attr->attr))
+		goto err_create_smooth_up_sysfs_entry;
+
+	attr = &wmarkinfo->up_steps_attr;
+	INIT_SYSFS_ATTR_RW(up_steps);
+	if (sysfs_create_file(&df->dev.parent->kobj, &attr->attr))
+		goto err_create_up_steps_sysfs_entry;
+
+	attr = &wmarkinfo->down_steps_attr;
+	INIT_SYSFS_ATTR_RW(down_steps);
+	if (sysfs_create_file(&df->dev.parent->kobj, &attr->attr))
+		goto err_create_down_steps_sysfs_entry;
+
+	attr = &wmarkinfo->burst_en_attr;
+	INIT_SYSFS_ATTR_RW(burst_en);
+	if (sysfs_create_file(&df->dev.parent->kobj, &attr->attr))
+		goto err_create_burst_en_sysfs_entry;
+
 	return 0;
 
+err_create_burst_en_sysfs_entry:
+	sysfs_remove_file(&df->dev.parent->kobj,
+			&wmarkinfo->down_steps_attr.attr);
+err_create_down_steps_sysfs_entry:
+	sysfs_remove_file(&df->dev.parent->kobj,
+			&wmarkinfo->up_steps_attr.attr);
+err_create_up_steps_sysfs_entry:
+	sysfs_remove_file(&df->dev.parent->kobj,
+			&wmarkinfo->smooth_up_attr.attr);
+err_create_smooth_up_sysfs_entry:
+	sysfs_remove_file(&df->dev.parent->kobj,
+			&wmarkinfo->freq_boost_en_attr.attr);
 err_create_freq_boost_en_sysfs_entry:
 	sysfs_remove_file(&df->dev.parent->kobj,
 			&wmarkinfo->smooth_attr.attr);
@@ -524,6 +791,14 @@ static void devfreq_watermark_debug_stop(struct devfreq *df)
 {
 	struct wmark_gov_info *wmarkinfo = df->data;
 
+	sysfs_remove_file(&df->dev.parent->kobj,
+			&wmarkinfo->burst_en_attr.attr);
+	sysfs_remove_file(&df->dev.parent->kobj,
+			&wmarkinfo->down_steps_attr.attr);
+	sysfs_remove_file(&df->dev.parent->kobj,
+			&wmarkinfo->up_steps_attr.attr);
+	sysfs_remove_file(&df->dev.parent->kobj,
+			&wmarkinfo->smooth_up_attr.attr);
 	sysfs_remove_file(&df->dev.parent->kobj,
 			&wmarkinfo->freq_boost_en_attr.attr);
 	sysfs_remove_file(&df->dev.parent->kobj,
@@ -557,6 +832,7 @@ static int devfreq_watermark_start(struct devfreq *df)
 	wmarkinfo->param.load_target = 700;
 	wmarkinfo->param.load_max = 900;
 	wmarkinfo->param.smooth = 10;
+	wmarkinfo->param.smooth_up = 10;
 	wmarkinfo->param.block_window = 50000;
 	wmarkinfo->param.freq_boost_en = true;
 	wmarkinfo->df = df;
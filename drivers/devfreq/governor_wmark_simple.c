@@ -39,6 +39,8 @@ struct wmark_gov_info {
 	/* algorithm parameters */
 	unsigned int		p_high_wmark;
 	unsigned int		p_low_wmark;
+	unsigned int		p_up_steps;
+	unsigned int		p_down_steps;
 
 	/* dynamically changing data */
 	enum watermark_type	event;
@@ -77,6 +79,24 @@ static unsigned long freqlist_down(struct wmark_gov_info *wmarkinfo,
 	return wmarkinfo->freqlist[pos];
 }
 
+/* step up and down by a different number of table entries */
+static unsigned long freqlist_step(struct wmark_gov_info *wmarkinfo,
+			unsigned long curr_freq, bool up)
+{
+	unsigned int steps = up ? wmarkinfo->p_up_steps :
+				  wmarkinfo->p_down_steps;
+	unsigned long freq = curr_freq;
+	int i;
+
+	/* always move at least one step, at most to the end of the table */
+	steps = clamp_t(unsigned int, steps, 1, wmarkinfo->freq_count);
+	for (i = 0; i < steps; i++)
+		freq = up ? freqlist_up(wmarkinfo, freq) :
+			    freqlist_down(wmarkinfo, freq);
+
+	return freq;
+}
+
 static int devfreq_watermark_target_freq(struct devfreq *df,
 			unsigned long *freq)
 {
@@ -90,7 +110,8 @@ static int devfreq_watermark_target_freq(struct devfreq *df,
 
 	switch (wmarkinfo->event) {
 	case HIGH_WATERMARK_EVENT:
-		*freq = freqlist_up(wmarkinfo, dev_stat.current_frequency);
+		*freq = freqlist_step(wmarkinfo, dev_stat.current_frequency,
+				      true);
 
 		/* always enable low watermark */
 		df->profile->set_low_wmark(df->dev.parent,
@@ -101,7 +122,8 @@ static int devfreq_watermark_target_freq(struct devfreq *df,
 			df->profile->set_high_wmark(df->dev.parent, 1000);
 		break;
 	case LOW_WATERMARK_EVENT:
-		*freq = freqlist_down(wmarkinfo, dev_stat.current_frequency);
+		*freq = freqlist_step(wmarkinfo, dev_stat.current_frequency,
+				      false);
 
 		/* always enable high watermark */
 		df->profile->set_high_wmark(df->dev.parent,
@@ -152,6 +174,8 @@ static void devfreq_watermark_debug_start(struct devfreq *df)
 
 	CREATE_DBG_FILE(low_wmark);
 	CREATE_DBG_FILE(high_wmark);
+	CREATE_DBG_FILE(up_steps);
+	CREATE_DBG_FILE(down_steps);
 #undef CREATE_DBG_FILE
 
 }
@@ -184,6 +208,8 @@ static int devfreq_watermark_start(struct devfreq *df)
 	wmarkinfo->pdev = pdev;
 	wmarkinfo->p_low_wmark = 100;
 	wmarkinfo->p_high_wmark = 600;
+	wmarkinfo->p_up_steps = 1;
+	wmarkinfo->p_down_steps = 1;
 
 	devfreq_watermark_debug_start(df);
 
@@ -0,0 +1,259 @@
+/*
+ * Memory copy offload to GPC DMA memcpy channels
+ *
+ * Copyright (c) 2021, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ */
+
+#include <linux/completion.h>
+#include <linux/dma-mapping.h>
+#include <linux/dmaengine.h>
+#include <linux/mm.h>
+#include <linux/module.h>
+#include <linux/mutex.h>
+#include <linux/sizes.h>
+#include <linux/slab.h>
+#include <linux/tegra-dma-copy.h>
+
+/*
+ * A batch owns one channel from submit of its first copy to its done
+ * callback, so copies of different users don't queue behind each other.
+ * When no channel is free the CPU copies, which is what the user would
+ * have done anyway.
+ */
+#define TEGRA_DMA_COPY_CHANNELS		2
+
+struct tegra_dma_copy_chan {
+	struct dma_chan *chan;
+	atomic_t busy;
+};
+
+static struct {
+	struct mutex lock;
+	int users;
+	unsigned int nr_chans;
+	struct tegra_dma_copy_chan chans[TEGRA_DMA_COPY_CHANNELS];
+} dma_copy = {
+	.lock = __MUTEX_INITIALIZER(dma_copy.lock),
+};
+
+/* Below this the DMA setup and completion cost more than a CPU copy */
+static unsigned int min_bytes = SZ_16K;
+module_param(min_bytes, uint, 0644);
+MODULE_PARM_DESC(min_bytes, "Smallest copy offloaded to DMA");
+
+int tegra_dma_copy_get(void)
+{
+	dma_cap_mask_t mask;
+	struct dma_chan *chan;
+
+	mutex_lock(&dma_copy.lock);
+	if (dma_copy.users++)
+		goto out;
+
+	dma_cap_zero(mask);
+	dma_cap_set(DMA_MEMCPY, mask);
+	while (dma_copy.nr_chans < TEGRA_DMA_COPY_CHANNELS) {
+		chan = dma_request_chan_by_mask(&mask);
+		if (IS_ERR(chan))
+			break;
+		dma_copy.chans[dma_copy.nr_chans].chan = chan;
+		atomic_set(&dma_copy.chans[dma_copy.nr_chans].busy, 0);
+		dma_copy.nr_chans++;
+	}
+
+	if (!dma_copy.nr_chans)
+		pr_info("tegra-dma-copy: no memcpy channel, using the CPU\n");
+out:
+	mutex_unlock(&dma_copy.lock);
+	return 0;
+}
+EXPORT_SYMBOL_GPL(tegra_dma_copy_get);
+
+void tegra_dma_copy_put(void)
+{
+	mutex_lock(&dma_copy.lock);
+	if (!WARN_ON(!dma_copy.users) && !--dma_copy.users) {
+		while (dma_copy.nr_chans) {
+			dma_copy.nr_chans--;
+			dma_release_channel(
+				dma_copy.chans[dma_copy.nr_chans].chan);
+		}
+	}
+	mutex_unlock(&dma_copy.lock);
+}
+EXPORT_SYMBOL_GPL(tegra_dma_copy_put);
+
+void tegra_dma_copy_begin(struct tegra_dma_copy_batch *batch,
+			  tegra_dma_copy_done_t done, void *param)
+{
+	unsigned int i;
+
+	batch->chan = NULL;
+	batch->done = done;
+	batch->param = param;
+	batch->n = 0;
+	/* dropped by submit */
+	atomic_set(&batch->pending, 1);
+
+	for (i = 0; i < READ_ONCE(dma_copy.nr_chans); i++) {
+		if (!atomic_cmpxchg(&dma_copy.chans[i].busy, 0, 1)) {
+			batch->chan = &dma_copy.chans[i];
+			break;
+		}
+	}
+}
+EXPORT_SYMBOL_GPL(tegra_dma_copy_begin);
+
+static void tegra_dma_copy_finish(struct tegra_dma_copy_batch *batch)
+{
+	struct tegra_dma_copy_chan *c = batch->chan;
+	struct device *dev;
+	unsigned int i;
+	int err = 0;
+
+	if (c) {
+		dev = c->chan->device->dev;
+		for (i = 0; i < batch->n; i++) {
+			if (dmaengine_tx_status(c->chan, batch->map[i].cookie,
+						NULL) == DMA_ERROR)
+				err = -EIO;
+			dma_unmap_single(dev, batch->map[i].src,
+					 batch->map[i].len, DMA_TO_DEVICE);
+			dma_unmap_single(dev, batch->map[i].dst,
+					 batch->map[i].len, DMA_FROM_DEVICE);
+		}
+		atomic_set(&c->busy, 0);
+	}
+
+	if (batch->done)
+		batch->done(batch->param, err);
+}
+
+static void tegra_dma_copy_callback(void *param)
+{
+	struct tegra_dma_copy_batch *batch = param;
+
+	if (atomic_dec_and_test(&batch->pending))
+		tegra_dma_copy_finish(batch);
+}
+
+static bool tegra_dma_copy_offload(struct tegra_dma_copy_batch *batch,
+				   void *dst, const void *src, size_t len)
+{
+	struct tegra_dma_copy_chan *c = batch->chan;
+	struct dma_async_tx_descriptor *tx;
+	struct device *dev;
+	dma_addr_t d, s;
+	dma_cookie_t cookie;
+
+	if (!c || batch->n == TEGRA_DMA_COPY_BATCH_MAX || len < min_bytes)
+		return false;
+
+	if ((((unsigned long)dst | (unsigned long)src | len) & 3) ||
+	    !virt_addr_valid(dst) || !virt_addr_valid(dst + len - 1) ||
+	    !virt_addr_valid(src) || !virt_addr_valid(src + len - 1))
+		return false;
+
+	dev = c->chan->device->dev;
+	d = dma_map_single(dev, dst, len, DMA_FROM_DEVICE);
+	if (dma_mapping_error(dev, d))
+		return false;
+	s = dma_map_single(dev, (void *)src, len, DMA_TO_DEVICE);
+	if (dma_mapping_error(dev, s))
+		goto unmap_dst;
+
+	tx = dmaengine_prep_dma_memcpy(c->chan, d, s, len,
+				       DMA_PREP_INTERRUPT | DMA_CTRL_ACK);
+	if (!tx)
+		goto unmap_src;
+
+	tx->callback = tegra_dma_copy_callback;
+	tx->callback_param = batch;
+	atomic_inc(&batch->pending);
+	cookie = dmaengine_submit(tx);
+	if (dma_submit_error(cookie)) {
+		atomic_dec(&batch->pending);
+		goto unmap_src;
+	}
+
+	batch->map[batch->n].dst = d;
+	batch->map[batch->n].src = s;
+	batch->map[batch->n].len = len;
+	batch->map[batch->n].cookie = cookie;
+	batch->n++;
+
+	/* start right away, the CPU keeps preparing the next copies */
+	dma_async_issue_pending(c->chan);
+	return true;
+
+unmap_src:
+	dma_unmap_single(dev, s, len, DMA_TO_DEVICE);
+unmap_dst:
+	dma_unmap_single(dev, d, len, DMA_FROM_DEVICE);
+	return false;
+}
+
+void tegra_dma_copy_add(struct tegra_dma_copy_batch *batch, void *dst,
+			const void *src, size_t len)
+{
+	if (!tegra_dma_copy_offload(batch, dst, src, len))
+		memcpy(dst, src, len);
+}
+EXPORT_SYMBOL_GPL(tegra_dma_copy_add);
+
+void tegra_dma_copy_submit(struct tegra_dma_copy_batch *batch)
+{
+	if (atomic_dec_and_test(&batch->pending))
+		tegra_dma_copy_finish(batch);
+}
+EXPORT_SYMBOL_GPL(tegra_dma_copy_submit);
+
+struct tegra_dma_copy_sync {
+	struct tegra_dma_copy_batch batch;
+	struct completion done;
+	int err;
+};
+
+static void tegra_dma_copy_sync_done(void *param, int err)
+{
+	struct tegra_dma_copy_sync *sync = param;
+
+	sync->err = err;
+	complete(&sync->done);
+}
+
+int tegra_dma_copy_sync(void *dst, const void *src, size_t len)
+{
+	struct tegra_dma_copy_sync *sync;
+	int err;
+
+	if (len < min_bytes)
+		goto cpu;
+
+	sync = kmalloc(sizeof(*sync), GFP_KERNEL);
+	if (!sync)
+		goto cpu;
+
+	init_completion(&sync->done);
+	tegra_dma_copy_begin(&sync->batch, tegra_dma_copy_sync_done, sync);
+	tegra_dma_copy_add(&sync->batch, dst, src, len);
+	tegra_dma_copy_submit(&sync->batch);
+	wait_for_completion(&sync->done);
+	err = sync->err;
+	kfree(sync);
+	return err;
+
+cpu:
+	memcpy(dst, src, len);
+	return 0;
+}
+EXPORT_SYMBOL_GPL(tegra_dma_copy_sync);
@@ -1338,6 +1338,7 @@ static struct dma_async_tx_descriptor *tegra_dma_prep_slave_sg(
 	unsigned long csr, mc_seq, apb_ptr = 0, mmio_seq = 0;
 	struct list_head req_list;
 	struct tegra_dma_sg_req *sg_req = NULL;
+	dma_addr_t sg_req_mem = 0;
 	u32 burst_size;
 	enum dma_slave_buswidth slave_bw = 0;
 	int ret;
@@ -1407,7 +1408,11 @@ static struct dma_async_tx_descriptor *tegra_dma_prep_slave_sg(
 	dma_desc->wcount_overflow = 0;
 	dma_desc->dma_status = DMA_IN_PROGRESS;
 
-	/* Make transfer requests */
+	/*
+	 * Make transfer requests. The hardware has no descriptor chaining,
+	 * each request costs an EOC interrupt to program the next one, so
+	 * entries contiguous in memory are merged into one request.
+	 */
 	for_each_sg(sgl, sg, sg_len, i) {
 		u32 len;
 		dma_addr_t mem;
@@ -1423,15 +1428,29 @@ static struct dma_async_tx_descriptor *tegra_dma_prep_slave_sg(
 			return NULL;
 		}
 
+		dma_desc->bytes_requested += len;
+
+		/* The high address bits are per request, don't cross 4 GB */
+		if (sg_req && mem == sg_req_mem + sg_req->req_len &&
+		    sg_req->req_len + len <=
+				tdc->tdma->chip_data->max_dma_count &&
+		    upper_32_bits(sg_req_mem) ==
+				upper_32_bits(mem + len - 1)) {
+			sg_req->req_len += len;
+			sg_req->ch_regs.wcount = ((sg_req->req_len - 4) >> 2);
+			sg_req->ch_regs.mmio_seq = mmio_seq |
+				get_burst_size(tdc, burst_size, slave_bw,
+					       sg_req->req_len);
+			continue;
+		}
+
 		sg_req = tegra_dma_sg_req_get(tdc);
 		if (!sg_req) {
 			dev_err(tdc2dev(tdc), "Dma sg-req not available\n");
 			tegra_dma_desc_put(tdc, dma_desc);
 			return NULL;
 		}
-
-		mmio_seq |= get_burst_size(tdc, burst_size, slave_bw, len);
-		dma_desc->bytes_requested += len;
+		sg_req_mem = mem;
 
 		if (direction == DMA_MEM_TO_DEV) {
 			sg_req->ch_regs.src_ptr = mem;
@@ -1452,7 +1471,8 @@ static struct dma_async_tx_descriptor *tegra_dma_prep_slave_sg(
 		 */
 		sg_req->ch_regs.wcount = ((len - 4) >> 2);
 		sg_req->ch_regs.csr = csr;
-		sg_req->ch_regs.mmio_seq = mmio_seq;
+		sg_req->ch_regs.mmio_seq = mmio_seq |
+			get_burst_size(tdc, burst_size, slave_bw, len);
 		sg_req->ch_regs.mc_seq = mc_seq;
 		sg_req->configured = false;
 		sg_req->skipped = false;
@@ -18,8 +18,12 @@
 #include <linux/dma-buf.h>
 #include <linux/shmem_fs.h>
 #include <linux/extcon.h>
+#include <linux/workqueue.h>
 
 #include <uapi/drm/tegra_udrm.h>
+#ifdef CONFIG_TEGRA_DC
+#include <video/tegra_dc_ext_kernel.h>
+#endif
 
 #define DRIVER_NAME "tegra-udrm"
 #define DRIVER_DESC "Kernel DRM support for user mode DRM driver on NVIDIA Tegra Soc"
@@ -32,7 +36,7 @@
 /* Increase the minor number for minor updates which won't break compatibility
  * with user mode driver.
  */
-#define DRIVER_MINOR 0
+#define DRIVER_MINOR 1
 
 MODULE_PARM_DESC(
 		modeset,
@@ -42,9 +46,31 @@ module_param_named(modeset, tegra_udrm_modeset_module_param, bool, 0400);
 
 static const unsigned int cable_ids[] = {
 	EXTCON_DISP_HDMI, EXTCON_DISP_DP, EXTCON_DISP_DSIHPD, EXTCON_DISP_HDMI2};
+/* Display heads delivering kernel vblank events */
+#define TEGRA_UDRM_MAX_HEADS 4
+
+struct tegra_udrm_private;
+
+struct tegra_udrm_vblank {
+	struct tegra_udrm_private *priv;
+#ifdef CONFIG_TEGRA_DC
+	struct tegra_dc_client client;
+	struct tegra_dc_client_callbck_data callback;
+#endif
+	bool registered;
+	/* under priv->vblank_lock */
+	bool enabled;
+	/* under drm->event_lock */
+	struct list_head pending;
+	u32 sequence;
+	struct work_struct disable_work;
+};
+
 struct tegra_udrm_private {
 	struct drm_device *drm;
 	struct notifier_block hpd_nb[ARRAY_SIZE(cable_ids)];
+	struct mutex vblank_lock;
+	struct tegra_udrm_vblank vblank[TEGRA_UDRM_MAX_HEADS];
 };
 
 struct tegra_udrm_device {
@@ -349,6 +375,180 @@ static int tegra_udrm_send_vblank_event_ioctl(struct drm_device *drm,
 	return 0;
 }
 
+#ifdef CONFIG_TEGRA_DC
+/*
+ * Called from the display interrupt thread at each vblank while enabled.
+ * Sends every event queued for the head in one pass under event_lock, so
+ * all the waiting clients are woken for the same vblank. The interrupt
+ * is turned off once a vblank goes by with nothing queued.
+ */
+static void tegra_udrm_vblank_notify(int disp_id, u64 timestamp,
+		void *usr_ctx)
+{
+	struct tegra_udrm_vblank *vblank = usr_ctx;
+	struct drm_device *drm = vblank->priv->drm;
+	struct drm_pending_vblank_event *e, *tmp;
+	struct timeval tv = ns_to_timeval(timestamp);
+	unsigned long flags;
+
+	spin_lock_irqsave(&drm->event_lock, flags);
+	vblank->sequence++;
+	if (list_empty(&vblank->pending))
+		schedule_work(&vblank->disable_work);
+
+	list_for_each_entry_safe(e, tmp, &vblank->pending, base.link) {
+		list_del(&e->base.link);
+		e->event.sequence = vblank->sequence;
+		e->event.tv_sec = tv.tv_sec;
+		e->event.tv_usec = tv.tv_usec;
+		drm_send_event_locked(drm, &e->base);
+	}
+	spin_unlock_irqrestore(&drm->event_lock, flags);
+}
+
+static void tegra_udrm_vblank_disable_work(struct work_struct *work)
+{
+	struct tegra_udrm_vblank *vblank = container_of(work,
+			struct tegra_udrm_vblank, disable_work);
+	struct tegra_udrm_private *priv = vblank->priv;
+	bool idle;
+
+	mutex_lock(&priv->vblank_lock);
+	spin_lock_irq(&priv->drm->event_lock);
+	idle = list_empty(&vblank->pending);
+	spin_unlock_irq(&priv->drm->event_lock);
+
+	if (idle && vblank->enabled) {
+		tegra_dc_client_vblank_enable(&vblank->client, false);
+		vblank->enabled = false;
+	}
+	mutex_unlock(&priv->vblank_lock);
+}
+
+static void tegra_udrm_vblank_init(struct tegra_udrm_private *priv)
+{
+	struct tegra_udrm_vblank *vblank;
+	int i, heads = min(tegra_dc_get_numof_dispheads(),
+			   TEGRA_UDRM_MAX_HEADS);
+
+	mutex_init(&priv->vblank_lock);
+	for (i = 0; i < heads; i++) {
+		vblank = &priv->vblank[i];
+		vblank->priv = priv;
+		INIT_LIST_HEAD(&vblank->pending);
+		INIT_WORK(&vblank->disable_work,
+			tegra_udrm_vblank_disable_work);
+
+		vblank->callback.callback_type = NOTIFY_VBLANK_EVENT;
+		vblank->callback.callback_fn = tegra_udrm_vblank_notify;
+		vblank->client.disp_id = i;
+		vblank->client.usr_ctx = vblank;
+		vblank->client.nr_callbacks = 1;
+		vblank->client.callback_data = &vblank->callback;
+
+		/* heads not probed yet keep using UMD relayed events */
+		vblank->registered =
+			!tegra_dc_register_client(&vblank->client);
+	}
+}
+
+static void tegra_udrm_vblank_fini(struct tegra_udrm_private *priv)
+{
+	struct tegra_udrm_vblank *vblank;
+	struct drm_pending_vblank_event *e, *tmp;
+	LIST_HEAD(pending);
+	int i;
+
+	for (i = 0; i < TEGRA_UDRM_MAX_HEADS; i++) {
+		vblank = &priv->vblank[i];
+		if (!vblank->registered)
+			continue;
+
+		/* disables the interrupt as well */
+		tegra_dc_unregister_client(&vblank->client);
+		vblank->registered = false;
+		cancel_work_sync(&vblank->disable_work);
+
+		spin_lock_irq(&priv->drm->event_lock);
+		list_splice_init(&vblank->pending, &pending);
+		spin_unlock_irq(&priv->drm->event_lock);
+	}
+
+	list_for_each_entry_safe(e, tmp, &pending, base.link) {
+		list_del(&e->base.link);
+		drm_event_cancel_free(priv->drm, &e->base);
+	}
+}
+
+static int tegra_udrm_queue_vblank_event_ioctl(struct drm_device *drm,
+	void *data, struct drm_file *file)
+{
+	struct drm_tegra_udrm_queue_vblank_event *args =
+		(struct drm_tegra_udrm_queue_vblank_event *)data;
+	struct tegra_udrm_private *priv = drm->dev_private;
+	struct tegra_udrm_vblank *vblank;
+	struct drm_pending_vblank_event *e;
+	int ret;
+
+	if (args->reserved || args->head >= TEGRA_UDRM_MAX_HEADS)
+		return -EINVAL;
+
+	vblank = &priv->vblank[args->head];
+	if (!vblank->registered)
+		return -ENODEV;
+
+	e = kzalloc(sizeof(*e), GFP_KERNEL);
+	if (!e)
+		return -ENOMEM;
+
+	e->pipe = args->head;
+	e->base.pid = current->pid;
+	e->event.base.type = DRM_EVENT_VBLANK;
+	e->event.base.length = sizeof(e->event);
+	e->event.user_data = args->user_data;
+
+	ret = drm_event_reserve_init(drm, file, &e->base, &e->event.base);
+	if (ret) {
+		kfree(e);
+		return ret;
+	}
+
+	mutex_lock(&priv->vblank_lock);
+	spin_lock_irq(&drm->event_lock);
+	list_add_tail(&e->base.link, &vblank->pending);
+	spin_unlock_irq(&drm->event_lock);
+
+	if (!vblank->enabled) {
+		ret = tegra_dc_client_vblank_enable(&vblank->client, true);
+		if (ret) {
+			spin_lock_irq(&drm->event_lock);
+			list_del(&e->base.link);
+			spin_unlock_irq(&drm->event_lock);
+			drm_event_cancel_free(drm, &e->base);
+		} else {
+			vblank->enabled = true;
+		}
+	}
+	mutex_unlock(&priv->vblank_lock);
+
+	return ret;
+}
+#else
+static void tegra_udrm_vblank_init(struct tegra_udrm_private *priv)
+{
+}
+
+static void tegra_udrm_vblank_fini(struct tegra_udrm_private *priv)
+{
+}
+
+static int tegra_udrm_queue_vblank_event_ioctl(struct drm_device *drm,
+	void *data, struct drm_file *file)
+{
+	return -ENODEV;
+}
+#endif
+
 static int tegra_udrm_send_connector_status_event_ioctl(struct drm_device *drm,
 		void *data, struct drm_file *file)
 {
@@ -412,6 +612,8 @@ static const struct drm_ioctl_desc tegra_udrm_ioctls[] = {
 		tegra_udrm_set_master_notify_ioctl, 0),
 	DRM_IOCTL_DEF_DRV(TEGRA_UDRM_SEND_CONNECTOR_STATUS_EVENT,
 		tegra_udrm_send_connector_status_event_ioctl, 0),
+	DRM_IOCTL_DEF_DRV(TEGRA_UDRM_QUEUE_VBLANK_EVENT,
+		tegra_udrm_queue_vblank_event_ioctl, 0),
 };
 
 static int tegra_udrm_open(struct drm_device *drm, struct drm_file *filp)
@@ -598,6 +800,8 @@ static int tegra_udrm_probe(struct platform_device *pdev)
 		dev_warn(drm->dev, "DISP HOTPLUG event is not supported\n");
 	}
 
+	tegra_udrm_vblank_init(priv);
+
 	return 0;
 
 err_unload:
@@ -613,6 +817,7 @@ static int tegra_udrm_remove(struct platform_device *pdev)
 {
 	struct drm_device *drm = platform_get_drvdata(pdev);
 
+	tegra_udrm_vblank_fini(drm->dev_private);
 	drm_dev_unregister(drm);
 	tegra_udrm_unload(drm);
 	drm_dev_unref(drm);
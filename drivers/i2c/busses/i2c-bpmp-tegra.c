@@ -262,8 +262,9 @@ static int tegra_bpmp_i2c_preverify(struct i2c_msg *msgs, int num)
 	int i, totallen = 0;
 
 	for (i = 0, totallen = 0; i < num; i++) {
+		totallen += 6;
 		if (!(msgs[i].flags & I2C_M_RD))
-			totallen += 6 + msgs[i].len;
+			totallen += msgs[i].len;
 	}
 	if (totallen > TEGRA_I2C_IPC_MAX_IN_BUF_SIZE)
 		return totallen;
@@ -278,22 +279,34 @@ static int tegra_bpmp_i2c_preverify(struct i2c_msg *msgs, int num)
 	return 0;
 }
 
-static int tegra_bpmp_i2c_xfer(struct i2c_adapter *adap, struct i2c_msg msgs[],
-	int num)
+/*
+ * Number of messages from msgs that go in the first MRQ of a transfer too
+ * big for a single one, 0 if none fits. The transfer is only cut after a
+ * message with I2C_M_STOP, where the bus sees a STOP anyway.
+ */
+static int tegra_bpmp_i2c_split_len(struct i2c_msg *msgs, int num)
+{
+	int i, n = 0;
+
+	for (i = 0; i < num; i++) {
+		if (!(msgs[i].flags & I2C_M_STOP) && i != num - 1)
+			continue;
+		if (tegra_bpmp_i2c_preverify(msgs, i + 1))
+			break;
+		n = i + 1;
+	}
+
+	return n;
+}
+
+static int tegra_bpmp_i2c_xfer_msgs(struct tegra_bpmp_i2c_dev *i2c_dev,
+	struct i2c_msg msgs[], int num)
 {
-	struct tegra_bpmp_i2c_dev *i2c_dev = i2c_get_adapdata(adap);
 	struct mrq_i2c_request in;
 	struct mrq_i2c_response out;
 	int ret = 0;
 	int size;
 
-	ret = tegra_bpmp_i2c_preverify(msgs, num);
-	if (ret != 0) {
-		dev_err(&i2c_dev->adapter.dev, "msg len : %d not supported\n",
-			ret);
-		return -EINVAL;
-	}
-
 	size = serialize_i2c(in.xfer.data_buf,
 			TEGRA_I2C_IPC_MAX_IN_BUF_SIZE,
 			msgs, num);
@@ -330,6 +343,36 @@ static int tegra_bpmp_i2c_xfer(struct i2c_adapter *adap, struct i2c_msg msgs[],
 	return num;
 }
 
+/*
+ * The whole transfer normally goes to BPMP as one MRQ. One that does not
+ * fit the MRQ payload is sent as several, see tegra_bpmp_i2c_split_len().
+ */
+static int tegra_bpmp_i2c_xfer(struct i2c_adapter *adap, struct i2c_msg msgs[],
+	int num)
+{
+	struct tegra_bpmp_i2c_dev *i2c_dev = i2c_get_adapdata(adap);
+	int done, n, ret;
+
+	ret = tegra_bpmp_i2c_preverify(msgs, num);
+	if (ret == 0)
+		return tegra_bpmp_i2c_xfer_msgs(i2c_dev, msgs, num);
+
+	for (done = 0; done < num; done += n) {
+		n = tegra_bpmp_i2c_split_len(&msgs[done], num - done);
+		if (!n) {
+			dev_err(&i2c_dev->adapter.dev,
+				"msg len : %d not supported\n", ret);
+			return -EINVAL;
+		}
+
+		ret = tegra_bpmp_i2c_xfer_msgs(i2c_dev, &msgs[done], n);
+		if (ret < 0)
+			return ret;
+	}
+
+	return num;
+}
+
 static u32 tegra_bpmp_i2c_func(struct i2c_adapter *adap)
 {
 	u32 ret = I2C_FUNC_I2C | I2C_FUNC_SMBUS_EMUL | I2C_FUNC_10BIT_ADDR |
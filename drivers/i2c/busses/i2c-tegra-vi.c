@@ -193,6 +193,10 @@
 /* Packet header size in words */
 #define I2C_PACKET_HEADER_SIZE			(3)
 
+/* DMA buffer bytes taken by a write packet of len bytes */
+#define I2C_PACKET_DMA_LEN(len)	\
+	((I2C_PACKET_HEADER_SIZE + DIV_ROUND_UP(len, 4)) * 4)
+
 /*
  * msg_end_type: The bus control which need to be send at end of transfer.
  * @MSG_END_STOP: Send stop pulse at end of transfer.
@@ -570,11 +574,13 @@ static int tegra_i2c_init_dma_param(struct tegra_i2c_dev *i2c_dev,
 	}
 
 	if (dma_to_memory) {
-		dma_sconfig.src_addr = i2c_dev->phys_addr + I2C_RX_FIFO;
+		dma_sconfig.src_addr = i2c_dev->phys_addr +
+			tegra_i2c_reg_addr(i2c_dev, I2C_RX_FIFO);
 		dma_sconfig.src_addr_width = DMA_SLAVE_BUSWIDTH_4_BYTES;
 		dma_sconfig.src_maxburst = 0;
 	} else {
-		dma_sconfig.dst_addr = i2c_dev->phys_addr + I2C_TX_FIFO;
+		dma_sconfig.dst_addr = i2c_dev->phys_addr +
+			tegra_i2c_reg_addr(i2c_dev, I2C_TX_FIFO);
 		dma_sconfig.dst_addr_width = DMA_SLAVE_BUSWIDTH_4_BYTES;
 		dma_sconfig.dst_maxburst = 0;
 	}
@@ -600,6 +606,29 @@ scrub:
 	return ret;
 }
 
+/* Channels are requested on first use when they were not ready at probe */
+static int tegra_i2c_get_dma(struct tegra_i2c_dev *i2c_dev)
+{
+	int ret;
+
+	if (!i2c_dev->enable_dma_mode ||
+	    (i2c_dev->tx_dma_chan && i2c_dev->rx_dma_chan))
+		return 0;
+
+	if (!i2c_dev->rx_dma_chan) {
+		ret = tegra_i2c_init_dma_param(i2c_dev, true);
+		if (ret && (ret != -EPROBE_DEFER) && (ret != -ENODEV))
+			return ret;
+	}
+	if (!i2c_dev->tx_dma_chan) {
+		ret = tegra_i2c_init_dma_param(i2c_dev, false);
+		if (ret && (ret != -EPROBE_DEFER) && (ret != -ENODEV))
+			return ret;
+	}
+
+	return 0;
+}
+
 static void tegra_i2c_deinit_dma_param(struct tegra_i2c_dev *i2c_dev,
 	bool dma_to_memory)
 {
@@ -1327,12 +1356,14 @@ static void tegra_i2c_config_fifo_trig(struct tegra_i2c_dev *i2c_dev,
 	i2c_writel(i2c_dev, val, I2C_FIFO_CONTROL);
 
 	if (i2c_dev->curr_direction == DATA_DMA_DIR_TX) {
-		dma_sconfig.dst_addr = i2c_dev->phys_addr + I2C_TX_FIFO;
+		dma_sconfig.dst_addr = i2c_dev->phys_addr +
+			tegra_i2c_reg_addr(i2c_dev, I2C_TX_FIFO);
 		dma_sconfig.dst_addr_width = DMA_SLAVE_BUSWIDTH_4_BYTES;
 		dma_sconfig.dst_maxburst = maxburst;
 		dmaengine_slave_config(i2c_dev->tx_dma_chan, &dma_sconfig);
 	} else {
-		dma_sconfig.src_addr = i2c_dev->phys_addr + I2C_RX_FIFO;
+		dma_sconfig.src_addr = i2c_dev->phys_addr +
+			tegra_i2c_reg_addr(i2c_dev, I2C_RX_FIFO);
 		dma_sconfig.src_addr_width = DMA_SLAVE_BUSWIDTH_4_BYTES;
 		dma_sconfig.src_maxburst = maxburst;
 		dmaengine_slave_config(i2c_dev->rx_dma_chan, &dma_sconfig);
@@ -1426,6 +1457,73 @@ exit:
 	return ret;
 }
 
+/*
+ * Writes num messages as back to back packets of a single TX DMA. Only the
+ * last packet raises the transfer complete interrupt; a NACK or lost
+ * arbitration on any packet stops the controller and fails the whole batch.
+ */
+static int tegra_i2c_start_dma_batch_xfer(struct tegra_i2c_dev *i2c_dev,
+	struct i2c_msg *msgs, int num, enum msg_end_type end_state)
+{
+	int ret = 0;
+	u32 *packet = i2c_dev->tx_dma_buf;
+	u32 dma_xfer_len = 0;
+	u32 int_mask;
+	unsigned long flags = 0;
+	int i;
+
+	i2c_dev->is_curr_dma_xfer = true;
+	i2c_dev->curr_direction = DATA_DMA_DIR_TX;
+	i2c_dev->msg_buf_remaining = 0;
+	i2c_dev->msg_add = msgs[0].addr;
+
+	/* Enable error interrupts */
+	int_mask = I2C_INT_NO_ACK | I2C_INT_ARBITRATION_LOST
+					| I2C_INT_TX_FIFO_OVERFLOW;
+	tegra_i2c_unmask_irq(i2c_dev, int_mask);
+
+	dma_sync_single_for_cpu(i2c_dev->dev, i2c_dev->tx_dma_phys,
+			i2c_dev->dma_buf_size, DMA_TO_DEVICE);
+	for (i = 0; i < num; i++) {
+		struct i2c_msg *msg = &msgs[i];
+		enum msg_end_type end_type = end_state;
+
+		if (i < num - 1)
+			end_type = (msgs[i + 1].flags & I2C_M_NOSTART) ?
+				MSG_END_CONTINUE : MSG_END_REPEAT_START;
+
+		tegra_i2c_fill_packet_header(i2c_dev, msg, end_type, packet);
+		if (i < num - 1)
+			packet[2] &= ~I2C_HEADER_IE_ENABLE;
+		memcpy(packet + I2C_PACKET_HEADER_SIZE, msg->buf, msg->len);
+
+		packet += I2C_PACKET_DMA_LEN(msg->len) / 4;
+		dma_xfer_len += I2C_PACKET_DMA_LEN(msg->len);
+	}
+	dma_sync_single_for_device(i2c_dev->dev, i2c_dev->tx_dma_phys,
+			i2c_dev->dma_buf_size, DMA_TO_DEVICE);
+
+	tegra_i2c_config_fifo_trig(i2c_dev, dma_xfer_len);
+
+	/* Acquire the lock before posting the data to FIFO */
+	spin_lock_irqsave(&i2c_dev->xfer_lock, flags);
+
+	ret = tegra_i2c_start_tx_dma(i2c_dev, dma_xfer_len);
+	if (ret < 0) {
+		dev_err(i2c_dev->dev, "Starting tx dma failed, err %d\n", ret);
+		goto exit;
+	}
+
+	if (i2c_dev->hw->has_per_pkt_xfer_complete_irq)
+		int_mask |= I2C_INT_PACKET_XFER_COMPLETE;
+
+	tegra_i2c_unmask_irq(i2c_dev, int_mask);
+
+exit:
+	spin_unlock_irqrestore(&i2c_dev->xfer_lock, flags);
+	return ret;
+}
+
 static int tegra_i2c_start_pio_based_xfer(struct tegra_i2c_dev *i2c_dev,
 	struct i2c_msg *msg, enum msg_end_type end_state)
 {
@@ -1560,8 +1658,12 @@ static void tegra_i2c_reg_dump(struct tegra_i2c_dev *i2c_dev,
 			i2c_dev->msg_buf_remaining);
 }
 
+/*
+ * Transfers msg, or with num > 1 the write batch starting at msg, see
+ * tegra_i2c_xfer_batch_len(). end_state applies to the last message.
+ */
 static int tegra_i2c_xfer_msg(struct tegra_i2c_dev *i2c_dev,
-	struct i2c_msg *msg, enum msg_end_type end_state)
+	struct i2c_msg *msg, int num, enum msg_end_type end_state)
 {
 	u32 int_mask = 0;
 	unsigned long time_left;
@@ -1570,19 +1672,18 @@ static int tegra_i2c_xfer_msg(struct tegra_i2c_dev *i2c_dev,
 	if (msg->len == 0)
 		return -EINVAL;
 
-	if (i2c_dev->enable_dma_mode && (msg->len > I2C_PIO_MODE_MAX_LEN)
-			&& !(i2c_dev->tx_dma_chan && i2c_dev->rx_dma_chan)) {
-		ret = tegra_i2c_init_dma_param(i2c_dev, true);
-		if (ret && (ret != -EPROBE_DEFER) && (ret != -ENODEV))
-			return ret;
-		ret = tegra_i2c_init_dma_param(i2c_dev, false);
-		if (ret && (ret != -EPROBE_DEFER) && (ret != -ENODEV))
+	if (msg->len > I2C_PIO_MODE_MAX_LEN) {
+		ret = tegra_i2c_get_dma(i2c_dev);
+		if (ret)
 			return ret;
 	}
 
 	tegra_i2c_pre_xfer_config(i2c_dev, msg);
 
-	if ((msg->len > I2C_PIO_MODE_MAX_LEN) && i2c_dev->tx_dma_chan
+	if (num > 1)
+		ret = tegra_i2c_start_dma_batch_xfer(i2c_dev, msg, num,
+						     end_state);
+	else if ((msg->len > I2C_PIO_MODE_MAX_LEN) && i2c_dev->tx_dma_chan
 				&& i2c_dev->rx_dma_chan)
 		ret = tegra_i2c_start_dma_based_xfer(i2c_dev, msg, end_state);
 	else
@@ -1675,7 +1776,7 @@ static int tegra_i2c_split_i2c_msg_xfer(struct tegra_i2c_dev *i2c_dev,
 			end_type = MSG_END_CONTINUE;
 		else
 			end_type = temp_end_type;
-		ret = tegra_i2c_xfer_msg(i2c_dev, &temp_msg, end_type);
+		ret = tegra_i2c_xfer_msg(i2c_dev, &temp_msg, 1, end_type);
 		if (ret)
 			return ret;
 		buf += len;
@@ -1684,11 +1785,37 @@ static int tegra_i2c_split_i2c_msg_xfer(struct tegra_i2c_dev *i2c_dev,
 	return ret;
 }
 
+/*
+ * Number of messages from msgs that go out as one TX DMA: a run of writes
+ * that fits the DMA buffer, as for sensor register tables. Reads, and
+ * writes without DMA channels, go one message at a time.
+ */
+static int tegra_i2c_xfer_batch_len(struct tegra_i2c_dev *i2c_dev,
+	struct i2c_msg msgs[], int num)
+{
+	size_t size = 0;
+	int n;
+
+	if (num < 2 || tegra_i2c_get_dma(i2c_dev) || !i2c_dev->tx_dma_chan)
+		return 1;
+
+	for (n = 0; n < num; n++) {
+		if ((msgs[n].flags & I2C_M_RD) || !msgs[n].len ||
+		    msgs[n].len > I2C_MAX_TRANSFER_LEN)
+			break;
+		size += I2C_PACKET_DMA_LEN(msgs[n].len);
+		if (size > i2c_dev->dma_buf_size)
+			break;
+	}
+
+	return max(n, 1);
+}
+
 static int tegra_i2c_xfer(struct i2c_adapter *adap, struct i2c_msg msgs[],
 	int num)
 {
 	struct tegra_i2c_dev *i2c_dev = i2c_get_adapdata(adap);
-	int i;
+	int i, n;
 	int ret = 0;
 
 	if (i2c_dev->is_suspended)
@@ -1719,11 +1846,12 @@ static int tegra_i2c_xfer(struct i2c_adapter *adap, struct i2c_msg msgs[],
 			return ret;
 	}
 
-	for (i = 0; i < num; i++) {
+	for (i = 0; i < num; i += n) {
 		enum msg_end_type end_type = MSG_END_STOP;
 
-		if (i < (num - 1)) {
-			if (msgs[i + 1].flags & I2C_M_NOSTART)
+		n = tegra_i2c_xfer_batch_len(i2c_dev, &msgs[i], num - i);
+		if (i + n < num) {
+			if (msgs[i + n].flags & I2C_M_NOSTART)
 				end_type = MSG_END_CONTINUE;
 			else
 				end_type = MSG_END_REPEAT_START;
@@ -1732,7 +1860,8 @@ static int tegra_i2c_xfer(struct i2c_adapter *adap, struct i2c_msg msgs[],
 			ret = tegra_i2c_split_i2c_msg_xfer(i2c_dev, &msgs[i],
 							   end_type);
 		else
-			ret = tegra_i2c_xfer_msg(i2c_dev, &msgs[i], end_type);
+			ret = tegra_i2c_xfer_msg(i2c_dev, &msgs[i], n,
+						 end_type);
 		if (ret)
 			break;
 	}
@@ -2079,14 +2208,9 @@ static int tegra_i2c_probe(struct platform_device *pdev)
 		}
 	}
 
-	if (i2c_dev->enable_dma_mode) {
-		ret = tegra_i2c_init_dma_param(i2c_dev, true);
-		if (ret && (ret != -EPROBE_DEFER) && (ret != -ENODEV))
-			goto disable_clk;
-		ret = tegra_i2c_init_dma_param(i2c_dev, false);
-		if (ret && (ret != -EPROBE_DEFER) && (ret != -ENODEV))
-			goto disable_clk;
-	}
+	ret = tegra_i2c_get_dma(i2c_dev);
+	if (ret)
+		goto disable_clk;
 
 	ret = devm_request_irq(&pdev->dev, i2c_dev->irq,
 			tegra_i2c_isr, 0, dev_name(&pdev->dev), i2c_dev);
@@ -52,6 +52,7 @@
 #include <linux/dma-attrs.h>
 #include <soc/tegra/chip-id.h>
 #include <linux/ktime.h>
+#include <linux/math64.h>
 #include <linux/string.h>
 #include <linux/dma-override.h>
 
@@ -205,6 +206,18 @@ static bool arm_smmu_skip_mapping; /* For debug */
 static bool arm_smmu_gr0_tlbiallnsnh; /* Insert TLBIALLNSNH at all */
 static bool arm_smmu_tlb_inv_by_addr = 1; /* debugfs: tlb inv context by default */
 static bool arm_smmu_tlb_inv_at_map;	/* debugfs: tlb inv at map additionally */
+/* debugfs: larger ranges invalidate the whole context instead of each page */
+static u32 arm_smmu_tlb_inv_range_max_pages = 256;
+
+/* debugfs: tlb_stats */
+static struct {
+	atomic64_t inv_ranges;
+	atomic64_t inv_pages;
+	atomic64_t inv_contexts;
+	atomic64_t syncs;
+	atomic64_t sync_ns;
+	atomic64_t sync_max_ns;
+} arm_smmu_tlb_stats;
 
 static void get_pte_info(struct arm_smmu_cfg *cfg, ulong iova,
 	pgdval_t *pgdval, pudval_t *pudval, pmdval_t *pmdval, pteval_t *pteval);
@@ -613,37 +626,6 @@ static void arm_smmu_cb_tlb_sync_wait_for_complete(struct arm_smmu_device *smmu,
 	}
 }
 
-static void arm_smmu_cb_tlb_sync(struct arm_smmu_domain *smmu_domain, bool iso_client)
-{
-	struct arm_smmu_cfg *cfg = &smmu_domain->cfg;
-	struct arm_smmu_device *smmu = smmu_domain->smmu;
-	void __iomem *base;
-	uint64_t offset;
-	int smmu_id = 0;
-
-	base = ARM_SMMU_CB_BASE(smmu) + ARM_SMMU_CB(smmu, cfg->cbndx);
-
-	writel_relaxed_iso(0, base + ARM_SMMU_CB_TLBSYNC, iso_client);
-	offset = abs(base - smmu_handle->base[0]);
-
-	if (iso_client) {
-		if (smmu_handle->iso_smmu_id < 0)
-			return;
-		base = smmu->base[smmu->iso_smmu_id] + offset;
-		arm_smmu_cb_tlb_sync_wait_for_complete(smmu, base);
-		return;
-	}
-
-	while (smmu_id < smmu->num_smmus) {
-		if (smmu_id != smmu->iso_smmu_id) {
-			base = smmu->base[smmu_id] + offset;
-			arm_smmu_cb_tlb_sync_wait_for_complete(smmu, base);
-		}
-		smmu_id++;
-	}
-
-}
-
 static void arm_smmu_tlb_sync(struct arm_smmu_device *smmu, bool iso_client)
 {
 	int smmu_id = 0;
@@ -673,6 +655,72 @@ static void arm_smmu_tlb_sync(struct arm_smmu_device *smmu, bool iso_client)
 	}
 }
 
+static void arm_smmu_tlb_stats_sync(u64 ns)
+{
+	u64 max = atomic64_read(&arm_smmu_tlb_stats.sync_max_ns);
+
+	atomic64_inc(&arm_smmu_tlb_stats.syncs);
+	atomic64_add(ns, &arm_smmu_tlb_stats.sync_ns);
+	while (ns > max) {
+		u64 old = atomic64_cmpxchg(&arm_smmu_tlb_stats.sync_max_ns,
+					   max, ns);
+		if (old == max)
+			break;
+		max = old;
+	}
+}
+
+/*
+ * Sync the TLB invalidations of a domain on every SMMU serving its ISO or
+ * non-ISO clients. The syncs are all posted before waiting on any, so the
+ * SMMUs drain in parallel and a domain with both kinds of clients waits
+ * once.
+ */
+static void arm_smmu_domain_tlb_sync(struct arm_smmu_domain *smmu_domain,
+				     bool cb_sync)
+{
+	struct arm_smmu_cfg *cfg = &smmu_domain->cfg;
+	struct arm_smmu_device *smmu = smmu_domain->smmu;
+	void __iomem *base;
+	unsigned long smmus = 0;
+	u32 offset, sync_reg;
+	u64 start;
+	int smmu_id;
+
+	for (smmu_id = 0; smmu_id < smmu->num_smmus; smmu_id++) {
+		if (smmu_id == smmu->iso_smmu_id ? cfg->iso_client_count :
+						   cfg->non_iso_client_count)
+			smmus |= BIT(smmu_id);
+	}
+
+	if (cb_sync) {
+		base = ARM_SMMU_CB_BASE(smmu) + ARM_SMMU_CB(smmu, cfg->cbndx);
+		sync_reg = ARM_SMMU_CB_TLBSYNC;
+	} else {
+		base = ARM_SMMU_GR0(smmu);
+		sync_reg = ARM_SMMU_GR0_sTLBGSYNC;
+	}
+	offset = abs(base - smmu->base[0]);
+
+	for_each_set_bit(smmu_id, &smmus, MAX_SMMUS) {
+		base = smmu->base[smmu_id] + offset;
+		if (!cb_sync &&
+		    (tegra_platform_is_sim() || arm_smmu_gr0_tlbiallnsnh))
+			writel_relaxed(0, base + ARM_SMMU_GR0_TLBIALLNSNH);
+		writel_relaxed(0, base + sync_reg);
+	}
+
+	start = local_clock();
+	for_each_set_bit(smmu_id, &smmus, MAX_SMMUS) {
+		base = smmu->base[smmu_id] + offset;
+		if (cb_sync)
+			arm_smmu_cb_tlb_sync_wait_for_complete(smmu, base);
+		else
+			arm_smmu_tlb_sync_wait_for_complete(smmu, base);
+	}
+	arm_smmu_tlb_stats_sync(local_clock() - start);
+}
+
 static void arm_smmu_tlb_inv_context(struct arm_smmu_domain *smmu_domain)
 {
 	u64 time_before = 0;
@@ -702,19 +750,8 @@ static void arm_smmu_tlb_inv_context(struct arm_smmu_domain *smmu_domain)
 			       cfg);
 	}
 
-	if (do_cb_inval_sync) {
-		if (cfg->iso_client_count)
-			arm_smmu_cb_tlb_sync(smmu_domain, 1);
-
-		if (cfg->non_iso_client_count)
-			arm_smmu_cb_tlb_sync(smmu_domain, 0);
-	} else {
-		if (cfg->iso_client_count)
-			arm_smmu_tlb_sync(smmu, 1);
-
-		if (cfg->non_iso_client_count)
-			arm_smmu_tlb_sync(smmu, 0);
-	}
+	atomic64_inc(&arm_smmu_tlb_stats.inv_contexts);
+	arm_smmu_domain_tlb_sync(smmu_domain, do_cb_inval_sync);
 
 	if (time_before)
 		trace_arm_smmu_tlb_inv_context(time_before, cfg->cbndx);
@@ -755,6 +792,17 @@ static void arm_smmu_tlb_inv_range(struct arm_smmu_domain *smmu_domain,
 	struct arm_smmu_device *smmu = smmu_domain->smmu;
 	bool stage1 = cfg->cbar != CBAR_TYPE_S2_TRANS;
 
+	/*
+	 * There is no range TLBI. Past a point one invalidation of the whole
+	 * context, mirrored to each SMMU, is cheaper than one per page. SMMUv1
+	 * stage 2 can only invalidate the whole VMID anyway.
+	 */
+	if (size / PAGE_SIZE > arm_smmu_tlb_inv_range_max_pages ||
+	    (!stage1 && smmu->version != ARM_SMMU_V2)) {
+		arm_smmu_tlb_inv_context(smmu_domain);
+		return;
+	}
+
 #ifdef CONFIG_TRACEPOINTS
 	if (static_key_false(&__tracepoint_arm_smmu_tlb_inv_range.key)
 		&& test_bit(cfg->cbndx, smmu->context_filter))
@@ -765,21 +813,10 @@ static void arm_smmu_tlb_inv_range(struct arm_smmu_domain *smmu_domain,
 		__arm_smmu_tlb_inv_range(smmu_domain, iova);
 		iova += PAGE_SIZE;
 	}
+	atomic64_inc(&arm_smmu_tlb_stats.inv_ranges);
+	atomic64_add(size / PAGE_SIZE, &arm_smmu_tlb_stats.inv_pages);
 
-	if (!tegra_platform_is_sim() &&
-	    (stage1 || smmu->version == ARM_SMMU_V2)) {
-		if (cfg->iso_client_count)
-			arm_smmu_cb_tlb_sync(smmu_domain, 1);
-
-		if (cfg->non_iso_client_count)
-			arm_smmu_cb_tlb_sync(smmu_domain, 0);
-	} else {
-		if (cfg->iso_client_count)
-			arm_smmu_tlb_sync(smmu, 1);
-
-		if (cfg->non_iso_client_count)
-			arm_smmu_tlb_sync(smmu, 0);
-	}
+	arm_smmu_domain_tlb_sync(smmu_domain, !tegra_platform_is_sim());
 
 	if (time_before)
 		trace_arm_smmu_tlb_inv_range(time_before, cfg->cbndx,
@@ -2870,6 +2907,53 @@ static const struct file_operations smmu_context_filter_fops = {
 	.release	= single_release,
 };
 
+static int smmu_tlb_stats_show(struct seq_file *s, void *unused)
+{
+	u64 syncs = atomic64_read(&arm_smmu_tlb_stats.syncs);
+	u64 sync_ns = atomic64_read(&arm_smmu_tlb_stats.sync_ns);
+
+	seq_printf(s, "inv_ranges: %lld\n",
+		   (s64)atomic64_read(&arm_smmu_tlb_stats.inv_ranges));
+	seq_printf(s, "inv_pages: %lld\n",
+		   (s64)atomic64_read(&arm_smmu_tlb_stats.inv_pages));
+	seq_printf(s, "inv_contexts: %lld\n",
+		   (s64)atomic64_read(&arm_smmu_tlb_stats.inv_contexts));
+	seq_printf(s, "syncs: %llu\n", syncs);
+	seq_printf(s, "sync_wait_ns: %llu\n", sync_ns);
+	seq_printf(s, "sync_wait_avg_ns: %llu\n",
+		   syncs ? div64_u64(sync_ns, syncs) : 0);
+	seq_printf(s, "sync_wait_max_ns: %lld\n",
+		   (s64)atomic64_read(&arm_smmu_tlb_stats.sync_max_ns));
+	return 0;
+}
+
+static int smmu_tlb_stats_open(struct inode *inode, struct file *file)
+{
+	return single_open(file, smmu_tlb_stats_show, inode->i_private);
+}
+
+/* Any write clears the stats */
+static ssize_t smmu_tlb_stats_write(struct file *file,
+				    const char __user *user_buf,
+				    size_t count, loff_t *ppos)
+{
+	atomic64_set(&arm_smmu_tlb_stats.inv_ranges, 0);
+	atomic64_set(&arm_smmu_tlb_stats.inv_pages, 0);
+	atomic64_set(&arm_smmu_tlb_stats.inv_contexts, 0);
+	atomic64_set(&arm_smmu_tlb_stats.syncs, 0);
+	atomic64_set(&arm_smmu_tlb_stats.sync_ns, 0);
+	atomic64_set(&arm_smmu_tlb_stats.sync_max_ns, 0);
+	return count;
+}
+
+static const struct file_operations smmu_tlb_stats_fops = {
+	.open		= smmu_tlb_stats_open,
+	.read		= seq_read,
+	.write		= smmu_tlb_stats_write,
+	.llseek		= seq_lseek,
+	.release	= single_release,
+};
+
 static int smmu_reg32_debugfs_set(void *data, u64 val)
 {
 	struct debugfs_reg32 *regs = (struct debugfs_reg32 *)data;
@@ -3124,6 +3208,10 @@ static void arm_smmu_debugfs_create(struct arm_smmu_device *smmu)
 			smmu->debugfs_root, &arm_smmu_tlb_inv_by_addr);
 	debugfs_create_bool("tlb_inv_at_map",  S_IRUGO | S_IWUSR,
 			smmu->debugfs_root, &arm_smmu_tlb_inv_at_map);
+	debugfs_create_u32("tlb_inv_range_max_pages",  S_IRUGO | S_IWUSR,
+			smmu->debugfs_root, &arm_smmu_tlb_inv_range_max_pages);
+	debugfs_create_file("tlb_stats", S_IRUGO | S_IWUSR,
+			    smmu->debugfs_root, NULL, &smmu_tlb_stats_fops);
 	return;
 
 err_out:
@@ -841,6 +841,7 @@ static struct i2c_driver imx185_i2c_driver = {
 	.driver = {
 		.name = "imx185",
 		.owner = THIS_MODULE,
+		.probe_type = PROBE_PREFER_ASYNCHRONOUS,
 		.of_match_table = of_match_ptr(imx185_of_match),
 	},
 	.probe = imx185_probe,
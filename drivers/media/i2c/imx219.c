@@ -765,6 +765,7 @@ static struct i2c_driver imx219_i2c_driver = {
 	.driver = {
 		.name = "imx219",
 		.owner = THIS_MODULE,
+		.probe_type = PROBE_PREFER_ASYNCHRONOUS,
 		.of_match_table = of_match_ptr(imx219_of_match),
 	},
 	.probe = imx219_probe,
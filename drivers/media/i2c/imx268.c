@@ -713,6 +713,7 @@ static struct i2c_driver imx268_i2c_driver = {
 	.driver = {
 		.name = "imx268",
 		.owner = THIS_MODULE,
+		.probe_type = PROBE_PREFER_ASYNCHRONOUS,
 		.of_match_table = of_match_ptr(imx268_of_match),
 	},
 	.probe = imx268_probe,
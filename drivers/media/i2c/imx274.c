@@ -1359,6 +1359,7 @@ static struct i2c_driver imx274_i2c_driver = {
 	.driver = {
 		.name = "imx274",
 		.owner = THIS_MODULE,
+		.probe_type = PROBE_PREFER_ASYNCHRONOUS,
 	},
 	.probe = imx274_probe,
 	.remove = imx274_remove,
@@ -790,6 +790,7 @@ static struct i2c_driver imx318_i2c_driver = {
 	.driver = {
 		.name = "imx318",
 		.owner = THIS_MODULE,
+		.probe_type = PROBE_PREFER_ASYNCHRONOUS,
 		.of_match_table = of_match_ptr(imx318_of_match),
 	},
 	.probe = imx318_probe,
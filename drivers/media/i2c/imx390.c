@@ -615,7 +615,9 @@ static int imx390_board_setup(struct imx390 *priv)
 		goto error;
 	}
 	if (ser_i2c->dev.driver == NULL) {
-		dev_err(dev, "missing serializer driver\n");
+		/* probed asynchronously, the serdes may not be bound yet */
+		dev_dbg(dev, "serializer driver not bound yet\n");
+		err = -EPROBE_DEFER;
 		goto error;
 	}
 
@@ -637,7 +639,9 @@ static int imx390_board_setup(struct imx390 *priv)
 		goto error;
 	}
 	if (dser_i2c->dev.driver == NULL) {
-		dev_err(dev, "missing deserializer driver\n");
+		/* probed asynchronously, the serdes may not be bound yet */
+		dev_dbg(dev, "deserializer driver not bound yet\n");
+		err = -EPROBE_DEFER;
 		goto error;
 	}
 
@@ -876,6 +880,7 @@ static struct i2c_driver imx390_i2c_driver = {
 	.driver = {
 		.name = "imx390",
 		.owner = THIS_MODULE,
+		.probe_type = PROBE_PREFER_ASYNCHRONOUS,
 		.of_match_table = of_match_ptr(imx390_of_match),
 	},
 	.probe = imx390_probe,
@@ -771,6 +771,7 @@ static struct i2c_driver imx477_i2c_driver = {
 	.driver = {
 		   .name = "imx477",
 		   .owner = THIS_MODULE,
+		   .probe_type = PROBE_PREFER_ASYNCHRONOUS,
 		   .of_match_table = of_match_ptr(imx477_of_match),
 		   },
 	.probe = imx477_probe,
@@ -527,6 +527,7 @@ static struct i2c_driver lt6911uxc_i2c_driver = {
 	.driver = {
 		.name = "lt6911uxc",
 		.owner = THIS_MODULE,
+		.probe_type = PROBE_PREFER_ASYNCHRONOUS,
 		.of_match_table = of_match_ptr(lt6911uxc_of_match),
 	},
 	.probe = lt6911uxc_probe,
@@ -1247,6 +1247,7 @@ static struct i2c_driver ov5693_i2c_driver = {
 	.driver = {
 		.name = "ov5693",
 		.owner = THIS_MODULE,
+		.probe_type = PROBE_PREFER_ASYNCHRONOUS,
 		.of_match_table = of_match_ptr(ov5693_of_match),
 	},
 	.probe = ov5693_probe,
@@ -18,6 +18,7 @@
 #include <linux/types.h>
 #include <media/tegra-v4l2-camera.h>
 #include <media/camera_common.h>
+#include <media/tegracam_utils.h>
 #include <media/mc_common.h>
 #include <linux/of_graph.h>
 #include <linux/string.h>
@@ -1157,3 +1158,80 @@ int camera_common_i2c_write_table_8(
 			wait_ms_addr, end_addr);
 }
 EXPORT_SYMBOL(camera_common_i2c_write_table_8);
+
+/*
+ * Write a sensor blob as a single RTCPU transfer. The transfer is only
+ * split where the blob asks for a delay, so a whole mode table or a
+ * frame worth of control updates costs one IVC round trip instead of
+ * one per register. Without an RTCPU sensor the blob goes out through
+ * regmap as before.
+ */
+int camera_common_i2c_write_blob(
+	struct camera_common_i2c *sensor,
+	struct sensor_blob *blob,
+	int frame_id)
+{
+	int err = 0;
+	int ret;
+	int cmd_idx = 0;
+	int buf_index = 0;
+
+	if (!sensor->rt_sensor)
+		return write_sensor_blob(sensor->regmap, blob);
+
+	err = tegra_i2c_rtcpu_aggregate(sensor->rt_sensor, true);
+	if (err)
+		return err;
+
+	if (frame_id >= 0) {
+		err = tegra_i2c_rtcpu_set_frame_id(sensor->rt_sensor,
+			frame_id);
+		if (err)
+			goto done;
+	}
+
+	while (cmd_idx < blob->num_cmds) {
+		struct sensor_cmd *cmd = &blob->cmds[cmd_idx++];
+		u32 val = cmd->opcode;
+
+		if ((val >> 24) == SENSOR_OPCODE_DONE)
+			break;
+
+		if ((val >> 24) == SENSOR_OPCODE_SLEEP) {
+			/* flush what precedes the delay before sleeping */
+			err = tegra_i2c_rtcpu_aggregate(sensor->rt_sensor,
+				false);
+			if (err)
+				return err;
+
+			val = val & 0x00FFFFFF;
+			usleep_range(val, val + 10);
+
+			err = tegra_i2c_rtcpu_aggregate(sensor->rt_sensor,
+				true);
+			if (err)
+				return err;
+			continue;
+		}
+
+		if ((val >> 24) == SENSOR_OPCODE_WRITE) {
+			int size = val & 0x00FFFFFF;
+
+			err = tegra_i2c_rtcpu_write_reg8(sensor->rt_sensor,
+				cmd->addr, &blob->buf[buf_index], size);
+			if (err)
+				goto done;
+			buf_index += size;
+		} else {
+			pr_err("blob has been packaged with errors\n");
+			err = -EINVAL;
+			goto done;
+		}
+	}
+
+done:
+	ret = tegra_i2c_rtcpu_aggregate(sensor->rt_sensor, false);
+
+	return err ? err : ret;
+}
+EXPORT_SYMBOL(camera_common_i2c_write_blob);
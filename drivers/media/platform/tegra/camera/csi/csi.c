@@ -381,6 +381,7 @@ static void deskew_setup(struct tegra_csi_channel *chan,
 			break;
 		}
 		deskew_ctx->deskew_lanes = 0;
+		deskew_ctx->data_rate = pix_clk_hz;
 		for (i = 0; i < csi_lanes; ++i)
 			deskew_ctx->deskew_lanes |= csi_lane_start << i;
 		nvcsi_deskew_setup(deskew_ctx);
@@ -32,6 +32,7 @@
 
 #define CAPTURE_CHANNEL_UNKNOWN_RESP 0xFFFFFFFF
 #define CAPTURE_CHANNEL_ISP_INVALID_ID 0xFFFF
+#define ISP_CAPTURE_NO_BUFFER_SET U32_MAX
 
 struct isp_desc_rec {
 	struct capture_common_buf requests;
@@ -49,6 +50,17 @@ struct isp_desc_rec {
 	struct capture_common_unpins *unpins_list;
 };
 
+/* Surfaces of a capture descriptor, pinned once for many requests */
+struct isp_buffer_set {
+	struct capture_common_unpins pins;
+	struct isp_capture_descriptor_memoryinfo meminfo;
+	uint64_t request_offset;
+		/**< ring offset of the descriptor the set was built from */
+	uint32_t users;
+		/**< capture descriptors in flight using the set */
+	bool valid;
+};
+
 /* ISP capture context per channel */
 struct isp_capture {
 	uint16_t channel_id;
@@ -62,6 +74,13 @@ struct isp_capture {
 	/* isp program desc and it's ring buffer related details */
 	struct isp_desc_rec program_desc_ctx;
 
+	/*
+	 * registered buffer sets, and the set used by each isp capture
+	 * descriptor; protected by capture_desc_ctx.unpins_list_lock
+	 */
+	struct isp_buffer_set buffer_sets[ISP_CAPTURE_MAX_BUFFER_SETS];
+	struct isp_buffer_set **request_sets;
+
 	struct capture_common_status_notifier progress_status_notifier;
 	bool is_progress_status_notifier_set;
 
@@ -123,6 +142,9 @@ static void isp_capture_request_unpin(struct tegra_isp_channel *chan,
 static void isp_capture_program_request_unpin(struct tegra_isp_channel *chan,
 		uint32_t buffer_index);
 
+static void isp_capture_buffer_set_put(struct isp_capture *capture,
+		struct isp_buffer_set *set);
+
 static void isp_capture_ivc_status_callback(const void *ivc_resp,
 		const void *pcontext)
 {
@@ -487,6 +509,16 @@ int isp_capture_setup(struct tegra_isp_channel *chan,
 		goto unpins_list_fail;
 	}
 
+	capture->request_sets = vzalloc(
+		capture->capture_desc_ctx.queue_depth *
+			sizeof(*capture->request_sets));
+
+	if (unlikely(capture->request_sets == NULL)) {
+		dev_err(chan->isp_dev,
+			"failed to allocate buffer set array\n");
+		goto request_sets_fail;
+	}
+
 	/* Allocate memory info ring buffer for isp capture descriptors */
 	capture->capture_desc_ctx.requests_memoryinfo =
 		dma_alloc_coherent(capture->rtcpu_dev,
@@ -665,6 +697,9 @@ prog_pin_fail:
 		capture->capture_desc_ctx.requests_memoryinfo,
 		capture->capture_desc_ctx.requests_memoryinfo_iova);
 capture_meminfo_alloc_fail:
+	vfree(capture->request_sets);
+	capture->request_sets = NULL;
+request_sets_fail:
 	vfree(capture->capture_desc_ctx.unpins_list);
 unpins_list_fail:
 	capture_common_unpin_memory(&capture->capture_desc_ctx.requests);
@@ -824,6 +859,11 @@ int isp_capture_release(struct tegra_isp_channel *chan,
 		isp_capture_request_unpin(chan, i);
 	}
 
+	mutex_lock(&capture->capture_desc_ctx.unpins_list_lock);
+	for (i = 0; i < ISP_CAPTURE_MAX_BUFFER_SETS; i++)
+		isp_capture_buffer_set_put(capture, &capture->buffer_sets[i]);
+	mutex_unlock(&capture->capture_desc_ctx.unpins_list_lock);
+
 	isp_capture_release_syncpts(chan);
 
 	capture_common_unpin_memory(&capture->capture_desc_ctx.requests);
@@ -832,6 +872,8 @@ int isp_capture_release(struct tegra_isp_channel *chan,
 	capture->program_desc_ctx.unpins_list = NULL;
 	vfree(capture->capture_desc_ctx.unpins_list);
 	capture->capture_desc_ctx.unpins_list = NULL;
+	vfree(capture->request_sets);
+	capture->request_sets = NULL;
 
 	dma_free_coherent(capture->rtcpu_dev,
 		capture->program_desc_ctx.queue_depth *
@@ -1080,6 +1122,10 @@ static void isp_capture_request_unpin(struct tegra_isp_channel *chan,
 			put_mapping(capture->buffer_ctx, unpins->data[i]);
 		(void)memset(unpins, 0U, sizeof(*unpins));
 	}
+	if (capture->request_sets[buffer_index] != NULL) {
+		capture->request_sets[buffer_index]->users--;
+		capture->request_sets[buffer_index] = NULL;
+	}
 	mutex_unlock(&capture->capture_desc_ctx.unpins_list_lock);
 }
 
@@ -1245,19 +1291,15 @@ int isp_capture_program_status(struct tegra_isp_channel *chan)
  */
 static int pin_isp_capture_request_buffers_locked(
 		struct tegra_isp_channel *chan,
-		struct isp_capture_req *req,
+		uint32_t buffer_index,
+		struct isp_capture_descriptor_memoryinfo *desc_mem,
 		struct capture_common_unpins *request_unpins)
 {
 	struct isp_desc_rec *capture_desc_ctx =
 			&chan->capture_data->capture_desc_ctx;
 	struct isp_capture_descriptor *desc = (struct isp_capture_descriptor *)
 		(capture_desc_ctx->requests.va +
-			req->buffer_index * capture_desc_ctx->request_size);
-
-	struct isp_capture_descriptor_memoryinfo *desc_mem =
-		&((struct isp_capture_descriptor_memoryinfo *)
-			capture_desc_ctx->requests_memoryinfo)
-				[req->buffer_index];
+			buffer_index * capture_desc_ctx->request_size);
 
 	struct capture_buffer_table *buffer_ctx =
 			chan->capture_data->buffer_ctx;
@@ -1265,7 +1307,7 @@ static int pin_isp_capture_request_buffers_locked(
 	int err = 0;
 
 	/* Pushbuffer 2 is located after isp desc, in same ringbuffer */
-	uint32_t request_offset = req->buffer_index *
+	uint32_t request_offset = buffer_index *
 			capture_desc_ctx->request_size;
 
 	err = capture_common_pin_and_get_iova(buffer_ctx,
@@ -1360,8 +1402,149 @@ fail:
 	return err;
 }
 
-int isp_capture_request(struct tegra_isp_channel *chan,
-		struct isp_capture_req *req)
+static void isp_capture_buffer_set_put(struct isp_capture *capture,
+		struct isp_buffer_set *set)
+{
+	int i;
+
+	for (i = 0; i < set->pins.num_unpins; i++)
+		put_mapping(capture->buffer_ctx, set->pins.data[i]);
+	(void)memset(set, 0U, sizeof(*set));
+}
+
+/**
+ * Fill the memoryinfo of a capture descriptor from a registered buffer
+ * set, in place of pinning its surfaces.
+ */
+static int isp_capture_use_buffer_set_locked(
+		struct tegra_isp_channel *chan,
+		uint32_t buffer_index, uint32_t set_index)
+{
+	struct isp_capture *capture = chan->capture_data;
+	struct isp_desc_rec *capture_desc_ctx = &capture->capture_desc_ctx;
+	struct isp_capture_descriptor_memoryinfo *desc_mem =
+		&((struct isp_capture_descriptor_memoryinfo *)
+			capture_desc_ctx->requests_memoryinfo)[buffer_index];
+	struct memoryinfo_surface *pb2 = &desc_mem->isp_pb2_mem;
+	struct isp_buffer_set *set;
+	uint64_t request_offset = (uint64_t)buffer_index *
+			capture_desc_ctx->request_size;
+
+	if (set_index >= ISP_CAPTURE_MAX_BUFFER_SETS) {
+		dev_err(chan->isp_dev, "buffer set index is out of bound\n");
+		return -EINVAL;
+	}
+	set_index = array_index_nospec(set_index,
+			ISP_CAPTURE_MAX_BUFFER_SETS);
+
+	set = &capture->buffer_sets[set_index];
+	if (!set->valid) {
+		dev_err(chan->isp_dev, "buffer set %u is not registered\n",
+			set_index);
+		return -ENOENT;
+	}
+
+	*desc_mem = set->meminfo;
+
+	/* Pushbuffer 2 follows the descriptor, move it to this slot */
+	if (pb2->base_address != 0ULL) {
+		if (pb2->size + set->request_offset <= request_offset) {
+			dev_err(chan->isp_dev,
+				"%s: pushbuffer2 is out of bounds\n", __func__);
+			return -EINVAL;
+		}
+		pb2->base_address = pb2->base_address - set->request_offset +
+				request_offset;
+		pb2->size = pb2->size + set->request_offset - request_offset;
+	}
+
+	capture->request_sets[buffer_index] = set;
+	set->users++;
+
+	return 0;
+}
+
+int isp_capture_buffer_set(struct tegra_isp_channel *chan,
+		struct isp_buffer_set_req *req)
+{
+	struct isp_capture *capture = chan->capture_data;
+	struct isp_buffer_set *set;
+	uint32_t set_index;
+	int err = 0;
+
+	if (capture == NULL) {
+		dev_err(chan->isp_dev,
+			"%s: isp capture uninitialized\n", __func__);
+		return -ENODEV;
+	}
+
+	if (capture->channel_id == CAPTURE_CHANNEL_ISP_INVALID_ID) {
+		dev_err(chan->isp_dev,
+			"%s: setup channel first\n", __func__);
+		return -ENODEV;
+	}
+
+	if (req->flag != ISP_BUFFER_SET_REGISTER &&
+			req->flag != ISP_BUFFER_SET_UNREGISTER) {
+		dev_err(chan->isp_dev, "%s: invalid flag %u\n", __func__,
+			req->flag);
+		return -EINVAL;
+	}
+
+	if (req->set_index >= ISP_CAPTURE_MAX_BUFFER_SETS) {
+		dev_err(chan->isp_dev, "buffer set index is out of bound\n");
+		return -EINVAL;
+	}
+
+	if (req->flag == ISP_BUFFER_SET_REGISTER &&
+			req->buffer_index >= capture->capture_desc_ctx.queue_depth) {
+		dev_err(chan->isp_dev, "buffer index is out of bound\n");
+		return -EINVAL;
+	}
+
+	speculation_barrier();
+
+	set_index = array_index_nospec(req->set_index,
+			ISP_CAPTURE_MAX_BUFFER_SETS);
+	set = &capture->buffer_sets[set_index];
+
+	mutex_lock(&capture->capture_desc_ctx.unpins_list_lock);
+
+	if (set->users != 0U) {
+		dev_err(chan->isp_dev,
+			"%s: buffer set %u is still in use by rtcpu\n",
+			__func__, set_index);
+		err = -EBUSY;
+		goto unlock;
+	}
+
+	/* registering again replaces the previous surfaces */
+	isp_capture_buffer_set_put(capture, set);
+
+	if (req->flag == ISP_BUFFER_SET_UNREGISTER)
+		goto unlock;
+
+	err = pin_isp_capture_request_buffers_locked(chan, req->buffer_index,
+			&set->meminfo, &set->pins);
+	if (err < 0) {
+		dev_err(chan->isp_dev, "%s: failed to pin buffer set %u\n",
+			__func__, set_index);
+		isp_capture_buffer_set_put(capture, set);
+		goto unlock;
+	}
+
+	set->request_offset = (uint64_t)req->buffer_index *
+			capture->capture_desc_ctx.request_size;
+	set->valid = true;
+
+unlock:
+	mutex_unlock(&capture->capture_desc_ctx.unpins_list_lock);
+
+	return err;
+}
+
+static int __isp_capture_request(struct tegra_isp_channel *chan,
+		struct isp_capture_req *req, uint32_t set_index)
 {
 	struct isp_capture *capture = chan->capture_data;
 	struct CAPTURE_MSG capture_msg;
@@ -1428,7 +1611,8 @@ int isp_capture_request(struct tegra_isp_channel *chan,
 	}
 
 	mutex_lock(&capture->capture_desc_ctx.unpins_list_lock);
-	if (capture->capture_desc_ctx.unpins_list[req->buffer_index].num_unpins != 0U) {
+	if (capture->capture_desc_ctx.unpins_list[req->buffer_index].num_unpins != 0U ||
+			capture->request_sets[req->buffer_index] != NULL) {
 		dev_err(chan->isp_dev,
 			"%s: descriptor is still in use by rtcpu\n",
 			__func__);
@@ -1436,8 +1620,16 @@ int isp_capture_request(struct tegra_isp_channel *chan,
 		return -EBUSY;
 	}
 
-	err = pin_isp_capture_request_buffers_locked(chan, req,
-		&capture->capture_desc_ctx.unpins_list[req->buffer_index]);
+	if (set_index == ISP_CAPTURE_NO_BUFFER_SET)
+		err = pin_isp_capture_request_buffers_locked(chan,
+			req->buffer_index,
+			&((struct isp_capture_descriptor_memoryinfo *)
+				capture->capture_desc_ctx.requests_memoryinfo)
+					[req->buffer_index],
+			&capture->capture_desc_ctx.unpins_list[req->buffer_index]);
+	else
+		err = isp_capture_use_buffer_set_locked(chan,
+			req->buffer_index, set_index);
 
 	mutex_unlock(&capture->capture_desc_ctx.unpins_list_lock);
 
@@ -1472,6 +1664,18 @@ fail:
 	return err;
 }
 
+int isp_capture_request(struct tegra_isp_channel *chan,
+		struct isp_capture_req *req)
+{
+	return __isp_capture_request(chan, req, ISP_CAPTURE_NO_BUFFER_SET);
+}
+
+int isp_capture_request_set(struct tegra_isp_channel *chan,
+		struct isp_capture_req_set *req)
+{
+	return __isp_capture_request(chan, &req->capture_req, req->set_index);
+}
+
 int isp_capture_status(struct tegra_isp_channel *chan,
 		int32_t timeout_ms)
 {
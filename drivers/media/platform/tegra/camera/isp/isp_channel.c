@@ -59,6 +59,10 @@
 		_IOW('I', 10, struct isp_capture_progress_status_req)
 #define ISP_CAPTURE_BUFFER_REQUEST \
 		_IOW('I', 11, struct isp_buffer_req)
+#define ISP_CAPTURE_BUFFER_SET \
+		_IOW('I', 12, struct isp_buffer_set_req)
+#define ISP_CAPTURE_REQUEST_SET \
+		_IOW('I', 13, struct isp_capture_req_set)
 
 struct isp_channel_drv {
 	struct device *dev;
@@ -194,6 +198,30 @@ static long isp_channel_ioctl(struct file *file, unsigned int cmd,
 			dev_err(chan->isp_dev, "isp buffer req failed\n");
 		break;
 	}
+	case _IOC_NR(ISP_CAPTURE_BUFFER_SET): {
+		struct isp_buffer_set_req req;
+
+		if (copy_from_user(&req, ptr, sizeof(req)) != 0U)
+			break;
+
+		err = isp_capture_buffer_set(chan, &req);
+		if (err < 0)
+			dev_err(chan->isp_dev, "isp buffer set req failed\n");
+		break;
+	}
+	case _IOC_NR(ISP_CAPTURE_REQUEST_SET): {
+		struct isp_capture_req_set req;
+
+		if (copy_from_user(&req, ptr, sizeof(req)) != 0U)
+			break;
+
+		err = isp_capture_request_set(chan, &req);
+		if (err < 0)
+			dev_err(chan->isp_dev,
+				"isp process capture request with set %u failed\n",
+				req.set_index);
+		break;
+	}
 	default: {
 		dev_err(chan->isp_dev, "%s:Unknown ioctl\n", __func__);
 		return -ENOIOCTLCMD;
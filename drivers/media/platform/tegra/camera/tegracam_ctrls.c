@@ -320,7 +320,23 @@ static int tegracam_set_ctrls(struct tegracam_ctrl_handler *handler,
 		err = ops->set_exposure_short(tc_dev, *ctrl->p_new.p_s64);
 		break;
 	case TEGRA_CAMERA_CID_GROUP_HOLD:
+		/*
+		 * Collect the writes done under group hold into a single
+		 * RTCPU transfer, so they land within the same frame.
+		 */
+		if (ctrl->val && s_data->i2c) {
+			err = camera_common_i2c_aggregate(s_data->i2c, true);
+			if (err)
+				break;
+		}
 		err = ops->set_group_hold(tc_dev, ctrl->val);
+		if (!ctrl->val && s_data->i2c) {
+			int ret = camera_common_i2c_aggregate(s_data->i2c,
+							false);
+
+			if (!err)
+				err = ret;
+		}
 		break;
 	default:
 		pr_err("%s: unknown ctrl id.\n", __func__);
@@ -357,7 +373,7 @@ static int tegracam_set_grouphold_ex(struct tegracam_device *tc_dev,
 
 		/* TODO: block this write selectively from VI5 */
 		if (tc_dev->is_streaming) {
-			err = write_sensor_blob(s_data->regmap, blob);
+			err = tegracam_write_blob(s_data, blob);
 			if (err)
 				return err;
 		}
@@ -223,6 +223,16 @@ int write_sensor_blob(struct regmap *regmap, struct sensor_blob *blob)
 }
 EXPORT_SYMBOL_GPL(write_sensor_blob);
 
+int tegracam_write_blob(struct camera_common_data *s_data,
+			struct sensor_blob *blob)
+{
+	if (s_data->i2c)
+		return camera_common_i2c_write_blob(s_data->i2c, blob, -1);
+
+	return write_sensor_blob(s_data->regmap, blob);
+}
+EXPORT_SYMBOL_GPL(tegracam_write_blob);
+
 int tegracam_write_blobs(struct tegracam_ctrl_handler *hdl)
 {
 	struct camera_common_data *s_data = hdl->tc_dev->s_data;
@@ -242,14 +252,14 @@ int tegracam_write_blobs(struct tegracam_ctrl_handler *hdl)
 	 * and stop streaming cases
 	 */
 	if (mode_blob->num_cmds) {
-		err = write_sensor_blob(s_data->regmap, mode_blob);
+		err = tegracam_write_blob(s_data, mode_blob);
 		if (err) {
 			dev_err(s_data->dev, "Error writing mode blob\n");
 			return err;
 		}
 	}
 
-	err = write_sensor_blob(s_data->regmap, ctrl_blob);
+	err = tegracam_write_blob(s_data, ctrl_blob);
 	if (err) {
 		dev_err(s_data->dev, "Error writing control blob\n");
 		return err;
@@ -119,6 +119,9 @@ static void vi_capture_ivc_status_callback(const void *ivc_resp,
 			 * the new progress status buffer mechanism
 			 */
 			complete(&capture->capture_resp);
+			if (capture->status_notify)
+				capture->status_notify(
+					capture->status_notify_data);
 		}
 		dev_dbg(chan->dev, "%s: status chan_id %u msg_id %u\n",
 				__func__, status_msg->header.channel_id,
@@ -1079,6 +1082,69 @@ int vi_capture_request(struct tegra_vi_channel *chan,
 	return 0;
 }
 
+int vi_capture_request_list(struct tegra_vi_channel *chan,
+		struct vi_capture_req *reqs, uint32_t num_requests)
+{
+	struct vi_capture *capture = chan->capture_data;
+	struct CAPTURE_MSG *capture_descs;
+	uint32_t i;
+	int err = 0;
+
+	if (capture == NULL) {
+		dev_err(chan->dev,
+			"%s: vi capture uninitialized\n", __func__);
+		return -ENODEV;
+	}
+
+	if (capture->channel_id == CAPTURE_CHANNEL_INVALID_ID) {
+		dev_err(chan->dev,
+			"%s: setup channel first\n", __func__);
+		return -ENODEV;
+	}
+
+	if (reqs == NULL || num_requests == 0) {
+		dev_err(chan->dev,
+			"%s: Invalid req\n", __func__);
+		return -EINVAL;
+	}
+
+	capture_descs = kcalloc(num_requests, sizeof(*capture_descs),
+			GFP_KERNEL);
+	if (capture_descs == NULL)
+		return -ENOMEM;
+
+	for (i = 0; i < num_requests; i++) {
+		capture_descs[i].header.msg_id = CAPTURE_REQUEST_REQ;
+		capture_descs[i].header.channel_id = capture->channel_id;
+		capture_descs[i].capture_request_req.buffer_index =
+				reqs[i].buffer_index;
+	}
+
+	mutex_lock(&capture->reset_lock);
+
+	nvhost_eventlib_log_submit(
+			chan->ndev,
+			capture->progress_sp.id,
+			capture->progress_sp.threshold,
+			arch_counter_get_cntvct());
+
+	dev_dbg(chan->dev, "%s: sending chan_id %u %u requests\n",
+			__func__, capture->channel_id, num_requests);
+	err = tegra_capture_ivc_capture_submit_batch(capture_descs,
+			sizeof(*capture_descs), num_requests);
+
+	mutex_unlock(&capture->reset_lock);
+	kfree(capture_descs);
+
+	if (err < 0) {
+		dev_err(chan->dev, "IVC capture submit failed\n");
+		return err;
+	}
+
+	/* the requests that were not sent are returned to the caller */
+	return err;
+}
+
 int vi_capture_status(struct tegra_vi_channel *chan,
 		int32_t timeout_ms)
 {
@@ -1128,6 +1194,62 @@ int vi_capture_status(struct tegra_vi_channel *chan,
 	return 0;
 }
 
+int vi_capture_status_list(struct tegra_vi_channel *chan,
+		struct vi_capture_status_list *req)
+{
+	struct vi_capture *capture = chan->capture_data;
+	int err;
+
+	if (req->max_done == 0) {
+		dev_err(chan->dev,
+			"%s: Invalid req\n", __func__);
+		return -EINVAL;
+	}
+
+	req->num_done = 0;
+
+	err = vi_capture_status(chan, req->timeout_ms);
+	if (err < 0)
+		return err;
+
+	/* drain what completed since the wakeup, without sleeping again */
+	req->num_done = 1;
+	while (req->num_done < req->max_done &&
+			try_wait_for_completion(&capture->capture_resp))
+		req->num_done++;
+
+	return 0;
+}
+
+bool vi_capture_status_poll(struct tegra_vi_channel *chan)
+{
+	struct vi_capture *capture = chan->capture_data;
+
+	if (capture == NULL ||
+		capture->channel_id == CAPTURE_CHANNEL_INVALID_ID)
+		return false;
+
+	return try_wait_for_completion(&capture->capture_resp);
+}
+
+int vi_capture_set_status_notify(struct tegra_vi_channel *chan,
+		void (*notify)(void *data), void *data)
+{
+	struct vi_capture *capture = chan->capture_data;
+
+	if (capture == NULL) {
+		dev_err(chan->dev,
+			 "%s: vi capture uninitialized\n", __func__);
+		return -ENODEV;
+	}
+
+	/* set before any request is queued, the callback has no lock */
+	capture->status_notify_data = data;
+	WRITE_ONCE(capture->status_notify, notify);
+
+	return 0;
+}
+
 int vi_capture_set_progress_status_notifier(struct tegra_vi_channel *chan,
 		struct vi_capture_progress_status_req *req)
 {
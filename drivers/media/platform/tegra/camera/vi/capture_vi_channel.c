@@ -47,6 +47,10 @@
 	_IOW('I', 9, struct vi_capture_progress_status_req)
 #define VI_CAPTURE_BUFFER_REQUEST \
 	_IOW('I', 10, struct vi_buffer_req)
+#define VI_CAPTURE_REQUEST_LIST \
+	_IOWR('I', 11, struct vi_capture_req_list)
+#define VI_CAPTURE_STATUS_LIST \
+	_IOWR('I', 12, struct vi_capture_status_list)
 
 struct vi_channel_drv {
 	struct device *dev;
@@ -127,6 +131,55 @@ fail:
 	return err;
 }
 
+static int vi_channel_pin_request(struct tegra_vi_channel *chan,
+		struct vi_capture_req *req)
+{
+	struct vi_capture *capture = chan->capture_data;
+	struct capture_common_unpins *request_unpins;
+	int err;
+
+	if (req->num_relocs == 0) {
+		dev_err(chan->dev, "request must have non-zero relocs\n");
+		return -EINVAL;
+	}
+
+	if (capture->unpins_list == NULL) {
+		dev_err(chan->dev, "Channel setup incomplete\n");
+		return -EINVAL;
+	}
+
+	if (req->buffer_index >= capture->queue_depth) {
+		dev_err(chan->dev, "invalid buffer index %u\n",
+			req->buffer_index);
+		return -EINVAL;
+	}
+
+	/* Don't let to speculate with invalid buffer_index value */
+	speculation_barrier();
+
+	mutex_lock(&capture->unpins_list_lock);
+
+	request_unpins = &capture->unpins_list[req->buffer_index];
+
+	if (request_unpins->num_unpins != 0U) {
+		dev_err(chan->dev, "Descriptor is still in use by rtcpu\n");
+		mutex_unlock(&capture->unpins_list_lock);
+		return -EBUSY;
+	}
+	err = pin_vi_capture_request_buffers_locked(chan, req,
+			request_unpins);
+
+	mutex_unlock(&capture->unpins_list_lock);
+
+	if (err < 0) {
+		dev_err(chan->dev,
+			"pin request failed\n");
+		vi_capture_request_unpin(chan, req->buffer_index);
+	}
+
+	return err;
+}
+
 static long vi_channel_ioctl(struct file *file, unsigned int cmd,
 				unsigned long arg)
 {
@@ -247,51 +300,81 @@ static long vi_channel_ioctl(struct file *file, unsigned int cmd,
 
 	case _IOC_NR(VI_CAPTURE_REQUEST): {
 		struct vi_capture_req req;
-		struct capture_common_unpins *request_unpins;
 
 		if (copy_from_user(&req, ptr, sizeof(req)))
 			break;
 
-		if (req.num_relocs == 0) {
-			dev_err(chan->dev, "request must have non-zero relocs\n");
-			return -EINVAL;
-		}
-
-		/* Don't let to speculate with invalid buffer_index value */
-		speculation_barrier();
+		err = vi_channel_pin_request(chan, &req);
+		if (err < 0)
+			break;
 
-		if (capture->unpins_list == NULL) {
-			dev_err(chan->dev, "Channel setup incomplete\n");
-			return -EINVAL;
+		err = vi_capture_request(chan, &req);
+		if (err < 0) {
+			dev_err(chan->dev,
+				"vi capture request submit failed\n");
+			vi_capture_request_unpin(chan, req.buffer_index);
 		}
+		break;
+	}
 
-		mutex_lock(&capture->unpins_list_lock);
+	case _IOC_NR(VI_CAPTURE_REQUEST_LIST): {
+		struct vi_capture_req_list list;
+		struct vi_capture_req *reqs;
+		uint32_t i, num_pinned = 0;
+		int sent;
 
-		request_unpins = &capture->unpins_list[req.buffer_index];
+		if (copy_from_user(&list, ptr, sizeof(list)))
+			break;
 
-		if (request_unpins->num_unpins != 0U) {
-			dev_err(chan->dev, "Descriptor is still in use by rtcpu\n");
-			mutex_unlock(&capture->unpins_list_lock);
-			return -EBUSY;
+		if (list.num_requests == 0 ||
+				list.num_requests > VI_CAPTURE_MAX_REQUEST_LIST ||
+				list.num_requests > capture->queue_depth) {
+			dev_err(chan->dev, "invalid request list size %u\n",
+				list.num_requests);
+			return -EINVAL;
 		}
-		err = pin_vi_capture_request_buffers_locked(chan, &req,
-				request_unpins);
 
-		mutex_unlock(&capture->unpins_list_lock);
+		reqs = kcalloc(list.num_requests, sizeof(*reqs), GFP_KERNEL);
+		if (reqs == NULL)
+			return -ENOMEM;
 
-		if (err < 0) {
-			dev_err(chan->dev,
-				"pin request failed\n");
-			vi_capture_request_unpin(chan, req.buffer_index);
+		if (copy_from_user(reqs,
+				(void __user *)(uintptr_t)list.requests,
+				list.num_requests * sizeof(*reqs))) {
+			kfree(reqs);
 			break;
 		}
 
-		err = vi_capture_request(chan, &req);
-		if (err < 0) {
-			dev_err(chan->dev,
-				"vi capture request submit failed\n");
-			vi_capture_request_unpin(chan, req.buffer_index);
+		for (num_pinned = 0; num_pinned < list.num_requests;
+				num_pinned++) {
+			err = vi_channel_pin_request(chan, &reqs[num_pinned]);
+			if (err < 0)
+				break;
 		}
+
+		/* queue what could be pinned, stop at the first failure */
+		sent = 0;
+		if (num_pinned > 0) {
+			sent = vi_capture_request_list(chan, reqs, num_pinned);
+			if (sent < 0) {
+				dev_err(chan->dev,
+					"vi capture request list submit failed\n");
+				err = sent;
+				sent = 0;
+			}
+		}
+
+		for (i = sent; i < num_pinned; i++)
+			vi_capture_request_unpin(chan, reqs[i].buffer_index);
+
+		if (err >= 0 && (uint32_t)sent < list.num_requests)
+			err = -EIO;
+
+		kfree(reqs);
+
+		list.num_queued = sent;
+		if (copy_to_user(ptr, &list, sizeof(list)))
+			err = -EFAULT;
 		break;
 	}
 
@@ -307,6 +390,20 @@ static long vi_channel_ioctl(struct file *file, unsigned int cmd,
 		break;
 	}
 
+	case _IOC_NR(VI_CAPTURE_STATUS_LIST): {
+		struct vi_capture_status_list req;
+
+		if (copy_from_user(&req, ptr, sizeof(req)))
+			break;
+		err = vi_capture_status_list(chan, &req);
+		if (err < 0)
+			dev_err(chan->dev,
+				"vi capture get status list failed\n");
+		if (copy_to_user(ptr, &req, sizeof(req)))
+			err = -EFAULT;
+		break;
+	}
+
 	case _IOC_NR(VI_CAPTURE_SET_COMPAND): {
 		struct vi_capture_compand compand;
 
@@ -773,8 +773,172 @@ static void tegra_channel_buffer_queue(struct vb2_buffer *vb)
 
 	/* Wake up kthread for capture */
 	wake_up_interruptible(&chan->start_wait);
+
+	if (chan->vi->fops && chan->vi->fops->vi_buffer_queued)
+		chan->vi->fops->vi_buffer_queued(chan);
+}
+
+static const struct v4l2_file_operations tegra_channel_fops;
+
+/*
+ * Capture graph: a driver downstream of VI (ISP, DLA, ...) links itself
+ * to a channel and gets each completed frame from the capture completion
+ * path, so it can submit its own work without a round trip through user
+ * space. Linking is only allowed while the channel is not streaming,
+ * which keeps the sink stable for the completion path.
+ */
+struct tegra_channel *tegra_channel_from_file(struct file *file)
+{
+	struct video_device *vdev = video_devdata(file);
+
+	if (vdev == NULL || vdev->fops != &tegra_channel_fops)
+		return ERR_PTR(-EINVAL);
+
+	return video_drvdata(file);
+}
+EXPORT_SYMBOL(tegra_channel_from_file);
+
+int tegra_channel_link_sink(struct tegra_channel *chan,
+		const struct tegra_channel_sink_ops *ops, void *priv)
+{
+	int err = 0;
+
+	if (ops == NULL || ops->frame_done == NULL)
+		return -EINVAL;
+
+	mutex_lock(&chan->video_lock);
+	if (vb2_is_streaming(&chan->queue)) {
+		err = -EBUSY;
+	} else if (chan->sink_ops != NULL) {
+		err = -EEXIST;
+	} else {
+		chan->sink_priv = priv;
+		chan->sink_ops = ops;
+	}
+	mutex_unlock(&chan->video_lock);
+
+	return err;
+}
+EXPORT_SYMBOL(tegra_channel_link_sink);
+
+int tegra_channel_unlink_sink(struct tegra_channel *chan)
+{
+	int err = 0;
+
+	mutex_lock(&chan->video_lock);
+	if (vb2_is_streaming(&chan->queue)) {
+		err = -EBUSY;
+	} else {
+		chan->sink_ops = NULL;
+		chan->sink_priv = NULL;
+	}
+	mutex_unlock(&chan->video_lock);
+
+	return err;
+}
+EXPORT_SYMBOL(tegra_channel_unlink_sink);
+
+bool tegra_channel_sink_frame_done(struct tegra_channel *chan,
+		struct tegra_channel_buffer *buf)
+{
+	struct tegra_channel_frame frame;
+
+	if (chan->sink_ops == NULL)
+		return false;
+
+	frame.buf = buf;
+	frame.addr = buf->addr;
+	frame.size = chan->format.sizeimage;
+	frame.sequence = buf->buf.sequence;
+
+	atomic_inc(&chan->sink_held);
+	if (chan->sink_ops->frame_done(chan->sink_priv, &frame))
+		return true;
+
+	if (atomic_dec_and_test(&chan->sink_held))
+		wake_up(&chan->sink_wait);
+
+	return false;
+}
+
+void tegra_channel_sink_release(struct tegra_channel_buffer *buf)
+{
+	struct tegra_channel *chan = buf->chan;
+
+	vb2_buffer_done(&buf->buf.vb2_buf, buf->vb2_state);
+
+	if (atomic_dec_and_test(&chan->sink_held))
+		wake_up(&chan->sink_wait);
 }
+EXPORT_SYMBOL(tegra_channel_sink_release);
 
+/* videobuf2 wants every buffer back before streaming stops */
+void tegra_channel_sink_drain(struct tegra_channel *chan)
+{
+	if (!wait_event_timeout(chan->sink_wait,
+			atomic_read(&chan->sink_held) == 0,
+			msecs_to_jiffies(2500)))
+		dev_err(chan->vi->dev,
+			"%d buffers still held by the channel sink\n",
+			atomic_read(&chan->sink_held));
+}
+
+void tegra_channel_stats_reset(struct tegra_channel *chan)
+{
+	struct tegra_channel_stats *stats = &chan->stats;
+	unsigned long flags;
+
+	spin_lock_irqsave(&stats->lock, flags);
+	stats->frames = 0;
+	stats->errors = 0;
+	stats->discarded = 0;
+	stats->missed = 0;
+	stats->last_frame_id = 0;
+	stats->first_sof_ts = 0;
+	stats->last_sof_ts = 0;
+	stats->latency_sum = 0;
+	stats->latency_max = 0;
+	spin_unlock_irqrestore(&stats->lock, flags);
+}
+EXPORT_SYMBOL(tegra_channel_stats_reset);
+
+void tegra_channel_stats_update(struct tegra_channel *chan,
+		struct tegra_channel_buffer *buf)
+{
+	struct tegra_channel_stats *stats = &chan->stats;
+	unsigned long flags;
+	u64 latency;
+	s32 gap;
+
+	spin_lock_irqsave(&stats->lock, flags);
+	switch (buf->vb2_state) {
+	case VB2_BUF_STATE_DONE:
+		if (stats->frames) {
+			gap = buf->frame_id - stats->last_frame_id - 1;
+			if (gap > 0)
+				stats->missed += gap;
+		} else {
+			stats->first_sof_ts = buf->sof_ts;
+		}
+		stats->frames++;
+		stats->last_frame_id = buf->frame_id;
+		stats->last_sof_ts = buf->sof_ts;
+
+		latency = buf->done_ts - buf->eof_ts;
+		stats->latency_sum += latency;
+		if (latency > stats->latency_max)
+			stats->latency_max = latency;
+		break;
+	case VB2_BUF_STATE_REQUEUEING:
+		stats->discarded++;
+		break;
+	default:
+		stats->errors++;
+		break;
+	}
+	spin_unlock_irqrestore(&stats->lock, flags);
+}
+EXPORT_SYMBOL(tegra_channel_stats_update);
 
 static void tegra_channel_queued_buf_done_single_thread(
 		struct tegra_channel *chan,
@@ -971,10 +1135,26 @@ static void tegra_channel_stop_streaming(struct vb2_queue *vq)
 	queue_init_ts = 0;
 }
 
+static void tegra_channel_buffer_finish(struct vb2_buffer *vb)
+{
+	struct vb2_v4l2_buffer *vbuf = to_vb2_v4l2_buffer(vb);
+	struct tegra_channel *chan = vb2_get_drv_priv(vb->vb2_queue);
+	struct tegra_channel_buffer *buf = to_tegra_channel_buffer(vbuf);
+
+	/* only frames stamped by the capture path have a timeline */
+	if (vb->state == VB2_BUF_STATE_DONE && buf->done_ts)
+		trace_tegra_channel_frame_timeline(chan->video->name,
+			vbuf->sequence, buf->frame_id, buf->sof_ts,
+			buf->eof_ts, buf->done_ts, ktime_get_ns());
+
+	buf->done_ts = 0;
+}
+
 static const struct vb2_ops tegra_channel_queue_qops = {
 	.queue_setup = tegra_channel_queue_setup,
 	.buf_prepare = tegra_channel_buffer_prepare,
 	.buf_queue = tegra_channel_buffer_queue,
+	.buf_finish = tegra_channel_buffer_finish,
 	.wait_prepare = vb2_ops_wait_prepare,
 	.wait_finish = vb2_ops_wait_finish,
 	.start_streaming = tegra_channel_start_streaming,
@@ -2330,6 +2510,9 @@ int tegra_channel_init(struct tegra_channel *chan)
 	INIT_LIST_HEAD(&chan->dequeue);
 	init_waitqueue_head(&chan->dequeue_wait);
 	spin_lock_init(&chan->dequeue_lock);
+	atomic_set(&chan->sink_held, 0);
+	init_waitqueue_head(&chan->sink_wait);
+	spin_lock_init(&chan->stats.lock);
 	mutex_init(&chan->stop_kthread_lock);
 	init_rwsem(&chan->reset_lock);
 	atomic_set(&chan->is_streaming, DISABLE);
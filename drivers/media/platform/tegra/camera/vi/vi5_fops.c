@@ -10,11 +10,10 @@
  * published by the Free Software Foundation.
  */
 
-#include <linux/freezer.h>
-#include <linux/kthread.h>
 #include <linux/nvhost.h>
 #include <linux/tegra-powergate.h>
 #include <linux/semaphore.h>
+#include <linux/workqueue.h>
 #include <media/tegra_camera_platform.h>
 #include <media/mc_common.h>
 #include <media/tegra-v4l2-camera.h>
@@ -46,6 +45,10 @@
 	| CAPTURE_STATUS_CHANSEL_NOMATCH \
 	| CAPTURE_STATUS_ABORTED)
 
+/* shared by all channels, so the thread count does not grow with them */
+static struct workqueue_struct *vi5_capture_wq;
+static DEFINE_MUTEX(vi5_capture_wq_lock);
+
 static const struct vi_capture_setup default_setup = {
 	.channel_flags = 0
 	| CAPTURE_CHANNEL_FLAG_VIDEO
@@ -241,6 +244,42 @@ done:
 	return ret;
 }
 
+static void vi5_capture_queue_work(struct tegra_channel *chan,
+	struct work_struct *work)
+{
+	unsigned long flags;
+
+	spin_lock_irqsave(&chan->capture_state_lock, flags);
+	if (chan->capture_work_active)
+		queue_work(vi5_capture_wq, work);
+	spin_unlock_irqrestore(&chan->capture_state_lock, flags);
+}
+
+static void vi5_capture_arm_timeout(struct tegra_channel *chan, bool restart)
+{
+	unsigned long flags;
+	unsigned long delay = msecs_to_jiffies(CAPTURE_TIMEOUT_MS);
+
+	spin_lock_irqsave(&chan->capture_state_lock, flags);
+	if (chan->capture_work_active) {
+		if (restart)
+			mod_delayed_work(vi5_capture_wq,
+				&chan->capture_timeout_work, delay);
+		else
+			queue_delayed_work(vi5_capture_wq,
+				&chan->capture_timeout_work, delay);
+	}
+	spin_unlock_irqrestore(&chan->capture_state_lock, flags);
+}
+
+/* Called from the capture status IVC callback for every completed frame */
+static void vi5_capture_status_notify(void *data)
+{
+	struct tegra_channel *chan = data;
+
+	vi5_capture_queue_work(chan, &chan->capture_dequeue_work);
+}
+
 static int tegra_channel_capture_setup(struct tegra_channel *chan, unsigned int vi_port )
 {
 	struct vi_capture_setup setup = default_setup;
@@ -268,6 +307,13 @@ static int tegra_channel_capture_setup(struct tegra_channel *chan, unsigned int
 		return err;
 	}
 
+	err = vi_capture_set_status_notify(chan->tegra_vi_channel[vi_port],
+			vi5_capture_status_notify, chan);
+	if (err) {
+		dev_err(chan->vi->dev, "vi capture status notify failed\n");
+		return err;
+	}
+
 	return 0;
 }
 
@@ -334,6 +380,15 @@ static void vi5_release_buffer(struct tegra_channel *chan,
 	vbuf->field = V4L2_FIELD_NONE;
 	vb2_set_plane_payload(&vbuf->vb2_buf, 0, chan->format.sizeimage);
 
+	if (buf->vb2_state == VB2_BUF_STATE_DONE)
+		buf->done_ts = ktime_get_ns();
+	tegra_channel_stats_update(chan, buf);
+
+	/* a linked sink may keep the frame until its own work is done */
+	if (buf->vb2_state == VB2_BUF_STATE_DONE &&
+			tegra_channel_sink_frame_done(chan, buf))
+		return;
+
 	vb2_buffer_done(&vbuf->vb2_buf, buf->vb2_state);
 }
 
@@ -350,6 +405,8 @@ static void vi5_capture_enqueue(struct tegra_channel *chan,
 		.buffer_index = 0,
 	}};
 
+	buf->capture_ports_done = 0;
+
 	for(vi_port = 0; vi_port < chan->valid_ports; vi_port++)
 	{
 		vi5_setup_surface(chan, buf, chan->capture_descr_index, vi_port);
@@ -377,7 +434,7 @@ static void vi5_capture_enqueue(struct tegra_channel *chan,
 	list_add_tail(&buf->queue, &chan->dequeue);
 	spin_unlock(&chan->dequeue_lock);
 
-	wake_up_interruptible(&chan->dequeue_wait);
+	vi5_capture_arm_timeout(chan, false);
 
 	return;
 
@@ -385,12 +442,14 @@ uncorr_err:
 	spin_lock_irqsave(&chan->capture_state_lock, flags);
 	chan->capture_state = CAPTURE_ERROR;
 	spin_unlock_irqrestore(&chan->capture_state_lock, flags);
+
+	/* let the dequeue side run the error recovery */
+	vi5_capture_queue_work(chan, &chan->capture_dequeue_work);
 }
 
 static void vi5_capture_dequeue(struct tegra_channel *chan,
 	struct tegra_channel_buffer *buf)
 {
-	int err = 0;
 	int vi_port = 0;
 	int gang_prev_frame_id = 0;
 	unsigned long flags;
@@ -405,18 +464,8 @@ static void vi5_capture_dequeue(struct tegra_channel *chan,
 		if (buf->vb2_state != VB2_BUF_STATE_ACTIVE)
 			goto rel_buf;
 
-		/* Dequeue a frame and check its capture status */
-		err = vi_capture_status(chan->tegra_vi_channel[vi_port], CAPTURE_TIMEOUT_MS);
-		if (err) {
-			if (err == -ETIMEDOUT) {
-				dev_err(vi->dev,
-					"uncorr_err: request timed out after %d ms\n",
-					CAPTURE_TIMEOUT_MS);
-			} else {
-				dev_err(vi->dev, "uncorr_err: request err %d\n", err);
-			}
-			goto uncorr_err;
-		} else if (descr->status.status != CAPTURE_STATUS_SUCCESS) {
+		/* The status was already consumed, check the frame result */
+		if (descr->status.status != CAPTURE_STATUS_SUCCESS) {
 			if ((descr->status.flags
 					& CAPTURE_STATUS_FLAG_CHANNEL_IN_ERROR) != 0) {
 				chan->queue_error = true;
@@ -447,7 +496,6 @@ static void vi5_capture_dequeue(struct tegra_channel *chan,
 		spin_unlock_irqrestore(&chan->capture_state_lock, flags);
 	}
 
-	wake_up_interruptible(&chan->start_wait);
 	/* Read SOF from capture descriptor */
 	ts = ns_to_timespec((s64)descr->status.sof_timestamp);
 	trace_tegra_channel_capture_frame("sof", ts);
@@ -459,6 +507,10 @@ static void vi5_capture_dequeue(struct tegra_channel *chan,
 	vb->vb2_buf.timestamp = descr->status.sof_timestamp;
 #endif
 
+	buf->frame_id = descr->status.frame_id;
+	buf->sof_ts = descr->status.sof_timestamp;
+	buf->eof_ts = descr->status.eof_timestamp;
+
 	buf->vb2_state = VB2_BUF_STATE_DONE;
 	/* Read EOF from capture descriptor */
 	ts = ns_to_timespec((s64)descr->status.eof_timestamp);
@@ -546,146 +598,181 @@ done:
 	return err;
 }
 
-static int tegra_channel_kthread_capture_enqueue(void *data)
+static void vi5_capture_enqueue_work(struct work_struct *work)
 {
-	struct tegra_channel *chan = data;
+	struct tegra_channel *chan = container_of(work, struct tegra_channel,
+			capture_enqueue_work);
 	struct tegra_channel_buffer *buf;
 	unsigned long flags;
-	set_freezable();
 
-	while (1) {
-		try_to_freeze();
-
-		wait_event_interruptible(chan->start_wait,
-			(kthread_should_stop() || !list_empty(&chan->capture)));
-
-		while (!(kthread_should_stop() || list_empty(&chan->capture))) {
-			spin_lock_irqsave(&chan->capture_state_lock, flags);
-			if ((chan->capture_state == CAPTURE_ERROR)
-					|| !(chan->capture_reqs_enqueued
-					< (chan->capture_queue_depth * chan->valid_ports))) {
-				spin_unlock_irqrestore(
-					&chan->capture_state_lock, flags);
-				break;
-			}
+	while (!list_empty(&chan->capture)) {
+		spin_lock_irqsave(&chan->capture_state_lock, flags);
+		if ((chan->capture_state == CAPTURE_ERROR)
+				|| !(chan->capture_reqs_enqueued
+				< (chan->capture_queue_depth * chan->valid_ports))) {
 			spin_unlock_irqrestore(&chan->capture_state_lock,
 				flags);
+			break;
+		}
+		spin_unlock_irqrestore(&chan->capture_state_lock, flags);
+
+		buf = dequeue_buffer(chan, false);
+		if (!buf)
+			break;
 
-			buf = dequeue_buffer(chan, false);
-			if (!buf)
-				break;
+		buf->vb2_state = VB2_BUF_STATE_ACTIVE;
 
-			buf->vb2_state = VB2_BUF_STATE_ACTIVE;
+		vi5_capture_enqueue(chan, buf);
+	}
+}
 
-			vi5_capture_enqueue(chan, buf);
-		}
+/*
+ * Check, without sleeping, whether all ports of the oldest in-flight
+ * buffer have reported their status. Ports already seen are remembered
+ * in the buffer, so each status is consumed only once.
+ */
+static bool vi5_capture_done(struct tegra_channel *chan,
+	struct tegra_channel_buffer *buf)
+{
+	int vi_port;
 
-		if (kthread_should_stop())
-			break;
+	if (buf->vb2_state != VB2_BUF_STATE_ACTIVE)
+		return true;
+
+	for (vi_port = 0; vi_port < chan->valid_ports; vi_port++) {
+		if (buf->capture_ports_done & BIT(vi_port))
+			continue;
+
+		if (!vi_capture_status_poll(chan->tegra_vi_channel[vi_port]))
+			return false;
+
+		buf->capture_ports_done |= BIT(vi_port);
 	}
 
-	return 0;
+	return true;
 }
 
-static int tegra_channel_kthread_capture_dequeue(void *data)
+static void vi5_capture_dequeue_work(struct work_struct *work)
 {
 	int err = 0;
 	unsigned long flags;
-	struct tegra_channel *chan = data;
+	bool error, progress = false;
+	struct tegra_channel *chan = container_of(work, struct tegra_channel,
+			capture_dequeue_work);
 	struct tegra_channel_buffer *buf;
 
-	set_freezable();
-
 	while (1) {
-		try_to_freeze();
+		spin_lock_irqsave(&chan->capture_state_lock, flags);
+		error = (chan->capture_state == CAPTURE_ERROR);
+		spin_unlock_irqrestore(&chan->capture_state_lock, flags);
+		if (error)
+			break;
 
-		wait_event_interruptible(chan->dequeue_wait,
-			(kthread_should_stop()
-				|| !list_empty(&chan->dequeue)
-				|| (chan->capture_state == CAPTURE_ERROR)));
+		/* only this work removes from the list, peeking is safe */
+		spin_lock(&chan->dequeue_lock);
+		buf = list_first_entry_or_null(&chan->dequeue,
+			struct tegra_channel_buffer, queue);
+		spin_unlock(&chan->dequeue_lock);
 
-		while (!(kthread_should_stop() || list_empty(&chan->dequeue)
-				|| (chan->capture_state == CAPTURE_ERROR))) {
+		if (!buf || !vi5_capture_done(chan, buf))
+			break;
 
-			buf = dequeue_dequeue_buffer(chan);
-			if (!buf)
-				break;
+		buf = dequeue_dequeue_buffer(chan);
+		if (!buf)
+			break;
 
-			vi5_capture_dequeue(chan, buf);
-		}
+		vi5_capture_dequeue(chan, buf);
+		progress = true;
+	}
 
-		spin_lock_irqsave(&chan->capture_state_lock, flags);
-		if (chan->capture_state == CAPTURE_ERROR) {
-			spin_unlock_irqrestore(&chan->capture_state_lock,
-				flags);
-			err = tegra_channel_error_recover(chan, false);
-			if (err) {
-				dev_err(chan->vi->dev,
-					"fatal: error recovery failed\n");
-				break;
-			}
-		} else
-			spin_unlock_irqrestore(&chan->capture_state_lock,
-				flags);
-		if (kthread_should_stop())
-			break;
+	if (error) {
+		cancel_delayed_work(&chan->capture_timeout_work);
+		err = tegra_channel_error_recover(chan, false);
+		if (err) {
+			dev_err(chan->vi->dev,
+				"fatal: error recovery failed\n");
+			return;
+		}
+	} else if (list_empty(&chan->dequeue)) {
+		cancel_delayed_work(&chan->capture_timeout_work);
+	} else if (progress) {
+		vi5_capture_arm_timeout(chan, true);
 	}
 
-	return 0;
+	/* descriptors were freed, refill them with the queued buffers */
+	vi5_capture_queue_work(chan, &chan->capture_enqueue_work);
 }
 
-static int vi5_channel_start_kthreads(struct tegra_channel *chan)
+static void vi5_capture_timeout_work(struct work_struct *work)
 {
-	int err = 0;
+	unsigned long flags;
+	struct tegra_channel *chan = container_of(to_delayed_work(work),
+			struct tegra_channel, capture_timeout_work);
 
-	/* Start the kthread for capture enqueue */
-	if (chan->kthread_capture_start) {
-		dev_err(chan->vi->dev, "enqueue kthread already initialized\n");
-		err = -1;
-		goto done;
-	}
-	chan->kthread_capture_start = kthread_run(
-		tegra_channel_kthread_capture_enqueue, chan, chan->video->name);
-	if (IS_ERR(chan->kthread_capture_start)) {
-		dev_err(&chan->video->dev,
-			"failed to run kthread for capture enqueue\n");
-		err = PTR_ERR(chan->kthread_capture_start);
-		goto done;
-	}
+	dev_err(chan->vi->dev,
+		"uncorr_err: request timed out after %d ms\n",
+		CAPTURE_TIMEOUT_MS);
 
-	/* Start the kthread for capture dequeue */
-	if (chan->kthread_capture_dequeue) {
-		dev_err(chan->vi->dev, "dequeue kthread already initialized\n");
-		err = -1;
-		goto done;
-	}
-	chan->kthread_capture_dequeue = kthread_run(
-		tegra_channel_kthread_capture_dequeue, chan, chan->video->name);
-	if (IS_ERR(chan->kthread_capture_dequeue)) {
+	spin_lock_irqsave(&chan->capture_state_lock, flags);
+	chan->capture_state = CAPTURE_ERROR;
+	spin_unlock_irqrestore(&chan->capture_state_lock, flags);
+
+	vi5_capture_queue_work(chan, &chan->capture_dequeue_work);
+}
+
+static void vi5_buffer_queued(struct tegra_channel *chan)
+{
+	vi5_capture_queue_work(chan, &chan->capture_enqueue_work);
+}
+
+static int vi5_channel_start_work(struct tegra_channel *chan)
+{
+	unsigned long flags;
+
+	mutex_lock(&vi5_capture_wq_lock);
+	if (!vi5_capture_wq)
+		vi5_capture_wq = alloc_workqueue("vi5_capture",
+			WQ_HIGHPRI | WQ_UNBOUND | WQ_FREEZABLE, 0);
+	mutex_unlock(&vi5_capture_wq_lock);
+
+	if (!vi5_capture_wq) {
 		dev_err(&chan->video->dev,
-			"failed to run kthread for capture dequeue\n");
-		err = PTR_ERR(chan->kthread_capture_dequeue);
-		goto done;
+			"failed to allocate capture workqueue\n");
+		return -ENOMEM;
 	}
 
-done:
-	return err;
+	INIT_WORK(&chan->capture_enqueue_work, vi5_capture_enqueue_work);
+	INIT_WORK(&chan->capture_dequeue_work, vi5_capture_dequeue_work);
+	INIT_DELAYED_WORK(&chan->capture_timeout_work,
+		vi5_capture_timeout_work);
+
+	spin_lock_irqsave(&chan->capture_state_lock, flags);
+	chan->capture_work_active = true;
+	spin_unlock_irqrestore(&chan->capture_state_lock, flags);
+
+	/* pick up the buffers queued before streaming started */
+	vi5_capture_queue_work(chan, &chan->capture_enqueue_work);
+
+	return 0;
 }
 
-static void vi5_channel_stop_kthreads(struct tegra_channel *chan)
+static void vi5_channel_stop_work(struct tegra_channel *chan)
 {
+	unsigned long flags;
+	bool active;
+
 	mutex_lock(&chan->stop_kthread_lock);
 
-	/* Stop the kthread for capture enqueue */
-	if (chan->kthread_capture_start) {
-		kthread_stop(chan->kthread_capture_start);
-		chan->kthread_capture_start = NULL;
-	}
+	/* no work can be queued anymore once this is cleared */
+	spin_lock_irqsave(&chan->capture_state_lock, flags);
+	active = chan->capture_work_active;
+	chan->capture_work_active = false;
+	spin_unlock_irqrestore(&chan->capture_state_lock, flags);
 
-	/* Stop the kthread for capture dequeue */
-	if (chan->kthread_capture_dequeue) {
-		kthread_stop(chan->kthread_capture_dequeue);
-		chan->kthread_capture_dequeue = NULL;
+	if (active) {
+		cancel_delayed_work_sync(&chan->capture_timeout_work);
+		cancel_work_sync(&chan->capture_enqueue_work);
+		cancel_work_sync(&chan->capture_dequeue_work);
 	}
 
 	mutex_unlock(&chan->stop_kthread_lock);
@@ -793,11 +880,12 @@ static int vi5_channel_start_streaming(struct vb2_queue *vq, u32 count)
 				goto err_setup;
 		}
 		chan->sequence = 0;
+		tegra_channel_stats_reset(chan);
 		tegra_channel_init_ring_buffer(chan);
 
-		ret = vi5_channel_start_kthreads(chan);
+		ret = vi5_channel_start_work(chan);
 		if (ret != 0)
-			goto err_start_kthreads;
+			goto err_start_work;
 	}
 
 	/* csi stream/sensor devices should be streamon post vi channel setup */
@@ -816,9 +904,9 @@ err_write_blobs:
 
 err_set_stream:
 	if (!chan->bypass)
-		vi5_channel_stop_kthreads(chan);
+		vi5_channel_stop_work(chan);
 
-err_start_kthreads:
+err_start_work:
 err_setup:
 	if (!chan->bypass)
 		for (vi_port = 0; vi_port < chan->valid_ports; vi_port++) {
@@ -841,8 +929,10 @@ static int vi5_channel_stop_streaming(struct vb2_queue *vq)
 	struct tegra_channel *chan = vb2_get_drv_priv(vq);
 	long err;
 	int vi_port = 0;
-	if (!chan->bypass)
-		vi5_channel_stop_kthreads(chan);
+	if (!chan->bypass) {
+		vi5_channel_stop_work(chan);
+		tegra_channel_sink_drain(chan);
+	}
 
 	/* csi stream/sensor(s) devices to be closed before vi channel */
 	tegra_channel_set_stream(chan, false);
@@ -956,6 +1046,7 @@ struct tegra_vi_fops vi5_fops = {
 	.vi_stop_streaming = vi5_channel_stop_streaming,
 	.vi_setup_queue = vi5_channel_setup_queue,
 	.vi_error_recover = vi5_channel_error_recover,
+	.vi_buffer_queued = vi5_buffer_queued,
 	.vi_add_ctrls = vi5_add_ctrls,
 	.vi_init_video_formats = vi5_init_video_formats,
 };
@@ -21,6 +21,10 @@
 #include <linux/export.h>
 #include <linux/module.h>
 #include <linux/debugfs.h>
+#include <linux/seq_file.h>
+#if defined(CONFIG_TEGRA_BWMGR)
+#include <linux/platform/tegra/emc_bwmgr.h>
+#endif
 
 #include <media/mc_common.h>
 #include <media/csi.h>
@@ -37,6 +41,15 @@ MODULE_PARM_DESC(override_frmfmt, "override existing format table");
 static int framerate = 30;
 module_param(framerate, int, 0444);
 
+/* extra frame size for benchmarking, offered in every TPG format */
+static unsigned int bench_width;
+module_param(bench_width, uint, 0444);
+MODULE_PARM_DESC(bench_width, "width of an additional TPG frame size");
+
+static unsigned int bench_height;
+module_param(bench_height, uint, 0444);
+MODULE_PARM_DESC(bench_height, "height of an additional TPG frame size");
+
 /* PG generate 32 bit per nvcsi_clk:
  * clks_per_line = width * bits_per_pixel / 32
  * ((clks_per_line + hblank) * height + vblank) * fps * lanes = nvcsi_clk_freq
@@ -51,6 +64,11 @@ const struct tpg_frmfmt tegra19x_csi_tpg_frmfmt[] = {
 	{{3840, 2160}, V4L2_PIX_FMT_RGB32, 30, 0, 0},
 };
 
+static const int tegra19x_csi_tpg_bench_fmts[] = {
+	V4L2_PIX_FMT_SRGGB10,
+	V4L2_PIX_FMT_RGB32,
+};
+
 #define TPG_PORT_IDX	0
 
 static int tpg_debugfs_height_show(void *data, u64 *val)
@@ -87,6 +105,67 @@ DEFINE_SIMPLE_ATTRIBUTE(tpg_debugfs_width_fops,
 			NULL,
 			"%lld\n");
 
+/*
+ * Capture statistics of the stream, for driving several TPG channels at
+ * once and checking what the VI/NVCSI/EMC setup sustains. Writing to the
+ * file restarts the measurement.
+ */
+static int tpg_debugfs_stats_show(struct seq_file *s, void *data)
+{
+	struct tegra_channel *vi_chan = s->private;
+	struct tegra_channel_stats *stats = &vi_chan->stats;
+	struct tegra_channel_stats snap;
+	unsigned long flags;
+	u64 fps_x100 = 0;
+	u64 latency_avg = 0;
+
+	spin_lock_irqsave(&stats->lock, flags);
+	snap = *stats;
+	spin_unlock_irqrestore(&stats->lock, flags);
+
+	if (snap.frames > 1 && snap.last_sof_ts > snap.first_sof_ts)
+		fps_x100 = div64_u64((snap.frames - 1) * 100 * NSEC_PER_SEC,
+				snap.last_sof_ts - snap.first_sof_ts);
+	if (snap.frames)
+		latency_avg = div64_u64(snap.latency_sum, snap.frames);
+
+	seq_printf(s, "frames: %llu\n", snap.frames);
+	seq_printf(s, "fps: %llu.%02llu\n", fps_x100 / 100, fps_x100 % 100);
+	seq_printf(s, "errors: %llu\n", snap.errors);
+	seq_printf(s, "discarded: %llu\n", snap.discarded);
+	seq_printf(s, "missed: %llu\n", snap.missed);
+	seq_printf(s, "latency_avg_us: %llu\n", latency_avg / NSEC_PER_USEC);
+	seq_printf(s, "latency_max_us: %llu\n",
+		snap.latency_max / NSEC_PER_USEC);
+#if defined(CONFIG_TEGRA_BWMGR)
+	seq_printf(s, "emc_rate_hz: %lu\n", tegra_bwmgr_get_emc_rate());
+#endif
+
+	return 0;
+}
+
+static int tpg_debugfs_stats_open(struct inode *inode, struct file *file)
+{
+	return single_open(file, tpg_debugfs_stats_show, inode->i_private);
+}
+
+static ssize_t tpg_debugfs_stats_write(struct file *file,
+		const char __user *buf, size_t count, loff_t *ppos)
+{
+	struct seq_file *s = file->private_data;
+
+	tegra_channel_stats_reset(s->private);
+
+	return count;
+}
+
+static const struct file_operations tpg_debugfs_stats_fops = {
+	.open		= tpg_debugfs_stats_open,
+	.read		= seq_read,
+	.write		= tpg_debugfs_stats_write,
+	.llseek		= seq_lseek,
+	.release	= single_release,
+};
 
 static void tpg_remove_debugfs(struct tegra_csi_device *csi)
 {
@@ -105,7 +184,7 @@ static int tpg_create_debugfs(struct tegra_csi_device *csi)
 
 	chan = csi->tpg_start;
 	list_for_each_entry_from(chan, &csi->csi_chans, list) {
-		const struct tegra_channel *vi_chan =
+		struct tegra_channel *vi_chan =
 				v4l2_get_subdev_hostdata(&chan->subdev);
 		if (vi_chan->pg_mode) {
 			const char *name = vi_chan->video->name;
@@ -123,6 +202,10 @@ static int tpg_create_debugfs(struct tegra_csi_device *csi)
 						dir, chan,
 						&tpg_debugfs_width_fops))
 				goto error;
+			if (!debugfs_create_file("stats", 0644,
+						dir, vi_chan,
+						&tpg_debugfs_stats_fops))
+				goto error;
 		}
 	}
 
@@ -138,13 +221,19 @@ static int __init tpg_probe_t19x(void)
 	struct tegra_mc_vi *mc_vi = tegra_get_mc_vi();
 	int err = 0;
 	int i = 0;
-	unsigned int table_size = ARRAY_SIZE(tegra19x_csi_tpg_frmfmt);
+	unsigned int base_size = ARRAY_SIZE(tegra19x_csi_tpg_frmfmt);
+	unsigned int table_size = base_size;
+	bool bench = bench_width && bench_height;
 
 	if (!mc_vi || !mc_csi)
 		return -EINVAL;
 
 	dev_info(mc_csi->dev, "%s\n", __func__);
 	mc_vi->csi = mc_csi;
+
+	if (bench)
+		table_size += ARRAY_SIZE(tegra19x_csi_tpg_bench_fmts);
+
 	/* Init CSI related media controller interface */
 	frmfmt_table = devm_kzalloc(mc_csi->dev,
 			table_size * sizeof(struct tpg_frmfmt), GFP_KERNEL);
@@ -153,7 +242,18 @@ static int __init tpg_probe_t19x(void)
 
 	mc_csi->tpg_frmfmt_table_size = table_size;
 	memcpy(frmfmt_table, tegra19x_csi_tpg_frmfmt,
-		table_size * sizeof(struct tpg_frmfmt));
+		base_size * sizeof(struct tpg_frmfmt));
+
+	if (bench) {
+		for (i = 0; i < ARRAY_SIZE(tegra19x_csi_tpg_bench_fmts); i++) {
+			struct tpg_frmfmt *fmt = &frmfmt_table[base_size + i];
+
+			fmt->frmsize.width = bench_width;
+			fmt->frmsize.height = bench_height;
+			fmt->pixel_format = tegra19x_csi_tpg_bench_fmts[i];
+			fmt->framerate = framerate;
+		}
+	}
 
 	if (override_frmfmt) {
 		for (i = 0; i < table_size; i++)
@@ -24,6 +24,8 @@
 #include <linux/mm.h>
 #include <linux/fs.h>
 #include <linux/crc32.h>
+#include <linux/rcupdate.h>
+#include <linux/spinlock.h>
 
 #include <linux/keventlib.h>
 
@@ -51,6 +53,7 @@ struct eventlib_provider_info {
 	size_t data_size;
 
 	struct eventlib_ctx el_ctx;
+	spinlock_t write_lock;	/* tracebuf has a single writer */
 
 	void *w2r;
 	size_t w2r_size;
@@ -68,6 +71,9 @@ static struct eventlib_module {
 	struct list_head providers;
 	atomic_t nr_providers;
 
+	/* writers look providers up here, without the lock */
+	struct eventlib_provider_info __rcu *by_id[EVENTLIB_MAX_PROVIDERS];
+
 	spinlock_t lock;
 
 	int test_id;
@@ -295,6 +301,7 @@ provider_init(struct eventlib_provider_info *info,
 		goto err_sysfs;
 
 	INIT_LIST_HEAD(&info->list);
+	spin_lock_init(&info->write_lock);
 
 	spin_lock(&ctx.lock);
 
@@ -309,6 +316,7 @@ provider_init(struct eventlib_provider_info *info,
 
 	list_add_tail(&info->list, &ctx.providers);
 	atomic_inc(&ctx.nr_providers);
+	rcu_assign_pointer(ctx.by_id[id], info);
 
 	spin_unlock(&ctx.lock);
 
@@ -353,6 +361,14 @@ __free_provider(struct work_struct *work)
 
 	struct eventlib_provider_info *info = wd->provider;
 
+	/* wait for keventlib_write() callers still using the buffer */
+	synchronize_rcu();
+
+	eventlib_close(&info->el_ctx);
+
+	free_pages((unsigned long)info->data,
+		   get_order(info->data_size));
+
 	remove_sysfs_entry(info);
 
 	if (info->schema)
@@ -369,13 +385,10 @@ static void free_provider(struct eventlib_provider_info *info)
 {
 	struct eventlib_work_data *wd;
 
-	eventlib_close(&info->el_ctx);
-
-	free_pages((unsigned long)info->data,
-		   get_order(info->data_size));
-
 	list_del(&info->list);
+	RCU_INIT_POINTER(ctx.by_id[info->id], NULL);
 
+	/* leak it rather than free it under a writer */
 	wd = kmalloc(sizeof(*wd), GFP_ATOMIC);
 	if (!wd)
 		return;
@@ -402,9 +415,16 @@ int keventlib_write(int id, void *data, size_t size, uint32_t type, uint64_t ts)
 
 	pr_debug("%s: size: %#zx\n", __func__, size);
 
-	spin_lock(&ctx.lock);
+	if (id < 0 || id >= EVENTLIB_MAX_PROVIDERS)
+		return -ENOENT;
 
-	info = find_provider_info(id);
+	/*
+	 * Only writers of the same provider serialize, engines recording
+	 * to their own providers don't contend.
+	 */
+	rcu_read_lock();
+
+	info = rcu_dereference(ctx.by_id[id]);
 	if (!info) {
 		err = -ENOENT;
 		goto err_out;
@@ -415,10 +435,12 @@ int keventlib_write(int id, void *data, size_t size, uint32_t type, uint64_t ts)
 		goto err_out;
 	}
 
+	spin_lock(&info->write_lock);
 	eventlib_write(&info->el_ctx, 0, type, ts, data, size);
+	spin_unlock(&info->write_lock);
 
 err_out:
-	spin_unlock(&ctx.lock);
+	rcu_read_unlock();
 	return err;
 }
 EXPORT_SYMBOL(keventlib_write);
@@ -120,6 +120,7 @@ struct MODS_PHYS_CHUNK {
 	u64          dma_addr:58; /* phys addr (or machine addr on XEN) */
 	u32          order:5;     /* 1<<order = number of contig pages */
 	int          allocated:1;
+	u32          page_idx;    /* first page of the chunk in the alloc */
 	struct page *p_page;
 };
 
@@ -429,6 +430,8 @@ int esc_mods_get_mapped_phys_addr_2(struct file *fp,
 				    struct MODS_GET_PHYSICAL_ADDRESS_2 *p);
 int esc_mods_get_mapped_phys_addr_3(struct file *fp,
 				    struct MODS_GET_PHYSICAL_ADDRESS_3 *p);
+int esc_mods_get_dma_addresses(struct file *fp,
+			       struct MODS_GET_ADDRESS_RANGE *p);
 int esc_mods_virtual_to_phys(struct file *fp,
 			     struct MODS_VIRTUAL_TO_PHYSICAL *p);
 int esc_mods_phys_to_virtual(struct file *fp,
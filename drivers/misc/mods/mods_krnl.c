@@ -1544,6 +1544,12 @@ static long mods_krnl_ioctl(struct file  *fp,
 			   MODS_GET_PHYSICAL_ADDRESS_3);
 		break;
 
+	case MODS_ESC_GET_DMA_ADDRESSES:
+		MODS_IOCTL(MODS_ESC_GET_DMA_ADDRESSES,
+			   esc_mods_get_dma_addresses,
+			   MODS_GET_ADDRESS_RANGE);
+		break;
+
 	case MODS_ESC_SET_MEMORY_TYPE:
 		MODS_IOCTL_NORETVAL(MODS_ESC_SET_MEMORY_TYPE,
 				    esc_mods_set_mem_type,
@@ -200,6 +200,24 @@ static int mods_create_dma_map(struct MODS_MEM_INFO *p_mem_info,
 	return OK;
 }
 
+/* Find the dma mapping of the allocation for the pci device */
+static struct MODS_DMA_MAP *mods_find_dma_map(struct MODS_MEM_INFO *p_mem_info,
+					      struct pci_dev *p_pci_dev)
+{
+	struct MODS_DMA_MAP *p_dma_map;
+	struct list_head  *head;
+	struct list_head  *iter;
+
+	head = &p_mem_info->dma_map_list;
+
+	list_for_each(iter, head) {
+		p_dma_map = list_entry(iter, struct MODS_DMA_MAP, list);
+		if (p_dma_map->dev == p_pci_dev)
+			return p_dma_map;
+	}
+	return NULL;
+}
+
 /* Find the dma mapping chunk for the specified memory.  If p_phys_chunk is *
  * NULL then the first mapped chunk is returned.
  */
@@ -209,31 +227,18 @@ static struct MODS_MAP_CHUNK *mods_find_dma_map_chunk(
 					struct MODS_PHYS_CHUNK *p_phys_chunk)
 {
 	struct MODS_DMA_MAP *p_dma_map;
-	struct list_head  *head;
-	struct list_head  *iter;
-	int i;
+	struct MODS_MAP_CHUNK *pm;
 
-	head = &p_mem_info->dma_map_list;
-	if (!head)
+	p_dma_map = mods_find_dma_map(p_mem_info, p_pci_dev);
+	if (!p_dma_map)
 		return NULL;
 
-	list_for_each(iter, head) {
-		p_dma_map = list_entry(iter, struct MODS_DMA_MAP, list);
-		if (p_dma_map->dev == p_pci_dev) {
-
-			if (!p_phys_chunk)
-				return &p_dma_map->mapping[0];
+	if (!p_phys_chunk)
+		return &p_dma_map->mapping[0];
 
-			for (i = p_mem_info->max_chunks; i > 0;) {
-				struct MODS_MAP_CHUNK *pm;
-				--i;
-				pm = &p_dma_map->mapping[i];
-				if (pm->pt == p_phys_chunk)
-					return pm;
-			}
-		}
-	}
-	return NULL;
+	/* mapping[i] is the mapping of pages[i] */
+	pm = &p_dma_map->mapping[p_phys_chunk - p_mem_info->pages];
+	return pm->pt == p_phys_chunk ? pm : NULL;
 }
 
 #if !defined(MODS_TEGRA) || defined(CONFIG_CPA)
@@ -327,6 +332,7 @@ static int mods_alloc_contig_sys_pages(struct MODS_MEM_INFO *p_mem_info)
 	while ((1U << order) < p_mem_info->num_pages)
 		order++;
 	p_mem_info->pages[0].order = order;
+	p_mem_info->pages[0].page_idx = 0;
 
 	p_mem_info->pages[0].p_page = alloc_pages_node(
 			p_mem_info->numa_node,
@@ -394,11 +400,11 @@ static int mods_alloc_contig_sys_pages(struct MODS_MEM_INFO *p_mem_info)
 	return 0;
 }
 
-static int mods_get_max_order_needed(u32 num_pages)
+static int mods_get_max_order_needed(u32 num_pages, int max_order)
 {
 	int order = 0;
 
-	while (order < 10 && (1U<<(order+1)) <= num_pages)
+	while (order < max_order && (1U<<(order+1)) <= num_pages)
 		++order;
 	return order;
 }
@@ -407,6 +413,8 @@ static int mods_alloc_noncontig_sys_pages(struct MODS_MEM_INFO *p_mem_info)
 {
 	u32 pages_left = p_mem_info->num_pages;
 	u32 num_chunks = 0;
+	/* Largest chunks the page allocator can give, lowered on failure */
+	int max_order  = MAX_ORDER - 1;
 
 	LOG_ENT();
 
@@ -416,9 +424,15 @@ static int mods_alloc_noncontig_sys_pages(struct MODS_MEM_INFO *p_mem_info)
 	/* alloc pages */
 	while (pages_left > 0) {
 		u64 phys_addr = 0;
-		int order     = mods_get_max_order_needed(pages_left);
+		int order     = mods_get_max_order_needed(pages_left,
+							    max_order);
 		struct MODS_PHYS_CHUNK *pt = &p_mem_info->pages[num_chunks];
 
+		if (num_chunks == p_mem_info->max_chunks) {
+			mods_error_printk("memory too fragmented\n");
+			goto failed;
+		}
+
 		for ( ; order >= 0; --order) {
 			pt->p_page = alloc_pages_node(
 					p_mem_info->numa_node,
@@ -426,6 +440,8 @@ static int mods_alloc_noncontig_sys_pages(struct MODS_MEM_INFO *p_mem_info)
 					(unsigned int)order);
 			if (pt->p_page)
 				break;
+			/* Don't retry orders which already failed */
+			max_order = order - 1;
 		}
 
 		if (!pt->p_page) {
@@ -434,6 +450,7 @@ static int mods_alloc_noncontig_sys_pages(struct MODS_MEM_INFO *p_mem_info)
 		}
 		pt->allocated = 1;
 
+		pt->page_idx = p_mem_info->num_pages - pages_left;
 		pages_left -= 1U << order;
 		pt->order = (u32)order;
 
@@ -617,32 +634,37 @@ static struct MODS_PHYS_CHUNK *mods_find_phys_chunk(
 					u64 offset,
 					u64 *chunk_offset)
 {
-	struct MODS_PHYS_CHUNK	*pt = NULL;
-	u64			pages_left;
-	u64			page_offs;
-	u32			i;
+	struct MODS_PHYS_CHUNK	*pt;
+	u64			page;
+	u32			lo, hi;
 
 	if (!p_mem_info)
 		return NULL;
 
-	pages_left = offset >> PAGE_SHIFT;
-	page_offs  = offset & (~PAGE_MASK);
-
-	for (i = 0; i < p_mem_info->max_chunks; i++) {
-		u32 num_pages;
-
-		pt = &p_mem_info->pages[i];
-		if (!pt->allocated)
-			break;
+	page = offset >> PAGE_SHIFT;
+	if (page >= p_mem_info->num_pages)
+		return NULL;
 
-		num_pages = 1U << pt->order;
-		if (pages_left < num_pages)
-			break;
-		pages_left -= num_pages;
-		pt = NULL;
+	/* Chunks are allocated in order, binary search the last one which *
+	 * starts at or before the page.  Unallocated chunks are at the end.
+	 */
+	lo = 0;
+	hi = p_mem_info->max_chunks;
+	while (hi - lo > 1) {
+		u32 mid = lo + (hi - lo) / 2;
+
+		pt = &p_mem_info->pages[mid];
+		if (pt->allocated && pt->page_idx <= page)
+			lo = mid;
+		else
+			hi = mid;
 	}
 
-	*chunk_offset = (pages_left << PAGE_SHIFT) + page_offs;
+	pt = &p_mem_info->pages[lo];
+	if (!pt->allocated || page >= pt->page_idx + (1U << pt->order))
+		return NULL;
+
+	*chunk_offset = offset - ((u64)pt->page_idx << PAGE_SHIFT);
 	return pt;
 }
 
@@ -1049,6 +1071,81 @@ int esc_mods_get_mapped_phys_addr_3(struct file *fp,
 	return 0;
 }
 
+/* Batched MODS_ESC_GET_MAPPED_PHYSICAL_ADDRESS_3, for num_entries offsets *
+ * starting at offset and stride bytes apart.
+ */
+int esc_mods_get_dma_addresses(struct file *fp,
+			       struct MODS_GET_ADDRESS_RANGE *p)
+{
+	struct pci_dev         *dev = NULL;
+	struct MODS_MEM_INFO   *p_mem_info;
+	struct MODS_DMA_MAP    *p_dma_map = NULL;
+	struct MODS_PHYS_CHUNK *pt;
+	u32			i;
+
+	LOG_ENT();
+
+	if (p->num_entries > MODS_GET_ADDR_RANGE_MAX) {
+		mods_error_printk("invalid number of addresses requested\n");
+		LOG_EXT();
+		return -EINVAL;
+	}
+
+	p_mem_info = (struct MODS_MEM_INFO *)(size_t)p->memory_handle;
+
+	if (p->pci_device.bus || p->pci_device.device) {
+		unsigned int devfn = PCI_DEVFN(p->pci_device.device,
+					       p->pci_device.function);
+		dev = MODS_PCI_GET_SLOT(p->pci_device.domain,
+					p->pci_device.bus,
+					devfn);
+	}
+
+	if (dev) {
+		p_dma_map = mods_find_dma_map(p_mem_info, dev);
+		if (!p_dma_map) {
+			mods_error_printk("invalid device mapping requested\n");
+			LOG_EXT();
+			return -EINVAL;
+		}
+	}
+
+	for (i = 0; i < p->num_entries; i++) {
+		u64 offset = p->offset + i * p->stride;
+		u64 chunk_offset;
+		u64 addr;
+
+		pt = mods_find_phys_chunk(p_mem_info, offset, &chunk_offset);
+		if (!pt) {
+			mods_error_printk("invalid offset requested\n");
+			LOG_EXT();
+			return -EINVAL;
+		}
+
+		if (p_dma_map) {
+			struct MODS_MAP_CHUNK *pm;
+
+			pm = &p_dma_map->mapping[pt - p_mem_info->pages];
+			if (!pm->pt) {
+				mods_error_printk(
+					"invalid device mapping requested\n");
+				LOG_EXT();
+				return -EINVAL;
+			}
+			addr = pm->map_addr;
+		} else
+			addr = pt->dma_addr;
+
+		p->physical_addresses[i] = addr + chunk_offset;
+	}
+
+	mods_debug_printk(DEBUG_MEM_DETAILED,
+		"get dma addresses: %p+0x%llx, %u x 0x%llx\n",
+		p_mem_info, p->offset, p->num_entries, p->stride);
+	LOG_EXT();
+	return OK;
+}
+
 int esc_mods_virtual_to_phys(struct file *fp,
 			     struct MODS_VIRTUAL_TO_PHYSICAL *p)
 {
@@ -48,7 +48,10 @@ enum aon_shub_request_type {
 	AON_SHUB_REQUEST_BATCH_RD = 11,
 	AON_SHUB_REQUEST_THRESH_LO = 12,
 	AON_SHUB_REQUEST_THRESH_HI = 13,
-	AON_SHUB_REQUEST_MAX = 13,
+	AON_SHUB_REQUEST_RING = 14,
+	AON_SHUB_REQUEST_MAX = 14,
+	/* SPE to CCPLEX only: payload ring reached its fill threshold */
+	AON_SHUB_REQUEST_RING_FILL = 15,
 };
 
 /* This enum represents the types of init requests to sensor hub associated
@@ -112,6 +115,25 @@ struct sensor_payload_t {
 	u16 z;
 };
 
+/* This struct is the header of the payload ring in DRAM. The SPE adds
+ * samples at head and the CCPLEX consumes them from tail. Indexes are
+ * free running, sample i is at data[i % entries].
+ *
+ * Fields:
+ * head:	Next sample the SPE writes, written by the SPE only
+ * tail:	Next sample the CCPLEX reads, written by the CCPLEX only
+ * entries:	Number of samples in the ring
+ * overflow:	Samples the SPE dropped because the ring was full
+ * data:	Sensor payloads
+ */
+struct aon_shub_ring_hdr {
+	u32 head;
+	u32 tail;
+	u32 entries;
+	u32 overflow;
+	struct sensor_payload_t data[];
+};
+
 /* This struct is used to represent data required to enable a sensor
  *  on the SHUB.
  * Fields:
@@ -400,6 +422,26 @@ struct aon_shub_chip_cfg_ids_response {
 	s8 ids[];
 };
 
+/* This struct is used to hand the payload ring to the SPE. Once accepted,
+ * the SPE stores payloads in the ring instead of sending them over IVC and
+ * sends AON_SHUB_REQUEST_RING_FILL once thresh samples are pending, or on a
+ * flush.
+ *
+ * Fields:
+ * addr_lo:	Low 32 bits of the IOVA of struct aon_shub_ring_hdr
+ * addr_hi:	High 32 bits of the IOVA, both 0 to stop using the ring
+ * size:	Size of the ring in bytes, header included
+ * thresh:	Pending samples that wake the CCPLEX
+ *
+ * The address is split to keep the request union 32-bit aligned.
+ */
+struct aon_shub_ring_request {
+	u32 addr_lo;
+	u32 addr_hi;
+	u32 size;
+	u32 thresh;
+};
+
 /* This struct represents the threshold_hi/lo setting for a given sensor.
  * Fields:
  * snsr_id:	Sensor handle to identify the sensor
@@ -486,6 +528,7 @@ struct aon_shub_request {
 		struct aon_shub_flush_request flush;
 		struct aon_shub_range_request range;
 		struct aon_shub_thresh_request thresh;
+		struct aon_shub_ring_request ring;
 	} data;
 };
 
@@ -54,6 +54,7 @@
 #include <linux/of_address.h>
 #include <linux/tegra-aon.h>
 #include <linux/mailbox_client.h>
+#include <linux/dma-mapping.h>
 #include <linux/time.h>
 #include <linux/time64.h>
 #include <linux/timekeeping.h>
@@ -126,6 +127,11 @@ struct tegra_aon_shub {
 	u64			 ts_res_ns;
 	s64			 ts_adjustment;
 	bool			 last_tx_done;
+	/* payload ring, NULL when payloads come over IVC */
+	struct aon_shub_ring_hdr *ring;
+	dma_addr_t		 ring_dma;
+	u32			 ring_entries;
+	u32			 ring_tail;
 };
 
 static const char *const snsr_types[] = {
@@ -181,15 +187,75 @@ static inline s64 get_ts_adjustment(u64 tsc_res)
 	return delta;
 }
 
+static void tegra_aon_shub_adjust_ts(struct tegra_aon_shub *shub)
+{
+	if (shub->adjust_ts_counter == READJUST_TS_SAMPLES) {
+		shub->ts_adjustment = get_ts_adjustment(shub->ts_res_ns);
+		shub->adjust_ts_counter = 0;
+	}
+	shub->adjust_ts_counter++;
+}
+
+static void tegra_aon_shub_push(struct tegra_aon_shub *shub,
+				struct sensor_payload_t *payload)
+{
+	int snsr_id = payload->snsr_id;
+	s64 ts;
+	int cookie;
+
+	ts = (s64)payload->ts;
+	ts += shub->ts_adjustment;
+	payload->ts = (u64)ts;
+	cookie = COOKIE(shub->snsrs[snsr_id]->type, ts);
+	trace_async_atrace_begin(__func__, TRACE_SENSOR_ID, cookie);
+	shub->nvs->handler(shub->snsrs[snsr_id]->nvs_st, &payload->x,
+			   payload->ts);
+	trace_async_atrace_end(__func__, TRACE_SENSOR_ID, cookie);
+}
+
+static void tegra_aon_shub_ring_drain(struct tegra_aon_shub *shub)
+{
+	struct aon_shub_ring_hdr *ring = shub->ring;
+	struct sensor_payload_t payload;
+	u32 head;
+	u32 tail = shub->ring_tail;
+
+	if (!ring)
+		return;
+
+	head = READ_ONCE(ring->head);
+	/* read the samples after the index the SPE published them with */
+	rmb();
+	if (head - tail > shub->ring_entries) {
+		dev_err(shub->dev, "Invalid ring head %u tail %u\n",
+			head, tail);
+		tail = head;
+		goto out;
+	}
+
+	tegra_aon_shub_adjust_ts(shub);
+	for (; tail != head; tail++) {
+		payload = ring->data[tail % shub->ring_entries];
+		if ((u32)payload.snsr_id >= shub->snsr_cnt ||
+		    !shub->snsrs[payload.snsr_id])
+			continue;
+
+		tegra_aon_shub_push(shub, &payload);
+	}
+
+out:
+	/* done with the samples before the SPE may overwrite them */
+	mb();
+	WRITE_ONCE(ring->tail, tail);
+	shub->ring_tail = tail;
+}
+
 static void tegra_aon_shub_mbox_rcv_msg(struct mbox_client *cl, void *rx_msg)
 {
 	struct tegra_aon_mbox_msg *msg = rx_msg;
 	struct tegra_aon_shub *shub = dev_get_drvdata(cl->dev);
 	struct aon_shub_response *shub_resp;
-	int snsr_id;
 	u32 i;
-	s64 ts;
-	int cookie;
 
 	shub_resp = (struct aon_shub_response *)msg->data;
 	if (shub_resp->resp_type == AON_SHUB_REQUEST_PAYLOAD) {
@@ -199,24 +265,12 @@ static void tegra_aon_shub_mbox_rcv_msg(struct mbox_client *cl, void *rx_msg)
 				"Invalid payload count\n");
 			return;
 		}
-		if (shub->adjust_ts_counter == READJUST_TS_SAMPLES) {
-			shub->ts_adjustment =
-				get_ts_adjustment(shub->ts_res_ns);
-			shub->adjust_ts_counter = 0;
-		}
-		shub->adjust_ts_counter++;
-		while (i--) {
-			snsr_id = shub_resp->data.payload.data[i].snsr_id;
-			ts = (s64)shub_resp->data.payload.data[i].ts;
-			ts += shub->ts_adjustment;
-			shub_resp->data.payload.data[i].ts = (u64)ts;
-			cookie = COOKIE(shub->snsrs[snsr_id]->type, ts);
-			trace_async_atrace_begin(__func__, TRACE_SENSOR_ID, cookie);
-			shub->nvs->handler(shub->snsrs[snsr_id]->nvs_st,
-				&shub_resp->data.payload.data[i].x,
-				shub_resp->data.payload.data[i].ts);
-			trace_async_atrace_end(__func__, TRACE_SENSOR_ID, cookie);
-		}
+		tegra_aon_shub_adjust_ts(shub);
+		while (i--)
+			tegra_aon_shub_push(shub,
+					    &shub_resp->data.payload.data[i]);
+	} else if (shub_resp->resp_type == AON_SHUB_REQUEST_RING_FILL) {
+		tegra_aon_shub_ring_drain(shub);
 	} else {
 		memcpy(shub->shub_resp, msg->data, sizeof(*shub->shub_resp));
 		complete(shub->wait_on);
@@ -1125,6 +1179,70 @@ err_exit:
 	return ret;
 }
 
+static int tegra_aon_shub_ring_send(struct tegra_aon_shub *shub, u64 addr,
+				    u32 size, u32 thresh)
+{
+	int ret;
+
+	mutex_lock(&shub->shub_mutex);
+	shub->shub_req->req_type = AON_SHUB_REQUEST_RING;
+	shub->shub_req->data.ring.addr_lo = lower_32_bits(addr);
+	shub->shub_req->data.ring.addr_hi = upper_32_bits(addr);
+	shub->shub_req->data.ring.size = size;
+	shub->shub_req->data.ring.thresh = thresh;
+	ret = tegra_aon_shub_ivc_msg_send(shub,
+					  sizeof(struct aon_shub_request),
+					  IVC_TIMEOUT);
+	mutex_unlock(&shub->shub_mutex);
+
+	return ret;
+}
+
+/*
+ * With ring_entries in DT, the SPE keeps the payloads in a DRAM ring and
+ * only wakes us up once ring_thresh of them are pending, instead of an IVC
+ * message for every few samples. Payloads keep coming over IVC if the SPE
+ * firmware does not take the ring.
+ */
+static void tegra_aon_shub_ring_init(struct tegra_aon_shub *shub,
+				     struct device_node *np)
+{
+	u32 entries;
+	u32 thresh;
+	size_t size;
+	int ret;
+
+	if (of_property_read_u32(np, "ring_entries", &entries) || !entries)
+		return;
+
+	if (of_property_read_u32(np, "ring_thresh", &thresh) ||
+	    !thresh || thresh > entries)
+		thresh = entries / 2 ? entries / 2 : 1;
+
+	size = sizeof(*shub->ring) + entries * sizeof(shub->ring->data[0]);
+	shub->ring = dmam_alloc_coherent(shub->dev, size, &shub->ring_dma,
+					 GFP_KERNEL | __GFP_ZERO);
+	if (!shub->ring) {
+		dev_err(shub->dev, "payload ring allocation failed\n");
+		return;
+	}
+	shub->ring->entries = entries;
+	shub->ring_entries = entries;
+	shub->ring_tail = 0;
+
+	ret = tegra_aon_shub_ring_send(shub, shub->ring_dma, size, thresh);
+	if (ret) {
+		dev_info(shub->dev, "payload ring not used: %d\n", ret);
+		dmam_free_coherent(shub->dev, size, shub->ring,
+				   shub->ring_dma);
+		shub->ring = NULL;
+		return;
+	}
+
+	dev_info(shub->dev, "payload ring of %u, wake up at %u\n",
+		 entries, thresh);
+}
+
 static int tegra_aon_shub_probe(struct platform_device *pdev)
 {
 	struct tegra_aon_shub *shub;
@@ -1216,6 +1334,8 @@ static int tegra_aon_shub_probe(struct platform_device *pdev)
 	#undef _PICO_SECS
 	shub->ts_adjustment = get_ts_adjustment(shub->ts_res_ns);
 
+	tegra_aon_shub_ring_init(shub, np);
+
 	dev_info(&pdev->dev, "tegra_aon_shub_driver_probe() OK\n");
 
 	return 0;
@@ -1232,6 +1352,9 @@ static int tegra_aon_shub_remove(struct platform_device *pdev)
 	struct tegra_aon_shub *shub;
 
 	shub  = dev_get_drvdata(&pdev->dev);
+	/* the SPE must not write to the ring once it is freed */
+	if (shub->ring && tegra_aon_shub_ring_send(shub, 0, 0, 0))
+		dev_err(shub->dev, "failed to stop the payload ring\n");
 	mbox_free_channel(shub->mbox);
 
 	return 0;
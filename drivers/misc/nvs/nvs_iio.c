@@ -735,6 +735,28 @@ static int nvs_handler(void *handle, void *buffer, s64 ts)
 	return ret;
 }
 
+static int nvs_handler_n(void *handle, void *buffer, unsigned int n,
+			 unsigned int size, s64 ts, s64 ts_period)
+{
+	struct iio_dev *indio_dev = (struct iio_dev *)handle;
+	unsigned char *buf = buffer;
+	unsigned int i;
+	int ret;
+
+	if (!indio_dev)
+		return 0;
+
+	for (i = 0; i < n; i++) {
+		ret = nvs_buf_push(indio_dev, buf, ts);
+		if (ret < 0)
+			return i ? i : ret;
+
+		buf += size;
+		ts += ts_period;
+	}
+	return i;
+}
+
 static int nvs_enable(struct iio_dev *indio_dev, bool en)
 {
 	struct nvs_state *st = iio_priv(indio_dev);
@@ -2017,6 +2039,7 @@ static struct nvs_fn_if nvs_fn_if_iio = {
 	.suspend			= nvs_suspend,
 	.resume				= nvs_resume,
 	.handler			= nvs_handler,
+	.handler_n			= nvs_handler_n,
 };
 
 struct nvs_fn_if *nvs_iio(void)
@@ -16,12 +16,17 @@
 #include <linux/relay.h>
 #include <linux/cdev.h>
 #include <linux/idr.h>
+#include <linux/poll.h>
+#include <linux/slab.h>
+#include <linux/uaccess.h>
+#include <linux/wait.h>
 #include "nvs_sysfs.h"
 
 #define NVS_RELAY_DRIVER_VERSION	(1)
 #define NVS_RELAY_DRIVER_NAME		"relay"
 #define NVS_DEV_MAX			(256)
 #define NVS_MAX_GROUPS			(2)
+#define NVS_RELAY_RING_N		(256)
 
 static DEFINE_IDA(nvs_ida);
 
@@ -38,11 +43,25 @@ struct nvs_state_relay {
 	unsigned int dev_id;
 	char link_name[16];
 	const struct attribute_group *groups[NVS_MAX_GROUPS + 1];
+	wait_queue_head_t wait;
+	struct mutex read_lock;		/* one consumer of st->ring */
+	unsigned int data_n;
+	u8 *rd_buf;
 };
 
 
+/* Samples are queued without a lock, readers get them from the cdev */
 static int nvs_relay_push(struct nvs_state *st)
 {
+	struct nvs_state_relay *sr = nvs_st_kif(st);
+	s64 ts;
+
+	if (!st->ring)
+		return 0;
+
+	memcpy(&ts, &st->buf[sr->data_n], sizeof(ts));
+	if (!nvs_ring_put(st->ring, st->buf, ts))
+		wake_up_interruptible(&sr->wait);
 	return 0;
 }
 
@@ -52,6 +71,12 @@ static void nvs_relay_remove(struct nvs_state *st)
 
 	if (st->cfg->flags & SENSOR_FLAG_DYNAMIC_SENSOR)
 		nvs_dsm_relay(sr->dev_id, false, st->snsr_type, st->cfg->uuid);
+	if (st->ring) {
+		cdev_del(&sr->cdev);
+		nvs_ring_free(st->ring);
+		st->ring = NULL;
+	}
+	kfree(sr->rd_buf);
 }
 
 static void nvs_dev_type_release(struct device *dev)
@@ -65,6 +90,78 @@ static int nvs_cdev_release(struct inode *inode, struct file *filp)
 
 static int nvs_cdev_open(struct inode *inode, struct file *filp)
 {
+	struct nvs_state_relay *sr = container_of(inode->i_cdev,
+						  struct nvs_state_relay,
+						  cdev);
+
+	filp->private_data = dev_get_drvdata(&sr->dev);
+	return 0;
+}
+
+/* Each sample read is the s64 timestamp followed by the channel data */
+static ssize_t nvs_cdev_read(struct file *filp, char __user *buf,
+			     size_t count, loff_t *f_ps)
+{
+	struct nvs_state *st = filp->private_data;
+	struct nvs_state_relay *sr = nvs_st_kif(st);
+	size_t rec_n = sizeof(s64) + sr->data_n;
+	size_t copied = 0;
+	s64 ts;
+	int ret;
+
+	if (!st->ring)
+		return -ENODEV;
+
+	if (count < rec_n)
+		return -EINVAL;
+
+	if (nvs_ring_empty(st->ring)) {
+		if (filp->f_flags & O_NONBLOCK)
+			return -EAGAIN;
+
+		ret = wait_event_interruptible(sr->wait,
+					       !nvs_ring_empty(st->ring));
+		if (ret)
+			return ret;
+	}
+
+	if (mutex_lock_interruptible(&sr->read_lock))
+		return -ERESTARTSYS;
+
+	while (count - copied >= rec_n) {
+		if (nvs_ring_get(st->ring, sr->rd_buf + sizeof(ts), &ts))
+			break;
+
+		memcpy(sr->rd_buf, &ts, sizeof(ts));
+		if (copy_to_user(buf + copied, sr->rd_buf, rec_n)) {
+			mutex_unlock(&sr->read_lock);
+			return copied ? copied : -EFAULT;
+		}
+
+		copied += rec_n;
+	}
+	mutex_unlock(&sr->read_lock);
+
+	if (!copied)
+		/* a different reader was faster */
+		return -EAGAIN;
+
+	return copied;
+}
+
+static unsigned int nvs_cdev_poll(struct file *filp,
+				  struct poll_table_struct *wait)
+{
+	struct nvs_state *st = filp->private_data;
+	struct nvs_state_relay *sr = nvs_st_kif(st);
+
+	if (!st->ring)
+		return POLLERR;
+
+	poll_wait(filp, &sr->wait, wait);
+	if (!nvs_ring_empty(st->ring))
+		return POLLIN | POLLRDNORM;
+
 	return 0;
 }
 
@@ -73,6 +170,8 @@ static const struct file_operations nvs_fops = {
 	.llseek = noop_llseek,
 	.open = nvs_cdev_open,
 	.release = nvs_cdev_release,
+	.read = nvs_cdev_read,
+	.poll = nvs_cdev_poll,
 };
 
 static int nvs_relay_init(struct nvs_state *st)
@@ -111,6 +210,20 @@ static int nvs_relay_init(struct nvs_state *st)
 	if (ret)
 		return ret;
 
+	/* channel data is everything before the timestamp in st->buf */
+	sr->data_n = st->buf_ch[st->ch_n - 1].buf_i;
+	init_waitqueue_head(&sr->wait);
+	mutex_init(&sr->read_lock);
+	sr->rd_buf = kzalloc(sizeof(s64) + sr->data_n, GFP_KERNEL);
+	if (!sr->rd_buf)
+		return -ENOMEM;
+
+	st->ring = nvs_ring_alloc(max_t(unsigned int, NVS_RELAY_RING_N,
+					2 * st->cfg->fifo_max_evnt_cnt),
+				  sr->data_n);
+	if (!st->ring)
+		return -ENOMEM;
+
 	cdev_init(&sr->cdev, &nvs_fops);
 	sr->cdev.owner = THIS_MODULE;
 	ret = cdev_add(&sr->cdev, sr->dev.devt, 1);
@@ -0,0 +1,159 @@
+/* Copyright (c) 2021, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * This software is licensed under the terms of the GNU General Public
+ * License version 2, as published by the Free Software Foundation, and
+ * may be copied, distributed, and modified under those terms.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+
+/* Lock-free single producer, single consumer sample ring.
+ *
+ * The producer is the sensor driver pushing samples, serialized as the
+ * handler calls already are. The consumer is the NVS front end reading
+ * them. A sample slot carries a 32-bit nanosecond delta to the previous
+ * sample. When the delta does not fit, e.g. on the first sample, a flush
+ * or after a long idle, an extra slot with the absolute timestamp is put
+ * just before the sample.
+ */
+
+#include <linux/module.h>
+#include <linux/atomic.h>
+#include <linux/slab.h>
+#include <linux/vmalloc.h>
+#include <linux/nvs.h>
+
+#define NVS_RING_TS_ABS			(U32_MAX)
+
+struct nvs_ring {
+	u32 head;			/* written by the producer only */
+	u32 tail;			/* written by the consumer only */
+	u32 mask;
+	unsigned int slot_sz;
+	unsigned int data_n;
+	bool put_abs;			/* producer needs an absolute ts */
+	s64 put_ts;			/* producer: last timestamp put */
+	s64 get_ts;			/* consumer: last timestamp read */
+	atomic_t dropped;
+	u8 slots[];
+};
+
+static inline u8 *nvs_ring_slot(struct nvs_ring *ring, u32 i)
+{
+	return &ring->slots[(i & ring->mask) * ring->slot_sz];
+}
+
+/* n is rounded up to a power of 2 and needs a spare slot per absolute ts */
+struct nvs_ring *nvs_ring_alloc(unsigned int n, unsigned int data_n)
+{
+	struct nvs_ring *ring;
+	unsigned int slot_sz;
+
+	if (!n || n > (1 << 16))
+		return NULL;
+
+	n = roundup_pow_of_two(n);
+	slot_sz = ALIGN(sizeof(u32) + max_t(unsigned int, data_n,
+					    sizeof(s64)), sizeof(u32));
+	ring = vzalloc(sizeof(*ring) + n * slot_sz);
+	if (!ring)
+		return NULL;
+
+	ring->mask = n - 1;
+	ring->slot_sz = slot_sz;
+	ring->data_n = data_n;
+	ring->put_abs = true;
+	atomic_set(&ring->dropped, 0);
+	return ring;
+}
+EXPORT_SYMBOL_GPL(nvs_ring_alloc);
+
+void nvs_ring_free(struct nvs_ring *ring)
+{
+	vfree(ring);
+}
+EXPORT_SYMBOL_GPL(nvs_ring_free);
+
+/* Returns 0 or -ENOSPC, in which case the sample is counted as dropped */
+int nvs_ring_put(struct nvs_ring *ring, const void *data, s64 ts)
+{
+	u32 head = ring->head;
+	u32 tail = smp_load_acquire(&ring->tail);
+	s64 delta = ts - ring->put_ts;
+	bool abs_ts;
+	u8 *slot;
+	u32 d;
+
+	abs_ts = ring->put_abs || !ts || delta < 0 || delta >= NVS_RING_TS_ABS;
+	if (ring->mask + 1 - (head - tail) < (abs_ts ? 2 : 1)) {
+		atomic_inc(&ring->dropped);
+		return -ENOSPC;
+	}
+
+	if (abs_ts) {
+		slot = nvs_ring_slot(ring, head++);
+		d = NVS_RING_TS_ABS;
+		memcpy(slot, &d, sizeof(d));
+		memcpy(slot + sizeof(d), &ts, sizeof(ts));
+		delta = 0;
+	}
+
+	slot = nvs_ring_slot(ring, head++);
+	d = delta;
+	memcpy(slot, &d, sizeof(d));
+	memcpy(slot + sizeof(d), data, ring->data_n);
+	ring->put_ts = ts;
+	ring->put_abs = false;
+	/* publish the slots before the index */
+	smp_store_release(&ring->head, head);
+	return 0;
+}
+EXPORT_SYMBOL_GPL(nvs_ring_put);
+
+/* Returns 0 or -EAGAIN when the ring is empty */
+int nvs_ring_get(struct nvs_ring *ring, void *data, s64 *ts)
+{
+	u32 tail = ring->tail;
+	u32 head = smp_load_acquire(&ring->head);
+	u8 *slot;
+	u32 d;
+
+	if (tail == head)
+		return -EAGAIN;
+
+	slot = nvs_ring_slot(ring, tail++);
+	memcpy(&d, slot, sizeof(d));
+	if (d == NVS_RING_TS_ABS) {
+		/* always published together with the sample after it */
+		memcpy(&ring->get_ts, slot + sizeof(d), sizeof(ring->get_ts));
+		slot = nvs_ring_slot(ring, tail++);
+		memcpy(&d, slot, sizeof(d));
+	}
+
+	ring->get_ts += d;
+	*ts = ring->get_ts;
+	memcpy(data, slot + sizeof(d), ring->data_n);
+	/* done with the slots before the producer reuses them */
+	smp_store_release(&ring->tail, tail);
+	return 0;
+}
+EXPORT_SYMBOL_GPL(nvs_ring_get);
+
+bool nvs_ring_empty(struct nvs_ring *ring)
+{
+	return READ_ONCE(ring->tail) == smp_load_acquire(&ring->head);
+}
+EXPORT_SYMBOL_GPL(nvs_ring_empty);
+
+unsigned int nvs_ring_dropped(struct nvs_ring *ring)
+{
+	return atomic_read(&ring->dropped);
+}
+EXPORT_SYMBOL_GPL(nvs_ring_dropped);
+
+MODULE_LICENSE("GPL v2");
+MODULE_DESCRIPTION("NVidia Sensor sample ring module");
+MODULE_AUTHOR("NVIDIA Corporation");
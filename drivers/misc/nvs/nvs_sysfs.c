@@ -167,6 +167,9 @@ static ssize_t nvs_dbg_cfg(struct nvs_state *st, char *buf)
 		      st->cfg->report_n);
 	t += snprintf(buf + t, PAGE_SIZE - t, "float_significance=%s\n",
 		      nvs_float_significances[st->cfg->float_significance]);
+	if (st->ring)
+		t += snprintf(buf + t, PAGE_SIZE - t, "ring_dropped=%u\n",
+			      nvs_ring_dropped(st->ring));
 	return t;
 }
 
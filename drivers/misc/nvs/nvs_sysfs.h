@@ -63,6 +63,7 @@ struct nvs_state {
 	s64 ts;
 	u64 dbg_data_lock;
 	u8 *buf;
+	struct nvs_ring *ring;		/* set by front ends that use one */
 };
 
 struct nvs_kif_fn {
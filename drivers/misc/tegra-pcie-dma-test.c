@@ -0,0 +1,475 @@
+/*
+ * Copyright (c) 2021, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ */
+
+#include <linux/delay.h>
+#include <linux/device.h>
+#include <linux/dma-mapping.h>
+#include <linux/io.h>
+#include <linux/io-64-nonatomic-lo-hi.h>
+#include <linux/ktime.h>
+#include <linux/module.h>
+#include <linux/moduleparam.h>
+#include <linux/mutex.h>
+#include <linux/pci.h>
+#include <linux/tegra_pcie_dma_test.h>
+
+#define MODULENAME "tegra_pcie_dma_test"
+
+/* Time allowed to the EP to finish a whole test */
+#define TEST_TIMEOUT_MS		30000
+
+static unsigned long host_buf_size = SZ_4M;
+module_param(host_buf_size, ulong, 0444);
+MODULE_PARM_DESC(host_buf_size, "Size of the host buffer used by DMA tests");
+
+enum dma_test_mode {
+	DMA_TEST_DMA_WRITE,
+	DMA_TEST_DMA_READ,
+	DMA_TEST_MMIO_WRITE,
+	DMA_TEST_MMIO_READ,
+};
+
+static const char * const dma_test_mode_names[] = {
+	[DMA_TEST_DMA_WRITE] = "dma_write",
+	[DMA_TEST_DMA_READ] = "dma_read",
+	[DMA_TEST_MMIO_WRITE] = "mmio_write",
+	[DMA_TEST_MMIO_READ] = "mmio_read",
+};
+
+struct dma_test_result {
+	bool valid;
+	int error;
+	enum dma_test_mode mode;
+	u32 size;
+	u32 depth;
+	u32 channels;
+	u32 iterations;
+	u64 total_ns;
+	u64 min_ns;
+	u64 max_ns;
+};
+
+struct dma_test_pvt {
+	struct pci_dev *pdev;
+	void __iomem *bar0;
+	void __iomem *buf;
+	u32 buf_size;
+	void *host_virt;
+	dma_addr_t host_iova;
+
+	/* Serializes test runs and the parameters below */
+	struct mutex lock;
+	enum dma_test_mode mode;
+	u32 size;
+	u32 depth;
+	u32 channels;
+	u32 iterations;
+	struct dma_test_result result;
+};
+
+#define mbox_off(field)	offsetof(struct pcie_dma_test_mbox, field)
+
+static inline u32 mbox_rd(struct dma_test_pvt *dt, u32 off)
+{
+	return readl(dt->bar0 + off);
+}
+
+static inline void mbox_wr(struct dma_test_pvt *dt, u32 val, u32 off)
+{
+	writel(val, dt->bar0 + off);
+}
+
+static int dma_test_run_dma(struct dma_test_pvt *dt,
+			    struct dma_test_result *res)
+{
+	unsigned long timeout;
+	u32 cmd, status;
+
+	cmd = res->mode == DMA_TEST_DMA_WRITE ? PCIE_DMA_TEST_CMD_WRITE :
+						PCIE_DMA_TEST_CMD_READ;
+
+	mbox_wr(dt, PCIE_DMA_TEST_STATUS_IDLE, mbox_off(status));
+	mbox_wr(dt, res->size, mbox_off(size));
+	mbox_wr(dt, res->depth, mbox_off(depth));
+	mbox_wr(dt, res->channels, mbox_off(channels));
+	mbox_wr(dt, res->iterations, mbox_off(iterations));
+	/* EP picks up the test as soon as it sees cmd */
+	wmb();
+	mbox_wr(dt, cmd, mbox_off(cmd));
+
+	timeout = jiffies + msecs_to_jiffies(TEST_TIMEOUT_MS);
+	while (true) {
+		status = mbox_rd(dt, mbox_off(status));
+		if (status == PCIE_DMA_TEST_STATUS_DONE ||
+		    status == PCIE_DMA_TEST_STATUS_ERROR)
+			break;
+		if (time_after(jiffies, timeout)) {
+			mbox_wr(dt, PCIE_DMA_TEST_CMD_NONE, mbox_off(cmd));
+			return -ETIMEDOUT;
+		}
+		usleep_range(100, 200);
+	}
+
+	rmb();
+	if (status == PCIE_DMA_TEST_STATUS_ERROR)
+		return (s32)mbox_rd(dt, mbox_off(error));
+
+	res->total_ns = readq(dt->bar0 + mbox_off(total_ns));
+	res->min_ns = readq(dt->bar0 + mbox_off(min_ns));
+	res->max_ns = readq(dt->bar0 + mbox_off(max_ns));
+
+	return 0;
+}
+
+/*
+ * CPU copies between host memory and the EP buffer through BAR0, for
+ * comparison with DMA. Writes are posted, so each round ends with a
+ * read back to account for their completion.
+ */
+static int dma_test_run_mmio(struct dma_test_pvt *dt,
+			     struct dma_test_result *res)
+{
+	bool write = res->mode == DMA_TEST_MMIO_WRITE;
+	u64 start, ns;
+	u32 i, j, off;
+
+	if (res->channels != 1)
+		return -EINVAL;
+
+	res->min_ns = U64_MAX;
+	res->max_ns = 0;
+	res->total_ns = 0;
+
+	for (i = 0; i < res->iterations; i++) {
+		start = ktime_get_ns();
+		for (j = 0; j < res->depth; j++) {
+			off = j * res->size;
+			if (write)
+				memcpy_toio(dt->buf + off, dt->host_virt + off,
+					    res->size);
+			else
+				memcpy_fromio(dt->host_virt + off,
+					      dt->buf + off, res->size);
+		}
+		if (write)
+			mbox_rd(dt, mbox_off(magic));
+		ns = ktime_get_ns() - start;
+
+		res->total_ns += ns;
+		res->min_ns = min(res->min_ns, ns);
+		res->max_ns = max(res->max_ns, ns);
+		cond_resched();
+	}
+
+	return 0;
+}
+
+static int dma_test_run(struct dma_test_pvt *dt)
+{
+	struct dma_test_result *res = &dt->result;
+	u64 len;
+	int ret;
+
+	memset(res, 0, sizeof(*res));
+	res->mode = dt->mode;
+	res->size = dt->size;
+	res->depth = dt->depth;
+	res->channels = dt->channels;
+	res->iterations = dt->iterations;
+
+	len = (u64)res->size * res->depth * res->channels;
+	if (!len || !res->iterations || len > dt->buf_size ||
+	    len > host_buf_size || res->depth > PCIE_DMA_TEST_MAX_DEPTH)
+		return -EINVAL;
+
+	if (res->mode == DMA_TEST_DMA_WRITE || res->mode == DMA_TEST_DMA_READ)
+		ret = dma_test_run_dma(dt, res);
+	else
+		ret = dma_test_run_mmio(dt, res);
+
+	res->error = ret;
+	res->valid = true;
+
+	return ret;
+}
+
+static ssize_t mode_show(struct device *dev, struct device_attribute *attr,
+			 char *buf)
+{
+	struct dma_test_pvt *dt = dev_get_drvdata(dev);
+
+	return sprintf(buf, "%s\n", dma_test_mode_names[dt->mode]);
+}
+
+static ssize_t mode_store(struct device *dev, struct device_attribute *attr,
+			  const char *buf, size_t count)
+{
+	struct dma_test_pvt *dt = dev_get_drvdata(dev);
+	int i;
+
+	for (i = 0; i < ARRAY_SIZE(dma_test_mode_names); i++) {
+		if (sysfs_streq(buf, dma_test_mode_names[i])) {
+			mutex_lock(&dt->lock);
+			dt->mode = i;
+			mutex_unlock(&dt->lock);
+			return count;
+		}
+	}
+
+	return -EINVAL;
+}
+static DEVICE_ATTR_RW(mode);
+
+#define DMA_TEST_PARAM_ATTR(name)					\
+static ssize_t name##_show(struct device *dev,				\
+			   struct device_attribute *attr, char *buf)	\
+{									\
+	struct dma_test_pvt *dt = dev_get_drvdata(dev);			\
+									\
+	return sprintf(buf, "%u\n", dt->name);				\
+}									\
+									\
+static ssize_t name##_store(struct device *dev,				\
+			    struct device_attribute *attr,		\
+			    const char *buf, size_t count)		\
+{									\
+	struct dma_test_pvt *dt = dev_get_drvdata(dev);			\
+	u32 val;							\
+	int ret;							\
+									\
+	ret = kstrtou32(buf, 0, &val);					\
+	if (ret)							\
+		return ret;						\
+	if (!val)							\
+		return -EINVAL;						\
+									\
+	mutex_lock(&dt->lock);						\
+	dt->name = val;							\
+	mutex_unlock(&dt->lock);					\
+									\
+	return count;							\
+}									\
+static DEVICE_ATTR_RW(name)
+
+DMA_TEST_PARAM_ATTR(size);
+DMA_TEST_PARAM_ATTR(depth);
+DMA_TEST_PARAM_ATTR(channels);
+DMA_TEST_PARAM_ATTR(iterations);
+
+static ssize_t run_store(struct device *dev, struct device_attribute *attr,
+			 const char *buf, size_t count)
+{
+	struct dma_test_pvt *dt = dev_get_drvdata(dev);
+	bool run;
+	int ret;
+
+	ret = kstrtobool(buf, &run);
+	if (ret)
+		return ret;
+	if (!run)
+		return count;
+
+	mutex_lock(&dt->lock);
+	ret = dma_test_run(dt);
+	mutex_unlock(&dt->lock);
+
+	return ret ? ret : count;
+}
+static DEVICE_ATTR_WO(run);
+
+static ssize_t result_show(struct device *dev, struct device_attribute *attr,
+			   char *buf)
+{
+	struct dma_test_pvt *dt = dev_get_drvdata(dev);
+	struct dma_test_result *res = &dt->result;
+	u64 bytes, mbps = 0;
+	ssize_t len;
+
+	mutex_lock(&dt->lock);
+	if (!res->valid) {
+		mutex_unlock(&dt->lock);
+		return sprintf(buf, "none\n");
+	}
+
+	len = sprintf(buf, "mode: %s\nsize: %u\ndepth: %u\nchannels: %u\n"
+		      "iterations: %u\n", dma_test_mode_names[res->mode],
+		      res->size, res->depth, res->channels, res->iterations);
+	if (res->error) {
+		len += sprintf(buf + len, "error: %d\n", res->error);
+		mutex_unlock(&dt->lock);
+		return len;
+	}
+
+	bytes = (u64)res->size * res->depth * res->channels * res->iterations;
+	/* bytes per usec is MB/s */
+	if (res->total_ns)
+		mbps = div64_u64(bytes * NSEC_PER_USEC, res->total_ns);
+
+	len += sprintf(buf + len, "bytes: %llu\ntotal_ns: %llu\n"
+		       "throughput_MBps: %llu\nlatency_min_ns: %llu\n"
+		       "latency_avg_ns: %llu\nlatency_max_ns: %llu\n",
+		       bytes, res->total_ns, mbps, res->min_ns,
+		       div_u64(res->total_ns, res->iterations), res->max_ns);
+	mutex_unlock(&dt->lock);
+
+	return len;
+}
+static DEVICE_ATTR_RO(result);
+
+static struct attribute *dma_test_attrs[] = {
+	&dev_attr_mode.attr,
+	&dev_attr_size.attr,
+	&dev_attr_depth.attr,
+	&dev_attr_channels.attr,
+	&dev_attr_iterations.attr,
+	&dev_attr_run.attr,
+	&dev_attr_result.attr,
+	NULL,
+};
+
+static const struct attribute_group dma_test_attr_group = {
+	.name = "dma_test",
+	.attrs = dma_test_attrs,
+};
+
+static int dma_test_probe(struct pci_dev *pdev, const struct pci_device_id *id)
+{
+	struct dma_test_pvt *dt;
+	u32 buf_offset;
+	int ret;
+
+	dt = devm_kzalloc(&pdev->dev, sizeof(*dt), GFP_KERNEL);
+	if (!dt)
+		return -ENOMEM;
+
+	dt->pdev = pdev;
+	mutex_init(&dt->lock);
+	dt->mode = DMA_TEST_DMA_WRITE;
+	dt->size = SZ_64K;
+	dt->depth = 1;
+	dt->channels = 1;
+	dt->iterations = 1000;
+	pci_set_drvdata(pdev, dt);
+
+	ret = pci_enable_device(pdev);
+	if (ret < 0) {
+		dev_err(&pdev->dev, "enabling device failed\n");
+		return ret;
+	}
+
+	pci_set_master(pdev);
+
+	ret = pci_request_regions(pdev, MODULENAME);
+	if (ret < 0) {
+		dev_err(&pdev->dev, "region request failed\n");
+		goto fail_region_request;
+	}
+
+	dt->bar0 = pci_ioremap_wc_bar(pdev, 0);
+	if (!dt->bar0) {
+		dev_err(&pdev->dev, "BAR0 remap failed\n");
+		ret = -ENOMEM;
+		goto fail_region_remap;
+	}
+
+	/* Other NVIDIA memory class functions are not ours */
+	if (mbox_rd(dt, mbox_off(magic)) != PCIE_DMA_TEST_MAGIC) {
+		ret = -ENODEV;
+		goto fail_magic;
+	}
+
+	buf_offset = mbox_rd(dt, mbox_off(buf_offset));
+	dt->buf_size = mbox_rd(dt, mbox_off(buf_size));
+	if ((u64)buf_offset + dt->buf_size > pci_resource_len(pdev, 0)) {
+		dev_err(&pdev->dev, "invalid EP buffer 0x%x@0x%x\n",
+			dt->buf_size, buf_offset);
+		ret = -EINVAL;
+		goto fail_magic;
+	}
+	dt->buf = dt->bar0 + buf_offset;
+
+	dt->host_virt = dma_alloc_coherent(&pdev->dev, host_buf_size,
+					   &dt->host_iova, GFP_KERNEL);
+	if (!dt->host_virt) {
+		dev_err(&pdev->dev, "host buffer allocation failed\n");
+		ret = -ENOMEM;
+		goto fail_magic;
+	}
+
+	writeq(dt->host_iova, dt->bar0 + mbox_off(host_buf_addr));
+	mbox_wr(dt, host_buf_size, mbox_off(host_buf_size));
+
+	ret = sysfs_create_group(&pdev->dev.kobj, &dma_test_attr_group);
+	if (ret < 0) {
+		dev_err(&pdev->dev, "sysfs group creation failed: %d\n", ret);
+		goto fail_sysfs;
+	}
+
+	return 0;
+
+fail_sysfs:
+	dma_free_coherent(&pdev->dev, host_buf_size, dt->host_virt,
+			  dt->host_iova);
+fail_magic:
+	iounmap(dt->bar0);
+fail_region_remap:
+	pci_release_regions(pdev);
+fail_region_request:
+	pci_clear_master(pdev);
+	pci_disable_device(pdev);
+	return ret;
+}
+
+static void dma_test_remove(struct pci_dev *pdev)
+{
+	struct dma_test_pvt *dt = pci_get_drvdata(pdev);
+
+	sysfs_remove_group(&pdev->dev.kobj, &dma_test_attr_group);
+	/* EP must not DMA to the buffer anymore */
+	writeq(0, dt->bar0 + mbox_off(host_buf_addr));
+	mbox_wr(dt, 0, mbox_off(host_buf_size));
+	mbox_rd(dt, mbox_off(magic));
+	dma_free_coherent(&pdev->dev, host_buf_size, dt->host_virt,
+			  dt->host_iova);
+	iounmap(dt->bar0);
+	pci_release_regions(pdev);
+	pci_clear_master(pdev);
+	pci_disable_device(pdev);
+}
+
+/* pci_epf_dma_test function, identified by its class and the BAR0 magic */
+static const struct pci_device_id dma_test_pci_tbl[] = {
+	{
+		.vendor = PCI_VENDOR_ID_NVIDIA,
+		.device = PCI_ANY_ID,
+		.subvendor = PCI_ANY_ID,
+		.subdevice = PCI_ANY_ID,
+		.class = PCI_CLASS_MEMORY_OTHER << 8,
+		.class_mask = ~0,
+	},
+	{},
+};
+
+MODULE_DEVICE_TABLE(pci, dma_test_pci_tbl);
+
+static struct pci_driver dma_test_pci_driver = {
+	.name		= MODULENAME,
+	.id_table	= dma_test_pci_tbl,
+	.probe		= dma_test_probe,
+	.remove		= dma_test_remove,
+};
+
+module_pci_driver(dma_test_pci_driver);
+
+MODULE_DESCRIPTION("Tegra PCIe endpoint DMA throughput test host driver");
+MODULE_LICENSE("GPL v2");
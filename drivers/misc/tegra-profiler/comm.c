@@ -34,16 +34,25 @@
 #include "quadd.h"
 #include "version.h"
 
+/*
+ * Samples are written without a lock. A writer runs with local irqs
+ * disabled, so samples from one CPU never nest, and reserves its space
+ * by moving the private reserve position with cmpxchg. This only races
+ * for samples put into another CPU's buffer. Writers publish pos_write
+ * in the order they reserved, so user space never sees a hole. The
+ * buffer is attached and detached with rb_hdr, which writers read once.
+ * Writers run with irqs off, so synchronize_sched() waits for them.
+ */
 struct quadd_ring_buffer {
 	struct quadd_ring_buffer_hdr *rb_hdr;
 	char *buf;
 
+	u32 pos_reserve;
+
 	size_t max_fill_count;
-	size_t nr_skipped_samples;
+	atomic_long_t nr_skipped_samples;
 
 	struct quadd_mmap_area *mmap;
-
-	raw_spinlock_t lock;
 };
 
 struct quadd_comm_ctx {
@@ -94,17 +103,17 @@ rb_write(struct quadd_ring_buffer_hdr *rb_hdr,
 	rb_hdr->pos_write = head;
 }
 
+/* call with local irqs disabled */
 static ssize_t
 write_sample(struct quadd_ring_buffer *rb,
+	     struct quadd_ring_buffer_hdr *rb_hdr,
 	     struct quadd_record_data *sample,
 	     const struct quadd_iovec *vec, int vec_count)
 {
 	int i;
 	size_t len = 0, c;
-	struct quadd_ring_buffer_hdr hdr, *rb_hdr = rb->rb_hdr;
-
-	if (!rb_hdr)
-		return -EIO;
+	u32 head, next;
+	struct quadd_ring_buffer_hdr hdr;
 
 	if (vec) {
 		for (i = 0; i < vec_count; i++)
@@ -115,16 +124,22 @@ write_sample(struct quadd_ring_buffer *rb,
 	len += sizeof(*sample);
 
 	hdr.size = rb_hdr->size;
-	hdr.pos_write = rb_hdr->pos_write;
-	hdr.pos_read = READ_ONCE(rb_hdr->pos_read);
-
-	c = CIRC_SPACE(hdr.pos_write, hdr.pos_read, hdr.size);
-	if (len > c) {
-		pr_err_once("[cpu: %d] warning: buffer has been overflowed\n",
-			    smp_processor_id());
-		return -ENOSPC;
-	}
 
+	do {
+		head = READ_ONCE(rb->pos_reserve);
+		hdr.pos_read = READ_ONCE(rb_hdr->pos_read);
+
+		c = CIRC_SPACE(head, hdr.pos_read, hdr.size);
+		if (len > c) {
+			pr_err_once("[cpu: %d] warning: buffer has been overflowed\n",
+				    smp_processor_id());
+			return -ENOSPC;
+		}
+
+		next = (head + len) & (hdr.size - 1);
+	} while (cmpxchg(&rb->pos_reserve, head, next) != head);
+
+	hdr.pos_write = head;
 	rb_write(&hdr, rb->buf, sample, sizeof(*sample));
 
 	if (vec) {
@@ -132,12 +147,19 @@ write_sample(struct quadd_ring_buffer *rb,
 			rb_write(&hdr, rb->buf, vec[i].base, vec[i].len);
 	}
 
+	/* racy, but only a statistic */
 	c = CIRC_CNT(hdr.pos_write, hdr.pos_read, hdr.size);
-	if (c > rb->max_fill_count) {
-		rb->max_fill_count = c;
+	if (c > READ_ONCE(rb->max_fill_count)) {
+		WRITE_ONCE(rb->max_fill_count, c);
 		rb_hdr->max_fill_count = c;
 	}
 
+	/* a sample reserved before ours on another CPU is published first,
+	 * it is being written with irqs off so this is a short wait
+	 */
+	while (READ_ONCE(rb_hdr->pos_write) != head)
+		cpu_relax();
+
 	/* Use smp_store_release() to update circle buffer write pointers to
 	 * ensure the data is stored before we update write pointer.
 	 */
@@ -160,16 +182,16 @@ static size_t get_data_size(void)
 
 		rb = &cc->rb;
 
-		rb_hdr = rb->rb_hdr;
-		if (!rb_hdr)
-			continue;
-
-		raw_spin_lock_irqsave(&rb->lock, flags);
+		local_irq_save(flags);
 
-		tail = READ_ONCE(rb_hdr->pos_read);
-		size += CIRC_CNT(rb_hdr->pos_write, tail, rb_hdr->size);
+		rb_hdr = smp_load_acquire(&rb->rb_hdr);
+		if (rb_hdr) {
+			tail = READ_ONCE(rb_hdr->pos_read);
+			size += CIRC_CNT(READ_ONCE(rb_hdr->pos_write), tail,
+					 rb_hdr->size);
+		}
 
-		raw_spin_unlock_irqrestore(&rb->lock, flags);
+		local_irq_restore(flags);
 	}
 
 	return size;
@@ -194,19 +216,21 @@ put_sample(struct quadd_record_data *data,
 
 	rb = &cc->rb;
 
-	raw_spin_lock_irqsave(&rb->lock, flags);
+	local_irq_save(flags);
 
-	err = write_sample(rb, data, vec, vec_count);
+	rb_hdr = smp_load_acquire(&rb->rb_hdr);
+	err = rb_hdr ? write_sample(rb, rb_hdr, data, vec, vec_count) : -EIO;
 	if (err < 0) {
+		long skipped;
+
 		pr_err_once("%s: error: write sample\n", __func__);
-		rb->nr_skipped_samples++;
+		skipped = atomic_long_inc_return(&rb->nr_skipped_samples);
 
-		rb_hdr = rb->rb_hdr;
 		if (rb_hdr)
-			rb_hdr->skipped_samples++;
+			WRITE_ONCE(rb_hdr->skipped_samples, skipped);
 	}
 
-	raw_spin_unlock_irqrestore(&rb->lock, flags);
+	local_irq_restore(flags);
 
 	return err;
 }
@@ -290,7 +314,6 @@ init_mmap_hdr(struct quadd_mmap_rb_info *mmap_rb,
 {
 	unsigned int cpu_id;
 	size_t size;
-	unsigned long flags;
 	struct vm_area_struct *vma;
 	struct quadd_ring_buffer *rb;
 	struct quadd_ring_buffer_hdr *rb_hdr;
@@ -317,15 +340,18 @@ init_mmap_hdr(struct quadd_mmap_rb_info *mmap_rb,
 
 	size -= PAGE_SIZE;
 
-	raw_spin_lock_irqsave(&rb->lock, flags);
+	/* writers may still use the attached buffer */
+	if (rb->rb_hdr)
+		return -EBUSY;
 
 	mmap->rb = rb;
 
 	rb->mmap = mmap;
 	rb->buf = (char *)mmap->data + PAGE_SIZE;
 
+	rb->pos_reserve = 0;
 	rb->max_fill_count = 0;
-	rb->nr_skipped_samples = 0;
+	atomic_long_set(&rb->nr_skipped_samples, 0);
 
 	mmap_hdr = mmap->data;
 
@@ -335,7 +361,6 @@ init_mmap_hdr(struct quadd_mmap_rb_info *mmap_rb,
 	mmap_hdr->samples_version = QUADD_SAMPLES_VERSION;
 
 	rb_hdr = (struct quadd_ring_buffer_hdr *)(mmap_hdr + 1);
-	rb->rb_hdr = rb_hdr;
 
 	rb_hdr->size = size;
 	rb_hdr->pos_read = 0;
@@ -346,7 +371,8 @@ init_mmap_hdr(struct quadd_mmap_rb_info *mmap_rb,
 
 	rb_hdr->state = QUADD_RB_STATE_ACTIVE;
 
-	raw_spin_unlock_irqrestore(&rb->lock, flags);
+	/* writers see the header only once it is set up */
+	smp_store_release(&rb->rb_hdr, rb_hdr);
 
 	pr_debug("[cpu: %d] init_mmap_hdr: vma: %#lx - %#lx, data: %p - %p\n",
 		 cpu_id,
@@ -372,27 +398,25 @@ static void rb_stop(void)
 		if (!rb_hdr)
 			continue;
 
-		pr_info("[%d] skipped samples/max filling: %zu/%zu\n",
-			cpu_id, rb->nr_skipped_samples, rb->max_fill_count);
+		pr_info("[%d] skipped samples/max filling: %ld/%zu\n",
+			cpu_id, atomic_long_read(&rb->nr_skipped_samples),
+			rb->max_fill_count);
 
 		rb_hdr->state = QUADD_RB_STATE_STOPPED;
 	}
 }
 
+/*
+ * Detach the buffer from writers. The caller has to synchronize_sched()
+ * before freeing it.
+ */
 static void rb_reset(struct quadd_ring_buffer *rb)
 {
-	unsigned long flags;
-
 	if (!rb)
 		return;
 
-	raw_spin_lock_irqsave(&rb->lock, flags);
-
+	WRITE_ONCE(rb->rb_hdr, NULL);
 	rb->mmap = NULL;
-	rb->buf = NULL;
-	rb->rb_hdr = NULL;
-
-	raw_spin_unlock_irqrestore(&rb->lock, flags);
 }
 
 static int
@@ -824,6 +848,10 @@ out:
 	raw_spin_unlock(&comm_ctx.ctx->mmaps_lock);
 
 	if (mmap) {
+		/* wait for writers still using the ring buffer */
+		if (mmap->type == QUADD_MMAP_TYPE_RB)
+			synchronize_sched();
+
 		vfree(mmap->data);
 		kfree(mmap);
 	}
@@ -977,10 +1005,9 @@ static int comm_init(void)
 		rb->buf = NULL;
 		rb->rb_hdr = NULL;
 
+		rb->pos_reserve = 0;
 		rb->max_fill_count = 0;
-		rb->nr_skipped_samples = 0;
-
-		raw_spin_lock_init(&rb->lock);
+		atomic_long_set(&rb->nr_skipped_samples, 0);
 	}
 
 	reset_params_ok_flag();
@@ -124,19 +124,6 @@ struct stackframe {
 	int is_sched;
 };
 
-struct dwarf_cpu_context {
-	struct regs_state rs_stack[DW_MAX_RS_STACK_DEPTH];
-	int depth;
-
-	struct stackframe sf;
-	int dw_ptr_size;
-};
-
-struct quadd_dwarf_context {
-	struct dwarf_cpu_context __percpu *cpu_ctx;
-	atomic_t started;
-};
-
 struct dw_cie {
 	unsigned long offset;
 	unsigned long length;
@@ -176,6 +163,41 @@ struct dw_fde {
 	unsigned char *data;
 };
 
+#define DW_FDE_CACHE_SIZE	8
+
+/*
+ * Recently decoded FDEs and their CIEs. A hit skips the search of the
+ * frame header table and the decoding. The entries point into the mmap
+ * data of the file, so the data address is part of the key along with
+ * the file and where it is mapped.
+ */
+struct dw_fde_cache_entry {
+	struct quadd_mmap_area *mmap;
+	void *data;
+	unsigned long vm_start;
+	u32 file_hash;
+	int is_eh;
+
+	struct dw_cie cie;
+	struct dw_fde fde;
+};
+
+struct dwarf_cpu_context {
+	struct regs_state rs_stack[DW_MAX_RS_STACK_DEPTH];
+	int depth;
+
+	struct stackframe sf;
+	int dw_ptr_size;
+
+	struct dw_fde_cache_entry fde_cache[DW_FDE_CACHE_SIZE];
+	unsigned int fde_cache_next;
+};
+
+struct quadd_dwarf_context {
+	struct dwarf_cpu_context __percpu *cpu_ctx;
+	atomic_t started;
+};
+
 struct eh_sec_data {
 	size_t length;
 	unsigned char *data;
@@ -1764,6 +1786,63 @@ is_fde_entry_exist(struct ex_region_info *ri,
 	return (*is_eh || *is_debug) ? 1 : 0;
 }
 
+static int
+dwarf_fde_cache_lookup(struct ex_region_info *ri,
+		       struct dw_cie *cie,
+		       struct dw_fde *fde,
+		       unsigned long pc,
+		       int is_eh)
+{
+	int i;
+	struct dw_fde_cache_entry *e;
+	struct dwarf_cpu_context *cpu_ctx = this_cpu_ptr(ctx.cpu_ctx);
+
+	for (i = 0; i < DW_FDE_CACHE_SIZE; i++) {
+		e = &cpu_ctx->fde_cache[i];
+
+		if (e->mmap != ri->mmap || e->data != ri->mmap->data ||
+		    e->vm_start != ri->vm_start ||
+		    e->file_hash != ri->file_hash || e->is_eh != is_eh)
+			continue;
+
+		if (pc < e->fde.initial_location ||
+		    pc >= e->fde.initial_location + e->fde.address_range)
+			continue;
+
+		*cie = e->cie;
+		*fde = e->fde;
+		fde->cie = cie;
+
+		return 1;
+	}
+
+	return 0;
+}
+
+static void
+dwarf_fde_cache_add(struct ex_region_info *ri,
+		    const struct dw_cie *cie,
+		    const struct dw_fde *fde,
+		    int is_eh)
+{
+	struct dw_fde_cache_entry *e;
+	struct dwarf_cpu_context *cpu_ctx = this_cpu_ptr(ctx.cpu_ctx);
+
+	e = &cpu_ctx->fde_cache[cpu_ctx->fde_cache_next];
+	cpu_ctx->fde_cache_next =
+		(cpu_ctx->fde_cache_next + 1) % DW_FDE_CACHE_SIZE;
+
+	e->mmap = ri->mmap;
+	e->data = ri->mmap->data;
+	e->vm_start = ri->vm_start;
+	e->file_hash = ri->file_hash;
+	e->is_eh = is_eh;
+
+	e->cie = *cie;
+	e->fde = *fde;
+	e->fde.cie = NULL;
+}
+
 static long
 dwarf_decode(struct ex_region_info *ri,
 	     struct stackframe *sf,
@@ -1780,6 +1859,9 @@ dwarf_decode(struct ex_region_info *ri,
 	unsigned long hdr_len, addr;
 	struct extab_info *ti;
 
+	if (dwarf_fde_cache_lookup(ri, cie, fde, pc, is_eh))
+		return 0;
+
 	secid_hdr = get_secid_frame_hdr(is_eh);
 	ti = &ri->mmap->fi.ex_sec[secid_hdr];
 
@@ -1809,6 +1891,8 @@ dwarf_decode(struct ex_region_info *ri,
 		return -QUADD_URC_IDX_NOT_FOUND;
 	}
 
+	dwarf_fde_cache_add(ri, cie, fde, is_eh);
+
 	return 0;
 }
 
@@ -564,49 +564,23 @@ int ttcan_tx_fifo_full(struct ttcan_controller *ttcan)
 	return (txfqs_reg & MTT_TXFQS_TFQF_MASK) >> MTT_TXFQS_TFQF_SHIFT;
 }
 
-static int process_rx_mesg(struct ttcan_controller *ttcan, u32 addr)
+/* Returns NDAT2:NDAT1, the dedicated Rx buffers holding new messages */
+u64 ttcan_read_rx_buf_ndat(struct ttcan_controller *ttcan)
 {
-	struct ttcanfd_frame ttcanfd;
-	ttcan_read_rx_msg_ram(ttcan, addr, &ttcanfd);
-	return add_msg_controller_list(ttcan, &ttcanfd, &ttcan->rx_b, BUFFER);
-}
+	u64 ndat;
 
-int ttcan_read_rx_buffer(struct ttcan_controller *ttcan)
-{
-	u32 ndat1, ndat2;
-	u32 read_addr;
-	int msgs_read = 0;
+	ndat = ttcan_read32(ttcan, ADR_MTTCAN_NDAT2);
+	ndat = (ndat << 32) | ttcan_read32(ttcan, ADR_MTTCAN_NDAT1);
 
-	ndat1 = ttcan_read32(ttcan, ADR_MTTCAN_NDAT1);
-	ndat2 = ttcan_read32(ttcan, ADR_MTTCAN_NDAT2);
-
-	while (ndat1 != 0 || ndat2 != 0) {
-		u32 bit_set1 = ffs(ndat1) - 1;
-		u32 bit_set2 = ffs(ndat2) - 1;
-		if (ndat1) {
-			read_addr = ttcan->mram_cfg[MRAM_RXB].off + (bit_set1 *
-				ttcan->e_size.rx_buffer);
-			if (process_rx_mesg(ttcan, read_addr))
-				return msgs_read;
-			ttcan_write32(ttcan, ADR_MTTCAN_NDAT1,
-				(1 << (bit_set1)));
-			msgs_read++;
-		}
-
-		if (ndat2) {
-			read_addr = ttcan->mram_cfg[MRAM_RXB].off + (bit_set2 *
-				ttcan->e_size.rx_buffer);
-			if (process_rx_mesg(ttcan, read_addr))
-				return msgs_read;
-			ttcan_write32(ttcan, ADR_MTTCAN_NDAT2,
-				(1 << (bit_set2)));
-			msgs_read++;
-		}
-		ndat1 &= ~(1 << (bit_set1));
-		ndat2 &= ~(1 << (bit_set2));
-	}
+	return ndat;
+}
 
-	return msgs_read;
+void ttcan_ack_rx_buf(struct ttcan_controller *ttcan, u64 ndat)
+{
+	if (lower_32_bits(ndat))
+		ttcan_write32(ttcan, ADR_MTTCAN_NDAT1, lower_32_bits(ndat));
+	if (upper_32_bits(ndat))
+		ttcan_write32(ttcan, ADR_MTTCAN_NDAT2, upper_32_bits(ndat));
 }
 
 /* Tx Evt Fifo */
@@ -652,110 +626,34 @@ unsigned int ttcan_read_txevt_fifo(struct ttcan_controller *ttcan)
 
 /* Rx FIFO section */
 
-unsigned int ttcan_read_rx_fifo0(struct ttcan_controller *ttcan)
-{
-	u32 rxf0s_reg;
-	struct ttcanfd_frame ttcanfd;
-	u32 read_addr;
-	int q_read = 0;
-	unsigned int msgs_read = 0;
-
-	rxf0s_reg = ttcan_read32(ttcan, ADR_MTTCAN_RXF0S);
-
-	if (!(rxf0s_reg & MTT_RXF0S_F0FL_MASK)) {
-		return msgs_read;
-	}
-
-	/* Read at max queue size in one attempt */
-	q_read = ttcan->mram_cfg[MRAM_RXF0].num;
-
-	while ((rxf0s_reg & MTT_RXF0S_F0FL_MASK) && q_read--) {
-		u32 get_idx = (rxf0s_reg & MTT_RXF0S_F0GI_MASK) >>
-		    MTT_RXF0S_F0GI_SHIFT;
-		if (ttcan->rx_config.rxq0_bmsk & (1 << get_idx)) {
-			/* All ready process on High priority */
-			ttcan_write32(ttcan, ADR_MTTCAN_RXF0A, get_idx);
-			ttcan->rx_config.rxq0_bmsk &= ~(1U << get_idx);
-			rxf0s_reg = ttcan_read32(ttcan, ADR_MTTCAN_RXF0S);
-			continue;
-		}
-
-		read_addr = ttcan->mram_cfg[MRAM_RXF0].off +
-		    (get_idx * ttcan->e_size.rx_fifo0);
-
-		pr_debug("%s:fifo0: read_addr %x FOGI %x\n", __func__,
-			 read_addr, get_idx);
-
-		ttcan_read_rx_msg_ram(ttcan, read_addr, &ttcanfd);
-		if (add_msg_controller_list(ttcan, &ttcanfd,
-					    &ttcan->rx_q0, FIFO_0) < 0) {
-			pr_err("%s: failed to add to list\n", __func__);
-			return msgs_read;
-		}
-		ttcan_write32(ttcan, ADR_MTTCAN_RXF0A, get_idx);
-		rxf0s_reg = ttcan_read32(ttcan, ADR_MTTCAN_RXF0S);
-		msgs_read++;
-	}
-	return msgs_read;
-}
-
-unsigned int ttcan_read_rx_fifo1(struct ttcan_controller *ttcan)
+/* Returns the fill level of a Rx FIFO and the index of its oldest element */
+u32 ttcan_read_rx_fifo_status(struct ttcan_controller *ttcan, int fifo_num,
+			      u32 *get_idx)
 {
-	u32 rxf1s_reg;
-	struct ttcanfd_frame ttcanfd;
-	u32 read_addr;
-	int q_read = 0;
-	int msgs_read = 0;
-
-	rxf1s_reg = ttcan_read32(ttcan, ADR_MTTCAN_RXF1S);
+	u32 rxfs_reg;
 
-	if (!(rxf1s_reg & MTT_RXF1S_F1FL_MASK)) {
-		return msgs_read;
+	if (fifo_num) {
+		rxfs_reg = ttcan_read32(ttcan, ADR_MTTCAN_RXF1S);
+		*get_idx = (rxfs_reg & MTT_RXF1S_F1GI_MASK) >>
+			MTT_RXF1S_F1GI_SHIFT;
+		return (rxfs_reg & MTT_RXF1S_F1FL_MASK) >>
+			MTT_RXF1S_F1FL_SHIFT;
 	}
 
-	/* Read at max queue size in one attempt */
-	q_read = ttcan->mram_cfg[MRAM_RXF1].num;
-
-	while ((rxf1s_reg & MTT_RXF1S_F1FL_MASK) && q_read--) {
-		u32 get_idx = (rxf1s_reg & MTT_RXF1S_F1GI_MASK) >>
-		    MTT_RXF1S_F1GI_SHIFT;
-		if (ttcan->rx_config.rxq1_bmsk & (1 << get_idx)) {
-			/* All ready process on High priority */
-			ttcan_write32(ttcan, ADR_MTTCAN_RXF1A, get_idx);
-			ttcan->rx_config.rxq1_bmsk &= ~(1U << get_idx);
-			rxf1s_reg = ttcan_read32(ttcan, ADR_MTTCAN_RXF1S);
-			continue;
-		}
-		read_addr = ttcan->mram_cfg[MRAM_RXF1].off +
-		    (get_idx * ttcan->e_size.rx_fifo1);
-
-		pr_debug("%s:fifo1: read_addr %x FOGI %x\n", __func__,
-			 read_addr, get_idx);
-
-		ttcan_read_rx_msg_ram(ttcan, read_addr, &ttcanfd);
-		if (add_msg_controller_list(ttcan, &ttcanfd,
-					    &ttcan->rx_q1, FIFO_1) < 0) {
-			pr_err("%s: failed to add to list\n", __func__);
-			return msgs_read;
-		}
-		ttcan_write32(ttcan, ADR_MTTCAN_RXF1A, get_idx);
-		rxf1s_reg = ttcan_read32(ttcan, ADR_MTTCAN_RXF1S);
-		msgs_read++;
-	}
-	return msgs_read;
+	rxfs_reg = ttcan_read32(ttcan, ADR_MTTCAN_RXF0S);
+	*get_idx = (rxfs_reg & MTT_RXF0S_F0GI_MASK) >> MTT_RXF0S_F0GI_SHIFT;
+	return (rxfs_reg & MTT_RXF0S_F0FL_MASK) >> MTT_RXF0S_F0FL_SHIFT;
 }
 
-/* Returns message read else return 0 */
-unsigned int ttcan_read_rx_fifo(struct ttcan_controller *ttcan)
+/*
+ * Acknowledging an element also releases all the elements before it,
+ * so a batch of reads needs a single write of the last index.
+ */
+void ttcan_ack_rx_fifo(struct ttcan_controller *ttcan, int fifo_num,
+		       u32 idx)
 {
-	int msgs_read = 0;
-
-	msgs_read = ttcan_read_rx_fifo0(ttcan);
-
-	if (ttcan->mram_cfg[MRAM_RXF1].num)
-		msgs_read += ttcan_read_rx_fifo1(ttcan);
-
-	return msgs_read;
+	ttcan_write32(ttcan, fifo_num ? ADR_MTTCAN_RXF1A : ADR_MTTCAN_RXF0A,
+		      idx);
 }
 
 unsigned int ttcan_read_hp_mesgs(struct ttcan_controller *ttcan,
@@ -294,8 +294,6 @@ struct ttcan_controller {
 	struct ttcan_rxbuff_config rx_config;
 	struct ttcan_filter_config fltr_config;
 	struct ttcan_mram_elem mram_cfg[MRAM_ELEMS];
-	struct list_head rx_q0;
-	struct list_head rx_q1;
 	struct list_head rx_b;
 	struct list_head tx_evt;
 	void __iomem *base;	/* controller regs space should be remapped. */
@@ -441,8 +439,10 @@ int ttcan_write_tx_msg_ram(struct ttcan_controller *ttcan,
 
 unsigned int ttcan_read_txevt_fifo(struct ttcan_controller *ttcan);
 
-unsigned int ttcan_read_rx_fifo0(struct ttcan_controller *ttcan);
-unsigned int ttcan_read_rx_fifo1(struct ttcan_controller *ttcan);
+u32 ttcan_read_rx_fifo_status(struct ttcan_controller *ttcan, int fifo_num,
+			      u32 *get_idx);
+void ttcan_ack_rx_fifo(struct ttcan_controller *ttcan, int fifo_num,
+		       u32 idx);
 unsigned int ttcan_read_hp_mesgs(struct ttcan_controller *ttcan,
 					struct ttcanfd_frame *ttcanfd);
 
@@ -500,7 +500,8 @@ u32 ttcan_read_tx_complete_reg(struct ttcan_controller *ttcan);
 void ttcan_set_tx_cancel_request(struct ttcan_controller *ttcan, u32 txbcr);
 u32 ttcan_read_tx_cancelled_reg(struct ttcan_controller *ttcan);
 u32 ttcan_read_psr(struct ttcan_controller *ttcan);
-int ttcan_read_rx_buffer(struct ttcan_controller *ttcan);
+u64 ttcan_read_rx_buf_ndat(struct ttcan_controller *ttcan);
+void ttcan_ack_rx_buf(struct ttcan_controller *ttcan, u64 ndat);
 int ttcan_set_bitrate(struct ttcan_controller *ttcan);
 
 void ttcan_disable_auto_retransmission(
@@ -39,6 +39,7 @@
 #include <linux/pinctrl/consumer.h>
 #include <linux/pm_runtime.h>
 #include <linux/net_tstamp.h>
+#include <linux/pkt_sched.h>
 #include <linux/spinlock.h>
 #include <linux/clocksource.h>
 #include <linux/platform/tegra/ptp-notifier.h>
@@ -65,12 +66,38 @@
 #define MTT_MAX_TX_CONF		4
 #define MTT_MAX_RX_CONF		3
 
+/* skb priority from which frames use the dedicated Tx buffers */
+#define MTTCAN_TX_PRIO_THRESH	TC_PRIO_INTERACTIVE
+
 #define MTTCAN_POLL_TIME	50
 #define MTTCAN_HWTS_ROLLOVER	250
 /* block period in ms */
 #define TX_BLOCK_PERIOD		200
 #define TSC_REF_CLK_RATE	31250000
 
+/* Private IOCTL to manage the acceptance filter elements at runtime */
+#define MTTCAN_PRV_FLTR_IOCTL	SIOCDEVPRIVATE
+
+#define MTTCAN_FLTR_SET		0
+#define MTTCAN_FLTR_GET		1
+#define MTTCAN_FLTR_CLEAR	2
+
+/*
+ * Argument of MTTCAN_PRV_FLTR_IOCTL, passed through ifr_data.
+ * type is SFT/EFT and fec is SFEC/EFEC of the element; with FEC_RXBUF,
+ * id2 holds the dedicated Rx buffer index. MTTCAN_FLTR_GET fills them
+ * from the element at idx.
+ */
+struct mttcan_fltr_req {
+	__u32 cmd;
+	__u32 xtd;		/* extended ID filter list */
+	__u32 idx;
+	__u32 type;
+	__u32 fec;
+	__u32 id1;
+	__u32 id2;
+};
+
 struct tegra_mttcan_soc_info {
 	bool set_can_core_clk;
 	unsigned long can_core_clk_rate;
@@ -78,6 +105,31 @@ struct tegra_mttcan_soc_info {
 	bool use_external_timer;
 };
 
+enum mttcan_rx_path {
+	MTTCAN_RX_FIFO0,
+	MTTCAN_RX_FIFO1,
+	MTTCAN_RX_BUF,
+	MTTCAN_RX_PATHS,
+};
+
+/*
+ * Receive telemetry of one Rx FIFO or of the dedicated Rx buffers,
+ * updated from NAPI only.
+ * isr_napi: ISR to NAPI poll latency, one sample per interrupt
+ * napi_sock: message RAM read to skb delivered to the sockets
+ * fill_max: highest FIFO fill level seen by NAPI
+ */
+struct mttcan_rx_stats {
+	u64 frames;
+	u64 lost;
+	u64 isr_napi_samples;
+	u64 isr_napi_ns;
+	u64 isr_napi_max_ns;
+	u64 napi_sock_ns;
+	u64 napi_sock_max_ns;
+	u64 fill_max;
+};
+
 struct can_gpio {
 	int gpio;
 	int active_low;
@@ -124,9 +176,12 @@ struct mttcan_priv {
 	u32 rx_conf[MTT_MAX_RX_CONF]; /*<rxb_dsize, rxq0_dsize, rxq1_dsize>*/
 	bool poll;
 	bool hwts_rx_en;
+	u64 isr_ns;
+	struct mttcan_rx_stats rx_stats[MTTCAN_RX_PATHS];
 	u32 resp;
 };
 
+int mttcan_check_fec_validity(struct mttcan_priv *priv, unsigned int fec);
 int mttcan_create_sys_files(struct device *dev);
 void mttcan_delete_sys_files(struct device *dev);
 #endif
@@ -256,6 +256,7 @@ static void mttcan_handle_lost_frame(struct net_device *dev, int fifo_num)
 	else
 		ack_ir = MTT_IR_RF0L_MASK;
 	ttcan_ir_write(priv->ttcan, ack_ir);
+	priv->rx_stats[fifo_num ? MTTCAN_RX_FIFO1 : MTTCAN_RX_FIFO0].lost++;
 
 	skb = alloc_can_err_skb(dev, &frame);
 	if (unlikely(!skb))
@@ -282,8 +283,8 @@ static void mttcan_rx_hwtstamp(struct mttcan_priv *priv,
 	hwtstamps->hwtstamp = ns_to_ktime(ns);
 }
 
-static int mttcan_hpm_do_receive(struct net_device *dev,
-				 struct ttcanfd_frame *msg)
+static int mttcan_do_receive(struct net_device *dev,
+			     struct ttcanfd_frame *msg)
 {
 	struct mttcan_priv *priv = netdev_priv(dev);
 	struct net_device_stats *stats = &dev->stats;
@@ -320,80 +321,115 @@ static int mttcan_hpm_do_receive(struct net_device *dev,
 	return 1;
 }
 
-static int mttcan_read_rcv_list(struct net_device *dev,
-				struct list_head *rcv,
-				enum ttcan_rx_type rx_type,
-				int rec_msgs, int quota)
+static void mttcan_rx_stats_update(struct mttcan_rx_stats *rx_stats,
+				   u64 isr_lat, u64 start, int frames)
 {
-	unsigned int pushed;
-	unsigned long flags;
-	struct mttcan_priv *priv = netdev_priv(dev);
-	struct ttcan_rx_msg_list *rx;
-	struct net_device_stats *stats = &dev->stats;
-	struct list_head *cur, *next, rx_q;
+	u64 ns;
 
-	if (list_empty(rcv))
-		return 0;
+	if (!frames)
+		return;
 
-	INIT_LIST_HEAD(&rx_q);
+	if (isr_lat) {
+		rx_stats->isr_napi_samples++;
+		rx_stats->isr_napi_ns += isr_lat;
+		rx_stats->isr_napi_max_ns = max(rx_stats->isr_napi_max_ns,
+						isr_lat);
+	}
 
-	spin_lock_irqsave(&priv->ttcan->lock, flags);
-	switch (rx_type) {
-	case BUFFER:
-		priv->ttcan->rxb_mem = 0;
-		priv->ttcan->list_status &= ~(BUFFER & 0xFF);
-		break;
-	case FIFO_0:
-		priv->ttcan->rxq0_mem = 0;
-		priv->ttcan->list_status &= ~(FIFO_0 & 0xFF);
-		break;
-	case FIFO_1:
-		priv->ttcan->rxq1_mem = 0;
-		priv->ttcan->list_status &= ~(FIFO_1 & 0xFF);
-	default:
-		break;
+	/* frames are delivered one after the other, this is per frame */
+	ns = div_u64(ktime_get_ns() - start, frames);
+	rx_stats->frames += frames;
+	rx_stats->napi_sock_ns += ns * frames;
+	rx_stats->napi_sock_max_ns = max(rx_stats->napi_sock_max_ns, ns);
+}
+
+/*
+ * Read the elements of a Rx FIFO from message RAM straight into skbs and
+ * release them all with one acknowledge. What does not fit in the quota
+ * stays in the FIFO for the next poll.
+ */
+static int mttcan_read_rx_fifo(struct net_device *dev, int fifo_num,
+			       int quota, u64 isr_lat)
+{
+	struct mttcan_priv *priv = netdev_priv(dev);
+	struct ttcan_controller *ttcan = priv->ttcan;
+	struct mttcan_rx_stats *rx_stats;
+	struct ttcan_mram_elem *mram;
+	struct ttcanfd_frame ttcanfd;
+	u32 fill, get_idx, idx = 0, elem_size, n;
+	u64 *hp_bmsk, start;
+	int work_done = 0;
+
+	if (fifo_num) {
+		mram = &ttcan->mram_cfg[MRAM_RXF1];
+		elem_size = ttcan->e_size.rx_fifo1;
+		hp_bmsk = &ttcan->rx_config.rxq1_bmsk;
+		rx_stats = &priv->rx_stats[MTTCAN_RX_FIFO1];
+	} else {
+		mram = &ttcan->mram_cfg[MRAM_RXF0];
+		elem_size = ttcan->e_size.rx_fifo0;
+		hp_bmsk = &ttcan->rx_config.rxq0_bmsk;
+		rx_stats = &priv->rx_stats[MTTCAN_RX_FIFO0];
 	}
-	list_splice_init(rcv, &rx_q);
-	spin_unlock_irqrestore(&priv->ttcan->lock, flags);
 
-	pushed = rec_msgs;
-	list_for_each_safe(cur, next, &rx_q) {
-		struct sk_buff *skb;
-		struct canfd_frame *fd_frame;
-		struct can_frame *frame;
-		if (!quota--)
-			break;
-		list_del_init(cur);
+	start = ktime_get_ns();
+	fill = ttcan_read_rx_fifo_status(ttcan, fifo_num, &get_idx);
+	rx_stats->fill_max = max_t(u64, rx_stats->fill_max, fill);
 
-		rx = list_entry(cur, struct ttcan_rx_msg_list, recv_list);
-		if (rx->msg.flags & CAN_FD_FLAG) {
-			skb = alloc_canfd_skb(dev, &fd_frame);
-			if (!skb) {
-				stats->rx_dropped += pushed;
-				return 0;
-			}
-			memcpy(fd_frame, &rx->msg, sizeof(struct canfd_frame));
-			stats->rx_bytes += fd_frame->len;
-		} else {
-			skb = alloc_can_skb(dev, &frame);
-			if (!skb) {
-				stats->rx_dropped += pushed;
-				return 0;
-			}
-			frame->can_id =  rx->msg.can_id;
-			frame->can_dlc = rx->msg.d_len;
-			memcpy(frame->data, &rx->msg.data, frame->can_dlc);
-			stats->rx_bytes += frame->can_dlc;
+	for (n = 0; n < fill && work_done < quota; n++) {
+		idx = (get_idx + n) % mram->num;
+
+		/* Already received as high priority message */
+		if (*hp_bmsk & (1ULL << idx)) {
+			*hp_bmsk &= ~(1ULL << idx);
+			continue;
 		}
 
-		if (priv->hwts_rx_en)
-			mttcan_rx_hwtstamp(priv, skb, &rx->msg);
-		kfree(rx);
-		netif_receive_skb(skb);
-		stats->rx_packets++;
-		pushed--;
+		ttcan_read_rx_msg_ram(ttcan, mram->off + idx * elem_size,
+				      &ttcanfd);
+		mttcan_do_receive(dev, &ttcanfd);
+		work_done++;
 	}
-	return rec_msgs - pushed;
+
+	if (n)
+		ttcan_ack_rx_fifo(ttcan, fifo_num, idx);
+
+	mttcan_rx_stats_update(rx_stats, isr_lat, start, work_done);
+
+	return work_done;
+}
+
+static int mttcan_read_rx_buffer(struct net_device *dev, int quota,
+				 u64 isr_lat)
+{
+	struct mttcan_priv *priv = netdev_priv(dev);
+	struct ttcan_controller *ttcan = priv->ttcan;
+	struct mttcan_rx_stats *rx_stats = &priv->rx_stats[MTTCAN_RX_BUF];
+	struct ttcanfd_frame ttcanfd;
+	u64 ndat, done = 0, start;
+	int work_done = 0;
+	u32 idx;
+
+	start = ktime_get_ns();
+	ndat = ttcan_read_rx_buf_ndat(ttcan);
+	rx_stats->fill_max = max_t(u64, rx_stats->fill_max, hweight64(ndat));
+
+	while (ndat && work_done < quota) {
+		idx = __ffs64(ndat);
+		ttcan_read_rx_msg_ram(ttcan, ttcan->mram_cfg[MRAM_RXB].off +
+				      idx * ttcan->e_size.rx_buffer, &ttcanfd);
+		mttcan_do_receive(dev, &ttcanfd);
+		done |= 1ULL << idx;
+		ndat &= ~(1ULL << idx);
+		work_done++;
+	}
+
+	if (done)
+		ttcan_ack_rx_buf(ttcan, done);
+
+	mttcan_rx_stats_update(rx_stats, isr_lat, start, work_done);
+
+	return work_done;
 }
 
 static int mttcan_state_change(struct net_device *dev,
@@ -640,14 +676,20 @@ static void mttcan_tx_cancelled(struct net_device *dev)
 static int mttcan_poll_ir(struct napi_struct *napi, int quota)
 {
 	int work_done = 0;
-	int rec_msgs = 0;
 	struct net_device *dev = napi->dev;
 	struct mttcan_priv *priv = netdev_priv(dev);
 	u32 ir, ack, ttir, ttack, psr;
+	u64 isr_lat = 0;
 
 	ir = priv->irqstatus;
 	ttir = priv->tt_irqstatus;
 
+	/* only the first poll after an interrupt has a latency sample */
+	if (priv->isr_ns) {
+		isr_lat = ktime_get_ns() - priv->isr_ns;
+		priv->isr_ns = 0;
+	}
+
 	netdev_dbg(dev, "IR %x\n", ir);
 	if (!ir && !ttir)
 		goto end;
@@ -725,8 +767,7 @@ static int mttcan_poll_ir(struct napi_struct *napi, int quota)
 			ack = MTT_IR_HPM_MASK;
 			ttcan_ir_write(priv->ttcan, ack);
 			if (ttcan_read_hp_mesgs(priv->ttcan, &ttcanfd))
-				work_done += mttcan_hpm_do_receive(dev,
-								   &ttcanfd);
+				work_done += mttcan_do_receive(dev, &ttcanfd);
 			pr_debug("%s: hp mesg received\n", __func__);
 		}
 
@@ -734,13 +775,10 @@ static int mttcan_poll_ir(struct napi_struct *napi, int quota)
 		if (ir & MTT_IR_DRX_MASK) {
 			ack = MTT_IR_DRX_MASK;
 			ttcan_ir_write(priv->ttcan, ack);
-			rec_msgs = ttcan_read_rx_buffer(priv->ttcan);
-			work_done +=
-			    mttcan_read_rcv_list(dev, &priv->ttcan->rx_b,
-						 BUFFER, rec_msgs,
-						 quota - work_done);
+			work_done += mttcan_read_rx_buffer(dev,
+							   quota - work_done,
+							   isr_lat);
 			pr_debug("%s: buffer mesg received\n", __func__);
-
 		}
 
 		/* Handle RX Fifo interrupt */
@@ -769,12 +807,9 @@ static int mttcan_poll_ir(struct napi_struct *napi, int quota)
 					MTT_IR_RF1N_MASK);
 				ttcan_ir_write(priv->ttcan, ack);
 
-				rec_msgs = ttcan_read_rx_fifo1(priv->ttcan);
-				work_done +=
-				    mttcan_read_rcv_list(dev,
-							 &priv->ttcan->rx_q1,
-							 FIFO_1, rec_msgs,
-							 quota - work_done);
+				work_done += mttcan_read_rx_fifo(dev, 1,
+							quota - work_done,
+							isr_lat);
 				pr_debug("%s: msg received in Q1\n", __func__);
 			}
 			if (ir & (MTT_IR_RF0F_MASK | MTT_IR_RF0W_MASK |
@@ -783,12 +818,9 @@ static int mttcan_poll_ir(struct napi_struct *napi, int quota)
 					MTT_IR_RF0W_MASK |
 					MTT_IR_RF0N_MASK);
 				ttcan_ir_write(priv->ttcan, ack);
-				rec_msgs = ttcan_read_rx_fifo0(priv->ttcan);
-				work_done +=
-				    mttcan_read_rcv_list(dev,
-							 &priv->ttcan->rx_q0,
-							 FIFO_0, rec_msgs,
-							 quota - work_done);
+				work_done += mttcan_read_rx_fifo(dev, 0,
+							quota - work_done,
+							isr_lat);
 				pr_debug("%s: msg received in Q0\n", __func__);
 			}
 		}
@@ -1154,6 +1186,8 @@ static irqreturn_t mttcan_isr(int irq, void *dev_id)
 	if (!priv->irqstatus && !priv->tt_irqstatus)
 		return IRQ_NONE;
 
+	priv->isr_ns = ktime_get_ns();
+
 	/* if there is error, read the PSR register now */
 	if (priv->irqstatus & MTTCAN_ERR_INTR)
 		priv->ttcan->proto_state = ttcan_read_psr(priv->ttcan);
@@ -1181,6 +1215,8 @@ static void mttcan_work(struct work_struct *work)
 	priv->tt_irqstatus = ttcan_read_ttir(priv->ttcan);
 
 	if (priv->irqstatus || priv->tt_irqstatus) {
+		priv->isr_ns = ktime_get_ns();
+
 		/* disable and clear all interrupts */
 		ttcan_set_intrpts(priv->ttcan, 0);
 
@@ -1288,6 +1324,18 @@ static int mttcan_close(struct net_device *dev)
 	return 0;
 }
 
+/*
+ * With both dedicated Tx buffers and a Tx FIFO/queue, the dedicated
+ * buffers are kept for frames of priority MTTCAN_TX_PRIO_THRESH and up
+ * (SO_PRIORITY, tc skbedit), everything else goes to the FIFO/queue.
+ * The controller arbitrates all pending buffers by ID, so high priority
+ * frames no longer wait behind the bulk traffic queued in the FIFO.
+ */
+static inline bool mttcan_tx_split(struct ttcan_controller *ttcan)
+{
+	return ttcan->tx_config.ded_buff_num && ttcan->tx_config.fifo_q_num;
+}
+
 static netdev_tx_t mttcan_start_xmit(struct sk_buff *skb,
 				     struct net_device *dev)
 {
@@ -1304,11 +1352,19 @@ static netdev_tx_t mttcan_start_xmit(struct sk_buff *skb,
 	spin_lock_bh(&priv->tx_lock);
 
 	/* Write Tx message to controller */
-	msg_no = ttcan_tx_msg_buffer_write(priv->ttcan,
-			(struct ttcanfd_frame *)frame);
-	if (msg_no < 0)
+	if (!mttcan_tx_split(priv->ttcan)) {
+		msg_no = ttcan_tx_msg_buffer_write(priv->ttcan,
+				(struct ttcanfd_frame *)frame);
+		if (msg_no < 0)
+			msg_no = ttcan_tx_fifo_queue_msg(priv->ttcan,
+					(struct ttcanfd_frame *)frame);
+	} else if (skb->priority >= MTTCAN_TX_PRIO_THRESH) {
+		msg_no = ttcan_tx_msg_buffer_write(priv->ttcan,
+				(struct ttcanfd_frame *)frame);
+	} else {
 		msg_no = ttcan_tx_fifo_queue_msg(priv->ttcan,
 				(struct ttcanfd_frame *)frame);
+	}
 
 	if (msg_no < 0) {
 		netif_stop_queue(dev);
@@ -1443,11 +1499,128 @@ static int mttcan_handle_hwtstamp_get(struct mttcan_priv *priv,
 			sizeof(struct hwtstamp_config)) ? -EFAULT : 0;
 }
 
+static void mttcan_get_fltr(struct mttcan_priv *priv,
+			    struct mttcan_fltr_req *req)
+{
+	u32 elem, f0, f1;
+
+	if (req->xtd) {
+		f0 = *(u32 *)((u8 *)priv->xtd_shadow +
+			      req->idx * XIDF_ELEM_SIZE);
+		f1 = *(u32 *)((u8 *)priv->xtd_shadow +
+			      req->idx * XIDF_ELEM_SIZE + CAN_WORD_IN_BYTES);
+		req->type = (f1 & MTT_XTD_FLTR_F1_EFT_MASK) >>
+			MTT_XTD_FLTR_F1_EFT_SHIFT;
+		req->fec = (f0 & MTT_XTD_FLTR_F0_EFEC_MASK) >>
+			MTT_XTD_FLTR_F0_EFEC_SHIFT;
+		req->id1 = (f0 & MTT_XTD_FLTR_F0_EFID1_MASK) >>
+			MTT_XTD_FLTR_F0_EFID1_SHIFT;
+		req->id2 = (f1 & MTT_XTD_FLTR_F1_EFID2_MASK) >>
+			MTT_XTD_FLTR_F1_EFID2_SHIFT;
+	} else {
+		elem = *(u32 *)((u8 *)priv->std_shadow +
+				req->idx * SIDF_ELEM_SIZE);
+		req->type = (elem & MTT_STD_FLTR_SFT_MASK) >>
+			MTT_STD_FLTR_SFT_SHIFT;
+		req->fec = (elem & MTT_STD_FLTR_SFEC_MASK) >>
+			MTT_STD_FLTR_SFEC_SHIFT;
+		req->id1 = (elem & MTT_STD_FLTR_SFID1_MASK) >>
+			MTT_STD_FLTR_SFID1_SHIFT;
+		req->id2 = (elem & MTT_STD_FLTR_SFID2_MASK) >>
+			MTT_STD_FLTR_SFID2_SHIFT;
+	}
+}
+
+/*
+ * Filter elements live in message RAM and, unlike the list sizes in
+ * SIDFC/XIDFC, can be rewritten while the controller is running. The
+ * lists always span all the DT configured elements, unused ones are
+ * disabled (SFEC/EFEC 0), so no protected register needs to change.
+ * The shadow copies restore them on controller re-init.
+ */
+static int mttcan_handle_fltr_ioctl(struct mttcan_priv *priv,
+				    struct ifreq *ifr)
+{
+	struct ttcan_controller *ttcan = priv->ttcan;
+	struct mttcan_fltr_req req;
+	u32 *fltr_size, list_size, id_mask;
+	int ret = 0;
+
+	if (copy_from_user(&req, ifr->ifr_data, sizeof(req)))
+		return -EFAULT;
+
+	if (req.xtd) {
+		list_size = min_t(u32, ttcan->mram_cfg[MRAM_XIDF].num, 64);
+		fltr_size = &ttcan->fltr_config.xtd_fltr_size;
+		id_mask = CAN_EFF_MASK;
+	} else {
+		list_size = min_t(u32, ttcan->mram_cfg[MRAM_SIDF].num, 128);
+		fltr_size = &ttcan->fltr_config.std_fltr_size;
+		id_mask = CAN_SFF_MASK;
+	}
+
+	if (req.idx >= list_size)
+		return -EINVAL;
+
+	/* array access based on user provided index */
+	speculation_barrier();
+
+	switch (req.cmd) {
+	case MTTCAN_FLTR_GET:
+		mttcan_get_fltr(priv, &req);
+		if (copy_to_user(ifr->ifr_data, &req, sizeof(req)))
+			return -EFAULT;
+		return 0;
+	case MTTCAN_FLTR_SET:
+		if (req.type > 3 || (req.id1 & ~id_mask) ||
+		    (req.id2 & ~id_mask))
+			return -EINVAL;
+		ret = mttcan_check_fec_validity(priv, req.fec);
+		if (ret < 0)
+			return ret;
+		/* id2 is the buffer index, bits 10:9 clear to store frames */
+		if (req.fec == FEC_RXBUF &&
+		    req.id2 >= ttcan->mram_cfg[MRAM_RXB].num)
+			return -EINVAL;
+		break;
+	case MTTCAN_FLTR_CLEAR:
+		req.type = 0;
+		req.fec = 0;
+		req.id1 = 0;
+		req.id2 = 0;
+		break;
+	default:
+		return -EOPNOTSUPP;
+	}
+
+	mttcan_pm_runtime_get_sync(priv);
+	if (req.xtd)
+		ttcan_set_xtd_id_filter(ttcan, priv->xtd_shadow, req.idx,
+					(u8)req.type, (u8)req.fec, req.id1,
+					req.id2);
+	else
+		ttcan_set_std_id_filter(ttcan, priv->std_shadow, req.idx,
+					(u8)req.type, (u8)req.fec, req.id1,
+					req.id2);
+	mttcan_pm_runtime_put_sync(priv);
+
+	if (req.cmd == MTTCAN_FLTR_SET && req.idx >= *fltr_size)
+		*fltr_size = req.idx + 1;
+	else if (req.cmd == MTTCAN_FLTR_CLEAR && req.idx + 1 == *fltr_size)
+		*fltr_size = req.idx;
+
+	return 0;
+}
+
 static int mttcan_ioctl(struct net_device *dev, struct ifreq *ifr, int cmd)
 {
 	struct mttcan_priv *priv = netdev_priv(dev);
 	int ret = 0;
 
+	/* may sleep, runs under RTNL only */
+	if (cmd == MTTCAN_PRV_FLTR_IOCTL)
+		return mttcan_handle_fltr_ioctl(priv, ifr);
+
 	spin_lock(&priv->tslock);
 	switch (cmd) {
 	case SIOCSHWTSTAMP:
@@ -1464,6 +1637,80 @@ static int mttcan_ioctl(struct net_device *dev, struct ifreq *ifr, int cmd)
 	return ret;
 }
 
+static const char * const mttcan_rx_path_names[MTTCAN_RX_PATHS] = {
+	[MTTCAN_RX_FIFO0] = "rxf0",
+	[MTTCAN_RX_FIFO1] = "rxf1",
+	[MTTCAN_RX_BUF] = "rxb",
+};
+
+static const char * const mttcan_rx_stat_names[] = {
+	"frames",
+	"lost",
+	"fill_max",
+	"isr_napi_avg_ns",
+	"isr_napi_max_ns",
+	"napi_sock_avg_ns",
+	"napi_sock_max_ns",
+};
+
+#define MTTCAN_RX_STATS_LEN \
+	(MTTCAN_RX_PATHS * ARRAY_SIZE(mttcan_rx_stat_names))
+
+static int mttcan_get_sset_count(struct net_device *dev, int sset)
+{
+	switch (sset) {
+	case ETH_SS_STATS:
+		return MTTCAN_RX_STATS_LEN;
+	default:
+		return -EOPNOTSUPP;
+	}
+}
+
+static void mttcan_get_strings(struct net_device *dev, u32 sset, u8 *data)
+{
+	int i, j;
+
+	if (sset != ETH_SS_STATS)
+		return;
+
+	for (i = 0; i < MTTCAN_RX_PATHS; i++) {
+		for (j = 0; j < ARRAY_SIZE(mttcan_rx_stat_names); j++) {
+			snprintf(data, ETH_GSTRING_LEN, "%s_%s",
+				 mttcan_rx_path_names[i],
+				 mttcan_rx_stat_names[j]);
+			data += ETH_GSTRING_LEN;
+		}
+	}
+}
+
+static void mttcan_get_ethtool_stats(struct net_device *dev,
+				     struct ethtool_stats *estats, u64 *data)
+{
+	struct mttcan_priv *priv = netdev_priv(dev);
+	struct mttcan_rx_stats *rx_stats;
+	int i;
+
+	for (i = 0; i < MTTCAN_RX_PATHS; i++) {
+		rx_stats = &priv->rx_stats[i];
+		*data++ = rx_stats->frames;
+		*data++ = rx_stats->lost;
+		*data++ = rx_stats->fill_max;
+		*data++ = rx_stats->isr_napi_samples ?
+			div64_u64(rx_stats->isr_napi_ns,
+				  rx_stats->isr_napi_samples) : 0;
+		*data++ = rx_stats->isr_napi_max_ns;
+		*data++ = rx_stats->frames ?
+			div64_u64(rx_stats->napi_sock_ns, rx_stats->frames) : 0;
+		*data++ = rx_stats->napi_sock_max_ns;
+	}
+}
+
+static const struct ethtool_ops mttcan_ethtool_ops = {
+	.get_sset_count = mttcan_get_sset_count,
+	.get_strings = mttcan_get_strings,
+	.get_ethtool_stats = mttcan_get_ethtool_stats,
+};
+
 static const struct net_device_ops mttcan_netdev_ops = {
 	.ndo_open = mttcan_open,
 	.ndo_stop = mttcan_close,
@@ -1477,6 +1724,7 @@ static int register_mttcan_dev(struct net_device *dev)
 	int err;
 
 	dev->netdev_ops = &mttcan_netdev_ops;
+	dev->ethtool_ops = &mttcan_ethtool_ops;
 	err = register_candev(dev);
 	if (!err)
 		devm_can_led_init(dev);
@@ -1765,9 +2013,6 @@ static int mttcan_probe(struct platform_device *pdev)
 	priv->ttcan->mram_base = mesg_ram->start;
 	priv->ttcan->id = priv->instance;
 	priv->ttcan->mram_vbase = mram_addr;
-	INIT_LIST_HEAD(&priv->ttcan->rx_q0);
-	INIT_LIST_HEAD(&priv->ttcan->rx_q1);
-	INIT_LIST_HEAD(&priv->ttcan->rx_b);
 	INIT_LIST_HEAD(&priv->ttcan->tx_evt);
 
 	platform_set_drvdata(pdev, dev);
@@ -16,9 +16,6 @@
 
 #include "m_ttcan.h"
 
-static int mttcan_check_fec_validity(struct mttcan_priv *priv,
-				     unsigned int fec);
-
 static ssize_t show_std_fltr(struct device *dev,
 	struct device_attribute *devattr, char *buf)
 {
@@ -151,8 +148,7 @@ static ssize_t store_xidam(struct device *dev,
 	return count;
 }
 
-static int mttcan_check_fec_validity(struct mttcan_priv *priv,
-				     unsigned int fec)
+int mttcan_check_fec_validity(struct mttcan_priv *priv, unsigned int fec)
 {
 	struct ttcan_controller *ttcan = priv->ttcan;
 
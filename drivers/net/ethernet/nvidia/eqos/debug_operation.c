@@ -21856,6 +21856,45 @@ static const struct file_operations pre_padcal_err_regs_fops = {
 	.read = pre_padcal_err_regs_read,
 };
 
+static ssize_t ring_occupancy_read(struct file *file, char __user *userbuf,
+				   size_t count, loff_t *ppos)
+{
+	char *debug_buf;
+	ssize_t ret;
+	int len = 0;
+	int qinx, i;
+
+	debug_buf = kmalloc(4096, GFP_KERNEL);
+	if (!debug_buf)
+		return -ENOMEM;
+
+	len += scnprintf(debug_buf + len, 4096 - len,
+			 "Descriptors owned by the DMA at NAPI poll, per 1/%d ring\n",
+			 EQOS_RING_OCC_BUCKETS);
+	for (qinx = 0; qinx < EQOS_RX_QUEUE_CNT; qinx++) {
+		len += scnprintf(debug_buf + len, 4096 - len, "rx%d:", qinx);
+		for (i = 0; i < EQOS_RING_OCC_BUCKETS; i++)
+			len += scnprintf(debug_buf + len, 4096 - len, " %lu",
+					 GET_RX_QUEUE_PTR(qinx)->occ_hist[i]);
+		len += scnprintf(debug_buf + len, 4096 - len, "\n");
+	}
+	for (qinx = 0; qinx < EQOS_TX_QUEUE_CNT; qinx++) {
+		len += scnprintf(debug_buf + len, 4096 - len, "tx%d:", qinx);
+		for (i = 0; i < EQOS_RING_OCC_BUCKETS; i++)
+			len += scnprintf(debug_buf + len, 4096 - len, " %lu",
+					 GET_TX_QUEUE_PTR(qinx)->occ_hist[i]);
+		len += scnprintf(debug_buf + len, 4096 - len, "\n");
+	}
+
+	ret = simple_read_from_buffer(userbuf, count, ppos, debug_buf, len);
+	kfree(debug_buf);
+	return ret;
+}
+
+static const struct file_operations ring_occupancy_fops = {
+	.read = ring_occupancy_read,
+};
+
 /*!
 *  \brief  API to create debugfs files
 *
@@ -22668,6 +22707,7 @@ int create_debug_files(void)
 	struct dentry *RX_NORMAL_DESC_STATUS;
 	struct dentry *BCM_REGS;
 	struct dentry *pre_padcal_err_counters;
+	struct dentry *ring_occupancy;
 
 	pr_debug("--> create_debug_files\n");
 
@@ -30004,6 +30044,15 @@ int create_debug_files(void)
 		goto remove_debug_file;
 	}
 
+	ring_occupancy =
+	    debugfs_create_file("ring_occupancy", 744, dir,
+				NULL, &ring_occupancy_fops);
+	if (ring_occupancy == NULL) {
+		pr_info("error creating file: ring_occupancy\n");
+		ret = -ENODEV;
+		goto remove_debug_file;
+	}
+
 	pr_debug("<-- create_debug_files\n");
 
 	return ret;
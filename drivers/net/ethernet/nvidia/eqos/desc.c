@@ -373,50 +373,157 @@ static void eqos_wrapper_tx_descriptor_init_single_q(
 	pr_debug("<--eqos_wrapper_tx_descriptor_init_single_q\n");
 }
 
-static int desc_alloc_skb(struct eqos_prv_data *pdata,
-			  struct rx_swcx_desc *prx_swcx_desc, gfp_t gfp,
-			  unsigned int qinx)
+/*
+ * RX buffers are carved out of pages that stay DMA mapped for as long as
+ * they are in the ring. A received buffer is handed to the stack with
+ * build_skb(), and when frames fit in half a page the page is split in
+ * two buffers: the ring keeps using the other half and gets the first
+ * one back once the stack has freed it, so the steady state needs
+ * neither allocation nor mapping.
+ */
+static void eqos_rx_buf_config(struct eqos_prv_data *pdata)
 {
-	struct sk_buff *skb = prx_swcx_desc->skb;
-	dma_addr_t dma = prx_swcx_desc->dma;
+	unsigned int truesize;
 
-	if (skb) {
-		/* Recycled skbs should have zero length and their buffer
-		 * still DMA mapped.
-		 */
-		if (WARN_ON(skb->len != 0))
-			skb_trim(skb, 0);
-		if (WARN_ON(!dma))
-			goto dma_map;
+	/* same rounding as the DMA_RCR RBSZ programming */
+	pdata->rx_buf_size = ALIGN(pdata->rx_max_frame_size, AXI_BUS_WIDTH);
 
-		return 0;
+	truesize = SKB_DATA_ALIGN(EQOS_RX_HEADROOM + pdata->rx_buf_size) +
+		   SKB_DATA_ALIGN(sizeof(struct skb_shared_info));
+
+	if (truesize <= PAGE_SIZE / 2) {
+		pdata->rx_page_order = 0;
+		pdata->rx_page_split = true;
+		pdata->rx_buf_truesize = PAGE_SIZE / 2;
+	} else {
+		pdata->rx_page_order = get_order(truesize);
+		pdata->rx_page_split = false;
+		pdata->rx_buf_truesize = PAGE_SIZE << pdata->rx_page_order;
+	}
+}
+
+static void desc_unmap_rx_page(struct eqos_prv_data *pdata,
+			       struct rx_swcx_desc *prx_swcx_desc)
+{
+	/*
+	 * The other half of a split page can still be in use by the stack,
+	 * which must not see its cache lines invalidated.
+	 */
+	dma_unmap_single_attrs(&pdata->pdev->dev, prx_swcx_desc->page_dma,
+			       PAGE_SIZE << pdata->rx_page_order,
+			       DMA_FROM_DEVICE, DMA_ATTR_SKIP_CPU_SYNC);
+
+	prx_swcx_desc->page = NULL;
+	prx_swcx_desc->page_dma = 0;
+}
+
+static void desc_free_rx_page(struct eqos_prv_data *pdata,
+			      struct rx_swcx_desc *prx_swcx_desc)
+{
+	struct page *page = prx_swcx_desc->page;
+
+	desc_unmap_rx_page(pdata, prx_swcx_desc);
+	put_page(page);
+}
+
+static int desc_alloc_rx_page(struct eqos_prv_data *pdata,
+			      struct rx_swcx_desc *prx_swcx_desc, gfp_t gfp,
+			      unsigned int qinx)
+{
+	struct page *page = prx_swcx_desc->page;
+	dma_addr_t dma;
+
+	if (page) {
+		/* Recycled pages are still DMA mapped, only give the
+		 * buffer back to the device.
+		 */
+		dma_sync_single_range_for_device(&pdata->pdev->dev,
+				prx_swcx_desc->page_dma,
+				prx_swcx_desc->page_offset + EQOS_RX_HEADROOM,
+				pdata->rx_buf_size, DMA_FROM_DEVICE);
+		goto set_buf;
 	}
 
-	skb = __netdev_alloc_skb_ip_align(pdata->dev, pdata->rx_buffer_len,
-					  gfp);
-	if (unlikely(!skb)) {
-		netdev_err(pdata->dev, "RX skb allocation failed, using reserved buffer\n");
+	page = __dev_alloc_pages(gfp, pdata->rx_page_order);
+	if (unlikely(!page)) {
+		netdev_err(pdata->dev, "RX page allocation failed, using reserved buffer\n");
 		prx_swcx_desc->skb = pdata->resv_skb;
 		prx_swcx_desc->dma = pdata->resv_dma;
 		pdata->xstats.q_re_alloc_rx_buf_failed[qinx]++;
 		return 0;
 	}
 
-dma_map:
-	dma = dma_map_single(&pdata->pdev->dev, skb->data, pdata->rx_buffer_len,
+	dma = dma_map_single(&pdata->pdev->dev, page_address(page),
+			     PAGE_SIZE << pdata->rx_page_order,
 			     DMA_FROM_DEVICE);
 	if (unlikely(dma_mapping_error(&pdata->pdev->dev, dma))) {
-		netdev_err(pdata->dev, "RX skb dma map failed\n");
-		dev_kfree_skb_any(skb);
+		netdev_err(pdata->dev, "RX page dma map failed\n");
+		__free_pages(page, pdata->rx_page_order);
 		return -ENOMEM;
 	}
 
-	prx_swcx_desc->skb = skb;
-	prx_swcx_desc->dma = dma;
+	prx_swcx_desc->page = page;
+	prx_swcx_desc->page_dma = dma;
+	prx_swcx_desc->page_offset = 0;
+
+set_buf:
+	prx_swcx_desc->skb = NULL;
+	prx_swcx_desc->dma = prx_swcx_desc->page_dma +
+			     prx_swcx_desc->page_offset + EQOS_RX_HEADROOM;
 
 	return 0;
 }
 
+/*!
+ * \details This function is invoked when a received buffer is passed to the
+ * stack. It builds the skb around the buffer and decides whether the page
+ * can stay in the ring.
+ *
+ * The frame must already be synced for the CPU.
+ *
+ * \param[in] pdata – pointer to private device structure.
+ * \param[in] prx_swcx_desc – pointer to rx wrapper buffer structure.
+ * \param[in] headroom – offset of the frame in the buffer.
+ * \param[in] pkt_len – length of the frame.
+ *
+ * \return skb on success, NULL when no skb could be allocated. The buffer
+ * then stays in the ring.
+ */
+
+static struct sk_buff *eqos_rx_build_skb(struct eqos_prv_data *pdata,
+					 struct rx_swcx_desc *prx_swcx_desc,
+					 unsigned int headroom,
+					 unsigned int pkt_len)
+{
+	struct page *page = prx_swcx_desc->page;
+	void *va = page_address(page) + prx_swcx_desc->page_offset;
+	struct sk_buff *skb;
+
+	skb = build_skb(va, pdata->rx_buf_truesize);
+	if (unlikely(!skb))
+		return NULL;
+
+	skb_reserve(skb, headroom);
+	skb_put(skb, pkt_len);
+
+	/*
+	 * The skb owns the page reference of the ring now. If it is the
+	 * only one left, the other half is back from the stack and the
+	 * ring takes a new reference to keep using it.
+	 */
+	if (pdata->rx_page_split && page_count(page) == 1 &&
+	    !page_is_pfmemalloc(page) && page_to_nid(page) == numa_mem_id()) {
+		prx_swcx_desc->page_offset ^= pdata->rx_buf_truesize;
+		page_ref_inc(page);
+	} else {
+		/* the page leaves the ring with the skb */
+		desc_unmap_rx_page(pdata, prx_swcx_desc);
+	}
+	prx_swcx_desc->dma = 0;
+
+	return skb;
+}
+
 /*!
 * \brief API to initialize the receive descriptors.
 *
@@ -454,8 +561,8 @@ static void eqos_wrapper_rx_descriptor_init_single_q(
 		    (desc_dma + sizeof(struct s_rx_desc) * i);
 		GET_RX_BUF_PTR(qinx, i) = &prx_swcx_desc[i];
 
-		ret = desc_alloc_skb(pdata, GET_RX_BUF_PTR(qinx, i),
-				     GFP_KERNEL, qinx);
+		ret = desc_alloc_rx_page(pdata, GET_RX_BUF_PTR(qinx, i),
+					 GFP_KERNEL, qinx);
 		if (ret < 0)
 			break;
 	}
@@ -489,6 +596,8 @@ static void eqos_wrapper_rx_descriptor_init(struct eqos_prv_data *pdata)
 	unsigned int qinx;
 
 	pr_debug("-->eqos_wrapper_rx_descriptor_init\n");
+	eqos_rx_buf_config(pdata);
+
 	pdata->resv_skb = __netdev_alloc_skb_ip_align(pdata->dev,
 						      pdata->rx_buffer_len,
 						      GFP_KERNEL);
@@ -585,6 +694,7 @@ static void eqos_tx_skb_free_mem_single_q(struct eqos_prv_data *pdata,
 
 		INCR_TX_DESC_INDEX(ptx_ring->dirty_tx, 1);
 	}
+	netdev_tx_reset_queue(netdev_get_tx_queue(pdata->dev, qinx));
 	pr_debug("<--%s()\n", __func__);
 }
 
@@ -914,8 +1024,12 @@ static int tx_swcx_alloc(struct net_device *dev, struct sk_buff *skb)
 	TX_PKT_FEATURES_PKT_ATTRIBUTES_VLAN_PKT_RD(
 		ppkt_opts->pkt_attributes, is_pkt_vlan);
 
-	if ((is_pkt_vlan) ||
-	    (is_pkt_tso)) {
+	/* The MSS programmed by a context descriptor is kept by the channel
+	 * for the following TSO packets, so a new one is only needed when it
+	 * changes. pre_transmit() makes the same decision.
+	 */
+	if (is_pkt_vlan ||
+	    (is_pkt_tso && ppkt_opts->mss != ptx_ring->default_mss)) {
 		ptx_swcx = GET_TX_BUF_PTR(qinx, idx);
 		if (ptx_swcx->len)
 			goto tx_swcx_alloc_failed;
@@ -1075,22 +1189,11 @@ static void eqos_unmap_rx_skb(struct eqos_prv_data *pdata,
 {
 	pr_debug("-->eqos_unmap_rx_skb\n");
 
-	/* unmap the first buffer */
-	if (prx_swcx_desc->dma) {
-		if (pdata->resv_dma != prx_swcx_desc->dma) {
-			dma_unmap_single(&pdata->pdev->dev, prx_swcx_desc->dma,
-					 pdata->rx_buffer_len,
-					 DMA_FROM_DEVICE);
-		}
-		prx_swcx_desc->dma = 0;
-	}
+	if (prx_swcx_desc->page)
+		desc_free_rx_page(pdata, prx_swcx_desc);
 
-	if (prx_swcx_desc->skb) {
-		if (pdata->resv_skb != prx_swcx_desc->skb) {
-			dev_kfree_skb_any(prx_swcx_desc->skb);
-		}
-		prx_swcx_desc->skb = NULL;
-	}
+	prx_swcx_desc->dma = 0;
+	prx_swcx_desc->skb = NULL;
 
 	pr_debug("<--eqos_unmap_rx_skb\n");
 }
@@ -1119,11 +1222,17 @@ static void eqos_re_alloc_skb(struct eqos_prv_data *pdata,
 	while (prx_ring->dirty_rx != prx_ring->cur_rx) {
 		prx_swcx_desc = GET_RX_BUF_PTR(qinx, prx_ring->dirty_rx);
 
-		ret = desc_alloc_skb(pdata, prx_swcx_desc, GFP_ATOMIC, qinx);
+		ret = desc_alloc_rx_page(pdata, prx_swcx_desc, GFP_ATOMIC,
+					 qinx);
 		if (ret < 0) {
 			break;
 		}
 
+		/* same IOC pattern as rx_descriptor_init(), the frame
+		 * count can change at runtime with dynamic moderation
+		 */
+		prx_swcx_desc->inte = !prx_ring->use_riwt ||
+			!(prx_ring->dirty_rx % prx_ring->rx_coal_frames);
 		hw_if->rx_desc_reset(prx_ring->dirty_rx, pdata,
 				     prx_swcx_desc->inte, qinx);
 		INCR_RX_DESC_INDEX(prx_ring->dirty_rx, 1);
@@ -1162,6 +1271,7 @@ void eqos_init_function_ptrs_desc(struct desc_if_struct *desc_if)
 	desc_if->free_buff_and_desc = free_buffer_and_desc;
 	desc_if->realloc_skb = eqos_re_alloc_skb;
 	desc_if->unmap_rx_skb = eqos_unmap_rx_skb;
+	desc_if->rx_build_skb = eqos_rx_build_skb;
 	desc_if->tx_swcx_free = tx_swcx_free;
 	desc_if->tx_swcx_alloc = tx_swcx_alloc;
 	desc_if->tx_free_mem = eqos_tx_free_mem;
@@ -1475,6 +1475,32 @@ static VOID config_ptp_channel(UINT ptp_ch_id, UINT addr_index)
 	DBGPR_FILTER("<--config_ptp_channel\n");
 }
 
+/*!
+* \brief This sequence is used to steer the packets matching a MAC address
+* filter register to a DMA channel
+* \param[in] chan - DMA channel
+* \param[in] addr_index - index of the MAC address filter register
+* \return void
+*/
+
+static VOID config_rx_flow_channel(UINT chan, UINT addr_index)
+{
+	u32 dynamic_map_on;
+
+	/* unicast addresses end up in Q0, multicast ones in Q1 */
+	MTL_RQDCM0R_RXQ0DADMACH_RD(dynamic_map_on);
+	if (!dynamic_map_on)
+		MTL_RQDCM0R_RXQ0DADMACH_WR(0x1);
+	MTL_RQDCM0R_RXQ1DADMACH_RD(dynamic_map_on);
+	if (!dynamic_map_on)
+		MTL_RQDCM0R_RXQ1DADMACH_WR(0x1);
+
+	if (addr_index < 32)
+		MAC_MA1_31HR_DCS_WR(addr_index, chan);
+	else
+		MAC_MA32_127HR_DCS_WR(addr_index, chan);
+}
+
 static VOID configure_reg_vlan_control(struct tx_ring
 				       *ptx_ring)
 {
@@ -2856,7 +2882,9 @@ static void pre_transmit(struct eqos_prv_data *pdata, UINT qinx)
 	TX_PKT_FEATURES_PKT_ATTRIBUTES_TSO_ENABLE_RD(tx_pkt_features->
 						     pkt_attributes,
 						     vartso_enable);
-	if (varvlan_pkt || vartso_enable) {
+	/* the MSS sticks to the channel, see tx_swcx_alloc() */
+	if (varvlan_pkt ||
+	    (vartso_enable && tx_pkt_features->mss != ptx_ring->default_mss)) {
 		TX_CONTEXT_DESC_TDES3_CTXT_WR(TX_CONTEXT_DESC->tdes3, 0x1);
 
 		if (varvlan_pkt) {
@@ -3038,10 +3066,8 @@ static void pre_transmit(struct eqos_prv_data *pdata, UINT qinx)
 		     1, qinx);
 #endif
 
-	/* issue a poll command to Tx DMA by writing address
-	 * of next immediate free descriptor */
-	wmb();
-	DMA_TDTP_TPDR_WR(qinx, GET_TX_DESC_DMA_ADDR(qinx, cur_index));
+	/* the Tx DMA is kicked by the caller through update_tx_tail_ptr,
+	 * possibly once for several packets */
 	ptx_ring->cur_tx = cur_index;
 
 	if (pdata->eee_enabled) {
@@ -3058,6 +3084,13 @@ static void update_rx_tail_ptr(unsigned int qinx, unsigned int dma_addr)
 	DMA_RDTP_RPDR_WR(qinx, dma_addr);
 }
 
+static void update_tx_tail_ptr(unsigned int qinx, unsigned int dma_addr)
+{
+	/* descriptors must be visible before the poll demand */
+	wmb();
+	DMA_TDTP_TPDR_WR(qinx, dma_addr);
+}
+
 /*!
 * \brief This sequence is used to check whether CTXT bit is
 * set or not returns 1 if CTXT is set else returns zero
@@ -3948,6 +3981,7 @@ void eqos_init_function_ptrs_dev(struct hw_if_struct *hw_if)
 	hw_if->get_tx_desc_ls = get_tx_descriptor_last;
 	hw_if->get_tx_desc_ctxt = get_tx_descriptor_ctxt;
 	hw_if->update_rx_tail_ptr = update_rx_tail_ptr;
+	hw_if->update_tx_tail_ptr = update_tx_tail_ptr;
 
 	/* for FLOW ctrl */
 	hw_if->enable_rx_flow_ctrl = enable_rx_flow_ctrl;
@@ -4097,6 +4131,7 @@ void eqos_init_function_ptrs_dev(struct hw_if_struct *hw_if)
 
 	/*for PTP channel routingi */
 	hw_if->config_ptp_channel = config_ptp_channel;
+	hw_if->config_rx_flow_channel = config_rx_flow_channel;
 
 	pr_debug("<--eqos_init_function_ptrs_dev\n");
 }
@@ -0,0 +1,336 @@
+/*
+ * Copyright (c) 2021, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ */
+/*!@file: dim.c
+ * @brief: Dynamic interrupt moderation of the DMA channels.
+ *
+ * Each channel samples its packet, byte and interrupt rates every
+ * EQOS_DIM_NEVENTS interrupts and walks a table of moderation levels,
+ * keeping the direction while the rates improve and turning around when
+ * they get worse, in the spirit of net_dim. Sparse traffic, like PTP or
+ * control messages, always goes back to the lowest level so that it is
+ * not delayed by the moderation.
+ */
+#include "yheader.h"
+
+/* interrupts between two samples */
+#define EQOS_DIM_NEVENTS		64
+/* below this many packets per msec, moderation is not worth the latency */
+#define EQOS_DIM_SPARSE_PPMS		8
+/* rates within 10% of the previous sample are considered the same */
+#define EQOS_DIM_SIGNIFICANT(cur, prev)	\
+	((cur) > (prev) + (prev) / 10 || (cur) + (prev) / 10 < (prev))
+
+struct eqos_dim_profile {
+	unsigned int usecs;
+	unsigned int frames;
+};
+
+/* RX watchdog time and frames per interrupt */
+static const struct eqos_dim_profile eqos_dim_rx_profile[EQOS_DIM_NLEVELS] = {
+	{ 2, 1 },
+	{ 8, 4 },
+	{ 32, 8 },
+	{ 64, 16 },
+	{ 124, 32 },
+};
+
+/* TX completion timer and frames per interrupt */
+static const struct eqos_dim_profile eqos_dim_tx_profile[EQOS_DIM_NLEVELS] = {
+	{ EQOS_MIN_TX_COALESCE_USEC, 1 },
+	{ 64, 4 },
+	{ 128, 8 },
+	{ 256, 16 },
+	{ 512, 32 },
+};
+
+enum {
+	EQOS_DIM_WORSE,
+	EQOS_DIM_SAME,
+	EQOS_DIM_BETTER,
+};
+
+static int eqos_dim_compare(struct eqos_dim *dim, u32 bpms, u32 ppms,
+			    u32 epms)
+{
+	/* more data moved is better */
+	if (EQOS_DIM_SIGNIFICANT(bpms, dim->prev_bpms))
+		return bpms > dim->prev_bpms ? EQOS_DIM_BETTER : EQOS_DIM_WORSE;
+
+	if (EQOS_DIM_SIGNIFICANT(ppms, dim->prev_ppms))
+		return ppms > dim->prev_ppms ? EQOS_DIM_BETTER : EQOS_DIM_WORSE;
+
+	/* and the same with fewer interrupts too */
+	if (EQOS_DIM_SIGNIFICANT(epms, dim->prev_epms))
+		return epms < dim->prev_epms ? EQOS_DIM_BETTER : EQOS_DIM_WORSE;
+
+	return EQOS_DIM_SAME;
+}
+
+static void eqos_dim_step(struct eqos_dim *dim)
+{
+	int level = dim->level + dim->dir;
+
+	if (level < 0 || level >= EQOS_DIM_NLEVELS) {
+		/* at the end of the table, try the other way next */
+		dim->dir = -dim->dir;
+		return;
+	}
+
+	dim->level = level;
+}
+
+/*
+ * Returns true if the moderation level of the channel changed and
+ * needs to be applied.
+ */
+static bool eqos_dim_update(struct eqos_dim *dim)
+{
+	ktime_t now = ktime_get();
+	u32 bpms, ppms, epms;
+	u8 old_level = dim->level;
+	s64 usecs;
+
+	if (++dim->events < EQOS_DIM_NEVENTS)
+		return false;
+
+	usecs = ktime_us_delta(now, dim->start_time);
+	if (usecs <= 0)
+		return false;
+
+	bpms = div64_u64(dim->bytes * USEC_PER_MSEC, usecs);
+	ppms = div64_u64(dim->pkts * USEC_PER_MSEC, usecs);
+	epms = div64_u64((u64)dim->events * USEC_PER_MSEC, usecs);
+
+	if (ppms < EQOS_DIM_SPARSE_PPMS) {
+		dim->level = 0;
+		dim->dir = 1;
+		dim->parked = false;
+	} else {
+		switch (eqos_dim_compare(dim, bpms, ppms, epms)) {
+		case EQOS_DIM_WORSE:
+			dim->dir = -dim->dir;
+			/* fall through */
+		case EQOS_DIM_BETTER:
+			dim->parked = false;
+			eqos_dim_step(dim);
+			break;
+		case EQOS_DIM_SAME:
+			/* settle until the load changes */
+			if (!dim->parked) {
+				dim->parked = true;
+				eqos_dim_step(dim);
+			}
+			break;
+		}
+	}
+
+	dim->prev_bpms = bpms;
+	dim->prev_ppms = ppms;
+	dim->prev_epms = epms;
+
+	dim->start_time = now;
+	dim->events = 0;
+	dim->pkts = 0;
+	dim->bytes = 0;
+
+	return dim->level != old_level;
+}
+
+static void eqos_dim_reset(struct eqos_dim *dim)
+{
+	dim->level = 0;
+	dim->dir = 1;
+	dim->parked = false;
+	dim->events = 0;
+	dim->pkts = 0;
+	dim->bytes = 0;
+	dim->prev_bpms = 0;
+	dim->prev_ppms = 0;
+	dim->prev_epms = 0;
+	dim->start_time = ktime_get();
+}
+
+static void eqos_dim_set_rx_level(struct eqos_prv_data *pdata, UINT qinx)
+{
+	struct eqos_rx_queue *rx_queue = GET_RX_QUEUE_PTR(qinx);
+	struct rx_ring *prx_ring = GET_RX_WRAPPER_DESC(qinx);
+	const struct eqos_dim_profile *profile =
+		&eqos_dim_rx_profile[rx_queue->dim.level];
+	struct hw_if_struct *hw_if = &pdata->hw_if;
+
+	/*
+	 * The watchdog stays armed on every level: descriptors refilled
+	 * before a change keep their IOC setting and rely on it.
+	 */
+	prx_ring->use_riwt = EQOS_COAELSCING_ENABLE;
+	prx_ring->rx_riwt = max_t(u32, eqos_usec2riwt(profile->usecs, pdata),
+				  1);
+	prx_ring->rx_coal_frames = profile->frames;
+	/* applied by configure_dma_channel() otherwise */
+	if (netif_running(pdata->dev))
+		hw_if->config_rx_watchdog(qinx, prx_ring->rx_riwt);
+
+	pdata->xstats.q_rx_dim_level[qinx] = rx_queue->dim.level;
+}
+
+static void eqos_dim_set_tx_level(struct eqos_prv_data *pdata, UINT qinx)
+{
+	struct eqos_tx_queue *tx_queue = GET_TX_QUEUE_PTR(qinx);
+	struct tx_ring *ptx_ring = GET_TX_WRAPPER_DESC(qinx);
+	const struct eqos_dim_profile *profile =
+		&eqos_dim_tx_profile[tx_queue->dim.level];
+
+	/*
+	 * The completion timer stays armed on every level, for the
+	 * frames queued without IOC before a change.
+	 */
+	ptx_ring->tx_usecs = profile->usecs;
+	ptx_ring->tx_coal_frames = profile->frames;
+	ptx_ring->use_tx_usecs = EQOS_COAELSCING_ENABLE;
+	ptx_ring->use_tx_frames = EQOS_COAELSCING_ENABLE;
+
+	pdata->xstats.q_tx_dim_level[qinx] = tx_queue->dim.level;
+}
+
+/*!
+ * \details Called from RX NAPI when interrupts of the channel get
+ * re-enabled, i.e. once per interrupt.
+ *
+ * \param[in] pdata – pointer to private data structure.
+ * \param[in] qinx – DMA channel.
+ *
+ * \return void
+ */
+void eqos_dim_rx_event(struct eqos_prv_data *pdata, UINT qinx)
+{
+	struct eqos_rx_queue *rx_queue = GET_RX_QUEUE_PTR(qinx);
+
+	if (!pdata->rx_dim_enabled)
+		return;
+
+	if (eqos_dim_update(&rx_queue->dim)) {
+		eqos_dim_set_rx_level(pdata, qinx);
+		pdata->xstats.rx_dim_changes_n++;
+	}
+}
+
+/*!
+ * \details Called from TX NAPI when interrupts of the channel get
+ * re-enabled, i.e. once per interrupt.
+ *
+ * \param[in] pdata – pointer to private data structure.
+ * \param[in] qinx – DMA channel.
+ *
+ * \return void
+ */
+void eqos_dim_tx_event(struct eqos_prv_data *pdata, UINT qinx)
+{
+	struct eqos_tx_queue *tx_queue = GET_TX_QUEUE_PTR(qinx);
+
+	if (!pdata->tx_dim_enabled)
+		return;
+
+	if (eqos_dim_update(&tx_queue->dim)) {
+		eqos_dim_set_tx_level(pdata, qinx);
+		pdata->xstats.tx_dim_changes_n++;
+	}
+}
+
+/*!
+ * \details Enables or disables dynamic moderation of the RX channels.
+ * When disabled, the static ethtool/DT coalescing parameters are restored.
+ *
+ * \param[in] pdata – pointer to private data structure.
+ * \param[in] enable – new state.
+ *
+ * \return void
+ */
+void eqos_dim_rx_enable(struct eqos_prv_data *pdata, bool enable)
+{
+	struct hw_if_struct *hw_if = &pdata->hw_if;
+	struct rx_ring *prx_ring;
+	UINT qinx;
+
+	if (pdata->rx_dim_enabled == enable)
+		return;
+
+	for (qinx = 0; qinx < EQOS_RX_QUEUE_CNT; qinx++) {
+		struct eqos_rx_queue *rx_queue = GET_RX_QUEUE_PTR(qinx);
+
+		prx_ring = GET_RX_WRAPPER_DESC(qinx);
+		if (enable) {
+			rx_queue->dim_saved_use_riwt = prx_ring->use_riwt;
+			rx_queue->dim_saved_riwt = prx_ring->rx_riwt;
+			rx_queue->dim_saved_frames = prx_ring->rx_coal_frames;
+
+			eqos_dim_reset(&rx_queue->dim);
+			eqos_dim_set_rx_level(pdata, qinx);
+		} else {
+			prx_ring->use_riwt = rx_queue->dim_saved_use_riwt;
+			prx_ring->rx_riwt = rx_queue->dim_saved_riwt;
+			prx_ring->rx_coal_frames = rx_queue->dim_saved_frames;
+
+			/* keep the watchdog for descriptors without IOC */
+			if (netif_running(pdata->dev))
+				hw_if->config_rx_watchdog(qinx,
+					prx_ring->use_riwt ?
+					prx_ring->rx_riwt : 1);
+			pdata->xstats.q_rx_dim_level[qinx] = 0;
+		}
+	}
+
+	pdata->rx_dim_enabled = enable;
+}
+
+/*!
+ * \details Enables or disables dynamic moderation of the TX channels.
+ * When disabled, the static ethtool/DT coalescing parameters are restored.
+ *
+ * \param[in] pdata – pointer to private data structure.
+ * \param[in] enable – new state.
+ *
+ * \return void
+ */
+void eqos_dim_tx_enable(struct eqos_prv_data *pdata, bool enable)
+{
+	struct tx_ring *ptx_ring;
+	UINT qinx;
+
+	if (pdata->tx_dim_enabled == enable)
+		return;
+
+	for (qinx = 0; qinx < EQOS_TX_QUEUE_CNT; qinx++) {
+		struct eqos_tx_queue *tx_queue = GET_TX_QUEUE_PTR(qinx);
+
+		ptx_ring = GET_TX_WRAPPER_DESC(qinx);
+		if (enable) {
+			tx_queue->dim_saved_use_usecs = ptx_ring->use_tx_usecs;
+			tx_queue->dim_saved_use_frames =
+				ptx_ring->use_tx_frames;
+			tx_queue->dim_saved_usecs = ptx_ring->tx_usecs;
+			tx_queue->dim_saved_frames = ptx_ring->tx_coal_frames;
+
+			eqos_dim_reset(&tx_queue->dim);
+			eqos_dim_set_tx_level(pdata, qinx);
+		} else {
+			ptx_ring->use_tx_usecs = tx_queue->dim_saved_use_usecs;
+			ptx_ring->use_tx_frames =
+				tx_queue->dim_saved_use_frames;
+			ptx_ring->tx_usecs = tx_queue->dim_saved_usecs;
+			ptx_ring->tx_coal_frames = tx_queue->dim_saved_frames;
+			pdata->xstats.q_tx_dim_level[qinx] = 0;
+		}
+	}
+
+	pdata->tx_dim_enabled = enable;
+}
@@ -60,9 +60,6 @@ extern ULONG eqos_base_addr;
 
 static INT eqos_status;
 
-/* raw spinlock to get HW PTP time and kernel time atomically */
-static DEFINE_RAW_SPINLOCK(eqos_ts_lock);
-
 /* SA(Source Address) operations on TX */
 unsigned char mac_addr0[6] = { 0x00, 0x11, 0x22, 0x33, 0x44, 0x55 };
 unsigned char mac_addr1[6] = { 0x00, 0x66, 0x77, 0x88, 0x99, 0xaa };
@@ -88,15 +85,9 @@ MODULE_PARM_DESC(q_op_mode,
 u64 eqos_get_ptptime(void *data)
 {
 	struct eqos_prv_data *pdata = data;
-	struct hw_if_struct *hw_if = &pdata->hw_if;
-	unsigned long flags;
 	u64 ns;
 
-	raw_spin_lock_irqsave(&pdata->ptp_lock, flags);
-
-	ns = hw_if->get_systime();
-
-	raw_spin_unlock_irqrestore(&pdata->ptp_lock, flags);
+	ns = eqos_ptp_read_time(pdata);
 
 	return ns;
 }
@@ -1027,9 +1018,11 @@ void free_txrx_irqs(struct eqos_prv_data *pdata)
 
 	for (i = 0; i < pdata->num_chans; i++) {
 		if (pdata->rx_irq_alloc_mask & (1 << i)) {
+			irq_set_affinity_hint(pdata->rx_irqs[i], NULL);
 			free_irq(pdata->rx_irqs[i], &pdata->rx_queue[i]);
 		}
 		if (pdata->tx_irq_alloc_mask & (1 << i)) {
+			irq_set_affinity_hint(pdata->tx_irqs[i], NULL);
 			free_irq(pdata->tx_irqs[i], &pdata->tx_queue[i]);
 		}
 	}
@@ -1041,6 +1034,7 @@ int request_txrx_irqs(struct eqos_prv_data *pdata)
 {
 	struct platform_device *pdev = pdata->pdev;
 	int ret = 0, i, j = 0;
+	unsigned int cpu;
 
 	pdata->irq_number = pdata->dev->irq;
 
@@ -1076,6 +1070,11 @@ int request_txrx_irqs(struct eqos_prv_data *pdata)
 		}
 
 		pdata->tx_irq_alloc_mask |= (1 << i);
+
+		/* spread the channels, Rx and Tx of a channel share a CPU */
+		cpu = cpumask_local_spread(i, dev_to_node(&pdev->dev));
+		irq_set_affinity_hint(pdata->rx_irqs[i], cpumask_of(cpu));
+		irq_set_affinity_hint(pdata->tx_irqs[i], cpumask_of(cpu));
 	}
 
 	return ret;
@@ -1270,6 +1269,44 @@ static int eqos_close(struct net_device *dev)
 	return Y_SUCCESS;
 }
 
+/*!
+* \brief API to steer the packets of a MAC address filter register
+*
+* \details Programs the DMA channel of an ethtool flow steering rule
+* matching the address, or the channel the MTL queue of the address is
+* statically mapped to otherwise, as the register may hold the channel of
+* a rule that was deleted since.
+*
+* \param[in] pdata - pointer to private data structure.
+* \param[in] addr - address programmed in the register.
+* \param[in] addr_index - index of the register.
+*
+* \return void
+*/
+static void eqos_config_rx_flow(struct eqos_prv_data *pdata, u8 *addr,
+				unsigned int addr_index)
+{
+	struct hw_if_struct *hw_if = &pdata->hw_if;
+	unsigned int chan;
+	int i;
+
+	if (!pdata->dt_cfg.use_multi_q)
+		return;
+
+	/* MTL Rx Q1 takes the multicast traffic, see configure_mac() */
+	chan = is_multicast_ether_addr(addr) ? 1 : 0;
+
+	for (i = 0; i < EQOS_MAX_RX_FLOWS; i++) {
+		if (pdata->rx_flows[i].used &&
+		    ether_addr_equal(pdata->rx_flows[i].addr, addr)) {
+			chan = pdata->rx_flows[i].chan;
+			break;
+		}
+	}
+
+	hw_if->config_rx_flow_channel(chan, addr_index);
+}
+
 /*!
 * \brief API to configure the multicast address in device.
 *
@@ -1390,6 +1427,8 @@ static int eqos_prepare_mc_list(struct net_device *dev,
 									  ha->
 									  addr);
 
+			eqos_config_rx_flow(pdata, ha->addr, i);
+
 			if ((pdata->ptp_cfg.use_tagged_ptp) &&
 			    (is_ptp_addr(ha->addr)) &&
 			    pdata->dt_cfg.use_multi_q)
@@ -1516,6 +1555,7 @@ static int eqos_prepare_uc_list(struct net_device *dev,
 				hw_if->update_mac_addr32_127_low_high_reg(i,
 									  ha->
 									  addr);
+			eqos_config_rx_flow(pdata, ha->addr, i);
 			i++;
 		}
 
@@ -1659,6 +1699,7 @@ static int eqos_start_xmit(struct sk_buff *skb, struct net_device *dev)
 	struct desc_if_struct *desc_if = &pdata->desc_if;
 	struct hw_if_struct *hw_if = &pdata->hw_if;
 	INT retval = NETDEV_TX_OK;
+	bool xmit_more = skb->xmit_more;
 	int cnt = 0;
 	int tso;
 	unsigned long timer_val;
@@ -1732,6 +1773,7 @@ static int eqos_start_xmit(struct sk_buff *skb, struct net_device *dev)
 	if (cnt <= 0) {
 		if (cnt == 0) {
 			netif_stop_subqueue(dev, qinx);
+			pdata->xstats.q_tx_ring_full_n[qinx]++;
 			netdev_err(dev, "%s(): TX ring full for queue %d\n",
 				   __func__, qinx);
 			retval = NETDEV_TX_BUSY;
@@ -1757,6 +1799,8 @@ static int eqos_start_xmit(struct sk_buff *skb, struct net_device *dev)
 	if ((pdata->hw_feat.tsstssel == 0) || (pdata->hwts_tx_en == 0))
 		skb_tx_timestamp(skb);
 
+	netdev_tx_sent_queue(txq, skb->len);
+
 	/* configure required descriptor fields for transmission */
 	hw_if->pre_xmit(pdata, qinx);
 
@@ -1765,6 +1809,7 @@ static int eqos_start_xmit(struct sk_buff *skb, struct net_device *dev)
 	 */
 	if (eqos_tx_avail(ptx_ring) <= EQOS_TX_DESC_THRESHOLD) {
 		netif_stop_subqueue(dev, qinx);
+		pdata->xstats.q_tx_ring_full_n[qinx]++;
 		netdev_dbg(dev, "%s(): Stopping TX ring %d\n", __func__, qinx);
 	}
 
@@ -1779,6 +1824,14 @@ static int eqos_start_xmit(struct sk_buff *skb, struct net_device *dev)
 	}
 
 tx_netdev_return:
+	/* Kick the Tx DMA once for a batch of packets from the stack. This
+	 * also covers the packets queued before one that was dropped or the
+	 * queue being stopped, when no more packets follow.
+	 */
+	if (!xmit_more || netif_xmit_stopped(txq))
+		hw_if->update_tx_tail_ptr(qinx,
+				GET_TX_DESC_DMA_ADDR(qinx, ptx_ring->cur_tx));
+
 	return retval;
 }
 
@@ -2033,6 +2086,8 @@ static int process_tx_completions(struct eqos_tx_queue *tx_queue, int budget)
 	struct s_tx_desc *ptx_desc = NULL;
 	int entry = ptx_ring->dirty_tx;
 	unsigned int tstamp_taken = 0;
+	unsigned int bytes_compl = 0;
+	struct sk_buff *skb;
 	int err_incremented;
 	int processed = 0;
 
@@ -2136,7 +2191,14 @@ static int process_tx_completions(struct eqos_tx_queue *tx_queue, int budget)
 				dev->stats.tx_bytes += VLAN_HLEN;
 		}
 
+		/* free the skb in bulk with the NAPI skb cache */
+		skb = ptx_swcx_desc->skb;
+		ptx_swcx_desc->skb = NULL;
 		desc_if->tx_swcx_free(pdata, ptx_swcx_desc);
+		if (skb) {
+			bytes_compl += skb->len;
+			napi_consume_skb(skb, budget);
+		}
 
 		/* reset the descriptor so that driver/host can reuse it */
 		hw_if->tx_desc_reset(entry, pdata, qinx);
@@ -2147,6 +2209,7 @@ static int process_tx_completions(struct eqos_tx_queue *tx_queue, int budget)
 	__netif_tx_lock(txq, smp_processor_id());
 	/* Update the dirty pointer and wake up the TX queue, if necessary. */
 	ptx_ring->dirty_tx = entry;
+	netdev_tx_completed_queue(txq, processed, bytes_compl);
 	if (netif_tx_queue_stopped(txq) &&
 	    eqos_tx_avail(ptx_ring) > EQOS_TX_DESC_THRESHOLD) {
 		netif_tx_wake_queue(txq);
@@ -2209,6 +2272,8 @@ static void eqos_receive_skb(struct eqos_prv_data *pdata,
 #endif
 	dev->stats.rx_packets++;
 	dev->stats.rx_bytes += skb->len;
+	rx_queue->dim.pkts++;
+	rx_queue->dim.bytes += skb->len;
 
 	if (dev->features & NETIF_F_GRO)
 		napi_gro_receive(&rx_queue->napi, skb);
@@ -2279,6 +2344,54 @@ static inline int eqos_rx_dirty(struct rx_ring *prx_ring)
 * \retval number of packets received.
 */
 
+/*!
+* \brief API to run the XDP program on a received frame.
+*
+* \details The frame is passed in place, in the RX buffer. The program can
+* move its start, so headroom and pkt_len are updated for XDP_PASS.
+*
+* \return true if the frame was consumed and its buffer is to be reused.
+*/
+
+static bool eqos_rx_run_xdp(struct eqos_prv_data *pdata,
+			    struct bpf_prog *prog,
+			    struct rx_swcx_desc *prx_swcx_desc,
+			    unsigned int *headroom, unsigned int *pkt_len)
+{
+	void *va = page_address(prx_swcx_desc->page) +
+		   prx_swcx_desc->page_offset;
+	struct xdp_buff xdp;
+	u32 act;
+
+	xdp.data = va + *headroom;
+	xdp.data_end = xdp.data + *pkt_len;
+#if LINUX_VERSION_CODE >= KERNEL_VERSION(4, 10, 0)
+	xdp.data_hard_start = va;
+#endif
+
+	act = bpf_prog_run_xdp(prog, &xdp);
+	switch (act) {
+	case XDP_PASS:
+		*headroom = xdp.data - va;
+		*pkt_len = xdp.data_end - xdp.data;
+		return false;
+	case XDP_TX:
+		/* TX ring only takes skbs */
+		pr_warn_once("eqos: XDP_TX is not supported, dropping\n");
+		break;
+	default:
+		bpf_warn_invalid_xdp_action(act);
+		/* fall through */
+	case XDP_ABORTED:
+	case XDP_DROP:
+		break;
+	}
+
+	pdata->xstats.rx_xdp_drop_n++;
+
+	return true;
+}
+
 static int process_rx_completions(struct eqos_rx_queue *rx_queue, int quota)
 {
 	struct eqos_prv_data *pdata = rx_queue->pdata;
@@ -2287,18 +2400,22 @@ static int process_rx_completions(struct eqos_rx_queue *rx_queue, int quota)
 	    GET_RX_WRAPPER_DESC(qinx);
 	struct desc_if_struct *desc_if = &pdata->desc_if;
 	struct net_device *dev = pdata->dev;
+	struct bpf_prog *xdp_prog;
 	int received = 0;
 	int received_resv = 0;
 	int ret;
 
 	pr_debug("-->%s(): qinx = %u, quota = %d\n", __func__, qinx, quota);
 
+	rcu_read_lock();
+	xdp_prog = rcu_dereference(pdata->xdp_prog);
+
 	while (received < quota && received < RX_DESC_CNT &&
 	       received_resv < quota) {
 		struct rx_swcx_desc *prx_swcx_desc;
 		struct s_rx_desc *prx_desc, *context_desc;
 		struct sk_buff *skb;
-		u32 status, pkt_len;
+		u32 status, pkt_len, headroom;
 		int entry = prx_ring->cur_rx;
 
 		prx_swcx_desc = GET_RX_BUF_PTR(qinx, entry);
@@ -2328,17 +2445,30 @@ static int process_rx_completions(struct eqos_rx_queue *rx_queue, int quota)
 #endif
 		if (likely(!(status & EQOS_RDESC3_ES_BITS) &&
 			   (status & EQOS_RDESC3_LD))) {
-			/* Unmap the SKB */
-			skb = prx_swcx_desc->skb;
-			prx_swcx_desc->skb = NULL;
-
-			dma_unmap_single(&pdata->pdev->dev, prx_swcx_desc->dma,
-					 pdata->rx_buffer_len, DMA_FROM_DEVICE);
-
-			prx_swcx_desc->dma = 0;
-
 			pkt_len = (status & EQOS_RDESC3_PL);
-			skb_put(skb, pkt_len);
+			headroom = EQOS_RX_HEADROOM;
+
+			dma_sync_single_range_for_cpu(&pdata->pdev->dev,
+				prx_swcx_desc->page_dma,
+				prx_swcx_desc->page_offset + headroom,
+				pkt_len, DMA_FROM_DEVICE);
+			prefetch(page_address(prx_swcx_desc->page) +
+				 prx_swcx_desc->page_offset + headroom);
+
+			/* Dropped frames leave the buffer in the ring */
+			if (xdp_prog &&
+			    eqos_rx_run_xdp(pdata, xdp_prog, prx_swcx_desc,
+					    &headroom, &pkt_len))
+				goto next;
+
+			/* Wrap the buffer, its page is recycled if possible */
+			skb = desc_if->rx_build_skb(pdata, prx_swcx_desc,
+						    headroom, pkt_len);
+			if (unlikely(!skb)) {
+				/* The buffer stays in the ring */
+				dev->stats.rx_dropped++;
+				goto next;
+			}
 
 #ifdef EQOS_ENABLE_RX_PKT_DUMP
 			print_pkt(skb, pkt_len, 0, entry);
@@ -2354,7 +2484,7 @@ static int process_rx_completions(struct eqos_rx_queue *rx_queue, int quota)
 			ret = eqos_get_rx_hwtstamp(pdata, skb, prx_desc,
 						   context_desc);
 			if (ret == 0) {
-				/* Context descriptor was consumed. Its skb
+				/* Context descriptor was consumed. Its page
 				 * and DMA mapping will be recycled.
 				 */
 				INCR_RX_DESC_INDEX(prx_ring->cur_rx, 1);
@@ -2362,16 +2492,19 @@ static int process_rx_completions(struct eqos_rx_queue *rx_queue, int quota)
 
 			eqos_receive_skb(pdata, dev, skb, qinx);
 		} else {
+			/* The buffer stays in the ring */
 			eqos_update_rx_errors(dev, status);
-			dev_kfree_skb_any(prx_swcx_desc->skb);
 		}
 
+next:
 		received++;
 		if (eqos_rx_dirty(prx_ring) >=
 		    prx_ring->skb_realloc_threshold)
 			desc_if->realloc_skb(pdata, qinx);
 	}
 
+	rcu_read_unlock();
+
 	desc_if->realloc_skb(pdata, qinx);
 
 	pdata->xstats.rx_pkt_n += received;
@@ -2400,6 +2533,32 @@ void eqos_update_rx_errors(struct net_device *dev, unsigned int rx_status)
 	dev->stats.rx_errors++;
 }
 
+/*
+ * Records how many descriptors the DMA owns when a poll starts, for the
+ * ethtool gauges and the debugfs occupancy histogram. A RX ring that is
+ * often found close to empty is about to drop frames.
+ */
+static void eqos_sample_rx_occupancy(struct eqos_rx_queue *rx_queue)
+{
+	struct eqos_prv_data *pdata = rx_queue->pdata;
+	unsigned int qinx = rx_queue->chan_num;
+	int inflight = RX_DESC_CNT - eqos_rx_dirty(&rx_queue->prx_ring);
+
+	pdata->xstats.q_rx_desc_inflight[qinx] = inflight;
+	rx_queue->occ_hist[min(inflight * EQOS_RING_OCC_BUCKETS / RX_DESC_CNT,
+			       EQOS_RING_OCC_BUCKETS - 1)]++;
+}
+
+static void eqos_sample_tx_occupancy(struct eqos_tx_queue *tx_queue)
+{
+	struct eqos_prv_data *pdata = tx_queue->pdata;
+	unsigned int qinx = tx_queue->chan_num;
+	int inflight = TX_DESC_CNT - 1 - eqos_tx_avail(&tx_queue->ptx_ring);
+
+	pdata->xstats.q_tx_desc_inflight[qinx] = inflight;
+	tx_queue->occ_hist[inflight * EQOS_RING_OCC_BUCKETS / TX_DESC_CNT]++;
+}
+
 int eqos_napi_poll_rx(struct napi_struct *napi, int budget)
 {
 	struct eqos_rx_queue *rx_queue =
@@ -2408,10 +2567,17 @@ int eqos_napi_poll_rx(struct napi_struct *napi, int budget)
 	int qinx = rx_queue->chan_num;
 	int received = 0;
 
+	pdata->xstats.napi_poll_n++;
+	pdata->xstats.q_rx_napi_poll_n[qinx]++;
+	eqos_sample_rx_occupancy(rx_queue);
+
 	received = process_rx_completions(rx_queue, budget);
 	if (received < budget) {
 		napi_complete(napi);
+		eqos_dim_rx_event(pdata, qinx);
 		eqos_enable_chan_rx_interrupt(pdata, qinx);
+	} else {
+		pdata->xstats.q_rx_budget_exhausted_n[qinx]++;
 	}
 
 	return received;
@@ -2432,7 +2598,12 @@ int eqos_napi_poll_tx(struct napi_struct *napi, int budget)
 	int processed;
 	unsigned long timer_val;
 
+	pdata->xstats.napi_poll_n++;
+	pdata->xstats.q_tx_napi_poll_n[qinx]++;
+	eqos_sample_tx_occupancy(tx_queue);
+
 	processed = process_tx_completions(tx_queue, budget);
+	tx_queue->dim.pkts += processed;
 	/* re-arm the timer if tx ring is not empty */
 	if ((!eqos_txring_empty(ptx_ring)) &&
 	    (ptx_ring->use_tx_usecs == EQOS_COAELSCING_ENABLE) &&
@@ -2447,7 +2618,10 @@ int eqos_napi_poll_tx(struct napi_struct *napi, int budget)
 
 	if (processed < budget) {
 		napi_complete(napi);
+		eqos_dim_tx_event(pdata, qinx);
 		eqos_enable_chan_tx_interrupt(pdata, qinx);
+	} else {
+		pdata->xstats.q_tx_budget_exhausted_n[qinx]++;
 	}
 
 	return processed;
@@ -3007,6 +3181,7 @@ static VOID eqos_config_timer_registers(struct eqos_prv_data *pdata)
 {
 	struct timespec now;
 	struct hw_if_struct *hw_if = &(pdata->hw_if);
+	unsigned long flags;
 	u64 temp;
 
 	pr_debug("-->eqos_config_timer_registers\n");
@@ -3030,12 +3205,18 @@ static VOID eqos_config_timer_registers(struct eqos_prv_data *pdata)
 	temp = (u64) (62500000ULL << 32);
 	pdata->default_addend = div_u64(temp, pdata->ptp_ref_clk_rate);
 
-	hw_if->config_addend(pdata->default_addend);
-
 	/* initialize system time */
 	getnstimeofday(&now);
+
+	raw_spin_lock_irqsave(&pdata->ptp_lock, flags);
+	write_seqcount_begin(&pdata->ptp_seq);
+
+	hw_if->config_addend(pdata->default_addend);
 	hw_if->init_systime(now.tv_sec, now.tv_nsec);
 
+	write_seqcount_end(&pdata->ptp_seq);
+	raw_spin_unlock_irqrestore(&pdata->ptp_lock, flags);
+
 	pr_debug("-->eqos_config_timer_registers\n");
 }
 
@@ -3169,7 +3350,9 @@ static int eqos_handle_prv_ts_ioctl(struct eqos_prv_data *pdata,
 	if (copy_from_user(&req, ifr->ifr_data, sizeof(req)))
 		return -EFAULT;
 
-	raw_spin_lock_irqsave(&eqos_ts_lock, flags);
+	/* keep the kernel and HW PTP reads close together, nothing needs to
+	 * be serialized against other CPUs for that */
+	local_irq_save(flags);
 
 	switch (req.clockid) {
 	case CLOCK_REALTIME:
@@ -3186,7 +3369,7 @@ static int eqos_handle_prv_ts_ioctl(struct eqos_prv_data *pdata,
 
 	ret = get_ptp_hwtime(&ns);
 
-	raw_spin_unlock_irqrestore(&eqos_ts_lock, flags);
+	local_irq_restore(flags);
 
 	if (ret != 0) {
 		pr_err("eqos ioctl: HW PTP not running\n");
@@ -3447,6 +3630,10 @@ static int eqos_handle_prv_ioctl(struct eqos_prv_data *pdata,
 		eqos_program_avb_algorithm(pdata, &req);
 		break;
 
+	case EQOS_CBS_CMD:
+		ret = eqos_program_cbs(pdata, &req);
+		break;
+
 	case EQOS_L3_L4_FILTER_CMD:
 		if (pdata->hw_feat.l3l4_filter_num > 0) {
 			ret = eqos_config_l3_l4_filtering(dev, req.flags);
@@ -4256,6 +4443,136 @@ static void eqos_program_avb_algorithm(struct eqos_prv_data *pdata,
 	return;
 }
 
+/*!
+ * \details This function converts the credit based shaper parameters of a
+ * queue to register values for the current link speed and programs them.
+ * The slopes are in 1/1024 bits per Tx clock cycle, the credits in 1/1024
+ * bits.
+ *
+ * \param[in] pdata – pointer to private data structure.
+ * \param[in] qinx – queue number.
+ *
+ * \return void
+ */
+
+static void eqos_cbs_apply(struct eqos_prv_data *pdata, UINT qinx)
+{
+	struct eqos_tx_queue *tx_queue = GET_TX_QUEUE_PTR(qinx);
+	struct hw_if_struct *hw_if = &pdata->hw_if;
+	u64 port_rate, idle_slope, max_frame, hi_credit, low_credit;
+	u32 bits_per_cycle;
+
+	switch (pdata->speed) {
+	case SPEED_1000:
+		bits_per_cycle = 8;
+		break;
+	case SPEED_100:
+	case SPEED_10:
+		bits_per_cycle = 4;
+		break;
+	default:
+		/* programmed once the link is up */
+		return;
+	}
+
+	port_rate = pdata->speed * 1000ULL;
+	idle_slope = min_t(u64, tx_queue->cbs_idle_slope, port_rate);
+	max_frame = pdata->dev->mtu + ETH_HLEN + VLAN_HLEN + ETH_FCS_LEN;
+
+	/* 802.1Q Annex L, a frame of another queue may delay ours */
+	if (tx_queue->cbs_hi_credit)
+		hi_credit = tx_queue->cbs_hi_credit;
+	else
+		hi_credit = DIV_ROUND_UP_ULL(max_frame * idle_slope, port_rate);
+
+	if (tx_queue->cbs_low_credit)
+		low_credit = -tx_queue->cbs_low_credit;
+	else
+		low_credit = DIV_ROUND_UP_ULL(max_frame *
+					      (port_rate - idle_slope),
+					      port_rate);
+
+	hw_if->set_tx_queue_operating_mode(qinx, EQOS_Q_AVB);
+	hw_if->set_avb_algorithm(qinx, 1);
+	hw_if->config_credit_control(qinx, 0);
+	hw_if->config_idle_slope(qinx,
+		div64_u64(idle_slope * 1024 * bits_per_cycle, port_rate));
+	hw_if->config_send_slope(qinx,
+		div64_u64((port_rate - idle_slope) * 1024 * bits_per_cycle,
+			  port_rate));
+	hw_if->config_high_credit(qinx, hi_credit * 1024 * 8);
+	/* two's complement, truncated to the width of the field */
+	hw_if->config_low_credit(qinx, -(low_credit * 1024 * 8));
+}
+
+/*!
+ * \details This function reprograms the credit based shapers for a new
+ * link speed, or after the registers were reset.
+ *
+ * \param[in] pdata – pointer to private data structure.
+ *
+ * \return void
+ */
+
+void eqos_cbs_apply_all(struct eqos_prv_data *pdata)
+{
+	UINT qinx;
+
+	for (qinx = 1; qinx < EQOS_TX_QUEUE_CNT; qinx++)
+		if (pdata->tx_queue[qinx].cbs_enable)
+			eqos_cbs_apply(pdata, qinx);
+}
+
+/*!
+ * \details This function is invoked by ioctl function when the user issues an
+ * ioctl command to set up the credit based shaper of a queue from the
+ * bandwidth reserved for it, the way tc-cbs does.
+ *
+ * \param[in] pdata – pointer to private data structure.
+ * \param[in] req – pointer to ioctl data structure.
+ *
+ * \return int
+ *
+ * \retval zero on success and -ve number on failure.
+ */
+
+static int eqos_program_cbs(struct eqos_prv_data *pdata,
+			    struct ifr_data_struct *req)
+{
+	struct hw_if_struct *hw_if = &pdata->hw_if;
+	struct eqos_tx_queue *tx_queue;
+	struct eqos_cbs cbs;
+	UINT qinx;
+
+	if (copy_from_user(&cbs, req->ptr, sizeof(struct eqos_cbs)))
+		return -EFAULT;
+
+	if (cbs.qinx == 0 || cbs.qinx >= EQOS_TX_QUEUE_CNT)
+		return -EINVAL;
+
+	qinx = array_index_nospec(cbs.qinx, EQOS_TX_QUEUE_CNT);
+	tx_queue = GET_TX_QUEUE_PTR(qinx);
+	if (tx_queue->q_op_mode != EQOS_Q_AVB)
+		return -EINVAL;
+
+	if (cbs.enable &&
+	    (!cbs.idle_slope || cbs.idle_slope > SPEED_1000 * 1000 ||
+	     cbs.hi_credit < 0 || cbs.low_credit > 0))
+		return -EINVAL;
+
+	tx_queue->cbs_enable = !!cbs.enable;
+	tx_queue->cbs_idle_slope = cbs.idle_slope;
+	tx_queue->cbs_hi_credit = cbs.hi_credit;
+	tx_queue->cbs_low_credit = cbs.low_credit;
+
+	if (tx_queue->cbs_enable)
+		eqos_cbs_apply(pdata, qinx);
+	else
+		hw_if->set_avb_algorithm(qinx, 0);
+
+	return 0;
+}
+
 /*!
 * \brief API to read the registers & prints the value.
 * \details This function will read all the device register except
@@ -5357,8 +5674,52 @@ static const struct net_device_ops eqos_netdev_ops = {
 	.ndo_vlan_rx_add_vid = eqos_vlan_rx_add_vid,
 	.ndo_vlan_rx_kill_vid = eqos_vlan_rx_kill_vid,
 	.ndo_set_mac_address = eth_mac_addr,
+	.ndo_xdp = eqos_xdp,
 };
 
+static int eqos_xdp_setup(struct net_device *dev, struct bpf_prog *prog)
+{
+	struct eqos_prv_data *pdata = netdev_priv(dev);
+	struct bpf_prog *old_prog;
+
+	/*
+	 * Frames are received in a single page backed buffer, so the
+	 * program can be swapped while the rings run.
+	 */
+	old_prog = rtnl_dereference(pdata->xdp_prog);
+	rcu_assign_pointer(pdata->xdp_prog, prog);
+	if (old_prog)
+		bpf_prog_put(old_prog);
+
+	return 0;
+}
+
+static int eqos_xdp(struct net_device *dev, struct netdev_xdp *xdp)
+{
+	struct eqos_prv_data *pdata = netdev_priv(dev);
+
+	switch (xdp->command) {
+	case XDP_SETUP_PROG:
+		return eqos_xdp_setup(dev, xdp->prog);
+	case XDP_QUERY_PROG:
+		xdp->prog_attached = !!rtnl_dereference(pdata->xdp_prog);
+		return 0;
+	default:
+		return -EINVAL;
+	}
+}
+
+/* drops the XDP program when the device goes away */
+void eqos_xdp_release(struct eqos_prv_data *pdata)
+{
+	struct bpf_prog *prog;
+
+	prog = rcu_dereference_protected(pdata->xdp_prog, 1);
+	RCU_INIT_POINTER(pdata->xdp_prog, NULL);
+	if (prog)
+		bpf_prog_put(prog);
+}
+
 struct net_device_ops *eqos_get_netdev_ops(void)
 {
 	return (struct net_device_ops *)&eqos_netdev_ops;
@@ -5454,6 +5815,7 @@ void eqos_start_dev(struct eqos_prv_data *pdata)
 
 	/* initializes MAC and DMA */
 	hw_if->init(pdata);
+	eqos_cbs_apply_all(pdata);
 
 	MAC_1US_TIC_WR(pdata->csr_clock_speed - 1);
 
@@ -67,6 +67,9 @@ static void eqos_program_dcb_algorithm(struct eqos_prv_data *pdata,
 static void eqos_program_avb_algorithm(struct eqos_prv_data *pdata,
 		struct ifr_data_struct *req);
 
+static int eqos_program_cbs(struct eqos_prv_data *pdata,
+		struct ifr_data_struct *req);
+
 static void eqos_config_tx_pbl(struct eqos_prv_data *pdata,
 				      UINT tx_pbl, UINT ch_no);
 static void eqos_config_rx_pbl(struct eqos_prv_data *pdata,
@@ -121,6 +121,25 @@ static const struct eqos_stats eqos_gstrings_stats[] = {
 	EQOS_EXTRA_STAT(rx_normal_irq_n[5]),
 	EQOS_EXTRA_STAT(rx_normal_irq_n[6]),
 	EQOS_EXTRA_STAT(rx_normal_irq_n[7]),
+	/* Dynamic interrupt moderation */
+	EQOS_EXTRA_STAT(q_tx_dim_level[0]),
+	EQOS_EXTRA_STAT(q_tx_dim_level[1]),
+	EQOS_EXTRA_STAT(q_tx_dim_level[2]),
+	EQOS_EXTRA_STAT(q_tx_dim_level[3]),
+	EQOS_EXTRA_STAT(q_tx_dim_level[4]),
+	EQOS_EXTRA_STAT(q_tx_dim_level[5]),
+	EQOS_EXTRA_STAT(q_tx_dim_level[6]),
+	EQOS_EXTRA_STAT(q_tx_dim_level[7]),
+	EQOS_EXTRA_STAT(q_rx_dim_level[0]),
+	EQOS_EXTRA_STAT(q_rx_dim_level[1]),
+	EQOS_EXTRA_STAT(q_rx_dim_level[2]),
+	EQOS_EXTRA_STAT(q_rx_dim_level[3]),
+	EQOS_EXTRA_STAT(q_rx_dim_level[4]),
+	EQOS_EXTRA_STAT(q_rx_dim_level[5]),
+	EQOS_EXTRA_STAT(q_rx_dim_level[6]),
+	EQOS_EXTRA_STAT(q_rx_dim_level[7]),
+	EQOS_EXTRA_STAT(tx_dim_changes_n),
+	EQOS_EXTRA_STAT(rx_dim_changes_n),
 	EQOS_EXTRA_STAT(napi_poll_n),
 	EQOS_EXTRA_STAT(tx_clean_n[0]),
 	EQOS_EXTRA_STAT(tx_clean_n[1]),
@@ -130,6 +149,63 @@ static const struct eqos_stats eqos_gstrings_stats[] = {
 	EQOS_EXTRA_STAT(tx_clean_n[5]),
 	EQOS_EXTRA_STAT(tx_clean_n[6]),
 	EQOS_EXTRA_STAT(tx_clean_n[7]),
+	/* NAPI and ring telemetry */
+	EQOS_EXTRA_STAT(q_rx_napi_poll_n[0]),
+	EQOS_EXTRA_STAT(q_rx_napi_poll_n[1]),
+	EQOS_EXTRA_STAT(q_rx_napi_poll_n[2]),
+	EQOS_EXTRA_STAT(q_rx_napi_poll_n[3]),
+	EQOS_EXTRA_STAT(q_rx_napi_poll_n[4]),
+	EQOS_EXTRA_STAT(q_rx_napi_poll_n[5]),
+	EQOS_EXTRA_STAT(q_rx_napi_poll_n[6]),
+	EQOS_EXTRA_STAT(q_rx_napi_poll_n[7]),
+	EQOS_EXTRA_STAT(q_tx_napi_poll_n[0]),
+	EQOS_EXTRA_STAT(q_tx_napi_poll_n[1]),
+	EQOS_EXTRA_STAT(q_tx_napi_poll_n[2]),
+	EQOS_EXTRA_STAT(q_tx_napi_poll_n[3]),
+	EQOS_EXTRA_STAT(q_tx_napi_poll_n[4]),
+	EQOS_EXTRA_STAT(q_tx_napi_poll_n[5]),
+	EQOS_EXTRA_STAT(q_tx_napi_poll_n[6]),
+	EQOS_EXTRA_STAT(q_tx_napi_poll_n[7]),
+	EQOS_EXTRA_STAT(q_rx_budget_exhausted_n[0]),
+	EQOS_EXTRA_STAT(q_rx_budget_exhausted_n[1]),
+	EQOS_EXTRA_STAT(q_rx_budget_exhausted_n[2]),
+	EQOS_EXTRA_STAT(q_rx_budget_exhausted_n[3]),
+	EQOS_EXTRA_STAT(q_rx_budget_exhausted_n[4]),
+	EQOS_EXTRA_STAT(q_rx_budget_exhausted_n[5]),
+	EQOS_EXTRA_STAT(q_rx_budget_exhausted_n[6]),
+	EQOS_EXTRA_STAT(q_rx_budget_exhausted_n[7]),
+	EQOS_EXTRA_STAT(q_tx_budget_exhausted_n[0]),
+	EQOS_EXTRA_STAT(q_tx_budget_exhausted_n[1]),
+	EQOS_EXTRA_STAT(q_tx_budget_exhausted_n[2]),
+	EQOS_EXTRA_STAT(q_tx_budget_exhausted_n[3]),
+	EQOS_EXTRA_STAT(q_tx_budget_exhausted_n[4]),
+	EQOS_EXTRA_STAT(q_tx_budget_exhausted_n[5]),
+	EQOS_EXTRA_STAT(q_tx_budget_exhausted_n[6]),
+	EQOS_EXTRA_STAT(q_tx_budget_exhausted_n[7]),
+	EQOS_EXTRA_STAT(q_tx_ring_full_n[0]),
+	EQOS_EXTRA_STAT(q_tx_ring_full_n[1]),
+	EQOS_EXTRA_STAT(q_tx_ring_full_n[2]),
+	EQOS_EXTRA_STAT(q_tx_ring_full_n[3]),
+	EQOS_EXTRA_STAT(q_tx_ring_full_n[4]),
+	EQOS_EXTRA_STAT(q_tx_ring_full_n[5]),
+	EQOS_EXTRA_STAT(q_tx_ring_full_n[6]),
+	EQOS_EXTRA_STAT(q_tx_ring_full_n[7]),
+	EQOS_EXTRA_STAT(q_rx_desc_inflight[0]),
+	EQOS_EXTRA_STAT(q_rx_desc_inflight[1]),
+	EQOS_EXTRA_STAT(q_rx_desc_inflight[2]),
+	EQOS_EXTRA_STAT(q_rx_desc_inflight[3]),
+	EQOS_EXTRA_STAT(q_rx_desc_inflight[4]),
+	EQOS_EXTRA_STAT(q_rx_desc_inflight[5]),
+	EQOS_EXTRA_STAT(q_rx_desc_inflight[6]),
+	EQOS_EXTRA_STAT(q_rx_desc_inflight[7]),
+	EQOS_EXTRA_STAT(q_tx_desc_inflight[0]),
+	EQOS_EXTRA_STAT(q_tx_desc_inflight[1]),
+	EQOS_EXTRA_STAT(q_tx_desc_inflight[2]),
+	EQOS_EXTRA_STAT(q_tx_desc_inflight[3]),
+	EQOS_EXTRA_STAT(q_tx_desc_inflight[4]),
+	EQOS_EXTRA_STAT(q_tx_desc_inflight[5]),
+	EQOS_EXTRA_STAT(q_tx_desc_inflight[6]),
+	EQOS_EXTRA_STAT(q_tx_desc_inflight[7]),
 	/* EEE */
 	EQOS_EXTRA_STAT(tx_path_in_lpi_mode_irq_n),
 	EQOS_EXTRA_STAT(tx_path_exit_lpi_mode_irq_n),
@@ -143,6 +219,7 @@ static const struct eqos_stats eqos_gstrings_stats[] = {
 	EQOS_EXTRA_STAT(tx_timestamp_captured_n),
 	EQOS_EXTRA_STAT(rx_timestamp_captured_n),
 	EQOS_EXTRA_STAT(tx_tso_pkt_n),
+	EQOS_EXTRA_STAT(rx_xdp_drop_n),
 
 	/* Tx/Rx frames per channels/queues */
 	EQOS_EXTRA_STAT(q_tx_pkt_n[0]),
@@ -299,6 +376,180 @@ static int eqos_get_ts_info(struct net_device *net,
 	return 0;
 }
 
+/* reprogram the MAC address filters, and with them the DA channel select */
+static void eqos_rx_flow_sync(struct net_device *dev)
+{
+	if (!netif_running(dev))
+		return;
+
+	netif_addr_lock_bh(dev);
+	dev->netdev_ops->ndo_set_rx_mode(dev);
+	netif_addr_unlock_bh(dev);
+}
+
+static int eqos_get_rx_flow(struct eqos_prv_data *pdata,
+			    struct ethtool_rxnfc *cmd)
+{
+	struct ethtool_rx_flow_spec *fsp = &cmd->fs;
+	struct eqos_rx_flow *flow;
+
+	if (fsp->location >= EQOS_MAX_RX_FLOWS)
+		return -EINVAL;
+
+	flow = &pdata->rx_flows[fsp->location];
+	if (!flow->used)
+		return -ENOENT;
+
+	memset(&fsp->h_u, 0, sizeof(fsp->h_u));
+	memset(&fsp->m_u, 0, sizeof(fsp->m_u));
+	fsp->flow_type = ETHER_FLOW;
+	ether_addr_copy(fsp->h_u.ether_spec.h_dest, flow->addr);
+	eth_broadcast_addr(fsp->m_u.ether_spec.h_dest);
+	fsp->ring_cookie = flow->chan;
+
+	return 0;
+}
+
+static int eqos_add_rx_flow(struct eqos_prv_data *pdata,
+			    struct ethtool_rx_flow_spec *fsp)
+{
+	const struct ethhdr *mask = &fsp->m_u.ether_spec;
+	struct eqos_rx_flow *flow;
+	int i;
+
+	/* only exact destination MAC address matches can be steered */
+	if (fsp->flow_type != ETHER_FLOW ||
+	    !is_broadcast_ether_addr(mask->h_dest) ||
+	    !is_zero_ether_addr(mask->h_source) || mask->h_proto)
+		return -EINVAL;
+
+	if (!is_valid_ether_addr(fsp->h_u.ether_spec.h_dest) &&
+	    !is_multicast_ether_addr(fsp->h_u.ether_spec.h_dest))
+		return -EINVAL;
+
+	if (fsp->ring_cookie == RX_CLS_FLOW_DISC ||
+	    fsp->ring_cookie >= pdata->num_chans)
+		return -EINVAL;
+
+	if (fsp->location >= EQOS_MAX_RX_FLOWS)
+		return -EINVAL;
+
+	for (i = 0; i < EQOS_MAX_RX_FLOWS; i++) {
+		flow = &pdata->rx_flows[i];
+		if (i != fsp->location && flow->used &&
+		    ether_addr_equal(flow->addr, fsp->h_u.ether_spec.h_dest))
+			return -EEXIST;
+	}
+
+	flow = &pdata->rx_flows[fsp->location];
+	spin_lock_bh(&pdata->lock);
+	ether_addr_copy(flow->addr, fsp->h_u.ether_spec.h_dest);
+	flow->chan = fsp->ring_cookie;
+	flow->used = true;
+	spin_unlock_bh(&pdata->lock);
+
+	return 0;
+}
+
+/*!
+ * \details This function is invoked by kernel when user requests to get
+ * the Rx rings or the flow steering rules through ethtool -n/-u.
+ *
+ * \param[in] dev – pointer to net device structure.
+ * \param[in] cmd – pointer to ethtool_rxnfc structure.
+ * \param[out] rule_locs – locations of the rules, for ETHTOOL_GRXCLSRLALL.
+ *
+ * \return int
+ *
+ * \retval zero on success and -ve number on failure.
+ */
+
+static int eqos_get_rxnfc(struct net_device *dev, struct ethtool_rxnfc *cmd,
+			  u32 *rule_locs)
+{
+	struct eqos_prv_data *pdata = netdev_priv(dev);
+	u32 cnt = 0;
+	int i;
+
+	switch (cmd->cmd) {
+	case ETHTOOL_GRXRINGS:
+		cmd->data = pdata->num_chans;
+		return 0;
+	case ETHTOOL_GRXCLSRLCNT:
+		for (i = 0; i < EQOS_MAX_RX_FLOWS; i++)
+			if (pdata->rx_flows[i].used)
+				cnt++;
+		cmd->rule_cnt = cnt;
+		cmd->data = EQOS_MAX_RX_FLOWS;
+		return 0;
+	case ETHTOOL_GRXCLSRULE:
+		return eqos_get_rx_flow(pdata, cmd);
+	case ETHTOOL_GRXCLSRLALL:
+		for (i = 0; i < EQOS_MAX_RX_FLOWS; i++) {
+			if (!pdata->rx_flows[i].used)
+				continue;
+			if (cnt == cmd->rule_cnt)
+				return -EMSGSIZE;
+			rule_locs[cnt++] = i;
+		}
+		cmd->rule_cnt = cnt;
+		cmd->data = EQOS_MAX_RX_FLOWS;
+		return 0;
+	default:
+		return -EOPNOTSUPP;
+	}
+}
+
+/*!
+ * \details This function is invoked by kernel when user requests to insert
+ * or delete a flow steering rule through ethtool -N/-U. Packets are steered
+ * on their destination MAC address to a DMA channel, which covers the
+ * multicast groups of streams with several receivers and the additional
+ * unicast addresses of macvlan interfaces. Rules only take effect while
+ * their address sits in a perfect MAC address filter register.
+ *
+ * \param[in] dev – pointer to net device structure.
+ * \param[in] cmd – pointer to ethtool_rxnfc structure.
+ *
+ * \return int
+ *
+ * \retval zero on success and -ve number on failure.
+ */
+
+static int eqos_set_rxnfc(struct net_device *dev, struct ethtool_rxnfc *cmd)
+{
+	struct eqos_prv_data *pdata = netdev_priv(dev);
+	struct eqos_rx_flow *flow;
+	int ret;
+
+	if (!pdata->dt_cfg.use_multi_q)
+		return -EOPNOTSUPP;
+
+	switch (cmd->cmd) {
+	case ETHTOOL_SRXCLSRLINS:
+		ret = eqos_add_rx_flow(pdata, &cmd->fs);
+		break;
+	case ETHTOOL_SRXCLSRLDEL:
+		if (cmd->fs.location >= EQOS_MAX_RX_FLOWS)
+			return -EINVAL;
+		flow = &pdata->rx_flows[cmd->fs.location];
+		if (!flow->used)
+			return -ENOENT;
+		spin_lock_bh(&pdata->lock);
+		flow->used = false;
+		spin_unlock_bh(&pdata->lock);
+		ret = 0;
+		break;
+	default:
+		return -EOPNOTSUPP;
+	}
+
+	if (!ret)
+		eqos_rx_flow_sync(dev);
+
+	return ret;
+}
+
 static const struct ethtool_ops eqos_ethtool_ops = {
 	.get_link = ethtool_op_get_link,
 	.get_pauseparam = eqos_get_pauseparam,
@@ -311,6 +562,8 @@ static const struct ethtool_ops eqos_ethtool_ops = {
 	.get_strings = eqos_get_strings,
 	.get_sset_count = eqos_get_sset_count,
 	.get_ts_info = eqos_get_ts_info,
+	.get_rxnfc = eqos_get_rxnfc,
+	.set_rxnfc = eqos_set_rxnfc,
 #if LINUX_VERSION_CODE > KERNEL_VERSION(4, 9, 0)
 	.get_link_ksettings = eqos_get_link_ksettings,
 	.set_link_ksettings = eqos_set_link_ksettings,
@@ -686,6 +939,10 @@ static int eqos_get_coalesce(struct net_device *dev,
 	if (ptx_ring->use_tx_frames)
 		ec->tx_max_coalesced_frames = ptx_ring->tx_coal_frames;
 
+	/* with these set, the values above are the current levels */
+	ec->use_adaptive_rx_coalesce = pdata->rx_dim_enabled;
+	ec->use_adaptive_tx_coalesce = pdata->tx_dim_enabled;
+
 	pr_debug("<--eqos_get_coalesce\n");
 
 	return 0;
@@ -722,7 +979,6 @@ static int eqos_set_coalesce(struct net_device *dev,
 	/* Check for not supported parameters  */
 	if ((ec->rx_coalesce_usecs_irq) ||
 	    (ec->rx_max_coalesced_frames_irq) || (ec->tx_coalesce_usecs_irq) ||
-	    (ec->use_adaptive_rx_coalesce) || (ec->use_adaptive_tx_coalesce) ||
 	    (ec->pkt_rate_low) || (ec->rx_coalesce_usecs_low) ||
 	    (ec->rx_max_coalesced_frames_low) || (ec->tx_coalesce_usecs_high) ||
 	    (ec->tx_max_coalesced_frames_low) || (ec->pkt_rate_high) ||
@@ -733,6 +989,22 @@ static int eqos_set_coalesce(struct net_device *dev,
 	    (ec->tx_max_coalesced_frames_high) || (ec->rate_sample_interval))
 		return -EOPNOTSUPP;
 
+	/*
+	 * Dynamic moderation owns the parameters while enabled, and
+	 * restores the static ones when it gets disabled.
+	 */
+	if (!!ec->use_adaptive_rx_coalesce != pdata->rx_dim_enabled ||
+	    !!ec->use_adaptive_tx_coalesce != pdata->tx_dim_enabled) {
+		eqos_dim_rx_enable(pdata, !!ec->use_adaptive_rx_coalesce);
+		eqos_dim_tx_enable(pdata, !!ec->use_adaptive_tx_coalesce);
+		return 0;
+	}
+
+	if (pdata->rx_dim_enabled || pdata->tx_dim_enabled) {
+		DBGPR_ETHTOOL("Coalesce parameters cannot be changed while adaptive coalescing is enabled\n");
+		return -EINVAL;
+	}
+
 	/* check if we are changing the parameters when interface is already up */
 	if (prx_ring->rx_coal_frames != ec->rx_max_coalesced_frames
 	    && netif_running(dev)) {
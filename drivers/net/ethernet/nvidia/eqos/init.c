@@ -1458,6 +1458,8 @@ int eqos_probe(struct platform_device *pdev)
 	spin_lock_init(&pdata->lock);
 	spin_lock_init(&pdata->tx_lock);
 	spin_lock_init(&pdata->pmt_lock);
+	raw_spin_lock_init(&pdata->ptp_lock);
+	seqcount_init(&pdata->ptp_seq);
 
 	ret = register_netdev(ndev);
 	if (ret) {
@@ -1630,6 +1632,8 @@ int eqos_remove(struct platform_device *pdev)
 
 	desc_if->free_queue_struct(pdata);
 
+	eqos_xdp_release(pdata);
+
 	if (!tegra_platform_is_unit_fpga()) {
 		eqos_clock_deinit(pdata);
 
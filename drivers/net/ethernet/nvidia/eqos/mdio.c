@@ -401,6 +401,8 @@ static void eqos_adjust_link(struct net_device *dev)
 
 	if (speed_changed) {
 		hw_if->set_tx_clk_speed(pdata, phydev->speed);
+		/* the slopes depend on the port rate */
+		eqos_cbs_apply_all(pdata);
 		/* recalibrate if speed 10 to 100 or 1000mbps */
 		if (pdata->oldspeed == SPEED_10)
 			hw_if->pad_calibrate(pdata);
@@ -46,6 +46,35 @@
  */
 #include "yheader.h"
 
+/*!
+ * \brief API to read the hardware time without locking.
+ *
+ * \details The time registers can be read from any number of CPUs at
+ * once, readers only retry when an adjustment of the clock, serialized
+ * by ptp_lock, ran in between. Writers disable interrupts so that a
+ * reader in interrupt context never spins on a writer it preempted.
+ *
+ * \param[in] pdata – pointer to private data structure.
+ *
+ * \return u64
+ *
+ * \retval time in nanoseconds.
+ */
+
+u64 eqos_ptp_read_time(struct eqos_prv_data *pdata)
+{
+	struct hw_if_struct *hw_if = &pdata->hw_if;
+	unsigned int seq;
+	u64 ns;
+
+	do {
+		seq = read_seqcount_begin(&pdata->ptp_seq);
+		ns = hw_if->get_systime();
+	} while (read_seqcount_retry(&pdata->ptp_seq, seq));
+
+	return ns;
+}
+
 /*!
  * \brief API to adjust the frequency of hardware clock.
  *
@@ -65,6 +94,7 @@ static int eqos_adjust_freq(struct ptp_clock_info *ptp, s32 ppb)
 	struct eqos_prv_data *pdata =
 	    container_of(ptp, struct eqos_prv_data, ptp_clock_ops);
 	struct hw_if_struct *hw_if = &(pdata->hw_if);
+	unsigned long flags;
 	u64 adj;
 	u32 diff, addend;
 	int neg_adj = 0;
@@ -86,11 +116,13 @@ static int eqos_adjust_freq(struct ptp_clock_info *ptp, s32 ppb)
 	diff = div_u64(adj, 1000000000ULL);
 	addend = neg_adj ? (addend - diff) : (addend + diff);
 
-	raw_spin_lock(&pdata->ptp_lock);
+	raw_spin_lock_irqsave(&pdata->ptp_lock, flags);
+	write_seqcount_begin(&pdata->ptp_seq);
 
 	hw_if->config_addend(addend);
 
-	raw_spin_unlock(&pdata->ptp_lock);
+	write_seqcount_end(&pdata->ptp_seq);
+	raw_spin_unlock_irqrestore(&pdata->ptp_lock, flags);
 
 	DBGPR_PTP("<--eqos_adjust_freq\n");
 
@@ -116,6 +148,7 @@ static int eqos_adjust_time(struct ptp_clock_info *ptp, s64 delta)
 	struct eqos_prv_data *pdata =
 	    container_of(ptp, struct eqos_prv_data, ptp_clock_ops);
 	struct hw_if_struct *hw_if = &(pdata->hw_if);
+	unsigned long flags;
 	u32 sec, nsec;
 	u32 quotient, reminder;
 	int neg_adj = 0;
@@ -131,11 +164,13 @@ static int eqos_adjust_time(struct ptp_clock_info *ptp, s64 delta)
 	sec = quotient;
 	nsec = reminder;
 
-	raw_spin_lock(&pdata->ptp_lock);
+	raw_spin_lock_irqsave(&pdata->ptp_lock, flags);
+	write_seqcount_begin(&pdata->ptp_seq);
 
 	hw_if->adjust_systime(sec, nsec, neg_adj, pdata->one_nsec_accuracy);
 
-	raw_spin_unlock(&pdata->ptp_lock);
+	write_seqcount_end(&pdata->ptp_seq);
+	raw_spin_unlock_irqrestore(&pdata->ptp_lock, flags);
 
 	DBGPR_PTP("<--eqos_adjust_time\n");
 
@@ -160,18 +195,12 @@ static int eqos_get_time(struct ptp_clock_info *ptp, struct timespec *ts)
 {
 	struct eqos_prv_data *pdata =
 	    container_of(ptp, struct eqos_prv_data, ptp_clock_ops);
-	struct hw_if_struct *hw_if = &(pdata->hw_if);
-	unsigned long flags;
 	u64 ns;
 	u32 reminder;
 
 	DBGPR_PTP("-->eqos_get_time\n");
 
-	raw_spin_lock_irqsave(&pdata->ptp_lock, flags);
-
-	ns = hw_if->get_systime();
-
-	raw_spin_unlock_irqrestore(&pdata->ptp_lock, flags);
+	ns = eqos_ptp_read_time(pdata);
 
 	ts->tv_sec = div_u64_rem(ns, 1000000000ULL, &reminder);
 	ts->tv_nsec = reminder;
@@ -201,15 +230,18 @@ static int eqos_set_time(struct ptp_clock_info *ptp, const struct timespec *ts)
 	struct eqos_prv_data *pdata =
 	    container_of(ptp, struct eqos_prv_data, ptp_clock_ops);
 	struct hw_if_struct *hw_if = &(pdata->hw_if);
+	unsigned long flags;
 
 	DBGPR_PTP("-->eqos_set_time: ts->tv_sec = %ld, ts->tv_nsec = %ld\n",
 		ts->tv_sec, ts->tv_nsec);
 
-	raw_spin_lock(&pdata->ptp_lock);
+	raw_spin_lock_irqsave(&pdata->ptp_lock, flags);
+	write_seqcount_begin(&pdata->ptp_seq);
 
 	hw_if->init_systime(ts->tv_sec, ts->tv_nsec);
 
-	raw_spin_unlock(&pdata->ptp_lock);
+	write_seqcount_end(&pdata->ptp_seq);
+	raw_spin_unlock_irqrestore(&pdata->ptp_lock, flags);
 
 	DBGPR_PTP("<--eqos_set_time\n");
 
@@ -286,8 +318,6 @@ int eqos_ptp_init(struct eqos_prv_data *pdata)
 		goto no_hw_ptp;
 	}
 
-	raw_spin_lock_init(&pdata->ptp_lock);
-
 	pdata->ptp_clock_ops = eqos_ptp_clock_ops;
 
 	pdata->ptp_clock =
@@ -126,6 +126,8 @@
 #define EQOS_CSR_ISO_TEST	43
 #define EQOS_MEM_ISO_TEST	44
 #define EQOS_PHY_LOOPBACK 45
+/* credit based shaper from bandwidth, see struct eqos_cbs */
+#define EQOS_CBS_CMD			46
 
 #define EQOS_RWK_FILTER_LENGTH	8
 
@@ -315,6 +317,23 @@ struct eqos_avb_algorithm {
 	eqos_queue_operating_mode op_mode;
 };
 
+/* Parameters of the 802.1Qav credit based shaper, as for tc-cbs. The
+ * register values are derived from them by the driver, again on each
+ * link speed change.
+ */
+struct eqos_cbs {
+	/* 1 - 7, queue 0 has no shaper */
+	unsigned int qinx;
+	/* 0 - strict priority, 1 - credit based shaper */
+	unsigned int enable;
+	/* bandwidth reserved for the queue, in kbps */
+	unsigned int idle_slope;
+	/* max credit in bytes, 0 to derive it from the MTU */
+	int hi_credit;
+	/* min credit in bytes (negative), 0 to derive it from the MTU */
+	int low_credit;
+};
+
 struct eqos_l3_l4_filter {
 	/* 0, 1,2,3,4,5,6 or 7 */
 	int filter_no;
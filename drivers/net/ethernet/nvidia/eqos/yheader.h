@@ -66,8 +66,12 @@
 #include <linux/etherdevice.h>
 #include <linux/ethtool.h>
 #include <linux/skbuff.h>
+#include <linux/prefetch.h>
+#include <linux/bpf.h>
+#include <linux/filter.h>
 #include <linux/delay.h>
 #include <linux/spinlock.h>
+#include <linux/seqlock.h>
 #include <linux/crc32.h>
 #include <linux/bitops.h>
 #include <linux/mii.h>
@@ -161,6 +165,9 @@
  */
 #define EQOS_RX_BUF_LEN 2048
 
+/* Room left in front of received frames for the stack */
+#define EQOS_RX_HEADROOM (NET_SKB_PAD + NET_IP_ALIGN)
+
 /* Max value of RXPBL */
 #define MAX_RXPBL 32
 
@@ -807,6 +814,7 @@ struct hw_if_struct {
 	 INT (*get_tx_desc_ls)(struct s_tx_desc *);
 	 INT (*get_tx_desc_ctxt)(struct s_tx_desc *);
 	void (*update_rx_tail_ptr) (unsigned int qinx, unsigned int dma_addr);
+	void (*update_tx_tail_ptr) (unsigned int qinx, unsigned int dma_addr);
 
 	/* for FLOW ctrl */
 	 INT(*enable_rx_flow_ctrl) (VOID);
@@ -957,6 +965,9 @@ struct hw_if_struct {
 
 	/* for PTP channel configuration */
 	VOID(*config_ptp_channel)(UINT, UINT);
+
+	/* for ethtool flow steering */
+	VOID(*config_rx_flow_channel)(UINT, UINT);
 };
 
 /* wrapper buffer structure to hold transmit pkt details */
@@ -1012,6 +1023,34 @@ struct tx_ring {
 	unsigned long tx_usecs;
 };
 
+/* ethtool flow steering rules, matched on the destination MAC address */
+#define EQOS_MAX_RX_FLOWS 16
+
+struct eqos_rx_flow {
+	bool used;
+	u8 addr[ETH_ALEN];
+	u8 chan;	/* DMA channel the matching packets are steered to */
+};
+
+#define EQOS_DIM_NLEVELS 5
+
+/* Dynamic interrupt moderation state of a DMA channel, see dim.c */
+struct eqos_dim {
+	u8 level;	/* current moderation level */
+	s8 dir;		/* direction of the next step */
+	bool parked;	/* level kept until the load changes */
+	u32 events;	/* interrupts in the current sample */
+	u64 pkts;	/* packets in the current sample */
+	u64 bytes;	/* bytes in the current sample */
+	ktime_t start_time;
+	u32 prev_bpms;	/* rates of the previous sample, per msec */
+	u32 prev_ppms;
+	u32 prev_epms;
+};
+
+/* ring occupancy histogram buckets, see debugfs ring_occupancy */
+#define EQOS_RING_OCC_BUCKETS	8
+
 struct eqos_tx_queue {
 	/* Tx descriptors */
 	struct tx_ring ptx_ring;
@@ -1024,12 +1063,28 @@ struct eqos_tx_queue {
 	struct hrtimer tx_usecs_timer;
 	/** SW timer flag associated with transmit channel */
 	atomic_t tx_usecs_timer_armed;
+	/** Dynamic moderation, and the static parameters it overrides */
+	struct eqos_dim dim;
+	bool dim_saved_use_usecs;
+	bool dim_saved_use_frames;
+	unsigned long dim_saved_usecs;
+	unsigned int dim_saved_frames;
+	/** Credit based shaper requested through EQOS_CBS_CMD */
+	bool cbs_enable;
+	u32 cbs_idle_slope;	/* kbps */
+	int cbs_hi_credit;	/* bytes */
+	int cbs_low_credit;	/* bytes */
+	/** Descriptors in flight at each poll, in 1/8th of the ring */
+	unsigned long occ_hist[EQOS_RING_OCC_BUCKETS];
 };
 
 /* wrapper buffer structure to hold received pkt details */
 struct rx_swcx_desc {
-	dma_addr_t dma;		/* dma address of skb */
-	struct sk_buff *skb;	/* virtual address of skb */
+	dma_addr_t dma;		/* dma address of the buffer */
+	struct sk_buff *skb;	/* set to resv_skb when no page is available */
+	struct page *page;	/* page the buffer is carved from */
+	dma_addr_t page_dma;	/* dma address of the page */
+	unsigned int page_offset; /* offset of the buffer in the page */
 	bool inte;	/* set to non-zero if INTE is set for
 				corresponding desc */
 };
@@ -1071,6 +1126,13 @@ struct eqos_rx_queue {
 	struct napi_struct napi;
 	struct eqos_prv_data *pdata;
 	uint	chan_num;
+	/* Dynamic moderation, and the static parameters it overrides */
+	struct eqos_dim dim;
+	bool dim_saved_use_riwt;
+	u32 dim_saved_riwt;
+	u32 dim_saved_frames;
+	/* Descriptors owned by the DMA at each poll, in 1/8th of the ring */
+	unsigned long occ_hist[EQOS_RING_OCC_BUCKETS];
 };
 
 struct desc_if_struct {
@@ -1081,6 +1143,9 @@ struct desc_if_struct {
 	void (*realloc_skb) (struct eqos_prv_data *, UINT);
 	void (*unmap_rx_skb) (struct eqos_prv_data *,
 			      struct rx_swcx_desc *);
+	struct sk_buff *(*rx_build_skb)(struct eqos_prv_data *,
+					struct rx_swcx_desc *, unsigned int,
+					unsigned int);
 	void (*tx_swcx_free)(struct eqos_prv_data *, struct tx_swcx_desc *);
 	int (*tx_swcx_alloc)(struct net_device *, struct sk_buff *);
 	void (*tx_free_mem) (struct eqos_prv_data *);
@@ -1292,8 +1357,22 @@ struct eqos_extra_stats {
 	/* Tx/Rx IRQ Events */
 	unsigned long tx_normal_irq_n[8];
 	unsigned long rx_normal_irq_n[8];
+	/* Dynamic interrupt moderation */
+	unsigned long q_tx_dim_level[8];
+	unsigned long q_rx_dim_level[8];
+	unsigned long tx_dim_changes_n;
+	unsigned long rx_dim_changes_n;
 	unsigned long napi_poll_n;
 	unsigned long tx_clean_n[8];
+	/* NAPI and ring telemetry */
+	unsigned long q_rx_napi_poll_n[8];
+	unsigned long q_tx_napi_poll_n[8];
+	unsigned long q_rx_budget_exhausted_n[8];
+	unsigned long q_tx_budget_exhausted_n[8];
+	unsigned long q_tx_ring_full_n[8];
+	/* descriptors owned by the DMA at the last poll */
+	unsigned long q_rx_desc_inflight[8];
+	unsigned long q_tx_desc_inflight[8];
 	/* EEE */
 	unsigned long tx_path_in_lpi_mode_irq_n;
 	unsigned long tx_path_exit_lpi_mode_irq_n;
@@ -1307,6 +1386,7 @@ struct eqos_extra_stats {
 	unsigned long tx_timestamp_captured_n;
 	unsigned long rx_timestamp_captured_n;
 	unsigned long tx_tso_pkt_n;
+	unsigned long rx_xdp_drop_n;
 
 	/* Tx/Rx frames per channels/queues */
 	unsigned long q_tx_pkt_n[8];
@@ -1478,6 +1558,12 @@ struct eqos_prv_data {
 	unsigned int rx_buffer_len;
 	unsigned int rx_max_frame_size;
 
+	/* RX buffers, see eqos_rx_buf_config() */
+	unsigned int rx_buf_size;	/* DMA size of a buffer */
+	unsigned int rx_buf_truesize;	/* page space used by a buffer */
+	unsigned int rx_page_order;
+	bool rx_page_split;		/* two buffers per page */
+
 	/* variable frame burst size */
 	UINT drop_tx_pktburstcnt;
 	unsigned int mac_enable_count;	/* counter for enabling MAC transmit at
@@ -1494,7 +1580,8 @@ struct eqos_prv_data {
 	unsigned char hwts_rx_en;
 	struct ptp_clock *ptp_clock;
 	struct ptp_clock_info ptp_clock_ops;
-	raw_spinlock_t ptp_lock; /* protects registers */
+	raw_spinlock_t ptp_lock; /* serializes clock adjustments */
+	seqcount_t ptp_seq; /* lets time reads skip ptp_lock */
 	unsigned int default_addend;
 	bool one_nsec_accuracy; /* set to 1 if one nano second accuracy
 				   is enabled else set to zero */
@@ -1506,6 +1593,9 @@ struct eqos_prv_data {
 	/* To store index of last written MAC address filter register */
 	unsigned int mac_addr_idx;
 
+	/* DA based flow steering, see eqos_set_rxnfc() */
+	struct eqos_rx_flow rx_flows[EQOS_MAX_RX_FLOWS];
+
 	/* L3/L4 filtering */
 	unsigned int l3_l4_filter;
 
@@ -1587,6 +1677,11 @@ struct eqos_prv_data {
 	/** Reserve SKB pointer and DMA */
 	struct sk_buff *resv_skb;
 	dma_addr_t resv_dma;
+	/** Dynamic interrupt moderation enabled via ethtool */
+	bool rx_dim_enabled;
+	bool tx_dim_enabled;
+	/** XDP program run on received frames */
+	struct bpf_prog __rcu *xdp_prog;
 };
 
 typedef enum {
@@ -1599,6 +1694,7 @@ typedef enum {
 void eqos_init_function_ptrs_dev(struct hw_if_struct *);
 void eqos_init_function_ptrs_desc(struct desc_if_struct *);
 struct net_device_ops *eqos_get_netdev_ops(void);
+void eqos_xdp_release(struct eqos_prv_data *pdata);
 struct ethtool_ops *eqos_get_ethtool_ops(void);
 int eqos_napi_poll_rx(struct napi_struct *napi, int budget);
 int eqos_napi_poll_tx(struct napi_struct *napi, int budget);
@@ -1624,6 +1720,7 @@ void print_pkt(struct sk_buff *skb, int len, bool tx_rx, int desc_idx);
 void eqos_get_all_hw_features(struct eqos_prv_data *pdata);
 void eqos_print_all_hw_features(struct eqos_prv_data *pdata);
 void eqos_configure_flow_ctrl(struct eqos_prv_data *pdata);
+void eqos_cbs_apply_all(struct eqos_prv_data *pdata);
 u32 eqos_usec2riwt(u32 usec, struct eqos_prv_data *pdata);
 void eqos_init_rx_coalesce(struct eqos_prv_data *pdata);
 void eqos_enable_all_ch_rx_interrpt(struct eqos_prv_data *pdata);
@@ -1635,12 +1732,18 @@ UCHAR get_rx_queue_count(void);
 void eqos_mmc_read(struct eqos_mmc_counters *mmc);
 
 int eqos_ptp_init(struct eqos_prv_data *pdata);
+u64 eqos_ptp_read_time(struct eqos_prv_data *pdata);
 void eqos_ptp_remove(struct eqos_prv_data *pdata);
 bool eqos_eee_init(struct eqos_prv_data *pdata);
 void eqos_handle_eee_interrupt(struct eqos_prv_data *pdata);
 void eqos_disable_eee_mode(struct eqos_prv_data *pdata);
 void eqos_enable_eee_mode(struct eqos_prv_data *pdata);
 
+void eqos_dim_rx_event(struct eqos_prv_data *pdata, UINT qinx);
+void eqos_dim_tx_event(struct eqos_prv_data *pdata, UINT qinx);
+void eqos_dim_rx_enable(struct eqos_prv_data *pdata, bool enable);
+void eqos_dim_tx_enable(struct eqos_prv_data *pdata, bool enable);
+
 int eqos_handle_mem_iso_ioctl(struct eqos_prv_data *pdata, void *ptr);
 int eqos_handle_csr_iso_ioctl(struct eqos_prv_data *pdata, void *ptr);
 int eqos_handle_phy_loopback(struct eqos_prv_data *pdata, void *ptr);
@@ -12,14 +12,43 @@
  */
 
 #include <linux/etherdevice.h>
+#include <linux/hrtimer.h>
 #include <linux/module.h>
 #include <linux/netdevice.h>
 #include <linux/pci.h>
 #include <linux/tegra_vnet.h>
 
+/* Delay of the H2EP data irq to batch packets, 0 raises it per xmit batch */
+static unsigned int tx_coalesce_usecs;
+module_param(tx_coalesce_usecs, uint, 0444);
+MODULE_PARM_DESC(tx_coalesce_usecs, "H2EP data irq coalescing time in usecs");
+
+struct tvnet_priv;
+
+/* One pair of data rings, flows are hashed onto them by the stack */
+struct tvnet_queue {
+	struct tvnet_priv *tvnet;
+	struct napi_struct napi;
+	int qid;
+	struct list_head ep2h_empty_list;
+	/* To protect ep2h empty list */
+	spinlock_t ep2h_empty_lock;
+
+	struct tvnet_counter h2ep_empty;
+	struct tvnet_counter h2ep_full;
+	struct tvnet_counter ep2h_empty;
+	struct tvnet_counter ep2h_full;
+
+	/* EP event index and h2ep_full wr_cnt at the last data irq */
+	u32 *h2ep_full_event;
+	u32 h2ep_full_kick;
+	struct hrtimer kick_timer;
+	/* Own event index of the EP2H full ring */
+	u32 *ep2h_full_event;
+};
+
 struct tvnet_priv {
 	struct net_device *ndev;
-	struct napi_struct napi;
 	struct pci_dev *pdev;
 	void __iomem *mmio_base;
 	void __iomem *msix_tbl;
@@ -27,12 +56,12 @@ struct tvnet_priv {
 	struct bar_md *bar_md;
 	struct ep_ring_buf ep_mem;
 	struct host_ring_buf host_mem;
-	struct list_head ep2h_empty_list;
-	/* To protect ep2h empty list */
-	spinlock_t ep2h_empty_lock;
+	struct tvnet_queue queue[TVNET_NUM_QUEUES];
 	struct tvnet_dma_desc *dma_desc;
 #if ENABLE_DMA
 	struct dma_desc_cnt desc_cnt;
+	/* EP DMA read channel is shared by all queues */
+	spinlock_t dma_lock;
 #endif
 	enum dir_link_state tx_link_state;
 	enum dir_link_state rx_link_state;
@@ -47,10 +76,6 @@ struct tvnet_priv {
 
 	struct tvnet_counter h2ep_ctrl;
 	struct tvnet_counter ep2h_ctrl;
-	struct tvnet_counter h2ep_empty;
-	struct tvnet_counter h2ep_full;
-	struct tvnet_counter ep2h_empty;
-	struct tvnet_counter ep2h_full;
 };
 
 #if ENABLE_DMA
@@ -89,9 +114,9 @@ static void tvnet_host_raise_ep_ctrl_irq(struct tvnet_priv *tvnet)
 	}
 }
 
-static void tvnet_host_raise_ep_data_irq(struct tvnet_priv *tvnet)
+static void tvnet_host_raise_ep_data_irq(struct tvnet_priv *tvnet, int qid)
 {
-	struct irq_md *irq = &tvnet->bar_md->irq_data;
+	struct irq_md *irq = &tvnet->bar_md->irq_data[qid];
 
 	if (irq->irq_type == IRQ_SIMPLE) {
 		/* Can write any value to generate sync point irq */
@@ -105,6 +130,40 @@ static void tvnet_host_raise_ep_data_irq(struct tvnet_priv *tvnet)
 	}
 }
 
+static void tvnet_host_kick_ep_data(struct tvnet_queue *q)
+{
+	u32 wr = tvnet_ivc_get_wr_cnt(&q->h2ep_full);
+
+	if (tvnet_ivc_need_event(READ_ONCE(*q->h2ep_full_event), wr,
+				 q->h2ep_full_kick))
+		tvnet_host_raise_ep_data_irq(q->tvnet, q->qid);
+	q->h2ep_full_kick = wr;
+}
+
+static enum hrtimer_restart tvnet_host_kick_timer(struct hrtimer *t)
+{
+	struct tvnet_queue *q = container_of(t, struct tvnet_queue,
+					     kick_timer);
+
+	tvnet_host_kick_ep_data(q);
+
+	return HRTIMER_NORESTART;
+}
+
+/* Let EP know about new H2EP full msgs, either now or after coalescing */
+static void tvnet_host_flush_ep_data(struct tvnet_queue *q)
+{
+	if (!tx_coalesce_usecs) {
+		tvnet_host_kick_ep_data(q);
+		return;
+	}
+
+	if (!hrtimer_is_queued(&q->kick_timer))
+		hrtimer_start(&q->kick_timer,
+			      ns_to_ktime(tx_coalesce_usecs * NSEC_PER_USEC),
+			      HRTIMER_MODE_REL);
+}
+
 static void tvnet_host_read_ctrl_msg(struct tvnet_priv *tvnet,
 				     struct ctrl_msg *msg)
 {
@@ -149,16 +208,18 @@ static int tvnet_host_write_ctrl_msg(struct tvnet_priv *tvnet,
 	return 0;
 }
 
-static void tvnet_host_alloc_empty_buffers(struct tvnet_priv *tvnet)
+static void tvnet_host_alloc_empty_buffers(struct tvnet_queue *q)
 {
+	struct tvnet_priv *tvnet = q->tvnet;
 	struct net_device *ndev = tvnet->ndev;
 	struct host_ring_buf *host_mem = &tvnet->host_mem;
-	struct data_msg *ep2h_empty_msg = host_mem->ep2h_empty_msgs;
+	struct data_msg *ep2h_empty_msg = host_mem->ep2h_empty_msgs[q->qid];
 	struct ep2h_empty_list *ep2h_empty_ptr;
 	struct device *d = &tvnet->pdev->dev;
 	unsigned long flags;
+	int count = 0;
 
-	while (!tvnet_ivc_full(&tvnet->ep2h_empty)) {
+	while (!tvnet_ivc_full(&q->ep2h_empty)) {
 		struct sk_buff *skb;
 		dma_addr_t iova;
 		int len = ndev->mtu + ETH_HLEN;
@@ -185,11 +246,11 @@ static void tvnet_host_alloc_empty_buffers(struct tvnet_priv *tvnet)
 		ep2h_empty_ptr->skb = skb;
 		ep2h_empty_ptr->iova = iova;
 		ep2h_empty_ptr->len = len;
-		spin_lock_irqsave(&tvnet->ep2h_empty_lock, flags);
-		list_add_tail(&ep2h_empty_ptr->list, &tvnet->ep2h_empty_list);
-		spin_unlock_irqrestore(&tvnet->ep2h_empty_lock, flags);
+		spin_lock_irqsave(&q->ep2h_empty_lock, flags);
+		list_add_tail(&ep2h_empty_ptr->list, &q->ep2h_empty_list);
+		spin_unlock_irqrestore(&q->ep2h_empty_lock, flags);
 
-		idx = tvnet_ivc_get_wr_cnt(&tvnet->ep2h_empty) %
+		idx = tvnet_ivc_get_wr_cnt(&q->ep2h_empty) %
 					RING_COUNT;
 		ep2h_empty_msg[idx].u.empty_buffer.pcie_address = iova;
 		ep2h_empty_msg[idx].u.empty_buffer.buffer_len = len;
@@ -197,10 +258,13 @@ static void tvnet_host_alloc_empty_buffers(struct tvnet_priv *tvnet)
 		 * buffers are updated before updating counters.
 		 */
 		mb();
-		tvnet_ivc_advance_wr(&tvnet->ep2h_empty);
+		tvnet_ivc_advance_wr(&q->ep2h_empty);
+		count++;
+	}
 
+	/* One irq for the whole refill */
+	if (count)
 		tvnet_host_raise_ep_ctrl_irq(tvnet);
-	}
 }
 
 static void tvnet_host_free_empty_buffers(struct tvnet_priv *tvnet)
@@ -208,33 +272,45 @@ static void tvnet_host_free_empty_buffers(struct tvnet_priv *tvnet)
 	struct ep2h_empty_list *ep2h_empty_ptr, *temp;
 	struct device *d = &tvnet->pdev->dev;
 	unsigned long flags;
-
-	spin_lock_irqsave(&tvnet->ep2h_empty_lock, flags);
-	list_for_each_entry_safe(ep2h_empty_ptr, temp, &tvnet->ep2h_empty_list,
-				 list) {
-		list_del(&ep2h_empty_ptr->list);
-		dma_unmap_single(d, ep2h_empty_ptr->iova, ep2h_empty_ptr->len,
-				 DMA_FROM_DEVICE);
-		dev_kfree_skb_any(ep2h_empty_ptr->skb);
-		kfree(ep2h_empty_ptr);
+	int i;
+
+	for (i = 0; i < TVNET_NUM_QUEUES; i++) {
+		struct tvnet_queue *q = &tvnet->queue[i];
+
+		spin_lock_irqsave(&q->ep2h_empty_lock, flags);
+		list_for_each_entry_safe(ep2h_empty_ptr, temp,
+					 &q->ep2h_empty_list, list) {
+			list_del(&ep2h_empty_ptr->list);
+			dma_unmap_single(d, ep2h_empty_ptr->iova,
+					 ep2h_empty_ptr->len, DMA_FROM_DEVICE);
+			dev_kfree_skb_any(ep2h_empty_ptr->skb);
+			kfree(ep2h_empty_ptr);
+		}
+		spin_unlock_irqrestore(&q->ep2h_empty_lock, flags);
 	}
-	spin_unlock_irqrestore(&tvnet->ep2h_empty_lock, flags);
 }
 
 static void tvnet_host_stop_tx_queue(struct tvnet_priv *tvnet)
 {
 	struct net_device *ndev = tvnet->ndev;
+	int i;
 
-	netif_stop_queue(ndev);
+	netif_tx_stop_all_queues(ndev);
 	/* Get tx lock to make sure that there is no ongoing xmit */
 	netif_tx_lock(ndev);
 	netif_tx_unlock(ndev);
+
+	for (i = 0; i < TVNET_NUM_QUEUES; i++)
+		hrtimer_cancel(&tvnet->queue[i].kick_timer);
 }
 
 static void tvnet_host_stop_rx_work(struct tvnet_priv *tvnet)
 {
+	int i;
+
 	/* wait for interrupt handle to return to ensure rx is stopped */
-	synchronize_irq(pci_irq_vector(tvnet->pdev, 1));
+	for (i = 0; i < TVNET_NUM_QUEUES; i++)
+		synchronize_irq(pci_irq_vector(tvnet->pdev, 1 + i));
 }
 
 static void tvnet_host_clear_data_msg_counters(struct tvnet_priv *tvnet)
@@ -243,22 +319,27 @@ static void tvnet_host_clear_data_msg_counters(struct tvnet_priv *tvnet)
 	struct host_own_cnt *host_cnt = host_mem->host_cnt;
 	struct ep_ring_buf *ep_mem = &tvnet->ep_mem;
 	struct ep_own_cnt *ep_cnt = ep_mem->ep_cnt;
-
-	host_cnt->ep2h_empty_wr_cnt = 0;
-	ep_cnt->ep2h_empty_rd_cnt = 0;
-	host_cnt->h2ep_full_wr_cnt = 0;
-	ep_cnt->h2ep_full_rd_cnt = 0;
+	int i;
+
+	for (i = 0; i < TVNET_NUM_QUEUES; i++) {
+		host_cnt->data[i].ep2h_empty_wr_cnt = 0;
+		ep_cnt->data[i].ep2h_empty_rd_cnt = 0;
+		host_cnt->data[i].h2ep_full_wr_cnt = 0;
+		ep_cnt->data[i].h2ep_full_rd_cnt = 0;
+		ep_cnt->data[i].h2ep_full_event = 0;
+		tvnet->queue[i].h2ep_full_kick = 0;
+	}
 }
 
 static void tvnet_host_update_link_state(struct net_device *ndev,
 					 enum os_link_state state)
 {
 	if (state == OS_LINK_STATE_UP) {
-		netif_start_queue(ndev);
+		netif_tx_start_all_queues(ndev);
 		netif_carrier_on(ndev);
 	} else if (state == OS_LINK_STATE_DOWN) {
 		netif_carrier_off(ndev);
-		netif_stop_queue(ndev);
+		netif_tx_stop_all_queues(ndev);
 	} else {
 		pr_err("%s: invalid sate: %d\n", __func__, state);
 	}
@@ -284,9 +365,11 @@ static void tvnet_host_update_link_sm(struct tvnet_priv *tvnet)
 static void tvnet_host_user_link_up_req(struct tvnet_priv *tvnet)
 {
 	struct ctrl_msg msg;
+	int i;
 
 	tvnet_host_clear_data_msg_counters(tvnet);
-	tvnet_host_alloc_empty_buffers(tvnet);
+	for (i = 0; i < TVNET_NUM_QUEUES; i++)
+		tvnet_host_alloc_empty_buffers(&tvnet->queue[i]);
 	msg.msg_id = CTRL_MSG_LINK_UP;
 	tvnet_host_write_ctrl_msg(tvnet, &msg);
 	tvnet->rx_link_state = DIR_LINK_STATE_UP;
@@ -334,11 +417,17 @@ static void tvnet_host_rcv_link_down_ack(struct tvnet_priv *tvnet)
 static int tvnet_host_open(struct net_device *ndev)
 {
 	struct tvnet_priv *tvnet = netdev_priv(ndev);
+	int i;
 
 	mutex_lock(&tvnet->link_state_lock);
 	if (tvnet->rx_link_state == DIR_LINK_STATE_DOWN)
 		tvnet_host_user_link_up_req(tvnet);
-	napi_enable(&tvnet->napi);
+	for (i = 0; i < TVNET_NUM_QUEUES; i++) {
+		struct tvnet_queue *q = &tvnet->queue[i];
+
+		napi_enable(&q->napi);
+		tvnet_ivc_arm_event(&q->ep2h_full, q->ep2h_full_event);
+	}
 	mutex_unlock(&tvnet->link_state_lock);
 
 	return 0;
@@ -348,9 +437,11 @@ static int tvnet_host_close(struct net_device *ndev)
 {
 	struct tvnet_priv *tvnet = netdev_priv(ndev);
 	int ret = 0;
+	int i;
 
 	mutex_lock(&tvnet->link_state_lock);
-	napi_disable(&tvnet->napi);
+	for (i = 0; i < TVNET_NUM_QUEUES; i++)
+		napi_disable(&tvnet->queue[i].napi);
 	if (tvnet->rx_link_state == DIR_LINK_STATE_UP)
 		tvnet_host_user_link_down_req(tvnet);
 
@@ -394,94 +485,42 @@ static int tvnet_host_change_mtu(struct net_device *ndev, int new_mtu)
 	return 0;
 }
 
-static netdev_tx_t tvnet_host_start_xmit(struct sk_buff *skb,
-					 struct net_device *ndev)
-{
-	struct tvnet_priv *tvnet = netdev_priv(ndev);
-	struct host_ring_buf *host_mem = &tvnet->host_mem;
-	struct data_msg *h2ep_full_msg = host_mem->h2ep_full_msgs;
-	struct skb_shared_info *info = skb_shinfo(skb);
-	struct ep_ring_buf *ep_mem = &tvnet->ep_mem;
-	struct data_msg *h2ep_empty_msg = ep_mem->h2ep_empty_msgs;
-	struct device *d = &tvnet->pdev->dev;
 #if ENABLE_DMA
+/*
+ * Queue one EP DMA read desc per segment to consecutive dst addresses and
+ * wait for the chain. Only the last desc raises the done interrupt.
+ */
+static int tvnet_host_dma_xfer(struct tvnet_priv *tvnet,
+			       struct tvnet_dma_seg *segs, int nsegs,
+			       dma_addr_t dst_iova)
+{
 	struct tvnet_dma_desc *dma_desc = tvnet->dma_desc;
 	struct dma_desc_cnt *desc_cnt = &tvnet->desc_cnt;
 	u32 desc_widx, desc_ridx, val;
 	u32 ctrl_d;
 	unsigned long timeout;
-#endif
-	dma_addr_t src_iova;
-	dma_addr_t dst_iova;
-	u32 rd_idx;
-	u32 wr_idx;
-	void *dst_virt;
-	int len;
-
-	/* TODO Not expecting skb frags, remove this after testing */
-	WARN_ON(info->nr_frags);
-
-	/* Check if H2EP_EMPTY_BUF available to read */
-	if (!tvnet_ivc_rd_available(&tvnet->h2ep_empty)) {
-		tvnet_host_raise_ep_ctrl_irq(tvnet);
-		pr_debug("%s: No H2EP empty msg, stop tx\n", __func__);
-		netif_stop_queue(ndev);
-		return NETDEV_TX_BUSY;
-	}
-
-	/* Check if H2EP_FULL_BUF available to write */
-	if (tvnet_ivc_full(&tvnet->h2ep_full)) {
-		tvnet_host_raise_ep_ctrl_irq(tvnet);
-		pr_debug("%s: No H2EP full buf, stop tx\n", __func__);
-		netif_stop_queue(ndev);
-		return NETDEV_TX_BUSY;
-	}
-
-#if ENABLE_DMA
-	/* Check if dma desc available */
-	if ((desc_cnt->wr_cnt - desc_cnt->rd_cnt) >= DMA_DESC_COUNT) {
-		pr_debug("%s: dma descriptors are not available\n", __func__);
-		netif_stop_queue(ndev);
-		return NETDEV_TX_BUSY;
-	}
-#endif
-
-	len = skb_headlen(skb);
-
-	src_iova = dma_map_single(d, skb->data, len, DMA_TO_DEVICE);
-	if (dma_mapping_error(d, src_iova)) {
-		pr_err("%s: dma_map_single failed\n", __func__);
-		dev_kfree_skb_any(skb);
-		return NETDEV_TX_OK;
+	int i;
+
+	spin_lock(&tvnet->dma_lock);
+
+	for (i = 0; i < nsegs; i++) {
+		desc_widx = (desc_cnt->wr_cnt + i) % DMA_DESC_COUNT;
+		dma_desc[desc_widx].size = segs[i].len;
+		dma_desc[desc_widx].sar_low = lower_32_bits(segs[i].iova);
+		dma_desc[desc_widx].sar_high = upper_32_bits(segs[i].iova);
+		dma_desc[desc_widx].dar_low = lower_32_bits(dst_iova);
+		dma_desc[desc_widx].dar_high = upper_32_bits(dst_iova);
+		dst_iova += segs[i].len;
+		/* CB bit should be set at the end */
+		mb();
+		ctrl_d = DMA_CH_CONTROL1_OFF_RDCH_CB;
+		if (i == nsegs - 1) {
+			/* RIE is not required for polling mode */
+			ctrl_d |= DMA_CH_CONTROL1_OFF_RDCH_RIE;
+			ctrl_d |= DMA_CH_CONTROL1_OFF_RDCH_LIE;
+		}
+		dma_desc[desc_widx].ctrl_reg.ctrl_d = ctrl_d;
 	}
-
-	/* Get H2EP empty msg */
-	rd_idx = tvnet_ivc_get_rd_cnt(&tvnet->h2ep_empty) %
-				RING_COUNT;
-	dst_iova = h2ep_empty_msg[rd_idx].u.empty_buffer.pcie_address;
-	dst_virt = tvnet->mmio_base + (dst_iova - tvnet->bar_md->bar0_base_phy);
-	/* Advance read count after all failure cases complated, to avoid
-	 * dangling buffer at endpoint.
-	 */
-	tvnet_ivc_advance_rd(&tvnet->h2ep_empty);
-	/* Raise an interrupt to let EP populate H2EP_EMPTY_BUF ring */
-	tvnet_host_raise_ep_ctrl_irq(tvnet);
-
-#if ENABLE_DMA
-	/* Trigger DMA write from src_iova to dst_iova */
-	desc_widx = desc_cnt->wr_cnt % DMA_DESC_COUNT;
-	dma_desc[desc_widx].size = len;
-	dma_desc[desc_widx].sar_low = lower_32_bits(src_iova);
-	dma_desc[desc_widx].sar_high = upper_32_bits(src_iova);
-	dma_desc[desc_widx].dar_low = lower_32_bits(dst_iova);
-	dma_desc[desc_widx].dar_high = upper_32_bits(dst_iova);
-	/* CB bit should be set at the end */
-	mb();
-	/* RIE is not required for polling mode */
-	ctrl_d = DMA_CH_CONTROL1_OFF_RDCH_RIE;
-	ctrl_d |= DMA_CH_CONTROL1_OFF_RDCH_LIE;
-	ctrl_d |= DMA_CH_CONTROL1_OFF_RDCH_CB;
-	dma_desc[desc_widx].ctrl_reg.ctrl_d = ctrl_d;
 	/*
 	 * Read after write to avoid EP DMA reading LLE before CB is written to
 	 * EP's system memory.
@@ -494,7 +533,7 @@ static netdev_tx_t tvnet_host_start_xmit(struct sk_buff *skb,
 	timeout = jiffies + msecs_to_jiffies(1000);
 	dma_common_wr(tvnet->dma_base, DMA_RD_DATA_CH, DMA_READ_DOORBELL_OFF);
 
-	desc_cnt->wr_cnt++;
+	desc_cnt->wr_cnt += nsegs;
 
 	while (true) {
 		val = dma_common_rd(tvnet->dma_base, DMA_READ_INT_STATUS_OFF);
@@ -512,42 +551,142 @@ static netdev_tx_t tvnet_host_start_xmit(struct sk_buff *skb,
 			dma_common_wr(tvnet->dma_base,
 				      DMA_READ_ENGINE_EN_OFF_ENABLE,
 				      DMA_READ_ENGINE_EN_OFF);
-			desc_cnt->wr_cnt--;
-			dma_unmap_single(d, src_iova, len, DMA_TO_DEVICE);
-			return NETDEV_TX_BUSY;
+			desc_cnt->wr_cnt -= nsegs;
+			spin_unlock(&tvnet->dma_lock);
+			return -ETIMEDOUT;
 		}
 	}
 
-	desc_ridx = tvnet->desc_cnt.rd_cnt % DMA_DESC_COUNT;
-	/* Clear DMA cycle bit and increment rd_cnt */
-	dma_desc[desc_ridx].ctrl_reg.ctrl_e.cb = 0;
+	/* Clear DMA cycle bits and increment rd_cnt */
+	for (i = 0; i < nsegs; i++) {
+		desc_ridx = desc_cnt->rd_cnt % DMA_DESC_COUNT;
+		dma_desc[desc_ridx].ctrl_reg.ctrl_e.cb = 0;
+		desc_cnt->rd_cnt++;
+	}
 	mb();
 
-	tvnet->desc_cnt.rd_cnt++;
-#else
-	/* Copy skb->data to endpoint dst address, use CPU virt addr */
-	memcpy(dst_virt, skb->data, len);
-	/* BAR0 mmio address is wc mem, add mb to make sure that complete
-	 * skb->data is written before updating counters.
+	spin_unlock(&tvnet->dma_lock);
+
+	return 0;
+}
+#endif
+
+static netdev_tx_t tvnet_host_start_xmit(struct sk_buff *skb,
+					 struct net_device *ndev)
+{
+	struct tvnet_priv *tvnet = netdev_priv(ndev);
+	int qid = skb_get_queue_mapping(skb);
+	struct tvnet_queue *q = &tvnet->queue[qid];
+	struct host_ring_buf *host_mem = &tvnet->host_mem;
+	struct data_msg *h2ep_full_msg = host_mem->h2ep_full_msgs[qid];
+	struct ep_ring_buf *ep_mem = &tvnet->ep_mem;
+	struct data_msg *h2ep_empty_msg = ep_mem->h2ep_empty_msgs[qid];
+#if ENABLE_DMA
+	struct device *d = &tvnet->pdev->dev;
+	struct dma_desc_cnt *desc_cnt = &tvnet->desc_cnt;
+	struct tvnet_dma_seg segs[TVNET_MAX_DMA_SEGS];
+	int nsegs = 0;
+#endif
+	dma_addr_t dst_iova;
+	u32 rd_idx;
+	u32 wr_idx;
+	u32 empty_left;
+	void *dst_virt;
+
+	/* Check if H2EP_EMPTY_BUF available to read */
+	if (!tvnet_ivc_rd_available(&q->h2ep_empty)) {
+		tvnet_host_raise_ep_ctrl_irq(tvnet);
+		tvnet_host_kick_ep_data(q);
+		pr_debug("%s: No H2EP empty msg, stop tx\n", __func__);
+		netif_stop_subqueue(ndev, qid);
+		return NETDEV_TX_BUSY;
+	}
+
+	/* Check if H2EP_FULL_BUF available to write */
+	if (tvnet_ivc_full(&q->h2ep_full)) {
+		tvnet_host_raise_ep_ctrl_irq(tvnet);
+		tvnet_host_kick_ep_data(q);
+		pr_debug("%s: No H2EP full buf, stop tx\n", __func__);
+		netif_stop_subqueue(ndev, qid);
+		return NETDEV_TX_BUSY;
+	}
+
+#if ENABLE_DMA
+	if (skb->len > TVNET_DMA_COPYBREAK) {
+		/* Check if dma desc available */
+		if ((desc_cnt->wr_cnt - desc_cnt->rd_cnt) +
+		    skb_shinfo(skb)->nr_frags + 1 > DMA_DESC_COUNT) {
+			pr_debug("%s: dma descriptors are not available\n",
+				 __func__);
+			tvnet_host_kick_ep_data(q);
+			netif_stop_subqueue(ndev, qid);
+			return NETDEV_TX_BUSY;
+		}
+
+		nsegs = tvnet_dma_map_skb(d, skb, segs);
+		if (nsegs < 0) {
+			pr_err("%s: dma map failed\n", __func__);
+			tvnet_host_kick_ep_data(q);
+			dev_kfree_skb_any(skb);
+			return NETDEV_TX_OK;
+		}
+	}
+#endif
+
+	/* Get H2EP empty msg */
+	rd_idx = tvnet_ivc_get_rd_cnt(&q->h2ep_empty) %
+				RING_COUNT;
+	dst_iova = h2ep_empty_msg[rd_idx].u.empty_buffer.pcie_address;
+	dst_virt = tvnet->mmio_base + (dst_iova - tvnet->bar_md->bar0_base_phy);
+	/* Advance read count after all failure cases complated, to avoid
+	 * dangling buffer at endpoint.
 	 */
-	mb();
+	tvnet_ivc_advance_rd(&q->h2ep_empty);
+	/*
+	 * Raise an interrupt to let EP populate H2EP_EMPTY_BUF ring once
+	 * it is half used, or when it runs empty.
+	 */
+	empty_left = tvnet_ivc_rd_available(&q->h2ep_empty);
+	if (empty_left == TVNET_REFILL_THRESH || !empty_left)
+		tvnet_host_raise_ep_ctrl_irq(tvnet);
+
+#if ENABLE_DMA
+	if (nsegs > 0) {
+		/* Trigger DMA write from skb segments to dst_iova */
+		if (tvnet_host_dma_xfer(tvnet, segs, nsegs, dst_iova) < 0) {
+			tvnet_dma_unmap_skb(d, segs, nsegs);
+			tvnet_host_kick_ep_data(q);
+			return NETDEV_TX_BUSY;
+		}
+		tvnet_dma_unmap_skb(d, segs, nsegs);
+	} else
 #endif
+	{
+		/* Copy skb to endpoint dst address, use CPU virt addr */
+		skb_copy_bits(skb, 0, dst_virt, skb->len);
+		/* BAR0 mmio address is wc mem, add mb to make sure that
+		 * complete skb data is written before updating counters.
+		 */
+		mb();
+	}
 
 	/* Push dst to H2EP full ring */
-	wr_idx = tvnet_ivc_get_wr_cnt(&tvnet->h2ep_full) %
+	wr_idx = tvnet_ivc_get_wr_cnt(&q->h2ep_full) %
 				RING_COUNT;
-	h2ep_full_msg[wr_idx].u.full_buffer.packet_size = len;
+	h2ep_full_msg[wr_idx].u.full_buffer.packet_size = skb->len;
 	h2ep_full_msg[wr_idx].u.full_buffer.pcie_address = dst_iova;
 	h2ep_full_msg[wr_idx].msg_id = DATA_MSG_FULL_BUF;
 	/* BAR0 mmio address is wc mem, add mb to make sure that full
 	 * buffer is written before updating counters.
 	 */
 	mb();
-	tvnet_ivc_advance_wr(&tvnet->h2ep_full);
-	tvnet_host_raise_ep_data_irq(tvnet);
+	tvnet_ivc_advance_wr(&q->h2ep_full);
+	/* Ring the doorbell once for a batch of packets from the stack */
+	if (!skb->xmit_more ||
+	    netif_xmit_stopped(netdev_get_tx_queue(ndev, qid)))
+		tvnet_host_flush_ep_data(q);
 
 	/* Free skb */
-	dma_unmap_single(d, src_iova, len, DMA_TO_DEVICE);
 	dev_kfree_skb_any(skb);
 
 	return NETDEV_TX_OK;
@@ -564,26 +703,21 @@ static void tvnet_host_setup_bar0_md(struct tvnet_priv *tvnet)
 {
 	struct ep_ring_buf *ep_mem = &tvnet->ep_mem;
 	struct host_ring_buf *host_mem = &tvnet->host_mem;
+	struct bar_md *bar_md;
+	int i;
 
 	tvnet->bar_md = (struct bar_md *)tvnet->mmio_base;
+	bar_md = tvnet->bar_md;
 
 	ep_mem->ep_cnt = (struct ep_own_cnt *)(tvnet->mmio_base +
 					tvnet->bar_md->ep_own_cnt_offset);
 	ep_mem->ep2h_ctrl_msgs = (struct ctrl_msg *)(tvnet->mmio_base +
 					tvnet->bar_md->ctrl_md.ep2h_offset);
-	ep_mem->ep2h_full_msgs = (struct data_msg *)(tvnet->mmio_base +
-					tvnet->bar_md->ep2h_md.ep2h_offset);
-	ep_mem->h2ep_empty_msgs = (struct data_msg *)(tvnet->mmio_base +
-					tvnet->bar_md->h2ep_md.ep2h_offset);
 
 	host_mem->host_cnt = (struct host_own_cnt *)(tvnet->mmio_base +
 					tvnet->bar_md->host_own_cnt_offset);
 	host_mem->h2ep_ctrl_msgs = (struct ctrl_msg *)(tvnet->mmio_base +
 					tvnet->bar_md->ctrl_md.h2ep_offset);
-	host_mem->ep2h_empty_msgs = (struct data_msg *)(tvnet->mmio_base +
-					tvnet->bar_md->ep2h_md.h2ep_offset);
-	host_mem->h2ep_full_msgs = (struct data_msg *)(tvnet->mmio_base +
-					tvnet->bar_md->h2ep_md.h2ep_offset);
 
 	tvnet->dma_desc = (struct tvnet_dma_desc *)(tvnet->mmio_base +
 					tvnet->bar_md->host_dma_offset);
@@ -592,14 +726,33 @@ static void tvnet_host_setup_bar0_md(struct tvnet_priv *tvnet)
 	tvnet->h2ep_ctrl.wr = &host_mem->host_cnt->h2ep_ctrl_wr_cnt;
 	tvnet->ep2h_ctrl.rd = &host_mem->host_cnt->ep2h_ctrl_rd_cnt;
 	tvnet->ep2h_ctrl.wr = &ep_mem->ep_cnt->ep2h_ctrl_wr_cnt;
-	tvnet->h2ep_empty.rd = &host_mem->host_cnt->h2ep_empty_rd_cnt;
-	tvnet->h2ep_empty.wr = &ep_mem->ep_cnt->h2ep_empty_wr_cnt;
-	tvnet->h2ep_full.rd = &ep_mem->ep_cnt->h2ep_full_rd_cnt;
-	tvnet->h2ep_full.wr = &host_mem->host_cnt->h2ep_full_wr_cnt;
-	tvnet->ep2h_empty.rd = &ep_mem->ep_cnt->ep2h_empty_rd_cnt;
-	tvnet->ep2h_empty.wr = &host_mem->host_cnt->ep2h_empty_wr_cnt;
-	tvnet->ep2h_full.rd = &host_mem->host_cnt->ep2h_full_rd_cnt;
-	tvnet->ep2h_full.wr = &ep_mem->ep_cnt->ep2h_full_wr_cnt;
+
+	for (i = 0; i < TVNET_NUM_QUEUES; i++) {
+		struct ep_own_data_cnt *ep_cnt = &ep_mem->ep_cnt->data[i];
+		struct host_own_data_cnt *host_cnt =
+					&host_mem->host_cnt->data[i];
+		struct tvnet_queue *q = &tvnet->queue[i];
+
+		ep_mem->ep2h_full_msgs[i] = (struct data_msg *)
+			(tvnet->mmio_base + bar_md->ep2h_md[i].ep2h_offset);
+		ep_mem->h2ep_empty_msgs[i] = (struct data_msg *)
+			(tvnet->mmio_base + bar_md->h2ep_md[i].ep2h_offset);
+		host_mem->ep2h_empty_msgs[i] = (struct data_msg *)
+			(tvnet->mmio_base + bar_md->ep2h_md[i].h2ep_offset);
+		host_mem->h2ep_full_msgs[i] = (struct data_msg *)
+			(tvnet->mmio_base + bar_md->h2ep_md[i].h2ep_offset);
+
+		q->h2ep_empty.rd = &host_cnt->h2ep_empty_rd_cnt;
+		q->h2ep_empty.wr = &ep_cnt->h2ep_empty_wr_cnt;
+		q->h2ep_full.rd = &ep_cnt->h2ep_full_rd_cnt;
+		q->h2ep_full.wr = &host_cnt->h2ep_full_wr_cnt;
+		q->ep2h_empty.rd = &ep_cnt->ep2h_empty_rd_cnt;
+		q->ep2h_empty.wr = &host_cnt->ep2h_empty_wr_cnt;
+		q->ep2h_full.rd = &host_cnt->ep2h_full_rd_cnt;
+		q->ep2h_full.wr = &ep_cnt->ep2h_full_wr_cnt;
+		q->h2ep_full_event = &ep_cnt->h2ep_full_event;
+		q->ep2h_full_event = &host_cnt->ep2h_full_event;
+	}
 }
 
 static void tvnet_host_process_ctrl_msg(struct tvnet_priv *tvnet)
@@ -617,17 +770,18 @@ static void tvnet_host_process_ctrl_msg(struct tvnet_priv *tvnet)
 	}
 }
 
-static int tvnet_host_process_ep2h_msg(struct tvnet_priv *tvnet)
+static int tvnet_host_process_ep2h_msg(struct tvnet_queue *q)
 {
+	struct tvnet_priv *tvnet = q->tvnet;
 	struct ep_ring_buf *ep_mem = &tvnet->ep_mem;
-	struct data_msg *data_msg = ep_mem->ep2h_full_msgs;
+	struct data_msg *data_msg = ep_mem->ep2h_full_msgs[q->qid];
 	struct device *d = &tvnet->pdev->dev;
 	struct ep2h_empty_list *ep2h_empty_ptr;
 	struct net_device *ndev = tvnet->ndev;
 	int count = 0;
 
 	while ((count < TVNET_NAPI_WEIGHT) &&
-	       tvnet_ivc_rd_available(&tvnet->ep2h_full)) {
+	       tvnet_ivc_rd_available(&q->ep2h_full)) {
 		struct sk_buff *skb;
 		u64 pcie_address;
 		u32 len;
@@ -635,13 +789,13 @@ static int tvnet_host_process_ep2h_msg(struct tvnet_priv *tvnet)
 		unsigned long flags;
 
 		/* Read EP2H full msg */
-		idx = tvnet_ivc_get_rd_cnt(&tvnet->ep2h_full) %
+		idx = tvnet_ivc_get_rd_cnt(&q->ep2h_full) %
 					RING_COUNT;
 		len = data_msg[idx].u.full_buffer.packet_size;
 		pcie_address = data_msg[idx].u.full_buffer.pcie_address;
 
-		spin_lock_irqsave(&tvnet->ep2h_empty_lock, flags);
-		list_for_each_entry(ep2h_empty_ptr, &tvnet->ep2h_empty_list,
+		spin_lock_irqsave(&q->ep2h_empty_lock, flags);
+		list_for_each_entry(ep2h_empty_ptr, &q->ep2h_empty_list,
 				    list) {
 			if (ep2h_empty_ptr->iova == pcie_address) {
 				found = 1;
@@ -650,26 +804,29 @@ static int tvnet_host_process_ep2h_msg(struct tvnet_priv *tvnet)
 		}
 		WARN_ON(!found);
 		list_del(&ep2h_empty_ptr->list);
-		spin_unlock_irqrestore(&tvnet->ep2h_empty_lock, flags);
+		spin_unlock_irqrestore(&q->ep2h_empty_lock, flags);
 
 		/* Advance H2EP full buffer after search in local list */
-		tvnet_ivc_advance_rd(&tvnet->ep2h_full);
-		/* If EP2H network queue is stopped due to lack of EP2H_FULL
-		 * queue, raising ctrl irq will help.
-		 */
-		tvnet_host_raise_ep_ctrl_irq(tvnet);
+		tvnet_ivc_advance_rd(&q->ep2h_full);
 
 		dma_unmap_single(d, pcie_address, ndev->mtu + ETH_HLEN, DMA_FROM_DEVICE);
 		skb = ep2h_empty_ptr->skb;
 		skb_put(skb, len);
 		skb->protocol = eth_type_trans(skb, ndev);
-		napi_gro_receive(&tvnet->napi, skb);
+		skb_record_rx_queue(skb, q->qid);
+		napi_gro_receive(&q->napi, skb);
 
 		/* Free EP2H empty list element */
 		kfree(ep2h_empty_ptr);
 		count++;
 	}
 
+	/* If EP2H network queue is stopped due to lack of EP2H_FULL
+	 * queue, raising ctrl irq will help.
+	 */
+	if (count)
+		tvnet_host_raise_ep_ctrl_irq(tvnet);
+
 	return count;
 }
 
@@ -677,34 +834,41 @@ static irqreturn_t tvnet_irq_ctrl(int irq, void *data)
 {
 	struct net_device *ndev = data;
 	struct tvnet_priv *tvnet = netdev_priv(ndev);
+	int i;
+
+	for (i = 0; i < TVNET_NUM_QUEUES; i++) {
+		struct tvnet_queue *q = &tvnet->queue[i];
 
-	if (netif_queue_stopped(ndev)) {
-		if ((tvnet->os_link_state == OS_LINK_STATE_UP) &&
-		    tvnet_ivc_rd_available(&tvnet->h2ep_empty) &&
-		    !tvnet_ivc_full(&tvnet->h2ep_full)) {
-			pr_debug("%s: wake net tx queue\n", __func__);
-			netif_wake_queue(ndev);
+		if (__netif_subqueue_stopped(ndev, i) &&
+		    (tvnet->os_link_state == OS_LINK_STATE_UP) &&
+		    tvnet_ivc_rd_available(&q->h2ep_empty) &&
+		    !tvnet_ivc_full(&q->h2ep_full)) {
+			pr_debug("%s: wake net tx queue %d\n", __func__, i);
+			netif_wake_subqueue(ndev, i);
 		}
 	}
 
 	if (tvnet_ivc_rd_available(&tvnet->ep2h_ctrl))
 		tvnet_host_process_ctrl_msg(tvnet);
 
-	if (!tvnet_ivc_full(&tvnet->ep2h_empty) &&
-	    (tvnet->os_link_state == OS_LINK_STATE_UP))
-		tvnet_host_alloc_empty_buffers(tvnet);
+	for (i = 0; i < TVNET_NUM_QUEUES; i++) {
+		struct tvnet_queue *q = &tvnet->queue[i];
+
+		if (!tvnet_ivc_full(&q->ep2h_empty) &&
+		    (tvnet->os_link_state == OS_LINK_STATE_UP))
+			tvnet_host_alloc_empty_buffers(q);
+	}
 
 	return IRQ_HANDLED;
 }
 
 static irqreturn_t tvnet_irq_data(int irq, void *data)
 {
-	struct net_device *ndev = data;
-	struct tvnet_priv *tvnet = netdev_priv(ndev);
+	struct tvnet_queue *q = data;
 
-	if (tvnet_ivc_rd_available(&tvnet->ep2h_full)) {
-		disable_irq_nosync(pci_irq_vector(tvnet->pdev, 1));
-		napi_schedule(&tvnet->napi);
+	if (tvnet_ivc_rd_available(&q->ep2h_full)) {
+		disable_irq_nosync(irq);
+		napi_schedule(&q->napi);
 	}
 
 	return IRQ_HANDLED;
@@ -712,14 +876,23 @@ static irqreturn_t tvnet_irq_data(int irq, void *data)
 
 static int tvnet_host_poll(struct napi_struct *napi, int budget)
 {
-	struct tvnet_priv *tvnet = container_of(napi, struct tvnet_priv, napi);
+	struct tvnet_queue *q = container_of(napi, struct tvnet_queue, napi);
+	struct tvnet_priv *tvnet = q->tvnet;
 	int work_done;
 
-	work_done = tvnet_host_process_ep2h_msg(tvnet);
+	work_done = tvnet_host_process_ep2h_msg(q);
 	trace_printk("work_done: %d budget: %d\n", work_done, budget);
 	if (work_done < budget) {
 		napi_complete(napi);
-		enable_irq(pci_irq_vector(tvnet->pdev, 1));
+		/*
+		 * Ask EP for an irq on the next msg, then catch the ones
+		 * written before it could see the request.
+		 */
+		tvnet_ivc_arm_event(&q->ep2h_full, q->ep2h_full_event);
+		if (tvnet_ivc_rd_available(&q->ep2h_full) &&
+		    napi_reschedule(napi))
+			return work_done;
+		enable_irq(pci_irq_vector(tvnet->pdev, 1 + q->qid));
 		mmiowb();
 	}
 
@@ -731,11 +904,11 @@ static int tvnet_host_probe(struct pci_dev *pdev,
 {
 	struct tvnet_priv *tvnet;
 	struct net_device *ndev;
-	int ret;
+	int ret, i;
 
 	dev_dbg(&pdev->dev, "%s: PCIe VID: 0x%x DID: 0x%x\n", __func__,
 		pci_id->vendor, pci_id->device);
-	ndev = alloc_etherdev(sizeof(struct tvnet_priv));
+	ndev = alloc_etherdev_mq(sizeof(struct tvnet_priv), TVNET_NUM_QUEUES);
 	if (!ndev) {
 		ret = -ENOMEM;
 		dev_err(&pdev->dev, "alloc_etherdev() failed");
@@ -750,6 +923,21 @@ static int tvnet_host_probe(struct pci_dev *pdev,
 	tvnet->pdev = pdev;
 	pci_set_drvdata(pdev, tvnet);
 
+	for (i = 0; i < TVNET_NUM_QUEUES; i++) {
+		struct tvnet_queue *q = &tvnet->queue[i];
+
+		q->tvnet = tvnet;
+		q->qid = i;
+		INIT_LIST_HEAD(&q->ep2h_empty_list);
+		spin_lock_init(&q->ep2h_empty_lock);
+		hrtimer_init(&q->kick_timer, CLOCK_MONOTONIC,
+			     HRTIMER_MODE_REL);
+		q->kick_timer.function = tvnet_host_kick_timer;
+	}
+#if ENABLE_DMA
+	spin_lock_init(&tvnet->dma_lock);
+#endif
+
 	ret = pci_enable_device(pdev);
 	if (ret) {
 		dev_err(&pdev->dev, "pci_enable_device() failed: %d\n", ret);
@@ -799,9 +987,14 @@ static int tvnet_host_probe(struct pci_dev *pdev,
 	/* Setup BAR0 meta data */
 	tvnet_host_setup_bar0_md(tvnet);
 
-	netif_napi_add(ndev, &tvnet->napi, tvnet_host_poll, TVNET_NAPI_WEIGHT);
+	for (i = 0; i < TVNET_NUM_QUEUES; i++)
+		netif_napi_add(ndev, &tvnet->queue[i].napi, tvnet_host_poll,
+			       TVNET_NAPI_WEIGHT);
 
 	ndev->mtu = TVNET_DEFAULT_MTU;
+	/* skb frags are sent with one DMA desc each */
+	ndev->hw_features |= NETIF_F_SG;
+	ndev->features |= NETIF_F_SG;
 
 	ret = register_netdev(ndev);
 	if (ret) {
@@ -816,8 +1009,10 @@ static int tvnet_host_probe(struct pci_dev *pdev,
 	mutex_init(&tvnet->link_state_lock);
 	init_waitqueue_head(&tvnet->link_state_wq);
 
-	ret = pci_alloc_irq_vectors(pdev, 2, 2, PCI_IRQ_MSIX |
-				    PCI_IRQ_AFFINITY);
+	/* Vector 0 is for control messages, one more per data queue */
+	ret = pci_alloc_irq_vectors(pdev, 1 + TVNET_NUM_QUEUES,
+				    1 + TVNET_NUM_QUEUES,
+				    PCI_IRQ_MSIX | PCI_IRQ_AFFINITY);
 	if (ret <= 0) {
 		dev_err(&pdev->dev, "pci_alloc_irq_vectors() fail: %d\n", ret);
 		ret = -EIO;
@@ -831,30 +1026,32 @@ static int tvnet_host_probe(struct pci_dev *pdev,
 		goto disable_msi;
 	}
 
-	ret = request_irq(pci_irq_vector(pdev, 1), tvnet_irq_data, 0,
-			  ndev->name, ndev);
-	if (ret < 0) {
-		dev_err(&pdev->dev, "request_irq() fail: %d\n", ret);
-		goto fail_request_irq_ctrl;
+	for (i = 0; i < TVNET_NUM_QUEUES; i++) {
+		ret = request_irq(pci_irq_vector(pdev, 1 + i), tvnet_irq_data,
+				  0, ndev->name, &tvnet->queue[i]);
+		if (ret < 0) {
+			dev_err(&pdev->dev, "request_irq() fail: %d\n", ret);
+			goto fail_request_irq_data;
+		}
 	}
 
 #if ENABLE_DMA
 	tvnet_host_write_dma_msix_settings(tvnet);
 #endif
 
-	INIT_LIST_HEAD(&tvnet->ep2h_empty_list);
-	spin_lock_init(&tvnet->ep2h_empty_lock);
-
 	return 0;
 
-fail_request_irq_ctrl:
+fail_request_irq_data:
+	while (--i >= 0)
+		free_irq(pci_irq_vector(pdev, 1 + i), &tvnet->queue[i]);
 	free_irq(pci_irq_vector(pdev, 0), ndev);
 disable_msi:
 	pci_free_irq_vectors(pdev);
 unreg_netdev:
 	unregister_netdev(ndev);
 pci_disable:
-	netif_napi_del(&tvnet->napi);
+	for (i = 0; i < TVNET_NUM_QUEUES; i++)
+		netif_napi_del(&tvnet->queue[i].napi);
 	pci_disable_device(pdev);
 free_netdev:
 	free_netdev(ndev);
@@ -865,8 +1062,10 @@ fail:
 static int tvnet_host_suspend(struct pci_dev *pdev, pm_message_t state)
 {
 	struct tvnet_priv *tvnet = pci_get_drvdata(pdev);
+	int i;
 
-	disable_irq(pci_irq_vector(tvnet->pdev, 1));
+	for (i = 0; i < TVNET_NUM_QUEUES; i++)
+		disable_irq(pci_irq_vector(tvnet->pdev, 1 + i));
 
 	if (tvnet->rx_link_state == DIR_LINK_STATE_UP) {
 		tvnet_host_close(tvnet->ndev);
@@ -879,6 +1078,7 @@ static int tvnet_host_suspend(struct pci_dev *pdev, pm_message_t state)
 static int tvnet_host_resume(struct pci_dev *pdev)
 {
 	struct tvnet_priv *tvnet = pci_get_drvdata(pdev);
+	int i;
 #if ENABLE_DMA
 	struct dma_desc_cnt *desc_cnt = &tvnet->desc_cnt;
 
@@ -891,7 +1091,8 @@ static int tvnet_host_resume(struct pci_dev *pdev)
 		tvnet->pm_closed = false;
 	}
 
-	enable_irq(pci_irq_vector(tvnet->pdev, 1));
+	for (i = 0; i < TVNET_NUM_QUEUES; i++)
+		enable_irq(pci_irq_vector(tvnet->pdev, 1 + i));
 
 	return 0;
 }
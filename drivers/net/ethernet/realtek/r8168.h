@@ -376,6 +376,8 @@ This is free software, and you are welcome to redistribute it under certain cond
 #define NUM_RX_DESC 1024    /* Number of Rx descriptor registers */
 
 #define RX_BUF_SIZE 0x05F3  /* 0x05F3 = 1522bye + 1 */
+#define RX_HDR_SIZE 256     /* Linear part of skbs built from Rx pages */
+#define RX_COPYBREAK 256    /* Frames below this are copied, the page stays */
 #define R8168_TX_RING_BYTES (NUM_TX_DESC * sizeof(struct TxDesc))
 #define R8168_RX_RING_BYTES (NUM_RX_DESC * sizeof(struct RxDesc))
 
@@ -1377,6 +1379,13 @@ struct ring_info {
         u8      __pad[sizeof(void *) - sizeof(u32)];
 };
 
+/* Rx buffer, a part of a page that is recycled while the stack frees it */
+struct rtl8168_rx_buffer {
+        struct page     *page;
+        dma_addr_t      dma;
+        unsigned int    page_offset;
+};
+
 struct pci_resource {
         u8  cmd;
         u8  cls;
@@ -1425,9 +1434,12 @@ struct rtl8168_private {
         struct RxDesc *RxDescArray; /* 256-aligned Rx descriptor ring */
         dma_addr_t TxPhyAddr;
         dma_addr_t RxPhyAddr;
-        struct sk_buff *Rx_skbuff[NUM_RX_DESC]; /* Rx data buffers */
+        struct rtl8168_rx_buffer Rx_buffer[NUM_RX_DESC]; /* Rx data buffers */
         struct ring_info tx_skb[NUM_TX_DESC];   /* Tx data buffers */
         unsigned rx_buf_sz;
+        unsigned rx_buf_truesize;   /* Rx page space used by one buffer */
+        unsigned rx_page_order;
+        unsigned rx_copybreak;
         struct timer_list esd_timer;
         struct timer_list link_timer;
         struct pci_resource pci_cfg_space;
@@ -1614,6 +1626,8 @@ struct rtl8168_private {
         PPGDEV	pgdev;
 
 	bool first_link_up;
+	/* probe order, spreads the interrupts of the ports over the CPUs */
+	int board_idx;
 };
 
 enum eetype {
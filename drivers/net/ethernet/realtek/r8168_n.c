@@ -315,9 +315,10 @@ static struct pci_device_id rtl8168_pci_tbl[] = {
 
 MODULE_DEVICE_TABLE(pci, rtl8168_pci_tbl);
 
-static int rx_copybreak = 0;
+static int rx_copybreak = RX_COPYBREAK;
 static int use_dac = 1;
 static int timer_count = 0x2600;
+static int irq_cpu = -1;
 
 static struct {
         u32 msg_enable;
@@ -379,7 +380,7 @@ module_param(s5_keep_curr_mac, int, 0);
 MODULE_PARM_DESC(s5_keep_curr_mac, "Enable Shutdown Keep Current MAC Address.");
 
 module_param(rx_copybreak, int, 0);
-MODULE_PARM_DESC(rx_copybreak, "Copy breakpoint for copy-only-tiny-frames");
+MODULE_PARM_DESC(rx_copybreak, "Copy breakpoint for copy-only-tiny-frames, per device with ethtool --set-tunable rx-copybreak");
 
 module_param(use_dac, int, 0);
 MODULE_PARM_DESC(use_dac, "Enable PCI DAC. Unsafe on 32 bit PCI slot.");
@@ -396,6 +397,9 @@ MODULE_PARM_DESC(hwoptimize, "Enable HW optimization function.");
 module_param(s0_magic_packet, int, 0);
 MODULE_PARM_DESC(s0_magic_packet, "Enable S0 Magic Packet.");
 
+module_param(irq_cpu, int, 0);
+MODULE_PARM_DESC(irq_cpu, "CPU for the interrupt and NAPI of all ports, -1 spreads the ports over the CPUs.");
+
 #if LINUX_VERSION_CODE > KERNEL_VERSION(2,6,0)
 module_param_named(debug, debug.msg_enable, int, 0);
 MODULE_PARM_DESC(debug, "Debug verbosity level (0=none, ..., 16=all)");
@@ -3233,7 +3237,8 @@ static void rtl8168_mac_loopback_test(struct rtl8168_private *tp)
 {
         void __iomem *ioaddr = tp->mmio_addr;
         struct net_device *dev = tp->dev;
-        struct sk_buff *skb, *rx_skb;
+        struct rtl8168_rx_buffer *rx_buf;
+        struct sk_buff *skb;
         dma_addr_t mapping;
         struct TxDesc *txd;
         struct RxDesc *rxd;
@@ -3251,7 +3256,7 @@ static void rtl8168_mac_loopback_test(struct rtl8168_private *tp)
         type = htons(ETH_P_IP);
         txd = tp->TxDescArray;
         rxd = tp->RxDescArray;
-        rx_skb = tp->Rx_skbuff[0];
+        rx_buf = tp->Rx_buffer;
         RTL_W32(TxConfig, (RTL_R32(TxConfig) & ~0x00060000) | 0x00020000);
 
         do {
@@ -3300,7 +3305,8 @@ static void rtl8168_mac_loopback_test(struct rtl8168_private *tp)
 
                 if (rx_len == len) {
                         pci_dma_sync_single_for_cpu(tp->pci_dev, le64_to_cpu(rxd->addr), tp->rx_buf_sz, PCI_DMA_FROMDEVICE);
-                        i = memcmp(skb->data, rx_skb->data, rx_len);
+                        i = memcmp(skb->data, page_address(rx_buf->page) +
+                                   rx_buf->page_offset, rx_len);
                         pci_dma_sync_single_for_device(tp->pci_dev, le64_to_cpu(rxd->addr), tp->rx_buf_sz, PCI_DMA_FROMDEVICE);
                         if (i == 0) {
 //              dev_printk(KERN_INFO, &tp->pci_dev->dev, "loopback test finished\n",rx_len,len);
@@ -5463,6 +5469,40 @@ static int rtl_nway_reset(struct net_device *dev)
         return ret;
 }
 
+#if LINUX_VERSION_CODE >= KERNEL_VERSION(3,18,0)
+static int rtl8168_get_tunable(struct net_device *dev,
+                               const struct ethtool_tunable *tuna, void *data)
+{
+        struct rtl8168_private *tp = netdev_priv(dev);
+
+        switch (tuna->id) {
+        case ETHTOOL_RX_COPYBREAK:
+                *(u32 *)data = tp->rx_copybreak;
+                return 0;
+        default:
+                return -EOPNOTSUPP;
+        }
+}
+
+static int rtl8168_set_tunable(struct net_device *dev,
+                               const struct ethtool_tunable *tuna,
+                               const void *data)
+{
+        struct rtl8168_private *tp = netdev_priv(dev);
+        u32 val = *(u32 *)data;
+
+        switch (tuna->id) {
+        case ETHTOOL_RX_COPYBREAK:
+                if (val > RX_BUF_SIZE)
+                        return -EINVAL;
+                WRITE_ONCE(tp->rx_copybreak, val);
+                return 0;
+        default:
+                return -EOPNOTSUPP;
+        }
+}
+#endif //LINUX_VERSION_CODE >= KERNEL_VERSION(3,18,0)
+
 #if LINUX_VERSION_CODE > KERNEL_VERSION(2,4,22)
 static const struct ethtool_ops rtl8168_ethtool_ops = {
         .get_drvinfo        = rtl8168_get_drvinfo,
@@ -5514,6 +5554,10 @@ static const struct ethtool_ops rtl8168_ethtool_ops = {
         .set_eee = rtl_ethtool_set_eee,
 #endif /* LINUX_VERSION_CODE >= KERNEL_VERSION(3,6,0) */
         .nway_reset = rtl_nway_reset,
+#if LINUX_VERSION_CODE >= KERNEL_VERSION(3,18,0)
+        .get_tunable = rtl8168_get_tunable,
+        .set_tunable = rtl8168_set_tunable,
+#endif //LINUX_VERSION_CODE >= KERNEL_VERSION(3,18,0)
 };
 #endif //LINUX_VERSION_CODE > KERNEL_VERSION(2,4,22)
 
@@ -25136,6 +25180,8 @@ rtl8168_init_one(struct pci_dev *pdev, const struct pci_device_id *ent)
         tp->phy_reset_pending = rtl8168_xmii_reset_pending;
         tp->link_ok = rtl8168_xmii_link_ok;
 
+        tp->board_idx = board_idx;
+        tp->rx_copybreak = rx_copybreak;
         tp->features |= rtl8168_try_msi(pdev, tp);
 
         RTL_NET_DEVICE_OPS(rtl8168_netdev_ops);
@@ -25320,6 +25366,44 @@ rtl8168_set_rxbufsize(struct rtl8168_private *tp,
         unsigned int mtu = dev->mtu;
 
         tp->rx_buf_sz = (mtu > ETH_DATA_LEN) ? mtu + ETH_HLEN + 8 + 1 : RX_BUF_SIZE;
+
+        /*
+         * With small pages, a page holds two buffers and the driver flips
+         * between them, with big pages it walks through the page.
+         */
+#if (PAGE_SIZE < 8192)
+        tp->rx_buf_truesize = roundup_pow_of_two(tp->rx_buf_sz);
+        tp->rx_page_order = get_order(2 * tp->rx_buf_truesize);
+#else
+        tp->rx_buf_truesize = ALIGN(tp->rx_buf_sz, L1_CACHE_BYTES);
+        tp->rx_page_order = get_order(tp->rx_buf_truesize);
+#endif
+}
+
+/*
+ * The RTL8111 family has a single RX ring and no RSS, so all of the RX
+ * work of a port runs where its interrupt lands, CPU0 by default. Give
+ * every port its own CPU, starting past CPU0, so that several ports do
+ * not saturate the same core. Protocol processing can be spread further
+ * across CPUs with RPS (/sys/class/net/<if>/queues/rx-0/rps_cpus), which
+ * hashes the flows in software.
+ */
+static void
+rtl8168_set_irq_affinity(struct net_device *dev)
+{
+        struct rtl8168_private *tp = netdev_priv(dev);
+        unsigned int cpu;
+
+        if (irq_cpu >= 0 && irq_cpu < nr_cpu_ids && cpu_online(irq_cpu))
+                cpu = irq_cpu;
+        else
+                cpu = cpumask_local_spread(tp->board_idx + 1,
+                                           dev_to_node(&tp->pci_dev->dev));
+
+        if (irq_set_affinity_hint(dev->irq, cpumask_of(cpu)))
+                netif_warn(tp, ifup, dev, "failed to set irq affinity hint\n");
+        else
+                netif_info(tp, ifup, dev, "irq %d on cpu %u\n", dev->irq, cpu);
 }
 
 static int rtl8168_open(struct net_device *dev)
@@ -25406,6 +25490,8 @@ static int rtl8168_open(struct net_device *dev)
         if (retval<0)
                 goto err_free_all_allocated_mem;
 
+        rtl8168_set_irq_affinity(dev);
+
 	tp->first_link_up = true;
 
         if (tp->esd_flag == 0)
@@ -26707,16 +26793,14 @@ rtl8168_make_unusable_by_asic(struct RxDesc *desc)
 }
 
 static void
-rtl8168_free_rx_skb(struct rtl8168_private *tp,
-                    struct sk_buff **sk_buff,
-                    struct RxDesc *desc)
-{
-        struct pci_dev *pdev = tp->pci_dev;
-
-        pci_unmap_single(pdev, le64_to_cpu(desc->addr), tp->rx_buf_sz,
-                         PCI_DMA_FROMDEVICE);
-        dev_kfree_skb(*sk_buff);
-        *sk_buff = NULL;
+rtl8168_free_rx_page(struct rtl8168_private *tp,
+                     struct rtl8168_rx_buffer *rx_buf,
+                     struct RxDesc *desc)
+{
+        dma_unmap_page(&tp->pci_dev->dev, rx_buf->dma,
+                       PAGE_SIZE << tp->rx_page_order, DMA_FROM_DEVICE);
+        put_page(rx_buf->page);
+        rx_buf->page = NULL;
         rtl8168_make_unusable_by_asic(desc);
 }
 
@@ -26740,45 +26824,37 @@ rtl8168_map_to_asic(struct RxDesc *desc,
 }
 
 static int
-rtl8168_alloc_rx_skb(struct rtl8168_private *tp,
-                     struct sk_buff **sk_buff,
-                     struct RxDesc *desc,
-                     int rx_buf_sz,
-                     u8 in_intr)
+rtl8168_alloc_rx_page(struct rtl8168_private *tp,
+                      struct rtl8168_rx_buffer *rx_buf,
+                      struct RxDesc *desc)
 {
-        struct sk_buff *skb;
+        struct page *page;
         dma_addr_t mapping;
-        int ret = 0;
 
-        if (in_intr)
-                skb = RTL_ALLOC_SKB_INTR(tp, rx_buf_sz + RTK_RX_ALIGN);
-        else
-                skb = dev_alloc_skb(rx_buf_sz + RTK_RX_ALIGN);
-
-        if (unlikely(!skb))
+        page = dev_alloc_pages(tp->rx_page_order);
+        if (unlikely(!page))
                 goto err_out;
 
-        skb_reserve(skb, RTK_RX_ALIGN);
-
-        mapping = pci_map_single(tp->pci_dev, skb->data, rx_buf_sz,
-                                 PCI_DMA_FROMDEVICE);
+        mapping = dma_map_page(&tp->pci_dev->dev, page, 0,
+                               PAGE_SIZE << tp->rx_page_order,
+                               DMA_FROM_DEVICE);
         if (unlikely(dma_mapping_error(&tp->pci_dev->dev, mapping))) {
                 if (unlikely(net_ratelimit()))
                         netif_err(tp, drv, tp->dev, "Failed to map RX DMA!\n");
+                __free_pages(page, tp->rx_page_order);
                 goto err_out;
         }
 
-        *sk_buff = skb;
-        rtl8168_map_to_asic(desc, mapping, rx_buf_sz);
-out:
-        return ret;
+        rx_buf->page = page;
+        rx_buf->dma = mapping;
+        rx_buf->page_offset = 0;
+        rtl8168_map_to_asic(desc, mapping, tp->rx_buf_sz);
+
+        return 0;
 
 err_out:
-        if (skb)
-                dev_kfree_skb(skb);
-        ret = -ENOMEM;
         rtl8168_make_unusable_by_asic(desc);
-        goto out;
+        return -ENOMEM;
 }
 
 static void
@@ -26787,9 +26863,9 @@ rtl8168_rx_clear(struct rtl8168_private *tp)
         int i;
 
         for (i = 0; i < NUM_RX_DESC; i++) {
-                if (tp->Rx_skbuff[i])
-                        rtl8168_free_rx_skb(tp, tp->Rx_skbuff + i,
-                                            tp->RxDescArray + i);
+                if (tp->Rx_buffer[i].page)
+                        rtl8168_free_rx_page(tp, tp->Rx_buffer + i,
+                                             tp->RxDescArray + i);
         }
 }
 
@@ -26797,21 +26873,18 @@ static u32
 rtl8168_rx_fill(struct rtl8168_private *tp,
                 struct net_device *dev,
                 u32 start,
-                u32 end,
-                u8 in_intr)
+                u32 end)
 {
         u32 cur;
 
         for (cur = start; end - cur > 0; cur++) {
                 int ret, i = cur % NUM_RX_DESC;
 
-                if (tp->Rx_skbuff[i])
+                if (tp->Rx_buffer[i].page)
                         continue;
 
-                ret = rtl8168_alloc_rx_skb(tp, tp->Rx_skbuff + i,
-                                           tp->RxDescArray + i,
-                                           tp->rx_buf_sz,
-                                           in_intr);
+                ret = rtl8168_alloc_rx_page(tp, tp->Rx_buffer + i,
+                                            tp->RxDescArray + i);
                 if (ret < 0)
                         break;
         }
@@ -26882,12 +26955,12 @@ rtl8168_init_ring(struct net_device *dev)
         rtl8168_init_ring_indexes(tp);
 
         memset(tp->tx_skb, 0x0, NUM_TX_DESC * sizeof(struct ring_info));
-        memset(tp->Rx_skbuff, 0x0, NUM_RX_DESC * sizeof(struct sk_buff *));
+        memset(tp->Rx_buffer, 0x0, NUM_RX_DESC * sizeof(struct rtl8168_rx_buffer));
 
         rtl8168_tx_desc_init(tp);
         rtl8168_rx_desc_init(tp);
 
-        if (rtl8168_rx_fill(tp, dev, 0, NUM_RX_DESC, 0) != NUM_RX_DESC)
+        if (rtl8168_rx_fill(tp, dev, 0, NUM_RX_DESC) != NUM_RX_DESC)
                 goto err_out;
 
         rtl8168_mark_as_last_descriptor(tp->RxDescArray + NUM_RX_DESC - 1);
@@ -27633,34 +27706,111 @@ rtl8168_rx_csum(struct rtl8168_private *tp,
         }
 }
 
-static inline int
-rtl8168_try_rx_copy(struct rtl8168_private *tp,
-                    struct sk_buff **sk_buff,
-                    int pkt_size,
-                    struct RxDesc *desc,
-                    int rx_buf_sz)
+static bool
+rtl8168_can_reuse_rx_page(struct rtl8168_private *tp,
+                          struct rtl8168_rx_buffer *rx_buf)
 {
-        int ret = -1;
+        struct page *page = rx_buf->page;
 
-        if (pkt_size < rx_copybreak) {
-                struct sk_buff *skb;
+        /* avoid re-using remote pages and emergency reserves */
+        if (unlikely(page_to_nid(page) != numa_mem_id() ||
+                     page_is_pfmemalloc(page)))
+                return false;
 
-                skb = RTL_ALLOC_SKB_INTR(tp, pkt_size + RTK_RX_ALIGN);
-                if (skb) {
-                        u8 *data;
+#if (PAGE_SIZE < 8192)
+        /* the stack still holds the other half */
+        if (unlikely(page_count(page) != 1))
+                return false;
 
-                        data = sk_buff[0]->data;
-                        skb_reserve(skb, RTK_RX_ALIGN);
-#if LINUX_VERSION_CODE >= KERNEL_VERSION(2,4,37)
-                        prefetch(data - RTK_RX_ALIGN);
+        rx_buf->page_offset ^= tp->rx_buf_truesize;
+#else
+        rx_buf->page_offset += tp->rx_buf_truesize;
+
+        if (rx_buf->page_offset >
+            (PAGE_SIZE << tp->rx_page_order) - tp->rx_buf_truesize)
+                return false;
 #endif
-                        eth_copy_and_sum(skb, data, pkt_size, 0);
-                        *sk_buff = skb;
-                        rtl8168_mark_to_asic(desc, rx_buf_sz);
-                        ret = 0;
-                }
+
+        /* one reference for the skb, one for the ring */
+        page_ref_inc(page);
+
+        return true;
+}
+
+/*
+ * Build an skb for a received frame. Frames below the copybreak are
+ * copied and their buffer is handed back to the NIC as is. Larger frames
+ * get their headers copied and the rest attached as a page fragment, and
+ * the buffer moves on to the other part of the page if the stack is done
+ * with it, or a new page is allocated on refill otherwise.
+ */
+static struct sk_buff *
+rtl8168_rx_build_skb(struct rtl8168_private *tp,
+                     struct rtl8168_rx_buffer *rx_buf,
+                     int pkt_size)
+{
+        struct device *d = &tp->pci_dev->dev;
+        unsigned int headlen;
+        struct sk_buff *skb;
+        u8 *data;
+
+        data = page_address(rx_buf->page) + rx_buf->page_offset;
+        dma_sync_single_range_for_cpu(d, rx_buf->dma, rx_buf->page_offset,
+                                      pkt_size, DMA_FROM_DEVICE);
+        prefetch(data);
+
+        if (pkt_size < tp->rx_copybreak) {
+                skb = RTL_ALLOC_SKB_INTR(tp, pkt_size + RTK_RX_ALIGN);
+                if (unlikely(!skb))
+                        goto out;
+
+                skb_reserve(skb, RTK_RX_ALIGN);
+                memcpy(skb_put(skb, pkt_size), data, pkt_size);
+                goto out;
         }
-        return ret;
+
+        skb = RTL_ALLOC_SKB_INTR(tp, RX_HDR_SIZE + RTK_RX_ALIGN);
+        if (unlikely(!skb))
+                goto out;
+
+        skb_reserve(skb, RTK_RX_ALIGN);
+
+        headlen = pkt_size;
+        if (headlen > RX_HDR_SIZE)
+                headlen = eth_get_headlen(data, RX_HDR_SIZE);
+
+        memcpy(__skb_put(skb, headlen), data, ALIGN(headlen, sizeof(long)));
+        if (headlen == pkt_size)
+                goto out;
+
+        skb_add_rx_frag(skb, 0, rx_buf->page, rx_buf->page_offset + headlen,
+                        pkt_size - headlen, tp->rx_buf_truesize);
+
+        if (!rtl8168_can_reuse_rx_page(tp, rx_buf)) {
+                dma_unmap_page(d, rx_buf->dma, PAGE_SIZE << tp->rx_page_order,
+                               DMA_FROM_DEVICE);
+                rx_buf->page = NULL;
+                return skb;
+        }
+
+out:
+        dma_sync_single_range_for_device(d, rx_buf->dma, rx_buf->page_offset,
+                                         tp->rx_buf_sz, DMA_FROM_DEVICE);
+
+        return skb;
+}
+
+/* Hand the buffer back to the NIC once the descriptor has been parsed */
+static inline void
+rtl8168_rx_rearm(struct rtl8168_private *tp,
+                 struct rtl8168_rx_buffer *rx_buf,
+                 struct RxDesc *desc)
+{
+        if (rx_buf->page)
+                rtl8168_map_to_asic(desc, rx_buf->dma + rx_buf->page_offset,
+                                    tp->rx_buf_sz);
+        else
+                rtl8168_make_unusable_by_asic(desc);
 }
 
 static inline void
@@ -27694,7 +27844,7 @@ rtl8168_rx_interrupt(struct net_device *dev,
         assert(tp != NULL);
         assert(ioaddr != NULL);
 
-        if ((tp->RxDescArray == NULL) || (tp->Rx_skbuff == NULL))
+        if (tp->RxDescArray == NULL)
                 goto rx_out;
 
         rx_quota = RTL_RX_QUOTA(budget);
@@ -27729,8 +27879,6 @@ rtl8168_rx_interrupt(struct net_device *dev,
                 } else {
                         struct sk_buff *skb;
                         int pkt_size;
-                        void (*pci_action)(struct pci_dev *, dma_addr_t,
-                                           size_t, int);
 
 process_pkt:
                         if (likely(!(dev->features & NETIF_F_RXFCS)))
@@ -27750,26 +27898,19 @@ process_pkt:
                                 continue;
                         }
 
-                        skb = tp->Rx_skbuff[entry];
-                        if (tp->cp_cmd & RxChkSum)
-                                rtl8168_rx_csum(tp, skb, desc);
-
-                        pci_dma_sync_single_for_cpu(tp->pci_dev,
-                                                    le64_to_cpu(desc->addr), tp->rx_buf_sz,
-                                                    PCI_DMA_FROMDEVICE);
-
-                        pci_action = pci_dma_sync_single_for_device;
-                        if (rtl8168_try_rx_copy(tp, &skb, pkt_size,
-                                                desc, tp->rx_buf_sz)) {
-                                pci_action = pci_unmap_single;
-                                tp->Rx_skbuff[entry] = NULL;
+                        skb = rtl8168_rx_build_skb(tp, tp->Rx_buffer + entry,
+                                                   pkt_size);
+                        if (unlikely(!skb)) {
+                                RTLDEV->stats.rx_dropped++;
+                                rtl8168_rx_rearm(tp, tp->Rx_buffer + entry,
+                                                 desc);
+                                goto next_desc;
                         }
 
-                        pci_action(tp->pci_dev, le64_to_cpu(desc->addr),
-                                   tp->rx_buf_sz, PCI_DMA_FROMDEVICE);
+                        if (tp->cp_cmd & RxChkSum)
+                                rtl8168_rx_csum(tp, skb, desc);
 
                         skb->dev = dev;
-                        skb_put(skb, pkt_size);
                         skb->protocol = eth_type_trans(skb, dev);
 
                         if (skb->pkt_type == PACKET_MULTICAST)
@@ -27782,8 +27923,11 @@ process_pkt:
 #endif //LINUX_VERSION_CODE < KERNEL_VERSION(4,11,0)
                         RTLDEV->stats.rx_bytes += pkt_size;
                         RTLDEV->stats.rx_packets++;
+
+                        rtl8168_rx_rearm(tp, tp->Rx_buffer + entry, desc);
                 }
 
+next_desc:
                 cur_rx++;
                 entry = cur_rx % NUM_RX_DESC;
                 desc = tp->RxDescArray + entry;
@@ -27795,7 +27939,7 @@ process_pkt:
         count = cur_rx - tp->cur_rx;
         tp->cur_rx = cur_rx;
 
-        delta = rtl8168_rx_fill(tp, dev, tp->dirty_rx, tp->cur_rx, 1);
+        delta = rtl8168_rx_fill(tp, dev, tp->dirty_rx, tp->cur_rx);
         if (!delta && count && netif_msg_intr(tp))
                 printk(KERN_INFO "%s: no Rx buffer allocated\n", dev->name);
         tp->dirty_rx += delta;
@@ -28106,6 +28250,7 @@ static int rtl8168_close(struct net_device *dev)
 
                 rtl8168_powerdown_pll(dev);
 
+                irq_set_affinity_hint(dev->irq, NULL);
                 free_irq(dev->irq, dev);
 
                 pci_free_consistent(pdev, R8168_RX_RING_BYTES, tp->RxDescArray,
@@ -344,6 +344,9 @@
 #endif
 #define EARLY_AGG_HIGH		0x0e837a12
 #define EARLY_AGG_SLOW		0x0e83ffff
+#define EARLY_AGG_SIZE_SHIFT	16	/* in units of 4 bytes */
+#define EARLY_AGG_TIMEOUT_MASK	0xffff	/* in units of 8 ns */
+#define EARLY_AGG_UNITS_PER_US	125	/* timeout units per usec */
 
 /* USB_WDT11_CTRL */
 #define TIMER11_EN		0x0001
@@ -438,7 +441,8 @@ enum rtl_register_content {
 };
 
 #define RTL8152_MAX_TX		4
-#define RTL8152_MAX_RX		10
+#define RTL8152_MAX_RX		32
+#define RTL8152_RX_URBS		10	/* default number of rx urbs */
 #define INTBUFSIZE		2
 #define CRC_SIZE		4
 #define TX_ALIGN		4
@@ -575,6 +579,14 @@ struct r8152 {
 	struct urb *intr_urb;
 	struct tx_agg tx_info[RTL8152_MAX_TX];
 	struct rx_agg rx_info[RTL8152_MAX_RX];
+	struct rtl_agg_stats {
+		u64 rx_urbs;
+		u64 rx_packets;
+		u64 tx_urbs;
+		u64 tx_packets;
+		u32 rx_max;
+		u32 tx_max;
+	} agg_stats;
 	struct list_head rx_done, tx_free;
 	struct sk_buff_head tx_queue;
 	spinlock_t rx_lock, tx_lock;
@@ -605,6 +617,9 @@ struct r8152 {
 	u32 saved_wolopts;
 	u32 msg_enable;
 	u32 tx_qlen;
+	u32 rx_pending;		/* rx urbs in use */
+	u32 rx_coalesce_usecs;	/* rx aggregation timeout, 0 for speed default */
+	u32 rx_agg_frames;	/* rx aggregation size, 0 for the default */
 	u16 ocp_base;
 	u8 *intr_buff;
 	u8 version;
@@ -1396,7 +1411,7 @@ static int alloc_all_mem(struct r8152 *tp)
 	INIT_LIST_HEAD(&tp->tx_free);
 	skb_queue_head_init(&tp->tx_queue);
 
-	for (i = 0; i < RTL8152_MAX_RX; i++) {
+	for (i = 0; i < tp->rx_pending; i++) {
 		struct sk_buff *skb;
 
 		skb = rtl_alloc_rx_skb(tp, GFP_KERNEL);
@@ -1751,6 +1766,12 @@ static int r8152_tx_agg_fill(struct r8152 *tp, struct tx_agg *agg)
 		spin_unlock(&tx_queue->lock);
 	}
 
+	if (agg->skb_num) {
+		tp->agg_stats.tx_urbs++;
+		tp->agg_stats.tx_packets += agg->skb_num;
+		tp->agg_stats.tx_max = max(tp->agg_stats.tx_max, agg->skb_num);
+	}
+
 	netif_tx_lock(tp->netdev);
 
 	if (netif_queue_stopped(tp->netdev) &&
@@ -1825,6 +1846,7 @@ static void rx_bottom(struct r8152 *tp)
 		bool cloned = false;
 		struct rx_agg *agg;
 		int len_used = 0;
+		u32 rx_num = 0;
 		struct urb *urb;
 		u8 *rx_data;
 
@@ -1900,6 +1922,7 @@ static void rx_bottom(struct r8152 *tp)
 #endif
 			stats->rx_packets++;
 			stats->rx_bytes += pkt_len;
+			rx_num++;
 
 find_next_rx:
 			rx_data = rx_agg_align(rx_data + pkt_len + CRC_SIZE);
@@ -1912,6 +1935,10 @@ find_next_rx:
 		if (cloned)
 			kfree_skb(rx_skb);
 
+		tp->agg_stats.rx_urbs++;
+		tp->agg_stats.rx_packets += rx_num;
+		tp->agg_stats.rx_max = max(tp->agg_stats.rx_max, rx_num);
+
 submit:
 		r8152_submit_rx(tp, agg, GFP_ATOMIC);
 	}
@@ -2126,6 +2153,12 @@ static netdev_tx_t rtl8152_start_xmit(struct sk_buff *skb,
 
 	skb_queue_tail(&tp->tx_queue, skb);
 
+#if LINUX_VERSION_CODE >= KERNEL_VERSION(3,18,0)
+	/* more frames follow, let them join the same tx urb */
+	if (skb->xmit_more && skb_queue_len(&tp->tx_queue) < tp->tx_qlen)
+		return NETDEV_TX_OK;
+#endif /* LINUX_VERSION_CODE >= KERNEL_VERSION(3,18,0) */
+
 	if (!list_empty(&tp->tx_free)) {
 		if (test_bit(SELECTIVE_SUSPEND, &tp->flags)) {
 			set_bit(SCHEDULE_TASKLET, &tp->flags);
@@ -2212,7 +2245,7 @@ static int rtl_start_rx(struct r8152 *tp)
 	int i, ret = 0;
 
 	INIT_LIST_HEAD(&tp->rx_done);
-	for (i = 0; i < RTL8152_MAX_RX; i++) {
+	for (i = 0; i < tp->rx_pending; i++) {
 		int rr;
 
 		INIT_LIST_HEAD(&tp->rx_info[i].list);
@@ -2264,28 +2297,64 @@ static int rtl8152_enable(struct r8152 *tp)
 	return rtl_enable(tp);
 }
 
-static void r8153_set_rx_agg(struct r8152 *tp)
+/* the bytes a full sized frame takes in a rx aggregation */
+static u32 rtl_rx_frame_size(struct r8152 *tp)
+{
+	return ALIGN(tp->netdev->mtu + VLAN_ETH_HLEN + CRC_SIZE +
+		     sizeof(struct rx_desc), RX_ALIGN);
+}
+
+/* the largest early aggregation size that still leaves a frame of room */
+static u32 rtl_rx_early_size_max(struct r8152 *tp)
+{
+	return AGG_BUF_SZ - rtl_rx_frame_size(tp);
+}
+
+/*
+ * Returns the USB_RX_EARLY_AGG setting for the current link, the speed
+ * default with the timeout and size set with ethtool on top.
+ */
+static u32 r8153_rx_early_agg(struct r8152 *tp, u32 *buf_th)
 {
+	u32 early_agg, size;
 	u8 speed;
 
 	speed = rtl8152_get_speed(tp);
 	if (speed & _1000bps) {
 		if (tp->udev->speed == USB_SPEED_SUPER) {
-			ocp_write_dword(tp, MCU_TYPE_USB, USB_RX_BUF_TH,
-					RX_THR_SUPPER);
-			ocp_write_dword(tp, MCU_TYPE_USB, USB_RX_EARLY_AGG,
-					EARLY_AGG_SUPER);
+			*buf_th = RX_THR_SUPPER;
+			early_agg = EARLY_AGG_SUPER;
 		} else {
-			ocp_write_dword(tp, MCU_TYPE_USB, USB_RX_BUF_TH,
-					RX_THR_HIGH);
-			ocp_write_dword(tp, MCU_TYPE_USB, USB_RX_EARLY_AGG,
-					EARLY_AGG_HIGH);
+			*buf_th = RX_THR_HIGH;
+			early_agg = EARLY_AGG_HIGH;
 		}
 	} else {
-		ocp_write_dword(tp, MCU_TYPE_USB, USB_RX_BUF_TH, RX_THR_SLOW);
-		ocp_write_dword(tp, MCU_TYPE_USB, USB_RX_EARLY_AGG,
-				EARLY_AGG_SLOW);
+		*buf_th = RX_THR_SLOW;
+		early_agg = EARLY_AGG_SLOW;
+	}
+
+	if (tp->rx_coalesce_usecs) {
+		early_agg &= ~EARLY_AGG_TIMEOUT_MASK;
+		early_agg |= tp->rx_coalesce_usecs * EARLY_AGG_UNITS_PER_US;
+	}
+
+	if (tp->rx_agg_frames) {
+		size = min(tp->rx_agg_frames * rtl_rx_frame_size(tp),
+			   rtl_rx_early_size_max(tp));
+		early_agg &= EARLY_AGG_TIMEOUT_MASK;
+		early_agg |= (size / 4) << EARLY_AGG_SIZE_SHIFT;
 	}
+
+	return early_agg;
+}
+
+static void r8153_set_rx_agg(struct r8152 *tp)
+{
+	u32 early_agg, buf_th;
+
+	early_agg = r8153_rx_early_agg(tp, &buf_th);
+	ocp_write_dword(tp, MCU_TYPE_USB, USB_RX_BUF_TH, buf_th);
+	ocp_write_dword(tp, MCU_TYPE_USB, USB_RX_EARLY_AGG, early_agg);
 }
 
 static int rtl8153_enable(struct r8152 *tp)
@@ -5227,6 +5296,12 @@ static const char rtl8152_gstrings[][ETH_GSTRING_LEN] = {
 	"rx_multicast",
 	"tx_aborted",
 	"tx_underrun",
+	"rx_agg_urbs",
+	"rx_agg_packets",
+	"rx_agg_max",
+	"tx_agg_urbs",
+	"tx_agg_packets",
+	"tx_agg_max",
 };
 
 #if LINUX_VERSION_CODE < KERNEL_VERSION(2,6,33)
@@ -5272,6 +5347,12 @@ static void rtl8152_get_ethtool_stats(struct net_device *dev,
 	data[10] = le32_to_cpu(tally.rx_multicast);
 	data[11] = le16_to_cpu(tally.tx_aborted);
 	data[12] = le16_to_cpu(tally.tx_underrun);
+	data[13] = tp->agg_stats.rx_urbs;
+	data[14] = tp->agg_stats.rx_packets;
+	data[15] = tp->agg_stats.rx_max;
+	data[16] = tp->agg_stats.tx_urbs;
+	data[17] = tp->agg_stats.tx_packets;
+	data[18] = tp->agg_stats.tx_max;
 }
 
 static void rtl8152_get_strings(struct net_device *dev, u32 stringset, u8 *data)
@@ -5432,6 +5513,109 @@ out:
 	return ret;
 }
 
+static int rtl8152_get_coalesce(struct net_device *dev,
+				struct ethtool_coalesce *coalesce)
+{
+	struct r8152 *tp = netdev_priv(dev);
+	u32 early_agg, buf_th;
+	int ret;
+
+	switch (tp->version) {
+	case RTL_VER_01:
+	case RTL_VER_02:
+		return -EOPNOTSUPP;
+	default:
+		break;
+	}
+
+	ret = usb_autopm_get_interface(tp->intf);
+	if (ret < 0)
+		return ret;
+
+	mutex_lock(&tp->control);
+	early_agg = r8153_rx_early_agg(tp, &buf_th);
+	mutex_unlock(&tp->control);
+
+	usb_autopm_put_interface(tp->intf);
+
+	coalesce->rx_coalesce_usecs = (early_agg & EARLY_AGG_TIMEOUT_MASK) /
+				      EARLY_AGG_UNITS_PER_US;
+	coalesce->rx_max_coalesced_frames =
+		((early_agg >> EARLY_AGG_SIZE_SHIFT) * 4) /
+		rtl_rx_frame_size(tp);
+
+	return 0;
+}
+
+static int rtl8152_set_coalesce(struct net_device *dev,
+				struct ethtool_coalesce *coalesce)
+{
+	struct r8152 *tp = netdev_priv(dev);
+	u32 frames = coalesce->rx_max_coalesced_frames;
+	u32 usecs = coalesce->rx_coalesce_usecs;
+	int ret;
+
+	switch (tp->version) {
+	case RTL_VER_01:
+	case RTL_VER_02:
+		return -EOPNOTSUPP;
+	default:
+		break;
+	}
+
+	if (usecs > EARLY_AGG_TIMEOUT_MASK / EARLY_AGG_UNITS_PER_US ||
+	    frames > rtl_rx_early_size_max(tp) / rtl_rx_frame_size(tp))
+		return -EINVAL;
+
+	ret = usb_autopm_get_interface(tp->intf);
+	if (ret < 0)
+		return ret;
+
+	mutex_lock(&tp->control);
+
+	tp->rx_coalesce_usecs = usecs;
+	tp->rx_agg_frames = frames;
+
+	/* otherwise applied by the next link up */
+	if (netif_carrier_ok(dev))
+		r8153_set_rx_agg(tp);
+
+	mutex_unlock(&tp->control);
+
+	usb_autopm_put_interface(tp->intf);
+
+	return 0;
+}
+
+static void rtl8152_get_ringparam(struct net_device *dev,
+				  struct ethtool_ringparam *ring)
+{
+	struct r8152 *tp = netdev_priv(dev);
+
+	ring->rx_max_pending = RTL8152_MAX_RX;
+	ring->rx_pending = tp->rx_pending;
+	ring->tx_max_pending = RTL8152_MAX_TX;
+	ring->tx_pending = RTL8152_MAX_TX;
+}
+
+static int rtl8152_set_ringparam(struct net_device *dev,
+				 struct ethtool_ringparam *ring)
+{
+	struct r8152 *tp = netdev_priv(dev);
+
+	if (ring->rx_pending < 1 || ring->rx_pending > RTL8152_MAX_RX ||
+	    ring->tx_pending != RTL8152_MAX_TX)
+		return -EINVAL;
+
+	/* the rx urbs are allocated on open */
+	if (netif_running(dev))
+		return -EBUSY;
+
+	tp->rx_pending = ring->rx_pending;
+
+	return 0;
+}
+
 static struct ethtool_ops ops = {
 	.get_drvinfo = rtl8152_get_drvinfo,
 	.get_settings = rtl8152_get_settings,
@@ -5445,6 +5629,10 @@ static struct ethtool_ops ops = {
 	.get_strings = rtl8152_get_strings,
 	.get_sset_count = rtl8152_get_sset_count,
 	.get_ethtool_stats = rtl8152_get_ethtool_stats,
+	.get_coalesce = rtl8152_get_coalesce,
+	.set_coalesce = rtl8152_set_coalesce,
+	.get_ringparam = rtl8152_get_ringparam,
+	.set_ringparam = rtl8152_set_ringparam,
 #if LINUX_VERSION_CODE < KERNEL_VERSION(3,3,0)
 	.get_tx_csum = ethtool_op_get_tx_csum,
 	.set_tx_csum = ethtool_op_set_tx_csum,
@@ -5839,6 +6027,7 @@ static int rtl8152_probe(struct usb_interface *intf,
 	tp->udev = udev;
 	tp->netdev = netdev;
 	tp->intf = intf;
+	tp->rx_pending = RTL8152_RX_URBS;
 
 	r8152b_get_version(tp);
 	ret = rtl_ops_init(tp);
@@ -645,6 +645,9 @@ dhd_flowid_lookup(dhd_pub_t *dhdp, uint8 ifindex,
 		flow_ring_node->flow_info.ifindex = ifindex;
 		flow_ring_node->active = TRUE;
 		flow_ring_node->status = FLOW_RING_STATUS_PENDING;
+		flow_ring_node->tx_inflight = 0;
+		flow_ring_node->tx_deficit = 0;
+		bzero(&flow_ring_node->txlat, sizeof(flow_ring_node->txlat));
 		DHD_FLOWRING_UNLOCK(flow_ring_node->lock, flags);
 
 		/* Create and inform device about the new flow */
@@ -159,6 +159,30 @@ typedef struct flow_info {
 	char		da[ETHER_ADDR_LEN];
 } flow_info_t;
 
+/* tx latency histograms: bin 0 is below 64 usec, each next bin doubles the bound */
+#define DHD_TX_LAT_BINS		10
+#define DHD_TX_LAT_BIN0_SHIFT	6
+
+typedef struct flow_txlat {
+	uint32	queue[DHD_TX_LAT_BINS];	/* flow queue, until posted to the flow ring */
+	uint32	cmpl[DHD_TX_LAT_BINS];	/* flow ring, until the tx status from the dongle */
+	uint32	cmpl_err;		/* tx status other than success */
+} flow_txlat_t;
+
+static INLINE uint8
+dhd_tx_lat_bin(uint32 usec)
+{
+	uint8 bin = 0;
+
+	usec >>= DHD_TX_LAT_BIN0_SHIFT;
+	while (usec && (bin < DHD_TX_LAT_BINS - 1)) {
+		usec >>= 1;
+		bin++;
+	}
+
+	return bin;
+}
+
 /** a flow ring is used for outbound (towards antenna) 802.3 packets */
 typedef struct flow_ring_node {
 	dll_t		list;  /* manage a constructed flowring in a dll, must be at first place */
@@ -173,6 +197,9 @@ typedef struct flow_ring_node {
 	flow_info_t	flow_info;
 	void		*prot_info;
 	void		*lock; /* lock for flowring access protection */
+	uint32		tx_inflight; /* bytes posted to the flow ring, not yet completed */
+	int32		tx_deficit; /* DRR deficit of the flow queue, in bytes */
+	flow_txlat_t	txlat; /* tx latency of the flow */
 } flow_ring_node_t;
 
 typedef flow_ring_node_t flow_ring_table_t;
@@ -136,6 +136,7 @@ extern void register_page_corrupt_cb(page_corrupt_cb_t cb, void* handle);
 #include <linux/cpu.h>
 #include <linux/cpumask.h>
 #include <linux/notifier.h>
+#include <linux/topology.h>
 #include <linux/workqueue.h>
 #include <asm/atomic.h>
 
@@ -894,6 +895,21 @@ dhd_cpumasks_init(dhd_info_t *dhd)
 			cpumask_set_cpu(id, dhd->cpumask_secondary);
 	}
 
+	/*
+	 * Without a configured primary set, prefer the CPUs outside the
+	 * cluster of CPU0, which takes the PCIe interrupt and runs the DPC.
+	 * On Carmel the two cores of a cluster share their L2, the jobs moved
+	 * off the DPC then do not compete with it for the cache, while the
+	 * napi and completion jobs end up on the two cores of the next cluster.
+	 */
+	if (cpumask_empty(dhd->cpumask_primary)) {
+		for_each_possible_cpu(id) {
+			if (topology_physical_package_id(id) !=
+				topology_physical_package_id(0))
+				cpumask_set_cpu(id, dhd->cpumask_primary);
+		}
+	}
+
 	return ret;
 fail:
 	dhd_cpumasks_deinit(dhd);
@@ -2140,7 +2156,7 @@ static void dhd_rx_compl_dispatcher_fn(struct work_struct * work)
 	int cpu;
 
 	get_online_cpus();
-	cpu = atomic_read(&dhd->tx_compl_cpu);
+	cpu = atomic_read(&dhd->rx_compl_cpu);
 	if (!cpu_online(cpu))
 		dhd_tasklet_schedule(&dhd->rx_compl_tasklet);
 	else
@@ -14027,6 +14043,128 @@ dhd_pktid_audit_fail_cb(dhd_pub_t *dhdp)
 #include <linux/sysfs.h>
 #include <linux/kobject.h>
 
+#if defined(DHD_LB)
+
+static ssize_t
+dhd_lb_show_cpumask(struct cpumask *mask, char *buf)
+{
+	return scnprintf(buf, PAGE_SIZE, "%*pb\n", cpumask_pr_args(mask));
+}
+
+/* Replace a candidacy CPU set and run the candidacy algorithm again */
+static ssize_t
+dhd_lb_store_cpumask(dhd_info_t *dhd, struct cpumask *mask,
+	const char *buf, size_t count)
+{
+	cpumask_var_t new_mask;
+	int ret;
+
+	if (!alloc_cpumask_var(&new_mask, GFP_KERNEL))
+		return -ENOMEM;
+
+	ret = cpumask_parse(buf, new_mask);
+	if (ret)
+		goto exit;
+
+	/* serialized against the CPU hotplug callback */
+	get_online_cpus();
+	cpumask_copy(mask, new_mask);
+	dhd_select_cpu_candidacy(dhd);
+	put_online_cpus();
+
+	ret = count;
+exit:
+	free_cpumask_var(new_mask);
+	return ret;
+}
+
+static ssize_t
+show_cpumask_primary(struct dhd_info *dhd, char *buf)
+{
+	return dhd_lb_show_cpumask(dhd->cpumask_primary, buf);
+}
+
+static ssize_t
+set_cpumask_primary(struct dhd_info *dhd, const char *buf, size_t count)
+{
+	return dhd_lb_store_cpumask(dhd, dhd->cpumask_primary, buf, count);
+}
+
+static ssize_t
+show_cpumask_secondary(struct dhd_info *dhd, char *buf)
+{
+	return dhd_lb_show_cpumask(dhd->cpumask_secondary, buf);
+}
+
+static ssize_t
+set_cpumask_secondary(struct dhd_info *dhd, const char *buf, size_t count)
+{
+	return dhd_lb_store_cpumask(dhd, dhd->cpumask_secondary, buf, count);
+}
+
+static ssize_t
+dhd_lb_show_cpu(atomic_t *cpu, char *buf)
+{
+	return scnprintf(buf, PAGE_SIZE, "%d\n", atomic_read(cpu));
+}
+
+/*
+ * Pin a job to a CPU. The choice holds until the candidacy algorithm runs
+ * again, on a CPU hotplug event or a change of the CPU sets.
+ */
+static ssize_t
+dhd_lb_store_cpu(atomic_t *cpu, const char *buf, size_t count)
+{
+	unsigned int val;
+
+	if (kstrtouint(buf, 0, &val))
+		return -EINVAL;
+
+	if (val >= nr_cpu_ids || !cpu_online(val))
+		return -EINVAL;
+
+	atomic_set(cpu, val);
+
+	return count;
+}
+
+static ssize_t
+show_rx_napi_cpu(struct dhd_info *dhd, char *buf)
+{
+	return dhd_lb_show_cpu(&dhd->rx_napi_cpu, buf);
+}
+
+static ssize_t
+set_rx_napi_cpu(struct dhd_info *dhd, const char *buf, size_t count)
+{
+	return dhd_lb_store_cpu(&dhd->rx_napi_cpu, buf, count);
+}
+
+static ssize_t
+show_tx_compl_cpu(struct dhd_info *dhd, char *buf)
+{
+	return dhd_lb_show_cpu(&dhd->tx_compl_cpu, buf);
+}
+
+static ssize_t
+set_tx_compl_cpu(struct dhd_info *dhd, const char *buf, size_t count)
+{
+	return dhd_lb_store_cpu(&dhd->tx_compl_cpu, buf, count);
+}
+
+static ssize_t
+show_rx_compl_cpu(struct dhd_info *dhd, char *buf)
+{
+	return dhd_lb_show_cpu(&dhd->rx_compl_cpu, buf);
+}
+
+static ssize_t
+set_rx_compl_cpu(struct dhd_info *dhd, const char *buf, size_t count)
+{
+	return dhd_lb_store_cpu(&dhd->rx_compl_cpu, buf, count);
+}
+#endif /* DHD_LB */
+
 #if defined(DHD_TRACE_WAKE_LOCK)
 
 /* Function to show the history buffer */
@@ -14089,11 +14227,31 @@ static struct dhd_attr dhd_attr_wklock =
 	__ATTR(wklock_trace, 0660, show_wklock_trace, wklock_trace_onoff);
 #endif /* defined(DHD_TRACE_WAKE_LOCK */
 
+#if defined(DHD_LB)
+static struct dhd_attr dhd_attr_cpumask_primary =
+	__ATTR(primary_mask, 0660, show_cpumask_primary, set_cpumask_primary);
+static struct dhd_attr dhd_attr_cpumask_secondary =
+	__ATTR(secondary_mask, 0660, show_cpumask_secondary, set_cpumask_secondary);
+static struct dhd_attr dhd_attr_rx_napi_cpu =
+	__ATTR(rx_napi_cpu, 0660, show_rx_napi_cpu, set_rx_napi_cpu);
+static struct dhd_attr dhd_attr_tx_compl_cpu =
+	__ATTR(tx_compl_cpu, 0660, show_tx_compl_cpu, set_tx_compl_cpu);
+static struct dhd_attr dhd_attr_rx_compl_cpu =
+	__ATTR(rx_compl_cpu, 0660, show_rx_compl_cpu, set_rx_compl_cpu);
+#endif /* DHD_LB */
+
 /* Attribute object that gets registered with "bcm-dhd" kobject tree */
 static struct attribute *default_attrs[] = {
 #if defined(DHD_TRACE_WAKE_LOCK)
 	&dhd_attr_wklock.attr,
 #endif
+#if defined(DHD_LB)
+	&dhd_attr_cpumask_primary.attr,
+	&dhd_attr_cpumask_secondary.attr,
+	&dhd_attr_rx_napi_cpu.attr,
+	&dhd_attr_tx_compl_cpu.attr,
+	&dhd_attr_rx_compl_cpu.attr,
+#endif /* DHD_LB */
 	NULL
 };
 
@@ -86,6 +86,8 @@
 #define DEFAULT_RX_BUFFERS_TO_POST	256
 #define RXBUFPOST_THRESHOLD			32
 #define RX_BUF_BURST				32 /* Rx buffers for MSDU Data */
+#define DHD_RX_RECYCLE_MAX			64 /* mapped rx buffers kept for reposting */
+#define DHD_RX_COPYBREAK			256 /* rx frames up to this size are copied */
 
 #define DHD_STOP_QUEUE_THRESHOLD	200
 #define DHD_START_QUEUE_THRESHOLD	100
@@ -305,10 +307,22 @@ typedef struct msgbuf_ring {
 
 
 
+/** A posted rx buffer whose frame was copied out, still mapped for the dongle */
+typedef struct dhd_rxbuf_recycle {
+	void *pkt;
+	dmaaddr_t pa;
+	uint32 len;
+} dhd_rxbuf_recycle_t;
+
 /** DHD protocol handle. Is an opaque type to other DHD software layers. */
 typedef struct dhd_prot {
 	osl_t *osh;		/* OSL handle */
 	uint16 rxbufpost;
+	uint16 rxbuf_cpl_pend;	/* completed rx buffers not yet taken off rxbufpost */
+	uint16 rx_recycle_cnt;	/* mapped rx buffers in rx_recycle */
+	uint32 rx_copybreak;	/* copy rx frames up to this length, recycle the buffer */
+	uint32 rx_copied;	/* rx frames copied out of a recycled buffer */
+	dhd_rxbuf_recycle_t rx_recycle[DHD_RX_RECYCLE_MAX];
 	uint16 max_rxbufpost;
 	uint16 max_eventbufpost;
 	uint16 max_ioctlrespbufpost;
@@ -470,6 +484,8 @@ static void dhd_msgbuf_rxbuf_post(dhd_pub_t *dhd, bool use_rsv_pktid);
 static int dhd_prot_rxbuf_post(dhd_pub_t *dhd, uint16 count, bool use_rsv_pktid);
 
 static void dhd_prot_return_rxbuf(dhd_pub_t *dhd, uint32 pktid, uint32 rxcnt);
+static void dhd_prot_rxbuf_cpl_flush(dhd_pub_t *dhd);
+static void dhd_prot_rxbuf_recycle_flush(dhd_pub_t *dhd);
 
 /* D2H Message handling */
 static int dhd_prot_process_msgtype(dhd_pub_t *dhd, msgbuf_ring_t *ring, uint8 *buf, uint32 len);
@@ -2309,6 +2325,10 @@ dhd_prot_init(dhd_pub_t *dhd)
 	prot->data_seq_no = 0;
 	prot->ioctl_seq_no = 0;
 	prot->rxbufpost = 0;
+	prot->rxbuf_cpl_pend = 0;
+	prot->rx_recycle_cnt = 0;
+	prot->rx_copybreak = DHD_RX_COPYBREAK;
+	prot->rx_copied = 0;
 	prot->cur_event_bufs_posted = 0;
 	prot->ioctl_state = 0;
 	prot->curr_ioctl_cmd = 0;
@@ -2432,6 +2452,7 @@ dhd_prot_detach(dhd_pub_t *dhd)
 		/* Detach each DMA-able buffer and free the pool of msgbuf_ring_t */
 		dhd_prot_flowrings_pool_detach(dhd);
 
+		dhd_prot_rxbuf_recycle_flush(dhd);
 		DHD_NATIVE_TO_PKTID_FINI(dhd, dhd->prot->pktid_map_handle);
 
 #ifndef CONFIG_DHD_USE_STATIC_BUF
@@ -2478,6 +2499,7 @@ dhd_prot_reset(dhd_pub_t *dhd)
 	}
 
 	dhd_prot_flowrings_pool_reset(dhd);
+	dhd_prot_rxbuf_recycle_flush(dhd);
 
 	dhd_prot_ring_reset(dhd, &prot->h2dring_ctrl_subn);
 	dhd_prot_ring_reset(dhd, &prot->h2dring_rxp_subn);
@@ -2498,6 +2520,7 @@ dhd_prot_reset(dhd_pub_t *dhd)
 	prot->tx_metadata_offset = 0;
 
 	prot->rxbufpost = 0;
+	prot->rxbuf_cpl_pend = 0;
 	prot->cur_event_bufs_posted = 0;
 	prot->cur_ioctlresp_bufs_posted = 0;
 
@@ -2847,6 +2870,115 @@ dhd_prot_packet_get(dhd_pub_t *dhd, uint32 pktid, uint8 pkttype, bool free_pktid
 	return PKTBUF;
 }
 
+/**
+ * Like dhd_prot_packet_get() for a completed rx buffer, but a short frame is copied
+ * into a new packet and the posted buffer goes, still mapped, to the recycle pool for
+ * the next rxbuf post. Must be called with the general lock held. 'offset' is where the
+ * frame starts past the rx metadata, '*copied' tells which of the two was returned.
+ */
+static INLINE void * BCMFASTPATH
+dhd_prot_rxpkt_get(dhd_pub_t *dhd, uint32 pktid, bool free_pktid, uint32 offset,
+	uint16 data_len, bool *copied)
+{
+	dhd_prot_t *prot = dhd->prot;
+	void *PKTBUF;
+	void *copy;
+	dmaaddr_t pa;
+	uint32 len;
+	void *dmah;
+	void *secdma;
+
+	*copied = FALSE;
+
+#ifdef DHD_PCIE_PKTID
+	if (free_pktid) {
+		PKTBUF = DHD_PKTID_TO_NATIVE(dhd, prot->pktid_map_handle,
+			pktid, pa, len, dmah, secdma, PKTTYPE_DATA_RX);
+	} else {
+		PKTBUF = DHD_PKTID_TO_NATIVE_RSV(dhd, prot->pktid_map_handle,
+			pktid, pa, len, dmah, secdma, PKTTYPE_DATA_RX);
+	}
+#else
+	PKTBUF = DHD_PKTID_TO_NATIVE(dhd, prot->pktid_map_handle, pktid, pa,
+		len, dmah, secdma, PKTTYPE_DATA_RX);
+#endif /* DHD_PCIE_PKTID */
+
+	if (PKTBUF == NULL) {
+		return NULL;
+	}
+
+	if (!SECURE_DMA_ENAB(dhd->osh) && (data_len <= prot->rx_copybreak) &&
+		(prot->rx_recycle_cnt < DHD_RX_RECYCLE_MAX) &&
+		(offset + data_len <= len) &&
+		((copy = PKTGET(dhd->osh, data_len, FALSE)) != NULL)) {
+		dhd_rxbuf_recycle_t *rcl = &prot->rx_recycle[prot->rx_recycle_cnt++];
+
+		DMA_SYNC_FOR_CPU(dhd->osh, pa, prot->rx_metadata_offset + offset,
+			data_len, DMA_RX);
+		bcopy(PKTDATA(dhd->osh, PKTBUF) + offset, PKTDATA(dhd->osh, copy), data_len);
+		PKTSETLEN(dhd->osh, copy, data_len);
+
+		rcl->pkt = PKTBUF;
+		rcl->pa = pa;
+		rcl->len = len;
+		prot->rx_copied++;
+		*copied = TRUE;
+		return copy;
+	}
+
+	if (SECURE_DMA_ENAB(dhd->osh)) {
+		SECURE_DMA_UNMAP(dhd->osh, pa, (uint) len, DMA_RX, 0, dmah, secdma, 0);
+	} else {
+		DMA_UNMAP(dhd->osh, pa, (uint) len, DMA_RX, 0, dmah);
+	}
+
+	return PKTBUF;
+}
+
+/**
+ * Takes a mapped buffer off the recycle pool, handing it back to the device.
+ * Returns NULL when the pool is empty.
+ */
+static void * BCMFASTPATH
+dhd_prot_rxbuf_recycle_get(dhd_pub_t *dhd, dmaaddr_t *pa, uint32 *len)
+{
+	dhd_prot_t *prot = dhd->prot;
+	dhd_rxbuf_recycle_t *rcl;
+	unsigned long flags;
+	void *p = NULL;
+
+	DHD_GENERAL_LOCK(dhd, flags);
+	if (prot->rx_recycle_cnt) {
+		rcl = &prot->rx_recycle[--prot->rx_recycle_cnt];
+		p = rcl->pkt;
+		*pa = rcl->pa;
+		*len = rcl->len;
+		rcl->pkt = NULL;
+	}
+	DHD_GENERAL_UNLOCK(dhd, flags);
+
+	if (p) {
+		DMA_SYNC_FOR_DEVICE(dhd->osh, *pa, 0, *len + prot->rx_metadata_offset, DMA_RX);
+	}
+
+	return p;
+}
+
+/** Unmaps and frees the buffers left in the recycle pool */
+static void
+dhd_prot_rxbuf_recycle_flush(dhd_pub_t *dhd)
+{
+	dhd_prot_t *prot = dhd->prot;
+	dhd_rxbuf_recycle_t *rcl;
+
+	while (prot->rx_recycle_cnt) {
+		rcl = &prot->rx_recycle[--prot->rx_recycle_cnt];
+		DMA_UNMAP(dhd->osh, rcl->pa, rcl->len, DMA_RX, 0, DHD_DMAH_NULL);
+		PKTFREE(dhd->osh, rcl->pkt, FALSE);
+		rcl->pkt = NULL;
+	}
+}
+
 #ifdef IOCTLRESP_USE_CONSTMEM
 static INLINE void BCMFASTPATH
 dhd_prot_ioctl_ret_buffer_get(dhd_pub_t *dhd, uint32 pktid, dhd_dma_buf_t *retbuf)
@@ -2884,7 +3016,12 @@ dhd_msgbuf_rxbuf_post(dhd_pub_t *dhd, bool use_rsv_pktid)
 		retcount = dhd_prot_rxbuf_post(dhd, fillbufs, use_rsv_pktid);
 
 		if (retcount >= 0) {
+			unsigned long flags;
+
+			/* the DPC returns buffers while the rx_compl_tasklet posts */
+			DHD_GENERAL_LOCK(dhd, flags);
 			prot->rxbufpost += (uint16)retcount;
+			DHD_GENERAL_UNLOCK(dhd, flags);
 #ifdef DHD_LB_RXC
 			/* dhd_prot_rxbuf_post returns the number of buffers posted */
 			DHD_LB_STATS_UPDATE_RXC_HISTO(dhd, retcount);
@@ -2936,6 +3073,11 @@ dhd_prot_rxbuf_post(dhd_pub_t *dhd, uint16 count, bool use_rsv_pktid)
 	/* loop through each allocated message in the rxbuf post msgbuf_ring */
 	for (i = 0; i < alloced; i++) {
 		rxbuf_post = (host_rxbuf_post_t *)rxbuf_post_tmp;
+		/* Reuse a buffer whose frame was copied out, it is still mapped and pulled */
+		if ((p = dhd_prot_rxbuf_recycle_get(dhd, &pa, &pktlen)) != NULL) {
+			goto post;
+		}
+
 		/* Create a rx buffer */
 		if ((p = PKTGET(dhd->osh, pktsz, FALSE)) == NULL) {
 			DHD_ERROR(("%s:%d: PKTGET for rxbuf failed\n", __FUNCTION__, __LINE__));
@@ -2963,6 +3105,7 @@ dhd_prot_rxbuf_post(dhd_pub_t *dhd, uint16 count, bool use_rsv_pktid)
 		PKTPULL(dhd->osh, p, prot->rx_metadata_offset);
 		pktlen = PKTLEN(dhd->osh, p);
 
+post:
 		/* Common msg header */
 		rxbuf_post->cmn_hdr.msg_type = MSG_TYPE_RXBUF_POST;
 		rxbuf_post->cmn_hdr.if_id = 0;
@@ -3406,7 +3549,8 @@ dhd_prot_process_msgbuf_rxcpl(dhd_pub_t *dhd, uint bound)
 }
 
 /**
- * Hands transmit packets (with a caller provided flow_id) over to dongle territory (the flow ring)
+ * Refreshes the read index of a flow ring, before the bus tx scheduler hands transmit packets over
+ * to dongle territory (the flow ring)
  */
 void
 dhd_prot_update_txflowring(dhd_pub_t *dhd, uint16 flowid, void *msgring)
@@ -3420,9 +3564,6 @@ dhd_prot_update_txflowring(dhd_pub_t *dhd, uint16 flowid, void *msgring)
 
 	DHD_TRACE(("ringid %d flowid %d write %d read %d \n\n",
 		ring->idx, flowid, ring->wr, ring->rd));
-
-	/* Need more logic here, but for now use it directly */
-	dhd_bus_schedule_queue(dhd->bus, flowid, TRUE); /* from queue to flowring */
 }
 
 /** called when DHD needs to check for 'transmit complete' messages from the dongle */
@@ -3590,6 +3731,9 @@ dhd_prot_process_msgtype(dhd_pub_t *dhd, msgbuf_ring_t *ring, uint8 *buf, uint32
 
 done:
 
+	/* rx buffers of the whole batch, before the LB dispatch looks at rxbufpost */
+	if (ring == &dhd->prot->d2hring_rx_cpln)
+		dhd_prot_rxbuf_cpl_flush(dhd);
 #ifdef DHD_RX_CHAINING
 	dhd_rxchain_commit(dhd);
 #endif
@@ -3761,6 +3905,30 @@ exit:
 #endif /* !IOCTLRESP_USE_CONSTMEM */
 }
 
+/**
+ * Takes a completed tx packet off the bytes in flight on its flow ring, and accounts its
+ * completion latency
+ */
+static INLINE void BCMFASTPATH
+dhd_prot_flow_ring_txcmpl(dhd_pub_t *dhd, void *pkt, uint32 len, uint16 tx_status)
+{
+	uint16 flowid = DHD_PKT_GET_FLOWID(pkt);
+	flow_ring_node_t *flow_ring_node;
+
+	if ((dhd->flow_ring_table == NULL) || (flowid >= dhd->num_flow_rings)) {
+		return;
+	}
+
+	flow_ring_node = DHD_FLOW_RING(dhd, flowid);
+	/* the ring may have been deleted and recreated meanwhile */
+	flow_ring_node->tx_inflight -= MIN(len, flow_ring_node->tx_inflight);
+
+	flow_ring_node->txlat.cmpl[dhd_tx_lat_bin(PKTTXSTAMP_US(dhd->osh, pkt))]++;
+	if (tx_status) {
+		flow_ring_node->txlat.cmpl_err++;
+	}
+}
+
 /** called on MSG_TYPE_TX_STATUS message received from dongle */
 static void BCMFASTPATH
 dhd_prot_txstatus_process(dhd_pub_t *dhd, void *msg)
@@ -3811,6 +3979,9 @@ dhd_prot_txstatus_process(dhd_pub_t *dhd, void *msg)
 
 		pkt = DHD_PKTID_TO_NATIVE(dhd, dhd->prot->pktid_map_handle,
 			pktid, pa, len, dmah, secdma, PKTTYPE_DATA_TX);
+		if (pkt) {
+			dhd_prot_flow_ring_txcmpl(dhd, pkt, len, ltoh16(txstatus->tx_status));
+		}
 
 		workq = &prot->tx_compl_prod;
 		/*
@@ -3859,6 +4030,9 @@ workq_ring_full:
 	if (pkt == NULL) {
 		pkt = DHD_PKTID_TO_NATIVE(dhd, dhd->prot->pktid_map_handle,
 			pktid, pa, len, dmah, secdma, PKTTYPE_DATA_TX);
+		if (pkt) {
+			dhd_prot_flow_ring_txcmpl(dhd, pkt, len, ltoh16(txstatus->tx_status));
+		}
 	}
 
 	if (pkt) {
@@ -3964,6 +4138,8 @@ dhd_prot_rxcmplt_process(dhd_pub_t *dhd, void *msg)
 	unsigned long flags;
 	uint ifidx;
 	uint32 pktid;
+	uint32 offset;
+	bool copied;
 #if defined(DHD_LB_RXC)
 	const bool free_pktid = FALSE;
 #else
@@ -3986,8 +4162,11 @@ dhd_prot_rxcmplt_process(dhd_pub_t *dhd, void *msg)
 		}
 #endif /* DHD_PKTID_AUDIT_RING */
 
+	offset = data_offset ? data_offset : dhd->prot->rx_dataoffset;
+
 	DHD_GENERAL_LOCK(dhd, flags);
-	pkt = dhd_prot_packet_get(dhd, pktid, PKTTYPE_DATA_RX, free_pktid);
+	pkt = dhd_prot_rxpkt_get(dhd, pktid, free_pktid, offset,
+		ltoh16(rxcmplt_h->data_len), &copied);
 	DHD_GENERAL_UNLOCK(dhd, flags);
 
 	if (!pkt) {
@@ -3997,6 +4176,11 @@ dhd_prot_rxcmplt_process(dhd_pub_t *dhd, void *msg)
 	/* Post another set of rxbufs to the device */
 	dhd_prot_return_rxbuf(dhd, pktid, 1);
 
+	/* a copied frame starts at the packet head and carries no metadata */
+	if (copied) {
+		goto sendup;
+	}
+
 	DHD_INFO(("id 0x%04x, offset %d, len %d, idx %d, phase 0x%02x, pktdata %p, metalen %d\n",
 		ltoh32(rxcmplt_h->cmn_hdr.request_id), data_offset, ltoh16(rxcmplt_h->data_len),
 		rxcmplt_h->cmn_hdr.if_id, rxcmplt_h->cmn_hdr.flags, PKTDATA(dhd->osh, pkt),
@@ -4029,6 +4213,7 @@ dhd_prot_rxcmplt_process(dhd_pub_t *dhd, void *msg)
 	/* Actual length of the packet */
 	PKTSETLEN(dhd->osh, pkt, ltoh16(rxcmplt_h->data_len));
 
+sendup:
 	ifidx = rxcmplt_h->cmn_hdr.if_id;
 
 #if defined(DHD_LB_RXP)
@@ -4172,6 +4357,9 @@ dhd_prot_txdata(dhd_pub_t *dhd, void *PKTBUF, uint8 ifidx)
 	DHD_NATIVE_TO_PKTID_SAVE(dhd, dhd->prot->pktid_map_handle, PKTBUF, pktid,
 	    pa, pktlen, DMA_TX, NULL, ring->dma_buf.secdma, PKTTYPE_DATA_TX);
 
+	/* bytes in flight on the flow ring, limited by the bus tx scheduler */
+	flow_ring_node->tx_inflight += pktlen;
+
 #ifdef TXP_FLUSH_NITEMS
 	if (ring->pend_items_count == 0) {
 		ring->start_addr = (void *)txdesc;
@@ -4363,13 +4551,35 @@ dhd_prot_return_rxbuf(dhd_pub_t *dhd, uint32 pktid, uint32 rxcnt)
 
 #endif /* DHD_LB_RXC */
 
+	/*
+	 * The accounting and the reposting are done once per batch of rx
+	 * completions, see dhd_prot_process_msgtype(), or once a burst worth
+	 * of buffers is pending in a long batch.
+	 */
+	prot->rxbuf_cpl_pend += rxcnt;
+	if (prot->rxbuf_cpl_pend >= RX_BUF_BURST)
+		dhd_prot_rxbuf_cpl_flush(dhd);
+}
+
+/** take the completed rx buffers off the posted count and post new ones */
+static void BCMFASTPATH
+dhd_prot_rxbuf_cpl_flush(dhd_pub_t *dhd)
+{
+	dhd_prot_t *prot = dhd->prot;
+	unsigned long flags;
+
+	if (prot->rxbuf_cpl_pend == 0)
+		return;
 
-	if (prot->rxbufpost >= rxcnt) {
-		prot->rxbufpost -= rxcnt;
+	DHD_GENERAL_LOCK(dhd, flags);
+	if (prot->rxbufpost >= prot->rxbuf_cpl_pend) {
+		prot->rxbufpost -= prot->rxbuf_cpl_pend;
 	} else {
 		/* ASSERT(0); */
 		prot->rxbufpost = 0;
 	}
+	DHD_GENERAL_UNLOCK(dhd, flags);
+	prot->rxbuf_cpl_pend = 0;
 
 #if !defined(DHD_LB_RXC)
 	if (prot->rxbufpost <= (prot->max_rxbufpost - RXBUFPOST_THRESHOLD)) {
@@ -6004,6 +6214,8 @@ void dhd_prot_print_info(dhd_pub_t *dhd, struct bcmstrbuf *strbuf)
 	bcm_bprintf(strbuf, "active_tx_count %d	 pktidmap_avail %d\n",
 		dhd->prot->active_tx_count,
 		DHD_PKTID_AVAIL(dhd->prot->pktid_map_handle));
+	bcm_bprintf(strbuf, "rx_copybreak %d rx_copied %d rx_recycle %d\n",
+		prot->rx_copybreak, prot->rx_copied, prot->rx_recycle_cnt);
 }
 
 int
@@ -214,6 +214,7 @@ enum {
 	IOV_RXBOUND,
 	IOV_TXBOUND,
 	IOV_HANGREPORT,
+	IOV_TX_FLOW_LIMIT,
 #ifdef PCIE_OOB
 	IOV_OOB_BT_REG_ON,
 	IOV_OOB_ENABLE
@@ -262,12 +263,16 @@ const bcm_iovar_t dhdpcie_iovars[] = {
 	{"rxbound",     IOV_RXBOUND,    0,      IOVT_UINT32,    0 },
 	{"txbound",     IOV_TXBOUND,    0,      IOVT_UINT32,    0 },
 	{"fw_hang_report", IOV_HANGREPORT,	0,	IOVT_BOOL,	0 },
+	{"tx_flow_limit", IOV_TX_FLOW_LIMIT,	0,	IOVT_UINT32,	0 },
 	{NULL, 0, 0, 0, 0 }
 };
 
 
 #define MAX_READ_TIMEOUT	5 * 1000 * 1000
 
+/* Default bytes in flight per tx flow ring, the rest waits in the flow queue */
+#define DHD_TX_FLOW_LIMIT	(64 * 1024)
+
 #ifndef DHD_RXBOUND
 #define DHD_RXBOUND		64
 #endif
@@ -350,6 +355,7 @@ dhd_bus_t* dhdpcie_bus_attach(osl_t *osh,
 		bus->dev = (struct pci_dev *)pci_dev;
 
 		dll_init(&bus->const_flowring);
+		bus->tx_flow_limit = DHD_TX_FLOW_LIMIT;
 
 		/* Attach pcie shared structure */
 		if (!(bus->pcie_sh = MALLOCZ(osh, sizeof(pciedev_shared_t)))) {
@@ -2231,28 +2237,51 @@ dhdpcie_bus_membytes(dhd_bus_t *bus, bool write, ulong address, uint8 *data, uin
 	return BCME_OK;
 } /* dhdpcie_bus_membytes */
 
+/* DRR quantum of a backlogged flow ring per round, scaled by the weight of its access category */
+#define DHD_TX_SCHED_QUANTUM	1536
+/* DRR rounds per scheduler run */
+#define DHD_TX_SCHED_ROUNDS	64
+
+static const uint8 dhd_tx_sched_ac_weight[AC_COUNT] = {
+	2,	/* AC_BE */
+	1,	/* AC_BK */
+	4,	/* AC_VI */
+	8	/* AC_VO */
+};
+
+static const uint8 dhd_tx_sched_tid2ac[NUMPRIO] = {
+	AC_BE, AC_BK, AC_BK, AC_BE, AC_VI, AC_VI, AC_VO, AC_VO
+};
+
+static INLINE int32
+dhd_bus_flow_ring_quantum(dhd_pub_t *dhdp, flow_ring_node_t *flow_ring_node)
+{
+	uint8 ac = flow_ring_node->flow_info.tid;
+
+	if (dhdp->flow_prio_map_type == DHD_FLOW_PRIO_TID_MAP) {
+		ac = dhd_tx_sched_tid2ac[ac & (NUMPRIO - 1)];
+	} else if (ac >= AC_COUNT) {
+		/* lossless roaming maps 802.1X frames past the last AC */
+		ac = AC_VO;
+	}
+
+	return DHD_TX_SCHED_QUANTUM * dhd_tx_sched_ac_weight[ac];
+}
+
 /**
- * Transfers one transmit (ethernet) packet that was queued in the (flow controlled) flow ring queue
- * to the (non flow controlled) flow ring.
+ * Transfers transmit (ethernet) packets that were queued in the (flow controlled) flow ring queue
+ * to the (non flow controlled) flow ring, until the flow ring has tx_flow_limit bytes in flight.
+ * With 'drr', packets are only sent while they fit in the DRR deficit of the flow ring.
+ * Returns BCME_BUSY if the flow ring ran out of space.
  */
-int BCMFASTPATH
-dhd_bus_schedule_queue(struct dhd_bus  *bus, uint16 flow_id, bool txs)
+static int BCMFASTPATH
+dhd_bus_flow_ring_xmit(struct dhd_bus *bus, flow_ring_node_t *flow_ring_node, bool drr)
 {
-	flow_ring_node_t *flow_ring_node;
+	uint16 flow_id = flow_ring_node->flowid;
 	int ret = BCME_OK;
 #ifdef DHD_LOSSLESS_ROAMING
 	dhd_pub_t *dhdp = bus->dhd;
 #endif
-	DHD_INFO(("%s: flow_id is %d\n", __FUNCTION__, flow_id));
-
-	/* ASSERT on flow_id */
-	if (flow_id >= bus->max_sub_queues) {
-		DHD_ERROR(("%s: flow_id is invalid %d, max %d\n", __FUNCTION__,
-			flow_id, bus->max_sub_queues));
-		return 0;
-	}
-
-	flow_ring_node = DHD_FLOW_RING(bus->dhd, flow_id);
 
 #ifdef DHD_LOSSLESS_ROAMING
 	if ((dhdp->dequeue_prec_map & (1 << flow_ring_node->flow_info.tid)) == 0) {
@@ -2280,9 +2309,27 @@ dhd_bus_schedule_queue(struct dhd_bus  *bus, uint16 flow_id, bool txs)
 			return BCME_NOTREADY;
 		}
 
-		while ((txp = dhd_flow_queue_dequeue(bus->dhd, queue)) != NULL) {
+		while ((txp = queue->head) != NULL) {
+			uint32 pktlen;
+
+			if (bus->tx_flow_limit &&
+				flow_ring_node->tx_inflight >= bus->tx_flow_limit) {
+				break;
+			}
+
+			pktlen = PKTLEN(bus->dhd->osh, txp);
+			if (drr && (int32)pktlen > flow_ring_node->tx_deficit) {
+				break;
+			}
+
+			txp = dhd_flow_queue_dequeue(bus->dhd, queue);
 			PKTORPHAN(txp);
 
+			/* time spent in the flow queue, then restart for the completion */
+			flow_ring_node->txlat.queue[
+				dhd_tx_lat_bin(PKTTXSTAMP_US(bus->dhd->osh, txp))]++;
+			PKTSETTXSTAMP(bus->dhd->osh, txp);
+
 			/*
 			 * Modifying the packet length caused P2P cert failures.
 			 * Specifically on test cases where a packet of size 52 bytes
@@ -2322,9 +2369,17 @@ dhd_bus_schedule_queue(struct dhd_bus  *bus, uint16 flow_id, bool txs)
 				dhd_flow_queue_reinsert(bus->dhd, queue, txp);
 				DHD_FLOWRING_UNLOCK(flow_ring_node->lock, flags);
 
-				/* If we are able to requeue back, return success */
-				return BCME_OK;
+				return BCME_BUSY;
 			}
+
+			if (drr) {
+				flow_ring_node->tx_deficit -= pktlen;
+			}
+		}
+
+		/* an idle flow does not keep its deficit */
+		if (DHD_FLOW_QUEUE_EMPTY(queue)) {
+			flow_ring_node->tx_deficit = 0;
 		}
 
 		dhd_prot_txdata_write_flush(bus->dhd, flow_id, FALSE);
@@ -2333,6 +2388,30 @@ dhd_bus_schedule_queue(struct dhd_bus  *bus, uint16 flow_id, bool txs)
 	}
 
 	return ret;
+} /* dhd_bus_flow_ring_xmit */
+
+/**
+ * Transfers transmit (ethernet) packets that were queued in the (flow controlled) flow ring queue
+ * to the (non flow controlled) flow ring.
+ */
+int BCMFASTPATH
+dhd_bus_schedule_queue(struct dhd_bus  *bus, uint16 flow_id, bool txs)
+{
+	int ret;
+
+	DHD_INFO(("%s: flow_id is %d\n", __FUNCTION__, flow_id));
+
+	/* ASSERT on flow_id */
+	if (flow_id >= bus->max_sub_queues) {
+		DHD_ERROR(("%s: flow_id is invalid %d, max %d\n", __FUNCTION__,
+			flow_id, bus->max_sub_queues));
+		return 0;
+	}
+
+	ret = dhd_bus_flow_ring_xmit(bus, DHD_FLOW_RING(bus->dhd, flow_id), FALSE);
+
+	/* If we are able to requeue back, return success */
+	return (ret == BCME_BUSY) ? BCME_OK : ret;
 } /* dhd_bus_schedule_queue */
 
 /** Sends an (ethernet) data frame (in 'txp') to the dongle. Callee disposes of txp. */
@@ -2374,6 +2453,7 @@ dhd_bus_txdata(struct dhd_bus *bus, void *txp, uint8 ifidx)
 
 	queue = &flow_ring_node->queue; /* queue associated with flow ring */
 
+	PKTSETTXSTAMP(bus->dhd->osh, txp);
 	if ((ret = dhd_flow_queue_enqueue(bus->dhd, queue, txp)) != BCME_OK) {
 		txp_pend = txp;
 	}
@@ -3796,6 +3876,15 @@ dhdpcie_bus_doiovar(dhd_bus_t *bus, const bcm_iovar_t *vi, uint32 actionid, cons
 		bcopy(&int_val, arg, val_size);
 		break;
 
+	case IOV_GVAL(IOV_TX_FLOW_LIMIT):
+		int_val = (int32)bus->tx_flow_limit;
+		bcopy(&int_val, arg, val_size);
+		break;
+
+	case IOV_SVAL(IOV_TX_FLOW_LIMIT):
+		bus->tx_flow_limit = (uint32)int_val;
+		break;
+
 	default:
 		bcmerror = BCME_UNSUPPORTED;
 		break;
@@ -4510,6 +4599,44 @@ void dhd_dump_intr_registers(dhd_pub_t *dhd, struct bcmstrbuf *strbuf)
 }
 
 /** Add bus dump output to a buffer */
+/** Per station (flow ring) histograms of the host queue and tx completion latency */
+static void
+dhd_bus_dump_txlat(dhd_pub_t *dhdp, struct bcmstrbuf *strbuf)
+{
+	uint16 flowid;
+	flow_ring_node_t *flow_ring_node;
+	flow_info_t *flow_info;
+	char eabuf[ETHER_ADDR_STR_LEN];
+	int i;
+
+	bcm_bprintf(strbuf, "Tx latency (usec) %4s %17s %4s %5s", "Flow", ":Dest_MacAddress:",
+		"Prio", "");
+	for (i = 0; i < DHD_TX_LAT_BINS - 1; i++) {
+		bcm_bprintf(strbuf, " <%-6u", 1 << (DHD_TX_LAT_BIN0_SHIFT + i));
+	}
+	bcm_bprintf(strbuf, " >=%-5u %7s\n", 1 << (DHD_TX_LAT_BIN0_SHIFT + i), "Errors");
+
+	for (flowid = 0; flowid < dhdp->num_flow_rings; flowid++) {
+		flow_ring_node = DHD_FLOW_RING(dhdp, flowid);
+		if (!flow_ring_node->active) {
+			continue;
+		}
+
+		flow_info = &flow_ring_node->flow_info;
+		bcm_bprintf(strbuf, "%17s %4d %17s %4d %5s", "", flow_ring_node->flowid,
+			bcm_ether_ntoa((struct ether_addr *)&flow_info->da, eabuf),
+			flow_info->tid, "queue");
+		for (i = 0; i < DHD_TX_LAT_BINS; i++) {
+			bcm_bprintf(strbuf, " %7u", flow_ring_node->txlat.queue[i]);
+		}
+		bcm_bprintf(strbuf, "\n%17s %4s %17s %4s %5s", "", "", "", "", "cmpl");
+		for (i = 0; i < DHD_TX_LAT_BINS; i++) {
+			bcm_bprintf(strbuf, " %7u", flow_ring_node->txlat.cmpl[i]);
+		}
+		bcm_bprintf(strbuf, " %7u\n", flow_ring_node->txlat.cmpl_err);
+	}
+}
+
 void dhd_bus_dump(dhd_pub_t *dhdp, struct bcmstrbuf *strbuf)
 {
 	uint16 flowid;
@@ -4525,12 +4652,13 @@ void dhd_bus_dump(dhd_pub_t *dhdp, struct bcmstrbuf *strbuf)
 	dhd_dump_intr_registers(dhdp, strbuf);
 	bcm_bprintf(strbuf, "h2d_mb_data_ptr_addr 0x%x, d2h_mb_data_ptr_addr 0x%x\n",
 		dhdp->bus->h2d_mb_data_ptr_addr, dhdp->bus->d2h_mb_data_ptr_addr);
-	bcm_bprintf(strbuf, "dhd cumm_ctr %d\n", DHD_CUMM_CTR_READ(&dhdp->cumm_ctr));
+	bcm_bprintf(strbuf, "dhd cumm_ctr %d tx_flow_limit %u\n",
+		DHD_CUMM_CTR_READ(&dhdp->cumm_ctr), dhdp->bus->tx_flow_limit);
 	bcm_bprintf(strbuf,
 		"%s %4s %2s %4s %17s %4s %4s %10s %4s %4s %17s %17s %7s ",
 		"Num:", "Flow", "If", "Prio", ":Dest_MacAddress:", "Qlen", "CLen",
 		"Overflows", "RD", "WR", "BASE(VA)", "BASE(PA)", "SIZE");
-	bcm_bprintf(strbuf, "%5s %6s %5s \n", "Acked", "tossed", "noack");
+	bcm_bprintf(strbuf, "%5s %6s %5s %8s \n", "Acked", "tossed", "noack", "Inflight");
 
 	for (flowid = 0; flowid < dhdp->num_flow_rings; flowid++) {
 		flow_ring_node = DHD_FLOW_RING(dhdp, flowid);
@@ -4546,9 +4674,11 @@ void dhd_bus_dump(dhd_pub_t *dhdp, struct bcmstrbuf *strbuf)
 			dhd_prot_print_flow_ring(dhdp, flow_ring_node->prot_info, strbuf,
 				"%4d %4d %17p %8x:%8x %7d ");
 			bcm_bprintf(strbuf,
-				"%5s %6s %5s\n", "NA", "NA", "NA");
+				"%5s %6s %5s %8u\n", "NA", "NA", "NA",
+				flow_ring_node->tx_inflight);
 		}
 	}
+	dhd_bus_dump_txlat(dhdp, strbuf);
 	bcm_bprintf(strbuf, "D3 inform cnt %d\n", dhdp->bus->d3_inform_cnt);
 	bcm_bprintf(strbuf, "D0 inform cnt %d\n", dhdp->bus->d0_inform_cnt);
 	bcm_bprintf(strbuf, "D0 inform in use cnt %d\n", dhdp->bus->d0_inform_in_use_cnt);
@@ -4557,7 +4687,9 @@ void dhd_bus_dump(dhd_pub_t *dhdp, struct bcmstrbuf *strbuf)
 
 /**
  * Brings transmit packets on all flow rings closer to the dongle, by moving (a subset) from their
- * flow queue to their flow ring.
+ * flow queue to their flow ring. Backlogged flow rings are served by deficit round robin, weighted
+ * by access category, so that bulk flows do not take the room in flight from latency sensitive
+ * ones.
  */
 static void
 dhd_update_txflowrings(dhd_pub_t *dhd)
@@ -4566,6 +4698,8 @@ dhd_update_txflowrings(dhd_pub_t *dhd)
 	dll_t *item, *next;
 	flow_ring_node_t *flow_ring_node;
 	struct dhd_bus *bus = dhd->bus;
+	bool more;
+	int round = 0;
 
 	DHD_FLOWRING_LIST_LOCK(bus->dhd->flowring_list_lock, flags);
 	for (item = dll_head_p(&bus->const_flowring);
@@ -4586,6 +4720,34 @@ dhd_update_txflowrings(dhd_pub_t *dhd)
 
 		dhd_prot_update_txflowring(dhd, flow_ring_node->flowid, flow_ring_node->prot_info);
 	}
+
+	do {
+		more = FALSE;
+		for (item = dll_head_p(&bus->const_flowring);
+			(!dhd_is_device_removed(dhd) && !dll_end(&bus->const_flowring, item));
+			item = next) {
+			if (dhd->hang_was_sent) {
+				break;
+			}
+
+			next = dll_next_p(item);
+			flow_ring_node = dhd_constlist_to_flowring(item);
+
+			if (DHD_FLOW_QUEUE_EMPTY(&flow_ring_node->queue)) {
+				continue;
+			}
+			if (bus->tx_flow_limit &&
+				flow_ring_node->tx_inflight >= bus->tx_flow_limit) {
+				continue;
+			}
+
+			flow_ring_node->tx_deficit += dhd_bus_flow_ring_quantum(dhd, flow_ring_node);
+			if (dhd_bus_flow_ring_xmit(bus, flow_ring_node, TRUE) == BCME_OK &&
+				!DHD_FLOW_QUEUE_EMPTY(&flow_ring_node->queue)) {
+				more = TRUE;
+			}
+		}
+	} while (more && (++round < DHD_TX_SCHED_ROUNDS));
 	DHD_FLOWRING_LIST_UNLOCK(bus->dhd->flowring_list_lock, flags);
 }
 
@@ -4913,14 +5075,14 @@ dhdpci_bus_read_frames(dhd_bus_t *bus)
 	DHD_PERIM_UNLOCK_ALL((bus->dhd->fwder_unit % FWDER_MAX_UNIT));
 
 	DHD_PERIM_LOCK_ALL((bus->dhd->fwder_unit % FWDER_MAX_UNIT));
-	/* update the flow ring cpls */
-	dhd_update_txflowrings(bus->dhd);
-
 	/* With heavy TX traffic, we could get a lot of TxStatus
 	 * so add bound
 	 */
 	more |= dhd_prot_process_msgbuf_txcpl(bus->dhd, dhd_txbound);
 
+	/* update the flow ring cpls, after the tx completions made room in flight */
+	dhd_update_txflowrings(bus->dhd);
+
 	/* With heavy RX traffic, this routine potentially could spend some time
 	 * processing RX frames without RX bound
 	 */
@@ -133,6 +133,7 @@ typedef struct dhd_bus {
 	dhd_pub_t	*dhd;
 	struct pci_dev  *dev;		/* pci device handle */
 	dll_t       const_flowring; /* constructed list of tx flowring queues */
+	uint32      tx_flow_limit; /* bytes a flow ring may have in flight, 0 for no limit */
 
 	si_t		*sih;			/* Handle for SI calls */
 	char		*vars;			/* Variables (from CIS and/or other) */
@@ -182,6 +182,14 @@ extern dmaaddr_t osl_dma_map(osl_t *osh, void *va, uint size, int direction, voi
 	hnddma_seg_map_t *txp_dmah);
 extern void osl_dma_unmap(osl_t *osh, dmaaddr_t pa, uint size, int direction);
 
+/* hand a part of a mapped buffer to the CPU or back to the device, keeping the mapping */
+#define	DMA_SYNC_FOR_CPU(osh, pa, offset, size, direction) \
+	osl_dma_sync((osh), (pa), (offset), (size), (direction), FALSE)
+#define	DMA_SYNC_FOR_DEVICE(osh, pa, offset, size, direction) \
+	osl_dma_sync((osh), (pa), (offset), (size), (direction), TRUE)
+extern void osl_dma_sync(osl_t *osh, dmaaddr_t pa, uint offset, uint size, int direction,
+	bool for_device);
+
 /* API for DMA addressing capability */
 #define OSL_DMADDRWIDTH(osh, addrwidth) ({BCM_REFERENCE(osh); BCM_REFERENCE(addrwidth);})
 
@@ -456,6 +464,13 @@ extern void osl_pkt_orphan_partial(struct sk_buff *skb);
 #define PKTORPHAN(skb)          ({BCM_REFERENCE(skb); 0;})
 #endif /* LINUX VERSION >= 3.6 */
 
+/* tx latency accounting, the time stamp is kept in the skb tstamp field */
+#define PKTSETTXSTAMP(osh, skb) \
+	({BCM_REFERENCE(osh); ((struct sk_buff*)(skb))->tstamp = ktime_get();})
+#define PKTTXSTAMP_US(osh, skb) \
+	({BCM_REFERENCE(osh); \
+	(uint32)max_t(s64, 0, ktime_us_delta(ktime_get(), ((struct sk_buff*)(skb))->tstamp));})
+
 
 #ifdef BCMDBG_CTRACE
 #define	DEL_CTRACE(zosh, zskb) { \
@@ -1673,6 +1673,29 @@ osl_dma_unmap(osl_t *osh, dmaaddr_t pa, uint size, int direction)
 #endif /* BCMDMA64OSL */
 }
 
+void BCMFASTPATH
+osl_dma_sync(osl_t *osh, dmaaddr_t pa, uint offset, uint size, int direction, bool for_device)
+{
+	struct pci_dev *pdev;
+	int dir;
+	dma_addr_t paddr;
+
+	ASSERT((osh && (osh->magic == OS_HANDLE_MAGIC)));
+
+	pdev = (struct pci_dev *)osh->pdev;
+	dir = (direction == DMA_TX)? PCI_DMA_TODEVICE: PCI_DMA_FROMDEVICE;
+#ifdef BCMDMA64OSL
+	PHYSADDRTOULONG(pa, paddr);
+#else
+	paddr = (uint32)pa;
+#endif /* BCMDMA64OSL */
+
+	if (for_device)
+		dma_sync_single_range_for_device(&pdev->dev, paddr, offset, size, dir);
+	else
+		dma_sync_single_range_for_cpu(&pdev->dev, paddr, offset, size, dir);
+}
+
 /* OSL function for CPU relax */
 inline void BCMFASTPATH
 osl_cpu_relax(void)
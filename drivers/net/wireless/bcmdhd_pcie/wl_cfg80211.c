@@ -5740,6 +5740,10 @@ wl_cfg80211_get_station(struct wiphy *wiphy, struct net_device *dev,
 		sinfo->tx_failed  = sta->tx_failures;
 		sinfo->rx_bytes = sta->rx_tot_bytes;
 		sinfo->tx_bytes = sta->tx_tot_bytes;
+		if (sta->len >= (OFFSETOF(sta_info_t, tx_pkts_retried) + sizeof(uint32))) {
+			sinfo->filled |= STA_INFO_BIT(INFO_TX_RETRIES);
+			sinfo->tx_retries = dtoh32(sta->tx_pkts_retried);
+		}
 #if (LINUX_VERSION_CODE >= KERNEL_VERSION(3, 0, 0)) || defined(WL_COMPAT_WIRELESS)
 		if (sta->flags & WL_STA_ASSOC) {
 			sinfo->filled |= STA_INFO_BIT(INFO_CONNECTED_TIME);
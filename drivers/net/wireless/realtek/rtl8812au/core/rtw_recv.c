@@ -3271,12 +3271,55 @@ exit:
 }
 
 #if defined(CONFIG_80211N_HT) && defined(CONFIG_RECV_REORDERING_CTRL)
+/* Indicate the frame buffered for indicate_seq, if any, and move the window on by one */
+static void recv_reorder_release_one(_adapter *padapter, struct recv_reorder_ctrl *preorder_ctrl)
+{
+	struct recv_priv *precvpriv = &padapter->recvpriv;
+	u8 idx = RECV_REORDER_IDX(preorder_ctrl->indicate_seq);
+	union recv_frame *prframe = preorder_ctrl->reorder_buf[idx];
+	u16 seq_num;
+
+	if (prframe) {
+		seq_num = prframe->u.hdr.attrib.seq_num;
+		preorder_ctrl->reorder_buf[idx] = NULL;
+		preorder_ctrl->reorder_cnt--;
+
+		if (recv_process_mpdu(padapter, prframe) != _SUCCESS)
+			precvpriv->dbg_rx_drop_count++;
+
+		/* left over from before a window reset, the window stays */
+		if (!SN_EQUAL(seq_num, preorder_ctrl->indicate_seq))
+			return;
+	}
+
+	preorder_ctrl->indicate_seq = (preorder_ctrl->indicate_seq + 1) & 0xFFF;
+	#ifdef DBG_RX_SEQ
+	RTW_INFO("DBG_RX_SEQ "FUNC_ADPT_FMT" tid:%u SN_EQUAL indicate_seq:%d\n"
+		, FUNC_ADPT_ARG(padapter), preorder_ctrl->tid, preorder_ctrl->indicate_seq);
+	#endif
+}
+
+/* Move the window start to seq_num, indicating the buffered frames on the way */
+static void recv_reorder_release_to(_adapter *padapter, struct recv_reorder_ctrl *preorder_ctrl, u16 seq_num)
+{
+	u16 steps = (seq_num - preorder_ctrl->indicate_seq) & 0xFFF;
+
+	/* past one lap of the ring every slot has been visited */
+	if (steps > RECV_REORDER_BUF_SZ)
+		steps = RECV_REORDER_BUF_SZ;
+
+	while (steps-- && preorder_ctrl->reorder_cnt)
+		recv_reorder_release_one(padapter, preorder_ctrl);
+
+	preorder_ctrl->indicate_seq = seq_num;
+}
+
 static int check_indicate_seq(struct recv_reorder_ctrl *preorder_ctrl, u16 seq_num)
 {
 	PADAPTER padapter = preorder_ctrl->padapter;
 	struct recv_priv  *precvpriv = &padapter->recvpriv;
-	u8	wsize = preorder_ctrl->wsize_b;
-	u16	wend = (preorder_ctrl->indicate_seq + wsize - 1) & 0xFFF; /* % 4096; */
+	u8	wsize = rtw_min(preorder_ctrl->wsize_b, RECV_REORDER_BUF_SZ);
+	u16	wend;
 
 	/* Rx Reorder initialize condition. */
 	if (preorder_ctrl->indicate_seq == 0xFFFF) {
@@ -3286,6 +3329,7 @@ static int check_indicate_seq(struct recv_reorder_ctrl *preorder_ctrl, u16 seq_n
 			, FUNC_ADPT_ARG(padapter), preorder_ctrl->tid, preorder_ctrl->indicate_seq, seq_num);
 		#endif
 	}
+	wend = (preorder_ctrl->indicate_seq + wsize - 1) & 0xFFF; /* % 4096; */
 
 	/* Drop out the packet which SeqNum is smaller than WinStart */
 	if (SN_LESS(seq_num, preorder_ctrl->indicate_seq)) {
@@ -3297,23 +3341,21 @@ static int check_indicate_seq(struct recv_reorder_ctrl *preorder_ctrl, u16 seq_n
 	}
 
 	/*
-	* Sliding window manipulation. Conditions includes:
-	* 1. Incoming SeqNum is equal to WinStart =>Window shift 1
-	* 2. Incoming SeqNum is larger than the WinEnd => Window shift N
+	* Sliding window manipulation. An incoming SeqNum larger than the
+	* WinEnd shifts the window by N, frames falling out of it are
+	* indicated. SeqNum equal to WinStart is taken care of by
+	* recv_indicatepkts_in_order() once the frame is in the buffer.
 	*/
-	if (SN_EQUAL(seq_num, preorder_ctrl->indicate_seq)) {
-		preorder_ctrl->indicate_seq = (preorder_ctrl->indicate_seq + 1) & 0xFFF;
-		#ifdef DBG_RX_SEQ
-		RTW_INFO("DBG_RX_SEQ "FUNC_ADPT_FMT" tid:%u SN_EQUAL indicate_seq:%d, seq_num:%d\n"
-			, FUNC_ADPT_ARG(padapter), preorder_ctrl->tid, preorder_ctrl->indicate_seq, seq_num);
-		#endif
+	if (SN_LESS(wend, seq_num)) {
+		u16 wstart;
 
-	} else if (SN_LESS(wend, seq_num)) {
 		/* boundary situation, when seq_num cross 0xFFF */
 		if (seq_num >= (wsize - 1))
-			preorder_ctrl->indicate_seq = seq_num + 1 - wsize;
+			wstart = seq_num + 1 - wsize;
 		else
-			preorder_ctrl->indicate_seq = 0xFFF - (wsize - (seq_num + 1)) + 1;
+			wstart = 0xFFF - (wsize - (seq_num + 1)) + 1;
+
+		recv_reorder_release_to(padapter, preorder_ctrl, wstart);
 
 		precvpriv->dbg_rx_ampdu_window_shift_cnt++;
 		#ifdef DBG_RX_SEQ
@@ -3328,50 +3370,25 @@ static int check_indicate_seq(struct recv_reorder_ctrl *preorder_ctrl, u16 seq_n
 static int enqueue_reorder_recvframe(struct recv_reorder_ctrl *preorder_ctrl, union recv_frame *prframe)
 {
 	struct rx_pkt_attrib *pattrib = &prframe->u.hdr.attrib;
-	_queue *ppending_recvframe_queue = &preorder_ctrl->pending_recvframe_queue;
-	_list	*phead, *plist;
-	union recv_frame *pnextrframe;
-	struct rx_pkt_attrib *pnextattrib;
-
-	/* DbgPrint("+enqueue_reorder_recvframe()\n"); */
-
-	/* _enter_critical_ex(&ppending_recvframe_queue->lock, &irql); */
-	/* _rtw_spinlock_ex(&ppending_recvframe_queue->lock); */
-
-
-	phead = get_list_head(ppending_recvframe_queue);
-	plist = get_next(phead);
-
-	while (rtw_end_of_queue_search(phead, plist) == _FALSE) {
-		pnextrframe = LIST_CONTAINOR(plist, union recv_frame, u);
-		pnextattrib = &pnextrframe->u.hdr.attrib;
-
-		if (SN_LESS(pnextattrib->seq_num, pattrib->seq_num))
-			plist = get_next(plist);
-		else if (SN_EQUAL(pnextattrib->seq_num, pattrib->seq_num)) {
-			/* Duplicate entry is found!! Do not insert current entry. */
-
-			/* _exit_critical_ex(&ppending_recvframe_queue->lock, &irql); */
+	u8 idx = RECV_REORDER_IDX(pattrib->seq_num);
+	union recv_frame *pslot = preorder_ctrl->reorder_buf[idx];
 
+	if (pslot) {
+		/* Duplicate entry is found!! Do not insert current entry. */
+		if (SN_EQUAL(pslot->u.hdr.attrib.seq_num, pattrib->seq_num))
 			return _FALSE;
-		} else
-			break;
-
-		/* DbgPrint("enqueue_reorder_recvframe():while\n"); */
 
+		/* left over from before a window reset, older than anything in the window */
+		preorder_ctrl->reorder_buf[idx] = NULL;
+		preorder_ctrl->reorder_cnt--;
+		if (recv_process_mpdu(preorder_ctrl->padapter, pslot) != _SUCCESS)
+			preorder_ctrl->padapter->recvpriv.dbg_rx_drop_count++;
 	}
 
-
-	/* _enter_critical_ex(&ppending_recvframe_queue->lock, &irql); */
-	/* _rtw_spinlock_ex(&ppending_recvframe_queue->lock); */
-
 	rtw_list_delete(&(prframe->u.hdr.list));
 
-	rtw_list_insert_tail(&(prframe->u.hdr.list), plist);
-
-	/* _rtw_spinunlock_ex(&ppending_recvframe_queue->lock); */
-	/* _exit_critical_ex(&ppending_recvframe_queue->lock, &irql); */
-
+	preorder_ctrl->reorder_buf[idx] = prframe;
+	preorder_ctrl->reorder_cnt++;
 
 	return _TRUE;
 
@@ -3390,138 +3407,43 @@ static void recv_indicatepkts_pkt_loss_cnt(_adapter *padapter, u64 prev_seq, u64
 	}
 }
 
+/*
+ * Indicate the frames from the window start on, until the first hole.
+ * Forced, the holes before the first buffered frame are given up on.
+ * Returns _TRUE if frames are still buffered.
+ */
 static int recv_indicatepkts_in_order(_adapter *padapter, struct recv_reorder_ctrl *preorder_ctrl, int bforced)
 {
-	/* _irqL irql; */
-	_list	*phead, *plist;
-	union recv_frame *prframe;
-	struct rx_pkt_attrib *pattrib;
-	/* u8 index = 0; */
-	int bPktInBuf = _FALSE;
 	struct recv_priv *precvpriv = &padapter->recvpriv;
-	_queue *ppending_recvframe_queue = &preorder_ctrl->pending_recvframe_queue;
+	u16 seq_num;
+	u8 i;
 
 	DBG_COUNTER(padapter->rx_logs.core_rx_post_indicate_in_oder);
 
-	/* DbgPrint("+recv_indicatepkts_in_order\n"); */
-
-	/* _enter_critical_ex(&ppending_recvframe_queue->lock, &irql); */
-	/* _rtw_spinlock_ex(&ppending_recvframe_queue->lock); */
-
-	phead =	get_list_head(ppending_recvframe_queue);
-	plist = get_next(phead);
-
-#if 0
-	/* Check if there is any other indication thread running. */
-	if (pTS->RxIndicateState == RXTS_INDICATE_PROCESSING)
-		return;
-#endif
-
 	/* Handling some condition for forced indicate case. */
 	if (bforced == _TRUE) {
 		precvpriv->dbg_rx_ampdu_forced_indicate_count++;
-		if (rtw_is_list_empty(phead)) {
-			/* _exit_critical_ex(&ppending_recvframe_queue->lock, &irql); */
-			/* _rtw_spinunlock_ex(&ppending_recvframe_queue->lock); */
-			return _TRUE;
-		}
+		if (!preorder_ctrl->reorder_cnt)
+			return _FALSE;
 
-		prframe = LIST_CONTAINOR(plist, union recv_frame, u);
-		pattrib = &prframe->u.hdr.attrib;
+		for (i = 0; i < RECV_REORDER_BUF_SZ; i++) {
+			seq_num = (preorder_ctrl->indicate_seq + i) & 0xFFF;
+			if (preorder_ctrl->reorder_buf[RECV_REORDER_IDX(seq_num)])
+				break;
+		}
 
 		#ifdef DBG_RX_SEQ
 		RTW_INFO("DBG_RX_SEQ "FUNC_ADPT_FMT" tid:%u FORCE indicate_seq:%d, seq_num:%d\n"
-			, FUNC_ADPT_ARG(padapter), preorder_ctrl->tid, preorder_ctrl->indicate_seq, pattrib->seq_num);
+			, FUNC_ADPT_ARG(padapter), preorder_ctrl->tid, preorder_ctrl->indicate_seq, seq_num);
 		#endif
-		recv_indicatepkts_pkt_loss_cnt(padapter, preorder_ctrl->indicate_seq, pattrib->seq_num);
-		preorder_ctrl->indicate_seq = pattrib->seq_num;
-	}
-
-	/* Prepare indication list and indication. */
-	/* Check if there is any packet need indicate. */
-	while (!rtw_is_list_empty(phead)) {
-
-		prframe = LIST_CONTAINOR(plist, union recv_frame, u);
-		pattrib = &prframe->u.hdr.attrib;
-
-		if (!SN_LESS(preorder_ctrl->indicate_seq, pattrib->seq_num)) {
-
-#if 0
-			/* This protect buffer from overflow. */
-			if (index >= REORDER_WIN_SIZE) {
-				RT_ASSERT(FALSE, ("IndicateRxReorderList(): Buffer overflow!!\n"));
-				bPktInBuf = TRUE;
-				break;
-			}
-#endif
-
-			plist = get_next(plist);
-			rtw_list_delete(&(prframe->u.hdr.list));
-
-			if (SN_EQUAL(preorder_ctrl->indicate_seq, pattrib->seq_num)) {
-				preorder_ctrl->indicate_seq = (preorder_ctrl->indicate_seq + 1) & 0xFFF;
-				#ifdef DBG_RX_SEQ
-				RTW_INFO("DBG_RX_SEQ "FUNC_ADPT_FMT" tid:%u SN_EQUAL indicate_seq:%d, seq_num:%d\n"
-					, FUNC_ADPT_ARG(padapter), preorder_ctrl->tid, preorder_ctrl->indicate_seq, pattrib->seq_num);
-				#endif
-			}
-
-#if 0
-			index++;
-			if (index == 1) {
-				/* Cancel previous pending timer. */
-				/* PlatformCancelTimer(Adapter, &pTS->RxPktPendingTimer); */
-				if (bforced != _TRUE) {
-					/* RTW_INFO("_cancel_timer_ex(&preorder_ctrl->reordering_ctrl_timer);\n"); */
-					_cancel_timer_ex(&preorder_ctrl->reordering_ctrl_timer);
-				}
-			}
-#endif
-
-			/* Set this as a lock to make sure that only one thread is indicating packet. */
-			/* pTS->RxIndicateState = RXTS_INDICATE_PROCESSING; */
-
-			/* Indicate packets */
-			/* RT_ASSERT((index<=REORDER_WIN_SIZE), ("RxReorderIndicatePacket(): Rx Reorder buffer full!!\n")); */
-
-
-			/* indicate this recv_frame */
-			/* DbgPrint("recv_indicatepkts_in_order, indicate_seq=%d, seq_num=%d\n", precvpriv->indicate_seq, pattrib->seq_num); */
-			if (recv_process_mpdu(padapter, prframe) != _SUCCESS)
-				precvpriv->dbg_rx_drop_count++;
-
-			/* Update local variables. */
-			bPktInBuf = _FALSE;
-
-		} else {
-			bPktInBuf = _TRUE;
-			break;
-		}
-
-		/* DbgPrint("recv_indicatepkts_in_order():while\n"); */
-
-	}
-
-	/* _rtw_spinunlock_ex(&ppending_recvframe_queue->lock); */
-	/* _exit_critical_ex(&ppending_recvframe_queue->lock, &irql); */
-
-#if 0
-	/* Release the indication lock and set to new indication step. */
-	if (bPktInBuf) {
-		/*  Set new pending timer. */
-		/* pTS->RxIndicateState = RXTS_INDICATE_REORDER; */
-		/* PlatformSetTimer(Adapter, &pTS->RxPktPendingTimer, pHTInfo->RxReorderPendingTime); */
-
-		_set_timer(&preorder_ctrl->reordering_ctrl_timer, REORDER_WAIT_TIME);
-	} else {
-		/* pTS->RxIndicateState = RXTS_INDICATE_IDLE; */
+		recv_indicatepkts_pkt_loss_cnt(padapter, preorder_ctrl->indicate_seq, seq_num);
+		preorder_ctrl->indicate_seq = seq_num;
 	}
-#endif
-	/* _exit_critical_ex(&ppending_recvframe_queue->lock, &irql); */
 
-	/* return _TRUE; */
-	return bPktInBuf;
+	while (preorder_ctrl->reorder_buf[RECV_REORDER_IDX(preorder_ctrl->indicate_seq)])
+		recv_reorder_release_one(padapter, preorder_ctrl);
 
+	return preorder_ctrl->reorder_cnt ? _TRUE : _FALSE;
 }
 
 static int recv_indicatepkt_reorder(_adapter *padapter, union recv_frame *prframe)
@@ -90,6 +90,9 @@ extern u8 rtw_bridge_tunnel_header[];
 extern u8 rtw_rfc1042_header[];
 
 /* for Rx reordering buffer control */
+#define RECV_REORDER_BUF_SZ	64 /* power of 2, not smaller than wsize_b */
+#define RECV_REORDER_IDX(seq)	((seq) & (RECV_REORDER_BUF_SZ - 1))
+
 struct recv_reorder_ctrl {
 	_adapter	*padapter;
 	u8 tid;
@@ -98,7 +101,10 @@ struct recv_reorder_ctrl {
 	u16 wend_b;
 	u8 wsize_b;
 	u8 ampdu_size;
-	_queue pending_recvframe_queue;
+	_queue pending_recvframe_queue;	/* only its lock is used */
+	/* buffered frames, indexed by RECV_REORDER_IDX(seq_num) */
+	union recv_frame *reorder_buf[RECV_REORDER_BUF_SZ];
+	u16 reorder_cnt;
 	_timer reordering_ctrl_timer;
 	u8 bReorderWaiting;
 };
@@ -410,6 +416,11 @@ struct recv_priv {
 	struct sk_buff_head rx_skb_queue;
 #ifdef CONFIG_RTW_NAPI
 		struct sk_buff_head rx_napi_skb_queue;
+	/* frames handed to the stack per NAPI poll */
+	u32 napi_polls;
+	u32 napi_full_polls;
+	u32 napi_frames_max;
+	u64 napi_frames;
 #endif 
 #ifdef CONFIG_RX_INDICATE_QUEUE
 	struct task rx_indicate_tasklet;
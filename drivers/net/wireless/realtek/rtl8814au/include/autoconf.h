@@ -44,6 +44,7 @@
 /*
  * Internal  General Config
  */
+#define CONFIG_RTW_XMITFRAME_CACHE	/* per-CPU cache of free xmit frames */
 /* #define CONFIG_H2CLBK */
 
 #define CONFIG_EMBEDDED_FWIMG	1
@@ -351,6 +351,8 @@ static int napi_recv(_adapter *padapter, int budget)
 		if (!pskb)
 			break;
 
+		/* dropped frames cost the poll as much as delivered ones */
+		work_done++;
 		rx_ok = _FALSE;
 
 #ifdef CONFIG_RTW_GRO
@@ -365,14 +367,19 @@ static int napi_recv(_adapter *padapter, int budget)
 			rx_ok = _TRUE;
 
 next:
-		if (rx_ok == _TRUE) {
-			work_done++;
+		if (rx_ok == _TRUE)
 			DBG_COUNTER(padapter->rx_logs.os_netif_ok);
-		} else {
+		else
 			DBG_COUNTER(padapter->rx_logs.os_netif_err);
-		}
 	}
 
+	precvpriv->napi_polls++;
+	precvpriv->napi_frames += work_done;
+	if (work_done > precvpriv->napi_frames_max)
+		precvpriv->napi_frames_max = work_done;
+	if (work_done >= budget)
+		precvpriv->napi_full_polls++;
+
 	return work_done;
 }
 
@@ -80,6 +80,9 @@ enum addba_rsp_ack_state {
 };
 
 /* for Rx reordering buffer control */
+#define RECV_REORDER_BUF_SZ	64 /* power of 2, not smaller than wsize_b */
+#define RECV_REORDER_IDX(seq)	((seq) & (RECV_REORDER_BUF_SZ - 1))
+
 struct recv_reorder_ctrl {
 	_adapter	*padapter;
 	u8 tid;
@@ -88,7 +91,10 @@ struct recv_reorder_ctrl {
 	u16 wend_b;
 	u8 wsize_b;
 	u8 ampdu_size;
-	_queue pending_recvframe_queue;
+	_queue pending_recvframe_queue;	/* only its lock is used */
+	/* buffered frames, indexed by RECV_REORDER_IDX(seq_num) */
+	union recv_frame *reorder_buf[RECV_REORDER_BUF_SZ];
+	u16 reorder_cnt;
 	_timer reordering_ctrl_timer;
 	u8 bReorderWaiting;
 	unsigned long rec_abba_rsp_ack;
@@ -385,6 +391,11 @@ struct recv_priv {
 	struct sk_buff_head rx_skb_queue;
 #ifdef CONFIG_RTW_NAPI
 		struct sk_buff_head rx_napi_skb_queue;
+	/* frames handed to the stack per NAPI poll */
+	u32 napi_polls;
+	u32 napi_full_polls;
+	u32 napi_frames_max;
+	u64 napi_frames;
 #endif 
 #ifdef CONFIG_RX_INDICATE_QUEUE
 	_tasklet rx_indicate_tasklet;
@@ -735,6 +735,22 @@ enum cmdbuf_type {
 
 u8 rtw_get_hwseq_no(_adapter *padapter);
 
+#ifdef CONFIG_RTW_XMITFRAME_CACHE
+/*
+ * Free xmit frames kept per CPU, so that allocating and freeing a frame
+ * only takes the lock of the local cache. Frames move from and to
+ * free_xmit_queue in batches, free_xmitframe_cnt does not count them.
+ */
+#define XMITFRAME_CACHE_SZ	8
+#define XMITFRAME_CACHE_BATCH	4
+
+struct xmitframe_cache {
+	_lock lock;
+	_list list;
+	u32 cnt;
+};
+#endif
+
 struct	xmit_priv	{
 
 	_lock	lock;
@@ -755,6 +771,9 @@ struct	xmit_priv	{
 	u8 *pxmit_frame_buf;
 	uint free_xmitframe_cnt;
 	_queue	free_xmit_queue;
+#ifdef CONFIG_RTW_XMITFRAME_CACHE
+	struct xmitframe_cache __percpu *xframe_cache;
+#endif
 
 	/* uint mapping_addr; */
 	/* uint pkt_sz; */
@@ -947,6 +966,9 @@ extern struct xmit_frame *rtw_alloc_xmitframe(struct xmit_priv *pxmitpriv);
 struct xmit_frame *rtw_alloc_xmitframe_ext(struct xmit_priv *pxmitpriv);
 struct xmit_frame *rtw_alloc_xmitframe_once(struct xmit_priv *pxmitpriv);
 extern s32 rtw_free_xmitframe(struct xmit_priv *pxmitpriv, struct xmit_frame *pxmitframe);
+#ifdef CONFIG_RTW_XMITFRAME_CACHE
+extern void rtw_flush_xmitframe_cache(struct xmit_priv *pxmitpriv);
+#endif
 extern void rtw_free_xmitframe_queue(struct xmit_priv *pxmitpriv, _queue *pframequeue);
 struct tx_servq *rtw_get_sta_pending(_adapter *padapter, struct sta_info *psta, sint up, u8 *ac);
 extern s32 rtw_xmitframe_enqueue(_adapter *padapter, struct xmit_frame *pxmitframe);
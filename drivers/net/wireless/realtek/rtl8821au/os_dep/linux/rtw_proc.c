@@ -3430,6 +3430,20 @@ static int proc_get_napi_info(struct seq_file *m, void *v)
 	}
 	RTW_PRINT_SEL(m, "GRO %s\n", gro?"enable":"disable");
 
+#ifdef CONFIG_RTW_NAPI
+	if (napi) {
+		struct recv_priv *precvpriv = &adapter->recvpriv;
+
+		RTW_PRINT_SEL(m, "polls=%u, full_budget_polls=%u\n",
+			      precvpriv->napi_polls, precvpriv->napi_full_polls);
+		RTW_PRINT_SEL(m, "frames=%llu, avg_frames_per_poll=%llu, max_frames_per_poll=%u\n",
+			      precvpriv->napi_frames,
+			      precvpriv->napi_polls ?
+			      div_u64(precvpriv->napi_frames, precvpriv->napi_polls) : 0,
+			      precvpriv->napi_frames_max);
+	}
+#endif /* CONFIG_RTW_NAPI */
+
 	return 0;
 
 }
@@ -64,6 +64,177 @@ void rtw_free_xmit_block(_adapter *padapter)
 	_rtw_spinlock_free(&dvobj->xmit_block_lock);
 }
 
+#ifdef CONFIG_RTW_XMITFRAME_CACHE
+static void rtw_init_xmitframe_cache(struct xmit_priv *pxmitpriv)
+{
+	struct xmitframe_cache *cache;
+	int cpu;
+
+	pxmitpriv->xframe_cache = alloc_percpu(struct xmitframe_cache);
+	if (pxmitpriv->xframe_cache == NULL) {
+		/* frames come straight from free_xmit_queue then */
+		RTW_WARN("%s: no per-CPU xmit frame cache\n", __func__);
+		return;
+	}
+
+	for_each_possible_cpu(cpu) {
+		cache = per_cpu_ptr(pxmitpriv->xframe_cache, cpu);
+		_rtw_spinlock_init(&cache->lock);
+		_rtw_init_listhead(&cache->list);
+		cache->cnt = 0;
+	}
+}
+
+/* caller holds cache->lock */
+static void rtw_xmitframe_cache_put(struct xmit_priv *pxmitpriv,
+	struct xmitframe_cache *cache, u32 num)
+{
+	_queue *queue = &pxmitpriv->free_xmit_queue;
+	_list *plist;
+	_irqL irqL;
+
+	_enter_critical_bh(&queue->lock, &irqL);
+
+	while (num-- && cache->cnt) {
+		plist = get_next(&cache->list);
+		rtw_list_delete(plist);
+		rtw_list_insert_tail(plist, get_list_head(queue));
+		cache->cnt--;
+		pxmitpriv->free_xmitframe_cnt++;
+	}
+
+	_exit_critical_bh(&queue->lock, &irqL);
+}
+
+/* caller holds cache->lock */
+static void rtw_xmitframe_cache_refill(struct xmit_priv *pxmitpriv,
+	struct xmitframe_cache *cache)
+{
+	_queue *queue = &pxmitpriv->free_xmit_queue;
+	_list *plist;
+	_irqL irqL;
+
+	_enter_critical_bh(&queue->lock, &irqL);
+
+	while (cache->cnt < XMITFRAME_CACHE_BATCH
+		&& _rtw_queue_empty(queue) == _FALSE) {
+		plist = get_next(get_list_head(queue));
+		rtw_list_delete(plist);
+		rtw_list_insert_tail(plist, &cache->list);
+		cache->cnt++;
+		pxmitpriv->free_xmitframe_cnt--;
+	}
+
+	_exit_critical_bh(&queue->lock, &irqL);
+}
+
+/* caller holds cache->lock */
+static struct xmit_frame *rtw_xmitframe_cache_take(struct xmitframe_cache *cache)
+{
+	_list *plist;
+
+	if (cache->cnt == 0)
+		return NULL;
+
+	plist = get_next(&cache->list);
+	rtw_list_delete(plist);
+	cache->cnt--;
+
+	return LIST_CONTAINOR(plist, struct xmit_frame, list);
+}
+
+static struct xmit_frame *rtw_xmitframe_cache_get(struct xmit_priv *pxmitpriv)
+{
+	struct xmitframe_cache *cache;
+	struct xmit_frame *pxframe;
+	_irqL irqL;
+	int cpu;
+
+	cache = get_cpu_ptr(pxmitpriv->xframe_cache);
+	_enter_critical_bh(&cache->lock, &irqL);
+
+	if (cache->cnt == 0)
+		rtw_xmitframe_cache_refill(pxmitpriv, cache);
+	pxframe = rtw_xmitframe_cache_take(cache);
+
+	_exit_critical_bh(&cache->lock, &irqL);
+	put_cpu_ptr(pxmitpriv->xframe_cache);
+
+	if (pxframe)
+		return pxframe;
+
+	/* free_xmit_queue is empty, look for frames left on the other CPUs */
+	for_each_possible_cpu(cpu) {
+		cache = per_cpu_ptr(pxmitpriv->xframe_cache, cpu);
+
+		_enter_critical_bh(&cache->lock, &irqL);
+		pxframe = rtw_xmitframe_cache_take(cache);
+		_exit_critical_bh(&cache->lock, &irqL);
+
+		if (pxframe)
+			break;
+	}
+
+	return pxframe;
+}
+
+static void rtw_xmitframe_cache_free(struct xmit_priv *pxmitpriv,
+	struct xmit_frame *pxframe)
+{
+	struct xmitframe_cache *cache;
+	_irqL irqL;
+
+	cache = get_cpu_ptr(pxmitpriv->xframe_cache);
+	_enter_critical_bh(&cache->lock, &irqL);
+
+	/* at the head, the next alloc gets the frame that is still hot */
+	rtw_list_delete(&pxframe->list);
+	rtw_list_insert_head(&pxframe->list, &cache->list);
+	cache->cnt++;
+
+	if (cache->cnt > XMITFRAME_CACHE_SZ)
+		rtw_xmitframe_cache_put(pxmitpriv, cache, XMITFRAME_CACHE_BATCH);
+
+	_exit_critical_bh(&cache->lock, &irqL);
+	put_cpu_ptr(pxmitpriv->xframe_cache);
+}
+
+/* Give all cached frames back to free_xmit_queue */
+void rtw_flush_xmitframe_cache(struct xmit_priv *pxmitpriv)
+{
+	struct xmitframe_cache *cache;
+	_irqL irqL;
+	int cpu;
+
+	if (pxmitpriv->xframe_cache == NULL)
+		return;
+
+	for_each_possible_cpu(cpu) {
+		cache = per_cpu_ptr(pxmitpriv->xframe_cache, cpu);
+
+		_enter_critical_bh(&cache->lock, &irqL);
+		rtw_xmitframe_cache_put(pxmitpriv, cache, cache->cnt);
+		_exit_critical_bh(&cache->lock, &irqL);
+	}
+}
+
+static void rtw_free_xmitframe_cache(struct xmit_priv *pxmitpriv)
+{
+	int cpu;
+
+	if (pxmitpriv->xframe_cache == NULL)
+		return;
+
+	rtw_flush_xmitframe_cache(pxmitpriv);
+
+	for_each_possible_cpu(cpu)
+		_rtw_spinlock_free(&per_cpu_ptr(pxmitpriv->xframe_cache, cpu)->lock);
+
+	free_percpu(pxmitpriv->xframe_cache);
+	pxmitpriv->xframe_cache = NULL;
+}
+#endif /* CONFIG_RTW_XMITFRAME_CACHE */
+
 s32	_rtw_init_xmit_priv(struct xmit_priv *pxmitpriv, _adapter *padapter)
 {
 	int i;
@@ -136,6 +307,10 @@ s32	_rtw_init_xmit_priv(struct xmit_priv *pxmitpriv, _adapter *padapter)
 
 	pxmitpriv->free_xmitframe_cnt = NR_XMITFRAME;
 
+#ifdef CONFIG_RTW_XMITFRAME_CACHE
+	rtw_init_xmitframe_cache(pxmitpriv);
+#endif
+
 	pxmitpriv->frag_len = MAX_FRAG_THRESHOLD;
 
 
@@ -383,6 +558,10 @@ void _rtw_free_xmit_priv(struct xmit_priv *pxmitpriv)
 
 	rtw_hal_free_xmit_priv(padapter);
 
+#ifdef CONFIG_RTW_XMITFRAME_CACHE
+	rtw_free_xmitframe_cache(pxmitpriv);
+#endif
+
 	rtw_mfree_xmit_priv_lock(pxmitpriv);
 
 	if (pxmitpriv->pxmit_frame_buf == NULL)
@@ -3569,6 +3748,13 @@ struct xmit_frame *rtw_alloc_xmitframe(struct xmit_priv *pxmitpriv)/* (_queue *p
 	_list *plist, *phead;
 	_queue *pfree_xmit_queue = &pxmitpriv->free_xmit_queue;
 
+#ifdef CONFIG_RTW_XMITFRAME_CACHE
+	if (pxmitpriv->xframe_cache) {
+		pxframe = rtw_xmitframe_cache_get(pxmitpriv);
+		rtw_init_xmitframe(pxframe);
+		return pxframe;
+	}
+#endif
 
 	_enter_critical_bh(&pfree_xmit_queue->lock, &irqL);
 
@@ -3674,6 +3860,13 @@ s32 rtw_free_xmitframe(struct xmit_priv *pxmitpriv, struct xmit_frame *pxmitfram
 		goto check_pkt_complete;
 	}
 
+#ifdef CONFIG_RTW_XMITFRAME_CACHE
+	if (pxmitframe->ext_tag == 0 && pxmitpriv->xframe_cache) {
+		rtw_xmitframe_cache_free(pxmitpriv, pxmitframe);
+		goto check_pkt_complete;
+	}
+#endif
+
 	if (pxmitframe->ext_tag == 0)
 		queue = &pxmitpriv->free_xmit_queue;
 	else if (pxmitframe->ext_tag == 1)
@@ -17,6 +17,64 @@
 #include <drv_types.h>
 #include <hal_data.h>
 
+/*
+ * Number of bulk-in URBs kept in flight. A faster bus drains the RX FIFO
+ * quicker than the URB completions are turned around, so it needs a
+ * deeper queue to keep the pipe busy.
+ */
+u8 rtw_usb_nr_recvbuff(_adapter *padapter)
+{
+	struct registry_priv *regsty = &padapter->registrypriv;
+	u8 nr;
+
+#ifdef CONFIG_SINGLE_RECV_BUF
+	nr = NR_RECVBUFF;
+#else
+	if (regsty->usb_rx_urbs)
+		nr = rtw_min(regsty->usb_rx_urbs, NR_RECVBUFF_USB_MAX);
+	else if (IS_SUPER_SPEED_USB(padapter))
+		nr = NR_RECVBUFF_USB3;
+	else if (IS_HIGH_SPEED_USB(padapter))
+		nr = NR_RECVBUFF_USB2;
+	else
+		nr = NR_RECVBUFF_USB1;
+#endif
+
+	return nr;
+}
+
+#ifdef CONFIG_USB_RX_AGGREGATION
+/*
+ * Apply the registry RX aggregation threshold over the chip default.
+ * The size is in 4KB units and leaves room in the rx buffer for the
+ * frame that crosses the threshold.
+ */
+void rtw_usb_rxagg_set_thresh(_adapter *padapter)
+{
+	struct registry_priv *regsty = &GET_PRIMARY_ADAPTER(padapter)->registrypriv;
+	HAL_DATA_TYPE *pHalData = GET_HAL_DATA(padapter);
+	u8 size_max = (MAX_RECVBUF_SZ >> 12) > 3 ? (MAX_RECVBUF_SZ >> 12) - 3 : 1;
+
+	if (regsty->usb_rxagg_size)
+		pHalData->rxagg_usb_size = rtw_min(regsty->usb_rxagg_size, size_max);
+	if (regsty->usb_rxagg_timeout)
+		pHalData->rxagg_usb_timeout = regsty->usb_rxagg_timeout;
+}
+#endif /* CONFIG_USB_RX_AGGREGATION */
+
+#ifdef CONFIG_USB_TX_AGGREGATION
+/* Frames per bulk-out URB, the registry can only lower the halmac value */
+void rtw_usb_txagg_set_desc_num(_adapter *padapter)
+{
+	struct registry_priv *regsty = &GET_PRIMARY_ADAPTER(padapter)->registrypriv;
+	HAL_DATA_TYPE *pHalData = GET_HAL_DATA(padapter);
+
+	pHalData->UsbTxAggDescNum = pHalData->UsbTxAggDescNumMax;
+	if (regsty->usb_txagg_num && regsty->usb_txagg_num < pHalData->UsbTxAggDescNumMax)
+		pHalData->UsbTxAggDescNum = regsty->usb_txagg_num;
+}
+#endif /* CONFIG_USB_TX_AGGREGATION */
+
 int	usb_init_recv_priv(_adapter *padapter, u16 ini_in_buf_sz)
 {
 	struct recv_priv	*precvpriv = &padapter->recvpriv;
@@ -60,9 +118,10 @@ int	usb_init_recv_priv(_adapter *padapter, u16 ini_in_buf_sz)
 	skb_queue_head_init(&precvpriv->free_recv_skb_queue);
 #endif
 
-	RTW_INFO("NR_RECVBUFF: %d\n", NR_RECVBUFF);
+	precvpriv->nr_recvbuff = rtw_usb_nr_recvbuff(padapter);
+	RTW_INFO("NR_RECVBUFF: %d\n", precvpriv->nr_recvbuff);
 	RTW_INFO("MAX_RECVBUF_SZ: %d\n", MAX_RECVBUF_SZ);
-	precvpriv->pallocated_recv_buf = rtw_zmalloc(NR_RECVBUFF * sizeof(struct recv_buf) + 4);
+	precvpriv->pallocated_recv_buf = rtw_zmalloc(precvpriv->nr_recvbuff * sizeof(struct recv_buf) + 4);
 	if (precvpriv->pallocated_recv_buf == NULL) {
 		res = _FAIL;
 		goto exit;
@@ -72,7 +131,7 @@ int	usb_init_recv_priv(_adapter *padapter, u16 ini_in_buf_sz)
 
 	precvbuf = (struct recv_buf *)precvpriv->precv_buf;
 
-	for (i = 0; i < NR_RECVBUFF ; i++) {
+	for (i = 0; i < precvpriv->nr_recvbuff ; i++) {
 		_rtw_init_listhead(&precvbuf->list);
 
 		_rtw_spinlock_init(&precvbuf->recvbuf_lock);
@@ -91,7 +150,7 @@ int	usb_init_recv_priv(_adapter *padapter, u16 ini_in_buf_sz)
 		precvbuf++;
 	}
 
-	precvpriv->free_recv_buf_queue_cnt = NR_RECVBUFF;
+	precvpriv->free_recv_buf_queue_cnt = precvpriv->nr_recvbuff;
 
 #if defined(PLATFORM_LINUX) || defined(PLATFORM_FREEBSD)
 
@@ -154,13 +213,13 @@ void usb_free_recv_priv(_adapter *padapter, u16 ini_in_buf_sz)
 
 	precvbuf = (struct recv_buf *)precvpriv->precv_buf;
 
-	for (i = 0; i < NR_RECVBUFF ; i++) {
+	for (i = 0; i < precvpriv->nr_recvbuff ; i++) {
 		rtw_os_recvbuf_resource_free(padapter, precvbuf);
 		precvbuf++;
 	}
 
 	if (precvpriv->pallocated_recv_buf)
-		rtw_mfree(precvpriv->pallocated_recv_buf, NR_RECVBUFF * sizeof(struct recv_buf) + 4);
+		rtw_mfree(precvpriv->pallocated_recv_buf, precvpriv->nr_recvbuff * sizeof(struct recv_buf) + 4);
 
 #ifdef CONFIG_USB_INTERRUPT_IN_PIPE
 #ifdef PLATFORM_LINUX
@@ -125,7 +125,7 @@ u32 rtl8821cu_inirp_init(PADAPTER padapter)
 
 	/* issue Rx irp to receive data */
 	precvbuf = (struct recv_buf *)precvpriv->precv_buf;
-	for (i = 0; i < NR_RECVBUFF; i++) {
+	for (i = 0; i < precvpriv->nr_recvbuff; i++) {
 		if (_read_port(pintfhdl, precvpriv->ff_hwaddr, 0, (u8 *)precvbuf) == _FALSE) {
 			status = _FAIL;
 			goto exit;
@@ -258,7 +258,8 @@ void rtl8821cu_interface_configure(PADAPTER padapter)
 #ifdef CONFIG_USB_TX_AGGREGATION
 	/* according to value defined by halmac */
 	pHalData->UsbTxAggMode		= 1;
-	rtw_halmac_usb_get_txagg_desc_num(pdvobjpriv, &pHalData->UsbTxAggDescNum);
+	rtw_halmac_usb_get_txagg_desc_num(pdvobjpriv, &pHalData->UsbTxAggDescNumMax);
+	rtw_usb_txagg_set_desc_num(padapter);
 #endif /* CONFIG_USB_TX_AGGREGATION */
 
 #ifdef CONFIG_USB_RX_AGGREGATION
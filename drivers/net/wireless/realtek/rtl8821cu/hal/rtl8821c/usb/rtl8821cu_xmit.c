@@ -809,6 +809,10 @@ agg_end:
 	pbuf_tail -= (pfirstframe->agg_num * TXDESC_SIZE);
 	pbuf_tail -= (pfirstframe->pkt_offset * PACKET_OFFSET_SZ);
 
+	pxmitpriv->tx_urbs++;
+	pxmitpriv->tx_urb_frames += pfirstframe->agg_num;
+	if (pfirstframe->agg_num > pxmitpriv->tx_urb_frames_max)
+		pxmitpriv->tx_urb_frames_max = pfirstframe->agg_num;
 
 	rtw_count_tx_stats(padapter, pfirstframe, pbuf_tail);
 
@@ -66,6 +66,7 @@
 /*
  * Internal  General Config
  */
+#define CONFIG_RTW_XMITFRAME_CACHE	/* per-CPU cache of free xmit frames */
 /* #define CONFIG_H2CLBK */
 
 #define RTW_HALMAC		/* Use HALMAC architecture, necessary for 8821C */
@@ -210,6 +210,12 @@ struct registry_priv {
 #endif /* CONFIG_WMMPS_STA */
 	u8   usb_rxagg_mode;
 	u8	dynamic_agg_enable;
+#ifdef CONFIG_USB_HCI
+	u8	usb_rx_urbs;
+	u8	usb_rxagg_size;
+	u8	usb_rxagg_timeout;
+	u8	usb_txagg_num;
+#endif /* CONFIG_USB_HCI */
 	u8	long_retry_lmt;
 	u8	short_retry_lmt;
 	u16	busy_thresh;
@@ -708,6 +708,7 @@ typedef struct hal_com_data {
 #ifdef CONFIG_USB_TX_AGGREGATION
 	u8			UsbTxAggMode;
 	u8			UsbTxAggDescNum;
+	u8			UsbTxAggDescNumMax;	/* by halmac */
 #endif /* CONFIG_USB_TX_AGGREGATION */
 
 #ifdef CONFIG_USB_RX_AGGREGATION
@@ -30,6 +30,13 @@
 		#define NR_RECVBUFF (8)
 	#endif
 #endif /* CONFIG_SINGLE_RECV_BUF */
+#ifdef CONFIG_USB_HCI
+	/* bulk-in URBs kept in flight by USB speed, see rtw_usb_nr_recvbuff() */
+	#define NR_RECVBUFF_USB3 (16)
+	#define NR_RECVBUFF_USB2 NR_RECVBUFF
+	#define NR_RECVBUFF_USB1 (4)
+	#define NR_RECVBUFF_USB_MAX (32)
+#endif /* CONFIG_USB_HCI */
 #ifdef CONFIG_PREALLOC_RX_SKB_BUFFER
 	#define NR_PREALLOC_RECV_SKB (rtw_rtkm_get_nr_recv_skb()>>1)
 #else /*!CONFIG_PREALLOC_RX_SKB_BUFFER */
@@ -80,6 +87,9 @@ enum addba_rsp_ack_state {
 };
 
 /* for Rx reordering buffer control */
+#define RECV_REORDER_BUF_SZ	64 /* power of 2, not smaller than wsize_b */
+#define RECV_REORDER_IDX(seq)	((seq) & (RECV_REORDER_BUF_SZ - 1))
+
 struct recv_reorder_ctrl {
 	_adapter	*padapter;
 	u8 tid;
@@ -88,7 +98,10 @@ struct recv_reorder_ctrl {
 	u16 wend_b;
 	u8 wsize_b;
 	u8 ampdu_size;
-	_queue pending_recvframe_queue;
+	_queue pending_recvframe_queue;	/* only its lock is used */
+	/* buffered frames, indexed by RECV_REORDER_IDX(seq_num) */
+	union recv_frame *reorder_buf[RECV_REORDER_BUF_SZ];
+	u16 reorder_cnt;
 	_timer reordering_ctrl_timer;
 	u8 bReorderWaiting;
 	unsigned long rec_abba_rsp_ack;
@@ -385,6 +398,11 @@ struct recv_priv {
 	struct sk_buff_head rx_skb_queue;
 #ifdef CONFIG_RTW_NAPI
 		struct sk_buff_head rx_napi_skb_queue;
+	/* frames handed to the stack per NAPI poll */
+	u32 napi_polls;
+	u32 napi_full_polls;
+	u32 napi_frames_max;
+	u64 napi_frames;
 #endif 
 #ifdef CONFIG_RX_INDICATE_QUEUE
 	_tasklet rx_indicate_tasklet;
@@ -398,6 +416,15 @@ struct recv_priv {
 	_queue	free_recv_buf_queue;
 	u32	free_recv_buf_queue_cnt;
 
+#ifdef CONFIG_USB_HCI
+	u8 nr_recvbuff;
+	/* bulk-in aggregation statistic */
+	u32 rx_urbs;
+	u32 rx_urb_frames_max;
+	u64 rx_urb_bytes;
+	u64 rx_urb_frames;
+#endif
+
 #if defined(CONFIG_SDIO_HCI) || defined(CONFIG_GSPI_HCI) || defined(CONFIG_USB_HCI)
 	_queue	recv_buf_pending_queue;
 #endif
@@ -17,6 +17,13 @@
 
 int usb_init_recv_priv(_adapter *padapter, u16 ini_in_buf_sz);
 void usb_free_recv_priv(_adapter *padapter, u16 ini_in_buf_sz);
+u8 rtw_usb_nr_recvbuff(_adapter *padapter);
+#ifdef CONFIG_USB_RX_AGGREGATION
+void rtw_usb_rxagg_set_thresh(_adapter *padapter);
+#endif
+#ifdef CONFIG_USB_TX_AGGREGATION
+void rtw_usb_txagg_set_desc_num(_adapter *padapter);
+#endif
 #ifdef CONFIG_FW_C2H_REG
 void usb_c2h_hisr_hdl(_adapter *adapter, u8 *buf);
 #endif
@@ -587,6 +587,8 @@ struct	sta_info *rtw_alloc_stainfo(struct	sta_priv *pstapriv, const u8 *hwaddr)
 			preorder_ctrl->ampdu_size = RX_AMPDU_SIZE_INVALID;
 
 			_rtw_init_queue(&preorder_ctrl->pending_recvframe_queue);
+			_rtw_memset(preorder_ctrl->reorder_buf, 0, sizeof(preorder_ctrl->reorder_buf));
+			preorder_ctrl->reorder_cnt = 0;
 
 			rtw_init_recv_timer(preorder_ctrl);
 			rtw_clear_bit(RTW_RECV_ACK_OR_TIMEOUT, &preorder_ctrl->rec_abba_rsp_ack);
@@ -743,9 +745,9 @@ u32	rtw_free_stainfo(_adapter *padapter , struct sta_info *psta)
 	/* for A-MPDU Rx reordering buffer control, cancel reordering_ctrl_timer */
 	for (i = 0; i < 16 ; i++) {
 		_irqL irqL;
-		_list	*phead, *plist;
 		union recv_frame *prframe;
 		_queue *ppending_recvframe_queue;
+		int j;
 		_queue *pfree_recv_queue = &padapter->recvpriv.free_recv_queue;
 
 		preorder_ctrl = &psta->recvreorder_ctrl[i];
@@ -758,18 +760,15 @@ u32	rtw_free_stainfo(_adapter *padapter , struct sta_info *psta)
 
 		_enter_critical_bh(&ppending_recvframe_queue->lock, &irqL);
 
-		phead =	get_list_head(ppending_recvframe_queue);
-		plist = get_next(phead);
-
-		while (!rtw_is_list_empty(phead)) {
-			prframe = LIST_CONTAINOR(plist, union recv_frame, u);
-
-			plist = get_next(plist);
-
-			rtw_list_delete(&(prframe->u.hdr.list));
+		for (j = 0; j < RECV_REORDER_BUF_SZ; j++) {
+			prframe = preorder_ctrl->reorder_buf[j];
+			if (!prframe)
+				continue;
 
+			preorder_ctrl->reorder_buf[j] = NULL;
 			rtw_free_recvframe(prframe, pfree_recv_queue);
 		}
+		preorder_ctrl->reorder_cnt = 0;
 
 		_exit_critical_bh(&ppending_recvframe_queue->lock, &irqL);
 
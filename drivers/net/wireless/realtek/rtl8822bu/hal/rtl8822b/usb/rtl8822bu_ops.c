@@ -59,10 +59,11 @@ static u8 sethwreg(PADAPTER padapter, u8 variable, u8 *val)
 			pHalData->rxagg_usb_timeout = 8;
 			pHalData->rxagg_usb_size = 3;
 #else
-			/* default setting */
-			pHalData->rxagg_usb_timeout = 0x20;
+			/* default setting, SuperSpeed fills the threshold sooner */
+			pHalData->rxagg_usb_timeout = IS_SUPER_SPEED_USB(padapter) ? 0x10 : 0x20;
 			pHalData->rxagg_usb_size = 0x05;
 #endif
+			rtw_usb_rxagg_set_thresh(padapter);
 		}
 		rtw_halmac_rx_agg_switch(pdvobjpriv, _TRUE);
 #if 0
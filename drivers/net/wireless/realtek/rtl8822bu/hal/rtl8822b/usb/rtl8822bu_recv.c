@@ -74,6 +74,7 @@ int recvbuf2recvframe(PADAPTER padapter, void *ptr)
 	u8 *pbuf;
 	u8 pkt_cnt = 0;
 	u32 pkt_offset;
+	u32 nr_frames = 0;
 	s32 transfer_len;
 	u8 *pphy_status = NULL;
 	union recv_frame *precvframe = NULL;
@@ -93,6 +94,8 @@ int recvbuf2recvframe(PADAPTER padapter, void *ptr)
 	pbuf = pskb->data;
 #endif /* CONFIG_USE_USB_BUFFER_ALLOC_RX */
 
+	precvpriv->rx_urbs++;
+	precvpriv->rx_urb_bytes += transfer_len;
 
 #ifdef CONFIG_USB_RX_AGGREGATION
 	pkt_cnt = GET_RX_DESC_DMA_AGG_NUM_8822B(pbuf);
@@ -161,10 +164,14 @@ int recvbuf2recvframe(PADAPTER padapter, void *ptr)
 #endif
 		transfer_len -= pkt_offset;
 		precvframe = NULL;
+		nr_frames++;
 
 	} while (transfer_len > 0);
 
 _exit_recvbuf2recvframe:
+	precvpriv->rx_urb_frames += nr_frames;
+	if (nr_frames > precvpriv->rx_urb_frames_max)
+		precvpriv->rx_urb_frames_max = nr_frames;
 
 	return _SUCCESS;
 }
@@ -148,6 +148,24 @@ module_param(rtw_usb_rxagg_mode, int, 0644);
 int rtw_dynamic_agg_enable = 1;
 module_param(rtw_dynamic_agg_enable, int, 0644);
 
+#ifdef CONFIG_USB_HCI
+int rtw_usb_rx_urbs = 0;
+module_param(rtw_usb_rx_urbs, int, 0644);
+MODULE_PARM_DESC(rtw_usb_rx_urbs, "Bulk-in URBs kept in flight, 0: by USB speed");
+
+int rtw_usb_rxagg_size = 0;
+module_param(rtw_usb_rxagg_size, int, 0644);
+MODULE_PARM_DESC(rtw_usb_rxagg_size, "USB RX aggregation size in 4KB units, 0: chip default");
+
+int rtw_usb_rxagg_timeout = 0;
+module_param(rtw_usb_rxagg_timeout, int, 0644);
+MODULE_PARM_DESC(rtw_usb_rxagg_timeout, "USB RX aggregation timeout, 0: chip default");
+
+int rtw_usb_txagg_num = 0;
+module_param(rtw_usb_txagg_num, int, 0644);
+MODULE_PARM_DESC(rtw_usb_txagg_num, "Frames per bulk-out URB, 0: halmac default");
+#endif /* CONFIG_USB_HCI */
+
 /* set log level when inserting driver module, default log level is _DRV_INFO_ = 4,
 * please refer to "How_to_set_driver_debug_log_level.doc" to set the available level.
 */
@@ -1145,6 +1163,12 @@ uint loadparam(_adapter *padapter)
 	registry_par->acm_method = (u8)rtw_acm_method;
 	registry_par->usb_rxagg_mode = (u8)rtw_usb_rxagg_mode;
 	registry_par->dynamic_agg_enable = (u8)rtw_dynamic_agg_enable;
+#ifdef CONFIG_USB_HCI
+	registry_par->usb_rx_urbs = (u8)rtw_usb_rx_urbs;
+	registry_par->usb_rxagg_size = (u8)rtw_usb_rxagg_size;
+	registry_par->usb_rxagg_timeout = (u8)rtw_usb_rxagg_timeout;
+	registry_par->usb_txagg_num = (u8)rtw_usb_txagg_num;
+#endif /* CONFIG_USB_HCI */
 
 	/* WMM */
 	registry_par->wmm_enable = (u8)rtw_wmm_enable;
@@ -3575,10 +3575,119 @@ static int proc_get_napi_info(struct seq_file *m, void *v)
 	}
 	RTW_PRINT_SEL(m, "GRO %s\n", gro?"enable":"disable");
 
+#ifdef CONFIG_RTW_NAPI
+	if (napi) {
+		struct recv_priv *precvpriv = &adapter->recvpriv;
+
+		RTW_PRINT_SEL(m, "polls=%u, full_budget_polls=%u\n",
+			      precvpriv->napi_polls, precvpriv->napi_full_polls);
+		RTW_PRINT_SEL(m, "frames=%llu, avg_frames_per_poll=%llu, max_frames_per_poll=%u\n",
+			      precvpriv->napi_frames,
+			      precvpriv->napi_polls ?
+			      div_u64(precvpriv->napi_frames, precvpriv->napi_polls) : 0,
+			      precvpriv->napi_frames_max);
+	}
+#endif /* CONFIG_RTW_NAPI */
+
 	return 0;
 
 }
 
+#ifdef CONFIG_USB_HCI
+static int proc_get_usb_agg(struct seq_file *m, void *v)
+{
+	struct net_device *dev = m->private;
+	_adapter *adapter = (_adapter *)rtw_netdev_priv(dev);
+	struct registry_priv *regsty = &adapter->registrypriv;
+	struct recv_priv *precvpriv = &adapter->recvpriv;
+	struct xmit_priv *pxmitpriv = &adapter->xmitpriv;
+	HAL_DATA_TYPE *pHalData = GET_HAL_DATA(adapter);
+
+	RTW_PRINT_SEL(m, "usb_speed=%u, rx_urbs=%u\n",
+		      adapter_to_dvobj(adapter)->usb_speed, precvpriv->nr_recvbuff);
+#ifdef CONFIG_USB_RX_AGGREGATION
+	RTW_PRINT_SEL(m, "rxagg_size=%u, rxagg_timeout=0x%02x (registry %u, 0x%02x)\n",
+		      pHalData->rxagg_usb_size, pHalData->rxagg_usb_timeout,
+		      regsty->usb_rxagg_size, regsty->usb_rxagg_timeout);
+#endif
+#ifdef CONFIG_USB_TX_AGGREGATION
+	RTW_PRINT_SEL(m, "txagg_num=%u, max=%u (registry %u)\n",
+		      pHalData->UsbTxAggDescNum, pHalData->UsbTxAggDescNumMax,
+		      regsty->usb_txagg_num);
+#endif
+
+	RTW_PRINT_SEL(m, "rx: urbs=%u, bytes=%llu, frames=%llu\n",
+		      precvpriv->rx_urbs, precvpriv->rx_urb_bytes, precvpriv->rx_urb_frames);
+	RTW_PRINT_SEL(m, "rx: avg_bytes_per_urb=%llu, avg_frames_per_urb=%llu, max_frames_per_urb=%u\n",
+		      precvpriv->rx_urbs ? div_u64(precvpriv->rx_urb_bytes, precvpriv->rx_urbs) : 0,
+		      precvpriv->rx_urbs ? div_u64(precvpriv->rx_urb_frames, precvpriv->rx_urbs) : 0,
+		      precvpriv->rx_urb_frames_max);
+	RTW_PRINT_SEL(m, "tx: urbs=%u, frames=%llu, avg_frames_per_urb=%llu, max_frames_per_urb=%u\n",
+		      pxmitpriv->tx_urbs, pxmitpriv->tx_urb_frames,
+		      pxmitpriv->tx_urbs ? div_u64(pxmitpriv->tx_urb_frames, pxmitpriv->tx_urbs) : 0,
+		      pxmitpriv->tx_urb_frames_max);
+
+	return 0;
+}
+
+static ssize_t proc_set_usb_agg(struct file *file, const char __user *buffer, size_t count, loff_t *pos, void *data)
+{
+	struct net_device *dev = data;
+	_adapter *adapter = (_adapter *)rtw_netdev_priv(dev);
+	struct dvobj_priv *dvobj = adapter_to_dvobj(adapter);
+	PADAPTER iface = NULL;
+	char tmp[32] = {0};
+	u32 rxagg_size = 0, rxagg_timeout = 0, txagg_num = 0;
+	int num, i;
+
+	if (count < 1)
+		return -EFAULT;
+
+	if (count > sizeof(tmp)) {
+		rtw_warn_on(1);
+		return -EFAULT;
+	}
+
+	if (!buffer || copy_from_user(tmp, buffer, count))
+		return -EFAULT;
+
+	/* <rxagg_size> <rxagg_timeout> <txagg_num>, 0 for the default */
+	num = sscanf(tmp, "%u %u %u", &rxagg_size, &rxagg_timeout, &txagg_num);
+	if (num < 1)
+		return count;
+
+	for (i = 0; i < dvobj->iface_nums; i++) {
+		iface = dvobj->padapters[i];
+		if (!iface)
+			continue;
+
+		iface->registrypriv.usb_rxagg_size = (u8)rxagg_size;
+		if (num >= 2)
+			iface->registrypriv.usb_rxagg_timeout = (u8)rxagg_timeout;
+		if (num >= 3)
+			iface->registrypriv.usb_txagg_num = (u8)txagg_num;
+	}
+
+	/* reset the statistic for the new setting */
+	adapter->recvpriv.rx_urbs = 0;
+	adapter->recvpriv.rx_urb_frames_max = 0;
+	adapter->recvpriv.rx_urb_bytes = 0;
+	adapter->recvpriv.rx_urb_frames = 0;
+	adapter->xmitpriv.tx_urbs = 0;
+	adapter->xmitpriv.tx_urb_frames_max = 0;
+	adapter->xmitpriv.tx_urb_frames = 0;
+
+#ifdef CONFIG_USB_TX_AGGREGATION
+	rtw_usb_txagg_set_desc_num(adapter);
+#endif
+#ifdef CONFIG_USB_RX_AGGREGATION
+	rtw_hal_set_hwreg(adapter, HW_VAR_RXDMA_AGG_PG_TH, NULL);
+#endif
+
+	return count;
+}
+#endif /* CONFIG_USB_HCI */
+
 #ifdef CONFIG_RTW_NAPI_DYNAMIC
 static ssize_t proc_set_napi_th(struct file *file, const char __user *buffer, size_t count, loff_t *pos, void *data)
 {
@@ -4666,6 +4775,9 @@ const struct rtw_proc_hdl adapter_proc_hdls[] = {
 #ifdef CONFIG_RTW_NAPI_DYNAMIC
 	RTW_PROC_HDL_SSEQ("napi_th", proc_get_napi_info, proc_set_napi_th),
 #endif /* CONFIG_RTW_NAPI_DYNAMIC */
+#ifdef CONFIG_USB_HCI
+	RTW_PROC_HDL_SSEQ("usb_agg", proc_get_usb_agg, proc_set_usb_agg),
+#endif
 
 	RTW_PROC_HDL_SSEQ("rsvd_page", proc_dump_rsvd_page, proc_set_rsvd_page_info),
 
@@ -414,7 +414,7 @@ void usb_read_port_cancel(struct intf_hdl *pintfhdl)
 
 	RTW_INFO("%s\n", __func__);
 
-	for (i = 0; i < NR_RECVBUFF ; i++) {
+	for (i = 0; i < padapter->recvpriv.nr_recvbuff ; i++) {
 
 		if (precvbuf->purb)	 {
 			/* RTW_INFO("usb_read_port_cancel : usb_kill_urb\n"); */
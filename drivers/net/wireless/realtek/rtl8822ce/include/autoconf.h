@@ -62,6 +62,7 @@
 /*
  * Internal  General Config
  */
+#define CONFIG_RTW_XMITFRAME_CACHE	/* per-CPU cache of free xmit frames */
 /*#define CONFIG_PWRCTRL*/
 /*#define CONFIG_H2CLBK*/
 #define CONFIG_TRX_BD_ARCH	/* PCI only */
@@ -849,6 +849,9 @@ int rtw_mp_ctx(struct net_device *dev,
 		sprintf(extra, "Stop continuous Tx");
 		odm_write_dig(&pHalData->odmpriv, 0x20);
 		do {
+#ifdef CONFIG_RTW_XMITFRAME_CACHE
+			rtw_flush_xmitframe_cache(pxmitpriv);
+#endif
 			if (pxmitpriv->free_xmitframe_cnt == NR_XMITFRAME && pxmitpriv->free_xmitbuf_cnt == NR_XMITBUFF)
 				break;
 			else {
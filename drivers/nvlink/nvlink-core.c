@@ -23,6 +23,7 @@
 #include <linux/debugfs.h>
 #include <linux/delay.h>
 #include <linux/module.h>
+#include <linux/workqueue.h>
 #include <linux/platform/tegra/tegra-nvlink.h>
 
 #include <asm/cacheflush.h>
@@ -445,66 +446,58 @@ static int nvlink_poll_link_state(struct nvlink_device *ndev, u32 link_state,
 	return 0;
 }
 
-static int nvlink_poll_tx_sublink_state(struct nvlink_device *ndev,
-				u32 tx_sublink_state, u32 timeout_ms)
+/*
+ * Wait for the tx sublinks of both ends to reach tx_sublink_state and the rx
+ * sublinks of both ends to reach rx_sublink_state. The four sublinks change
+ * together in HW, so they are checked on each pass instead of one after the
+ * other, and a sublink already in place costs no sleep.
+ */
+static int nvlink_poll_sublink_state(struct nvlink_device *ndev0,
+				struct nvlink_device *ndev1,
+				u32 tx_sublink_state,
+				u32 rx_sublink_state,
+				u32 timeout_ms)
 {
-	u32 sublink_mode;
+	struct nvlink_device *ndevs[] = { ndev0, ndev1 };
 	u32 timeout_us = timeout_ms * 1000;
-
-	sublink_mode = ndev->link.link_ops.get_sublink_mode(ndev, false);
-	while (sublink_mode != tx_sublink_state) {
-		usleep_range(DEFAULT_LOOP_SLEEP_US, DEFAULT_LOOP_SLEEP_US * 2);
-		timeout_us = timeout_us - DEFAULT_LOOP_SLEEP_US;
-		if (timeout_us <= 0) {
-			nvlink_err("Timeout while polling on Tx sublink");
-			return -ETIMEDOUT;
+	u32 elapsed_us = 0;
+	bool tx_done[2] = { false, false };
+	bool rx_done[2] = { false, false };
+	int i;
+
+	while (true) {
+		for (i = 0; i < ARRAY_SIZE(ndevs); i++) {
+			struct nvlink_device *ndev = ndevs[i];
+			struct link_operations *ops = &ndev->link.link_ops;
+
+			if (!tx_done[i])
+				tx_done[i] = ops->get_sublink_mode(ndev, false)
+						== tx_sublink_state;
+			if (!rx_done[i])
+				rx_done[i] = ops->get_sublink_mode(ndev, true)
+						== rx_sublink_state;
 		}
-		sublink_mode = ndev->link.link_ops.get_sublink_mode(ndev,
-									false);
-	}
 
-	return 0;
-}
+		if (tx_done[0] && tx_done[1] && rx_done[0] && rx_done[1])
+			return 0;
 
-static int nvlink_poll_rx_sublink_state(struct nvlink_device *ndev,
-				u32 rx_sublink_state, u32 timeout_ms)
-{
-	u32 sublink_mode;
-	u32 timeout_us = timeout_ms * 1000;
+		if (elapsed_us >= timeout_us)
+			break;
 
-	sublink_mode = ndev->link.link_ops.get_sublink_mode(ndev, true);
-	while (sublink_mode != rx_sublink_state) {
 		usleep_range(DEFAULT_LOOP_SLEEP_US, DEFAULT_LOOP_SLEEP_US * 2);
-		timeout_us = timeout_us - DEFAULT_LOOP_SLEEP_US;
-		if (timeout_us <= 0) {
-			nvlink_err("Timeout while polling on Rx sublink");
-			return -ETIMEDOUT;
-		}
-		sublink_mode = ndev->link.link_ops.get_sublink_mode(ndev, true);
+		elapsed_us += DEFAULT_LOOP_SLEEP_US;
 	}
 
-	return 0;
-}
-
-static int nvlink_poll_sublink_state(struct nvlink_device *ndev0,
-				u32 tx_sublink_state,
-				struct nvlink_device *ndev1,
-				u32 rx_sublink_state,
-				u32 timeout_ms)
-{
-	int status;
-
-	status = nvlink_poll_tx_sublink_state(ndev0, tx_sublink_state,
-						timeout_ms);
-	if (status) {
-		/* polling on tx sublink failed. skip any rx polling */
-		return status;
+	for (i = 0; i < ARRAY_SIZE(ndevs); i++) {
+		if (!tx_done[i])
+			nvlink_err("Timeout while polling on Tx sublink of dev%u",
+				ndevs[i]->device_id);
+		if (!rx_done[i])
+			nvlink_err("Timeout while polling on Rx sublink of dev%u",
+				ndevs[i]->device_id);
 	}
 
-	status = nvlink_poll_rx_sublink_state(ndev1, rx_sublink_state,
-						timeout_ms);
-
-	return status;
+	return -ETIMEDOUT;
 }
 
 
@@ -819,16 +812,8 @@ int nvlink_transition_intranode_conn_hs_to_safe(struct nvlink_device *ndev)
 	}
 
 	/* wait for sublinks to go in SAFE Mode */
-	ret = nvlink_poll_sublink_state(ndev0, NVLINK_TX_SAFE,
-					ndev1, NVLINK_RX_SAFE,
-					NVLINK_TRANSITION_SAFE_TIMEOUT_MS);
-	if (ret < 0) {
-		nvlink_err("Unable to set sublinks in safe mode");
-		return ret;
-	}
-
-	ret = nvlink_poll_sublink_state(ndev1, NVLINK_TX_SAFE,
-					ndev0, NVLINK_RX_SAFE,
+	ret = nvlink_poll_sublink_state(ndev0, ndev1,
+					NVLINK_TX_SAFE, NVLINK_RX_SAFE,
 					NVLINK_TRANSITION_SAFE_TIMEOUT_MS);
 	if (ret < 0) {
 		nvlink_err("Unable to set sublinks in safe mode");
@@ -945,20 +930,8 @@ int nvlink_transition_intranode_conn_off_to_safe(struct nvlink_device *ndev)
 	}
 
 	/* wait for sublinks to go in Safe Mode */
-	ret = nvlink_poll_sublink_state(ndev0,
-					NVLINK_TX_SAFE,
-					ndev1,
-					NVLINK_RX_SAFE,
-					NVLINK_TRANSITION_SAFE_TIMEOUT_MS);
-	if (ret < 0) {
-		nvlink_err("Unable to set sublinks in Safe mode");
-		return ret;
-	}
-
-	ret = nvlink_poll_sublink_state(ndev1,
-					NVLINK_TX_SAFE,
-					ndev0,
-					NVLINK_RX_SAFE,
+	ret = nvlink_poll_sublink_state(ndev0, ndev1,
+					NVLINK_TX_SAFE, NVLINK_RX_SAFE,
 					NVLINK_TRANSITION_SAFE_TIMEOUT_MS);
 	if (ret < 0) {
 		nvlink_err("Unable to set sublinks in Safe mode");
@@ -1070,20 +1043,8 @@ int nvlink_train_intranode_conn_safe_to_hs(struct nvlink_device *ndev)
 	}
 
 	/* wait for sublinks to go in High Speed */
-	ret = nvlink_poll_sublink_state(ndev0,
-					NVLINK_TX_HS,
-					ndev1,
-					NVLINK_RX_HS,
-					NVLINK_TRANSITION_HS_TIMEOUT_MS);
-	if (ret < 0) {
-		nvlink_err("Unable to set sublinks in high speed mode");
-		return ret;
-	}
-
-	ret = nvlink_poll_sublink_state(ndev1,
-					NVLINK_TX_HS,
-					ndev0,
-					NVLINK_RX_HS,
+	ret = nvlink_poll_sublink_state(ndev0, ndev1,
+					NVLINK_TX_HS, NVLINK_RX_HS,
 					NVLINK_TRANSITION_HS_TIMEOUT_MS);
 	if (ret < 0) {
 		nvlink_err("Unable to set sublinks in high speed mode");
@@ -1295,6 +1256,46 @@ success:
 }
 EXPORT_SYMBOL(nvlink_initialize_endpoint);
 
+struct nvlink_endpoint_init_work {
+	struct work_struct work;
+	struct nvlink_device *ndev;
+	int ret;
+};
+
+static void nvlink_endpoint_init_worker(struct work_struct *work)
+{
+	struct nvlink_endpoint_init_work *w = container_of(work,
+					struct nvlink_endpoint_init_work, work);
+
+	w->ret = nvlink_initialize_endpoint(w->ndev);
+}
+
+/*
+ * Initialize both endpoints of a connection. The endpoints are separate
+ * devices, except in loopback, so the slave is brought up on a worker while
+ * the master is brought up here.
+ */
+static int nvlink_initialize_endpoints(struct nvlink_device *master_dev,
+					struct nvlink_device *slave_dev)
+{
+	struct nvlink_endpoint_init_work slave_init;
+	int ret;
+
+	if (master_dev == slave_dev)
+		return nvlink_initialize_endpoint(master_dev);
+
+	slave_init.ndev = slave_dev;
+	INIT_WORK_ONSTACK(&slave_init.work, nvlink_endpoint_init_worker);
+	queue_work(system_unbound_wq, &slave_init.work);
+
+	ret = nvlink_initialize_endpoint(master_dev);
+
+	flush_work(&slave_init.work);
+	destroy_work_on_stack(&slave_init.work);
+
+	return ret < 0 ? ret : slave_init.ret;
+}
+
 /*
  * Setup the link and endpoint devices for data transfer over high speed
  * Only master device can call nvlink_enumerate to start data transfer over
@@ -1336,11 +1337,7 @@ int nvlink_enumerate(struct nvlink_device *ndev)
 	 * Initialize the clocks, resets, minion, uphy, interrupts,
 	 * memory interface on both the endpoints
 	 */
-	ret = nvlink_initialize_endpoint(slave_dev);
-	if (ret < 0)
-		goto fail;
-
-	ret = nvlink_initialize_endpoint(master_dev);
+	ret = nvlink_initialize_endpoints(master_dev, slave_dev);
 	if (ret < 0)
 		goto fail;
 
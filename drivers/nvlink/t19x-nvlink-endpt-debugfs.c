@@ -20,6 +20,10 @@
 #include "t19x-nvlink-endpt.h"
 #include "nvlink-hw.h"
 #include <linux/uaccess.h>
+#include <linux/ktime.h>
+#include <linux/math64.h>
+#include <linux/sizes.h>
+#include <uapi/linux/tegra-nvlink-uapi.h>
 
 static int nvlink_refclk_rate_file_open(struct inode *inode, struct file *file)
 {
@@ -340,6 +344,110 @@ static const struct file_operations tp_cntrs_fops = {
 	.release	= single_release,
 };
 
+/* Packets per second since the previous read of link_stats */
+static u64 link_stats_rate(u64 now, u64 last, u64 ns)
+{
+	if (!ns || now < last)
+		return 0;
+
+	return div64_u64((now - last) * NSEC_PER_SEC, ns);
+}
+
+static int link_stats_show(struct seq_file *s, void *unused)
+{
+	struct tnvlink_dev *tdev = (struct tnvlink_dev *)s->private;
+	struct tnvlink_link *tlink = &tdev->tlink;
+	u64 tx_pkts, tx_idle, rx_pkts, rx_idle;
+	u64 now = ktime_get_ns();
+	u64 ns = tlink->last_stats_ns ? now - tlink->last_stats_ns : 0;
+	u32 reg_val;
+
+	t19x_nvlink_get_tp_counters(tdev, &tx_pkts, &tx_idle, &rx_pkts,
+					&rx_idle);
+	if (!tdev->is_tp_cntr_running)
+		seq_puts(s, "TP counters are stopped, see start_tp_cntrs\n");
+
+	seq_printf(s, "TX packets: %llu (%llu/s)\n", tx_pkts,
+		link_stats_rate(tx_pkts, tlink->last_tx_packets, ns));
+	seq_printf(s, "TX idle cycles: %llu\n", tx_idle);
+	seq_printf(s, "RX packets: %llu (%llu/s)\n", rx_pkts,
+		link_stats_rate(rx_pkts, tlink->last_rx_packets, ns));
+	seq_printf(s, "RX idle cycles: %llu\n", rx_idle);
+
+	reg_val = nvlw_nvl_readl(tdev, NVL_SL0_ERROR_COUNT4);
+	seq_printf(s, "Replays: %u\n",
+		NVL_SL0_ERROR_COUNT4_REPLAY_EVENTS_V(reg_val));
+	reg_val = nvlw_nvl_readl(tdev, NVL_ERROR_COUNT1);
+	seq_printf(s, "HW recoveries: %u\n",
+		NVL_ERROR_COUNT1_RECOVERY_EVENTS_V(reg_val));
+	reg_val = nvlw_nvl_readl(tdev, NVL_SL1_ERROR_COUNT1);
+	seq_printf(s, "Flit CRC errors: %u\n",
+		NVL_SL1_ERROR_COUNT1_FLIT_CRC_ERRORS_V(reg_val));
+	seq_printf(s, "Error recoveries: %u\n", tlink->error_recoveries);
+
+	tlink->last_tx_packets = tx_pkts;
+	tlink->last_rx_packets = rx_pkts;
+	tlink->last_stats_ns = now;
+
+	return 0;
+}
+
+static int link_stats_open(struct inode *inode, struct file *file)
+{
+	return single_open(file, link_stats_show, inode->i_private);
+}
+
+static const struct file_operations link_stats_fops = {
+	.open		= link_stats_open,
+	.read		= seq_read,
+	.llseek		= seq_lseek,
+	.release	= single_release,
+};
+
+/* Loopback read bandwidth at a few sizes, see t19x_nvlink_bw_test() */
+static int bw_test_show(struct seq_file *s, void *unused)
+{
+	struct tnvlink_dev *tdev = (struct tnvlink_dev *)s->private;
+	struct tegra_nvlink_bw_test *bw_test;
+	static const u32 sizes[] = { SZ_4K, SZ_64K, SZ_1M, SZ_4M };
+	int i, ret;
+
+	bw_test = kzalloc(sizeof(*bw_test), GFP_KERNEL);
+	if (!bw_test)
+		return -ENOMEM;
+
+	bw_test->num_sizes = ARRAY_SIZE(sizes);
+	bw_test->iterations = 64;
+	memcpy(bw_test->sizes, sizes, sizeof(sizes));
+
+	ret = t19x_nvlink_bw_test(tdev, bw_test);
+	if (ret < 0)
+		goto free;
+
+	for (i = 0; i < bw_test->num_sizes; i++)
+		seq_printf(s, "%8u bytes: %u.%02u GB/s\n", bw_test->sizes[i],
+			bw_test->mbps[i] / 1000,
+			(bw_test->mbps[i] % 1000) / 10);
+	seq_printf(s, "TX packets: %llu\n", bw_test->tx_packets);
+	seq_printf(s, "RX packets: %llu\n", bw_test->rx_packets);
+
+free:
+	kfree(bw_test);
+	return ret;
+}
+
+static int bw_test_open(struct inode *inode, struct file *file)
+{
+	return single_open(file, bw_test_show, inode->i_private);
+}
+
+static const struct file_operations bw_test_fops = {
+	.open		= bw_test_open,
+	.read		= seq_read,
+	.llseek		= seq_lseek,
+	.release	= single_release,
+};
+
 static int nvlink_tlc_debugfs_init(struct tnvlink_dev *tdev)
 {
 	int ret = 0;
@@ -375,6 +483,22 @@ static int nvlink_tlc_debugfs_init(struct tnvlink_dev *tdev)
 		"Unable to create debugfs node for reset_tp_cntrs");
 		return -ENOMEM;
 	}
+
+	d = debugfs_create_file("link_stats", 0444, tlc_root, tdev,
+							&link_stats_fops);
+	if (!d) {
+		nvlink_err(
+		"Unable to create debugfs node for link_stats");
+		return -ENOMEM;
+	}
+
+	d = debugfs_create_file("bw_test", 0400, tlc_root, tdev,
+							&bw_test_fops);
+	if (!d) {
+		nvlink_err(
+		"Unable to create debugfs node for bw_test");
+		return -ENOMEM;
+	}
 	return ret;
 }
 
@@ -19,6 +19,11 @@
 
 #include <linux/uaccess.h>
 #include <linux/clk.h>
+#include <linux/ktime.h>
+#include <linux/math64.h>
+#include <linux/mutex.h>
+#include <linux/sched.h>
+#include <linux/vmalloc.h>
 #include <uapi/linux/tegra-nvlink-uapi.h>
 
 #include "t19x-nvlink-endpt.h"
@@ -26,6 +31,9 @@
 
 #define TNVLINK_LINK_ID_TO_MASK(link_id)	BIT(link_id)
 
+/* The bottom of the NVLINK aperture is fixed at 128 GB */
+#define TNVLINK_APERTURE_BASE			(128ULL << 30)
+
 static int get_nvlink_caps_ioctl(struct tnvlink_dev *tdev,
 					void *ioctl_struct);
 static int get_nvlink_status_ioctl(struct tnvlink_dev *tdev,
@@ -80,6 +88,7 @@ static int interface_disable_ioctl(struct tnvlink_dev *tdev,
 					void *ioctl_struct);
 static int finalize_shutdown_ioctl(struct tnvlink_dev *tdev,
 					void *ioctl_struct);
+static int bw_test_ioctl(struct tnvlink_dev *tdev, void *ioctl_struct);
 
 struct tnvlink_ioctl {
 	const char *const name;
@@ -254,6 +263,12 @@ static const struct tnvlink_ioctl ioctls[] = {
 		.handler		= finalize_shutdown_ioctl,
 		.is_rm_shim_ioctl	= true,
 	},
+	[TNVLINK_IOCTL_BW_TEST] = {
+		.name			= "bw_test",
+		.struct_size		= sizeof(struct tegra_nvlink_bw_test),
+		.handler		= bw_test_ioctl,
+		.is_rm_shim_ioctl	= false,
+	},
 };
 
 static bool is_nvlink_loopback_topology(struct tnvlink_dev *tdev)
@@ -1364,6 +1379,110 @@ static int finalize_shutdown_ioctl(struct tnvlink_dev *tdev, void *ioctl_struct)
 	return ret;
 }
 
+/*
+ * Loopback read bandwidth test. In loopback the NVLINK aperture is routed
+ * out on the link and back to our own memory, so copying from it with the
+ * CPU measures what the link delivers. The test only reads: we don't know
+ * what memory the aperture ends up at, so it must not be written.
+ */
+int t19x_nvlink_bw_test(struct tnvlink_dev *tdev,
+			struct tegra_nvlink_bw_test *bw_test)
+{
+	static DEFINE_MUTEX(bw_test_lock);
+	u64 tx_start, rx_start, tx_end, rx_end, idle;
+	u32 i, j, size, max_size = 0;
+	void __iomem *window;
+	bool started = false;
+	u64 start_ns, ns;
+	void *buf;
+	int ret = 0;
+
+	if (!is_nvlink_loopback_topology(tdev)) {
+		nvlink_err("Bandwidth test needs the loopback topology");
+		return -EOPNOTSUPP;
+	}
+
+	if (t19x_nvlink_get_link_mode(tdev->ndev) != NVLINK_LINK_HS) {
+		nvlink_err("Bandwidth test needs the link in HS mode");
+		return -EAGAIN;
+	}
+
+	if (!bw_test->num_sizes ||
+	    bw_test->num_sizes > TEGRA_CTRL_NVLINK_BW_TEST_MAX_SIZES ||
+	    !bw_test->iterations ||
+	    bw_test->iterations > TEGRA_CTRL_NVLINK_BW_TEST_MAX_ITERATIONS)
+		return -EINVAL;
+
+	for (i = 0; i < bw_test->num_sizes; i++) {
+		size = bw_test->sizes[i];
+		if (!size || size > TEGRA_CTRL_NVLINK_BW_TEST_MAX_BYTES)
+			return -EINVAL;
+		max_size = max(max_size, size);
+	}
+
+	buf = vmalloc(max_size);
+	if (!buf)
+		return -ENOMEM;
+
+	window = ioremap_wc(TNVLINK_APERTURE_BASE, max_size);
+	if (!window) {
+		nvlink_err("Failed to map the NVLINK aperture");
+		ret = -ENOMEM;
+		goto free_buf;
+	}
+
+	mutex_lock(&bw_test_lock);
+
+	/* Packet counts are how we know the reads did go over the link */
+	if (!tdev->is_tp_cntr_running) {
+		ret = t19x_nvlink_freeze_tp_counters(tdev, false);
+		if (ret < 0)
+			goto unlock;
+		started = true;
+	}
+	t19x_nvlink_get_tp_counters(tdev, &tx_start, &idle, &rx_start, &idle);
+
+	memset(bw_test->mbps, 0, sizeof(bw_test->mbps));
+	for (i = 0; i < bw_test->num_sizes; i++) {
+		size = bw_test->sizes[i];
+		start_ns = ktime_get_ns();
+		for (j = 0; j < bw_test->iterations; j++) {
+			memcpy_fromio(buf, window, size);
+			if (fatal_signal_pending(current)) {
+				ret = -EINTR;
+				goto stop;
+			}
+			cond_resched();
+		}
+		ns = ktime_get_ns() - start_ns;
+
+		/* bytes per us is MB/s */
+		bw_test->mbps[i] = ns ? div64_u64((u64)size *
+					bw_test->iterations * 1000, ns) : 0;
+		nvlink_dbg("Bandwidth test: %u bytes x %u: %u MB/s", size,
+			bw_test->iterations, bw_test->mbps[i]);
+	}
+
+stop:
+	t19x_nvlink_get_tp_counters(tdev, &tx_end, &idle, &rx_end, &idle);
+	bw_test->tx_packets = tx_end - tx_start;
+	bw_test->rx_packets = rx_end - rx_start;
+	if (started)
+		t19x_nvlink_freeze_tp_counters(tdev, true);
+unlock:
+	mutex_unlock(&bw_test_lock);
+	iounmap(window);
+free_buf:
+	vfree(buf);
+	return ret;
+}
+
+static int bw_test_ioctl(struct tnvlink_dev *tdev, void *ioctl_struct)
+{
+	return t19x_nvlink_bw_test(tdev,
+			(struct tegra_nvlink_bw_test *)ioctl_struct);
+}
+
 static long t19x_nvlink_endpt_ioctl(struct file *file, unsigned int cmd,
 				unsigned long arg)
 {
@@ -1141,6 +1141,12 @@ int t19x_nvlink_get_tp_counters(struct tnvlink_dev *tdev, u64 *tx0cnt,
 	rx1cntlo = nvlw_nvltlc_readl(tdev, NVLTLC_RX_DEBUG_TP_CNTR1_LO);
 	rx1cnthi = nvlw_nvltlc_readl(tdev, NVLTLC_RX_DEBUG_TP_CNTR1_HI);
 
+	/* ROLLOVER flags a wrap of the counter, it is not part of the count */
+	tx0cnthi &= ~BIT(NVLTLC_TX_DEBUG_TP_CNTR0_HI_ROLLOVER);
+	tx1cnthi &= ~BIT(NVLTLC_TX_DEBUG_TP_CNTR1_HI_ROLLOVER);
+	rx0cnthi &= ~BIT(NVLTLC_RX_DEBUG_TP_CNTR0_HI_ROLLOVER);
+	rx1cnthi &= ~BIT(NVLTLC_RX_DEBUG_TP_CNTR1_HI_ROLLOVER);
+
 	*tx0cnt = ((u64)tx0cnthi << 32) | tx0cntlo;
 	*tx1cnt = ((u64)tx1cnthi << 32) | tx1cntlo;
 	*rx0cnt = ((u64)rx0cnthi << 32) | rx0cntlo;
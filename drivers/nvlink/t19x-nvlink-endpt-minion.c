@@ -378,46 +378,39 @@ void minion_dump_registers(struct tnvlink_dev *tdev)
 	nvlink_err("");
 }
 
+/* Drop the MINION ucode kept by minion_boot() */
+void minion_release_ucode(struct tnvlink_dev *tdev)
+{
+	struct nvlink_device *ndev = tdev->ndev;
+	struct minion_hdr *hdr = &(ndev->minion_hdr);
+
+	release_firmware(ndev->minion_fw);
+	kfree(hdr->app_code_offsets);
+	kfree(hdr->app_code_sizes);
+	kfree(hdr->app_data_offsets);
+	kfree(hdr->app_data_sizes);
+	memset(hdr, 0, sizeof(struct minion_hdr));
+	ndev->minion_fw = NULL;
+	ndev->minion_img = NULL;
+}
+
 /*
- * minion_boot:
- * ------------
- * Boot the MINION microcontroller by executing the following steps:
- *    - Get MINION ucode from the filesystem
- *    - Read ucode header
- *    - Load ucode image sections into MINION's IMEM and DMEM
- *    - Start MINION boot and wait for boot to complete
- *    - Send the SWINTR DLCMD to the MINION and poll for expected interrupt
- *
- * If all goes well, the MINION should be booted and ready to accept DLCMDs from
- * SW.
- *
- * TODO: Currently we're making assumptions about the ordering of the IMEM/DMEM
- *       sections. We need to do a run-time sort on the starting offsets of all
- *       the IMEM/DMEM sections and then load each section in the derived order.
+ * Read the MINION ucode and its header. They are kept after a successful boot,
+ * so the MINION boots after a low power exit don't go back to the filesystem.
  */
-int minion_boot(struct tnvlink_dev *tdev)
+static int minion_read_ucode(struct tnvlink_dev *tdev)
 {
 	int ret = 0;
 	struct nvlink_device *ndev = tdev->ndev;
 	struct minion_hdr *hdr = &(ndev->minion_hdr);
 	int data_idx = 0;
 	int i = 0;
-	u32 elapsed_us = 0;
-	u32 reg_val = 0;
-	int dmem_scrub_pending = 1;
-	int imem_scrub_pending = 1;
-	int dump_ucode = 0;
-	u32 minion_status = 0;
-	u32 intr_code = 0;
-
-	/* Configure minion falcon Interrupts */
-	nvlink_config_minion_falcon_intr(tdev);
 
 	/* Get MINION ucode from the filesystem */
 	ret = request_firmware(&(ndev->minion_fw), MINION_FW_PATH, tdev->dev);
 	if (ret) {
 		nvlink_err("Can't get MINION ucode binary");
-		goto exit;
+		return ret;
 	}
 
 	/* Read ucode header */
@@ -445,28 +438,28 @@ int minion_boot(struct tnvlink_dev *tdev)
 	if (!hdr->app_code_offsets) {
 		nvlink_err("Couldn't allocate MINION app_code_offsets array");
 		ret = -ENOMEM;
-		goto cleanup;
+		goto fail;
 	}
 
 	hdr->app_code_sizes = kcalloc(hdr->num_apps, sizeof(u32), GFP_KERNEL);
 	if (!hdr->app_code_sizes) {
 		nvlink_err("Couldn't allocate MINION app_code_sizes array");
 		ret = -ENOMEM;
-		goto cleanup;
+		goto fail;
 	}
 
 	hdr->app_data_offsets = kcalloc(hdr->num_apps, sizeof(u32), GFP_KERNEL);
 	if (!hdr->app_data_offsets) {
 		nvlink_err("Couldn't allocate MINION app_data_offsets array");
 		ret = -ENOMEM;
-		goto cleanup;
+		goto fail;
 	}
 
 	hdr->app_data_sizes = kcalloc(hdr->num_apps, sizeof(u32), GFP_KERNEL);
 	if (!hdr->app_data_sizes) {
 		nvlink_err("Couldn't allocate MINION app_data_sizes array");
 		ret = -ENOMEM;
-		goto cleanup;
+		goto fail;
 	}
 
 	/* Get app code offsets and sizes */
@@ -509,6 +502,53 @@ int minion_boot(struct tnvlink_dev *tdev)
 	nvlink_dbg("  - Overlay Size = %u", hdr->ovl_size);
 	nvlink_dbg("  - Ucode Data Size = %u", hdr->ucode_data_size);
 
+	return 0;
+
+fail:
+	minion_release_ucode(tdev);
+	return ret;
+}
+
+/*
+ * minion_boot:
+ * ------------
+ * Boot the MINION microcontroller by executing the following steps:
+ *    - Get MINION ucode from the filesystem, unless kept from a previous boot
+ *    - Read ucode header
+ *    - Load ucode image sections into MINION's IMEM and DMEM
+ *    - Start MINION boot and wait for boot to complete
+ *    - Send the SWINTR DLCMD to the MINION and poll for expected interrupt
+ *
+ * If all goes well, the MINION should be booted and ready to accept DLCMDs from
+ * SW.
+ *
+ * TODO: Currently we're making assumptions about the ordering of the IMEM/DMEM
+ *       sections. We need to do a run-time sort on the starting offsets of all
+ *       the IMEM/DMEM sections and then load each section in the derived order.
+ */
+int minion_boot(struct tnvlink_dev *tdev)
+{
+	int ret = 0;
+	struct nvlink_device *ndev = tdev->ndev;
+	struct minion_hdr *hdr = &(ndev->minion_hdr);
+	int i = 0;
+	u32 elapsed_us = 0;
+	u32 reg_val = 0;
+	int dmem_scrub_pending = 1;
+	int imem_scrub_pending = 1;
+	int dump_ucode = 0;
+	u32 minion_status = 0;
+	u32 intr_code = 0;
+
+	/* Configure minion falcon Interrupts */
+	nvlink_config_minion_falcon_intr(tdev);
+
+	if (!ndev->minion_fw) {
+		ret = minion_read_ucode(tdev);
+		if (ret < 0)
+			goto exit;
+	}
+
 	/* Do memory scrub */
 	nvlw_minion_writel(tdev, CMINION_FALCON_DMACTL, 0);
 	while (dmem_scrub_pending || imem_scrub_pending) {
@@ -712,7 +752,7 @@ int minion_boot(struct tnvlink_dev *tdev)
 		goto err_dump;
 	}
 
-	goto cleanup;
+	goto exit;
 
 err_dump:
 	/* Dump the PC trace and misc registers for error conditions */
@@ -720,16 +760,9 @@ err_dump:
 	minion_dump_registers(tdev);
 
 cleanup:
-	release_firmware(ndev->minion_fw);
-	kfree(hdr->app_code_offsets);
-	kfree(hdr->app_code_sizes);
-	kfree(hdr->app_data_offsets);
-	kfree(hdr->app_data_sizes);
-	memset(hdr, 0, sizeof(struct minion_hdr));
-
+	/* read it again next time, the failure may have been the ucode */
+	minion_release_ucode(tdev);
 exit:
-	ndev->minion_fw = NULL;
-	ndev->minion_img = NULL;
 	return ret;
 }
 
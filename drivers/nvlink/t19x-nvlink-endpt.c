@@ -1426,6 +1426,7 @@ static int t19x_nvlink_endpt_remove(struct platform_device *pdev)
 	}
 
 	t19x_nvlink_endpt_debugfs_deinit(tdev);
+	minion_release_ucode(tdev);
 	tegra_nvlink_clk_rst_deinit(tdev);
 	device_destroy(&tdev->class, tdev->dev_t);
 	cdev_del(&tdev->cdev);
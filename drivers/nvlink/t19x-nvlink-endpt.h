@@ -159,6 +159,10 @@ struct tnvlink_link {
 	u32 tlc_rx_err_status1;
 	/* Successful error recoveries */
 	u32 error_recoveries;
+	/* TL packet counts at the last link_stats read, for the rates */
+	u64 last_tx_packets;
+	u64 last_rx_packets;
+	u64 last_stats_ns;
 	/* Parameters which describe the selected Single-Lane policy */
 	struct single_lane_params sl_params;
 	/* Pointer to parent struct tnvlink_dev */
@@ -262,6 +266,7 @@ int t19x_nvlink_dev_interface_disable(struct nvlink_device *ndev);
 void minion_dump_pc_trace(struct tnvlink_dev *tdev);
 void minion_dump_registers(struct tnvlink_dev *tdev);
 int minion_boot(struct tnvlink_dev *tdev);
+void minion_release_ucode(struct tnvlink_dev *tdev);
 int init_nvhs_phy(struct tnvlink_dev *tdev);
 int minion_send_cmd(struct tnvlink_dev *tdev,
 				u32 cmd,
@@ -300,6 +305,9 @@ int t19x_nvlink_freeze_tp_counters(struct tnvlink_dev *tdev, bool bFreeze);
 int t19x_nvlink_config_tp_counters(struct tnvlink_dev *tdev);
 int t19x_nvlink_get_tp_counters(struct tnvlink_dev *tdev, u64 *tx0cnt,
 					u64 *tx1cnt, u64 *rx0cnt, u64 *rx1cnt);
+struct tegra_nvlink_bw_test;
+int t19x_nvlink_bw_test(struct tnvlink_dev *tdev,
+			struct tegra_nvlink_bw_test *bw_test);
 #ifdef CONFIG_DEBUG_FS
 void t19x_nvlink_endpt_debugfs_init(struct tnvlink_dev *tdev);
 void t19x_nvlink_endpt_debugfs_deinit(struct tnvlink_dev *tdev);
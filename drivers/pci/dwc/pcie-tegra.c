@@ -966,6 +966,25 @@ static irqreturn_t tegra_pcie_msi_irq_handler(int irq, void *arg)
 	return dw_handle_msi_irq(pp);
 }
 
+/*
+ * All MSI vectors of a controller are muxed on its one "msi" interrupt, so
+ * they can't be steered on their own. Spread the controllers instead, each
+ * one on its own CPU, so that endpoints on different root ports don't all
+ * complete on CPU0. irqbalance honours the hint.
+ */
+static void tegra_pcie_msi_set_affinity(struct tegra_pcie_dw *pcie, bool set)
+{
+	struct pcie_port *pp = &pcie->pci.pp;
+
+	if (!IS_ENABLED(CONFIG_PCI_MSI) || pp->msi_irq <= 0)
+		return;
+
+	irq_set_affinity_hint(pp->msi_irq, set ?
+			      cpumask_of(cpumask_local_spread(pcie->cid,
+							      NUMA_NO_NODE)) :
+			      NULL);
+}
+
 static inline void prog_atu(struct pcie_port *pp, int i, u32 val, u32 reg)
 {
 	struct dw_pcie *pci = to_dw_pcie_from_pp(pp);
@@ -3349,6 +3368,7 @@ static int tegra_pcie_config_rp(struct tegra_pcie_dw *pcie)
 			dev_err(pcie->dev, "failed to request \"msi\" irq\n");
 			return ret;
 		}
+		tegra_pcie_msi_set_affinity(pcie, true);
 	}
 
 	pm_runtime_enable(pcie->dev);
@@ -3356,6 +3376,7 @@ static int tegra_pcie_config_rp(struct tegra_pcie_dw *pcie)
 	if (ret < 0) {
 		dev_err(pcie->dev, "failed to enable pcie dev");
 		pm_runtime_disable(pcie->dev);
+		tegra_pcie_msi_set_affinity(pcie, false);
 		return ret;
 	}
 
@@ -3383,6 +3404,9 @@ static int tegra_pcie_config_rp(struct tegra_pcie_dw *pcie)
 
 fail_host_init:
 	pm_runtime_put_sync(pcie->dev);
+	/* the probe still succeeds without a link, keep the irq set up */
+	if (ret != -ENOMEDIUM)
+		tegra_pcie_msi_set_affinity(pcie, false);
 	return ret;
 }
 
@@ -4522,6 +4546,8 @@ static int tegra_pcie_dw_remove(struct platform_device *pdev)
 	struct tegra_pcie_dw *pcie = platform_get_drvdata(pdev);
 
 	if (pcie->mode == DW_PCIE_RC_TYPE) {
+		/* the irq is freed by devres, without a hint */
+		tegra_pcie_msi_set_affinity(pcie, false);
 		if (!pcie->link_state && pcie->power_down_en)
 			return 0;
 
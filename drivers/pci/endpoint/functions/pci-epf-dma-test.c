@@ -0,0 +1,424 @@
+/*
+ * Copyright (c) 2021, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ */
+
+#include <linux/delay.h>
+#include <linux/dma-mapping.h>
+#include <linux/ktime.h>
+#include <linux/module.h>
+#include <linux/of_platform.h>
+#include <linux/pci-epc.h>
+#include <linux/pci-epf.h>
+#include <linux/platform_device.h>
+#include <linux/tegra_pcie_dma_test.h>
+#include <linux/workqueue.h>
+
+#include "pci-epf-tegra-dma.h"
+
+#define BAR0_SIZE		PCIE_DMA_TEST_BAR0_SIZE
+#define LL_DESC_COUNT		(PCIE_DMA_TEST_MAX_DEPTH + 1)
+#define LL_SIZE			(DMA_WR_CHNL_NUM * LL_DESC_COUNT * \
+				 sizeof(struct tvnet_dma_desc))
+
+#define POLL_INTERVAL_MS	1
+#define ROUND_TIMEOUT_MS	1000
+
+struct pci_epf_dma_test {
+	struct pci_epf_header header;
+	struct device *fdev;
+	struct pci_epc *epc;
+	void __iomem *dma_base;
+	struct pcie_dma_test_mbox *mbox;
+	dma_addr_t bar0_iova;
+	struct tvnet_dma_desc *ll_virt;
+	dma_addr_t ll_iova;
+	struct delayed_work poll_work;
+};
+
+/* eDMA register layout of one direction */
+struct dma_test_dir {
+	u32 nch;
+	u32 en_off;
+	u32 db_off;
+	u32 db_stop;
+	u32 sts_off;
+	u32 clr_off;
+	u32 ctrl_off;
+	u32 ctrl_val;
+	u32 llp_low_off;
+	u32 llp_high_off;
+};
+
+static const struct dma_test_dir dma_test_wr = {
+	.nch = DMA_WR_CHNL_NUM,
+	.en_off = DMA_WRITE_ENGINE_EN_OFF,
+	.db_off = DMA_WRITE_DOORBELL_OFF,
+	.db_stop = DMA_WRITE_DOORBELL_OFF_WR_STOP,
+	.sts_off = DMA_WRITE_INT_STATUS_OFF,
+	.clr_off = DMA_WRITE_INT_CLEAR_OFF,
+	.ctrl_off = DMA_CH_CONTROL1_OFF_WRCH,
+	.ctrl_val = DMA_CH_CONTROL1_OFF_WRCH_LLE |
+		    DMA_CH_CONTROL1_OFF_WRCH_CCS,
+	.llp_low_off = DMA_LLP_LOW_OFF_WRCH,
+	.llp_high_off = DMA_LLP_HIGH_OFF_WRCH,
+};
+
+static const struct dma_test_dir dma_test_rd = {
+	.nch = DMA_RD_CHNL_NUM,
+	.en_off = DMA_READ_ENGINE_EN_OFF,
+	.db_off = DMA_READ_DOORBELL_OFF,
+	.db_stop = DMA_READ_DOORBELL_OFF_RD_STOP,
+	.sts_off = DMA_READ_INT_STATUS_OFF,
+	.clr_off = DMA_READ_INT_CLEAR_OFF,
+	.ctrl_off = DMA_CH_CONTROL1_OFF_RDCH,
+	.ctrl_val = DMA_CH_CONTROL1_OFF_RDCH_LLE |
+		    DMA_CH_CONTROL1_OFF_RDCH_CCS,
+	.llp_low_off = DMA_LLP_LOW_OFF_RDCH,
+	.llp_high_off = DMA_LLP_HIGH_OFF_RDCH,
+};
+
+/*
+ * Each channel gets depth descriptors to consecutive, non overlapping
+ * chunks of both buffers, followed by one without CB which stops it.
+ * The chain is built once and replayed every round by resetting LLP.
+ */
+static void pci_epf_dma_test_build_ll(struct pci_epf_dma_test *epfdt,
+				      bool write, u32 size, u32 depth,
+				      u32 channels, u64 host_addr)
+{
+	dma_addr_t ep_addr = epfdt->bar0_iova + PCIE_DMA_TEST_MBOX_SIZE;
+	struct tvnet_dma_desc *desc;
+	u64 off, src, dst;
+	u32 ch, i;
+
+	for (ch = 0; ch < channels; ch++) {
+		desc = epfdt->ll_virt + ch * LL_DESC_COUNT;
+		for (i = 0; i < depth; i++) {
+			off = (u64)(ch * depth + i) * size;
+			src = write ? ep_addr + off : host_addr + off;
+			dst = write ? host_addr + off : ep_addr + off;
+			desc[i].size = size;
+			desc[i].sar_low = lower_32_bits(src);
+			desc[i].sar_high = upper_32_bits(src);
+			desc[i].dar_low = lower_32_bits(dst);
+			desc[i].dar_high = upper_32_bits(dst);
+			desc[i].ctrl_reg.ctrl_d = DMA_CH_CONTROL1_OFF_WRCH_CB;
+		}
+		desc[depth - 1].ctrl_reg.ctrl_d |= DMA_CH_CONTROL1_OFF_WRCH_LIE;
+		memset(&desc[depth], 0, sizeof(desc[depth]));
+	}
+
+	/* DMA should not see the descriptors before they are complete */
+	wmb();
+}
+
+static int pci_epf_dma_test_round(struct pci_epf_dma_test *epfdt,
+				  const struct dma_test_dir *dir,
+				  u32 channels, u64 *ns)
+{
+	void __iomem *base = epfdt->dma_base;
+	u32 done = 0, mask = GENMASK(channels - 1, 0);
+	unsigned long timeout;
+	dma_addr_t ll_iova;
+	u64 start;
+	u32 ch, val;
+	int ret = 0;
+
+	for (ch = 0; ch < channels; ch++) {
+		ll_iova = epfdt->ll_iova +
+			  ch * LL_DESC_COUNT * sizeof(struct tvnet_dma_desc);
+		dma_channel_wr(base, ch, dir->ctrl_val, dir->ctrl_off);
+		dma_channel_wr(base, ch, lower_32_bits(ll_iova),
+			       dir->llp_low_off);
+		dma_channel_wr(base, ch, upper_32_bits(ll_iova),
+			       dir->llp_high_off);
+	}
+
+	timeout = jiffies + msecs_to_jiffies(ROUND_TIMEOUT_MS);
+	start = ktime_get_ns();
+	for (ch = 0; ch < channels; ch++)
+		dma_common_wr(base, ch, dir->db_off);
+
+	while (done != mask) {
+		val = dma_common_rd(base, dir->sts_off);
+		if (val & (mask << 16)) {
+			ret = -EIO;
+			break;
+		}
+		done |= val & mask;
+		if (done != mask && time_after(jiffies, timeout)) {
+			ret = -ETIMEDOUT;
+			break;
+		}
+	}
+	*ns = ktime_get_ns() - start;
+
+	dma_common_wr(base, mask | (mask << 16), dir->clr_off);
+
+	if (ret) {
+		dev_err(epfdt->fdev, "%s DMA failed: %d, status 0x%x\n",
+			dir == &dma_test_wr ? "write" : "read", ret, val);
+		for (ch = 0; ch < channels; ch++)
+			dma_common_wr(base, dir->db_stop | ch, dir->db_off);
+		/* Enable bit is the same on both engines */
+		dma_common_wr(base, DMA_WRITE_ENGINE_EN_OFF_DISABLE,
+			      dir->en_off);
+		mdelay(1);
+		dma_common_wr(base, DMA_WRITE_ENGINE_EN_OFF_ENABLE,
+			      dir->en_off);
+	}
+
+	return ret;
+}
+
+static int pci_epf_dma_test_run(struct pci_epf_dma_test *epfdt, u32 cmd)
+{
+	struct pcie_dma_test_mbox *mbox = epfdt->mbox;
+	bool write = cmd == PCIE_DMA_TEST_CMD_WRITE;
+	const struct dma_test_dir *dir = write ? &dma_test_wr : &dma_test_rd;
+	u32 mask_off = write ? DMA_WRITE_INT_MASK_OFF : DMA_READ_INT_MASK_OFF;
+	u32 size, depth, channels, iterations, i, val;
+	u64 host_addr, len, ns, min_ns = U64_MAX, max_ns = 0, total_ns = 0;
+	int ret;
+
+	if (cmd != PCIE_DMA_TEST_CMD_WRITE && cmd != PCIE_DMA_TEST_CMD_READ)
+		return -EINVAL;
+
+	size = READ_ONCE(mbox->size);
+	depth = READ_ONCE(mbox->depth);
+	channels = READ_ONCE(mbox->channels);
+	iterations = READ_ONCE(mbox->iterations);
+	host_addr = READ_ONCE(mbox->host_buf_addr);
+
+	if (!size || !depth || depth > PCIE_DMA_TEST_MAX_DEPTH ||
+	    !channels || channels > dir->nch || !iterations || !host_addr)
+		return -EINVAL;
+
+	len = (u64)size * depth * channels;
+	if (len > BAR0_SIZE - PCIE_DMA_TEST_MBOX_SIZE ||
+	    len > READ_ONCE(mbox->host_buf_size))
+		return -EINVAL;
+
+	pci_epf_dma_test_build_ll(epfdt, write, size, depth, channels,
+				  host_addr);
+
+	/* Completion is polled, mask the done and abort irqs */
+	val = dma_common_rd(epfdt->dma_base, mask_off);
+	val |= GENMASK(channels - 1, 0) | (GENMASK(channels - 1, 0) << 16);
+	dma_common_wr(epfdt->dma_base, val, mask_off);
+	dma_common_wr(epfdt->dma_base, DMA_WRITE_ENGINE_EN_OFF_ENABLE,
+		      dir->en_off);
+
+	for (i = 0; i < iterations; i++) {
+		ret = pci_epf_dma_test_round(epfdt, dir, channels, &ns);
+		if (ret)
+			return ret;
+
+		total_ns += ns;
+		min_ns = min(min_ns, ns);
+		max_ns = max(max_ns, ns);
+		cond_resched();
+	}
+
+	WRITE_ONCE(mbox->total_ns, total_ns);
+	WRITE_ONCE(mbox->min_ns, min_ns);
+	WRITE_ONCE(mbox->max_ns, max_ns);
+
+	return 0;
+}
+
+static void pci_epf_dma_test_poll_work(struct work_struct *work)
+{
+	struct pci_epf_dma_test *epfdt =
+		container_of(work, struct pci_epf_dma_test, poll_work.work);
+	struct pcie_dma_test_mbox *mbox = epfdt->mbox;
+	u32 cmd;
+	int ret;
+
+	cmd = READ_ONCE(mbox->cmd);
+	if (cmd != PCIE_DMA_TEST_CMD_NONE) {
+		/* Parameters are written by host before cmd */
+		rmb();
+		WRITE_ONCE(mbox->cmd, PCIE_DMA_TEST_CMD_NONE);
+		WRITE_ONCE(mbox->status, PCIE_DMA_TEST_STATUS_BUSY);
+
+		ret = pci_epf_dma_test_run(epfdt, cmd);
+
+		WRITE_ONCE(mbox->error, ret);
+		/* Results must be visible before the status */
+		wmb();
+		WRITE_ONCE(mbox->status, ret ? PCIE_DMA_TEST_STATUS_ERROR :
+			   PCIE_DMA_TEST_STATUS_DONE);
+	}
+
+	queue_delayed_work(system_long_wq, &epfdt->poll_work,
+			   msecs_to_jiffies(POLL_INTERVAL_MS));
+}
+
+static void pci_epf_dma_test_unbind(struct pci_epf *epf)
+{
+	struct pci_epf_dma_test *epfdt = epf_get_drvdata(epf);
+	struct pci_epc *epc = epf->epc;
+	struct device *cdev = epc->dev.parent;
+
+	cancel_delayed_work_sync(&epfdt->poll_work);
+	pci_epc_stop(epc);
+	pci_epc_clear_bar(epc, BAR_0);
+	dma_free_coherent(cdev, LL_SIZE, epfdt->ll_virt, epfdt->ll_iova);
+	dma_free_coherent(cdev, BAR0_SIZE, epfdt->mbox, epfdt->bar0_iova);
+}
+
+static int pci_epf_dma_test_bind(struct pci_epf *epf)
+{
+	struct pci_epf_dma_test *epfdt = epf_get_drvdata(epf);
+	struct pci_epc *epc = epf->epc;
+	struct pci_epf_header *header = epf->header;
+	struct device *fdev = &epf->dev;
+	struct device *cdev = epc->dev.parent;
+	struct platform_device *pdev = of_find_device_by_node(cdev->of_node);
+	struct resource *res;
+	int ret;
+
+	epfdt->fdev = fdev;
+	epfdt->epc = epc;
+
+	ret = pci_epc_write_header(epc, header);
+	if (ret) {
+		dev_err(fdev, "pci_epc_write_header() failed: %d\n", ret);
+		return ret;
+	}
+
+	res = platform_get_resource_byname(pdev, IORESOURCE_MEM, "atu_dma");
+	if (!res) {
+		dev_err(fdev, "missing atu_dma resource in DT\n");
+		return -ENODEV;
+	}
+
+	epfdt->dma_base = devm_ioremap(fdev, res->start + DMA_OFFSET,
+				       resource_size(res) - DMA_OFFSET);
+	if (!epfdt->dma_base) {
+		dev_err(fdev, "dma region map failed\n");
+		return -ENOMEM;
+	}
+
+	epfdt->mbox = dma_alloc_coherent(cdev, BAR0_SIZE, &epfdt->bar0_iova,
+					 GFP_KERNEL | __GFP_ZERO);
+	if (!epfdt->mbox) {
+		dev_err(fdev, "BAR0 allocation failed\n");
+		return -ENOMEM;
+	}
+
+	epfdt->ll_virt = dma_alloc_coherent(cdev, LL_SIZE, &epfdt->ll_iova,
+					    GFP_KERNEL | __GFP_ZERO);
+	if (!epfdt->ll_virt) {
+		dev_err(fdev, "DMA link list allocation failed\n");
+		ret = -ENOMEM;
+		goto fail_free_bar0;
+	}
+
+	epfdt->mbox->buf_offset = PCIE_DMA_TEST_MBOX_SIZE;
+	epfdt->mbox->buf_size = BAR0_SIZE - PCIE_DMA_TEST_MBOX_SIZE;
+	epfdt->mbox->status = PCIE_DMA_TEST_STATUS_IDLE;
+	wmb();
+	epfdt->mbox->magic = PCIE_DMA_TEST_MAGIC;
+
+	ret = pci_epc_set_bar(epc, BAR_0, epfdt->bar0_iova, BAR0_SIZE,
+			      PCI_BASE_ADDRESS_SPACE_MEMORY |
+			      PCI_BASE_ADDRESS_MEM_TYPE_32);
+	if (ret) {
+		dev_err(fdev, "pci_epc_set_bar() failed: %d\n", ret);
+		goto fail_free_ll;
+	}
+
+	return 0;
+
+fail_free_ll:
+	dma_free_coherent(cdev, LL_SIZE, epfdt->ll_virt, epfdt->ll_iova);
+fail_free_bar0:
+	dma_free_coherent(cdev, BAR0_SIZE, epfdt->mbox, epfdt->bar0_iova);
+	return ret;
+}
+
+static void pci_epf_dma_test_linkup(struct pci_epf *epf)
+{
+	struct pci_epf_dma_test *epfdt = epf_get_drvdata(epf);
+
+	queue_delayed_work(system_long_wq, &epfdt->poll_work, 0);
+}
+
+static const struct pci_epf_device_id pci_epf_dma_test_ids[] = {
+	{
+		.name = "pci_epf_dma_test",
+	},
+	{},
+};
+
+static int pci_epf_dma_test_probe(struct pci_epf *epf)
+{
+	struct device *dev = &epf->dev;
+	struct pci_epf_dma_test *epfdt;
+
+	epfdt = devm_kzalloc(dev, sizeof(*epfdt), GFP_KERNEL);
+	if (!epfdt)
+		return -ENOMEM;
+	epf_set_drvdata(epf, epfdt);
+
+	INIT_DELAYED_WORK(&epfdt->poll_work, pci_epf_dma_test_poll_work);
+
+	epfdt->header.vendorid = PCI_VENDOR_ID_NVIDIA;
+	epfdt->header.deviceid = PCI_ANY_ID;
+	/* Matched by tegra_pcie_dma_test host driver */
+	epfdt->header.baseclass_code = PCI_BASE_CLASS_MEMORY;
+	epfdt->header.subclass_code = PCI_CLASS_MEMORY_OTHER & 0xff;
+	epfdt->header.interrupt_pin = PCI_INTERRUPT_INTA;
+	epf->header = &epfdt->header;
+
+	return 0;
+}
+
+static struct pci_epf_ops ops = {
+	.unbind	= pci_epf_dma_test_unbind,
+	.bind	= pci_epf_dma_test_bind,
+	.linkup = pci_epf_dma_test_linkup,
+};
+
+static struct pci_epf_driver dma_test_driver = {
+	.driver.name	= "pci_epf_dma_test",
+	.probe		= pci_epf_dma_test_probe,
+	.id_table	= pci_epf_dma_test_ids,
+	.ops		= &ops,
+	.owner		= THIS_MODULE,
+};
+
+static int __init pci_epf_dma_test_init(void)
+{
+	int ret;
+
+	ret = pci_epf_register_driver(&dma_test_driver);
+	if (ret) {
+		pr_err("Failed to register PCIe EPF DMA test driver: %d\n",
+		       ret);
+		return ret;
+	}
+
+	return 0;
+}
+module_init(pci_epf_dma_test_init);
+
+static void __exit pci_epf_dma_test_exit(void)
+{
+	pci_epf_unregister_driver(&dma_test_driver);
+}
+module_exit(pci_epf_dma_test_exit);
+
+MODULE_DESCRIPTION("PCI EPF DMA THROUGHPUT TEST DRIVER");
+MODULE_LICENSE("GPL v2");
@@ -14,6 +14,8 @@
 #ifndef PCIE_EPF_TEGRA_DMA_H
 #define PCIE_EPF_TEGRA_DMA_H
 
+#define DMA_OFFSET			0x20000
+
 #define DMA_RD_CHNL_NUM			2
 #define DMA_WR_CHNL_NUM			4
 
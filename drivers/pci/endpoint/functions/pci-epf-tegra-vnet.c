@@ -13,6 +13,7 @@
 
 #include <linux/dma-iommu.h>
 #include <linux/etherdevice.h>
+#include <linux/hrtimer.h>
 #include <linux/module.h>
 #include <linux/netdevice.h>
 #include <linux/nvhost.h>
@@ -50,6 +51,33 @@ struct irqsp_data {
 	struct nvhost_interrupt_syncpt *is;
 	struct work_struct reprime_work;
 	struct device *dev;
+	/* data queue of the irq, unused for ctrl irq */
+	int qid;
+};
+
+struct pci_epf_tvnet;
+
+/* One pair of data rings, flows are hashed onto them by the stack */
+struct tvnet_ep_queue {
+	struct pci_epf_tvnet *tvnet;
+	struct napi_struct napi;
+	int qid;
+	struct irqsp_data *data_irqsp;
+	struct list_head h2ep_empty_list;
+	/* To protect h2ep empty list */
+	spinlock_t h2ep_empty_lock;
+
+	struct tvnet_counter h2ep_empty;
+	struct tvnet_counter h2ep_full;
+	struct tvnet_counter ep2h_empty;
+	struct tvnet_counter ep2h_full;
+
+	/* Host event index and ep2h_full wr_cnt at the last data irq */
+	u32 *ep2h_full_event;
+	u32 ep2h_full_kick;
+	struct hrtimer kick_timer;
+	/* Own event index of the H2EP full ring */
+	u32 *h2ep_full_event;
 };
 
 struct pci_epf_tvnet {
@@ -61,7 +89,7 @@ struct pci_epf_tvnet {
 	struct bar_md *bar_md;
 	dma_addr_t bar0_iova;
 	struct net_device *ndev;
-	struct napi_struct napi;
+	struct tvnet_ep_queue queue[TVNET_NUM_QUEUES];
 	bool pcie_link_status;
 	struct ep_ring_buf ep_ring_buf;
 	struct host_ring_buf host_ring_buf;
@@ -71,13 +99,17 @@ struct pci_epf_tvnet {
 	/* To synchronize network link state machine*/
 	struct mutex link_state_lock;
 	wait_queue_head_t link_state_wq;
-	struct list_head h2ep_empty_list;
 #if ENABLE_DMA
 	struct dma_desc_cnt desc_cnt;
 #endif
-	/* To protect h2ep empty list */
-	spinlock_t h2ep_empty_lock;
+	/*
+	 * The PCIe outbound window and the DMA write channel are shared
+	 * by all tx queues.
+	 */
+	spinlock_t tx_lock;
 	dma_addr_t rx_buf_iova;
+	/* To protect rx_buf_bitmap, buffers are freed by each queue */
+	spinlock_t rx_buf_lock;
 	unsigned long *rx_buf_bitmap;
 	int rx_num_pages;
 	void __iomem *tx_dst_va;
@@ -85,16 +117,51 @@ struct pci_epf_tvnet {
 	void *ep_dma_virt;
 	dma_addr_t ep_dma_iova;
 	struct irqsp_data *ctrl_irqsp;
-	struct irqsp_data *data_irqsp;
 
 	struct tvnet_counter h2ep_ctrl;
 	struct tvnet_counter ep2h_ctrl;
-	struct tvnet_counter h2ep_empty;
-	struct tvnet_counter h2ep_full;
-	struct tvnet_counter ep2h_empty;
-	struct tvnet_counter ep2h_full;
 };
 
+/* Delay of the EP2H data irq to batch packets, 0 raises it per xmit batch */
+static unsigned int tx_coalesce_usecs;
+module_param(tx_coalesce_usecs, uint, 0444);
+MODULE_PARM_DESC(tx_coalesce_usecs, "EP2H data irq coalescing time in usecs");
+
+static void tvnet_ep_kick_host_data(struct tvnet_ep_queue *q)
+{
+	struct pci_epc *epc = q->tvnet->epf->epc;
+	u32 wr = tvnet_ivc_get_wr_cnt(&q->ep2h_full);
+
+	if (tvnet_ivc_need_event(READ_ONCE(*q->ep2h_full_event), wr,
+				 q->ep2h_full_kick))
+		pci_epc_raise_irq(epc, PCI_EPC_IRQ_MSIX, 1 + q->qid);
+	q->ep2h_full_kick = wr;
+}
+
+static enum hrtimer_restart tvnet_ep_kick_timer(struct hrtimer *t)
+{
+	struct tvnet_ep_queue *q = container_of(t, struct tvnet_ep_queue,
+						kick_timer);
+
+	tvnet_ep_kick_host_data(q);
+
+	return HRTIMER_NORESTART;
+}
+
+/* Let host know about new EP2H full msgs, either now or after coalescing */
+static void tvnet_ep_flush_host_data(struct tvnet_ep_queue *q)
+{
+	if (!tx_coalesce_usecs) {
+		tvnet_ep_kick_host_data(q);
+		return;
+	}
+
+	if (!hrtimer_is_queued(&q->kick_timer))
+		hrtimer_start(&q->kick_timer,
+			      ns_to_ktime(tx_coalesce_usecs * NSEC_PER_USEC),
+			      HRTIMER_MODE_REL);
+}
+
 static void tvnet_ep_read_ctrl_msg(struct pci_epf_tvnet *tvnet,
 				struct ctrl_msg *msg)
 {
@@ -140,10 +207,13 @@ static int tvnet_ep_write_ctrl_msg(struct pci_epf_tvnet *tvnet,
 static dma_addr_t tvnet_ivoa_alloc(struct pci_epf_tvnet *tvnet)
 {
 	dma_addr_t iova;
+	unsigned long flags;
 	int pageno;
 
+	spin_lock_irqsave(&tvnet->rx_buf_lock, flags);
 	pageno = bitmap_find_free_region(tvnet->rx_buf_bitmap,
 					 tvnet->rx_num_pages, 0);
+	spin_unlock_irqrestore(&tvnet->rx_buf_lock, flags);
 	if (pageno < 0) {
 		dev_err(tvnet->fdev, "%s: Rx iova alloc fail, page: %d\n",
 			__func__, pageno);
@@ -156,20 +226,25 @@ static dma_addr_t tvnet_ivoa_alloc(struct pci_epf_tvnet *tvnet)
 
 static void tvnet_ep_iova_dealloc(struct pci_epf_tvnet *tvnet, dma_addr_t iova)
 {
+	unsigned long flags;
 	int pageno;
 
 	pageno = (iova - tvnet->rx_buf_iova) >> PAGE_SHIFT;
+	spin_lock_irqsave(&tvnet->rx_buf_lock, flags);
 	bitmap_release_region(tvnet->rx_buf_bitmap, pageno, 0);
+	spin_unlock_irqrestore(&tvnet->rx_buf_lock, flags);
 }
 #endif
 
-static void tvnet_ep_alloc_empty_buffers(struct pci_epf_tvnet *tvnet)
+static void tvnet_ep_alloc_empty_buffers(struct tvnet_ep_queue *q)
 {
+	struct pci_epf_tvnet *tvnet = q->tvnet;
 	struct ep_ring_buf *ep_ring_buf = &tvnet->ep_ring_buf;
 	struct pci_epc *epc = tvnet->epf->epc;
 	struct device *cdev = epc->dev.parent;
-	struct data_msg *h2ep_empty_msg = ep_ring_buf->h2ep_empty_msgs;
+	struct data_msg *h2ep_empty_msg = ep_ring_buf->h2ep_empty_msgs[q->qid];
 	struct h2ep_empty_list *h2ep_empty_ptr;
+	int count = 0;
 #if ENABLE_DMA
 	struct net_device *ndev = tvnet->ndev;
 #else
@@ -177,7 +252,7 @@ static void tvnet_ep_alloc_empty_buffers(struct pci_epf_tvnet *tvnet)
 	int ret = 0;
 #endif
 
-	while (!tvnet_ivc_full(&tvnet->h2ep_empty)) {
+	while (!tvnet_ivc_full(&q->h2ep_empty)) {
 		dma_addr_t iova;
 #if ENABLE_DMA
 		struct sk_buff *skb;
@@ -262,17 +337,20 @@ static void tvnet_ep_alloc_empty_buffers(struct pci_epf_tvnet *tvnet)
 		h2ep_empty_ptr->size = PAGE_SIZE;
 #endif
 		h2ep_empty_ptr->iova = iova;
-		spin_lock_irqsave(&tvnet->h2ep_empty_lock, flags);
-		list_add_tail(&h2ep_empty_ptr->list, &tvnet->h2ep_empty_list);
-		spin_unlock_irqrestore(&tvnet->h2ep_empty_lock, flags);
+		spin_lock_irqsave(&q->h2ep_empty_lock, flags);
+		list_add_tail(&h2ep_empty_ptr->list, &q->h2ep_empty_list);
+		spin_unlock_irqrestore(&q->h2ep_empty_lock, flags);
 
-		idx = tvnet_ivc_get_wr_cnt(&tvnet->h2ep_empty) % RING_COUNT;
+		idx = tvnet_ivc_get_wr_cnt(&q->h2ep_empty) % RING_COUNT;
 		h2ep_empty_msg[idx].u.empty_buffer.pcie_address = iova;
 		h2ep_empty_msg[idx].u.empty_buffer.buffer_len = PAGE_SIZE;
-		tvnet_ivc_advance_wr(&tvnet->h2ep_empty);
+		tvnet_ivc_advance_wr(&q->h2ep_empty);
+		count++;
+	}
 
+	/* One irq for the whole refill */
+	if (count)
 		pci_epc_raise_irq(epc, PCI_EPC_IRQ_MSIX, 0);
-	}
 }
 
 static void tvnet_ep_free_empty_buffers(struct pci_epf_tvnet *tvnet)
@@ -285,34 +363,45 @@ static void tvnet_ep_free_empty_buffers(struct pci_epf_tvnet *tvnet)
 #endif
 	struct h2ep_empty_list *h2ep_empty_ptr, *temp;
 	unsigned long flags;
+	int i;
 
-	spin_lock_irqsave(&tvnet->h2ep_empty_lock, flags);
-	list_for_each_entry_safe(h2ep_empty_ptr, temp, &tvnet->h2ep_empty_list,
-				 list) {
-		list_del(&h2ep_empty_ptr->list);
+	for (i = 0; i < TVNET_NUM_QUEUES; i++) {
+		struct tvnet_ep_queue *q = &tvnet->queue[i];
+
+		spin_lock_irqsave(&q->h2ep_empty_lock, flags);
+		list_for_each_entry_safe(h2ep_empty_ptr, temp,
+					 &q->h2ep_empty_list, list) {
+			list_del(&h2ep_empty_ptr->list);
 #if ENABLE_DMA
-		dma_unmap_single(cdev, h2ep_empty_ptr->iova,
-				 h2ep_empty_ptr->size, DMA_FROM_DEVICE);
-		dev_kfree_skb_any(h2ep_empty_ptr->skb);
+			dma_unmap_single(cdev, h2ep_empty_ptr->iova,
+					 h2ep_empty_ptr->size,
+					 DMA_FROM_DEVICE);
+			dev_kfree_skb_any(h2ep_empty_ptr->skb);
 #else
-		vunmap(h2ep_empty_ptr->virt);
-		iommu_unmap(domain, h2ep_empty_ptr->iova, PAGE_SIZE);
-		__free_pages(h2ep_empty_ptr->page, 1);
-		tvnet_ep_iova_dealloc(tvnet, h2ep_empty_ptr->iova);
+			vunmap(h2ep_empty_ptr->virt);
+			iommu_unmap(domain, h2ep_empty_ptr->iova, PAGE_SIZE);
+			__free_pages(h2ep_empty_ptr->page, 1);
+			tvnet_ep_iova_dealloc(tvnet, h2ep_empty_ptr->iova);
 #endif
-		kfree(h2ep_empty_ptr);
+			kfree(h2ep_empty_ptr);
+		}
+		spin_unlock_irqrestore(&q->h2ep_empty_lock, flags);
 	}
-	spin_unlock_irqrestore(&tvnet->h2ep_empty_lock, flags);
 }
 
 static void tvnet_ep_stop_tx_queue(struct pci_epf_tvnet *tvnet)
 {
 	struct net_device *ndev = tvnet->ndev;
 
-	netif_stop_queue(ndev);
+	int i;
+
+	netif_tx_stop_all_queues(ndev);
 	/* Get tx lock to make sure that there is no ongoing xmit */
 	netif_tx_lock(ndev);
 	netif_tx_unlock(ndev);
+
+	for (i = 0; i < TVNET_NUM_QUEUES; i++)
+		hrtimer_cancel(&tvnet->queue[i].kick_timer);
 }
 
 static void tvnet_ep_stop_rx_work(struct pci_epf_tvnet *tvnet)
@@ -326,22 +415,27 @@ static void tvnet_ep_clear_data_msg_counters(struct pci_epf_tvnet *tvnet)
 	struct host_own_cnt *host_cnt = host_ring_buf->host_cnt;
 	struct ep_ring_buf *ep_ring_buf = &tvnet->ep_ring_buf;
 	struct ep_own_cnt *ep_cnt = ep_ring_buf->ep_cnt;
-
-	host_cnt->h2ep_empty_rd_cnt = 0;
-	ep_cnt->h2ep_empty_wr_cnt = 0;
-	ep_cnt->ep2h_full_wr_cnt = 0;
-	host_cnt->ep2h_full_rd_cnt = 0;
+	int i;
+
+	for (i = 0; i < TVNET_NUM_QUEUES; i++) {
+		host_cnt->data[i].h2ep_empty_rd_cnt = 0;
+		ep_cnt->data[i].h2ep_empty_wr_cnt = 0;
+		ep_cnt->data[i].ep2h_full_wr_cnt = 0;
+		host_cnt->data[i].ep2h_full_rd_cnt = 0;
+		host_cnt->data[i].ep2h_full_event = 0;
+		tvnet->queue[i].ep2h_full_kick = 0;
+	}
 }
 
 static void tvnet_ep_update_link_state(struct net_device *ndev,
 				    enum os_link_state state)
 {
 	if (state == OS_LINK_STATE_UP) {
-		netif_start_queue(ndev);
+		netif_tx_start_all_queues(ndev);
 		netif_carrier_on(ndev);
 	} else if (state == OS_LINK_STATE_DOWN) {
 		netif_carrier_off(ndev);
-		netif_stop_queue(ndev);
+		netif_tx_stop_all_queues(ndev);
 	} else {
 		pr_err("%s: invalid sate: %d\n", __func__, state);
 	}
@@ -367,9 +461,11 @@ static void tvnet_ep_update_link_sm(struct pci_epf_tvnet *tvnet)
 static void tvnet_ep_user_link_up_req(struct pci_epf_tvnet *tvnet)
 {
 	struct ctrl_msg msg;
+	int i;
 
 	tvnet_ep_clear_data_msg_counters(tvnet);
-	tvnet_ep_alloc_empty_buffers(tvnet);
+	for (i = 0; i < TVNET_NUM_QUEUES; i++)
+		tvnet_ep_alloc_empty_buffers(&tvnet->queue[i]);
 	msg.msg_id = CTRL_MSG_LINK_UP;
 	tvnet_ep_write_ctrl_msg(tvnet, &msg);
 	tvnet->rx_link_state = DIR_LINK_STATE_UP;
@@ -418,6 +514,7 @@ static int tvnet_ep_open(struct net_device *ndev)
 {
 	struct device *fdev = ndev->dev.parent;
 	struct pci_epf_tvnet *tvnet = dev_get_drvdata(fdev);
+	int i;
 
 	if (!tvnet->pcie_link_status) {
 		dev_err(fdev, "%s: PCIe link is not up\n", __func__);
@@ -427,7 +524,12 @@ static int tvnet_ep_open(struct net_device *ndev)
 	mutex_lock(&tvnet->link_state_lock);
 	if (tvnet->rx_link_state == DIR_LINK_STATE_DOWN)
 		tvnet_ep_user_link_up_req(tvnet);
-	napi_enable(&tvnet->napi);
+	for (i = 0; i < TVNET_NUM_QUEUES; i++) {
+		struct tvnet_ep_queue *q = &tvnet->queue[i];
+
+		napi_enable(&q->napi);
+		tvnet_ivc_arm_event(&q->h2ep_full, q->h2ep_full_event);
+	}
 	mutex_unlock(&tvnet->link_state_lock);
 
 	return 0;
@@ -438,9 +540,11 @@ static int tvnet_ep_close(struct net_device *ndev)
 	struct device *fdev = ndev->dev.parent;
 	struct pci_epf_tvnet *tvnet = dev_get_drvdata(fdev);
 	int ret = 0;
+	int i;
 
 	mutex_lock(&tvnet->link_state_lock);
-	napi_disable(&tvnet->napi);
+	for (i = 0; i < TVNET_NUM_QUEUES; i++)
+		napi_disable(&tvnet->queue[i].napi);
 	if (tvnet->rx_link_state == DIR_LINK_STATE_UP)
 		tvnet_ep_user_link_down_req(tvnet);
 
@@ -484,70 +588,143 @@ static int tvnet_ep_change_mtu(struct net_device *ndev, int new_mtu)
 	return 0;
 }
 
+#if ENABLE_DMA
+/*
+ * Queue one DMA write desc per segment to consecutive dst addresses and
+ * wait for the chain. Only the last desc raises the done interrupt.
+ */
+static int tvnet_ep_dma_xfer(struct pci_epf_tvnet *tvnet,
+			     struct tvnet_dma_seg *segs, int nsegs,
+			     u64 dst_iova)
+{
+	struct dma_desc_cnt *desc_cnt = &tvnet->desc_cnt;
+	struct tvnet_dma_desc *ep_dma_virt =
+				(struct tvnet_dma_desc *)tvnet->ep_dma_virt;
+	u32 desc_widx, desc_ridx, val, ctrl_d;
+	unsigned long timeout;
+	int i;
+
+	for (i = 0; i < nsegs; i++) {
+		desc_widx = (desc_cnt->wr_cnt + i) % DMA_DESC_COUNT;
+		ep_dma_virt[desc_widx].size = segs[i].len;
+		ep_dma_virt[desc_widx].sar_low = lower_32_bits(segs[i].iova);
+		ep_dma_virt[desc_widx].sar_high = upper_32_bits(segs[i].iova);
+		ep_dma_virt[desc_widx].dar_low = lower_32_bits(dst_iova);
+		ep_dma_virt[desc_widx].dar_high = upper_32_bits(dst_iova);
+		dst_iova += segs[i].len;
+		/* CB bit should be set at the end */
+		mb();
+		ctrl_d = DMA_CH_CONTROL1_OFF_WRCH_CB;
+		if (i == nsegs - 1)
+			ctrl_d |= DMA_CH_CONTROL1_OFF_WRCH_LIE;
+		ep_dma_virt[desc_widx].ctrl_reg.ctrl_d = ctrl_d;
+	}
+
+	/* DMA write should not go out of order wrt CB bit set */
+	mb();
+
+	timeout = jiffies + msecs_to_jiffies(1000);
+	dma_common_wr8(tvnet->dma_base, DMA_WR_DATA_CH, DMA_WRITE_DOORBELL_OFF);
+	desc_cnt->wr_cnt += nsegs;
+
+	while (true) {
+		val = dma_common_rd(tvnet->dma_base, DMA_WRITE_INT_STATUS_OFF);
+		if (val == BIT(DMA_WR_DATA_CH)) {
+			dma_common_wr(tvnet->dma_base, val,
+				      DMA_WRITE_INT_CLEAR_OFF);
+			break;
+		}
+		if (time_after(jiffies, timeout)) {
+			dev_err(tvnet->fdev,
+				"dma took more time, reset dma engine\n");
+			dma_common_wr(tvnet->dma_base,
+				      DMA_WRITE_ENGINE_EN_OFF_DISABLE,
+				      DMA_WRITE_ENGINE_EN_OFF);
+			mdelay(1);
+			dma_common_wr(tvnet->dma_base,
+				      DMA_WRITE_ENGINE_EN_OFF_ENABLE,
+				      DMA_WRITE_ENGINE_EN_OFF);
+			desc_cnt->wr_cnt -= nsegs;
+			return -ETIMEDOUT;
+		}
+	}
+
+	/* Clear DMA cycle bits and increment rd_cnt */
+	for (i = 0; i < nsegs; i++) {
+		desc_ridx = desc_cnt->rd_cnt % DMA_DESC_COUNT;
+		ep_dma_virt[desc_ridx].ctrl_reg.ctrl_e.cb = 0;
+		desc_cnt->rd_cnt++;
+	}
+	mb();
+
+	return 0;
+}
+#endif
+
 static netdev_tx_t tvnet_ep_start_xmit(struct sk_buff *skb,
 				    struct net_device *ndev)
 {
 	struct device *fdev = ndev->dev.parent;
 	struct pci_epf_tvnet *tvnet = dev_get_drvdata(fdev);
+	int qid = skb_get_queue_mapping(skb);
+	struct tvnet_ep_queue *q = &tvnet->queue[qid];
 	struct host_ring_buf *host_ring_buf = &tvnet->host_ring_buf;
 	struct ep_ring_buf *ep_ring_buf = &tvnet->ep_ring_buf;
-	struct data_msg *ep2h_full_msg = ep_ring_buf->ep2h_full_msgs;
-	struct skb_shared_info *info = skb_shinfo(skb);
-	struct data_msg *ep2h_empty_msg = host_ring_buf->ep2h_empty_msgs;
+	struct data_msg *ep2h_full_msg = ep_ring_buf->ep2h_full_msgs[qid];
+	struct data_msg *ep2h_empty_msg = host_ring_buf->ep2h_empty_msgs[qid];
 	struct pci_epf *epf = tvnet->epf;
 	struct pci_epc *epc = epf->epc;
-	struct device *cdev = epc->dev.parent;
 #if ENABLE_DMA
+	struct device *cdev = epc->dev.parent;
 	struct dma_desc_cnt *desc_cnt = &tvnet->desc_cnt;
-	struct tvnet_dma_desc *ep_dma_virt =
-				(struct tvnet_dma_desc *)tvnet->ep_dma_virt;
-	u32 desc_widx, desc_ridx, val, ctrl_d;
-	unsigned long timeout;
+	struct tvnet_dma_seg segs[TVNET_MAX_DMA_SEGS];
+	int nsegs = 0;
 #endif
-	dma_addr_t src_iova;
-	u32 rd_idx, wr_idx;
+	u32 rd_idx, wr_idx, empty_left;
 	u64 dst_masked, dst_off, dst_iova;
-	int ret, dst_len, len;
-
-	/*TODO Not expecting skb frags, remove this after testing */
-	WARN_ON(info->nr_frags);
+	int ret, dst_len;
 
 	/* Check if EP2H_EMPTY_BUF available to read */
-	if (!tvnet_ivc_rd_available(&tvnet->ep2h_empty)) {
+	if (!tvnet_ivc_rd_available(&q->ep2h_empty)) {
 		pci_epc_raise_irq(epc, PCI_EPC_IRQ_MSIX, 0);
+		tvnet_ep_kick_host_data(q);
 		dev_dbg(fdev, "%s: No EP2H empty msg, stop tx\n", __func__);
-		netif_stop_queue(ndev);
+		netif_stop_subqueue(ndev, qid);
 		return NETDEV_TX_BUSY;
 	}
 
 	/* Check if EP2H_FULL_BUF available to write */
-	if (tvnet_ivc_full(&tvnet->ep2h_full)) {
-		pci_epc_raise_irq(epc, PCI_EPC_IRQ_MSIX, 1);
+	if (tvnet_ivc_full(&q->ep2h_full)) {
+		pci_epc_raise_irq(epc, PCI_EPC_IRQ_MSIX, 1 + qid);
 		dev_dbg(fdev, "%s: No EP2H full buf, stop tx\n", __func__);
-		netif_stop_queue(ndev);
+		netif_stop_subqueue(ndev, qid);
 		return NETDEV_TX_BUSY;
 	}
 
 #if ENABLE_DMA
-	/* Check if dma desc available */
-	if ((desc_cnt->wr_cnt - desc_cnt->rd_cnt) >= DMA_DESC_COUNT) {
-		dev_dbg(fdev, "%s: dma descs are not available\n", __func__);
-		netif_stop_queue(ndev);
-		return NETDEV_TX_BUSY;
-	}
-#endif
-
-	len = skb_headlen(skb);
+	if (skb->len > TVNET_DMA_COPYBREAK) {
+		/* Check if dma desc available */
+		if ((desc_cnt->wr_cnt - desc_cnt->rd_cnt) +
+		    skb_shinfo(skb)->nr_frags + 1 > DMA_DESC_COUNT) {
+			dev_dbg(fdev, "%s: dma descs are not available\n",
+				__func__);
+			tvnet_ep_kick_host_data(q);
+			netif_stop_subqueue(ndev, qid);
+			return NETDEV_TX_BUSY;
+		}
 
-	src_iova = dma_map_single(cdev, skb->data, len, DMA_TO_DEVICE);
-	if (dma_mapping_error(cdev, src_iova)) {
-		dev_err(fdev, "%s: dma_map_single failed\n", __func__);
-		dev_kfree_skb_any(skb);
-		return NETDEV_TX_OK;
+		nsegs = tvnet_dma_map_skb(cdev, skb, segs);
+		if (nsegs < 0) {
+			dev_err(fdev, "%s: dma map failed\n", __func__);
+			tvnet_ep_kick_host_data(q);
+			dev_kfree_skb_any(skb);
+			return NETDEV_TX_OK;
+		}
 	}
+#endif
 
 	/* Get EP2H empty msg */
-	rd_idx = tvnet_ivc_get_rd_cnt(&tvnet->ep2h_empty) % RING_COUNT;
+	rd_idx = tvnet_ivc_get_rd_cnt(&q->ep2h_empty) % RING_COUNT;
 	dst_iova = ep2h_empty_msg[rd_idx].u.empty_buffer.pcie_address;
 	dst_len = ep2h_empty_msg[rd_idx].u.empty_buffer.buffer_len;
 
@@ -558,11 +735,17 @@ static netdev_tx_t tvnet_ep_start_xmit(struct sk_buff *skb,
 	dst_masked = (dst_iova & ~(SZ_64K - 1));
 	dst_off = (dst_iova & (SZ_64K - 1));
 
+	spin_lock(&tvnet->tx_lock);
 	ret = pci_epc_map_addr(epc, tvnet->tx_dst_pci_addr, dst_masked,
 			       dst_len);
 	if (ret < 0) {
+		spin_unlock(&tvnet->tx_lock);
 		dev_err(fdev, "failed to map dst addr to PCIe addr range\n");
-		dma_unmap_single(cdev, src_iova, len, DMA_TO_DEVICE);
+		tvnet_ep_kick_host_data(q);
+#if ENABLE_DMA
+		if (nsegs > 0)
+			tvnet_dma_unmap_skb(cdev, segs, nsegs);
+#endif
 		dev_kfree_skb_any(skb);
 		return NETDEV_TX_OK;
 	}
@@ -571,80 +754,51 @@ static netdev_tx_t tvnet_ep_start_xmit(struct sk_buff *skb,
 	 * Advance read count after all failure cases completed, to avoid
 	 * dangling buffer at host.
 	 */
-	tvnet_ivc_advance_rd(&tvnet->ep2h_empty);
-	/* Raise an interrupt to let host populate EP2H_EMPTY_BUF ring */
-	pci_epc_raise_irq(epc, PCI_EPC_IRQ_MSIX, 0);
+	tvnet_ivc_advance_rd(&q->ep2h_empty);
+	/*
+	 * Raise an interrupt to let host populate EP2H_EMPTY_BUF ring once
+	 * it is half used, or when it runs empty.
+	 */
+	empty_left = tvnet_ivc_rd_available(&q->ep2h_empty);
+	if (empty_left == TVNET_REFILL_THRESH || !empty_left)
+		pci_epc_raise_irq(epc, PCI_EPC_IRQ_MSIX, 0);
 
 #if ENABLE_DMA
-	/* Trigger DMA write from src_iova to dst_iova */
-	desc_widx = desc_cnt->wr_cnt % DMA_DESC_COUNT;
-	ep_dma_virt[desc_widx].size = len;
-	ep_dma_virt[desc_widx].sar_low = lower_32_bits(src_iova);
-	ep_dma_virt[desc_widx].sar_high = upper_32_bits(src_iova);
-	ep_dma_virt[desc_widx].dar_low = lower_32_bits(dst_iova);
-	ep_dma_virt[desc_widx].dar_high = upper_32_bits(dst_iova);
-	/* CB bit should be set at the end */
-	mb();
-	ctrl_d = DMA_CH_CONTROL1_OFF_WRCH_LIE;
-	ctrl_d |= DMA_CH_CONTROL1_OFF_WRCH_CB;
-	ep_dma_virt[desc_widx].ctrl_reg.ctrl_d = ctrl_d;
-
-	/* DMA write should not go out of order wrt CB bit set */
-	mb();
-
-	timeout = jiffies + msecs_to_jiffies(1000);
-	dma_common_wr8(tvnet->dma_base, DMA_WR_DATA_CH, DMA_WRITE_DOORBELL_OFF);
-	desc_cnt->wr_cnt++;
-
-	while (true) {
-		val = dma_common_rd(tvnet->dma_base, DMA_WRITE_INT_STATUS_OFF);
-		if (val == BIT(DMA_WR_DATA_CH)) {
-			dma_common_wr(tvnet->dma_base, val,
-				      DMA_WRITE_INT_CLEAR_OFF);
-			break;
-		}
-		if (time_after(jiffies, timeout)) {
-			dev_err(fdev, "dma took more time, reset dma engine\n");
-			dma_common_wr(tvnet->dma_base,
-				      DMA_WRITE_ENGINE_EN_OFF_DISABLE,
-				      DMA_WRITE_ENGINE_EN_OFF);
-			mdelay(1);
-			dma_common_wr(tvnet->dma_base,
-				      DMA_WRITE_ENGINE_EN_OFF_ENABLE,
-				      DMA_WRITE_ENGINE_EN_OFF);
-			desc_cnt->wr_cnt--;
+	if (nsegs > 0) {
+		/* Trigger DMA write from skb segments to dst_iova */
+		ret = tvnet_ep_dma_xfer(tvnet, segs, nsegs, dst_iova);
+		tvnet_dma_unmap_skb(cdev, segs, nsegs);
+		if (ret < 0) {
 			pci_epc_unmap_addr(epc, tvnet->tx_dst_pci_addr);
-			dma_unmap_single(cdev, src_iova, len, DMA_TO_DEVICE);
+			spin_unlock(&tvnet->tx_lock);
+			tvnet_ep_kick_host_data(q);
 			return NETDEV_TX_BUSY;
 		}
-	}
-
-	desc_ridx = tvnet->desc_cnt.rd_cnt % DMA_DESC_COUNT;
-	/* Clear DMA cycle bit and increment rd_cnt */
-	ep_dma_virt[desc_ridx].ctrl_reg.ctrl_e.cb = 0;
-	mb();
-
-	tvnet->desc_cnt.rd_cnt++;
-#else
-	/* Copy skb->data to host dst address, use CPU virt addr */
-	memcpy((void *)(tvnet->tx_dst_va + dst_off), skb->data, len);
-	/*
-	 * tx_dst_va is ioremap_wc() mem, add mb to make sure complete skb->data
-	 * written to dst before adding it to full buffer
-	 */
-	mb();
+	} else
 #endif
+	{
+		/* Copy skb to host dst address, use CPU virt addr */
+		skb_copy_bits(skb, 0, (void *)(tvnet->tx_dst_va + dst_off),
+			      skb->len);
+		/*
+		 * tx_dst_va is ioremap_wc() mem, add mb to make sure complete
+		 * skb data written to dst before adding it to full buffer
+		 */
+		mb();
+	}
+	pci_epc_unmap_addr(epc, tvnet->tx_dst_pci_addr);
+	spin_unlock(&tvnet->tx_lock);
 
 	/* Push dst to EP2H full ring */
-	wr_idx = tvnet_ivc_get_wr_cnt(&tvnet->ep2h_full) % RING_COUNT;
-	ep2h_full_msg[wr_idx].u.full_buffer.packet_size = len;
+	wr_idx = tvnet_ivc_get_wr_cnt(&q->ep2h_full) % RING_COUNT;
+	ep2h_full_msg[wr_idx].u.full_buffer.packet_size = skb->len;
 	ep2h_full_msg[wr_idx].u.full_buffer.pcie_address = dst_iova;
-	tvnet_ivc_advance_wr(&tvnet->ep2h_full);
-	pci_epc_raise_irq(epc, PCI_EPC_IRQ_MSIX, 1);
+	tvnet_ivc_advance_wr(&q->ep2h_full);
+	/* Ring the doorbell once for a batch of packets from the stack */
+	if (!skb->xmit_more ||
+	    netif_xmit_stopped(netdev_get_tx_queue(ndev, qid)))
+		tvnet_ep_flush_host_data(q);
 
-	/* Free temp src and skb */
-	pci_epc_unmap_addr(epc, tvnet->tx_dst_pci_addr);
-	dma_unmap_single(cdev, src_iova, len, DMA_TO_DEVICE);
 	dev_kfree_skb_any(skb);
 
 	return NETDEV_TX_OK;
@@ -672,10 +826,11 @@ static void tvnet_ep_process_ctrl_msg(struct pci_epf_tvnet *tvnet)
 	}
 }
 
-static int tvnet_ep_process_h2ep_msg(struct pci_epf_tvnet *tvnet)
+static int tvnet_ep_process_h2ep_msg(struct tvnet_ep_queue *q)
 {
+	struct pci_epf_tvnet *tvnet = q->tvnet;
 	struct host_ring_buf *host_ring_buf = &tvnet->host_ring_buf;
-	struct data_msg *data_msg = host_ring_buf->h2ep_full_msgs;
+	struct data_msg *data_msg = host_ring_buf->h2ep_full_msgs[q->qid];
 	struct pci_epf *epf = tvnet->epf;
 	struct pci_epc *epc = epf->epc;
 	struct device *cdev = epc->dev.parent;
@@ -687,7 +842,7 @@ static int tvnet_ep_process_h2ep_msg(struct pci_epf_tvnet *tvnet)
 	int count = 0;
 
 	while ((count < TVNET_NAPI_WEIGHT) &&
-	       tvnet_ivc_rd_available(&tvnet->h2ep_full)) {
+	       tvnet_ivc_rd_available(&q->h2ep_full)) {
 		struct sk_buff *skb;
 		int idx, found = 0;
 		u32 len;
@@ -695,13 +850,13 @@ static int tvnet_ep_process_h2ep_msg(struct pci_epf_tvnet *tvnet)
 		unsigned long flags;
 
 		/* Read H2EP full msg */
-		idx = tvnet_ivc_get_rd_cnt(&tvnet->h2ep_full) % RING_COUNT;
+		idx = tvnet_ivc_get_rd_cnt(&q->h2ep_full) % RING_COUNT;
 		len = data_msg[idx].u.full_buffer.packet_size;
 		pcie_address = data_msg[idx].u.full_buffer.pcie_address;
 
 		/* Get H2EP msg pointer from saved list */
-		spin_lock_irqsave(&tvnet->h2ep_empty_lock, flags);
-		list_for_each_entry(h2ep_empty_ptr, &tvnet->h2ep_empty_list,
+		spin_lock_irqsave(&q->h2ep_empty_lock, flags);
+		list_for_each_entry(h2ep_empty_ptr, &q->h2ep_empty_list,
 				    list) {
 			if (h2ep_empty_ptr->iova == pcie_address) {
 				found = 1;
@@ -710,16 +865,10 @@ static int tvnet_ep_process_h2ep_msg(struct pci_epf_tvnet *tvnet)
 		}
 		WARN_ON(!found);
 		list_del(&h2ep_empty_ptr->list);
-		spin_unlock_irqrestore(&tvnet->h2ep_empty_lock, flags);
+		spin_unlock_irqrestore(&q->h2ep_empty_lock, flags);
 
 		/* Advance H2EP full buffer after search in local list */
-		tvnet_ivc_advance_rd(&tvnet->h2ep_full);
-
-		/*
-		 * If H2EP network queue is stopped due to lack of H2EP_FULL
-		 * queue, raising ctrl irq will help.
-		 */
-		pci_epc_raise_irq(epc, PCI_EPC_IRQ_MSIX, 0);
+		tvnet_ivc_advance_rd(&q->h2ep_full);
 
 #if ENABLE_DMA
 		dma_unmap_single(cdev, pcie_address, ndev->mtu,
@@ -727,14 +876,16 @@ static int tvnet_ep_process_h2ep_msg(struct pci_epf_tvnet *tvnet)
 		skb = h2ep_empty_ptr->skb;
 		skb_put(skb, len);
 		skb->protocol = eth_type_trans(skb, ndev);
-		napi_gro_receive(&tvnet->napi, skb);
+		skb_record_rx_queue(skb, q->qid);
+		napi_gro_receive(&q->napi, skb);
 #else
 		/* Alloc new skb and copy data from full buffer */
 		skb = netdev_alloc_skb(ndev, len);
 		memcpy(skb->data, h2ep_empty_ptr->virt, len);
 		skb_put(skb, len);
 		skb->protocol = eth_type_trans(skb, ndev);
-		napi_gro_receive(&tvnet->napi, skb);
+		skb_record_rx_queue(skb, q->qid);
+		napi_gro_receive(&q->napi, skb);
 
 		/* Free H2EP dst msg */
 		vunmap(h2ep_empty_ptr->virt);
@@ -747,6 +898,13 @@ static int tvnet_ep_process_h2ep_msg(struct pci_epf_tvnet *tvnet)
 		count++;
 	}
 
+	/*
+	 * If H2EP network queue is stopped due to lack of H2EP_FULL
+	 * queue, raising ctrl irq will help.
+	 */
+	if (count)
+		pci_epc_raise_irq(epc, PCI_EPC_IRQ_MSIX, 0);
+
 	return count;
 }
 
@@ -832,21 +990,28 @@ static void tvnet_ep_ctrl_irqsp_callback(void *private_data)
 	struct irqsp_data *data_irqsp = private_data;
 	struct pci_epf_tvnet *tvnet = dev_get_drvdata(data_irqsp->dev);
 	struct net_device *ndev = tvnet->ndev;
+	int i;
 
-	if (netif_queue_stopped(ndev)) {
-		if ((tvnet->os_link_state == OS_LINK_STATE_UP) &&
-		    tvnet_ivc_rd_available(&tvnet->ep2h_empty) &&
-		    !tvnet_ivc_full(&tvnet->ep2h_full)) {
-			netif_wake_queue(ndev);
-		}
+	for (i = 0; i < TVNET_NUM_QUEUES; i++) {
+		struct tvnet_ep_queue *q = &tvnet->queue[i];
+
+		if (__netif_subqueue_stopped(ndev, i) &&
+		    (tvnet->os_link_state == OS_LINK_STATE_UP) &&
+		    tvnet_ivc_rd_available(&q->ep2h_empty) &&
+		    !tvnet_ivc_full(&q->ep2h_full))
+			netif_wake_subqueue(ndev, i);
 	}
 
 	if (tvnet_ivc_rd_available(&tvnet->h2ep_ctrl))
 		tvnet_ep_process_ctrl_msg(tvnet);
 
-	if (!tvnet_ivc_full(&tvnet->h2ep_empty) &&
-	    (tvnet->os_link_state == OS_LINK_STATE_UP))
-		tvnet_ep_alloc_empty_buffers(tvnet);
+	for (i = 0; i < TVNET_NUM_QUEUES; i++) {
+		struct tvnet_ep_queue *q = &tvnet->queue[i];
+
+		if (!tvnet_ivc_full(&q->h2ep_empty) &&
+		    (tvnet->os_link_state == OS_LINK_STATE_UP))
+			tvnet_ep_alloc_empty_buffers(q);
+	}
 	schedule_work(&data_irqsp->reprime_work);
 }
 
@@ -854,31 +1019,43 @@ static void tvnet_ep_data_irqsp_reprime_work(struct work_struct *work)
 {
 	struct irqsp_data *data_irqsp =
 		container_of(work, struct irqsp_data, reprime_work);
+	struct pci_epf_tvnet *tvnet = dev_get_drvdata(data_irqsp->dev);
+	struct tvnet_ep_queue *q = &tvnet->queue[data_irqsp->qid];
 
 	nvhost_interrupt_syncpt_prime(data_irqsp->is);
+
+	/* Host may have rung the doorbell before the syncpt was primed */
+	if (tvnet_ivc_rd_available(&q->h2ep_full)) {
+		local_bh_disable();
+		napi_schedule(&q->napi);
+		local_bh_enable();
+	}
 }
 
 static void tvnet_ep_data_irqsp_callback(void *private_data)
 {
 	struct irqsp_data *data_irqsp = private_data;
 	struct pci_epf_tvnet *tvnet = dev_get_drvdata(data_irqsp->dev);
+	struct tvnet_ep_queue *q = &tvnet->queue[data_irqsp->qid];
 
-	if (tvnet_ivc_rd_available(&tvnet->h2ep_full))
-		napi_schedule(&tvnet->napi);
+	if (tvnet_ivc_rd_available(&q->h2ep_full))
+		napi_schedule(&q->napi);
 	else
 		schedule_work(&data_irqsp->reprime_work);
 }
 
 static int tvnet_ep_poll(struct napi_struct *napi, int budget)
 {
-	struct pci_epf_tvnet *tvnet = container_of(napi, struct pci_epf_tvnet,
-						   napi);
-	struct irqsp_data *data_irqsp = tvnet->data_irqsp;
+	struct tvnet_ep_queue *q = container_of(napi, struct tvnet_ep_queue,
+						napi);
+	struct irqsp_data *data_irqsp = q->data_irqsp;
 	int work_done;
 
-	work_done = tvnet_ep_process_h2ep_msg(tvnet);
+	work_done = tvnet_ep_process_h2ep_msg(q);
 	if (work_done < budget) {
 		napi_complete(napi);
+		/* Ask host for an irq on the next msg */
+		tvnet_ivc_arm_event(&q->h2ep_full, q->h2ep_full_event);
 		schedule_work(&data_irqsp->reprime_work);
 	}
 
@@ -896,7 +1073,7 @@ static int tvnet_ep_pci_epf_setup_irqsp(struct pci_epf_tvnet *tvnet)
 	struct iommu_domain *domain = iommu_get_domain_for_dev(cdev);
 	struct irq_md *irq;
 	phys_addr_t syncpt_addr;
-	int ret;
+	int ret, i;
 
 	ctrl_irqsp = devm_kzalloc(fdev, sizeof(*ctrl_irqsp), GFP_KERNEL);
 	if (!ctrl_irqsp) {
@@ -918,56 +1095,70 @@ static int tvnet_ep_pci_epf_setup_irqsp(struct pci_epf_tvnet *tvnet)
 	INIT_WORK(&ctrl_irqsp->reprime_work, tvnet_ep_ctrl_irqsp_reprime_work);
 	tvnet->ctrl_irqsp = ctrl_irqsp;
 
-	data_irqsp = devm_kzalloc(fdev, sizeof(*data_irqsp), GFP_KERNEL);
-	if (!data_irqsp) {
-		ret = -ENOMEM;
-		goto free_ctrl_sp;
-	}
-
-	data_irqsp->is =
-		nvhost_interrupt_syncpt_get(cdev->of_node,
-					    tvnet_ep_data_irqsp_callback,
-					    data_irqsp);
-	if (IS_ERR(data_irqsp->is)) {
-		ret = PTR_ERR(data_irqsp->is);
-		dev_err(fdev, "failed to get data syncpt irq: %d\n", ret);
-		goto free_ctrl_sp;
-	}
-
-	data_irqsp->dev = fdev;
-	INIT_WORK(&data_irqsp->reprime_work, tvnet_ep_data_irqsp_reprime_work);
-	tvnet->data_irqsp = data_irqsp;
-
 	syncpt_addr = nvhost_interrupt_syncpt_get_syncpt_addr(ctrl_irqsp->is);
 	ret = iommu_map(domain, amap->iova, syncpt_addr, PAGE_SIZE,
 			IOMMU_READ | IOMMU_WRITE);
 	if (ret < 0) {
 		dev_err(fdev, "%s: iommu_map of ctrlsp mem failed: %d\n",
 			__func__, ret);
-		goto free_data_sp;
+		goto free_ctrl_sp;
 	}
 	irq = &tvnet->bar_md->irq_ctrl;
 	irq->irq_addr = PAGE_SIZE;
 	irq->irq_type = IRQ_SIMPLE;
 
-	syncpt_addr = nvhost_interrupt_syncpt_get_syncpt_addr(data_irqsp->is);
-	ret = iommu_map(domain, amap->iova + PAGE_SIZE, syncpt_addr, PAGE_SIZE,
-			IOMMU_READ | IOMMU_WRITE);
-	if (ret < 0) {
-		dev_err(fdev, "%s: iommu_map of datasp mem failed: %d\n",
-			__func__, ret);
-		goto free_ctrl_ivoa;
+	/* One syncpoint page per data queue after the ctrl one */
+	for (i = 0; i < TVNET_NUM_QUEUES; i++) {
+		data_irqsp = devm_kzalloc(fdev, sizeof(*data_irqsp),
+					  GFP_KERNEL);
+		if (!data_irqsp) {
+			ret = -ENOMEM;
+			goto free_data_sp;
+		}
+
+		data_irqsp->is = nvhost_interrupt_syncpt_get(cdev->of_node,
+					tvnet_ep_data_irqsp_callback,
+					data_irqsp);
+		if (IS_ERR(data_irqsp->is)) {
+			ret = PTR_ERR(data_irqsp->is);
+			dev_err(fdev, "failed to get data syncpt irq: %d\n",
+				ret);
+			goto free_data_sp;
+		}
+
+		data_irqsp->dev = fdev;
+		data_irqsp->qid = i;
+		INIT_WORK(&data_irqsp->reprime_work,
+			  tvnet_ep_data_irqsp_reprime_work);
+
+		syncpt_addr =
+			nvhost_interrupt_syncpt_get_syncpt_addr(data_irqsp->is);
+		ret = iommu_map(domain, amap->iova + (1 + i) * PAGE_SIZE,
+				syncpt_addr, PAGE_SIZE,
+				IOMMU_READ | IOMMU_WRITE);
+		if (ret < 0) {
+			dev_err(fdev,
+				"%s: iommu_map of datasp mem failed: %d\n",
+				__func__, ret);
+			nvhost_interrupt_syncpt_free(data_irqsp->is);
+			goto free_data_sp;
+		}
+		tvnet->queue[i].data_irqsp = data_irqsp;
+
+		irq = &tvnet->bar_md->irq_data[i];
+		irq->irq_addr = (2 + i) * PAGE_SIZE;
+		irq->irq_type = IRQ_SIMPLE;
 	}
-	irq = &tvnet->bar_md->irq_data;
-	irq->irq_addr = 2 * PAGE_SIZE;
-	irq->irq_type = IRQ_SIMPLE;
 
 	return 0;
 
-free_ctrl_ivoa:
-	iommu_unmap(domain, amap->iova, PAGE_SIZE);
 free_data_sp:
-	nvhost_interrupt_syncpt_free(data_irqsp->is);
+	while (--i >= 0) {
+		iommu_unmap(domain, amap->iova + (1 + i) * PAGE_SIZE,
+			    PAGE_SIZE);
+		nvhost_interrupt_syncpt_free(tvnet->queue[i].data_irqsp->is);
+	}
+	iommu_unmap(domain, amap->iova, PAGE_SIZE);
 free_ctrl_sp:
 	nvhost_interrupt_syncpt_free(ctrl_irqsp->is);
 fail:
@@ -980,11 +1171,14 @@ static void tvnet_ep_pci_epf_destroy_irqsp(struct pci_epf_tvnet *tvnet)
 	struct pci_epc *epc = epf->epc;
 	struct device *cdev = epc->dev.parent;
 	struct iommu_domain *domain = iommu_get_domain_for_dev(cdev);
+	int i;
 
-	iommu_unmap(domain, tvnet->bar0_amap[SIMPLE_IRQ].iova + PAGE_SIZE,
-		    PAGE_SIZE);
+	for (i = 0; i < TVNET_NUM_QUEUES; i++) {
+		iommu_unmap(domain, tvnet->bar0_amap[SIMPLE_IRQ].iova +
+			    (1 + i) * PAGE_SIZE, PAGE_SIZE);
+		nvhost_interrupt_syncpt_free(tvnet->queue[i].data_irqsp->is);
+	}
 	iommu_unmap(domain, tvnet->bar0_amap[SIMPLE_IRQ].iova, PAGE_SIZE);
-	nvhost_interrupt_syncpt_free(tvnet->data_irqsp->is);
 	nvhost_interrupt_syncpt_free(tvnet->ctrl_irqsp->is);
 }
 
@@ -1138,7 +1332,9 @@ static int tvnet_ep_pci_epf_bind(struct pci_epf *epf)
 	struct resource *res;
 	struct bar0_amap *amap;
 	struct tvnet_dma_desc *dma_desc;
-	int ret, size, bitmap_size;
+	struct data_msg *data_msg;
+	int ret, size, bitmap_size, i;
+	u32 offset;
 
 	if (!domain) {
 		dev_err(fdev, "IOMMU domain not found\n");
@@ -1189,11 +1385,11 @@ static int tvnet_ep_pci_epf_bind(struct pci_epf *epf)
 	tvnet->bar_md = (struct bar_md *)tvnet->bar0_amap[META_DATA].virt;
 	bar_md = tvnet->bar_md;
 
-	/* BAR0 SIMPLE_IRQ setup: two interrupts required two pages */
+	/* BAR0 SIMPLE_IRQ setup: one page each for ctrl and every data queue */
 	amap = &tvnet->bar0_amap[SIMPLE_IRQ];
 	amap->iova = tvnet->bar0_amap[META_DATA].iova +
 		tvnet->bar0_amap[META_DATA].size;
-	amap->size = 2 * PAGE_SIZE;
+	amap->size = (1 + TVNET_NUM_QUEUES) * PAGE_SIZE;
 	ret = tvnet_ep_pci_epf_setup_irqsp(tvnet);
 	if (ret < 0) {
 		dev_err(fdev, "irqsp setup failed: %d\n", ret);
@@ -1205,7 +1401,8 @@ static int tvnet_ep_pci_epf_bind(struct pci_epf *epf)
 	amap->iova = tvnet->bar0_amap[SIMPLE_IRQ].iova +
 		tvnet->bar0_amap[SIMPLE_IRQ].size;
 	size = sizeof(struct ep_own_cnt) + (RING_COUNT *
-		(sizeof(struct ctrl_msg) + 2 * sizeof(struct data_msg)));
+		(sizeof(struct ctrl_msg) +
+		 TVNET_NUM_QUEUES * 2 * sizeof(struct data_msg)));
 	amap->size = PAGE_ALIGN(size);
 	ret = tvnet_ep_alloc_multi_page_bar0_mem(epf, EP_MEM);
 	if (ret < 0) {
@@ -1216,10 +1413,14 @@ static int tvnet_ep_pci_epf_bind(struct pci_epf *epf)
 	ep_ring_buf->ep_cnt = (struct ep_own_cnt *)amap->virt;
 	ep_ring_buf->ep2h_ctrl_msgs = (struct ctrl_msg *)
 				(ep_ring_buf->ep_cnt + 1);
-	ep_ring_buf->ep2h_full_msgs = (struct data_msg *)
-				(ep_ring_buf->ep2h_ctrl_msgs + RING_COUNT);
-	ep_ring_buf->h2ep_empty_msgs = (struct data_msg *)
-				(ep_ring_buf->ep2h_full_msgs + RING_COUNT);
+	data_msg = (struct data_msg *)(ep_ring_buf->ep2h_ctrl_msgs +
+				       RING_COUNT);
+	for (i = 0; i < TVNET_NUM_QUEUES; i++) {
+		ep_ring_buf->ep2h_full_msgs[i] = data_msg;
+		data_msg += RING_COUNT;
+		ep_ring_buf->h2ep_empty_msgs[i] = data_msg;
+		data_msg += RING_COUNT;
+	}
 	/* Clear EP counters */
 	memset(ep_ring_buf->ep_cnt, 0, sizeof(struct ep_own_cnt));
 
@@ -1228,7 +1429,8 @@ static int tvnet_ep_pci_epf_bind(struct pci_epf *epf)
 	amap->iova = tvnet->bar0_amap[EP_MEM].iova +
 					tvnet->bar0_amap[EP_MEM].size;
 	size = (sizeof(struct host_own_cnt)) + (RING_COUNT *
-		(sizeof(struct ctrl_msg) + 2 * sizeof(struct data_msg)));
+		(sizeof(struct ctrl_msg) +
+		 TVNET_NUM_QUEUES * 2 * sizeof(struct data_msg)));
 	amap->size = PAGE_ALIGN(size);
 	ret = tvnet_ep_alloc_multi_page_bar0_mem(epf, HOST_MEM);
 	if (ret < 0) {
@@ -1239,10 +1441,14 @@ static int tvnet_ep_pci_epf_bind(struct pci_epf *epf)
 	host_ring_buf->host_cnt = (struct host_own_cnt *)amap->virt;
 	host_ring_buf->h2ep_ctrl_msgs = (struct ctrl_msg *)
 				(host_ring_buf->host_cnt + 1);
-	host_ring_buf->ep2h_empty_msgs = (struct data_msg *)
-				(host_ring_buf->h2ep_ctrl_msgs + RING_COUNT);
-	host_ring_buf->h2ep_full_msgs = (struct data_msg *)
-				(host_ring_buf->ep2h_empty_msgs + RING_COUNT);
+	data_msg = (struct data_msg *)(host_ring_buf->h2ep_ctrl_msgs +
+				       RING_COUNT);
+	for (i = 0; i < TVNET_NUM_QUEUES; i++) {
+		host_ring_buf->ep2h_empty_msgs[i] = data_msg;
+		data_msg += RING_COUNT;
+		host_ring_buf->h2ep_full_msgs[i] = data_msg;
+		data_msg += RING_COUNT;
+	}
 	/* Clear host counters */
 	memset(host_ring_buf->host_cnt, 0, sizeof(struct host_own_cnt));
 
@@ -1275,12 +1481,16 @@ static int tvnet_ep_pci_epf_bind(struct pci_epf *epf)
 	bar_md->ctrl_md.ep2h_offset = bar_md->ep_own_cnt_offset +
 					sizeof(struct ep_own_cnt);
 	bar_md->ctrl_md.ep2h_size = RING_COUNT;
-	bar_md->ep2h_md.ep2h_offset = bar_md->ctrl_md.ep2h_offset +
+	offset = bar_md->ctrl_md.ep2h_offset +
 					(RING_COUNT * sizeof(struct ctrl_msg));
-	bar_md->ep2h_md.ep2h_size = RING_COUNT;
-	bar_md->h2ep_md.ep2h_offset = bar_md->ep2h_md.ep2h_offset +
-					(RING_COUNT * sizeof(struct data_msg));
-	bar_md->h2ep_md.ep2h_size = RING_COUNT;
+	for (i = 0; i < TVNET_NUM_QUEUES; i++) {
+		bar_md->ep2h_md[i].ep2h_offset = offset;
+		bar_md->ep2h_md[i].ep2h_size = RING_COUNT;
+		offset += RING_COUNT * sizeof(struct data_msg);
+		bar_md->h2ep_md[i].ep2h_offset = offset;
+		bar_md->h2ep_md[i].ep2h_size = RING_COUNT;
+		offset += RING_COUNT * sizeof(struct data_msg);
+	}
 
 	/* Host owned memory */
 	bar_md->host_own_cnt_offset = bar_md->ep_own_cnt_offset +
@@ -1288,25 +1498,39 @@ static int tvnet_ep_pci_epf_bind(struct pci_epf *epf)
 	bar_md->ctrl_md.h2ep_offset = bar_md->host_own_cnt_offset +
 					sizeof(struct host_own_cnt);
 	bar_md->ctrl_md.h2ep_size = RING_COUNT;
-	bar_md->ep2h_md.h2ep_offset = bar_md->ctrl_md.h2ep_offset +
+	offset = bar_md->ctrl_md.h2ep_offset +
 					(RING_COUNT * sizeof(struct ctrl_msg));
-	bar_md->ep2h_md.h2ep_size = RING_COUNT;
-	bar_md->h2ep_md.h2ep_offset = bar_md->ep2h_md.h2ep_offset +
-					(RING_COUNT * sizeof(struct data_msg));
-	bar_md->h2ep_md.h2ep_size = RING_COUNT;
+	for (i = 0; i < TVNET_NUM_QUEUES; i++) {
+		bar_md->ep2h_md[i].h2ep_offset = offset;
+		bar_md->ep2h_md[i].h2ep_size = RING_COUNT;
+		offset += RING_COUNT * sizeof(struct data_msg);
+		bar_md->h2ep_md[i].h2ep_offset = offset;
+		bar_md->h2ep_md[i].h2ep_size = RING_COUNT;
+		offset += RING_COUNT * sizeof(struct data_msg);
+	}
 
 	tvnet->h2ep_ctrl.rd = &ep_ring_buf->ep_cnt->h2ep_ctrl_rd_cnt;
 	tvnet->h2ep_ctrl.wr = &host_ring_buf->host_cnt->h2ep_ctrl_wr_cnt;
 	tvnet->ep2h_ctrl.rd = &host_ring_buf->host_cnt->ep2h_ctrl_rd_cnt;
 	tvnet->ep2h_ctrl.wr = &ep_ring_buf->ep_cnt->ep2h_ctrl_wr_cnt;
-	tvnet->h2ep_empty.rd = &host_ring_buf->host_cnt->h2ep_empty_rd_cnt;
-	tvnet->h2ep_empty.wr = &ep_ring_buf->ep_cnt->h2ep_empty_wr_cnt;
-	tvnet->h2ep_full.rd = &ep_ring_buf->ep_cnt->h2ep_full_rd_cnt;
-	tvnet->h2ep_full.wr = &host_ring_buf->host_cnt->h2ep_full_wr_cnt;
-	tvnet->ep2h_empty.rd = &ep_ring_buf->ep_cnt->ep2h_empty_rd_cnt;
-	tvnet->ep2h_empty.wr = &host_ring_buf->host_cnt->ep2h_empty_wr_cnt;
-	tvnet->ep2h_full.rd = &host_ring_buf->host_cnt->ep2h_full_rd_cnt;
-	tvnet->ep2h_full.wr = &ep_ring_buf->ep_cnt->ep2h_full_wr_cnt;
+
+	for (i = 0; i < TVNET_NUM_QUEUES; i++) {
+		struct tvnet_ep_queue *q = &tvnet->queue[i];
+		struct ep_own_data_cnt *ep_cnt = &ep_ring_buf->ep_cnt->data[i];
+		struct host_own_data_cnt *host_cnt =
+					&host_ring_buf->host_cnt->data[i];
+
+		q->h2ep_empty.rd = &host_cnt->h2ep_empty_rd_cnt;
+		q->h2ep_empty.wr = &ep_cnt->h2ep_empty_wr_cnt;
+		q->h2ep_full.rd = &ep_cnt->h2ep_full_rd_cnt;
+		q->h2ep_full.wr = &host_cnt->h2ep_full_wr_cnt;
+		q->ep2h_empty.rd = &ep_cnt->ep2h_empty_rd_cnt;
+		q->ep2h_empty.wr = &host_cnt->ep2h_empty_wr_cnt;
+		q->ep2h_full.rd = &host_cnt->ep2h_full_rd_cnt;
+		q->ep2h_full.wr = &ep_cnt->ep2h_full_wr_cnt;
+		q->ep2h_full_event = &host_cnt->ep2h_full_event;
+		q->h2ep_full_event = &ep_cnt->h2ep_full_event;
+	}
 
 	/* RAM region for use by host when programming EP DMA controller */
 	bar_md->host_dma_offset = bar_md->host_own_cnt_offset +
@@ -1346,10 +1570,13 @@ static int tvnet_ep_pci_epf_bind(struct pci_epf *epf)
 		goto free_host_dma;
 	}
 
+	spin_lock_init(&tvnet->rx_buf_lock);
+	spin_lock_init(&tvnet->tx_lock);
+
 	/* Register network device */
-	ndev = alloc_etherdev(0);
+	ndev = alloc_etherdev_mqs(0, TVNET_NUM_QUEUES, TVNET_NUM_QUEUES);
 	if (!ndev) {
-		dev_err(fdev, "alloc_etherdev() failed\n");
+		dev_err(fdev, "alloc_etherdev_mqs() failed\n");
 		ret = -ENOMEM;
 		goto free_pci_mem;
 	}
@@ -1358,9 +1585,24 @@ static int tvnet_ep_pci_epf_bind(struct pci_epf *epf)
 	tvnet->ndev = ndev;
 	SET_NETDEV_DEV(ndev, fdev);
 	ndev->netdev_ops = &tvnet_netdev_ops;
-	netif_napi_add(ndev, &tvnet->napi, tvnet_ep_poll, TVNET_NAPI_WEIGHT);
+	for (i = 0; i < TVNET_NUM_QUEUES; i++) {
+		struct tvnet_ep_queue *q = &tvnet->queue[i];
+
+		q->tvnet = tvnet;
+		q->qid = i;
+		INIT_LIST_HEAD(&q->h2ep_empty_list);
+		spin_lock_init(&q->h2ep_empty_lock);
+		hrtimer_init(&q->kick_timer, CLOCK_MONOTONIC,
+			     HRTIMER_MODE_REL);
+		q->kick_timer.function = tvnet_ep_kick_timer;
+		netif_napi_add(ndev, &q->napi, tvnet_ep_poll,
+			       TVNET_NAPI_WEIGHT);
+	}
 
 	ndev->mtu = TVNET_DEFAULT_MTU;
+	/* skb frags are sent with one DMA desc each */
+	ndev->hw_features |= NETIF_F_SG;
+	ndev->features |= NETIF_F_SG;
 
 	ret = register_netdev(ndev);
 	if (ret < 0) {
@@ -1375,9 +1617,6 @@ static int tvnet_ep_pci_epf_bind(struct pci_epf *epf)
 	mutex_init(&tvnet->link_state_lock);
 	init_waitqueue_head(&tvnet->link_state_wq);
 
-	INIT_LIST_HEAD(&tvnet->h2ep_empty_list);
-	spin_lock_init(&tvnet->h2ep_empty_lock);
-
 	/* TODO Update it to 64-bit prefetch type */
 	ret = pci_epc_set_bar(epc, BAR_0, tvnet->bar0_iova, BAR0_SIZE,
 			      PCI_BASE_ADDRESS_SPACE_MEMORY |
@@ -1413,7 +1652,8 @@ static int tvnet_ep_pci_epf_bind(struct pci_epf *epf)
 	dma_desc[DMA_DESC_COUNT].ctrl_reg.ctrl_e.llp = 1;
 
 	nvhost_interrupt_syncpt_prime(tvnet->ctrl_irqsp->is);
-	nvhost_interrupt_syncpt_prime(tvnet->data_irqsp->is);
+	for (i = 0; i < TVNET_NUM_QUEUES; i++)
+		nvhost_interrupt_syncpt_prime(tvnet->queue[i].data_irqsp->is);
 
 	return 0;
 
@@ -1422,7 +1662,8 @@ fail_clear_bar:
 fail_unreg_netdev:
 	unregister_netdev(ndev);
 fail_free_netdev:
-	netif_napi_del(&tvnet->napi);
+	for (i = 0; i < TVNET_NUM_QUEUES; i++)
+		netif_napi_del(&tvnet->queue[i].napi);
 	free_netdev(ndev);
 free_pci_mem:
 	pci_epc_mem_free_addr(epc, tvnet->tx_dst_pci_addr, tvnet->tx_dst_va,
@@ -1448,16 +1689,21 @@ static void tvnet_ep_pci_epf_unbind(struct pci_epf *epf)
 	struct pci_epf_tvnet *tvnet = epf_get_drvdata(epf);
 	struct pci_epc *epc = epf->epc;
 	struct device *cdev = epc->dev.parent;
+	int i;
 
 	cancel_work_sync(&tvnet->ctrl_irqsp->reprime_work);
-	cancel_work_sync(&tvnet->data_irqsp->reprime_work);
+	for (i = 0; i < TVNET_NUM_QUEUES; i++) {
+		cancel_work_sync(&tvnet->queue[i].data_irqsp->reprime_work);
+		hrtimer_cancel(&tvnet->queue[i].kick_timer);
+	}
 	pci_epc_stop(epc);
 	pci_epc_clear_bar(epc, BAR_0);
 	dma_free_coherent(cdev,
 			  ((RING_COUNT + 1) * sizeof(struct tvnet_dma_desc)),
 			  tvnet->ep_dma_virt, tvnet->ep_dma_iova);
 	unregister_netdev(tvnet->ndev);
-	netif_napi_del(&tvnet->napi);
+	for (i = 0; i < TVNET_NUM_QUEUES; i++)
+		netif_napi_del(&tvnet->queue[i].napi);
 	free_netdev(tvnet->ndev);
 	pci_epc_mem_free_addr(epc, tvnet->tx_dst_pci_addr, tvnet->tx_dst_va,
 			      SZ_64K);
@@ -1472,6 +1718,7 @@ static void tvnet_ep_pci_epf_unbind(struct pci_epf *epf)
 static void tvnet_ep_pci_epf_linkup(struct pci_epf *epf)
 {
 	struct pci_epf_tvnet *tvnet = epf_get_drvdata(epf);
+	int i;
 
 #if ENABLE_DMA
 	tvnet_ep_setup_dma(tvnet);
@@ -1481,8 +1728,13 @@ static void tvnet_ep_pci_epf_linkup(struct pci_epf *epf)
 	 * If host goes through a suspend resume, it recycles EP2H empty buffer.
 	 * Clear any pending EP2H full buffer by setting "wr_cnt = rd_cnt".
 	 */
-	tvnet_ivc_set_wr(&tvnet->ep2h_full,
-			 tvnet_ivc_get_rd_cnt(&tvnet->ep2h_full));
+	for (i = 0; i < TVNET_NUM_QUEUES; i++) {
+		struct tvnet_ep_queue *q = &tvnet->queue[i];
+
+		tvnet_ivc_set_wr(&q->ep2h_full,
+				 tvnet_ivc_get_rd_cnt(&q->ep2h_full));
+		q->ep2h_full_kick = tvnet_ivc_get_wr_cnt(&q->ep2h_full);
+	}
 
 	tvnet->pcie_link_status = true;
 }
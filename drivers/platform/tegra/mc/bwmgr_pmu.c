@@ -0,0 +1,317 @@
+/*
+ * Perf PMU for the EMC bandwidth requested by each bwmgr client
+ *
+ * Copyright (c) 2021, NVIDIA CORPORATION. All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ */
+
+#include <linux/kernel.h>
+#include <linux/init.h>
+#include <linux/ktime.h>
+#include <linux/perf_event.h>
+#include <linux/slab.h>
+#include <linux/spinlock.h>
+#include <linux/sysfs.h>
+#include <linux/platform/tegra/emc_bwmgr.h>
+#include <linux/platform/tegra/bwmgr_mc.h>
+
+/*
+ * Each client's bandwidth requests, integrated over time, are counted as
+ * KB of DRAM traffic. These are what the clients asked bwmgr for, not
+ * what the MC measured, but they attribute EMC demand per engine:
+ *
+ *	perf stat -a -e mc/nvdla0_bw/,mc/disp_0_iso_bw/ -- sleep 10
+ *	perf stat -a -e mc/client=0x10,event=0x1/ -- sleep 10
+ *
+ * This is a system wide PMU, events count on one CPU only.
+ */
+
+#define BWMGR_PMU_EVENT_BW	0x1
+#define BWMGR_PMU_EVENT_ISO_BW	0x2
+#define BWMGR_PMU_NUM_EVENTS	2
+
+#define BWMGR_PMU_CLIENT(config)	((config) & 0xff)
+#define BWMGR_PMU_EVENT(config)		(((config) >> 8) & 0xff)
+
+static struct {
+	spinlock_t lock;
+	struct {
+		u64 kb[BWMGR_PMU_NUM_EVENTS];
+		unsigned long kbps[BWMGR_PMU_NUM_EVENTS];
+		u64 since_ns;
+	} client[TEGRA_BWMGR_CLIENT_COUNT];
+} pmu_stats = {
+	.lock = __SPIN_LOCK_UNLOCKED(pmu_stats.lock),
+};
+
+static struct pmu bwmgr_pmu;
+
+/* KB transferred at kbps over ns, without overflowing for long windows */
+static u64 bwmgr_pmu_kb(unsigned long kbps, u64 ns)
+{
+	u32 rem;
+	u64 sec = div_u64_rem(ns, NSEC_PER_SEC, &rem);
+
+	return sec * kbps + div_u64((u64)kbps * rem, NSEC_PER_SEC);
+}
+
+/* call with pmu_stats.lock held */
+static void bwmgr_pmu_account(int client, u64 now)
+{
+	int i;
+	u64 ns = now - pmu_stats.client[client].since_ns;
+
+	for (i = 0; i < BWMGR_PMU_NUM_EVENTS; i++)
+		pmu_stats.client[client].kb[i] +=
+			bwmgr_pmu_kb(pmu_stats.client[client].kbps[i], ns);
+	pmu_stats.client[client].since_ns = now;
+}
+
+/*
+ * Called by bwmgr, with its lock held, when the bw or iso_bw request of a
+ * client changes. Requests are EMC rates in Hz.
+ */
+void bwmgr_pmu_update(int client, unsigned long bw, unsigned long iso_bw)
+{
+	unsigned long flags;
+
+	spin_lock_irqsave(&pmu_stats.lock, flags);
+	bwmgr_pmu_account(client, ktime_get_ns());
+	pmu_stats.client[client].kbps[BWMGR_PMU_EVENT_BW - 1] =
+		bw ? bwmgr_freq_to_bw(bw / 1000) : 0;
+	pmu_stats.client[client].kbps[BWMGR_PMU_EVENT_ISO_BW - 1] =
+		iso_bw ? bwmgr_freq_to_bw(iso_bw / 1000) : 0;
+	spin_unlock_irqrestore(&pmu_stats.lock, flags);
+}
+
+static u64 bwmgr_pmu_read_counter(struct perf_event *event)
+{
+	int client = BWMGR_PMU_CLIENT(event->attr.config);
+	int ev = BWMGR_PMU_EVENT(event->attr.config) - 1;
+	unsigned long flags;
+	u64 kb;
+
+	spin_lock_irqsave(&pmu_stats.lock, flags);
+	bwmgr_pmu_account(client, ktime_get_ns());
+	kb = pmu_stats.client[client].kb[ev];
+	spin_unlock_irqrestore(&pmu_stats.lock, flags);
+
+	return kb;
+}
+
+static void bwmgr_pmu_event_update(struct perf_event *event)
+{
+	struct hw_perf_event *hwc = &event->hw;
+	u64 prev, now;
+
+	do {
+		prev = local64_read(&hwc->prev_count);
+		now = bwmgr_pmu_read_counter(event);
+	} while (local64_cmpxchg(&hwc->prev_count, prev, now) != prev);
+
+	local64_add(now - prev, &event->count);
+}
+
+static int bwmgr_pmu_event_init(struct perf_event *event)
+{
+	u64 config = event->attr.config;
+	u32 ev = BWMGR_PMU_EVENT(config);
+
+	if (event->attr.type != event->pmu->type)
+		return -ENOENT;
+
+	/* nothing to sample on, and no per task counting */
+	if (is_sampling_event(event) || event->attach_state & PERF_ATTACH_TASK)
+		return -EOPNOTSUPP;
+
+	if (event->cpu < 0)
+		return -EINVAL;
+
+	if (config >> 16 || BWMGR_PMU_CLIENT(config) >= TEGRA_BWMGR_CLIENT_COUNT ||
+	    ev < BWMGR_PMU_EVENT_BW || ev > BWMGR_PMU_EVENT_ISO_BW)
+		return -EINVAL;
+
+	/* counters are system wide, count them all on CPU0 */
+	event->cpu = 0;
+
+	return 0;
+}
+
+static void bwmgr_pmu_event_start(struct perf_event *event, int flags)
+{
+	struct hw_perf_event *hwc = &event->hw;
+
+	local64_set(&hwc->prev_count, bwmgr_pmu_read_counter(event));
+	hwc->state = 0;
+}
+
+static void bwmgr_pmu_event_stop(struct perf_event *event, int flags)
+{
+	struct hw_perf_event *hwc = &event->hw;
+
+	if (hwc->state & PERF_HES_STOPPED)
+		return;
+
+	bwmgr_pmu_event_update(event);
+	hwc->state |= PERF_HES_STOPPED | PERF_HES_UPTODATE;
+}
+
+static int bwmgr_pmu_event_add(struct perf_event *event, int flags)
+{
+	event->hw.state = PERF_HES_STOPPED | PERF_HES_UPTODATE;
+
+	if (flags & PERF_EF_START)
+		bwmgr_pmu_event_start(event, flags);
+
+	return 0;
+}
+
+static void bwmgr_pmu_event_del(struct perf_event *event, int flags)
+{
+	bwmgr_pmu_event_stop(event, PERF_EF_UPDATE);
+}
+
+static void bwmgr_pmu_event_read(struct perf_event *event)
+{
+	bwmgr_pmu_event_update(event);
+}
+
+PMU_EVENT_ATTR_STRING(bw, bwmgr_pmu_attr_bw, "event=0x1");
+PMU_EVENT_ATTR_STRING(bw.unit, bwmgr_pmu_attr_bw_unit, "KB");
+PMU_EVENT_ATTR_STRING(iso_bw, bwmgr_pmu_attr_iso_bw, "event=0x2");
+PMU_EVENT_ATTR_STRING(iso_bw.unit, bwmgr_pmu_attr_iso_bw_unit, "KB");
+
+/*
+ * Generic events, followed by a <client>_bw and <client>_iso_bw alias for
+ * each bwmgr client, filled in at init.
+ */
+#define BWMGR_PMU_GENERIC_EVENTS	4
+#define BWMGR_PMU_EVENT_ATTRS	(BWMGR_PMU_GENERIC_EVENTS + \
+				 TEGRA_BWMGR_CLIENT_COUNT * BWMGR_PMU_NUM_EVENTS)
+
+static struct attribute *bwmgr_pmu_events[BWMGR_PMU_EVENT_ATTRS + 1] = {
+	&bwmgr_pmu_attr_bw.attr.attr,
+	&bwmgr_pmu_attr_bw_unit.attr.attr,
+	&bwmgr_pmu_attr_iso_bw.attr.attr,
+	&bwmgr_pmu_attr_iso_bw_unit.attr.attr,
+};
+
+static struct attribute_group bwmgr_pmu_events_group = {
+	.name = "events",
+	.attrs = bwmgr_pmu_events,
+};
+
+PMU_FORMAT_ATTR(client,	"config:0-7");
+PMU_FORMAT_ATTR(event,	"config:8-15");
+
+static struct attribute *bwmgr_pmu_formats[] = {
+	&format_attr_client.attr,
+	&format_attr_event.attr,
+	NULL,
+};
+
+static struct attribute_group bwmgr_pmu_format_group = {
+	.name = "format",
+	.attrs = bwmgr_pmu_formats,
+};
+
+static ssize_t cpumask_show(struct device *dev,
+			    struct device_attribute *attr, char *buf)
+{
+	return cpumap_print_to_pagebuf(true, buf, cpumask_of(0));
+}
+static DEVICE_ATTR_RO(cpumask);
+
+static struct attribute *bwmgr_pmu_cpumask_attrs[] = {
+	&dev_attr_cpumask.attr,
+	NULL,
+};
+
+static struct attribute_group bwmgr_pmu_cpumask_group = {
+	.attrs = bwmgr_pmu_cpumask_attrs,
+};
+
+static const struct attribute_group *bwmgr_pmu_attr_grps[] = {
+	&bwmgr_pmu_events_group,
+	&bwmgr_pmu_format_group,
+	&bwmgr_pmu_cpumask_group,
+	NULL,
+};
+
+static int __init bwmgr_pmu_add_event(int idx, const char *client, u32 id,
+				      u32 ev, const char *suffix)
+{
+	struct perf_pmu_events_attr *pmu_attr;
+
+	pmu_attr = kzalloc(sizeof(*pmu_attr), GFP_KERNEL);
+	if (!pmu_attr)
+		return -ENOMEM;
+
+	pmu_attr->attr.attr.name = kasprintf(GFP_KERNEL, "%s_%s",
+					     client, suffix);
+	pmu_attr->event_str = kasprintf(GFP_KERNEL,
+					"event=0x%x,client=0x%x", ev, id);
+	if (!pmu_attr->attr.attr.name || !pmu_attr->event_str) {
+		kfree(pmu_attr->attr.attr.name);
+		kfree(pmu_attr->event_str);
+		kfree(pmu_attr);
+		return -ENOMEM;
+	}
+
+	sysfs_attr_init(&pmu_attr->attr.attr);
+	pmu_attr->attr.attr.mode = S_IRUGO;
+	pmu_attr->attr.show = perf_event_sysfs_show;
+	bwmgr_pmu_events[idx] = &pmu_attr->attr.attr;
+
+	return 0;
+}
+
+static int __init bwmgr_pmu_init(void)
+{
+	int idx = BWMGR_PMU_GENERIC_EVENTS;
+	const char *name;
+	u64 now = ktime_get_ns();
+	int i, err;
+
+	for (i = 0; i < TEGRA_BWMGR_CLIENT_COUNT; i++)
+		pmu_stats.client[i].since_ns = now;
+
+	/* aliases are only a convenience, keep going without them */
+	for (i = 0; i < TEGRA_BWMGR_CLIENT_COUNT; i++) {
+		name = tegra_bwmgr_get_client_name(i);
+		if (!name ||
+		    bwmgr_pmu_add_event(idx, name, i, BWMGR_PMU_EVENT_BW,
+					"bw") ||
+		    bwmgr_pmu_add_event(idx + 1, name, i,
+					BWMGR_PMU_EVENT_ISO_BW, "iso_bw"))
+			break;
+		idx += BWMGR_PMU_NUM_EVENTS;
+	}
+	bwmgr_pmu_events[idx] = NULL;
+
+	bwmgr_pmu = (struct pmu) {
+		.task_ctx_nr	= perf_invalid_context,
+		.event_init	= bwmgr_pmu_event_init,
+		.add		= bwmgr_pmu_event_add,
+		.del		= bwmgr_pmu_event_del,
+		.start		= bwmgr_pmu_event_start,
+		.stop		= bwmgr_pmu_event_stop,
+		.read		= bwmgr_pmu_event_read,
+		.attr_groups	= bwmgr_pmu_attr_grps,
+	};
+
+	err = perf_pmu_register(&bwmgr_pmu, "mc", -1);
+	if (err)
+		pr_err("bwmgr: error %d registering mc PMU\n", err);
+
+	return err;
+}
+late_initcall(bwmgr_pmu_init);
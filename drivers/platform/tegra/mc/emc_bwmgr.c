@@ -21,6 +21,9 @@
 #include <linux/debugfs.h>
 #include <linux/thermal.h>
 #include <linux/version.h>
+#include <linux/ktime.h>
+#include <linux/seq_file.h>
+#include <linux/workqueue.h>
 #include <soc/tegra/chip-id.h>
 
 #define CREATE_TRACE_POINTS
@@ -40,6 +43,12 @@ int bwmgr_iso_bw_percentage;
 enum bwmgr_dram_types bwmgr_dram_type;
 int emc_to_dram_freq_factor;
 
+/* window over which requests lowering the EMC rate are coalesced */
+#define BWMGR_COALESCE_MS	4
+
+/* margin over the measured MC activity in closed loop mode, in % */
+#define BWMGR_CLOSED_LOOP_HEADROOM	10
+
 #define IS_HANDLE_VALID(x) ((x >= bwmgr.bwmgr_client) && \
 		(x < bwmgr.bwmgr_client + TEGRA_BWMGR_CLIENT_COUNT))
 
@@ -63,6 +72,19 @@ static struct {
 	bool status;
 	struct bwmgr_ops *ops;
 	bool override;
+	struct delayed_work coalesce_work;
+	u32 coalesce_ms;
+	/* requests waiting for coalesce_work */
+	u32 deferred;
+	u64 clk_updates;
+	/* clock changes saved by coalescing */
+	u64 coalesced;
+	/*
+	 * Size non-ISO traffic from the activity measured by the MC actmon
+	 * instead of the static requests of the non-ISO clients.
+	 */
+	bool closed_loop;
+	u32 closed_loop_headroom;
 } bwmgr;
 
 static struct dram_refresh_alrt {
@@ -85,6 +107,45 @@ static struct {
 	unsigned long req_freq;
 } debug_info;
 
+/* EMC rates tracked for residency, more than any EMC table has */
+#define BWMGR_STATS_MAX_RATES	32
+
+/* request type that set the EMC rate, as reported in the stats */
+enum bwmgr_win_type {
+	BWMGR_WIN_NONE,
+	BWMGR_WIN_FLOOR,
+	BWMGR_WIN_CAP,
+	BWMGR_WIN_ISO_CAP,
+	BWMGR_WIN_BW,
+	BWMGR_WIN_ISO_BW,
+	BWMGR_WIN_COUNT
+};
+
+static const char * const bwmgr_win_names[] = {
+	"none", "floor", "cap", "iso_cap", "bw", "iso_bw",
+};
+
+/* EMC residency and the client requests that set each rate */
+static struct {
+	struct {
+		unsigned long rate;
+		u64 time_ns;
+		u64 entries;
+	} rate[BWMGR_STATS_MAX_RATES];
+	int num_rates;
+	struct {
+		u64 time_ns[BWMGR_WIN_COUNT];
+		u64 wins[BWMGR_WIN_COUNT];
+		u64 max_time_ns; /* set the max EMC rate */
+	} client[TEGRA_BWMGR_CLIENT_COUNT];
+	unsigned long cur_rate;
+	int cur_client; /* -1 when no request sets the rate */
+	enum bwmgr_win_type cur_win;
+	ktime_t since;
+	u64 transitions;
+	u64 dvfs_time_ns; /* spent in clk_set_rate() changing the rate */
+} stats;
+
 static void bwmgr_debugfs_init(void);
 
 /* keep in sync with tegra_bwmgr_client_id */
@@ -195,6 +256,8 @@ static inline bool bwmgr_unlock(void)
 /* call with bwmgr lock held except during init*/
 static void purge_client(struct tegra_bwmgr_client *handle)
 {
+	if (handle->bw || handle->iso_bw)
+		bwmgr_pmu_update(handle - bwmgr.bwmgr_client, 0, 0);
 	handle->bw = 0;
 	handle->iso_bw = 0;
 	handle->cap = bwmgr.emc_max_rate;
@@ -214,6 +277,72 @@ static unsigned long tegra_bwmgr_apply_efficiency(
 			iso_bw_nvdis, iso_bw_vi);
 }
 
+/* call with bwmgr lock held */
+static void bwmgr_stats_account(ktime_t now)
+{
+	u64 delta = ktime_to_ns(ktime_sub(now, stats.since));
+	int i;
+
+	stats.since = now;
+	if (!stats.cur_rate)
+		return;
+
+	for (i = 0; i < stats.num_rates; i++) {
+		if (stats.rate[i].rate == stats.cur_rate) {
+			stats.rate[i].time_ns += delta;
+			break;
+		}
+	}
+
+	if (stats.cur_client >= 0) {
+		stats.client[stats.cur_client].time_ns[stats.cur_win] += delta;
+		if (stats.cur_rate >= bwmgr.emc_max_rate)
+			stats.client[stats.cur_client].max_time_ns += delta;
+	}
+}
+
+/* call with bwmgr lock held */
+static void bwmgr_stats_update(unsigned long rate, int client,
+		enum bwmgr_win_type win, s64 dvfs_ns)
+{
+	unsigned long old_rate = stats.cur_rate;
+	int i;
+
+	bwmgr_stats_account(ktime_get());
+
+	if (client >= 0 && (client != stats.cur_client ||
+			    win != stats.cur_win))
+		stats.client[client].wins[win]++;
+	stats.cur_client = client;
+	stats.cur_win = win;
+
+	if (rate == old_rate)
+		return;
+
+	stats.cur_rate = rate;
+	if (old_rate) {
+		stats.transitions++;
+		stats.dvfs_time_ns += dvfs_ns;
+	}
+
+	for (i = 0; i < stats.num_rates; i++)
+		if (stats.rate[i].rate == rate)
+			break;
+
+	if (i == stats.num_rates && i < BWMGR_STATS_MAX_RATES) {
+		stats.rate[i].rate = rate;
+		stats.num_rates++;
+	}
+	if (i < stats.num_rates)
+		stats.rate[i].entries++;
+
+#ifdef CONFIG_TRACEPOINTS
+	trace_tegra_bwmgr_emc_transition(old_rate, rate,
+			client >= 0 ? tegra_bwmgr_client_names[client] : "none",
+			bwmgr_win_names[win], dvfs_ns);
+#endif /* CONFIG_TRACEPOINTS */
+}
+
 /* call with bwmgr lock held */
 static int bwmgr_update_clk(void)
 {
@@ -228,6 +357,14 @@ static int bwmgr_update_clk(void)
 	unsigned long floor = 0;
 	unsigned long iso_bw_min;
 	u64 iso_client_flags = 0;
+	int floor_client = -1, cap_client = -1, iso_cap_client = -1;
+	int bw_client = -1, win_client = -1;
+	enum bwmgr_win_type win = BWMGR_WIN_NONE;
+	unsigned long max_client_bw = 0, unclamped;
+	struct tegra_bwmgr_client *mon =
+		&bwmgr.bwmgr_client[TEGRA_BWMGR_CLIENT_MON];
+	bool closed_loop;
+	ktime_t start;
 	int ret = 0;
 
 	/* sizeof(iso_client_flags) */
@@ -241,7 +378,40 @@ static int bwmgr_update_clk(void)
 	if (bwmgr.override)
 		return 0;
 
+	/* this change covers the requests waiting to be coalesced */
+	bwmgr.coalesced += bwmgr.deferred;
+	bwmgr.deferred = 0;
+	bwmgr.clk_updates++;
+
+	/* actmon sets the MON floor from the measured MC activity */
+	closed_loop = bwmgr.closed_loop && mon->refcount && mon->floor;
+
 	for (i = 0; i < TEGRA_BWMGR_CLIENT_COUNT; i++) {
+		unsigned long client_floor = bwmgr.bwmgr_client[i].floor;
+
+		if (bwmgr.bwmgr_client[i].cap < non_iso_cap) {
+			non_iso_cap = bwmgr.bwmgr_client[i].cap;
+			cap_client = i;
+		}
+		if (bwmgr.bwmgr_client[i].iso_cap < iso_cap) {
+			iso_cap = bwmgr.bwmgr_client[i].iso_cap;
+			iso_cap_client = i;
+		}
+
+		if (closed_loop) {
+			/*
+			 * The measured activity covers the traffic the
+			 * non-ISO requests estimate. ISO requests are
+			 * guarantees and still count, as do the debug ones.
+			 */
+			if (i == TEGRA_BWMGR_CLIENT_MON)
+				client_floor += client_floor *
+					bwmgr.closed_loop_headroom / 100;
+			else if (!bwmgr.bwmgr_client[i].iso_bw &&
+				 i != TEGRA_BWMGR_CLIENT_DEBUG)
+				continue;
+		}
+
 		bw += bwmgr.bwmgr_client[i].bw;
 		bw = min(bw, bwmgr.emc_max_rate);
 
@@ -269,9 +439,16 @@ static int bwmgr_update_clk(void)
 			iso_bw = min(iso_bw, bwmgr.emc_max_rate);
 		}
 
-		non_iso_cap = min(non_iso_cap, bwmgr.bwmgr_client[i].cap);
-		iso_cap = min(iso_cap, bwmgr.bwmgr_client[i].iso_cap);
-		floor = max(floor, bwmgr.bwmgr_client[i].floor);
+		if (client_floor > floor) {
+			floor = client_floor;
+			floor_client = i;
+		}
+		if (bwmgr.bwmgr_client[i].bw + bwmgr.bwmgr_client[i].iso_bw >
+				max_client_bw) {
+			max_client_bw = bwmgr.bwmgr_client[i].bw +
+				bwmgr.bwmgr_client[i].iso_bw;
+			bw_client = i;
+		}
 	}
 	debug_info.bw = bw;
 	debug_info.iso_bw = iso_bw;
@@ -286,20 +463,66 @@ static int bwmgr_update_clk(void)
 	debug_info.total_bw_aftr_eff = bw;
 	debug_info.iso_bw_aftr_eff = iso_bw_min;
 	floor = min(floor, bwmgr.emc_max_rate);
+
+	/* the request that sets the rate, for the stats */
+	if (floor_client >= 0 && floor >= bw) {
+		win_client = floor_client;
+		win = BWMGR_WIN_FLOOR;
+	} else if (bw_client >= 0) {
+		win_client = bw_client;
+		win = bwmgr.bwmgr_client[bw_client].iso_bw >
+			bwmgr.bwmgr_client[bw_client].bw ?
+			BWMGR_WIN_ISO_BW : BWMGR_WIN_BW;
+	}
+
 	bw = max(bw, floor);
+	unclamped = bw;
 	bw = min(bw, min(iso_cap, max(non_iso_cap, iso_bw_min)));
+	if (bw < unclamped) {
+		if (iso_cap < max(non_iso_cap, iso_bw_min)) {
+			win_client = iso_cap_client;
+			win = BWMGR_WIN_ISO_CAP;
+		} else {
+			win_client = cap_client;
+			win = BWMGR_WIN_CAP;
+		}
+	}
 	debug_info.calc_freq = bw;
 	debug_info.req_freq = bw;
 
+	start = ktime_get();
 	ret = clk_set_rate(bwmgr.emc_clk, bw);
-	if (ret)
+	if (ret) {
 		pr_err
 		("bwmgr: clk_set_rate failed for freq %lu Hz with errno %d\n",
 				bw, ret);
+		return ret;
+	}
+
+	bwmgr_stats_update(clk_get_rate(bwmgr.emc_clk),
+		win_client, win_client >= 0 ? win : BWMGR_WIN_NONE,
+		ktime_to_ns(ktime_sub(ktime_get(), start)));
 
 	return ret;
 }
 
+static void bwmgr_coalesce_worker(struct work_struct *work)
+{
+	if (!bwmgr_lock()) {
+		pr_err("bwmgr: %s failed\n", __func__);
+		return;
+	}
+
+	/* the first deferred request is the one this change applies */
+	if (bwmgr.deferred && !clk_update_disabled) {
+		bwmgr.deferred--;
+		bwmgr_update_clk();
+	}
+
+	if (!bwmgr_unlock())
+		pr_err("bwmgr: %s failed\n", __func__);
+}
+
 struct tegra_bwmgr_client *tegra_bwmgr_register(
 		enum tegra_bwmgr_client_id client)
 {
@@ -409,6 +632,10 @@ int tegra_bwmgr_set_emc(struct tegra_bwmgr_client *handle, unsigned long val,
 {
 	int ret = 0;
 	bool update_clk = false;
+	bool lower_only = false;
+	bool immediate = req & TEGRA_BWMGR_SET_EMC_IMMEDIATE;
+
+	req &= ~TEGRA_BWMGR_SET_EMC_IMMEDIATE;
 
 	if (!bwmgr.emc_clk)
 		return 0;
@@ -452,6 +679,7 @@ int tegra_bwmgr_set_emc(struct tegra_bwmgr_client *handle, unsigned long val,
 	switch (req) {
 	case TEGRA_BWMGR_SET_EMC_FLOOR:
 		if (handle->floor != val) {
+			lower_only = val < handle->floor;
 			handle->floor = val;
 			update_clk = true;
 		}
@@ -462,6 +690,7 @@ int tegra_bwmgr_set_emc(struct tegra_bwmgr_client *handle, unsigned long val,
 			val = bwmgr.emc_max_rate;
 
 		if (handle->cap != val) {
+			lower_only = val > handle->cap;
 			handle->cap = val;
 			update_clk = true;
 		}
@@ -472,6 +701,7 @@ int tegra_bwmgr_set_emc(struct tegra_bwmgr_client *handle, unsigned long val,
 			val = bwmgr.emc_max_rate;
 
 		if (handle->iso_cap != val) {
+			lower_only = val > handle->iso_cap;
 			handle->iso_cap = val;
 			update_clk = true;
 		}
@@ -479,15 +709,21 @@ int tegra_bwmgr_set_emc(struct tegra_bwmgr_client *handle, unsigned long val,
 
 	case TEGRA_BWMGR_SET_EMC_SHARED_BW:
 		if (handle->bw != val) {
+			lower_only = val < handle->bw;
 			handle->bw = val;
 			update_clk = true;
+			bwmgr_pmu_update(handle - bwmgr.bwmgr_client,
+					handle->bw, handle->iso_bw);
 		}
 		break;
 
 	case TEGRA_BWMGR_SET_EMC_SHARED_BW_ISO:
 		if (handle->iso_bw != val) {
+			lower_only = val < handle->iso_bw;
 			handle->iso_bw = val;
 			update_clk = true;
+			bwmgr_pmu_update(handle - bwmgr.bwmgr_client,
+					handle->bw, handle->iso_bw);
 		}
 		break;
 
@@ -502,8 +738,19 @@ int tegra_bwmgr_set_emc(struct tegra_bwmgr_client *handle, unsigned long val,
 		return -EINVAL;
 	}
 
-	if (update_clk && !clk_update_disabled)
-		ret = bwmgr_update_clk();
+	if (update_clk && !clk_update_disabled) {
+		/*
+		 * A lower rate is not needed by anyone, so wait for the
+		 * other requests of a burst and change the clock once.
+		 */
+		if (lower_only && !immediate && bwmgr.coalesce_ms) {
+			bwmgr.deferred++;
+			schedule_delayed_work(&bwmgr.coalesce_work,
+				msecs_to_jiffies(bwmgr.coalesce_ms));
+		} else {
+			ret = bwmgr_update_clk();
+		}
+	}
 
 	if (!bwmgr_unlock()) {
 		pr_err("bwmgr: %s failed for client %s\n",
@@ -664,6 +911,15 @@ int bwmgr_iso_bw_percentage_max(void)
 }
 EXPORT_SYMBOL_GPL(bwmgr_iso_bw_percentage_max);
 
+const char *tegra_bwmgr_get_client_name(enum tegra_bwmgr_client_id client)
+{
+	if ((unsigned int)client >= TEGRA_BWMGR_CLIENT_COUNT)
+		return NULL;
+
+	return tegra_bwmgr_client_names[client];
+}
+EXPORT_SYMBOL_GPL(tegra_bwmgr_get_client_name);
+
 unsigned long bwmgr_freq_to_bw(unsigned long freq)
 {
 	return bwmgr.ops->freq_to_bw(freq);
@@ -785,6 +1041,10 @@ int __init bwmgr_init(void)
 	struct clk *emc_master_clk;
 
 	mutex_init(&bwmgr.lock);
+	INIT_DELAYED_WORK(&bwmgr.coalesce_work, bwmgr_coalesce_worker);
+	bwmgr.coalesce_ms = BWMGR_COALESCE_MS;
+	bwmgr.closed_loop_headroom = BWMGR_CLOSED_LOOP_HEADROOM;
+	stats.cur_client = -1;
 
 	if (tegra_get_chip_id() == TEGRA210)
 		bwmgr.ops = bwmgr_eff_init_t21x();
@@ -819,6 +1079,9 @@ int __init bwmgr_init(void)
 	if (of_property_read_bool(dn, "nvidia,bwmgr-use-shared-master"))
 		emc_master_clk = clk_get_parent(emc_master_clk);
 
+	bwmgr.closed_loop = of_property_read_bool(dn,
+			"nvidia,bwmgr-closed-loop");
+
 	round_rate = clk_round_rate(emc_master_clk, 0);
 	if (round_rate < 0) {
 		bwmgr.emc_min_rate = 0;
@@ -863,6 +1126,8 @@ void __exit bwmgr_exit(void)
 {
 	int i;
 
+	cancel_delayed_work_sync(&bwmgr.coalesce_work);
+
 	for (i = 0; i < TEGRA_BWMGR_CLIENT_COUNT; i++)
 		purge_client(bwmgr.bwmgr_client + i);
 
@@ -975,6 +1240,32 @@ static int bwmgr_debugfs_emc_rate_get(void *data, u64 *val)
 DEFINE_SIMPLE_ATTRIBUTE(fops_debugfs_emc_rate, bwmgr_debugfs_emc_rate_get,
 		bwmgr_debugfs_emc_rate_set, "%llu\n");
 
+static int bwmgr_debugfs_closed_loop_set(void *data, u64 val)
+{
+	if (!bwmgr_lock()) {
+		pr_err("bwmgr: %s failed\n", __func__);
+		return -EINVAL;
+	}
+	bwmgr.closed_loop = !!val;
+	if (!clk_update_disabled)
+		bwmgr_update_clk();
+	if (!bwmgr_unlock()) {
+		pr_err("bwmgr: %s failed\n", __func__);
+		return -EINVAL;
+	}
+	return 0;
+}
+
+static int bwmgr_debugfs_closed_loop_get(void *data, u64 *val)
+{
+	*val = bwmgr.closed_loop;
+	return 0;
+}
+
+DEFINE_SIMPLE_ATTRIBUTE(fops_debugfs_closed_loop,
+		bwmgr_debugfs_closed_loop_get, bwmgr_debugfs_closed_loop_set,
+		"%llu\n");
+
 static int bwmgr_debugfs_core_emc_rate_get(void *data, u64 *val)
 {
 	*val = tegra_bwmgr_get_core_emc_rate();
@@ -1127,6 +1418,68 @@ static int bwmgr_clients_info_open(struct inode *inode, struct file *file)
 	return single_open(file, bwmgr_clients_info_show, inode->i_private);
 }
 
+static int bwmgr_emc_stats_show(struct seq_file *s, void *data)
+{
+	int i, j;
+
+	if (!bwmgr_lock()) {
+		pr_err("bwmgr: %s failed\n", __func__);
+		return -EINVAL;
+	}
+
+	bwmgr_stats_account(ktime_get());
+
+	seq_printf(s, "%15s%15s%15s\n", "Rate (Khz)", "Time (ms)",
+			"Entries");
+	for (i = 0; i < stats.num_rates; i++)
+		seq_printf(s, "%14lu%s%15llu%15llu\n",
+				stats.rate[i].rate / 1000,
+				stats.rate[i].rate == stats.cur_rate ? "*" : " ",
+				div_u64(stats.rate[i].time_ns, NSEC_PER_MSEC),
+				stats.rate[i].entries);
+	seq_printf(s, "Transitions                 : %llu\n",
+			stats.transitions);
+	seq_printf(s, "Time in DVFS transitions    : %llu (us)\n",
+			div_u64(stats.dvfs_time_ns, NSEC_PER_USEC));
+
+	/* time each client request set the EMC rate */
+	seq_printf(s, "\n%15s%10s%15s%10s%15s\n", "Client", "Request",
+			"Time (ms)", "Wins", "AtMax (ms)");
+	for (i = 0; i < TEGRA_BWMGR_CLIENT_COUNT; i++) {
+		for (j = BWMGR_WIN_FLOOR; j < BWMGR_WIN_COUNT; j++) {
+			if (!stats.client[i].wins[j])
+				continue;
+			seq_printf(s, "%14s%s%10s%15llu%10llu%15llu\n",
+				tegra_bwmgr_client_names[i],
+				(i == stats.cur_client && j == stats.cur_win) ?
+				"*" : " ", bwmgr_win_names[j],
+				div_u64(stats.client[i].time_ns[j],
+					NSEC_PER_MSEC),
+				stats.client[i].wins[j],
+				div_u64(stats.client[i].max_time_ns,
+					NSEC_PER_MSEC));
+		}
+	}
+
+	if (!bwmgr_unlock()) {
+		pr_err("bwmgr: %s failed\n", __func__);
+		return -EINVAL;
+	}
+	return 0;
+}
+
+static int bwmgr_emc_stats_open(struct inode *inode, struct file *file)
+{
+	return single_open(file, bwmgr_emc_stats_show, inode->i_private);
+}
+
+static const struct file_operations fops_bwmgr_emc_stats = {
+	.open = bwmgr_emc_stats_open,
+	.read = seq_read,
+	.llseek = seq_lseek,
+	.release = single_release,
+};
+
 static const struct file_operations fops_bwmgr_clients_info = {
 	.open = bwmgr_clients_info_open,
 	.read = seq_read,
@@ -1150,6 +1503,20 @@ static void bwmgr_debugfs_init(void)
 		debugfs_create_bool(
 			"clk_update_disabled", S_IRWXU, debugfs_dir,
 			&clk_update_disabled);
+		debugfs_create_u32(
+			"coalesce_ms", S_IRUSR | S_IWUSR, debugfs_dir,
+			&bwmgr.coalesce_ms);
+		debugfs_create_file("closed_loop", S_IRUSR | S_IWUSR,
+			debugfs_dir, NULL, &fops_debugfs_closed_loop);
+		debugfs_create_u32(
+			"closed_loop_headroom", S_IRUSR | S_IWUSR, debugfs_dir,
+			&bwmgr.closed_loop_headroom);
+		debugfs_create_u64(
+			"clk_updates", S_IRUSR, debugfs_dir,
+			&bwmgr.clk_updates);
+		debugfs_create_u64(
+			"coalesced_updates", S_IRUSR, debugfs_dir,
+			&bwmgr.coalesced);
 		debugfs_node_emc_min = debugfs_create_u64(
 			"emc_min_rate", S_IRUSR, debugfs_dir,
 			(u64 *) &bwmgr.emc_min_rate);
@@ -1180,6 +1547,8 @@ static void bwmgr_debugfs_init(void)
 		debugfs_node_clients_info = debugfs_create_file
 			("bwmgr_clients_info", S_IRUGO, debugfs_dir, NULL,
 			 &fops_bwmgr_clients_info);
+		debugfs_create_file("emc_stats", S_IRUGO, debugfs_dir, NULL,
+			 &fops_bwmgr_emc_stats);
 		debugfs_node_dram_channels = debugfs_create_file(
 			"num_dram_channels", S_IRUSR, debugfs_dir, NULL,
 			 &fops_debugfs_dram_channels);
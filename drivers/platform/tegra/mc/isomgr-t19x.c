@@ -195,6 +195,15 @@ static void t19x_iso_plat_unregister(struct isomgr_client *cp)
 static bool t19x_iso_plat_reserve(struct isomgr_client *cp, u32 bw,
 					enum tegra_iso_client client)
 {
+	/*
+	 * The client's current reservation and realization were both found
+	 * possible already. A request that doesn't need a higher min freq
+	 * than either of them can't raise the total, so skip walking the
+	 * DRAM freq table against all other clients.
+	 */
+	if (bwmgr_bw_to_freq(bw) <= max(cp->rsvd_mf, cp->real_mf))
+		return true;
+
 	if (is_isomgr_request_possible(1, 0, bw, 0, client))
 		return true;
 	else
@@ -457,12 +457,54 @@ void tegra_isomgr_unregister(tegra_isomgr_handle handle)
 }
 EXPORT_SYMBOL(tegra_isomgr_unregister);
 
+/* call with isomgr_lock and a client reference held. */
+static u32 isomgr_do_reserve(struct isomgr_client *cp, int client,
+			     u32 ubw, u32 ult)
+{
+	s32 bw = ubw;
+	u32 mf, dvfs_latency;
+
+	if (unlikely(cp->realize))
+		return 0;
+
+	if (unlikely(!cp->renegotiate && bw > cp->dedi_bw))
+		return 0;
+
+	if (isomgr.ops->isomgr_plat_reserve &&
+	    !isomgr.ops->isomgr_plat_reserve(cp, bw,
+				(enum tegra_iso_client)client))
+		return 0;
+
+	/* Look up MC's min freq that could satisfy requested BW and LT */
+	mf = mc_min_freq(ubw, ult);
+	/* Look up MC's dvfs latency at min freq */
+	dvfs_latency = mc_dvfs_latency(mf);
+
+	cp->lti = ult;		/* remember client spec'd LT (usec) */
+	cp->lto = dvfs_latency;	/* remember MC calculated LT (usec) */
+	cp->rsvd_mf = mf;	/* remember associated min freq */
+	cp->rsvd_bw = bw;
+
+	return dvfs_latency;
+}
+
+/* call with isomgr_lock and a client reference held. */
+static u32 isomgr_do_realize(struct isomgr_client *cp)
+{
+	if (isomgr.ops->isomgr_plat_realize &&
+	    !isomgr.ops->isomgr_plat_realize(cp))
+		return 0;
+
+	cp->realize = false;
+	update_mc_clock();
+
+	return (u32)cp->lto;
+}
+
 static u32 __tegra_isomgr_reserve(tegra_isomgr_handle handle,
 			 u32 ubw, u32 ult)
 {
-	s32 bw = ubw;
-	bool ret = 0;
-	u32 mf, dvfs_latency = 0;
+	u32 dvfs_latency = 0;
 	struct isomgr_client *cp = (struct isomgr_client *) handle;
 	int client = cp - &isomgr_clients[0];
 
@@ -488,29 +530,8 @@ static u32 __tegra_isomgr_reserve(tegra_isomgr_handle handle,
 
 	trace_tegra_isomgr_reserve(handle, ubw, ult, cname[client], "enter");
 
-	if (unlikely(cp->realize))
-		goto out;
-
-	if (unlikely(!cp->renegotiate && bw > cp->dedi_bw))
-		goto out;
-
-	if (isomgr.ops->isomgr_plat_reserve) {
-		ret = isomgr.ops->isomgr_plat_reserve(cp, bw,
-				(enum tegra_iso_client)client);
-		if (!ret)
-			goto out;
-	}
-
-	/* Look up MC's min freq that could satisfy requested BW and LT */
-	mf = mc_min_freq(ubw, ult);
-	/* Look up MC's dvfs latency at min freq */
-	dvfs_latency = mc_dvfs_latency(mf);
+	dvfs_latency = isomgr_do_reserve(cp, client, ubw, ult);
 
-	cp->lti = ult;		/* remember client spec'd LT (usec) */
-	cp->lto = dvfs_latency;	/* remember MC calculated LT (usec) */
-	cp->rsvd_mf = mf;	/* remember associated min freq */
-	cp->rsvd_bw = bw;
-out:
 	kref_put(&cp->kref, unregister_iso_client);
 	if (!isomgr_unlock()) {
 		pr_err("isomgr: %s failed for %s\n",
@@ -556,7 +577,6 @@ EXPORT_SYMBOL(tegra_isomgr_reserve);
 static u32 __tegra_isomgr_realize(tegra_isomgr_handle handle)
 {
 	u32 dvfs_latency = 0;
-	bool ret = 0;
 	struct isomgr_client *cp = (struct isomgr_client *) handle;
 	int client = cp - &isomgr_clients[0];
 
@@ -582,17 +602,8 @@ static u32 __tegra_isomgr_realize(tegra_isomgr_handle handle)
 
 	trace_tegra_isomgr_realize(handle, cname[client], "enter");
 
-	if (isomgr.ops->isomgr_plat_realize) {
-		ret = isomgr.ops->isomgr_plat_realize(cp);
-		if (!ret)
-			goto out;
-	}
-
-	dvfs_latency = (u32)cp->lto;
-	cp->realize = false;
-	update_mc_clock();
+	dvfs_latency = isomgr_do_realize(cp);
 
-out:
 	kref_put(&cp->kref, unregister_iso_client);
 	if (!isomgr_unlock()) {
 		pr_err("isomgr: %s failed for %s\n",
@@ -631,6 +642,96 @@ u32 tegra_isomgr_realize(tegra_isomgr_handle handle)
 }
 EXPORT_SYMBOL(tegra_isomgr_realize);
 
+static u32 __tegra_isomgr_reserve_realize(tegra_isomgr_handle handle,
+			 u32 ubw, u32 ult)
+{
+	u32 dvfs_latency = 0;
+	struct isomgr_client *cp = (struct isomgr_client *) handle;
+	int client = cp - &isomgr_clients[0];
+
+	VALIDATE_HANDLE();
+
+	/*
+	 * Fast path for the common case of a client, e.g. display on each
+	 * flip, re-applying the bw it already has. Nothing would change, so
+	 * don't queue up on isomgr.lock behind other clients' reservations.
+	 * The client's own fields are only changed by its own calls.
+	 */
+	if (READ_ONCE(cp->rsvd_bw) == ubw && READ_ONCE(cp->real_bw) == ubw &&
+	    READ_ONCE(cp->lti) == ult &&
+	    READ_ONCE(cp->rsvd_mf) == READ_ONCE(cp->real_mf) &&
+	    !READ_ONCE(cp->realize))
+		return READ_ONCE(cp->lto);
+
+	if (!isomgr_lock()) {
+		pr_err("isomgr: %s failed for %s\n",
+			__func__, cname[client]);
+		goto validation_fail;
+	}
+	if (unlikely(!OBJ_REF_INC_NOT_ZERO(&cp->kref.refcount)))
+		goto handle_unregistered;
+
+	trace_tegra_isomgr_reserve(handle, ubw, ult, cname[client], "enter");
+
+	if (cp->rsvd_bw != ubw || cp->lti != ult)
+		dvfs_latency = isomgr_do_reserve(cp, client, ubw, ult);
+	else
+		dvfs_latency = cp->lto;
+
+	if (dvfs_latency &&
+	    (cp->rsvd_bw != cp->real_bw || cp->rsvd_mf != cp->real_mf)) {
+		trace_tegra_isomgr_realize(handle, cname[client], "enter");
+		dvfs_latency = isomgr_do_realize(cp);
+		trace_tegra_isomgr_realize(handle, cname[client],
+			dvfs_latency ? "exit" : "real_fail_exit");
+	}
+
+	kref_put(&cp->kref, unregister_iso_client);
+	if (!isomgr_unlock()) {
+		pr_err("isomgr: %s failed for %s\n",
+			__func__, cname[client]);
+		goto validation_fail;
+	}
+	trace_tegra_isomgr_reserve(handle, ubw, ult, cname[client],
+		dvfs_latency ? "exit" : "rsrv_fail_exit");
+	return dvfs_latency;
+handle_unregistered:
+	if (!isomgr_unlock()) {
+		pr_err("isomgr: %s failed for %s\n",
+			__func__, cname[client]);
+		goto validation_fail;
+	}
+	trace_tegra_isomgr_reserve(handle, ubw, ult,
+		cname[client], "inv_handle_exit");
+	return dvfs_latency;
+validation_fail:
+	trace_tegra_isomgr_reserve(handle, ubw, ult, "unk", "inv_handle_exit");
+	return dvfs_latency;
+}
+
+/**
+ * tegra_isomgr_reserve_realize - reserve and realize bw for the ISO client.
+ *
+ * @handle	handle acquired during tegra_isomgr_register.
+ * @ubw		bandwidth in KBps.
+ * @ult		latency that can be tolerated by client in usec.
+ *
+ * Same as tegra_isomgr_reserve() followed by tegra_isomgr_realize(), but
+ * done under a single isomgr lock hold, and without taking the lock at all
+ * when the client already has this bw and latency realized.
+ *
+ * returns dvfs latency thresh in usec.
+ * return 0 indicates that reserve or realize failed.
+ */
+u32 tegra_isomgr_reserve_realize(tegra_isomgr_handle handle,
+			 u32 ubw, u32 ult)
+{
+	if (test_mode)
+		return 1;
+	return __tegra_isomgr_reserve_realize(handle, ubw, ult);
+}
+EXPORT_SYMBOL(tegra_isomgr_reserve_realize);
+
 static int __tegra_isomgr_set_margin(enum tegra_iso_client client,
 					u32 bw, bool wait)
 {
@@ -1099,6 +1200,13 @@ u32 test_tegra_isomgr_realize(tegra_isomgr_handle handle)
 }
 EXPORT_SYMBOL(test_tegra_isomgr_realize);
 
+u32 test_tegra_isomgr_reserve_realize(tegra_isomgr_handle handle,
+			 u32 bw, u32 lt)
+{
+	return __tegra_isomgr_reserve_realize(handle, bw, lt);
+}
+EXPORT_SYMBOL(test_tegra_isomgr_reserve_realize);
+
 int test_tegra_isomgr_set_margin(enum tegra_iso_client client,
 				u32 bw, bool wait)
 {
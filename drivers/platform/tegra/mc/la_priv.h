@@ -312,6 +312,7 @@ struct la_client_info {
 	unsigned int min_scaling_ratio;
 	unsigned int init_la;		/* initial la to set for client */
 	unsigned int la_set;
+	unsigned int la_relax;		/* added to la_set by adaptive LA */
 	unsigned int la_ref_clk_mhz;
 };
 
@@ -594,6 +595,11 @@ struct la_chip_specific {
 	struct la_to_dc_params la_params;
 	bool disable_disp_ptsa;
 	bool disable_bbc_ptsa;
+	bool adaptive_la;
+	unsigned int adaptive_margin_low;	/* % of FIFO */
+	unsigned int adaptive_margin_high;	/* % of FIFO */
+	unsigned int adaptive_step;		/* % of la_set per report */
+	unsigned int adaptive_max;		/* % of la_set */
 
 	void (*init_ptsa)(void);
 	void (*update_display_ptsa_rate)(unsigned int *disp_bw_array);
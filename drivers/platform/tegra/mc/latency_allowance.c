@@ -46,13 +46,24 @@
 #define HACK_LA_FIFO 1
 static int default_set_la(enum tegra_la_id id, unsigned int bw_mbps);
 
-static struct la_chip_specific cs;
+static struct la_chip_specific cs = {
+	.adaptive_margin_low = 25,
+	.adaptive_margin_high = 50,
+	.adaptive_step = 10,
+	.adaptive_max = 100,
+};
 module_param_named(disable_la, cs.disable_la, bool, S_IRUGO | S_IWUSR);
 module_param_named(disable_ptsa, cs.disable_ptsa, bool, S_IRUGO | S_IWUSR);
 module_param_named(disable_disp_ptsa,
 	cs.disable_disp_ptsa, bool, S_IRUGO | S_IWUSR);
 module_param_named(disable_bbc_ptsa,
 	cs.disable_bbc_ptsa, bool, S_IRUGO | S_IWUSR);
+module_param_named(adaptive_margin_low,
+	cs.adaptive_margin_low, uint, S_IRUGO | S_IWUSR);
+module_param_named(adaptive_margin_high,
+	cs.adaptive_margin_high, uint, S_IRUGO | S_IWUSR);
+module_param_named(adaptive_step, cs.adaptive_step, uint, S_IRUGO | S_IWUSR);
+module_param_named(adaptive_max, cs.adaptive_max, uint, S_IRUGO | S_IWUSR);
 
 #ifdef CONFIG_DEBUG_FS
 static int la_ptsa_debugfs_init(void);
@@ -170,11 +181,25 @@ static void program_scaled_la(struct la_client_info *ci, int la)
 		program_scaled_la_t21x(ci, la);
 }
 
-void program_la(struct la_client_info *ci, int la)
+/* call with cs.lock held. Programs la_set, relaxed by adaptive LA. */
+static void __program_la(struct la_client_info *ci)
 {
 	u32 reg_read;
 	u32 reg_write;
+	int la = min_t(int, ci->la_set + ci->la_relax, cs.la_max_value);
 
+	reg_read = mc_readl(ci->reg_addr);
+	reg_write = (reg_read & ~ci->mask) |
+			(la << ci->shift);
+	mc_writel(reg_write, ci->reg_addr);
+	la_debug("name=%s, reg_addr=0x%x, read=0x%x, write=0x%x\n", ci->name,
+		(u32)(uintptr_t)ci->reg_addr, (u32)reg_read, (u32)reg_write);
+
+	program_scaled_la(ci, la);
+}
+
+void program_la(struct la_client_info *ci, int la)
+{
 	if (la > cs.la_max_value) {
 		pr_err("la > cs.la_max_value\n");
 		WARN_ON(1);
@@ -182,18 +207,92 @@ void program_la(struct la_client_info *ci, int la)
 	}
 
 	spin_lock(&cs.lock);
-	reg_read = mc_readl(ci->reg_addr);
-	reg_write = (reg_read & ~ci->mask) |
-			(la << ci->shift);
-	mc_writel(reg_write, ci->reg_addr);
 	ci->la_set = la;
-	la_debug("name=%s, reg_addr=0x%x, read=0x%x, write=0x%x\n", ci->name,
-		(u32)(uintptr_t)ci->reg_addr, (u32)reg_read, (u32)reg_write);
+	ci->la_relax = min(ci->la_relax, la * cs.adaptive_max / 100);
+	__program_la(ci);
+	spin_unlock(&cs.lock);
+}
 
-	program_scaled_la(ci, la);
+/* Drop all adaptive LA relaxation, back to the computed LA values. */
+static void la_adaptive_reset(void)
+{
+	struct la_client_info *ci;
+	int i;
 
+	spin_lock(&cs.lock);
+	for (i = 0; i < cs.la_info_array_size; i++) {
+		ci = &cs.la_info_array[i];
+		if (!ci->la_relax)
+			continue;
+		ci->la_relax = 0;
+		__program_la(ci);
+	}
+	spin_unlock(&cs.lock);
+}
+
+/*
+ * Adaptive LA. The LA of ISO clients is computed for the worst case, so
+ * most of the time their FIFOs run well above the watermark, and MC gives
+ * them priority over non-ISO clients (GPU, DLA, ...) that they don't need.
+ *
+ * ISO client drivers report the lowest FIFO fullness they saw since their
+ * last report, as a % of the FIFO. While it stays at or above
+ * adaptive_margin_high, the client's LA is relaxed by adaptive_step % of
+ * its computed value per report, up to adaptive_max %. As soon as it
+ * drops below adaptive_margin_low, the computed LA is restored.
+ *
+ * Report 0 on a FIFO underflow. cs.lock is taken without disabling
+ * interrupts, so don't call this from interrupt context.
+ */
+int tegra_la_report_iso_margin(enum tegra_la_id id, unsigned int margin_pct)
+{
+	struct la_client_info *ci;
+	unsigned int relax, max_relax;
+
+	if (!cs.adaptive_la || !cs.la_info_array)
+		return 0;
+
+	VALIDATE_ID(id, &cs);
+	if (!is_display_client(id) && !is_camera_client(id))
+		return -EINVAL;
+
+	ci = &cs.la_info_array[cs.id_to_index[id]];
+
+	spin_lock(&cs.lock);
+	relax = ci->la_relax;
+	if (margin_pct < cs.adaptive_margin_low) {
+		relax = 0;
+	} else if (margin_pct >= cs.adaptive_margin_high) {
+		max_relax = ci->la_set * cs.adaptive_max / 100;
+		relax += max(ci->la_set * cs.adaptive_step / 100, 1U);
+		relax = min(relax, max_relax);
+	}
+
+	if (relax != ci->la_relax) {
+		ci->la_relax = relax;
+		__program_la(ci);
+	}
 	spin_unlock(&cs.lock);
+
+	return 0;
 }
+EXPORT_SYMBOL(tegra_la_report_iso_margin);
+
+static int adaptive_la_set(const char *val, const struct kernel_param *kp)
+{
+	int ret = param_set_bool(val, kp);
+
+	if (!ret && !cs.adaptive_la && cs.la_info_array)
+		la_adaptive_reset();
+	return ret;
+}
+
+static const struct kernel_param_ops adaptive_la_ops = {
+	.set = adaptive_la_set,
+	.get = param_get_bool,
+};
+module_param_cb(adaptive_la, &adaptive_la_ops, &cs.adaptive_la,
+	S_IRUGO | S_IWUSR);
 
 int la_suspend(void)
 {
@@ -202,7 +301,9 @@ int la_suspend(void)
 
 	/* stashing LA and PTSA from registers is necessary
 	 * in order to get latest values programmed by DVFS.
+	 * Adaptive LA is dropped first so that it isn't stashed too.
 	 */
+	la_adaptive_reset();
 	for (i = 0; i < cs.la_info_array_size; i++) {
 		ci = &cs.la_info_array[i];
 		ci->la_set = (mc_readl(ci->reg_addr) & ci->mask) >>
@@ -343,7 +444,13 @@ static int la_regs_show(struct seq_file *s, void *unused)
 	for (i = 0; i < cs.la_info_array_size - 1; i++) {
 		la = (mc_readl(cs.la_info_array[i].reg_addr) &
 			cs.la_info_array[i].mask) >> cs.la_info_array[i].shift;
-		seq_printf(s, "%-16s: %4lu\n", cs.la_info_array[i].name, la);
+		if (cs.la_info_array[i].la_relax)
+			seq_printf(s, "%-16s: %4lu (+%u adaptive)\n",
+				   cs.la_info_array[i].name, la,
+				   cs.la_info_array[i].la_relax);
+		else
+			seq_printf(s, "%-16s: %4lu\n",
+				   cs.la_info_array[i].name, la);
 	}
 
 	return 0;
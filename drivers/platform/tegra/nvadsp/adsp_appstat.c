@@ -0,0 +1,260 @@
+/*
+ * adsp_appstat.c
+ *
+ * ADSP per app load accounting
+ *
+ * Copyright (c) 2021, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ */
+
+#include <linux/debugfs.h>
+#include <linux/dma-mapping.h>
+#include <linux/math64.h>
+#include <linux/mutex.h>
+#include <linux/platform_device.h>
+#include <linux/seq_file.h>
+#include <linux/slab.h>
+#include <linux/workqueue.h>
+#include <linux/tegra_nvadsp.h>
+
+#include "dev.h"
+#include "adsp_shared_struct.h"
+
+#define CREATE_TRACE_POINTS
+#include <trace/events/nvadsp.h>
+
+#define RW_MODE (S_IWUSR | S_IRUSR)
+#define RO_MODE S_IRUSR
+
+/* attempts to read the page while ADSP OS is not updating it */
+#define APPSTAT_SNAPSHOT_RETRIES	4
+
+struct adsp_appstat {
+	struct device *dev;
+	struct nvadsp_os_args *os_args;
+	struct nvadsp_app_stats *page;
+	dma_addr_t page_addr;
+	struct delayed_work trace_work;
+	unsigned int trace_period_ms;
+	struct mutex lock;
+};
+
+static struct adsp_appstat appstat;
+
+static int adsp_appstat_snapshot(struct nvadsp_app_stats *snap)
+{
+	struct nvadsp_app_stats *page = appstat.page;
+	u32 seq;
+	int i;
+
+	if (READ_ONCE(page->magic) != NVADSP_APP_STATS_MAGIC)
+		return -ENODATA;
+
+	for (i = 0; i < APPSTAT_SNAPSHOT_RETRIES; i++) {
+		seq = READ_ONCE(page->seq);
+		if (seq & 1) {
+			cpu_relax();
+			continue;
+		}
+		rmb();
+		memcpy(snap, page, sizeof(*snap));
+		rmb();
+		if (READ_ONCE(page->seq) == seq)
+			break;
+	}
+
+	if (i == APPSTAT_SNAPSHOT_RETRIES)
+		return -EBUSY;
+
+	snap->num_apps = min_t(u32, snap->num_apps, NVADSP_APP_STATS_MAX);
+	return 0;
+}
+
+static u32 adsp_appstat_freq_mhz(void)
+{
+	return div_u64(appstat.os_args->adsp_freq_hz, 1000000);
+}
+
+static void adsp_appstat_trace_worker(struct work_struct *work)
+{
+	struct nvadsp_app_stats *snap;
+	u32 mcps = 0, peak_mcps = 0;
+	int i;
+
+	snap = kmalloc(sizeof(*snap), GFP_KERNEL);
+	if (!snap)
+		goto resched;
+
+	if (adsp_appstat_snapshot(snap))
+		goto free;
+
+	for (i = 0; i < snap->num_apps; i++) {
+		struct nvadsp_app_stats_entry *app = &snap->app[i];
+
+		app->name[NVADSP_APP_STATS_NAME_SZ - 1] = '\0';
+		trace_nvadsp_app_stats(app->name, app->cycles, app->mcps,
+				       app->peak_mcps, app->msgq_lat_us,
+				       app->msgq_lat_max_us);
+		mcps += app->mcps;
+		peak_mcps += app->peak_mcps;
+	}
+	trace_nvadsp_load(mcps, peak_mcps, adsp_appstat_freq_mhz());
+
+free:
+	kfree(snap);
+resched:
+	mutex_lock(&appstat.lock);
+	if (appstat.trace_period_ms)
+		schedule_delayed_work(&appstat.trace_work,
+			msecs_to_jiffies(appstat.trace_period_ms));
+	mutex_unlock(&appstat.lock);
+}
+
+static int apps_show(struct seq_file *s, void *data)
+{
+	struct nvadsp_app_stats *snap;
+	u32 mcps = 0, peak_mcps = 0, freq_mhz;
+	u64 busy;
+	int ret, i;
+
+	snap = kmalloc(sizeof(*snap), GFP_KERNEL);
+	if (!snap)
+		return -ENOMEM;
+
+	ret = adsp_appstat_snapshot(snap);
+	if (ret == -ENODATA) {
+		seq_puts(s, "not provided by ADSP OS\n");
+		ret = 0;
+		goto free;
+	} else if (ret) {
+		goto free;
+	}
+
+	seq_printf(s, "%-32s %16s %10s %6s %10s %12s %16s\n", "app",
+		   "cycles", "runs", "mcps", "peak_mcps", "msgq_lat_us",
+		   "msgq_lat_max_us");
+	for (i = 0; i < snap->num_apps; i++) {
+		struct nvadsp_app_stats_entry *app = &snap->app[i];
+
+		app->name[NVADSP_APP_STATS_NAME_SZ - 1] = '\0';
+		seq_printf(s, "%-32s %16llu %10u %6u %10u %12u %16u\n",
+			   app->name, app->cycles, app->runs, app->mcps,
+			   app->peak_mcps, app->msgq_lat_us,
+			   app->msgq_lat_max_us);
+		mcps += app->mcps;
+		peak_mcps += app->peak_mcps;
+	}
+
+	freq_mhz = adsp_appstat_freq_mhz();
+	busy = snap->total_cycles > snap->idle_cycles ?
+		snap->total_cycles - snap->idle_cycles : 0;
+
+	seq_printf(s, "\nperiod: %u ms\n", snap->period_ms);
+	seq_printf(s, "load: %llu%%\n", snap->total_cycles ?
+		   div64_u64(busy * 100, snap->total_cycles) : 0);
+	seq_printf(s, "mcps: %u, peak: %u, adsp freq: %u MHz\n",
+		   mcps, peak_mcps, freq_mhz);
+	/* what is left for more streams if all of them hit their peak */
+	seq_printf(s, "headroom: %d mcps\n", (int)freq_mhz - (int)peak_mcps);
+
+free:
+	kfree(snap);
+	return ret;
+}
+
+static int apps_open(struct inode *inode, struct file *file)
+{
+	return single_open(file, apps_show, inode->i_private);
+}
+
+static const struct file_operations apps_fops = {
+	.open = apps_open,
+	.read = seq_read,
+	.llseek = seq_lseek,
+	.release = single_release,
+};
+
+static int trace_period_get(void *data, u64 *val)
+{
+	*val = appstat.trace_period_ms;
+	return 0;
+}
+
+/* Period in ms of the nvadsp tracepoints, 0 to stop them */
+static int trace_period_set(void *data, u64 val)
+{
+	if (val > UINT_MAX)
+		return -EINVAL;
+
+	mutex_lock(&appstat.lock);
+	appstat.trace_period_ms = val;
+	if (val)
+		mod_delayed_work(system_wq, &appstat.trace_work, 0);
+	mutex_unlock(&appstat.lock);
+
+	return 0;
+}
+DEFINE_SIMPLE_ATTRIBUTE(trace_period_fops, trace_period_get,
+			trace_period_set, "%llu\n");
+
+static void adsp_appstat_debugfs_init(struct nvadsp_drv_data *drv)
+{
+	struct dentry *dir;
+
+	if (!drv->adsp_debugfs_root)
+		return;
+
+	dir = debugfs_create_dir("adsp_appstat", drv->adsp_debugfs_root);
+	if (!dir)
+		return;
+
+	if (!debugfs_create_file("apps", RO_MODE, dir, NULL, &apps_fops) ||
+	    !debugfs_create_file("trace_period_ms", RW_MODE, dir, NULL,
+				 &trace_period_fops)) {
+		dev_err(appstat.dev, "failed to create adsp_appstat debugfs\n");
+		debugfs_remove_recursive(dir);
+	}
+}
+
+/*
+ * Called each time the ADSP OS image is set up, to give it the stats page
+ * in os_args. The page is allocated on the first call.
+ */
+void adsp_appstat_setup(struct platform_device *pdev,
+			struct nvadsp_os_args *os_args)
+{
+	struct nvadsp_drv_data *drv = platform_get_drvdata(pdev);
+
+	BUILD_BUG_ON(sizeof(struct nvadsp_app_stats) > PAGE_SIZE);
+
+	if (!appstat.page) {
+		appstat.dev = &pdev->dev;
+		appstat.page = dmam_alloc_coherent(&pdev->dev, PAGE_SIZE,
+						   &appstat.page_addr,
+						   GFP_KERNEL);
+		if (!appstat.page) {
+			dev_err(&pdev->dev, "unable to allocate app stats\n");
+			return;
+		}
+
+		mutex_init(&appstat.lock);
+		INIT_DELAYED_WORK(&appstat.trace_work,
+				  adsp_appstat_trace_worker);
+		adsp_appstat_debugfs_init(drv);
+	}
+
+	/* stale stats of a previous ADSP OS boot */
+	memset(appstat.page, 0, PAGE_SIZE);
+
+	appstat.os_args = os_args;
+	os_args->app_stats_addr = appstat.page_addr;
+	os_args->app_stats_size = sizeof(struct nvadsp_app_stats);
+}
@@ -28,6 +28,7 @@
 #include <linux/sched/cputime.h>
 #endif
 #include <linux/slab.h>
+#include <linux/workqueue.h>
 
 #include "dev.h"
 #include "ape_actmon.h"
@@ -134,6 +135,12 @@ static struct device *device;
 
 static DEFINE_MUTEX(policy_mutex);
 
+/* Sum of the loads announced by the running streams, in kHz */
+static atomic_long_t hint_load = ATOMIC_LONG_INIT(0);
+
+static void adsp_dfs_hint_worker(struct work_struct *work);
+static DECLARE_WORK(hint_work, adsp_dfs_hint_worker);
+
 static bool is_os_running(struct device *dev)
 {
 	struct platform_device *pdev;
@@ -413,6 +420,40 @@ err_out:
 	return tfreq_hz / 1000;
 }
 
+/*
+ * Lowest freq(KHz) DFS may pick: the policy min, raised by the workload
+ * hints of the running streams. Called with policy_mutex held.
+ */
+static unsigned long policy_floor(void)
+{
+	unsigned long floor = max_t(unsigned long, policy->min,
+				    atomic_long_read(&hint_load));
+
+	return min(floor, policy->max);
+}
+
+static void adsp_dfs_hint_worker(struct work_struct *work)
+{
+	unsigned long floor, freq;
+
+	if (!policy || !is_os_running(device))
+		return;
+
+	mutex_lock(&policy_mutex);
+	if (!policy->enable)
+		goto exit_out;
+
+	/* only raise the freq, actmon brings it down once it is idle */
+	floor = policy_floor();
+	if (floor > policy->cur) {
+		freq = update_freq(floor);
+		if (freq)
+			policy->cur = freq;
+	}
+exit_out:
+	mutex_unlock(&policy_mutex);
+}
+
 /* Set adsp dfs policy min freq(Khz) */
 static int policy_min_set(void *data, u64 val)
 {
@@ -705,8 +746,8 @@ void adsp_cpu_set_rate(unsigned long freq)
 		goto exit_out;
 	}
 
-	if (freq < policy->min)
-		freq = policy->min;
+	if (freq < policy_floor())
+		freq = policy_floor();
 	else if (freq > policy->max)
 		freq = policy->max;
 
@@ -740,8 +781,8 @@ unsigned long adsp_override_freq(unsigned long req_freq_khz)
 
 	freq = req_freq_khz;
 
-	if (freq < policy->min)
-		freq = policy->min;
+	if (freq < policy_floor())
+		freq = policy_floor();
 	else if (freq > policy->max)
 		freq = policy->max;
 
@@ -790,6 +831,34 @@ void adsp_update_dfs_min_rate(unsigned long freq)
 }
 EXPORT_SYMBOL(adsp_update_dfs_min_rate);
 
+/*
+ * Announce the load of a stream starting on ADSP, so that the freq is
+ * raised before the stream runs instead of after actmon notices it.
+ * May be called from atomic context.
+ *
+ * @params:
+ * freq: load in KHz, i.e. MCPS * 1000
+ */
+void adsp_dfs_add_load(unsigned long freq)
+{
+	atomic_long_add(freq, &hint_load);
+	schedule_work(&hint_work);
+}
+EXPORT_SYMBOL(adsp_dfs_add_load);
+
+/*
+ * Withdraw a load added by adsp_dfs_add_load() when its stream stops.
+ * May be called from atomic context.
+ *
+ * @params:
+ * freq: load in KHz, as passed to adsp_dfs_add_load()
+ */
+void adsp_dfs_remove_load(unsigned long freq)
+{
+	atomic_long_sub(freq, &hint_load);
+}
+EXPORT_SYMBOL(adsp_dfs_remove_load);
+
 /* Enable / disable dynamic freq scaling */
 void adsp_update_dfs(bool val)
 {
@@ -871,6 +940,8 @@ int adsp_dfs_core_exit(struct platform_device *pdev)
 	if (!drv->dfs_initialized)
 		return -ENODEV;
 
+	cancel_work_sync(&hint_work);
+
 	ret = nvadsp_mbox_close(&policy->mbox);
 	if (ret)
 		dev_info(&pdev->dev,
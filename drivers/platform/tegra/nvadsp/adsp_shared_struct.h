@@ -129,7 +129,38 @@ struct nvadsp_os_args {
 	uint64_t	adsp_freq_hz;
 	uint32_t        dynamic_app_support;
 	uint32_t	chip_id;
-	char		reserved[120];
+	uint32_t	app_stats_addr; /* struct nvadsp_app_stats, 0 if none */
+	uint32_t	app_stats_size;
+	char		reserved[112];
+} __packed;
+
+/*
+ * ADSP per app load accounting, filled by ADSP OS in a page given by the
+ * host in os_args. An app instance is a plugin for the audio apps.
+ */
+#define NVADSP_APP_STATS_MAGIC		0x54415453 /* "STAT" */
+#define NVADSP_APP_STATS_MAX		32
+#define NVADSP_APP_STATS_NAME_SZ	32
+
+struct nvadsp_app_stats_entry {
+	char		name[NVADSP_APP_STATS_NAME_SZ];
+	uint64_t	cycles;		/* since the instance started */
+	uint32_t	runs;
+	uint32_t	mcps;		/* over the last period */
+	uint32_t	peak_mcps;
+	uint32_t	msgq_lat_us;	/* host queue to app dequeue, last */
+	uint32_t	msgq_lat_max_us;
+	uint32_t	reserved;
+} __packed;
+
+struct nvadsp_app_stats {
+	uint32_t	magic;		/* set by ADSP OS when it fills the page */
+	uint32_t	seq;		/* odd while ADSP OS updates the page */
+	uint32_t	num_apps;
+	uint32_t	period_ms;	/* mcps sampling period */
+	uint64_t	total_cycles;
+	uint64_t	idle_cycles;
+	struct nvadsp_app_stats_entry app[NVADSP_APP_STATS_MAX];
 } __packed;
 
 /* ARM MODE REGS */
@@ -24,6 +24,10 @@
 #include <linux/platform_device.h>
 #include <linux/firmware.h>
 #include <linux/kernel.h>
+#include <linux/crc32.h>
+#include <linux/list.h>
+#include <linux/mutex.h>
+#include <linux/vmalloc.h>
 
 #include "os.h"
 #include "dram_app_mem_manager.h"
@@ -849,6 +853,139 @@ struct adsp_module *load_adsp_static_module(const char *appname,
 	return mod;
 }
 
+/*
+ * Relocated images of the dynamic apps, kept after unload so that a
+ * reload of the same binary at the same address is a copy of the image
+ * instead of an ELF parse and relocation. The image is saved before the
+ * app runs, as ADSP writes to its data sections.
+ */
+#define ADSP_MODULE_CACHE_MAX	8
+
+struct adsp_module_cache {
+	struct list_head node;
+	char name[NVADSP_NAME_SZ];
+	u32 crc;
+	size_t fw_size;
+	uint32_t adsp_module_ptr;
+	size_t size;
+	struct app_mem_size mem_size;
+	void *image;
+};
+
+static LIST_HEAD(adsp_module_cache_list);
+static DEFINE_MUTEX(adsp_module_cache_lock);
+static int adsp_module_cache_num;
+
+static void adsp_module_cache_free(struct adsp_module_cache *entry)
+{
+	list_del(&entry->node);
+	adsp_module_cache_num--;
+	vfree(entry->image);
+	kfree(entry);
+}
+
+static struct adsp_module_cache *adsp_module_cache_find(const char *appname)
+{
+	struct adsp_module_cache *entry;
+
+	list_for_each_entry(entry, &adsp_module_cache_list, node) {
+		if (!strcmp(entry->name, appname))
+			return entry;
+	}
+	return NULL;
+}
+
+static void adsp_module_cache_add(struct adsp_module *mod, const char *appname,
+	const struct firmware *fw, u32 crc)
+{
+	struct adsp_module_cache *entry;
+
+	entry = kzalloc(sizeof(*entry), GFP_KERNEL);
+	if (!entry)
+		return;
+
+	entry->image = vmalloc(mod->size);
+	if (!entry->image) {
+		kfree(entry);
+		return;
+	}
+
+	strlcpy(entry->name, appname, NVADSP_NAME_SZ);
+	entry->crc = crc;
+	entry->fw_size = fw->size;
+	entry->adsp_module_ptr = mod->adsp_module_ptr;
+	entry->size = mod->size;
+	memcpy(&entry->mem_size, &mod->mem_size, sizeof(entry->mem_size));
+	memcpy(entry->image, mod->module_ptr, mod->size);
+
+	mutex_lock(&adsp_module_cache_lock);
+	if (adsp_module_cache_num >= ADSP_MODULE_CACHE_MAX)
+		adsp_module_cache_free(list_last_entry(&adsp_module_cache_list,
+			struct adsp_module_cache, node));
+	list_add(&entry->node, &adsp_module_cache_list);
+	adsp_module_cache_num++;
+	mutex_unlock(&adsp_module_cache_lock);
+}
+
+/* Returns the module if the cached image of the binary could be reused */
+static struct adsp_module *adsp_module_cache_load(const char *appname,
+	const struct firmware *fw, u32 crc, struct device *dev)
+{
+	struct adsp_module_cache *entry;
+	struct adsp_module *mod = NULL;
+
+	mutex_lock(&adsp_module_cache_lock);
+	entry = adsp_module_cache_find(appname);
+	if (!entry)
+		goto unlock;
+
+	if (entry->crc != crc || entry->fw_size != fw->size) {
+		/* binary was updated */
+		adsp_module_cache_free(entry);
+		goto unlock;
+	}
+
+	mod = kzalloc(sizeof(struct adsp_module), GFP_KERNEL);
+	if (!mod)
+		goto unlock;
+
+	mod->handle = dram_app_mem_request(appname, entry->size);
+	if (!mod->handle)
+		goto err_free_mod;
+
+	/* the image is only valid at the address it was relocated for */
+	if (dram_app_mem_get_address(mod->handle) != entry->adsp_module_ptr) {
+		dev_dbg(dev, "module %s moved, relocating again\n", appname);
+		dram_app_mem_release(mod->handle);
+		goto err_free_mod;
+	}
+
+	mod->name = appname;
+	mod->adsp_module_ptr = entry->adsp_module_ptr;
+	mod->size = entry->size;
+	mod->module_ptr = nvadsp_da_to_va_mappings(mod->adsp_module_ptr,
+			mod->size);
+	memcpy(mod->module_ptr, entry->image, mod->size);
+	memcpy((struct app_mem_size *)&mod->mem_size, &entry->mem_size,
+		sizeof(entry->mem_size));
+	mod->dynamic = true;
+
+	/* most recently used first */
+	list_move(&entry->node, &adsp_module_cache_list);
+	mutex_unlock(&adsp_module_cache_lock);
+
+	dev_info(dev, "module %s Load address %p 0x%x (cached)\n", appname,
+					mod->module_ptr, mod->adsp_module_ptr);
+	return mod;
+
+err_free_mod:
+	kfree(mod);
+	mod = NULL;
+unlock:
+	mutex_unlock(&adsp_module_cache_lock);
+	return mod;
+}
+
 struct adsp_module *load_adsp_dynamic_module(const char *appname,
 	const char *appfile, struct device *dev)
 {
@@ -862,6 +999,7 @@ struct adsp_module *load_adsp_dynamic_module(const char *appname,
 	struct elf32_shdr *aram_x_shdr;
 	struct app_mem_size *mem_size;
 	void *buf;
+	u32 crc;
 	int ret;
 
 	ret = request_firmware(&fw, appfile, dev);
@@ -872,6 +1010,13 @@ struct adsp_module *load_adsp_dynamic_module(const char *appname,
 		return ERR_PTR(ret);
 	}
 
+	crc = crc32_le(~0, fw->data, fw->size);
+	mod = adsp_module_cache_load(appname, fw, crc, dev);
+	if (mod) {
+		release_firmware(fw);
+		return mod;
+	}
+
 	buf = kzalloc(fw->size, GFP_KERNEL);
 	if (!buf)
 		goto release_firmware;
@@ -950,6 +1095,7 @@ struct adsp_module *load_adsp_dynamic_module(const char *appname,
 	}
 
 	mod->dynamic = true;
+	adsp_module_cache_add(mod, appname, fw, crc);
 
  error_free_memory:
 	kfree(buf);
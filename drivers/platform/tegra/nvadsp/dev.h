@@ -242,6 +242,12 @@ int adsp_cpustat_init(struct platform_device *pdev);
 int adsp_cpustat_exit(struct platform_device *pdev);
 #endif
 
+#ifdef CONFIG_TEGRA_ADSP_APPSTAT
+struct nvadsp_os_args;
+void adsp_appstat_setup(struct platform_device *pdev,
+			struct nvadsp_os_args *os_args);
+#endif
+
 #if defined(CONFIG_TEGRA_ADSP_FILEIO)
 int adspff_init(struct platform_device *pdev);
 void adspff_exit(void);
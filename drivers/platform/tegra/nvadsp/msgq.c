@@ -49,6 +49,42 @@ void msgq_init(msgq_t *msgq, int32_t size)
 	msgq->write_index = 0;
 }
 EXPORT_SYMBOL(msgq_init);
+/*
+ * Copies a message at write index wi, without publishing it. Returns the
+ * write index following the message or -ENOSPC.
+ */
+static int32_t msgq_copy_message(msgq_t *msgq, int32_t wi, int32_t ri,
+				 const msgq_message_t *message)
+{
+	bool wrap = ri <= wi;
+	int32_t *start = msgq->queue;
+	int32_t *end = &msgq->queue[msgq->size];
+	int32_t *first = &msgq->queue[wi];
+	int32_t *last = &msgq->queue[ri];
+	int32_t qremainder = wrap ? end - first : last - first;
+	int32_t qsize = wrap ? qremainder + (last - start) : qremainder;
+	int32_t msize = &message->payload[message->size] -
+		(int32_t *)message;
+
+	if (qsize <= msize) {
+		/* don't allow read == write */
+		pr_err("%s failed: msgq ri: %d, wi %d, msg size %d\n",
+			__func__, ri, wi, message->size);
+		return -ENOSPC;
+	}
+
+	if (msize < qremainder) {
+		msgq_wmemcpy(first, message, msize);
+		return wi + MSGQ_MESSAGE_HEADER_WSIZE + message->size;
+	}
+
+	/* message wrapped */
+	msgq_wmemcpy(first, message, qremainder);
+	msgq_wmemcpy(msgq->queue, (int32_t *)message + qremainder,
+		msize - qremainder);
+	return wi + MSGQ_MESSAGE_HEADER_WSIZE + message->size - msgq->size;
+}
+
 /**
  * msgq_queue_message - Queues a message in the queue
  * @msgq:           pointer to the client message queue
@@ -64,47 +100,63 @@ EXPORT_SYMBOL(msgq_init);
  */
 int32_t msgq_queue_message(msgq_t *msgq, const msgq_message_t *message)
 {
-	int32_t ret = 0;
+	int32_t ret = msgq_queue_messages(msgq, &message, 1);
 
-	if (msgq && message) {
-		int32_t ri = msgq->read_index;
-		int32_t wi = msgq->write_index;
-		bool wrap = ri <= wi;
-		int32_t *start = msgq->queue;
-		int32_t *end = &msgq->queue[msgq->size];
-		int32_t *first = &msgq->queue[wi];
-		int32_t *last = &msgq->queue[ri];
-		int32_t qremainder = wrap ? end - first : last - first;
-		int32_t qsize = wrap ? qremainder + (last - start) : qremainder;
-		int32_t msize = &message->payload[message->size] -
-			(int32_t *)message;
-
-		if (qsize <= msize) {
-			/* don't allow read == write */
-			pr_err("%s failed: msgq ri: %d, wi %d, msg size %d\n",
-				__func__, msgq->read_index,
-				msgq->write_index, message->size);
-			ret = -ENOSPC;
-		} else if (msize < qremainder) {
-			msgq_wmemcpy(first, message, msize);
-			msgq->write_index = wi + MSGQ_MESSAGE_HEADER_WSIZE +
-				message->size;
-		} else {
-			/* message wrapped */
-			msgq_wmemcpy(first, message, qremainder);
-			msgq_wmemcpy(msgq->queue, (int32_t *)message +
-				qremainder, msize - qremainder);
-			msgq->write_index = wi + MSGQ_MESSAGE_HEADER_WSIZE +
-				message->size - msgq->size;
+	return ret < 0 ? ret : 0;
+}
+EXPORT_SYMBOL(msgq_queue_message);
+/**
+ * msgq_queue_messages - Queues several messages in the queue
+ * @msgq:           pointer to the client message queue
+ * @messages:       Message buffers to copy from
+ * @count:          number of messages
+ *
+ * Messages are queued in order until one does not fit, and the write
+ * index is published once, so the receiver sees the whole batch with a
+ * single notification. Returns the number of messages queued or a
+ * negative error if none could be queued.
+ *
+ * The queue has a single producer and a single consumer, the ADSP or
+ * the CPU, and needs no lock between them: the payload is written
+ * before the write index and read before the read index moves.
+ */
+int32_t msgq_queue_messages(msgq_t *msgq, const msgq_message_t **messages,
+			    int32_t count)
+{
+	int32_t ri, wi, next, i;
+	int32_t err = -ENOSPC;
+
+	if (!msgq || !messages) {
+		pr_err("NULL: msgq %p messages %p\n", msgq, messages);
+		return -EFAULT; /* Bad Address */
+	}
+
+	ri = READ_ONCE(msgq->read_index);
+	wi = msgq->write_index;
+
+	for (i = 0; i < count; i++) {
+		if (!messages[i]) {
+			pr_err("NULL: msgq %p message %p\n", msgq, messages[i]);
+			err = -EFAULT; /* Bad Address */
+			break;
 		}
-	} else {
-		pr_err("NULL: msgq %p message %p\n", msgq, message);
-		ret = -EFAULT; /* Bad Address */
+
+		next = msgq_copy_message(msgq, wi, ri, messages[i]);
+		if (next < 0)
+			break;
+		wi = next;
 	}
 
-	return ret;
+	if (!i)
+		return count ? err : 0;
+
+	/* payload before the index that makes it visible */
+	wmb();
+	WRITE_ONCE(msgq->write_index, wi);
+
+	return i;
 }
-EXPORT_SYMBOL(msgq_queue_message);
+EXPORT_SYMBOL(msgq_queue_messages);
 /**
  * msgq_dequeue_message - Dequeues a message from the queue
  * @msgq:           pointer to the client message queue
@@ -132,7 +184,9 @@ int32_t msgq_dequeue_message(msgq_t *msgq, msgq_message_t *message)
 	}
 
 	ri = msgq->read_index;
-	wi = msgq->write_index;
+	wi = READ_ONCE(msgq->write_index);
+	/* index before the payload it covers */
+	rmb();
 	msg = (msgq_message_t *)&msgq->queue[msgq->read_index];
 
 	if (ri == wi) {
@@ -145,7 +199,9 @@ int32_t msgq_dequeue_message(msgq_t *msgq, msgq_message_t *message)
 	} else if (!message) {
 		/* no input buffer, discard top message */
 		ri += MSGQ_MESSAGE_HEADER_WSIZE + msg->size;
-		msgq->read_index = ri < msgq->size ? ri : ri - msgq->size;
+		mb();
+		WRITE_ONCE(msgq->read_index,
+			ri < msgq->size ? ri : ri - msgq->size);
 	} else if (message->size < msg->size) {
 		/* return buffer too small */
 		pr_err("%s failed: msgq ri: %d, wi %d, NO SPACE\n",
@@ -161,16 +217,18 @@ int32_t msgq_dequeue_message(msgq_t *msgq, msgq_message_t *message)
 
 		if (msize < qremainder) {
 			msgq_wmemcpy(message, first, msize);
-			msgq->read_index = ri + MSGQ_MESSAGE_HEADER_WSIZE +
-				msg->size;
+			ri += MSGQ_MESSAGE_HEADER_WSIZE + msg->size;
 		} else {
 			/* message wrapped */
 			msgq_wmemcpy(message, first, qremainder);
 			msgq_wmemcpy((int32_t *)message + qremainder,
 				msgq->queue, msize - qremainder);
-			msgq->read_index = ri + MSGQ_MESSAGE_HEADER_WSIZE +
-				msg->size - msgq->size;
+			ri += MSGQ_MESSAGE_HEADER_WSIZE + msg->size -
+				msgq->size;
 		}
+		/* done with the payload before the producer can reuse it */
+		mb();
+		WRITE_ONCE(msgq->read_index, ri);
 	}
 
 	return ret;
@@ -393,6 +393,19 @@ void nvadsp_free_coherent(size_t size, void *va, dma_addr_t da)
 }
 EXPORT_SYMBOL(nvadsp_free_coherent);
 
+/* Maps a buffer from nvadsp_alloc_coherent() to user space */
+int nvadsp_mmap_coherent(struct vm_area_struct *vma, void *va,
+			 dma_addr_t da, size_t size)
+{
+	if (!priv.pdev) {
+		pr_err("ADSP Driver is not initialized\n");
+		return -ENODEV;
+	}
+
+	return dma_mmap_coherent(&priv.pdev->dev, vma, va, da, size);
+}
+EXPORT_SYMBOL(nvadsp_mmap_coherent);
+
 struct elf32_shdr *
 nvadsp_get_section(const struct firmware *fw, char *sec_name)
 {
@@ -669,6 +682,10 @@ static void nvadsp_set_shared_mem(struct platform_device *pdev,
 	os_args = &shared_mem->os_args;
 	os_args->chip_id = chip_id;
 
+#ifdef CONFIG_TEGRA_ADSP_APPSTAT
+	adsp_appstat_setup(pdev, os_args);
+#endif
+
 	drv_data->shared_adsp_os_data = shared_mem;
 }
 
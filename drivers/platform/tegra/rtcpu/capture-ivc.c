@@ -19,6 +19,8 @@
 #include <linux/tegra-capture-ivc.h>
 
 #include <linux/completion.h>
+#include <linux/cpumask.h>
+#include <linux/kfifo.h>
 #include <linux/module.h>
 #include <linux/platform_device.h>
 #include <linux/of.h>
@@ -27,6 +29,7 @@
 #include <linux/tegra-ivc-bus.h>
 #include <linux/nospec.h>
 #include <linux/semaphore.h>
+#include <linux/workqueue.h>
 
 #include <asm/barrier.h>
 
@@ -47,6 +50,12 @@
 /* Timeout for acquiring channel-id */
 #define TIMEOUT_ACQUIRE_CHANNEL_ID 120
 
+/* Maximum number of contexts capture status callbacks are run from */
+#define MAX_DISPATCH_CTX 8
+
+/* Status messages buffered per dispatch context */
+#define DISPATCH_CTX_DEPTH 256
+
 struct tegra_capture_ivc_cb_ctx {
 	struct list_head node;
 	tegra_capture_ivc_cb_func cb_func;
@@ -54,6 +63,22 @@ struct tegra_capture_ivc_cb_ctx {
 	struct semaphore sem_ch;
 };
 
+struct tegra_capture_ivc;
+
+/*
+ * Status messages of a capture channel are always handed to the same
+ * dispatch context, which keeps them in order, while a slow callback only
+ * delays the channels sharing its context. The fifo has a single producer,
+ * the ivc worker, and a single consumer, the dispatch work.
+ */
+struct tegra_capture_ivc_dispatch {
+	struct tegra_capture_ivc *civc;
+	struct work_struct work;
+	DECLARE_KFIFO_PTR(fifo, struct CAPTURE_MSG);
+	bool stalled;
+	int cpu;
+};
+
 struct tegra_capture_ivc {
 	struct tegra_ivc_channel *chan;
 	struct mutex cb_ctx_lock;
@@ -63,6 +88,9 @@ struct tegra_capture_ivc {
 	struct tegra_capture_ivc_cb_ctx cb_ctx[TOTAL_CHANNELS];
 	spinlock_t avl_ctx_list_lock;
 	struct list_head avl_ctx_list;
+	struct workqueue_struct *dispatch_wq;
+	struct tegra_capture_ivc_dispatch *dispatch;
+	unsigned int num_dispatch;
 };
 
 /*
@@ -115,6 +143,49 @@ static int tegra_capture_ivc_tx(struct tegra_capture_ivc *civc,
 	return ret;
 }
 
+/*
+ * Write count messages of len bytes each under a single hold of the write
+ * lock. The IVC layer only notifies the remote end when the queue turns
+ * non-empty, so a batch written back to back costs a single doorbell
+ * unless RTCPU drains the queue while it is being filled.
+ */
+static int tegra_capture_ivc_tx_batch(struct tegra_capture_ivc *civc,
+				const void *req, size_t len, unsigned int count)
+{
+	struct tegra_ivc_channel *chan = civc->chan;
+	unsigned int i;
+	int ret;
+
+	if (WARN_ON(!chan->is_ready))
+		return -EIO;
+
+	ret = mutex_lock_interruptible(&civc->ivc_wr_lock);
+	if (unlikely(ret == -EINTR))
+		return -ERESTARTSYS;
+	if (unlikely(ret))
+		return ret;
+
+	for (i = 0; i < count; i++) {
+		ret = wait_event_interruptible(civc->write_q,
+					tegra_ivc_can_write(&chan->ivc));
+		if (unlikely(ret))
+			break;
+
+		ret = tegra_ivc_write(&chan->ivc,
+				(const u8 *)req + i * len, len);
+		if (unlikely(ret < 0))
+			break;
+	}
+
+	mutex_unlock(&civc->ivc_wr_lock);
+
+	if (unlikely(ret < 0))
+		dev_err(&chan->dev, "tegra_ivc_write: error %d\n", ret);
+
+	/* number of messages sent, or error if none was */
+	return (i > 0) ? (int)i : ret;
+}
+
 static struct tegra_capture_ivc *__scivc_control;
 static struct tegra_capture_ivc *__scivc_capture;
 static int tegra_capture_ivc_can_read(struct tegra_capture_ivc *civc)
@@ -162,6 +233,20 @@ int tegra_capture_ivc_capture_submit(const void *capture_desc, size_t len)
 }
 EXPORT_SYMBOL(tegra_capture_ivc_capture_submit);
 
+int tegra_capture_ivc_capture_submit_batch(const void *capture_descs,
+		size_t len, unsigned int count)
+{
+	if (WARN_ON(__scivc_capture == NULL))
+		return -ENODEV;
+
+	if (count == 0)
+		return 0;
+
+	return tegra_capture_ivc_tx_batch(__scivc_capture, capture_descs,
+			len, count);
+}
+EXPORT_SYMBOL(tegra_capture_ivc_capture_submit_batch);
+
 int tegra_capture_ivc_register_control_cb(
 		tegra_capture_ivc_cb_func control_resp_cb,
 		uint32_t *trans_id, const void *priv_context)
@@ -216,8 +301,9 @@ int tegra_capture_ivc_register_control_cb(
 	}
 
 	*trans_id = (uint32_t)ctx_id;
-	cb_ctx->cb_func = control_resp_cb;
 	cb_ctx->priv_context = priv_context;
+	/* pairs with the acquire in tegra_capture_ivc_invoke_cb() */
+	smp_store_release(&cb_ctx->cb_func, control_resp_cb);
 
 	mutex_unlock(&civc->cb_ctx_lock);
 
@@ -277,12 +363,13 @@ int tegra_capture_ivc_notify_chan_id(uint32_t chan_id, uint32_t trans_id)
 	}
 
 	/* Update cb_ctx index */
-	civc->cb_ctx[chan_id].cb_func = civc->cb_ctx[trans_id].cb_func;
 	civc->cb_ctx[chan_id].priv_context =
 			civc->cb_ctx[trans_id].priv_context;
+	smp_store_release(&civc->cb_ctx[chan_id].cb_func,
+			civc->cb_ctx[trans_id].cb_func);
 
 	/* Reset trans_id cb_ctx fields */
-	civc->cb_ctx[trans_id].cb_func = NULL;
+	WRITE_ONCE(civc->cb_ctx[trans_id].cb_func, NULL);
 	civc->cb_ctx[trans_id].priv_context = NULL;
 
 	mutex_unlock(&civc->cb_ctx_lock);
@@ -327,8 +414,9 @@ int tegra_capture_ivc_register_capture_cb(
 		goto fail;
 	}
 
-	civc->cb_ctx[chan_id].cb_func = capture_status_ind_cb;
 	civc->cb_ctx[chan_id].priv_context = priv_context;
+	smp_store_release(&civc->cb_ctx[chan_id].cb_func,
+			capture_status_ind_cb);
 	mutex_unlock(&civc->cb_ctx_lock);
 
 	return 0;
@@ -362,7 +450,7 @@ int tegra_capture_ivc_unregister_control_cb(uint32_t id)
 		return -EBADF;
 	}
 
-	civc->cb_ctx[id].cb_func = NULL;
+	WRITE_ONCE(civc->cb_ctx[id].cb_func, NULL);
 	civc->cb_ctx[id].priv_context = NULL;
 
 	mutex_unlock(&civc->cb_ctx_lock);
@@ -407,9 +495,17 @@ int tegra_capture_ivc_unregister_capture_cb(uint32_t chan_id)
 		return -EBADF;
 	}
 
-	civc->cb_ctx[chan_id].cb_func = NULL;
-	civc->cb_ctx[chan_id].priv_context = NULL;
+	WRITE_ONCE(civc->cb_ctx[chan_id].cb_func, NULL);
+
+	mutex_unlock(&civc->cb_ctx_lock);
+
+	/* wait for a callback that may still be running on its context */
+	if (civc->dispatch)
+		flush_work(&civc->dispatch[chan_id % civc->num_dispatch].work);
 
+	mutex_lock(&civc->cb_ctx_lock);
+	if (civc->cb_ctx[chan_id].cb_func == NULL)
+		civc->cb_ctx[chan_id].priv_context = NULL;
 	mutex_unlock(&civc->cb_ctx_lock);
 
 	tegra_ivc_channel_runtime_put(civc->chan);
@@ -418,6 +514,83 @@ int tegra_capture_ivc_unregister_capture_cb(uint32_t chan_id)
 }
 EXPORT_SYMBOL(tegra_capture_ivc_unregister_capture_cb);
 
+static void tegra_capture_ivc_invoke_cb(struct tegra_capture_ivc *civc,
+		uint32_t id, const void *msg)
+{
+	const struct tegra_capture_ivc_msg_header *header = msg;
+	tegra_capture_ivc_cb_func cb_func;
+
+	/* Lockless lookup, pairs with the release on registration */
+	cb_func = smp_load_acquire(&civc->cb_ctx[id].cb_func);
+
+	/* Check if callback function available */
+	if (unlikely(!cb_func)) {
+		dev_dbg(&civc->chan->dev, "No callback for id %u\n", id);
+		return;
+	}
+
+	/* WAR: Skip the callback if channel-id is 65, and msg-id is
+	 * greater than CAPTURE_CHANNEL_ISP_RELEASE_RESP. Channel id
+	 * 65 is used for csi and it is specific to v4l2.
+	 * TODO: Bug 200619454
+	 */
+	/* Invoke client callback.*/
+	if (header->msg_id >= CAPTURE_CHANNEL_ISP_RELEASE_RESP &&
+		id == CSI_TEMP_CHANNEL_ID) {
+		dev_err(&civc->chan->dev,
+			"No callback found for msg id: 0x%x",
+			header->msg_id);
+	} else {
+		cb_func(msg, civc->cb_ctx[id].priv_context);
+	}
+}
+
+static void tegra_capture_ivc_dispatch_worker(struct work_struct *work)
+{
+	struct tegra_capture_ivc_dispatch *dctx = container_of(work,
+			struct tegra_capture_ivc_dispatch, work);
+	struct tegra_capture_ivc *civc = dctx->civc;
+	struct CAPTURE_MSG msg;
+
+	while (kfifo_out(&dctx->fifo, &msg, 1) == 1)
+		tegra_capture_ivc_invoke_cb(civc,
+			array_index_nospec(msg.header.channel_id,
+				NUM_CAPTURE_CHANNELS), &msg);
+
+	/* The ivc worker stopped reading on our full fifo, restart it */
+	smp_mb();
+	if (READ_ONCE(dctx->stalled)) {
+		WRITE_ONCE(dctx->stalled, false);
+		schedule_work(&civc->work);
+	}
+}
+
+/*
+ * Queue a status message on the dispatch context of its channel. Returns
+ * false when the context is full, the message must then stay in the ivc
+ * until the context drained.
+ */
+static bool tegra_capture_ivc_dispatch(struct tegra_capture_ivc *civc,
+		uint32_t id, const void *msg)
+{
+	struct tegra_capture_ivc_dispatch *dctx =
+			&civc->dispatch[id % civc->num_dispatch];
+
+	if (unlikely(kfifo_is_full(&dctx->fifo))) {
+		WRITE_ONCE(dctx->stalled, true);
+		/* pairs with the barrier in the dispatch worker */
+		smp_mb();
+		if (kfifo_is_full(&dctx->fifo))
+			return false;
+		WRITE_ONCE(dctx->stalled, false);
+	}
+
+	kfifo_in(&dctx->fifo, (const struct CAPTURE_MSG *)msg, 1);
+	queue_work_on(dctx->cpu, civc->dispatch_wq, &dctx->work);
+
+	return true;
+}
+
 static void tegra_capture_ivc_worker(struct work_struct *work)
 {
 	struct tegra_capture_ivc *civc = container_of(work,
@@ -437,32 +610,75 @@ static void tegra_capture_ivc_worker(struct work_struct *work)
 
 		id = array_index_nospec(id, TOTAL_CHANNELS);
 
-		/* Check if callback function available */
-		if (unlikely(!civc->cb_ctx[id].cb_func)) {
-			dev_dbg(&chan->dev, "No callback for id %u\n", id);
-			goto skip;
-		}
-
-		/* WAR: Skip the callback if channel-id is 65, and msg-id is
-		 * greater than CAPTURE_CHANNEL_ISP_RELEASE_RESP. Channel id
-		 * 65 is used for csi and it is specific to v4l2.
-		 * TODO: Bug 200619454
-		 */
-		/* Invoke client callback.*/
-		if (msg->header.msg_id >= CAPTURE_CHANNEL_ISP_RELEASE_RESP &&
-			id == CSI_TEMP_CHANNEL_ID) {
-			dev_err(&chan->dev,
-				"No callback found for msg id: 0x%x",
-				msg->header.msg_id);
+		if (civc->dispatch && id < NUM_CAPTURE_CHANNELS) {
+			if (!tegra_capture_ivc_dispatch(civc, id, msg))
+				break;
 		} else {
-			civc->cb_ctx[id].cb_func(msg,
-				civc->cb_ctx[id].priv_context);
+			tegra_capture_ivc_invoke_cb(civc, id, msg);
 		}
 skip:
 		tegra_ivc_read_advance(&chan->ivc);
 	}
 }
 
+static int tegra_capture_ivc_dispatch_init(struct tegra_capture_ivc *civc)
+{
+	struct device *dev = &civc->chan->dev;
+	unsigned int i;
+	int ret;
+
+	civc->num_dispatch = min_t(unsigned int, num_online_cpus(),
+			MAX_DISPATCH_CTX);
+
+	civc->dispatch = devm_kcalloc(dev, civc->num_dispatch,
+			sizeof(*civc->dispatch), GFP_KERNEL);
+	if (unlikely(civc->dispatch == NULL))
+		return -ENOMEM;
+
+	civc->dispatch_wq = alloc_workqueue("capture-ivc", WQ_HIGHPRI, 0);
+	if (unlikely(civc->dispatch_wq == NULL))
+		return -ENOMEM;
+
+	for (i = 0; i < civc->num_dispatch; i++) {
+		struct tegra_capture_ivc_dispatch *dctx = &civc->dispatch[i];
+
+		ret = kfifo_alloc(&dctx->fifo, DISPATCH_CTX_DEPTH,
+				GFP_KERNEL);
+		if (unlikely(ret))
+			goto fail;
+
+		dctx->civc = civc;
+		dctx->cpu = cpumask_local_spread(i, dev_to_node(dev));
+		INIT_WORK(&dctx->work, tegra_capture_ivc_dispatch_worker);
+	}
+
+	return 0;
+
+fail:
+	while (i--)
+		kfifo_free(&civc->dispatch[i].fifo);
+	destroy_workqueue(civc->dispatch_wq);
+	civc->dispatch = NULL;
+
+	return ret;
+}
+
+static void tegra_capture_ivc_dispatch_deinit(struct tegra_capture_ivc *civc)
+{
+	unsigned int i;
+
+	if (civc->dispatch == NULL)
+		return;
+
+	for (i = 0; i < civc->num_dispatch; i++) {
+		cancel_work_sync(&civc->dispatch[i].work);
+		kfifo_free(&civc->dispatch[i].fifo);
+	}
+
+	destroy_workqueue(civc->dispatch_wq);
+	civc->dispatch = NULL;
+}
+
 static void tegra_capture_ivc_notify(struct tegra_ivc_channel *chan)
 {
 	struct tegra_capture_ivc *civc = tegra_ivc_channel_get_drvdata(chan);
@@ -524,6 +740,12 @@ static int tegra_capture_ivc_probe(struct tegra_ivc_channel *chan)
 	} else if (!strcmp("capture", service)) {
 		if (WARN_ON(__scivc_capture != NULL))
 			return -EEXIST;
+		/* status callbacks run per channel group, off the ivc worker */
+		ret = tegra_capture_ivc_dispatch_init(civc);
+		if (unlikely(ret)) {
+			dev_err(dev, "failed to init dispatch: %d\n", ret);
+			return ret;
+		}
 		__scivc_capture = civc;
 	} else {
 		dev_err(dev, "Unknown ivc channel %s\n", service);
@@ -537,6 +759,9 @@ static void tegra_capture_ivc_remove(struct tegra_ivc_channel *chan)
 {
 	struct tegra_capture_ivc *civc = tegra_ivc_channel_get_drvdata(chan);
 
+	cancel_work_sync(&civc->work);
+	tegra_capture_ivc_dispatch_deinit(civc);
+	/* a stalled dispatch context may have restarted the ivc worker */
 	cancel_work_sync(&civc->work);
 
 	if (__scivc_control == civc)
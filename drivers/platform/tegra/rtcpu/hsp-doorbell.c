@@ -72,8 +72,17 @@ static int tegra_hsp_doorbell_probe(struct device *dev)
 		goto error;
 
 	/* Register for notifications from remote processor */
-	ret = tegra_hsp_db_add_handler(db->master, tegra_hsp_doorbell_notify,
-					dev);
+	if (of_property_read_bool(dev->of_node, NV(hsp-doorbell-threaded))) {
+		u32 cpu;
+
+		if (of_property_read_u32(dev->of_node, NV(hsp-doorbell-cpu),
+					&cpu))
+			cpu = -1;
+		ret = tegra_hsp_db_add_threaded_handler(db->master,
+					tegra_hsp_doorbell_notify, dev, cpu);
+	} else
+		ret = tegra_hsp_db_add_handler(db->master,
+					tegra_hsp_doorbell_notify, dev);
 	if (ret) {
 		dev_err(dev, "HSP doorbell %s error: %d\n", "register", ret);
 		goto error2;
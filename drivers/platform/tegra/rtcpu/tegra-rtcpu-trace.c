@@ -23,6 +23,8 @@
 #include <linux/ioport.h>
 #include <linux/jiffies.h>
 #include <linux/kernel.h>
+#include <linux/miscdevice.h>
+#include <linux/mm.h>
 #include <linux/module.h>
 #include <linux/of.h>
 #include <linux/of_address.h>
@@ -34,6 +36,7 @@
 #include <linux/tegra-rtcpu-trace.h>
 #include <linux/workqueue.h>
 #include <linux/platform_device.h>
+#include <linux/poll.h>
 #include <linux/nvhost.h>
 #include <asm/cacheflush.h>
 
@@ -98,6 +101,11 @@ struct tegra_rtcpu_trace {
 	/* debugfs */
 	struct dentry *debugfs_root;
 
+	/* raw export, events are not converted while it is open */
+	struct miscdevice raw_dev;
+	atomic_t raw_users;
+	wait_queue_head_t raw_wq;
+
 	/* eventlib */
 	struct platform_device *vi_platform_device;
 	struct platform_device *isp_platform_device;
@@ -1035,6 +1043,18 @@ static inline void rtcpu_trace_events(struct tegra_rtcpu_trace *tracer)
 				CAMRTC_TRACE_EVENT_SIZE,
 				tracer->event_entries);
 
+	/* raw readers parse the mmapped events themselves */
+	if (atomic_read(&tracer->raw_users) > 0) {
+		tracer->n_events += (new_next + tracer->event_entries - old_next)
+			% tracer->event_entries;
+		last_event = &tracer->events[new_next ? new_next - 1 :
+			tracer->event_entries - 1];
+		tracer->event_last_idx = new_next;
+		tracer->copy_last_event = *last_event;
+		wake_up_interruptible(&tracer->raw_wq);
+		return;
+	}
+
 	/* pull events */
 	while (old_next != new_next) {
 		event = &tracer->events[old_next];
@@ -1069,6 +1089,19 @@ void tegra_rtcpu_trace_flush(struct tegra_rtcpu_trace *tracer)
 }
 EXPORT_SYMBOL(tegra_rtcpu_trace_flush);
 
+/*
+ * Run the worker now instead of at the next poll interval. Can be called
+ * from the RTCPU mailbox interrupt.
+ */
+void tegra_rtcpu_trace_kick(struct tegra_rtcpu_trace *tracer)
+{
+	if (tracer == NULL)
+		return;
+
+	mod_delayed_work(system_wq, &tracer->work, 0);
+}
+EXPORT_SYMBOL(tegra_rtcpu_trace_kick);
+
 static void rtcpu_trace_worker(struct work_struct *work)
 {
 	struct tegra_rtcpu_trace *tracer;
@@ -1204,6 +1237,120 @@ failed_create:
 	debugfs_remove_recursive(tracer->debugfs_root);
 }
 
+/*
+ * Raw export
+ *
+ * The trace memory, header included, is mapped read-only to user space.
+ * Readers follow event_next_idx in the header and poll() for new events.
+ */
+
+struct rtcpu_trace_raw_file {
+	struct tegra_rtcpu_trace *tracer;
+	u64 n_events;
+};
+
+static int rtcpu_trace_raw_open(struct inode *inode, struct file *file)
+{
+	struct tegra_rtcpu_trace *tracer = container_of(file->private_data,
+		struct tegra_rtcpu_trace, raw_dev);
+	struct rtcpu_trace_raw_file *raw;
+
+	raw = kzalloc(sizeof(*raw), GFP_KERNEL);
+	if (raw == NULL)
+		return -ENOMEM;
+
+	raw->tracer = tracer;
+	raw->n_events = tracer->n_events;
+	file->private_data = raw;
+
+	atomic_inc(&tracer->raw_users);
+
+	return nonseekable_open(inode, file);
+}
+
+static int rtcpu_trace_raw_release(struct inode *inode, struct file *file)
+{
+	struct rtcpu_trace_raw_file *raw = file->private_data;
+
+	atomic_dec(&raw->tracer->raw_users);
+	kfree(raw);
+
+	return 0;
+}
+
+static int rtcpu_trace_raw_mmap(struct file *file, struct vm_area_struct *vma)
+{
+	struct rtcpu_trace_raw_file *raw = file->private_data;
+	struct tegra_rtcpu_trace *tracer = raw->tracer;
+
+	if (vma->vm_flags & VM_WRITE)
+		return -EPERM;
+
+	vma->vm_flags &= ~VM_MAYWRITE;
+
+	return dma_mmap_coherent(tracer->dev, vma, tracer->trace_memory,
+			tracer->dma_handle, tracer->trace_memory_size);
+}
+
+static unsigned int rtcpu_trace_raw_poll(struct file *file,
+	struct poll_table_struct *wait)
+{
+	struct rtcpu_trace_raw_file *raw = file->private_data;
+	struct tegra_rtcpu_trace *tracer = raw->tracer;
+	u64 n_events;
+
+	poll_wait(file, &tracer->raw_wq, wait);
+
+	n_events = READ_ONCE(tracer->n_events);
+	if (n_events == raw->n_events)
+		return 0;
+
+	raw->n_events = n_events;
+
+	return POLLIN | POLLRDNORM;
+}
+
+static const struct file_operations rtcpu_trace_raw_fops = {
+	.owner = THIS_MODULE,
+	.open = rtcpu_trace_raw_open,
+	.release = rtcpu_trace_raw_release,
+	.mmap = rtcpu_trace_raw_mmap,
+	.poll = rtcpu_trace_raw_poll,
+	.llseek = no_llseek,
+};
+
+static void rtcpu_trace_raw_init(struct tegra_rtcpu_trace *tracer)
+{
+	int ret;
+
+	atomic_set(&tracer->raw_users, 0);
+	init_waitqueue_head(&tracer->raw_wq);
+
+	tracer->raw_dev.minor = MISC_DYNAMIC_MINOR;
+	tracer->raw_dev.fops = &rtcpu_trace_raw_fops;
+	tracer->raw_dev.name = kasprintf(GFP_KERNEL, "rtcpu-trace-%s",
+					 dev_name(tracer->dev));
+	if (tracer->raw_dev.name == NULL)
+		return;
+
+	/* tracepoints still work without it */
+	ret = misc_register(&tracer->raw_dev);
+	if (ret) {
+		dev_warn(tracer->dev, "raw trace export disabled: %d\n", ret);
+		kfree(tracer->raw_dev.name);
+		tracer->raw_dev.name = NULL;
+	}
+}
+
+static void rtcpu_trace_raw_deinit(struct tegra_rtcpu_trace *tracer)
+{
+	if (tracer->raw_dev.name == NULL)
+		return;
+
+	misc_deregister(&tracer->raw_dev);
+	kfree(tracer->raw_dev.name);
+}
+
 /*
  * Init/Cleanup
  */
@@ -1236,6 +1383,9 @@ struct tegra_rtcpu_trace *tegra_rtcpu_trace_create(struct device *dev,
 	/* Debugfs */
 	rtcpu_trace_debugfs_init(tracer);
 
+	/* Raw export */
+	rtcpu_trace_raw_init(tracer);
+
 #ifdef CONFIG_EVENTLIB
 	if (camera_devices != NULL) {
 		/* Eventlib */
@@ -1300,6 +1450,7 @@ void tegra_rtcpu_trace_destroy(struct tegra_rtcpu_trace *tracer)
 	of_node_put(tracer->of_node);
 	cancel_delayed_work_sync(&tracer->work);
 	flush_delayed_work(&tracer->work);
+	rtcpu_trace_raw_deinit(tracer);
 	rtcpu_trace_debugfs_deinit(tracer);
 	dma_free_coherent(tracer->dev, tracer->trace_memory_size,
 			tracer->trace_memory, tracer->dma_handle);
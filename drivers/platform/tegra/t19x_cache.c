@@ -27,6 +27,8 @@
 #include <uapi/linux/tegra_l3_cache.h>
 #include <soc/tegra/chip-id.h>
 #include <linux/delay.h>
+#include <linux/mutex.h>
+#include <linux/capability.h>
 
 #define MASK GENMASK(15, 12)
 #define T19x_CACHE_STR	"l3_cache"
@@ -49,6 +51,9 @@ struct cache_drv_data {
 
 static struct cache_drv_data *cache_data;
 
+/* serializes the updates of the L3 partition and of its cached copy */
+static DEFINE_MUTEX(l3_ways_lock);
+
 
 int t19x_flush_cache_all(void)
 {
@@ -257,15 +262,44 @@ static int t19x_set_l3_cache_ways(u32 gpu_cpu_ways, u32 gpu_only_ways)
 		return -ENODEV;
 	}
 
+	cache_data->ioctl_data.igpu_cpu_ways = gpu_cpu_ways;
+	cache_data->ioctl_data.igpu_only_ways =
+		gpu_only_ways >> CCPLEX_CC_GPU_ONLY_BITS_SHIFT;
+
 	return 0;
 }
 
+/* keeps the ways not set by the caller, pass U32_MAX for those */
+static int t19x_update_l3_cache_ways(u32 gpu_cpu_ways, u32 gpu_only_ways)
+{
+	struct device *dev = &cache_data->pdev->dev;
+	int ret;
+
+	if (is_tegra_hypervisor_mode())
+		return -EPERM;
+
+	mutex_lock(&l3_ways_lock);
+	ret = t19x_extract_l3_cache_ways(dev);
+	if (!ret) {
+		if (gpu_cpu_ways == U32_MAX)
+			gpu_cpu_ways = cache_data->ioctl_data.igpu_cpu_ways;
+		if (gpu_only_ways == U32_MAX)
+			gpu_only_ways = cache_data->ioctl_data.igpu_only_ways;
+		ret = t19x_set_l3_cache_ways(gpu_cpu_ways, gpu_only_ways);
+	}
+	mutex_unlock(&l3_ways_lock);
+
+	return ret;
+}
+
 static ssize_t gpu_only_ways_show(struct device *device,
 				struct device_attribute *attr, char *buf)
 {
 	struct cache_drv_data *pdata;
 
+	mutex_lock(&l3_ways_lock);
 	t19x_extract_l3_cache_ways(device);
+	mutex_unlock(&l3_ways_lock);
 
 	pdata = dev_get_drvdata(device);
 
@@ -276,22 +310,15 @@ static ssize_t gpu_only_ways_store(struct device *device,
 				struct device_attribute *attr, const char *buf,
 				size_t count)
 {
-	struct cache_drv_data *pdata;
 	u32 new_gpu_only_ways;
-	u32 gpu_cpu_ways;
-
-	if (is_tegra_hypervisor_mode())
-		return -EPERM;
+	int ret;
 
 	if (kstrtou32(buf, 0, &new_gpu_only_ways) < 0)
 		return -EINVAL;
 
-	t19x_extract_l3_cache_ways(device);
-	pdata = dev_get_drvdata(device);
-	gpu_cpu_ways = pdata->ioctl_data.igpu_cpu_ways;
-	t19x_set_l3_cache_ways(gpu_cpu_ways, new_gpu_only_ways);
+	ret = t19x_update_l3_cache_ways(U32_MAX, new_gpu_only_ways);
 
-	return count;
+	return ret ? ret : count;
 }
 
 static ssize_t gpu_cpu_ways_show(struct device *device,
@@ -299,7 +326,9 @@ static ssize_t gpu_cpu_ways_show(struct device *device,
 {
 	struct cache_drv_data *pdata;
 
+	mutex_lock(&l3_ways_lock);
 	t19x_extract_l3_cache_ways(device);
+	mutex_unlock(&l3_ways_lock);
 
 	pdata = dev_get_drvdata(device);
 
@@ -310,22 +339,15 @@ static ssize_t gpu_cpu_ways_store(struct device *device,
 				struct device_attribute *attr, const char *buf,
 				size_t count)
 {
-	struct cache_drv_data *pdata;
 	u32 new_gpu_cpu_ways;
-	u32 gpu_only_ways;
-
-	if (is_tegra_hypervisor_mode())
-		return -EPERM;
+	int ret;
 
 	if (kstrtou32(buf, 0, &new_gpu_cpu_ways) < 0)
 		return -EINVAL;
 
-	t19x_extract_l3_cache_ways(device);
-	pdata = dev_get_drvdata(device);
-	gpu_only_ways = pdata->ioctl_data.igpu_only_ways;
-	t19x_set_l3_cache_ways(new_gpu_cpu_ways, gpu_only_ways);
+	ret = t19x_update_l3_cache_ways(new_gpu_cpu_ways, U32_MAX);
 
-	return count;
+	return ret ? ret : count;
 }
 
 static DEVICE_ATTR(l3_gpu_only_ways, 0644,
@@ -430,12 +452,30 @@ static int get_l3_data(void *arg)
 	struct tegra_l3_ioctl_data *in_data =
 			(struct tegra_l3_ioctl_data *)arg;
 
+	mutex_lock(&l3_ways_lock);
 	memcpy(in_data, &cache_data->ioctl_data,
 		sizeof(struct tegra_l3_ioctl_data));
+	mutex_unlock(&l3_ways_lock);
 
 	return 0;
 }
 
+/*
+ * Both way counts in one go, e.g. for a real-time task to take ways from
+ * the GPU for as long as it runs and give them back afterwards
+ */
+static int set_l3_ways(void *arg)
+{
+	struct tegra_l3_ioctl_data *in_data =
+			(struct tegra_l3_ioctl_data *)arg;
+
+	if (!capable(CAP_SYS_ADMIN))
+		return -EPERM;
+
+	return t19x_update_l3_cache_ways(in_data->igpu_cpu_ways,
+					 in_data->igpu_only_ways);
+}
+
 static long t19x_cache_ioctl(struct file *filp, unsigned int cmd,
 		unsigned long arg)
 {
@@ -468,6 +508,9 @@ static long t19x_cache_ioctl(struct file *filp, unsigned int cmd,
 	case TEGRA_L3_CACHE_GET_IOCTL_DATA:
 		err = get_l3_data(buf);
 		break;
+	case TEGRA_L3_CACHE_SET_WAYS:
+		err = set_l3_ways(buf);
+		break;
 	default:
 		dev_err(dev, "Unknown NVMAP_IOC = 0x%x\n", cmd);
 		return -ENOIOCTLCMD;
@@ -491,20 +534,10 @@ static int get_gpu_cpu_ways(void *data, u64 *val)
 
 static int set_gpu_cpu_ways(void *data, u64 val)
 {
-	u32 igpu_cpu_ways = (u32)val;
-	int ret = 0;
-
-	if (is_tegra_hypervisor_mode())
-		return -EPERM;
-
-	if (igpu_cpu_ways != cache_data->ioctl_data.igpu_cpu_ways) {
-		ret = t19x_set_l3_cache_ways(igpu_cpu_ways,
-				cache_data->ioctl_data.igpu_only_ways);
-		if (!ret)
-			cache_data->ioctl_data.igpu_cpu_ways = igpu_cpu_ways;
-	}
+	if (val >= U32_MAX)
+		return -EINVAL;
 
-	return ret;
+	return t19x_update_l3_cache_ways(val, U32_MAX);
 }
 DEFINE_SIMPLE_ATTRIBUTE(gpu_cpu_ways_ops, get_gpu_cpu_ways, set_gpu_cpu_ways,
 	"%llu\n");
@@ -517,20 +550,10 @@ static int get_gpu_only_ways(void *data, u64 *val)
 
 static int set_gpu_only_ways(void *data, u64 val)
 {
-	u32 igpu_only_ways = (u32)val;
-	int ret = 0;
-
-	if (is_tegra_hypervisor_mode())
-		return -EPERM;
-
-	if (igpu_only_ways != cache_data->ioctl_data.igpu_only_ways) {
-		ret = t19x_set_l3_cache_ways(
-			cache_data->ioctl_data.igpu_cpu_ways, igpu_only_ways);
-		if (!ret)
-			cache_data->ioctl_data.igpu_only_ways = igpu_only_ways;
-	}
+	if (val >= U32_MAX)
+		return -EINVAL;
 
-	return ret;
+	return t19x_update_l3_cache_ways(U32_MAX, val);
 }
 DEFINE_SIMPLE_ATTRIBUTE(gpu_only_ways_ops, get_gpu_only_ways, set_gpu_only_ways,
 	"%llu\n");
@@ -11,20 +11,25 @@
  * more details.
  */
 
+#include <linux/completion.h>
 #include <linux/device.h>
 #include <linux/mailbox_client.h>
 #include <linux/module.h>
 #include <linux/of.h>
 #include <linux/platform_device.h>
 #include <linux/tegra-aon.h>
+#include <linux/platform/tegra/perf_selftest.h>
 
 #define TX_BLOCK_PERIOD	100
+#define ECHO_TIMEOUT_MS	100
 
 struct tegra_aon_ivc_echo_data {
 	struct mbox_client cl;
 	struct mbox_chan *mbox;
 	u32 frame_size;
 	char *rx_data;
+	struct completion rx_done;
+	struct tegra_perf_test perf;
 };
 
 static ssize_t tegra_aon_ivc_echo_show(struct device *dev,
@@ -70,6 +75,32 @@ static void tegra_aon_ivc_echo_rx(struct mbox_client *cl, void *data)
 					struct tegra_aon_ivc_echo_data,
 					cl);
 	memcpy(drvdata->rx_data, msg->data, drvdata->frame_size);
+	complete(&drvdata->rx_done);
+}
+
+/* Round trip of a full frame through the AON echo service */
+static int tegra_aon_ivc_echo_perf_run(struct tegra_perf_test *test,
+				       u64 *ns, u64 *bytes)
+{
+	struct tegra_aon_ivc_echo_data *drvdata = container_of(test,
+					struct tegra_aon_ivc_echo_data,
+					perf);
+	struct tegra_aon_mbox_msg msg;
+	int ret;
+
+	reinit_completion(&drvdata->rx_done);
+	msg.length = drvdata->frame_size;
+	msg.data = drvdata->rx_data;
+	ret = mbox_send_message(drvdata->mbox, (void *)&msg);
+	if (ret < 0)
+		return ret;
+
+	if (!wait_for_completion_timeout(&drvdata->rx_done,
+					 msecs_to_jiffies(ECHO_TIMEOUT_MS)))
+		return -ETIMEDOUT;
+
+	*bytes += 2 * drvdata->frame_size;
+	return 0;
 }
 
 static int tegra_aon_ivc_echo_probe(struct platform_device *pdev)
@@ -87,6 +118,7 @@ static int tegra_aon_ivc_echo_probe(struct platform_device *pdev)
 	drvdata->cl.tx_tout = TX_BLOCK_PERIOD;
 	drvdata->cl.knows_txdone = false;
 	drvdata->cl.rx_callback = tegra_aon_ivc_echo_rx;
+	init_completion(&drvdata->rx_done);
 	drvdata->mbox = mbox_request_channel(&drvdata->cl, 0);
 	if (IS_ERR(drvdata->mbox)) {
 		ret = PTR_ERR(drvdata->mbox);
@@ -115,6 +147,10 @@ static int tegra_aon_ivc_echo_probe(struct platform_device *pdev)
 		goto out;
 	}
 
+	drvdata->perf.name = "aon_ivc_echo";
+	drvdata->perf.run = tegra_aon_ivc_echo_perf_run;
+	tegra_perf_test_register(&drvdata->perf);
+
 	return ret;
 out:
 	mbox_free_channel(drvdata->mbox);
@@ -125,6 +161,7 @@ static int tegra_aon_ivc_echo_remove(struct platform_device *pdev)
 {
 	struct tegra_aon_ivc_echo_data *drvdata = dev_get_drvdata(&pdev->dev);
 
+	tegra_perf_test_unregister(&drvdata->perf);
 	device_remove_file(&pdev->dev, &dev_attr_data_channel);
 	mbox_free_channel(drvdata->mbox);
 
@@ -233,6 +233,9 @@ struct tegra_cam_rtcpu {
 	bool powered;
 	bool boot_sync_done;
 	bool online;
+	bool fw_suspended;	/* PM_SUSPEND acked, not rebooted since */
+	bool warm_resume;	/* keep the core out of reset over SC7 */
+	bool warm_suspended;
 };
 
 static int tegra_camrtc_mbox_exchange(struct device *dev,
@@ -389,6 +392,7 @@ static int tegra_camrtc_deassert_resets(struct device *dev)
 		ret = rtcpu->pdata->deassert_resets(dev);
 		rtcpu->stats.reset_complete = ktime_get_ns();
 		rtcpu->stats.boot_handshake = 0;
+		rtcpu->fw_suspended = false;
 	}
 
 	return ret;
@@ -698,13 +702,17 @@ static void tegra_rce_cam_assert_resets(struct device *dev)
 static int tegra_camrtc_suspend_core(struct device *dev)
 {
 	struct tegra_cam_rtcpu *rtcpu = dev_get_drvdata(dev);
+	int err;
 
 	if (!rtcpu->boot_sync_done || !rtcpu->sm_pair)
 		return 0;
 
 	rtcpu->boot_sync_done = false;
 
-	return rtcpu->pdata->suspend_core(dev);
+	err = rtcpu->pdata->suspend_core(dev);
+	rtcpu->fw_suspended = (err == 0);
+
+	return err;
 }
 
 static void tegra_camrtc_set_online(struct device *dev, bool online)
@@ -738,6 +746,9 @@ static u32 tegra_camrtc_full_notify(void *data, u32 response)
 	atomic_set(&rtcpu->cmd.response, response);
 	wake_up(&rtcpu->cmd.response_waitq);
 
+	/* RTCPU is active, pick up its trace without waiting for the poll */
+	tegra_rtcpu_trace_kick(rtcpu->tracer);
+
 	return 0;
 }
 
@@ -938,6 +949,7 @@ static int tegra_camrtc_boot_sync(struct device *dev)
 
 	rtcpu->fw_version = RTCPU_GET_COMMAND_VALUE(ret);
 	rtcpu->boot_sync_done = true;
+	rtcpu->fw_suspended = false;
 
 	/*
 	 * Enable trace
@@ -990,6 +1002,8 @@ static int tegra_camrtc_boot(struct device *dev)
 			break;
 		dev_warn(dev, "%s full reset, retry %u/%u\n",
 			rtcpu->name, retry, max_retries);
+		/* channels kept across a warm resume must sync again */
+		tegra_camrtc_set_online(dev, false);
 		tegra_camrtc_assert_resets(dev);
 		usleep_range(10, 30);
 		tegra_camrtc_deassert_resets(dev);
@@ -1263,6 +1277,9 @@ static int tegra_cam_rtcpu_probe(struct platform_device *pdev)
 	if (ret)
 		goto fail;
 
+	rtcpu->warm_resume = pdata->id != TEGRA_CAM_RTCPU_APE &&
+		of_property_read_bool(dev->of_node, NV(warm-resume));
+
 	rtcpu->max_reboot_retry = 2;
 	(void)of_property_read_u32(dev->of_node, NV(max-reboot),
 			&rtcpu->max_reboot_retry);
@@ -1432,9 +1449,60 @@ static int tegra_camrtc_halt(struct device *dev)
 	return 0;
 }
 
+/*
+ * Firmware from SM4 on restores itself after PM_SUSPEND, and its image and
+ * state stay in DRAM over SC7. With warm-resume, system suspend only halts
+ * the core with PM_SUSPEND and gates its clocks: no reset, no reboot, and
+ * the IVC channels stay online. Resume then only redoes the INIT handshake,
+ * and falls back to a full reset if the firmware does not answer.
+ */
+static int tegra_camrtc_suspend(struct device *dev)
+{
+	struct tegra_cam_rtcpu *rtcpu = dev_get_drvdata(dev);
+
+	if (!rtcpu->warm_resume || !rtcpu->powered ||
+	    rtcpu->fw_version < RTCPU_FW_SM4_VERSION)
+		return tegra_camrtc_halt(dev);
+
+	if (!pm_runtime_suspended(dev) &&
+	    tegra_camrtc_suspend_core(dev) < 0)
+		return tegra_camrtc_halt(dev);
+
+	if (!rtcpu->fw_suspended)
+		return tegra_camrtc_halt(dev);
+
+	tegra_camrtc_disable_clks(dev);
+	rtcpu->warm_suspended = true;
+
+	return 0;
+}
+
 static int tegra_camrtc_resume(struct device *dev)
 {
-	return tegra_camrtc_poweron(dev, false);
+	struct tegra_cam_rtcpu *rtcpu = dev_get_drvdata(dev);
+	int ret;
+
+	if (!rtcpu->warm_suspended)
+		return tegra_camrtc_poweron(dev, false);
+
+	rtcpu->warm_suspended = false;
+
+	ret = tegra_camrtc_enable_clks(dev);
+	if (ret) {
+		dev_err(dev, "failed to turn on %s clocks: %d\n",
+			rtcpu->name, ret);
+		/* reboot on the next runtime resume */
+		rtcpu->powered = false;
+		tegra_camrtc_assert_resets(dev);
+		tegra_camrtc_set_online(dev, false);
+		return ret;
+	}
+
+	/* otherwise runtime_resume() does the handshake */
+	if (!pm_runtime_suspended(dev))
+		return tegra_camrtc_boot(dev);
+
+	return 0;
 }
 
 static void tegra_cam_rtcpu_shutdown(struct platform_device *pdev)
@@ -1457,7 +1525,7 @@ static const struct of_device_id tegra_cam_rtcpu_of_match[] = {
 MODULE_DEVICE_TABLE(of, tegra_cam_rtcpu_of_match);
 
 static const struct dev_pm_ops tegra_cam_rtcpu_pm_ops = {
-	.suspend = tegra_camrtc_halt,
+	.suspend = tegra_camrtc_suspend,
 	.resume = tegra_camrtc_resume,
 	.runtime_suspend = tegra_cam_rtcpu_runtime_suspend,
 	.runtime_resume = tegra_cam_rtcpu_runtime_resume,
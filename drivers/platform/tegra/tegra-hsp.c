@@ -22,6 +22,8 @@
 #include <linux/module.h>
 #include <linux/slab.h>
 #include <linux/debugfs.h>
+#include <linux/kthread.h>
+#include <linux/ktime.h>
 
 #include <linux/tegra-hsp.h>
 
@@ -48,6 +50,13 @@ static DEFINE_SPINLOCK(hsp_top_lock);
 struct db_handler_info {
 	db_handler_t	handler;
 	void			*data;
+	/* set for masters dispatched from their own thread */
+	bool			threaded;
+	struct kthread_worker	*worker;
+	struct kthread_work	work;
+	/* doorbell time of the first ring not handled yet by the worker */
+	atomic64_t		ring_ns;
+	struct tegra_hsp_db_latency	lat;
 };
 
 static struct hsp_top hsp_top = { .status = HSP_INIT_PENDING };
@@ -111,23 +120,66 @@ static inline void hsp_writel(void __iomem *base, int reg, u32 val)
 	(void)readl(base + reg);
 }
 
+static inline void db_account_latency(struct db_handler_info *info,
+				      u64 ring_ns)
+{
+	u64 delta = ktime_get_ns() - ring_ns;
+
+	/* each master is only accounted from one context at a time */
+	info->lat.count++;
+	info->lat.total_ns += delta;
+	if (delta > info->lat.max_ns)
+		info->lat.max_ns = delta;
+}
+
+static void db_thread_fn(struct kthread_work *work)
+{
+	struct db_handler_info *info =
+		container_of(work, struct db_handler_info, work);
+	u64 ring_ns = atomic64_xchg(&info->ring_ns, 0);
+
+	db_account_latency(info, ring_ns);
+	info->handler(info->data);
+}
+
 static irqreturn_t dbell_irq(int irq, void *data)
 {
 	ulong reg;
 	int master;
 	struct db_handler_info *info;
+	u64 ring_ns = ktime_get_ns();
 
 	reg = (ulong)hsp_readl(db_bases[HSP_DB_CCPLEX], HSP_DB_REG_PENDING);
 	hsp_writel(db_bases[HSP_DB_CCPLEX], HSP_DB_REG_PENDING, reg);
 
+	/*
+	 * Threaded masters are kicked first, so that they do not wait for
+	 * the handlers running in hard IRQ context.
+	 */
 	for_each_set_bit(master, &reg, HSP_LAST_MASTER + 1) {
 		info = &db_handlers[master];
 		if (unlikely(!is_master_valid(master))) {
 			pr_warn("invalid master from HW.\n");
+			clear_bit(master, &reg);
 			continue;
 		}
-		if (info->handler)
+		if (info->handler && info->threaded) {
+			/* NULL while the handler is being removed */
+			if (info->worker) {
+				/* rings coalesce until the worker runs */
+				atomic64_cmpxchg(&info->ring_ns, 0, ring_ns);
+				kthread_queue_work(info->worker, &info->work);
+			}
+			clear_bit(master, &reg);
+		}
+	}
+
+	for_each_set_bit(master, &reg, HSP_LAST_MASTER + 1) {
+		info = &db_handlers[master];
+		if (info->handler) {
+			db_account_latency(info, ring_ns);
 			info->handler(info->data);
+		}
 	}
 
 	return IRQ_HANDLED;
@@ -232,6 +284,7 @@ int tegra_hsp_db_add_handler(int master, db_handler_t handler, void *data)
 	disable_irq(db_irq);
 	db_handlers[master].handler = handler;
 	db_handlers[master].data = data;
+	memset(&db_handlers[master].lat, 0, sizeof(db_handlers[master].lat));
 	enable_irq(db_irq);
 	mutex_unlock(&db_handlers_lock);
 
@@ -239,6 +292,74 @@ int tegra_hsp_db_add_handler(int master, db_handler_t handler, void *data)
 }
 EXPORT_SYMBOL(tegra_hsp_db_add_handler);
 
+/**
+ * tegra_hsp_db_add_threaded_handler: register an CCPLEX doorbell handler
+ * running in a dedicated thread
+ * @ master:	master id
+ * @ handler:	doorbell handler, may sleep
+ * @ data:		custom data
+ * @ cpu:		CPU the thread is bound to, or -1 for any CPU
+ *
+ * The doorbell IRQ only queues the handler, so a slow master does not
+ * delay the others. Rings arriving before the handler runs are coalesced.
+ *
+ * Returns 0 if successful.
+ */
+int tegra_hsp_db_add_threaded_handler(int master, db_handler_t handler,
+				      void *data, int cpu)
+{
+	struct db_handler_info *info;
+	struct kthread_worker *worker;
+	int ret;
+
+	if (!handler || !is_master_valid(master))
+		return -EINVAL;
+
+	if (cpu >= 0 && (cpu >= nr_cpu_ids || !cpu_online(cpu)))
+		return -EINVAL;
+
+	if (unlikely(db_irq <= 0))
+		return -ENODEV;
+
+	mutex_lock(&db_handlers_lock);
+	info = &db_handlers[master];
+	if (likely(info->handler != NULL)) {
+		ret = -EBUSY;
+		goto unlock;
+	}
+
+	worker = kthread_create_worker(0, "hsp-db/%s", master_names[master]);
+	if (IS_ERR(worker)) {
+		ret = PTR_ERR(worker);
+		goto unlock;
+	}
+
+	if (cpu >= 0) {
+		ret = set_cpus_allowed_ptr(worker->task, cpumask_of(cpu));
+		if (ret) {
+			kthread_destroy_worker(worker);
+			goto unlock;
+		}
+	}
+
+	kthread_init_work(&info->work, db_thread_fn);
+	atomic64_set(&info->ring_ns, 0);
+
+	disable_irq(db_irq);
+	info->threaded = true;
+	info->worker = worker;
+	info->handler = handler;
+	info->data = data;
+	memset(&info->lat, 0, sizeof(info->lat));
+	enable_irq(db_irq);
+	ret = 0;
+
+unlock:
+	mutex_unlock(&db_handlers_lock);
+	return ret;
+}
+EXPORT_SYMBOL(tegra_hsp_db_add_threaded_handler);
+
 /**
  * tegra_hsp_db_del_handler: unregister an CCPLEX doorbell IRQ handler
  * @handler:	IRQ handler
@@ -247,6 +368,8 @@ EXPORT_SYMBOL(tegra_hsp_db_add_handler);
  */
 int tegra_hsp_db_del_handler(int master)
 {
+	struct kthread_worker *worker;
+
 	if (!is_master_valid(master))
 		return -EINVAL;
 
@@ -255,9 +378,20 @@ int tegra_hsp_db_del_handler(int master)
 
 	mutex_lock(&db_handlers_lock);
 	WARN_ON(db_handlers[master].handler == NULL);
+	disable_irq(db_irq);
+	worker = db_handlers[master].worker;
+	/* the IRQ stops queuing the work, the handler must stay threaded */
+	db_handlers[master].worker = NULL;
+	enable_irq(db_irq);
+
+	/* lets a pending work run before the handler goes away */
+	if (worker)
+		kthread_destroy_worker(worker);
+
 	disable_irq(db_irq);
 	db_handlers[master].handler = NULL;
 	db_handlers[master].data = NULL;
+	db_handlers[master].threaded = false;
 	enable_irq(db_irq);
 	mutex_unlock(&db_handlers_lock);
 
@@ -265,6 +399,23 @@ int tegra_hsp_db_del_handler(int master)
 }
 EXPORT_SYMBOL(tegra_hsp_db_del_handler);
 
+/**
+ * tegra_hsp_db_get_latency: doorbell to handler latency of <master>
+ * @master:	master id
+ * @lat:	filled with the statistics since the handler was registered
+ *
+ * Returns 0 if successful.
+ */
+int tegra_hsp_db_get_latency(int master, struct tegra_hsp_db_latency *lat)
+{
+	if (!lat || !is_master_valid(master))
+		return -EINVAL;
+
+	*lat = db_handlers[master].lat;
+	return 0;
+}
+EXPORT_SYMBOL(tegra_hsp_db_get_latency);
+
 #ifdef CONFIG_DEBUG_FS
 
 static int hsp_dbg_enable_master_show(void *data, u64 *val)
@@ -392,6 +543,28 @@ static int hsp_dbg_handlers_show(struct seq_file *s, void *data)
 	return 0;
 }
 
+static int hsp_dbg_latency_show(struct seq_file *s, void *data)
+{
+	struct db_handler_info *info;
+	int m;
+
+	seq_printf(s, "%-20s%-10s%-12s%-12s%-12s\n", "master", "thread",
+		"count", "avg_ns", "max_ns");
+	seq_printf(s, "------------------------------------------------------------------\n");
+	for_each_valid_master(m) {
+		info = &db_handlers[m];
+		if (!info->handler)
+			continue;
+		seq_printf(s, "%-20s%-10s%-12llu%-12llu%-12llu\n",
+			master_names[m], info->threaded ? "yes" : "no",
+			info->lat.count,
+			info->lat.count ?
+				div64_u64(info->lat.total_ns, info->lat.count) : 0,
+			info->lat.max_ns);
+	}
+	return 0;
+}
+
 DEFINE_SIMPLE_ATTRIBUTE(enable_master_fops,
 	hsp_dbg_enable_master_show, hsp_dbg_enable_master_store, "%llx\n");
 DEFINE_SIMPLE_ATTRIBUTE(ring_fops,
@@ -420,6 +593,7 @@ static const struct file_operations name##_fops = { \
 DEFINE_DBG_OPEN(doorbells);
 DEFINE_DBG_OPEN(masters);
 DEFINE_DBG_OPEN(handlers);
+DEFINE_DBG_OPEN(latency);
 
 struct debugfs_entry {
 	const char *name;
@@ -436,6 +610,7 @@ static struct debugfs_entry hsp_dbg_attrs[] = {
 	{ "doorbells", &doorbells_fops, S_IRUGO },
 	{ "masters", &masters_fops, S_IRUGO },
 	{ "handlers", &handlers_fops, S_IRUGO },
+	{ "latency", &latency_fops, S_IRUGO },
 	{ "intr_count", &intr_count_fops, S_IRUGO },
 	{ NULL, NULL, 0 }
 };
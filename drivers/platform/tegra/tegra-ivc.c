@@ -11,6 +11,8 @@
 
 #include <linux/tegra-ivc.h>
 #include <linux/tegra-ivc-instance.h>
+#include <linux/tegra-ivc-batch.h>
+#include <linux/tegra-ivc-poll.h>
 #include <linux/module.h>
 #include <linux/uaccess.h>
 #include <linux/err.h>
@@ -105,8 +107,16 @@ struct ivc_channel_header {
 		uint8_t w_align[IVC_ALIGN];
 	};
 	union {
-		/* fields owned by the receiving end */
-		uint32_t r_count;
+		struct {
+			/* fields owned by the receiving end */
+			uint32_t r_count;
+			/*
+			 * Set while the receiver busy-polls the channel, the
+			 * transmitting end does not need to notify it. Peers
+			 * unaware of it keep the padding, and so this, zero.
+			 */
+			uint32_t r_polling;
+		};
 		uint8_t r_align[IVC_ALIGN];
 	};
 };
@@ -178,26 +188,24 @@ static inline uint32_t ivc_channel_avail_count(struct ivc *ivc,
 	return ACCESS_ONCE(ch->w_count) - ACCESS_ONCE(ch->r_count);
 }
 
-static inline void ivc_advance_tx(struct ivc *ivc)
+static inline void ivc_advance_tx(struct ivc *ivc, uint32_t count)
 {
 	ACCESS_ONCE(ivc->tx_channel->w_count) =
-		ACCESS_ONCE(ivc->tx_channel->w_count) + 1;
+		ACCESS_ONCE(ivc->tx_channel->w_count) + count;
 
-	if (ivc->w_pos == ivc->nframes - 1)
-		ivc->w_pos = 0;
-	else
-		ivc->w_pos++;
+	ivc->w_pos += count;
+	if (ivc->w_pos >= ivc->nframes)
+		ivc->w_pos -= ivc->nframes;
 }
 
-static inline void ivc_advance_rx(struct ivc *ivc)
+static inline void ivc_advance_rx(struct ivc *ivc, uint32_t count)
 {
 	ACCESS_ONCE(ivc->rx_channel->r_count) =
-		ACCESS_ONCE(ivc->rx_channel->r_count) + 1;
+		ACCESS_ONCE(ivc->rx_channel->r_count) + count;
 
-	if (ivc->r_pos == ivc->nframes - 1)
-		ivc->r_pos = 0;
-	else
-		ivc->r_pos++;
+	ivc->r_pos += count;
+	if (ivc->r_pos >= ivc->nframes)
+		ivc->r_pos -= ivc->nframes;
 }
 
 static inline int ivc_check_read(struct ivc *ivc)
@@ -269,6 +277,40 @@ uint32_t tegra_ivc_tx_frames_available(struct ivc *ivc)
 }
 EXPORT_SYMBOL(tegra_ivc_tx_frames_available);
 
+/*
+ * Tell the transmitting end that we are busy-polling the channel, so that
+ * frames written meanwhile are not notified. Every call must be paired with
+ * tegra_ivc_rx_poll_stop() before waiting for an interrupt again.
+ */
+void tegra_ivc_rx_poll_start(struct ivc *ivc)
+{
+	ACCESS_ONCE(ivc->rx_channel->r_polling) = 1;
+	ivc_flush_counter(ivc, ivc->rx_handle +
+			offsetof(struct ivc_channel_header, r_count));
+}
+EXPORT_SYMBOL(tegra_ivc_rx_poll_start);
+
+/*
+ * Go back to interrupt mode. Returns true if frames arrived without a
+ * notification meanwhile, in which case the caller must consume them
+ * instead of waiting for the next interrupt.
+ */
+bool tegra_ivc_rx_poll_stop(struct ivc *ivc)
+{
+	ACCESS_ONCE(ivc->rx_channel->r_polling) = 0;
+	ivc_flush_counter(ivc, ivc->rx_handle +
+			offsetof(struct ivc_channel_header, r_count));
+
+	/*
+	 * Ensure our write to r_polling occurs before our read from w_count,
+	 * pairs with ivc_mb() in ivc_tx_commit().
+	 */
+	ivc_mb();
+
+	return tegra_ivc_can_read(ivc);
+}
+EXPORT_SYMBOL(tegra_ivc_rx_poll_stop);
+
 static void *ivc_frame_pointer(struct ivc *ivc, struct ivc_channel_header *ch,
 		uint32_t frame)
 {
@@ -305,6 +347,117 @@ static inline void ivc_flush_frame(struct ivc *ivc, dma_addr_t channel_handle,
 			len, DMA_TO_DEVICE);
 }
 
+/*
+ * Release count frames, that have been consumed, to the transmitting end.
+ */
+static void ivc_rx_commit(struct ivc *ivc, uint32_t count)
+{
+	ivc_advance_rx(ivc, count);
+	ivc_flush_counter(ivc, ivc->rx_handle +
+			offsetof(struct ivc_channel_header, r_count));
+
+	/*
+	 * Ensure our write to r_pos occurs before our read from w_pos.
+	 */
+	ivc_mb();
+
+	/*
+	 * Notify only upon transition from full to non-full.
+	 * The available count can only asynchronously increase, so the
+	 * worst possible side-effect will be a spurious notification.
+	 */
+	ivc_invalidate_counter(ivc, ivc->rx_handle +
+		offsetof(struct ivc_channel_header, w_count));
+
+	if (ivc_channel_avail_count(ivc, ivc->rx_channel) ==
+			ivc->nframes - count)
+		ivc->notify(ivc);
+}
+
+/*
+ * Publish count frames, that have been filled in, to the receiving end.
+ */
+static void ivc_tx_commit(struct ivc *ivc, uint32_t count)
+{
+	/*
+	 * Ensure that updated data is visible before the w_pos counter
+	 * indicates that it is ready.
+	 */
+	ivc_wmb();
+
+	ivc_advance_tx(ivc, count);
+	ivc_flush_counter(ivc, ivc->tx_handle +
+			offsetof(struct ivc_channel_header, w_count));
+
+	/*
+	 * Ensure our write to w_pos occurs before our read from r_pos.
+	 */
+	ivc_mb();
+
+	/*
+	 * Notify only upon transition from empty to non-empty.
+	 * The available count can only asynchronously decrease, so the
+	 * worst possible side-effect will be a spurious notification.
+	 */
+	ivc_invalidate_counter(ivc, ivc->tx_handle +
+		offsetof(struct ivc_channel_header, r_count));
+
+	/*
+	 * A polling receiver will find the frames on its own. It rechecks
+	 * the channel after clearing r_polling, see tegra_ivc_rx_poll_stop(),
+	 * so skipping the notification here cannot be missed.
+	 */
+	if (ACCESS_ONCE(ivc->tx_channel->r_polling))
+		return;
+
+	if (ivc_channel_avail_count(ivc, ivc->tx_channel) == count)
+		ivc->notify(ivc);
+}
+
+/*
+ * Number of frames that can be read at once. The counters are synchronized
+ * a single time for the whole batch, an over-full channel reads as empty
+ * as explained in ivc_channel_empty().
+ */
+static int ivc_rx_batch_avail(struct ivc *ivc, uint32_t max)
+{
+	uint32_t avail;
+
+	if (ivc->tx_channel->state != ivc_state_established)
+		return -ECONNRESET;
+
+	ivc_invalidate_counter(ivc, ivc->rx_handle +
+			offsetof(struct ivc_channel_header, w_count));
+	avail = ivc_channel_avail_count(ivc, ivc->rx_channel);
+	if (avail == 0 || avail > ivc->nframes)
+		return -ENOMEM;
+
+	/*
+	 * Order observation of w_pos potentially indicating new data before
+	 * data read.
+	 */
+	ivc_rmb();
+
+	return min(avail, max);
+}
+
+/* Number of frames that can be written at once. */
+static int ivc_tx_batch_avail(struct ivc *ivc, uint32_t max)
+{
+	uint32_t used;
+
+	if (ivc->tx_channel->state != ivc_state_established)
+		return -ECONNRESET;
+
+	ivc_invalidate_counter(ivc, ivc->tx_handle +
+			offsetof(struct ivc_channel_header, r_count));
+	used = ivc_channel_avail_count(ivc, ivc->tx_channel);
+	if (used >= ivc->nframes)
+		return -ENOMEM;
+
+	return min(ivc->nframes - used, max);
+}
+
 static int ivc_read_frame(struct ivc *ivc, void *buf, void __user *user_buf,
 		size_t max_read)
 {
@@ -343,25 +496,7 @@ static int ivc_read_frame(struct ivc *ivc, void *buf, void __user *user_buf,
 	} else
 		BUG();
 
-	ivc_advance_rx(ivc);
-	ivc_flush_counter(ivc, ivc->rx_handle +
-			offsetof(struct ivc_channel_header, r_count));
-
-	/*
-	 * Ensure our write to r_pos occurs before our read from w_pos.
-	 */
-	ivc_mb();
-
-	/*
-	 * Notify only upon transition from full to non-full.
-	 * The available count can only asynchronously increase, so the
-	 * worst possible side-effect will be a spurious notification.
-	 */
-	ivc_invalidate_counter(ivc, ivc->rx_handle +
-		offsetof(struct ivc_channel_header, w_count));
-
-	if (ivc_channel_avail_count(ivc, ivc->rx_channel) == ivc->nframes - 1)
-		ivc->notify(ivc);
+	ivc_rx_commit(ivc, 1);
 
 	return (int)max_read;
 }
@@ -438,29 +573,89 @@ int tegra_ivc_read_advance(struct ivc *ivc)
 	if (result)
 		return result;
 
-	ivc_advance_rx(ivc);
-	ivc_flush_counter(ivc, ivc->rx_handle +
-			offsetof(struct ivc_channel_header, r_count));
+	ivc_rx_commit(ivc, 1);
 
-	/*
-	 * Ensure our write to r_pos occurs before our read from w_pos.
-	 */
-	ivc_mb();
+	return 0;
+}
+EXPORT_SYMBOL(tegra_ivc_read_advance);
+
+/*
+ * Read up to count frames of size bytes each into buf, which holds them
+ * back to back. Returns the number of frames read.
+ */
+int tegra_ivc_read_batch(struct ivc *ivc, void *buf, size_t size,
+		unsigned count)
+{
+	uint32_t pos;
+	int i, n;
+
+	if (size > ivc->frame_size)
+		return -E2BIG;
+
+	n = ivc_rx_batch_avail(ivc, count);
+	if (n <= 0)
+		return n;
+
+	for (i = 0, pos = ivc->r_pos; i < n; i++) {
+		ivc_invalidate_frame(ivc, ivc->rx_handle, pos, 0, size);
+		memcpy(buf + i * size, ivc_frame_pointer(ivc,
+				ivc->rx_channel, pos), size);
+		if (++pos == ivc->nframes)
+			pos = 0;
+	}
+
+	ivc_rx_commit(ivc, n);
+
+	return n;
+}
+EXPORT_SYMBOL(tegra_ivc_read_batch);
+
+/*
+ * Directly peek at up to count frames rx'ed, in order. The frames stay
+ * owned by the caller until tegra_ivc_read_advance_batch().
+ */
+int tegra_ivc_read_get_frames(struct ivc *ivc, void **frames, unsigned count)
+{
+	uint32_t pos;
+	int i, n;
+
+	n = ivc_rx_batch_avail(ivc, count);
+	if (n <= 0)
+		return n;
+
+	for (i = 0, pos = ivc->r_pos; i < n; i++) {
+		ivc_invalidate_frame(ivc, ivc->rx_handle, pos, 0,
+				ivc->frame_size);
+		frames[i] = ivc_frame_pointer(ivc, ivc->rx_channel, pos);
+		if (++pos == ivc->nframes)
+			pos = 0;
+	}
 
+	return n;
+}
+EXPORT_SYMBOL(tegra_ivc_read_get_frames);
+
+int tegra_ivc_read_advance_batch(struct ivc *ivc, unsigned count)
+{
 	/*
-	 * Notify only upon transition from full to non-full.
-	 * The available count can only asynchronously increase, so the
-	 * worst possible side-effect will be a spurious notification.
+	 * As in tegra_ivc_read_advance(), the caller has already observed
+	 * the frames, this check only catches programming errors.
 	 */
-	ivc_invalidate_counter(ivc, ivc->rx_handle +
-		offsetof(struct ivc_channel_header, w_count));
+	if (ivc->tx_channel->state != ivc_state_established)
+		return -ECONNRESET;
 
-	if (ivc_channel_avail_count(ivc, ivc->rx_channel) == ivc->nframes - 1)
-		ivc->notify(ivc);
+	if (count == 0)
+		return 0;
+
+	if (count > ivc_channel_avail_count(ivc, ivc->rx_channel) ||
+			count > ivc->nframes)
+		return -EINVAL;
+
+	ivc_rx_commit(ivc, count);
 
 	return 0;
 }
-EXPORT_SYMBOL(tegra_ivc_read_advance);
+EXPORT_SYMBOL(tegra_ivc_read_advance_batch);
 
 static int ivc_write_frame(struct ivc *ivc, const void *buf,
 		const void __user *user_buf, size_t size)
@@ -496,31 +691,7 @@ static int ivc_write_frame(struct ivc *ivc, const void *buf,
 	memset(p + size, 0, ivc->frame_size - size);
 	ivc_flush_frame(ivc, ivc->tx_handle, ivc->w_pos, 0, size);
 
-	/*
-	 * Ensure that updated data is visible before the w_pos counter
-	 * indicates that it is ready.
-	 */
-	ivc_wmb();
-
-	ivc_advance_tx(ivc);
-	ivc_flush_counter(ivc, ivc->tx_handle +
-			offsetof(struct ivc_channel_header, w_count));
-
-	/*
-	 * Ensure our write to w_pos occurs before our read from r_pos.
-	 */
-	ivc_mb();
-
-	/*
-	 * Notify only upon transition from empty to non-empty.
-	 * The available count can only asynchronously decrease, so the
-	 * worst possible side-effect will be a spurious notification.
-	 */
-	ivc_invalidate_counter(ivc, ivc->tx_handle +
-		offsetof(struct ivc_channel_header, r_count));
-
-	if (ivc_channel_avail_count(ivc, ivc->tx_channel) == 1)
-		ivc->notify(ivc);
+	ivc_tx_commit(ivc, 1);
 
 	return (int)size;
 }
@@ -579,34 +750,94 @@ int tegra_ivc_write_advance(struct ivc *ivc)
 
 	ivc_flush_frame(ivc, ivc->tx_handle, ivc->w_pos, 0, ivc->frame_size);
 
-	/*
-	 * Order any possible stores to the frame before update of w_pos.
-	 */
-	ivc_wmb();
+	ivc_tx_commit(ivc, 1);
 
-	ivc_advance_tx(ivc);
-	ivc_flush_counter(ivc, ivc->tx_handle +
-			offsetof(struct ivc_channel_header, w_count));
+	return 0;
+}
+EXPORT_SYMBOL(tegra_ivc_write_advance);
 
-	/*
-	 * Ensure our write to w_pos occurs before our read from r_pos.
-	 */
-	ivc_mb();
+/*
+ * Write up to count frames of size bytes each from buf, which holds them
+ * back to back. Returns the number of frames written.
+ */
+int tegra_ivc_write_batch(struct ivc *ivc, const void *buf, size_t size,
+		unsigned count)
+{
+	uint32_t pos;
+	void *p;
+	int i, n;
 
-	/*
-	 * Notify only upon transition from empty to non-empty.
-	 * The available count can only asynchronously decrease, so the
-	 * worst possible side-effect will be a spurious notification.
-	 */
-	ivc_invalidate_counter(ivc, ivc->tx_handle +
-		offsetof(struct ivc_channel_header, r_count));
+	if (size > ivc->frame_size)
+		return -E2BIG;
 
-	if (ivc_channel_avail_count(ivc, ivc->tx_channel) == 1)
-		ivc->notify(ivc);
+	n = ivc_tx_batch_avail(ivc, count);
+	if (n <= 0)
+		return n;
+
+	for (i = 0, pos = ivc->w_pos; i < n; i++) {
+		p = ivc_frame_pointer(ivc, ivc->tx_channel, pos);
+		memcpy(p, buf + i * size, size);
+		memset(p + size, 0, ivc->frame_size - size);
+		ivc_flush_frame(ivc, ivc->tx_handle, pos, 0, size);
+		if (++pos == ivc->nframes)
+			pos = 0;
+	}
+
+	ivc_tx_commit(ivc, n);
+
+	return n;
+}
+EXPORT_SYMBOL(tegra_ivc_write_batch);
+
+/*
+ * Directly poke at up to count frames to be tx'ed, in order. They are
+ * sent with tegra_ivc_write_advance_batch().
+ */
+int tegra_ivc_write_get_frames(struct ivc *ivc, void **frames, unsigned count)
+{
+	uint32_t pos;
+	int i, n;
+
+	n = ivc_tx_batch_avail(ivc, count);
+	if (n <= 0)
+		return n;
+
+	for (i = 0, pos = ivc->w_pos; i < n; i++) {
+		frames[i] = ivc_frame_pointer(ivc, ivc->tx_channel, pos);
+		if (++pos == ivc->nframes)
+			pos = 0;
+	}
+
+	return n;
+}
+EXPORT_SYMBOL(tegra_ivc_write_get_frames);
+
+int tegra_ivc_write_advance_batch(struct ivc *ivc, unsigned count)
+{
+	uint32_t pos;
+	unsigned i;
+	int n;
+
+	if (count == 0)
+		return 0;
+
+	n = ivc_tx_batch_avail(ivc, count);
+	if (n < 0)
+		return n;
+	if ((unsigned)n < count)
+		return -EINVAL;
+
+	for (i = 0, pos = ivc->w_pos; i < count; i++) {
+		ivc_flush_frame(ivc, ivc->tx_handle, pos, 0, ivc->frame_size);
+		if (++pos == ivc->nframes)
+			pos = 0;
+	}
+
+	ivc_tx_commit(ivc, count);
 
 	return 0;
 }
-EXPORT_SYMBOL(tegra_ivc_write_advance);
+EXPORT_SYMBOL(tegra_ivc_write_advance_batch);
 
 void tegra_ivc_channel_reset(struct ivc *ivc)
 {
@@ -660,6 +891,7 @@ int tegra_ivc_channel_notified(struct ivc *ivc)
 		 */
 		ivc->tx_channel->w_count = 0;
 		ivc->rx_channel->r_count = 0;
+		ivc->rx_channel->r_polling = 0;
 
 		ivc->w_pos = 0;
 		ivc->r_pos = 0;
@@ -698,6 +930,7 @@ int tegra_ivc_channel_notified(struct ivc *ivc)
 		 */
 		ivc->tx_channel->w_count = 0;
 		ivc->rx_channel->r_count = 0;
+		ivc->rx_channel->r_polling = 0;
 
 		ivc->w_pos = 0;
 		ivc->r_pos = 0;
@@ -26,6 +26,14 @@
 #include <linux/string.h>
 #include <linux/slab.h>
 #include <linux/memblock.h>
+#include <linux/math64.h>
+#include <linux/version.h>
+#if LINUX_VERSION_CODE >= KERNEL_VERSION(4, 14, 0)
+#include <linux/sched/clock.h>
+#else
+#include <linux/sched.h>
+#endif
+#include <asm/arch_timer.h>
 #include <asm/page.h>
 #include "tegra_bootloader_debug.h"
 
@@ -36,6 +44,7 @@ static const char *gr_file_mb2 = "gr_mb2";
 static const char *gr_file_cpu_bl = "gr_cpu_bl";
 static const char *profiler = "profiler";
 static const char *boot_cfg = "boot_cfg";
+static const char *boot_timeline = "boot_timeline";
 
 struct gr_address_value {
 	unsigned int gr_address;
@@ -188,6 +197,81 @@ static int profiler_open(struct inode *inode, struct file *file)
 	return single_open(file, profiler_show, &inode->i_private);
 }
 
+/*
+ * The bootloader profiler stamps are us of the SoC timestamp counter since
+ * power on, which also drives the arch counter. local_clock() starts at
+ * kernel init instead: its offset is where the kernel started on the
+ * bootloader timebase, and lines up dmesg and initcall_debug times too.
+ */
+static u64 tegra_bl_kernel_start_us(void)
+{
+	u64 cnt = arch_counter_get_cntvct();
+	u32 rate = arch_timer_get_cntfrq();
+	u64 now_us = div_u64(local_clock(), NSEC_PER_USEC);
+	u64 cnt_us;
+	u32 rem;
+
+	if (!rate)
+		return 0;
+
+	cnt_us = div_u64_rem(cnt, rate, &rem) * USEC_PER_SEC +
+		div_u64((u64)rem * USEC_PER_SEC, rate);
+
+	return cnt_us > now_us ? cnt_us - now_us : 0;
+}
+
+/*
+ * One tab separated line per event, in us on the bootloader timebase:
+ *	<source>	<event>	<start_us>	<duration_us>
+ * sources are "bl" for profiler records, "kernel" for the kernel start,
+ * and "probe" or "probe_failed" for each platform driver probe.
+ */
+static int boot_timeline_show(struct seq_file *s, void *unused)
+{
+	struct profiler_record *profiler_data = tegra_bl_mapped_prof_start;
+	struct tegra_bl_probe_time rec;
+	u64 kernel_us = tegra_bl_kernel_start_us();
+	unsigned int i, count = 0;
+
+	seq_puts(s, "# source\tevent\tstart_us\tduration_us\n");
+
+	if (profiler_data)
+		count = tegra_bl_prof_size / sizeof(struct profiler_record);
+	for (i = 0; i < count; i++) {
+		if (!profiler_data[i].timestamp)
+			continue;
+		seq_printf(s, "bl\t%.*s\t%llu\t0\n", MAX_PROFILE_STRLEN,
+			   profiler_data[i].str,
+			   (unsigned long long)profiler_data[i].timestamp);
+	}
+
+	seq_printf(s, "kernel\tstart\t%llu\t0\n", kernel_us);
+
+	for (i = 0; !tegra_bl_probe_time_get(i, &rec); i++) {
+		/* still probing */
+		if (!rec.end_ns)
+			continue;
+		seq_printf(s, "%s\t%s\t%llu\t%llu\n",
+			   rec.failed ? "probe_failed" : "probe", rec.name,
+			   kernel_us + div_u64(rec.start_ns, NSEC_PER_USEC),
+			   div_u64(rec.end_ns - rec.start_ns, NSEC_PER_USEC));
+	}
+
+	return 0;
+}
+
+static int boot_timeline_open(struct inode *inode, struct file *file)
+{
+	return single_open(file, boot_timeline_show, &inode->i_private);
+}
+
+static const struct file_operations boot_timeline_fops = {
+	.open		= boot_timeline_open,
+	.read		= seq_read,
+	.llseek		= seq_lseek,
+	.release	= single_release,
+};
+
 static int dbg_golden_register_show(struct seq_file *s, void *unused)
 {
 	struct gr_header *golden_reg_header = (struct gr_header *)tegra_bl_mapped_debug_data_start;
@@ -295,6 +379,12 @@ static int __init tegra_bootloader_debuginit(void)
 		goto out_err;
 	}
 
+	if (IS_ERR_OR_NULL(debugfs_create_file(boot_timeline, 0444,
+				bl_debug_node, NULL, &boot_timeline_fops))) {
+		pr_err("%s: failed to create debugfs entries\n", module_name);
+		goto out_err;
+	}
+
 	tegra_bl_mapped_prof_start = phys_to_virt(tegra_bl_prof_start);
 	if (!pfn_valid(__phys_to_pfn(tegra_bl_prof_start))) {
 		ptr_bl_prof_start = ioremap(tegra_bl_prof_start, tegra_bl_prof_size);
@@ -21,4 +21,16 @@ extern phys_addr_t tegra_bl_prof_start;
 extern phys_addr_t tegra_bl_prof_size;
 extern phys_addr_t tegra_bl_bcp_start;
 extern phys_addr_t tegra_bl_bcp_size;
+
+#define TEGRA_BL_PROBE_NAME_LEN	48
+
+/* A platform driver probe, times are local_clock() ns */
+struct tegra_bl_probe_time {
+	char name[TEGRA_BL_PROBE_NAME_LEN];	/* driver:device */
+	u64 start_ns;
+	u64 end_ns;				/* 0 while probing */
+	bool failed;				/* e.g. deferred */
+};
+
+int tegra_bl_probe_time_get(unsigned int i, struct tegra_bl_probe_time *rec);
 #endif
@@ -20,7 +20,17 @@
 #include <linux/kernel.h>
 #include <linux/errno.h>
 #include <linux/memblock.h>
+#include <linux/notifier.h>
+#include <linux/platform_device.h>
+#include <linux/spinlock.h>
+#include <linux/version.h>
+#if LINUX_VERSION_CODE >= KERNEL_VERSION(4, 14, 0)
+#include <linux/sched/clock.h>
+#else
+#include <linux/sched.h>
+#endif
 #include <asm/page.h>
+#include "tegra_bootloader_debug.h"
 
 phys_addr_t tegra_bl_debug_data_start;
 EXPORT_SYMBOL(tegra_bl_debug_data_start);
@@ -148,3 +158,79 @@ static int tegra_bl_bcp_arg(char *options)
 	return 0;
 }
 early_param("boot_cfg_dataptr", tegra_bl_bcp_arg);
+
+/*
+ * Platform driver probe times, for the boot timeline next to the
+ * bootloader profiler records. Recording stops once the table is full.
+ */
+#define TEGRA_BL_PROBE_TIMES	256
+
+static struct tegra_bl_probe_time probe_times[TEGRA_BL_PROBE_TIMES];
+static const struct device *probe_devs[TEGRA_BL_PROBE_TIMES];
+static unsigned int probe_times_n;
+static DEFINE_SPINLOCK(probe_times_lock);
+
+static int tegra_bl_probe_notify(struct notifier_block *nb,
+				 unsigned long action, void *data)
+{
+	struct device *dev = data;
+	u64 now = local_clock();
+	unsigned long flags;
+	int i;
+
+	spin_lock_irqsave(&probe_times_lock, flags);
+	switch (action) {
+	case BUS_NOTIFY_BIND_DRIVER:
+		if (probe_times_n == TEGRA_BL_PROBE_TIMES)
+			break;
+		i = probe_times_n++;
+		snprintf(probe_times[i].name, TEGRA_BL_PROBE_NAME_LEN, "%s:%s",
+			 dev->driver ? dev->driver->name : "", dev_name(dev));
+		probe_times[i].start_ns = now;
+		probe_devs[i] = dev;
+		break;
+	case BUS_NOTIFY_BOUND_DRIVER:
+	case BUS_NOTIFY_DRIVER_NOT_BOUND:
+		for (i = probe_times_n - 1; i >= 0; i--) {
+			if (probe_devs[i] != dev || probe_times[i].end_ns)
+				continue;
+			probe_times[i].end_ns = now;
+			probe_times[i].failed =
+				action == BUS_NOTIFY_DRIVER_NOT_BOUND;
+			/* only needed to match the end of the probe */
+			probe_devs[i] = NULL;
+			break;
+		}
+		break;
+	}
+	spin_unlock_irqrestore(&probe_times_lock, flags);
+
+	return NOTIFY_DONE;
+}
+
+static struct notifier_block tegra_bl_probe_nb = {
+	.notifier_call = tegra_bl_probe_notify,
+};
+
+int tegra_bl_probe_time_get(unsigned int i, struct tegra_bl_probe_time *rec)
+{
+	unsigned long flags;
+	int ret = -ENOENT;
+
+	spin_lock_irqsave(&probe_times_lock, flags);
+	if (i < probe_times_n) {
+		*rec = probe_times[i];
+		ret = 0;
+	}
+	spin_unlock_irqrestore(&probe_times_lock, flags);
+
+	return ret;
+}
+EXPORT_SYMBOL(tegra_bl_probe_time_get);
+
+/* before the drivers, most of which register at device_initcall */
+static int __init tegra_bl_probe_times_init(void)
+{
+	return bus_register_notifier(&platform_bus_type, &tegra_bl_probe_nb);
+}
+postcore_initcall(tegra_bl_probe_times_init);
@@ -0,0 +1,433 @@
+/*
+ * Tegra performance self-tests
+ *
+ * Copyright (c) 2021, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ */
+
+/*
+ * Drivers register micro-benchmarks, run from debugfs:
+ *
+ *	echo 1000 > /sys/kernel/debug/tegra_perf/iterations
+ *	echo se_sha256 > /sys/kernel/debug/tegra_perf/run	(or "all")
+ *	cat /sys/kernel/debug/tegra_perf/run
+ *
+ * Each open of "run" runs the selected tests once. A line is printed per
+ * test, tab separated, in a format kept stable to compare kernels:
+ *
+ *	test iterations p50_ns p99_ns max_ns MB/s
+ *
+ * or "test error <errno>" when it could not run.
+ */
+
+#include <linux/kernel.h>
+#include <linux/init.h>
+#include <linux/debugfs.h>
+#include <linux/fs.h>
+#include <linux/ktime.h>
+#include <linux/math64.h>
+#include <linux/mutex.h>
+#include <linux/scatterlist.h>
+#include <linux/sched.h>
+#include <linux/sizes.h>
+#include <linux/slab.h>
+#include <linux/sort.h>
+#include <linux/uaccess.h>
+#include <linux/vmalloc.h>
+#include <crypto/hash.h>
+#include <crypto/skcipher.h>
+#include <linux/platform/tegra/perf_selftest.h>
+
+#define PERF_ITERATIONS_DEF	1000
+#define PERF_ITERATIONS_MAX	100000
+#define PERF_NAME_SZ		32
+#define PERF_LINE_SZ		96
+#define PERF_TESTS_MAX		64
+
+static LIST_HEAD(perf_tests);
+static DEFINE_MUTEX(perf_lock);
+static u32 perf_iterations = PERF_ITERATIONS_DEF;
+static char perf_select[PERF_NAME_SZ] = "all";
+
+int tegra_perf_test_register(struct tegra_perf_test *test)
+{
+	if (!test->name || !test->run)
+		return -EINVAL;
+
+	mutex_lock(&perf_lock);
+	list_add_tail(&test->node, &perf_tests);
+	mutex_unlock(&perf_lock);
+
+	return 0;
+}
+EXPORT_SYMBOL_GPL(tegra_perf_test_register);
+
+void tegra_perf_test_unregister(struct tegra_perf_test *test)
+{
+	mutex_lock(&perf_lock);
+	list_del(&test->node);
+	mutex_unlock(&perf_lock);
+}
+EXPORT_SYMBOL_GPL(tegra_perf_test_unregister);
+
+static int perf_cmp_u64(const void *a, const void *b)
+{
+	u64 x = *(const u64 *)a, y = *(const u64 *)b;
+
+	return x < y ? -1 : x > y;
+}
+
+/* call with perf_lock held */
+static int perf_run_one(struct tegra_perf_test *test, u64 *samples, u32 n,
+			char *line)
+{
+	u64 total_ns = 0, bytes = 0, ns, t0;
+	u32 i;
+	int err = 0;
+
+	if (test->prepare) {
+		err = test->prepare(test);
+		if (err)
+			goto out;
+	}
+
+	for (i = 0; i < n; i++) {
+		ns = 0;
+		t0 = ktime_get_ns();
+		err = test->run(test, &ns, &bytes);
+		if (!ns)
+			ns = ktime_get_ns() - t0;
+		if (err)
+			break;
+		samples[i] = ns;
+		total_ns += ns;
+		cond_resched();
+	}
+
+	if (test->finish)
+		test->finish(test);
+
+out:
+	if (err)
+		return scnprintf(line, PERF_LINE_SZ, "%s\terror\t%d\n",
+				 test->name, err);
+
+	sort(samples, n, sizeof(*samples), perf_cmp_u64, NULL);
+
+	/* bytes per ns * 1000 is MB/s */
+	return scnprintf(line, PERF_LINE_SZ, "%s\t%u\t%llu\t%llu\t%llu\t%llu\n",
+			 test->name, n, samples[n / 2],
+			 samples[min(n - 1, n * 99 / 100)], samples[n - 1],
+			 total_ns ? div64_u64(bytes * 1000, total_ns) : 0);
+}
+
+struct perf_result {
+	size_t len;
+	char buf[];
+};
+
+static int perf_run_open(struct inode *inode, struct file *file)
+{
+	struct tegra_perf_test *test;
+	struct perf_result *res;
+	u64 *samples;
+	size_t sz = PERF_LINE_SZ * (PERF_TESTS_MAX + 1);
+	u32 n;
+
+	res = kzalloc(sizeof(*res) + sz, GFP_KERNEL);
+	if (!res)
+		return -ENOMEM;
+
+	mutex_lock(&perf_lock);
+	n = perf_iterations;
+	samples = vmalloc(n * sizeof(*samples));
+	if (!samples) {
+		mutex_unlock(&perf_lock);
+		kfree(res);
+		return -ENOMEM;
+	}
+
+	res->len = scnprintf(res->buf, sz,
+			"# test\titerations\tp50_ns\tp99_ns\tmax_ns\tMB/s\n");
+	list_for_each_entry(test, &perf_tests, node) {
+		if (strcmp(perf_select, "all") &&
+		    strcmp(perf_select, test->name))
+			continue;
+		if (res->len + PERF_LINE_SZ > sz)
+			break;
+		res->len += perf_run_one(test, samples, n,
+					 res->buf + res->len);
+	}
+	mutex_unlock(&perf_lock);
+
+	vfree(samples);
+	file->private_data = res;
+
+	return nonseekable_open(inode, file);
+}
+
+static ssize_t perf_run_read(struct file *file, char __user *buf,
+			     size_t count, loff_t *ppos)
+{
+	struct perf_result *res = file->private_data;
+
+	return simple_read_from_buffer(buf, count, ppos, res->buf, res->len);
+}
+
+/* Selects the test to run, by name, or "all" */
+static ssize_t perf_run_write(struct file *file, const char __user *buf,
+			      size_t count, loff_t *ppos)
+{
+	char name[PERF_NAME_SZ];
+
+	if (count >= sizeof(name))
+		return -EINVAL;
+
+	if (copy_from_user(name, buf, count))
+		return -EFAULT;
+
+	name[count] = '\0';
+	strim(name);
+
+	mutex_lock(&perf_lock);
+	strlcpy(perf_select, name[0] ? name : "all", sizeof(perf_select));
+	mutex_unlock(&perf_lock);
+
+	return count;
+}
+
+static int perf_run_release(struct inode *inode, struct file *file)
+{
+	kfree(file->private_data);
+	return 0;
+}
+
+static const struct file_operations perf_run_fops = {
+	.open = perf_run_open,
+	.read = perf_run_read,
+	.write = perf_run_write,
+	.release = perf_run_release,
+	.llseek = no_llseek,
+};
+
+static int perf_iterations_get(void *data, u64 *val)
+{
+	*val = perf_iterations;
+	return 0;
+}
+
+static int perf_iterations_set(void *data, u64 val)
+{
+	if (!val || val > PERF_ITERATIONS_MAX)
+		return -EINVAL;
+
+	mutex_lock(&perf_lock);
+	perf_iterations = val;
+	mutex_unlock(&perf_lock);
+
+	return 0;
+}
+DEFINE_SIMPLE_ATTRIBUTE(perf_iterations_fops, perf_iterations_get,
+			perf_iterations_set, "%llu\n");
+
+/*
+ * SE throughput, through the crypto API so that the Tegra SE drivers are
+ * picked by priority when they are there. The driver in use is printed
+ * once per run, a software fallback shows up as a throughput drop.
+ */
+#define PERF_SE_BUF_SZ		SZ_64K
+
+struct perf_se_result {
+	struct completion done;
+	int err;
+};
+
+static void perf_se_complete(struct crypto_async_request *req, int err)
+{
+	struct perf_se_result *res = req->data;
+
+	if (err == -EINPROGRESS)
+		return;
+
+	res->err = err;
+	complete(&res->done);
+}
+
+static int perf_se_wait(struct perf_se_result *res, int ret)
+{
+	if (ret == -EINPROGRESS || ret == -EBUSY) {
+		wait_for_completion(&res->done);
+		reinit_completion(&res->done);
+		ret = res->err;
+	}
+	return ret;
+}
+
+static struct {
+	void *buf;
+	struct scatterlist sg;
+	struct perf_se_result res;
+	struct crypto_ahash *ahash;
+	struct ahash_request *hreq;
+	struct crypto_skcipher *skcipher;
+	struct skcipher_request *sreq;
+	u8 digest[64];
+	u8 iv[16];
+} perf_se;
+
+static int perf_se_buf_alloc(void)
+{
+	perf_se.buf = kmalloc(PERF_SE_BUF_SZ, GFP_KERNEL);
+	if (!perf_se.buf)
+		return -ENOMEM;
+
+	memset(perf_se.buf, 0x5a, PERF_SE_BUF_SZ);
+	sg_init_one(&perf_se.sg, perf_se.buf, PERF_SE_BUF_SZ);
+	init_completion(&perf_se.res.done);
+
+	return 0;
+}
+
+static int perf_sha_prepare(struct tegra_perf_test *test)
+{
+	int err;
+
+	perf_se.ahash = crypto_alloc_ahash("sha256", 0, 0);
+	if (IS_ERR(perf_se.ahash))
+		return PTR_ERR(perf_se.ahash);
+
+	perf_se.hreq = ahash_request_alloc(perf_se.ahash, GFP_KERNEL);
+	err = perf_se.hreq ? perf_se_buf_alloc() : -ENOMEM;
+	if (err) {
+		ahash_request_free(perf_se.hreq);
+		crypto_free_ahash(perf_se.ahash);
+		return err;
+	}
+
+	ahash_request_set_callback(perf_se.hreq, CRYPTO_TFM_REQ_MAY_BACKLOG,
+				   perf_se_complete, &perf_se.res);
+	ahash_request_set_crypt(perf_se.hreq, &perf_se.sg, perf_se.digest,
+				PERF_SE_BUF_SZ);
+	pr_info("tegra_perf: %s using %s\n", test->name,
+		crypto_tfm_alg_driver_name(crypto_ahash_tfm(perf_se.ahash)));
+
+	return 0;
+}
+
+static int perf_sha_run(struct tegra_perf_test *test, u64 *ns, u64 *bytes)
+{
+	int err = perf_se_wait(&perf_se.res,
+			       crypto_ahash_digest(perf_se.hreq));
+
+	if (!err)
+		*bytes += PERF_SE_BUF_SZ;
+	return err;
+}
+
+static void perf_sha_finish(struct tegra_perf_test *test)
+{
+	kfree(perf_se.buf);
+	ahash_request_free(perf_se.hreq);
+	crypto_free_ahash(perf_se.ahash);
+}
+
+static struct tegra_perf_test perf_sha_test = {
+	.name = "se_sha256",
+	.prepare = perf_sha_prepare,
+	.run = perf_sha_run,
+	.finish = perf_sha_finish,
+};
+
+static int perf_aes_prepare(struct tegra_perf_test *test)
+{
+	static const u8 key[16] = { 0x2b, 0x7e, 0x15, 0x16, 0x28, 0xae, 0xd2,
+				    0xa6, 0xab, 0xf7, 0x15, 0x88, 0x09, 0xcf,
+				    0x4f, 0x3c };
+	int err;
+
+	perf_se.skcipher = crypto_alloc_skcipher("cbc(aes)", 0, 0);
+	if (IS_ERR(perf_se.skcipher))
+		return PTR_ERR(perf_se.skcipher);
+
+	err = crypto_skcipher_setkey(perf_se.skcipher, key, sizeof(key));
+	if (err)
+		goto free_tfm;
+
+	perf_se.sreq = skcipher_request_alloc(perf_se.skcipher, GFP_KERNEL);
+	err = perf_se.sreq ? perf_se_buf_alloc() : -ENOMEM;
+	if (err)
+		goto free_req;
+
+	/* in place, each iteration encrypts the previous ciphertext */
+	skcipher_request_set_callback(perf_se.sreq, CRYPTO_TFM_REQ_MAY_BACKLOG,
+				      perf_se_complete, &perf_se.res);
+	skcipher_request_set_crypt(perf_se.sreq, &perf_se.sg, &perf_se.sg,
+				   PERF_SE_BUF_SZ, perf_se.iv);
+	pr_info("tegra_perf: %s using %s\n", test->name,
+		crypto_tfm_alg_driver_name(
+			crypto_skcipher_tfm(perf_se.skcipher)));
+
+	return 0;
+
+free_req:
+	skcipher_request_free(perf_se.sreq);
+free_tfm:
+	crypto_free_skcipher(perf_se.skcipher);
+	return err;
+}
+
+static int perf_aes_run(struct tegra_perf_test *test, u64 *ns, u64 *bytes)
+{
+	int err = perf_se_wait(&perf_se.res,
+			       crypto_skcipher_encrypt(perf_se.sreq));
+
+	if (!err)
+		*bytes += PERF_SE_BUF_SZ;
+	return err;
+}
+
+static void perf_aes_finish(struct tegra_perf_test *test)
+{
+	kfree(perf_se.buf);
+	skcipher_request_free(perf_se.sreq);
+	crypto_free_skcipher(perf_se.skcipher);
+}
+
+static struct tegra_perf_test perf_aes_test = {
+	.name = "se_aes_cbc",
+	.prepare = perf_aes_prepare,
+	.run = perf_aes_run,
+	.finish = perf_aes_finish,
+};
+
+static int __init tegra_perf_selftest_init(void)
+{
+	struct dentry *dir;
+
+	dir = debugfs_create_dir("tegra_perf", NULL);
+	if (IS_ERR_OR_NULL(dir))
+		return -ENOMEM;
+
+	if (!debugfs_create_file("iterations", S_IRUGO | S_IWUSR, dir, NULL,
+				 &perf_iterations_fops) ||
+	    !debugfs_create_file("run", S_IRUSR | S_IWUSR, dir, NULL,
+				 &perf_run_fops)) {
+		pr_err("tegra_perf: failed to create debugfs\n");
+		debugfs_remove_recursive(dir);
+		return -ENOMEM;
+	}
+
+	tegra_perf_test_register(&perf_sha_test);
+	tegra_perf_test_register(&perf_aes_test);
+
+	return 0;
+}
+late_initcall(tegra_perf_selftest_init);
@@ -55,6 +55,24 @@ arch_initcall(display_tegra_dt_info);
 
 static struct ramoops_platform_data ramoops_data;
 
+/*
+ * Sizes may be overridden from the reserved-memory node, with the property
+ * names of the generic ramoops binding. A bigger record-size keeps more of
+ * the panic log, which pstore compresses when built with a compressor.
+ */
+static unsigned long __init ramoops_size(struct reserved_mem *rmem,
+					 const char *name, unsigned long def)
+{
+	const __be32 *prop;
+	int len;
+
+	prop = of_get_flat_dt_prop(rmem->fdt_node, name, &len);
+	if (!prop || len != sizeof(*prop))
+		return def;
+
+	return be32_to_cpup(prop);
+}
+
 static struct platform_device ramoops_dev = {
 	.name = "ramoops",
 	.dev = {
@@ -66,15 +84,19 @@ static int __init ramoops_init(struct reserved_mem *rmem)
 {
 	ramoops_data.mem_address = rmem->base;
 	ramoops_data.mem_size = rmem->size;
-	ramoops_data.record_size = RECORD_MEM_SIZE;
+	ramoops_data.record_size = ramoops_size(rmem, "record-size",
+						RECORD_MEM_SIZE);
 #ifdef CONFIG_PSTORE_CONSOLE
-	ramoops_data.console_size = CONSOLE_MEM_SIZE;
+	ramoops_data.console_size = ramoops_size(rmem, "console-size",
+						 CONSOLE_MEM_SIZE);
 #endif
 #ifdef CONFIG_PSTORE_FTRACE
-	ramoops_data.ftrace_size = FTRACE_MEM_SIZE;
+	ramoops_data.ftrace_size = ramoops_size(rmem, "ftrace-size",
+						FTRACE_MEM_SIZE);
 #endif
 #ifdef CONFIG_PSTORE_PMSG
-	ramoops_data.pmsg_size = PMSG_MEM_SIZE;
+	ramoops_data.pmsg_size = ramoops_size(rmem, "pmsg-size",
+					      PMSG_MEM_SIZE);
 #endif
 
 	ramoops_data.dump_oops = 1;
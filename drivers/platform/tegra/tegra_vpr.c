@@ -17,6 +17,7 @@
 #include <linux/dma-mapping.h>
 #include <linux/ote_protocol.h>
 #include <linux/delay.h>
+#include <linux/ktime.h>
 
 extern phys_addr_t tegra_vpr_start;
 extern phys_addr_t tegra_vpr_size;
@@ -51,14 +52,36 @@ static struct vpr_user_module_info {
 } vpr_user_module[NUM_MODULES_IDLE_VPR_RESIZE];
 static int _tegra_set_vpr_params(void *vpr_base, size_t vpr_size);
 
+/* call with vpr_lock held, unidles modules [0, n) */
+static void tegra_vpr_unidle(int n)
+{
+	int i, err;
+
+	for (i = n - 1; i >= 0; i--) {
+		if (!vpr_user_module[i].do_unidle)
+			continue;
+
+		err = vpr_user_module[i].do_unidle(
+				vpr_user_module[i].data);
+		if (!err)
+			continue;
+		pr_err("%s:%d: %pF failed err:%d. Could be fatal!!\n",
+			 __func__, __LINE__,
+			vpr_user_module[i].do_unidle, err);
+	}
+}
+
 static int tegra_update_resize_cfg(phys_addr_t base , size_t size)
 {
-	int i = 0, err = 0;
+	int i, err = 0;
 #define MAX_RETRIES 6
 	int retries = MAX_RETRIES;
+	u64 idle_ns;
+
 	mutex_lock(&vpr_lock);
 retry:
-	for (; i < NUM_MODULES_IDLE_VPR_RESIZE; i++) {
+	idle_ns = ktime_get_ns();
+	for (i = 0; i < NUM_MODULES_IDLE_VPR_RESIZE; i++) {
 		if (vpr_user_module[i].do_idle) {
 			err = vpr_user_module[i].do_idle(
 					vpr_user_module[i].data);
@@ -76,29 +99,20 @@ retry:
 		if (err)
 			pr_err("vpr resize to (%p, %zu) failed. err=%d\n",
 				(void *)(uintptr_t)base, size, err);
-		else
-			retries = 0; /* finish */
 	}
-	if (retries--) {
+	/*
+	 * Let display and decode run again before backing off, the engines
+	 * that did idle would otherwise stay frozen for the whole retry.
+	 */
+	tegra_vpr_unidle(i);
+	pr_debug("%s: idled engines for %llu us\n", __func__,
+		 div_u64(ktime_get_ns() - idle_ns, NSEC_PER_USEC));
+	if (err && retries--) {
 		pr_err("%s:%d: fail retry=%d",
 			__func__, __LINE__, MAX_RETRIES - retries);
 		msleep(1);
 		goto retry;
 	}
-	while (--i >= 0) {
-		if (!vpr_user_module[i].do_unidle)
-			continue;
-
-		err = vpr_user_module[i].do_unidle(
-				vpr_user_module[i].data);
-		if (!err)
-			continue;
-		pr_err("%s:%d: %pF failed err:%d. Could be fatal!!\n",
-			 __func__, __LINE__,
-			vpr_user_module[i].do_unidle, err);
-		/* vpr resize is success, so return 0 on unidle failure */
-		err = 0;
-	}
 	mutex_unlock(&vpr_lock);
 	return err;
 }
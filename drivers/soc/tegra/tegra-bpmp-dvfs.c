@@ -17,12 +17,25 @@
 #include <linux/clk.h>
 #include <linux/export.h>
 #include <linux/err.h>
+#include <linux/mutex.h>
 #include <soc/tegra/tegra_bpmp.h>
 #include <soc/tegra/bpmp_abi.h>
 #include <soc/tegra/tegra-bpmp-dvfs.h>
 
 #define BPMP_CLK_CMD(cmd, id) ((id) | ((cmd) << 24))
 
+/*
+ * fmax at vmin holds at all temperatures, so it does not change at run
+ * time. Governors look it up often, keep what BPMP answered so far.
+ */
+#define FMAX_AT_VMIN_CACHE	16
+
+static struct {
+	int clk_id;
+	unsigned long rate;
+} fmax_at_vmin_cache[FMAX_AT_VMIN_CACHE];
+static DEFINE_MUTEX(fmax_at_vmin_lock);
+
 static int64_t bpmp_dvfs_get_fmax_at_vmin(int clk_id)
 {
 	struct mrq_clk_request req;
@@ -45,13 +58,35 @@ static int64_t bpmp_dvfs_get_fmax_at_vmin(int clk_id)
 unsigned long tegra_bpmp_dvfs_get_fmax_at_vmin(int clk_id)
 {
 	int64_t rate;
+	int i;
+
+	if (clk_id <= 0)
+		return 0;
+
+	mutex_lock(&fmax_at_vmin_lock);
+	for (i = 0; i < FMAX_AT_VMIN_CACHE; i++) {
+		if (fmax_at_vmin_cache[i].clk_id == clk_id) {
+			rate = fmax_at_vmin_cache[i].rate;
+			goto out;
+		}
+		if (!fmax_at_vmin_cache[i].clk_id)
+			break;
+	}
+
+	rate = bpmp_dvfs_get_fmax_at_vmin(clk_id);
+	if (rate <= 0) {
+		rate = 0;
+		goto out;
+	}
 
-	if (clk_id > 0) {
-		rate = bpmp_dvfs_get_fmax_at_vmin(clk_id);
-		if (rate > 0)
-			return rate;
+	/* failures are not cached, and neither are clocks past the table */
+	if (i < FMAX_AT_VMIN_CACHE) {
+		fmax_at_vmin_cache[i].rate = rate;
+		fmax_at_vmin_cache[i].clk_id = clk_id;
 	}
-	return 0;
+out:
+	mutex_unlock(&fmax_at_vmin_lock);
+	return rate;
 }
 EXPORT_SYMBOL(tegra_bpmp_dvfs_get_fmax_at_vmin);
 
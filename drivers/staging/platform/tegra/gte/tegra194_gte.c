@@ -33,6 +33,9 @@
 #include <linux/file.h>
 #include <linux/poll.h>
 #include <linux/kfifo.h>
+#include <linux/mm.h>
+#include <linux/sizes.h>
+#include <linux/vmalloc.h>
 #include <uapi/linux/tegra-gte-ioctl.h>
 
 #define GTE_SUSPEND	0
@@ -135,6 +138,7 @@ static LIST_HEAD(gte_devices);
 #define GTE_EVENT_UNREGISTERING		1
 
 #define GTE_EV_FIFO_EL			32
+#define GTE_EV_RING_MAX_SZ		SZ_1M
 #define GTE_MAX_EV_NAME_SZ		9
 
 struct gte_slices {
@@ -603,17 +607,48 @@ struct gte_uspace_event_state {
 	struct mutex read_lock;
 	DECLARE_KFIFO(events, struct tegra_gte_hts_event_data, GTE_EV_FIFO_EL);
 	struct tegra_gte_ev_desc *gte_data;
+	/*
+	 * mmap'd ring, replaces the kfifo once mapped. head and overflow are
+	 * kept here too as user space can write to the shared header.
+	 */
+	struct tegra_gte_hts_ring *ring;
+	u32 ring_entries;
+	u32 ring_head;
+	u32 ring_overflow;
 };
 
+/* Called from the event irq thread only, the single producer */
+static bool gte_event_ring_put(struct gte_uspace_event_state *le,
+			       struct tegra_gte_hts_ring *ring,
+			       const struct tegra_gte_hts_event_data *ge)
+{
+	u32 head = le->ring_head;
+
+	if (head - READ_ONCE(ring->tail) >= le->ring_entries) {
+		WRITE_ONCE(ring->overflow, ++le->ring_overflow);
+		return false;
+	}
+
+	ring->events[head % le->ring_entries] = *ge;
+	le->ring_head = head + 1;
+	/* publish the event before the index */
+	smp_store_release(&ring->head, le->ring_head);
+
+	return true;
+}
+
 static unsigned int gte_event_poll(struct file *filep,
 				   struct poll_table_struct *wait)
 {
 	struct gte_uspace_event_state *le = filep->private_data;
 	unsigned int events = 0;
 
+	struct tegra_gte_hts_ring *ring = smp_load_acquire(&le->ring);
+
 	poll_wait(filep, &le->wait, wait);
 
-	if (!kfifo_is_empty(&le->events))
+	if (!kfifo_is_empty(&le->events) ||
+	    (ring && READ_ONCE(ring->tail) != READ_ONCE(le->ring_head)))
 		events = POLLIN | POLLRDNORM;
 
 	return events;
@@ -674,38 +709,91 @@ static int gte_event_release(struct inode *inode, struct file *filep)
 	gpio_free(le->gpio_in);
 	kfree(le->irqname);
 	kfree(le->label);
+	vfree(le->ring);
 	kfree(le);
 	put_device(&gdev->c_dev);
 	return 0;
 }
 
+/*
+ * Maps a struct tegra_gte_hts_ring sized by the mapping. From then on events
+ * are delivered to the ring only, read() returns what was queued before.
+ */
+static int gte_event_mmap(struct file *filep, struct vm_area_struct *vma)
+{
+	struct gte_uspace_event_state *le = filep->private_data;
+	struct tegra_gte_hts_ring *ring;
+	unsigned long size = vma->vm_end - vma->vm_start;
+	int ret;
+
+	if (vma->vm_pgoff || size > GTE_EV_RING_MAX_SZ ||
+	    size < sizeof(*ring) + sizeof(ring->events[0]))
+		return -EINVAL;
+
+	if (mutex_lock_interruptible(&le->read_lock))
+		return -ERESTARTSYS;
+
+	if (le->ring) {
+		ret = -EBUSY;
+		goto unlock;
+	}
+
+	ring = vmalloc_user(size);
+	if (!ring) {
+		ret = -ENOMEM;
+		goto unlock;
+	}
+
+	ret = remap_vmalloc_range(vma, ring, 0);
+	if (ret) {
+		vfree(ring);
+		goto unlock;
+	}
+
+	le->ring_entries = (size - sizeof(*ring)) / sizeof(ring->events[0]);
+	ring->entries = le->ring_entries;
+	smp_store_release(&le->ring, ring);
+
+unlock:
+	mutex_unlock(&le->read_lock);
+	return ret;
+}
+
 static const struct file_operations gte_event_fileops = {
 	.release = gte_event_release,
 	.read = gte_event_read,
 	.poll = gte_event_poll,
+	.mmap = gte_event_mmap,
 	.owner = THIS_MODULE,
 	.llseek = noop_llseek,
 };
 
 static irqreturn_t gte_event_irq_thread(int irq, void *p)
 {
-	int ret;
 	struct gte_uspace_event_state *le = p;
+	struct tegra_gte_hts_ring *ring = smp_load_acquire(&le->ring);
 	struct tegra_gte_hts_event_data ge;
 	struct tegra_gte_ev_detail hw;
+	unsigned int n = 0;
 
+	/*
+	 * Edges that came in while the thread was running are already in the
+	 * GTE fifo, take all of them and wake the reader once.
+	 */
 	memset(&ge, 0, sizeof(ge));
-	ret = tegra_gte_retrieve_event(le->gte_data, &hw);
-	if (ret == 0) {
+	while (tegra_gte_retrieve_event(le->gte_data, &hw) == 0) {
 		ge.timestamp = hw.ts_ns;
 		ge.dir = hw.dir;
-	} else {
-		dev_dbg(le->gdev->pdev, "failed to retrieve event\n");
-		return IRQ_HANDLED;
+
+		if (ring) {
+			if (gte_event_ring_put(le, ring, &ge))
+				n++;
+		} else if (kfifo_put(&le->events, ge)) {
+			n++;
+		}
 	}
 
-	ret = kfifo_put(&le->events, ge);
-	if (ret != 0)
+	if (n)
 		wake_up_poll(&le->wait, POLLIN);
 
 	return IRQ_HANDLED;
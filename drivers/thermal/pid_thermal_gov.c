@@ -32,6 +32,8 @@
 #define MAX_DOUT_DEFAULT		0
 #define UP_COMPENSATION_DEFAULT		20
 #define DOWN_COMPENSATION_DEFAULT	20
+#define MPC_HORIZON_DEFAULT		0	/* in ms */
+#define MPC_GAIN_DEFAULT		2000	/* in mC/s */
 
 static struct pid_thermal_gov_params pm_default = {
 	.max_err_temp		= MAX_ERR_TEMP_DEFAULT,
@@ -41,6 +43,8 @@ static struct pid_thermal_gov_params pm_default = {
 	.max_dout		= MAX_DOUT_DEFAULT,
 	.up_compensation	= UP_COMPENSATION_DEFAULT,
 	.down_compensation	= DOWN_COMPENSATION_DEFAULT,
+	.mpc_horizon		= MPC_HORIZON_DEFAULT,
+	.mpc_gain		= MPC_GAIN_DEFAULT,
 };
 
 struct pid_thermal_gov_attribute {
@@ -279,6 +283,66 @@ static struct pid_thermal_gov_attribute down_compensation_attr =
 	__ATTR(down_compensation, 0644,
 	       down_compensation_show, down_compensation_store);
 
+static ssize_t mpc_horizon_show(struct kobject *kobj,
+			       struct attribute *attr, char *buf)
+{
+	struct pid_thermal_governor *gov = kobj_to_gov(kobj);
+
+	if (!gov)
+		return -ENODEV;
+
+	return sprintf(buf, "%lu\n", gov->pm.mpc_horizon);
+}
+
+static ssize_t mpc_horizon_store(struct kobject *kobj, struct attribute *attr,
+				const char *buf, size_t count)
+{
+	struct pid_thermal_governor *gov = kobj_to_gov(kobj);
+	unsigned long val;
+
+	if (!gov)
+		return -ENODEV;
+
+	if (!sscanf(buf, "%lu\n", &val))
+		return -EINVAL;
+
+	gov->pm.mpc_horizon = val;
+	return count;
+}
+
+static struct pid_thermal_gov_attribute mpc_horizon_attr =
+	__ATTR(mpc_horizon, 0644, mpc_horizon_show, mpc_horizon_store);
+
+static ssize_t mpc_gain_show(struct kobject *kobj,
+			       struct attribute *attr, char *buf)
+{
+	struct pid_thermal_governor *gov = kobj_to_gov(kobj);
+
+	if (!gov)
+		return -ENODEV;
+
+	return sprintf(buf, "%lu\n", gov->pm.mpc_gain);
+}
+
+static ssize_t mpc_gain_store(struct kobject *kobj, struct attribute *attr,
+				const char *buf, size_t count)
+{
+	struct pid_thermal_governor *gov = kobj_to_gov(kobj);
+	unsigned long val;
+
+	if (!gov)
+		return -ENODEV;
+
+	if (!sscanf(buf, "%lu\n", &val))
+		return -EINVAL;
+
+	gov->pm.mpc_gain = val;
+	return count;
+}
+
+static struct pid_thermal_gov_attribute mpc_gain_attr =
+	__ATTR(mpc_gain, 0644, mpc_gain_show, mpc_gain_store);
+
 static struct attribute *pid_thermal_gov_default_attrs[] = {
 	&max_err_temp_attr.attr,
 	&max_err_gain_attr.attr,
@@ -287,6 +351,8 @@ static struct attribute *pid_thermal_gov_default_attrs[] = {
 	&max_dout_attr.attr,
 	&up_compensation_attr.attr,
 	&down_compensation_attr.attr,
+	&mpc_horizon_attr.attr,
+	&mpc_gain_attr.attr,
 	NULL,
 };
 
@@ -378,6 +444,56 @@ static void pid_thermal_gov_update_passive(struct thermal_zone_device *tz,
 		tz->passive--;
 }
 
+/*
+ * Temperature expected mpc_horizon ms from now if it keeps changing as
+ * it did over the last sample, or the current one if there is no trend.
+ */
+static s64 pid_thermal_gov_predict(struct thermal_zone_device *tz,
+				   struct pid_thermal_governor *gov)
+{
+	int delay = tz->passive ? tz->passive_delay : tz->polling_delay;
+	s64 delta = (s64)tz->temperature - (s64)tz->last_temperature;
+
+	if (!delay)
+		return tz->temperature;
+
+	return tz->temperature +
+		div64_s64(delta * (s64)gov->pm.mpc_horizon, delay);
+}
+
+/*
+ * Predictive target: the state change that turns the expected drift
+ * over the horizon into just reaching trip_temp at the end of it. Each
+ * step of state is assumed to cool by an equal share of mpc_gain, so
+ * only as much throttling as needed is applied, and it is released as
+ * soon as the trajectory has margin.
+ */
+static unsigned long
+pid_thermal_gov_mpc_target(struct thermal_zone_device *tz,
+			   struct pid_thermal_governor *gov,
+			   unsigned long cur_state, unsigned long max_state,
+			   int trip_temp)
+{
+	s64 excess, steps, target;
+
+	if (!gov->pm.mpc_gain)
+		return cur_state;
+
+	/* mC/s the zone has to cool faster by to end up at trip_temp */
+	excess = pid_thermal_gov_predict(tz, gov) - (s64)trip_temp;
+	excess = div64_s64(excess * MSEC_PER_SEC, gov->pm.mpc_horizon);
+
+	steps = excess * (s64)max_state;
+	if (steps > 0)
+		steps += gov->pm.mpc_gain - 1;
+	steps = div64_s64(steps, gov->pm.mpc_gain);
+
+	target = (s64)cur_state + steps;
+	target = clamp_t(s64, target, 0, (s64)max_state);
+
+	return (unsigned long)target;
+}
+
 static unsigned long
 pid_thermal_gov_get_target(struct thermal_zone_device *tz,
 			   struct thermal_cooling_device *cdev,
@@ -396,6 +512,12 @@ pid_thermal_gov_get_target(struct thermal_zone_device *tz,
 	if (cdev->ops->get_cur_state(cdev, &cur_state) < 0)
 		return 0;
 
+	if (gov->pm.mpc_horizon) {
+		target = pid_thermal_gov_mpc_target(tz, gov, cur_state,
+						    max_state, trip_temp);
+		goto compensate;
+	}
+
 	max_err = (s64)gov->pm.max_err_temp * (s64)gov->pm.max_err_gain;
 
 	/* Calculate proportional term */
@@ -420,6 +542,7 @@ pid_thermal_gov_get_target(struct thermal_zone_device *tz,
 	sum_err = sum_err * max_state + max_err - 1;
 	target = (unsigned long)div64_s64(sum_err, max_err);
 
+compensate:
 	/* Apply compensation */
 	if (target == cur_state)
 		return target;
@@ -440,10 +563,12 @@ pid_thermal_gov_get_target(struct thermal_zone_device *tz,
 
 static int pid_thermal_gov_throttle(struct thermal_zone_device *tz, int trip)
 {
+	struct pid_thermal_governor *gov = tz_to_gov(tz);
 	struct thermal_instance *instance;
 	enum thermal_trip_type trip_type;
 	int trip_temp, hyst = 0;
 	unsigned long target;
+	s64 temp;
 
 	tz->ops->get_trip_type(tz, trip, &trip_type);
 	tz->ops->get_trip_temp(tz, trip, &trip_temp);
@@ -452,9 +577,14 @@ static int pid_thermal_gov_throttle(struct thermal_zone_device *tz, int trip)
 
 	mutex_lock(&tz->lock);
 
+	/* in predictive mode start throttling before the trip is crossed */
+	temp = tz->temperature;
+	if (gov->pm.mpc_horizon)
+		temp = max(temp, pid_thermal_gov_predict(tz, gov));
+
 	list_for_each_entry(instance, &tz->thermal_instances, tz_node) {
 		if ((instance->trip != trip) ||
-				((tz->temperature < trip_temp) &&
+				((temp < trip_temp) &&
 				 (instance->target == THERMAL_NO_TARGET)))
 			continue;
 
@@ -467,7 +597,7 @@ static int pid_thermal_gov_throttle(struct thermal_zone_device *tz, int trip)
 				     instance->upper);
 		}
 
-		if ((tz->temperature < trip_temp - hyst) &&
+		if ((temp < trip_temp - hyst) &&
 				(instance->target == instance->lower) &&
 				(target == instance->lower))
 			target = THERMAL_NO_TARGET;
@@ -516,6 +646,10 @@ static int pid_thermal_gov_of_parse(struct thermal_zone_params *tzp,
 		gpm->up_compensation = val;
 	if (!of_property_read_u32(np, "down_compensation", &val))
 		gpm->down_compensation = val;
+	if (!of_property_read_u32(np, "mpc_horizon", &val))
+		gpm->mpc_horizon = val;
+	if (!of_property_read_u32(np, "mpc_gain", &val))
+		gpm->mpc_gain = val;
 
 	tzp->governor_params = gpm;
 	return 0;
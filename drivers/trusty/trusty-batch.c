@@ -0,0 +1,161 @@
+/*
+ * Copyright (c) 2021, NVIDIA CORPORATION. All rights reserved.
+ *
+ * This software is licensed under the terms of the GNU General Public
+ * License version 2, as published by the Free Software Foundation, and
+ * may be copied, distributed, and modified under those terms.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ */
+
+/*
+ * Batched standard calls.
+ *
+ * Commands are queued in a page shared with trusty and handed over with
+ * one SMC_SC_BATCH, so a burst of small commands costs one world switch
+ * instead of one per command. Trusty runs them in order, stores each
+ * result in its slot and returns how many it ran. Against a trusty that
+ * does not know SMC_SC_BATCH the commands are issued one by one.
+ */
+
+#include <linux/gfp.h>
+#include <linux/module.h>
+#include <linux/slab.h>
+#include <linux/trusty/smcall.h>
+#include <linux/trusty/trusty.h>
+
+struct trusty_batch {
+	struct device *dev;
+	struct trusty_batch_cmd *cmds;	/* page shared with trusty */
+	unsigned int n;			/* queued */
+	unsigned int done;		/* results of the last submit */
+};
+
+/* cleared the first time trusty rejects SMC_SC_BATCH */
+static bool trusty_batch_supported = true;
+
+struct trusty_batch *trusty_batch_alloc(struct device *dev)
+{
+	struct trusty_batch *batch;
+
+	batch = kzalloc(sizeof(*batch), GFP_KERNEL);
+	if (!batch)
+		return NULL;
+
+	batch->cmds = (void *)get_zeroed_page(GFP_KERNEL);
+	if (!batch->cmds) {
+		kfree(batch);
+		return NULL;
+	}
+
+	batch->dev = dev;
+	return batch;
+}
+EXPORT_SYMBOL(trusty_batch_alloc);
+
+void trusty_batch_free(struct trusty_batch *batch)
+{
+	if (!batch)
+		return;
+
+	free_page((unsigned long)batch->cmds);
+	kfree(batch);
+}
+EXPORT_SYMBOL(trusty_batch_free);
+
+/* Returns the slot of the command, or -ENOSPC once TRUSTY_BATCH_MAX are queued */
+int trusty_batch_add(struct trusty_batch *batch, u32 smcnr,
+		     u32 a0, u32 a1, u32 a2)
+{
+	struct trusty_batch_cmd *cmd;
+
+	if (WARN_ON(SMC_IS_FASTCALL(smcnr) || SMC_IS_SMC64(smcnr)))
+		return -EINVAL;
+
+	if (batch->n == TRUSTY_BATCH_MAX)
+		return -ENOSPC;
+
+	batch->done = 0;
+
+	cmd = &batch->cmds[batch->n];
+	cmd->smcnr = smcnr;
+	cmd->args[0] = a0;
+	cmd->args[1] = a1;
+	cmd->args[2] = a2;
+	cmd->ret = SM_ERR_NOT_SUPPORTED;
+	return batch->n++;
+}
+EXPORT_SYMBOL(trusty_batch_add);
+
+s32 trusty_batch_result(struct trusty_batch *batch, unsigned int i)
+{
+	if (WARN_ON(i >= batch->done))
+		return SM_ERR_INVALID_PARAMETERS;
+
+	return READ_ONCE(batch->cmds[i].ret);
+}
+EXPORT_SYMBOL(trusty_batch_result);
+
+static void trusty_batch_run_each(struct trusty_batch *batch, unsigned int i)
+{
+	struct trusty_batch_cmd *cmd;
+
+	for (; i < batch->n; i++) {
+		cmd = &batch->cmds[i];
+		cmd->ret = trusty_std_call32(batch->dev, cmd->smcnr,
+					     cmd->args[0], cmd->args[1],
+					     cmd->args[2]);
+	}
+}
+
+/*
+ * Runs the queued commands in order and empties the queue, their results
+ * can be read with trusty_batch_result() until the next trusty_batch_add().
+ * Returns 0, or the error of the batch call itself.
+ */
+int trusty_batch_submit(struct trusty_batch *batch)
+{
+	unsigned int n = batch->n;
+	s32 ret;
+
+	if (!n)
+		return 0;
+
+	/* a single command does not win anything from the shared page */
+	if (n == 1 || !trusty_batch_supported) {
+		trusty_batch_run_each(batch, 0);
+		goto done;
+	}
+
+	ret = trusty_call32_mem_buf(batch->dev, SMC_SC_BATCH,
+				    virt_to_page(batch->cmds),
+				    n * sizeof(*batch->cmds), PAGE_KERNEL);
+	if (ret == SM_ERR_UNDEFINED_SMC || ret == SM_ERR_NOT_SUPPORTED) {
+		dev_info(batch->dev, "%s: no batch support, falling back\n",
+			 __func__);
+		trusty_batch_supported = false;
+		ret = 0;
+	}
+	if (ret < 0) {
+		dev_err(batch->dev, "%s: SMC_SC_BATCH failed %d\n",
+			__func__, ret);
+		batch->n = 0;
+		batch->done = 0;
+		return ret;
+	}
+
+	/* whatever trusty did not get to is issued on its own */
+	trusty_batch_run_each(batch, min_t(unsigned int, ret, n));
+	trusty_account_batch(batch->dev, ret);
+done:
+	batch->done = n;
+	batch->n = 0;
+	return 0;
+}
+EXPORT_SYMBOL(trusty_batch_submit);
+
+MODULE_LICENSE("GPL v2");
@@ -30,6 +30,8 @@
 #endif /* LINUX_VERSION_CODE >= KERNEL_VERSION(4, 14, 0) */
 #include <linux/compat.h>
 #include <linux/uio.h>
+#include <linux/mm.h>
+#include <linux/vmalloc.h>
 
 #include <linux/virtio.h>
 #include <linux/virtio_ids.h>
@@ -84,6 +86,11 @@ enum tipc_ctrl_msg_types {
 	TIPC_CTRL_MSGTYPE_CONN_REQ,
 	TIPC_CTRL_MSGTYPE_CONN_RSP,
 	TIPC_CTRL_MSGTYPE_DISC_REQ,
+	/* shared memory, kept clear of the message types above */
+	TIPC_CTRL_MSGTYPE_SHM_REG_REQ = 0x100,
+	TIPC_CTRL_MSGTYPE_SHM_REG_RSP,
+	TIPC_CTRL_MSGTYPE_SHM_UNREG_REQ,
+	TIPC_CTRL_MSGTYPE_SHM_UNREG_RSP,
 };
 
 struct tipc_ctrl_msg {
@@ -108,6 +115,28 @@ struct tipc_disc_req_body {
 	u32 target;
 } __packed;
 
+/* page_list is the encoded page of an array of page_cnt encoded pages */
+struct tipc_shm_reg_req_body {
+	u32 target;
+	u32 cookie;
+	u64 page_list;
+	u32 page_cnt;
+	u32 reserved;
+	u64 size;
+} __packed;
+
+struct tipc_shm_unreg_req_body {
+	u32 target;
+	u32 cookie;
+	u64 handle;
+} __packed;
+
+struct tipc_shm_rsp_body {
+	u32 cookie;
+	u32 status;
+	u64 handle;
+} __packed;
+
 struct tipc_cdev_node {
 	struct cdev cdev;
 	struct device *dev;
@@ -133,6 +162,7 @@ struct tipc_virtio_dev {
 	struct list_head free_buf_list;
 	wait_queue_head_t sendq;
 	struct idr addr_idr;
+	struct idr shm_idr; /* shared memory waiting for a response */
 	enum tipc_device_state state;
 	struct tipc_cdev_node cdev_node;
 	char   cdev_name[MAX_DEV_NAME_LEN];
@@ -723,6 +753,229 @@ EXPORT_SYMBOL(tipc_chan_destroy);
 
 /***************************************************************************/
 
+struct tipc_shm_region {
+	struct tipc_shm shm;
+	struct tipc_chan *chan;
+	struct page **pages;
+	unsigned int page_cnt;
+	struct ns_mem_page_info *pg_list;
+	size_t pg_list_sz;
+	struct completion done;
+	int cookie;
+	u32 status;
+};
+
+static void _shm_free(struct tipc_shm_region *reg)
+{
+	unsigned int i;
+
+	if (reg->shm.va)
+		vunmap(reg->shm.va);
+	if (reg->pg_list)
+		_free_shareable_mem(reg->pg_list_sz, reg->pg_list, 0);
+	for (i = 0; i < reg->page_cnt; i++)
+		if (reg->pages[i])
+			__free_page(reg->pages[i]);
+	kfree(reg->pages);
+	kfree(reg);
+}
+
+/* sends a shared memory control message and waits for its response */
+static int _shm_ctrl_call(struct tipc_shm_region *reg, u32 type,
+			  void *body, size_t body_len)
+{
+	struct tipc_chan *chan = reg->chan;
+	struct tipc_ctrl_msg *msg;
+	struct tipc_msg_buf *txbuf;
+	long ret;
+	int err;
+
+	txbuf = vds_get_txbuf(chan->vds, TXBUF_TIMEOUT);
+	if (IS_ERR(txbuf))
+		return PTR_ERR(txbuf);
+
+	msg = mb_put_data(txbuf, sizeof(*msg) + body_len);
+	msg->type = type;
+	msg->body_len = body_len;
+	memcpy(msg->body, body, body_len);
+
+	reinit_completion(&reg->done);
+
+	mutex_lock(&chan->lock);
+	if (chan->state == TIPC_CONNECTED) {
+		fill_msg_hdr(txbuf, chan->local, TIPC_CTRL_ADDR);
+		err = vds_queue_txbuf(chan->vds, txbuf);
+		if (err)
+			pr_err("%s: failed to queue tx buffer (%d)\n",
+			       __func__, err);
+		else
+			txbuf = NULL; /* prevents discarding buffer */
+	} else {
+		err = -ENOTCONN;
+	}
+	mutex_unlock(&chan->lock);
+
+	if (txbuf)
+		tipc_chan_put_txbuf(chan, txbuf);
+	if (err)
+		return err;
+
+	ret = wait_for_completion_timeout(&reg->done,
+					  msecs_to_jiffies(REPLY_TIMEOUT));
+	if (!ret)
+		return -ETIMEDOUT;
+
+	return reg->status == NO_ERROR ? 0 : -EIO;
+}
+
+/*
+ * tipc_shm_create - allocate memory and register it with the service
+ * the channel is connected to. The service maps it once, messages then
+ * carry a struct tipc_shm_ref to point at the data in it.
+ */
+struct tipc_shm *tipc_shm_create(struct tipc_chan *chan, size_t size)
+{
+	struct tipc_virtio_dev *vds = chan->vds;
+	struct tipc_shm_reg_req_body body;
+	struct ns_mem_page_info list_inf;
+	struct tipc_shm_region *reg;
+	unsigned int i;
+	int err;
+
+	if (!is_trusty_dev_enabled())
+		return ERR_PTR(-ENODEV);
+
+	if (!size || size > U32_MAX * (u64)PAGE_SIZE)
+		return ERR_PTR(-EINVAL);
+
+	reg = kzalloc(sizeof(*reg), GFP_KERNEL);
+	if (!reg)
+		return ERR_PTR(-ENOMEM);
+
+	reg->chan = chan;
+	reg->shm.size = size;
+	reg->page_cnt = DIV_ROUND_UP(size, PAGE_SIZE);
+	init_completion(&reg->done);
+
+	err = -ENOMEM;
+	reg->pages = kcalloc(reg->page_cnt, sizeof(*reg->pages), GFP_KERNEL);
+	if (!reg->pages)
+		goto err_free;
+
+	for (i = 0; i < reg->page_cnt; i++) {
+		reg->pages[i] = alloc_page(GFP_KERNEL | __GFP_ZERO);
+		if (!reg->pages[i])
+			goto err_free;
+	}
+
+	reg->shm.va = vmap(reg->pages, reg->page_cnt, VM_MAP, PAGE_KERNEL);
+	if (!reg->shm.va)
+		goto err_free;
+
+	/* the page list itself is contiguous, one entry describes it */
+	reg->pg_list_sz = PAGE_ALIGN(reg->page_cnt * sizeof(*reg->pg_list));
+	reg->pg_list = _alloc_shareable_mem(reg->pg_list_sz, NULL,
+					    GFP_KERNEL | __GFP_ZERO);
+	if (!reg->pg_list)
+		goto err_free;
+
+	err = trusty_encode_page_list(reg->pg_list, reg->pages, reg->page_cnt,
+				      PAGE_KERNEL);
+	if (!err)
+		err = trusty_encode_page_info(&list_inf,
+					      virt_to_page(reg->pg_list),
+					      PAGE_KERNEL);
+	if (err)
+		goto err_free;
+
+	mutex_lock(&vds->lock);
+	reg->cookie = idr_alloc(&vds->shm_idr, reg, 1, 0, GFP_KERNEL);
+	mutex_unlock(&vds->lock);
+	if (reg->cookie < 0) {
+		err = reg->cookie;
+		goto err_free;
+	}
+
+	mutex_lock(&chan->lock);
+	body.target = chan->remote;
+	mutex_unlock(&chan->lock);
+	body.cookie = reg->cookie;
+	body.page_list = list_inf.attr;
+	body.page_cnt = reg->page_cnt;
+	body.reserved = 0;
+	body.size = size;
+
+	err = _shm_ctrl_call(reg, TIPC_CTRL_MSGTYPE_SHM_REG_REQ,
+			     &body, sizeof(body));
+	if (err == -ETIMEDOUT) {
+		/* secure side may still map it later, never reuse the pages */
+		pr_err("%s: no response, leaking %zu bytes\n", __func__, size);
+		mutex_lock(&vds->lock);
+		idr_remove(&vds->shm_idr, reg->cookie);
+		mutex_unlock(&vds->lock);
+		return ERR_PTR(err);
+	}
+	if (err) {
+		mutex_lock(&vds->lock);
+		idr_remove(&vds->shm_idr, reg->cookie);
+		mutex_unlock(&vds->lock);
+		goto err_free;
+	}
+
+	return &reg->shm;
+
+err_free:
+	_shm_free(reg);
+	return ERR_PTR(err);
+}
+EXPORT_SYMBOL(tipc_shm_create);
+
+/*
+ * tipc_shm_destroy - unregister and free shared memory. Memory the service
+ * did not give back is leaked rather than reused.
+ */
+int tipc_shm_destroy(struct tipc_shm *shm)
+{
+	struct tipc_shm_region *reg;
+	struct tipc_shm_unreg_req_body body;
+	struct tipc_virtio_dev *vds;
+	int err;
+
+	if (!is_trusty_dev_enabled())
+		return -ENODEV;
+
+	if (IS_ERR_OR_NULL(shm))
+		return -EINVAL;
+
+	reg = container_of(shm, struct tipc_shm_region, shm);
+	vds = reg->chan->vds;
+
+	mutex_lock(&reg->chan->lock);
+	body.target = reg->chan->remote;
+	mutex_unlock(&reg->chan->lock);
+	body.cookie = reg->cookie;
+	body.handle = shm->handle;
+
+	err = _shm_ctrl_call(reg, TIPC_CTRL_MSGTYPE_SHM_UNREG_REQ,
+			     &body, sizeof(body));
+
+	mutex_lock(&vds->lock);
+	idr_remove(&vds->shm_idr, reg->cookie);
+	mutex_unlock(&vds->lock);
+
+	if (err) {
+		pr_err("%s: unregister failed (%d), leaking %zu bytes\n",
+		       __func__, err, shm->size);
+		return err;
+	}
+
+	_shm_free(reg);
+	return 0;
+}
+EXPORT_SYMBOL(tipc_shm_destroy);
+
+/***************************************************************************/
+
 struct tipc_dn_chan {
 	int state;
 	struct mutex lock; /* protects rx_msg_queue list and channel state */
@@ -1395,6 +1648,29 @@ static void _handle_disc_req(struct tipc_virtio_dev *vds,
 	}
 }
 
+static void _handle_shm_rsp(struct tipc_virtio_dev *vds,
+			    struct tipc_shm_rsp_body *rsp, size_t len,
+			    u32 type)
+{
+	struct tipc_shm_region *reg;
+
+	if (sizeof(*rsp) != len) {
+		dev_err(&vds->vdev->dev, "%s: Invalid response length %zd\n",
+			__func__, len);
+		return;
+	}
+
+	mutex_lock(&vds->lock);
+	reg = idr_find(&vds->shm_idr, rsp->cookie);
+	if (reg) {
+		reg->status = rsp->status;
+		if (type == TIPC_CTRL_MSGTYPE_SHM_REG_RSP)
+			reg->shm.handle = rsp->handle;
+		complete(&reg->done);
+	}
+	mutex_unlock(&vds->lock);
+}
+
 static void _handle_ctrl_msg(struct tipc_virtio_dev *vds,
 			     void *data, int len, u32 src)
 {
@@ -1430,6 +1706,12 @@ static void _handle_ctrl_msg(struct tipc_virtio_dev *vds,
 				 msg->body_len);
 	break;
 
+	case TIPC_CTRL_MSGTYPE_SHM_REG_RSP:
+	case TIPC_CTRL_MSGTYPE_SHM_UNREG_RSP:
+		_handle_shm_rsp(vds, (struct tipc_shm_rsp_body *)msg->body,
+				msg->body_len, msg->type);
+	break;
+
 	default:
 		dev_warn(&vds->vdev->dev,
 			 "%s: Unexpected message type: %d\n",
@@ -1562,6 +1844,7 @@ static int tipc_virtio_probe(struct virtio_device *vdev)
 	init_waitqueue_head(&vds->sendq);
 	INIT_LIST_HEAD(&vds->free_buf_list);
 	idr_init(&vds->addr_idr);
+	idr_init(&vds->shm_idr);
 
 	/* set default max message size and alignment */
 	memset(&config, 0, sizeof(config));
@@ -1634,6 +1917,7 @@ static void tipc_virtio_remove(struct virtio_device *vdev)
 	vdev->config->reset(vdev);
 
 	idr_destroy(&vds->addr_idr);
+	idr_destroy(&vds->shm_idr);
 
 	_cleanup_vq(vds->rxvq);
 	_cleanup_vq(vds->txvq);
@@ -138,3 +138,27 @@ int trusty_call32_mem_buf(struct device *dev, u32 smcnr,
 }
 EXPORT_SYMBOL(trusty_call32_mem_buf);
 
+/*
+ * Encodes n pages for secure world in one go, for regions that are
+ * registered once and then referred to by handle.
+ */
+int trusty_encode_page_list(struct ns_mem_page_info *inf,
+			    struct page **pages, unsigned int n,
+			    pgprot_t pgprot)
+{
+	unsigned int i;
+	int ret;
+
+	if (!inf || !pages)
+		return -EINVAL;
+
+	for (i = 0; i < n; i++) {
+		ret = trusty_encode_page_info(&inf[i], pages[i], pgprot);
+		if (ret)
+			return ret;
+	}
+
+	return 0;
+}
+EXPORT_SYMBOL(trusty_encode_page_list);
+
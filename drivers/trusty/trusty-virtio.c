@@ -69,6 +69,7 @@ struct trusty_ctx {
 	struct mutex		mlock; /* protects vdev_list */
 	struct workqueue_struct	*kick_wq;
 	struct workqueue_struct	*check_wq;
+	struct trusty_batch	*kick_batch; /* NULL kicks one vq per smc */
 #ifdef CONFIG_TEGRA_VIRTUALIZATION
 	struct task_struct	*vq_poll;
 #endif
@@ -180,9 +181,27 @@ static void kick_vq(struct trusty_ctx *tctx,
 	}
 }
 
+static void kick_vqs_submit(struct trusty_ctx *tctx, unsigned int n)
+{
+	unsigned int i;
+	int ret;
+
+	if (trusty_batch_submit(tctx->kick_batch))
+		return;
+
+	for (i = 0; i < n; i++) {
+		ret = trusty_batch_result(tctx->kick_batch, i);
+		if (ret)
+			dev_err(tctx->dev, "vq notify %u of %u returned %d\n",
+				i, n, ret);
+	}
+}
+
+/* kicks of all vqs that need one go to trusty in one batch */
 static void kick_vqs(workitem_t *work)
 {
 	uint i;
+	unsigned int n = 0;
 	struct trusty_vdev *tvdev;
 	struct trusty_ctx *tctx = container_of(work, struct trusty_ctx,
 					       kick_vqs);
@@ -190,10 +209,25 @@ static void kick_vqs(workitem_t *work)
 	list_for_each_entry(tvdev, &tctx->vdev_list, node) {
 		for (i = 0; i < tvdev->vring_num; i++) {
 			struct trusty_vring *tvr = &tvdev->vrings[i];
-			if (atomic_xchg(&tvr->needs_kick, 0))
+			if (!atomic_xchg(&tvr->needs_kick, 0))
+				continue;
+
+			if (!tctx->kick_batch) {
 				kick_vq(tctx, tvdev, tvr);
+				continue;
+			}
+
+			if (n == TRUSTY_BATCH_MAX) {
+				kick_vqs_submit(tctx, n);
+				n = 0;
+			}
+			trusty_batch_add(tctx->kick_batch, SMC_SC_VDEV_KICK_VQ,
+					 tvdev->notifyid, tvr->notifyid, 0);
+			n++;
 		}
 	}
+	if (n)
+		kick_vqs_submit(tctx, n);
 	mutex_unlock(&tctx->mlock);
 }
 
@@ -783,6 +817,10 @@ static int trusty_virtio_probe(struct platform_device *pdev)
 		goto err_create_kick_wq;
 	}
 
+	tctx->kick_batch = trusty_batch_alloc(tctx->dev->parent);
+	if (!tctx->kick_batch)
+		dev_warn(&pdev->dev, "vq kicks are not batched\n");
+
 	ret = trusty_virtio_add_devices(tctx);
 	if (ret) {
 		dev_err(&pdev->dev, "Failed to add virtio devices\n");
@@ -793,6 +831,7 @@ static int trusty_virtio_probe(struct platform_device *pdev)
 	return 0;
 
 err_add_devices:
+	trusty_batch_free(tctx->kick_batch);
 	destroy_workqueue(tctx->kick_wq);
 #ifdef CONFIG_TEGRA_VIRTUALIZATION
 	/* stop the vq polling thread */
@@ -841,6 +880,7 @@ static int trusty_virtio_remove(struct platform_device *pdev)
 	/* destroy workqueues */
 	destroy_workqueue(tctx->kick_wq);
 	destroy_workqueue(tctx->check_wq);
+	trusty_batch_free(tctx->kick_batch);
 
 	/* notify remote that shared area goes away */
 	trusty_virtio_stop(tctx, tctx->shared_va, tctx->shared_sz);
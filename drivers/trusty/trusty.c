@@ -15,6 +15,9 @@
 
 #include <asm/compiler.h>
 #include <linux/delay.h>
+#include <linux/ktime.h>
+#include <linux/math64.h>
+#include <linux/percpu.h>
 #include <linux/module.h>
 #include <linux/of.h>
 #include <linux/of_platform.h>
@@ -49,8 +52,16 @@ struct trusty_state {
 	struct trusty_work __percpu *nop_works;
 	struct list_head nop_queue;
 	spinlock_t nop_lock; /* protects nop_queue */
+	atomic64_t batches;
+	atomic64_t batched_cmds;
+	struct mutex stats_lock; /* protects stats_smcs, stats_ns */
+	u64 stats_smcs;
+	u64 stats_ns;
 };
 
+/* world switches, counted per cpu to keep them off the smc path */
+static DEFINE_PER_CPU(unsigned long, trusty_smc_count);
+
 #define TRUSTY_DEV_COMP "android,trusty-smc-v1"
 
 #ifdef CONFIG_ARM64
@@ -102,6 +113,8 @@ static inline ulong smc(ulong r0, ulong r1, ulong r2, ulong r3)
 	register ulong _r2 asm(SMC_ARG2) = r2;
 	register ulong _r3 asm(SMC_ARG3) = r3;
 
+	this_cpu_inc(trusty_smc_count);
+
 	asm volatile(
 		__asmeq("%0", SMC_ARG0)
 		__asmeq("%1", SMC_ARG1)
@@ -318,6 +331,42 @@ int trusty_panic_notifier_unregister(struct device *dev,
 }
 EXPORT_SYMBOL(trusty_panic_notifier_unregister);
 
+void trusty_account_batch(struct device *dev, unsigned int n)
+{
+	struct trusty_state *s = platform_get_drvdata(to_platform_device(dev));
+
+	atomic64_inc(&s->batches);
+	atomic64_add(n, &s->batched_cmds);
+}
+EXPORT_SYMBOL(trusty_account_batch);
+
+/* per_sec is the rate since the previous read */
+static ssize_t smc_stats_show(struct device *dev,
+			      struct device_attribute *attr, char *buf)
+{
+	struct trusty_state *s = platform_get_drvdata(to_platform_device(dev));
+	u64 smcs = 0, now, rate;
+	unsigned int cpu;
+
+	for_each_possible_cpu(cpu)
+		smcs += per_cpu(trusty_smc_count, cpu);
+
+	mutex_lock(&s->stats_lock);
+	now = ktime_get_ns();
+	rate = div64_u64((smcs - s->stats_smcs) * NSEC_PER_SEC,
+			 max_t(u64, now - s->stats_ns, 1));
+	s->stats_smcs = smcs;
+	s->stats_ns = now;
+	mutex_unlock(&s->stats_lock);
+
+	return scnprintf(buf, PAGE_SIZE,
+			 "total: %llu\nper_sec: %llu\nbatches: %lld\nbatched_cmds: %lld\n",
+			 smcs, rate, (long long)atomic64_read(&s->batches),
+			 (long long)atomic64_read(&s->batched_cmds));
+}
+
+static DEVICE_ATTR(smc_stats, S_IRUSR, smc_stats_show, NULL);
+
 static int trusty_remove_child(struct device *dev, void *data)
 {
 	platform_device_unregister(to_platform_device(dev));
@@ -597,6 +646,8 @@ static int trusty_probe(struct platform_device *pdev)
 	INIT_LIST_HEAD(&s->nop_queue);
 	mutex_init(&s->smc_lock);
 	mutex_init(&s->panic_lock);
+	mutex_init(&s->stats_lock);
+	s->stats_ns = ktime_get_ns();
 	ATOMIC_INIT_NOTIFIER_HEAD(&s->notifier);
 	RAW_INIT_NOTIFIER_HEAD(&s->panic_notifier);
 	init_completion(&s->cpu_idle_completion);
@@ -634,6 +685,10 @@ static int trusty_probe(struct platform_device *pdev)
 		INIT_WORKITEM(&tw->work, work_func);
 	}
 
+	/* only telemetry, not worth failing the probe for */
+	if (device_create_file(&pdev->dev, &dev_attr_smc_stats))
+		dev_warn(&pdev->dev, "Failed to create smc_stats\n");
+
 	ret = of_platform_populate(pdev->dev.of_node, NULL, NULL, &pdev->dev);
 	if (ret < 0) {
 		dev_err(&pdev->dev, "Failed to add children: %d\n", ret);
@@ -644,6 +699,7 @@ static int trusty_probe(struct platform_device *pdev)
 	return 0;
 
 err_add_children:
+	device_remove_file(&pdev->dev, &dev_attr_smc_stats);
 	for_each_possible_cpu(cpu) {
 		struct trusty_work *tw = per_cpu_ptr(s->nop_works, cpu);
 
@@ -661,6 +717,7 @@ err_api_version:
 	device_for_each_child(&pdev->dev, NULL, trusty_remove_child);
 	mutex_destroy(&s->smc_lock);
 	mutex_destroy(&s->panic_lock);
+	mutex_destroy(&s->stats_lock);
 	kfree(s);
 err_allocate_state:
 	return ret;
@@ -683,8 +740,10 @@ static int trusty_remove(struct platform_device *pdev)
 	free_percpu(s->nop_works);
 	destroy_workqueue(s->nop_wq);
 
+	device_remove_file(&pdev->dev, &dev_attr_smc_stats);
 	mutex_destroy(&s->smc_lock);
 	mutex_destroy(&s->panic_lock);
+	mutex_destroy(&s->stats_lock);
 	if (s->version_str) {
 		device_remove_file(&pdev->dev, &dev_attr_trusty_version);
 		kfree(s->version_str);
@@ -28,6 +28,7 @@
 #define DRV_NAME "tegra_hv_comm"
 
 #include <linux/tegra-ivc.h>
+#include <linux/tegra-ivc-batch.h>
 
 /* frame format is
 * 0000: <size>
@@ -37,6 +38,9 @@
 
 #define HDR_SIZE	8
 
+/* frames filled in place and sent with a single notification */
+#define TX_BATCH	16
+
 struct tegra_hv_comm {
 	struct uart_port port;
 	struct platform_device *pdev;
@@ -142,17 +146,30 @@ static void tegra_hv_comm_tx_chars(struct tegra_hv_comm *pp)
 		return;
 	}
 
+	/*
+	 * Fill as many free frames as there is pending data for, in place.
+	 * The peer is only notified once per batch, and only if it had
+	 * nothing left to read, when the ring is full the peer notifies us
+	 * as soon as it frees a frame.
+	 */
 	pending = uart_circ_chars_pending(xmit);
-	if (pending > 0) {
-		count = pp->ivck->frame_size - HDR_SIZE;
-		if (count > pending)
-			count = pending;
-		if (count > 0) {
+	while (pending > 0) {
+		void *frames[TX_BATCH];
+		int i, n;
+
+		n = tegra_hv_ivc_write_get_frames(pp->ivck, frames, TX_BATCH);
+		if (n <= 0)
+			break;
+
+		for (i = 0; i < n && pending > 0; i++) {
+			count = pp->ivck->frame_size - HDR_SIZE;
+			if (count > pending)
+				count = pending;
 			pending -= count;
 
-			((u32 *)pp->tx_frame)[0] = count;	/* count */
-			((u32 *)pp->tx_frame)[1] = 0;		/* flags */
-			s = pp->tx_frame + HDR_SIZE;
+			((u32 *)frames[i])[0] = count;	/* count */
+			((u32 *)frames[i])[1] = 0;	/* flags */
+			s = frames[i] + HDR_SIZE;
 			while (count-- > 0) {
 				*s++ = xmit->buf[xmit->tail];
 				xmit->tail = (xmit->tail + 1) &
@@ -161,24 +178,22 @@ static void tegra_hv_comm_tx_chars(struct tegra_hv_comm *pp)
 			}
 
 			/* count is now from start of frame */
-			count = (void *)s - pp->tx_frame;
-			if (count > 0)
-				memset(pp->tx_frame + count, 0,
-						pp->ivck->frame_size - count);
-
-			ret = tegra_hv_ivc_write(pp->ivck, pp->tx_frame, count);
-			if (ret != count) {
-				/* error */
-				dev_err(dev, "%s: failed to write normal data\n",
-						__func__);
-				return;
-			}
+			count = (void *)s - frames[i];
+			memset(frames[i] + count, 0,
+					pp->ivck->frame_size - count);
+		}
 
-			if (pending < WAKEUP_CHARS)
-				uart_write_wakeup(port);
+		ret = tegra_hv_ivc_write_advance_batch(pp->ivck, i);
+		if (ret < 0) {
+			/* error */
+			dev_err(dev, "%s: failed to write normal data\n",
+					__func__);
+			return;
 		}
 	}
 
+	if (pending < WAKEUP_CHARS)
+		uart_write_wakeup(port);
 }
 
 static void tegra_hv_tx_timer_expired(unsigned long data)
@@ -26,6 +26,7 @@
 #include <linux/platform/tegra/latency_allowance.h>
 #include <linux/platform/tegra/isomgr.h>
 #include <linux/list.h>
+#include <linux/workqueue.h>
 
 #include <media/vi.h>
 #include <media/tegra_camera_dev_mfi.h>
@@ -33,6 +34,9 @@
 
 #include "nvhost_acm.h"
 
+#define CREATE_TRACE_POINTS
+#include <trace/events/tegra_camera_platform.h>
+
 #define CAMDEV_NAME "tegra_camera_ctrl"
 
 /* Peak BPP for any of the YUV/Bayer formats */
@@ -41,6 +45,13 @@
 #define LANE_SPEED_1_GBPS 1000000000
 #define LANE_SPEED_1_5_GBPS 1500000000
 
+/*
+ * ISO bw decreases are held back for this long, so that staggered stream
+ * stops and stop/start sequences of a mode change do not walk EMC DVFS
+ * down and back up. Increases are always applied right away.
+ */
+#define ISOBW_DECREASE_DELAY_MS 250
+
 #if defined(CONFIG_TEGRA_BWMGR)
 #include <linux/platform/tegra/emc_bwmgr.h>
 #endif
@@ -60,6 +71,7 @@ struct tegra_camera_info {
 	u64 max_bw;
 #endif
 	struct mutex update_bw_lock;
+	struct delayed_work isobw_work;
 	u64 vi_mode_isobw;
 	u64 bypass_mode_isobw;
 	/* set max bw by default */
@@ -342,28 +354,10 @@ static int dbgfs_tegra_camera_init(void)
 }
 #endif
 
-/*
- * submits total aggregated iso bw request to isomgr.
- */
-int tegra_camera_update_isobw(void)
+/* called with update_bw_lock held */
+static u64 tegra_camera_isobw_target(struct tegra_camera_info *info)
 {
-	struct tegra_camera_info *info;
-	unsigned long total_khz;
-	unsigned long bw;
-#ifdef CONFIG_TEGRA_MC
-	unsigned long bw_mbps;
-#endif
-	int ret = 0;
-
-	if (tegra_camera_misc.parent == NULL) {
-		pr_info("driver not enabled, cannot update bw\n");
-		return -ENODEV;
-	}
-
-	info = dev_get_drvdata(tegra_camera_misc.parent);
-	if (!info)
-		return -ENODEV;
-	mutex_lock(&info->update_bw_lock);
+	u64 bw;
 
 	bw = info->active_iso_bw;
 	if (info->bypass_mode_isobw > info->active_iso_bw)
@@ -372,7 +366,7 @@ int tegra_camera_update_isobw(void)
 	/* Bug 200323801 consider iso bw of both vi mode and vi-bypass mode */
 	if (bw >= info->max_bw) {
 		dev_info(info->dev,
-			"%s: Warning, Requested ISO BW %lu has been capped to VI's max BW %llu\n",
+			"%s: Warning, Requested ISO BW %llu has been capped to VI's max BW %llu\n",
 			__func__, bw, info->max_bw);
 		bw = info->max_bw;
 	}
@@ -382,6 +376,20 @@ int tegra_camera_update_isobw(void)
 	if (info->num_active_streams == 0)
 		bw = 0;
 
+	return bw;
+}
+
+/* called with update_bw_lock held */
+static int tegra_camera_set_isobw(struct tegra_camera_info *info,
+				unsigned long bw)
+{
+	u64 old_bw = info->vi_mode_isobw;
+	unsigned long total_khz;
+#ifdef CONFIG_TEGRA_MC
+	unsigned long bw_mbps;
+#endif
+	int ret = 0;
+
 #ifdef CONFIG_TEGRA_MC
 	/*
 	 * Different chip versions use different APIs to set LA for VI.
@@ -396,7 +404,7 @@ int tegra_camera_update_isobw(void)
 		if (ret) {
 			dev_err(info->dev, "%s: set la failed: %d\n",
 				__func__, ret);
-			return ret;
+			goto out;
 		}
 	}
 #endif
@@ -421,8 +429,8 @@ int tegra_camera_update_isobw(void)
 		dev_err(info->dev,
 		"%s: failed to reserve %lu KBps with isomgr\n",
 		__func__, bw);
-		mutex_unlock(&info->update_bw_lock);
-		return -ENOMEM;
+		ret = -ENOMEM;
+		goto out;
 	}
 
 	info->vi_mode_isobw = bw;
@@ -430,6 +438,59 @@ int tegra_camera_update_isobw(void)
 	vi_mode_d = bw;
 	bypass_mode_d = info->bypass_mode_isobw;
 #endif
+out:
+	trace_tegra_camera_isobw_set(old_bw, bw,
+				info->memory_latency, ret);
+	return ret;
+}
+
+static void tegra_camera_isobw_work(struct work_struct *work)
+{
+	struct tegra_camera_info *info = container_of(to_delayed_work(work),
+				struct tegra_camera_info, isobw_work);
+	u64 bw;
+
+	mutex_lock(&info->update_bw_lock);
+	/* an increase may have been applied in the meantime */
+	bw = tegra_camera_isobw_target(info);
+	if (bw < info->vi_mode_isobw)
+		tegra_camera_set_isobw(info, bw);
+	mutex_unlock(&info->update_bw_lock);
+}
+
+/*
+ * submits total aggregated iso bw request to isomgr.
+ */
+int tegra_camera_update_isobw(void)
+{
+	struct tegra_camera_info *info;
+	u64 bw;
+	int ret = 0;
+
+	if (tegra_camera_misc.parent == NULL) {
+		pr_info("driver not enabled, cannot update bw\n");
+		return -ENODEV;
+	}
+
+	info = dev_get_drvdata(tegra_camera_misc.parent);
+	if (!info)
+		return -ENODEV;
+	mutex_lock(&info->update_bw_lock);
+
+	bw = tegra_camera_isobw_target(info);
+	trace_tegra_camera_isobw_request(bw, info->vi_mode_isobw,
+				bw < info->vi_mode_isobw);
+
+	if (bw < info->vi_mode_isobw) {
+		/* restart the window, decreases within it are merged */
+		mod_delayed_work(system_wq, &info->isobw_work,
+				msecs_to_jiffies(ISOBW_DECREASE_DELAY_MS));
+	} else {
+		cancel_delayed_work(&info->isobw_work);
+		if (bw != info->vi_mode_isobw)
+			ret = tegra_camera_set_isobw(info, bw);
+	}
+
 	mutex_unlock(&info->update_bw_lock);
 	return ret;
 }
@@ -596,6 +657,7 @@ static int tegra_camera_probe(struct platform_device *pdev)
 	clk_set_rate(info->iso_emc, 0);
 #endif
 	mutex_init(&info->update_bw_lock);
+	INIT_DELAYED_WORK(&info->isobw_work, tegra_camera_isobw_work);
 	/* Register Camera as isomgr client. */
 	ret = tegra_camera_isomgr_register(info, &pdev->dev);
 	if (ret) {
@@ -1020,6 +1082,8 @@ static int tegra_camera_remove(struct platform_device *pdev)
 
 	dev_info(&pdev->dev, "%s:camera_platform_driver remove\n", __func__);
 
+	cancel_delayed_work_sync(&info->isobw_work);
+
 	/* deallocate isomgr bw */
 	if (info->en_max_bw)
 		tegra_camera_isomgr_request(info, 0, info->memory_latency);
@@ -20,6 +20,10 @@
 #include <linux/slab.h>
 #include <linux/mutex.h>
 #include <linux/string.h>
+#include <linux/mm.h>
+#include <linux/poll.h>
+#include <linux/vmalloc.h>
+#include <linux/ktime.h>
 
 #include "dc.h"
 #include "dc_priv_defs.h"
@@ -30,6 +34,11 @@
 #define TEGRA_DC_FLIP_BUF_CAPACITY 1024 /* in units of number of elements */
 #define TEGRA_DC_CRC_BUF_CAPACITY 1024 /* in units of number of elements */
 #define CRC_COMPLETE_TIMEOUT msecs_to_jiffies(1000)
+#define TEGRA_DC_CRC_STREAM_ENTRIES 256 /* must be a power of two */
+#define TEGRA_DC_CRC_STREAM_SIZE \
+	PAGE_ALIGN(sizeof(struct tegra_dc_ext_crc_stream_header) + \
+		TEGRA_DC_CRC_STREAM_ENTRIES * \
+		sizeof(struct tegra_dc_ext_crc_stream_entry))
 
 static inline size_t _get_bytes_per_ele(struct tegra_dc_ring_buf *buf)
 {
@@ -703,8 +712,126 @@ long tegra_dc_crc_get(struct tegra_dc *dc, struct tegra_dc_ext_crc_arg *arg)
 	return ret;
 }
 
+/* Append the CRCs of the frame that just ended to the CRC stream
+ * Single producer, called from the frame end interrupt only. The entry is
+ * invalidated while it is rewritten so that a reader racing with the
+ * overwrite can tell.
+ */
+static void tegra_dc_crc_stream_put(struct tegra_dc *dc,
+				    struct tegra_dc_ext_crc_stream_header *hdr,
+				    struct tegra_dc_crc_buf_ele *e)
+{
+	struct tegra_dc_ext_crc_stream_entry *entries =
+		(struct tegra_dc_ext_crc_stream_entry *)(hdr + 1);
+	struct tegra_dc_ext_crc_stream_entry *ent;
+	u32 head = dc->crc_stream_head;
+	u32 valid = 0;
+	int i;
+
+	ent = &entries[head & (TEGRA_DC_CRC_STREAM_ENTRIES - 1)];
+
+	WRITE_ONCE(ent->seq, 0);
+	smp_wmb();
+
+	ent->frame_cnt = tegra_dc_get_frame_cnt(dc);
+	ent->timestamp_ns = ktime_get_ns();
+
+	if (e->rg.valid)
+		valid |= TEGRA_DC_EXT_CRC_STREAM_VALID_RG;
+	if (e->comp.valid)
+		valid |= TEGRA_DC_EXT_CRC_STREAM_VALID_COMP;
+	if (e->sor.valid)
+		valid |= TEGRA_DC_EXT_CRC_STREAM_VALID_OR;
+	ent->rg = e->rg.crc;
+	ent->comp = e->comp.crc;
+	ent->sor = e->sor.crc;
+
+	for (i = 0; i < TEGRA_DC_MAX_CRC_REGIONS; i++) {
+		if (e->regional[i].valid)
+			valid |= TEGRA_DC_EXT_CRC_STREAM_VALID_REGION(i);
+		ent->regional[i] = e->regional[i].crc;
+	}
+	ent->valid = valid;
+
+	smp_wmb();
+	WRITE_ONCE(ent->seq, head + 1);
+
+	dc->crc_stream_head = head + 1;
+	WRITE_ONCE(hdr->head, head + 1);
+
+	/* Only a reader that has caught up can be waiting. Pairs with the
+	 * barrier in tegra_dc_crc_stream_poll()
+	 */
+	smp_mb();
+	if (READ_ONCE(hdr->tail) == head)
+		wake_up(&dc->crc_stream_wq);
+}
+
+/* Map the CRC stream of the head, allocating it on the first call */
+int tegra_dc_crc_stream_mmap(struct tegra_dc *dc, struct vm_area_struct *vma)
+{
+	struct tegra_dc_ext_crc_stream_header *hdr;
+	int ret;
+
+	if (vma->vm_pgoff ||
+	    vma->vm_end - vma->vm_start > TEGRA_DC_CRC_STREAM_SIZE)
+		return -EINVAL;
+
+	mutex_lock(&dc->crc_stream_lock);
+
+	hdr = dc->crc_stream;
+	if (!hdr) {
+		hdr = vmalloc_user(TEGRA_DC_CRC_STREAM_SIZE);
+		if (!hdr) {
+			ret = -ENOMEM;
+			goto unlock;
+		}
+
+		hdr->magic = TEGRA_DC_EXT_CRC_STREAM_MAGIC;
+		hdr->entries = TEGRA_DC_CRC_STREAM_ENTRIES;
+
+		/* frame end starts filling the stream from now on */
+		smp_store_release(&dc->crc_stream, hdr);
+	}
+
+	ret = remap_vmalloc_range(vma, hdr, 0);
+unlock:
+	mutex_unlock(&dc->crc_stream_lock);
+
+	return ret;
+}
+
+unsigned int tegra_dc_crc_stream_poll(struct tegra_dc *dc, struct file *filp,
+				      poll_table *wait)
+{
+	struct tegra_dc_ext_crc_stream_header *hdr =
+		smp_load_acquire(&dc->crc_stream);
+
+	/* nothing will ever arrive before the stream is mapped */
+	if (!hdr)
+		return POLLERR;
+
+	poll_wait(filp, &dc->crc_stream_wq, wait);
+
+	/* pairs with the barrier in tegra_dc_crc_stream_put() */
+	smp_mb();
+
+	if (READ_ONCE(hdr->head) != READ_ONCE(hdr->tail))
+		return POLLIN | POLLRDNORM;
+
+	return 0;
+}
+
+/* Called when removing the DC, once the head device can no longer be used */
+void tegra_dc_crc_stream_free(struct tegra_dc *dc)
+{
+	vfree(dc->crc_stream);
+	dc->crc_stream = NULL;
+}
+
 int tegra_dc_crc_process(struct tegra_dc *dc)
 {
+	struct tegra_dc_ext_crc_stream_header *hdr;
 	int ret = 0, matched = 0;
 	struct tegra_dc_crc_buf_ele crc_ele;
 	struct tegra_dc_flip_buf_ele *flip_ele;
@@ -720,6 +847,10 @@ int tegra_dc_crc_process(struct tegra_dc *dc)
 	if (ret)
 		return ret;
 
+	hdr = smp_load_acquire(&dc->crc_stream);
+	if (hdr)
+		tegra_dc_crc_stream_put(dc, hdr, &crc_ele);
+
 	mutex_lock(&dc->flip_buf.lock);
 
 	/* Before doing any work, check if there are flips to match */
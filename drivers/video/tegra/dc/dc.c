@@ -1094,8 +1094,14 @@ static int dbg_dc_stats_show(struct seq_file *s, void *unused)
 		dc->stats.underflows);
 	if (tegra_dc_is_nvdisplay()) {
 		seq_printf(s,
-			"underflow_frames: %llu\n",
-			dc->stats.underflow_frames);
+			"underflow_frames: %llu\n"
+			"win_updates: %llu\n"
+			"win_regs_written: %llu\n"
+			"win_regs_skipped: %llu\n",
+			dc->stats.underflow_frames,
+			dc->stats.win_updates,
+			dc->stats.win_regs_written,
+			dc->stats.win_regs_skipped);
 	} else {
 		seq_printf(s,
 			"underflows_a: %llu\n"
@@ -4454,6 +4460,34 @@ void tegra_dc_vsync_disable(struct tegra_dc *dc)
 	mutex_unlock(&dc->lock);
 }
 
+/*
+ * Vblank interrupt for the dc clients that enabled NOTIFY_VBLANK_EVENT,
+ * kept apart from V_BLANK_USER so that dc/ext and clients don't disable
+ * each other's. Assumes dc->lock is already taken.
+ */
+void _tegra_dc_client_vblank_arm(struct tegra_dc *dc, bool arm)
+{
+	int vsync_irq;
+
+	if (arm == test_bit(V_BLANK_CLIENT, &dc->vblank_ref_count))
+		return;
+	if (dc->out->flags & TEGRA_DC_OUT_ONE_SHOT_MODE)
+		vsync_irq = MSF_INT;
+	else
+		vsync_irq = V_BLANK_INT;
+
+	if (arm) {
+		tegra_dc_hold_dc_out(dc);
+		set_bit(V_BLANK_CLIENT, &dc->vblank_ref_count);
+		tegra_dc_unmask_interrupt(dc, vsync_irq);
+	} else {
+		clear_bit(V_BLANK_CLIENT, &dc->vblank_ref_count);
+		if (!dc->vblank_ref_count)
+			tegra_dc_mask_interrupt(dc, vsync_irq);
+		tegra_dc_release_dc_out(dc);
+	}
+}
+
 bool tegra_dc_has_vsync(struct tegra_dc *dc)
 {
 	return true;
@@ -4555,6 +4589,10 @@ static void tegra_dc_vrr_extend_vfp(struct tegra_dc *dc)
 	if (!vrr->enable)
 		return;
 
+	/* refresh is locked to the content cadence, don't wait for flips */
+	if (vrr->cadence_locked)
+		return;
+
 	tegra_dc_set_act_vfp(dc, MAX_VRR_V_FRONT_PORCH);
 }
 
@@ -4857,13 +4895,17 @@ static void tegra_dc_process_vblank(struct tegra_dc *dc)
 		dc->out->user_needs_vblank = false;
 		complete(&dc->out->user_vblank_comp);
 	}
-	if (test_bit(V_BLANK_USER, &dc->vblank_ref_count)) {
+	if (test_bit(V_BLANK_USER, &dc->vblank_ref_count) ||
+	    test_bit(V_BLANK_CLIENT, &dc->vblank_ref_count)) {
 		u64 timestamp = tegra_dc_get_scanline_timestamp(dc,
 					dc->mode_metadata.vblank_lines);
 		if (unlikely(!timestamp))
 			dev_err(&dc->ndev->dev, "Invalid Timestamp Value\n");
 
-		tegra_dc_ext_process_vblank(dc->ndev->id, timestamp);
+		if (test_bit(V_BLANK_USER, &dc->vblank_ref_count))
+			tegra_dc_ext_process_vblank(dc->ndev->id, timestamp);
+		if (test_bit(V_BLANK_CLIENT, &dc->vblank_ref_count))
+			tegra_dc_client_handle_vblank(dc, timestamp);
 	}
 }
 
@@ -4917,6 +4959,9 @@ static void tegra_dc_one_shot_irq(struct tegra_dc *dc, unsigned long status)
 			tegra_dc_collect_latency_data(dc);
 		queue_work(system_freezable_wq, &dc->vpulse2_work);
 	}
+
+	if (status & V_PULSE3_INT)
+		tegra_dc_ext_process_late_latch(dc->ext);
 }
 
 static void tegra_dc_continuous_irq(struct tegra_dc *dc, unsigned long status)
@@ -4979,6 +5024,9 @@ static void tegra_dc_continuous_irq(struct tegra_dc *dc, unsigned long status)
 			tegra_dc_collect_latency_data(dc);
 		queue_work(system_freezable_wq, &dc->vpulse2_work);
 	}
+
+	if (status & V_PULSE3_INT)
+		tegra_dc_ext_process_late_latch(dc->ext);
 }
 
 /* XXX: Not sure if we limit look ahead to 1 frame */
@@ -5813,6 +5861,10 @@ static bool _tegra_dc_enable(struct tegra_dc *dc)
 	if (tegra_dc_is_nvdisplay())
 		tegra_dc_crc_reset(dc);
 
+	/* clients keep their vblank notifications over disable/enable */
+	if (dc->clients_info.vblank_map)
+		_tegra_dc_client_vblank_arm(dc, true);
+
 	tegra_dc_client_handle_event(dc, NOTIFY_DC_ENABLED_EVENT);
 
 	return true;
@@ -5934,6 +5986,11 @@ static void _tegra_dc_controller_disable(struct tegra_dc *dc)
 		clear_bit(V_BLANK_USER, &dc->vblank_ref_count);
 	}
 
+	if (test_bit(V_BLANK_CLIENT, &dc->vblank_ref_count)) {
+		tegra_dc_release_dc_out(dc);
+		clear_bit(V_BLANK_CLIENT, &dc->vblank_ref_count);
+	}
+
 	tegra_dc_put(dc);
 
 	if (tegra_dc_is_t21x()) {
@@ -6591,6 +6648,8 @@ static int tegra_dc_probe(struct platform_device *ndev)
 	init_completion(&dc->frame_end_complete);
 	init_completion(&dc->crc_complete);
 	init_completion(&dc->hpd_complete);
+	mutex_init(&dc->crc_stream_lock);
+	init_waitqueue_head(&dc->crc_stream_wq);
 	init_waitqueue_head(&dc->wq);
 	init_waitqueue_head(&dc->timestamp_wq);
 	INIT_WORK(&dc->vblank_work, tegra_dc_vblank);
@@ -6995,6 +7054,7 @@ static int tegra_dc_remove(struct platform_device *ndev)
 
 	kfree(dc->flip_buf.data);
 	kfree(dc->crc_buf.data);
+	tegra_dc_crc_stream_free(dc);
 
 	if (dc->out->flags & TEGRA_DC_OUT_ONE_SHOT_MODE) {
 		mutex_lock(&dc->one_shot_lock);
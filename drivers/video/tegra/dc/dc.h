@@ -612,6 +612,15 @@ struct tegra_vrr {
 	s32	vfp;
 	s32	insert_frame;
 
+	/* Content adaptive refresh, see tegra_dc_vrr_cadence_flip() */
+	s32	cadence_enable;
+	s32	cadence_locked;
+	s32	cadence_stable;
+	s32	cadence_us;
+	s32	cadence_multiple;
+	s32	cadence_vfp;
+	s64	cadence_last_flip_us;
+
 	/* Used with TLK */
 	s32	vrr_session_id;
 	/* Used with Trusty */
@@ -722,6 +731,7 @@ struct tegra_dc_out {
 #define V_BLANK_FLIP		0
 #define V_BLANK_USER		2
 #define V_BLANK_IMP		3
+#define V_BLANK_CLIENT		4
 
 #define V_PULSE2_FLIP		0
 #define V_PULSE2_LATENCY_MSRMNT	2
@@ -855,6 +865,7 @@ int tegra_dc_ext_process_bandwidth_renegotiate(int output,
 					struct tegra_dc_bw_data *bw);
 bool tegra_dc_ext_is_userspace_active(void);
 int tegra_dc_ext_get_scanline(struct tegra_dc_ext *dc_ext);
+void tegra_dc_ext_process_late_latch(struct tegra_dc_ext *dc_ext);
 /* finish dc/ext */
 
 #if defined(CONFIG_FRAMEBUFFER_CONSOLE)
@@ -1164,6 +1175,8 @@ struct nvdisp_bandwidth_config {
 	u32 hubclk;		/* Hz */
 };
 
+#define NVDISP_BW_HISTORY_DEPTH		8
+
 struct nvdisp_isoclient_bw_info {
 	tegra_isomgr_handle		isomgr_handle;
 	struct tegra_bwmgr_client	*bwmgr_handle;
@@ -1176,6 +1189,10 @@ struct nvdisp_isoclient_bw_info {
 
 	u32				emc_at_res_bw;		/* Hz */
 	u32				hubclk_at_res_bw;	/* Hz */
+
+	/* most recently proposed configurations, kept reserved */
+	struct nvdisp_bandwidth_config	history[NVDISP_BW_HISTORY_DEPTH];
+	u8				history_idx;
 };
 
 struct nvdisp_imp_table {
@@ -1193,6 +1210,14 @@ void tegra_dc_crc_drop_ref_cnts(struct tegra_dc *dc);
 void tegra_dc_crc_reset(struct tegra_dc *dc);
 int tegra_dc_crc_process(struct tegra_dc *dc);
 
+/* APIs related to the mmap()-ed CRC stream */
+struct vm_area_struct;
+struct poll_table_struct;
+int tegra_dc_crc_stream_mmap(struct tegra_dc *dc, struct vm_area_struct *vma);
+unsigned int tegra_dc_crc_stream_poll(struct tegra_dc *dc, struct file *filp,
+				      struct poll_table_struct *wait);
+void tegra_dc_crc_stream_free(struct tegra_dc *dc);
+
 /* APIs related to ring buffer */
 struct tegra_dc_ring_buf;
 void tegra_dc_ring_buf_add(struct tegra_dc_ring_buf *buf, void *src,
@@ -181,6 +181,8 @@ int tegra_dc_unregister_client(struct tegra_dc_client *client)
 								__func__);
 		return -ENOENT;
 	}
+
+	tegra_dc_client_vblank_enable(client, false);
 	ret = tegra_dc_client_remove_client_id(client->client_id,
 						&dc->clients_info);
 	if (ret)
@@ -193,6 +195,49 @@ int tegra_dc_unregister_client(struct tegra_dc_client *client)
 }
 EXPORT_SYMBOL(tegra_dc_unregister_client);
 
+/*
+ * tegra_dc_client_vblank_enable - turns the vblank interrupt of the head on
+ *				or off for the client.
+ * @client : pointer to client's data
+ * @enable : true while the client needs NOTIFY_VBLANK_EVENT.
+ *
+ * The interrupt stays on while any client of the head has it enabled. It
+ * is armed right away if the head is enabled, else when it gets enabled.
+ *
+ * Return: 0 if no errors else corresponding error value.
+ */
+int tegra_dc_client_vblank_enable(struct tegra_dc_client *client,
+				  bool enable)
+{
+	struct tegra_dc *dc;
+	struct tegra_dc_clients_info *clients_info;
+
+	if (!client || client->client_id < 0 ||
+	    client->client_id >= MAX_NO_DC_CLIENTS)
+		return -EINVAL;
+
+	dc = tegra_dc_get_dc(client->disp_id);
+	if (!dc)
+		return -ENODEV;
+
+	clients_info = &dc->clients_info;
+	if (!clients_info->client_data[client->client_id].registered)
+		return -ENOENT;
+
+	mutex_lock(&dc->lock);
+	if (enable)
+		set_bit(client->client_id, &clients_info->vblank_map);
+	else
+		clear_bit(client->client_id, &clients_info->vblank_map);
+
+	if (dc->enabled)
+		_tegra_dc_client_vblank_arm(dc, !!clients_info->vblank_map);
+	mutex_unlock(&dc->lock);
+
+	return 0;
+}
+EXPORT_SYMBOL(tegra_dc_client_vblank_enable);
+
 /*
  * handle_state_dc_enabled_event() - notifies the client of DC_ENABLED_EVENT.
  * @client_data : Pointer the individual client specific data.
@@ -297,3 +342,27 @@ int tegra_dc_client_handle_event(struct tegra_dc *dc,
 
 	return 0;
 }
+
+/*
+ * tegra_dc_client_handle_vblank() - notifies the clients that enabled
+ *					NOTIFY_VBLANK_EVENT of a vblank.
+ * @dc : ptr to tegra_dc for which the vblank has occurred.
+ * @timestamp : vblank timestamp in ns.
+ *
+ * Called from the dc interrupt thread with dc->lock held.
+ */
+void tegra_dc_client_handle_vblank(struct tegra_dc *dc, u64 timestamp)
+{
+	int i;
+	struct tegra_dc_clients_info *clients_info = &dc->clients_info;
+	tegra_dc_notify_vblank_event callback_fn;
+
+	for_each_set_bit(i, &clients_info->vblank_map, MAX_NO_DC_CLIENTS) {
+		callback_fn = (tegra_dc_notify_vblank_event)
+			clients_info->client_data[i].callback_fn[
+							NOTIFY_VBLANK_EVENT];
+		if (callback_fn)
+			callback_fn(dc->ndev->id, timestamp,
+				    clients_info->client_data[i].usr_ctx);
+	}
+}
@@ -386,6 +386,8 @@ struct tegra_dc_pd_table *tegra_dc_get_disp_pd_table(void);
 
 int tegra_dc_client_handle_event(struct tegra_dc *dc,
 		enum tegra_dc_client_cllbck_event_type event_type);
+void tegra_dc_client_handle_vblank(struct tegra_dc *dc, u64 timestamp);
+void _tegra_dc_client_vblank_arm(struct tegra_dc *dc, bool arm);
 
 void tegra_dc_activate_general_channel(struct tegra_dc *dc);
 
@@ -399,6 +401,8 @@ void tegra_nvdisp_crc_reset(struct tegra_dc *dc);
 
 void tegra_nvdisp_set_output_lut(struct tegra_dc *dc,
 	struct tegra_dc_ext_nvdisp_cmu *user_nvdisp_cmu, bool new_cmu_values);
+u64 *tegra_nvdisp_get_spare_output_lut(struct tegra_dc *dc);
+void tegra_nvdisp_swap_output_lut(struct tegra_dc *dc);
 void tegra_nvdisp_set_output_colorspace(struct tegra_dc *dc, u16 colorspace);
 void tegra_nvdisp_set_output_range(struct tegra_dc *dc, u8 lim_range_enable);
 void tegra_nvdisp_set_csc2(struct tegra_dc *dc);
@@ -423,6 +427,7 @@ int tegra_nvdisp_set_degamma_user_config(struct tegra_dc_win *win,
 				    long degamma_flag);
 int tegra_nvdisp_get_degamma_user_config(struct tegra_dc_win *win);
 int tegra_nvdisp_get_imp_caps(struct tegra_dc_ext_imp_caps *imp_caps);
+int tegra_nvdisp_query_bandwidth(struct tegra_dc_ext_control_bw_query *query);
 int tegra_nvdisp_verify_win_properties(struct tegra_dc *dc,
 				struct tegra_dc_ext_flip_windowattr *win);
 
@@ -282,10 +282,12 @@ struct tegra_dc_client_data {
  * struct tegra_dc_clients_info - Used to store info regarding all the clients
  * registered with a specific head.
  * @client_id_map : a pool of resource for client ids under a specific head.
+ * @vblank_map : clients that enabled NOTIFY_VBLANK_EVENT, under dc->lock.
  * @client_data : array storing all individual client's info.
  */
 struct tegra_dc_clients_info {
 	unsigned long client_id_map;
+	unsigned long vblank_map;
 	struct tegra_dc_client_data client_data[MAX_NO_DC_CLIENTS];
 };
 
@@ -529,6 +531,9 @@ struct tegra_dc {
 
 	struct tegra_dc_cmu		cmu;
 	struct tegra_dc_nvdisp_lut	nvdisp_postcomp_lut;
+	/* written while nvdisp_postcomp_lut is in use, then swapped */
+	struct tegra_dc_nvdisp_lut	nvdisp_postcomp_lut_spare;
+	bool				postcomp_lut_swap_pending;
 
 	/* either unity or panel specific */
 	struct tegra_dc_nvdisp_win_csc	default_csc;
@@ -585,6 +590,9 @@ struct tegra_dc {
 		u64			underflows_h;
 		u64			underflows_t;
 		u64			underflow_frames;
+		u64			win_updates;
+		u64			win_regs_written;
+		u64			win_regs_skipped;
 	} stats;
 
 	struct tegra_dc_ext		*ext;
@@ -670,6 +678,11 @@ struct tegra_dc {
 	struct tegra_dc_ring_buf crc_buf; /* Buffer to save HW generated CRCs */
 	struct tegra_dc_crc_ref_cnt crc_ref_cnt;
 	bool crc_initialized;
+	/* Per frame CRCs shared with userspace, allocated on first mmap */
+	struct tegra_dc_ext_crc_stream_header *crc_stream;
+	u32 crc_stream_head;
+	struct mutex crc_stream_lock;
+	wait_queue_head_t crc_stream_wq;
 	struct tegra_dc_latency_measurement_data msrmnt_info;
 
 #if defined(CONFIG_TEGRA_DC_FAKE_PANEL_SUPPORT)
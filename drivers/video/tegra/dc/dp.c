@@ -2385,12 +2385,18 @@ static void tegra_dp_hpd_op_edid_ready(void *drv_data)
 {
 	struct tegra_dc_dp_data *dp = drv_data;
 	struct tegra_dc *dc = dp->dc;
+	struct tegra_dc_edid *dc_edid;
 
 	/*
 	 * we have a new panel connected.
-	 * Forget old LT config data.
+	 * Forget old LT config data, but keep the cached drive
+	 * settings if it is the sink they were trained on.
 	 */
-	tegra_dp_lt_invalidate(&dp->lt_data);
+	dc_edid = dp->hpd_data.edid ?
+		tegra_edid_get_data(dp->hpd_data.edid) : NULL;
+	tegra_dp_lt_set_sink(&dp->lt_data, dc_edid ? dc_edid->buf : NULL,
+			dc_edid ? dc_edid->len : 0);
+	tegra_edid_put_data(dc_edid);
 
 	/* in mm */
 	dc->out->h_size = dc->out->h_size ? : dp->hpd_data.mon_spec.max_x * 10;
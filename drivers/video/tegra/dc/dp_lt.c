@@ -19,6 +19,7 @@
 #include <linux/delay.h>
 #include <linux/completion.h>
 #include <linux/kernel.h>
+#include <linux/crc32.h>
 #include "dc.h"
 #include <linux/moduleparam.h>
 #include "dp_lt.h"
@@ -38,6 +39,11 @@ module_param(force_trigger_lt, bool, 0644);
 MODULE_PARM_DESC(force_trigger_lt,
 	"Retrigger LT even if link is already stable");
 
+static bool lt_cache_enable = true;
+module_param(lt_cache_enable, bool, 0644);
+MODULE_PARM_DESC(lt_cache_enable,
+	"Start LT with the drive settings last trained on the same sink");
+
 static int lane_fallback_table[] = {1, 2, 4};
 
 static void set_lt_state(struct tegra_dp_lt_data *lt_data,
@@ -492,12 +498,81 @@ static void lt_failed(struct tegra_dp_lt_data *lt_data)
 	mutex_unlock(&lt_data->lock);
 }
 
+/* called with lt_data->lock held */
+static void lt_cache_save(struct tegra_dp_lt_data *lt_data)
+{
+	struct tegra_dp_lt_cache *cache = &lt_data->cache;
+
+	cache->sink_id = lt_data->sink_id;
+	cache->n_lanes = lt_data->n_lanes;
+	cache->link_bw = lt_data->link_bw;
+	cache->tx_pu = lt_data->tx_pu;
+	memcpy(cache->drive_current, lt_data->drive_current,
+		sizeof(cache->drive_current));
+	memcpy(cache->pre_emphasis, lt_data->pre_emphasis,
+		sizeof(cache->pre_emphasis));
+	memcpy(cache->post_cursor2, lt_data->post_cursor2,
+		sizeof(cache->post_cursor2));
+	cache->valid = true;
+}
+
+/*
+ * Preload the drive settings of the last pass on this sink, so that
+ * CR and CE normally complete on their first iteration. Only used when
+ * the link config is the one the cache was trained with.
+ */
+static bool lt_cache_load(struct tegra_dp_lt_data *lt_data)
+{
+	struct tegra_dp_lt_cache *cache = &lt_data->cache;
+
+	if (!lt_cache_enable || !cache->valid ||
+		cache->sink_id != lt_data->sink_id ||
+		cache->n_lanes != lt_data->n_lanes ||
+		cache->link_bw != lt_data->link_bw)
+		return false;
+
+	lt_data->tx_pu = cache->tx_pu;
+	memcpy(lt_data->drive_current, cache->drive_current,
+		sizeof(lt_data->drive_current));
+	memcpy(lt_data->pre_emphasis, cache->pre_emphasis,
+		sizeof(lt_data->pre_emphasis));
+	memcpy(lt_data->post_cursor2, cache->post_cursor2,
+		sizeof(lt_data->post_cursor2));
+
+	pr_info("dp lt: trying cached config, lanes: %d, link rate: 0x%x\n",
+		lt_data->n_lanes, lt_data->link_bw);
+	return true;
+}
+
+/*
+ * The cached settings did not train the link. Drop them and
+ * restart with full link training.
+ */
+static void lt_cache_miss(struct tegra_dp_lt_data *lt_data, int *tgt_state,
+			int *timeout)
+{
+	pr_info("dp lt: cached config failed, retry full LT\n");
+
+	lt_failed(lt_data);
+
+	mutex_lock(&lt_data->lock);
+	lt_data->cache.valid = false;
+	lt_data->cache_try = false;
+	lt_data->force_trigger = true;
+	mutex_unlock(&lt_data->lock);
+
+	*tgt_state = STATE_RESET;
+	*timeout = 0;
+}
+
 static void lt_passed(struct tegra_dp_lt_data *lt_data)
 {
 	struct tegra_dc_dp_data *dp = lt_data->dp;
 
 	mutex_lock(&lt_data->lock);
 
+	lt_cache_save(lt_data);
+	lt_data->cache_try = false;
 	lt_data->lt_config_valid = true;
 	set_lt_tpg(lt_data, TEGRA_DC_DP_TRAINING_PATTERN_DISABLE);
 	tegra_dc_sor_attach(dp->sor);
@@ -562,6 +637,7 @@ static void lt_reset_state(struct tegra_dp_lt_data *lt_data)
 	mutex_unlock(&lt_data->lock);
 
 	lt_data_reset(lt_data);
+	lt_data->cache_try = lt_cache_load(lt_data);
 	tgt_state = STATE_CLOCK_RECOVERY;
 	timeout = 0;
 
@@ -779,7 +855,10 @@ static void lt_channel_equalization_state(struct tegra_dp_lt_data *lt_data)
 
 	/* Fallback condition #1 */
 	cr_done = get_clock_recovery_status(lt_data, &cr_lane_mask);
-	if (!cr_done) {
+	if (!cr_done && lt_data->cache_try) {
+		lt_cache_miss(lt_data, &tgt_state, &timeout);
+		goto done;
+	} else if (!cr_done) {
 		pr_info("dp lt: CR lost\n");
 
 		lt_channel_equalization_fallback(lt_data, &tgt_state, &timeout,
@@ -797,6 +876,11 @@ static void lt_channel_equalization_state(struct tegra_dp_lt_data *lt_data)
 	}
 	pr_info("dp lt: CE not done\n");
 
+	if (lt_data->cache_try) {
+		lt_cache_miss(lt_data, &tgt_state, &timeout);
+		goto done;
+	}
+
 	/* Fallback condition #2 */
 	if (++(lt_data->ce_retry) > (CE_RETRY_LIMIT + 1)) {
 		pr_info("dp lt: CE retry limit %d reached\n",
@@ -901,6 +985,11 @@ static void lt_clock_recovery_state(struct tegra_dp_lt_data *lt_data)
 	}
 	pr_info("dp lt: CR not done\n");
 
+	if (lt_data->cache_try) {
+		lt_cache_miss(lt_data, &tgt_state, &timeout);
+		goto done;
+	}
+
 	memcpy(vs_temp, vs, sizeof(vs_temp));
 	get_lt_new_config(lt_data);
 
@@ -1081,6 +1170,25 @@ void tegra_dp_lt_invalidate(struct tegra_dp_lt_data *lt_data)
 	mutex_unlock(&lt_data->lock);
 }
 
+/*
+ * Identifies the sink by its EDID base block, which carries the
+ * vendor, product and serial number. Cached LT settings are kept only
+ * while the same sink is connected.
+ */
+void tegra_dp_lt_set_sink(struct tegra_dp_lt_data *lt_data,
+			const u8 *edid, size_t len)
+{
+	u32 sink_id = edid ? crc32_le(~0, edid, min_t(size_t, len, 128)) : 0;
+
+	mutex_lock(&lt_data->lock);
+	lt_data->lt_config_valid = false;
+	if (sink_id != lt_data->sink_id) {
+		lt_data->cache.valid = false;
+		lt_data->sink_id = sink_id;
+	}
+	mutex_unlock(&lt_data->lock);
+}
+
 /* block till link training has reached final state */
 long tegra_dp_lt_wait_for_completion(struct tegra_dp_lt_data *lt_data,
 			int target_state, unsigned long timeout_ms)
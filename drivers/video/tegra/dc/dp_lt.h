@@ -48,6 +48,21 @@ static const char * const tegra_dp_lt_state_names[] = {
 	"reduce lane count",
 };
 
+/*
+ * Drive settings of the last successful link training. They are
+ * tried first the next time the same sink is trained, e.g. on resume.
+ */
+struct tegra_dp_lt_cache {
+	bool valid;
+	u32 sink_id; /* crc32 of the sink's EDID base block */
+	u32 n_lanes;
+	u32 link_bw;
+	u32 drive_current[4];
+	u32 pre_emphasis[4];
+	u32 post_cursor2[4];
+	u32 tx_pu;
+};
+
 struct tegra_dp_lt_data {
 	struct tegra_dc_dp_data *dp;
 	int shutdown;
@@ -74,6 +89,10 @@ struct tegra_dp_lt_data {
 	u32 cr_adj_retry;
 	u32 cr_max_retry;
 	u32 ce_retry;
+
+	u32 sink_id;
+	struct tegra_dp_lt_cache cache;
+	bool cache_try; /* current attempt uses the cached settings */
 };
 
 static const u32 tegra_dp_vs_regs[][4][4] = {
@@ -274,4 +293,6 @@ long tegra_dp_lt_wait_for_completion(struct tegra_dp_lt_data *lt_data,
 			int target_state, unsigned long timeout_ms);
 int tegra_dp_get_lt_state(struct tegra_dp_lt_data *lt_data);
 void tegra_dp_lt_invalidate(struct tegra_dp_lt_data *lt_data);
+void tegra_dp_lt_set_sink(struct tegra_dp_lt_data *lt_data,
+			const u8 *edid, size_t len);
 #endif
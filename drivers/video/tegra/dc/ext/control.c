@@ -392,6 +392,26 @@ static long tegra_dc_ext_control_ioctl(struct file *filp, unsigned int cmd,
 
 		return 0;
 	}
+	case TEGRA_DC_EXT_CONTROL_QUERY_BW:
+	{
+		struct tegra_dc_ext_control_bw_query args;
+		int ret;
+
+		if (!tegra_dc_is_nvdisplay())
+			return -EINVAL;
+
+		if (copy_from_user(&args, user_arg, sizeof(args)))
+			return -EFAULT;
+
+		ret = tegra_nvdisp_query_bandwidth(&args);
+		if (ret)
+			return ret;
+
+		if (copy_to_user(user_arg, &args, sizeof(args)))
+			return -EFAULT;
+
+		return 0;
+	}
 	case TEGRA_DC_EXT_CONTROL_GET_CAP_INFO:
 	{
 		int ret = 0;
@@ -20,11 +20,13 @@
 
 #include <linux/file.h>
 #include <linux/fs.h>
+#include <linux/poll.h>
 #include <linux/uaccess.h>
 #include <linux/slab.h>
 #include <linux/workqueue.h>
 #include <linux/export.h>
 #include <linux/delay.h>
+#include <linux/timer.h>
 #include <linux/fb.h>
 #include <linux/version.h>
 #include <linux/string.h>
@@ -54,6 +56,7 @@
 
 #define TEGRA_DC_TS_MAX_DELAY_US 1000000
 #define TEGRA_DC_TS_SLACK_US 2000
+#define TEGRA_DC_PRE_FENCE_TIMEOUT_MS 5000
 
 /* Compatibility for kthread refactoring */
 #if LINUX_VERSION_CODE < KERNEL_VERSION(4, 9, 0)
@@ -143,6 +146,17 @@ struct tegra_dc_ext_flip_data {
 	struct tegra_dc_flip_buf_ele *flip_buf_ele;
 	bool background_color_update_needed;
 	u32 background_color;
+	/* flip waiting for its pre-fence on the armed queue of armed_win */
+	struct tegra_dc_ext_win *armed_win;
+	struct list_head armed_node;
+	bool pre_fence_ready;
+#ifdef CONFIG_TEGRA_GRHOST_SYNC
+	/* pre-fences of all the windows of the flip, merged at queue time */
+	struct sync_fence *pre_fence;
+	struct sync_fence_waiter pre_fence_waiter;
+	struct timer_list pre_fence_timer;
+	bool pre_fence_timedout;
+#endif
 };
 
 struct tegra_dc_ext_scanline_data {
@@ -153,6 +167,8 @@ struct tegra_dc_ext_scanline_data {
 };
 
 static int tegra_dc_ext_set_vblank(struct tegra_dc_ext *ext, bool enable);
+static int tegra_dc_ext_set_late_latch_line(struct tegra_dc_ext *ext,
+					    int line);
 static void tegra_dc_ext_unpin_window(struct tegra_dc_ext_win *win);
 static void tegra_dc_flip_trace(struct tegra_dc_ext_flip_data *data,
 				display_syncpt_notifier trace_fn);
@@ -239,7 +255,7 @@ static int tegra_dc_ext_put_window(struct tegra_dc_ext_user *user,
 	mutex_lock(&win->lock);
 
 	if (win->user == user) {
-		kthread_flush_worker(&win->flip_worker);
+		tegra_dc_ext_flush_flips(win);
 		win->user = NULL;
 		win->enabled = false;
 	} else {
@@ -318,6 +334,8 @@ int tegra_dc_ext_disable(struct tegra_dc_ext *ext)
 
 	set_enable(ext, false);
 
+	tegra_dc_ext_set_late_latch_line(ext, -1);
+
 	/* Flush any scanline work */
 	kthread_flush_worker(&ext->scanline_worker);
 
@@ -333,7 +351,7 @@ int tegra_dc_ext_disable(struct tegra_dc_ext *ext)
 	for (i = 0; i < ext->dc->n_windows; i++) {
 		struct tegra_dc_ext_win *win = &ext->win[i];
 
-		kthread_flush_worker(&win->flip_worker);
+		tegra_dc_ext_flush_flips(win);
 	}
 
 	tegra_dc_en_dis_latency_msrmnt_mode(ext->dc, false);
@@ -538,6 +556,7 @@ static int tegra_dc_ext_set_windowattr(struct tegra_dc_ext *ext,
 
 	memcpy(ext_win->cur_handle, flip_win->handle,
 	       sizeof(ext_win->cur_handle));
+	ext_win->cur_syncpt_max = flip_win->syncpt_max;
 
 	/* XXX verify that this won't read outside of the surface */
 	win->phys_addr = flip_win->phys_addr + flip_win->attr.offset;
@@ -820,6 +839,14 @@ int tegra_dc_ext_vpulse3(struct tegra_dc_ext *ext,
 		return -EINVAL;
 	}
 
+	/* vpulse3 is shared with late latching */
+	if ((args->flags & TEGRA_DC_EXT_SCANLINE_FLAG_ENABLE) &&
+		ext->late_latch.line >= 0 &&
+		ext->late_latch.line != args->triggered_line) {
+		dev_err(&dc->ndev->dev, "Scanline used by late latch\n");
+		return -EBUSY;
+	}
+
 	/* TODO: Support frame != 0 and raw syncpt */
 	if ((args->flags & TEGRA_DC_EXT_SCANLINE_FLAG_ENABLE) &&
 		(args->frame ||
@@ -879,6 +906,207 @@ int tegra_dc_ext_get_scanline(struct tegra_dc_ext *ext)
 	return ext->scanline_trigger;
 }
 
+static void tegra_dc_ext_late_latch_win_worker(struct kthread_work *work)
+{
+	struct tegra_dc_ext_win *ext_win =
+		container_of(work, struct tegra_dc_ext_win, late_latch_work);
+	struct tegra_dc_ext *ext = ext_win->ext;
+	struct tegra_dc *dc = ext->dc;
+	struct tegra_dc_ext_late_latch latch;
+	struct tegra_dc_win *win;
+	unsigned int out_x, out_y;
+	fixed20_12 x, y;
+	unsigned long flags;
+
+	spin_lock_irqsave(&ext->late_latch.lock, flags);
+	if (!test_and_clear_bit(ext_win->idx, &ext->late_latch.pending)) {
+		spin_unlock_irqrestore(&ext->late_latch.lock, flags);
+		return;
+	}
+	latch = ext->late_latch.win[ext_win->idx];
+	spin_unlock_irqrestore(&ext->late_latch.lock, flags);
+
+	win = tegra_dc_get_window(dc, ext_win->idx);
+	if (!win || !ext->enabled || !ext_win->enabled)
+		return;
+
+	out_x = win->out_x;
+	out_y = win->out_y;
+	x = win->x;
+	y = win->y;
+
+	win->out_x = latch.out_x;
+	win->out_y = latch.out_y;
+	if (latch.flags & TEGRA_DC_EXT_LATE_LATCH_FLAG_CROP) {
+		win->x.full = latch.x;
+		win->y.full = latch.y;
+	}
+
+	if (tegra_dc_ext_check_windowattr(ext, win)) {
+		dev_dbg(&dc->ndev->dev, "late latch of win %d rejected\n",
+			ext_win->idx);
+		win->out_x = out_x;
+		win->out_y = out_y;
+		win->x = x;
+		win->y = y;
+		return;
+	}
+
+	/* Latched by hardware at the next vblank, do not wait for it */
+	tegra_dc_scrncapt_disp_pause_lock(dc);
+	tegra_dc_update_windows(&win, 1, NULL, false, false);
+	tegra_dc_scrncapt_disp_pause_unlock(dc);
+}
+
+static void tegra_dc_ext_late_latch_cursor_worker(struct kthread_work *work)
+{
+	struct tegra_dc_ext *ext =
+		container_of(work, struct tegra_dc_ext, late_latch.cursor_work);
+	struct tegra_dc *dc = ext->dc;
+	struct tegra_dc_ext_late_latch latch;
+	unsigned long flags;
+
+	spin_lock_irqsave(&ext->late_latch.lock, flags);
+	if (!ext->late_latch.cursor_pending) {
+		spin_unlock_irqrestore(&ext->late_latch.lock, flags);
+		return;
+	}
+	ext->late_latch.cursor_pending = false;
+	latch = ext->late_latch.cursor;
+	spin_unlock_irqrestore(&ext->late_latch.lock, flags);
+
+	mutex_lock(&ext->cursor.lock);
+	if (ext->enabled && ext->cursor.cur_handle)
+		tegra_dc_cursor_set(dc, dc->cursor.enabled,
+				    latch.out_x, latch.out_y);
+	mutex_unlock(&ext->cursor.lock);
+}
+
+/*
+ * Called from the DC interrupt when the raster reaches the late latch line.
+ * The updates are applied from the SCHED_FIFO flip and scanline workers so
+ * that they reach the shadow registers before the vblank that follows.
+ */
+void tegra_dc_ext_process_late_latch(struct tegra_dc_ext *ext)
+{
+	unsigned long flags, pending;
+	int i;
+
+	if (!ext)
+		return;
+
+	spin_lock_irqsave(&ext->late_latch.lock, flags);
+	pending = ext->late_latch.pending;
+	for_each_set_bit(i, &pending, DC_N_WINDOWS)
+		kthread_queue_work(&ext->win[i].flip_worker,
+				   &ext->win[i].late_latch_work);
+	if (ext->late_latch.cursor_pending)
+		kthread_queue_work(&ext->scanline_worker,
+				   &ext->late_latch.cursor_work);
+	spin_unlock_irqrestore(&ext->late_latch.lock, flags);
+}
+
+static int tegra_dc_ext_set_late_latch_line(struct tegra_dc_ext *ext,
+					    int line)
+{
+	struct tegra_dc *dc = ext->dc;
+	unsigned long flags;
+	u32 val;
+
+	if (line < 0) {
+		line = -1;
+	} else {
+		if (!dc->enabled || !dc->connected ||
+			dc->vpulse3_syncpt == NVSYNCPT_INVALID)
+			return -EACCES;
+
+		if (line >= dc->mode_metadata.vtotal_lines)
+			return -EINVAL;
+
+		/* vpulse3 is shared with the scanline sync ioctl */
+		if (ext->scanline_trigger >= 0 &&
+			ext->scanline_trigger != line)
+			return -EBUSY;
+
+		tegra_dc_ext_setup_vpulse3(ext, line);
+	}
+
+	spin_lock_irqsave(&ext->late_latch.lock, flags);
+	ext->late_latch.line = line;
+	if (line < 0) {
+		ext->late_latch.pending = 0;
+		ext->late_latch.cursor_pending = false;
+	}
+	spin_unlock_irqrestore(&ext->late_latch.lock, flags);
+
+	if (!dc->enabled)
+		return 0;
+
+	mutex_lock(&dc->lock);
+	tegra_dc_get(dc);
+	val = tegra_dc_readl(dc, DC_CMD_INT_ENABLE);
+	if (line >= 0) {
+		tegra_dc_writel(dc, val | V_PULSE3_INT, DC_CMD_INT_ENABLE);
+		tegra_dc_unmask_interrupt(dc, V_PULSE3_INT);
+	} else {
+		tegra_dc_mask_interrupt(dc, V_PULSE3_INT);
+		tegra_dc_writel(dc, val & ~V_PULSE3_INT, DC_CMD_INT_ENABLE);
+	}
+	tegra_dc_put(dc);
+	mutex_unlock(&dc->lock);
+
+	return 0;
+}
+
+static int tegra_dc_ext_set_late_latch(struct tegra_dc_ext_user *user,
+				       struct tegra_dc_ext_late_latch *args)
+{
+	struct tegra_dc_ext *ext = user->ext;
+	bool cursor = args->win_index == TEGRA_DC_EXT_LATE_LATCH_CURSOR;
+	unsigned int idx = 0;
+	unsigned long flags;
+	int ret = 0;
+
+	if ((args->flags & ~TEGRA_DC_EXT_LATE_LATCH_FLAG_CROP) ||
+		args->reserved[0] || args->reserved[1])
+		return -EINVAL;
+
+	if (cursor) {
+		mutex_lock(&ext->cursor.lock);
+		if (ext->cursor.user != user)
+			ret = -EACCES;
+		mutex_unlock(&ext->cursor.lock);
+	} else {
+		idx = args->win_index;
+		if (idx >= tegra_dc_get_numof_dispwindows() ||
+			!(ext->dc->valid_windows & BIT(idx)) ||
+			args->out_x < 0 || args->out_y < 0)
+			return -EINVAL;
+		idx = array_index_nospec(idx, tegra_dc_get_numof_dispwindows());
+
+		mutex_lock(&ext->win[idx].lock);
+		if (ext->win[idx].user != user)
+			ret = -EACCES;
+		mutex_unlock(&ext->win[idx].lock);
+	}
+	if (ret)
+		return ret;
+
+	spin_lock_irqsave(&ext->late_latch.lock, flags);
+	if (ext->late_latch.line < 0) {
+		ret = -ENXIO;
+	} else if (cursor) {
+		ext->late_latch.cursor = *args;
+		ext->late_latch.cursor_pending = true;
+	} else {
+		ext->late_latch.win[idx] = *args;
+		set_bit(idx, &ext->late_latch.pending);
+	}
+	spin_unlock_irqrestore(&ext->late_latch.lock, flags);
+
+	return ret;
+}
+
 static void tegra_dc_ext_unpin_handles(struct tegra_dc_dmabuf *unpin_handles[],
 				       int nr_unpin)
 {
@@ -1039,6 +1267,24 @@ static void tegra_dc_ext_flip_worker(struct kthread_work *work)
 	if (flip_ele)
 		flip_ele->state = TEGRA_DC_FLIP_STATE_DEQUEUED;
 
+#ifdef CONFIG_TEGRA_GRHOST_SYNC
+	/*
+	 * The flip is normally queued by the pre-fence callback once every
+	 * buffer is ready. It only gets here with the fence pending when the
+	 * flip queue is flushed, in which case wait like a blocking flip.
+	 */
+	if (data->pre_fence) {
+		del_timer_sync(&data->pre_fence_timer);
+		sync_fence_cancel_async(data->pre_fence,
+					&data->pre_fence_waiter);
+		if (!data->pre_fence_timedout)
+			sync_fence_wait(data->pre_fence,
+					TEGRA_DC_PRE_FENCE_TIMEOUT_MS);
+		sync_fence_put(data->pre_fence);
+		data->pre_fence = NULL;
+	}
+#endif
+
 	blank_win = kzalloc(sizeof(*blank_win), GFP_KERNEL);
 	if (!blank_win)
 		dev_err(&ext->dc->ndev->dev, "Failed to allocate blank_win.\n");
@@ -1871,6 +2117,153 @@ static int tegra_dc_ext_read_user_data(struct tegra_dc_ext_flip_data *data,
 	return ret;
 }
 
+#ifdef CONFIG_TEGRA_GRHOST_SYNC
+/*
+ * Merge the pre-fences of all windows into a single fence, so the flip
+ * worker waits once for the whole flip instead of once per window.
+ */
+static int tegra_dc_ext_merge_pre_fences(struct tegra_dc_ext_flip_data *data,
+					 int win_num)
+{
+	struct sync_fence *merged;
+	int i;
+
+	for (i = 0; i < win_num; i++) {
+		struct tegra_dc_ext_flip_win *flip_win = &data->win[i];
+		struct sync_fence *fence = flip_win->pre_syncpt_fence;
+
+		if (!fence)
+			continue;
+
+		flip_win->pre_syncpt_fence = NULL;
+		flip_win->attr.pre_syncpt_id = NVSYNCPT_INVALID;
+
+		if (!data->pre_fence) {
+			data->pre_fence = fence;
+			continue;
+		}
+
+		merged = sync_fence_merge("flip-pre-fence", data->pre_fence,
+					  fence);
+		sync_fence_put(fence);
+		if (!merged)
+			return -ENOMEM;
+
+		sync_fence_put(data->pre_fence);
+		data->pre_fence = merged;
+	}
+
+	return 0;
+}
+#endif
+
+/*
+ * Queue to the flip worker, in submission order, the armed flips whose
+ * pre-fences have signalled. Called with win->armed_lock held.
+ */
+static void tegra_dc_ext_queue_armed_flips(struct tegra_dc_ext_win *win)
+{
+	struct tegra_dc_ext_flip_data *data, *tmp;
+
+	list_for_each_entry_safe(data, tmp, &win->armed_queue, armed_node) {
+		if (!data->pre_fence_ready)
+			break;
+
+		list_del(&data->armed_node);
+		kthread_queue_work(&win->flip_worker, &data->work);
+	}
+}
+
+static void tegra_dc_ext_pre_fence_ready(struct tegra_dc_ext_flip_data *data)
+{
+	struct tegra_dc_ext_win *win = data->armed_win;
+	unsigned long flags;
+
+	spin_lock_irqsave(&win->armed_lock, flags);
+	data->pre_fence_ready = true;
+	tegra_dc_ext_queue_armed_flips(win);
+	spin_unlock_irqrestore(&win->armed_lock, flags);
+}
+
+#ifdef CONFIG_TEGRA_GRHOST_SYNC
+static void tegra_dc_ext_pre_fence_signaled(struct sync_fence *fence,
+					    struct sync_fence_waiter *waiter)
+{
+	struct tegra_dc_ext_flip_data *data = container_of(waiter,
+			struct tegra_dc_ext_flip_data, pre_fence_waiter);
+
+	tegra_dc_ext_pre_fence_ready(data);
+}
+
+static void tegra_dc_ext_pre_fence_timeout(unsigned long arg)
+{
+	struct tegra_dc_ext_flip_data *data =
+		(struct tegra_dc_ext_flip_data *)arg;
+
+	if (sync_fence_cancel_async(data->pre_fence, &data->pre_fence_waiter))
+		return;
+
+	dev_warn(&data->ext->dc->ndev->dev,
+		 "pre-fence timed out, flipping anyway\n");
+	data->pre_fence_timedout = true;
+	tegra_dc_ext_pre_fence_ready(data);
+}
+#endif
+
+/*
+ * Hand a flip over to the flip worker of win. The flip is queued from the
+ * pre-fence callback when its last buffer is ready, so no worker thread
+ * sleeps on the fence and the commit happens right when it signals.
+ */
+static void tegra_dc_ext_arm_flip(struct tegra_dc_ext_win *win,
+				  struct tegra_dc_ext_flip_data *data)
+{
+	unsigned long flags;
+
+	data->armed_win = win;
+
+	spin_lock_irqsave(&win->armed_lock, flags);
+	list_add_tail(&data->armed_node, &win->armed_queue);
+	spin_unlock_irqrestore(&win->armed_lock, flags);
+
+#ifdef CONFIG_TEGRA_GRHOST_SYNC
+	if (data->pre_fence) {
+		setup_timer(&data->pre_fence_timer,
+			    tegra_dc_ext_pre_fence_timeout,
+			    (unsigned long)data);
+		sync_fence_waiter_init(&data->pre_fence_waiter,
+				       tegra_dc_ext_pre_fence_signaled);
+		mod_timer(&data->pre_fence_timer, jiffies +
+			  msecs_to_jiffies(TEGRA_DC_PRE_FENCE_TIMEOUT_MS));
+
+		/* 0 means the callback was registered, > 0 already signalled */
+		if (!sync_fence_wait_async(data->pre_fence,
+					   &data->pre_fence_waiter))
+			return;
+	}
+#endif
+
+	tegra_dc_ext_pre_fence_ready(data);
+}
+
+/*
+ * Push the armed flips of win to its worker regardless of their pre-fences,
+ * and wait for all of them to be processed.
+ */
+static void tegra_dc_ext_flush_flips(struct tegra_dc_ext_win *win)
+{
+	struct tegra_dc_ext_flip_data *data;
+	unsigned long flags;
+
+	spin_lock_irqsave(&win->armed_lock, flags);
+	list_for_each_entry(data, &win->armed_queue, armed_node)
+		data->pre_fence_ready = true;
+	tegra_dc_ext_queue_armed_flips(win);
+	spin_unlock_irqrestore(&win->armed_lock, flags);
+
+	kthread_flush_worker(&win->flip_worker);
+}
+
 static int tegra_dc_ext_flip(struct tegra_dc_ext_user *user,
 			     struct tegra_dc_ext_flip_windowattr *win,
 			     int win_num,
@@ -1915,6 +2308,12 @@ static int tegra_dc_ext_flip(struct tegra_dc_ext_user *user,
 	if (ret)
 		goto fail_pin;
 
+#ifdef CONFIG_TEGRA_GRHOST_SYNC
+	ret = tegra_dc_ext_merge_pre_fences(data, win_num);
+	if (ret)
+		goto fail_pin;
+#endif
+
 	ret = tegra_dc_ext_read_user_data(data, flip_user_data, nr_user_data);
 	if (ret)
 		goto fail_pin;
@@ -2045,7 +2444,7 @@ static int tegra_dc_ext_flip(struct tegra_dc_ext_user *user,
 		data->flip_buf_ele = in_q_ptr;
 	}
 
-	kthread_queue_work(&ext->win[work_index].flip_worker, &data->work);
+	tegra_dc_ext_arm_flip(&ext->win[work_index], data);
 
 	unlock_windows_for_flip(user, win, win_num);
 
@@ -2058,6 +2457,11 @@ fail_pin:
 
 	for (i = 0; i < win_num; i++) {
 		int j;
+
+#ifdef CONFIG_TEGRA_GRHOST_SYNC
+		if (data->win[i].pre_syncpt_fence)
+			sync_fence_put(data->win[i].pre_syncpt_fence);
+#endif
 		for (j = 0; j < TEGRA_DC_NUM_PLANES; j++) {
 			if (!data->win[i].handle[j])
 				continue;
@@ -2071,6 +2475,11 @@ fail_pin:
 		}
 	}
 
+#ifdef CONFIG_TEGRA_GRHOST_SYNC
+	if (data->pre_fence)
+		sync_fence_put(data->pre_fence);
+#endif
+
 	/* Release the COMMON channel in case of failure. */
 	if (data->imp_dirty)
 		tegra_dc_release_common_channel(ext->dc);
@@ -2329,20 +2738,25 @@ static int tegra_dc_ext_set_nvdisp_cmu(struct tegra_dc_ext_user *user,
 	int i, lut_size;
 	struct tegra_dc_nvdisp_lut *nvdisp_cmu;
 	struct tegra_dc *dc = user->ext->dc;
+	u64 *rgb;
 
-	/* Directly copying the values to DC
-	 * output lut whose address is already
-	 * programmed to HW register.
-	 */
 	nvdisp_cmu = &dc->nvdisp_postcomp_lut;
-	if (!nvdisp_cmu)
+	if (!nvdisp_cmu->rgb)
 		return -ENOMEM;
 
+	lut_size = min_t(int, args->lut_size, ARRAY_SIZE(args->rgb));
+
+	/* The values go to the spare output lut, which replaces the one
+	 * in use at the next vblank.
+	 */
 	tegra_dc_scrncapt_disp_pause_lock(dc);
 	dc->pdata->cmu_enable = args->cmu_enable;
-	lut_size = args->lut_size;
+	rgb = tegra_nvdisp_get_spare_output_lut(dc);
+	if (lut_size < nvdisp_cmu->size / sizeof(u64))
+		memcpy(rgb, nvdisp_cmu->rgb, nvdisp_cmu->size);
 	for (i = 0; i < lut_size; i++)
-		nvdisp_cmu->rgb[i] = args->rgb[i];
+		rgb[i] = args->rgb[i];
+	tegra_nvdisp_swap_output_lut(dc);
 
 	tegra_nvdisp_update_cmu(dc, nvdisp_cmu);
 	tegra_dc_scrncapt_disp_pause_unlock(dc);
@@ -3454,6 +3868,25 @@ free_and_ret:
 #endif
 	}
 
+	case TEGRA_DC_EXT_SCRNCAPT_EXPORT_FBUF:
+	{
+#ifdef CONFIG_TEGRA_DC_SCREEN_CAPTURE
+		struct tegra_dc_ext_scrncapt_export_fbuf  args;
+		int  ret;
+
+		if (copy_from_user(&args, user_arg, sizeof(args)))
+			return -EFAULT;
+		ret = tegra_dc_scrncapt_export_fbuf(user, &args);
+		if (ret)
+			return ret;
+		if (copy_to_user(user_arg, &args, sizeof(args)))
+			return -EFAULT;
+		return 0;
+#else
+		return -EINVAL;
+#endif
+	}
+
 	case TEGRA_DC_EXT_GET_SCANLINE:
 	{
 		u32 scanln;
@@ -3489,6 +3922,26 @@ free_and_ret:
 		return ret;
 	}
 
+	case TEGRA_DC_EXT_SET_LATE_LATCH_LINE:
+	{
+		__s32 line;
+
+		if (copy_from_user(&line, user_arg, sizeof(line)))
+			return -EFAULT;
+
+		return tegra_dc_ext_set_late_latch_line(user->ext, line);
+	}
+
+	case TEGRA_DC_EXT_SET_LATE_LATCH:
+	{
+		struct tegra_dc_ext_late_latch args;
+
+		if (copy_from_user(&args, user_arg, sizeof(args)))
+			return -EFAULT;
+
+		return tegra_dc_ext_set_late_latch(user, &args);
+	}
+
 	case TEGRA_DC_EXT_CRC_ENABLE:
 	{
 		struct tegra_dc_ext_crc_arg args;
@@ -3680,6 +4133,10 @@ static int tegra_dc_ext_setup_windows(struct tegra_dc_ext *ext)
 		mutex_init(&win->lock);
 		mutex_init(&win->queue_lock);
 		INIT_LIST_HEAD(&win->timestamp_queue);
+		spin_lock_init(&win->armed_lock);
+		INIT_LIST_HEAD(&win->armed_queue);
+		kthread_init_work(&win->late_latch_work,
+				  tegra_dc_ext_late_latch_win_worker);
 	}
 
 	return 0;
@@ -3693,10 +4150,26 @@ cleanup:
 	return ret;
 }
 
+static int tegra_dc_mmap(struct file *filp, struct vm_area_struct *vma)
+{
+	struct tegra_dc_ext_user *user = filp->private_data;
+
+	return tegra_dc_crc_stream_mmap(user->ext->dc, vma);
+}
+
+static unsigned int tegra_dc_poll(struct file *filp, poll_table *wait)
+{
+	struct tegra_dc_ext_user *user = filp->private_data;
+
+	return tegra_dc_crc_stream_poll(user->ext->dc, filp, wait);
+}
+
 static const struct file_operations tegra_dc_devops = {
 	.owner =		THIS_MODULE,
 	.open =			tegra_dc_open,
 	.release =		tegra_dc_release,
+	.mmap =			tegra_dc_mmap,
+	.poll =			tegra_dc_poll,
 	.unlocked_ioctl =	tegra_dc_ioctl,
 #ifdef CONFIG_COMPAT
 	.compat_ioctl =		tegra_dc_ioctl,
@@ -3759,6 +4232,11 @@ struct tegra_dc_ext *tegra_dc_ext_register(struct platform_device *ndev,
 	}
 	sched_setscheduler(ext->scanline_task, SCHED_FIFO, &sparm);
 
+	spin_lock_init(&ext->late_latch.lock);
+	ext->late_latch.line = -1;
+	kthread_init_work(&ext->late_latch.cursor_work,
+			  tegra_dc_ext_late_latch_cursor_worker);
+
 	head_count++;
 
 	return ext;
@@ -3782,7 +4260,7 @@ void tegra_dc_ext_unregister(struct tegra_dc_ext *ext)
 	for (i = 0; i < ext->dc->n_windows; i++) {
 		struct tegra_dc_ext_win *win = &ext->win[i];
 
-		kthread_flush_worker(&win->flip_worker);
+		tegra_dc_ext_flush_flips(win);
 		kthread_stop(win->flip_kthread);
 	}
 
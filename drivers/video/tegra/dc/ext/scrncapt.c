@@ -17,6 +17,7 @@
  */
 
 #include <linux/file.h>
+#include <linux/fdtable.h>
 #include <linux/fs.h>
 #include <linux/uaccess.h>
 #include <linux/slab.h>
@@ -26,6 +27,8 @@
 #include <linux/timer.h>
 #include <linux/memblock.h>
 #include <linux/fb.h>
+#include <linux/dma-buf.h>
+#include <linux/nvhost.h>
 #include <uapi/video/tegra_dc_ext.h>
 #include <trace/events/display.h>
 
@@ -563,6 +566,86 @@ int tegra_dc_scrncapt_dup_fbuf(struct tegra_dc_ext_user *user,
 }
 
 
+/* export the current buffers of a window as dma-buf fds
+ * o any planes already exported are closed again on failure
+ * o the head is held from flipping only while the references are
+ *   taken, instead of for the whole copy like in the pause mode
+ */
+int tegra_dc_scrncapt_export_fbuf(struct tegra_dc_ext_user *user,
+		struct tegra_dc_ext_scrncapt_export_fbuf *args)
+{
+	int err = 0;
+	int p;
+	struct tegra_dc_ext *ext = user->ext;
+	struct tegra_dc *dc = ext->dc;
+	struct tegra_dc_ext_win *extwin;
+	struct dma_buf *bufs[TEGRA_DC_NUM_PLANES] = { NULL };
+	u32 syncpt_id, syncpt_val;
+
+	if (args->flags || args->reserved0)
+		return -EINVAL;
+	if (tegra_dc_get_numof_dispwindows() <= args->win)
+		return -EINVAL;
+	if (!(dc->valid_windows & (1 << args->win)))
+		return -EBUSY;
+
+	extwin = &ext->win[args->win];
+
+	down_write(&scrncapt.rwsema_head[dc->ctrl_num]);
+	scrncapt_get_info_win(dc, args->win, &args->winattr);
+	for (p = 0; p < TEGRA_DC_NUM_PLANES; p++) {
+		struct tegra_dc_dmabuf *buf = extwin->cur_handle[p];
+
+		if (!buf || !buf->buf)
+			continue;
+		get_dma_buf(buf->buf);
+		bufs[p] = buf->buf;
+	}
+	syncpt_id = tegra_dc_get_syncpt_id(dc, args->win);
+	syncpt_val = extwin->cur_syncpt_max + 1;
+	up_write(&scrncapt.rwsema_head[dc->ctrl_num]);
+
+	if (!bufs[TEGRA_DC_Y]) {
+		err = -ENODATA;
+		goto put_bufs;
+	}
+
+	err = nvhost_syncpt_create_fence_single_ext(dc->ndev, syncpt_id,
+			syncpt_val, "scrncapt-release", &args->release_fence_fd);
+	if (err)
+		goto put_bufs;
+
+	for (p = 0; p < TEGRA_DC_SCRNCAPT_DUP_FBUF_IDX_NUM; p++)
+		args->plane_fds[p] = -1;
+
+	for (p = 0; p < TEGRA_DC_NUM_PLANES; p++) {
+		if (!bufs[p])
+			continue;
+
+		args->plane_fds[p] = dma_buf_fd(bufs[p], O_CLOEXEC);
+		if (args->plane_fds[p] < 0) {
+			err = args->plane_fds[p];
+			goto close_fds;
+		}
+		bufs[p] = NULL;
+	}
+
+	return 0;
+
+close_fds:
+	while (p--)
+		if (args->plane_fds[p] >= 0)
+			__close_fd(current->files, args->plane_fds[p]);
+	__close_fd(current->files, args->release_fence_fd);
+put_bufs:
+	for (p = 0; p < TEGRA_DC_NUM_PLANES; p++)
+		if (bufs[p])
+			dma_buf_put(bufs[p]);
+
+	return err;
+}
+
+
 int  tegra_dc_scrncapt_pause(struct tegra_dc_ext_control_user *ctlusr,
 		struct tegra_dc_ext_control_scrncapt_pause *args)
 {
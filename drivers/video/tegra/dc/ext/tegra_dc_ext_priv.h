@@ -24,6 +24,7 @@
 #include <linux/kthread.h>
 #include <linux/list.h>
 #include <linux/mutex.h>
+#include <linux/spinlock.h>
 #include <linux/poll.h>
 #include <uapi/video/tegra_dc_ext.h>
 
@@ -60,6 +61,8 @@ struct tegra_dc_ext_win {
 
 	/* Current dmabuf (if any) for Y, U, V planes */
 	struct tegra_dc_dmabuf	*cur_handle[TEGRA_DC_NUM_PLANES];
+	/* syncpt value of the flip that put cur_handle on screen */
+	u32			cur_syncpt_max;
 
 	struct task_struct	*flip_kthread;
 	struct kthread_worker	flip_worker;
@@ -70,6 +73,13 @@ struct tegra_dc_ext_win {
 
 	struct list_head	timestamp_queue;
 
+	/* flips waiting for their pre-fences, in submission order */
+	spinlock_t		armed_lock;
+	struct list_head	armed_queue;
+
+	/* applies a late latched update, runs on flip_worker */
+	struct kthread_work	late_latch_work;
+
 	bool			enabled;
 };
 
@@ -98,6 +108,17 @@ struct tegra_dc_ext {
 	/* scanline work */
 	struct kthread_worker	scanline_worker;
 	struct task_struct	*scanline_task;
+
+	/* updates sampled at the vpulse3 line, committed at the next vblank */
+	struct {
+		spinlock_t			lock;
+		int				line;
+		unsigned long			pending;
+		bool				cursor_pending;
+		struct tegra_dc_ext_late_latch	win[DC_N_WINDOWS];
+		struct tegra_dc_ext_late_latch	cursor;
+		struct kthread_work		cursor_work;
+	} late_latch;
 };
 
 #define TEGRA_DC_EXT_EVENT_MASK_ALL		\
@@ -196,6 +217,9 @@ extern int  tegra_dc_scrncapt_get_info(
 extern int  tegra_dc_scrncapt_dup_fbuf(
 		struct tegra_dc_ext_user *user,
 		struct tegra_dc_ext_scrncapt_dup_fbuf *args);
+extern int  tegra_dc_scrncapt_export_fbuf(
+		struct tegra_dc_ext_user *user,
+		struct tegra_dc_ext_scrncapt_export_fbuf *args);
 #else /* !CONFIG_TEGRA_DC_SCREEN_CAPTURE */
 static inline int  tegra_dc_scrncapt_init(void)
 {
@@ -1804,10 +1804,6 @@ static int tsec_hdcp_authentication(struct tegra_dc_dp_data *dp,
 	if (err)
 		goto exit;
 
-	err = tsec_hdcp_encrypt_pairing_info(hdcp_context);
-	if (err)
-		goto exit;
-
 	err = tsec_hdcp_generate_lc_init(hdcp_context);
 	if (err)
 		goto exit;
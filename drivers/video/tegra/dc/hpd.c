@@ -15,6 +15,7 @@
  */
 
 #include <linux/kernel.h>
+#include <linux/moduleparam.h>
 #ifdef CONFIG_SWITCH
 #include <linux/switch.h>
 #endif
@@ -67,9 +68,23 @@ static void hpd_disable(struct tegra_hpd_data *data)
 #endif
 }
 
-/* returns bytes read, or negative error */
-static int read_edid_into_buffer(struct tegra_hpd_data *data,
-				 u8 *edid_data, size_t edid_data_len)
+/*
+ * On resume, only compare the base block of the EDID. It carries the
+ * vendor, product and serial number of the sink, so this catches a
+ * different sink being connected but not a sink that changed its
+ * extension blocks while we were suspended.
+ */
+static bool edid_recheck_base_only;
+module_param(edid_recheck_base_only, bool, 0644);
+MODULE_PARM_DESC(edid_recheck_base_only,
+	"Skip reading EDID extension blocks when rechecking the EDID on resume");
+
+/*
+ * reads the extension blocks following the base block already in
+ * edid_data. returns bytes read, or negative error
+ */
+static int read_edid_ext_blocks(struct tegra_hpd_data *data,
+				u8 *edid_data, size_t edid_data_len)
 {
 #define EXT_BLOCK_COUNT_OFFSET 0x7e
 
@@ -77,12 +92,6 @@ static int read_edid_into_buffer(struct tegra_hpd_data *data,
 	int extension_blocks;
 	int max_ext_blocks = (edid_data_len / 128) - 1;
 
-	err = tegra_edid_read_block(data->edid, 0, edid_data);
-	if (err) {
-		pr_err("hpd: tegra_edid_read_block(0) returned err %d\n", err);
-		return err;
-	}
-
 	extension_blocks = edid_data[EXT_BLOCK_COUNT_OFFSET];
 	pr_info("hpd: extension_blocks = %d, max_ext_blocks = %d\n",
 		extension_blocks, max_ext_blocks);
@@ -113,31 +122,48 @@ static int recheck_edid(struct tegra_hpd_data *data, int *match)
 {
 	int ret;
 	u8 tmp[HPD_EDID_MAX_LENGTH] = {0};
+	struct tegra_dc_edid *dc_edid;
 
-	ret = read_edid_into_buffer(data, tmp, sizeof(tmp));
-	pr_info("hpd: read_edid_into_buffer() returned %d\n", ret);
-	if (ret > 0) {
-		struct tegra_dc_edid *dc_edid = tegra_edid_get_data(data->edid);
+	ret = tegra_edid_read_block(data->edid, 0, tmp);
+	if (ret) {
+		pr_err("hpd: tegra_edid_read_block(0) returned err %d\n", ret);
+		return ret;
+	}
 
-		if (!dc_edid) {
-			*match = 0;
-			return 0;
-		}
+	dc_edid = tegra_edid_get_data(data->edid);
+	if (!dc_edid) {
+		*match = 0;
+		return 0;
+	}
+
+	pr_info("hpd: old edid len = %ld\n", (long int)dc_edid->len);
 
-		pr_info("hpd: old edid len = %ld\n", (long int)dc_edid->len);
+	/*
+	 * A changed base block is a changed EDID, the extension
+	 * blocks only need to be read when it is the same.
+	 */
+	ret = 128;
+	*match = !!((dc_edid->len >= ret) && !memcmp(tmp, dc_edid->buf, ret));
+	if (*match && !edid_recheck_base_only) {
+		ret = read_edid_ext_blocks(data, tmp, sizeof(tmp));
+		pr_info("hpd: read_edid_ext_blocks() returned %d\n", ret);
+		if (ret < 0) {
+			tegra_edid_put_data(dc_edid);
+			return ret;
+		}
 		*match = !!((ret == dc_edid->len) &&
 			  !memcmp(tmp, dc_edid->buf, dc_edid->len));
-		if (*match == 0) {
-			print_hex_dump(KERN_INFO, "tmp :", DUMP_PREFIX_ADDRESS,
-				       16, 4, tmp, ret, true);
-			print_hex_dump(KERN_INFO, "data:", DUMP_PREFIX_ADDRESS,
-				       16, 4, dc_edid->buf, dc_edid->len, true);
-		}
-		tegra_edid_put_data(dc_edid);
-		ret = 0;
 	}
 
-	return ret;
+	if (*match == 0) {
+		print_hex_dump(KERN_INFO, "tmp :", DUMP_PREFIX_ADDRESS,
+			       16, 4, tmp, ret, true);
+		print_hex_dump(KERN_INFO, "data:", DUMP_PREFIX_ADDRESS,
+			       16, 4, dc_edid->buf, dc_edid->len, true);
+	}
+	tegra_edid_put_data(dc_edid);
+
+	return 0;
 }
 
 static void edid_read_notify(struct tegra_hpd_data *data)
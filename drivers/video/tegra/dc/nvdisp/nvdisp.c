@@ -774,6 +774,38 @@ static int tegra_nvdisp_program_output_lut(struct tegra_dc *dc,
 	return 0;
 }
 
+/*
+ * The output LUT is fetched from memory while the head scans out, so a
+ * table cannot be rewritten while it is in use without a visible glitch.
+ * Updates are written to the spare table instead, which is then swapped
+ * with the current one and has its address programmed in the ASSEMBLY
+ * state. The HW switches tables atomically when the next ACT_REQ is
+ * promoted at vblank, only after which the old table is reused.
+ */
+u64 *tegra_nvdisp_get_spare_output_lut(struct tegra_dc *dc)
+{
+	u32 act_req_mask = nvdisp_cmd_state_ctrl_general_act_req_enable_f();
+
+	if (dc->postcomp_lut_swap_pending && dc->enabled) {
+		tegra_dc_get(dc);
+		if (tegra_dc_poll_register(dc, nvdisp_cmd_state_ctrl_r(),
+					   act_req_mask, 0, 1,
+					   NVDISP_TEGRA_POLL_TIMEOUT_MS))
+			dev_warn(&dc->ndev->dev,
+				"output LUT swap is not promoted yet\n");
+		tegra_dc_put(dc);
+	}
+	dc->postcomp_lut_swap_pending = false;
+
+	return dc->nvdisp_postcomp_lut_spare.rgb;
+}
+
+void tegra_nvdisp_swap_output_lut(struct tegra_dc *dc)
+{
+	swap(dc->nvdisp_postcomp_lut, dc->nvdisp_postcomp_lut_spare);
+	dc->postcomp_lut_swap_pending = true;
+}
+
 static void nvdisp_copy_output_lut(u64 *dst, unsigned int *src, int size)
 {
 	int i;
@@ -794,6 +826,7 @@ void tegra_nvdisp_get_default_cmu(struct tegra_dc_nvdisp_cmu *default_cmu)
 static int nvdisp_alloc_output_lut(struct tegra_dc *dc)
 {
 	struct tegra_dc_nvdisp_lut *nvdisp_lut = &dc->nvdisp_postcomp_lut;
+	struct tegra_dc_nvdisp_lut *spare = &dc->nvdisp_postcomp_lut_spare;
 
 	if (!nvdisp_lut)
 		return -ENOMEM;
@@ -805,6 +838,17 @@ static int nvdisp_alloc_output_lut(struct tegra_dc *dc)
 	if (!nvdisp_lut->rgb)
 		return -ENOMEM;
 
+	/* and the spare one LUT updates are written to */
+	spare->size = nvdisp_lut->size;
+	spare->rgb = (u64 *)dma_zalloc_coherent(&dc->ndev->dev,
+			spare->size, &spare->phy_addr, GFP_KERNEL);
+	if (!spare->rgb) {
+		dma_free_coherent(&dc->ndev->dev, nvdisp_lut->size,
+			nvdisp_lut->rgb, nvdisp_lut->phy_addr);
+		nvdisp_lut->rgb = NULL;
+		return -ENOMEM;
+	}
+
 	/* Init LUT with cmu data provided from DT file */
 	if (dc->pdata->nvdisp_cmu && dc->pdata->cmu_enable) {
 		memcpy(nvdisp_lut->rgb, dc->pdata->nvdisp_cmu->rgb,
@@ -1348,22 +1392,24 @@ void tegra_nvdisp_set_chroma_lpf(struct tegra_dc *dc)
 static int _tegra_nvdisp_set_ec_output_lut(struct tegra_dc *dc,
 			struct tegra_dc_mode *mode)
 {
-	struct tegra_dc_nvdisp_lut *nvdisp_lut = &dc->nvdisp_postcomp_lut;
+	unsigned int *regamma_lut = NULL;
 
-	if (!nvdisp_lut)
+	if (!dc->nvdisp_postcomp_lut.rgb)
 		return -ENOMEM;
 
 	if (mode->vmode & FB_VMODE_SET_YUV_MASK) {
 		if (mode->vmode & FB_VMODE_Y24 ||
-		    mode->vmode & FB_VMODE_Y30) {
-			nvdisp_copy_output_lut(nvdisp_lut->rgb,
-				yuv8_10bpc_regamma_lut,
-				NVDISP_OUTPUT_LUT_SIZE);
-		} else if (mode->vmode & FB_VMODE_Y36) {
-			nvdisp_copy_output_lut(nvdisp_lut->rgb,
-				yuv12bpc_regamma_lut,
-				NVDISP_OUTPUT_LUT_SIZE);
-		}
+		    mode->vmode & FB_VMODE_Y30)
+			regamma_lut = yuv8_10bpc_regamma_lut;
+		else if (mode->vmode & FB_VMODE_Y36)
+			regamma_lut = yuv12bpc_regamma_lut;
+	}
+
+	/* programmed to HW along with the rest of the mode */
+	if (regamma_lut) {
+		nvdisp_copy_output_lut(tegra_nvdisp_get_spare_output_lut(dc),
+			regamma_lut, NVDISP_OUTPUT_LUT_SIZE);
+		tegra_nvdisp_swap_output_lut(dc);
 	}
 
 	return 0;
@@ -2655,8 +2701,9 @@ void tegra_dc_cache_nvdisp_cmu(struct tegra_dc *dc,
 				struct tegra_dc_nvdisp_cmu *src_cmu)
 {
 	/* copy the data to DC lut */
-	memcpy(dc->nvdisp_postcomp_lut.rgb, src_cmu->rgb,
+	memcpy(tegra_nvdisp_get_spare_output_lut(dc), src_cmu->rgb,
 		dc->nvdisp_postcomp_lut.size);
+	tegra_nvdisp_swap_output_lut(dc);
 	dc->cmu_dirty = true;
 }
 
@@ -4479,10 +4526,15 @@ void tegra_nvdisp_set_output_lut(struct tegra_dc *dc,
 	if (user_nvdisp_cmu->cmu_enable) {
 		reg_val |= nvdisp_color_ctl_cmu_enable_f();
 		if (new_cmu_values) {
-			nvdisp_lut = &dc->nvdisp_postcomp_lut;
-			nvdisp_copy_output_lut(nvdisp_lut->rgb,
+			nvdisp_copy_output_lut(
+				tegra_nvdisp_get_spare_output_lut(dc),
 				(unsigned int *)&user_nvdisp_cmu->rgb,
 				NVDISP_OUTPUT_LUT_SIZE);
+			tegra_nvdisp_swap_output_lut(dc);
+
+			/* promoted at vblank together with the flip */
+			nvdisp_lut = &dc->nvdisp_postcomp_lut;
+			tegra_nvdisp_program_output_lut(dc, nvdisp_lut);
 		}
 	} else {
 		reg_val &= ~nvdisp_color_ctl_cmu_enable_f();
@@ -137,6 +137,39 @@ static int tegra_nvdisp_program_final_bw_settings(
 	return ret;
 }
 
+/*
+ * Remember the bw of a proposed configuration. Compositors typically cycle
+ * through a handful of layouts, and keeping the largest of the recent ones
+ * reserved lets them come back without another isomgr transaction, which
+ * may also fail if another ISO client took the bw in the meantime.
+ */
+static void tegra_nvdisp_bw_history_add(u32 iso_bw, u32 total_bw, u32 emc,
+					u32 hubclk)
+{
+	struct nvdisp_bandwidth_config *entry;
+
+	entry = &ihub_bw_info.history[ihub_bw_info.history_idx];
+	entry->iso_bw = iso_bw;
+	entry->total_bw = total_bw;
+	entry->emc_la_floor = emc;
+	entry->hubclk = hubclk;
+
+	ihub_bw_info.history_idx =
+		(ihub_bw_info.history_idx + 1) % NVDISP_BW_HISTORY_DEPTH;
+}
+
+static struct nvdisp_bandwidth_config *tegra_nvdisp_bw_history_max(void)
+{
+	struct nvdisp_bandwidth_config *max = &ihub_bw_info.history[0];
+	int i;
+
+	for (i = 1; i < NVDISP_BW_HISTORY_DEPTH; i++)
+		if (ihub_bw_info.history[i].iso_bw > max->iso_bw)
+			max = &ihub_bw_info.history[i];
+
+	return max;
+}
+
 int tegra_nvdisp_program_bandwidth(struct tegra_dc *dc,
 				u32 new_iso_bw,
 				u32 new_total_bw,
@@ -205,21 +238,41 @@ int tegra_nvdisp_program_bandwidth(struct tegra_dc *dc,
 		u32 max_bw = tegra_nvdisp_get_max_pending_bw(dc);
 		if (new_iso_bw >= max_bw &&
 					new_iso_bw < cur_config->iso_bw) {
+			struct nvdisp_bandwidth_config *hist =
+				tegra_nvdisp_bw_history_max();
+			u32 resv_bw = new_iso_bw;
+			u32 resv_emc = new_emc;
+			u32 resv_hubclk = new_hubclk;
+
+			/*
+			 * Only give back what none of the recently proposed
+			 * configurations need anymore.
+			 */
+			if (hist->iso_bw > resv_bw &&
+				hist->iso_bw <= ihub_bw_info.available_bw) {
+				resv_bw = min(hist->iso_bw,
+					ihub_bw_info.reserved_bw);
+				resv_emc = hist->emc_la_floor;
+				resv_hubclk = hist->hubclk;
+			}
+
 			/*
 			 * Client's latency tolerance is ignored by isomgr. Pass
 			 * in a dummy value of 1000 usec.
 			 */
-			if (!tegra_isomgr_reserve(ihub_bw_info.isomgr_handle,
-						new_iso_bw,
-						1000)) {
-				pr_err("%s: failed to reserve %u KB/s\n",
-					__func__, new_iso_bw);
-				return -EINVAL;
+			if (resv_bw != ihub_bw_info.reserved_bw) {
+				if (!tegra_isomgr_reserve(
+						ihub_bw_info.isomgr_handle,
+						resv_bw, 1000)) {
+					pr_err("%s: failed to reserve %u KB/s\n",
+						__func__, resv_bw);
+					return -EINVAL;
+				}
+
+				ihub_bw_info.reserved_bw = resv_bw;
+				ihub_bw_info.emc_at_res_bw = resv_emc;
+				ihub_bw_info.hubclk_at_res_bw = resv_hubclk;
 			}
-
-			ihub_bw_info.reserved_bw = new_iso_bw;
-			ihub_bw_info.emc_at_res_bw = new_emc;
-			ihub_bw_info.hubclk_at_res_bw = new_hubclk;
 			cur_config->total_bw = new_total_bw;
 
 			final_iso_bw = new_iso_bw;
@@ -271,6 +324,8 @@ void tegra_nvdisp_init_bandwidth(struct tegra_dc *dc)
 
 	memset(&ihub_bw_info.cur_config, 0, sizeof(ihub_bw_info.cur_config));
 	ihub_bw_info.reserved_bw = 0;
+	memset(ihub_bw_info.history, 0, sizeof(ihub_bw_info.history));
+	ihub_bw_info.history_idx = 0;
 
 	tegra_nvdisp_negotiate_reserved_bw(dc,
 				new_iso_bw,
@@ -348,6 +403,9 @@ int tegra_nvdisp_negotiate_reserved_bw(struct tegra_dc *dc,
 		goto exit;
 	}
 
+	tegra_nvdisp_bw_history_add(new_iso_bw, new_total_bw, new_emc,
+				    new_hubclk);
+
 	if (new_iso_bw > ihub_bw_info.reserved_bw) { /* Case B */
 		/*
 		 * Client's latency tolerance is ignored by isomgr. Pass in a
@@ -376,6 +434,42 @@ exit:
 	return ret;
 }
 
+/*
+ * tegra_nvdisp_query_bandwidth - check a proposed ISO bw against the current
+ * reservation and what isomgr allows us, without reserving anything
+ *
+ * @query	query, iso_bw is the input
+ *
+ * @retval	0 on success
+ */
+int tegra_nvdisp_query_bandwidth(struct tegra_dc_ext_control_bw_query *query)
+{
+	if (query->reserved[0] || query->reserved[1])
+		return -EINVAL;
+
+	if (IS_ERR_OR_NULL(ihub_bw_info.isomgr_handle) ||
+				IS_ERR_OR_NULL(ihub_bw_info.bwmgr_handle))
+		return -ENODEV;
+
+	mutex_lock(&tegra_nvdisp_lock);
+
+	query->flags = 0;
+	query->avail_bw = ihub_bw_info.available_bw;
+	query->resvd_bw = ihub_bw_info.reserved_bw;
+	query->cur_bw = ihub_bw_info.cur_config.iso_bw;
+	query->max_bw = ihub_bw_info.max_config.iso_bw;
+
+	if (query->iso_bw <= ihub_bw_info.available_bw)
+		query->flags |= TEGRA_DC_EXT_BW_QUERY_FLAG_FITS;
+	if (query->iso_bw <= ihub_bw_info.reserved_bw)
+		query->flags |= TEGRA_DC_EXT_BW_QUERY_FLAG_RESERVED;
+
+	mutex_unlock(&tegra_nvdisp_lock);
+
+	return 0;
+}
+EXPORT_SYMBOL(tegra_nvdisp_query_bandwidth);
+
 static void tegra_nvdisp_bandwidth_renegotiate(void *p, u32 avail_bw)
 {
 	struct tegra_dc_bw_data data;
@@ -662,5 +756,9 @@ long tegra_nvdisp_calc_min_bandwidth(struct tegra_dc *dc)
 {
 	return -ENOSYS;
 }
+int tegra_nvdisp_query_bandwidth(struct tegra_dc_ext_control_bw_query *query)
+{
+	return -ENOSYS;
+}
 #endif /* CONFIG_TEGRA_ISOMGR */
 
@@ -125,7 +125,26 @@ static inline u32 nvdisp_win_read(struct tegra_dc_win *win, u32 off)
 }
 
 
-static inline void nvdisp_win_write(struct tegra_dc_win *win, u32 val, u32 off)
+/*
+ * Shadow of the WIN and the low WINBUF registers of each window, which hold
+ * all the per flip state. Flips go through nvdisp_win_write_cached(), which
+ * skips registers whose value did not change, so that e.g. a flip changing
+ * only the surface address costs two register writes. Any other write
+ * invalidates the shadow of the register.
+ * The cache is only valid while a window is owned by a head, it is reset at
+ * window attach and detach, and when the window is disabled.
+ */
+#define NVDISP_WIN_REGCACHE_WORDS	0x140
+
+struct nvdisp_win_regcache {
+	u32 val[NVDISP_WIN_REGCACHE_WORDS];
+	DECLARE_BITMAP(valid, NVDISP_WIN_REGCACHE_WORDS);
+};
+
+extern struct nvdisp_win_regcache nvdisp_win_regcache[DC_N_WINDOWS];
+
+static inline void __nvdisp_win_write(struct tegra_dc_win *win, u32 val,
+				      u32 off)
 {
 	u32 reg;
 	struct tegra_dc *dc = win->dc;
@@ -135,6 +154,51 @@ static inline void nvdisp_win_write(struct tegra_dc_win *win, u32 val, u32 off)
 	writel(val, dc->base + reg);
 }
 
+static inline void nvdisp_win_write(struct tegra_dc_win *win, u32 val, u32 off)
+{
+	u32 i = off - win_base_addr_dc_win_r();
+
+	__nvdisp_win_write(win, val, off);
+
+	/* must follow the write, see nvdisp_win_write_cached() */
+	if (i < NVDISP_WIN_REGCACHE_WORDS)
+		clear_bit(i, nvdisp_win_regcache[win->idx].valid);
+}
+
+/* Caller must hold tegra_nvdisp_lock */
+static inline void nvdisp_win_write_cached(struct tegra_dc_win *win, u32 val,
+					   u32 off)
+{
+	struct nvdisp_win_regcache *cache = &nvdisp_win_regcache[win->idx];
+	u32 i = off - win_base_addr_dc_win_r();
+
+	if (i >= NVDISP_WIN_REGCACHE_WORDS) {
+		nvdisp_win_write(win, val, off);
+		return;
+	}
+
+	if (test_bit(i, cache->valid) && cache->val[i] == val) {
+		win->dc->stats.win_regs_skipped++;
+		return;
+	}
+
+	/*
+	 * Update the shadow before the register. A concurrent uncached write
+	 * invalidates the shadow only after its own register write, so the
+	 * shadow can never be left valid with a value the register lost.
+	 */
+	cache->val[i] = val;
+	set_bit(i, cache->valid);
+	__nvdisp_win_write(win, val, off);
+	win->dc->stats.win_regs_written++;
+}
+
+static inline void nvdisp_win_regcache_invalidate(struct tegra_dc_win *win)
+{
+	bitmap_zero(nvdisp_win_regcache[win->idx].valid,
+		    NVDISP_WIN_REGCACHE_WORDS);
+}
+
 static inline bool tegra_dc_is_yuv_12bpc(int fmt)
 {
 	switch (tegra_dc_fmt(fmt)) {
@@ -28,6 +28,8 @@
 
 #define NVDISP_ODD_VAL(x) ((x) % (2))
 
+struct nvdisp_win_regcache nvdisp_win_regcache[DC_N_WINDOWS];
+
 /* Num Fractional Bits in 8.24 fixed point phase and phase increment values */
 #define NFB 24
 
@@ -131,14 +133,14 @@ static int tegra_nvdisp_blend(struct tegra_dc_win *win)
 			win_blend_layer_control_k1_f(blend->alpha[idx]) |
 			win_blend_layer_control_blend_enable_enable_f());
 
-			nvdisp_win_write(win,
+			nvdisp_win_write_cached(win,
 			WIN_BLEND_FACT_SRC_COLOR_MATCH_SEL_K1_TIMES_SRC |
 			WIN_BLEND_FACT_DST_COLOR_MATCH_SEL_NEG_K1_TIMES_SRC |
 			WIN_BLEND_FACT_SRC_ALPHA_MATCH_SEL_K2 |
 			WIN_BLEND_FACT_DST_ALPHA_MATCH_SEL_ZERO,
 			win_blend_match_select_r());
 
-			nvdisp_win_write(win,
+			nvdisp_win_write_cached(win,
 			WIN_BLEND_FACT_SRC_COLOR_NOMATCH_SEL_K1_TIMES_SRC |
 			WIN_BLEND_FACT_DST_COLOR_NOMATCH_SEL_NEG_K1_TIMES_SRC |
 			WIN_BLEND_FACT_SRC_ALPHA_NOMATCH_SEL_K2 |
@@ -152,14 +154,14 @@ static int tegra_nvdisp_blend(struct tegra_dc_win *win)
 			win_blend_layer_control_k1_f(blend->alpha[idx]) |
 			win_blend_layer_control_blend_enable_enable_f());
 
-			nvdisp_win_write(win,
+			nvdisp_win_write_cached(win,
 			WIN_BLEND_FACT_SRC_COLOR_MATCH_SEL_K1 |
 			WIN_BLEND_FACT_DST_COLOR_MATCH_SEL_NEG_K1_TIMES_SRC |
 			WIN_BLEND_FACT_SRC_ALPHA_MATCH_SEL_K2 |
 			WIN_BLEND_FACT_DST_ALPHA_MATCH_SEL_ZERO,
 			win_blend_match_select_r());
 
-			nvdisp_win_write(win,
+			nvdisp_win_write_cached(win,
 			WIN_BLEND_FACT_SRC_COLOR_NOMATCH_SEL_NEG_K1_TIMES_DST |
 			WIN_BLEND_FACT_DST_COLOR_NOMATCH_SEL_K1 |
 			WIN_BLEND_FACT_SRC_ALPHA_NOMATCH_SEL_K2 |
@@ -173,7 +175,7 @@ static int tegra_nvdisp_blend(struct tegra_dc_win *win)
 			win_blend_layer_control_k1_f(0xff) |
 			win_blend_layer_control_blend_enable_enable_f());
 
-			nvdisp_win_write(win,
+			nvdisp_win_write_cached(win,
 			/* note: WIN_BLEND_FACT_SRC_COLOR_MATCH_SEL_ONE is not
 			 * supported. Use K1 set to one instead. */
 			WIN_BLEND_FACT_SRC_COLOR_MATCH_SEL_K1 |
@@ -182,7 +184,7 @@ static int tegra_nvdisp_blend(struct tegra_dc_win *win)
 			WIN_BLEND_FACT_DST_ALPHA_MATCH_SEL_ZERO,
 			win_blend_match_select_r());
 
-			nvdisp_win_write(win,
+			nvdisp_win_write_cached(win,
 			WIN_BLEND_FACT_SRC_COLOR_NOMATCH_SEL_ZERO |
 			WIN_BLEND_FACT_DST_COLOR_NOMATCH_SEL_ZERO |
 			WIN_BLEND_FACT_SRC_ALPHA_NOMATCH_SEL_ZERO |
@@ -194,7 +196,7 @@ static int tegra_nvdisp_blend(struct tegra_dc_win *win)
 			win_blend_layer_control_blend_enable_bypass_f();
 		}
 
-		nvdisp_win_write(win, blend_ctrl,
+		nvdisp_win_write_cached(win, blend_ctrl,
 			win_blend_layer_control_r());
 	}
 	return 0;
@@ -260,17 +262,27 @@ static int tegra_nvdisp_scaling(struct tegra_dc_win *win)
 		min_width = (dfixed_trunc(hscalar) < win->out_w) ?
 			dfixed_trunc(hscalar) : win->out_w;
 
-		win_capc = nvdisp_win_read(win, win_precomp_wgrp_capc_r());
-		win_cape = nvdisp_win_read(win, win_precomp_wgrp_cape_r());
+		/* read once at window attach, avoid MMIO reads on flips */
+		if (win->precomp_caps_read) {
+			win_capc = win->precomp_capc;
+			win_cape = win->precomp_cape;
+		} else {
+			win_capc = nvdisp_win_read(win,
+					win_precomp_wgrp_capc_r());
+			win_cape = nvdisp_win_read(win,
+					win_precomp_wgrp_cape_r());
+		}
 
 		if (min_width <
 			win_precomp_wgrp_capc_max_pixels_5tap444_v(win_capc)) {
-			nvdisp_win_write(win, win_scaler_input_h_taps_5_f() |
+			nvdisp_win_write_cached(win,
+				win_scaler_input_h_taps_5_f() |
 				win_scaler_input_v_taps_5_f(),
 				win_scaler_input_r());
 		} else if (min_width <
 			win_precomp_wgrp_cape_max_pixels_2tap444_v(win_cape)) {
-			nvdisp_win_write(win, win_scaler_input_h_taps_2_f() |
+			nvdisp_win_write_cached(win,
+				win_scaler_input_h_taps_2_f() |
 				win_scaler_input_v_taps_2_f(),
 				win_scaler_input_r());
 		} else {
@@ -283,7 +295,7 @@ static int tegra_nvdisp_scaling(struct tegra_dc_win *win)
 		}
 	}
 
-	nvdisp_win_write(win, win_scaler_usage_hbypass_f(hbypass) |
+	nvdisp_win_write_cached(win, win_scaler_usage_hbypass_f(hbypass) |
 		win_scaler_usage_vbypass_f(vbypass) |
 		win_scaler_usage_use422_disable_f(), win_scaler_usage_r());
 
@@ -298,11 +310,11 @@ static int tegra_nvdisp_scaling(struct tegra_dc_win *win)
 		dev_dbg(&win->dc->ndev->dev,
 			"h_init_phase: 0x%x.\n", h_init_phase);
 
-		nvdisp_win_write(win,
+		nvdisp_win_write_cached(win,
 			win_scaler_hphase_incr_incr_f(hphase_incr),
 			win_scaler_hphase_incr_r());
 
-		nvdisp_win_write(win,
+		nvdisp_win_write_cached(win,
 			win_scaler_hstart_phase_phase_f(h_init_phase),
 			win_scaler_hstart_phase_r());
 	}
@@ -318,11 +330,11 @@ static int tegra_nvdisp_scaling(struct tegra_dc_win *win)
 		dev_dbg(&win->dc->ndev->dev,
 			"v_init_phase: 0x%x.\n", v_init_phase);
 
-		nvdisp_win_write(win,
+		nvdisp_win_write_cached(win,
 			win_scaler_vphase_incr_incr_f(vphase_incr),
 			win_scaler_vphase_incr_r());
 
-		nvdisp_win_write(win,
+		nvdisp_win_write_cached(win,
 			win_scaler_vstart_phase_phase_f(v_init_phase),
 			win_scaler_vstart_phase_r());
 	}
@@ -410,22 +422,24 @@ int tegra_nvdisp_verify_win_properties(struct tegra_dc *dc,
 static int tegra_nvdisp_enable_cde(struct tegra_dc_win *win)
 {
 	if (win->cde.cde_addr) {
-		nvdisp_win_write(win, tegra_dc_reg_l32(win->cde.cde_addr),
+		nvdisp_win_write_cached(win,
+			tegra_dc_reg_l32(win->cde.cde_addr),
 			win_cde_base_r());
-		nvdisp_win_write(win, tegra_dc_reg_h32(win->cde.cde_addr),
+		nvdisp_win_write_cached(win,
+			tegra_dc_reg_h32(win->cde.cde_addr),
 			win_cde_base_hi_r());
-		nvdisp_win_write(win,
+		nvdisp_win_write_cached(win,
 			win_cde_zbc_color_f(win->cde.zbc_color),
 			win_cde_zbc_r());
-		nvdisp_win_write(win,
+		nvdisp_win_write_cached(win,
 			win_cde_ctb_entry_f(win->cde.ctb_entry),
 			win_cde_ctb_r());
-		nvdisp_win_write(win,
+		nvdisp_win_write_cached(win,
 			win_cde_ctrl_surface_enable_f(),
 			win_cde_ctrl_r());
 
 	} else {
-		nvdisp_win_write(win,
+		nvdisp_win_write_cached(win,
 			0,
 			win_cde_ctrl_r());
 	}
@@ -729,23 +743,24 @@ static int tegra_nvdisp_win_attribute(struct tegra_dc_win *win,
 	if (tegra_dc_is_t19x())
 		addr_flag = nvdisp_t19x_get_addr_flag(win);
 	swap_uv = tegra_nvdisp_win_swap_uv(win);
-	nvdisp_win_write(win, tegra_dc_fmt(win->fmt), win_color_depth_r());
-	nvdisp_win_write(win, win_wgrp_params_swap_uv_f(swap_uv),
+	nvdisp_win_write_cached(win, tegra_dc_fmt(win->fmt),
+		win_color_depth_r());
+	nvdisp_win_write_cached(win, win_wgrp_params_swap_uv_f(swap_uv),
 		 win_wgrp_params_r());
 
-	nvdisp_win_write(win,
+	nvdisp_win_write_cached(win,
 		win_position_v_position_f(win->out_y) |
 		win_position_h_position_f(win->out_x),
 		win_position_r());
 
 	if (tegra_dc_feature_has_interlace(dc, win->idx) &&
 		(dc->mode.vmode == FB_VMODE_INTERLACED)) {
-		nvdisp_win_write(win,
+		nvdisp_win_write_cached(win,
 			win_size_v_size_f((win->out_h) >> 1) |
 			win_size_h_size_f(win->out_w),
 			win_size_r());
 	} else {
-		nvdisp_win_write(win, win_size_v_size_f(win->out_h) |
+		nvdisp_win_write_cached(win, win_size_v_size_f(win->out_h) |
 			win_size_h_size_f(win->out_w),
 			win_size_r());
 	}
@@ -771,48 +786,48 @@ static int tegra_nvdisp_win_attribute(struct tegra_dc_win *win,
 	if (win_options & win_options_cp_enable_enable_f())
 		tegra_dc_set_nvdisp_lut(dc, win);
 
-	nvdisp_win_write(win, win_options, win_options_r());
+	nvdisp_win_write_cached(win, win_options, win_options_r());
 
-	nvdisp_win_write(win,
+	nvdisp_win_write_cached(win,
 		win_set_cropped_size_in_height_f(dfixed_trunc(win->h)) |
 		win_set_cropped_size_in_width_f(dfixed_trunc(win->w)),
 		win_set_cropped_size_in_r());
 
 	win->phys_addr |= addr_flag;
-	nvdisp_win_write(win, tegra_dc_reg_l32(win->phys_addr),
+	nvdisp_win_write_cached(win, tegra_dc_reg_l32(win->phys_addr),
 		win_start_addr_r());
-	nvdisp_win_write(win, tegra_dc_reg_h32(win->phys_addr),
+	nvdisp_win_write_cached(win, tegra_dc_reg_h32(win->phys_addr),
 		win_start_addr_hi_r());
 
 	/*	pitch is in 64B chunks	*/
-	nvdisp_win_write(win, (win->stride>>6),
+	nvdisp_win_write_cached(win, (win->stride>>6),
 		win_set_planar_storage_r());
 
 	if (yuvp) {
 		win->phys_addr_u |= addr_flag;
 		win->phys_addr_v |= addr_flag;
 
-		nvdisp_win_write(win, tegra_dc_reg_l32(win->phys_addr_u),
+		nvdisp_win_write_cached(win, tegra_dc_reg_l32(win->phys_addr_u),
 			win_start_addr_u_r());
-		nvdisp_win_write(win, tegra_dc_reg_h32(win->phys_addr_u),
+		nvdisp_win_write_cached(win, tegra_dc_reg_h32(win->phys_addr_u),
 			win_start_addr_hi_u_r());
-		nvdisp_win_write(win, tegra_dc_reg_l32(win->phys_addr_v),
+		nvdisp_win_write_cached(win, tegra_dc_reg_l32(win->phys_addr_v),
 			win_start_addr_v_r());
-		nvdisp_win_write(win, tegra_dc_reg_h32(win->phys_addr_v),
+		nvdisp_win_write_cached(win, tegra_dc_reg_h32(win->phys_addr_v),
 			win_start_addr_hi_v_r());
 
-		nvdisp_win_write(win,
+		nvdisp_win_write_cached(win,
 			win_set_planar_storage_uv_uv0_f(win->stride_uv>>6) |
 			win_set_planar_storage_uv_uv1_f(win->stride_uv>>6),
 			win_set_planar_storage_uv_r());
 	} else if (yuvsp) {
 		win->phys_addr_u |= addr_flag;
-		nvdisp_win_write(win, tegra_dc_reg_l32(win->phys_addr_u),
+		nvdisp_win_write_cached(win, tegra_dc_reg_l32(win->phys_addr_u),
 			win_start_addr_u_r());
-		nvdisp_win_write(win, tegra_dc_reg_h32(win->phys_addr_u),
+		nvdisp_win_write_cached(win, tegra_dc_reg_h32(win->phys_addr_u),
 			win_start_addr_hi_u_r());
 
-		nvdisp_win_write(win,
+		nvdisp_win_write_cached(win,
 			win_set_planar_storage_uv_uv0_f(win->stride_uv>>6),
 			win_set_planar_storage_uv_r());
 	}
@@ -852,9 +867,9 @@ static int tegra_nvdisp_win_attribute(struct tegra_dc_win *win,
 			win_win_set_params_degamma_range_none_f();
 	}
 
-	nvdisp_win_write(win, win_params, win_win_set_params_r());
+	nvdisp_win_write_cached(win, win_params, win_win_set_params_r());
 
-	nvdisp_win_write(win,
+	nvdisp_win_write_cached(win,
 			win_cropped_point_h_offset_f(dfixed_trunc(h_offset))|
 			win_cropped_point_v_offset_f(dfixed_trunc(v_offset)),
 			win_cropped_point_r());
@@ -867,48 +882,48 @@ static int tegra_nvdisp_win_attribute(struct tegra_dc_win *win,
 	if (tegra_dc_feature_has_interlace(dc, win->idx) &&
 		(dc->mode.vmode == FB_VMODE_INTERLACED)) {
 			win->phys_addr2 |= addr_flag;
-			nvdisp_win_write(win,
+			nvdisp_win_write_cached(win,
 				tegra_dc_reg_l32(win->phys_addr2),
 				win_start_addr_fld2_r());
-			nvdisp_win_write(win,
+			nvdisp_win_write_cached(win,
 				tegra_dc_reg_h32(win->phys_addr2),
 				win_start_addr_fld2_hi_r());
 		if (yuvp) {
 			win->phys_addr_u2 |= addr_flag;
 			win->phys_addr_v2 |= addr_flag;
-			nvdisp_win_write(win,
+			nvdisp_win_write_cached(win,
 				tegra_dc_reg_l32(win->phys_addr_u2),
 				win_start_addr_fld2_u_r());
-			nvdisp_win_write(win,
+			nvdisp_win_write_cached(win,
 				tegra_dc_reg_h32(win->phys_addr_u2),
 				win_start_addr_fld2_hi_u_r());
-			nvdisp_win_write(win,
+			nvdisp_win_write_cached(win,
 				tegra_dc_reg_l32(win->phys_addr_v2),
 				win_start_addr_fld2_v_r());
-			nvdisp_win_write(win,
+			nvdisp_win_write_cached(win,
 				tegra_dc_reg_h32(win->phys_addr_v2),
 				win_start_addr_fld2_hi_v_r());
 		} else if (yuvsp) {
 			win->phys_addr_u2 |= addr_flag;
-			nvdisp_win_write(win,
+			nvdisp_win_write_cached(win,
 				tegra_dc_reg_l32(win->phys_addr_u2),
 				win_start_addr_fld2_u_r());
-			nvdisp_win_write(win,
+			nvdisp_win_write_cached(win,
 				tegra_dc_reg_h32(win->phys_addr_u2),
 				win_start_addr_fld2_hi_u_r());
 		}
-		nvdisp_win_write(win,
+		nvdisp_win_write_cached(win,
 			win_cropped_point_fld2_h_f(dfixed_trunc(h_offset)),
 			win_cropped_point_fld2_r());
 
 		if (WIN_IS_INTERLACE(win)) {
-			nvdisp_win_write(win,
+			nvdisp_win_write_cached(win,
 				win_cropped_point_fld2_v_f(
 						dfixed_trunc(v_offset)),
 				win_cropped_point_fld2_r());
 		} else {
 			v_offset.full += dfixed_const(1);
-			nvdisp_win_write(win,
+			nvdisp_win_write_cached(win,
 				win_cropped_point_fld2_v_f(
 						dfixed_trunc(v_offset)),
 				win_cropped_point_fld2_r());
@@ -916,14 +931,14 @@ static int tegra_nvdisp_win_attribute(struct tegra_dc_win *win,
 	}
 
 	if (WIN_IS_BLOCKLINEAR(win)) {
-		nvdisp_win_write(win, win_surface_kind_kind_bl_f() |
+		nvdisp_win_write_cached(win, win_surface_kind_kind_bl_f() |
 			win_surface_kind_block_height_f(win->block_height_log2),
 			win_surface_kind_r());
 	} else if (WIN_IS_TILED(win)) {
-		nvdisp_win_write(win, win_surface_kind_kind_tiled_f(),
+		nvdisp_win_write_cached(win, win_surface_kind_kind_tiled_f(),
 			win_surface_kind_r());
 	} else {
-		nvdisp_win_write(win, win_surface_kind_kind_pitch_f(),
+		nvdisp_win_write_cached(win, win_surface_kind_kind_pitch_f(),
 			win_surface_kind_r());
 	}
 
@@ -1031,10 +1046,12 @@ int tegra_nvdisp_update_windows(struct tegra_dc *dc,
 				win_act_control_ctrl_sel_vcounter_f(),
 				win_act_control_r());
 
+			nvdisp_win_regcache_invalidate(win);
+
 			dc_win->dirty = no_vsync ? 0 : 1;
 		} else {
 			/* attach window to the head */
-			nvdisp_win_write(win, dc->ctrl_num,
+			nvdisp_win_write_cached(win, dc->ctrl_num,
 					win_set_control_r());
 
 			update_mask |= nvdisp_cmd_state_ctrl_win_a_update_enable_f()
@@ -1074,6 +1091,7 @@ int tegra_nvdisp_update_windows(struct tegra_dc *dc,
 			}
 
 			dc_win->dirty = 1;
+			dc->stats.win_updates++;
 		}
 
 		trace_window_update(dc, win);
@@ -1192,6 +1210,7 @@ int tegra_nvdisp_detach_win(struct tegra_dc *dc, unsigned idx)
 	/* detach window idx */
 	nvdisp_win_write(win,
 		win_set_control_owner_none_f(), win_set_control_r());
+	nvdisp_win_regcache_invalidate(win);
 
 	win->dc = NULL;
 	win->is_scaler_coeff_set = false;
@@ -1213,6 +1232,7 @@ int tegra_nvdisp_assign_win(struct tegra_dc *dc, unsigned idx)
 		 * call attach idx for safety. Can remove this
 		 * once make sure detach_win is called before attach
 		 */
+		nvdisp_win_regcache_invalidate(win);
 		nvdisp_win_write(win, dc->ctrl_num, win_set_control_r());
 		return 0;
 	}
@@ -1228,6 +1248,9 @@ int tegra_nvdisp_assign_win(struct tegra_dc *dc, unsigned idx)
 
 	win->dc = dc;
 
+	/* the window may have lost its state while it was not owned */
+	nvdisp_win_regcache_invalidate(win);
+
 	/* attach window idx */
 	nvdisp_win_write(win, dc->ctrl_num, win_set_control_r());
 
@@ -20,6 +20,8 @@
 #include <linux/slab.h>
 #include <linux/backlight.h>
 #include <linux/stat.h>
+#include <linux/ktime.h>
+#include <linux/math64.h>
 
 #include "dc.h"
 #include "dc_reg.h"
@@ -45,6 +47,8 @@ VRR_ATTR(max_adj_pct);
 VRR_ATTR(max_flip_pct);
 VRR_ATTR(max_dcb);
 VRR_ATTR(max_inc_pct);
+VRR_ATTR(content_adaptive);
+VRR_ATTR(cadence_us);
 
 static struct attribute *vrr_attrs[] = {
 	VRR_ATTRS_ENTRY(capability),
@@ -54,6 +58,8 @@ static struct attribute *vrr_attrs[] = {
 	VRR_ATTRS_ENTRY(max_flip_pct),
 	VRR_ATTRS_ENTRY(max_dcb),
 	VRR_ATTRS_ENTRY(max_inc_pct),
+	VRR_ATTRS_ENTRY(content_adaptive),
+	VRR_ATTRS_ENTRY(cadence_us),
 	NULL,
 };
 
@@ -90,6 +96,12 @@ static ssize_t vrr_settings_show(struct kobject *kobj,
 		res = snprintf(buf, PAGE_SIZE, "%d\n", vrr->max_dcb);
 	else if (IS_VRR_ATTR(max_inc_pct))
 		res = snprintf(buf, PAGE_SIZE, "%d\n", vrr->max_inc_pct);
+	else if (IS_VRR_ATTR(content_adaptive))
+		res = snprintf(buf, PAGE_SIZE, "%d\n", vrr->cadence_enable);
+	else if (IS_VRR_ATTR(cadence_us))
+		/* 0 while the refresh is not locked to the content */
+		res = snprintf(buf, PAGE_SIZE, "%d\n",
+			vrr->cadence_locked ? vrr->cadence_us : 0);
 	else
 		res = -EINVAL;
 
@@ -149,13 +161,119 @@ static ssize_t vrr_settings_store(struct kobject *kobj,
 		vrr_check_and_update(0, 50000, max_dcb)
 	else if (IS_VRR_ATTR(max_inc_pct))
 		vrr_check_and_update(0, 100, max_inc_pct)
-	else
+	else if (IS_VRR_ATTR(content_adaptive)) {
+		vrr_check_and_update(0, 1, cadence_enable)
+		if (!vrr->cadence_enable)
+			vrr->cadence_locked = 0;
+	} else
 		res = -EINVAL;
 
 	mutex_unlock(&dc->lock);
 	return res;
 }
 
+/*
+ * Content adaptive refresh
+ *
+ * Video players flip at a steady cadence (24, 25, 30 fps...), which flip
+ * driven VRR follows with a jittery refresh, or which a fixed 60Hz refresh
+ * scans out with judder. Once the flip cadence has been stable for
+ * VRR_CADENCE_LOCK_FLIPS flips, lock the refresh to the lowest integer
+ * multiple of the content rate the monitor supports, by programming a
+ * fixed active VFP, and stop stretching frames until the next flip. A flip
+ * off the cadence unlocks it and falls back to flip driven VRR.
+ */
+#define VRR_CADENCE_LOCK_FLIPS		8
+#define VRR_CADENCE_TOLERANCE_US	1000
+#define VRR_CADENCE_MAX_US		(USEC_PER_SEC / 10)
+
+static int vrr_cadence_vfp(struct tegra_dc *dc, struct tegra_vrr *vrr,
+	s32 *multiple)
+{
+	struct tegra_dc_mode *m = &dc->mode;
+	s32 period_us, k;
+	int vfp;
+
+	if (vrr->frame_len_max <= 0 || !vrr->line_width)
+		return -EINVAL;
+
+	k = DIV_ROUND_UP(vrr->cadence_us, vrr->frame_len_max);
+	period_us = vrr->cadence_us / k;
+	if (period_us < vrr->frame_len_min)
+		return -ERANGE;
+
+	vfp = div_u64((u64)period_us * (m->pclk / 1000000), vrr->line_width) -
+		vrr->lines_per_frame_common;
+
+	*multiple = k;
+	return clamp(vfp, vrr->v_front_porch_min, vrr->v_front_porch_max);
+}
+
+/* Called on each flip of an HDMI or DP head, with dc->lock held */
+void tegra_dc_vrr_cadence_flip(struct tegra_dc *dc)
+{
+	struct tegra_vrr *vrr = dc->out->vrr;
+	s64 now_us;
+	s32 interval_us, multiple;
+	int vfp;
+
+	if (!vrr || !vrr->capability)
+		return;
+
+	if (!vrr->enable || !vrr->cadence_enable) {
+		vrr->cadence_locked = 0;
+		vrr->cadence_stable = 0;
+		vrr->cadence_last_flip_us = 0;
+		return;
+	}
+
+	now_us = ktime_to_us(ktime_get());
+	interval_us = min_t(s64, now_us - vrr->cadence_last_flip_us,
+			    VRR_CADENCE_MAX_US + 1);
+	vrr->cadence_last_flip_us = now_us;
+
+	/* first flip or a pause, there is no cadence to follow */
+	if (interval_us > VRR_CADENCE_MAX_US) {
+		vrr->cadence_locked = 0;
+		vrr->cadence_stable = 0;
+		vrr->cadence_us = 0;
+		return;
+	}
+
+	if (abs(interval_us - vrr->cadence_us) > VRR_CADENCE_TOLERANCE_US) {
+		if (vrr->cadence_locked)
+			dev_dbg(&dc->ndev->dev,
+				"vrr: cadence %dus lost, flip after %dus\n",
+				vrr->cadence_us, interval_us);
+		vrr->cadence_locked = 0;
+		vrr->cadence_stable = 0;
+		vrr->cadence_us = interval_us;
+		return;
+	}
+
+	/* follow the drift of the producer clock */
+	vrr->cadence_us += (interval_us - vrr->cadence_us) / 8;
+
+	if (!vrr->cadence_locked &&
+		++vrr->cadence_stable < VRR_CADENCE_LOCK_FLIPS)
+		return;
+
+	vfp = vrr_cadence_vfp(dc, vrr, &multiple);
+	if (vfp < 0) {
+		vrr->cadence_locked = 0;
+		return;
+	}
+
+	if (!vrr->cadence_locked)
+		dev_dbg(&dc->ndev->dev,
+			"vrr: locked to cadence %dus x%d, vfp %d\n",
+			vrr->cadence_us, multiple, vfp);
+
+	vrr->cadence_multiple = multiple;
+	vrr->cadence_vfp = vfp;
+	vrr->cadence_locked = 1;
+}
+
 /* Sysfs initializer */
 int vrr_create_sysfs(struct device *dev)
 {
@@ -17,7 +17,10 @@
 #ifndef __DRIVERS_VIDEO_TEGRA_DC_VRR_H
 #define __DRIVERS_VIDEO_TEGRA_DC_VRR_H
 
+struct tegra_dc;
+
 int  vrr_create_sysfs(struct device *dev);
 void vrr_remove_sysfs(struct device *dev);
+void tegra_dc_vrr_cadence_flip(struct tegra_dc *dc);
 
 #endif
@@ -30,6 +30,7 @@
 #include "dc_config.h"
 #include "dc_priv.h"
 #include "dc_common.h"
+#include "vrr.h"
 
 int no_vsync;
 
@@ -563,6 +564,8 @@ static void tegra_dc_vrr_cancel_vfp(struct tegra_dc *dc)
 	if (vrr->enable) {
 		if (dc->out->type == TEGRA_DC_OUT_DSI)
 			tegra_dc_set_act_vfp(dc, vrr->vfp_shrink);
+		else if (vrr->cadence_locked)
+			tegra_dc_set_act_vfp(dc, vrr->cadence_vfp);
 		else
 			tegra_dc_set_act_vfp(dc, dc->mode.v_front_porch);
 	} else {
@@ -1127,6 +1130,8 @@ int tegra_dc_update_windows(struct tegra_dc_win *windows[], int n,
 
 	if (dc->out->type == TEGRA_DC_OUT_DSI)
 		tegra_dc_vrr_flip_time(dc);
+	else
+		tegra_dc_vrr_cadence_flip(dc);
 
 	tegra_dc_vrr_cancel_vfp(dc);
 done:
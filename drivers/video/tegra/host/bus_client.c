@@ -247,6 +247,12 @@ struct nvhost_channel_userctx {
 	u32 syncpts[NVHOST_MODULE_MAX_SYNCPTS];
 	u32 client_managed_syncpt;
 
+	/* scheduling level used for channel allocation */
+	enum nvhost_channel_prio priority;
+
+	/* command buffers registered with RECORD_CMDBUF */
+	struct nvhost_reloc_records reloc_records;
+
 	/* error notificatiers used channel submit timeout */
 	struct dma_buf *error_notifier_ref;
 	u64 error_notifier_offset;
@@ -310,6 +316,8 @@ static int nvhost_channelrelease(struct inode *inode, struct file *filp)
 	if (pdata->keepalive)
 		nvhost_module_idle(priv->pdev);
 
+	nvhost_reloc_records_flush(&priv->reloc_records);
+
 	kfree(priv);
 	return 0;
 }
@@ -405,6 +413,8 @@ static int __nvhost_channelopen(struct inode *inode,
 
 	/* Initialize private structure */
 	priv->timeout = host1x_pdata->nvhost_timeout_default;
+	priv->priority = NVHOST_CHANNEL_PRIO_MEDIUM;
+	nvhost_reloc_records_init(&priv->reloc_records);
 	priv->timeout_debug_dump = true;
 	mutex_init(&priv->ioctl_lock);
 	priv->pdev = pdev;
@@ -755,8 +765,13 @@ static int submit_deliver_fences(struct nvhost_submit_args *args,
 	return 0;
 }
 
-static int nvhost_ioctl_channel_submit(struct nvhost_channel_userctx *ctx,
-		struct nvhost_submit_args *args)
+/*
+ * Build and pin a job from the user's submit arguments. extra_waitchks
+ * reserves room for wait checks added by the kernel after the job has
+ * been set up.
+ */
+static struct nvhost_job *submit_prepare_job(struct nvhost_channel_userctx *ctx,
+		struct nvhost_submit_args *args, u32 extra_waitchks, int *errp)
 {
 	struct nvhost_job *job;
 	struct nvhost_waitchk __user *waitchks =
@@ -770,16 +785,19 @@ static int nvhost_ioctl_channel_submit(struct nvhost_channel_userctx *ctx,
 		nvhost_err(&pdata->pdev->dev,
 			   "invalid num_syncpt_incrs=%u",
 			   args->num_syncpt_incrs);
-		return -EINVAL;
+		*errp = -EINVAL;
+		return NULL;
 	}
 
 	job = nvhost_job_alloc(ctx->ch,
 			args->num_cmdbufs,
 			args->num_relocs,
-			args->num_waitchks,
+			args->num_waitchks + extra_waitchks,
 			args->num_syncpt_incrs);
-	if (!job)
-		return -ENOMEM;
+	if (!job) {
+		*errp = -ENOMEM;
+		return NULL;
+	}
 
 	job->num_syncpts = args->num_syncpt_incrs;
 	job->clientid = ctx->clientid;
@@ -834,6 +852,29 @@ static int nvhost_ioctl_channel_submit(struct nvhost_channel_userctx *ctx,
 	else
 		job->timeout = ctx->timeout;
 	job->timeout_debug_dump = ctx->timeout_debug_dump;
+	job->priority = ctx->priority;
+	job->reloc_records = &ctx->reloc_records;
+
+	return job;
+
+put_job:
+	nvhost_job_put(job);
+	*errp = err;
+
+	return NULL;
+}
+
+static int nvhost_ioctl_channel_submit(struct nvhost_channel_userctx *ctx,
+		struct nvhost_submit_args *args)
+{
+	struct nvhost_job *job;
+	struct nvhost_device_data *pdata = platform_get_drvdata(ctx->pdev);
+
+	int err;
+
+	job = submit_prepare_job(ctx, args, 0, &err);
+	if (!job)
+		goto fail;
 
 	err = nvhost_channel_submit(job);
 	if (err)
@@ -855,12 +896,116 @@ unpin_job:
 	nvhost_job_unpin(job);
 put_job:
 	nvhost_job_put(job);
-
+fail:
 	nvhost_err(&pdata->pdev->dev, "failed with err %d", err);
 
 	return err;
 }
 
+/*
+ * Submit several jobs to the channel at once. All jobs are built and
+ * pinned before any of them is pushed, and pushing happens under a single
+ * hold of the channel's submit lock.
+ */
+static int nvhost_ioctl_channel_submit_batch(
+		struct nvhost_channel_userctx *ctx,
+		struct nvhost_submit_batch_args *args)
+{
+	struct nvhost_submit_args __user *user_submits =
+		(struct nvhost_submit_args __user *)(uintptr_t)args->submits;
+	s32 __user *user_depends = (s32 __user *)(uintptr_t)args->depends;
+	struct nvhost_device_data *pdata = platform_get_drvdata(ctx->pdev);
+	struct nvhost_submit_args *submits;
+	struct nvhost_job **jobs;
+	s32 *depends;
+	int num_prepared = 0, num_submitted = 0;
+	int err, i;
+	u32 n = args->num_submits;
+
+	if (!n || n > NVHOST_SUBMIT_BATCH_MAX || args->reserved) {
+		nvhost_err(&pdata->pdev->dev, "invalid num_submits=%u", n);
+		return -EINVAL;
+	}
+
+	submits = kcalloc(n, sizeof(*submits), GFP_KERNEL);
+	jobs = kcalloc(n, sizeof(*jobs), GFP_KERNEL);
+	depends = kcalloc(n, sizeof(*depends), GFP_KERNEL);
+	if (!submits || !jobs || !depends) {
+		err = -ENOMEM;
+		goto free;
+	}
+
+	if (copy_from_user(submits, user_submits, n * sizeof(*submits))) {
+		err = -EFAULT;
+		goto free;
+	}
+
+	if (user_depends) {
+		if (copy_from_user(depends, user_depends,
+				   n * sizeof(*depends))) {
+			err = -EFAULT;
+			goto free;
+		}
+	} else {
+		memset(depends, 0xff, n * sizeof(*depends));
+	}
+
+	for (i = 0; i < n; i++) {
+		if (depends[i] < -1 || depends[i] >= i) {
+			nvhost_err(&pdata->pdev->dev,
+				   "submit %d has invalid dependency %d",
+				   i, depends[i]);
+			err = -EINVAL;
+			goto free;
+		}
+	}
+
+	for (i = 0; i < n; i++) {
+		u32 extra = depends[i] >= 0 ?
+			submits[depends[i]].num_syncpt_incrs : 0;
+
+		jobs[i] = submit_prepare_job(ctx, &submits[i], extra, &err);
+		if (!jobs[i])
+			goto put_jobs;
+		num_prepared++;
+	}
+
+	err = nvhost_channel_submit_batch(jobs, depends, n, &num_submitted);
+
+	for (i = 0; i < num_submitted; i++) {
+		int fence_err;
+
+		nvhost_eventlib_log_submit(ctx->pdev, jobs[i]->sp[0].id,
+			pdata->push_work_done ? (jobs[i]->sp[0].fence - 1) :
+			jobs[i]->sp[0].fence, arch_counter_get_cntvct());
+
+		fence_err = submit_deliver_fences(&submits[i], jobs[i], ctx);
+		if (fence_err && !err)
+			err = fence_err;
+	}
+
+	if (num_submitted &&
+	    copy_to_user(user_submits, submits,
+			 num_submitted * sizeof(*submits)) && !err)
+		err = -EFAULT;
+
+put_jobs:
+	for (i = 0; i < num_prepared; i++) {
+		if (i >= num_submitted)
+			nvhost_job_unpin(jobs[i]);
+		nvhost_job_put(jobs[i]);
+	}
+free:
+	kfree(depends);
+	kfree(jobs);
+	kfree(submits);
+
+	if (err)
+		nvhost_err(&pdata->pdev->dev, "failed with err %d", err);
+
+	return err;
+}
+
 static int moduleid_to_index(struct platform_device *dev, u32 moduleid)
 {
 	int i;
@@ -1078,6 +1223,29 @@ static int nvhost_ioctl_channel_get_client_syncpt(
 	return 0;
 }
 
+static int nvhost_ioctl_channel_record_cmdbuf(
+				struct nvhost_channel_userctx *ctx,
+				struct nvhost_record_cmdbuf_args *args)
+{
+	struct dma_buf *dmabuf;
+	int err;
+
+	dmabuf = dma_buf_get(args->mem);
+	if (IS_ERR(dmabuf)) {
+		pr_err("%s: Invalid handle: %d\n", __func__, args->mem);
+		return -EINVAL;
+	}
+
+	if (args->flags & NVHOST_RECORD_CMDBUF_FLAG_REMOVE)
+		err = nvhost_reloc_records_remove(&ctx->reloc_records, dmabuf);
+	else
+		err = nvhost_reloc_records_add(&ctx->reloc_records, dmabuf);
+
+	dma_buf_put(dmabuf);
+
+	return err;
+}
+
 static int nvhost_ioctl_channel_set_syncpoint_name(
 				struct nvhost_channel_userctx *ctx,
 				struct nvhost_set_syncpt_name_args *buf)
@@ -1330,9 +1498,16 @@ static long nvhost_channelctl(struct file *filp,
 		((struct nvhost_get_param_args *)buf)->value = false;
 		break;
 	case NVHOST_IOCTL_CHANNEL_SET_PRIORITY:
-		nvhost_err(dev, "SET_PRIORITY not supported");
-		err = -EINVAL;
+	{
+		u32 priority =
+			((struct nvhost_set_priority_args *)buf)->priority;
+
+		priv->priority = nvhost_channel_prio_level(priority);
+		dev_dbg(&priv->pdev->dev,
+			"%s: setting priority %u (level %d) for userctx 0x%p\n",
+			__func__, priority, priv->priority, priv);
 		break;
+	}
 	case NVHOST32_IOCTL_CHANNEL_MODULE_REGRDWR:
 	{
 		struct nvhost32_ctrl_module_regrdwr_args *args32 =
@@ -1382,7 +1557,8 @@ static long nvhost_channelctl(struct file *filp,
 		args.fences = args32->fences;
 
 		/* first, get a channel */
-		err = nvhost_channel_map(pdata, &priv->ch, identifier);
+		err = nvhost_channel_map_prio(pdata, &priv->ch, identifier,
+					      priv->priority);
 		if (err)
 			break;
 
@@ -1409,7 +1585,8 @@ static long nvhost_channelctl(struct file *filp,
 			identifier = (void *)priv;
 
 		/* first, get a channel */
-		err = nvhost_channel_map(pdata, &priv->ch, identifier);
+		err = nvhost_channel_map_prio(pdata, &priv->ch, identifier,
+					      priv->priority);
 		if (err)
 			break;
 
@@ -1421,6 +1598,29 @@ static long nvhost_channelctl(struct file *filp,
 
 		break;
 	}
+	case NVHOST_IOCTL_CHANNEL_SUBMIT_BATCH:
+	{
+		struct nvhost_device_data *pdata =
+			platform_get_drvdata(priv->pdev);
+		void *identifier;
+
+		if (pdata->resource_policy == RESOURCE_PER_DEVICE &&
+		    !pdata->exclusive)
+			identifier = (void *)pdata;
+		else
+			identifier = (void *)priv;
+
+		err = nvhost_channel_map_prio(pdata, &priv->ch, identifier,
+					      priv->priority);
+		if (err)
+			break;
+
+		err = nvhost_ioctl_channel_submit_batch(priv, (void *)buf);
+
+		nvhost_putchannel(priv->ch, 1);
+
+		break;
+	}
 	case NVHOST_IOCTL_CHANNEL_SET_ERROR_NOTIFIER:
 		err = nvhost_init_error_notifier(priv,
 			(struct nvhost_set_error_notifier *)buf);
@@ -1445,6 +1645,10 @@ static long nvhost_channelctl(struct file *filp,
 			(struct nvhost_set_syncpt_name_args *)buf);
 		break;
 	}
+	case NVHOST_IOCTL_CHANNEL_RECORD_CMDBUF:
+		err = nvhost_ioctl_channel_record_cmdbuf(priv,
+			(struct nvhost_record_cmdbuf_args *)buf);
+		break;
 	default:
 		nvhost_dbg_info("unrecognized ioctl cmd: 0x%x", cmd);
 		err = -ENOTTY;
@@ -1626,6 +1830,11 @@ int nvhost_client_device_init(struct platform_device *dev)
 
 	nvhost_client_devfs_name_init(dev);
 
+	/* job latency histograms are optional, don't fail without them */
+	pdata->latency_hist = devm_kzalloc(&dev->dev,
+					   sizeof(*pdata->latency_hist),
+					   GFP_KERNEL);
+
 	/* Create debugfs directory for the device */
 	nvhost_device_debug_init(dev);
 
@@ -1970,3 +2179,43 @@ void nvhost_eventlib_log_fences(struct platform_device *pdev,
 EXPORT_SYMBOL(nvhost_eventlib_log_submit);
 EXPORT_SYMBOL(nvhost_eventlib_log_task);
 EXPORT_SYMBOL(nvhost_eventlib_log_fences);
+
+/*
+ * Publish one completed task record. The record is always appended to the
+ * per-device perf ring when one has been mapped through debugfs, and is
+ * additionally emitted as an eventlib event when eventlib is available.
+ */
+void nvhost_eventlib_log_task_perf(struct platform_device *pdev,
+				   struct nvhost_task_perf *perf,
+				   u64 timestamp)
+{
+	struct nvhost_device_data *pdata = platform_get_drvdata(pdev);
+	struct nvhost_task_perf_ring *ring = READ_ONCE(pdata->perf_ring);
+
+	perf->class_id = pdata->class;
+
+	if (ring) {
+		struct nvhost_task_perf_record *rec;
+		unsigned long flags;
+		u64 seq;
+
+		spin_lock_irqsave(&ring->lock, flags);
+		seq = ring->hdr->write_seq;
+		rec = &ring->records[seq % ring->num_entries];
+
+		WRITE_ONCE(rec->seq, 0);
+		smp_wmb();
+		rec->perf = *perf;
+		smp_wmb();
+		WRITE_ONCE(rec->seq, seq + 1);
+		WRITE_ONCE(ring->hdr->write_seq, seq + 1);
+		spin_unlock_irqrestore(&ring->lock, flags);
+	}
+
+#ifdef CONFIG_EVENTLIB
+	if (pdata->eventlib_id)
+		keventlib_write(pdata->eventlib_id, perf, sizeof(*perf),
+				NVHOST_TASK_PERF, timestamp);
+#endif
+}
+EXPORT_SYMBOL(nvhost_eventlib_log_task_perf);
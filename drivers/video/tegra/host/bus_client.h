@@ -22,9 +22,24 @@
 #define __NVHOST_BUS_CLIENT_H
 
 #include <linux/types.h>
+#include <linux/spinlock.h>
 
 struct firmware;
 struct platform_device;
+struct nvhost_task_perf_ring_header;
+struct nvhost_task_perf_record;
+
+/*
+ * Per-device ring of completed task records, shared with user space
+ * through the debugfs task_perf file.
+ */
+struct nvhost_task_perf_ring {
+	struct nvhost_task_perf_ring_header *hdr;
+	struct nvhost_task_perf_record *records;
+	u32 num_entries;
+	size_t size;
+	spinlock_t lock;
+};
 
 int nvhost_read_module_regs(struct platform_device *ndev,
 			u32 offset, int count, u32 *values);
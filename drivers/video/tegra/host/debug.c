@@ -20,7 +20,12 @@
 #include <linux/debugfs.h>
 #include <linux/seq_file.h>
 #include <linux/uaccess.h>
+#include <linux/math64.h>
+#include <linux/mm.h>
+#include <linux/slab.h>
+#include <linux/vmalloc.h>
 #include <linux/nvhost.h>
+#include <uapi/linux/nvhost_events.h>
 
 #include <linux/io.h>
 
@@ -29,6 +34,7 @@
 #include "nvhost_acm.h"
 #include "nvhost_channel.h"
 #include "chip_support.h"
+#include "bus_client.h"
 
 unsigned int nvhost_debug_trace_cmdbuf;
 unsigned int nvhost_debug_trace_actmon;
@@ -120,6 +126,11 @@ static int show_channels(struct platform_device *pdev, void *data,
 				m, ch, o, ch->chid);
 		nvhost_get_chip_ops()->debug.show_channel_cdma(
 			m, ch, o, ch->chid);
+		nvhost_debug_output(o,
+			"push buffer: %u bytes, high water %u slots, %u stalls\n",
+			ch->cdma.push_buffer.size,
+			ch->cdma.push_buffer.high_water,
+			ch->cdma.push_buffer.stalls);
 
 		if (ch->chid != locked_id)
 			up_write(&ch->cdma.lock);
@@ -218,6 +229,241 @@ static const struct file_operations nvhost_debug_fops = {
 	.release	= single_release,
 };
 
+static int nvhost_debug_show_prio_stats(struct seq_file *s, void *unused)
+{
+	static const char * const names[NVHOST_CHANNEL_PRIO_NUM] = {
+		[NVHOST_CHANNEL_PRIO_LOW] = "low",
+		[NVHOST_CHANNEL_PRIO_MEDIUM] = "medium",
+		[NVHOST_CHANNEL_PRIO_HIGH] = "high",
+	};
+	struct nvhost_master *master = s->private;
+	struct nvhost_channel_prio_stats stats[NVHOST_CHANNEL_PRIO_NUM];
+	int i;
+
+	spin_lock(&master->prio_lock);
+	memcpy(stats, master->prio_stats, sizeof(stats));
+	spin_unlock(&master->prio_lock);
+
+	seq_printf(s, "%-8s %10s %10s %12s %12s %10s %12s %12s\n",
+		   "level", "maps", "map_waits", "wait_avg_us", "wait_max_us",
+		   "jobs", "job_avg_us", "job_max_us");
+	for (i = 0; i < NVHOST_CHANNEL_PRIO_NUM; i++)
+		seq_printf(s, "%-8s %10llu %10llu %12llu %12llu %10llu %12llu %12llu\n",
+			   names[i], stats[i].maps, stats[i].map_waits,
+			   stats[i].map_waits ?
+				div64_u64(stats[i].map_wait_us,
+					  stats[i].map_waits) : 0,
+			   stats[i].map_wait_max_us, stats[i].jobs,
+			   stats[i].jobs ?
+				div64_u64(stats[i].job_us, stats[i].jobs) : 0,
+			   stats[i].job_max_us);
+
+	return 0;
+}
+
+static int nvhost_debug_open_prio_stats(struct inode *inode, struct file *file)
+{
+	return single_open(file, nvhost_debug_show_prio_stats,
+			   inode->i_private);
+}
+
+static const struct file_operations nvhost_debug_prio_stats_fops = {
+	.open		= nvhost_debug_open_prio_stats,
+	.read		= seq_read,
+	.llseek		= seq_lseek,
+	.release	= single_release,
+};
+
+static int nvhost_debug_show_latency(struct seq_file *s, void *unused)
+{
+	struct nvhost_latency_hist *hist = s->private;
+	int i;
+
+	seq_printf(s, "%-10s %12s %12s %12s\n",
+		   "latency", "queue", "exec", "notify");
+	for (i = 0; i < NVHOST_LATENCY_BUCKETS; i++) {
+		if (i == NVHOST_LATENCY_BUCKETS - 1)
+			seq_printf(s, ">=%6luus:", 1UL << (i - 1));
+		else
+			seq_printf(s, "< %6luus:", 1UL << i);
+		seq_printf(s, " %12lld %12lld %12lld\n",
+			(long long)atomic64_read(
+				&hist->count[NVHOST_LATENCY_QUEUE][i]),
+			(long long)atomic64_read(
+				&hist->count[NVHOST_LATENCY_EXEC][i]),
+			(long long)atomic64_read(
+				&hist->count[NVHOST_LATENCY_NOTIFY][i]));
+	}
+
+	return 0;
+}
+
+static int nvhost_debug_open_latency(struct inode *inode, struct file *file)
+{
+	return single_open(file, nvhost_debug_show_latency, inode->i_private);
+}
+
+/* any write clears the histograms */
+static ssize_t nvhost_debug_write_latency(struct file *file,
+		const char __user *buf, size_t count, loff_t *offp)
+{
+	struct seq_file *s = file->private_data;
+	struct nvhost_latency_hist *hist = s->private;
+	int i, j;
+
+	for (i = 0; i < NVHOST_LATENCY_NUM; i++)
+		for (j = 0; j < NVHOST_LATENCY_BUCKETS; j++)
+			atomic64_set(&hist->count[i][j], 0);
+
+	return count;
+}
+
+static const struct file_operations nvhost_debug_latency_fops = {
+	.open		= nvhost_debug_open_latency,
+	.read		= seq_read,
+	.write		= nvhost_debug_write_latency,
+	.llseek		= seq_lseek,
+	.release	= single_release,
+};
+
+#define NVHOST_TASK_PERF_RING_ENTRIES	1024
+
+static void nvhost_task_perf_ring_free(void *data)
+{
+	struct nvhost_task_perf_ring *ring = data;
+
+	vfree(ring->hdr);
+	kfree(ring);
+}
+
+/* the ring is only allocated once somebody opens the task_perf file */
+static struct nvhost_task_perf_ring *
+nvhost_task_perf_ring_get(struct platform_device *pdev)
+{
+	struct nvhost_device_data *pdata = platform_get_drvdata(pdev);
+	struct nvhost_task_perf_ring *ring;
+	size_t size;
+
+	ring = READ_ONCE(pdata->perf_ring);
+	if (ring)
+		return ring;
+
+	ring = kzalloc(sizeof(*ring), GFP_KERNEL);
+	if (!ring)
+		return NULL;
+
+	size = PAGE_ALIGN(sizeof(*ring->hdr) + NVHOST_TASK_PERF_RING_ENTRIES *
+			  sizeof(struct nvhost_task_perf_record));
+	ring->hdr = vmalloc_user(size);
+	if (!ring->hdr) {
+		kfree(ring);
+		return NULL;
+	}
+
+	ring->size = size;
+	ring->num_entries = NVHOST_TASK_PERF_RING_ENTRIES;
+	ring->records = (struct nvhost_task_perf_record *)(ring->hdr + 1);
+	spin_lock_init(&ring->lock);
+
+	ring->hdr->magic = NVHOST_TASK_PERF_RING_MAGIC;
+	ring->hdr->num_entries = ring->num_entries;
+	ring->hdr->entry_size = sizeof(struct nvhost_task_perf_record);
+
+	if (cmpxchg(&pdata->perf_ring, NULL, ring) != NULL) {
+		nvhost_task_perf_ring_free(ring);
+		return pdata->perf_ring;
+	}
+
+	if (devm_add_action(&pdev->dev, nvhost_task_perf_ring_free, ring))
+		nvhost_warn(&pdev->dev, "task perf ring will not be freed");
+
+	return ring;
+}
+
+static int nvhost_debug_open_task_perf(struct inode *inode, struct file *file)
+{
+	struct nvhost_task_perf_ring *ring;
+
+	ring = nvhost_task_perf_ring_get(inode->i_private);
+	if (!ring)
+		return -ENOMEM;
+
+	file->private_data = ring;
+
+	return nonseekable_open(inode, file);
+}
+
+static int nvhost_debug_mmap_task_perf(struct file *file,
+				       struct vm_area_struct *vma)
+{
+	struct nvhost_task_perf_ring *ring = file->private_data;
+
+	if (vma->vm_flags & VM_WRITE)
+		return -EPERM;
+
+	if (vma->vm_pgoff ||
+	    vma->vm_end - vma->vm_start > ring->size)
+		return -EINVAL;
+
+	vma->vm_flags &= ~VM_MAYWRITE;
+
+	return remap_vmalloc_range(vma, ring->hdr, 0);
+}
+
+static const struct file_operations nvhost_debug_task_perf_fops = {
+	.open		= nvhost_debug_open_task_perf,
+	.mmap		= nvhost_debug_mmap_task_perf,
+	.llseek		= no_llseek,
+};
+
+static int nvhost_debug_show_sessions(struct seq_file *s, void *unused)
+{
+	struct platform_device *pdev = s->private;
+	struct nvhost_device_data *pdata = platform_get_drvdata(pdev);
+	struct nvhost_master *host = nvhost_get_host(pdev);
+	int index;
+
+	seq_printf(s, "slice %d, busy sessions %d\n", pdata->session_slice,
+		   atomic_read(&pdata->busy_sessions));
+	seq_printf(s, "%-6s %8s %10s %10s %12s %10s\n", "chid", "pid",
+		   "inflight", "jobs", "job_avg_us", "jobs/s");
+
+	mutex_lock(&host->chlist_mutex);
+	for (index = 0; index < nvhost_channel_nb_channels(host); index++) {
+		struct nvhost_channel *ch = host->chlist[index];
+		u64 jobs, us;
+
+		if (!ch || ch->dev != pdev ||
+		    !test_bit(index, host->allocated_channels))
+			continue;
+
+		jobs = READ_ONCE(ch->session.jobs);
+		us = max_t(s64, ktime_us_delta(ktime_get(), ch->session.since),
+			   1);
+		seq_printf(s, "%-6d %8d %10d %10llu %12llu %10llu\n",
+			   ch->chid, ch->session.pid,
+			   atomic_read(&ch->inflight), jobs,
+			   jobs ? div64_u64(READ_ONCE(ch->session.job_us),
+					    jobs) : 0,
+			   div64_u64(jobs * USEC_PER_SEC, us));
+	}
+	mutex_unlock(&host->chlist_mutex);
+
+	return 0;
+}
+
+static int nvhost_debug_open_sessions(struct inode *inode, struct file *file)
+{
+	return single_open(file, nvhost_debug_show_sessions, inode->i_private);
+}
+
+static const struct file_operations nvhost_debug_sessions_fops = {
+	.open		= nvhost_debug_open_sessions,
+	.read		= seq_read,
+	.llseek		= seq_lseek,
+	.release	= single_release,
+};
+
 void nvhost_device_debug_init(struct platform_device *dev)
 {
 	struct nvhost_device_data *pdata = platform_get_drvdata(dev);
@@ -226,6 +472,19 @@ void nvhost_device_debug_init(struct platform_device *dev)
 	debugfs_name = pdata->devfs_name ? pdata->devfs_name : dev->name;
 
 	pdata->debugfs = debugfs_create_dir(debugfs_name, pdata->debugfs);
+
+	if (!IS_ERR_OR_NULL(pdata->debugfs) && pdata->latency_hist)
+		debugfs_create_file("latency_histogram", S_IRUGO | S_IWUSR,
+				    pdata->debugfs, pdata->latency_hist,
+				    &nvhost_debug_latency_fops);
+
+	if (!IS_ERR_OR_NULL(pdata->debugfs))
+		debugfs_create_file("task_perf", S_IRUSR, pdata->debugfs,
+				    dev, &nvhost_debug_task_perf_fops);
+
+	if (!IS_ERR_OR_NULL(pdata->debugfs))
+		debugfs_create_file("sessions", S_IRUGO, pdata->debugfs,
+				    dev, &nvhost_debug_sessions_fops);
 }
 
 void nvhost_device_debug_deinit(struct platform_device *dev)
@@ -253,6 +512,8 @@ void nvhost_debug_init(struct nvhost_master *master)
 			master, &nvhost_debug_fops);
 	debugfs_create_file("status_all", S_IRUGO, de,
 			master, &nvhost_debug_all_fops);
+	debugfs_create_file("priority_stats", S_IRUGO, de,
+			master, &nvhost_debug_prio_stats_fops);
 
 	debugfs_create_u32("trace_cmdbuf", S_IRUGO|S_IWUSR, de,
 			&nvhost_debug_trace_cmdbuf);
@@ -274,6 +535,16 @@ void nvhost_debug_init(struct nvhost_master *master)
 			&pdata->nvhost_timeout_default);
 	debugfs_create_u32("trace_actmon", S_IRUGO|S_IWUSR, de,
 			&nvhost_debug_trace_actmon);
+	debugfs_create_u32("pin_cache_max_kb", S_IRUGO|S_IWUSR, de,
+			&nvhost_pin_cache_max_kb);
+	debugfs_create_u32("syncpt_spin_max_us", S_IRUGO|S_IWUSR, de,
+			&nvhost_syncpt_spin_max_us);
+	debugfs_create_u32("syncpt_idle_hint_max_us", S_IRUGO|S_IWUSR, de,
+			&nvhost_syncpt_idle_hint_max_us);
+	debugfs_create_u32("pb_max_kb", S_IRUGO|S_IWUSR, de,
+			&nvhost_push_buffer_max_kb);
+	debugfs_create_u32("high_prio_reserve", S_IRUGO|S_IWUSR, de,
+			&nvhost_channel_high_prio_reserve);
 }
 
 void nvhost_register_dump_device(
@@ -59,6 +59,11 @@ static int nvhost_flcn_deinit_sw(struct platform_device *dev);
 
 #define FLCN_IDLE_TIMEOUT_DEFAULT	100000	/* 100 milliseconds */
 #define FLCN_IDLE_CHECK_PERIOD		10	/* 10 usec */
+/*
+ * A 256B block lands in the falcon well under a microsecond, sleeping
+ * between polls made the image load take milliseconds on each power-on
+ */
+#define FLCN_DMA_CHECK_PERIOD		0	/* busy poll */
 
 static irqreturn_t flcn_isr(int irq, void *dev_id)
 {
@@ -134,7 +139,7 @@ static int nvhost_flcn_dma_wait_idle(struct platform_device *pdev)
 	ret = readl_poll_timeout(addr, val,
 				(flcn_dmatrfcmd_idle_v(val) ==
 				 flcn_dmatrfcmd_idle_true_v()),
-				FLCN_IDLE_CHECK_PERIOD,
+				FLCN_DMA_CHECK_PERIOD,
 				FLCN_IDLE_TIMEOUT_DEFAULT);
 	if (ret)
 		nvhost_err(&pdev->dev, "flcn_idle_state_r =%x\n", val);
@@ -541,16 +546,20 @@ static int nvhost_flcn_init_sw(struct platform_device *dev)
 
 	nvhost_dbg_fn("in dev:%p v:%p", dev, v);
 
-	if (v)
+	/* the parsed ucode stays mapped across power-gating */
+	if (v && v->valid)
 		return 0;
 
-	v = kzalloc(sizeof(*v), GFP_KERNEL);
+	/* retry reading the ucode if it failed on a previous power-on */
 	if (!v) {
-		err = -ENOMEM;
-		goto clean_up;
-	}
+		v = kzalloc(sizeof(*v), GFP_KERNEL);
+		if (!v) {
+			err = -ENOMEM;
+			goto clean_up;
+		}
 
-	set_flcn(dev, v);
+		set_flcn(dev, v);
+	}
 	nvhost_dbg_fn("primed dev:%p v:%p", dev, v);
 	err = flcn_read_ucode(dev, pdata->firmware_name, v);
 	if (err || !v->valid)
@@ -34,6 +34,7 @@
 #include <soc/tegra/chip-id.h>
 #include <linux/tegra_pm_domains.h>
 #include <linux/vmalloc.h>
+#include <linux/mm.h>
 #include <linux/version.h>
 #include <linux/poll.h>
 #include <linux/anon_inodes.h>
@@ -69,6 +70,7 @@
 #endif
 #ifdef CONFIG_TEGRA_T19X_GRHOST
 #include "t194/t194.h"
+#include <linux/nvhost_t194.h>
 #endif
 
 #define DRIVER_NAME		"host1x"
@@ -221,9 +223,9 @@ static int nvhost_ioctl_ctrl_syncpt_waitmex(struct nvhost_ctrl_userctx *ctx,
 	else
 		timeout = (u32)msecs_to_jiffies(args->timeout);
 
-	err = nvhost_syncpt_wait_timeout(&ctx->dev->syncpt, args->id,
-					args->thresh, timeout, &args->value,
-					&nvts, true);
+	err = nvhost_syncpt_wait_timeout_mode(&ctx->dev->syncpt, args->id,
+			args->thresh, timeout, &args->value, &nvts, true,
+			args->flags & NVHOST_SYNCPT_WAIT_FLAG_LOW_LATENCY);
 	args->tv_sec = nvts.ts.tv_sec;
 	args->tv_nsec = nvts.ts.tv_nsec;
 	args->clock_id = nvts.clock;
@@ -663,10 +665,74 @@ static long nvhost_ctrlctl(struct file *filp,
 	return err;
 }
 
+/* host1x must stay powered while user space can read the shim */
+static void nvhost_ctrl_vm_open(struct vm_area_struct *vma)
+{
+	struct nvhost_master *host = vma->vm_private_data;
+
+	nvhost_module_busy_noresume(host->dev);
+}
+
+static void nvhost_ctrl_vm_close(struct vm_area_struct *vma)
+{
+	struct nvhost_master *host = vma->vm_private_data;
+
+	nvhost_module_idle(host->dev);
+}
+
+static const struct vm_operations_struct nvhost_ctrl_vm_ops = {
+	.open = nvhost_ctrl_vm_open,
+	.close = nvhost_ctrl_vm_close,
+};
+
+/*
+ * Read only mapping of the syncpoint shim, for checking fences and short
+ * spin waits without NVHOST_IOCTL_CTRL_SYNCPT_READ. Any syncpoint can be
+ * read with that ioctl already, so the whole shim may be mapped.
+ */
+static int nvhost_ctrlmmap(struct file *filp, struct vm_area_struct *vma)
+{
+	struct nvhost_ctrl_userctx *priv = filp->private_data;
+	struct nvhost_master *host = priv->dev;
+	struct resource *res = host->syncpt_shim;
+	unsigned long size = vma->vm_end - vma->vm_start;
+	unsigned long offset = vma->vm_pgoff << PAGE_SHIFT;
+	int err;
+
+	if (!res)
+		return -ENODEV;
+
+	if (vma->vm_flags & (VM_WRITE | VM_EXEC))
+		return -EPERM;
+
+	if (offset >= resource_size(res) ||
+	    size > resource_size(res) - offset)
+		return -EINVAL;
+
+	err = nvhost_module_busy(host->dev);
+	if (err)
+		return err;
+
+	vma->vm_flags &= ~(VM_MAYWRITE | VM_MAYEXEC);
+	vma->vm_flags |= VM_IO | VM_DONTCOPY | VM_DONTEXPAND | VM_DONTDUMP;
+	vma->vm_page_prot = pgprot_noncached(vma->vm_page_prot);
+	vma->vm_private_data = host;
+	vma->vm_ops = &nvhost_ctrl_vm_ops;
+
+	err = io_remap_pfn_range(vma, vma->vm_start,
+				 (res->start + offset) >> PAGE_SHIFT,
+				 size, vma->vm_page_prot);
+	if (err)
+		nvhost_module_idle(host->dev);
+
+	return err;
+}
+
 static const struct file_operations nvhost_ctrlops = {
 	.owner = THIS_MODULE,
 	.release = nvhost_ctrlrelease,
 	.open = nvhost_ctrlopen,
+	.mmap = nvhost_ctrlmmap,
 	.unlocked_ioctl = nvhost_ctrlctl,
 #ifdef CONFIG_COMPAT
 	.compat_ioctl = nvhost_ctrlctl,
@@ -1038,6 +1104,27 @@ int nvhost_update_characteristics(struct platform_device *dev)
 	host->nvhost_char.syncpts_limit = host->info.pts_limit;
 	host->nvhost_char.num_hw_pts = host->info.nb_hw_pts;
 
+#ifdef CONFIG_TEGRA_T19X_GRHOST
+	if (!host->syncpt_shim) {
+		struct resource *res;
+
+		res = platform_get_resource_byname(host->dev, IORESOURCE_MEM,
+						   "sem-syncpt-shim");
+		if (res && PAGE_ALIGNED(res->start) &&
+		    PAGE_ALIGNED(resource_size(res)))
+			host->syncpt_shim = res;
+	}
+
+	if (host->syncpt_shim) {
+		host->nvhost_char.flags |=
+			NVHOST_CHARACTERISTICS_SYNCPT_SHIM_MMAP;
+		host->nvhost_char.syncpt_shim_size =
+			resource_size(host->syncpt_shim);
+		host->nvhost_char.syncpt_shim_stride =
+			nvhost_syncpt_unit_interface_get_byte_offset(1);
+	}
+#endif
+
 	return 0;
 }
 
@@ -117,6 +117,7 @@ struct nvhost_master {
 	atomic_t clientid;
 	struct host1x_device_info info;
 	struct nvhost_characteristics nvhost_char;
+	struct resource *syncpt_shim;	/* user mappable, read only */
 	struct kobject *caps_kobj;
 	struct nvhost_capability_node *caps_nodes;
 	int major;
@@ -127,8 +128,12 @@ struct nvhost_master {
 	struct nvhost_channel **chlist;	/* channel list */
 	struct mutex chlist_mutex;	/* mutex for channel list */
 	struct mutex ch_alloc_mutex;	/* mutex for channel allocation */
-	struct semaphore free_channels; /* Semaphore tracking free channels */
+	int free_channels;		/* channels not allocated */
+	wait_queue_head_t free_channels_wq; /* signalled when one is freed */
+	unsigned int ch_waiters[NVHOST_CHANNEL_PRIO_NUM];
 	unsigned long allocated_channels[2];
+	spinlock_t prio_lock;		/* protects prio_stats */
+	struct nvhost_channel_prio_stats prio_stats[NVHOST_CHANNEL_PRIO_NUM];
 
 	/* nvhost vm specific structures */
 	struct nvhost_vm_firmware_area firmware_area;
@@ -53,7 +53,7 @@ static void cdma_timeout_handler(struct work_struct *work);
  */
 static void push_buffer_reset(struct push_buffer *pb)
 {
-	pb->fence = PUSH_BUFFER_SIZE - 8;
+	pb->fence = pb->size - 8;
 	pb->cur = 0;
 }
 
@@ -72,7 +72,7 @@ static int push_buffer_init(struct push_buffer *pb)
 		goto fail;
 
 	/* put the restart at the end of pushbuffer memory */
-	*(pb->mapped + (PUSH_BUFFER_SIZE >> 2)) =
+	*(pb->mapped + (pb->size >> 2)) =
 		nvhost_opcode_restart(0);
 
 	return 0;
@@ -85,15 +85,16 @@ fail:
 /**
  * Guarantees that the next N slots (2 words each ) pushed to the buffer will be
  * adjacent and not split across pushbuffer wraparound boundaries. Pushes no-ops
- * to pushbuffer until the boundary has been avoided. The number of words must
- * be less than (PUSH_BUFFER_SIZE - 1)/2.
+ * to pushbuffer until the boundary has been avoided. The number of slots must
+ * be less than half the capacity of the pushbuffer.
  */
 static void cdma_make_adjacent_space(struct nvhost_cdma *cdma, u32 slots)
 {
 	int i;
-	u32 slots_before_wrap = (PUSH_BUFFER_SIZE - 1 - cdma->push_buffer.cur)/8;
+	struct push_buffer *pb = &cdma->push_buffer;
+	u32 slots_before_wrap = (pb->size - 1 - pb->cur)/8;
 
-	if (WARN_ON(slots >= (NVHOST_GATHER_QUEUE_SIZE)/2))
+	if (WARN_ON(slots >= pb->size / 16))
 		return;
 
 	if (slots_before_wrap >= slots)
@@ -151,7 +152,7 @@ static void cdma_timeout_pb_cleanup(struct nvhost_cdma *cdma, u32 getptr,
 		*(p++) = NVHOST_OPCODE_NOOP;
 		dev_dbg(&dev->dev->dev, "%s: NOP at 0x%llx\n",
 			__func__, (u64)(pb->dma_addr + getidx));
-		getidx = (getidx + 8) & (PUSH_BUFFER_SIZE - 1);
+		getidx = (getidx + 8) & (pb->size - 1);
 	}
 	wmb();
 }
@@ -282,17 +282,12 @@ static void submit_work(struct nvhost_job *job)
 		lock_device(job, false);
 }
 
-static int host1x_channel_submit(struct nvhost_job *job)
+/* Turn on the client module and host1x, once per syncpoint of the job */
+static int submit_get_refs(struct nvhost_job *job)
 {
 	struct nvhost_channel *ch = job->ch;
-	struct nvhost_syncpt *sp = &nvhost_get_host(job->ch->dev)->syncpt;
-	u32 prev_max = 0;
 	int err, i;
-	void *completed_waiters[job->num_syncpts];
 
-	memset(completed_waiters, 0, sizeof(void *) * job->num_syncpts);
-
-	/* Turn on the client module and host1x */
 	for (i = 0; i < job->num_syncpts; ++i) {
 		err = nvhost_module_busy(ch->dev);
 		if (err) {
@@ -304,23 +299,37 @@ static int host1x_channel_submit(struct nvhost_job *job)
 		nvhost_getchannel(ch);
 	}
 
+	return 0;
+}
+
+static void submit_put_refs(struct nvhost_job *job)
+{
+	nvhost_module_idle_mult(job->ch->dev, job->num_syncpts);
+	nvhost_putchannel(job->ch, job->num_syncpts);
+}
+
+/*
+ * Push one job to hardware. The caller holds ch->submitlock and has
+ * already taken the power and channel references of submit_get_refs(),
+ * which are dropped again on failure.
+ */
+static int host1x_channel_submit_locked(struct nvhost_job *job)
+{
+	struct nvhost_channel *ch = job->ch;
+	struct nvhost_syncpt *sp = &nvhost_get_host(job->ch->dev)->syncpt;
+	u32 prev_max = 0;
+	int err, i;
+	void *completed_waiters[job->num_syncpts];
+
+	memset(completed_waiters, 0, sizeof(void *) * job->num_syncpts);
+
 	/* before error checks, return current max */
 	prev_max = job->sp->fence = nvhost_syncpt_read_max(sp, job->sp->id);
 
-	/* get submit lock */
-	err = mutex_lock_interruptible(&ch->submitlock);
-	if (err) {
-		nvhost_module_idle_mult(ch->dev, job->num_syncpts);
-		nvhost_putchannel(ch, job->num_syncpts);
-		goto error;
-	}
-
 	for (i = 0; i < job->num_syncpts; ++i) {
 		completed_waiters[i] = nvhost_intr_alloc_waiter();
 		if (!completed_waiters[i]) {
-			nvhost_module_idle_mult(ch->dev, job->num_syncpts);
-			nvhost_putchannel(ch, job->num_syncpts);
-			mutex_unlock(&ch->submitlock);
+			submit_put_refs(job);
 			err = -ENOMEM;
 			goto error;
 		}
@@ -334,9 +343,7 @@ static int host1x_channel_submit(struct nvhost_job *job)
 	/* begin a CDMA submit */
 	err = nvhost_cdma_begin(&ch->cdma, job);
 	if (err) {
-		nvhost_module_idle_mult(ch->dev, job->num_syncpts);
-		nvhost_putchannel(ch, job->num_syncpts);
-		mutex_unlock(&ch->submitlock);
+		submit_put_refs(job);
 		goto error;
 	}
 
@@ -387,8 +394,6 @@ static int host1x_channel_submit(struct nvhost_job *job)
 		WARN(err, "Failed to set submit complete interrupt");
 	}
 
-	mutex_unlock(&ch->submitlock);
-
 	return 0;
 
 error:
@@ -397,6 +402,77 @@ error:
 	return err;
 }
 
+static int host1x_channel_submit(struct nvhost_job *job)
+{
+	struct nvhost_channel *ch = job->ch;
+	int err;
+
+	err = submit_get_refs(job);
+	if (err)
+		return err;
+
+	/* get submit lock */
+	err = mutex_lock_interruptible(&ch->submitlock);
+	if (err) {
+		submit_put_refs(job);
+		return err;
+	}
+
+	err = host1x_channel_submit_locked(job);
+	mutex_unlock(&ch->submitlock);
+
+	return err;
+}
+
+/*
+ * Push a batch of jobs under a single hold of the submit lock. Dependencies
+ * are resolved as we go, since a job's fences are only known once it has
+ * been pushed.
+ */
+static int host1x_channel_submit_batch(struct nvhost_job **jobs,
+				       const s32 *depends, int num_jobs,
+				       int *num_submitted)
+{
+	struct nvhost_channel *ch = jobs[0]->ch;
+	int err, i, j;
+
+	*num_submitted = 0;
+
+	for (i = 0; i < num_jobs; i++) {
+		err = submit_get_refs(jobs[i]);
+		if (err) {
+			while (i--)
+				submit_put_refs(jobs[i]);
+			return err;
+		}
+	}
+
+	err = mutex_lock_interruptible(&ch->submitlock);
+	if (err) {
+		for (i = 0; i < num_jobs; i++)
+			submit_put_refs(jobs[i]);
+		return err;
+	}
+
+	for (i = 0; i < num_jobs; i++) {
+		if (depends[i] >= 0)
+			nvhost_job_add_dependency(jobs[i], jobs[depends[i]]);
+
+		err = host1x_channel_submit_locked(jobs[i]);
+		if (err)
+			break;
+	}
+	mutex_unlock(&ch->submitlock);
+
+	*num_submitted = i;
+
+	/* the failed job already dropped its own references */
+	for (j = i + 1; j < num_jobs; j++)
+		submit_put_refs(jobs[j]);
+
+	return err;
+}
+
 #ifdef _hw_host1x04_channel_h_
 static int t124_channel_init_gather_filter(struct platform_device *pdev,
 	struct nvhost_channel *ch)
@@ -425,6 +501,7 @@ static int host1x_channel_init(struct nvhost_channel *ch,
 static const struct nvhost_channel_ops host1x_channel_ops = {
 	.init = host1x_channel_init,
 	.submit = host1x_channel_submit,
+	.submit_batch = host1x_channel_submit_batch,
 #ifdef _hw_host1x04_channel_h_
 	.init_gather_filter = t124_channel_init_gather_filter,
 #endif
@@ -26,6 +26,8 @@
 #include <linux/list.h>
 #include <linux/of.h>
 #include <linux/version.h>
+#include <linux/vmalloc.h>
+#include <linux/workqueue.h>
 #include <linux/dma-buf.h>
 #include <linux/nvhost.h>
 
@@ -58,10 +60,70 @@ static LIST_HEAD(iommu_ctx_list);
 static LIST_HEAD(iommu_static_mappings_list);
 static DEFINE_MUTEX(iommu_ctx_list_mutex);
 
+/*
+ * Free contexts keep the stashings of their last user, so that the same
+ * process gets them back. A new process needing a context with none pays
+ * for dropping them, so a few free contexts are kept clean in advance.
+ */
+static unsigned int iommu_ctx_clean_min = 2;
+module_param(iommu_ctx_clean_min, uint, 0644);
+MODULE_PARM_DESC(iommu_ctx_clean_min,
+		 "Free context devices to keep without stashed mappings");
+
+static void iommu_context_dev_scrub_worker(struct work_struct *work);
+static DECLARE_WORK(iommu_ctx_scrub_work, iommu_context_dev_scrub_worker);
+
+/* call with iommu_ctx_list_mutex held */
+static bool iommu_context_dev_need_scrub(void)
+{
+	struct iommu_ctx *ctx;
+	unsigned int clean = 0, dirty = 0;
+
+	list_for_each_entry(ctx, &iommu_ctx_list, list) {
+		if (ctx->allocated)
+			continue;
+		if (ctx->prev_identifier)
+			dirty++;
+		else
+			clean++;
+	}
+
+	return dirty && clean < iommu_ctx_clean_min;
+}
+
+static void iommu_context_dev_scrub_worker(struct work_struct *work)
+{
+	struct iommu_ctx *ctx, *victim;
+
+	mutex_lock(&iommu_ctx_list_mutex);
+	while (iommu_context_dev_need_scrub()) {
+		/* the list is in release order, drop the oldest stashings */
+		victim = NULL;
+		list_for_each_entry(ctx, &iommu_ctx_list, list) {
+			if (!ctx->allocated && ctx->prev_identifier) {
+				victim = ctx;
+				break;
+			}
+		}
+
+		/* keep it away from allocations while its stash is dropped */
+		victim->allocated = true;
+		mutex_unlock(&iommu_ctx_list_mutex);
+
+		dma_buf_release_stash(&victim->pdev->dev);
+
+		mutex_lock(&iommu_ctx_list_mutex);
+		victim->prev_identifier = NULL;
+		victim->allocated = false;
+	}
+	mutex_unlock(&iommu_ctx_list_mutex);
+}
+
 struct platform_device *iommu_context_dev_allocate(void *identifier)
 {
 	struct iommu_ctx *ctx, *ctx_new = NULL;
 	bool dirty = false;
+	bool scrub;
 
 	mutex_lock(&iommu_ctx_list_mutex);
 	/*
@@ -96,17 +158,23 @@ struct platform_device *iommu_context_dev_allocate(void *identifier)
 	}
 
 	if (ctx_new) {
+		ctx_new->prev_identifier = identifier;
+		ctx_new->allocated = true;
+		scrub = iommu_context_dev_need_scrub();
+		mutex_unlock(&iommu_ctx_list_mutex);
+
 		if (dirty) {
 			/*
 			 * Ensure that all stashed mappings are removed from this context device
-			 * before this context device gets reassigned to some other process
+			 * before this context device gets reassigned to some other process.
+			 * It is ours now, the other allocations need not wait for it.
 			 */
 			dma_buf_release_stash(&ctx_new->pdev->dev);
 		}
 
-		ctx_new->prev_identifier = identifier;
-		ctx_new->allocated = true;
-		mutex_unlock(&iommu_ctx_list_mutex);
+		if (scrub)
+			schedule_work(&iommu_ctx_scrub_work);
+
 		return ctx_new->pdev;
 	}
 
@@ -118,10 +186,26 @@ struct platform_device *iommu_context_dev_allocate(void *identifier)
 void iommu_context_dev_release(struct platform_device *pdev)
 {
 	struct iommu_ctx *ctx = platform_get_drvdata(pdev);
+	bool scrub;
 
 	mutex_lock(&iommu_ctx_list_mutex);
 	ctx->allocated = false;
+	/* most recently released last, the scrubber picks from the head */
+	list_move_tail(&ctx->list, &iommu_ctx_list);
+	scrub = iommu_context_dev_need_scrub();
 	mutex_unlock(&iommu_ctx_list_mutex);
+
+	if (scrub)
+		schedule_work(&iommu_ctx_scrub_work);
+}
+
+static struct page *iommu_static_mapping_page(void *va)
+{
+	/* hack: the memory may be allocated from vmalloc
+	 * pool. this happens if dma_alloc_attrs() is called
+	 * with a device that is attached to smmu domain. */
+
+	return virt_addr_valid(va) ? virt_to_page(va) : vmalloc_to_page(va);
 }
 
 static int __iommu_context_dev_map_static(struct platform_device *pdev,
@@ -135,7 +219,7 @@ static int __iommu_context_dev_map_static(struct platform_device *pdev,
 #if LINUX_VERSION_CODE < KERNEL_VERSION(4, 4, 0)
 	dma_addr_t base_iova = mapping->paddr;
 #endif
-	int i, err;
+	int i, n, err;
 
 #if LINUX_VERSION_CODE < KERNEL_VERSION(4, 9, 0)
 	dma_set_attr(DMA_ATTR_SKIP_IOVA_GAP, &attrs);
@@ -152,18 +236,23 @@ static int __iommu_context_dev_map_static(struct platform_device *pdev,
 	}
 #endif
 
-	/* map each page of the buffer to this ctx dev */
-	for (i = 0; i < num_pages; i++) {
+	/*
+	 * map the buffer to this ctx dev, physically contiguous pages in one
+	 * go so that the page tables are filled in large blocks
+	 */
+	for (i = 0; i < num_pages; i += n) {
 		dma_addr_t iova = mapping->paddr + PAGE_SIZE * i;
 		void *va = mapping->vaddr + PAGE_SIZE * i;
-		struct page *page;
-
-		/* hack: the memory may be allocated from vmalloc
-		 * pool. this happens if dma_alloc_attrs() is called
-		 * with a device that is attached to smmu domain. */
-
-		page = virt_addr_valid(va) ? virt_to_page(va) :
-			vmalloc_to_page(va);
+		struct page *page = iommu_static_mapping_page(va);
+
+		n = 1;
+#if LINUX_VERSION_CODE >= KERNEL_VERSION(4, 4, 0)
+		while (i + n < num_pages &&
+		       page_to_phys(iommu_static_mapping_page(va +
+				PAGE_SIZE * n)) ==
+		       page_to_phys(page) + PAGE_SIZE * n)
+			n++;
+#endif
 
 #if LINUX_VERSION_CODE < KERNEL_VERSION(4, 4, 0)
 		iova = ops->map_page_at(&pdev->dev, page, iova,
@@ -171,10 +260,10 @@ static int __iommu_context_dev_map_static(struct platform_device *pdev,
 			     DMA_BIDIRECTIONAL, NULL);
 #elif LINUX_VERSION_CODE < KERNEL_VERSION(4, 9, 0)
 		iova = ops->map_at(&pdev->dev, iova, page_to_phys(page),
-					PAGE_SIZE, DMA_BIDIRECTIONAL, &attrs);
+					PAGE_SIZE * n, DMA_BIDIRECTIONAL, &attrs);
 #else
 		iova = ops->map_at(&pdev->dev, iova, page_to_phys(page),
-					PAGE_SIZE, DMA_BIDIRECTIONAL,
+					PAGE_SIZE * n, DMA_BIDIRECTIONAL,
 					DMA_ATTR_SKIP_IOVA_GAP);
 #endif
 		err = dma_mapping_error(&pdev->dev, iova);
@@ -269,6 +358,8 @@ static int __exit iommu_context_dev_remove(struct platform_device *pdev)
 {
 	struct iommu_ctx *ctx = platform_get_drvdata(pdev);
 
+	cancel_work_sync(&iommu_ctx_scrub_work);
+
 	mutex_lock(&iommu_ctx_list_mutex);
 	list_del(&ctx->list);
 	mutex_unlock(&iommu_ctx_list_mutex);
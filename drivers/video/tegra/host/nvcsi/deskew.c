@@ -34,6 +34,7 @@
 #include <linux/uaccess.h>
 #include <linux/regulator/consumer.h>
 #include <linux/slab.h>
+#include <linux/thermal.h>
 
 #include <media/mc_common.h>
 
@@ -55,7 +56,8 @@ static int debugfs_deskew_data_stats_high[NVCSI_PHY_CIL_NUM_LANE];
 static unsigned int enabled_deskew_lanes;
 static unsigned int done_deskew_lanes;
 
-static int nvcsi_deskew_apply_helper(unsigned int active_lanes);
+static int nvcsi_deskew_apply_helper(struct nvcsi_deskew_context *ctx);
+static int nvcsi_deskew_apply_cached(struct nvcsi_deskew_context *ctx);
 
 static bool is_t19x_or_greater;
 // a regmap for address changes between chips
@@ -424,7 +426,7 @@ static int nvcsi_deskew_thread(void *data)
 		phy_num++;
 	}
 
-	ret = nvcsi_deskew_apply_helper(ctx->deskew_lanes);
+	ret = nvcsi_deskew_apply_helper(ctx);
 	if (!ret) {
 		dev_info(mc_csi->dev, "deskew finished for lanes 0x%04x",
 							ctx->deskew_lanes);
@@ -471,6 +473,13 @@ int nvcsi_deskew_setup(struct nvcsi_deskew_context *ctx)
 	done_deskew_lanes &= ~(ctx->deskew_lanes);
 	mutex_unlock(&deskew_lock);
 
+	ctx->cached = false;
+	if (ctx->data_rate && !nvcsi_deskew_apply_cached(ctx)) {
+		init_completion(&ctx->thread_done);
+		complete(&ctx->thread_done);
+		return 0;
+	}
+
 	new_lanes = ctx->deskew_lanes & ~enabled_deskew_lanes;
 	if (new_lanes) {
 		set_enabled_with_lock(new_lanes);
@@ -704,6 +713,193 @@ static void set_trimmer(unsigned int phy_num, unsigned int cila,
 	}
 }
 
+/*
+ * Trimmers found by a full deskew search are cached per PHY, lane set,
+ * data rate and temperature band. Restarting a stream under the same
+ * conditions then only programs them and checks that the link stays
+ * clean for a frame, instead of sweeping again.
+ */
+#define NVCSI_PHY_NUM			(NVCSI_PHY_CIL_NUM_LANE / 4)
+#define DESKEW_CACHE_ENTRIES		4
+#define DESKEW_CACHE_TEMP_BAND		20000	/* millicelsius */
+#define DESKEW_THERMAL_ZONE		"CPU-therm"
+/* lane error bits of the CIL interrupt status, below the deskew bits */
+#define CIL_INTR_LANE_ERR_MASK	(intr_dphy_cil_deskew_calib_done_lane0 - 1)
+
+struct nvcsi_deskew_cache_entry {
+	bool valid;
+	unsigned int cil_lanes;
+	u64 data_rate;
+	int temp_band;
+	unsigned int d_trimmer[4];
+	unsigned int clk_trimmer;
+};
+
+static struct nvcsi_deskew_cache_entry
+	deskew_cache[NVCSI_PHY_NUM][DESKEW_CACHE_ENTRIES];
+static unsigned int deskew_cache_next[NVCSI_PHY_NUM];
+
+static int nvcsi_deskew_temp_band(void)
+{
+	struct thermal_zone_device *tz;
+	int temp;
+
+	tz = thermal_zone_get_zone_by_name(DESKEW_THERMAL_ZONE);
+	if (IS_ERR(tz) || thermal_zone_get_temp(tz, &temp))
+		return 0;
+
+	if (temp < 0)
+		return (temp - DESKEW_CACHE_TEMP_BAND + 1) /
+			DESKEW_CACHE_TEMP_BAND;
+	return temp / DESKEW_CACHE_TEMP_BAND;
+}
+
+/* called with deskew_lock held */
+static struct nvcsi_deskew_cache_entry *deskew_cache_find(
+	unsigned int phy_num, unsigned int cil_lanes,
+	u64 data_rate, int temp_band)
+{
+	struct nvcsi_deskew_cache_entry *entry;
+	unsigned int i;
+
+	for (i = 0; i < DESKEW_CACHE_ENTRIES; i++) {
+		entry = &deskew_cache[phy_num][i];
+		if (entry->valid && entry->cil_lanes == cil_lanes &&
+			entry->data_rate == data_rate &&
+			entry->temp_band == temp_band)
+			return entry;
+	}
+
+	return NULL;
+}
+
+static void deskew_cache_store(struct nvcsi_deskew_context *ctx,
+	unsigned int phy_num, unsigned int cil_lanes,
+	unsigned int *d, unsigned int c)
+{
+	struct nvcsi_deskew_cache_entry *entry;
+
+	if (!ctx->data_rate)
+		return;
+
+	mutex_lock(&deskew_lock);
+	entry = deskew_cache_find(phy_num, cil_lanes,
+				ctx->data_rate, ctx->temp_band);
+	if (!entry) {
+		entry = &deskew_cache[phy_num][deskew_cache_next[phy_num]];
+		deskew_cache_next[phy_num] = (deskew_cache_next[phy_num] + 1) %
+						DESKEW_CACHE_ENTRIES;
+	}
+	entry->valid = true;
+	entry->cil_lanes = cil_lanes;
+	entry->data_rate = ctx->data_rate;
+	entry->temp_band = ctx->temp_band;
+	memcpy(entry->d_trimmer, d, sizeof(entry->d_trimmer));
+	entry->clk_trimmer = c;
+	mutex_unlock(&deskew_lock);
+}
+
+static void deskew_cache_invalidate(struct nvcsi_deskew_context *ctx)
+{
+	struct nvcsi_deskew_cache_entry *entry;
+	unsigned int phy_num, cil_lanes;
+
+	mutex_lock(&deskew_lock);
+	for (phy_num = 0; phy_num < NVCSI_PHY_NUM; phy_num++) {
+		cil_lanes = (ctx->deskew_lanes >> (phy_num * 4)) & 0xf;
+		if (!cil_lanes)
+			continue;
+		entry = deskew_cache_find(phy_num, cil_lanes,
+					ctx->data_rate, ctx->temp_band);
+		if (entry)
+			entry->valid = false;
+	}
+	done_deskew_lanes &= ~ctx->deskew_lanes;
+	mutex_unlock(&deskew_lock);
+	ctx->cached = false;
+}
+
+static unsigned int nvcsi_deskew_lane_errors(unsigned int active_lanes,
+					bool clear)
+{
+	unsigned int phy_num, cil_lanes, addr, val;
+	unsigned int errors = 0;
+
+	for (phy_num = 0; phy_num < NVCSI_PHY_NUM; phy_num++) {
+		cil_lanes = (active_lanes >> (phy_num * 4)) & 0xf;
+		if (cil_lanes & (NVCSI_PHY_0_NVCSI_CIL_A_IO0 |
+				NVCSI_PHY_0_NVCSI_CIL_A_IO1)) {
+			addr = NVCSI_PHY_0_CILA_INTR_STATUS +
+				NVCSI_PHY_OFFSET * phy_num;
+			val = host1x_readl(mc_csi->pdev, addr);
+			errors |= val & CIL_INTR_LANE_ERR_MASK;
+			if (clear)
+				host1x_writel(mc_csi->pdev, addr,
+					val & CIL_INTR_LANE_ERR_MASK);
+		}
+		if (cil_lanes & (NVCSI_PHY_0_NVCSI_CIL_B_IO0 |
+				NVCSI_PHY_0_NVCSI_CIL_B_IO1)) {
+			addr = NVCSI_PHY_0_CILB_INTR_STATUS +
+				NVCSI_PHY_OFFSET * phy_num;
+			val = host1x_readl(mc_csi->pdev, addr);
+			errors |= val & CIL_INTR_LANE_ERR_MASK;
+			if (clear)
+				host1x_writel(mc_csi->pdev, addr,
+					val & CIL_INTR_LANE_ERR_MASK);
+		}
+	}
+
+	return errors;
+}
+
+static int nvcsi_deskew_apply_cached(struct nvcsi_deskew_context *ctx)
+{
+	struct nvcsi_deskew_cache_entry *entry[NVCSI_PHY_NUM] = { NULL };
+	unsigned int phy_num, cil_lanes;
+
+	ctx->temp_band = nvcsi_deskew_temp_band();
+
+	mutex_lock(&deskew_lock);
+	/* another stream is sweeping some of these lanes */
+	if (ctx->deskew_lanes & enabled_deskew_lanes)
+		goto miss;
+
+	for (phy_num = 0; phy_num < NVCSI_PHY_NUM; phy_num++) {
+		cil_lanes = (ctx->deskew_lanes >> (phy_num * 4)) & 0xf;
+		if (!cil_lanes)
+			continue;
+		entry[phy_num] = deskew_cache_find(phy_num, cil_lanes,
+					ctx->data_rate, ctx->temp_band);
+		if (!entry[phy_num])
+			goto miss;
+	}
+
+	for (phy_num = 0; phy_num < NVCSI_PHY_NUM; phy_num++) {
+		if (!entry[phy_num])
+			continue;
+		cil_lanes = entry[phy_num]->cil_lanes;
+		set_trimmer(phy_num,
+			cil_lanes & (NVCSI_PHY_0_NVCSI_CIL_A_IO0 |
+				NVCSI_PHY_0_NVCSI_CIL_A_IO1),
+			cil_lanes & (NVCSI_PHY_0_NVCSI_CIL_B_IO0 |
+				NVCSI_PHY_0_NVCSI_CIL_B_IO1),
+			entry[phy_num]->d_trimmer,
+			entry[phy_num]->clk_trimmer);
+	}
+	done_deskew_lanes |= ctx->deskew_lanes;
+	mutex_unlock(&deskew_lock);
+
+	ctx->cached = true;
+	dev_dbg(mc_csi->dev, "cached deskew applied for lanes 0x%04x\n",
+		ctx->deskew_lanes);
+
+	return 0;
+
+miss:
+	mutex_unlock(&deskew_lock);
+	return -ENOENT;
+}
+
 int nvcsi_deskew_apply_check(struct nvcsi_deskew_context *ctx)
 {
 	unsigned long timeout = 0, timeleft = 1;
@@ -717,16 +913,28 @@ int nvcsi_deskew_apply_check(struct nvcsi_deskew_context *ctx)
 		return -ETIMEDOUT;
 	if (ctx->deskew_lanes ==
 			(done_deskew_lanes & ctx->deskew_lanes)) {
+		/* cached trimmers are verified over the next frame */
+		if (ctx->cached)
+			nvcsi_deskew_lane_errors(ctx->deskew_lanes, true);
 		// sleep for a frame to make sure deskew result is reflected
 		usleep_range(35*1000, 36*1000);
+		if (ctx->cached &&
+			nvcsi_deskew_lane_errors(ctx->deskew_lanes, false)) {
+			dev_info(mc_csi->dev,
+				"cached deskew failed for lanes 0x%04x",
+				ctx->deskew_lanes);
+			deskew_cache_invalidate(ctx);
+			return -EINVAL;
+		}
 		return 0;
 	} else
 		return -EINVAL;
 }
 EXPORT_SYMBOL(nvcsi_deskew_apply_check);
 
-static int nvcsi_deskew_apply_helper(unsigned int active_lanes)
+static int nvcsi_deskew_apply_helper(struct nvcsi_deskew_context *ctx)
 {
+	unsigned int active_lanes = ctx->deskew_lanes;
 	unsigned int phy_num = -1;
 	unsigned int cil_lanes = 0, cila_io_lanes = 0, cilb_io_lanes = 0;
 	unsigned int remaining_lanes = active_lanes;
@@ -768,6 +976,8 @@ static int nvcsi_deskew_apply_helper(unsigned int active_lanes)
 		/*step 3: Apply trimmer settings */
 		set_trimmer(phy_num, cila_io_lanes, cilb_io_lanes,
 				d_trimmer, clk_trimmer);
+		deskew_cache_store(ctx, phy_num, cil_lanes,
+				d_trimmer, clk_trimmer);
 	}
 	return 0;
 }
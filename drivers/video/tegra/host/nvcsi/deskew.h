@@ -148,8 +148,15 @@
 
 #define DESKEW_TIMEOUT_MSEC 100
 
+/*
+ * data_rate is the lane rate of the stream, 0 when unknown. Trimmers are
+ * only cached for streams that provide it.
+ */
 struct nvcsi_deskew_context {
 	unsigned int deskew_lanes;
+	u64 data_rate;
+	int temp_band;
+	bool cached;
 	struct task_struct *deskew_kthread;
 	struct completion thread_done;
 };
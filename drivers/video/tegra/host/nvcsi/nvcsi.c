@@ -388,7 +388,7 @@ static int nvcsi_open(struct inode *inode, struct file *file)
 	struct platform_device *pdev = pdata->pdev;
 	struct nvcsi_private *priv;
 
-	priv = kmalloc(sizeof(*priv), GFP_KERNEL);
+	priv = kzalloc(sizeof(*priv), GFP_KERNEL);
 	if (unlikely(priv == NULL))
 		return -ENOMEM;
 
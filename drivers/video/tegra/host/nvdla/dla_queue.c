@@ -335,6 +335,13 @@ struct nvdla_queue *nvdla_queue_alloc(struct nvdla_queue_pool *pool,
 	queue->attr = NULL;
 	mutex_init(&queue->attr_lock);
 
+	/*
+	 * prio_suspended follows the firmware state of the queue id and is
+	 * cleared by the priority work, not here
+	 */
+	queue->priority = 0;
+	queue->suspended = false;
+
 	mutex_unlock(&pool->queue_lock);
 
 	/* Check if the queue should allocate a channel */
@@ -391,6 +398,22 @@ int nvdla_queue_submit(struct nvdla_queue *queue, void *task_arg)
 	return 0;
 }
 
+int nvdla_queue_submit_batch(struct nvdla_queue *queue, void **tasks,
+			     u32 num_tasks)
+{
+	struct nvdla_queue_pool *pool = queue->pool;
+	int err = 0;
+	u32 i;
+
+	if (pool->ops && pool->ops->submit_batch)
+		return pool->ops->submit_batch(queue, tasks, num_tasks);
+
+	for (i = 0; i < num_tasks && !err; i++)
+		err = nvdla_queue_submit(queue, tasks[i]);
+
+	return err;
+}
+
 int nvdla_queue_set_attr(struct nvdla_queue *queue, void *arg)
 {
 	struct nvdla_queue_pool *pool = queue->pool;
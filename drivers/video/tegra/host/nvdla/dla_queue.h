@@ -57,6 +57,9 @@ struct nvdla_queue_task_mem_info {
  * task_dma_size	dma size used in hardware for a task
  * task_kmem_size	kernel memory size for a task
  * attr			queue attribute associated with the host module
+ * priority		scheduling priority, NVDLA_QUEUE_PRIORITY_*
+ * suspended		queue was suspended by its user
+ * prio_suspended	queue was suspended for a higher priority task
  *
  */
 struct nvdla_queue {
@@ -81,6 +84,10 @@ struct nvdla_queue {
 
 	struct mutex list_lock;
 	struct list_head tasklist;
+
+	u32 priority;
+	bool suspended;
+	bool prio_suspended;
 };
 
 /**
@@ -89,6 +96,7 @@ struct nvdla_queue {
  * dump			dump the task information
  * abort		abort all tasks from a queue
  * submit		submit the given list of tasks to hardware
+ * submit_batch		submit several prepared tasks to hardware at once
  * get_task_size	get the dma size needed for the task in hw
  *			and the kernel memory size needed for task.
  *
@@ -97,6 +105,8 @@ struct nvdla_queue_ops {
 	void (*dump)(struct nvdla_queue *queue, struct seq_file *s);
 	int (*abort)(struct nvdla_queue *queue);
 	int (*submit)(struct nvdla_queue *queue, void *task_arg);
+	int (*submit_batch)(struct nvdla_queue *queue, void **task_args,
+			    u32 num_tasks);
 	void (*get_task_size)(size_t *dma_size, size_t *kmem_size);
 	int (*set_attribute)(struct nvdla_queue *queue, void *arg);
 };
@@ -222,6 +232,22 @@ int nvdla_queue_abort(struct nvdla_queue *queue);
  */
 int nvdla_queue_submit(struct nvdla_queue *queue, void *submit);
 
+/**
+ * @brief	submits several prepared tasks to hardware at once
+ *
+ * Tasks are queued in order. Hardware specific code may hand them to the
+ * engine with a single doorbell; queues without batch support submit the
+ * tasks one by one.
+ *
+ * @param queue		Pointer to an allocated queue
+ * @param tasks		Tasks to submit
+ * @param num_tasks	Number of entries in tasks
+ * @return		0 on success or negative error code on failure.
+ *
+ */
+int nvdla_queue_submit_batch(struct nvdla_queue *queue, void **tasks,
+			     u32 num_tasks);
+
 /**
  * @brief	Get the Task Size needed
  *
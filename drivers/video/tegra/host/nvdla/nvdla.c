@@ -43,6 +43,7 @@
 #include "nvdla/dla_queue.h"
 #include "nvdla/nvdla_buffer.h"
 #include "nvdla/nvdla_debug.h"
+#include "nvhost_trace_stream.h"
 #include <uapi/linux/nvhost_nvdla_ioctl.h>
 #include "dla_os_interface.h"
 
@@ -50,6 +51,47 @@
 
 static DEFINE_DMA_ATTRS(attrs);
 
+/* all probed DLA instances, for dispatching tasks of any instance */
+static LIST_HEAD(nvdla_group);
+static DEFINE_MUTEX(nvdla_group_lock);
+
+/*
+ * The load of an instance is its number of outstanding tasks weighted by
+ * its recent task execution time, so a core running long networks counts
+ * as busier than one with the same queue depth of short ones.
+ */
+struct nvdla_device *nvdla_group_pick(void)
+{
+	struct nvdla_device *nvdla_dev, *best = NULL;
+	u64 load, best_load = U64_MAX;
+
+	mutex_lock(&nvdla_group_lock);
+	list_for_each_entry(nvdla_dev, &nvdla_group, group_node) {
+		load = (u64)(atomic_read(&nvdla_dev->outstanding) + 1) *
+			(READ_ONCE(nvdla_dev->avg_exec_us) + 1);
+		if (load < best_load) {
+			best_load = load;
+			best = nvdla_dev;
+		}
+	}
+	mutex_unlock(&nvdla_group_lock);
+
+	return best;
+}
+
+void nvdla_group_task_done(struct nvdla_device *nvdla_dev, u32 exec_us)
+{
+	u32 avg = READ_ONCE(nvdla_dev->avg_exec_us);
+
+	/* running average with a weight of 1/8 for the new sample */
+	if (avg)
+		avg = avg - (avg >> 3) + (exec_us >> 3);
+	else
+		avg = exec_us;
+
+	WRITE_ONCE(nvdla_dev->avg_exec_us, avg);
+}
+
 /*
  * Work to handle engine reset for error recovery
  */
@@ -372,6 +414,8 @@ int nvdla_alloc_gcov_region(struct platform_device *pdev)
 	if (err)
 		nvdla_free_gcov_region(pdev, false);
 
+	nvhost_trace_stream_destroy(nvdla_dev->trace_stream);
+
 fail_alloc_gcov_dma:
 	return err;
 }
@@ -783,6 +827,8 @@ static int nvdla_probe(struct platform_device *pdev)
 	/* init reset handler workqueue */
 	nvdla_reset_handler_init(nvdla_dev);
 
+	nvdla_queue_prio_init(nvdla_dev);
+
 	err = nvhost_syncpt_unit_interface_init(pdev);
 	if (err)
 		goto err_mss_init;
@@ -791,6 +837,10 @@ static int nvdla_probe(struct platform_device *pdev)
 	if (err)
 		goto err_alloc_cmd_mem;
 
+	mutex_lock(&nvdla_group_lock);
+	list_add_tail(&nvdla_dev->group_node, &nvdla_group);
+	mutex_unlock(&nvdla_group_lock);
+
 	nvdla_dbg_info(pdev, "pdata:%p initialized\n", pdata);
 
 	return 0;
@@ -816,6 +866,11 @@ static int __exit nvdla_remove(struct platform_device *pdev)
 	struct nvhost_device_data *pdata = platform_get_drvdata(pdev);
 	struct nvdla_device *nvdla_dev = pdata->private_data;
 
+	mutex_lock(&nvdla_group_lock);
+	list_del(&nvdla_dev->group_node);
+	mutex_unlock(&nvdla_group_lock);
+
+	cancel_work_sync(&nvdla_dev->prio_work);
 	nvdla_queue_deinit(nvdla_dev->pool);
 	nvhost_client_device_release(pdev);
 
@@ -30,6 +30,8 @@
 #include "dla_os_interface.h"
 #include "dla_t19x_fw_version.h"
 
+struct nvhost_trace_stream;
+
 /*
  * macro to encode firmware version
  */
@@ -66,6 +68,11 @@
  */
 #define MAX_NVDLA_QUEUE_COUNT	16
 
+/**
+ * Maximum number of DLA instances
+ */
+#define NVDLA_MAX_INSTANCES	2
+
 /**
  * Maximum number of tasks per queue
  */
@@ -81,11 +88,22 @@
  */
 #define MAX_NUM_NVDLA_BUFFERS_PER_TASK	6144
 
+/**
+ * Maximum number of template addresses a single task can override
+ */
+#define MAX_NUM_NVDLA_TEMPLATE_PATCHES	64
+
 /**
  * Trace Buffer Size
  */
 #define TRACE_BUFFER_SIZE		SZ_1M
 
+/**
+ * Size and drain period of the firmware trace stream
+ */
+#define TRACE_STREAM_SIZE		SZ_4M
+#define TRACE_STREAM_PERIOD_MS		100
+
 /**
  * Maximum buffer size for debug dump
  */
@@ -174,6 +192,26 @@ enum nvdla_submit_mode {
 	NVDLA_SUBMIT_MODE_CHANNEL	= 1
 };
 
+/**
+ * struct nvdla_prio_stats:	task latency accounting of a queue priority
+ *
+ * @tasks		completed tasks
+ * @wait_us		total submit to start of execution time
+ * @wait_max_us		longest submit to start of execution time
+ * @latency_us		total submit to completion time
+ * @latency_max_us	longest submit to completion time
+ * @preemptions		times a queue of this priority was suspended for a
+ *			higher priority task
+ */
+struct nvdla_prio_stats {
+	u64 tasks;
+	u64 wait_us;
+	u64 wait_max_us;
+	u64 latency_us;
+	u64 latency_max_us;
+	u64 preemptions;
+};
+
 /**
  * data structure to keep per DLA engine device data
  *
@@ -196,6 +234,19 @@ enum nvdla_submit_mode {
  * @gcov_dump_pa	physical address of fw gcov buffer
  * @gcov_dump_va	virtual address of fw gcovbuffer
  * @quirks		Tegra/DLA Hardware version specific settings
+ * @group_node		entry in the list of DLA instances
+ * @outstanding		number of tasks submitted and not yet completed
+ * @avg_exec_us		running average of the task execution time
+ * @trace_stream	stream of firmware trace text for userspace
+ * @trace_stream_pos	next trace buffer index to copy to the stream
+ * @prio_lock		serializes priority suspend/resume of the queues
+ * @prio_outstanding	number of outstanding tasks per queue priority
+ * @prio_pinned		queues a higher priority task waits on, these are
+ *			not suspended
+ * @prio_work		work resuming the queues once higher priority tasks
+ *			completed
+ * @prio_stats_lock	protects prio_stats
+ * @prio_stats		per queue priority task latency accounting
  */
 struct nvdla_device {
 	struct platform_device *pdev;
@@ -222,6 +273,17 @@ struct nvdla_device {
 	u32 *gcov_dump_va;
 	u32 quirks;
 	struct work_struct reset_work;
+	struct list_head group_node;
+	atomic_t outstanding;
+	u32 avg_exec_us;
+	struct nvhost_trace_stream *trace_stream;
+	u32 trace_stream_pos;
+	struct mutex prio_lock;
+	atomic_t prio_outstanding[NVDLA_QUEUE_PRIORITY_NUM];
+	unsigned long prio_pinned;
+	struct work_struct prio_work;
+	spinlock_t prio_stats_lock;
+	struct nvdla_prio_stats prio_stats[NVDLA_QUEUE_PRIORITY_NUM];
 };
 
 /**
@@ -248,6 +310,26 @@ struct nvdla_emu_task {
 	u32 fence_counter;
 };
 
+/**
+ * struct nvdla_task_template:	address list registered once for a network
+ *
+ * @ref			Reference count, one per task using the template
+ * @id			Unique template id, never reused
+ * @buffers		nvdla buffers the template is pinned against
+ * @num_addresses	Number of entries in the address list
+ * @dmabufs		dma_buf of each address list entry
+ * @addresses		Resolved IOVA of each address list entry
+ *
+ */
+struct nvdla_task_template {
+	struct kref ref;
+	u32 id;
+	struct nvdla_buffers *buffers;
+	u32 num_addresses;
+	struct dma_buf **dmabufs;
+	u64 *addresses;
+};
+
 /**
  * struct nvdla_task:	structure for task info
  *
@@ -264,6 +346,13 @@ struct nvdla_emu_task {
  * @buf_size		Total size of task dma alloc
  * @timeout		max timeout to wait for task completion
  * @op_handle		pointer to handle list of operation descriptor
+ * @tmpl		template the address list is taken from, or NULL
+ * @patch_index		template slots overridden by memory_handles
+ * @desc_tmpl_id	template whose address list the descriptor memory of
+ *			this pool slot holds, 0 if none
+ * @desc_num_patches	number of overridden slots in the descriptor memory
+ * @desc_patch_index	overridden slots in the descriptor memory
+ * @priority		priority of the queue when the task was submitted
  *
  */
 struct nvdla_task {
@@ -288,6 +377,8 @@ struct nvdla_task {
 	u32 num_addresses;
 	u32 fence;
 	u32 fence_counter;
+	u64 submit_ts;
+	u32 priority;
 	struct kref ref;
 	struct list_head list;
 	struct dla_task_descriptor *task_desc;
@@ -304,6 +395,12 @@ struct nvdla_task {
 	struct dma_buf *eof_task_status_dmabuf[MAX_NUM_NVDLA_OUT_TASK_STATUS];
 	struct dma_buf *sof_timestamps_dmabuf[MAX_NUM_NVDLA_OUT_TIMESTAMP];
 	struct dma_buf *eof_timestamps_dmabuf[MAX_NUM_NVDLA_OUT_TIMESTAMP];
+
+	struct nvdla_task_template *tmpl;
+	u32 patch_index[MAX_NUM_NVDLA_TEMPLATE_PATCHES];
+	u32 desc_tmpl_id;
+	u32 desc_num_patches;
+	u32 desc_patch_index[MAX_NUM_NVDLA_TEMPLATE_PATCHES];
 };
 
 struct dla_mem_addr {
@@ -411,10 +508,31 @@ int nvdla_fill_task_desc(struct nvdla_task *task);
 int nvdla_send_postfences(struct nvdla_task *task,
 			struct nvdla_ioctl_submit_task *usr_task);
 
+/**
+ * nvdla_task_template_create()	pin a network address list once
+ *
+ * @buffers		nvdla buffers the handles are pinned against
+ * @handles		Address list of the network
+ * @num_addresses	Number of entries in @handles
+ *
+ * Return		template on success, otherwise pointer to err
+ *
+ * This function resolves and holds a submit pin on every buffer of the list
+ * so that template based submits only pin the addresses they override.
+ */
+struct nvdla_task_template *nvdla_task_template_create(
+			struct nvdla_buffers *buffers,
+			struct nvdla_mem_handle *handles,
+			u32 num_addresses);
+void nvdla_task_template_get(struct nvdla_task_template *tmpl);
+void nvdla_task_template_put(struct nvdla_task_template *tmpl);
+
 int nvdla_get_cmd_memory(struct platform_device *pdev,
 				struct nvdla_cmd_mem_info *cmd_mem_info);
 int nvdla_put_cmd_memory(struct platform_device *pdev, int index);
 int nvdla_set_queue_state(struct nvdla_queue *queue, int cmd);
+int nvdla_set_queue_priority(struct nvdla_queue *queue, u32 priority);
+void nvdla_queue_prio_init(struct nvdla_device *nvdla_dev);
 int nvdla_get_task_mem(struct nvdla_queue *queue,
 				struct nvdla_task **task);
 void nvdla_put_task_mem(struct nvdla_task *task);
@@ -425,7 +543,11 @@ int nvdla_free_gcov_region(struct platform_device *pdev, bool update_region);
 int nvdla_emulator_submit(struct nvdla_queue *queue,
 				struct nvdla_emu_task *task);
 void task_free(struct kref *ref);
-int nvdla_get_signal_fences(struct nvdla_queue *queue, void *in_task);
+int nvdla_get_signal_fences(struct nvdla_queue *queue, void *in_task,
+			u32 pending_incrs);
+int nvdla_unmap_task_memory(struct nvdla_task *task);
 int nvdla_send_gos_region(struct platform_device *pdev);
+struct nvdla_device *nvdla_group_pick(void);
+void nvdla_group_task_done(struct nvdla_device *nvdla_dev, u32 exec_us);
 
 #endif /* End of __NVHOST_NVDLA_H__ */
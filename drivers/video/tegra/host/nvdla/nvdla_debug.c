@@ -18,6 +18,7 @@
 
 #include <linux/platform_device.h>
 #include <linux/debugfs.h>
+#include <linux/math64.h>
 #include <linux/nvhost.h>
 #include "host1x/host1x.h"
 #include "flcn/flcn.h"
@@ -29,6 +30,7 @@
 
 #include "nvdla/nvdla.h"
 #include "nvdla_debug.h"
+#include "nvhost_trace_stream.h"
 
 /*
  * Header in ring buffer consist (start, end) two uint32_t values.
@@ -696,6 +698,106 @@ static const struct file_operations nvdla_a01_war_fops = {
 		.write		= debug_dla_fw_a01_war_set,
 };
 
+/*
+ * Copy the text the firmware added to its circular trace buffer since the
+ * last drain. The buffer header holds the start and end index of the text.
+ */
+static void dla_trace_stream_drain(struct nvhost_trace_stream *stream,
+				   void *data)
+{
+	struct nvdla_device *nvdla_dev = data;
+	char *bufptr = (char *)nvdla_dev->trace_dump_va;
+	uint32_t offset = TRACE_DATA_OFFSET;
+	uint32_t start, end, pos;
+
+	if (!bufptr || !nvdla_dev->trace_enable)
+		return;
+
+	memcpy(&start, bufptr, sizeof(uint32_t));
+	memcpy(&end, bufptr + sizeof(uint32_t), sizeof(uint32_t));
+
+	if (start < offset || start >= TRACE_BUFFER_SIZE ||
+	    end < offset || end >= TRACE_BUFFER_SIZE)
+		return;
+
+	pos = nvdla_dev->trace_stream_pos;
+	if (pos < offset || pos >= TRACE_BUFFER_SIZE)
+		pos = start;
+
+	if (pos == end)
+		return;
+
+	if (pos < end) {
+		nvhost_trace_stream_write(stream, bufptr + pos, end - pos);
+	} else {
+		nvhost_trace_stream_write(stream, bufptr + pos,
+					  TRACE_BUFFER_SIZE - pos);
+		nvhost_trace_stream_write(stream, bufptr + offset,
+					  end - offset);
+	}
+
+	nvdla_dev->trace_stream_pos = end;
+}
+
+static int nvdla_prio_stats_show(struct seq_file *s, void *unused)
+{
+	static const char * const names[NVDLA_QUEUE_PRIORITY_NUM] = {
+		[NVDLA_QUEUE_PRIORITY_LOW] = "low",
+		[NVDLA_QUEUE_PRIORITY_NORMAL] = "normal",
+		[NVDLA_QUEUE_PRIORITY_HIGH] = "high",
+	};
+	struct nvdla_device *nvdla_dev = s->private;
+	struct nvdla_prio_stats stats[NVDLA_QUEUE_PRIORITY_NUM];
+	int i;
+
+	spin_lock(&nvdla_dev->prio_stats_lock);
+	memcpy(stats, nvdla_dev->prio_stats, sizeof(stats));
+	spin_unlock(&nvdla_dev->prio_stats_lock);
+
+	seq_printf(s, "%-8s %10s %12s %12s %12s %12s %12s\n",
+		   "priority", "tasks", "wait_avg_us", "wait_max_us",
+		   "avg_us", "max_us", "preempted");
+	for (i = 0; i < NVDLA_QUEUE_PRIORITY_NUM; i++)
+		seq_printf(s, "%-8s %10llu %12llu %12llu %12llu %12llu %12llu\n",
+			   names[i], stats[i].tasks,
+			   stats[i].tasks ?
+				div64_u64(stats[i].wait_us, stats[i].tasks) : 0,
+			   stats[i].wait_max_us,
+			   stats[i].tasks ?
+				div64_u64(stats[i].latency_us,
+					  stats[i].tasks) : 0,
+			   stats[i].latency_max_us, stats[i].preemptions);
+
+	return 0;
+}
+
+static int nvdla_prio_stats_open(struct inode *inode, struct file *file)
+{
+	return single_open(file, nvdla_prio_stats_show, inode->i_private);
+}
+
+/* any write clears the statistics */
+static ssize_t nvdla_prio_stats_clear(struct file *file,
+		const char __user *buf, size_t count, loff_t *offp)
+{
+	struct seq_file *s = file->private_data;
+	struct nvdla_device *nvdla_dev = s->private;
+
+	spin_lock(&nvdla_dev->prio_stats_lock);
+	memset(nvdla_dev->prio_stats, 0, sizeof(nvdla_dev->prio_stats));
+	spin_unlock(&nvdla_dev->prio_stats_lock);
+
+	return count;
+}
+
+static const struct file_operations nvdla_prio_stats_fops = {
+	.open		= nvdla_prio_stats_open,
+	.read		= seq_read,
+	.write		= nvdla_prio_stats_clear,
+	.llseek		= seq_lseek,
+	.release	= single_release,
+};
+
 static void dla_fw_debugfs_init(struct platform_device *pdev)
 {
 	struct dentry *fw_dir, *fw_trace, *events, *fw_gcov;
@@ -742,6 +844,14 @@ static void dla_fw_debugfs_init(struct platform_device *pdev)
 			nvdla_dev, &debug_dla_bin_event_trace_fops))
 		goto trace_failed;
 
+	nvdla_dev->trace_stream = nvhost_trace_stream_create(fw_trace,
+			"stream", TRACE_STREAM_SIZE, dla_trace_stream_drain,
+			nvdla_dev, TRACE_STREAM_PERIOD_MS);
+	if (IS_ERR(nvdla_dev->trace_stream)) {
+		nvdla_dev->trace_stream = NULL;
+		goto trace_failed;
+	}
+
 	events = debugfs_create_dir("events", fw_trace);
 	if (!events)
 		goto event_failed;
@@ -797,6 +907,8 @@ void nvdla_debug_init(struct platform_device *pdev)
 #endif
 	debugfs_create_u32("submit_mode", S_IRUGO | S_IWUSR, de,
 			&nvdla_dev->submit_mode);
+	debugfs_create_file("priority_stats", S_IRUGO | S_IWUSR, de,
+			nvdla_dev, &nvdla_prio_stats_fops);
 
 	/* Check if isolate context enabled if submit mode is CHANNEL */
 	nvdla_dev->submit_mode = nvdla_dev->submit_mode &&
@@ -16,11 +16,13 @@
  * along with this program.  If not, see <http://www.gnu.org/licenses/>.
  */
 
+#include <linux/capability.h>
 #include <linux/fs.h>
 #include <linux/platform_device.h>
 #include <linux/slab.h>
 #include <linux/dma-mapping.h>
 #include <linux/uaccess.h>
+#include <linux/vmalloc.h>
 
 #include "dev.h"
 #include "bus_client.h"
@@ -46,12 +48,27 @@
  * @pdev		pointer to platform device
  * @queue		pointer to nvdla_queue
  * @buffers		pointer to nvdla_buffer
+ * @tmpl		task template registered on the queue
+ * @tmpl_lock		protects @tmpl
+ * @peers		queues on other DLA instances, for tasks that may run
+ *			on any instance
+ * @peers_lock		protects @peers
  */
 
+struct nvdla_peer_queue {
+	struct nvdla_device *nvdla_dev;
+	struct nvdla_queue *queue;
+	struct nvdla_buffers *buffers;
+};
+
 struct nvdla_private {
 	struct platform_device *pdev;
 	struct nvdla_queue *queue;
 	struct nvdla_buffers *buffers;
+	struct nvdla_task_template *tmpl;
+	struct mutex tmpl_lock;
+	struct nvdla_peer_queue peers[NVDLA_MAX_INSTANCES - 1];
+	struct mutex peers_lock;
 };
 
 static int nvdla_get_fw_ver(struct nvdla_private *priv,
@@ -126,6 +143,50 @@ inval_cmd:
 	return err;
 }
 
+static int nvdla_set_queue_prio(struct nvdla_private *priv, void *args)
+{
+	struct nvdla_queue_priority_args *prio_arg =
+			(struct nvdla_queue_priority_args *)args;
+	struct platform_device *pdev = priv->pdev;
+	struct nvdla_queue *queue = priv->queue;
+	int err = 0;
+	int i;
+
+	nvdla_dbg_fn(pdev, "");
+
+	if (!queue) {
+		nvdla_dbg_err(pdev, "invalid queue\n");
+		return -EINVAL;
+	}
+
+	if (prio_arg->reserved ||
+	    prio_arg->priority >= NVDLA_QUEUE_PRIORITY_NUM) {
+		nvdla_dbg_err(pdev, "invalid queue priority[%u]\n",
+				prio_arg->priority);
+		return -EINVAL;
+	}
+
+	/* preempting other users of the engine needs privileges */
+	if (prio_arg->priority == NVDLA_QUEUE_PRIORITY_HIGH &&
+	    !capable(CAP_SYS_NICE))
+		return -EPERM;
+
+	err = nvdla_set_queue_priority(queue, prio_arg->priority);
+	if (err)
+		return err;
+
+	mutex_lock(&priv->peers_lock);
+	for (i = 0; i < ARRAY_SIZE(priv->peers); i++)
+		if (priv->peers[i].nvdla_dev)
+			(void) nvdla_set_queue_priority(priv->peers[i].queue,
+							prio_arg->priority);
+	mutex_unlock(&priv->peers_lock);
+
+	nvdla_dbg_fn(pdev, "queue priority set[%u]", prio_arg->priority);
+
+	return 0;
+}
+
 static int nvdla_get_q_status(struct nvdla_private *priv, void *args)
 {
 	struct nvdla_get_q_status_args *queue_arg =
@@ -686,6 +747,15 @@ static int nvdla_val_task_submit_input(struct nvdla_ioctl_submit_task *in_task)
 			MAX_NUM_NVDLA_OUT_TIMESTAMP);
 		return -EINVAL;
 	}
+	if (in_task->flags & NVDLA_TASK_FLAGS_USE_TEMPLATE) {
+		if (in_task->num_addresses > MAX_NUM_NVDLA_TEMPLATE_PATCHES) {
+			pr_err("num patches[%u] crossing expected[%d]\n",
+				in_task->num_addresses,
+				MAX_NUM_NVDLA_TEMPLATE_PATCHES);
+			return -EINVAL;
+		}
+		return 0;
+	}
 	if (in_task->num_addresses < 1) {
 		pr_err("num addresses[%u] should be min one\n",
 				in_task->num_addresses);
@@ -701,7 +771,141 @@ static int nvdla_val_task_submit_input(struct nvdla_ioctl_submit_task *in_task)
 	return 0;
 }
 
-static int nvdla_fill_task(struct nvdla_queue *queue,
+static int nvdla_get_patches(struct nvdla_private *priv,
+				struct nvdla_ioctl_submit_task *local_task,
+				struct nvdla_task *task)
+{
+	struct nvdla_mem_patch patches[MAX_NUM_NVDLA_TEMPLATE_PATCHES];
+	struct platform_device *pdev = priv->pdev;
+	u32 i;
+
+	if (task->num_addresses && copy_from_user(patches,
+		(void __user *)local_task->address_list,
+		(task->num_addresses * sizeof(struct nvdla_mem_patch)))) {
+		nvdla_dbg_err(pdev, "failed to copy patch list");
+		return -EFAULT;
+	}
+
+	mutex_lock(&priv->tmpl_lock);
+	if (!priv->tmpl) {
+		mutex_unlock(&priv->tmpl_lock);
+		nvdla_dbg_err(pdev, "no task template registered");
+		return -EINVAL;
+	}
+
+	for (i = 0; i < task->num_addresses; i++) {
+		if (patches[i].index >= priv->tmpl->num_addresses) {
+			mutex_unlock(&priv->tmpl_lock);
+			nvdla_dbg_err(pdev, "patch index[%u] out of template",
+					patches[i].index);
+			return -EINVAL;
+		}
+		task->patch_index[i] = patches[i].index;
+		task->memory_handles[i].handle = patches[i].handle;
+		task->memory_handles[i].offset = patches[i].offset;
+	}
+
+	/* released with the task memory */
+	nvdla_task_template_get(priv->tmpl);
+	task->tmpl = priv->tmpl;
+	mutex_unlock(&priv->tmpl_lock);
+
+	return 0;
+}
+
+/*
+ * Choose the queue a task is submitted to. Tasks flagged to run on any
+ * instance go to the least loaded DLA; a queue on that instance is created
+ * on first use and kept until the queue of the file is released.
+ */
+static void nvdla_select_queue(struct nvdla_private *priv,
+			       struct nvdla_ioctl_submit_task *local_task,
+			       struct nvdla_queue **queue,
+			       struct nvdla_buffers **buffers)
+{
+	struct nvdla_peer_queue *peer = NULL;
+	struct nvdla_device *nvdla_dev;
+	struct nvdla_queue *new_queue;
+	struct nvdla_buffers *new_buffers;
+	int i;
+
+	*queue = priv->queue;
+	*buffers = priv->buffers;
+
+	if (!(local_task->flags & NVDLA_TASK_FLAGS_ANY_INSTANCE) ||
+	    (local_task->flags & NVDLA_TASK_FLAGS_USE_TEMPLATE))
+		return;
+
+	nvdla_dev = nvdla_group_pick();
+	if (!nvdla_dev || nvdla_dev->pdev == priv->pdev)
+		return;
+
+	mutex_lock(&priv->peers_lock);
+
+	for (i = 0; i < ARRAY_SIZE(priv->peers); i++) {
+		if (priv->peers[i].nvdla_dev == nvdla_dev ||
+		    !priv->peers[i].nvdla_dev) {
+			peer = &priv->peers[i];
+			break;
+		}
+	}
+
+	if (!peer)
+		goto out;
+
+	if (!peer->nvdla_dev) {
+		new_buffers = nvdla_buffer_init(NULL);
+		if (IS_ERR(new_buffers))
+			goto out;
+
+		new_queue = nvdla_queue_alloc(nvdla_dev->pool,
+				MAX_NVDLA_TASK_COUNT,
+				nvdla_dev->submit_mode ==
+					NVDLA_SUBMIT_MODE_CHANNEL);
+		if (IS_ERR(new_queue)) {
+			nvdla_buffer_release(new_buffers);
+			goto out;
+		}
+
+		nvdla_buffer_set_platform_device(new_buffers,
+						 new_queue->vm_pdev);
+
+		/* the peer runs at the priority of the queue of the file */
+		(void) nvdla_set_queue_priority(new_queue,
+						priv->queue->priority);
+
+		peer->queue = new_queue;
+		peer->buffers = new_buffers;
+		peer->nvdla_dev = nvdla_dev;
+	}
+
+	*queue = peer->queue;
+	*buffers = peer->buffers;
+out:
+	mutex_unlock(&priv->peers_lock);
+}
+
+static void nvdla_release_peers(struct nvdla_private *priv)
+{
+	struct nvdla_peer_queue *peer;
+	int i;
+
+	mutex_lock(&priv->peers_lock);
+	for (i = 0; i < ARRAY_SIZE(priv->peers); i++) {
+		peer = &priv->peers[i];
+		if (!peer->nvdla_dev)
+			continue;
+
+		(void) nvdla_queue_abort(peer->queue);
+		nvdla_queue_put(peer->queue);
+		nvdla_buffer_release(peer->buffers);
+		memset(peer, 0, sizeof(*peer));
+	}
+	mutex_unlock(&priv->peers_lock);
+}
+
+static int nvdla_fill_task(struct nvdla_private *priv,
+				struct nvdla_queue *queue,
 				struct nvdla_buffers *buffers,
 				struct nvdla_ioctl_submit_task *local_task,
 				struct nvdla_task *task)
@@ -744,11 +948,16 @@ static int nvdla_fill_task(struct nvdla_queue *queue,
 		goto fail_to_get_actions;
 	}
 
-	/* get user addresses list */
-	if (copy_from_user(task->memory_handles,
+	/* template based task only carries the overridden addresses */
+	if (local_task->flags & NVDLA_TASK_FLAGS_USE_TEMPLATE) {
+		err = nvdla_get_patches(priv, local_task, task);
+		if (err)
+			goto fail_to_get_addr_list;
+	} else if (copy_from_user(task->memory_handles,
 		(void __user *)local_task->address_list,
 		(task->num_addresses *
 			sizeof(struct nvdla_mem_handle)))) {
+		/* get user addresses list */
 		err = -EFAULT;
 		nvdla_dbg_err(pdev, "failed to copy address list");
 		goto fail_to_get_addr_list;
@@ -971,6 +1180,9 @@ static int nvdla_queue_alloc_handler(struct nvdla_private *priv, void *arg)
 		goto fail;
 	}
 
+	(void) nvdla_set_queue_priority(priv->queue,
+					NVDLA_QUEUE_PRIORITY_NORMAL);
+
 	/* Set nvdla_buffers platform device */
 	nvdla_buffer_set_platform_device(priv->buffers, priv->queue->vm_pdev);
 
@@ -1001,6 +1213,17 @@ static int nvdla_queue_release_handler(struct nvdla_private *priv, void *arg)
 
 	/* Release the queue */
 	(void) nvdla_queue_abort(priv->queue);
+
+	/* tasks still in flight keep their own template reference */
+	mutex_lock(&priv->tmpl_lock);
+	if (priv->tmpl) {
+		nvdla_task_template_put(priv->tmpl);
+		priv->tmpl = NULL;
+	}
+	mutex_unlock(&priv->tmpl_lock);
+
+	nvdla_release_peers(priv);
+
 	nvdla_queue_put(priv->queue);
 
 	priv->queue = NULL;
@@ -1008,6 +1231,71 @@ fail:
 	return err;
 }
 
+static int nvdla_set_task_template(struct nvdla_private *priv, void *arg)
+{
+	struct nvdla_task_template_args *args =
+			(struct nvdla_task_template_args *)arg;
+	struct platform_device *pdev = priv->pdev;
+	struct nvdla_task_template *tmpl = NULL;
+	struct nvdla_task_template *old;
+	struct nvdla_mem_handle *handles;
+	u32 count;
+	int err = 0;
+
+	if (!priv->queue) {
+		nvdla_dbg_err(pdev, "No queue allocated");
+		return -EINVAL;
+	}
+
+	if (args->flags & ~NVDLA_TASK_TEMPLATE_FLAGS_REMOVE)
+		return -EINVAL;
+
+	if (args->flags & NVDLA_TASK_TEMPLATE_FLAGS_REMOVE)
+		goto install;
+
+	count = args->num_addresses;
+	if (count == 0 || count > NVDLA_MAX_BUFFERS_PER_TASK ||
+	    !args->address_list) {
+		nvdla_dbg_err(pdev, "Inval count arg for template");
+		return -EINVAL;
+	}
+
+	handles = vmalloc(count * sizeof(*handles));
+	if (!handles)
+		return -ENOMEM;
+
+	if (copy_from_user(handles, (void __user *)args->address_list,
+			(count * sizeof(*handles)))) {
+		err = -EFAULT;
+		goto fail_to_copy_list;
+	}
+
+	tmpl = nvdla_task_template_create(priv->buffers, handles, count);
+	if (IS_ERR(tmpl)) {
+		err = PTR_ERR(tmpl);
+		nvdla_dbg_err(pdev, "failed to create template: %d", err);
+		goto fail_to_copy_list;
+	}
+	vfree(handles);
+
+install:
+	mutex_lock(&priv->tmpl_lock);
+	old = priv->tmpl;
+	priv->tmpl = tmpl;
+	mutex_unlock(&priv->tmpl_lock);
+
+	if (old)
+		nvdla_task_template_put(old);
+
+	nvdla_dbg_info(pdev, "task template[%u] set",
+			tmpl ? tmpl->id : 0);
+
+	return 0;
+
+fail_to_copy_list:
+	vfree(handles);
+	return err;
+}
 
 static int nvdla_submit(struct nvdla_private *priv, void *arg)
 {
@@ -1055,6 +1343,8 @@ static int nvdla_submit(struct nvdla_private *priv, void *arg)
 	for (i = 0; i < num_tasks; i++) {
 		nvdla_dbg_info(pdev, "submit [%d]th task", i + 1);
 
+		nvdla_select_queue(priv, local_tasks + i, &queue, &buffers);
+
 		err = nvdla_get_task_mem(queue, &task);
 		if (err) {
 			nvdla_dbg_err(pdev, "failed to get task[%d] mem", i + 1);
@@ -1066,7 +1356,8 @@ static int nvdla_submit(struct nvdla_private *priv, void *arg)
 		kref_init(&task->ref);
 
 		/* fill local task param from user args */
-		err = nvdla_fill_task(queue, buffers, local_tasks + i, task);
+		err = nvdla_fill_task(priv, queue, buffers,
+				      local_tasks + i, task);
 		if (err) {
 			nvdla_dbg_err(pdev, "failed to fill task[%d]", i + 1);
 			goto fail_to_fill_task;
@@ -1086,7 +1377,7 @@ static int nvdla_submit(struct nvdla_private *priv, void *arg)
 		nvdla_dbg_info(pdev, "task[%d] desc filled", i + 1);
 
 		/* get expected signal fences prior to submit */
-		err = nvdla_get_signal_fences(queue, task);
+		err = nvdla_get_signal_fences(queue, task, 0);
 		if (err) {
 			nvdla_dbg_err(pdev, "fail to get fences%d", i + 1);
 			goto fail_to_get_fences;
@@ -1136,6 +1427,119 @@ fail_to_copy_task:
 	return err;
 }
 
+/*
+ * Batch submit: every task is prepared first, with fences accounting for
+ * the increments of the tasks ahead of it in the batch, and the whole batch
+ * is then handed to the queue in one go.
+ */
+static int nvdla_submit_batch(struct nvdla_private *priv, void *arg)
+{
+	struct nvdla_submit_args *args =
+			(struct nvdla_submit_args *)arg;
+	struct nvdla_ioctl_submit_task local_tasks[MAX_TASKS_PER_SUBMIT];
+	struct nvdla_task *tasks[MAX_TASKS_PER_SUBMIT];
+	struct nvhost_device_data *pdata;
+	struct nvdla_device *nvdla_dev;
+	struct platform_device *pdev;
+	struct nvdla_queue *queue;
+	struct nvdla_task *task = NULL;
+	u32 num_tasks, pending = 0;
+	int err = 0, i = 0, prepared = 0;
+
+	if (!args || !priv)
+		return -EINVAL;
+
+	pdev = priv->pdev;
+	queue = priv->queue;
+	if (!(queue && pdev && priv->buffers))
+		return -EINVAL;
+
+	pdata = platform_get_drvdata(pdev);
+	nvdla_dev = pdata->private_data;
+
+	num_tasks = args->num_tasks;
+	if (!args->tasks || num_tasks == 0 ||
+	    num_tasks > MAX_TASKS_PER_SUBMIT)
+		return -EINVAL;
+
+	nvdla_dbg_fn(pdev, "num of tasks [%d]", num_tasks);
+
+	if (copy_from_user(local_tasks, (void __user *)(uintptr_t)args->tasks,
+			(num_tasks * sizeof(*local_tasks))))
+		return -EFAULT;
+
+	for (i = 0; i < num_tasks; i++) {
+		err = nvdla_get_task_mem(queue, &task);
+		if (err) {
+			nvdla_dbg_err(pdev, "failed to get task[%d] mem", i + 1);
+			goto fail_to_prepare;
+		}
+
+		/* Initialize ref for task submit preparation */
+		kref_init(&task->ref);
+
+		/* a batch is a single job and stays on this instance */
+		err = nvdla_fill_task(priv, priv->queue, priv->buffers,
+				      local_tasks + i, task);
+		if (err) {
+			nvdla_dbg_err(pdev, "failed to fill task[%d]", i + 1);
+			goto fail_to_fill_task;
+		}
+
+		nvdla_dump_task(task);
+
+		err = nvdla_fill_task_desc(task);
+		if (err) {
+			nvdla_dbg_err(pdev, "fail to fill task desc%d", i + 1);
+			goto fail_to_fill_task;
+		}
+
+		tasks[prepared++] = task;
+		task = NULL;
+
+		err = nvdla_get_signal_fences(queue, tasks[i], pending);
+		if (err) {
+			nvdla_dbg_err(pdev, "fail to get fences%d", i + 1);
+			goto fail_to_prepare;
+		}
+
+		/* channel mode jobs increment once per task */
+		if (nvdla_dev->submit_mode == NVDLA_SUBMIT_MODE_CHANNEL)
+			pending += 1;
+		else
+			pending += tasks[i]->fence_counter;
+
+		err = nvdla_update_signal_fences(tasks[i], local_tasks + i);
+		if (err) {
+			nvdla_dbg_err(pdev, "fail update postfence%d", i + 1);
+			goto fail_to_prepare;
+		}
+	}
+
+	err = nvdla_queue_submit_batch(queue, (void **)tasks, num_tasks);
+	if (err)
+		nvdla_dbg_err(pdev, "fail to submit batch: %d", err);
+
+	/* Remove refs corresponding task submit preparation */
+	for (i = 0; i < num_tasks; i++)
+		kref_put(&tasks[i]->ref, task_free);
+
+	nvdla_dbg_fn(pdev, "Batch submitted, done!");
+
+	return err;
+
+fail_to_fill_task:
+	kref_put(&task->ref, task_free);
+fail_to_prepare:
+	/* nothing has reached the engine, drop the whole batch */
+	for (i = 0; i < prepared; i++) {
+		nvdla_unmap_task_memory(tasks[i]);
+		kref_put(&tasks[i]->ref, task_free);
+	}
+
+	return err;
+}
+
 static long nvdla_ioctl(struct file *file, unsigned int cmd,
 			unsigned long arg)
 {
@@ -1194,6 +1598,15 @@ static long nvdla_ioctl(struct file *file, unsigned int cmd,
 	case NVDLA_IOCTL_RELEASE_QUEUE:
 		err = nvdla_queue_release_handler(priv, (void*)buf);
 		break;
+	case NVDLA_IOCTL_SUBMIT_BATCH:
+		err = nvdla_submit_batch(priv, (void *)buf);
+		break;
+	case NVDLA_IOCTL_SET_TASK_TEMPLATE:
+		err = nvdla_set_task_template(priv, (void *)buf);
+		break;
+	case NVDLA_IOCTL_SET_QUEUE_PRIORITY:
+		err = nvdla_set_queue_prio(priv, (void *)buf);
+		break;
 	default:
 		nvdla_dbg_err(pdev, "invalid IOCTL CMD");
 		err = -ENOIOCTLCMD;
@@ -1249,6 +1662,10 @@ static int nvdla_open(struct inode *inode, struct file *file)
 
 	/* Zero out explicitly */
 	priv->queue = NULL;
+	priv->tmpl = NULL;
+	mutex_init(&priv->tmpl_lock);
+	memset(priv->peers, 0, sizeof(priv->peers));
+	mutex_init(&priv->peers_lock);
 
 	/**
 	 * Platform device corresponding to buffers is deferred
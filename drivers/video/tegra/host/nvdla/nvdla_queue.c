@@ -23,7 +23,11 @@
 #include <linux/dma-mapping.h>
 #include <linux/uaccess.h>
 #include <linux/delay.h>
+#include <linux/vmalloc.h>
+#include <linux/math64.h>
+#include <clocksource/arm_arch_timer.h>
 #include <trace/events/nvhost.h>
+#include <uapi/linux/nvhost_events.h>
 
 #include "../drivers/staging/android/sync.h"
 
@@ -43,6 +47,8 @@
 #define NVDLA_QUEUE_ABORT_TIMEOUT	10000	/* 10 sec */
 #define NVDLA_QUEUE_ABORT_RETRY_PERIOD	500	/* 500 ms */
 
+static atomic_t nvdla_template_id = ATOMIC_INIT(0);
+
 /* task management API's */
 static void nvdla_queue_dump_op(struct nvdla_queue *queue, struct seq_file *s)
 {
@@ -112,6 +118,7 @@ int nvdla_get_task_mem(struct nvdla_queue *queue,
 	task->task_desc = task_mem_info.va;
 	task->task_desc_pa = task_mem_info.dma_addr;
 	task->pool_index = task_mem_info.pool_index;
+	task->tmpl = NULL;
 
 	*ptask = task;
 
@@ -122,6 +129,12 @@ fail_to_assign_pool:
 
 void nvdla_put_task_mem(struct nvdla_task *task)
 {
+	/* drop the template before the slot can be handed out again */
+	if (task->tmpl) {
+		nvdla_task_template_put(task->tmpl);
+		task->tmpl = NULL;
+	}
+
 	/* release allocated task desc and task mem */
 	nvdla_queue_free_task_memory(task->queue, task->pool_index);
 
@@ -164,7 +177,7 @@ void nvdla_task_get(struct nvdla_task *task)
 	kref_get(&task->ref);
 }
 
-static int nvdla_unmap_task_memory(struct nvdla_task *task)
+int nvdla_unmap_task_memory(struct nvdla_task *task)
 {
 	int ii;
 	struct nvdla_queue *queue = task->queue;
@@ -260,6 +273,8 @@ static void nvdla_task_free_locked(struct nvdla_task *task)
 {
 	struct nvdla_queue *queue = task->queue;
 	struct platform_device *pdev = queue->pool->pdev;
+	struct nvhost_device_data *pdata = platform_get_drvdata(pdev);
+	struct nvdla_device *nvdla_dev = pdata->private_data;
 
 	nvdla_dbg_info(pdev,
 		"task[%p] completed. syncpt[%d] fence[%d]",
@@ -270,6 +285,12 @@ static void nvdla_task_free_locked(struct nvdla_task *task)
 
 	/* update takslist */
 	list_del(&task->list);
+	atomic_dec(&nvdla_dev->outstanding);
+
+	/* resume the queues preempted for the last task of its priority */
+	if (atomic_dec_and_test(&nvdla_dev->prio_outstanding[task->priority]) &&
+	    task->priority > NVDLA_QUEUE_PRIORITY_LOW)
+		schedule_work(&nvdla_dev->prio_work);
 
 	/* give taks refs */
 	nvdla_task_put(task);
@@ -332,12 +353,79 @@ static inline size_t nvdla_profile_status_offset(struct nvdla_task *task)
 	return offset;
 }
 
+/*
+ * Falcon only reports start/end time of a task, so the engine cycle count
+ * is derived from the duration and the current engine clock, and the DMA
+ * traffic is not known.
+ */
+static void nvdla_queue_log_task_perf(struct platform_device *pdev,
+				      struct nvdla_queue *queue,
+				      struct nvdla_task *task,
+				      u64 timestamp_start,
+				      u64 timestamp_end,
+				      u32 duration_us)
+{
+	struct nvhost_task_perf perf;
+	unsigned long rate = 0;
+
+	memset(&perf, 0, sizeof(perf));
+
+	perf.syncpt_id = queue->syncpt_id;
+	perf.syncpt_thresh = task->fence;
+	perf.submit_time = task->submit_ts;
+	perf.start_time = timestamp_start;
+	perf.end_time = timestamp_end;
+	if (task->submit_ts && timestamp_start > task->submit_ts)
+		perf.queue_wait = timestamp_start - task->submit_ts;
+
+	if (!nvhost_module_get_rate(pdev, &rate, 0))
+		perf.engine_cycles = div_u64((u64)duration_us * rate,
+					     USEC_PER_SEC);
+
+	nvhost_eventlib_log_task_perf(pdev, &perf, timestamp_end);
+}
+
+/*
+ * Task timestamps are in TSC ticks, the latency is accounted from the
+ * submission of the task, so it includes the time the task was kept
+ * waiting by tasks of other queues.
+ */
+static void nvdla_queue_prio_account(struct nvdla_device *nvdla_dev,
+				     struct nvdla_task *task,
+				     u64 timestamp_start,
+				     u64 timestamp_end)
+{
+	struct nvdla_prio_stats *stats = &nvdla_dev->prio_stats[task->priority];
+	u32 rate = arch_timer_get_rate();
+	u64 wait_us = 0, latency_us = 0;
+
+	if (!task->submit_ts || !rate)
+		return;
+
+	if (timestamp_start > task->submit_ts)
+		wait_us = div_u64((timestamp_start - task->submit_ts) *
+				  USEC_PER_SEC, rate);
+	if (timestamp_end > task->submit_ts)
+		latency_us = div_u64((timestamp_end - task->submit_ts) *
+				     USEC_PER_SEC, rate);
+
+	spin_lock(&nvdla_dev->prio_stats_lock);
+	stats->tasks++;
+	stats->wait_us += wait_us;
+	stats->wait_max_us = max(stats->wait_max_us, wait_us);
+	stats->latency_us += latency_us;
+	stats->latency_max_us = max(stats->latency_max_us, latency_us);
+	spin_unlock(&nvdla_dev->prio_stats_lock);
+}
+
 static void nvdla_queue_update(void *priv, int nr_completed)
 {
 	int task_complete;
 	struct nvdla_task *task, *safe;
 	struct nvdla_queue *queue = priv;
 	struct platform_device *pdev = queue->pool->pdev;
+	struct nvhost_device_data *pdata = platform_get_drvdata(pdev);
+	struct nvdla_device *nvdla_dev = pdata->private_data;
 	struct nvhost_notification *tsp_notifier;
 	u64 timestamp_start, timestamp_end;
 	u64 *timestamp_ptr;
@@ -371,6 +459,14 @@ static void nvdla_queue_update(void *priv, int nr_completed)
 				timestamp_start,
 				timestamp_end);
 
+			nvdla_queue_log_task_perf(pdev, queue, task,
+				timestamp_start, timestamp_end,
+				tsp_notifier->info32);
+			nvdla_group_task_done(nvdla_dev,
+					      tsp_notifier->info32);
+			nvdla_queue_prio_account(nvdla_dev, task,
+				timestamp_start, timestamp_end);
+
 			/* Record task postfences */
 			nvhost_eventlib_log_fences(pdev,
 				queue->syncpt_id,
@@ -494,12 +590,92 @@ static u8 *add_gos_action(u8 *mem, uint8_t op, uint8_t index, uint16_t offset,
 	return mem + sizeof(struct dla_action_gos);
 }
 
+static int nvdla_pin_task_address(struct nvdla_task *task, int jj,
+				   u64 *addr)
+{
+	int err;
+	dma_addr_t dma_addr;
+	size_t dma_size;
+	struct platform_device *pdev = task->queue->pool->pdev;
+
+	nvdla_dbg_info(pdev, "count[%d] handle[%u] offset[%u]",
+			jj,
+			task->memory_handles[jj].handle,
+			task->memory_handles[jj].offset);
+
+	if (!task->memory_handles[jj].handle)
+		return -EFAULT;
+
+	task->memory_dmabuf[jj] =
+		dma_buf_get(task->memory_handles[jj].handle);
+	if (IS_ERR_OR_NULL(task->memory_dmabuf[jj])) {
+		task->memory_dmabuf[jj] = NULL;
+		nvdla_dbg_err(pdev, "fail to get buf");
+		return -EFAULT;
+	}
+
+	err = nvdla_buffer_submit_pin(task->buffers,
+			&task->memory_dmabuf[jj],
+			1, &dma_addr, &dma_size, NULL);
+	if (err) {
+		nvdla_dbg_err(pdev, "fail to pin address list");
+		return err;
+	}
+
+	*addr = dma_addr + task->memory_handles[jj].offset;
+
+	return 0;
+}
+
+/*
+ * Address list of a template based task. The descriptor memory of a pool
+ * slot outlives the task, so when the slot already holds the list of the
+ * same template only the entries overridden by its previous task have to be
+ * restored before applying the overrides of this one.
+ */
+static int nvdla_map_task_template(struct nvdla_task *task,
+				   struct dla_mem_addr *list)
+{
+	int jj;
+	int err;
+	u32 index;
+	u64 addr;
+	struct nvdla_task_template *tmpl = task->tmpl;
+
+	if (task->desc_tmpl_id == tmpl->id) {
+		for (jj = 0; jj < task->desc_num_patches; jj++) {
+			index = task->desc_patch_index[jj];
+			list[index].val = tmpl->addresses[index];
+		}
+	} else {
+		memcpy(list, tmpl->addresses,
+		       tmpl->num_addresses * sizeof(struct dla_mem_addr));
+	}
+
+	/* slot content is unknown until all overrides are applied */
+	task->desc_tmpl_id = 0;
+
+	for (jj = 0; jj < task->num_addresses; jj++) {
+		err = nvdla_pin_task_address(task, jj, &addr);
+		if (err)
+			return err;
+
+		list[task->patch_index[jj]].val = addr;
+	}
+
+	memcpy(task->desc_patch_index, task->patch_index,
+	       task->num_addresses * sizeof(u32));
+	task->desc_num_patches = task->num_addresses;
+	task->desc_tmpl_id = tmpl->id;
+
+	return 0;
+}
+
 static int nvdla_map_task_memory(struct nvdla_task *task)
 {
 	int jj;
 	int err = 0;
 	size_t offset;
-	struct nvdla_buffers *buffers = task->buffers;
 	struct platform_device *pdev = task->queue->pool->pdev;
 	struct dla_task_descriptor *task_desc = task->task_desc;
 	u8 *next;
@@ -518,44 +694,110 @@ static int nvdla_map_task_memory(struct nvdla_task *task)
 
 	/* send address lists task desc dma to engine */
 	task_desc->address_list = (uint64_t)((u8 *)task->task_desc_pa + offset);
+
+	if (task->tmpl) {
+		task_desc->num_addresses = task->tmpl->num_addresses;
+		return nvdla_map_task_template(task,
+				(struct dla_mem_addr *)next);
+	}
+
 	task_desc->num_addresses = task->num_addresses;
+	task->desc_tmpl_id = 0;
 
 	/* update address list with all dma */
 	for (jj = 0; jj < task->num_addresses; jj++) {
-		dma_addr_t dma_addr;
-		size_t dma_size;
-		err = -EFAULT;
+		u64 addr;
 
-		nvdla_dbg_info(pdev, "count[%d] handle[%u] offset[%u]",
-				jj,
-				task->memory_handles[jj].handle,
-				task->memory_handles[jj].offset);
-
-		if (!task->memory_handles[jj].handle)
+		err = nvdla_pin_task_address(task, jj, &addr);
+		if (err)
 			goto fail_to_pin_mem;
 
-		task->memory_dmabuf[jj] =
-			dma_buf_get(task->memory_handles[jj].handle);
-		if (IS_ERR_OR_NULL(task->memory_dmabuf[jj])) {
-			task->memory_dmabuf[jj] = NULL;
+		next = add_address(next, addr);
+	}
+
+fail_to_pin_mem:
+	return err;
+}
+
+static void nvdla_task_template_free(struct kref *ref)
+{
+	struct nvdla_task_template *tmpl =
+		container_of(ref, struct nvdla_task_template, ref);
+	u32 i;
+
+	for (i = 0; i < tmpl->num_addresses; i++) {
+		nvdla_buffer_submit_unpin(tmpl->buffers, &tmpl->dmabufs[i], 1);
+		dma_buf_put(tmpl->dmabufs[i]);
+	}
+
+	vfree(tmpl);
+}
+
+struct nvdla_task_template *nvdla_task_template_create(
+			struct nvdla_buffers *buffers,
+			struct nvdla_mem_handle *handles,
+			u32 num_addresses)
+{
+	struct nvdla_task_template *tmpl;
+	dma_addr_t dma_addr;
+	size_t dma_size;
+	int err = 0;
+	u32 i;
+
+	tmpl = vzalloc(sizeof(*tmpl) + num_addresses *
+		       (sizeof(u64) + sizeof(struct dma_buf *)));
+	if (!tmpl)
+		return ERR_PTR(-ENOMEM);
+
+	tmpl->addresses = (u64 *)(tmpl + 1);
+	tmpl->dmabufs = (struct dma_buf **)(tmpl->addresses + num_addresses);
+	tmpl->buffers = buffers;
+	kref_init(&tmpl->ref);
+
+	do {
+		tmpl->id = atomic_inc_return(&nvdla_template_id);
+	} while (!tmpl->id);
+
+	for (i = 0; i < num_addresses; i++) {
+		if (!handles[i].handle) {
 			err = -EFAULT;
-			nvdla_dbg_err(pdev, "fail to get buf");
-			goto fail_to_pin_mem;
+			goto fail_to_pin;
 		}
 
-		err = nvdla_buffer_submit_pin(buffers,
-				&task->memory_dmabuf[jj],
-				1, &dma_addr, &dma_size, NULL);
+		tmpl->dmabufs[i] = dma_buf_get(handles[i].handle);
+		if (IS_ERR_OR_NULL(tmpl->dmabufs[i])) {
+			err = -EFAULT;
+			goto fail_to_pin;
+		}
+
+		err = nvdla_buffer_submit_pin(buffers, &tmpl->dmabufs[i], 1,
+					      &dma_addr, &dma_size, NULL);
 		if (err) {
-			nvdla_dbg_err(pdev, "fail to pin address list");
-			goto fail_to_pin_mem;
+			dma_buf_put(tmpl->dmabufs[i]);
+			goto fail_to_pin;
 		}
-		next = add_address(next,
-			dma_addr + task->memory_handles[jj].offset);
+
+		tmpl->addresses[i] = dma_addr + handles[i].offset;
 	}
+	tmpl->num_addresses = num_addresses;
 
-fail_to_pin_mem:
-	return err;
+	return tmpl;
+
+fail_to_pin:
+	/* only release the entries pinned so far */
+	tmpl->num_addresses = i;
+	nvdla_task_template_free(&tmpl->ref);
+	return ERR_PTR(err);
+}
+
+void nvdla_task_template_get(struct nvdla_task_template *tmpl)
+{
+	kref_get(&tmpl->ref);
+}
+
+void nvdla_task_template_put(struct nvdla_task_template *tmpl)
+{
+	kref_put(&tmpl->ref, nvdla_task_template_free);
 }
 
 static int nvdla_update_gos(struct platform_device *pdev)
@@ -1449,7 +1691,8 @@ int nvdla_emulator_submit(struct nvdla_queue *queue, struct nvdla_emu_task *task
 	return 0;
 }
 
-int nvdla_get_signal_fences(struct nvdla_queue *queue, void *in_task)
+int nvdla_get_signal_fences(struct nvdla_queue *queue, void *in_task,
+			u32 pending_incrs)
 {
 	struct nvdla_task *task = (struct nvdla_task *)in_task;
 	struct platform_device *pdev = queue->pool->pdev;
@@ -1462,7 +1705,7 @@ int nvdla_get_signal_fences(struct nvdla_queue *queue, void *in_task)
 		task->fence_counter = 1;
 
 	task_fence = nvhost_syncpt_read_maxval(pdev, queue->syncpt_id) +
-			task->fence_counter;
+			pending_incrs + task->fence_counter;
 
 	/* Update fences signal updates for both prefence and postfence */
 	counter = task->fence_counter - 1;
@@ -1506,6 +1749,223 @@ int nvdla_get_signal_fences(struct nvdla_queue *queue, void *in_task)
 	return 0;
 }
 
+/*
+ * Queue priorities
+ *
+ * The falcon runs the tasks of a queue in order and only switches between
+ * queues at task boundaries. A task overtakes the tasks already queued by
+ * lower priority queues by suspending those queues before it is submitted:
+ * the firmware completes the running task and then ignores the suspended
+ * queues until they are resumed, once no task of a higher priority is
+ * outstanding. The queues a task waits on through its prefences are pinned
+ * and never suspended, a task with a prefence whose producer can't be known
+ * doesn't preempt at all.
+ */
+static bool nvdla_queue_prio_preempted(struct nvdla_device *nvdla_dev,
+				       u32 priority)
+{
+	u32 i;
+
+	for (i = priority + 1; i < NVDLA_QUEUE_PRIORITY_NUM; i++)
+		if (atomic_read(&nvdla_dev->prio_outstanding[i]))
+			return true;
+
+	return false;
+}
+
+static void nvdla_queue_prio_pin_syncpt(struct nvdla_device *nvdla_dev,
+					u32 syncpt_id)
+{
+	struct nvdla_queue_pool *pool = nvdla_dev->pool;
+	u32 i;
+
+	for (i = 0; i < pool->max_queue_cnt; i++)
+		if (pool->queues[i].syncpt_id == syncpt_id)
+			set_bit(i, &nvdla_dev->prio_pinned);
+}
+
+/* returns false if not all queues the task waits on are known */
+static bool nvdla_queue_prio_pin(struct nvdla_device *nvdla_dev,
+				 struct nvdla_task *task)
+{
+	struct nvdev_fence *fence;
+	struct sync_fence *f;
+	struct sync_pt *pt;
+	u32 i, j;
+
+	for (i = 0; i < task->num_prefences; i++) {
+		fence = &task->prefences[i];
+
+		switch (fence->type) {
+		case NVDEV_FENCE_TYPE_SYNCPT:
+			nvdla_queue_prio_pin_syncpt(nvdla_dev,
+					fence->syncpoint_index);
+			break;
+		case NVDEV_FENCE_TYPE_SYNC_FD:
+			f = nvhost_sync_fdget(fence->sync_fd);
+			if (!f)
+				return false;
+
+			for (j = 0; j < f->num_fences; j++) {
+				pt = sync_pt_from_fence(f->cbs[j].sync_pt);
+				nvdla_queue_prio_pin_syncpt(nvdla_dev,
+						nvhost_sync_pt_id(pt));
+			}
+			sync_fence_put(f);
+			break;
+		default:
+			return false;
+		}
+	}
+
+	return true;
+}
+
+static int nvdla_queue_send_state(struct nvdla_queue *queue, int cmd)
+{
+	struct platform_device *pdev = queue->pool->pdev;
+	struct nvdla_cmd_data cmd_data;
+	int err;
+
+	/* get pm refcount */
+	err = nvhost_module_busy(pdev);
+	if (err) {
+		nvdla_dbg_err(pdev, "failed to poweron, err: %d", err);
+		goto fail_to_poweron;
+	}
+
+	/* prepare command */
+	cmd_data.method_id = cmd;
+	cmd_data.method_data = queue->id;
+	cmd_data.wait = true;
+
+	err = nvdla_send_cmd(pdev, &cmd_data);
+	if (err) {
+		nvdla_dbg_err(pdev, "failed to suspend queue %d", err);
+		goto fail_to_suspend;
+	}
+
+fail_to_suspend:
+	nvhost_module_idle(pdev);
+fail_to_poweron:
+	return err;
+}
+
+static void nvdla_queue_prio_suspend(struct nvdla_device *nvdla_dev,
+				     struct nvdla_queue *queue)
+{
+	if (queue->suspended || queue->prio_suspended ||
+	    test_bit(queue->id, &nvdla_dev->prio_pinned))
+		return;
+
+	if (nvdla_queue_send_state(queue, DLA_CMD_QUEUE_SUSPEND))
+		return;
+
+	queue->prio_suspended = true;
+
+	spin_lock(&nvdla_dev->prio_stats_lock);
+	nvdla_dev->prio_stats[queue->priority].preemptions++;
+	spin_unlock(&nvdla_dev->prio_stats_lock);
+}
+
+/*
+ * Called with the list lock of the queue held, after the tasks were
+ * accounted in prio_outstanding and before they are sent to the engine.
+ */
+static void nvdla_queue_prio_submit(struct nvdla_queue *queue,
+				    struct nvdla_task **tasks, u32 num_tasks)
+{
+	struct nvdla_queue_pool *pool = queue->pool;
+	struct nvhost_device_data *pdata = platform_get_drvdata(pool->pdev);
+	struct nvdla_device *nvdla_dev = pdata->private_data;
+	struct nvdla_queue *other;
+	bool preempt = queue->priority > NVDLA_QUEUE_PRIORITY_LOW;
+	u32 i;
+
+	mutex_lock(&nvdla_dev->prio_lock);
+
+	for (i = 0; preempt && i < num_tasks; i++)
+		preempt = nvdla_queue_prio_pin(nvdla_dev, tasks[i]);
+
+	/* new tasks of a lower priority queue wait as well */
+	if (nvdla_queue_prio_preempted(nvdla_dev, queue->priority))
+		nvdla_queue_prio_suspend(nvdla_dev, queue);
+
+	if (!preempt)
+		goto out;
+
+	for (i = 0; i < pool->max_queue_cnt; i++) {
+		other = &pool->queues[i];
+
+		if (other == queue || !test_bit(i, &pool->alloc_table) ||
+		    other->priority >= queue->priority ||
+		    list_empty(&other->tasklist))
+			continue;
+
+		nvdla_queue_prio_suspend(nvdla_dev, other);
+	}
+
+out:
+	mutex_unlock(&nvdla_dev->prio_lock);
+}
+
+static void nvdla_queue_prio_resume(struct work_struct *work)
+{
+	struct nvdla_device *nvdla_dev = container_of(work,
+					struct nvdla_device, prio_work);
+	struct nvdla_queue_pool *pool = nvdla_dev->pool;
+	struct nvdla_queue *queue;
+	u32 i;
+
+	mutex_lock(&nvdla_dev->prio_lock);
+
+	if (!nvdla_queue_prio_preempted(nvdla_dev, NVDLA_QUEUE_PRIORITY_LOW))
+		nvdla_dev->prio_pinned = 0;
+
+	for (i = 0; i < pool->max_queue_cnt; i++) {
+		queue = &pool->queues[i];
+
+		if (!queue->prio_suspended ||
+		    nvdla_queue_prio_preempted(nvdla_dev, queue->priority))
+			continue;
+
+		/* a queue suspended by its user stays suspended */
+		if (!queue->suspended &&
+		    nvdla_queue_send_state(queue, DLA_CMD_QUEUE_RESUME))
+			continue;
+
+		queue->prio_suspended = false;
+	}
+
+	mutex_unlock(&nvdla_dev->prio_lock);
+}
+
+void nvdla_queue_prio_init(struct nvdla_device *nvdla_dev)
+{
+	mutex_init(&nvdla_dev->prio_lock);
+	spin_lock_init(&nvdla_dev->prio_stats_lock);
+	INIT_WORK(&nvdla_dev->prio_work, nvdla_queue_prio_resume);
+}
+
+int nvdla_set_queue_priority(struct nvdla_queue *queue, u32 priority)
+{
+	struct nvhost_device_data *pdata =
+			platform_get_drvdata(queue->pool->pdev);
+	struct nvdla_device *nvdla_dev = pdata->private_data;
+
+	if (priority >= NVDLA_QUEUE_PRIORITY_NUM)
+		return -EINVAL;
+
+	mutex_lock(&nvdla_dev->prio_lock);
+	queue->priority = priority;
+	mutex_unlock(&nvdla_dev->prio_lock);
+
+	/* the queue may no longer have to wait */
+	schedule_work(&nvdla_dev->prio_work);
+
+	return 0;
+}
+
 /* Queue management API */
 static int nvdla_queue_submit_op(struct nvdla_queue *queue, void *in_task)
 {
@@ -1544,6 +2004,9 @@ static int nvdla_queue_submit_op(struct nvdla_queue *queue, void *in_task)
 				last_task, task->task_desc_pa);
 	}
 	list_add_tail(&task->list, &queue->tasklist);
+	atomic_inc(&nvdla_dev->outstanding);
+	task->priority = queue->priority;
+	atomic_inc(&nvdla_dev->prio_outstanding[task->priority]);
 
 	nvdla_dbg_info(pdev, "task[%p] added to list", task);
 
@@ -1557,13 +2020,17 @@ static int nvdla_queue_submit_op(struct nvdla_queue *queue, void *in_task)
 			(1 << DLA_INT_ON_ERROR_SHIFT);
 	method_data = ALIGNED_DMA(task->task_desc_pa);
 
-	/* Report timestamp in TSC ticks. */
-	timestamp = arch_counter_get_cntvct();
-
 	/* get pm refcount */
 	if (nvhost_module_busy(pdev))
 		goto fail_to_poweron;
 
+	/* let the task overtake the queued tasks of lower priority */
+	nvdla_queue_prio_submit(queue, &task, 1);
+
+	/* Report timestamp in TSC ticks. */
+	timestamp = arch_counter_get_cntvct();
+	task->submit_ts = timestamp;
+
 	/* prepare command for channel submit */
 	if (nvdla_dev->submit_mode == NVDLA_SUBMIT_MODE_CHANNEL) {
 
@@ -1631,11 +2098,196 @@ fail_to_poweron:
 	return err;
 }
 
+/*
+ * Channel mode batch: all tasks go out in a single host1x job carrying one
+ * SUBMIT_TASK method per task, so the whole batch costs one gather, one
+ * doorbell and one command acknowledgment. Only the last method asks the
+ * falcon for the completion interrupt.
+ */
+static int nvdla_queue_submit_batch_channel(struct nvdla_queue *queue,
+					    struct nvdla_task **tasks,
+					    u32 num_tasks)
+{
+	struct platform_device *pdev = queue->pool->pdev;
+	struct nvhost_device_data *pdata = platform_get_drvdata(pdev);
+	struct nvdla_device *nvdla_dev = pdata->private_data;
+	struct nvdla_task *last_task = NULL;
+	struct nvdla_task *task;
+	u32 *syncpt_wait_ids = NULL;
+	u32 *syncpt_wait_thresh;
+	u32 *cmdbuf;
+	u32 num_waits = 0, num_words = 0;
+	u32 batch_fence;
+	unsigned long timeout;
+	u64 timestamp;
+	int err = 0, busy = 0;
+	u32 i, j;
+
+	nvdla_dbg_fn(pdev, "num_tasks[%u]", num_tasks);
+
+	cmdbuf = kcalloc(3 * num_tasks + 2 * num_tasks *
+			 MAX_NUM_NVDLA_PREFENCES, sizeof(u32), GFP_KERNEL);
+	if (!cmdbuf)
+		return -ENOMEM;
+
+	syncpt_wait_ids = cmdbuf + 3 * num_tasks;
+	syncpt_wait_thresh = syncpt_wait_ids +
+			num_tasks * MAX_NUM_NVDLA_PREFENCES;
+
+	mutex_lock(&queue->list_lock);
+
+	for (i = 0; i < num_tasks; i++) {
+		uint32_t method_id = DLA_CMD_SUBMIT_TASK &
+					DLA_METHOD_ID_CMD_MASK;
+
+		task = tasks[i];
+
+		/* Get a reference before registration or submission */
+		nvdla_task_get(task);
+
+		/* link the task into the firmware queue */
+		if (!list_empty(&queue->tasklist)) {
+			last_task = list_last_entry(&queue->tasklist,
+						struct nvdla_task, list);
+			last_task->task_desc->next =
+					(uint64_t)task->task_desc_pa;
+		}
+		list_add_tail(&task->list, &queue->tasklist);
+		atomic_inc(&nvdla_dev->outstanding);
+		task->priority = queue->priority;
+		atomic_inc(&nvdla_dev->prio_outstanding[task->priority]);
+
+		for (j = 0; j < task->num_prefences; j++) {
+			if (task->prefences[j].type !=
+					NVDEV_FENCE_TYPE_SYNCPT) {
+				nvdla_dbg_err(pdev, "syncpt only supported");
+				err = -EINVAL;
+				goto fail_to_prepare;
+			}
+
+			syncpt_wait_ids[num_waits] =
+				task->prefences[j].syncpoint_index;
+			syncpt_wait_thresh[num_waits] =
+				task->prefences[j].syncpoint_value;
+			num_waits++;
+		}
+
+		if (i == num_tasks - 1)
+			method_id |= (1 << DLA_INT_ON_COMPLETE_SHIFT) |
+					(1 << DLA_INT_ON_ERROR_SHIFT);
+
+		cmdbuf[num_words++] =
+			nvhost_opcode_incr(NV_DLA_THI_METHOD_ID >> 2, 2);
+		cmdbuf[num_words++] = method_id;
+		cmdbuf[num_words++] = ALIGNED_DMA(task->task_desc_pa);
+	}
+
+	/* one pm reference per task, dropped as each task completes */
+	for (busy = 0; busy < num_tasks; busy++) {
+		err = nvhost_module_busy(pdev);
+		if (err)
+			goto fail_to_poweron;
+	}
+
+	nvdla_queue_prio_submit(queue, tasks, num_tasks);
+
+	/* Report timestamp in TSC ticks. */
+	timestamp = arch_counter_get_cntvct();
+
+	nvdla_dev->waiting = 1;
+
+	err = nvdla_queue_submit_to_host1x(queue, cmdbuf, num_words,
+					    num_tasks, syncpt_wait_ids,
+					    syncpt_wait_thresh, num_waits,
+					    &batch_fence);
+	if (err) {
+		nvdla_dbg_err(pdev, "channel batch submit failed");
+		nvdla_dev->waiting = 0;
+		goto fail_to_poweron;
+	}
+
+	/* every task completes one increment of the job */
+	for (i = 0; i < num_tasks; i++) {
+		task = tasks[i];
+		task->fence = batch_fence - (num_tasks - 1 - i);
+		task->submit_ts = timestamp;
+
+		if (nvhost_intr_register_notifier(pdev, queue->syncpt_id,
+				task->fence, nvdla_queue_update, queue)) {
+			/*
+			 * The job is already on the channel; the tasks are
+			 * reaped by the notifier of a later task or by abort.
+			 */
+			nvdla_dbg_err(pdev, "task[%p] notifier failed", task);
+			continue;
+		}
+
+		nvhost_eventlib_log_submit(pdev, queue->syncpt_id,
+					   task->fence, timestamp);
+		nvhost_eventlib_log_fences(pdev, queue->syncpt_id,
+					   task->fence, task->prefences,
+					   task->num_prefences,
+					   NVDEV_FENCE_KIND_PRE, timestamp);
+	}
+
+	timeout = msecs_to_jiffies(CMD_TIMEOUT_MSEC);
+	if (!wait_for_completion_timeout(&nvdla_dev->cmd_completion, timeout))
+		nvdla_dbg_err(pdev, "channel mode batch submit timedout");
+	nvdla_dev->waiting = 0;
+
+	mutex_unlock(&queue->list_lock);
+	kfree(cmdbuf);
+
+	return 0;
+
+fail_to_poweron:
+	while (busy--)
+		nvhost_module_idle(pdev);
+	i = num_tasks;
+fail_to_prepare:
+	/* drop every task linked so far, including the failing one */
+	for (j = 0; j <= i && j < num_tasks; j++)
+		nvdla_task_free_locked(tasks[j]);
+	mutex_unlock(&queue->list_lock);
+	kfree(cmdbuf);
+
+	return err;
+}
+
+static int nvdla_queue_submit_batch_op(struct nvdla_queue *queue,
+				       void **in_tasks, u32 num_tasks)
+{
+	struct nvdla_task **tasks = (struct nvdla_task **)in_tasks;
+	struct platform_device *pdev = queue->pool->pdev;
+	struct nvhost_device_data *pdata = platform_get_drvdata(pdev);
+	struct nvdla_device *nvdla_dev = pdata->private_data;
+	int err = 0;
+	u32 i;
+
+	if (num_tasks > 1 &&
+	    nvdla_dev->submit_mode == NVDLA_SUBMIT_MODE_CHANNEL)
+		return nvdla_queue_submit_batch_channel(queue, tasks,
+							num_tasks);
+
+	/*
+	 * In MMIO mode every SUBMIT_TASK method is a separate handshake with
+	 * the falcon, so tasks still go out one by one.
+	 */
+	for (i = 0; i < num_tasks; i++) {
+		err = nvdla_queue_submit_op(queue, tasks[i]);
+		if (err)
+			break;
+	}
+
+	return err;
+}
+
 int nvdla_set_queue_state(struct nvdla_queue *queue, int cmd)
 {
 	struct platform_device *pdev = queue->pool->pdev;
-	struct nvdla_cmd_data cmd_data;
-	int err;
+	struct nvhost_device_data *pdata = platform_get_drvdata(pdev);
+	struct nvdla_device *nvdla_dev = pdata->private_data;
+	int err = 0;
 
 	nvdla_dbg_fn(pdev, "");
 
@@ -1645,27 +2297,20 @@ int nvdla_set_queue_state(struct nvdla_queue *queue, int cmd)
 		return -EINVAL;
 	}
 
-	/* get pm refcount */
-	err = nvhost_module_busy(pdev);
-	if (err) {
-		nvdla_dbg_err(pdev, "failed to poweron, err: %d", err);
-		goto fail_to_poweron;
-	}
+	mutex_lock(&nvdla_dev->prio_lock);
 
-	/* prepare command */
-	cmd_data.method_id = cmd;
-	cmd_data.method_data = queue->id;
-	cmd_data.wait = true;
+	/*
+	 * A queue preempted by a higher priority task is already suspended
+	 * in firmware and resumed by the priority work, only record the
+	 * state the user asked for.
+	 */
+	if (!queue->prio_suspended)
+		err = nvdla_queue_send_state(queue, cmd);
+	if (!err)
+		queue->suspended = (cmd == DLA_CMD_QUEUE_SUSPEND);
 
-	err = nvdla_send_cmd(pdev, &cmd_data);
-	if (err) {
-		nvdla_dbg_err(pdev, "failed to suspend queue %d", err);
-		goto fail_to_suspend;
-	}
+	mutex_unlock(&nvdla_dev->prio_lock);
 
-fail_to_suspend:
-	nvhost_module_idle(pdev);
-fail_to_poweron:
 	return err;
 }
 
@@ -1738,6 +2383,7 @@ list_empty:
 struct nvdla_queue_ops nvdla_queue_ops = {
 	.abort = nvdla_queue_abort_op,
 	.submit = nvdla_queue_submit_op,
+	.submit_batch = nvdla_queue_submit_batch_op,
 	.get_task_size =  nvdla_get_task_desc_memsize_op,
 	.dump = nvdla_queue_dump_op,
 };
@@ -39,6 +39,9 @@
 #include <linux/clk-provider.h>
 #include <linux/dma-mapping.h>
 #include <linux/nospec.h>
+#include <linux/sort.h>
+#include <linux/ktime.h>
+#include <linux/math64.h>
 
 #include <linux/platform/tegra/mc.h>
 #if defined(CONFIG_TEGRA_BWMGR)
@@ -159,6 +162,65 @@ void nvhost_module_reset(struct platform_device *dev, bool reboot)
 }
 EXPORT_SYMBOL(nvhost_module_reset);
 
+static int nvhost_idle_gap_cmp(const void *a, const void *b)
+{
+	u32 x = *(const u32 *)a, y = *(const u32 *)b;
+
+	return x < y ? -1 : x > y;
+}
+
+/*
+ * Called on the first busy after the engine went idle. Returns the
+ * autosuspend delay to use from now on, or -1 to keep the current one.
+ */
+static int nvhost_module_learn_idle_gap(struct nvhost_device_data *pdata)
+{
+	u32 gaps[NVHOST_IDLE_GAPS];
+	unsigned int n;
+	unsigned long flags;
+	int delay;
+	u32 p75;
+
+	if (!pdata->autosuspend_delay)
+		return -1;
+
+	spin_lock_irqsave(&pdata->idle_gap_lock, flags);
+	if (!pdata->autosuspend_breakeven || !pdata->idle_since_ns) {
+		spin_unlock_irqrestore(&pdata->idle_gap_lock, flags);
+		/* back to the platform delay once adaptation is disabled */
+		return pdata->autosuspend_breakeven ? -1 :
+			pdata->autosuspend_delay;
+	}
+
+	pdata->idle_gaps[pdata->idle_gap_count++ % NVHOST_IDLE_GAPS] =
+		min_t(u64, div_u64(ktime_get_ns() - pdata->idle_since_ns,
+				   NSEC_PER_MSEC), U32_MAX);
+	pdata->idle_since_ns = 0;
+
+	n = min_t(unsigned int, pdata->idle_gap_count, NVHOST_IDLE_GAPS);
+	memcpy(gaps, pdata->idle_gaps, n * sizeof(gaps[0]));
+	spin_unlock_irqrestore(&pdata->idle_gap_lock, flags);
+
+	/* not enough history yet */
+	if (n < NVHOST_IDLE_GAPS / 2)
+		return -1;
+
+	sort(gaps, n, sizeof(gaps[0]), nvhost_idle_gap_cmp, NULL);
+	p75 = gaps[(n * 3) / 4];
+
+	/*
+	 * Powering down pays off only for gaps above the break-even time. If
+	 * three quarters of the recent gaps are below it, stay up for them
+	 * with some margin, otherwise power down as the platform asks.
+	 */
+	delay = pdata->autosuspend_delay;
+	if (p75 < pdata->autosuspend_breakeven)
+		delay = clamp_t(int, p75 + p75 / 4 + 1, pdata->autosuspend_delay,
+				pdata->autosuspend_breakeven);
+
+	return delay;
+}
+
 void nvhost_module_busy_noresume(struct platform_device *dev)
 {
 	if (dev->dev.parent && (dev->dev.parent != &platform_bus))
@@ -170,6 +232,7 @@ void nvhost_module_busy_noresume(struct platform_device *dev)
 int nvhost_module_busy(struct platform_device *dev)
 {
 	struct nvhost_device_data *pdata = platform_get_drvdata(dev);
+	int delay;
 	int ret = 0;
 
 	/* Explicitly turn on the host1x clocks
@@ -193,6 +256,8 @@ int nvhost_module_busy(struct platform_device *dev)
 
 	down_read(&pdata->busy_lock);
 
+	delay = nvhost_module_learn_idle_gap(pdata);
+
 	ret = pm_runtime_get_sync(&dev->dev);
 	if (ret < 0) {
 		pm_runtime_put_noidle(&dev->dev);
@@ -203,9 +268,17 @@ int nvhost_module_busy(struct platform_device *dev)
 		return ret;
 	}
 
+	/* set while busy, so that it cannot suspend the device right away */
+	if (delay >= 0 && delay != pdata->autosuspend_cur) {
+		pdata->autosuspend_cur = delay;
+		pm_runtime_set_autosuspend_delay(&dev->dev, delay);
+	}
+
 	if (pdata->busy)
 		pdata->busy(dev);
 
+	nvhost_scale_predict_busy(dev);
+
 	up_read(&pdata->busy_lock);
 
 	return 0;
@@ -226,8 +299,15 @@ void nvhost_module_idle_mult(struct platform_device *dev, int refs)
 	/* call idle callback only if the device is turned on. */
 	if (atomic_read(&dev->dev.power.usage_count) == refs &&
 	    pm_runtime_active(&dev->dev)) {
+		unsigned long flags;
+
 		if (pdata->idle)
 			pdata->idle(dev);
+		nvhost_scale_predict_idle(dev);
+
+		spin_lock_irqsave(&pdata->idle_gap_lock, flags);
+		pdata->idle_since_ns = ktime_get_ns();
+		spin_unlock_irqrestore(&pdata->idle_gap_lock, flags);
 	}
 
 	while (refs--) {
@@ -574,6 +654,7 @@ static ssize_t autosuspend_delay_store(struct kobject *kobj,
 	if (ret == 1 && autosuspend_delay >= 0) {
 		mutex_lock(&pdata->lock);
 		pdata->autosuspend_delay = autosuspend_delay;
+		pdata->autosuspend_cur = autosuspend_delay;
 		mutex_unlock(&pdata->lock);
 
 		pm_runtime_set_autosuspend_delay(&dev->dev,
@@ -602,6 +683,59 @@ static ssize_t autosuspend_delay_show(struct kobject *kobj,
 	return ret;
 }
 
+static ssize_t autosuspend_breakeven_store(struct kobject *kobj,
+	struct kobj_attribute *attr, const char *buf, size_t count)
+{
+	struct nvhost_device_power_attr *power_attribute =
+		container_of(attr, struct nvhost_device_power_attr,
+			power_attr[NVHOST_POWER_SYSFS_ATTRIB_AUTOSUSPEND_BREAKEVEN]);
+	struct platform_device *dev = power_attribute->ndev;
+	struct nvhost_device_data *pdata = platform_get_drvdata(dev);
+	unsigned long flags;
+	int breakeven;
+
+	if (kstrtoint(buf, 0, &breakeven) || breakeven < 0)
+		return -EINVAL;
+
+	/* start learning again, the old gaps were for another policy */
+	spin_lock_irqsave(&pdata->idle_gap_lock, flags);
+	pdata->autosuspend_breakeven = breakeven;
+	pdata->idle_gap_count = 0;
+	pdata->idle_since_ns = 0;
+	spin_unlock_irqrestore(&pdata->idle_gap_lock, flags);
+
+	return count;
+}
+
+static ssize_t autosuspend_breakeven_show(struct kobject *kobj,
+	struct kobj_attribute *attr, char *buf)
+{
+	struct nvhost_device_power_attr *power_attribute =
+		container_of(attr, struct nvhost_device_power_attr,
+			power_attr[NVHOST_POWER_SYSFS_ATTRIB_AUTOSUSPEND_BREAKEVEN]);
+	struct platform_device *dev = power_attribute->ndev;
+	struct nvhost_device_data *pdata = platform_get_drvdata(dev);
+
+	return snprintf(buf, PAGE_SIZE, "%d\n", pdata->autosuspend_breakeven);
+}
+
+static ssize_t power_cycles_show(struct kobject *kobj,
+	struct kobj_attribute *attr, char *buf)
+{
+	struct nvhost_device_power_attr *power_attribute =
+		container_of(attr, struct nvhost_device_power_attr,
+			power_attr[NVHOST_POWER_SYSFS_ATTRIB_POWER_CYCLES]);
+	struct platform_device *dev = power_attribute->ndev;
+	struct nvhost_device_data *pdata = platform_get_drvdata(dev);
+	u64 cycles = pdata->power_cycles;
+
+	/* power-ups, average power-up time and current delay */
+	return snprintf(buf, PAGE_SIZE, "%llu %llu us %d ms\n", cycles,
+			cycles ? div64_u64(pdata->poweron_ns,
+					   cycles * NSEC_PER_USEC) : 0,
+			pdata->autosuspend_cur);
+}
+
 static ssize_t clk_cap_store(struct kobject *kobj,
 	struct kobj_attribute *attr, const char *buf, size_t count)
 {
@@ -813,6 +947,8 @@ int nvhost_module_init(struct platform_device *dev)
 #endif
 
 	/* set pm runtime delays */
+	spin_lock_init(&pdata->idle_gap_lock);
+	pdata->autosuspend_cur = pdata->autosuspend_delay;
 	if (pdata->autosuspend_delay) {
 		pm_runtime_set_autosuspend_delay(&dev->dev,
 			pdata->autosuspend_delay);
@@ -874,6 +1010,29 @@ int nvhost_module_init(struct platform_device *dev)
 		goto fail_forceon;
 	}
 
+	attr = &pdata->power_attrib->power_attr[NVHOST_POWER_SYSFS_ATTRIB_AUTOSUSPEND_BREAKEVEN];
+	attr->attr.name = "autosuspend_breakeven";
+	attr->attr.mode = S_IWUSR | S_IRUGO;
+	attr->show = autosuspend_breakeven_show;
+	attr->store = autosuspend_breakeven_store;
+	sysfs_attr_init(&attr->attr);
+	if (sysfs_create_file(pdata->power_kobj, &attr->attr)) {
+		dev_err(&dev->dev, "Could not create sysfs attribute autosuspend_breakeven\n");
+		err = -EIO;
+		goto fail_breakeven;
+	}
+
+	attr = &pdata->power_attrib->power_attr[NVHOST_POWER_SYSFS_ATTRIB_POWER_CYCLES];
+	attr->attr.name = "power_cycles";
+	attr->attr.mode = S_IRUGO;
+	attr->show = power_cycles_show;
+	sysfs_attr_init(&attr->attr);
+	if (sysfs_create_file(pdata->power_kobj, &attr->attr)) {
+		dev_err(&dev->dev, "Could not create sysfs attribute power_cycles\n");
+		err = -EIO;
+		goto fail_power_cycles;
+	}
+
 	err = device_create_file(&dev->dev, &dev_attr_force_idle);
 	if (err) {
 		dev_err(&dev->dev, "Couldn't create device file force_idle\n");
@@ -926,6 +1085,14 @@ fail_clk_cap:
 	device_remove_file(&dev->dev, &dev_attr_force_idle);
 
 fail_force_idle:
+	attr = &pdata->power_attrib->power_attr[NVHOST_POWER_SYSFS_ATTRIB_POWER_CYCLES];
+	sysfs_remove_file(pdata->power_kobj, &attr->attr);
+
+fail_power_cycles:
+	attr = &pdata->power_attrib->power_attr[NVHOST_POWER_SYSFS_ATTRIB_AUTOSUSPEND_BREAKEVEN];
+	sysfs_remove_file(pdata->power_kobj, &attr->attr);
+
+fail_breakeven:
 	attr = &pdata->power_attrib->power_attr[NVHOST_POWER_SYSFS_ATTRIB_FORCE_ON];
 	sysfs_remove_file(pdata->power_kobj, &attr->attr);
 
@@ -1119,6 +1286,8 @@ static int nvhost_module_runtime_suspend(struct device *dev)
 
 static int nvhost_module_runtime_resume(struct device *dev)
 {
+	struct nvhost_device_data *pdata = dev_get_drvdata(dev);
+	u64 start = ktime_get_ns();
 	int err;
 
 	dev_dbg(dev, "runtime resuming");
@@ -1133,6 +1302,10 @@ static int nvhost_module_runtime_resume(struct device *dev)
 		return err;
 	}
 
+	/* runtime PM callbacks of a device are serialized */
+	pdata->power_cycles++;
+	pdata->poweron_ns += ktime_get_ns() - start;
+
 	return 0;
 }
 
@@ -21,6 +21,7 @@
 #include <linux/uaccess.h>
 #include <linux/slab.h>
 #include <linux/dma-buf.h>
+#include <linux/idr.h>
 #include <linux/cvnas.h>
 
 #include "dev.h"
@@ -36,6 +37,8 @@
  * @size:		Size of the buffer
  * @user_map_count:	Buffer reference count from user space
  * @submit_map_count:	Buffer reference count from task submit
+ * @reg_id:		Id in the registered buffer table, 0 if none
+ * @registered:		Buffer can still be referenced through reg_id
  * @rb_node:		pinned buffer node
  * @list_head:		List entry
  *
@@ -52,6 +55,9 @@ struct nvhost_vm_buffer {
 	s32 user_map_count;
 	s32 submit_map_count;
 
+	u32 reg_id;
+	bool registered;
+
 	struct rb_node rb_node;
 	struct list_head list_head;
 };
@@ -192,6 +198,7 @@ static void nvhost_free_buffers(struct kref *kref)
 	struct nvhost_buffers *nvhost_buffers =
 		container_of(kref, struct nvhost_buffers, kref);
 
+	idr_destroy(&nvhost_buffers->registered);
 	kfree(nvhost_buffers);
 }
 
@@ -207,6 +214,10 @@ static void nvhost_buffer_unmap(struct nvhost_buffers *nvhost_buffers,
 	dma_buf_detach(vm->dmabuf, vm->attach);
 	dma_buf_put(vm->dmabuf);
 
+	/* the id stays reserved until no submit can refer to it anymore */
+	if (vm->reg_id)
+		idr_remove(&nvhost_buffers->registered, vm->reg_id);
+
 	rb_erase(&vm->rb_node, &nvhost_buffers->rb_root);
 	list_del(&vm->list_head);
 
@@ -228,6 +239,7 @@ struct nvhost_buffers *nvhost_buffer_init(struct platform_device *pdev)
 	mutex_init(&nvhost_buffers->mutex);
 	nvhost_buffers->rb_root = RB_ROOT;
 	INIT_LIST_HEAD(&nvhost_buffers->list_head);
+	idr_init(&nvhost_buffers->registered);
 	kref_init(&nvhost_buffers->kref);
 
 	return nvhost_buffers;
@@ -375,9 +387,125 @@ void nvhost_buffer_release(struct nvhost_buffers *nvhost_buffers)
 	list_for_each_entry_safe(vm, n, &nvhost_buffers->list_head,
 				 list_head) {
 		vm->user_map_count = 0;
+		vm->registered = false;
 		nvhost_buffer_unmap(nvhost_buffers, vm);
 	}
 	mutex_unlock(&nvhost_buffers->mutex);
 
 	kref_put(&nvhost_buffers->kref, nvhost_free_buffers);
 }
+
+int nvhost_buffer_register(struct nvhost_buffers *nvhost_buffers,
+			   struct dma_buf *dmabuf, u32 *id)
+{
+	struct nvhost_vm_buffer *vm;
+	int err;
+
+	/* the registration holds one user pin */
+	err = nvhost_buffer_pin(nvhost_buffers, &dmabuf, 1);
+	if (err)
+		return err;
+
+	mutex_lock(&nvhost_buffers->mutex);
+
+	vm = nvhost_find_map_buffer(nvhost_buffers, dmabuf);
+	if (vm == NULL) {
+		err = -EINVAL;
+		goto unlock;
+	}
+
+	/* registering twice returns the same id and a single pin */
+	if (vm->registered) {
+		vm->user_map_count--;
+		*id = vm->reg_id;
+		goto unlock;
+	}
+
+	if (!vm->reg_id) {
+		err = idr_alloc(&nvhost_buffers->registered, vm, 1, 0,
+				GFP_KERNEL);
+		if (err < 0) {
+			vm->user_map_count--;
+			nvhost_buffer_unmap(nvhost_buffers, vm);
+			goto unlock;
+		}
+		vm->reg_id = err;
+		err = 0;
+	}
+
+	vm->registered = true;
+	*id = vm->reg_id;
+
+unlock:
+	mutex_unlock(&nvhost_buffers->mutex);
+	return err;
+}
+
+void nvhost_buffer_unregister(struct nvhost_buffers *nvhost_buffers, u32 id)
+{
+	struct nvhost_vm_buffer *vm;
+
+	mutex_lock(&nvhost_buffers->mutex);
+
+	vm = idr_find(&nvhost_buffers->registered, id);
+	if (vm && vm->registered) {
+		vm->registered = false;
+		if (vm->user_map_count-- < 0)
+			vm->user_map_count = 0;
+		nvhost_buffer_unmap(nvhost_buffers, vm);
+	}
+
+	mutex_unlock(&nvhost_buffers->mutex);
+}
+
+int nvhost_buffer_submit_pin_id(struct nvhost_buffers *nvhost_buffers,
+				u32 id, struct dma_buf **dmabuf,
+				dma_addr_t *paddr, size_t *psize,
+				enum nvhost_buffers_heap *heap)
+{
+	struct nvhost_vm_buffer *vm;
+	int err = 0;
+
+	mutex_lock(&nvhost_buffers->mutex);
+
+	vm = idr_find(&nvhost_buffers->registered, id);
+	if (vm == NULL || !vm->registered) {
+		err = -EINVAL;
+		goto unlock;
+	}
+
+	kref_get(&nvhost_buffers->kref);
+	vm->submit_map_count++;
+
+	*dmabuf = vm->dmabuf;
+	*paddr = vm->addr;
+	*psize = vm->size;
+
+	/* Return heap only if requested */
+	if (heap != NULL)
+		*heap = vm->heap;
+
+unlock:
+	mutex_unlock(&nvhost_buffers->mutex);
+	return err;
+}
+
+void nvhost_buffer_submit_unpin_id(struct nvhost_buffers *nvhost_buffers,
+				   u32 id)
+{
+	struct nvhost_vm_buffer *vm;
+
+	mutex_lock(&nvhost_buffers->mutex);
+
+	/* found even after unregister, the submit pin keeps the entry */
+	vm = idr_find(&nvhost_buffers->registered, id);
+	if (vm) {
+		if (vm->submit_map_count-- < 0)
+			vm->submit_map_count = 0;
+		nvhost_buffer_unmap(nvhost_buffers, vm);
+	}
+
+	mutex_unlock(&nvhost_buffers->mutex);
+
+	kref_put(&nvhost_buffers->kref, nvhost_free_buffers);
+}
@@ -20,6 +20,7 @@
 #define __NVHOST_NVHOST_BUFFER_H__
 
 #include <linux/dma-buf.h>
+#include <linux/idr.h>
 
 enum nvhost_buffers_heap {
 	NVHOST_BUFFERS_HEAP_DRAM = 0,
@@ -33,6 +34,7 @@ enum nvhost_buffers_heap {
  * rb_root		RB tree root for of all the buffers used by a file pointer
  * list			List for traversing through all the buffers
  * mutex		Mutex for the buffer tree and the buffer list
+ * registered		Table of registered buffers indexed by id
  * kref			Reference count for the bufferlist
  *
  */
@@ -42,6 +44,7 @@ struct nvhost_buffers {
 	struct list_head list_head;
 	struct rb_root rb_root;
 	struct mutex mutex;
+	struct idr registered;
 
 	struct kref kref;
 };
@@ -125,6 +128,64 @@ int nvhost_buffer_submit_pin(struct nvhost_buffers *nvhost_buffers,
 void nvhost_buffer_submit_unpin(struct nvhost_buffers *nvhost_buffers,
 					struct dma_buf **dmabufs, u32 count);
 
+/**
+ * @brief			Register a buffer for submits by id
+ *
+ * This function pins the buffer once and returns a stable id for it. Submits
+ * that reference the buffer by id skip the dma_buf lookup and the search in
+ * the buffer tree. Registering an already registered buffer returns the same
+ * id.
+ *
+ * @param nvhost_buffers	Pointer to nvhost_buffer struct
+ * @param dmabuf		Buffer to register
+ * @param id			Pointer to the returned id
+ * @return			0 on success or negative on error
+ *
+ */
+int nvhost_buffer_register(struct nvhost_buffers *nvhost_buffers,
+			   struct dma_buf *dmabuf, u32 *id);
+
+/**
+ * @brief			Drop a buffer registration
+ *
+ * The buffer stays mapped until the last task referencing it completes.
+ *
+ * @param nvhost_buffers	Pointer to nvhost_buffer struct
+ * @param id			Id returned by nvhost_buffer_register()
+ * @return			None
+ *
+ */
+void nvhost_buffer_unregister(struct nvhost_buffers *nvhost_buffers, u32 id);
+
+/**
+ * @brief			Pin a registered buffer for a task submit
+ *
+ * @param nvhost_buffers	Pointer to nvhost_buffer struct
+ * @param id			Id returned by nvhost_buffer_register()
+ * @param dmabuf		Pointer to the returned dma_buf. No reference
+ *				is taken, the submit pin keeps it alive.
+ * @param paddr			Pointer to the returned IOVA
+ * @param psize			Pointer to the returned buffer size
+ * @param heap			Pointer to the returned heap, may be NULL
+ * @return			0 on success or negative on error
+ *
+ */
+int nvhost_buffer_submit_pin_id(struct nvhost_buffers *nvhost_buffers,
+				u32 id, struct dma_buf **dmabuf,
+				dma_addr_t *paddr, size_t *psize,
+				enum nvhost_buffers_heap *heap);
+
+/**
+ * @brief			Release a submit pin taken by id
+ *
+ * @param nvhost_buffers	Pointer to nvhost_buffer struct
+ * @param id			Id passed to nvhost_buffer_submit_pin_id()
+ * @return			None
+ *
+ */
+void nvhost_buffer_submit_unpin_id(struct nvhost_buffers *nvhost_buffers,
+				   u32 id);
+
 /**
  * @brief			Drop a user reference to buffer structure
  *
@@ -31,15 +31,28 @@
 #include <linux/kfifo.h>
 #include <trace/events/nvhost.h>
 #include <linux/interrupt.h>
+#include <linux/log2.h>
+#include <linux/sizes.h>
 
 /*
  * TODO:
  *   stats
  *     - for figuring out what to optimize further
- *   resizable push buffer
- *     - some channels hardly need any, some channels (3d) could use more
  */
 
+u32 nvhost_push_buffer_max_kb = 64;
+
+/*
+ * A ring that was replaced by a larger one. The static mapping of the old
+ * ring cannot be removed, so its memory is kept until the cdma is destroyed.
+ */
+struct push_buffer_segment {
+	struct list_head list;
+	u32 *mapped;
+	dma_addr_t dma_addr;
+	u32 size;
+};
+
 /*
  * push_buffer
  *
@@ -58,7 +71,7 @@ int nvhost_push_buffer_alloc(struct push_buffer *pb)
 	pb->dma_addr = 0;
 
 	pb->mapped = dma_alloc_coherent(&cdma_to_dev(cdma)->dev->dev,
-			PUSH_BUFFER_SIZE + 4,
+			pb->size + 4,
 			&pb->dma_addr,
 			GFP_KERNEL);
 	if (!pb->mapped) {
@@ -69,7 +82,7 @@ int nvhost_push_buffer_alloc(struct push_buffer *pb)
 
 	/* for now, map pushbuffer to all address spaces */
 	nvhost_vm_map_static(cdma_to_dev(cdma)->dev, pb->mapped,
-			     pb->dma_addr, PUSH_BUFFER_SIZE + 4);
+			     pb->dma_addr, pb->size + 4);
 
 	return 0;
 }
@@ -82,7 +95,7 @@ void nvhost_push_buffer_destroy(struct push_buffer *pb)
 	struct nvhost_cdma *cdma = pb_to_cdma(pb);
 	if (pb->mapped)
 		dma_free_coherent(&cdma_to_dev(cdma)->dev->dev,
-					PUSH_BUFFER_SIZE + 4,
+					pb->size + 4,
 					pb->mapped,
 					pb->dma_addr);
 
@@ -102,7 +115,7 @@ static void nvhost_push_buffer_push_to(struct push_buffer *pb,
 	WARN_ON(cur == pb->fence);
 	*(p++) = op1;
 	*(p++) = op2;
-	pb->cur = (cur + 8) & (PUSH_BUFFER_SIZE - 1);
+	pb->cur = (cur + 8) & (pb->size - 1);
 }
 
 /**
@@ -113,7 +126,7 @@ static void nvhost_push_buffer_pop_from(struct push_buffer *pb,
 		unsigned int slots)
 {
 	/* Advance the next write position */
-	pb->fence = (pb->fence + slots * 8) & (PUSH_BUFFER_SIZE - 1);
+	pb->fence = (pb->fence + slots * 8) & (pb->size - 1);
 }
 
 /**
@@ -121,7 +134,69 @@ static void nvhost_push_buffer_pop_from(struct push_buffer *pb,
  */
 static u32 nvhost_push_buffer_space(struct push_buffer *pb)
 {
-	return ((pb->fence - pb->cur) & (PUSH_BUFFER_SIZE - 1)) / 8;
+	return ((pb->fence - pb->cur) & (pb->size - 1)) / 8;
+}
+
+/**
+ * Track the largest number of slots ever in use
+ */
+static void nvhost_push_buffer_update_high_water(struct push_buffer *pb)
+{
+	u32 used = pb->size / 8 - 1 - nvhost_push_buffer_space(pb);
+
+	if (used > pb->high_water)
+		pb->high_water = used;
+}
+
+/**
+ * Replace the ring by a larger one of the given size. Caller must ensure
+ * command DMA is stopped and no job refers to the current ring.
+ */
+static int nvhost_push_buffer_grow(struct push_buffer *pb, u32 size)
+{
+	struct push_buffer_segment *seg;
+	int err;
+
+	seg = kzalloc(sizeof(*seg), GFP_KERNEL);
+	if (!seg)
+		return -ENOMEM;
+
+	seg->mapped = pb->mapped;
+	seg->dma_addr = pb->dma_addr;
+	seg->size = pb->size;
+
+	pb->size = size;
+	err = cdma_pb_op().init(pb);
+	if (err) {
+		/* keep using the old ring, it is idle and thus empty */
+		pb->mapped = seg->mapped;
+		pb->dma_addr = seg->dma_addr;
+		pb->size = seg->size;
+		pb->fence = pb->size - 8;
+		pb->cur = 0;
+		kfree(seg);
+		return err;
+	}
+
+	list_add_tail(&seg->list, &pb->retired);
+
+	return 0;
+}
+
+/**
+ * Release rings left behind by nvhost_push_buffer_grow()
+ */
+static void nvhost_push_buffer_free_retired(struct push_buffer *pb)
+{
+	struct nvhost_cdma *cdma = pb_to_cdma(pb);
+	struct push_buffer_segment *seg, *tmp;
+
+	list_for_each_entry_safe(seg, tmp, &pb->retired, list) {
+		list_del(&seg->list);
+		dma_free_coherent(&cdma_to_dev(cdma)->dev->dev,
+				  seg->size + 4, seg->mapped, seg->dma_addr);
+		kfree(seg);
+	}
 }
 
 u32 nvhost_push_buffer_putptr(struct push_buffer *pb)
@@ -136,7 +211,7 @@ dma_addr_t nvhost_push_buffer_start(struct push_buffer *pb)
 
 dma_addr_t nvhost_push_buffer_end(struct push_buffer *pb)
 {
-	return pb->dma_addr + PUSH_BUFFER_SIZE + 4;
+	return pb->dma_addr + pb->size + 4;
 }
 
 /**
@@ -188,6 +263,7 @@ unsigned int nvhost_cdma_wait_locked(struct nvhost_cdma *cdma,
 		enum cdma_event event)
 {
 	struct mutex *lock;
+	bool stalled = false;
 
 	if (event == CDMA_EVENT_SYNC_QUEUE_EMPTY)
 		lock = &cdma->sync_queue_lock;
@@ -225,6 +301,12 @@ unsigned int nvhost_cdma_wait_locked(struct nvhost_cdma *cdma,
 		trace_nvhost_wait_cdma(cdma_to_channel(cdma)->dev->name,
 				event);
 
+		if (event == CDMA_EVENT_PUSH_BUFFER_SPACE && !stalled) {
+			cdma->push_buffer.stalls++;
+			cdma->push_buffer.grow_pending = true;
+			stalled = true;
+		}
+
 		/* If somebody has managed to already start waiting, yield */
 		if (cdma->event != CDMA_EVENT_NONE) {
 			mutex_unlock(lock);
@@ -297,6 +379,44 @@ static void stop_cdma_timer_locked(struct nvhost_cdma *cdma)
 	mutex_unlock(&cdma->timeout_lock);
 }
 
+static void cdma_latency_add(struct nvhost_latency_hist *hist,
+			     enum nvhost_latency_stage stage, s64 us)
+{
+	unsigned int bucket = us > 0 ? ilog2(us) + 1 : 0;
+
+	bucket = min_t(unsigned int, bucket, NVHOST_LATENCY_BUCKETS - 1);
+	atomic64_inc(&hist->count[stage][bucket]);
+}
+
+/**
+ * Account a retired job in the latency histograms of its engine. Jobs
+ * retired without their completion interrupt, e.g. by the timeout
+ * handler, have no notify latency.
+ */
+static void cdma_record_latency(struct nvhost_cdma *cdma,
+				struct nvhost_job *job)
+{
+	struct nvhost_device_data *pdata = platform_get_drvdata(job->ch->dev);
+	struct nvhost_latency_hist *hist = pdata->latency_hist;
+	ktime_t now, irq;
+
+	if (!hist || !ktime_to_ns(job->submit_ktime))
+		return;
+
+	now = ktime_get();
+	irq = cdma->irq_ktime;
+	if (ktime_before(irq, job->submit_ktime) || ktime_after(irq, now))
+		irq = now;
+
+	if (ktime_to_ns(job->queue_ktime))
+		cdma_latency_add(hist, NVHOST_LATENCY_QUEUE,
+			ktime_us_delta(job->submit_ktime, job->queue_ktime));
+	cdma_latency_add(hist, NVHOST_LATENCY_EXEC,
+			 ktime_us_delta(irq, job->submit_ktime));
+	cdma_latency_add(hist, NVHOST_LATENCY_NOTIFY,
+			 ktime_us_delta(now, irq));
+}
+
 /**
  * For all sync queue entries that have already finished according to the
  * current sync point registers:
@@ -356,6 +476,10 @@ static void update_cdma_locked(struct nvhost_cdma *cdma)
 		/* Cancel timeout, when a buffer completes */
 		stop_cdma_timer_locked(cdma);
 
+		nvhost_channel_prio_job_done(dev, job);
+		nvhost_channel_session_job_done(job->ch, job);
+		cdma_record_latency(cdma, job);
+
 		/* Drop syncpoint references from this job */
 		for (i = 0; i < job->num_syncpts; ++i)
 			nvhost_syncpt_put_ref(sp, job->sp[i].id);
@@ -522,12 +646,17 @@ int nvhost_cdma_init(struct platform_device *pdev,
 	mutex_init(&cdma->timeout_lock);
 
 	INIT_LIST_HEAD(&cdma->sync_queue);
+	INIT_LIST_HEAD(&pb->retired);
 
 	cdma->event = CDMA_EVENT_NONE;
 	cdma->running = false;
 	cdma->torndown = false;
 	cdma->pdev = pdev;
 
+	pb->size = PUSH_BUFFER_SIZE;
+	pb->high_water = 0;
+	pb->stalls = 0;
+	pb->grow_pending = false;
 	err = cdma_pb_op().init(pb);
 	if (err)
 		return err;
@@ -543,14 +672,60 @@ void nvhost_cdma_deinit(struct nvhost_cdma *cdma)
 
 	WARN_ON(cdma->running);
 	nvhost_push_buffer_destroy(pb);
+	nvhost_push_buffer_free_retired(pb);
 	cdma_op().timeout_destroy(cdma);
 }
 
+/**
+ * Grow the push buffer after a submitter had to wait for space. The
+ * channel is drained and stopped first so that the ring can be swapped
+ * without any job pointing into it; cdma_start() then programs the new
+ * ring on the next submit.
+ */
+static void cdma_grow_push_buffer(struct nvhost_cdma *cdma)
+{
+	struct push_buffer *pb = &cdma->push_buffer;
+	u32 max_size = 0;
+	u32 size;
+	int err;
+
+	if (nvhost_push_buffer_max_kb)
+		max_size = rounddown_pow_of_two(min_t(u32,
+				nvhost_push_buffer_max_kb, SZ_1M) * SZ_1K);
+
+	size = pb->size * 2;
+	if (size > max_size) {
+		pb->grow_pending = false;
+		return;
+	}
+
+	cdma_op().stop(cdma);
+
+	down_write(&cdma->lock);
+	if (!cdma->running && !cdma->torndown &&
+	    list_empty(&cdma->sync_queue)) {
+		err = nvhost_push_buffer_grow(pb, size);
+		if (err)
+			nvhost_warn(&cdma->pdev->dev,
+				    "failed to grow push buffer to %u bytes",
+				    size);
+		else
+			nvhost_dbg_info("%s: push buffer grown to %u bytes",
+					cdma_to_channel(cdma)->dev->name,
+					size);
+	}
+	pb->grow_pending = false;
+	up_write(&cdma->lock);
+}
+
 /**
  * Begin a cdma submit
  */
 int nvhost_cdma_begin(struct nvhost_cdma *cdma, struct nvhost_job *job)
 {
+	if (cdma->push_buffer.grow_pending)
+		cdma_grow_push_buffer(cdma);
+
 	down_read(&cdma->lock);
 
 	if (job->timeout) {
@@ -630,6 +805,7 @@ void nvhost_cdma_push_gather(struct nvhost_cdma *cdma,
 	cdma->slots_used++;
 	mutex_lock(&cdma->push_buffer_lock);
 	nvhost_push_buffer_push_to(pb, op1, op2);
+	nvhost_push_buffer_update_high_water(pb);
 	mutex_unlock(&cdma->push_buffer_lock);
 }
 
@@ -648,6 +824,8 @@ void nvhost_cdma_end(struct nvhost_cdma *cdma,
 	was_idle = list_empty(&cdma->sync_queue);
 	mutex_unlock(&cdma->sync_queue_lock);
 
+	job->submit_ktime = ktime_get();
+	nvhost_channel_session_job_queued(job->ch);
 	add_to_sync_queue(cdma,
 			job,
 			cdma->slots_used,
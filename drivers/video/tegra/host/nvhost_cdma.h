@@ -33,13 +33,30 @@ struct nvhost_job;
 struct mem_mgr;
 struct mem_handle;
 
-/* Number of gathers we allow to be queued up per channel. Must be a
- * power of two. Currently sized such that pushbuffer is 4KB (512*8B). */
+/* Number of gathers we initially allow to be queued up per channel. Must be
+ * a power of two. Currently sized such that pushbuffer is 4KB (512*8B). */
 #define NVHOST_GATHER_QUEUE_SIZE 512
 
   /* 8 bytes per slot. (This number does not include the final RESTART.) */
 #define PUSH_BUFFER_SIZE (NVHOST_GATHER_QUEUE_SIZE * 8)
 
+/* Upper bound a push buffer may grow to, in KB. Zero disables growing. */
+extern u32 nvhost_push_buffer_max_kb;
+
+/* Buckets of the per engine job latency histograms, log2 of microseconds */
+#define NVHOST_LATENCY_BUCKETS 20
+
+enum nvhost_latency_stage {
+	NVHOST_LATENCY_QUEUE,		/* submit call until pushed to hw */
+	NVHOST_LATENCY_EXEC,		/* pushed until completion interrupt */
+	NVHOST_LATENCY_NOTIFY,		/* interrupt until the job is retired */
+	NVHOST_LATENCY_NUM
+};
+
+struct nvhost_latency_hist {
+	atomic64_t count[NVHOST_LATENCY_NUM][NVHOST_LATENCY_BUCKETS];
+};
+
    /* 4K page containing GATHERed methods to increment channel syncpts
      * and replaces the original timed out contexts GATHER slots */
 #define SYNCPT_INCR_BUFFER_SIZE_WORDS   (4096 / sizeof(u32))
@@ -61,8 +78,13 @@ struct mem_handle;
 struct push_buffer {
 	u32 *mapped;			/* mapped pushbuffer memory */
 	dma_addr_t dma_addr;		/* dma address of pushbuffer */
+	u32 size;			/* bytes, power of two, w/o RESTART */
 	u32 fence;			/* index we've written */
 	u32 cur;			/* index to write to */
+	u32 high_water;			/* most slots ever in use */
+	u32 stalls;			/* submits that waited for space */
+	bool grow_pending;		/* grow once the channel idles */
+	struct list_head retired;	/* rings replaced by a larger one */
 };
 
 struct buffer_timeout {
@@ -142,6 +164,7 @@ struct nvhost_cdma {
 	unsigned int slots_free;	/* pb slots free in current submit */
 	unsigned int first_get;		/* DMAGET value, where submit begins */
 	unsigned int last_put;		/* last value written to DMAPUT */
+	ktime_t irq_ktime;		/* last submit complete interrupt */
 	struct push_buffer push_buffer;	/* channel's push buffer */
 	struct list_head sync_queue;	/* job queue */
 	struct buffer_timeout timeout;	/* channel's timeout state/wq */
@@ -37,6 +37,9 @@
 
 #define NVHOST_CHANNEL_LOW_PRIO_MAX_WAIT 50
 
+/* Channels only the high priority level may take */
+u32 nvhost_channel_high_prio_reserve;
+
 /* Memory allocation for all supported channels */
 int nvhost_alloc_channels(struct nvhost_master *host)
 {
@@ -54,7 +57,9 @@ int nvhost_alloc_channels(struct nvhost_master *host)
 	mutex_init(&host->ch_alloc_mutex);
 	max_channels = nvhost_channel_nb_channels(host);
 
-	sema_init(&host->free_channels, max_channels);
+	host->free_channels = max_channels;
+	init_waitqueue_head(&host->free_channels_wq);
+	spin_lock_init(&host->prio_lock);
 
 	for (index = 0; index < max_channels; index++) {
 		ch = kzalloc(sizeof(*ch), GFP_KERNEL);
@@ -66,6 +71,8 @@ int nvhost_alloc_channels(struct nvhost_master *host)
 		/* initialize data structures */
 		nvhost_set_chanops(ch);
 		mutex_init(&ch->submitlock);
+		nvhost_pin_cache_init(&ch->pin_cache);
+		nvhost_job_pool_init(&ch->job_pool);
 		ch->chid = nvhost_channel_get_id_from_index(host, index);
 
 		/* initialize channel cdma */
@@ -93,37 +100,161 @@ int nvhost_alloc_channels(struct nvhost_master *host)
 	return 0;
 }
 
+enum nvhost_channel_prio nvhost_channel_prio_level(u32 priority)
+{
+	if (priority < NVHOST_PRIORITY_MEDIUM)
+		return NVHOST_CHANNEL_PRIO_LOW;
+	if (priority < NVHOST_PRIORITY_HIGH)
+		return NVHOST_CHANNEL_PRIO_MEDIUM;
+	return NVHOST_CHANNEL_PRIO_HIGH;
+}
+
 /*
- * Must be called with the chlist_mutex held.
+ * A channel may be taken at the given level if no higher level is waiting
+ * for one and, below the high level, the reserved channels stay free. Must
+ * be called with the chlist_mutex held; wait conditions may call it without
+ * and recheck under the mutex.
+ */
+static bool nvhost_channel_can_alloc(struct nvhost_master *host,
+				     enum nvhost_channel_prio prio)
+{
+	int reserve = 0;
+	int level;
+
+	for (level = prio + 1; level < NVHOST_CHANNEL_PRIO_NUM; level++)
+		if (READ_ONCE(host->ch_waiters[level]))
+			return false;
+
+	if (prio != NVHOST_CHANNEL_PRIO_HIGH)
+		reserve = min_t(int, nvhost_channel_high_prio_reserve,
+				nvhost_channel_nb_channels(host) - 1);
+
+	return READ_ONCE(host->free_channels) > reserve;
+}
+
+/*
+ * Must be called with the chlist_mutex held, and only after
+ * nvhost_channel_can_alloc() allowed it.
  *
- * Returns the allocated channel. If no channel could be allocated within a
- * reasonable time, returns ERR_PTR(-EBUSY). In an internal error situation,
- * returns NULL. Under normal conditions, this call will block till an existing
- * channel is freed.
+ * Returns the allocated channel. In an internal error situation, returns
+ * NULL.
  */
 static struct nvhost_channel* nvhost_channel_alloc(struct nvhost_master *host)
 {
-	int index, max_channels, err;
-
-	mutex_unlock(&host->chlist_mutex);
-	err = down_timeout(&host->free_channels, msecs_to_jiffies(5000));
-	mutex_lock(&host->chlist_mutex);
-	if (err)
-		return ERR_PTR(-EBUSY);
+	int index, max_channels;
 
 	max_channels = nvhost_channel_nb_channels(host);
 	index = find_first_zero_bit(host->allocated_channels, max_channels);
 	if (index >= max_channels) {
-		pr_err("%s: Free channels sema and allocated mask out of sync!\n",
+		pr_err("%s: Free channels count and allocated mask out of sync!\n",
 			__func__);
 		return NULL;
 	}
 
 	/* Reserve the channel */
 	set_bit(index, host->allocated_channels);
+	host->free_channels--;
 	return host->chlist[index];
 }
 
+static void nvhost_channel_prio_map_done(struct nvhost_master *host,
+		enum nvhost_channel_prio prio, bool waited, ktime_t start)
+{
+	struct nvhost_channel_prio_stats *stats = &host->prio_stats[prio];
+	u64 us = 0;
+
+	if (waited)
+		us = ktime_us_delta(ktime_get(), start);
+
+	spin_lock(&host->prio_lock);
+	stats->maps++;
+	if (waited) {
+		stats->map_waits++;
+		stats->map_wait_us += us;
+		stats->map_wait_max_us = max(stats->map_wait_max_us, us);
+	}
+	spin_unlock(&host->prio_lock);
+}
+
+/* Account a completed job to the level it was submitted at */
+void nvhost_channel_prio_job_done(struct nvhost_master *host,
+		struct nvhost_job *job)
+{
+	struct nvhost_channel_prio_stats *stats;
+	u64 us;
+
+	if (!ktime_to_ns(job->submit_ktime))
+		return;
+
+	us = ktime_us_delta(ktime_get(), job->submit_ktime);
+	stats = &host->prio_stats[job->priority];
+
+	spin_lock(&host->prio_lock);
+	stats->jobs++;
+	stats->job_us += us;
+	stats->job_max_us = max(stats->job_max_us, us);
+	spin_unlock(&host->prio_lock);
+}
+
+/*
+ * Sessions of an engine with a session_slice take turns: while another
+ * session has jobs in flight, a session may only have up to session_slice
+ * jobs queued. The jobs of a session, a batch in particular, then reach the
+ * engine back to back instead of interleaved one by one with the other
+ * sessions' jobs, which costs a context switch on every job.
+ */
+static DECLARE_WAIT_QUEUE_HEAD(nvhost_session_wq);
+
+static bool nvhost_channel_session_may_submit(struct nvhost_channel *ch,
+		int num_jobs)
+{
+	struct nvhost_device_data *pdata = platform_get_drvdata(ch->dev);
+	int inflight = atomic_read(&ch->inflight);
+
+	return !inflight || inflight + num_jobs <= pdata->session_slice ||
+		atomic_read(&pdata->busy_sessions) <= 1;
+}
+
+static int nvhost_channel_session_wait(struct nvhost_channel *ch,
+		int num_jobs)
+{
+	struct nvhost_device_data *pdata = platform_get_drvdata(ch->dev);
+
+	if (!pdata->session_slice)
+		return 0;
+
+	return wait_event_interruptible(nvhost_session_wq,
+			nvhost_channel_session_may_submit(ch, num_jobs));
+}
+
+/* Called by cdma for each job it puts on the sync queue */
+void nvhost_channel_session_job_queued(struct nvhost_channel *ch)
+{
+	struct nvhost_device_data *pdata = platform_get_drvdata(ch->dev);
+
+	if (atomic_inc_return(&ch->inflight) == 1)
+		atomic_inc(&pdata->busy_sessions);
+}
+
+/* Called by cdma, serialized per channel, for each completed job */
+void nvhost_channel_session_job_done(struct nvhost_channel *ch,
+		struct nvhost_job *job)
+{
+	struct nvhost_device_data *pdata = platform_get_drvdata(ch->dev);
+
+	if (ktime_to_ns(job->submit_ktime)) {
+		ch->session.jobs++;
+		ch->session.job_us += ktime_us_delta(ktime_get(),
+						     job->submit_ktime);
+	}
+
+	if (atomic_dec_return(&ch->inflight) == 0)
+		atomic_dec(&pdata->busy_sessions);
+
+	if (pdata->session_slice)
+		wake_up_all(&nvhost_session_wq);
+}
+
 /*
  * Must be called with the chlist_mutex held.
  */
@@ -138,7 +269,8 @@ static void nvhost_channel_free(struct nvhost_master *host,
 		WARN_ON(1);
 		return;
 	}
-	up(&host->free_channels);
+	host->free_channels++;
+	wake_up_all(&host->free_channels_wq);
 }
 
 int nvhost_channel_remove_identifier(struct nvhost_device_data *pdata,
@@ -203,6 +335,9 @@ static void nvhost_channel_unmap_locked(struct kref *ref)
 
 err_module_busy:
 
+	/* cached mappings belong to the vm that is going away */
+	nvhost_pin_cache_flush(&ch->pin_cache);
+
 	/* drop reference to the vm */
 	nvhost_vm_put(ch->vm);
 
@@ -213,14 +348,23 @@ err_module_busy:
 	ch->identifier = NULL;
 }
 
-/* Maps free channel with device */
-int nvhost_channel_map_with_vm(struct nvhost_device_data *pdata,
+/*
+ * Maps free channel with device. If all channels are taken, waits for one
+ * to be freed with both channel mutexes dropped, so that a waiter at a
+ * higher level can overtake waiters at lower levels.
+ */
+static int channel_map_prio(struct nvhost_device_data *pdata,
 			struct nvhost_channel **channel,
 			void *identifier,
-			void *vm_identifier)
+			void *vm_identifier,
+			enum nvhost_channel_prio prio)
 {
 	struct nvhost_master *host = NULL;
 	struct nvhost_channel *ch = NULL;
+	unsigned long deadline = jiffies + msecs_to_jiffies(5000);
+	ktime_t start = ktime_get();
+	bool waiting = false;
+	bool waited = false;
 	int max_channels = 0;
 	int index = 0;
 
@@ -236,6 +380,7 @@ int nvhost_channel_map_with_vm(struct nvhost_device_data *pdata,
 	host = nvhost_get_host(pdata->pdev);
 	max_channels = nvhost_channel_nb_channels(host);
 
+retry:
 	mutex_lock(&host->ch_alloc_mutex);
 	mutex_lock(&host->chlist_mutex);
 
@@ -246,9 +391,14 @@ int nvhost_channel_map_with_vm(struct nvhost_device_data *pdata,
 			&& kref_get_unless_zero(&ch->refcount)) {
 			/* yes, client can continue using it */
 			*channel = ch;
+			if (waiting) {
+				host->ch_waiters[prio]--;
+				wake_up_all(&host->free_channels_wq);
+			}
 			mutex_unlock(&host->chlist_mutex);
 			mutex_unlock(&host->ch_alloc_mutex);
 
+			nvhost_channel_prio_map_done(host, prio, waited, start);
 			trace_nvhost_channel_remap(pdata->pdev->name, ch->chid,
 						   pdata->num_mapped_chs,
 						   identifier);
@@ -256,13 +406,40 @@ int nvhost_channel_map_with_vm(struct nvhost_device_data *pdata,
 		}
 	}
 
-	ch = nvhost_channel_alloc(host);
-	if (PTR_ERR(ch) == -EBUSY) {
-		pr_err("%s: Timeout while allocating channel\n", __func__);
+	if (!nvhost_channel_can_alloc(host, prio)) {
+		long left = (long)(deadline - jiffies);
+
+		if (!waiting) {
+			host->ch_waiters[prio]++;
+			waiting = true;
+		}
+
+		if (left <= 0) {
+			host->ch_waiters[prio]--;
+			wake_up_all(&host->free_channels_wq);
+			mutex_unlock(&host->chlist_mutex);
+			mutex_unlock(&host->ch_alloc_mutex);
+			pr_err("%s: Timeout while allocating channel\n",
+				__func__);
+			return -EBUSY;
+		}
+
 		mutex_unlock(&host->chlist_mutex);
 		mutex_unlock(&host->ch_alloc_mutex);
-		return -EBUSY;
+
+		wait_event_timeout(host->free_channels_wq,
+				   nvhost_channel_can_alloc(host, prio), left);
+		waited = true;
+		goto retry;
 	}
+
+	if (waiting) {
+		/* lower levels may take what is left after us */
+		host->ch_waiters[prio]--;
+		wake_up_all(&host->free_channels_wq);
+	}
+
+	ch = nvhost_channel_alloc(host);
 	if (!ch) {
 		pr_err("%s: Couldn't find a free channel. Sema out of sync\n",
 			__func__);
@@ -275,6 +452,10 @@ int nvhost_channel_map_with_vm(struct nvhost_device_data *pdata,
 	ch->dev = pdata->pdev;
 	ch->identifier = identifier;
 	kref_init(&ch->refcount);
+	ch->session.pid = current->tgid;
+	ch->session.since = ktime_get();
+	ch->session.jobs = 0;
+	ch->session.job_us = 0;
 	/* channel is allocated, release mutex */
 	mutex_unlock(&host->chlist_mutex);
 
@@ -294,6 +475,8 @@ int nvhost_channel_map_with_vm(struct nvhost_device_data *pdata,
 
 	mutex_unlock(&host->ch_alloc_mutex);
 
+	nvhost_channel_prio_map_done(host, prio, waited, start);
+
 	*channel = ch;
 
 	return 0;
@@ -315,6 +498,23 @@ err_alloc_vm:
 	return -ENOMEM;
 }
 
+int nvhost_channel_map_with_vm(struct nvhost_device_data *pdata,
+			struct nvhost_channel **channel,
+			void *identifier,
+			void *vm_identifier)
+{
+	return channel_map_prio(pdata, channel, identifier, vm_identifier,
+				NVHOST_CHANNEL_PRIO_MEDIUM);
+}
+
+int nvhost_channel_map_prio(struct nvhost_device_data *pdata,
+			struct nvhost_channel **channel,
+			void *identifier,
+			enum nvhost_channel_prio prio)
+{
+	return channel_map_prio(pdata, channel, identifier, NULL, prio);
+}
+
 int nvhost_channel_map(struct nvhost_device_data *pdata,
 			struct nvhost_channel **channel,
 			void *identifier)
@@ -328,8 +528,11 @@ int nvhost_channel_list_free(struct nvhost_master *host)
 {
 	int i;
 
-	for (i = 0; i < nvhost_channel_nb_channels(host); i++)
+	for (i = 0; i < nvhost_channel_nb_channels(host); i++) {
+		if (host->chlist[i])
+			nvhost_job_pool_drain(&host->chlist[i]->job_pool);
 		kfree(host->chlist[i]);
+	}
 
 	dev_info(&host->dev->dev, "channel list free'd\n");
 
@@ -410,10 +613,54 @@ void nvhost_channel_init_gather_filter(struct platform_device *pdev,
 
 int nvhost_channel_submit(struct nvhost_job *job)
 {
+	int err = nvhost_channel_session_wait(job->ch, 1);
+
+	if (err)
+		return err;
+
+	job->queue_ktime = ktime_get();
 	return channel_op(job->ch).submit(job);
 }
 EXPORT_SYMBOL(nvhost_channel_submit);
 
+/*
+ * Submit num_jobs jobs, all on the same channel, in order. depends[i] is
+ * the index of an earlier job whose syncpoint increments job i must wait
+ * for, or -1. On return num_submitted holds the number of jobs that made
+ * it to hardware; the remaining ones are still owned by the caller.
+ */
+int nvhost_channel_submit_batch(struct nvhost_job **jobs, const s32 *depends,
+			int num_jobs, int *num_submitted)
+{
+	struct nvhost_channel *ch = jobs[0]->ch;
+	ktime_t now;
+	int i, err;
+
+	*num_submitted = 0;
+	err = nvhost_channel_session_wait(ch, num_jobs);
+	if (err)
+		return err;
+
+	now = ktime_get();
+	for (i = 0; i < num_jobs; i++)
+		jobs[i]->queue_ktime = now;
+
+	if (channel_op(ch).submit_batch)
+		return channel_op(ch).submit_batch(jobs, depends, num_jobs,
+						   num_submitted);
+
+	for (i = 0; i < num_jobs; i++) {
+		if (depends[i] >= 0)
+			nvhost_job_add_dependency(jobs[i], jobs[depends[i]]);
+		err = channel_op(ch).submit(jobs[i]);
+		if (err)
+			break;
+	}
+	*num_submitted = i;
+
+	return err;
+}
+
 void nvhost_getchannel(struct nvhost_channel *ch)
 {
 	struct nvhost_device_data *pdata = platform_get_drvdata(ch->dev);
@@ -25,6 +25,7 @@
 #include <linux/io.h>
 #include <linux/nvhost.h>
 #include "nvhost_cdma.h"
+#include "nvhost_job.h"
 
 #define NVHOST_MAX_WAIT_CHECKS		256
 #define NVHOST_MAX_GATHERS		512
@@ -35,11 +36,38 @@ struct nvhost_master;
 struct platform_device;
 struct nvhost_channel;
 
+/*
+ * Scheduling levels derived from NVHOST_PRIORITY_*. When channels run out,
+ * a freed channel goes to the highest level that is waiting, and the last
+ * nvhost_channel_high_prio_reserve channels are kept for the high level.
+ */
+enum nvhost_channel_prio {
+	NVHOST_CHANNEL_PRIO_LOW,
+	NVHOST_CHANNEL_PRIO_MEDIUM,
+	NVHOST_CHANNEL_PRIO_HIGH,
+	NVHOST_CHANNEL_PRIO_NUM
+};
+
+extern u32 nvhost_channel_high_prio_reserve;
+
+/* Per-level latency accounting, protected by nvhost_master.prio_lock */
+struct nvhost_channel_prio_stats {
+	u64 maps;		/* channel acquisitions */
+	u64 map_waits;		/* acquisitions that had to wait */
+	u64 map_wait_us;	/* total time waited for a channel */
+	u64 map_wait_max_us;
+	u64 jobs;		/* completed jobs */
+	u64 job_us;		/* total submit to completion time */
+	u64 job_max_us;
+};
+
 struct nvhost_channel_ops {
 	const char *soc_name;
 	int (*init)(struct nvhost_channel *,
 		    struct nvhost_master *);
 	int (*submit)(struct nvhost_job *job);
+	int (*submit_batch)(struct nvhost_job **jobs, const s32 *depends,
+			    int num_jobs, int *num_submitted);
 	int (*init_gather_filter)(struct platform_device *pdev,
 		struct nvhost_channel *ch);
 };
@@ -58,6 +86,19 @@ struct nvhost_channel {
 	struct nvhost_vm *vm;
 	/* owner identifier */
 	void *identifier;
+	/* buffers kept mapped across jobs */
+	struct nvhost_pin_cache pin_cache;
+	/* recycled job allocations */
+	struct nvhost_job_pool job_pool;
+	/* jobs queued to hardware and not yet completed */
+	atomic_t inflight;
+	/* usage of the session the channel is currently mapped to */
+	struct nvhost_channel_session_stats {
+		pid_t pid;
+		ktime_t since;
+		u64 jobs;
+		u64 job_us;
+	} session;
 };
 
 #define channel_op(ch)		(ch->ops)
@@ -92,6 +133,19 @@ int nvhost_channel_map_with_vm(struct nvhost_device_data *pdata,
 			struct nvhost_channel **channel,
 			void *identifier,
 			void *vm_identifier);
+int nvhost_channel_map_prio(struct nvhost_device_data *pdata,
+			struct nvhost_channel **channel,
+			void *identifier,
+			enum nvhost_channel_prio prio);
+enum nvhost_channel_prio nvhost_channel_prio_level(u32 priority);
+void nvhost_channel_prio_job_done(struct nvhost_master *host,
+			struct nvhost_job *job);
+void nvhost_channel_session_job_queued(struct nvhost_channel *ch);
+void nvhost_channel_session_job_done(struct nvhost_channel *ch,
+			struct nvhost_job *job);
+
+int nvhost_channel_submit_batch(struct nvhost_job **jobs, const s32 *depends,
+			int num_jobs, int *num_submitted);
 
 int nvhost_channel_nb_channels(struct nvhost_master *host);
 int nvhost_channel_ch_base(struct nvhost_master *host);
@@ -73,42 +73,62 @@ int nvhost_intr_release_time(void *ref, struct nvhost_timespec *ts)
 }
 
 /**
- * add a waiter to a waiter queue, sorted by threshold
- * returns true if it was added at the head of the queue
+ * add a waiter to a syncpoint's waiter tree, ordered by threshold. Waiters
+ * with equal thresholds keep their insertion order.
+ * returns true if it became the first waiter of the tree
  */
-static bool add_waiter_to_queue(struct nvhost_waitlist *waiter,
-				struct list_head *queue)
+static bool add_waiter_to_tree(struct nvhost_waitlist *waiter,
+				struct rb_root *root)
 {
-	struct nvhost_waitlist *pos;
+	struct rb_node **link = &root->rb_node, *parent = NULL;
 	u32 thresh = waiter->thresh;
+	bool leftmost = true;
 
-	list_for_each_entry_reverse(pos, queue, list)
+	while (*link) {
+		struct nvhost_waitlist *pos;
+
+		parent = *link;
+		pos = rb_entry(parent, struct nvhost_waitlist, node);
 		if ((s32)(pos->thresh - thresh) <= 0) {
-			list_add(&waiter->list, &pos->list);
-			return false;
+			link = &parent->rb_right;
+			leftmost = false;
+		} else {
+			link = &parent->rb_left;
 		}
+	}
+
+	rb_link_node(&waiter->node, parent, link);
+	rb_insert_color(&waiter->node, root);
+
+	return leftmost;
+}
+
+static inline struct nvhost_waitlist *first_waiter(struct rb_root *root)
+{
+	struct rb_node *node = rb_first(root);
 
-	list_add(&waiter->list, queue);
-	return true;
+	return node ? rb_entry(node, struct nvhost_waitlist, node) : NULL;
 }
 
 /**
- * run through a waiter queue for a single sync point ID
+ * run through the waiter tree for a single sync point ID
  * and gather all completed waiters into lists by actions
  */
-static void remove_completed_waiters(struct list_head *head, u32 sync,
+static void remove_completed_waiters(struct rb_root *root, u32 sync,
 			struct nvhost_timespec isr_recv,
 			struct list_head *completed[NVHOST_INTR_ACTION_COUNT])
 {
 	struct list_head *dest;
-	struct nvhost_waitlist *waiter, *next, *prev;
+	struct nvhost_waitlist *waiter, *prev;
 
-	list_for_each_entry_safe(waiter, next, head, list) {
+	while ((waiter = first_waiter(root))) {
 		bool removed = false;
 
 		if ((s32)(waiter->thresh - sync) > 0)
 			break;
 
+		rb_erase(&waiter->node, root);
+
 		waiter->isr_recv = isr_recv;
 		dest = *(completed + waiter->action);
 
@@ -131,18 +151,17 @@ static void remove_completed_waiters(struct list_head *head, u32 sync,
 		if ((atomic_inc_return(&waiter->state) == WLS_HANDLED)
 								|| removed) {
 			atomic_set(&waiter->state, WLS_CLEANUP);
-			list_move(&waiter->list, dest);
+			list_add(&waiter->list, dest);
 		} else
-			list_move_tail(&waiter->list, dest);
+			list_add_tail(&waiter->list, dest);
 	}
 }
 
 static void reset_threshold_interrupt(struct nvhost_intr *intr,
-			       struct list_head *head,
+			       struct rb_root *root,
 			       unsigned int id)
 {
-	u32 thresh = list_first_entry(head,
-				struct nvhost_waitlist, list)->thresh;
+	u32 thresh = first_waiter(root)->thresh;
 
 	intr_op().set_syncpt_threshold(intr, id, thresh);
 	intr_op().enable_syncpt_intr(intr, id);
@@ -166,6 +185,11 @@ static void action_submit_complete(struct nvhost_waitlist *waiter)
 		return;
 	}
 
+	if (waiter->isr_recv.clock == NVHOST_CLOCK_MONOTONIC)
+		channel->cdma.irq_ktime = timespec_to_ktime(waiter->isr_recv.ts);
+	else
+		channel->cdma.irq_ktime = ktime_get();
+
 	nvhost_cdma_update(&channel->cdma);
 	nvhost_module_idle_mult(channel->dev, nr_completed);
 
@@ -283,17 +307,17 @@ static int process_wait_list(struct nvhost_intr *intr,
 		completed[i] = syncpt->low_prio_handlers + j;
 
 	/* this functions fills completed data */
-	remove_completed_waiters(&syncpt->wait_head, threshold,
+	remove_completed_waiters(&syncpt->wait_tree, threshold,
 		syncpt->isr_recv, completed);
 
 	/* check if there are still waiters left */
-	empty = list_empty(&syncpt->wait_head);
+	empty = RB_EMPTY_ROOT(&syncpt->wait_tree);
 
 	/* if not, disable interrupt. If yes, update the inetrrupt */
 	if (empty)
 		intr_op().disable_syncpt_intr(intr, syncpt->id);
 	else
-		reset_threshold_interrupt(intr, &syncpt->wait_head,
+		reset_threshold_interrupt(intr, &syncpt->wait_tree,
 					  syncpt->id);
 
 	/* remove low priority handlers from this list */
@@ -384,17 +408,20 @@ bool nvhost_intr_has_pending_jobs(struct nvhost_intr *intr, u32 id,
 {
 	struct nvhost_intr_syncpt *syncpt;
 	struct nvhost_waitlist *waiter;
+	struct rb_node *node;
 	bool res = false;
 
 	syncpt = intr->syncpt + id;
 	spin_lock(&syncpt->lock);
-	list_for_each_entry(waiter, &syncpt->wait_head, list)
+	for (node = rb_first(&syncpt->wait_tree); node; node = rb_next(node)) {
+		waiter = rb_entry(node, struct nvhost_waitlist, node);
 		if (((waiter->action ==
 			NVHOST_INTR_ACTION_SUBMIT_COMPLETE) &&
 			(waiter->data != exclude_data))) {
 			res = true;
 			break;
 		}
+	}
 
 	spin_unlock(&syncpt->lock);
 
@@ -422,6 +449,7 @@ int nvhost_intr_add_action(struct nvhost_intr *intr, u32 id, u32 thresh,
 		return err;
 
 	/* initialize a new waiter */
+	RB_CLEAR_NODE(&waiter->node);
 	INIT_LIST_HEAD(&waiter->list);
 	init_waitqueue_head(&waiter->wq);
 	kref_init(&waiter->refcount);
@@ -438,9 +466,9 @@ int nvhost_intr_add_action(struct nvhost_intr *intr, u32 id, u32 thresh,
 
 	spin_lock(&syncpt->lock);
 
-	queue_was_empty = list_empty(&syncpt->wait_head);
+	queue_was_empty = RB_EMPTY_ROOT(&syncpt->wait_tree);
 
-	if (add_waiter_to_queue(waiter, &syncpt->wait_head)) {
+	if (add_waiter_to_tree(waiter, &syncpt->wait_tree)) {
 		/* added at head of list - new threshold value */
 		intr_op().set_syncpt_threshold(intr, id, thresh);
 
@@ -581,7 +609,7 @@ int nvhost_intr_init(struct nvhost_intr *intr, u32 irq_gen, u32 irq_sync)
 		syncpt->intr = &host->intr;
 		syncpt->id = id;
 		spin_lock_init(&syncpt->lock);
-		INIT_LIST_HEAD(&syncpt->wait_head);
+		syncpt->wait_tree = RB_ROOT;
 		snprintf(syncpt->thresh_irq_name,
 			sizeof(syncpt->thresh_irq_name),
 			"host_sp_%02d", id);
@@ -631,19 +659,22 @@ int nvhost_intr_stop(struct nvhost_intr *intr)
 	for (id = 0, syncpt = intr->syncpt;
 	     id < nb_pts;
 	     ++id, ++syncpt) {
-		struct nvhost_waitlist *waiter, *next;
+		struct nvhost_waitlist *waiter;
+		struct rb_node *node, *next;
 
 		intr_op().disable_syncpt_intr(intr, id);
 
-		list_for_each_entry_safe(waiter, next, &syncpt->wait_head, list) {
+		for (node = rb_first(&syncpt->wait_tree); node; node = next) {
+			next = rb_next(node);
+			waiter = rb_entry(node, struct nvhost_waitlist, node);
 			if (atomic_cmpxchg(&waiter->state, WLS_CANCELLED, WLS_HANDLED)
 				== WLS_CANCELLED) {
-				list_del(&waiter->list);
+				rb_erase(&waiter->node, &syncpt->wait_tree);
 				kref_put(&waiter->refcount, waiter_release);
 			}
 		}
 
-		if (!list_empty(&syncpt->wait_head)) {  /* output diagnostics */
+		if (!RB_EMPTY_ROOT(&syncpt->wait_tree)) {  /* output diagnostics */
 			intr_op().enable_syncpt_intr(intr, id);
 			mutex_unlock(&intr->mutex);
 			return -EBUSY;
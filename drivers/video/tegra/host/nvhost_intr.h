@@ -26,6 +26,7 @@
 #include <linux/interrupt.h>
 #include <linux/workqueue.h>
 #include <linux/spinlock.h>
+#include <linux/rbtree.h>
 #include <linux/version.h>
 #if LINUX_VERSION_CODE > KERNEL_VERSION(4, 13, 0)
 #include <linux/wait.h>
@@ -86,7 +87,8 @@ struct nvhost_intr;
 
 struct nvhost_waitlist {
 	struct nvhost_master *host;
-	struct list_head list;
+	struct rb_node node;		/* in nvhost_intr_syncpt.wait_tree */
+	struct list_head list;		/* in a completed list */
 	struct kref refcount;
 	u32 thresh;
 	enum nvhost_intr_action action;
@@ -108,7 +110,8 @@ struct nvhost_intr_syncpt {
 	struct nvhost_intr *intr;
 	u32 id;
 	spinlock_t lock;
-	struct list_head wait_head;
+	/* pending waiters, ordered by threshold */
+	struct rb_root wait_tree;
 	char thresh_irq_name[12];
 	struct nvhost_timespec isr_recv;
 	struct work_struct low_prio_work;
@@ -24,6 +24,8 @@
 #include <linux/vmalloc.h>
 #include <linux/sort.h>
 #include <linux/scatterlist.h>
+#include <linux/fs.h>
+#include <linux/sizes.h>
 #include <trace/events/nvhost.h>
 #include "nvhost_channel.h"
 #include "nvhost_vm.h"
@@ -96,6 +98,46 @@ static void init_fields(struct nvhost_job *job,
 	job->gather_addr_phys = &job->addr_phys[num_relocs];
 }
 
+void nvhost_job_pool_init(struct nvhost_job_pool *pool)
+{
+	spin_lock_init(&pool->lock);
+	pool->count = 0;
+}
+
+void nvhost_job_pool_drain(struct nvhost_job_pool *pool)
+{
+	spin_lock(&pool->lock);
+	while (pool->count)
+		kfree(pool->slots[--pool->count]);
+	spin_unlock(&pool->lock);
+}
+
+static void *job_pool_get(struct nvhost_job_pool *pool)
+{
+	void *mem = NULL;
+
+	spin_lock(&pool->lock);
+	if (pool->count)
+		mem = pool->slots[--pool->count];
+	spin_unlock(&pool->lock);
+
+	return mem;
+}
+
+static bool job_pool_put(struct nvhost_job_pool *pool, void *mem)
+{
+	bool stored = false;
+
+	spin_lock(&pool->lock);
+	if (pool->count < NVHOST_JOB_POOL_DEPTH) {
+		pool->slots[pool->count++] = mem;
+		stored = true;
+	}
+	spin_unlock(&pool->lock);
+
+	return stored;
+}
+
 struct nvhost_job *nvhost_job_alloc(struct nvhost_channel *ch,
 		int num_cmdbufs, int num_relocs, int num_waitchks,
 		int num_syncpts)
@@ -109,8 +151,12 @@ struct nvhost_job *nvhost_job_alloc(struct nvhost_channel *ch,
 		nvhost_err(&pdata->pdev->dev, "empty job requested");
 		return NULL;
 	}
-	if (size <= PAGE_SIZE * 2) {
-		job = kzalloc(size, GFP_KERNEL);
+	if (size <= NVHOST_JOB_POOL_SLOT_SIZE) {
+		job = job_pool_get(&ch->job_pool);
+		if (job)
+			memset(job, 0, size);
+		else
+			job = kzalloc(NVHOST_JOB_POOL_SLOT_SIZE, GFP_KERNEL);
 		if (!job) {
 			job = vzalloc(size);
 		}
@@ -128,6 +174,7 @@ struct nvhost_job *nvhost_job_alloc(struct nvhost_channel *ch,
 	kref_init(&job->ref);
 	job->ch = ch;
 	job->size = size;
+	job->priority = NVHOST_CHANNEL_PRIO_MEDIUM;
 
 	init_fields(job, num_cmdbufs, num_relocs, num_waitchks, num_syncpts);
 
@@ -173,10 +220,10 @@ static void job_free(struct kref *ref)
 
 	if (job->error_notifier_ref)
 		dma_buf_put(job->error_notifier_ref);
-	if (!is_vmalloc_addr(job))
-		kfree(job);
-	else
+	if (is_vmalloc_addr(job))
 		vfree(job);
+	else if (!job_pool_put(&ch->job_pool, job))
+		kfree(job);
 }
 
 void nvhost_job_put(struct nvhost_job *job)
@@ -211,6 +258,20 @@ void nvhost_job_add_gather(struct nvhost_job *job,
 	job->num_gathers += 1;
 }
 
+void nvhost_job_add_dependency(struct nvhost_job *job, struct nvhost_job *dep)
+{
+	int i;
+
+	for (i = 0; i < dep->num_syncpts; i++) {
+		struct nvhost_waitchk *wait = &job->waitchk[job->num_waitchk++];
+
+		wait->mem = 0;
+		wait->offset = 0;
+		wait->syncpt_id = dep->sp[i].id;
+		wait->thresh = dep->sp[i].fence;
+	}
+}
+
 void nvhost_job_set_notifier(struct nvhost_job *job, u32 error)
 {
 	struct nvhost_notification *error_notifier;
@@ -261,7 +322,146 @@ static int id_cmp(const void *_id1, const void *_id2)
 	return 0;
 }
 
+/* Upper bound on the memory kept mapped by each channel's pin cache */
+u32 nvhost_pin_cache_max_kb = SZ_64K;
+
+struct nvhost_pin_cache_entry {
+	struct list_head node;
+	struct dma_buf *buf;
+	struct device *dev;
+	enum dma_data_direction direction;
+	struct dma_buf_attachment *attach;
+	struct sg_table *sgt;
+	int users;
+};
+
+void nvhost_pin_cache_init(struct nvhost_pin_cache *cache)
+{
+	mutex_init(&cache->lock);
+	INIT_LIST_HEAD(&cache->entries);
+	cache->size = 0;
+}
+
+static void pin_cache_entry_free(struct nvhost_pin_cache *cache,
+		struct nvhost_pin_cache_entry *e)
+{
+	list_del(&e->node);
+	cache->size -= e->buf->size;
+	dma_buf_unmap_attachment(e->attach, e->sgt, e->direction);
+	dma_buf_detach(e->buf, e->attach);
+	dma_buf_put(e->buf);
+	kfree(e);
+}
+
+/*
+ * Drop idle entries whose buffer nobody but the cache refers to any more,
+ * and then the least recently used idle entries until the cache fits in
+ * limit bytes. Must be called with cache->lock held.
+ */
+static void pin_cache_reap_locked(struct nvhost_pin_cache *cache,
+		size_t limit)
+{
+	struct nvhost_pin_cache_entry *e, *tmp;
+
+	list_for_each_entry_safe_reverse(e, tmp, &cache->entries, node) {
+		if (e->users)
+			continue;
+		if (file_count(e->buf->file) == 1 || cache->size > limit)
+			pin_cache_entry_free(cache, e);
+	}
+}
+
+void nvhost_pin_cache_flush(struct nvhost_pin_cache *cache)
+{
+	struct nvhost_pin_cache_entry *e, *tmp;
+
+	mutex_lock(&cache->lock);
+	list_for_each_entry_safe(e, tmp, &cache->entries, node) {
+		WARN_ON(e->users);
+		pin_cache_entry_free(cache, e);
+	}
+	mutex_unlock(&cache->lock);
+}
+
+static struct nvhost_pin_cache_entry *pin_cache_get(
+		struct nvhost_pin_cache *cache, struct dma_buf *buf,
+		struct device *dev, enum dma_data_direction direction)
+{
+	struct nvhost_pin_cache_entry *e;
+
+	mutex_lock(&cache->lock);
+	list_for_each_entry(e, &cache->entries, node) {
+		if (e->buf == buf && e->dev == dev &&
+		    e->direction == direction) {
+			e->users++;
+			list_move(&e->node, &cache->entries);
+			mutex_unlock(&cache->lock);
+			return e;
+		}
+	}
+	mutex_unlock(&cache->lock);
+
+	return NULL;
+}
+
+/*
+ * Hand a freshly mapped attachment over to the cache. Returns NULL if it
+ * does not fit, in which case the caller keeps ownership of the mapping.
+ */
+static struct nvhost_pin_cache_entry *pin_cache_add(
+		struct nvhost_pin_cache *cache, struct dma_buf *buf,
+		struct device *dev, enum dma_data_direction direction,
+		struct dma_buf_attachment *attach, struct sg_table *sgt)
+{
+	size_t limit = (size_t)nvhost_pin_cache_max_kb << 10;
+	struct nvhost_pin_cache_entry *e;
+
+	if (buf->size > limit)
+		return NULL;
+
+	e = kzalloc(sizeof(*e), GFP_KERNEL);
+	if (!e)
+		return NULL;
+
+	mutex_lock(&cache->lock);
+	pin_cache_reap_locked(cache, limit - buf->size);
+	if (cache->size + buf->size > limit) {
+		mutex_unlock(&cache->lock);
+		kfree(e);
+		return NULL;
+	}
+
+	get_dma_buf(buf);
+	e->buf = buf;
+	e->dev = dev;
+	e->direction = direction;
+	e->attach = attach;
+	e->sgt = sgt;
+	e->users = 1;
+	list_add(&e->node, &cache->entries);
+	cache->size += buf->size;
+	mutex_unlock(&cache->lock);
+
+	return e;
+}
+
+static void unpin_one(struct nvhost_pin_cache *cache,
+		struct nvhost_job_unpin *unpin)
+{
+	if (unpin->cached) {
+		mutex_lock(&cache->lock);
+		unpin->cached->users--;
+		mutex_unlock(&cache->lock);
+	} else {
+		dma_buf_unmap_attachment(unpin->attach, unpin->sgt,
+					 unpin->direction);
+		dma_buf_detach(unpin->buf, unpin->attach);
+	}
+	dma_buf_put(unpin->buf);
+}
+
 static int pin_array_ids(struct platform_device *dev,
+		struct nvhost_pin_cache *cache,
 		struct nvhost_pinid *ids,
 		dma_addr_t *phys_addr,
 		u32 count,
@@ -271,6 +471,7 @@ static int pin_array_ids(struct platform_device *dev,
 	struct sg_table *sgt;
 	struct dma_buf *buf;
 	struct dma_buf_attachment *attach;
+	struct nvhost_pin_cache_entry *cached;
 	u32 prev_id = 0;
 	dma_addr_t prev_addr = 0;
 	int err = 0;
@@ -293,6 +494,14 @@ static int pin_array_ids(struct platform_device *dev,
 			goto clean_up;
 		}
 
+		cached = pin_cache_get(cache, buf, &dev->dev,
+				       ids[i].direction);
+		if (cached) {
+			attach = cached->attach;
+			sgt = cached->sgt;
+			goto pinned;
+		}
+
 		attach = dma_buf_attach(buf, &dev->dev);
 		if (IS_ERR(attach)) {
 			err = PTR_ERR(attach);
@@ -318,10 +527,14 @@ static int pin_array_ids(struct platform_device *dev,
 		if (!sg_dma_address(sgt->sgl))
 			sg_dma_address(sgt->sgl) = sg_phys(sgt->sgl);
 
+		cached = pin_cache_add(cache, buf, &dev->dev,
+				       ids[i].direction, attach, sgt);
+pinned:
 		phys_addr[ids[i].index] = sg_dma_address(sgt->sgl);
 		unpin_data[pin_count].buf = buf;
 		unpin_data[pin_count].attach = attach;
 		unpin_data[pin_count].direction = ids[i].direction;
+		unpin_data[pin_count].cached = cached;
 		unpin_data[pin_count++].sgt = sgt;
 
 		prev_id = ids[i].id;
@@ -336,12 +549,8 @@ clean_up_map:
 clean_up_attach:
 	dma_buf_put(buf);
 clean_up:
-	for (i = 0; i < pin_count; i++) {
-		dma_buf_unmap_attachment(unpin_data[i].attach,
-			unpin_data[i].sgt, unpin_data[i].direction);
-		dma_buf_detach(unpin_data[i].buf, unpin_data[i].attach);
-		dma_buf_put(unpin_data[i].buf);
-	}
+	for (i = 0; i < pin_count; i++)
+		unpin_one(cache, &unpin_data[i]);
 
 	return err;
 }
@@ -367,7 +576,7 @@ static int pin_job_mem(struct nvhost_job *job)
 	}
 
 	/* validate array and pin unique ids, get refs for reloc unpinning */
-	result = pin_array_ids(job->ch->vm->pdev,
+	result = pin_array_ids(job->ch->vm->pdev, &job->ch->pin_cache,
 		job->pin_ids, job->addr_phys,
 		job->num_relocs,
 		job->unpins);
@@ -386,6 +595,7 @@ static int pin_job_mem(struct nvhost_job *job)
 
 	/* validate array and pin unique ids, get refs for gather unpinning */
 	result = pin_array_ids(nvhost_get_host(job->ch->dev)->dev,
+		&job->ch->pin_cache,
 		&job->pin_ids[job->num_relocs],
 		&job->addr_phys[job->num_relocs],
 		job->num_gathers,
@@ -400,22 +610,191 @@ static int pin_job_mem(struct nvhost_job *job)
 	return result;
 }
 
+/* Value last patched at one relocation offset of a recorded buffer */
+struct reloc_record_word {
+	u32 offset;
+	u32 value;
+};
+
+#define RELOC_RECORD_WORDS_MAX		4096
+
+struct reloc_record {
+	struct list_head node;
+	struct dma_buf *buf;
+	struct reloc_record_word *words;
+	u32 num_words;
+	u32 max_words;
+	u32 cursor;			/* word after the last lookup hit */
+};
+
+void nvhost_reloc_records_init(struct nvhost_reloc_records *records)
+{
+	mutex_init(&records->lock);
+	INIT_LIST_HEAD(&records->buffers);
+	records->count = 0;
+}
+
+static struct reloc_record *reloc_record_find(
+		struct nvhost_reloc_records *records, struct dma_buf *buf)
+{
+	struct reloc_record *rec;
+
+	list_for_each_entry(rec, &records->buffers, node)
+		if (rec->buf == buf)
+			return rec;
+
+	return NULL;
+}
+
+static void reloc_record_free(struct nvhost_reloc_records *records,
+		struct reloc_record *rec)
+{
+	list_del(&rec->node);
+	records->count--;
+	dma_buf_put(rec->buf);
+	kfree(rec->words);
+	kfree(rec);
+}
+
+int nvhost_reloc_records_add(struct nvhost_reloc_records *records,
+			     struct dma_buf *buf)
+{
+	struct reloc_record *rec;
+	int err = 0;
+
+	mutex_lock(&records->lock);
+	if (reloc_record_find(records, buf))
+		goto out;
+
+	if (records->count >= NVHOST_RELOC_RECORDS_MAX) {
+		err = -ENOSPC;
+		goto out;
+	}
+
+	rec = kzalloc(sizeof(*rec), GFP_KERNEL);
+	if (!rec) {
+		err = -ENOMEM;
+		goto out;
+	}
+
+	get_dma_buf(buf);
+	rec->buf = buf;
+	list_add(&rec->node, &records->buffers);
+	records->count++;
+out:
+	mutex_unlock(&records->lock);
+	return err;
+}
+
+int nvhost_reloc_records_remove(struct nvhost_reloc_records *records,
+				struct dma_buf *buf)
+{
+	struct reloc_record *rec;
+	int err = 0;
+
+	mutex_lock(&records->lock);
+	rec = reloc_record_find(records, buf);
+	if (rec)
+		reloc_record_free(records, rec);
+	else
+		err = -ENOENT;
+	mutex_unlock(&records->lock);
+
+	return err;
+}
+
+void nvhost_reloc_records_flush(struct nvhost_reloc_records *records)
+{
+	struct reloc_record *rec, *tmp;
+
+	mutex_lock(&records->lock);
+	list_for_each_entry_safe(rec, tmp, &records->buffers, node)
+		reloc_record_free(records, rec);
+	mutex_unlock(&records->lock);
+}
+
+/*
+ * Find the word recorded at offset. Relocations come in the same order on
+ * every submit of an unchanged stream, so the word following the previous
+ * hit is tried first.
+ */
+static struct reloc_record_word *reloc_record_lookup(struct reloc_record *rec,
+		u32 offset)
+{
+	u32 i;
+
+	if (rec->cursor < rec->num_words &&
+	    rec->words[rec->cursor].offset == offset)
+		return &rec->words[rec->cursor++];
+
+	for (i = 0; i < rec->num_words; i++) {
+		if (rec->words[i].offset == offset) {
+			rec->cursor = i + 1;
+			return &rec->words[i];
+		}
+	}
+
+	return NULL;
+}
+
+/*
+ * Remember the value patched at offset. Words that cannot be recorded are
+ * simply patched again on the next submit.
+ */
+static void reloc_record_store(struct reloc_record *rec,
+		struct reloc_record_word *word, u32 offset, u32 value)
+{
+	if (!word) {
+		if (rec->num_words == rec->max_words) {
+			struct reloc_record_word *words;
+			u32 max = max_t(u32, rec->max_words * 2, 16);
+
+			if (max > RELOC_RECORD_WORDS_MAX)
+				return;
+
+			words = krealloc(rec->words, max * sizeof(*words),
+					 GFP_KERNEL);
+			if (!words)
+				return;
+
+			rec->words = words;
+			rec->max_words = max;
+		}
+		word = &rec->words[rec->num_words++];
+		word->offset = offset;
+	}
+
+	word->value = value;
+}
+
 static int do_relocs(struct nvhost_job *job,
 		u32 cmdbuf_mem, struct dma_buf *buf)
 {
 	struct nvhost_device_data *pdata = platform_get_drvdata(job->ch->dev);
+	struct reloc_record *rec = NULL;
 	int i = 0;
 	int last_page = -1;
 	size_t last_offset;
 	void *cmdbuf_page_addr = NULL;
 	dma_addr_t phys_addr;
-	int err;
+	int err = 0;
+
+	if (job->reloc_records) {
+		mutex_lock(&job->reloc_records->lock);
+		rec = reloc_record_find(job->reloc_records, buf);
+		if (rec)
+			rec->cursor = 0;
+		else
+			mutex_unlock(&job->reloc_records->lock);
+	}
 
 	/* pin & patch the relocs for one gather */
 	while (i < job->num_relocs) {
 		struct nvhost_reloc *reloc = &job->relocarray[i];
 		struct nvhost_reloc_shift *shift = &job->relocshiftarray[i];
 		struct nvhost_reloc_type *type = &job->reloctypearray[i];
+		struct reloc_record_word *word = NULL;
+		u32 value;
 
 		/* skip all other gathers */
 		if (cmdbuf_mem != reloc->cmdbuf_mem) {
@@ -428,7 +807,24 @@ static int do_relocs(struct nvhost_job *job,
 			nvhost_err(&pdata->pdev->dev,
 				   "invalid cmdbuf_offset=0x%x",
 				   reloc->cmdbuf_offset);
-			return -EINVAL;
+			err = -EINVAL;
+			goto out;
+		}
+
+		if (pdata->get_reloc_phys_addr)
+			phys_addr = pdata->get_reloc_phys_addr(
+						job->reloc_addr_phys[i],
+						type->reloc_type);
+		else
+			phys_addr = job->reloc_addr_phys[i];
+
+		value = (phys_addr + reloc->target_offset) >> shift->shift;
+
+		/* recorded buffer already holds this address */
+		if (rec) {
+			word = reloc_record_lookup(rec, reloc->cmdbuf_offset);
+			if (word && word->value == value)
+				goto done;
 		}
 
 		if (last_page != reloc->cmdbuf_offset >> PAGE_SHIFT) {
@@ -446,7 +842,8 @@ static int do_relocs(struct nvhost_job *job,
 
 			if (unlikely(!cmdbuf_page_addr)) {
 				pr_err("Couldn't map cmdbuf for relocation\n");
-				return -ENOMEM;
+				err = -ENOMEM;
+				goto out;
 			}
 
 			err = dma_buf_begin_cpu_access(buf, last_offset,
@@ -455,23 +852,22 @@ static int do_relocs(struct nvhost_job *job,
 				nvhost_err(&pdata->pdev->dev,
 					"begin_cpu_access() failed for patching reloc %d",
 					err);
-				return err;
+				dma_buf_kunmap(buf, last_page,
+						cmdbuf_page_addr);
+				cmdbuf_page_addr = NULL;
+				goto out;
 			}
 		}
 
-		if (pdata->get_reloc_phys_addr)
-			phys_addr = pdata->get_reloc_phys_addr(
-						job->reloc_addr_phys[i],
-						type->reloc_type);
-		else
-			phys_addr = job->reloc_addr_phys[i];
-
-		__raw_writel(
-			(phys_addr +
-				reloc->target_offset) >> shift->shift,
+		__raw_writel(value,
 			(void __iomem *)(cmdbuf_page_addr +
 				(reloc->cmdbuf_offset & ~PAGE_MASK)));
 
+		if (rec)
+			reloc_record_store(rec, word, reloc->cmdbuf_offset,
+					   value);
+
+done:
 		/* remove completed reloc from the job */
 		if (i != job->num_relocs - 1) {
 			struct nvhost_reloc *reloc_last =
@@ -494,13 +890,17 @@ static int do_relocs(struct nvhost_job *job,
 		}
 	}
 
+out:
 	if (cmdbuf_page_addr) {
 		dma_buf_kunmap(buf, last_page, cmdbuf_page_addr);
 		dma_buf_end_cpu_access(buf, last_offset,
 				PAGE_SIZE, DMA_TO_DEVICE);
 	}
 
-	return 0;
+	if (rec)
+		mutex_unlock(&job->reloc_records->lock);
+
+	return err;
 }
 
 
@@ -558,17 +958,25 @@ fail:
 
 void nvhost_job_unpin(struct nvhost_job *job)
 {
+	struct nvhost_pin_cache *cache = &job->ch->pin_cache;
+	bool cached = false;
 	int i;
 
 	for (i = 0; i < job->num_unpins; i++) {
 		struct nvhost_job_unpin *unpin = &job->unpins[i];
 
-		dma_buf_unmap_attachment(unpin->attach, unpin->sgt,
-					 unpin->direction);
-		dma_buf_detach(unpin->buf, unpin->attach);
-		dma_buf_put(unpin->buf);
+		cached |= !!unpin->cached;
+		unpin_one(cache, unpin);
 	}
 	job->num_unpins = 0;
+
+	/* let go of cached buffers that were released while we held them */
+	if (cached) {
+		mutex_lock(&cache->lock);
+		pin_cache_reap_locked(cache,
+				(size_t)nvhost_pin_cache_max_kb << 10);
+		mutex_unlock(&cache->lock);
+	}
 }
 
 /**
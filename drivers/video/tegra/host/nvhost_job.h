@@ -23,7 +23,10 @@
 
 #include <uapi/linux/nvhost_ioctl.h>
 #include <linux/kref.h>
+#include <linux/mutex.h>
+#include <linux/spinlock.h>
 #include <linux/dma-buf.h>
+#include <linux/ktime.h>
 
 struct nvhost_channel;
 struct nvhost_waitchk;
@@ -53,13 +56,74 @@ struct nvhost_pinid {
 	enum dma_data_direction direction;
 };
 
+struct nvhost_pin_cache_entry;
+
 struct nvhost_job_unpin {
 	struct sg_table *sgt;
 	struct dma_buf *buf;
 	struct dma_buf_attachment *attach;
 	enum dma_data_direction direction;
+	/* set when the mapping is owned by the channel pin cache */
+	struct nvhost_pin_cache_entry *cached;
+};
+
+/*
+ * Per-channel cache of dma-buf attachments. Entries keep a buffer attached
+ * and mapped after the job that pinned it completes, so that the next job
+ * using the same buffer skips attach and map. An entry is dropped once the
+ * cache holds the only reference left to the buffer, when the cache grows
+ * beyond nvhost_pin_cache_max_kb or when the channel is unmapped.
+ */
+struct nvhost_pin_cache {
+	struct mutex lock;
+	struct list_head entries;	/* most recently used first */
+	size_t size;
+};
+
+extern u32 nvhost_pin_cache_max_kb;
+
+/*
+ * Per-channel pool of job allocations. Every job small enough for a pool
+ * slot is allocated at slot size, so any of them can be recycled for the
+ * next submit on the channel instead of going back to the heap.
+ */
+#define NVHOST_JOB_POOL_SLOT_SIZE	(PAGE_SIZE * 2)
+#define NVHOST_JOB_POOL_DEPTH		16
+
+struct nvhost_job_pool {
+	spinlock_t lock;
+	int count;
+	void *slots[NVHOST_JOB_POOL_DEPTH];
+};
+
+void nvhost_job_pool_init(struct nvhost_job_pool *pool);
+void nvhost_job_pool_drain(struct nvhost_job_pool *pool);
+
+void nvhost_pin_cache_init(struct nvhost_pin_cache *cache);
+void nvhost_pin_cache_flush(struct nvhost_pin_cache *cache);
+
+/*
+ * Per-client set of recorded command buffers. For each recorded buffer the
+ * value last patched at every relocation offset is kept, and relocations
+ * whose target address did not change are not patched again. Combined with
+ * the pin cache this turns repeated submits of an unchanged command stream
+ * into a compare of the relocation table without touching the buffer.
+ */
+#define NVHOST_RELOC_RECORDS_MAX	64
+
+struct nvhost_reloc_records {
+	struct mutex lock;
+	struct list_head buffers;
+	int count;
 };
 
+void nvhost_reloc_records_init(struct nvhost_reloc_records *records);
+int nvhost_reloc_records_add(struct nvhost_reloc_records *records,
+			     struct dma_buf *buf);
+int nvhost_reloc_records_remove(struct nvhost_reloc_records *records,
+				struct dma_buf *buf);
+void nvhost_reloc_records_flush(struct nvhost_reloc_records *records);
+
 /*
  * Each submit is tracked as a nvhost_job.
  */
@@ -118,10 +182,20 @@ struct nvhost_job {
 	/* Set to true to force an added wait-for-idle before the job */
 	int serialize;
 
+	/* Scheduling level (enum nvhost_channel_prio) */
+	int priority;
+
+	/* Time the job was handed to the channel and pushed to hardware */
+	ktime_t queue_ktime;
+	ktime_t submit_ktime;
+
 	/* error notifiers used channel submit timeout */
 	struct dma_buf *error_notifier_ref;
 	u64 error_notifier_offset;
 
+	/* recorded command buffers of the submitting client, if any */
+	struct nvhost_reloc_records *reloc_records;
+
 	/* engine job timestamps */
 	struct {
 		dma_addr_t dma;
@@ -135,6 +209,13 @@ struct nvhost_job {
 void nvhost_job_add_gather(struct nvhost_job *job,
 		u32 mem_id, u32 words, u32 offset, u32 class_id, int pre_fence);
 
+/*
+ * Make job wait for all syncpoint increments of dep. Must be called after
+ * dep's fences have been assigned, and job must have been allocated with
+ * room for dep->num_syncpts extra wait checks.
+ */
+void nvhost_job_add_dependency(struct nvhost_job *job, struct nvhost_job *dep);
+
 /*
  * Increment reference going to nvhost_job.
  */
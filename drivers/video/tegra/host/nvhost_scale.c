@@ -170,6 +170,13 @@ static int nvhost_scale_target(struct device *dev, unsigned long *freq,
 {
 	struct nvhost_device_data *pdata = dev_get_drvdata(dev);
 	struct nvhost_device_profile *profile = pdata->power_profile;
+	unsigned long floor = max(READ_ONCE(profile->predict.floor),
+				  READ_ONCE(profile->frame_floor));
+
+	/* predicted burst is due or a client has a frame deadline to
+	 * meet, don't let the governor go below it */
+	if (*freq < floor)
+		*freq = floor;
 
 	*freq = clk_round_rate(profile->clk, *freq);
 	if (clk_get_rate(profile->clk) == *freq)
@@ -260,6 +267,225 @@ void nvhost_scale_notify_busy(struct platform_device *pdev)
 	nvhost_scale_notify(pdev, true);
 }
 
+/* Bursts further apart than this do not form a periodic load */
+#define PREDICT_PERIOD_MIN_US	4000
+#define PREDICT_PERIOD_MAX_US	100000
+#define PREDICT_LEAD_US		2000
+
+static void nvhost_scale_predict_update(struct nvhost_device_profile *profile)
+{
+	struct nvhost_device_data *pdata = platform_get_drvdata(profile->pdev);
+	struct devfreq *devfreq = pdata->power_manager;
+
+	mutex_lock(&devfreq->lock);
+#if defined(CONFIG_PM_DEVFREQ)
+	update_devfreq(devfreq);
+#endif
+	mutex_unlock(&devfreq->lock);
+}
+
+static void nvhost_scale_predict_boost(struct work_struct *work)
+{
+	struct nvhost_device_profile *profile = container_of(work,
+			struct nvhost_device_profile, predict.boost_work.work);
+	struct nvhost_scale_predictor *p = &profile->predict;
+	unsigned long flags;
+	u32 hold_us;
+
+	spin_lock_irqsave(&p->lock, flags);
+	WRITE_ONCE(p->floor, p->burst_freq);
+	hold_us = p->lead_us + p->busy_us + p->jitter_us;
+	spin_unlock_irqrestore(&p->lock, flags);
+
+	nvhost_scale_predict_update(profile);
+
+	mod_delayed_work(system_wq, &p->decay_work, usecs_to_jiffies(hold_us));
+}
+
+static void nvhost_scale_predict_decay(struct work_struct *work)
+{
+	struct nvhost_device_profile *profile = container_of(work,
+			struct nvhost_device_profile, predict.decay_work.work);
+
+	WRITE_ONCE(profile->predict.floor, 0);
+	nvhost_scale_predict_update(profile);
+}
+
+static struct nvhost_scale_predictor *nvhost_scale_predictor(
+		struct platform_device *pdev)
+{
+	struct nvhost_device_data *pdata = platform_get_drvdata(pdev);
+	struct nvhost_device_profile *profile = pdata->power_profile;
+
+	if (!profile || !pdata->power_manager || !profile->predict.enabled)
+		return NULL;
+
+	return &profile->predict;
+}
+
+/*
+ * nvhost_scale_predict_busy(pdev)
+ *
+ * Marks the start of a burst. The interval since the previous burst start
+ * updates the period estimate; an interval out of range resets it.
+ */
+
+void nvhost_scale_predict_busy(struct platform_device *pdev)
+{
+	struct nvhost_scale_predictor *p = nvhost_scale_predictor(pdev);
+	unsigned long flags;
+	ktime_t now;
+	s64 interval;
+
+	if (!p)
+		return;
+
+	spin_lock_irqsave(&p->lock, flags);
+	if (p->active) {
+		spin_unlock_irqrestore(&p->lock, flags);
+		return;
+	}
+
+	now = ktime_get();
+	p->active = true;
+	interval = ktime_us_delta(now, p->burst_start);
+
+	if (interval < PREDICT_PERIOD_MIN_US ||
+	    interval > PREDICT_PERIOD_MAX_US) {
+		p->period_us = 0;
+		p->jitter_us = 0;
+	} else if (!p->period_us) {
+		p->period_us = interval;
+	} else {
+		s32 delta = (s32)interval - (s32)p->period_us;
+
+		p->jitter_us = (s32)p->jitter_us +
+			((s32)abs(delta) - (s32)p->jitter_us) / 4;
+		p->period_us = (s32)p->period_us + delta / 8;
+	}
+	p->burst_start = now;
+	spin_unlock_irqrestore(&p->lock, flags);
+}
+
+/*
+ * nvhost_scale_predict_idle(pdev)
+ *
+ * Marks the end of a burst. If the period is stable, the boost for the
+ * next burst is scheduled lead_us before it is due.
+ */
+
+void nvhost_scale_predict_idle(struct platform_device *pdev)
+{
+	struct nvhost_device_data *pdata = platform_get_drvdata(pdev);
+	struct nvhost_scale_predictor *p = nvhost_scale_predictor(pdev);
+	unsigned long flags;
+	s64 busy, delay = -1;
+	ktime_t now;
+
+	if (!p)
+		return;
+
+	spin_lock_irqsave(&p->lock, flags);
+	if (!p->active) {
+		spin_unlock_irqrestore(&p->lock, flags);
+		return;
+	}
+
+	now = ktime_get();
+	p->active = false;
+	busy = ktime_us_delta(now, p->burst_start);
+	p->busy_us = (s32)p->busy_us + ((s32)busy - (s32)p->busy_us) / 4;
+	p->burst_freq = pdata->power_manager->previous_freq;
+
+	if (p->period_us && p->jitter_us < p->period_us / 8 &&
+	    p->busy_us < p->period_us)
+		delay = (s64)p->period_us - p->lead_us - busy;
+	spin_unlock_irqrestore(&p->lock, flags);
+
+	if (delay > 0)
+		mod_delayed_work(system_wq, &p->boost_work,
+				 usecs_to_jiffies(delay));
+}
+
+static void nvhost_scale_frame_expire(struct work_struct *work)
+{
+	struct nvhost_device_profile *profile = container_of(work,
+			struct nvhost_device_profile, frame_work.work);
+
+	WRITE_ONCE(profile->frame_floor, 0);
+	nvhost_scale_predict_update(profile);
+}
+
+/*
+ * nvhost_scale_frame_hint(pdev, freq, deadline_us)
+ *
+ * Called by a client that knows its next frame needs the engine at freq
+ * or faster to complete in time. The clock is kept at or above freq
+ * until deadline_us from now, without waiting for actmon to see the load.
+ * A new hint replaces the previous one, freq 0 drops it. May sleep.
+ */
+
+void nvhost_scale_frame_hint(struct platform_device *pdev, unsigned long freq,
+			     u32 deadline_us)
+{
+	struct nvhost_device_data *pdata = platform_get_drvdata(pdev);
+	struct nvhost_device_profile *profile = pdata->power_profile;
+
+	if (!profile || !pdata->power_manager)
+		return;
+
+	if (!freq || !deadline_us) {
+		cancel_delayed_work(&profile->frame_work);
+		freq = 0;
+	} else {
+		mod_delayed_work(system_wq, &profile->frame_work,
+				 usecs_to_jiffies(deadline_us));
+	}
+
+	if (READ_ONCE(profile->frame_floor) == freq)
+		return;
+
+	WRITE_ONCE(profile->frame_floor, freq);
+	nvhost_scale_predict_update(profile);
+}
+
+static void nvhost_scale_predict_init(struct nvhost_device_profile *profile)
+{
+	struct nvhost_device_data *pdata = platform_get_drvdata(profile->pdev);
+	struct nvhost_scale_predictor *p = &profile->predict;
+
+	spin_lock_init(&p->lock);
+	p->lead_us = PREDICT_LEAD_US;
+	INIT_DELAYED_WORK(&p->boost_work, nvhost_scale_predict_boost);
+	INIT_DELAYED_WORK(&p->decay_work, nvhost_scale_predict_decay);
+
+	if (IS_ERR_OR_NULL(pdata->debugfs))
+		return;
+
+	p->debugfs = debugfs_create_dir("predict", pdata->debugfs);
+	if (IS_ERR_OR_NULL(p->debugfs))
+		return;
+
+	debugfs_create_bool("enable", S_IRUGO | S_IWUSR, p->debugfs,
+			    &p->enabled);
+	debugfs_create_u32("lead_us", S_IRUGO | S_IWUSR, p->debugfs,
+			   &p->lead_us);
+	debugfs_create_u32("period_us", S_IRUGO, p->debugfs, &p->period_us);
+	debugfs_create_u32("jitter_us", S_IRUGO, p->debugfs, &p->jitter_us);
+	debugfs_create_u32("busy_us", S_IRUGO, p->debugfs, &p->busy_us);
+}
+
+static void nvhost_scale_predict_deinit(struct nvhost_device_profile *profile)
+{
+	struct nvhost_scale_predictor *p = &profile->predict;
+
+	p->enabled = false;
+	debugfs_remove_recursive(p->debugfs);
+	p->debugfs = NULL;
+	cancel_delayed_work_sync(&p->boost_work);
+	cancel_delayed_work_sync(&p->decay_work);
+}
+
 /*
  * nvhost_scale_get_dev_status(dev, *stat)
  *
@@ -447,6 +673,12 @@ void nvhost_scale_init(struct platform_device *pdev)
 			nvhost_err(&pdev->dev,
 				"failed to register devfreq as acm client");
 		}
+
+		if (devfreq) {
+			INIT_DELAYED_WORK(&profile->frame_work,
+					  nvhost_scale_frame_expire);
+			nvhost_scale_predict_init(profile);
+		}
 	}
 
 	nvhost_module_idle(nvhost_get_host(pdev)->dev);
@@ -479,6 +711,11 @@ void nvhost_scale_deinit(struct platform_device *pdev)
 	if (!profile)
 		return;
 
+	if (pdata->power_manager) {
+		nvhost_scale_predict_deinit(profile);
+		cancel_delayed_work_sync(&profile->frame_work);
+	}
+
 	/* Remove devfreq from acm client list */
 	nvhost_module_remove_client(pdev, pdata->power_manager);
 
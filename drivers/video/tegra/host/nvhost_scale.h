@@ -23,10 +23,35 @@
 
 #include <linux/nvhost.h>
 #include <linux/devfreq.h>
+#include <linux/workqueue.h>
 
 struct platform_device;
 struct host1x_actmon;
 struct clk;
+struct dentry;
+
+/*
+ * Periodic load predictor. Learns the interval between busy bursts and,
+ * once it is stable, raises the clock floor to the frequency the previous
+ * burst ended at shortly before the next burst is due. The floor is dropped
+ * again after the expected burst length, so the governor can decay the
+ * clock in between.
+ */
+struct nvhost_scale_predictor {
+	bool				enabled;
+	u32				lead_us;	/* boost this early */
+	spinlock_t			lock;
+	bool				active;		/* inside a burst */
+	ktime_t				burst_start;
+	u32				period_us;	/* smoothed interval */
+	u32				jitter_us;	/* smoothed deviation */
+	u32				busy_us;	/* smoothed length */
+	unsigned long			burst_freq;
+	unsigned long			floor;
+	struct delayed_work		boost_work;
+	struct delayed_work		decay_work;
+	struct dentry			*debugfs;
+};
 
 /*
  * profile_rec - Device specific power management variables
@@ -48,6 +73,12 @@ struct nvhost_device_profile {
 	void				*private_data;
 	struct notifier_block		qos_notify_block;
 	int				num_actmons;
+
+	struct nvhost_scale_predictor	predict;
+
+	/* floor requested by a client for its current frame */
+	unsigned long			frame_floor;
+	struct delayed_work		frame_work;
 };
 
 #if defined(CONFIG_TEGRA_GRHOST_SCALE)
@@ -62,6 +93,14 @@ void nvhost_scale_deinit(struct platform_device *);
 void nvhost_scale_notify_busy(struct platform_device *);
 void nvhost_scale_notify_idle(struct platform_device *);
 
+/* burst start and end, used by the load predictor */
+void nvhost_scale_predict_busy(struct platform_device *);
+void nvhost_scale_predict_idle(struct platform_device *);
+
+/* clock floor a client needs to meet its frame deadline */
+void nvhost_scale_frame_hint(struct platform_device *, unsigned long freq,
+			     u32 deadline_us);
+
 int nvhost_scale_hw_init(struct platform_device *);
 void nvhost_scale_hw_deinit(struct platform_device *);
 
@@ -72,6 +111,11 @@ static inline void nvhost_scale_init(struct platform_device *d) { }
 static inline void nvhost_scale_deinit(struct platform_device *d) { }
 static inline void nvhost_scale_notify_busy(struct platform_device *d) { }
 static inline void nvhost_scale_notify_idle(struct platform_device *d) { }
+static inline void nvhost_scale_predict_busy(struct platform_device *d) { }
+static inline void nvhost_scale_predict_idle(struct platform_device *d) { }
+static inline void nvhost_scale_frame_hint(struct platform_device *d,
+					   unsigned long freq,
+					   u32 deadline_us) { }
 static inline int nvhost_scale_hw_init(struct platform_device *d)
 {
 	return 0;
@@ -26,6 +26,8 @@
 #include <linux/export.h>
 #include <linux/delay.h>
 #include <linux/nospec.h>
+#include <linux/cpu.h>
+#include <linux/pm_qos.h>
 #include <trace/events/nvhost.h>
 #include <soc/tegra/chip-id.h>
 #include "nvhost_syncpt.h"
@@ -213,12 +215,92 @@ static bool syncpt_update_min_is_expired(
 	return nvhost_syncpt_is_expired(sp, id, thresh);
 }
 
+/* Upper bound on the busy-wait phase of low latency waits */
+u32 nvhost_syncpt_spin_max_us = 50;
+
+/**
+ * Fold the latency of a wait that had to block into the syncpoint's
+ * running average. Lost updates from concurrent waiters are harmless.
+ */
+static void syncpt_wait_record(struct nvhost_syncpt *sp, u32 id,
+			ktime_t start)
+{
+	s64 ns = ktime_to_ns(ktime_sub(ktime_get(), start));
+	u32 avg = atomic_read(&sp->wait_ns[id]);
+
+	ns = clamp_t(s64, ns, 0, SYNCPT_WAIT_NS_MAX);
+	atomic_set(&sp->wait_ns[id], avg - (avg >> 3) + ((u32)ns >> 3));
+}
+
+/**
+ * Busy-wait for up to twice the recent average wait latency. Syncpoints
+ * that usually take longer than nvhost_syncpt_spin_max_us are not worth
+ * spinning on at all. Returns true if the threshold was reached.
+ */
+static bool syncpt_wait_spin(struct nvhost_syncpt *sp, u32 id, u32 thresh,
+			bool (*syncpt_is_expired)(struct nvhost_syncpt *sp,
+						  u32 id, u32 thresh))
+{
+	u64 max_ns = (u64)nvhost_syncpt_spin_max_us * NSEC_PER_USEC;
+	u64 avg = atomic_read(&sp->wait_ns[id]);
+	ktime_t end;
+
+	if (!avg || avg > max_ns)
+		return false;
+
+	end = ktime_add_ns(ktime_get(), min(2 * avg, max_ns));
+	do {
+		if (syncpt_is_expired(sp, id, thresh))
+			return true;
+		cpu_relax();
+	} while (!need_resched() && ktime_before(ktime_get(), end));
+
+	return false;
+}
+
+/* Blocking waits expected to be shorter than this get an idle hint */
+u32 nvhost_syncpt_idle_hint_max_us = 1000;
+
+/**
+ * A CPU that blocks on a short hardware job would spend longer leaving a
+ * deep idle state than waiting. Cap the resume latency of this CPU at
+ * half the recent average wait on the syncpoint, so that cpuidle picks a
+ * shallow state. Returns true if the request was added.
+ */
+static bool syncpt_wait_idle_hint(struct nvhost_syncpt *sp, u32 id,
+			struct dev_pm_qos_request *req)
+{
+	u64 max_ns = (u64)nvhost_syncpt_idle_hint_max_us * NSEC_PER_USEC;
+	u32 avg = atomic_read(&sp->wait_ns[id]);
+	struct device *cpu_dev;
+
+	if (!avg || avg > max_ns)
+		return false;
+
+	cpu_dev = get_cpu_device(raw_smp_processor_id());
+	if (!cpu_dev)
+		return false;
+
+	/* 0 would mean no constraint */
+	return dev_pm_qos_add_request(cpu_dev, req, DEV_PM_QOS_RESUME_LATENCY,
+			max_t(u32, avg / (2 * NSEC_PER_USEC), 1)) >= 0;
+}
+
 /**
  * Main entrypoint for syncpoint value waits.
  */
 int nvhost_syncpt_wait_timeout(struct nvhost_syncpt *sp, u32 id,
 			u32 thresh, u32 timeout, u32 *value,
 			struct nvhost_timespec *ts, bool interruptible)
+{
+	return nvhost_syncpt_wait_timeout_mode(sp, id, thresh, timeout, value,
+					       ts, interruptible, false);
+}
+
+int nvhost_syncpt_wait_timeout_mode(struct nvhost_syncpt *sp, u32 id,
+			u32 thresh, u32 timeout, u32 *value,
+			struct nvhost_timespec *ts, bool interruptible,
+			bool low_latency)
 {
 	void *ref = NULL;
 	struct nvhost_waitlist *waiter = NULL;
@@ -229,6 +311,9 @@ int nvhost_syncpt_wait_timeout(struct nvhost_syncpt *sp, u32 id,
 	bool (*syncpt_is_expired)(struct nvhost_syncpt *sp,
 			u32 id,
 			u32 thresh);
+	ktime_t start;
+	struct dev_pm_qos_request idle_req = {};
+	bool idle_hint = false;
 
 	sp = nvhost_get_syncpt_owner_struct(id, sp);
 	host = syncpt_to_dev(sp);
@@ -281,6 +366,24 @@ int nvhost_syncpt_wait_timeout(struct nvhost_syncpt *sp, u32 id,
 		goto done;
 	}
 
+	start = ktime_get();
+
+	if (nvhost_dev_is_virtual(host->dev))
+		syncpt_is_expired = nvhost_syncpt_is_expired;
+	else
+		syncpt_is_expired = syncpt_update_min_is_expired;
+
+	/* short jobs finish before an interrupt would even be delivered */
+	if (low_latency &&
+	    syncpt_wait_spin(sp, id, thresh, syncpt_is_expired)) {
+		syncpt_wait_record(sp, id, start);
+		if (value)
+			*value = nvhost_syncpt_read_min(sp, id);
+		if (ts)
+			nvhost_ktime_get_ts(ts);
+		goto done;
+	}
+
 	old_val = val;
 
 	/* Set up a threshold interrupt waiter */
@@ -303,6 +406,8 @@ int nvhost_syncpt_wait_timeout(struct nvhost_syncpt *sp, u32 id,
 				&ref);
 		if (err)
 			goto done;
+
+		idle_hint = syncpt_wait_idle_hint(sp, id, &idle_req);
 	}
 
 	err = -EAGAIN;
@@ -310,11 +415,6 @@ int nvhost_syncpt_wait_timeout(struct nvhost_syncpt *sp, u32 id,
 	if (timeout < SYNCPT_CHECK_PERIOD)
 		low_timeout = timeout;
 
-	if (nvhost_dev_is_virtual(host->dev))
-		syncpt_is_expired = nvhost_syncpt_is_expired;
-	else
-		syncpt_is_expired = syncpt_update_min_is_expired;
-
 	/* wait for the syncpoint, or timeout, or signal */
 	while (timeout) {
 		u32 check = min_t(u32, SYNCPT_CHECK_PERIOD, timeout);
@@ -350,6 +450,7 @@ int nvhost_syncpt_wait_timeout(struct nvhost_syncpt *sp, u32 id,
 				check);
 		if (remain > 0 ||
 			syncpt_update_min_is_expired(sp, id, thresh)) {
+			syncpt_wait_record(sp, id, start);
 			if (value)
 				*value = nvhost_syncpt_read_min(sp, id);
 			if (ts) {
@@ -400,6 +501,9 @@ int nvhost_syncpt_wait_timeout(struct nvhost_syncpt *sp, u32 id,
 		}
 	}
 
+	if (idle_hint)
+		dev_pm_qos_remove_request(&idle_req);
+
 	if (!syncpt_poll)
 		nvhost_intr_put_ref(&(syncpt_to_dev(sp)->intr), id, ref);
 
@@ -1131,6 +1235,7 @@ int nvhost_syncpt_init(struct platform_device *dev,
 		kzalloc(sizeof(atomic_t) * nvhost_syncpt_nb_mlocks(sp),
 			GFP_KERNEL);
 	sp->ref = kzalloc(sizeof(atomic_t) * nb_pts, GFP_KERNEL);
+	sp->wait_ns = kzalloc(sizeof(atomic_t) * nb_pts, GFP_KERNEL);
 #ifdef CONFIG_TEGRA_GRHOST_SYNC
 	sp->timeline = kzalloc(sizeof(struct nvhost_sync_timeline *) *
 			nb_pts, GFP_KERNEL);
@@ -1153,7 +1258,8 @@ int nvhost_syncpt_init(struct platform_device *dev,
 	}
 
 	if (!(sp->assigned && sp->client_managed && sp->min_val && sp->max_val
-		     && sp->lock_counts && sp->in_use_ch && sp->ref)) {
+		     && sp->lock_counts && sp->in_use_ch && sp->ref
+		     && sp->wait_ns)) {
 		nvhost_err(&dev->dev, "syncpt in a wrong state");
 		/* frees happen in the deinit */
 		err = -ENOMEM;
@@ -1287,6 +1393,9 @@ void nvhost_syncpt_deinit(struct nvhost_syncpt *sp)
 	kfree(sp->ref);
 	sp->ref = NULL;
 
+	kfree(sp->wait_ns);
+	sp->wait_ns = NULL;
+
 	kfree(sp->lock_counts);
 	sp->lock_counts = NULL;
 
@@ -56,6 +56,8 @@ struct nvhost_syncpt {
 	atomic_t *max_val;
 	atomic_t *lock_counts;
 	atomic_t *ref;
+	/* running average of recent blocking wait latencies, in ns */
+	atomic_t *wait_ns;
 	struct mutex cpu_increment_mutex;
 	const char **syncpt_names;
 	const char **last_used_by;
@@ -78,6 +80,10 @@ void nvhost_syncpt_deinit(struct nvhost_syncpt *);
 #define SYNCPT_CHECK_PERIOD (6 * HZ)
 #define SYNCPT_POLL_PERIOD 1 /* msecs */
 #define MAX_STUCK_CHECK_COUNT 15
+#define SYNCPT_WAIT_NS_MAX (10 * NSEC_PER_MSEC)
+
+extern u32 nvhost_syncpt_spin_max_us;
+extern u32 nvhost_syncpt_idle_hint_max_us;
 
 /**
  * Updates the value sent to hardware.
@@ -165,6 +171,16 @@ int nvhost_syncpt_wait_timeout(struct nvhost_syncpt *sp, u32 id, u32 thresh,
 			u32 timeout, u32 *value, struct nvhost_timespec *ts,
 			bool interruptible);
 
+/*
+ * As nvhost_syncpt_wait_timeout(), but with low_latency set the caller first
+ * busy-waits for about as long as recent waits on the syncpoint took, before
+ * falling back to a threshold interrupt.
+ */
+int nvhost_syncpt_wait_timeout_mode(struct nvhost_syncpt *sp, u32 id,
+			u32 thresh, u32 timeout, u32 *value,
+			struct nvhost_timespec *ts, bool interruptible,
+			bool low_latency);
+
 static inline int nvhost_syncpt_wait(struct nvhost_syncpt *sp, u32 id, u32 thresh)
 {
 	return nvhost_syncpt_wait_timeout(sp, id, thresh,
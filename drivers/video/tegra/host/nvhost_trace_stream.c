@@ -0,0 +1,259 @@
+/*
+ * NVHOST firmware trace streaming
+ *
+ * Copyright (c) 2019, NVIDIA Corporation.  All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <linux/debugfs.h>
+#include <linux/err.h>
+#include <linux/fs.h>
+#include <linux/kthread.h>
+#include <linux/log2.h>
+#include <linux/mm.h>
+#include <linux/poll.h>
+#include <linux/sched.h>
+#include <linux/slab.h>
+#include <linux/uaccess.h>
+#include <linux/vmalloc.h>
+
+#include <uapi/linux/nvhost_events.h>
+
+#include "nvhost_trace_stream.h"
+
+static int nvhost_trace_stream_thread(void *data)
+{
+	struct nvhost_trace_stream *stream = data;
+
+	while (!kthread_should_stop()) {
+		stream->drain(stream, stream->drain_data);
+		schedule_timeout_interruptible(
+				msecs_to_jiffies(stream->period_ms));
+	}
+
+	/* pick up what was written since the last period */
+	stream->drain(stream, stream->drain_data);
+
+	return 0;
+}
+
+static int nvhost_trace_stream_open(struct inode *inode, struct file *file)
+{
+	struct nvhost_trace_stream *stream = inode->i_private;
+	struct task_struct *thread;
+	int err = 0;
+
+	mutex_lock(&stream->users_lock);
+	if (stream->users++ == 0) {
+		thread = kthread_run(nvhost_trace_stream_thread, stream,
+				     "nvhost_trace");
+		if (IS_ERR(thread)) {
+			stream->users--;
+			err = PTR_ERR(thread);
+			goto out;
+		}
+		stream->thread = thread;
+	}
+out:
+	mutex_unlock(&stream->users_lock);
+
+	if (err)
+		return err;
+
+	file->private_data = stream;
+
+	/* new readers start with the data currently in the ring */
+	file->f_pos = 0;
+	if (stream->hdr->write_pos > stream->size)
+		file->f_pos = stream->hdr->write_pos - stream->size;
+
+	return 0;
+}
+
+static int nvhost_trace_stream_release(struct inode *inode, struct file *file)
+{
+	struct nvhost_trace_stream *stream = file->private_data;
+
+	mutex_lock(&stream->users_lock);
+	if (--stream->users == 0) {
+		kthread_stop(stream->thread);
+		stream->thread = NULL;
+	}
+	mutex_unlock(&stream->users_lock);
+
+	return 0;
+}
+
+static ssize_t nvhost_trace_stream_read(struct file *file, char __user *buf,
+					size_t count, loff_t *ppos)
+{
+	struct nvhost_trace_stream *stream = file->private_data;
+	u64 pos = *ppos, write_pos;
+	size_t len, chunk, offset;
+	int err;
+
+	for (;;) {
+		write_pos = READ_ONCE(stream->hdr->write_pos);
+		if (write_pos != pos)
+			break;
+
+		if (file->f_flags & O_NONBLOCK)
+			return -EAGAIN;
+
+		err = wait_event_interruptible(stream->wq,
+				READ_ONCE(stream->hdr->write_pos) != pos);
+		if (err)
+			return err;
+	}
+
+	/* the reader was overtaken, skip what has been overwritten */
+	if (write_pos - pos > stream->size)
+		pos = write_pos - stream->size;
+
+	smp_rmb();
+
+	len = min_t(u64, count, write_pos - pos);
+	offset = pos & (stream->size - 1);
+	chunk = min_t(size_t, len, stream->size - offset);
+
+	if (copy_to_user(buf, stream->data + offset, chunk))
+		return -EFAULT;
+	if (len > chunk && copy_to_user(buf + chunk, stream->data, len - chunk))
+		return -EFAULT;
+
+	*ppos = pos + len;
+
+	return len;
+}
+
+static unsigned int nvhost_trace_stream_poll(struct file *file,
+					     poll_table *wait)
+{
+	struct nvhost_trace_stream *stream = file->private_data;
+
+	poll_wait(file, &stream->wq, wait);
+
+	if (READ_ONCE(stream->hdr->write_pos) != file->f_pos)
+		return POLLIN | POLLRDNORM;
+
+	return 0;
+}
+
+static int nvhost_trace_stream_mmap(struct file *file,
+				    struct vm_area_struct *vma)
+{
+	struct nvhost_trace_stream *stream = file->private_data;
+
+	if (vma->vm_flags & VM_WRITE)
+		return -EPERM;
+
+	if (vma->vm_pgoff ||
+	    vma->vm_end - vma->vm_start > stream->alloc_size)
+		return -EINVAL;
+
+	vma->vm_flags &= ~VM_MAYWRITE;
+
+	return remap_vmalloc_range(vma, stream->hdr, 0);
+}
+
+static const struct file_operations nvhost_trace_stream_fops = {
+	.open		= nvhost_trace_stream_open,
+	.release	= nvhost_trace_stream_release,
+	.read		= nvhost_trace_stream_read,
+	.poll		= nvhost_trace_stream_poll,
+	.mmap		= nvhost_trace_stream_mmap,
+	.llseek		= no_llseek,
+};
+
+struct nvhost_trace_stream *nvhost_trace_stream_create(struct dentry *dir,
+		const char *name, size_t size,
+		void (*drain)(struct nvhost_trace_stream *stream, void *data),
+		void *drain_data, unsigned int period_ms)
+{
+	struct nvhost_trace_stream *stream;
+
+	stream = kzalloc(sizeof(*stream), GFP_KERNEL);
+	if (!stream)
+		return ERR_PTR(-ENOMEM);
+
+	size = roundup_pow_of_two(size);
+	stream->alloc_size = PAGE_ALIGN(sizeof(*stream->hdr) + size);
+	stream->hdr = vmalloc_user(stream->alloc_size);
+	if (!stream->hdr) {
+		kfree(stream);
+		return ERR_PTR(-ENOMEM);
+	}
+
+	stream->data = (u8 *)(stream->hdr + 1);
+	stream->size = size;
+	stream->drain = drain;
+	stream->drain_data = drain_data;
+	stream->period_ms = period_ms;
+	spin_lock_init(&stream->lock);
+	init_waitqueue_head(&stream->wq);
+	mutex_init(&stream->users_lock);
+
+	stream->hdr->magic = NVHOST_TRACE_STREAM_MAGIC;
+	stream->hdr->size = size;
+
+	debugfs_create_file(name, S_IRUSR, dir, stream,
+			    &nvhost_trace_stream_fops);
+
+	return stream;
+}
+
+void nvhost_trace_stream_destroy(struct nvhost_trace_stream *stream)
+{
+	if (IS_ERR_OR_NULL(stream))
+		return;
+
+	vfree(stream->hdr);
+	kfree(stream);
+}
+
+void nvhost_trace_stream_write(struct nvhost_trace_stream *stream,
+			       const void *buf, size_t len)
+{
+	size_t offset, chunk;
+	u64 pos;
+
+	/* only the tail of an oversized write can be kept */
+	if (len > stream->size) {
+		buf = (const u8 *)buf + len - stream->size;
+		len = stream->size;
+	}
+
+	spin_lock(&stream->lock);
+
+	pos = stream->hdr->write_pos;
+	offset = pos & (stream->size - 1);
+	chunk = min_t(size_t, len, stream->size - offset);
+
+	memcpy(stream->data + offset, buf, chunk);
+	memcpy(stream->data, (const u8 *)buf + chunk, len - chunk);
+
+	smp_wmb();
+	WRITE_ONCE(stream->hdr->write_pos, pos + len);
+
+	spin_unlock(&stream->lock);
+
+	wake_up_interruptible(&stream->wq);
+}
+
+void nvhost_trace_stream_drop(struct nvhost_trace_stream *stream, size_t len)
+{
+	spin_lock(&stream->lock);
+	stream->hdr->dropped += len;
+	spin_unlock(&stream->lock);
+}
@@ -0,0 +1,123 @@
+/*
+ * NVHOST firmware trace streaming
+ *
+ * Copyright (c) 2019, NVIDIA Corporation.  All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __NVHOST_TRACE_STREAM_H__
+#define __NVHOST_TRACE_STREAM_H__
+
+#include <linux/mutex.h>
+#include <linux/spinlock.h>
+#include <linux/wait.h>
+
+struct dentry;
+struct task_struct;
+struct nvhost_trace_stream_header;
+
+/**
+ * @brief		Firmware trace stream
+ *
+ * hdr			Start of the vmalloc'd ring, mapped to userspace
+ * data			First data byte of the ring
+ * size			Size of the data area, a power of two
+ * alloc_size		Size of the ring allocation
+ * lock			Protects the write position
+ * wq			Readers waiting for data
+ * drain		Callback copying new firmware trace data to the stream
+ * drain_data		Argument of the drain callback
+ * period_ms		Interval between two drains
+ * thread		Thread draining the firmware buffer while the stream
+ *			is open
+ * users		Number of open files of the stream
+ * users_lock		Protects thread and users
+ *
+ */
+struct nvhost_trace_stream {
+	struct nvhost_trace_stream_header *hdr;
+	u8 *data;
+	u32 size;
+	size_t alloc_size;
+	spinlock_t lock;
+	wait_queue_head_t wq;
+
+	void (*drain)(struct nvhost_trace_stream *stream, void *data);
+	void *drain_data;
+	unsigned int period_ms;
+
+	struct task_struct *thread;
+	int users;
+	struct mutex users_lock;
+};
+
+/**
+ * @brief			Create a trace stream and its debugfs file
+ *
+ * The drain callback is run every period_ms from a kernel thread that
+ * only exists while the debugfs file is open, so the stream costs nothing
+ * when nobody listens.
+ *
+ * @param dir			debugfs directory of the file
+ * @param name			name of the file
+ * @param size			size of the ring, rounded up to a power of two
+ * @param drain			callback copying new trace data to the stream
+ * @param drain_data		argument of the callback
+ * @param period_ms		interval between two drains
+ * @return			stream pointer on success
+ *					or negative on error
+ *
+ */
+struct nvhost_trace_stream *nvhost_trace_stream_create(struct dentry *dir,
+		const char *name, size_t size,
+		void (*drain)(struct nvhost_trace_stream *stream, void *data),
+		void *drain_data, unsigned int period_ms);
+
+/**
+ * @brief			Destroy a trace stream
+ *
+ * The debugfs file must have been removed before.
+ *
+ * @param stream		Pointer to the stream
+ * @return			None
+ *
+ */
+void nvhost_trace_stream_destroy(struct nvhost_trace_stream *stream);
+
+/**
+ * @brief			Append data to a trace stream
+ *
+ * The oldest data is overwritten when readers do not keep up.
+ *
+ * @param stream		Pointer to the stream
+ * @param buf		Data to append
+ * @param len			Length of the data
+ * @return			None
+ *
+ */
+void nvhost_trace_stream_write(struct nvhost_trace_stream *stream,
+			       const void *buf, size_t len);
+
+/**
+ * @brief			Account firmware trace data that was lost
+ *
+ * @param stream		Pointer to the stream
+ * @param len			Number of bytes the firmware overwrote before
+ *				they could be drained
+ * @return			None
+ *
+ */
+void nvhost_trace_stream_drop(struct nvhost_trace_stream *stream, size_t len);
+
+#endif
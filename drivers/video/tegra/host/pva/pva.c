@@ -42,6 +42,7 @@
 #include "nvhost_acm.h"
 #include "t194/t194.h"
 #include "nvhost_queue.h"
+#include "nvhost_trace_stream.h"
 #include "pva_queue.h"
 #include "pva.h"
 #include "pva_regs.h"
@@ -365,9 +366,8 @@ static int pva_read_ucode(struct platform_device *pdev,
 	fw_info->priv2_buffer.va =
 			(void *)ALIGN((u64)pva->priv2_dma.va, SZ_4K);
 
-	trace->addr = (void *)((u8 *)fw_info->priv2_buffer.va +
-					trace->offset);
-	memset(trace->addr, 0, trace->size);
+	memset((u8 *)fw_info->priv2_buffer.va + trace->offset, 0, trace->size);
+	pva_trace_set_log(pva, (u8 *)fw_info->priv2_buffer.va + trace->offset);
 
 	fw_info->priv2_buffer.pa =
 			(dma_addr_t)ALIGN((u64)pva->priv2_dma.pa, SZ_4K);
@@ -663,6 +663,7 @@ int pva_prepare_poweroff(struct platform_device *pdev)
 	reset_control_assert(pdata->reset_control);
 	pva->booted = false;
 
+	pva_trace_set_log(pva, NULL);
 	pva_free_fw(pdev, pva);
 
 	return 0;
@@ -730,6 +731,8 @@ static int pva_probe(struct platform_device *pdev)
 	init_waitqueue_head(&pva->mailbox_waitqueue);
 	mutex_init(&pva->mailbox_mutex);
 	mutex_init(&pva->ccq_mutex);
+	mutex_init(&pva->trace_lock);
+	spin_lock_init(&pva->prio_stats_lock);
 	pva->submit_mode = PVA_SUBMIT_MODE_MMIO_CCQ;
 	pva->slcg_disable = 0;
 	pva->vmem_war_disable = 0;
@@ -807,6 +810,7 @@ static int __exit pva_remove(struct platform_device *pdev)
 	nvhost_queue_deinit(pva->pool);
 	nvhost_client_device_release(pdev);
 	free_irq(pva->irq, pdata);
+	nvhost_trace_stream_destroy(pva->trace_stream);
 
 	return 0;
 }
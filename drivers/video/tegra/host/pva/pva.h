@@ -28,6 +28,9 @@
 #include "nvhost_queue.h"
 #include "pva_regs.h"
 
+struct dentry;
+struct nvhost_trace_stream;
+
 extern const struct file_operations tegra_pva_ctrl_ops;
 
 enum pva_submit_mode {
@@ -155,6 +158,27 @@ struct pva_func_table {
 	uint32_t entries;
 };
 
+/* Queue priorities above the last one are accounted together */
+#define PVA_NUM_PRIO_STATS	8
+
+/**
+ * @brief		Task latency accounting of a queue priority
+ *
+ * tasks		Completed tasks
+ * wait_us		Total time from acceptance to the start on a VPU
+ * wait_max_us		Longest time from acceptance to the start on a VPU
+ * latency_us		Total time from acceptance to completion
+ * latency_max_us	Longest time from acceptance to completion
+ *
+ */
+struct pva_prio_stats {
+	u64 tasks;
+	u64 wait_us;
+	u64 wait_max_us;
+	u64 latency_us;
+	u64 latency_max_us;
+};
+
 /**
  * @brief		Driver private data, shared with all applications
  *
@@ -172,11 +196,15 @@ struct pva_func_table {
  * priv1_dma		struct pva_dma_alloc_info for priv1_dma
  * priv2_dma		struct pva_dma_alloc_info for priv2_dma
  * pva_trace		struct for pva_trace_log
+ * trace_lock		Serializes readers of the firmware trace log
+ * trace_stream		Stream of firmware trace points for userspace
  * submit_mode		Select the task submit mode
  * dbg_vpu_app_id	Set the vpu_app id to debug
  * r5_dbg_wait		Set the r5 debugger to wait
  * timeout_enabled	Set pva timeout enabled based on debug
  * slcg_disable		Second level Clock Gating control variable
+ * prio_stats_lock	Protects prio_stats
+ * prio_stats		Task latency accounting per queue priority
  *
  */
 struct pva {
@@ -201,6 +229,8 @@ struct pva {
 	struct pva_dma_alloc_info priv2_dma;
 
 	struct pva_trace_log pva_trace;
+	struct mutex trace_lock;
+	struct nvhost_trace_stream *trace_stream;
 	u32 submit_mode;
 
 	u32 dbg_vpu_app_id;
@@ -214,6 +244,9 @@ struct pva {
 	bool booted;
 
 	u32 log_level;
+
+	spinlock_t prio_stats_lock;
+	struct pva_prio_stats prio_stats[PVA_NUM_PRIO_STATS];
 };
 
 /**
@@ -228,6 +261,28 @@ struct pva {
  */
 void pva_trace_copy_to_ftrace(struct pva *pva);
 
+/**
+ * @brief	Attach or detach the firmware trace log
+ *
+ * The trace log lives in firmware memory that is freed on power off, so
+ * it is attached once the firmware is loaded and detached, after a final
+ * copy of the pending trace points, before the memory is freed.
+ *
+ * @pva Pointer to pva structure
+ * @addr Address of the trace log, or NULL to detach it
+ *
+ */
+void pva_trace_set_log(struct pva *pva, void *addr);
+
+/**
+ * @brief	Create the firmware trace stream of the device
+ *
+ * @pva Pointer to pva structure
+ * @dir debugfs directory of the stream
+ *
+ */
+void pva_trace_stream_init(struct pva *pva, struct dentry *dir);
+
 /**
  * @brief	Finalize the PVA Power-on-Sequence.
  *
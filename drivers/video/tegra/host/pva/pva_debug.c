@@ -19,6 +19,7 @@
 #include <linux/kernel.h>
 #include <linux/module.h>
 #include <linux/debugfs.h>
+#include <linux/math64.h>
 #include <linux/platform_device.h>
 #include "dev.h"
 #include "pva.h"
@@ -200,6 +201,60 @@ static int set_log_level(void *data, u64 val)
 
 DEFINE_DEBUGFS_ATTRIBUTE(log_level_fops, get_log_level, set_log_level, "%llu");
 
+static int pva_prio_stats_show(struct seq_file *s, void *data)
+{
+	struct pva *pva = s->private;
+	struct pva_prio_stats stats[PVA_NUM_PRIO_STATS];
+	int i;
+
+	spin_lock(&pva->prio_stats_lock);
+	memcpy(stats, pva->prio_stats, sizeof(stats));
+	spin_unlock(&pva->prio_stats_lock);
+
+	seq_printf(s, "%-8s %10s %12s %12s %12s %12s\n",
+		   "priority", "tasks", "wait_avg_us", "wait_max_us",
+		   "avg_us", "max_us");
+	for (i = 0; i < PVA_NUM_PRIO_STATS; i++)
+		seq_printf(s, "%-8d %10llu %12llu %12llu %12llu %12llu\n",
+			   i, stats[i].tasks,
+			   stats[i].tasks ?
+				div64_u64(stats[i].wait_us, stats[i].tasks) : 0,
+			   stats[i].wait_max_us,
+			   stats[i].tasks ?
+				div64_u64(stats[i].latency_us,
+					  stats[i].tasks) : 0,
+			   stats[i].latency_max_us);
+
+	return 0;
+}
+
+static int pva_prio_stats_open(struct inode *inode, struct file *file)
+{
+	return single_open(file, pva_prio_stats_show, inode->i_private);
+}
+
+/* any write clears the statistics */
+static ssize_t pva_prio_stats_clear(struct file *file,
+		const char __user *buf, size_t count, loff_t *offp)
+{
+	struct seq_file *s = file->private_data;
+	struct pva *pva = s->private;
+
+	spin_lock(&pva->prio_stats_lock);
+	memset(pva->prio_stats, 0, sizeof(pva->prio_stats));
+	spin_unlock(&pva->prio_stats_lock);
+
+	return count;
+}
+
+static const struct file_operations pva_prio_stats_fops = {
+	.open		= pva_prio_stats_open,
+	.read		= seq_read,
+	.write		= pva_prio_stats_clear,
+	.llseek		= seq_lseek,
+	.release	= single_release,
+};
+
 void pva_debugfs_init(struct platform_device *pdev)
 {
 	struct dentry *ret;
@@ -274,4 +329,11 @@ void pva_debugfs_init(struct platform_device *pdev)
 				  pva, &log_level_fops);
 	if (!ret)
 		nvhost_dbg_info("Failed to create log_lovel node");
+
+	ret = debugfs_create_file("priority_stats", 0644, de,
+				  pva, &pva_prio_stats_fops);
+	if (!ret)
+		nvhost_dbg_info("Failed to create priority_stats node");
+
+	pva_trace_stream_init(pva, de);
 }
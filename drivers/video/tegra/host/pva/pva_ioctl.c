@@ -21,6 +21,9 @@
 #include <linux/uaccess.h>
 #include <linux/slab.h>
 #include <linux/nospec.h>
+#include <linux/mm.h>
+#include <linux/vmalloc.h>
+#include <linux/log2.h>
 
 #include <asm/ioctls.h>
 #include <asm/barrier.h>
@@ -45,8 +48,53 @@ struct pva_private {
 	struct pva *pva;
 	struct nvhost_queue *queue;
 	struct nvhost_buffers *buffers;
+	struct pva_submit_ring *ring;
+	struct mutex ring_lock;
 };
 
+/**
+ * @brief pva_submit_ring - Submit ring shared with userspace
+ *
+ * hdr		Start of the vmalloc'd ring, mapped to userspace
+ * entries	First entry of the ring
+ * num_entries	Number of entries, a power of two
+ * tail		Next entry to consume, mirrored to the header
+ * size		Size of the ring allocation
+ */
+struct pva_submit_ring {
+	struct pva_submit_ring_header *hdr;
+	struct pva_submit_ring_entry *entries;
+	u32 num_entries;
+	u32 tail;
+	size_t size;
+};
+
+#define PVA_SUBMIT_RING_DATA_SIZE \
+	FIELD_SIZEOF(struct pva_submit_ring_entry, data)
+
+/*
+ * Copy a task field either from userspace or, for ring entries, from the
+ * data area of the entry. Ring offsets are bounds checked against the
+ * entry since userspace controls them.
+ */
+static int pva_copy_task_field(void *dst, u64 src, size_t size,
+			       const u8 *ring_data)
+{
+	if (!ring_data) {
+		if (copy_from_user(dst, (void __user *)src, size))
+			return -EFAULT;
+		return 0;
+	}
+
+	if (src > PVA_SUBMIT_RING_DATA_SIZE ||
+	    size > PVA_SUBMIT_RING_DATA_SIZE - src)
+		return -EINVAL;
+
+	memcpy(dst, ring_data + src, size);
+
+	return 0;
+}
+
 /**
  * @brief	Copy a single task from userspace to kernel space
  *
@@ -58,14 +106,16 @@ struct pva_private {
  * @param ioctl_task	Pointer to a userspace task that is copied
  *				to kernel memory
  * @param task		Pointer to a task that should be created
+ * @param ring_data	Data area of the ring entry holding the task, or
+ *				NULL if the task comes from userspace
  * @return		0 on Success or negative error code
  *
  */
 static int pva_copy_task(struct pva_ioctl_submit_task *ioctl_task,
-			 struct pva_submit_task *task)
+			 struct pva_submit_task *task,
+			 const u8 *ring_data)
 {
 	int err = 0;
-	int copy_ret = 0;
 	int i;
 
 	if (ioctl_task->num_prefences > PVA_MAX_PREFENCES ||
@@ -97,13 +147,12 @@ static int pva_copy_task(struct pva_ioctl_submit_task *ioctl_task,
 
 	/* Copy the user primary_payload */
 	if (task->primary_payload_size) {
-		copy_ret = copy_from_user(task->primary_payload,
-				(void __user *)(ioctl_task->primary_payload),
-				ioctl_task->primary_payload_size);
-		if (copy_ret) {
-			err = -EFAULT;
+		err = pva_copy_task_field(task->primary_payload,
+				ioctl_task->primary_payload,
+				ioctl_task->primary_payload_size,
+				ring_data);
+		if (err)
 			goto err_out;
-		}
 	}
 
 #define COPY_FIELD(dst, src, num, type)					\
@@ -111,13 +160,10 @@ static int pva_copy_task(struct pva_ioctl_submit_task *ioctl_task,
 		if ((num) == 0) {					\
 			break;						\
 		}							\
-		copy_ret = copy_from_user((dst),			\
-				(void __user *)(src),			\
-				(num) * sizeof(type));			\
-		if (copy_ret) {						\
-			err = -EFAULT;					\
+		err = pva_copy_task_field((dst), (src),			\
+				(num) * sizeof(type), ring_data);	\
+		if (err)						\
 			goto err_out;					\
-		}							\
 	} while (0)
 
 	/* Copy the fields */
@@ -161,6 +207,88 @@ err_out:
 	return err;
 }
 
+/**
+ * @brief	Fill in the post-fences of a submitted task
+ *
+ * @param priv		PVA Private data
+ * @param task		Submitted task
+ * @param threshold	Syncpoint value of the first task increment
+ * @return		0 on Success or negative error code
+ *
+ */
+static int pva_task_fill_pvafences(struct pva_private *priv,
+				   struct pva_submit_task *task,
+				   u32 threshold)
+{
+	struct platform_device *host1x_pdev =
+		to_platform_device(priv->queue->vm_pdev->dev.parent);
+	int err = 0;
+	int j;
+	int k;
+
+	for (k = 0; k < PVA_MAX_FENCE_TYPES; k++) {
+		u32 increment = 0;
+		struct nvdev_fence *fence;
+
+		if ((task->num_pvafences[k] == 0) ||
+			(k == PVA_FENCE_PRE)) {
+			continue;
+		}
+
+		switch (k) {
+		case PVA_FENCE_SOT_V:
+			increment = 1;
+			break;
+		case PVA_FENCE_SOT_R:
+			increment = 1;
+			break;
+		case PVA_FENCE_POST:
+			increment = 1;
+			break;
+		default:
+
+			break;
+		};
+
+		for (j = 0; j < task->num_pvafences[k]; j++) {
+			fence = &task->pvafences[k][j].fence;
+
+			switch (fence->type) {
+			case NVDEV_FENCE_TYPE_SYNCPT: {
+				fence->syncpoint_index =
+					priv->queue->syncpt_id;
+				fence->syncpoint_value =
+					threshold;
+				threshold += increment;
+				break;
+			}
+			case NVDEV_FENCE_TYPE_SYNC_FD: {
+				struct nvhost_ctrl_sync_fence_info pts;
+
+				pts.id = priv->queue->syncpt_id;
+				pts.thresh = threshold;
+				threshold += increment;
+				err = nvhost_sync_create_fence_fd(
+					host1x_pdev,
+					&pts, 1,
+					"fence_pva",
+					&fence->sync_fd);
+
+				break;
+			}
+			case NVDEV_FENCE_TYPE_SEMAPHORE:
+				break;
+			default:
+				err = -ENOSYS;
+				nvhost_warn(&priv->pva->pdev->dev,
+					    "Bad fence type");
+			}
+		}
+	}
+
+	return err;
+}
+
 /**
  * @brief	Submit a task to PVA
  *
@@ -183,8 +311,6 @@ static int pva_submit(struct pva_private *priv, void *arg)
 	struct pva_submit_task *task = NULL;
 	int err = 0;
 	int i;
-	int j;
-	int k;
 	int threshold;
 
 	memset(&tasks_header, 0, sizeof(tasks_header));
@@ -233,7 +359,7 @@ static int pva_submit(struct pva_private *priv, void *arg)
 		if ((err < 0) || !task)
 			goto err_get_task_buffer;
 
-		err = pva_copy_task(ioctl_tasks + i, task);
+		err = pva_copy_task(ioctl_tasks + i, task, NULL);
 		if (err < 0)
 			goto err_copy_tasks;
 
@@ -269,73 +395,12 @@ static int pva_submit(struct pva_private *priv, void *arg)
 			(struct nvpva_fence __user *)
 			ioctl_tasks[i].pvafences;
 
-		struct platform_device *host1x_pdev =
-			to_platform_device(priv->queue->vm_pdev->dev.parent);
-
 		task = tasks_header.tasks[i];
 
 		threshold = tasks_header.task_thresh[i] - task->fence_num + 1;
 
 		/* Return post-fences */
-		for (k = 0; k < PVA_MAX_FENCE_TYPES; k++) {
-			u32 increment = 0;
-			struct nvdev_fence *fence;
-
-			if ((task->num_pvafences[k] == 0) ||
-				(k == PVA_FENCE_PRE)) {
-				continue;
-			}
-
-			switch (k) {
-			case PVA_FENCE_SOT_V:
-				increment = 1;
-				break;
-			case PVA_FENCE_SOT_R:
-				increment = 1;
-				break;
-			case PVA_FENCE_POST:
-				increment = 1;
-				break;
-			default:
-
-				break;
-			};
-
-			for (j = 0; j < task->num_pvafences[k]; j++) {
-				fence = &task->pvafences[k][j].fence;
-
-				switch (fence->type) {
-				case NVDEV_FENCE_TYPE_SYNCPT: {
-					fence->syncpoint_index =
-						priv->queue->syncpt_id;
-					fence->syncpoint_value =
-						threshold;
-					threshold += increment;
-					break;
-				}
-				case NVDEV_FENCE_TYPE_SYNC_FD: {
-					struct nvhost_ctrl_sync_fence_info pts;
-
-					pts.id = priv->queue->syncpt_id;
-					pts.thresh = threshold;
-					threshold += increment;
-					err = nvhost_sync_create_fence_fd(
-						host1x_pdev,
-						&pts, 1,
-						"fence_pva",
-						&fence->sync_fd);
-
-					break;
-				}
-				case NVDEV_FENCE_TYPE_SEMAPHORE:
-					break;
-				default:
-					err = -ENOSYS;
-					nvhost_warn(&priv->pva->pdev->dev,
-						    "Bad fence type");
-				}
-			}
-		}
+		pva_task_fill_pvafences(priv, task, threshold);
 
 		err = copy_to_user(pvafences,
 				   task->pvafences,
@@ -367,6 +432,205 @@ err_check_num_tasks:
 	return err;
 }
 
+/**
+ * @brief	Submit a single entry of the submit ring
+ *
+ * The entry is deep copied out of the ring before it is validated so that
+ * userspace cannot change it behind our back. Post-fences are written
+ * back into the pvafences area of the entry.
+ *
+ * @param priv	PVA Private data
+ * @param entry	Ring entry to submit
+ * @return	0 on Success or negative error code
+ *
+ */
+static int pva_ring_submit_entry(struct pva_private *priv,
+				 struct pva_submit_ring_entry *entry)
+{
+	struct nvhost_queue_task_mem_info task_mem_info;
+	struct pva_ioctl_submit_task ioctl_task;
+	struct pva_submit_tasks tasks_header;
+	struct pva_submit_task *task;
+	u64 pvafences;
+	int err;
+
+	memcpy(&ioctl_task, &entry->task, sizeof(ioctl_task));
+	pvafences = ioctl_task.pvafences;
+
+	if (pvafences > PVA_SUBMIT_RING_DATA_SIZE ||
+	    sizeof(task->pvafences) > PVA_SUBMIT_RING_DATA_SIZE - pvafences)
+		return -EINVAL;
+
+	err = nvhost_queue_alloc_task_memory(priv->queue, &task_mem_info);
+	task = task_mem_info.kmem_addr;
+	if ((err < 0) || !task)
+		return err < 0 ? err : -ENOMEM;
+
+	err = pva_copy_task(&ioctl_task, task, entry->data);
+	if (err < 0) {
+		nvhost_queue_free_task_memory(priv->queue,
+					      task_mem_info.pool_index);
+		return err;
+	}
+
+	INIT_LIST_HEAD(&task->node);
+	kref_init(&task->ref);
+
+	task->pva = priv->pva;
+	task->queue = priv->queue;
+	task->buffers = priv->buffers;
+
+	task->dma_addr = task_mem_info.dma_addr;
+	task->va = task_mem_info.va;
+	task->pool_index = task_mem_info.pool_index;
+
+	memset(&tasks_header, 0, sizeof(tasks_header));
+	tasks_header.tasks[0] = task;
+	tasks_header.num_tasks = 1;
+
+	err = nvhost_queue_submit(priv->queue, &tasks_header);
+	if (err < 0)
+		goto out;
+
+	err = pva_task_fill_pvafences(priv, task,
+			tasks_header.task_thresh[0] - task->fence_num + 1);
+
+	memcpy(entry->data + pvafences, task->pvafences,
+	       sizeof(task->pvafences));
+
+out:
+	kref_put(&task->ref, pva_task_free);
+
+	return err;
+}
+
+/**
+ * @brief	Submit the pending entries of the submit ring
+ *
+ * Entries between the current tail and the head given by userspace are
+ * submitted in order. Processing stops at the first entry that fails to
+ * submit; its status holds the error and tail points past it.
+ *
+ * @param priv	PVA Private data
+ * @param arg	ioctl data
+ * @return	0 on Success or negative error code
+ *
+ */
+static int pva_ring_doorbell(struct pva_private *priv, void *arg)
+{
+	struct pva_ioctl_ring_doorbell *doorbell = arg;
+	struct pva_submit_ring *ring;
+	struct pva_submit_ring_entry *entry;
+	u32 start, tail;
+	int err = 0;
+
+	mutex_lock(&priv->ring_lock);
+
+	ring = priv->ring;
+	if (!ring) {
+		err = -EINVAL;
+		goto out;
+	}
+
+	start = tail = ring->tail;
+	if (doorbell->head - tail > ring->num_entries) {
+		err = -EINVAL;
+		goto out;
+	}
+
+	while (tail != doorbell->head) {
+		entry = &ring->entries[tail & (ring->num_entries - 1)];
+
+		err = pva_ring_submit_entry(priv, entry);
+
+		/* A full task pool is retried on the next doorbell */
+		if (err == -EAGAIN)
+			break;
+
+		WRITE_ONCE(entry->status, err);
+		tail++;
+
+		if (err < 0)
+			break;
+	}
+
+	/* Publish the statuses and fences before the new tail */
+	smp_wmb();
+	ring->tail = tail;
+	WRITE_ONCE(ring->hdr->tail, tail);
+	doorbell->tail = tail;
+
+	/* Running out of task slots is only an error if nothing was taken */
+	if (err == -EAGAIN && tail != start)
+		err = 0;
+out:
+	mutex_unlock(&priv->ring_lock);
+
+	return err;
+}
+
+static void pva_ring_free(struct pva_submit_ring *ring)
+{
+	if (!ring)
+		return;
+
+	vfree(ring->hdr);
+	kfree(ring);
+}
+
+/**
+ * @brief	Create or destroy the submit ring of the file
+ *
+ * @param priv	PVA Private data
+ * @param arg	ioctl data
+ * @return	0 on Success or negative error code
+ *
+ */
+static int pva_set_submit_ring(struct pva_private *priv, void *arg)
+{
+	struct pva_ioctl_submit_ring *args = arg;
+	struct pva_submit_ring *ring = NULL;
+	size_t size;
+
+	if (args->reserved)
+		return -EINVAL;
+
+	if (args->num_entries) {
+		if (args->num_entries > PVA_SUBMIT_RING_MAX_ENTRIES ||
+		    !is_power_of_2(args->num_entries))
+			return -EINVAL;
+
+		ring = kzalloc(sizeof(*ring), GFP_KERNEL);
+		if (!ring)
+			return -ENOMEM;
+
+		size = PAGE_ALIGN(sizeof(*ring->hdr) + args->num_entries *
+				  sizeof(struct pva_submit_ring_entry));
+		ring->hdr = vmalloc_user(size);
+		if (!ring->hdr) {
+			kfree(ring);
+			return -ENOMEM;
+		}
+
+		ring->size = size;
+		ring->num_entries = args->num_entries;
+		ring->entries = (struct pva_submit_ring_entry *)(ring->hdr + 1);
+
+		ring->hdr->magic = PVA_SUBMIT_RING_MAGIC;
+		ring->hdr->num_entries = ring->num_entries;
+		ring->hdr->entry_size = sizeof(struct pva_submit_ring_entry);
+	}
+
+	/* Existing mappings keep the pages of the old ring alive */
+	mutex_lock(&priv->ring_lock);
+	swap(priv->ring, ring);
+	mutex_unlock(&priv->ring_lock);
+
+	pva_ring_free(ring);
+
+	return 0;
+}
+
 /**
  * pva_queue_set_attr() - Set attribute to the queue
  *
@@ -519,6 +783,98 @@ pva_buffer_cpy_err:
 	return err;
 }
 
+static int pva_register(struct pva_private *priv, void *arg)
+{
+	u32 *handles;
+	int err = 0;
+	int i = 0;
+	struct dma_buf *dmabuf;
+	struct pva_pin_unpin_args *buf_list = (struct pva_pin_unpin_args *)arg;
+	u32 count = buf_list->num_buffers;
+
+	if (count > PVA_MAX_PIN_BUFFERS)
+		return -EINVAL;
+
+	handles = kcalloc(count, sizeof(u32), GFP_KERNEL);
+	if (!handles)
+		return -ENOMEM;
+
+	if (copy_from_user(handles, (void __user *)buf_list->buffers,
+			(count * sizeof(u32)))) {
+		err = -EFAULT;
+		goto pva_buffer_cpy_err;
+	}
+
+	for (i = 0; i < count; i++) {
+		u32 id;
+
+		dmabuf = dma_buf_get(handles[i]);
+		if (IS_ERR_OR_NULL(dmabuf)) {
+			err = -EFAULT;
+			goto pva_buffer_register_err;
+		}
+
+		err = nvhost_buffer_register(priv->buffers, dmabuf, &id);
+		dma_buf_put(dmabuf);
+		if (err < 0)
+			goto pva_buffer_register_err;
+
+		handles[i] = id | PVA_REGISTERED_HANDLE;
+	}
+
+	if (copy_to_user((void __user *)buf_list->buffers, handles,
+			(count * sizeof(u32)))) {
+		err = -EFAULT;
+		goto pva_buffer_register_err;
+	}
+
+	kfree(handles);
+	return 0;
+
+pva_buffer_register_err:
+	count = i;
+	for (i = 0; i < count; i++)
+		nvhost_buffer_unregister(priv->buffers,
+				handles[i] & ~PVA_REGISTERED_HANDLE);
+pva_buffer_cpy_err:
+	kfree(handles);
+	return err;
+}
+
+static int pva_unregister(struct pva_private *priv, void *arg)
+{
+	u32 *handles;
+	int err = 0;
+	int i;
+	struct pva_pin_unpin_args *buf_list = (struct pva_pin_unpin_args *)arg;
+	u32 count = buf_list->num_buffers;
+
+	if (count > PVA_MAX_PIN_BUFFERS)
+		return -EINVAL;
+
+	handles = kcalloc(count, sizeof(u32), GFP_KERNEL);
+	if (!handles)
+		return -ENOMEM;
+
+	if (copy_from_user(handles, (void __user *)buf_list->buffers,
+			(count * sizeof(u32)))) {
+		err = -EFAULT;
+		goto pva_buffer_cpy_err;
+	}
+
+	for (i = 0; i < count; i++) {
+		if (!(handles[i] & PVA_REGISTERED_HANDLE))
+			continue;
+
+		nvhost_buffer_unregister(priv->buffers,
+				handles[i] & ~PVA_REGISTERED_HANDLE);
+	}
+
+pva_buffer_cpy_err:
+	kfree(handles);
+	return err;
+}
+
 static int pva_get_characteristics(struct pva_private *priv,
 		void *arg)
 {
@@ -751,6 +1107,26 @@ static long pva_ioctl(struct file *file, unsigned int cmd,
 		err = pva_get_rate(priv, buf);
 		break;
 	}
+	case PVA_IOCTL_REGISTER:
+	{
+		err = pva_register(priv, buf);
+		break;
+	}
+	case PVA_IOCTL_UNREGISTER:
+	{
+		err = pva_unregister(priv, buf);
+		break;
+	}
+	case PVA_IOCTL_SET_SUBMIT_RING:
+	{
+		err = pva_set_submit_ring(priv, buf);
+		break;
+	}
+	case PVA_IOCTL_RING_DOORBELL:
+	{
+		err = pva_ring_doorbell(priv, buf);
+		break;
+	}
 	default:
 		return -ENOIOCTLCMD;
 	}
@@ -833,6 +1209,7 @@ static int pva_open(struct inode *inode, struct file *file)
 
 	file->private_data = priv;
 	priv->pva = pva;
+	mutex_init(&priv->ring_lock);
 
 	/* add the pva client to nvhost */
 	err = nvhost_module_add_client(pdev, priv);
@@ -903,12 +1280,37 @@ static int pva_release(struct inode *inode, struct file *file)
 	/* Release the handle to buffer structure */
 	nvhost_buffer_release(priv->buffers);
 
+	pva_ring_free(priv->ring);
+
 	/* Finally, release the private data */
 	kfree(priv);
 
 	return 0;
 }
 
+static int pva_mmap(struct file *file, struct vm_area_struct *vma)
+{
+	struct pva_private *priv = file->private_data;
+	int err;
+
+	if (vma->vm_pgoff)
+		return -EINVAL;
+
+	mutex_lock(&priv->ring_lock);
+
+	if (!priv->ring ||
+	    vma->vm_end - vma->vm_start > priv->ring->size) {
+		err = -EINVAL;
+		goto out;
+	}
+
+	err = remap_vmalloc_range(vma, priv->ring->hdr, 0);
+out:
+	mutex_unlock(&priv->ring_lock);
+
+	return err;
+}
+
 const struct file_operations tegra_pva_ctrl_ops = {
 	.owner = THIS_MODULE,
 	.llseek = no_llseek,
@@ -918,4 +1320,5 @@ const struct file_operations tegra_pva_ctrl_ops = {
 #endif
 	.open = pva_open,
 	.release = pva_release,
+	.mmap = pva_mmap,
 };
@@ -22,8 +22,10 @@
 #include <linux/uaccess.h>
 #include <linux/slab.h>
 #include <linux/errno.h>
+#include <linux/math64.h>
 #include <linux/nvhost.h>
 #include <linux/cvnas.h>
+#include <clocksource/arm_arch_timer.h>
 
 #include <trace/events/nvhost.h>
 
@@ -216,6 +218,10 @@ static void pva_task_unpin_mem(struct pva_submit_task *task)
 #define UNPIN_MEMORY(dst_name)						\
 	do {								\
 		if ((((dst_name).dmabuf) != NULL) &&			\
+				((dst_name).reg_id != 0)) {		\
+			nvhost_buffer_submit_unpin_id(task->buffers,	\
+				(dst_name).reg_id);			\
+		} else if ((((dst_name).dmabuf) != NULL) &&		\
 				((dst_name).dma_addr != 0)) {		\
 			nvhost_buffer_submit_unpin(task->buffers,	\
 				&((dst_name).dmabuf), 1);		\
@@ -297,6 +303,20 @@ static int pva_task_pin_mem(struct pva_submit_task *task)
 			goto err_map_handle;				\
 		}							\
 									\
+		if ((dmabuf_fd) & PVA_REGISTERED_HANDLE) {		\
+			err = nvhost_buffer_submit_pin_id(task->buffers, \
+				(dmabuf_fd) & ~PVA_REGISTERED_HANDLE,	\
+				&(dst_name).dmabuf,			\
+				&(dst_name).dma_addr,			\
+				&(dst_name).size,			\
+				&(dst_name).heap);			\
+			if (err < 0)					\
+				goto err_map_handle;			\
+			(dst_name).reg_id =				\
+				(dmabuf_fd) & ~PVA_REGISTERED_HANDLE;	\
+			break;						\
+		}							\
+									\
 		((dst_name).dmabuf) = dma_buf_get(dmabuf_fd);		\
 		if (IS_ERR_OR_NULL((dst_name).dmabuf)) {		\
 			(dst_name).dmabuf = NULL;			\
@@ -1288,6 +1308,65 @@ pva_eventlib_record_r5_states(struct platform_device *pdev,
 }
 #endif
 
+/*
+ * R5 timestamps the task when it is queued and when the VPU starts and
+ * finishes it; there is no per-task cycle or DMA byte counter.
+ */
+static void pva_task_log_perf(struct platform_device *pdev,
+			      struct nvhost_queue *queue,
+			      struct pva_submit_task *task,
+			      struct pva_task_statistics *stats)
+{
+	struct nvhost_task_perf perf;
+
+	memset(&perf, 0, sizeof(perf));
+
+	perf.syncpt_id = queue->syncpt_id;
+	perf.syncpt_thresh = task->syncpt_thresh;
+	perf.submit_time = stats->queued_time;
+	perf.start_time = stats->vpu_start_time;
+	perf.end_time = stats->vpu_complete_time;
+	if (stats->vpu_start_time > stats->queued_time)
+		perf.queue_wait = stats->vpu_start_time - stats->queued_time;
+
+	nvhost_eventlib_log_task_perf(pdev, &perf, stats->complete_time);
+}
+
+/*
+ * The R5 picks the next task among the queues by their priority attribute,
+ * the wait time shows how long a task was kept behind other queues.
+ */
+static void pva_task_account_prio(struct pva *pva,
+				  struct pva_submit_task *task,
+				  struct pva_task_statistics *stats)
+{
+	struct pva_prio_stats *prio_stats;
+	u32 rate = arch_timer_get_rate();
+	u64 wait_us = 0, latency_us = 0;
+
+	if (!rate)
+		return;
+
+	prio_stats = &pva->prio_stats[min_t(u32, task->priority,
+					    PVA_NUM_PRIO_STATS - 1)];
+
+	if (stats->vpu_start_time > stats->queued_time)
+		wait_us = div_u64((stats->vpu_start_time -
+				   stats->queued_time) * USEC_PER_SEC, rate);
+	if (stats->complete_time > stats->queued_time)
+		latency_us = div_u64((stats->complete_time -
+				      stats->queued_time) * USEC_PER_SEC, rate);
+
+	spin_lock(&pva->prio_stats_lock);
+	prio_stats->tasks++;
+	prio_stats->wait_us += wait_us;
+	prio_stats->wait_max_us = max(prio_stats->wait_max_us, wait_us);
+	prio_stats->latency_us += latency_us;
+	prio_stats->latency_max_us = max(prio_stats->latency_max_us,
+					 latency_us);
+	spin_unlock(&pva->prio_stats_lock);
+}
+
 static void pva_task_update(struct pva_submit_task *task)
 {
 	struct nvhost_queue *queue = task->queue;
@@ -1310,6 +1389,8 @@ static void pva_task_update(struct pva_submit_task *task)
 				 task->syncpt_thresh,
 				 stats->vpu_assigned_time,
 				 stats->complete_time);
+	pva_task_log_perf(pdev, queue, task, stats);
+	pva_task_account_prio(pva, task, stats);
 	nvhost_dbg_info("Completed task %p (0x%llx), start_time=%llu, end_time=%llu",
 			task, (u64)task->dma_addr,
 			stats->vpu_assigned_time,
@@ -1682,6 +1763,20 @@ err_module_busy:
 	return err;
 }
 
+static u32 pva_queue_priority(struct nvhost_queue *queue)
+{
+	struct pva_queue_attribute *attrs;
+	u32 priority = PVA_QUEUE_DEFAULT_PRIORITY;
+
+	mutex_lock(&queue->attr_lock);
+	attrs = queue->attr;
+	if (attrs)
+		priority = attrs[QUEUE_ATTR_PRIORITY].value;
+	mutex_unlock(&queue->attr_lock);
+
+	return priority;
+}
+
 static int pva_queue_submit(struct nvhost_queue *queue, void *args)
 {
 	struct pva_submit_tasks *task_header = args;
@@ -1693,6 +1788,7 @@ static int pva_queue_submit(struct nvhost_queue *queue, void *args)
 		u32 *thresh = &task_header->task_thresh[i];
 
 		task->fence_num = 0;
+		task->priority = pva_queue_priority(queue);
 
 		/* First, dump the task that we are submitting */
 		pva_task_dump(task);
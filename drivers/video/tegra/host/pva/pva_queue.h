@@ -36,6 +36,7 @@ struct pva_parameter_ext {
 	size_t size;
 	struct dma_buf *dmabuf;
 	enum nvhost_buffers_heap heap;
+	u32 reg_id;
 };
 
 /**
@@ -60,6 +61,7 @@ struct pva_parameter_ext {
  * num_input_task_status	Number of input task status structures
  * num_output_task_status	Number of output task status structures
  * operation			task operation
+ * priority			queue priority when the task was submitted
  * timeout			Latest Unix time when the task must complete or
  *				0 if disabled.
  * prefences			Pre-fence structures
@@ -93,6 +95,7 @@ struct pva_submit_task {
 	u32 primary_payload_size;
 	u8 num_pointers;
 	u32 operation;
+	u32 priority;
 	u64 timeout;
 	bool invalid;
 	u32 syncpt_thresh;
@@ -19,11 +19,34 @@
 #define CREATE_TRACE_POINTS
 #include <trace/events/nvhost_pva.h>
 
+#include <linux/kernel.h>
+#include <linux/sizes.h>
+
 #include "dev.h"
+#include "nvhost_trace_stream.h"
 #include "pva.h"
 #include "pva_trace.h"
 
-static void read_linear(const char *name, struct pva_trace_log *trace, u32 toff)
+#define PVA_TRACE_STREAM_SIZE		SZ_1M
+#define PVA_TRACE_STREAM_PERIOD_MS	100
+
+static void stream_trace_point(struct pva *pva, const char *name, u64 dt,
+			       struct pva_trace_point *tp)
+{
+	char line[128];
+	int len;
+
+	len = scnprintf(line, sizeof(line),
+			"%llu %s major %u minor %u flags %u sequence %u "
+			"arg1 %u arg2 %u\n",
+			dt, name, tp->major, tp->minor, tp->flags,
+			tp->sequence, tp->arg1, tp->arg2);
+
+	nvhost_trace_stream_write(pva->trace_stream, line, len);
+}
+
+static void read_linear(struct pva *pva, const char *name,
+			struct pva_trace_log *trace, u32 toff)
 {
 	struct pva_trace_header *th = NULL;
 	struct pva_trace_block_hdr *bh = NULL;
@@ -47,6 +70,9 @@ static void read_linear(const char *name, struct pva_trace_log *trace, u32 toff)
 			trace_nvhost_pva_write(dt, name, tp->major,
 				tp->minor, tp->flags, tp->sequence,
 				tp->arg1, tp->arg2);
+
+			if (pva->trace_stream)
+				stream_trace_point(pva, name, dt, tp);
 			tp = tp + 1;
 		}
 
@@ -63,7 +89,7 @@ static void read_linear(const char *name, struct pva_trace_log *trace, u32 toff)
 }
 
 /* Read trace points from head to tail pointer */
-void pva_trace_copy_to_ftrace(struct pva *pva)
+static void pva_trace_copy_locked(struct pva *pva)
 {
 	struct pva_trace_log *trace;
 	struct pva_trace_header *th;
@@ -94,14 +120,52 @@ void pva_trace_copy_to_ftrace(struct pva *pva)
 
 	if (th->head_offset < toff) {
 		/* No circular read */
-		read_linear(dev_name, trace, toff);
+		read_linear(pva, dev_name, trace, toff);
 	} else {
 		/*
 		 * Circular read
 		 * Read from head to trace_log buffer size
 		 */
-		read_linear(dev_name, trace, trace->size);
+		read_linear(pva, dev_name, trace, trace->size);
 		/* Read from head to tail  */
-		read_linear(dev_name, trace, toff);
+		read_linear(pva, dev_name, trace, toff);
+	}
+}
+
+void pva_trace_copy_to_ftrace(struct pva *pva)
+{
+	mutex_lock(&pva->trace_lock);
+	pva_trace_copy_locked(pva);
+	mutex_unlock(&pva->trace_lock);
+}
+
+void pva_trace_set_log(struct pva *pva, void *addr)
+{
+	mutex_lock(&pva->trace_lock);
+	if (!addr)
+		pva_trace_copy_locked(pva);
+	pva->pva_trace.addr = addr;
+	mutex_unlock(&pva->trace_lock);
+}
+
+static void pva_trace_stream_drain(struct nvhost_trace_stream *stream,
+				   void *data)
+{
+	pva_trace_copy_to_ftrace(data);
+}
+
+void pva_trace_stream_init(struct pva *pva, struct dentry *dir)
+{
+	struct nvhost_trace_stream *stream;
+
+	stream = nvhost_trace_stream_create(dir, "trace_stream",
+					    PVA_TRACE_STREAM_SIZE,
+					    pva_trace_stream_drain, pva,
+					    PVA_TRACE_STREAM_PERIOD_MS);
+	if (IS_ERR(stream)) {
+		nvhost_dbg_info("Failed to create trace stream");
+		return;
 	}
+
+	pva->trace_stream = stream;
 }
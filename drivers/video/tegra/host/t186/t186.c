@@ -269,6 +269,7 @@ struct nvhost_device_data t18_msenc_info = {
 	.firmware_name		= "nvhost_nvenc061.fw",
 	.serialize		= 1,
 	.push_work_done		= 1,
+	.session_slice		= 4,
 	.resource_policy	= RESOURCE_PER_CHANNEL_INSTANCE,
 	.vm_regs		= {{0x30, true}, {0x34, false} },
 	.transcfg_addr		= 0x1844,
@@ -302,6 +303,7 @@ struct nvhost_device_data t18_nvdec_info = {
 	.num_channels		= 1,
 	.serialize		= 1,
 	.push_work_done		= 1,
+	.session_slice		= 4,
 	.resource_policy	= RESOURCE_PER_CHANNEL_INSTANCE,
 	.vm_regs		= {{0x30, true}, {0x34, false} },
 	.transcfg_addr		= 0x2c44,
@@ -335,6 +337,7 @@ struct nvhost_device_data t18_nvjpg_info = {
 	.firmware_name		= "nvhost_nvjpg011.fw",
 	.serialize		= 1,
 	.push_work_done		= 1,
+	.session_slice		= 4,
 	.resource_policy	= RESOURCE_PER_CHANNEL_INSTANCE,
 	.vm_regs		= {{0x30, true}, {0x34, false} },
 	.transcfg_addr		= 0x1444,
@@ -336,6 +336,7 @@ struct nvhost_device_data t19_msenc_info = {
 	.firmware_name		= "nvhost_nvenc070.fw",
 	.serialize		= true,
 	.push_work_done		= true,
+	.session_slice		= 4,
 	.resource_policy	= RESOURCE_PER_CHANNEL_INSTANCE,
 	.vm_regs		= {{0x30, true}, {0x34, false} },
 	.transcfg_addr		= 0x1844,
@@ -370,6 +371,7 @@ struct nvhost_device_data t19_nvenc1_info = {
 	.firmware_name		= "nvhost_nvenc070.fw",
 	.serialize		= true,
 	.push_work_done		= true,
+	.session_slice		= 4,
 	.resource_policy	= RESOURCE_PER_CHANNEL_INSTANCE,
 	.vm_regs		= {{0x30, true}, {0x34, false} },
 	.transcfg_addr		= 0x1844,
@@ -409,6 +411,7 @@ struct nvhost_device_data t19_nvdec_info = {
 	.num_channels		= 1,
 	.serialize		= true,
 	.push_work_done		= true,
+	.session_slice		= 4,
 	.resource_policy	= RESOURCE_PER_CHANNEL_INSTANCE,
 	.vm_regs		= {{0x30, true}, {0x34, false} },
 	.transcfg_addr		= 0x2c44,
@@ -445,6 +448,7 @@ struct nvhost_device_data t19_nvdec1_info = {
 	.num_channels		= 1,
 	.serialize		= true,
 	.push_work_done		= true,
+	.session_slice		= 4,
 	.resource_policy	= RESOURCE_PER_CHANNEL_INSTANCE,
 	.vm_regs		= {{0x30, true}, {0x34, false} },
 	.transcfg_addr		= 0x2c44,
@@ -480,6 +484,7 @@ struct nvhost_device_data t19_nvjpg_info = {
 	.firmware_name		= "nvhost_nvjpg012.fw",
 	.serialize		= true,
 	.push_work_done		= true,
+	.session_slice		= 4,
 	.resource_policy	= RESOURCE_PER_CHANNEL_INSTANCE,
 	.vm_regs		= {{0x30, true}, {0x34, false} },
 	.transcfg_addr		= 0x1444,
@@ -44,7 +44,7 @@ static int vhost_pb_sendrecv(struct tegra_vhost_cmd_msg *msg, size_t size_in,
 }
 
 static int vhost_channel_submit(u64 handle, struct nvhost_job *job,
-		u32 *pb_base, u32 start, u32 end, u32 job_id)
+		u32 *pb_base, u32 pb_size, u32 start, u32 end, u32 job_id)
 {
 	struct tegra_vhost_cmd_msg *msg;
 	struct tegra_vhost_channel_submit_params *p;
@@ -55,7 +55,7 @@ static int vhost_channel_submit(u64 handle, struct nvhost_job *job,
 	int err;
 
 	/* number of opcode/data pairs (8 bytes each) */
-	num_entries = ((end - start) & (PUSH_BUFFER_SIZE - 1)) / 8;
+	num_entries = ((end - start) & (pb_size - 1)) / 8;
 
 	size = sizeof(*msg) + 8 * (num_entries + job->num_syncpts);
 	msg = kmalloc(size, GFP_KERNEL);
@@ -80,8 +80,8 @@ static int vhost_channel_submit(u64 handle, struct nvhost_job *job,
 		ptr += 8 * num_entries;
 	}
 	else {
-		memcpy(ptr, (u8 *)pb_base + start, PUSH_BUFFER_SIZE - start);
-		ptr += PUSH_BUFFER_SIZE - start;
+		memcpy(ptr, (u8 *)pb_base + start, pb_size - start);
+		ptr += pb_size - start;
 		memcpy(ptr, pb_base, end);
 		ptr += end;
 	}
@@ -162,6 +162,7 @@ static void vhost_cdma_kick(struct nvhost_cdma *cdma)
 		up_read(&cdma->lock);
 		err = vhost_channel_submit(virt_ctx->handle, job,
 					cdma->push_buffer.mapped,
+					cdma->push_buffer.size,
 					start, end, cdma->last_put);
 		down_read(&cdma->lock);
 		if (err)
@@ -21,6 +21,7 @@
 #include <linux/device.h>
 #include <linux/fs.h>
 #include <linux/kfifo.h>
+#include <linux/mm.h>
 #include <linux/module.h>
 #include <linux/poll.h>
 #include <linux/version.h>
@@ -30,6 +31,7 @@
 #include <linux/slab.h>
 #include <linux/uaccess.h>
 #include <linux/sched.h>
+#include <linux/vmalloc.h>
 
 #include <media/vi.h>
 
@@ -93,6 +95,20 @@ static unsigned vi_notify_occupancy(struct vi_notify_channel *chan)
 	return ret;
 }
 
+static unsigned vi_notify_ring_occupancy(struct vi_notify_channel *chan)
+{
+	struct vi_notify_ring_header *ring = smp_load_acquire(&chan->ring);
+	u32 avail;
+
+	if (ring == NULL)
+		return 0;
+
+	/* tail is written by userspace, do not trust it */
+	avail = READ_ONCE(chan->ring_head) - READ_ONCE(ring->tail);
+
+	return min_t(u32, avail, VI_NOTIFY_RING_ENTRIES);
+}
+
 void vi_notify_channel_set_notify_funcs(struct vi_notify_channel *chan,
 			vi_notify_status_callback notify,
 			vi_notify_error_callback error,
@@ -161,6 +177,32 @@ static bool vi_notify_is_broadcast(u8 tag)
 		(1u << 14) /* Load collision */);
 }
 
+static void vi_notify_ring_put(struct vi_notify_channel *chan,
+				struct vi_notify_ring_header *ring,
+				const struct vi_notify_msg *msg)
+{
+	struct vi_notify_msg *msgs = (struct vi_notify_msg *)(ring + 1);
+	u32 head = chan->ring_head;
+
+	if (head - READ_ONCE(ring->tail) >= VI_NOTIFY_RING_ENTRIES) {
+		WRITE_ONCE(ring->overruns, ring->overruns + 1);
+		return;
+	}
+
+	msgs[head & (VI_NOTIFY_RING_ENTRIES - 1)] = *msg;
+	smp_wmb();
+	WRITE_ONCE(chan->ring_head, head + 1);
+	WRITE_ONCE(ring->head, head + 1);
+
+	/*
+	 * Only a reader that found the ring empty can be waiting. Pairs with
+	 * the barrier in vi_notify_poll().
+	 */
+	smp_mb();
+	if (READ_ONCE(ring->tail) == head)
+		wake_up(&chan->readq);
+}
+
 static void vi_notify_recv(struct vi_notify_dev *vnd,
 				const struct vi_notify_msg *msg, u8 channel)
 {
@@ -175,9 +217,16 @@ static void vi_notify_recv(struct vi_notify_dev *vnd,
 		tegra_vi_mfi_event_notify(vnd->mfi_ctx, channel);
 
 	if (chan != NULL && !((1u << tag) & atomic_read(&chan->ign_mask))) {
-		if (!kfifo_put(&chan->fifo, *msg))
-			atomic_set(&chan->overruns, 1);
-		wake_up(&chan->readq);
+		struct vi_notify_ring_header *ring =
+			smp_load_acquire(&chan->ring);
+
+		if (ring != NULL) {
+			vi_notify_ring_put(chan, ring, msg);
+		} else {
+			if (!kfifo_put(&chan->fifo, *msg))
+				atomic_set(&chan->overruns, 1);
+			wake_up(&chan->readq);
+		}
 	}
 	rcu_read_unlock();
 }
@@ -267,7 +316,10 @@ static unsigned int vi_notify_poll(struct file *file,
 
 	poll_wait(file, &chan->readq, table);
 
-	if (vi_notify_occupancy(chan))
+	/* pairs with the barrier in vi_notify_ring_put() */
+	smp_mb();
+
+	if (vi_notify_occupancy(chan) || vi_notify_ring_occupancy(chan))
 		ret |= POLLIN | POLLRDNORM;
 	if (atomic_read(&chan->overruns) || atomic_read(&chan->errors))
 		ret |= POLLERR;
@@ -399,7 +451,8 @@ static long vi_notify_ioctl(struct file *file, unsigned int cmd,
 	case FIONREAD: {
 		int val;
 
-		val = vi_notify_occupancy(chan);
+		val = vi_notify_occupancy(chan) +
+			vi_notify_ring_occupancy(chan);
 		val *= sizeof(struct vi_notify_msg);
 		return put_user(val, (int __user *)arg);
 	}
@@ -554,6 +607,15 @@ module_put:
 }
 EXPORT_SYMBOL(vi_notify_channel_open);
 
+static void vi_notify_channel_free(struct rcu_head *rcu)
+{
+	struct vi_notify_channel *chan =
+		container_of(rcu, struct vi_notify_channel, rcu);
+
+	vfree(chan->ring);
+	kfree(chan);
+}
+
 int vi_notify_channel_close(unsigned channel, struct vi_notify_channel *chan)
 {
 	struct vi_notify_dev *vnd = chan->vnd;
@@ -567,7 +629,7 @@ int vi_notify_channel_close(unsigned channel, struct vi_notify_channel *chan)
 
 	vi_notify_dev_classify(vnd);
 	mutex_unlock(&vnd->lock);
-	kfree_rcu(chan, rcu);
+	call_rcu(&chan->rcu, vi_notify_channel_free);
 	vi_notifier_idle(vnd);
 	module_put(vnd->driver->owner);
 
@@ -580,7 +642,8 @@ static int vi_notify_open(struct inode *inode, struct file *file)
 	struct vi_notify_channel *chan;
 	unsigned channel = iminor(inode);
 
-	if ((file->f_flags & O_ACCMODE) != O_RDONLY)
+	/* O_RDWR is needed to map the event ring and advance its tail */
+	if ((file->f_flags & O_ACCMODE) == O_WRONLY)
 		return -EINVAL;
 
 	chan = vi_notify_channel_open(channel);
@@ -592,6 +655,41 @@ static int vi_notify_open(struct inode *inode, struct file *file)
 	return nonseekable_open(inode, file);
 }
 
+static int vi_notify_mmap(struct file *file, struct vm_area_struct *vma)
+{
+	struct vi_notify_channel *chan = file->private_data;
+	struct vi_notify_ring_header *ring;
+	int err;
+
+	if (vma->vm_pgoff ||
+		vma->vm_end - vma->vm_start > VI_NOTIFY_RING_SIZE)
+		return -EINVAL;
+
+	if (mutex_lock_interruptible(&chan->read_lock))
+		return -ERESTARTSYS;
+
+	ring = chan->ring;
+	if (ring == NULL) {
+		ring = vmalloc_user(VI_NOTIFY_RING_SIZE);
+		if (ring == NULL) {
+			err = -ENOMEM;
+			goto unlock;
+		}
+
+		ring->magic = VI_NOTIFY_RING_MAGIC;
+		ring->entries = VI_NOTIFY_RING_ENTRIES;
+
+		/* events are delivered to the ring from now on */
+		smp_store_release(&chan->ring, ring);
+	}
+
+	err = remap_vmalloc_range(vma, ring, 0);
+unlock:
+	mutex_unlock(&chan->read_lock);
+
+	return err;
+}
+
 static int vi_notify_release(struct inode *inode, struct file *file)
 {
 	struct vi_notify_channel *chan = file->private_data;
@@ -605,6 +703,7 @@ static const struct file_operations vi_notify_fops = {
 	.llseek = no_llseek,
 	.read = vi_notify_read,
 	.poll = vi_notify_poll,
+	.mmap = vi_notify_mmap,
 	.unlocked_ioctl = vi_notify_ioctl,
 #ifdef CONFIG_COMPAT
 	.compat_ioctl = vi_notify_ioctl,
@@ -34,6 +34,31 @@ struct vi_notify_msg {
 	u32 reserve;
 };
 
+/*
+ * Event ring shared with userspace through mmap() of the channel device.
+ * Once the channel is mapped, events are written to the ring instead of
+ * the read() fifo. The kernel produces at head and userspace consumes at
+ * tail. Both count messages and wrap at 2^32, the slot of a message is
+ * its count modulo entries. head and tail sit on separate cache lines,
+ * the messages follow the header.
+ */
+#define VI_NOTIFY_RING_MAGIC	0x564e5247	/* "VNRG" */
+#define VI_NOTIFY_RING_ENTRIES	(1 << 12)
+
+struct vi_notify_ring_header {
+	u32 magic;
+	u32 entries;
+	u32 head;	/* written by the kernel */
+	u32 overruns;	/* messages dropped on a full ring */
+	u32 reserved0[12];
+	u32 tail;	/* written by userspace */
+	u32 reserved1[15];
+};
+
+#define VI_NOTIFY_RING_SIZE \
+	PAGE_ALIGN(sizeof(struct vi_notify_ring_header) + \
+		VI_NOTIFY_RING_ENTRIES * sizeof(struct vi_notify_msg))
+
 #define VI_NOTIFY_TAG_VALID(tag)	((tag) & 1)
 #define VI_NOTIFY_TAG_TAG(tag)		(((tag) >> 1) & 0x7f)
 #define VI_NOTIFY_TAG_CHANNEL(tag)	(((tag) >> 8) & 0xff)
@@ -120,6 +145,9 @@ struct vi_notify_channel {
 	DECLARE_KFIFO(fifo, struct vi_notify_msg, 128);
 	struct vi_capture_status status;
 
+	struct vi_notify_ring_header *ring;
+	u32 ring_head;
+
 	vi_notify_status_callback notify_cb;
 	vi_notify_error_callback error_cb;
 
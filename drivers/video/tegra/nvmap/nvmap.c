@@ -74,13 +74,20 @@ void *__nvmap_kmap(struct nvmap_handle *h, unsigned int pagenum)
 			goto out;
 		kaddr = (ulong)area->addr;
 
-		if (h->heap_pgalloc)
+		if (h->heap_pgalloc) {
+			nvmap_handle_zero_page(h, pagenum);
 			paddr = page_to_phys(nvmap_to_page(
 						h->pgalloc.pages[pagenum]));
-		else
+			ioremap_page_range(kaddr, kaddr + PAGE_SIZE,
+					   paddr, prot);
+		} else {
+			/* keep carveout compaction from moving the block */
+			mutex_lock(&h->lock);
 			paddr = h->carveout->base + pagenum * PAGE_SIZE;
-
-		ioremap_page_range(kaddr, kaddr + PAGE_SIZE, paddr, prot);
+			ioremap_page_range(kaddr, kaddr + PAGE_SIZE,
+					   paddr, prot);
+			mutex_unlock(&h->lock);
+		}
 	}
 	return (void *)kaddr;
 out:
@@ -161,6 +168,7 @@ void *__nvmap_mmap(struct nvmap_handle *h)
 	prot = nvmap_pgprot(h, PG_PROT_KERNEL);
 
 	if (h->heap_pgalloc) {
+		nvmap_handle_zero_pages(h);
 		pages = nvmap_pages(h->pgalloc.pages, h->size >> PAGE_SHIFT);
 		if (!pages)
 			goto out;
@@ -177,14 +185,20 @@ void *__nvmap_mmap(struct nvmap_handle *h)
 		return h->vaddr;
 	}
 
-	/* carveout - explicitly map the pfns into a vmalloc area */
+	/*
+	 * carveout - explicitly map the pfns into a vmalloc area. The handle
+	 * lock keeps carveout compaction from moving the block meanwhile.
+	 */
+	mutex_lock(&h->lock);
 	adj_size = h->carveout->base & ~PAGE_MASK;
 	adj_size += h->size;
 	adj_size = PAGE_ALIGN(adj_size);
 
 	v = alloc_vm_area(adj_size, NULL);
-	if (!v)
+	if (!v) {
+		mutex_unlock(&h->lock);
 		goto out;
+	}
 
 	vaddr = v->addr + (h->carveout->base & ~PAGE_MASK);
 	ioremap_page_range((ulong)v->addr, (ulong)v->addr + adj_size,
@@ -199,6 +213,7 @@ void *__nvmap_mmap(struct nvmap_handle *h)
 		free_vm_area(vm);
 		nvmap_kmaps_dec(h);
 	}
+	mutex_unlock(&h->lock);
 
 	/* leave the handle ref count incremented by 1, so that
 	 * the handle will not be freed while the kernel mapping exists.
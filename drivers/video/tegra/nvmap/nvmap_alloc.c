@@ -21,6 +21,7 @@
 #include <linux/random.h>
 #include <soc/tegra/chip-id.h>
 #include <trace/events/nvmap.h>
+#include <linux/nvmap_t19x.h>
 
 #include "nvmap_priv.h"
 
@@ -56,6 +57,148 @@ void nvmap_altfree(void *ptr, size_t len)
 		kfree(ptr);
 }
 
+/*
+ * Pages of handles allocated with NVMAP_HANDLE_SKIP_ZERO or
+ * NVMAP_HANDLE_ZERO_ON_FAULT go back to the allocating client when the
+ * handle is freed, so that later such allocations of the same client can
+ * reuse them without zeroing. The stale data never leaves the client it
+ * came from; everything else still goes through the zeroing page pool.
+ */
+static uint recycle_pages_per_client = 1024;
+module_param(recycle_pages_per_client, uint, 0644);
+
+static bool nvmap_handle_can_recycle(struct nvmap_client *client,
+				     struct nvmap_handle *h)
+{
+	if (!client || !recycle_pages_per_client)
+		return false;
+
+	if (!(h->userflags & (NVMAP_HANDLE_SKIP_ZERO |
+			      NVMAP_HANDLE_ZERO_ON_FAULT)))
+		return false;
+
+	return !(h->userflags & NVMAP_HANDLE_SECURE);
+}
+
+static int nvmap_client_recycle_take(struct nvmap_client *client,
+				     struct page **pages, int nr)
+{
+	struct page *page, *tmp;
+	int i = 0;
+
+	spin_lock(&client->recycle_lock);
+	list_for_each_entry_safe(page, tmp, &client->recycle_pages, lru) {
+		if (i == nr)
+			break;
+		list_del(&page->lru);
+		pages[i++] = page;
+	}
+	client->recycle_count -= i;
+	spin_unlock(&client->recycle_lock);
+
+	return i;
+}
+
+static int nvmap_client_recycle_give(struct nvmap_client *client,
+				     struct page **pages, int nr)
+{
+	int i = 0;
+
+	spin_lock(&client->recycle_lock);
+	while (!client->recycle_closed && i < nr &&
+	       client->recycle_count < recycle_pages_per_client) {
+		/*
+		 * Still pinned by get_user_pages(), e.g. O_DIRECT I/O into
+		 * an mmap of the handle that is yet to complete. Drop our
+		 * ref, the page is freed once the I/O lets go of it.
+		 */
+		if (page_count(pages[i]) > 1) {
+			__free_page(pages[i++]);
+			continue;
+		}
+		list_add_tail(&pages[i++]->lru, &client->recycle_pages);
+		client->recycle_count++;
+	}
+	spin_unlock(&client->recycle_lock);
+
+	return i;
+}
+
+/* Client is going away: hand its stale pages to the pool for zeroing. */
+void nvmap_client_recycle_release(struct nvmap_client *client)
+{
+	struct page *page, *tmp;
+	LIST_HEAD(pages);
+
+	spin_lock(&client->recycle_lock);
+	client->recycle_closed = true;
+	list_splice_init(&client->recycle_pages, &pages);
+	client->recycle_count = 0;
+	spin_unlock(&client->recycle_lock);
+
+	list_for_each_entry_safe(page, tmp, &pages, lru) {
+		list_del(&page->lru);
+#ifdef CONFIG_NVMAP_PAGE_POOLS
+		if (nvmap_page_pool_fill_lots(&nvmap_dev->pool, &page, 1))
+			continue;
+#endif
+		__free_page(page);
+	}
+}
+
+void nvmap_client_recycle_put(struct nvmap_client *client)
+{
+	if (atomic_dec_and_test(&client->recycle_refs))
+		kfree(client);
+}
+
+/* Called with h->lock held. */
+static void __nvmap_handle_zero_page(struct nvmap_handle *h,
+				     unsigned int pagenum)
+{
+	struct page *page;
+
+	if (!nvmap_page_zero_pending(h->pgalloc.pages[pagenum]))
+		return;
+
+	page = nvmap_to_page(h->pgalloc.pages[pagenum]);
+	clear_highpage(page);
+	nvmap_clean_cache_page(page);
+
+	h->pgalloc.pages[pagenum] = (struct page *)
+		((unsigned long)h->pgalloc.pages[pagenum] &
+		 ~NVMAP_PAGE_ZERO_PENDING);
+	atomic_dec(&h->pgalloc.nzero);
+	nvmap_stats_inc(NS_ZERO_ON_FAULT, PAGE_SIZE);
+}
+
+/*
+ * Zero a page of an NVMAP_HANDLE_ZERO_ON_FAULT handle before the CPU gets
+ * to see it. Pages that only the device ever touches are never zeroed.
+ */
+void nvmap_handle_zero_page(struct nvmap_handle *h, unsigned int pagenum)
+{
+	if (!h->heap_pgalloc || !atomic_read(&h->pgalloc.nzero))
+		return;
+
+	mutex_lock(&h->lock);
+	__nvmap_handle_zero_page(h, pagenum);
+	mutex_unlock(&h->lock);
+}
+
+void nvmap_handle_zero_pages(struct nvmap_handle *h)
+{
+	unsigned int i;
+
+	if (!h->heap_pgalloc || !atomic_read(&h->pgalloc.nzero))
+		return;
+
+	mutex_lock(&h->lock);
+	for (i = 0; i < h->size >> PAGE_SHIFT; i++)
+		__nvmap_handle_zero_page(h, i);
+	mutex_unlock(&h->lock);
+}
+
 static struct page *nvmap_alloc_pages_exact(gfp_t gfp, size_t size)
 {
 	struct page *page, *p, *e;
@@ -75,6 +218,12 @@ static struct page *nvmap_alloc_pages_exact(gfp_t gfp, size_t size)
 	return page;
 }
 
+/* Big page sizes tried from the page allocator, largest first */
+static const size_t nvmap_big_page_sizes[] = {
+	NVMAP_PP_HUGE_PAGE_SIZE,
+	NVMAP_PP_BIG_PAGE_SIZE,
+};
+
 static uint s_nr_colors = 1;
 module_param_named(nr_colors, s_nr_colors, uint, 0644);
 
@@ -452,15 +601,18 @@ static int alloc_colored(struct nvmap_page_pool *pool, u32 nr_pages,
 }
 
 static int handle_page_alloc(struct nvmap_client *client,
-			     struct nvmap_handle *h, bool contiguous)
+			     struct nvmap_handle *h, bool contiguous,
+			     bool *from_pool)
 {
 	size_t size = h->size;
 	int nr_page = size >> PAGE_SHIFT;
-	int i = 0, page_index = 0;
+	int i = 0, page_index = 0, nr_recycled = 0, nr_pool = 0;
 	struct page **pages;
 	gfp_t gfp = GFP_NVMAP | __GFP_ZERO;
-	int pages_per_big_pg = NVMAP_PP_BIG_PAGE_SIZE >> PAGE_SHIFT;
+	int pages_per_big_pg;
 	static u32 chipid;
+	bool recycle;
+	int t;
 
 	if (!chipid) {
 #ifdef CONFIG_NVMAP_COLOR_PAGES
@@ -474,6 +626,8 @@ static int handle_page_alloc(struct nvmap_client *client,
 	if (!pages)
 		return -ENOMEM;
 
+	recycle = nvmap_handle_can_recycle(client, h);
+
 	if (contiguous) {
 		struct page *page;
 		page = nvmap_alloc_pages_exact(gfp, size);
@@ -484,41 +638,60 @@ static int handle_page_alloc(struct nvmap_client *client,
 			pages[i] = nth_page(page, i);
 
 	} else {
+		/*
+		 * Stale pages of this client need no zeroing, but dirty
+		 * lines still have to be cleaned before the device writes.
+		 */
+		if (recycle) {
+			nr_recycled = nvmap_client_recycle_take(client, pages,
+								nr_page);
+			nvmap_clean_cache(pages, nr_recycled);
+			nvmap_stats_inc(NS_RECYCLED, nr_recycled << PAGE_SHIFT);
+			page_index = nr_recycled;
+		}
 #ifdef CONFIG_NVMAP_PAGE_POOLS
 		/* Get as many big pages from the pool as possible. */
-		page_index = nvmap_page_pool_alloc_lots_bp(&nvmap_dev->pool, pages,
-								 nr_page);
-		pages_per_big_pg = nvmap_dev->pool.pages_per_big_pg;
+		page_index += nvmap_page_pool_alloc_lots_bp(&nvmap_dev->pool,
+				&pages[page_index], nr_page - page_index);
 #endif
-		/* Try to allocate big pages from page allocator */
-		for (i = page_index;
-		     i < nr_page && pages_per_big_pg > 1 && (nr_page - i) >= pages_per_big_pg;
-		     i += pages_per_big_pg, page_index += pages_per_big_pg) {
-			struct page *page;
-			int idx;
-			/*
-			 * set the gfp not to trigger direct/kswapd reclaims and
-			 * not to use emergency reserves.
-			 */
-			gfp_t gfp_no_reclaim = (gfp | __GFP_NOMEMALLOC) & ~__GFP_RECLAIM;
-
-			page = nvmap_alloc_pages_exact(gfp_no_reclaim,
-					pages_per_big_pg << PAGE_SHIFT);
-			if (!page)
-				break;
-
-			for (idx = 0; idx < pages_per_big_pg; idx++)
-				pages[i + idx] = nth_page(page, idx);
-			nvmap_clean_cache(&pages[i], pages_per_big_pg);
+		nr_pool = page_index;
+		/*
+		 * Try to allocate big pages from page allocator, falling back
+		 * from the largest size to the smallest one.
+		 */
+		for (t = 0; t < ARRAY_SIZE(nvmap_big_page_sizes); t++) {
+			pages_per_big_pg = nvmap_big_page_sizes[t] >> PAGE_SHIFT;
+
+			for (i = page_index;
+			     i < nr_page && pages_per_big_pg > 1 && (nr_page - i) >= pages_per_big_pg;
+			     i += pages_per_big_pg, page_index += pages_per_big_pg) {
+				struct page *page;
+				int idx;
+				/*
+				 * set the gfp not to trigger direct/kswapd
+				 * reclaims and not to use emergency reserves.
+				 */
+				gfp_t gfp_no_reclaim = (gfp | __GFP_NOMEMALLOC) & ~__GFP_RECLAIM;
+
+				page = nvmap_alloc_pages_exact(gfp_no_reclaim,
+						pages_per_big_pg << PAGE_SHIFT);
+				if (!page)
+					break;
+
+				for (idx = 0; idx < pages_per_big_pg; idx++)
+					pages[i + idx] = nth_page(page, idx);
+				nvmap_clean_cache(&pages[i], pages_per_big_pg);
+			}
 		}
-		nvmap_big_page_allocs += page_index;
+		nvmap_big_page_allocs += page_index - nr_recycled;
 
 		if (s_nr_colors <= 1) {
 #ifdef CONFIG_NVMAP_PAGE_POOLS
 			/* Get as many 4K pages from the pool as possible. */
-			page_index += nvmap_page_pool_alloc_lots(
-				      &nvmap_dev->pool, &pages[page_index],
-				      nr_page - page_index);
+			i = nvmap_page_pool_alloc_lots(&nvmap_dev->pool,
+				&pages[page_index], nr_page - page_index);
+			page_index += i;
+			nr_pool += i;
 #endif
 
 			for (i = page_index; i < nr_page; i++) {
@@ -546,9 +719,23 @@ static int handle_page_alloc(struct nvmap_client *client,
 	if (page_index < nr_page)
 		nvmap_clean_cache(&pages[page_index], nr_page - page_index);
 
+	if (h->userflags & NVMAP_HANDLE_ZERO_ON_FAULT) {
+		for (i = 0; i < nr_recycled; i++)
+			pages[i] = (struct page *)((unsigned long)pages[i] |
+						   NVMAP_PAGE_ZERO_PENDING);
+	}
+
+	if (recycle) {
+		atomic_inc(&client->recycle_refs);
+		h->recycle_client = client;
+	}
+
+	*from_pool = nr_pool == nr_page;
 	h->pgalloc.pages = pages;
 	h->pgalloc.contig = contiguous;
 	atomic_set(&h->pgalloc.ndirty, 0);
+	atomic_set(&h->pgalloc.nzero,
+		   (h->userflags & NVMAP_HANDLE_ZERO_ON_FAULT) ? nr_recycled : 0);
 	return 0;
 
 fail:
@@ -637,6 +824,8 @@ static void alloc_handle(struct nvmap_client *client,
 {
 	unsigned int carveout_mask = NVMAP_HEAP_CARVEOUT_MASK;
 	unsigned int iovmm_mask = NVMAP_HEAP_IOVMM;
+	ktime_t start = ktime_get();
+	bool from_pool;
 	int ret;
 
 	BUG_ON(type & (type - 1));
@@ -664,6 +853,9 @@ static void alloc_handle(struct nvmap_client *client,
 			 */
 			mb();
 			h->alloc = true;
+			nvmap_stats_alloc_record(NVMAP_ALLOC_SRC_CARVEOUT,
+				h->size, ktime_to_ns(ktime_sub(ktime_get(),
+							       start)));
 			return;
 		}
 		ret = nvmap_heap_pgalloc(client, h, type);
@@ -673,15 +865,20 @@ static void alloc_handle(struct nvmap_client *client,
 		h->heap_pgalloc = true;
 		mb();
 		h->alloc = true;
+		nvmap_stats_alloc_record(NVMAP_ALLOC_SRC_CARVEOUT, h->size,
+				ktime_to_ns(ktime_sub(ktime_get(), start)));
 	} else if (type & iovmm_mask) {
 		ret = handle_page_alloc(client, h,
-			h->userflags & NVMAP_HANDLE_PHYS_CONTIG);
+			h->userflags & NVMAP_HANDLE_PHYS_CONTIG, &from_pool);
 		if (ret)
 			return;
 		h->heap_type = NVMAP_HEAP_IOVMM;
 		h->heap_pgalloc = true;
 		mb();
 		h->alloc = true;
+		nvmap_stats_alloc_record(from_pool ? NVMAP_ALLOC_SRC_POOL :
+				NVMAP_ALLOC_SRC_PAGE, h->size,
+				ktime_to_ns(ktime_sub(ktime_get(), start)));
 	}
 }
 
@@ -722,10 +919,12 @@ static int alloc_handle_from_va(struct nvmap_client *client,
 /* small allocations will try to allocate from generic OS memory before
  * any of the limited heaps, to increase the effective memory for graphics
  * allocations, and to reduce fragmentation of the graphics heaps with
- * sub-page splinters */
+ * sub-page splinters. On-chip RAM is asked for explicitly, it is tried
+ * first and DRAM is only the fallback when it is full. */
 static const unsigned int heap_policy_small[] = {
 	NVMAP_HEAP_CARVEOUT_VPR,
 	NVMAP_HEAP_CARVEOUT_IRAM,
+	NVMAP_HEAP_CARVEOUT_CVSRAM,
 	NVMAP_HEAP_CARVEOUT_MASK,
 	NVMAP_HEAP_IOVMM,
 	0,
@@ -734,6 +933,7 @@ static const unsigned int heap_policy_small[] = {
 static const unsigned int heap_policy_large[] = {
 	NVMAP_HEAP_CARVEOUT_VPR,
 	NVMAP_HEAP_CARVEOUT_IRAM,
+	NVMAP_HEAP_CARVEOUT_CVSRAM,
 	NVMAP_HEAP_IOVMM,
 	NVMAP_HEAP_CARVEOUT_MASK,
 	0,
@@ -757,6 +957,7 @@ int nvmap_alloc_handle(struct nvmap_client *client,
 	int err = -ENOMEM;
 	int tag, i;
 	bool alloc_from_excl = false;
+	bool want_cvsram = false;
 
 	h = nvmap_handle_get(h);
 
@@ -822,6 +1023,10 @@ int nvmap_alloc_handle(struct nvmap_client *client,
 	alloc_policy = alloc_from_excl ? heap_policy_excl :
 			(nr_page == 1) ? heap_policy_small : heap_policy_large;
 
+	want_cvsram = heap_mask & NVMAP_HEAP_CARVEOUT_CVSRAM;
+	if (want_cvsram)
+		nvmap_stats_inc(NS_CVSRAM_RQ, h->size);
+
 	while (!h->alloc && *alloc_policy) {
 		unsigned int heap_type;
 
@@ -850,6 +1055,9 @@ out:
 			nvmap_stats_inc(NS_KALLOC, h->size);
 		else
 			nvmap_stats_inc(NS_UALLOC, h->size);
+		if (want_cvsram &&
+		    h->heap_type == NVMAP_HEAP_CARVEOUT_CVSRAM)
+			nvmap_stats_inc(NS_CVSRAM_HIT, h->size);
 		NVMAP_TAG_TRACE(trace_nvmap_alloc_handle_done,
 			NVMAP_TP_ARGS_CHR(client, h, NULL));
 		err = 0;
@@ -966,10 +1174,17 @@ void _nvmap_handle_free(struct nvmap_handle *h)
 	for (i = 0; i < nr_page; i++)
 		h->pgalloc.pages[i] = nvmap_to_page(h->pgalloc.pages[i]);
 
+	if (h->recycle_client) {
+		page_index = nvmap_client_recycle_give(h->recycle_client,
+					h->pgalloc.pages, nr_page);
+		nvmap_client_recycle_put(h->recycle_client);
+	}
+
 #ifdef CONFIG_NVMAP_PAGE_POOLS
 	if (!h->from_va)
-		page_index = nvmap_page_pool_fill_lots(&nvmap_dev->pool,
-					h->pgalloc.pages, nr_page);
+		page_index += nvmap_page_pool_fill_lots(&nvmap_dev->pool,
+					&h->pgalloc.pages[page_index],
+					nr_page - page_index);
 #endif
 
 	for (i = page_index; i < nr_page; i++) {
@@ -19,6 +19,10 @@
 #include <linux/io.h>
 #include <linux/debugfs.h>
 #include <linux/of.h>
+#include <linux/ktime.h>
+#include <linux/moduleparam.h>
+#include <linux/vmalloc.h>
+#include <linux/workqueue.h>
 #include <soc/tegra/chip-id.h>
 
 #include <trace/events/nvmap.h>
@@ -34,6 +38,12 @@ int nvmap_cache_maint_by_set_ways = 1;
 size_t cache_maint_inner_threshold = 8 * SZ_2M;
 #endif
 
+/* Thresholds measured by nvmap_cache_calibrate(), 0 when not calibrated */
+size_t cache_maint_calibrated_threshold[2];
+
+static bool calibrate_cache_maint = true;
+module_param(calibrate_cache_maint, bool, 0644);
+
 static struct static_key nvmap_disable_vaddr_for_cache_maint;
 void (*nvmap_get_cacheability)(struct nvmap_handle *h,
 		bool *inner, bool *outer);
@@ -240,7 +250,7 @@ static inline bool can_fast_cache_maint(unsigned long start,
 		return false;
 
 	if ((op == NVMAP_CACHE_OP_INV) ||
-		((end - start) < cache_maint_inner_threshold))
+		((end - start) < nvmap_cache_inner_threshold(op)))
 		return false;
 	return true;
 }
@@ -361,7 +371,7 @@ out:
 	if (!err) {
 		if (can_fast_cache_maint(pstart, pend, op))
 			nvmap_stats_inc(NS_CFLUSH_DONE,
-					cache_maint_inner_threshold);
+					nvmap_cache_inner_threshold(op));
 		else
 			nvmap_stats_inc(NS_CFLUSH_DONE, pend - pstart);
 	}
@@ -496,7 +506,7 @@ static int __nvmap_do_cache_maint_list(struct nvmap_handle **handles,
 		"cache list operation may not function properly");
 
 	if (nvmap_cache_maint_by_set_ways)
-		thresh = cache_maint_inner_threshold;
+		thresh = nvmap_cache_inner_threshold(op);
 
 	for (i = 0; i < nr; i++) {
 		bool inner, outer;
@@ -586,6 +596,195 @@ inline int nvmap_do_cache_maint_list(struct nvmap_handle **handles,
 	return ret;
 }
 
+#define NVMAP_CACHE_CALIB_MIN_SIZE	SZ_256K
+#define NVMAP_CACHE_CALIB_NR_SIZES	7	/* 256K to 16M */
+#define NVMAP_CACHE_CALIB_MAX_SIZE	\
+	(NVMAP_CACHE_CALIB_MIN_SIZE << (NVMAP_CACHE_CALIB_NR_SIZES - 1))
+#define NVMAP_CACHE_CALIB_RUNS		3
+
+static const unsigned int nvmap_cache_calib_ops[] = {
+	NVMAP_CACHE_OP_WB,
+	NVMAP_CACHE_OP_WB_INV,
+};
+
+static struct nvmap_cache_calib {
+	u64 range_ns[2][NVMAP_CACHE_CALIB_NR_SIZES];
+	u64 full_ns[2];
+	u64 runs;
+} nvmap_cache_calib;
+static DEFINE_MUTEX(nvmap_cache_calib_lock);
+
+/* Best of a few runs, each on a freshly dirtied buffer */
+static u64 nvmap_cache_calib_time(void *buf, size_t size, unsigned int op,
+				  bool full)
+{
+	u64 best = U64_MAX;
+	int run;
+
+	for (run = 0; run < NVMAP_CACHE_CALIB_RUNS; run++) {
+		ktime_t start;
+		u64 ns;
+
+		memset(buf, run, size);
+		start = ktime_get();
+		if (!full)
+			inner_cache_maint(op, buf, size);
+		else if (op == NVMAP_CACHE_OP_WB)
+			inner_clean_cache_all();
+		else
+			inner_flush_cache_all();
+		ns = ktime_to_ns(ktime_sub(ktime_get(), start));
+		best = min(best, ns);
+	}
+
+	return best;
+}
+
+/*
+ * Find the size at which maintenance by range becomes as expensive as a
+ * full clean/flush, interpolating between the measured sizes.
+ */
+static size_t nvmap_cache_calib_threshold(const u64 *range_ns, u64 full_ns)
+{
+	size_t lo_sz, hi_sz;
+	u64 lo_ns, hi_ns;
+	int i;
+
+	for (i = 0; i < NVMAP_CACHE_CALIB_NR_SIZES; i++)
+		if (range_ns[i] >= full_ns)
+			break;
+
+	if (i == 0)
+		return NVMAP_CACHE_CALIB_MIN_SIZE;
+
+	if (i == NVMAP_CACHE_CALIB_NR_SIZES) {
+		/* Extrapolate from the largest measured size */
+		hi_ns = max_t(u64, range_ns[i - 1], 1);
+		return (size_t)min_t(u64, div64_u64(full_ns *
+				NVMAP_CACHE_CALIB_MAX_SIZE, hi_ns), SZ_1G);
+	}
+
+	lo_sz = NVMAP_CACHE_CALIB_MIN_SIZE << (i - 1);
+	hi_sz = NVMAP_CACHE_CALIB_MIN_SIZE << i;
+	lo_ns = range_ns[i - 1];
+	hi_ns = range_ns[i];
+	if (hi_ns <= lo_ns)
+		return hi_sz;
+
+	return lo_sz + (size_t)div64_u64((u64)(hi_sz - lo_sz) *
+					 (full_ns - lo_ns), hi_ns - lo_ns);
+}
+
+/*
+ * Measure the cost of maintenance by range against a full inner clean and
+ * flush on the running SoC and derive a threshold for each from it.
+ */
+int nvmap_cache_calibrate(void)
+{
+	struct nvmap_cache_calib *calib = &nvmap_cache_calib;
+	void *buf;
+	int i, j;
+
+	if (!nvmap_cache_maint_by_set_ways)
+		return -EOPNOTSUPP;
+
+	buf = vmalloc(NVMAP_CACHE_CALIB_MAX_SIZE);
+	if (!buf)
+		return -ENOMEM;
+
+	mutex_lock(&nvmap_cache_calib_lock);
+	for (i = 0; i < ARRAY_SIZE(nvmap_cache_calib_ops); i++) {
+		unsigned int op = nvmap_cache_calib_ops[i];
+		size_t thresh;
+
+		calib->full_ns[i] = nvmap_cache_calib_time(buf,
+				NVMAP_CACHE_CALIB_MAX_SIZE, op, true);
+		for (j = 0; j < NVMAP_CACHE_CALIB_NR_SIZES; j++)
+			calib->range_ns[i][j] = nvmap_cache_calib_time(buf,
+				NVMAP_CACHE_CALIB_MIN_SIZE << j, op, false);
+
+		thresh = nvmap_cache_calib_threshold(calib->range_ns[i],
+						     calib->full_ns[i]);
+		WRITE_ONCE(cache_maint_calibrated_threshold[i], thresh);
+	}
+	calib->runs++;
+	mutex_unlock(&nvmap_cache_calib_lock);
+
+	vfree(buf);
+
+	pr_info("calibrated inner threshold wb %zuB wb_inv %zuB\n",
+		cache_maint_calibrated_threshold[0],
+		cache_maint_calibrated_threshold[1]);
+	return 0;
+}
+
+static void nvmap_cache_calibrate_work(struct work_struct *work)
+{
+	nvmap_cache_calibrate();
+}
+static DECLARE_WORK(nvmap_cache_calib_work, nvmap_cache_calibrate_work);
+
+void nvmap_cache_calibrate_at_boot(void)
+{
+	if (calibrate_cache_maint)
+		schedule_work(&nvmap_cache_calib_work);
+}
+
+static int cache_calibration_show(struct seq_file *m, void *v)
+{
+	struct nvmap_cache_calib *calib = &nvmap_cache_calib;
+	int i, j;
+
+	mutex_lock(&nvmap_cache_calib_lock);
+	seq_printf(m, "runs: %llu\n", calib->runs);
+	for (i = 0; i < ARRAY_SIZE(nvmap_cache_calib_ops); i++) {
+		seq_printf(m, "%s: threshold %zuB full %lluns\n",
+			   i ? "wb_inv" : "wb",
+			   cache_maint_calibrated_threshold[i],
+			   calib->full_ns[i]);
+		for (j = 0; j < NVMAP_CACHE_CALIB_NR_SIZES; j++)
+			seq_printf(m, "  %8zuK range %lluns\n",
+				   (size_t)(NVMAP_CACHE_CALIB_MIN_SIZE << j) >> 10,
+				   calib->range_ns[i][j]);
+	}
+	mutex_unlock(&nvmap_cache_calib_lock);
+
+	return 0;
+}
+
+static int cache_calibration_open(struct inode *inode, struct file *file)
+{
+	return single_open(file, cache_calibration_show, inode->i_private);
+}
+
+static ssize_t cache_calibration_write(struct file *file,
+				       const char __user *buffer,
+				       size_t count, loff_t *pos)
+{
+	bool run;
+	int ret;
+
+	ret = kstrtobool_from_user(buffer, count, &run);
+	if (ret)
+		return ret;
+
+	if (run) {
+		ret = nvmap_cache_calibrate();
+		if (ret)
+			return ret;
+	}
+
+	return count;
+}
+
+static const struct file_operations cache_calibration_fops = {
+	.open		= cache_calibration_open,
+	.read		= seq_read,
+	.llseek		= seq_lseek,
+	.release	= single_release,
+	.write		= cache_calibration_write,
+};
+
 static int cache_inner_threshold_show(struct seq_file *m, void *v)
 {
 	if (nvmap_cache_maint_by_set_ways)
@@ -621,6 +820,10 @@ static ssize_t cache_inner_threshold_write(struct file *file,
 	if (ret != 1)
 		return -EINVAL;
 
+	/* A manually set threshold overrides the calibrated ones */
+	WRITE_ONCE(cache_maint_calibrated_threshold[0], 0);
+	WRITE_ONCE(cache_maint_calibrated_threshold[1], 0);
+
 	pr_debug("nvmap:cache_maint_inner_threshold is now :%zuB\n",
 			cache_maint_inner_threshold);
 	return count;
@@ -656,6 +859,12 @@ int nvmap_cache_debugfs_init(struct dentry *nvmap_root)
 			    cache_root,
 			    NULL,
 			    &cache_inner_threshold_fops);
+
+	debugfs_create_file("cache_maint_calibration",
+			    S_IRUSR | S_IWUSR,
+			    cache_root,
+			    NULL,
+			    &cache_calibration_fops);
 	}
 
 	debugfs_create_atomic_t("nvmap_disable_vaddr_for_cache_maint",
@@ -663,5 +872,7 @@ int nvmap_cache_debugfs_init(struct dentry *nvmap_root)
 				cache_root,
 				&nvmap_disable_vaddr_for_cache_maint.enabled);
 
+	nvmap_cache_async_debugfs_init(cache_root);
+
 	return 0;
 }
@@ -0,0 +1,444 @@
+/*
+ * drivers/video/tegra/nvmap/nvmap_cache_async.c
+ *
+ * Asynchronous, batched cache maintenance for nvmap handles
+ *
+ * Copyright (c) 2021, NVIDIA CORPORATION. All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ */
+
+#define pr_fmt(fmt)	"nvmap: %s() " fmt, __func__
+
+#include <linux/debugfs.h>
+#include <linux/dma-fence.h>
+#include <linux/file.h>
+#include <linux/ktime.h>
+#include <linux/sort.h>
+#include <linux/sync_file.h>
+#include <linux/workqueue.h>
+#include <soc/tegra/chip-id.h>
+
+#include <trace/events/nvmap.h>
+
+#include "nvmap_priv.h"
+
+/*
+ * Cost estimates used to pick between maintenance by range and a full
+ * set/way operation. Both are exponentially weighted moving averages of
+ * the maintenance this engine actually performed.
+ */
+struct nvmap_cache_cost {
+	u64 range_ns_per_mb;	/* by-range cost, in ns per MB */
+	u64 full_ns;		/* cost of one full inner clean/flush */
+};
+
+struct nvmap_cache_range {
+	struct nvmap_handle *h;
+	u64 offset;
+	u64 size;
+};
+
+struct nvmap_cache_async_job {
+	struct dma_fence fence;		/* must be first, see dma_fence_free */
+	spinlock_t lock;
+	struct work_struct work;
+	struct dma_fence *in_fence;
+	struct dma_fence_cb in_cb;
+	int op;
+	u32 nr;
+	size_t ranges_size;
+	struct nvmap_cache_range *ranges;
+};
+
+static struct workqueue_struct *nvmap_cache_wq;
+static u64 nvmap_cache_fence_context;
+static atomic_t nvmap_cache_fence_seqno = ATOMIC_INIT(0);
+
+static DEFINE_SPINLOCK(nvmap_cache_cost_lock);
+static struct nvmap_cache_cost nvmap_cache_cost[2];	/* WB, WB_INV */
+
+static atomic64_t nvmap_cache_async_jobs;
+static atomic64_t nvmap_cache_async_ranges;
+static atomic64_t nvmap_cache_async_merged;
+static atomic64_t nvmap_cache_async_full;
+
+static const char *nvmap_cache_fence_get_driver_name(struct dma_fence *fence)
+{
+	return "nvmap";
+}
+
+static const char *nvmap_cache_fence_get_timeline_name(struct dma_fence *fence)
+{
+	return "cache-maint";
+}
+
+static bool nvmap_cache_fence_enable_signaling(struct dma_fence *fence)
+{
+	return true;
+}
+
+static void nvmap_cache_fence_release(struct dma_fence *fence)
+{
+	dma_fence_free(fence);
+}
+
+static const struct dma_fence_ops nvmap_cache_fence_ops = {
+	.get_driver_name = nvmap_cache_fence_get_driver_name,
+	.get_timeline_name = nvmap_cache_fence_get_timeline_name,
+	.enable_signaling = nvmap_cache_fence_enable_signaling,
+	.wait = dma_fence_default_wait,
+	.release = nvmap_cache_fence_release,
+};
+
+static inline struct nvmap_cache_cost *nvmap_cache_cost_of(int op)
+{
+	return &nvmap_cache_cost[op == NVMAP_CACHE_OP_WB ? 0 : 1];
+}
+
+static inline u64 nvmap_cache_ewma(u64 avg, u64 sample)
+{
+	return avg ? (avg * 7 + sample) >> 3 : sample;
+}
+
+static void nvmap_cache_cost_update(int op, bool full, u64 bytes, u64 ns)
+{
+	struct nvmap_cache_cost *cost = nvmap_cache_cost_of(op);
+
+	spin_lock(&nvmap_cache_cost_lock);
+	if (full)
+		cost->full_ns = nvmap_cache_ewma(cost->full_ns, ns);
+	else if (bytes >= SZ_64K)
+		cost->range_ns_per_mb = nvmap_cache_ewma(cost->range_ns_per_mb,
+					div64_u64(ns << 20, bytes));
+	spin_unlock(&nvmap_cache_cost_lock);
+}
+
+/*
+ * Full set/way maintenance is picked when it is cheaper than the estimated
+ * by-range cost. Until both costs have been observed, fall back to the
+ * inner cache maintenance threshold.
+ */
+static bool nvmap_cache_use_full(int op, u64 total)
+{
+	struct nvmap_cache_cost *cost = nvmap_cache_cost_of(op);
+	u64 range_ns, full_ns;
+
+	if (!nvmap_cache_maint_by_set_ways)
+		return false;
+
+	spin_lock(&nvmap_cache_cost_lock);
+	range_ns = (total * cost->range_ns_per_mb) >> 20;
+	full_ns = cost->full_ns;
+	spin_unlock(&nvmap_cache_cost_lock);
+
+	if (!range_ns || !full_ns)
+		return total >= nvmap_cache_inner_threshold(op);
+
+	return range_ns > full_ns;
+}
+
+static int nvmap_cache_range_cmp(const void *a, const void *b)
+{
+	const struct nvmap_cache_range *ra = a, *rb = b;
+
+	if (ra->h != rb->h)
+		return (uintptr_t)ra->h < (uintptr_t)rb->h ? -1 : 1;
+	if (ra->offset != rb->offset)
+		return ra->offset < rb->offset ? -1 : 1;
+	return 0;
+}
+
+/*
+ * Sort the ranges by handle and offset and merge the ones that overlap or
+ * touch. The references held by merged-away ranges are dropped.
+ */
+static u32 nvmap_cache_coalesce(struct nvmap_cache_range *ranges, u32 nr)
+{
+	u32 i, out = 0;
+
+	if (!nr)
+		return 0;
+
+	sort(ranges, nr, sizeof(*ranges), nvmap_cache_range_cmp, NULL);
+
+	for (i = 1; i < nr; i++) {
+		struct nvmap_cache_range *cur = &ranges[out];
+		struct nvmap_cache_range *next = &ranges[i];
+
+		if (next->h == cur->h &&
+		    next->offset <= cur->offset + cur->size) {
+			u64 end = max(cur->offset + cur->size,
+				      next->offset + next->size);
+
+			cur->size = end - cur->offset;
+			nvmap_handle_put(next->h);
+			continue;
+		}
+		ranges[++out] = *next;
+	}
+
+	return out + 1;
+}
+
+static void nvmap_cache_async_do(struct nvmap_cache_async_job *job)
+{
+	u64 total = 0;
+	ktime_t start;
+	bool full;
+	u32 i;
+
+	/*
+	 * As io-coherency is enabled by default from T194 onwards,
+	 * Don't do cache maint from CPU side. The HW, SCF will do.
+	 */
+	if (tegra_get_chip_id() == TEGRA194)
+		return;
+
+	for (i = 0; i < job->nr; i++) {
+		bool inner, outer;
+
+		nvmap_get_cacheability(job->ranges[i].h, &inner, &outer);
+		if (inner || outer)
+			total += job->ranges[i].size;
+	}
+	if (!total)
+		return;
+
+	full = nvmap_cache_use_full(job->op, total);
+	start = ktime_get();
+
+	if (full) {
+		for (i = 0; i < job->nr; i++) {
+			struct nvmap_handle *h = job->ranges[i].h;
+
+			if (h->userflags & NVMAP_HANDLE_CACHE_SYNC) {
+				nvmap_handle_mkclean(h, 0, h->size);
+				nvmap_zap_handle(h, 0, h->size);
+			}
+		}
+
+		if (job->op == NVMAP_CACHE_OP_WB)
+			inner_clean_cache_all();
+		else
+			inner_flush_cache_all();
+		nvmap_stats_inc(NS_CFLUSH_RQ, total);
+		nvmap_stats_inc(NS_CFLUSH_DONE,
+				nvmap_cache_inner_threshold(job->op));
+		atomic64_inc(&nvmap_cache_async_full);
+	} else {
+		for (i = 0; i < job->nr; i++) {
+			struct nvmap_cache_range *r = &job->ranges[i];
+			int err;
+
+			err = __nvmap_do_cache_maint(r->h->owner, r->h,
+						     r->offset,
+						     r->offset + r->size,
+						     job->op, false);
+			if (err) {
+				pr_err("cache maint per handle failed [%d]\n",
+				       err);
+				dma_fence_set_error(&job->fence, err);
+				break;
+			}
+		}
+	}
+
+	nvmap_cache_cost_update(job->op, full, total,
+				ktime_to_ns(ktime_sub(ktime_get(), start)));
+	trace_nvmap_cache_flush(total,
+				nvmap_stats_read(NS_ALLOC),
+				nvmap_stats_read(NS_CFLUSH_RQ),
+				nvmap_stats_read(NS_CFLUSH_DONE));
+}
+
+static void nvmap_cache_async_work(struct work_struct *work)
+{
+	struct nvmap_cache_async_job *job =
+		container_of(work, struct nvmap_cache_async_job, work);
+	u32 i;
+
+	if (job->in_fence && job->in_fence->error < 0)
+		dma_fence_set_error(&job->fence, job->in_fence->error);
+	else
+		nvmap_cache_async_do(job);
+
+	for (i = 0; i < job->nr; i++)
+		nvmap_handle_put(job->ranges[i].h);
+	nvmap_altfree(job->ranges, job->ranges_size);
+	job->ranges = NULL;
+
+	if (job->in_fence)
+		dma_fence_put(job->in_fence);
+	dma_fence_signal(&job->fence);
+	dma_fence_put(&job->fence);
+}
+
+static void nvmap_cache_async_in_fence_cb(struct dma_fence *fence,
+					  struct dma_fence_cb *cb)
+{
+	struct nvmap_cache_async_job *job =
+		container_of(cb, struct nvmap_cache_async_job, in_cb);
+
+	queue_work(nvmap_cache_wq, &job->work);
+}
+
+/*
+ * Queue cache maintenance over the passed handle ranges. handles[] is
+ * consumed: every reference is dropped once the maintenance completes,
+ * regardless of the outcome. The returned file descriptor is a sync_file
+ * which signals when the maintenance is done; it is only started once
+ * in_fence_fd (if not negative) has signalled.
+ */
+int nvmap_cache_async_submit(struct nvmap_handle **handles, u64 *offsets,
+			     u64 *sizes, u32 nr, int op, int in_fence_fd)
+{
+	struct nvmap_cache_async_job *job;
+	struct sync_file *sync_file;
+	u32 i, coalesced;
+	int fd, err;
+
+	if (!nvmap_cache_wq) {
+		err = -ENODEV;
+		goto put_handles;
+	}
+
+	job = kzalloc(sizeof(*job), GFP_KERNEL);
+	if (!job) {
+		err = -ENOMEM;
+		goto put_handles;
+	}
+
+	job->ranges = nvmap_altalloc(nr * sizeof(*job->ranges));
+	if (!job->ranges) {
+		kfree(job);
+		err = -ENOMEM;
+		goto put_handles;
+	}
+
+	/* As with the synchronous path, INV is done as WB_INV */
+	job->op = op == NVMAP_CACHE_OP_INV ? NVMAP_CACHE_OP_WB_INV : op;
+	for (i = 0; i < nr; i++) {
+		job->ranges[i].h = handles[i];
+		job->ranges[i].offset = sizes[i] ? offsets[i] : 0;
+		job->ranges[i].size = sizes[i] ?: handles[i]->size;
+	}
+	job->ranges_size = nr * sizeof(*job->ranges);
+	coalesced = nvmap_cache_coalesce(job->ranges, nr);
+	job->nr = coalesced;
+
+	atomic64_add(nr - coalesced, &nvmap_cache_async_merged);
+	atomic64_add(nr, &nvmap_cache_async_ranges);
+	atomic64_inc(&nvmap_cache_async_jobs);
+
+	spin_lock_init(&job->lock);
+	INIT_WORK(&job->work, nvmap_cache_async_work);
+	dma_fence_init(&job->fence, &nvmap_cache_fence_ops, &job->lock,
+		       nvmap_cache_fence_context,
+		       atomic_inc_return(&nvmap_cache_fence_seqno));
+
+	fd = get_unused_fd_flags(O_CLOEXEC);
+	if (fd < 0) {
+		err = fd;
+		goto free_job;
+	}
+
+	sync_file = sync_file_create(&job->fence);
+	if (!sync_file) {
+		put_unused_fd(fd);
+		err = -ENOMEM;
+		goto free_job;
+	}
+
+	if (in_fence_fd >= 0) {
+		job->in_fence = sync_file_get_fence(in_fence_fd);
+		if (!job->in_fence) {
+			fput(sync_file->file);
+			put_unused_fd(fd);
+			err = -EINVAL;
+			goto free_job;
+		}
+	}
+
+	/* Reference dropped by the worker once the fence is signalled */
+	dma_fence_get(&job->fence);
+	fd_install(fd, sync_file->file);
+
+	if (!job->in_fence ||
+	    dma_fence_add_callback(job->in_fence, &job->in_cb,
+				   nvmap_cache_async_in_fence_cb))
+		queue_work(nvmap_cache_wq, &job->work);
+
+	return fd;
+
+free_job:
+	for (i = 0; i < job->nr; i++)
+		nvmap_handle_put(job->ranges[i].h);
+	nvmap_altfree(job->ranges, job->ranges_size);
+	job->ranges = NULL;
+	job->nr = 0;
+	dma_fence_put(&job->fence);
+	return err;
+
+put_handles:
+	for (i = 0; i < nr; i++)
+		nvmap_handle_put(handles[i]);
+	return err;
+}
+
+static int nvmap_cache_cost_show(struct seq_file *s, void *unused)
+{
+	int i;
+
+	seq_printf(s, "jobs %lld ranges %lld merged %lld full %lld\n",
+		   (s64)atomic64_read(&nvmap_cache_async_jobs),
+		   (s64)atomic64_read(&nvmap_cache_async_ranges),
+		   (s64)atomic64_read(&nvmap_cache_async_merged),
+		   (s64)atomic64_read(&nvmap_cache_async_full));
+
+	spin_lock(&nvmap_cache_cost_lock);
+	for (i = 0; i < ARRAY_SIZE(nvmap_cache_cost); i++)
+		seq_printf(s, "%-6s range %llu ns/MB full %llu ns\n",
+			   i ? "wb_inv" : "wb",
+			   nvmap_cache_cost[i].range_ns_per_mb,
+			   nvmap_cache_cost[i].full_ns);
+	spin_unlock(&nvmap_cache_cost_lock);
+
+	return 0;
+}
+
+static int nvmap_cache_cost_open(struct inode *inode, struct file *file)
+{
+	return single_open(file, nvmap_cache_cost_show, inode->i_private);
+}
+
+static const struct file_operations nvmap_cache_cost_fops = {
+	.open		= nvmap_cache_cost_open,
+	.read		= seq_read,
+	.llseek		= seq_lseek,
+	.release	= single_release,
+};
+
+void nvmap_cache_async_debugfs_init(struct dentry *cache_root)
+{
+	debugfs_create_file("async_maint", S_IRUGO, cache_root, NULL,
+			    &nvmap_cache_cost_fops);
+}
+
+int nvmap_cache_async_init(void)
+{
+	nvmap_cache_fence_context = dma_fence_context_alloc(1);
+	nvmap_cache_wq = alloc_workqueue("nvmap-cache",
+					 WQ_UNBOUND | WQ_HIGHPRI, 0);
+	if (!nvmap_cache_wq)
+		return -ENOMEM;
+
+	return 0;
+}
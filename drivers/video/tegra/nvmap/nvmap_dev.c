@@ -207,6 +207,9 @@ struct nvmap_client *__nvmap_create_client(struct nvmap_device *dev,
 
 	mutex_init(&client->ref_lock);
 	atomic_set(&client->count, 1);
+	spin_lock_init(&client->recycle_lock);
+	INIT_LIST_HEAD(&client->recycle_pages);
+	atomic_set(&client->recycle_refs, 1);
 
 	mutex_lock(&dev->clients_lock);
 	list_add(&client->list, &dev->clients);
@@ -253,10 +256,13 @@ static void destroy_client(struct nvmap_client *client)
 		kfree(ref);
 	}
 
+	nvmap_client_recycle_release(client);
+
 	if (client->task)
 		put_task_struct(client->task);
 
-	kfree(client);
+	/* handles still holding recycled pages keep the client around */
+	nvmap_client_recycle_put(client);
 }
 
 static int nvmap_open(struct inode *inode, struct file *filp)
@@ -415,6 +421,14 @@ static long nvmap_ioctl(struct file *filp, unsigned int cmd, unsigned long arg)
 						   cmd == NVMAP_IOC_RESERVE);
 		break;
 
+	case NVMAP_IOC_CACHE_LIST_ASYNC:
+		err = nvmap_ioctl_cache_maint_list_async(filp, uarg);
+		break;
+
+	case NVMAP_IOC_ALLOC_BULK:
+		err = nvmap_ioctl_alloc_bulk(filp, uarg);
+		break;
+
 	case NVMAP_IOC_GUP_TEST:
 		err = nvmap_ioctl_gup_test(filp, uarg);
 		break;
@@ -1285,6 +1299,7 @@ int __init nvmap_probe(struct platform_device *pdev)
 	nvmap_page_pool_debugfs_init(nvmap_dev->debug_root);
 #endif
 	nvmap_cache_debugfs_init(nvmap_dev->debug_root);
+	nvmap_cache_calibrate_at_boot();
 	nvmap_dev->handles_by_pid = debugfs_create_dir("handles_by_pid",
 							nvmap_debug_root);
 #if defined(CONFIG_DEBUG_FS)
@@ -1292,12 +1307,18 @@ int __init nvmap_probe(struct platform_device *pdev)
 				nvmap_dev->debug_root, &nvmap_init_time);
 #endif
 	nvmap_stats_init(nvmap_debug_root);
+	nvmap_dmabuf_debugfs_init(nvmap_debug_root);
 	platform_set_drvdata(pdev, dev);
 
 	e = nvmap_dmabuf_stash_init();
 	if (e)
 		goto fail_heaps;
 
+	if (nvmap_cache_async_init())
+		dev_warn(&pdev->dev, "async cache maintenance unavailable\n");
+
+	nvmap_perf_init(dev);
+
 	for (i = 0; i < dev->nr_carveouts; i++)
 		if (dev->heaps[i].heap_bit & NVMAP_HEAP_CARVEOUT_GENERIC)
 			generic_carveout_present = 1;
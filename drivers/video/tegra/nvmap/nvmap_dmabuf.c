@@ -31,12 +31,39 @@
 #include <linux/platform/tegra/tegra_fd.h>
 #include <linux/version.h>
 #include <linux/iommu.h>
+#include <linux/moduleparam.h>
+#include <linux/sizes.h>
 
 #include <trace/events/nvmap.h>
 
 #include "nvmap_priv.h"
 #include "nvmap_ioctl.h"
 
+/**
+ * Per device cache of IOVA mappings that no longer have users. Maps are
+ * kept mapped until the device's stash budget is exceeded, so that a buffer
+ * submitted again to the same device skips the SMMU map entirely.
+ *
+ * @dev Device the stashed maps were created for.
+ * @lru Stashed maps, least recently used first.
+ * @size Bytes of handle memory currently stashed.
+ * @max_size Stash budget; 0 disables stashing for the device.
+ * @hits Maps satisfied by an existing mapping.
+ * @misses Maps that needed a new mapping.
+ * @evictions Stashed maps unmapped to stay within the budget.
+ * @node Entry on nvmap_iova_caches.
+ */
+struct nvmap_iova_cache {
+	struct device *dev;
+	struct list_head lru;
+	size_t size;
+	size_t max_size;
+	u64 hits;
+	u64 misses;
+	u64 evictions;
+	struct list_head node;
+};
+
 /**
  * List node for maps of nvmap handles via the dma_buf API. These store the
  * necessary info for stashing mappings.
@@ -47,6 +74,7 @@
  * @refs Reference counting.
  * @maps_entry Entry on a given attachment's list of maps.
  * @stash_entry Entry on the stash list.
+ * @cache The per device stash this map is on, if any.
  * @owner The owner of this struct. There can be only one.
  */
 struct nvmap_handle_sgt {
@@ -59,12 +87,18 @@ struct nvmap_handle_sgt {
 
 	struct list_head maps_entry;
 	struct list_head stash_entry; /* lock the stash before accessing. */
+	struct nvmap_iova_cache *cache;
 
 	struct nvmap_handle_info *owner;
 } ____cacheline_aligned_in_smp;
 
+/* Protects all nvmap_iova_cache's and the stash_entry of every map. */
 static DEFINE_MUTEX(nvmap_stashed_maps_lock);
-static LIST_HEAD(nvmap_stashed_maps);
+static LIST_HEAD(nvmap_iova_caches);
+
+/* Stash budget given to a device the first time it maps a handle. */
+static ulong iova_cache_default_size = SZ_256M;
+module_param(iova_cache_default_size, ulong, 0644);
 static struct kmem_cache *handle_sgt_cache;
 static struct dma_buf_ops nvmap_dma_buf_ops;
 
@@ -89,6 +123,125 @@ int nvmap_dmabuf_stash_init(void)
 	return 0;
 }
 
+/*
+ * Run @relocate on a handle with its dma-buf maps locked, so that no device
+ * can map the handle until it returns. The handle must not be pinned; the
+ * maps left over from earlier users are all stashed and carry the old
+ * address, so they are dropped first.
+ */
+int nvmap_dmabuf_relocate(struct nvmap_handle *h,
+			  int (*relocate)(struct nvmap_handle *h, void *data),
+			  void *data)
+{
+	struct nvmap_handle_sgt *nvmap_sgt, *tmp;
+	struct nvmap_handle_info *info;
+	struct dma_buf *dmabuf;
+	int ret;
+
+	mutex_lock(&h->lock);
+	dmabuf = h->dmabuf;
+	/* This is same as get_dma_buf() if file->f_count was non-zero */
+	if (!dmabuf || !atomic_long_inc_not_zero(&dmabuf->file->f_count)) {
+		mutex_unlock(&h->lock);
+		return -ENOENT;
+	}
+	mutex_unlock(&h->lock);
+
+	info = dmabuf->priv;
+	mutex_lock(&info->maps_lock);
+	if (atomic_read(&h->pin)) {
+		ret = -EBUSY;
+		goto unlock;
+	}
+
+	list_for_each_entry_safe(nvmap_sgt, tmp, &info->maps, maps_entry) {
+		__nvmap_dmabuf_evict_stash(nvmap_sgt);
+		__nvmap_dmabuf_free_sgt_locked(nvmap_sgt);
+	}
+
+	ret = relocate(h, data);
+unlock:
+	mutex_unlock(&info->maps_lock);
+	dma_buf_put(dmabuf);
+	return ret;
+}
+
+static int nvmap_iova_cache_show(struct seq_file *s, void *unused)
+{
+	struct nvmap_iova_cache *cache;
+
+	seq_printf(s, "%-24s %10s %10s %10s %10s %10s\n", "device",
+		   "size(K)", "max(K)", "hits", "misses", "evictions");
+	mutex_lock(&nvmap_stashed_maps_lock);
+	list_for_each_entry(cache, &nvmap_iova_caches, node)
+		seq_printf(s, "%-24s %10zu %10zu %10llu %10llu %10llu\n",
+			   dev_name(cache->dev), cache->size >> 10,
+			   cache->max_size >> 10, cache->hits, cache->misses,
+			   cache->evictions);
+	mutex_unlock(&nvmap_stashed_maps_lock);
+
+	return 0;
+}
+
+static int nvmap_iova_cache_open(struct inode *inode, struct file *file)
+{
+	return single_open(file, nvmap_iova_cache_show, inode->i_private);
+}
+
+/*
+ * "<device> <bytes>" sets the stash budget of a device that has already
+ * mapped nvmap memory. Shrinking the budget evicts what no longer fits.
+ */
+static ssize_t nvmap_iova_cache_write(struct file *file,
+				      const char __user *buffer,
+				      size_t count, loff_t *pos)
+{
+	struct nvmap_iova_cache *cache;
+	char buf[64], name[48];
+	size_t max_size;
+	int ret = -ENODEV;
+
+	if (count >= sizeof(buf))
+		return -EINVAL;
+	if (copy_from_user(buf, buffer, count))
+		return -EFAULT;
+	buf[count] = '\0';
+
+	if (sscanf(buf, "%47s %zu", name, &max_size) != 2)
+		return -EINVAL;
+
+	mutex_lock(&nvmap_stashed_maps_lock);
+	list_for_each_entry(cache, &nvmap_iova_caches, node) {
+		if (strcmp(dev_name(cache->dev), name))
+			continue;
+
+		cache->max_size = max_size;
+		__nvmap_iova_cache_shrink_locked(cache, NULL);
+		ret = count;
+		break;
+	}
+	mutex_unlock(&nvmap_stashed_maps_lock);
+
+	return ret;
+}
+
+static const struct file_operations nvmap_iova_cache_fops = {
+	.open		= nvmap_iova_cache_open,
+	.read		= seq_read,
+	.llseek		= seq_lseek,
+	.release	= single_release,
+	.write		= nvmap_iova_cache_write,
+};
+
+void nvmap_dmabuf_debugfs_init(struct dentry *nvmap_root)
+{
+	if (IS_ERR_OR_NULL(nvmap_root))
+		return;
+
+	debugfs_create_file("iova_cache", S_IRUGO | S_IWUSR, nvmap_root,
+			    NULL, &nvmap_iova_cache_fops);
+}
+
 static int nvmap_dmabuf_attach(struct dma_buf *dmabuf, struct device *dev,
 			       struct dma_buf_attachment *attach)
 {
@@ -111,20 +264,26 @@ static void nvmap_dmabuf_detach(struct dma_buf *dmabuf,
 }
 
 /*
- * Make sure this mapping is no longer stashed - this corresponds to a "hit". If
- * the mapping is not stashed this is just a no-op.
+ * Find the IOVA cache of a device, creating it on first use. Requires the
+ * stash lock.
  */
-static void __nvmap_dmabuf_del_stash(struct nvmap_handle_sgt *nvmap_sgt)
+static struct nvmap_iova_cache *nvmap_iova_cache_get_locked(struct device *dev)
 {
-	mutex_lock(&nvmap_stashed_maps_lock);
-	if (list_empty(&nvmap_sgt->stash_entry)) {
-		mutex_unlock(&nvmap_stashed_maps_lock);
-		return;
-	}
+	struct nvmap_iova_cache *cache;
 
-	pr_debug("Removing map from stash.\n");
-	list_del_init(&nvmap_sgt->stash_entry);
-	mutex_unlock(&nvmap_stashed_maps_lock);
+	list_for_each_entry(cache, &nvmap_iova_caches, node)
+		if (cache->dev == dev)
+			return cache;
+
+	cache = kzalloc(sizeof(*cache), GFP_KERNEL);
+	if (!cache)
+		return NULL;
+
+	cache->dev = dev;
+	cache->max_size = iova_cache_default_size;
+	INIT_LIST_HEAD(&cache->lru);
+	list_add_tail(&cache->node, &nvmap_iova_caches);
+	return cache;
 }
 
 static inline bool access_vpr_phys(struct device *dev)
@@ -179,8 +338,11 @@ static void __nvmap_dmabuf_free_sgt_locked(struct nvmap_handle_sgt *nvmap_sgt)
 static void __nvmap_dmabuf_evict_stash_locked(
 			struct nvmap_handle_sgt *nvmap_sgt)
 {
-	if (!list_empty(&nvmap_sgt->stash_entry))
-		list_del_init(&nvmap_sgt->stash_entry);
+	if (list_empty(&nvmap_sgt->stash_entry))
+		return;
+
+	list_del_init(&nvmap_sgt->stash_entry);
+	nvmap_sgt->cache->size -= nvmap_sgt->owner->handle->size;
 }
 
 /*
@@ -215,12 +377,44 @@ static int __nvmap_dmabuf_prep_sgt_locked(struct dma_buf_attachment *attach,
 	nvmap_sgt->sgt = sgt;
 	nvmap_sgt->dev = attach->dev;
 	nvmap_sgt->owner = info;
+	nvmap_sgt->cache = NULL;
 	INIT_LIST_HEAD(&nvmap_sgt->stash_entry);
 	atomic_set(&nvmap_sgt->refs, 1);
 	list_add(&nvmap_sgt->maps_entry, &info->maps);
 	return 0;
 }
 
+/*
+ * Unmap the least recently used stashed maps of @cache until it fits its
+ * budget again. @info is the handle whose maps_lock the caller holds; maps
+ * of other handles are only evicted if their lock can be taken without
+ * waiting, since the usual lock order is maps_lock before the stash lock.
+ * Requires the stash lock.
+ */
+static void __nvmap_iova_cache_shrink_locked(struct nvmap_iova_cache *cache,
+					     struct nvmap_handle_info *info)
+{
+	struct nvmap_handle_sgt *nvmap_sgt, *tmp;
+	struct nvmap_handle_info *owner;
+
+	list_for_each_entry_safe(nvmap_sgt, tmp, &cache->lru, stash_entry) {
+		if (cache->size <= cache->max_size)
+			break;
+
+		owner = nvmap_sgt->owner;
+		if (owner != info && !mutex_trylock(&owner->maps_lock))
+			continue;
+
+		__nvmap_dmabuf_evict_stash_locked(nvmap_sgt);
+		__nvmap_dmabuf_free_sgt_locked(nvmap_sgt);
+		cache->evictions++;
+		nvmap_stats_inc(NS_IOVA_EVICT, 1);
+
+		if (owner != info)
+			mutex_unlock(&owner->maps_lock);
+	}
+}
+
 /*
  * Called when an SGT is no longer being used by a device. This will not
  * necessarily free the SGT - instead it may stash the SGT.
@@ -231,6 +425,7 @@ static void __nvmap_dmabuf_stash_sgt_locked(struct dma_buf_attachment *attach,
 {
 	struct nvmap_handle_sgt *nvmap_sgt;
 	struct nvmap_handle_info *info = attach->dmabuf->priv;
+	struct nvmap_iova_cache *cache;
 
 	pr_debug("Stashing SGT - if necessary.\n");
 	list_for_each_entry(nvmap_sgt, &info->maps, maps_entry) {
@@ -238,7 +433,19 @@ static void __nvmap_dmabuf_stash_sgt_locked(struct dma_buf_attachment *attach,
 			if (!atomic_sub_and_test(1, &nvmap_sgt->refs))
 				goto done;
 
-			__nvmap_dmabuf_free_sgt_locked(nvmap_sgt);
+			mutex_lock(&nvmap_stashed_maps_lock);
+			cache = nvmap_iova_cache_get_locked(nvmap_sgt->dev);
+			if (!cache || info->handle->size > cache->max_size) {
+				mutex_unlock(&nvmap_stashed_maps_lock);
+				__nvmap_dmabuf_free_sgt_locked(nvmap_sgt);
+				goto done;
+			}
+
+			nvmap_sgt->cache = cache;
+			list_add_tail(&nvmap_sgt->stash_entry, &cache->lru);
+			cache->size += info->handle->size;
+			__nvmap_iova_cache_shrink_locked(cache, info);
+			mutex_unlock(&nvmap_stashed_maps_lock);
 			goto done;
 		}
 	}
@@ -262,7 +469,10 @@ static struct sg_table *__nvmap_dmabuf_get_sgt_locked(
 	struct sg_table *sgt = NULL;
 	struct nvmap_handle_info *info = attach->dmabuf->priv;
 
+	struct nvmap_iova_cache *cache;
+
 	pr_debug("Getting SGT from stash.\n");
+	mutex_lock(&nvmap_stashed_maps_lock);
 	list_for_each_entry(nvmap_sgt, &info->maps, maps_entry) {
 		if (!nvmap_attach_handle_same_asid(attach, nvmap_sgt))
 			continue;
@@ -271,10 +481,20 @@ static struct sg_table *__nvmap_dmabuf_get_sgt_locked(
 		pr_debug("Stash hit (%s)!\n", dev_name(attach->dev));
 		sgt = nvmap_sgt->sgt;
 		atomic_inc(&nvmap_sgt->refs);
-		__nvmap_dmabuf_del_stash(nvmap_sgt);
+		__nvmap_dmabuf_evict_stash_locked(nvmap_sgt);
 		break;
 	}
 
+	cache = nvmap_iova_cache_get_locked(attach->dev);
+	if (cache) {
+		if (sgt)
+			cache->hits++;
+		else
+			cache->misses++;
+	}
+	mutex_unlock(&nvmap_stashed_maps_lock);
+
+	nvmap_stats_inc(sgt ? NS_IOVA_HIT : NS_IOVA_MISS, 1);
 	return sgt;
 }
 
@@ -491,11 +711,15 @@ int __nvmap_map(struct nvmap_handle *h, struct vm_area_struct *vma)
 	vma->vm_flags |= VM_SHARED | VM_DONTEXPAND |
 			  VM_DONTDUMP | VM_DONTCOPY |
 			  (h->heap_pgalloc ? 0 : VM_PFNMAP);
+	/* chunks are inserted with vm_insert_page() from the fault path */
+	if (nvmap_vma_wants_chunks(h))
+		vma->vm_flags |= VM_MIXEDMAP;
 	vma->vm_ops = &nvmap_vma_ops;
 	BUG_ON(vma->vm_private_data != NULL);
 	vma->vm_private_data = priv;
 	vma->vm_page_prot = nvmap_pgprot(h, vma->vm_page_prot);
 	nvmap_vma_open(vma);
+	nvmap_vma_prefault_chunks(vma);
 	return 0;
 }
 
@@ -17,6 +17,7 @@
 
 #include <trace/events/nvmap.h>
 #include <linux/highmem.h>
+#include <linux/moduleparam.h>
 
 #include "nvmap_priv.h"
 
@@ -41,6 +42,101 @@ int is_nvmap_vma(struct vm_area_struct *vma)
 	return vma->vm_ops == &nvmap_vma_ops;
 }
 
+/*
+ * Handles backed by physically contiguous 2M chunks get a whole chunk
+ * mapped on the first fault inside it instead of one page per fault.
+ * vmf_insert_pfn_pmd() only takes devmap pfns here, so the chunk is
+ * mapped with PTEs; it still turns 512 faults into one.
+ */
+static bool fault_map_chunks = true;
+module_param(fault_map_chunks, bool, 0644);
+
+/* map every contiguous chunk of the handle already at mmap time */
+static bool prefault_chunks_on_mmap;
+module_param(prefault_chunks_on_mmap, bool, 0644);
+
+#define NVMAP_CHUNK_PAGES	(NVMAP_PP_HUGE_PAGE_SIZE >> PAGE_SHIFT)
+
+bool nvmap_vma_wants_chunks(struct nvmap_handle *h)
+{
+	return fault_map_chunks && h->heap_pgalloc &&
+		h->size >= NVMAP_PP_HUGE_PAGE_SIZE &&
+		!nvmap_handle_track_dirty(h);
+}
+
+static bool nvmap_chunk_contig(struct nvmap_handle *h, unsigned int first)
+{
+	unsigned long pfn = page_to_pfn(nvmap_to_page(h->pgalloc.pages[first]));
+	unsigned int i;
+
+	if (!IS_ALIGNED(pfn, NVMAP_CHUNK_PAGES))
+		return false;
+
+	for (i = 1; i < NVMAP_CHUNK_PAGES; i++)
+		if (page_to_pfn(nvmap_to_page(h->pgalloc.pages[first + i])) !=
+		    pfn + i)
+			return false;
+
+	return true;
+}
+
+/*
+ * Map the chunk containing handle page @pagenum into @vma. Returns the
+ * number of pages mapped, 0 if the chunk is not contiguous.
+ */
+static int nvmap_vma_map_chunk(struct vm_area_struct *vma,
+			       unsigned int pagenum)
+{
+	struct nvmap_vma_priv *priv = vma->vm_private_data;
+	struct nvmap_handle *h = priv->handle;
+	unsigned int first = round_down(pagenum, NVMAP_CHUNK_PAGES);
+	unsigned long base, addr;
+	unsigned int i;
+	int mapped = 0;
+
+	if (first + NVMAP_CHUNK_PAGES > (h->size >> PAGE_SHIFT) ||
+	    !nvmap_chunk_contig(h, first))
+		return 0;
+
+	/* user address of handle page 0 in this vma */
+	base = vma->vm_start - priv->offs - (vma->vm_pgoff << PAGE_SHIFT);
+
+	for (i = first; i < first + NVMAP_CHUNK_PAGES; i++) {
+		addr = base + ((unsigned long)i << PAGE_SHIFT);
+		if (addr < vma->vm_start || addr >= vma->vm_end)
+			continue;
+
+		nvmap_handle_zero_page(h, i);
+		/* -EBUSY: already mapped by an earlier fault */
+		if (vm_insert_page(vma, addr,
+				   nvmap_to_page(h->pgalloc.pages[i])) &&
+		    i == pagenum)
+			return 0;
+		mapped++;
+	}
+
+	return mapped;
+}
+
+void nvmap_vma_prefault_chunks(struct vm_area_struct *vma)
+{
+	struct nvmap_vma_priv *priv = vma->vm_private_data;
+	struct nvmap_handle *h = priv->handle;
+	unsigned long offs, end;
+
+	if (!prefault_chunks_on_mmap || !(vma->vm_flags & VM_MIXEDMAP) ||
+	    atomic_read(&h->pgalloc.reserved))
+		return;
+
+	offs = priv->offs + (vma->vm_pgoff << PAGE_SHIFT);
+	end = min_t(unsigned long, h->size,
+		    offs + vma->vm_end - vma->vm_start);
+
+	for (offs = round_down(offs, NVMAP_PP_HUGE_PAGE_SIZE); offs < end;
+	     offs += NVMAP_PP_HUGE_PAGE_SIZE)
+		nvmap_vma_map_chunk(vma, offs >> PAGE_SHIFT);
+}
+
 /* to ensure that the backing store for the VMA isn't freed while a fork'd
  * reference still exists, nvmap_vma_open increments the reference count on
  * the handle, and nvmap_vma_close decrements it. alternatively, we could
@@ -205,13 +301,18 @@ static int nvmap_vma_fault(struct vm_area_struct *vma, struct vm_fault *vmf)
 
 	if (!priv->handle->heap_pgalloc) {
 		unsigned long pfn;
+
+		/* the block may be relocated by carveout compaction */
+		mutex_lock(&priv->handle->lock);
 		BUG_ON(priv->handle->carveout->base & ~PAGE_MASK);
 		pfn = ((priv->handle->carveout->base + offs) >> PAGE_SHIFT);
 		if (!pfn_valid(pfn)) {
 			vm_insert_pfn(vma,
 				(unsigned long)vmf_address, pfn);
+			mutex_unlock(&priv->handle->lock);
 			return VM_FAULT_NOPAGE;
 		}
+		mutex_unlock(&priv->handle->lock);
 		/* CMA memory would get here */
 		page = pfn_to_page(pfn);
 	} else {
@@ -220,6 +321,11 @@ static int nvmap_vma_fault(struct vm_area_struct *vma, struct vm_fault *vmf)
 		offs >>= PAGE_SHIFT;
 		if (atomic_read(&priv->handle->pgalloc.reserved))
 			return VM_FAULT_SIGBUS;
+
+		if ((vma->vm_flags & VM_MIXEDMAP) &&
+		    nvmap_vma_map_chunk(vma, offs))
+			return VM_FAULT_NOPAGE;
+		nvmap_handle_zero_page(priv->handle, offs);
 		page = nvmap_to_page(priv->handle->pgalloc.pages[offs]);
 
 		if (!nvmap_handle_track_dirty(priv->handle))
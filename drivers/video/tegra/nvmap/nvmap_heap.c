@@ -30,6 +30,12 @@
 #include <linux/sizes.h>
 #include <linux/io.h>
 #include <linux/version.h>
+#include <linux/seq_file.h>
+#include <linux/sort.h>
+#include <linux/log2.h>
+#include <linux/vmalloc.h>
+#include <linux/workqueue.h>
+#include <linux/moduleparam.h>
 
 #if LINUX_VERSION_CODE >= KERNEL_VERSION(4, 14, 0)
 #include <linux/sched/clock.h>
@@ -39,6 +45,8 @@
 #include <linux/dma-mapping.h>
 #include <linux/dma-contiguous.h>
 
+#include <trace/events/nvmap.h>
+
 #include "nvmap_priv.h"
 #include "nvmap_heap.h"
 
@@ -80,8 +88,15 @@ struct nvmap_heap {
 	int peer; /* Used only if is_ivm == true */
 	int vm_id; /* Used only if is_ivm == true */
 	struct nvmap_pm_ops pm_ops;
+	struct work_struct compact_work;
+	struct mutex compact_lock;
+	size_t compacted; /* bytes moved by the last compaction */
 };
 
+/* compact a heap in the background when an allocation from it fails */
+static bool compact_on_alloc_failure;
+module_param(compact_on_alloc_failure, bool, 0644);
+
 struct device *dma_dev_from_handle(unsigned long type)
 {
 	int i;
@@ -114,8 +129,153 @@ size_t nvmap_query_heap_size(struct nvmap_heap *heap)
 	return heap->len;
 }
 
+/* free extents are bucketed by power of two size: 4K .. > 128M */
+#define NVMAP_HEAP_FRAG_BUCKETS		17
+
+struct nvmap_heap_frag {
+	size_t free;
+	size_t largest;
+	u32 holes;
+	u32 hist[NVMAP_HEAP_FRAG_BUCKETS];
+};
+
+struct nvmap_heap_extent {
+	phys_addr_t base;
+	size_t size;
+};
+
+static int nvmap_heap_extent_cmp(const void *a, const void *b)
+{
+	const struct nvmap_heap_extent *x = a, *y = b;
+
+	if (x->base == y->base)
+		return 0;
+	return x->base < y->base ? -1 : 1;
+}
+
+static void nvmap_heap_frag_add_hole(struct nvmap_heap_frag *f, size_t len)
+{
+	unsigned int b;
+
+	if (!len)
+		return;
+
+	b = len > PAGE_SIZE ? order_base_2(len >> PAGE_SHIFT) : 0;
+	f->hist[min_t(unsigned int, b, NVMAP_HEAP_FRAG_BUCKETS - 1)]++;
+	f->free += len;
+	f->largest = max(f->largest, len);
+	f->holes++;
+}
+
+/*
+ * Carveout memory is handed out by the DMA coherent allocator, so there is
+ * no free list to walk. The free extents are the gaps between the blocks
+ * nvmap has allocated from the heap. Requires the heap lock.
+ */
+static int nvmap_heap_frag_calc_locked(struct nvmap_heap *h,
+				       struct nvmap_heap_frag *f)
+{
+	struct nvmap_heap_extent *ext;
+	struct list_block *lb;
+	phys_addr_t cur = h->base;
+	unsigned int i, nr = 0;
+
+	memset(f, 0, sizeof(*f));
+
+	list_for_each_entry(lb, &h->all_list, all_list)
+		nr++;
+
+	ext = nvmap_altalloc(nr * sizeof(*ext));
+	if (nr && !ext)
+		return -ENOMEM;
+
+	i = 0;
+	list_for_each_entry(lb, &h->all_list, all_list) {
+		ext[i].base = lb->block.base;
+		ext[i++].size = lb->size;
+	}
+	sort(ext, nr, sizeof(*ext), nvmap_heap_extent_cmp, NULL);
+
+	for (i = 0; i < nr; i++) {
+		if (ext[i].base > cur)
+			nvmap_heap_frag_add_hole(f, ext[i].base - cur);
+		cur = max_t(phys_addr_t, cur, ext[i].base + ext[i].size);
+	}
+	if (h->base + h->len > cur)
+		nvmap_heap_frag_add_hole(f, h->base + h->len - cur);
+
+	nvmap_altfree(ext, nr * sizeof(*ext));
+	return 0;
+}
+
+static int nvmap_heap_frag_show(struct seq_file *s, void *unused)
+{
+	struct nvmap_heap *h = s->private;
+	struct nvmap_heap_frag f;
+	unsigned int frag;
+	int i, ret;
+
+	mutex_lock(&h->lock);
+	ret = nvmap_heap_frag_calc_locked(h, &f);
+	mutex_unlock(&h->lock);
+	if (ret)
+		return ret;
+
+	/* 0 when all free memory is one extent, close to 100 when shattered */
+	frag = f.free ? 100 - div64_u64((u64)f.largest * 100, f.free) : 0;
+
+	seq_printf(s, "free: %zuK largest: %zuK holes: %u\n",
+		   f.free >> 10, f.largest >> 10, f.holes);
+	seq_printf(s, "fragmentation: %u%%\n", frag);
+	for (i = 0; i < NVMAP_HEAP_FRAG_BUCKETS; i++) {
+		if (i == NVMAP_HEAP_FRAG_BUCKETS - 1)
+			seq_printf(s, "> %6luK: %u\n",
+				   (PAGE_SIZE << (i - 1)) >> 10, f.hist[i]);
+		else
+			seq_printf(s, "<=%6luK: %u\n",
+				   (PAGE_SIZE << i) >> 10, f.hist[i]);
+	}
+
+	return 0;
+}
+
+static int nvmap_heap_frag_open(struct inode *inode, struct file *file)
+{
+	return single_open(file, nvmap_heap_frag_show, inode->i_private);
+}
+
+static const struct file_operations nvmap_heap_frag_fops = {
+	.open		= nvmap_heap_frag_open,
+	.read		= seq_read,
+	.llseek		= seq_lseek,
+	.release	= single_release,
+};
+
+static int nvmap_heap_compact_get(void *data, u64 *val)
+{
+	struct nvmap_heap *h = data;
+
+	*val = h->compacted;
+	return 0;
+}
+
+static int nvmap_heap_compact_set(void *data, u64 val)
+{
+	if (!val)
+		return 0;
+
+	return nvmap_heap_compact(data);
+}
+DEFINE_SIMPLE_ATTRIBUTE(nvmap_heap_compact_fops, nvmap_heap_compact_get,
+			nvmap_heap_compact_set, "%llu\n");
+
 void nvmap_heap_debugfs_init(struct dentry *heap_root, struct nvmap_heap *heap)
 {
+	debugfs_create_file("fragmentation", S_IRUGO, heap_root, heap,
+			    &nvmap_heap_frag_fops);
+	debugfs_create_file("compact", S_IRUGO | S_IWUSR, heap_root, heap,
+			    &nvmap_heap_compact_fops);
+
 	if (sizeof(heap->base) == sizeof(u64))
 		debugfs_create_x64("base", S_IRUGO,
 			heap_root, (u64 *)&heap->base);
@@ -346,6 +506,19 @@ struct nvmap_heap_block *nvmap_heap_alloc(struct nvmap_heap *h,
 					  NVMAP_IVM_OFFSET_SHIFT);
 			handle->ivm_id |= (len >> PAGE_SHIFT);
 		}
+	} else {
+		if (trace_nvmap_carveout_frag_enabled()) {
+			struct nvmap_heap_frag f;
+
+			if (!nvmap_heap_frag_calc_locked(h, &f))
+				trace_nvmap_carveout_frag(h->name, f.free,
+							  f.largest, f.holes);
+		}
+		if (compact_on_alloc_failure)
+			schedule_work(&h->compact_work);
+		/* nothing to keep the RAM powered for */
+		if (h->pm_ops.idle && h->pm_ops.idle() < 0)
+			WARN_ON(1);
 	}
 	mutex_unlock(&h->lock);
 	return b;
@@ -385,6 +558,174 @@ void nvmap_heap_free(struct nvmap_heap_block *b)
 	mutex_unlock(&h->lock);
 }
 
+/*
+ * Carveout compaction.
+ *
+ * Blocks of handles allocated with NVMAP_HANDLE_MOVABLE are moved to a
+ * lower address when the DMA allocator can give one, closing the holes
+ * that long uptimes leave behind. The copy is done by the CPU through
+ * temporary kernel mappings. A block is only moved while its handle is
+ * not pinned for a device, not mapped by the CPU, and with its dma-buf
+ * maps locked so that no device can map it until the move is done. Heaps
+ * without CPU access, VPR and IVM heaps are never compacted.
+ */
+static int nvmap_heap_copy_block(struct nvmap_handle *handle,
+				 phys_addr_t dst, phys_addr_t src, size_t len)
+{
+	pgprot_t prot = nvmap_pgprot(handle, PG_PROT_KERNEL);
+	struct vm_struct *area;
+	unsigned long vsrc, vdst;
+	size_t off;
+
+	area = alloc_vm_area(2 * PAGE_SIZE, NULL);
+	if (!area)
+		return -ENOMEM;
+
+	vsrc = (unsigned long)area->addr;
+	vdst = vsrc + PAGE_SIZE;
+	for (off = 0; off < len; off += PAGE_SIZE) {
+		ioremap_page_range(vsrc, vsrc + PAGE_SIZE, src + off, prot);
+		ioremap_page_range(vdst, vdst + PAGE_SIZE, dst + off, prot);
+		memcpy((void *)vdst, (void *)vsrc, PAGE_SIZE);
+		unmap_kernel_range(vsrc, 2 * PAGE_SIZE);
+		cond_resched();
+	}
+	free_vm_area(area);
+
+	return 0;
+}
+
+static int nvmap_heap_move_block(struct nvmap_handle *handle, void *data)
+{
+	struct nvmap_heap *h = data;
+	struct nvmap_heap_block *b;
+	struct list_block *old;
+	int ret;
+
+	mutex_lock(&handle->lock);
+	if (handle->vaddr || atomic_read(&handle->umap_count) ||
+	    atomic_read(&handle->kmap_count)) {
+		ret = -EBUSY;
+		goto unlock;
+	}
+
+	old = container_of(handle->carveout, struct list_block, block);
+
+	mutex_lock(&h->lock);
+	b = do_heap_alloc(h, old->size, old->align, old->mem_prot, 0, NULL);
+	if (b && b->base >= old->block.base) {
+		do_heap_free(b);
+		b = NULL;
+	}
+	mutex_unlock(&h->lock);
+	if (!b) {
+		ret = -ENOSPC;
+		goto unlock;
+	}
+
+	nvmap_flush_heap_block(NULL, &old->block, old->size, old->mem_prot);
+	ret = nvmap_heap_copy_block(handle, b->base, old->block.base,
+				    old->size);
+	if (ret) {
+		mutex_lock(&h->lock);
+		do_heap_free(b);
+		mutex_unlock(&h->lock);
+		goto unlock;
+	}
+	nvmap_flush_heap_block(NULL, b, old->size, old->mem_prot);
+
+	b->handle = handle;
+	b->type = old->block.type;
+	handle->carveout = b;
+
+	mutex_lock(&h->lock);
+	do_heap_free(&old->block);
+	mutex_unlock(&h->lock);
+
+unlock:
+	mutex_unlock(&handle->lock);
+	return ret;
+}
+
+struct nvmap_heap_move {
+	struct nvmap_handle *handle;
+	phys_addr_t base;
+};
+
+static int nvmap_heap_move_cmp(const void *a, const void *b)
+{
+	const struct nvmap_heap_move *x = a, *y = b;
+
+	/* highest blocks first, they are the ones that can move down */
+	if (x->base == y->base)
+		return 0;
+	return x->base > y->base ? -1 : 1;
+}
+
+int nvmap_heap_compact(struct nvmap_heap *h)
+{
+	struct nvmap_carveout_node *node = h->arg;
+	struct nvmap_heap_move *moves;
+	struct list_block *lb;
+	unsigned int i, nr = 0, nr_moves;
+	size_t moved = 0;
+
+	if (h->is_ivm || h->pm_ops.busy ||
+	    (node->heap_bit & NVMAP_HEAP_CARVEOUT_VPR) ||
+	    !(node->heap_bit & nvmap_dev->cpu_access_mask))
+		return -EPERM;
+
+	mutex_lock(&h->compact_lock);
+
+	mutex_lock(&h->lock);
+	list_for_each_entry(lb, &h->all_list, all_list)
+		nr++;
+	moves = nvmap_altalloc(nr * sizeof(*moves));
+	if (!moves) {
+		mutex_unlock(&h->lock);
+		mutex_unlock(&h->compact_lock);
+		return nr ? -ENOMEM : 0;
+	}
+
+	i = 0;
+	list_for_each_entry(lb, &h->all_list, all_list) {
+		struct nvmap_handle *handle = lb->block.handle;
+
+		if (!handle || !(handle->userflags & NVMAP_HANDLE_MOVABLE) ||
+		    atomic_read(&handle->pin))
+			continue;
+		/* the handle may already be on its way to being freed */
+		if (!atomic_inc_not_zero(&handle->ref))
+			continue;
+		moves[i].handle = handle;
+		moves[i++].base = lb->block.base;
+	}
+	mutex_unlock(&h->lock);
+
+	nr_moves = i;
+	sort(moves, nr_moves, sizeof(*moves), nvmap_heap_move_cmp, NULL);
+	for (i = 0; i < nr_moves; i++) {
+		struct nvmap_handle *handle = moves[i].handle;
+
+		if (!nvmap_dmabuf_relocate(handle, nvmap_heap_move_block, h))
+			moved += handle->size;
+		nvmap_handle_put(handle);
+	}
+	nvmap_altfree(moves, nr * sizeof(*moves));
+
+	h->compacted = moved;
+	mutex_unlock(&h->compact_lock);
+
+	dev_dbg(h->dma_dev, "compaction moved %zuKiB\n", moved >> 10);
+	return 0;
+}
+
+static void nvmap_heap_compact_work(struct work_struct *work)
+{
+	nvmap_heap_compact(container_of(work, struct nvmap_heap,
+					compact_work));
+}
+
 /* nvmap_heap_create: create a heap object of len bytes, starting from
  * address base.
  */
@@ -456,6 +797,8 @@ struct nvmap_heap *nvmap_heap_create(struct device *parent,
 
 	INIT_LIST_HEAD(&h->all_list);
 	mutex_init(&h->lock);
+	mutex_init(&h->compact_lock);
+	INIT_WORK(&h->compact_work, nvmap_heap_compact_work);
 	if (!co->no_cpu_access &&
 		nvmap_cache_maint_phys_range(NVMAP_CACHE_OP_WB_INV,
 				base, base + len, true, true)) {
@@ -481,6 +824,7 @@ fail:
 /* nvmap_heap_destroy: frees all resources in heap */
 void nvmap_heap_destroy(struct nvmap_heap *heap)
 {
+	cancel_work_sync(&heap->compact_work);
 	WARN_ON(!list_is_singular(&heap->all_list));
 	while (!list_empty(&heap->all_list)) {
 		struct list_block *l;
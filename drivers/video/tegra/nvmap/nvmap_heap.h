@@ -42,6 +42,8 @@ struct nvmap_heap *nvmap_block_to_heap(struct nvmap_heap_block *b);
 
 void nvmap_heap_free(struct nvmap_heap_block *block);
 
+int nvmap_heap_compact(struct nvmap_heap *heap);
+
 int __init nvmap_heap_init(void);
 
 void nvmap_heap_deinit(void);
@@ -192,6 +192,129 @@ int nvmap_ioctl_alloc_ivm(struct file *filp, void __user *arg)
 	return err;
 }
 
+#define NVMAP_ALLOC_BULK_MAX	256
+
+struct nvmap_alloc_bulk_state {
+	struct nvmap_handle *handle;
+	struct dma_buf *dmabuf;
+	int fd;
+};
+
+/*
+ * Create and allocate a batch of handles in one call. fds are reserved as
+ * each handle is built but only installed once every entry has succeeded
+ * and the results are back in user space, so a failure part way through
+ * leaves nothing behind in the caller's fd table.
+ */
+int nvmap_ioctl_alloc_bulk(struct file *filp, void __user *arg)
+{
+	struct nvmap_alloc_bulk op;
+	struct nvmap_client *client = filp->private_data;
+	struct nvmap_alloc_bulk_entry *entries;
+	struct nvmap_alloc_bulk_state *state;
+	struct nvmap_handle_ref *ref;
+	size_t total = 0;
+	u32 i, done = 0;
+	int err = 0;
+
+	if (copy_from_user(&op, arg, sizeof(op)))
+		return -EFAULT;
+
+	if (!client)
+		return -ENODEV;
+
+	if (!op.nr || op.nr > NVMAP_ALLOC_BULK_MAX || op.reserved)
+		return -EINVAL;
+
+	entries = nvmap_altalloc(op.nr * sizeof(*entries));
+	if (!entries)
+		return -ENOMEM;
+	state = nvmap_altalloc(op.nr * sizeof(*state));
+	if (!state) {
+		err = -ENOMEM;
+		goto free_entries;
+	}
+
+	if (copy_from_user(entries, (void __user *)(uintptr_t)op.entries,
+			   op.nr * sizeof(*entries))) {
+		err = -EFAULT;
+		goto free_state;
+	}
+
+	for (i = 0; i < op.nr; i++) {
+		if (!entries[i].size ||
+		    entries[i].align & (entries[i].align - 1)) {
+			err = -EINVAL;
+			goto free_state;
+		}
+		total += PAGE_ALIGN(entries[i].size);
+	}
+
+	/* One up front check for the whole batch rather than one per entry. */
+	if (!is_allocation_possible(total)) {
+		err = -ENOMEM;
+		goto free_state;
+	}
+
+	for (i = 0; i < op.nr; i++) {
+		struct nvmap_alloc_bulk_entry *e = &entries[i];
+		struct nvmap_alloc_bulk_state *st = &state[i];
+
+		ref = nvmap_create_handle(client, e->size, false);
+		if (IS_ERR(ref)) {
+			err = PTR_ERR(ref);
+			goto unwind;
+		}
+		st->handle = ref->handle;
+		st->handle->orig_size = e->size;
+		st->dmabuf = st->handle->dmabuf;
+		done++;
+
+		/* user-space handles are aligned to page boundaries, to
+		 * prevent data leakage. */
+		err = nvmap_alloc_handle(client, st->handle, e->heap_mask,
+					 max_t(size_t, e->align, PAGE_SIZE),
+					 0, /* no kind */
+					 e->flags & (~NVMAP_HANDLE_KIND_SPECIFIED),
+					 NVMAP_IVM_INVALID_PEER);
+		if (err) {
+			st->fd = -1;
+			goto unwind;
+		}
+
+		st->fd = nvmap_get_dmabuf_fd(client, st->handle);
+		if (IS_ERR_VALUE((uintptr_t)st->fd)) {
+			err = st->fd;
+			goto unwind;
+		}
+		e->handle = st->fd;
+	}
+
+	if (copy_to_user((void __user *)(uintptr_t)op.entries, entries,
+			 op.nr * sizeof(*entries))) {
+		err = -EFAULT;
+		goto unwind;
+	}
+
+	for (i = 0; i < op.nr; i++)
+		fd_install(state[i].fd, state[i].dmabuf->file);
+	goto free_state;
+
+unwind:
+	for (i = 0; i < done; i++) {
+		if (state[i].fd >= 0) {
+			put_unused_fd(state[i].fd);
+			dma_buf_put(state[i].dmabuf);
+		}
+		nvmap_free_handle(client, state[i].handle);
+	}
+free_state:
+	nvmap_altfree(state, op.nr * sizeof(*state));
+free_entries:
+	nvmap_altfree(entries, op.nr * sizeof(*entries));
+	return err;
+}
+
 int nvmap_ioctl_vpr_floor_size(struct file *filp, void __user *arg)
 {
 	int err=0;
@@ -808,6 +931,97 @@ free_mem:
 	return err;
 }
 
+int nvmap_ioctl_cache_maint_list_async(struct file *filp, void __user *arg)
+{
+	struct nvmap_cache_op_list_async op;
+	struct nvmap_handle **refs;
+	u32 *handle_ptr;
+	u64 *offset_ptr;
+	u64 *size_ptr;
+	u32 i, n_unmarshal_handles = 0;
+	size_t bytes;
+	int err = 0;
+
+	if (copy_from_user(&op, arg, sizeof(op)))
+		return -EFAULT;
+
+	if (!op.nr || op.nr > UINT_MAX / sizeof(u64))
+		return -EINVAL;
+
+	if (op.op < NVMAP_CACHE_OP_WB || op.op > NVMAP_CACHE_OP_WB_INV)
+		return -EINVAL;
+
+	if (!op.handles || !op.offsets || !op.sizes) {
+		pr_err("pointers are invalid\n");
+		return -EINVAL;
+	}
+
+	bytes = op.nr * (sizeof(*refs) + 2 * sizeof(u64) + sizeof(u32));
+	refs = nvmap_altalloc(bytes);
+	if (!refs) {
+		pr_err("memory allocation failed\n");
+		return -ENOMEM;
+	}
+
+	offset_ptr = (u64 *)(refs + op.nr);
+	size_ptr = offset_ptr + op.nr;
+	handle_ptr = (u32 *)(size_ptr + op.nr);
+
+	if (copy_from_user(handle_ptr, (void __user *)(uintptr_t)op.handles,
+			   op.nr * sizeof(u32)) ||
+	    copy_from_user(offset_ptr, (void __user *)(uintptr_t)op.offsets,
+			   op.nr * sizeof(u64)) ||
+	    copy_from_user(size_ptr, (void __user *)(uintptr_t)op.sizes,
+			   op.nr * sizeof(u64))) {
+		err = -EFAULT;
+		goto put_refs;
+	}
+
+	for (i = 0; i < op.nr; i++) {
+		refs[i] = nvmap_handle_get_from_fd(handle_ptr[i]);
+		if (!refs[i]) {
+			pr_err("invalid handle_ptr[%d] = %u\n",
+				i, handle_ptr[i]);
+			err = -EINVAL;
+			goto put_refs;
+		}
+		n_unmarshal_handles++;
+
+		if (!(refs[i]->heap_type & nvmap_dev->cpu_access_mask)) {
+			pr_err("heap %x can't be accessed from cpu\n",
+				refs[i]->heap_type);
+			err = -EPERM;
+			goto put_refs;
+		}
+
+		if (size_ptr[i] && (offset_ptr[i] >= refs[i]->size ||
+		    size_ptr[i] > refs[i]->size - offset_ptr[i])) {
+			err = -EINVAL;
+			goto put_refs;
+		}
+	}
+
+	/* The handle references are handed over to the async job */
+	err = nvmap_cache_async_submit(refs, offset_ptr, size_ptr, op.nr,
+				       op.op, op.in_fence);
+	n_unmarshal_handles = 0;
+	if (err < 0)
+		goto put_refs;
+
+	op.out_fence = err;
+	err = 0;
+	if (copy_to_user(arg, &op, sizeof(op))) {
+		/* The fd is already installed, user space owns it from here */
+		err = -EFAULT;
+	}
+
+put_refs:
+	for (i = 0; i < n_unmarshal_handles; i++)
+		nvmap_handle_put(refs[i]);
+	nvmap_altfree(refs, bytes);
+	return err;
+}
+
 int nvmap_ioctl_gup_test(struct file *filp, void __user *arg)
 {
 	int i, err = -EINVAL;
@@ -35,6 +35,8 @@ int nvmap_ioctl_alloc_kind(struct file *filp, void __user *arg);
 
 int nvmap_ioctl_alloc_ivm(struct file *filp, void __user *arg);
 
+int nvmap_ioctl_alloc_bulk(struct file *filp, void __user *arg);
+
 int nvmap_ioctl_vpr_floor_size(struct file *filp, void __user *arg);
 
 int nvmap_ioctl_free(struct file *filp, unsigned long arg);
@@ -57,6 +59,8 @@ int nvmap_ioctl_rw_handle(struct file *filp, int is_read, void __user *arg,
 int nvmap_ioctl_cache_maint_list(struct file *filp, void __user *arg,
 	bool is_rsrv_op);
 
+int nvmap_ioctl_cache_maint_list_async(struct file *filp, void __user *arg);
+
 int nvmap_ioctl_gup_test(struct file *filp, void __user *arg);
 
 int nvmap_ioctl_set_tag_label(struct file *filp, void __user *arg);
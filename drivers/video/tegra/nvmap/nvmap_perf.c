@@ -0,0 +1,109 @@
+/*
+ * drivers/video/tegra/nvmap/nvmap_perf.c
+ *
+ * nvmap allocation and cache maintenance micro-benchmarks
+ *
+ * Copyright (c) 2021, NVIDIA CORPORATION. All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ */
+
+#include <linux/sizes.h>
+#include <linux/platform/tegra/perf_selftest.h>
+
+#include "nvmap_priv.h"
+
+#define NVMAP_PERF_SIZE		SZ_1M
+#define NVMAP_PERF_FLAGS	NVMAP_HANDLE_CACHEABLE
+
+static struct nvmap_client *perf_client;
+static struct nvmap_handle *perf_handle;
+
+static int nvmap_perf_alloc(struct nvmap_handle **handle)
+{
+	struct nvmap_handle_ref *ref;
+	int err;
+
+	ref = nvmap_create_handle(perf_client, NVMAP_PERF_SIZE, false);
+	if (IS_ERR(ref))
+		return PTR_ERR(ref);
+
+	err = nvmap_alloc_handle(perf_client, ref->handle, NVMAP_HEAP_IOVMM,
+				 PAGE_SIZE, 0, NVMAP_PERF_FLAGS,
+				 NVMAP_IVM_INVALID_PEER);
+	if (err) {
+		nvmap_free_handle(perf_client, ref->handle);
+		return err;
+	}
+
+	*handle = ref->handle;
+	return 0;
+}
+
+/* Create, allocate and free a handle, pools included when enabled */
+static int nvmap_perf_alloc_run(struct tegra_perf_test *test, u64 *ns,
+				u64 *bytes)
+{
+	struct nvmap_handle *h;
+	int err = nvmap_perf_alloc(&h);
+
+	if (err)
+		return err;
+
+	nvmap_free_handle(perf_client, h);
+	*bytes += NVMAP_PERF_SIZE;
+	return 0;
+}
+
+static struct tegra_perf_test nvmap_perf_alloc_test = {
+	.name = "nvmap_alloc_free",
+	.run = nvmap_perf_alloc_run,
+};
+
+static int nvmap_perf_cache_prepare(struct tegra_perf_test *test)
+{
+	return nvmap_perf_alloc(&perf_handle);
+}
+
+/* Writeback and invalidate of a whole cacheable handle */
+static int nvmap_perf_cache_run(struct tegra_perf_test *test, u64 *ns,
+				u64 *bytes)
+{
+	int err = __nvmap_do_cache_maint(perf_client, perf_handle, 0,
+					 NVMAP_PERF_SIZE, NVMAP_CACHE_OP_WB_INV,
+					 false);
+
+	if (!err)
+		*bytes += NVMAP_PERF_SIZE;
+	return err;
+}
+
+static void nvmap_perf_cache_finish(struct tegra_perf_test *test)
+{
+	nvmap_free_handle(perf_client, perf_handle);
+}
+
+static struct tegra_perf_test nvmap_perf_cache_test = {
+	.name = "nvmap_cache_wb_inv",
+	.prepare = nvmap_perf_cache_prepare,
+	.run = nvmap_perf_cache_run,
+	.finish = nvmap_perf_cache_finish,
+};
+
+/* Called at probe, the client lives as long as the nvmap device */
+void nvmap_perf_init(struct nvmap_device *dev)
+{
+	perf_client = __nvmap_create_client(dev, "perf_selftest");
+	if (!perf_client)
+		return;
+
+	tegra_perf_test_register(&nvmap_perf_alloc_test);
+	tegra_perf_test_register(&nvmap_perf_cache_test);
+}
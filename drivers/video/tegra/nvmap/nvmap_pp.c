@@ -27,6 +27,9 @@
 #include <linux/freezer.h>
 #include <linux/highmem.h>
 #include <linux/version.h>
+#include <linux/percpu.h>
+#include <linux/seq_file.h>
+#include <linux/list_sort.h>
 
 #if LINUX_VERSION_CODE >= KERNEL_VERSION(4, 14, 0)
 #include <linux/sched/clock.h>
@@ -38,14 +41,22 @@
 #include "nvmap_priv.h"
 
 #define NVMAP_TEST_PAGE_POOL_SHRINKER     1
-#define PENDING_PAGES_SIZE                (SZ_1M / PAGE_SIZE)
+#define PENDING_PAGES_SIZE                (NVMAP_PP_HUGE_PAGE_SIZE / PAGE_SIZE)
 
 static bool enable_pp = 1;
 static u32 pool_size;
+static u32 pp_magazine_size = NVMAP_PP_MAG_DEFAULT_PAGES;
+
+static u32 pp_huge_pages;
 
 static struct task_struct *background_allocator;
 static DECLARE_WAIT_QUEUE_HEAD(nvmap_bg_wait);
 
+static struct task_struct *bp_compactor;
+static DECLARE_WAIT_QUEUE_HEAD(nvmap_bp_wait);
+static bool bp_compact_pending;
+static u32 bp_pages_since_compact;
+
 #ifdef CONFIG_NVMAP_PAGE_POOL_DEBUG
 static inline void __pp_dbg_var_add(u64 *dbg_var, u32 nr)
 {
@@ -97,22 +108,148 @@ static inline struct page *get_page_list_page(struct nvmap_page_pool *pool)
 	return page;
 }
 
-static inline struct page *get_page_list_page_bp(struct nvmap_page_pool *pool)
+static inline struct page *get_page_list_page_bp(struct nvmap_page_pool *pool,
+						 struct nvmap_pp_bp_tier *tier)
 {
 	struct page *page;
 
-	if (list_empty(&pool->page_list_bp))
+	if (list_empty(&tier->page_list))
 		return NULL;
 
-	page = list_first_entry(&pool->page_list_bp, struct page, lru);
+	page = list_first_entry(&tier->page_list, struct page, lru);
 	list_del(&page->lru);
 
-	pool->count -= pool->pages_per_big_pg;
-	pool->big_page_count -= pool->pages_per_big_pg;
+	pool->count -= tier->pages_per_pg;
+	pool->big_page_count -= tier->pages_per_pg;
+	tier->page_count -= tier->pages_per_pg;
 
 	return page;
 }
 
+static void nvmap_pgcount(struct page *page, bool incr)
+{
+#if LINUX_VERSION_CODE < KERNEL_VERSION(4, 9, 0)
+	if (incr)
+		atomic_inc(&page->_count);
+	else
+		atomic_dec(&page->_count);
+#else
+	page_ref_add(page, incr ? 1 : -1);
+#endif
+}
+
+/*
+ * Move up to @nr zeroed pages from the global page list into this CPU's
+ * magazine. Called with pool->lock held; the magazine lock nests inside it.
+ */
+static void nvmap_pp_mag_refill_locked(struct nvmap_page_pool *pool, u32 nr)
+{
+	struct nvmap_pp_magazine *mag;
+	u32 mag_size = READ_ONCE(pool->mag_size);
+	u32 added = 0;
+
+	mag = get_cpu_ptr(pool->mags);
+	spin_lock(&mag->lock);
+	nr = min(nr, mag_size > mag->nr ? mag_size - mag->nr : 0);
+	while (added < nr) {
+		struct page *page = get_page_list_page(pool);
+
+		if (!page)
+			break;
+		mag->pages[mag->nr++] = page;
+		added++;
+	}
+	if (added)
+		mag->refills++;
+	spin_unlock(&mag->lock);
+	put_cpu_ptr(pool->mags);
+
+	atomic_add(added, &pool->mag_count);
+}
+
+/*
+ * Return every page held in the per-CPU magazines to the global page list.
+ * Must be called with pool->lock held.
+ */
+static void nvmap_pp_mag_drain_locked(struct nvmap_page_pool *pool)
+{
+	int cpu;
+
+	if (!pool->mags)
+		return;
+
+	for_each_possible_cpu(cpu) {
+		struct nvmap_pp_magazine *mag = per_cpu_ptr(pool->mags, cpu);
+		u32 nr;
+
+		spin_lock(&mag->lock);
+		nr = mag->nr;
+		while (mag->nr)
+			list_add(&mag->pages[--mag->nr]->lru, &pool->page_list);
+		if (nr)
+			mag->drains++;
+		spin_unlock(&mag->lock);
+
+		pool->count += nr;
+		atomic_sub(nr, &pool->mag_count);
+	}
+}
+
+static u32 nvmap_pp_mag_get(struct nvmap_page_pool *pool,
+			    struct page **pages, u32 nr)
+{
+	struct nvmap_pp_magazine *mag;
+	u32 got;
+
+	mag = get_cpu_ptr(pool->mags);
+	spin_lock(&mag->lock);
+	got = min(nr, mag->nr);
+	mag->nr -= got;
+	memcpy(pages, &mag->pages[mag->nr], got * sizeof(*pages));
+	mag->hits += got;
+	mag->misses += nr - got;
+	spin_unlock(&mag->lock);
+	put_cpu_ptr(pool->mags);
+
+	atomic_sub(got, &pool->mag_count);
+
+	if (IS_ENABLED(CONFIG_NVMAP_PAGE_POOL_DEBUG)) {
+		u32 i;
+
+		for (i = 0; i < got; i++) {
+			nvmap_pgcount(pages[i], false);
+			BUG_ON(page_count(pages[i]) != 1);
+		}
+	}
+
+	return got;
+}
+
+/*
+ * Serve an allocation from this CPU's magazine. Requests larger than a
+ * magazine bypass it entirely; a short magazine is refilled once in a batch
+ * sized to leave it half full afterwards.
+ */
+static u32 nvmap_pp_mag_alloc(struct nvmap_page_pool *pool,
+			      struct page **pages, u32 nr)
+{
+	u32 mag_size = READ_ONCE(pool->mag_size);
+	u32 got;
+
+	if (!pool->mags || nr > mag_size)
+		return 0;
+
+	got = nvmap_pp_mag_get(pool, pages, nr);
+	if (got == nr)
+		return got;
+
+	rt_mutex_lock(&pool->lock);
+	nvmap_pp_mag_refill_locked(pool, (nr - got) + mag_size / 2);
+	rt_mutex_unlock(&pool->lock);
+
+	return got + nvmap_pp_mag_get(pool, &pages[got], nr - got);
+}
+
 static inline bool nvmap_bg_should_run(struct nvmap_page_pool *pool)
 {
 	return !list_empty(&pool->zero_list);
@@ -194,16 +331,148 @@ static int nvmap_background_zero_thread(void *arg)
 	return 0;
 }
 
-static void nvmap_pgcount(struct page *page, bool incr)
+static int nvmap_pp_page_pfn_cmp(void *priv, struct list_head *a,
+				 struct list_head *b)
 {
-#if LINUX_VERSION_CODE < KERNEL_VERSION(4, 9, 0)
-	if (incr)
-		atomic_inc(&page->_count);
-	else
-		atomic_dec(&page->_count);
-#else
-	page_ref_add(page, incr ? 1 : -1);
-#endif
+	unsigned long pfn_a = page_to_pfn(list_entry(a, struct page, lru));
+	unsigned long pfn_b = page_to_pfn(list_entry(b, struct page, lru));
+
+	return pfn_a < pfn_b ? -1 : pfn_a > pfn_b;
+}
+
+/*
+ * Promote runs of chunks in tier t + 1 that together form an aligned chunk
+ * of tier t. Must be called with pool->lock held.
+ */
+static u32 nvmap_pp_bp_promote_locked(struct nvmap_page_pool *pool, int t)
+{
+	struct nvmap_pp_bp_tier *big = &pool->bp_tiers[t];
+	struct nvmap_pp_bp_tier *small = &pool->bp_tiers[t + 1];
+	struct page *page, *tmp, *head = NULL;
+	u32 per_big, run = 0, promoted = 0;
+
+	if (small->pages_per_pg <= 1 ||
+	    big->pages_per_pg <= small->pages_per_pg ||
+	    small->page_count < big->pages_per_pg)
+		return 0;
+
+	per_big = big->pages_per_pg / small->pages_per_pg;
+	list_sort(NULL, &small->page_list, nvmap_pp_page_pfn_cmp);
+
+	list_for_each_entry_safe(page, tmp, &small->page_list, lru) {
+		u32 i;
+
+		if (run && page == nth_page(head, run * small->pages_per_pg)) {
+			run++;
+		} else if (!(page_to_phys(page) & (big->pg_sz - 1))) {
+			head = page;
+			run = 1;
+		} else {
+			run = 0;
+			continue;
+		}
+
+		if (run < per_big)
+			continue;
+
+		for (i = 0; i < per_big; i++)
+			list_del(&nth_page(head, i * small->pages_per_pg)->lru);
+		list_add_tail(&head->lru, &big->page_list);
+		small->page_count -= big->pages_per_pg;
+		big->page_count += big->pages_per_pg;
+		promoted++;
+		run = 0;
+	}
+
+	return promoted;
+}
+
+/*
+ * Top up the largest tier with freshly allocated chunks until it holds
+ * huge_pg_target of them. The page allocator is asked not to reclaim, so
+ * this gives up as soon as no free chunk of that order is available.
+ */
+static void nvmap_pp_bp_refill(struct nvmap_page_pool *pool)
+{
+	struct nvmap_pp_bp_tier *tier = &pool->bp_tiers[0];
+	gfp_t gfp = (GFP_NVMAP | __GFP_ZERO | __GFP_NOMEMALLOC) &
+		    ~__GFP_RECLAIM;
+	unsigned int order = get_order(tier->pg_sz);
+
+	if (tier->pages_per_pg <= 1)
+		return;
+
+	while (enable_pp && !kthread_should_stop() &&
+	       READ_ONCE(tier->page_count) <
+	       READ_ONCE(pool->huge_pg_target) * tier->pages_per_pg) {
+		struct page *page;
+		bool added = false;
+		u32 i, used;
+
+		page = alloc_pages(gfp, order);
+		if (!page)
+			break;
+		split_page(page, order);
+		for (i = 0; i < tier->pages_per_pg; i++)
+			nvmap_clean_cache_page(nth_page(page, i));
+
+		rt_mutex_lock(&pool->lock);
+		used = pool->count + pool->to_zero + pool->under_zero +
+			atomic_read(&pool->mag_count);
+		if (used + tier->pages_per_pg <= pool->max) {
+			list_add_tail(&page->lru, &tier->page_list);
+			tier->page_count += tier->pages_per_pg;
+			pool->big_page_count += tier->pages_per_pg;
+			pool->count += tier->pages_per_pg;
+			added = true;
+		}
+		rt_mutex_unlock(&pool->lock);
+
+		if (!added) {
+			for (i = 0; i < tier->pages_per_pg; i++)
+				__free_page(nth_page(page, i));
+			break;
+		}
+	}
+}
+
+static inline bool nvmap_bp_should_run(void)
+{
+	return READ_ONCE(bp_compact_pending);
+}
+
+/*
+ * This thread keeps the big page tiers in shape: it reassembles smaller
+ * chunks into larger ones whenever enough of them have been returned to the
+ * pool, and keeps the largest tier topped up to its target.
+ */
+static int nvmap_bp_compact_thread(void *arg)
+{
+	struct nvmap_page_pool *pool = &nvmap_dev->pool;
+	struct sched_param param = { .sched_priority = 0 };
+
+	set_freezable();
+	sched_setscheduler(current, SCHED_IDLE, &param);
+
+	while (!kthread_should_stop()) {
+		int t;
+
+		wait_event_freezable(nvmap_bp_wait,
+				nvmap_bp_should_run() ||
+				kthread_should_stop());
+		if (kthread_should_stop())
+			break;
+
+		rt_mutex_lock(&pool->lock);
+		bp_compact_pending = false;
+		for (t = NVMAP_PP_NR_BP_TIERS - 2; t >= 0; t--)
+			nvmap_pp_bp_promote_locked(pool, t);
+		rt_mutex_unlock(&pool->lock);
+
+		nvmap_pp_bp_refill(pool);
+	}
+
+	return 0;
 }
 
 /*
@@ -216,46 +485,49 @@ static void nvmap_pgcount(struct page *page, bool incr)
 static ulong nvmap_page_pool_free_pages_locked(struct nvmap_page_pool *pool,
 						      ulong nr_pages)
 {
+	/* zero list, page list, then big page tiers from smallest to largest */
+	const int nr_stages = 2 + NVMAP_PP_NR_BP_TIERS;
 	struct page *page;
-	bool use_page_list = false;
-	bool use_page_list_bp = false;
+	bool mags_drained = false;
+	int stage = 0;
 
 	pr_debug("req to release pages=%ld\n", nr_pages);
 
 	while (nr_pages) {
-		int i;
+		struct nvmap_pp_bp_tier *tier = NULL;
+		u32 i, nr;
 
-		if (use_page_list_bp)
-			page = get_page_list_page_bp(pool);
-		else if (use_page_list)
-			page = get_page_list_page(pool);
-		else
+		if (stage == 0) {
 			page = get_zero_list_page(pool);
+		} else if (stage == 1) {
+			page = get_page_list_page(pool);
+		} else {
+			tier = &pool->bp_tiers[nr_stages - 1 - stage];
+			page = get_page_list_page_bp(pool, tier);
+		}
 
 		if (!page) {
-			if (!use_page_list) {
-				use_page_list = true;
+			if (++stage < nr_stages)
 				continue;
-			} else if (!use_page_list_bp) {
-				use_page_list_bp = true;
+			if (!mags_drained && atomic_read(&pool->mag_count)) {
+				/* Per-CPU caches are the last to be reclaimed */
+				nvmap_pp_mag_drain_locked(pool);
+				mags_drained = true;
+				stage = 0;
 				continue;
 			}
 			break;
 		}
 
-		if (use_page_list_bp) {
-			for (i = 0; i < pool->pages_per_big_pg; i++)
-				__free_page(nth_page(page, i));
-			pr_debug("released %d pages\n", pool->pages_per_big_pg);
-			if (nr_pages > pool->pages_per_big_pg)
-				nr_pages -= pool->pages_per_big_pg;
-			else
-				nr_pages = 0;
-		} else {
-			__free_page(page);
-			nr_pages--;
-			pr_debug("released 1 page\n");
-		}
+		nr = tier ? tier->pages_per_pg : 1;
+		for (i = 0; i < nr; i++)
+			__free_page(nth_page(page, i));
+		pr_debug("released %u pages\n", nr);
+
+		if (nr_pages > nr)
+			nr_pages -= nr;
+		else
+			nr_pages = 0;
 	}
 
 	pr_debug("remaining pages to release=%ld\n", nr_pages);
@@ -277,6 +549,10 @@ int nvmap_page_pool_alloc_lots(struct nvmap_page_pool *pool,
 	if (!enable_pp || !nr)
 		return 0;
 
+	ind = nvmap_pp_mag_alloc(pool, pages, nr);
+	if (ind == nr)
+		goto out;
+
 	rt_mutex_lock(&pool->lock);
 
 	while (ind < nr) {
@@ -307,6 +583,7 @@ int nvmap_page_pool_alloc_lots(struct nvmap_page_pool *pool,
 	if (non_zero_cnt)
 		nvmap_pp_zero_pages(&pages[non_zero_idx], non_zero_cnt);
 
+out:
 	pp_alloc_add(pool, ind);
 	pp_hit_add(pool, ind);
 	pp_miss_add(pool, nr - ind);
@@ -316,11 +593,23 @@ int nvmap_page_pool_alloc_lots(struct nvmap_page_pool *pool,
 	return ind;
 }
 
+static inline void nvmap_pp_bp_kick_locked(struct nvmap_page_pool *pool)
+{
+	bp_compact_pending = true;
+	wake_up_interruptible(&nvmap_bp_wait);
+}
+
+/*
+ * Hand out big pages starting from the largest tier and falling back down
+ * the tiers for the remainder.
+ */
 int nvmap_page_pool_alloc_lots_bp(struct nvmap_page_pool *pool,
 				struct page **pages, u32 nr)
 {
+	struct nvmap_pp_bp_tier *huge = &pool->bp_tiers[0];
 	int ind = 0, nr_pages = nr;
 	struct page *page;
+	int t;
 
 	if (!enable_pp || pool->pages_per_big_pg <= 1 ||
 	    nr_pages < pool->pages_per_big_pg)
@@ -328,44 +617,54 @@ int nvmap_page_pool_alloc_lots_bp(struct nvmap_page_pool *pool,
 
 	rt_mutex_lock(&pool->lock);
 
-	while (nr_pages - ind >= pool->pages_per_big_pg) {
-		int i;
+	for (t = 0; t < NVMAP_PP_NR_BP_TIERS; t++) {
+		struct nvmap_pp_bp_tier *tier = &pool->bp_tiers[t];
 
-		page = get_page_list_page_bp(pool);
-		if (!page)
-			break;
+		if (tier->pages_per_pg <= 1)
+			continue;
+
+		while (nr_pages - ind >= tier->pages_per_pg) {
+			int i;
 
-		for (i = 0; i < pool->pages_per_big_pg; i++)
-			pages[ind + i] = nth_page(page, i);
+			page = get_page_list_page_bp(pool, tier);
+			if (!page)
+				break;
 
-		ind += pool->pages_per_big_pg;
+			for (i = 0; i < tier->pages_per_pg; i++)
+				pages[ind + i] = nth_page(page, i);
+
+			ind += tier->pages_per_pg;
+		}
 	}
 
+	if (huge->page_count < pool->huge_pg_target * huge->pages_per_pg)
+		nvmap_pp_bp_kick_locked(pool);
+
 	rt_mutex_unlock(&pool->lock);
 	return ind;
 }
 
-static bool nvmap_is_big_page(struct nvmap_page_pool *pool,
+static bool nvmap_is_big_page(struct nvmap_pp_bp_tier *tier,
 			      struct page **pages, int idx, int nr)
 {
 	int i;
 	struct page *page = pages[idx];
 
-	if (pool->pages_per_big_pg <= 1)
+	if (tier->pages_per_pg <= 1)
 		return false;
 
-	if (nr - idx < pool->pages_per_big_pg)
+	if (nr - idx < tier->pages_per_pg)
 		return false;
 
 	/* Allow coalescing pages at big page boundary only */
-	if (page_to_phys(page) & (pool->big_pg_sz - 1))
+	if (page_to_phys(page) & (tier->pg_sz - 1))
 		return false;
 
-	for (i = 1; i < pool->pages_per_big_pg; i++)
+	for (i = 1; i < tier->pages_per_pg; i++)
 		if (pages[idx + i] != nth_page(page, i))
 			break;
 
-	return i == pool->pages_per_big_pg ? true: false;
+	return i == tier->pages_per_pg ? true: false;
 }
 
 /*
@@ -378,13 +677,17 @@ static bool nvmap_is_big_page(struct nvmap_page_pool *pool,
 static int __nvmap_page_pool_fill_lots_locked(struct nvmap_page_pool *pool,
 				       struct page **pages, u32 nr)
 {
+	struct nvmap_pp_bp_tier *tier;
 	int real_nr;
 	int ind = 0;
+	u32 used;
+	int t;
 
 	if (!enable_pp)
 		return 0;
 
-	real_nr = min_t(u32, pool->max - pool->count, nr);
+	used = pool->count + atomic_read(&pool->mag_count);
+	real_nr = used < pool->max ? min_t(u32, pool->max - used, nr) : 0;
 	BUG_ON(real_nr < 0);
 	if (real_nr == 0)
 		return 0;
@@ -395,11 +698,23 @@ static int __nvmap_page_pool_fill_lots_locked(struct nvmap_page_pool *pool,
 			BUG_ON(page_count(pages[ind]) != 2);
 		}
 
-		if (nvmap_is_big_page(pool, pages, ind, nr)) {
-			list_add_tail(&pages[ind]->lru, &pool->page_list_bp);
-			ind += pool->pages_per_big_pg;
-			real_nr -= pool->pages_per_big_pg;
-			pool->big_page_count += pool->pages_per_big_pg;
+		for (t = 0, tier = NULL; t < NVMAP_PP_NR_BP_TIERS; t++) {
+			if (real_nr >= pool->bp_tiers[t].pages_per_pg &&
+			    nvmap_is_big_page(&pool->bp_tiers[t],
+					      pages, ind, nr)) {
+				tier = &pool->bp_tiers[t];
+				break;
+			}
+		}
+
+		if (tier) {
+			list_add_tail(&pages[ind]->lru, &tier->page_list);
+			ind += tier->pages_per_pg;
+			real_nr -= tier->pages_per_pg;
+			tier->page_count += tier->pages_per_pg;
+			pool->big_page_count += tier->pages_per_pg;
+			if (t == NVMAP_PP_NR_BP_TIERS - 1)
+				bp_pages_since_compact += tier->pages_per_pg;
 		} else {
 			list_add_tail(&pages[ind++]->lru, &pool->page_list);
 			real_nr--;
@@ -410,6 +725,12 @@ static int __nvmap_page_pool_fill_lots_locked(struct nvmap_page_pool *pool,
 	BUG_ON(pool->count > pool->max);
 	pp_fill_add(pool, ind);
 
+	/* Enough small chunks came back to possibly form a larger one */
+	if (bp_pages_since_compact >= pool->bp_tiers[0].pages_per_pg) {
+		bp_pages_since_compact = 0;
+		nvmap_pp_bp_kick_locked(pool);
+	}
+
 	return ind;
 }
 
@@ -419,12 +740,15 @@ int nvmap_page_pool_fill_lots(struct nvmap_page_pool *pool,
 	int ret = 0;
 	int i;
 	u32 save_to_zero;
+	u32 used;
 
 	rt_mutex_lock(&pool->lock);
 
 	save_to_zero = pool->to_zero;
 
-	ret = min(nr, pool->max - pool->count - pool->to_zero - pool->under_zero);
+	used = pool->count + pool->to_zero + pool->under_zero +
+		atomic_read(&pool->mag_count);
+	ret = used < pool->max ? min(nr, pool->max - used) : 0;
 
 	for (i = 0; i < ret; i++) {
 		/* If page has additonal referecnces, Don't add it into
@@ -459,7 +783,8 @@ ulong nvmap_page_pool_get_unused_pages(void)
 	if (!nvmap_dev)
 		return 0;
 
-	total = nvmap_dev->pool.count + nvmap_dev->pool.to_zero;
+	total = nvmap_dev->pool.count + nvmap_dev->pool.to_zero +
+		atomic_read(&nvmap_dev->pool.mag_count);
 
 	return total;
 }
@@ -474,6 +799,7 @@ int nvmap_page_pool_clear(void)
 
 	rt_mutex_lock(&pool->lock);
 
+	nvmap_pp_mag_drain_locked(pool);
 	(void)nvmap_page_pool_free_pages_locked(pool, pool->count + pool->to_zero);
 
 	/* For some reason, if an error occured... */
@@ -633,9 +959,116 @@ static struct kernel_param_ops pool_size_ops = {
 
 module_param_cb(pool_size, &pool_size_ops, &pool_size, 0644);
 
+static int pp_magazine_size_set(const char *arg, const struct kernel_param *kp)
+{
+	struct nvmap_page_pool *pool;
+	int ret = param_set_uint(arg, kp);
+
+	if (ret)
+		return ret;
+
+	pp_magazine_size = min_t(u32, pp_magazine_size, NVMAP_PP_MAG_MAX_PAGES);
+	if (!nvmap_dev)
+		return 0;
+
+	pool = &nvmap_dev->pool;
+	rt_mutex_lock(&pool->lock);
+	if (pp_magazine_size < pool->mag_size)
+		nvmap_pp_mag_drain_locked(pool);
+	WRITE_ONCE(pool->mag_size, pp_magazine_size);
+	rt_mutex_unlock(&pool->lock);
+
+	return 0;
+}
+
+static int pp_magazine_size_get(char *buff, const struct kernel_param *kp)
+{
+	return param_get_uint(buff, kp);
+}
+
+static struct kernel_param_ops pp_magazine_size_ops = {
+	.get = pp_magazine_size_get,
+	.set = pp_magazine_size_set,
+};
+
+module_param_cb(pp_magazine_size, &pp_magazine_size_ops,
+		&pp_magazine_size, 0644);
+
+static int pp_huge_pages_set(const char *arg, const struct kernel_param *kp)
+{
+	int ret = param_set_uint(arg, kp);
+
+	if (ret || !nvmap_dev)
+		return ret;
+
+	rt_mutex_lock(&nvmap_dev->pool.lock);
+	WRITE_ONCE(nvmap_dev->pool.huge_pg_target, pp_huge_pages);
+	nvmap_pp_bp_kick_locked(&nvmap_dev->pool);
+	rt_mutex_unlock(&nvmap_dev->pool.lock);
+
+	return 0;
+}
+
+static int pp_huge_pages_get(char *buff, const struct kernel_param *kp)
+{
+	return param_get_uint(buff, kp);
+}
+
+static struct kernel_param_ops pp_huge_pages_ops = {
+	.get = pp_huge_pages_get,
+	.set = pp_huge_pages_set,
+};
+
+module_param_cb(pp_huge_pages, &pp_huge_pages_ops, &pp_huge_pages, 0644);
+
+static int nvmap_pp_magazine_stats_show(struct seq_file *s, void *unused)
+{
+	struct nvmap_page_pool *pool = s->private;
+	u64 hits = 0, misses = 0, refills = 0, drains = 0;
+	int cpu;
+
+	if (!pool->mags)
+		return 0;
+
+	seq_printf(s, "%-4s %8s %12s %12s %10s %10s\n",
+		   "cpu", "pages", "hits", "misses", "refills", "drains");
+	for_each_possible_cpu(cpu) {
+		struct nvmap_pp_magazine *mag = per_cpu_ptr(pool->mags, cpu);
+
+		spin_lock(&mag->lock);
+		seq_printf(s, "%-4d %8u %12llu %12llu %10llu %10llu\n", cpu,
+			   mag->nr, mag->hits, mag->misses,
+			   mag->refills, mag->drains);
+		hits += mag->hits;
+		misses += mag->misses;
+		refills += mag->refills;
+		drains += mag->drains;
+		spin_unlock(&mag->lock);
+	}
+	seq_printf(s, "%-4s %8d %12llu %12llu %10llu %10llu\n", "all",
+		   atomic_read(&pool->mag_count), hits, misses,
+		   refills, drains);
+
+	return 0;
+}
+
+static int nvmap_pp_magazine_stats_open(struct inode *inode, struct file *file)
+{
+	return single_open(file, nvmap_pp_magazine_stats_show,
+			   inode->i_private);
+}
+
+static const struct file_operations nvmap_pp_magazine_stats_fops = {
+	.open		= nvmap_pp_magazine_stats_open,
+	.read		= seq_read,
+	.llseek		= seq_lseek,
+	.release	= single_release,
+};
+
 int nvmap_page_pool_debugfs_init(struct dentry *nvmap_root)
 {
 	struct dentry *pp_root;
+	int t;
 
 	if (!nvmap_root)
 		return -ENODEV;
@@ -662,6 +1095,26 @@ int nvmap_page_pool_debugfs_init(struct dentry *nvmap_root)
 	debugfs_create_u64("total_page_allocs",
 			   S_IRUGO, pp_root,
 			   &nvmap_total_page_allocs);
+	for (t = 0; t < NVMAP_PP_NR_BP_TIERS; t++) {
+		struct nvmap_pp_bp_tier *tier = &nvmap_dev->pool.bp_tiers[t];
+		char name[40];
+
+		if (tier->pages_per_pg <= 1)
+			continue;
+		snprintf(name, sizeof(name), "page_pool_big_pages_%uK",
+			 tier->pg_sz >> 10);
+		debugfs_create_u32(name, S_IRUGO, pp_root, &tier->page_count);
+	}
+	debugfs_create_u32("page_pool_huge_page_target",
+			   S_IRUGO, pp_root,
+			   &nvmap_dev->pool.huge_pg_target);
+	debugfs_create_u32("page_pool_magazine_size",
+			   S_IRUGO, pp_root,
+			   &nvmap_dev->pool.mag_size);
+	debugfs_create_file("page_pool_magazine_stats",
+			    S_IRUGO, pp_root,
+			    &nvmap_dev->pool,
+			    &nvmap_pp_magazine_stats_fops);
 
 #ifdef CONFIG_NVMAP_PAGE_POOL_DEBUG
 	debugfs_create_u64("page_pool_allocs",
@@ -685,15 +1138,33 @@ int nvmap_page_pool_init(struct nvmap_device *dev)
 {
 	struct sysinfo info;
 	struct nvmap_page_pool *pool = &dev->pool;
+	int cpu, t;
 
 	memset(pool, 0x0, sizeof(*pool));
 	rt_mutex_init(&pool->lock);
 	INIT_LIST_HEAD(&pool->page_list);
 	INIT_LIST_HEAD(&pool->zero_list);
-	INIT_LIST_HEAD(&pool->page_list_bp);
+	atomic_set(&pool->mag_count, 0);
+
+	pool->mags = alloc_percpu(struct nvmap_pp_magazine);
+	if (pool->mags) {
+		for_each_possible_cpu(cpu)
+			spin_lock_init(&per_cpu_ptr(pool->mags, cpu)->lock);
+		pool->mag_size = pp_magazine_size;
+	} else {
+		pr_warn("per-CPU page pool magazines disabled\n");
+	}
 
 	pool->big_pg_sz = NVMAP_PP_BIG_PAGE_SIZE;
 	pool->pages_per_big_pg = NVMAP_PP_BIG_PAGE_SIZE >> PAGE_SHIFT;
+	pool->bp_tiers[0].pg_sz = NVMAP_PP_HUGE_PAGE_SIZE;
+	pool->bp_tiers[1].pg_sz = NVMAP_PP_BIG_PAGE_SIZE;
+	for (t = 0; t < NVMAP_PP_NR_BP_TIERS; t++) {
+		INIT_LIST_HEAD(&pool->bp_tiers[t].page_list);
+		pool->bp_tiers[t].pages_per_pg =
+			pool->bp_tiers[t].pg_sz >> PAGE_SHIFT;
+	}
+	pool->huge_pg_target = pp_huge_pages;
 
 	si_meminfo(&info);
 	pr_info("Total RAM pages: %lu\n", info.totalram);
@@ -717,6 +1188,10 @@ int nvmap_page_pool_init(struct nvmap_device *dev)
 	if (IS_ERR(background_allocator))
 		goto fail;
 
+	bp_compactor = kthread_run(nvmap_bp_compact_thread, NULL, "nvmap-bp");
+	if (IS_ERR(bp_compactor))
+		pr_warn("big page compaction thread failed to start\n");
+
 	register_shrinker(&nvmap_page_pool_shrinker);
 
 	return 0;
@@ -739,6 +1214,26 @@ int nvmap_page_pool_fini(struct nvmap_device *dev)
 		kthread_stop(background_allocator);
 	}
 
+	if (!IS_ERR_OR_NULL(bp_compactor)) {
+		kthread_stop(bp_compactor);
+		bp_compactor = NULL;
+	}
+
+	if (pool->mags) {
+		int cpu;
+
+		for_each_possible_cpu(cpu) {
+			struct nvmap_pp_magazine *mag;
+
+			mag = per_cpu_ptr(pool->mags, cpu);
+			while (mag->nr)
+				__free_page(mag->pages[--mag->nr]);
+		}
+		free_percpu(pool->mags);
+		pool->mags = NULL;
+		atomic_set(&pool->mag_count, 0);
+	}
+
 	WARN_ON(!list_empty(&pool->page_list));
 
 	return 0;
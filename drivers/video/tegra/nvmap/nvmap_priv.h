@@ -131,6 +131,7 @@ struct nvmap_pgalloc {
 	bool contig;			/* contiguous system memory */
 	atomic_t reserved;
 	atomic_t ndirty;	/* count number of dirty pages */
+	atomic_t nzero;		/* pages still waiting for zero on fault */
 };
 
 /* bit 31-29: IVM peer
@@ -185,6 +186,7 @@ struct nvmap_handle {
 	u64 ivm_id;
 	int peer;		/* Peer VM number */
 	bool is_ro;		/* Is handle read-only? */
+	struct nvmap_client *recycle_client; /* client pages return to */
 };
 
 struct nvmap_handle_info {
@@ -219,6 +221,39 @@ struct nvmap_handle_ref {
 #define NVMAP_PP_POOL_SIZE               (128)
 
 #define NVMAP_PP_BIG_PAGE_SIZE           (0x10000)
+#define NVMAP_PP_HUGE_PAGE_SIZE          (0x200000)
+
+/*
+ * Big pages are kept in tiers of physically contiguous, size aligned
+ * chunks. Tiers are ordered from the largest chunk size to the smallest
+ * so that allocations can fall back down the tiers.
+ */
+#define NVMAP_PP_NR_BP_TIERS             (2)
+
+struct nvmap_pp_bp_tier {
+	u32 pg_sz;            /* chunk size of this tier */
+	u32 pages_per_pg;     /* number of pages in a chunk */
+	u32 page_count;       /* number of pages held in this tier */
+	struct list_head page_list;
+};
+
+/*
+ * Per-CPU magazines sit in front of the global page list. They only ever
+ * hold zeroed pages and are refilled/drained in batches under pool->lock,
+ * so allocations which fit in a magazine are served without touching it.
+ */
+#define NVMAP_PP_MAG_MAX_PAGES           (128)
+#define NVMAP_PP_MAG_DEFAULT_PAGES       (64)
+
+struct nvmap_pp_magazine {
+	spinlock_t lock;
+	u32 nr;         /* Number of zeroed pages in the magazine */
+	u64 hits;       /* Pages served from the magazine */
+	u64 misses;     /* Pages the magazine could not serve */
+	u64 refills;    /* Batches pulled in from the global page list */
+	u64 drains;     /* Times the magazine was emptied back to the pool */
+	struct page *pages[NVMAP_PP_MAG_MAX_PAGES];
+};
 
 struct nvmap_page_pool {
 	struct rt_mutex lock;
@@ -226,12 +261,17 @@ struct nvmap_page_pool {
 	u32 max;        /* Max no. of pages in all lists. */
 	u32 to_zero;    /* Number of pages on the zero list */
 	u32 under_zero; /* Number of pages getting zeroed */
-	u32 big_pg_sz;  /* big page size supported(64k, etc.) */
+	u32 big_pg_sz;  /* smallest big page size supported(64k, etc.) */
 	u32 big_page_count;   /* Number of zeroed big pages avaialble */
-	u32 pages_per_big_pg; /* Number of pages in big page */
+	u32 pages_per_big_pg; /* Number of pages in smallest big page */
+	u32 huge_pg_target;   /* Chunks to keep ready in the largest tier */
 	struct list_head page_list;
 	struct list_head zero_list;
-	struct list_head page_list_bp;
+	struct nvmap_pp_bp_tier bp_tiers[NVMAP_PP_NR_BP_TIERS];
+
+	struct nvmap_pp_magazine __percpu *mags;
+	u32 mag_size;         /* Max pages cached per CPU, 0 disables */
+	atomic_t mag_count;   /* Number of pages held in all magazines */
 
 #ifdef CONFIG_NVMAP_PAGE_POOL_DEBUG
 	u64 allocs;
@@ -268,6 +308,12 @@ struct nvmap_client {
 	u32				next_fd;
 	int				warned;
 	int				tag_warned;
+	/* stale pages kept for NVMAP_HANDLE_SKIP_ZERO allocations */
+	spinlock_t			recycle_lock;
+	struct list_head		recycle_pages;
+	u32				recycle_count;
+	bool				recycle_closed;
+	atomic_t			recycle_refs;
 };
 
 struct nvmap_vma_priv {
@@ -444,8 +490,25 @@ struct nvmap_handle *nvmap_handle_get_from_fd(int fd);
 
 /* MM definitions. */
 extern size_t cache_maint_inner_threshold;
+extern size_t cache_maint_calibrated_threshold[2];
 extern int nvmap_cache_maint_by_set_ways;
 
+/*
+ * Size above which a full inner clean (WB) or flush (INV, WB_INV) is used
+ * instead of maintenance by range. The value measured by
+ * nvmap_cache_calibrate() wins over the configured one.
+ */
+static inline size_t nvmap_cache_inner_threshold(unsigned int op)
+{
+	size_t thresh = READ_ONCE(cache_maint_calibrated_threshold[
+					op == NVMAP_CACHE_OP_WB ? 0 : 1]);
+
+	return thresh ? thresh : cache_maint_inner_threshold;
+}
+
+int nvmap_cache_calibrate(void);
+void nvmap_cache_calibrate_at_boot(void);
+
 extern void v7_flush_kern_cache_all(void);
 extern void v7_clean_kern_cache_all(void *);
 
@@ -464,6 +527,44 @@ int __nvmap_cache_maint(struct nvmap_client *client,
 			       struct nvmap_cache_op_64 *op);
 int nvmap_cache_debugfs_init(struct dentry *nvmap_root);
 
+extern void (*nvmap_get_cacheability)(struct nvmap_handle *h,
+		bool *inner, bool *outer);
+
+#ifdef CONFIG_NVMAP_ASYNC_CACHE_MAINT
+int nvmap_cache_async_init(void);
+int nvmap_cache_async_submit(struct nvmap_handle **handles, u64 *offsets,
+			     u64 *sizes, u32 nr, int op, int in_fence_fd);
+void nvmap_cache_async_debugfs_init(struct dentry *cache_root);
+#else
+static inline int nvmap_cache_async_init(void)
+{
+	return 0;
+}
+
+static inline int nvmap_cache_async_submit(struct nvmap_handle **handles,
+					   u64 *offsets, u64 *sizes, u32 nr,
+					   int op, int in_fence_fd)
+{
+	u32 i;
+
+	for (i = 0; i < nr; i++)
+		nvmap_handle_put(handles[i]);
+	return -EOPNOTSUPP;
+}
+
+static inline void nvmap_cache_async_debugfs_init(struct dentry *cache_root)
+{
+}
+#endif
+
+#ifdef CONFIG_TEGRA_PERF_SELFTEST
+void nvmap_perf_init(struct nvmap_device *dev);
+#else
+static inline void nvmap_perf_init(struct nvmap_device *dev)
+{
+}
+#endif
+
 /* Internal API to support dmabuf */
 struct dma_buf *__nvmap_dmabuf_export(struct nvmap_client *client,
 				 struct nvmap_handle *handle);
@@ -487,6 +588,10 @@ int __nvmap_dmabuf_fd(struct nvmap_client *client,
 		      struct dma_buf *dmabuf, int flags);
 
 int nvmap_dmabuf_stash_init(void);
+void nvmap_dmabuf_debugfs_init(struct dentry *nvmap_root);
+int nvmap_dmabuf_relocate(struct nvmap_handle *h,
+			  int (*relocate)(struct nvmap_handle *h, void *data),
+			  void *data);
 
 void *nvmap_altalloc(size_t len);
 void nvmap_altfree(void *ptr, size_t len);
@@ -494,11 +599,19 @@ void nvmap_altfree(void *ptr, size_t len);
 void do_set_pte(struct vm_area_struct *vma, unsigned long address,
 		struct page *page, pte_t *pte, bool write, bool anon);
 
+/* bit 0 of a pgalloc page pointer: dirty, bit 1: zeroing deferred */
+#define NVMAP_PAGE_ZERO_PENDING	2UL
+
 static inline struct page *nvmap_to_page(struct page *page)
 {
 	return (struct page *)((unsigned long)page & ~3UL);
 }
 
+static inline bool nvmap_page_zero_pending(struct page *page)
+{
+	return (unsigned long)page & NVMAP_PAGE_ZERO_PENDING;
+}
+
 static inline bool nvmap_page_dirty(struct page *page)
 {
 	return (unsigned long)page & 1UL;
@@ -593,7 +706,14 @@ static inline struct page **nvmap_pages(struct page **pg_pages, u32 nr_pages)
 
 void nvmap_zap_handle(struct nvmap_handle *handle, u64 offset, u64 size);
 
+void nvmap_handle_zero_page(struct nvmap_handle *h, unsigned int pagenum);
+void nvmap_handle_zero_pages(struct nvmap_handle *h);
+void nvmap_client_recycle_release(struct nvmap_client *client);
+void nvmap_client_recycle_put(struct nvmap_client *client);
+
 void nvmap_vma_open(struct vm_area_struct *vma);
+bool nvmap_vma_wants_chunks(struct nvmap_handle *h);
+void nvmap_vma_prefault_chunks(struct vm_area_struct *vma);
 
 int nvmap_reserve_pages(struct nvmap_handle **handles, u64 *offsets,
 			u64 *sizes, u32 nr, u32 op, bool is_32);
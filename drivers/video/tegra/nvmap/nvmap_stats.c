@@ -16,10 +16,21 @@
  */
 
 #include <linux/debugfs.h>
+#include <linux/log2.h>
+#include <linux/seq_file.h>
+
+#include <trace/events/nvmap.h>
 
 #include "nvmap_priv.h"
 
 struct nvmap_stats nvmap_stats;
+static struct nvmap_alloc_hist nvmap_alloc_hist;
+
+static const char * const nvmap_alloc_src_names[] = {
+	[NVMAP_ALLOC_SRC_POOL] = "pool",
+	[NVMAP_ALLOC_SRC_PAGE] = "page",
+	[NVMAP_ALLOC_SRC_CARVEOUT] = "carveout",
+};
 
 static int nvmap_stats_reset(void *data, u64 val)
 {
@@ -32,6 +43,7 @@ static int nvmap_stats_reset(void *data, u64 val)
 				continue;
 			atomic64_set(&nvmap_stats.stats[i], 0);
 		}
+		memset(&nvmap_alloc_hist, 0, sizeof(nvmap_alloc_hist));
 	}
 	return 0;
 }
@@ -55,6 +67,55 @@ static int nvmap_stats_set(void *data, u64 val)
 DEFINE_SIMPLE_ATTRIBUTE(reset_stats_fops, NULL, nvmap_stats_reset, "%llu\n");
 DEFINE_SIMPLE_ATTRIBUTE(stats_fops, nvmap_stats_get, nvmap_stats_set, "%llu\n");
 
+static int nvmap_alloc_hist_show(struct seq_file *s, void *unused)
+{
+	int src, i;
+
+	seq_puts(s, "size");
+	for (src = 0; src < NVMAP_ALLOC_SRC_NUM; src++)
+		seq_printf(s, " %12s", nvmap_alloc_src_names[src]);
+	seq_putc(s, '\n');
+	for (i = 0; i < NVMAP_HIST_SIZE_BUCKETS; i++) {
+		if (i == NVMAP_HIST_SIZE_BUCKETS - 1)
+			seq_printf(s, "> %6luK:", (PAGE_SIZE << (i - 1)) >> 10);
+		else
+			seq_printf(s, "<=%6luK:", (PAGE_SIZE << i) >> 10);
+		for (src = 0; src < NVMAP_ALLOC_SRC_NUM; src++)
+			seq_printf(s, " %12lld", (long long)atomic64_read(
+				   &nvmap_alloc_hist.size[src][i]));
+		seq_putc(s, '\n');
+	}
+
+	seq_puts(s, "\nlatency");
+	for (src = 0; src < NVMAP_ALLOC_SRC_NUM; src++)
+		seq_printf(s, " %12s", nvmap_alloc_src_names[src]);
+	seq_putc(s, '\n');
+	for (i = 0; i < NVMAP_HIST_LAT_BUCKETS; i++) {
+		if (i == NVMAP_HIST_LAT_BUCKETS - 1)
+			seq_printf(s, ">=%6luus:", 1UL << (i - 1));
+		else
+			seq_printf(s, "< %6luus:", 1UL << i);
+		for (src = 0; src < NVMAP_ALLOC_SRC_NUM; src++)
+			seq_printf(s, " %12lld", (long long)atomic64_read(
+				   &nvmap_alloc_hist.latency[src][i]));
+		seq_putc(s, '\n');
+	}
+
+	return 0;
+}
+
+static int nvmap_alloc_hist_open(struct inode *inode, struct file *file)
+{
+	return single_open(file, nvmap_alloc_hist_show, inode->i_private);
+}
+
+static const struct file_operations nvmap_alloc_hist_fops = {
+	.open		= nvmap_alloc_hist_open,
+	.read		= seq_read,
+	.llseek		= seq_lseek,
+	.release	= single_release,
+};
+
 void nvmap_stats_init(struct dentry *nvmap_debug_root)
 {
 	struct dentry *stats_root;
@@ -76,12 +137,21 @@ void nvmap_stats_init(struct dentry *nvmap_debug_root)
 		CREATE_DF(ucflush_done, nvmap_stats.stats[NS_UCFLUSH_DONE]);
 		CREATE_DF(kcflush_rq, nvmap_stats.stats[NS_KCFLUSH_RQ]);
 		CREATE_DF(kcflush_done, nvmap_stats.stats[NS_KCFLUSH_DONE]);
+		CREATE_DF(recycled, nvmap_stats.stats[NS_RECYCLED]);
+		CREATE_DF(zero_on_fault, nvmap_stats.stats[NS_ZERO_ON_FAULT]);
+		CREATE_DF(iova_hit, nvmap_stats.stats[NS_IOVA_HIT]);
+		CREATE_DF(iova_miss, nvmap_stats.stats[NS_IOVA_MISS]);
+		CREATE_DF(iova_evict, nvmap_stats.stats[NS_IOVA_EVICT]);
+		CREATE_DF(cvsram_rq, nvmap_stats.stats[NS_CVSRAM_RQ]);
+		CREATE_DF(cvsram_hit, nvmap_stats.stats[NS_CVSRAM_HIT]);
 		CREATE_DF(total_memory, nvmap_stats.stats[NS_TOTAL]);
 
 		debugfs_create_file("collect", S_IRUGO | S_IWUSR,
 			stats_root, &nvmap_stats.collect, &stats_fops);
 		debugfs_create_file("reset", S_IWUSR,
 			stats_root, NULL, &reset_stats_fops);
+		debugfs_create_file("alloc_histogram", S_IRUGO,
+			stats_root, NULL, &nvmap_alloc_hist_fops);
 	}
 
 #undef CREATE_DF
@@ -104,3 +174,27 @@ u64 nvmap_stats_read(enum nvmap_stats_t stat)
 	return atomic64_read(&nvmap_stats.stats[stat]);
 }
 
+
+/*
+ * Account one allocation in the size and latency histograms. Sizes land in
+ * the bucket of the next power of two, latencies in the bucket of their
+ * highest set microsecond bit.
+ */
+void nvmap_stats_alloc_record(enum nvmap_alloc_src_t src, size_t size, u64 ns)
+{
+	unsigned int sz, lat;
+	u64 us = ns / NSEC_PER_USEC;
+
+	trace_nvmap_alloc_latency(size, src, ns);
+
+	if (!atomic64_read(&nvmap_stats.collect))
+		return;
+
+	sz = size > PAGE_SIZE ? order_base_2(size >> PAGE_SHIFT) : 0;
+	sz = min_t(unsigned int, sz, NVMAP_HIST_SIZE_BUCKETS - 1);
+	lat = us ? ilog2(us) + 1 : 0;
+	lat = min_t(unsigned int, lat, NVMAP_HIST_LAT_BUCKETS - 1);
+
+	atomic64_inc(&nvmap_alloc_hist.size[src][sz]);
+	atomic64_inc(&nvmap_alloc_hist.latency[src][lat]);
+}
@@ -27,6 +27,13 @@ enum nvmap_stats_t {
 	NS_UCFLUSH_DONE,
 	NS_KCFLUSH_RQ,
 	NS_KCFLUSH_DONE,
+	NS_RECYCLED,
+	NS_ZERO_ON_FAULT,
+	NS_IOVA_HIT,
+	NS_IOVA_MISS,
+	NS_IOVA_EVICT,
+	NS_CVSRAM_RQ,	/* bytes asked for with CV SRAM allowed */
+	NS_CVSRAM_HIT,	/* bytes of them given CV SRAM */
 	NS_TOTAL,
 	NS_NUM,
 };
@@ -36,10 +43,28 @@ struct nvmap_stats {
 	atomic64_t collect;
 };
 
+/* where the memory of an allocation came from */
+enum nvmap_alloc_src_t {
+	NVMAP_ALLOC_SRC_POOL = 0,	/* page pool only */
+	NVMAP_ALLOC_SRC_PAGE,		/* page allocator involved */
+	NVMAP_ALLOC_SRC_CARVEOUT,
+	NVMAP_ALLOC_SRC_NUM,
+};
+
+/* power of two buckets: 4K .. > 128M and 1us .. >= 16ms */
+#define NVMAP_HIST_SIZE_BUCKETS		17
+#define NVMAP_HIST_LAT_BUCKETS		16
+
+struct nvmap_alloc_hist {
+	atomic64_t size[NVMAP_ALLOC_SRC_NUM][NVMAP_HIST_SIZE_BUCKETS];
+	atomic64_t latency[NVMAP_ALLOC_SRC_NUM][NVMAP_HIST_LAT_BUCKETS];
+};
+
 extern struct nvmap_stats nvmap_stats;
 
 void nvmap_stats_init(struct dentry *nvmap_debug_root);
 void nvmap_stats_inc(enum nvmap_stats_t, size_t size);
 void nvmap_stats_dec(enum nvmap_stats_t, size_t size);
 u64 nvmap_stats_read(enum nvmap_stats_t);
+void nvmap_stats_alloc_record(enum nvmap_alloc_src_t src, size_t size, u64 ns);
 #endif /* __VIDEO_TEGRA_NVMAP_STATS_H */
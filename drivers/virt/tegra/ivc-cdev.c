@@ -11,6 +11,8 @@
 
 #include <linux/tegra-ivc.h>
 #include <linux/tegra-ivc-instance.h>
+#include <linux/tegra-ivc-batch.h>
+#include <linux/tegra-ivc-poll.h>
 #include <linux/module.h>
 #include <linux/init.h>
 #include <linux/workqueue.h>
@@ -20,6 +22,9 @@
 #include <linux/device.h>
 #include <linux/slab.h>
 #include <linux/sched.h>
+#include <linux/mm.h>
+#include <linux/uaccess.h>
+#include <uapi/linux/nvhvivc_cdev_ioctl.h>
 
 #include "tegra_hv.h"
 
@@ -44,11 +49,25 @@ struct ivc_dev {
 	 * IRQ handler's notification processing and file ops.
 	 */
 	struct mutex		file_lock;
+
+	/* mmap mode, the whole queue area is mapped if page aligned */
+	phys_addr_t		area_pa;
+	size_t			mmap_size;
+	/* scratch for the get_frames ioctls, nframes entries */
+	void			**frames;
 };
 
 static dev_t ivc_dev;
 static const struct ivc_info_page *info;
 
+/*
+ * Busy-poll window of a blocking read() on an empty channel before falling
+ * back to waiting for the interrupt. The sender does not notify meanwhile.
+ */
+static unsigned int rx_poll_usecs;
+module_param(rx_poll_usecs, uint, 0644);
+MODULE_PARM_DESC(rx_poll_usecs, "read() busy-poll window in usecs, 0 = off");
+
 static irqreturn_t ivc_dev_handler(int irq, void *data)
 {
 	struct ivc_dev *ivc = data;
@@ -56,7 +75,7 @@ static irqreturn_t ivc_dev_handler(int irq, void *data)
 	BUG_ON(!ivc->ivck);
 
 	mutex_lock(&ivc->file_lock);
-	tegra_ivc_channel_notified(tegra_hv_ivc_convert_cookie(ivc->ivck));
+	tegra_hv_ivc_channel_notified(ivc->ivck);
 	mutex_unlock(&ivc->file_lock);
 
 	/* simple implementation, just kick all waiters */
@@ -90,6 +109,13 @@ static int ivc_dev_open(struct inode *inode, struct file *filp)
 	if (IS_ERR(ivck))
 		return PTR_ERR(ivck);
 
+	ivc->frames = kcalloc(ivc->qd->nframes, sizeof(*ivc->frames),
+			GFP_KERNEL);
+	if (!ivc->frames) {
+		tegra_hv_ivc_unreserve(ivck);
+		return -ENOMEM;
+	}
+
 	ivc->ivck = ivck;
 	ivcq = tegra_hv_ivc_convert_cookie(ivck);
 
@@ -105,6 +131,8 @@ static int ivc_dev_open(struct inode *inode, struct file *filp)
 		dev_err(ivc->device, "Failed to request irq %d\n",
 				ivck->irq);
 		ivc->ivck = NULL;
+		kfree(ivc->frames);
+		ivc->frames = NULL;
 		tegra_hv_ivc_unreserve(ivck);
 		return ret;
 	}
@@ -129,6 +157,8 @@ static int ivc_dev_release(struct inode *inode, struct file *filp)
 	devm_free_irq(ivc->device, ivck->irq, ivc);
 
 	ivc->ivck = NULL;
+	kfree(ivc->frames);
+	ivc->frames = NULL;
 
 	/*
 	 * Unreserve after clearing ivck; we no longer have exclusive
@@ -139,6 +169,36 @@ static int ivc_dev_release(struct inode *inode, struct file *filp)
 	return 0;
 }
 
+/* Returns true if frames arrived within the busy-poll window. */
+static bool ivc_dev_busy_poll(struct ivc_dev *ivcd, struct ivc *ivc)
+{
+	unsigned int usecs = READ_ONCE(rx_poll_usecs);
+	u64 end;
+	bool ready;
+
+	if (!usecs)
+		return false;
+
+	mutex_lock(&ivcd->file_lock);
+	tegra_ivc_rx_poll_start(ivc);
+	mutex_unlock(&ivcd->file_lock);
+
+	end = local_clock() + (u64)usecs * NSEC_PER_USEC;
+	do {
+		if (tegra_ivc_can_read(ivc))
+			break;
+		if (need_resched() || signal_pending(current))
+			break;
+		cpu_relax();
+	} while (local_clock() < end);
+
+	mutex_lock(&ivcd->file_lock);
+	ready = tegra_ivc_rx_poll_stop(ivc);
+	mutex_unlock(&ivcd->file_lock);
+
+	return ready;
+}
+
 static ssize_t ivc_dev_read(struct file *filp, char __user *buf,
 		size_t count, loff_t *ppos)
 {
@@ -153,10 +213,12 @@ static ssize_t ivc_dev_read(struct file *filp, char __user *buf,
 		if (filp->f_flags & O_NONBLOCK)
 			return -EAGAIN;
 
-		ret = wait_event_interruptible(ivcd->wq,
-				tegra_ivc_can_read(ivc));
-		if (ret)
-			return ret;
+		if (!ivc_dev_busy_poll(ivcd, ivc)) {
+			ret = wait_event_interruptible(ivcd->wq,
+					tegra_ivc_can_read(ivc));
+			if (ret)
+				return ret;
+		}
 	}
 
 	while (left > 0 && tegra_ivc_can_read(ivc)) {
@@ -165,7 +227,7 @@ static ssize_t ivc_dev_read(struct file *filp, char __user *buf,
 		if (chunk > left)
 			chunk = left;
 		mutex_lock(&ivcd->file_lock);
-		ret = tegra_ivc_read_user(ivc, buf, chunk);
+		ret = tegra_hv_ivc_read_user(ivcd->ivck, buf, chunk);
 		mutex_unlock(&ivcd->file_lock);
 		if (ret < 0)
 			break;
@@ -218,7 +280,7 @@ static ssize_t ivc_dev_write(struct file *filp, const char __user *buf,
 		}
 
 		mutex_lock(&ivcd->file_lock);
-		ret = tegra_ivc_write_user(ivc, buf, chunk);
+		ret = tegra_hv_ivc_write_user(ivcd->ivck, buf, chunk);
 		mutex_unlock(&ivcd->file_lock);
 		if (ret < 0)
 			break;
@@ -258,6 +320,146 @@ static unsigned int ivc_dev_poll(struct file *filp, poll_table *wait)
 	return mask;
 }
 
+static int ivc_dev_mmap(struct file *filp, struct vm_area_struct *vma)
+{
+	struct ivc_dev *ivcd = filp->private_data;
+	size_t map_region_sz = vma->vm_end - vma->vm_start;
+
+	BUG_ON(!ivcd);
+
+	if (ivcd->mmap_size == 0)
+		return -ENXIO;
+
+	/* fail if userspace attempts to partially map the queues */
+	if (vma->vm_pgoff != 0 || map_region_sz != ivcd->mmap_size)
+		return -EINVAL;
+
+	if (remap_pfn_range(vma, vma->vm_start, ivcd->area_pa >> PAGE_SHIFT,
+				map_region_sz, vma->vm_page_prot))
+		return -EAGAIN;
+
+	return 0;
+}
+
+/* both queues of the channel are adjacent, the mapping starts at the first */
+static uintptr_t ivc_dev_area_base(struct ivc *ivc)
+{
+	return min((uintptr_t)ivc->rx_channel, (uintptr_t)ivc->tx_channel);
+}
+
+static void ivc_dev_get_info(struct ivc_dev *ivcd, struct ivc *ivc,
+		struct ivc_cdev_info *ci)
+{
+	uintptr_t base = ivc_dev_area_base(ivc);
+	/* the frames follow the channel header */
+	uint32_t hdr = tegra_ivc_total_queue_size(0);
+
+	memset(ci, 0, sizeof(*ci));
+	ci->nframes = ivcd->qd->nframes;
+	ci->frame_size = ivcd->qd->frame_size;
+	ci->mmap_size = ivcd->mmap_size;
+	ci->rx_frames_offset = (uintptr_t)ivc->rx_channel - base + hdr;
+	ci->tx_frames_offset = (uintptr_t)ivc->tx_channel - base + hdr;
+}
+
+static int ivc_dev_get_frames(struct ivc_dev *ivcd, struct ivc *ivc,
+		bool rx, struct ivc_cdev_frames *cf)
+{
+	uintptr_t base = ivc_dev_area_base(ivc);
+	uint32_t frame_size = ivcd->qd->frame_size;
+	unsigned count;
+	int i, n, run = 0;
+
+	if (cf->count == 0)
+		return -EINVAL;
+	count = min(cf->count, ivcd->qd->nframes);
+
+	mutex_lock(&ivcd->file_lock);
+	if (rx)
+		n = tegra_hv_ivc_read_get_frames(ivcd->ivck, ivcd->frames,
+				count);
+	else
+		n = tegra_hv_ivc_write_get_frames(ivcd->ivck, ivcd->frames,
+				count);
+	mutex_unlock(&ivcd->file_lock);
+
+	/* empty or full */
+	if (n == -ENOMEM)
+		return -EAGAIN;
+	if (n < 0)
+		return n;
+
+	/* the frames are contiguous except where the ring wraps */
+	memset(cf, 0, sizeof(*cf));
+	cf->count = n;
+	cf->offset[0] = (uintptr_t)ivcd->frames[0] - base;
+	cf->nr[0] = 1;
+	for (i = 1; i < n; i++) {
+		if (ivcd->frames[i] != ivcd->frames[i - 1] + frame_size) {
+			run = 1;
+			cf->offset[1] = (uintptr_t)ivcd->frames[i] - base;
+		}
+		cf->nr[run]++;
+	}
+
+	return 0;
+}
+
+static long ivc_dev_ioctl(struct file *filp, unsigned int cmd,
+		unsigned long arg)
+{
+	struct ivc_dev *ivcd = filp->private_data;
+	void __user *uarg = (void __user *)arg;
+	struct ivc_cdev_frames cf;
+	struct ivc_cdev_info ci;
+	struct ivc *ivc;
+	__u32 count;
+	int ret;
+
+	BUG_ON(!ivcd);
+	ivc = tegra_hv_ivc_convert_cookie(ivcd->ivck);
+
+	/* validate the cmd */
+	if (_IOC_TYPE(cmd) != TEGRA_IVC_IOCTL_MAGIC ||
+			_IOC_NR(cmd) > TEGRA_IVC_IOCTL_NUMBER_MAX)
+		return -ENOTTY;
+
+	switch (cmd) {
+	case TEGRA_IVC_IOCTL_GET_INFO:
+		ivc_dev_get_info(ivcd, ivc, &ci);
+		if (copy_to_user(uarg, &ci, sizeof(ci)))
+			return -EFAULT;
+		return 0;
+
+	case TEGRA_IVC_IOCTL_READ_GET_FRAMES:
+	case TEGRA_IVC_IOCTL_WRITE_GET_FRAMES:
+		if (copy_from_user(&cf, uarg, sizeof(cf)))
+			return -EFAULT;
+		ret = ivc_dev_get_frames(ivcd, ivc,
+				cmd == TEGRA_IVC_IOCTL_READ_GET_FRAMES, &cf);
+		if (ret)
+			return ret;
+		if (copy_to_user(uarg, &cf, sizeof(cf)))
+			return -EFAULT;
+		return 0;
+
+	case TEGRA_IVC_IOCTL_READ_ADVANCE:
+	case TEGRA_IVC_IOCTL_WRITE_ADVANCE:
+		if (get_user(count, (__u32 __user *)uarg))
+			return -EFAULT;
+		mutex_lock(&ivcd->file_lock);
+		if (cmd == TEGRA_IVC_IOCTL_READ_ADVANCE)
+			ret = tegra_hv_ivc_read_advance_batch(ivcd->ivck, count);
+		else
+			ret = tegra_hv_ivc_write_advance_batch(ivcd->ivck, count);
+		mutex_unlock(&ivcd->file_lock);
+		return ret;
+
+	default:
+		return -ENOTTY;
+	}
+}
+
 static const struct file_operations ivc_fops = {
 	.owner		= THIS_MODULE,
 	.open		= ivc_dev_open,
@@ -266,6 +468,8 @@ static const struct file_operations ivc_fops = {
 	.read		= ivc_dev_read,
 	.write		= ivc_dev_write,
 	.poll		= ivc_dev_poll,
+	.unlocked_ioctl	= ivc_dev_ioctl,
+	.mmap		= ivc_dev_mmap,
 };
 
 static ssize_t id_show(struct device *dev,
@@ -320,11 +524,55 @@ static ssize_t peer_show(struct device *dev,
 			? ivc->qd->peers[1] : ivc->qd->peers[0]);
 }
 
+static ssize_t stats_show(struct device *dev,
+	struct device_attribute *attr, char *buf)
+{
+	struct ivc_dev *ivc = dev_get_drvdata(dev);
+	struct tegra_hv_ivc_stats st;
+	int ret;
+
+	ret = tegra_hv_ivc_get_stats(ivc->qd->id, &st);
+	if (ret)
+		return ret;
+
+	return snprintf(buf, PAGE_SIZE,
+			"tx_frames %llu\ntx_bytes %llu\n"
+			"rx_frames %llu\nrx_bytes %llu\n"
+			"notify_tx %llu\nnotify_rx %llu\n"
+			"tx_full %llu\nrx_empty %llu\n",
+			st.tx_frames, st.tx_bytes, st.rx_frames, st.rx_bytes,
+			st.notify_tx, st.notify_rx, st.tx_full, st.rx_empty);
+}
+
+/* one "<usecs count" line per bucket, the last one is ">=usecs count" */
+static ssize_t rx_latency_show(struct device *dev,
+	struct device_attribute *attr, char *buf)
+{
+	struct ivc_dev *ivc = dev_get_drvdata(dev);
+	struct tegra_hv_ivc_stats st;
+	ssize_t len = 0;
+	int i, ret;
+
+	ret = tegra_hv_ivc_get_stats(ivc->qd->id, &st);
+	if (ret)
+		return ret;
+
+	for (i = 0; i < TEGRA_HV_IVC_LAT_BUCKETS - 1; i++)
+		len += snprintf(buf + len, PAGE_SIZE - len, "<%lu %llu\n",
+				1UL << i, st.rx_lat[i]);
+	len += snprintf(buf + len, PAGE_SIZE - len, ">=%lu %llu\n",
+			1UL << (i - 1), st.rx_lat[i]);
+
+	return len;
+}
+
 static DEVICE_ATTR_RO(id);
 static DEVICE_ATTR_RO(frame_size);
 static DEVICE_ATTR_RO(nframes);
 static DEVICE_ATTR_RO(reserved);
 static DEVICE_ATTR_RO(peer);
+static DEVICE_ATTR_RO(stats);
+static DEVICE_ATTR_RO(rx_latency);
 
 struct attribute *ivc_attrs[] = {
 	&dev_attr_id.attr,
@@ -332,6 +580,8 @@ struct attribute *ivc_attrs[] = {
 	&dev_attr_nframes.attr,
 	&dev_attr_peer.attr,
 	&dev_attr_reserved.attr,
+	&dev_attr_stats.attr,
+	&dev_attr_rx_latency.attr,
 	NULL,
 };
 ATTRIBUTE_GROUPS(ivc);
@@ -345,12 +595,33 @@ static int __init add_ivc(int i)
 {
 	const struct tegra_hv_queue_data *qd = &ivc_info_queue_array(info)[i];
 	struct ivc_dev *ivc = &ivc_dev_array[i];
+	int guestid = tegra_hv_get_vmid();
+	uint32_t peer, j;
 	int ret;
 
 	ivc->minor = qd->id;
 	ivc->dev = MKDEV(MAJOR(ivc_dev), qd->id);
 	ivc->qd = qd;
 
+	/*
+	 * The rx and tx queues sit back to back in the area shared with the
+	 * peer. They can only be mapped to user space if that does not
+	 * expose anything else in the area.
+	 */
+	peer = qd->peers[0] == guestid ? qd->peers[1] : qd->peers[0];
+	for (j = 0; j < info->nr_areas; j++) {
+		const struct ivc_shared_area *area =
+				ivc_shared_area_addr(info, j);
+
+		if (area->guest != peer)
+			continue;
+		ivc->area_pa = area->pa + qd->offset;
+		if (PAGE_ALIGNED(ivc->area_pa) &&
+				PAGE_ALIGNED(2 * (size_t)qd->size))
+			ivc->mmap_size = 2 * (size_t)qd->size;
+		break;
+	}
+
 	cdev_init(&ivc->cdev, &ivc_fops);
 	snprintf(ivc->name, sizeof(ivc->name) - 1, "ivc%d", qd->id);
 	ret = cdev_add(&ivc->cdev, ivc->dev, 1);
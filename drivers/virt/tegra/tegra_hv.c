@@ -21,6 +21,7 @@
 #include <linux/spinlock.h>
 #include <linux/mutex.h>
 #include <linux/sched.h>
+#include <linux/ktime.h>
 #include <linux/interrupt.h>
 #include <linux/of.h>
 #include <linux/module.h>
@@ -29,6 +30,8 @@
 
 #include <soc/tegra/chip-id.h>
 #include <linux/tegra-ivc.h>
+#include <linux/tegra-ivc-batch.h>
+#include <linux/tegra-ivc-poll.h>
 
 #include <soc/tegra/virt/syscalls.h>
 #include "tegra_hv.h"
@@ -67,6 +70,10 @@ struct hv_ivc {
 
 	char			name[16];
 	int			irq;
+
+	struct tegra_hv_ivc_stats stats;
+	/* time of the last notification not followed by a read yet */
+	u64			rx_notify_ns;
 };
 
 #define cookie_to_ivc_dev(_cookie) \
@@ -113,9 +120,59 @@ static const struct tegra_hv_data *tegra_hv_data;
 static void ivc_raise_irq(struct ivc *ivc_channel)
 {
 	struct hv_ivc *ivc = container_of(ivc_channel, struct hv_ivc, ivc);
+
+	ivc->stats.notify_tx++;
 	hyp_raise_irq(ivc->qd->raise_irq, ivc->other_guestid);
 }
 
+static void ivc_account_notified(struct hv_ivc *ivc)
+{
+	ivc->stats.notify_rx++;
+	if (!READ_ONCE(ivc->rx_notify_ns))
+		WRITE_ONCE(ivc->rx_notify_ns, ktime_get_ns());
+}
+
+/*
+ * ret is the result of the read call, frames and bytes the amount it
+ * consumed on success.
+ */
+static void ivc_account_rx(struct hv_ivc *ivc, int ret, unsigned frames,
+		u64 bytes)
+{
+	u64 notified, usecs;
+	int bucket;
+
+	if (ret == -ENOMEM)
+		ivc->stats.rx_empty++;
+	if (ret < 0 || frames == 0)
+		return;
+
+	ivc->stats.rx_frames += frames;
+	ivc->stats.rx_bytes += bytes;
+
+	notified = xchg(&ivc->rx_notify_ns, 0);
+	if (!notified)
+		return;
+
+	usecs = div_u64(ktime_get_ns() - notified, NSEC_PER_USEC);
+	bucket = usecs ? fls64(usecs) : 0;
+	if (bucket >= TEGRA_HV_IVC_LAT_BUCKETS)
+		bucket = TEGRA_HV_IVC_LAT_BUCKETS - 1;
+	ivc->stats.rx_lat[bucket]++;
+}
+
+static void ivc_account_tx(struct hv_ivc *ivc, int ret, unsigned frames,
+		u64 bytes)
+{
+	if (ret == -ENOMEM)
+		ivc->stats.tx_full++;
+	if (ret < 0)
+		return;
+
+	ivc->stats.tx_frames += frames;
+	ivc->stats.tx_bytes += bytes;
+}
+
 static const struct tegra_hv_data *get_hvd(void)
 {
 	if (!tegra_hv_data) {
@@ -166,6 +223,8 @@ static void ivc_handle_notification(struct hv_ivc *ivc)
 static irqreturn_t ivc_dev_cookie_irq_handler(int irq, void *data)
 {
 	struct hv_ivc *ivcd = data;
+
+	ivc_account_notified(ivcd);
 	ivc_handle_notification(ivcd);
 	return IRQ_HANDLED;
 }
@@ -616,20 +675,54 @@ EXPORT_SYMBOL(tegra_hv_ivc_unreserve);
 int tegra_hv_ivc_write(struct tegra_hv_ivc_cookie *ivck, const void *buf,
 		int size)
 {
-	struct ivc *ivc = &cookie_to_ivc_dev(ivck)->ivc;
+	struct hv_ivc *ivcd = cookie_to_ivc_dev(ivck);
+	int ret;
 
-	return tegra_ivc_write(ivc, buf, size);
+	ret = tegra_ivc_write(&ivcd->ivc, buf, size);
+	ivc_account_tx(ivcd, ret, 1, ret);
+
+	return ret;
 }
 EXPORT_SYMBOL(tegra_hv_ivc_write);
 
 int tegra_hv_ivc_read(struct tegra_hv_ivc_cookie *ivck, void *buf, int size)
 {
-	struct ivc *ivc = &cookie_to_ivc_dev(ivck)->ivc;
+	struct hv_ivc *ivcd = cookie_to_ivc_dev(ivck);
+	int ret;
 
-	return tegra_ivc_read(ivc, buf, size);
+	ret = tegra_ivc_read(&ivcd->ivc, buf, size);
+	ivc_account_rx(ivcd, ret, 1, ret);
+
+	return ret;
 }
 EXPORT_SYMBOL(tegra_hv_ivc_read);
 
+int tegra_hv_ivc_write_user(struct tegra_hv_ivc_cookie *ivck,
+		const void __user *buf, int size)
+{
+	struct hv_ivc *ivcd = cookie_to_ivc_dev(ivck);
+	int ret;
+
+	ret = tegra_ivc_write_user(&ivcd->ivc, buf, size);
+	ivc_account_tx(ivcd, ret, 1, ret);
+
+	return ret;
+}
+EXPORT_SYMBOL(tegra_hv_ivc_write_user);
+
+int tegra_hv_ivc_read_user(struct tegra_hv_ivc_cookie *ivck,
+		void __user *buf, int size)
+{
+	struct hv_ivc *ivcd = cookie_to_ivc_dev(ivck);
+	int ret;
+
+	ret = tegra_ivc_read_user(&ivcd->ivc, buf, size);
+	ivc_account_rx(ivcd, ret, 1, ret);
+
+	return ret;
+}
+EXPORT_SYMBOL(tegra_hv_ivc_read_user);
+
 int tegra_hv_ivc_read_peek(struct tegra_hv_ivc_cookie *ivck, void *buf,
 			   int off, int count)
 {
@@ -680,36 +773,148 @@ EXPORT_SYMBOL(tegra_hv_ivc_dump);
 
 void *tegra_hv_ivc_read_get_next_frame(struct tegra_hv_ivc_cookie *ivck)
 {
-	struct ivc *ivc = &cookie_to_ivc_dev(ivck)->ivc;
+	struct hv_ivc *ivcd = cookie_to_ivc_dev(ivck);
+	void *frame;
 
-	return tegra_ivc_read_get_next_frame(ivc);
+	frame = tegra_ivc_read_get_next_frame(&ivcd->ivc);
+	if (IS_ERR(frame))
+		ivc_account_rx(ivcd, PTR_ERR(frame), 0, 0);
+
+	return frame;
 }
 EXPORT_SYMBOL(tegra_hv_ivc_read_get_next_frame);
 
 void *tegra_hv_ivc_write_get_next_frame(struct tegra_hv_ivc_cookie *ivck)
 {
-	struct ivc *ivc = &cookie_to_ivc_dev(ivck)->ivc;
+	struct hv_ivc *ivcd = cookie_to_ivc_dev(ivck);
+	void *frame;
 
-	return tegra_ivc_write_get_next_frame(ivc);
+	frame = tegra_ivc_write_get_next_frame(&ivcd->ivc);
+	if (IS_ERR(frame))
+		ivc_account_tx(ivcd, PTR_ERR(frame), 0, 0);
+
+	return frame;
 }
 EXPORT_SYMBOL(tegra_hv_ivc_write_get_next_frame);
 
 int tegra_hv_ivc_write_advance(struct tegra_hv_ivc_cookie *ivck)
 {
-	struct ivc *ivc = &cookie_to_ivc_dev(ivck)->ivc;
+	struct hv_ivc *ivcd = cookie_to_ivc_dev(ivck);
+	int ret;
+
+	ret = tegra_ivc_write_advance(&ivcd->ivc);
+	ivc_account_tx(ivcd, ret, 1, ivcd->qd->frame_size);
 
-	return tegra_ivc_write_advance(ivc);
+	return ret;
 }
 EXPORT_SYMBOL(tegra_hv_ivc_write_advance);
 
 int tegra_hv_ivc_read_advance(struct tegra_hv_ivc_cookie *ivck)
 {
-	struct ivc *ivc = &cookie_to_ivc_dev(ivck)->ivc;
+	struct hv_ivc *ivcd = cookie_to_ivc_dev(ivck);
+	int ret;
+
+	ret = tegra_ivc_read_advance(&ivcd->ivc);
+	ivc_account_rx(ivcd, ret, 1, ivcd->qd->frame_size);
 
-	return tegra_ivc_read_advance(ivc);
+	return ret;
 }
 EXPORT_SYMBOL(tegra_hv_ivc_read_advance);
 
+int tegra_hv_ivc_read_batch(struct tegra_hv_ivc_cookie *ivck, void *buf,
+		int size, unsigned count)
+{
+	struct hv_ivc *ivcd = cookie_to_ivc_dev(ivck);
+	int ret;
+
+	ret = tegra_ivc_read_batch(&ivcd->ivc, buf, size, count);
+	ivc_account_rx(ivcd, ret, ret, (u64)ret * size);
+
+	return ret;
+}
+EXPORT_SYMBOL(tegra_hv_ivc_read_batch);
+
+int tegra_hv_ivc_write_batch(struct tegra_hv_ivc_cookie *ivck,
+		const void *buf, int size, unsigned count)
+{
+	struct hv_ivc *ivcd = cookie_to_ivc_dev(ivck);
+	int ret;
+
+	ret = tegra_ivc_write_batch(&ivcd->ivc, buf, size, count);
+	ivc_account_tx(ivcd, ret, ret, (u64)ret * size);
+
+	return ret;
+}
+EXPORT_SYMBOL(tegra_hv_ivc_write_batch);
+
+int tegra_hv_ivc_read_get_frames(struct tegra_hv_ivc_cookie *ivck,
+		void **frames, unsigned count)
+{
+	struct hv_ivc *ivcd = cookie_to_ivc_dev(ivck);
+	int ret;
+
+	ret = tegra_ivc_read_get_frames(&ivcd->ivc, frames, count);
+	ivc_account_rx(ivcd, ret, 0, 0);
+
+	return ret;
+}
+EXPORT_SYMBOL(tegra_hv_ivc_read_get_frames);
+
+int tegra_hv_ivc_read_advance_batch(struct tegra_hv_ivc_cookie *ivck,
+		unsigned count)
+{
+	struct hv_ivc *ivcd = cookie_to_ivc_dev(ivck);
+	int ret;
+
+	ret = tegra_ivc_read_advance_batch(&ivcd->ivc, count);
+	ivc_account_rx(ivcd, ret, count, (u64)count * ivcd->qd->frame_size);
+
+	return ret;
+}
+EXPORT_SYMBOL(tegra_hv_ivc_read_advance_batch);
+
+int tegra_hv_ivc_write_get_frames(struct tegra_hv_ivc_cookie *ivck,
+		void **frames, unsigned count)
+{
+	struct hv_ivc *ivcd = cookie_to_ivc_dev(ivck);
+	int ret;
+
+	ret = tegra_ivc_write_get_frames(&ivcd->ivc, frames, count);
+	ivc_account_tx(ivcd, ret, 0, 0);
+
+	return ret;
+}
+EXPORT_SYMBOL(tegra_hv_ivc_write_get_frames);
+
+int tegra_hv_ivc_write_advance_batch(struct tegra_hv_ivc_cookie *ivck,
+		unsigned count)
+{
+	struct hv_ivc *ivcd = cookie_to_ivc_dev(ivck);
+	int ret;
+
+	ret = tegra_ivc_write_advance_batch(&ivcd->ivc, count);
+	ivc_account_tx(ivcd, ret, count, (u64)count * ivcd->qd->frame_size);
+
+	return ret;
+}
+EXPORT_SYMBOL(tegra_hv_ivc_write_advance_batch);
+
+void tegra_hv_ivc_rx_poll_start(struct tegra_hv_ivc_cookie *ivck)
+{
+	struct ivc *ivc = &cookie_to_ivc_dev(ivck)->ivc;
+
+	tegra_ivc_rx_poll_start(ivc);
+}
+EXPORT_SYMBOL(tegra_hv_ivc_rx_poll_start);
+
+bool tegra_hv_ivc_rx_poll_stop(struct tegra_hv_ivc_cookie *ivck)
+{
+	struct ivc *ivc = &cookie_to_ivc_dev(ivck)->ivc;
+
+	return tegra_ivc_rx_poll_stop(ivc);
+}
+EXPORT_SYMBOL(tegra_hv_ivc_rx_poll_stop);
+
 struct ivc *tegra_hv_ivc_convert_cookie(struct tegra_hv_ivc_cookie *ivck)
 {
 	return &cookie_to_ivc_dev(ivck)->ivc;
@@ -761,12 +966,33 @@ EXPORT_SYMBOL(tegra_hv_mempool_unreserve);
 
 int tegra_hv_ivc_channel_notified(struct tegra_hv_ivc_cookie *ivck)
 {
-	struct ivc *ivc = &cookie_to_ivc_dev(ivck)->ivc;
+	struct hv_ivc *ivcd = cookie_to_ivc_dev(ivck);
 
-	return tegra_ivc_channel_notified(ivc);
+	ivc_account_notified(ivcd);
+
+	return tegra_ivc_channel_notified(&ivcd->ivc);
 }
 EXPORT_SYMBOL(tegra_hv_ivc_channel_notified);
 
+int tegra_hv_ivc_get_stats(uint32_t id, struct tegra_hv_ivc_stats *stats)
+{
+	const struct tegra_hv_data *hvd = get_hvd();
+	struct hv_ivc *ivc;
+
+	if (IS_ERR(hvd))
+		return PTR_ERR(hvd);
+
+	ivc = ivc_device_by_id(hvd, id);
+	if (ivc == NULL)
+		return -ENODEV;
+
+	/* a snapshot, the counters are updated without locking */
+	memcpy(stats, &ivc->stats, sizeof(*stats));
+
+	return 0;
+}
+EXPORT_SYMBOL(tegra_hv_ivc_get_stats);
+
 void tegra_hv_ivc_channel_reset(struct tegra_hv_ivc_cookie *ivck)
 {
 	struct hv_ivc *ivc = cookie_to_ivc_dev(ivck);
@@ -1,5 +1,5 @@
 /*
- * Copyright (C) 2015-2016, NVIDIA CORPORATION. All rights reserved.
+ * Copyright (C) 2015-2021, NVIDIA CORPORATION. All rights reserved.
  *
  * This file is licensed under the terms of the GNU General Public License
  * version 2.  This program is licensed "as is" without any warranty of any
@@ -11,8 +11,38 @@
 #define __TEGRA_HV_H__
 
 #include <soc/tegra/virt/syscalls.h>
+#include <linux/types.h>
+
+struct tegra_hv_ivc_cookie;
+
+/* log2 usecs buckets, the last one counts everything slower */
+#define TEGRA_HV_IVC_LAT_BUCKETS	16
+
+/*
+ * Per channel counters, for the traffic going through the tegra_hv_ivc_*
+ * calls. Notifications raised are counted for every user.
+ */
+struct tegra_hv_ivc_stats {
+	u64 tx_frames;
+	u64 tx_bytes;
+	u64 rx_frames;
+	u64 rx_bytes;
+	u64 notify_tx;
+	u64 notify_rx;
+	/* calls failed on a full or empty queue */
+	u64 tx_full;
+	u64 rx_empty;
+	/* time from a notification to the first frame read */
+	u64 rx_lat[TEGRA_HV_IVC_LAT_BUCKETS];
+};
 
 const struct ivc_info_page *tegra_hv_get_ivc_info(void);
 int tegra_hv_get_vmid(void);
+int tegra_hv_ivc_get_stats(uint32_t id, struct tegra_hv_ivc_stats *stats);
+
+int tegra_hv_ivc_read_user(struct tegra_hv_ivc_cookie *ivck,
+		void __user *buf, int size);
+int tegra_hv_ivc_write_user(struct tegra_hv_ivc_cookie *ivck,
+		const void __user *buf, int size);
 
 #endif /* __TEGRA_HV_H__ */
@@ -23,6 +23,7 @@
 #ifndef __LINUX_NVHOST_H
 #define __LINUX_NVHOST_H
 
+#include <linux/atomic.h>
 #include <linux/cdev.h>
 #include <linux/device.h>
 #include <linux/types.h>
@@ -44,6 +45,9 @@ struct nvhost_cdma;
 struct nvhost_hwctx;
 struct nvhost_device_power_attr;
 struct nvhost_device_profile;
+struct nvhost_latency_hist;
+struct nvhost_task_perf_ring;
+struct nvhost_task_perf;
 struct mem_mgr;
 struct nvhost_as_moduleops;
 struct nvhost_ctrl_sync_fence_info;
@@ -79,9 +83,13 @@ struct sync_pt;
 #define NVMODMUTEX_VIC			(10)	/* t124, t132, t210 */
 #define NVMODMUTEX_VI_1			(11)	/* t124, t132, t210 */
 
+#define NVHOST_IDLE_GAPS		16
+
 enum nvhost_power_sysfs_attributes {
 	NVHOST_POWER_SYSFS_ATTRIB_AUTOSUSPEND_DELAY,
 	NVHOST_POWER_SYSFS_ATTRIB_FORCE_ON,
+	NVHOST_POWER_SYSFS_ATTRIB_AUTOSUSPEND_BREAKEVEN,
+	NVHOST_POWER_SYSFS_ATTRIB_POWER_CYCLES,
 	NVHOST_POWER_SYSFS_ATTRIB_MAX
 };
 
@@ -239,6 +247,8 @@ struct nvhost_device_data {
 	struct kobject clk_cap_kobj;
 	struct kobj_attribute *clk_cap_attrs;
 	struct dentry *debugfs;		/* debugfs directory */
+	struct nvhost_latency_hist *latency_hist; /* job latency stats */
+	struct nvhost_task_perf_ring *perf_ring; /* completed task records */
 
 	u32 nvhost_timeout_default;
 
@@ -387,6 +397,13 @@ struct nvhost_device_data {
 	/* number of frames mlock can be locked for */
 	u32 mlock_timeout_factor;
 
+	/*
+	 * Jobs a session may have in flight while other sessions are busy,
+	 * 0 for no limit. busy_sessions counts sessions with jobs in flight.
+	 */
+	int session_slice;
+	atomic_t busy_sessions;
+
 	/* eventlib id for the device */
 	int eventlib_id;
 
@@ -396,6 +413,22 @@ struct nvhost_device_data {
 
 	/* don't apply platform dma mask */
 	bool no_platform_dma_mask;
+
+	/*
+	 * Adaptive autosuspend: the last idle to busy gaps, in ms. While
+	 * most of them are below the break-even time the autosuspend delay
+	 * is stretched to cover them, autosuspend_delay being the minimum.
+	 */
+	spinlock_t	idle_gap_lock;
+	u32		idle_gaps[NVHOST_IDLE_GAPS];
+	unsigned int	idle_gap_count;
+	u64		idle_since_ns;
+	int		autosuspend_breakeven;	/* ms, 0 disables */
+	int		autosuspend_cur;	/* applied delay */
+
+	/* runtime power-ups and the time spent in them */
+	u64		power_cycles;
+	u64		poweron_ns;
 };
 
 
@@ -679,6 +712,12 @@ static inline void nvhost_eventlib_log_fences(struct platform_device *pdev,
                                               u64 timestamp)
 {
 }
+
+static inline void nvhost_eventlib_log_task_perf(struct platform_device *pdev,
+						 struct nvhost_task_perf *perf,
+						 u64 timestamp)
+{
+}
 #else
 
 #ifdef CONFIG_DEBUG_FS
@@ -802,6 +841,10 @@ void nvhost_eventlib_log_fences(struct platform_device *pdev,
 				enum nvdev_fence_kind kind,
 				u64 timestamp);
 
+void nvhost_eventlib_log_task_perf(struct platform_device *pdev,
+				   struct nvhost_task_perf *perf,
+				   u64 timestamp);
+
 /* public host1x interrupt management APIs */
 int nvhost_intr_register_notifier(struct platform_device *pdev,
 				  u32 id, u32 thresh,
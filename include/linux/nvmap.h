@@ -51,6 +51,12 @@
 #define NVMAP_HANDLE_CACHE_SYNC      (0x1ul << 7)
 #define NVMAP_HANDLE_CACHE_SYNC_AT_RESERVE      (0x1ul << 8)
 #define NVMAP_HANDLE_RO	             (0x1ul << 9)
+/* producer overwrites the whole buffer, stale pages of the client are fine */
+#define NVMAP_HANDLE_SKIP_ZERO       (0x1ul << 10)
+/* reuse stale pages of the client, zero them on first CPU access */
+#define NVMAP_HANDLE_ZERO_ON_FAULT   (0x1ul << 11)
+/* carveout block may be relocated while the handle is not pinned */
+#define NVMAP_HANDLE_MOVABLE         (0x1ul << 12)
 
 #ifdef CONFIG_NVMAP_PAGE_POOLS
 ulong nvmap_page_pool_get_unused_pages(void);
@@ -474,6 +474,12 @@ struct nvs_fn_if {
 	int (*suspend)(void *handle);
 	int (*resume)(void *handle);
 	int (*handler)(void *handle, void *buffer, s64 ts);
+	/* optional: n samples of size bytes each in buffer, the first one at
+	 * ts and the next ones every ts_period.
+	 * Returns the number of samples pushed or a negative error code.
+	 */
+	int (*handler_n)(void *handle, void *buffer, unsigned int n,
+			 unsigned int size, s64 ts, s64 ts_period);
 };
 
 extern const char * const nvs_float_significances[];
@@ -496,6 +502,13 @@ int nvs_vregs_init(struct device *dev, struct regulator_bulk_data *vregs,
 		   unsigned int vregs_n, char **vregs_name);
 int nvs_vregs_sts(struct regulator_bulk_data *vregs, unsigned int vregs_n);
 s64 nvs_timestamp(void);
+struct nvs_ring;
+struct nvs_ring *nvs_ring_alloc(unsigned int n, unsigned int data_n);
+void nvs_ring_free(struct nvs_ring *ring);
+int nvs_ring_put(struct nvs_ring *ring, const void *data, s64 ts);
+int nvs_ring_get(struct nvs_ring *ring, void *data, s64 *ts);
+bool nvs_ring_empty(struct nvs_ring *ring);
+unsigned int nvs_ring_dropped(struct nvs_ring *ring);
 int nvs_dsm_relay(int dev_id, bool connect, int snsr_id, unsigned char *uuid);
 int nvs_dsm_iio(int dev_id, bool connect, int snsr_id, unsigned char *uuid);
 int nvs_dsm_input(int dev_id, bool connect, int snsr_id, unsigned char *uuid);
@@ -32,6 +32,15 @@ struct pid_thermal_gov_params {
 
 	unsigned long up_compensation;
 	unsigned long down_compensation;
+
+	/*
+	 * Predictive mode, used instead of the PID terms if mpc_horizon
+	 * is set: the temperature is extrapolated mpc_horizon ms ahead and
+	 * the state is moved by what is needed to stay at the trip point,
+	 * given that the max state cools by mpc_gain mC/s.
+	 */
+	unsigned long mpc_horizon; /* in ms, 0 to use PID */
+	unsigned long mpc_gain; /* in mC/s at max state */
 };
 
 #endif
@@ -86,6 +86,12 @@ enum tegra_bwmgr_request_type {
 	TEGRA_BWMGR_SET_EMC_REQ_COUNT /* Should always be last */
 };
 
+/*
+ * OR'ed into the request type of tegra_bwmgr_set_emc() to apply a request
+ * that lowers the EMC rate right away instead of coalescing it.
+ */
+#define TEGRA_BWMGR_SET_EMC_IMMEDIATE	0x100
+
 enum bwmgr_dram_types {
 	DRAM_TYPE_NONE,
 	DRAM_TYPE_LPDDR4_16CH_ECC,
@@ -207,9 +213,16 @@ unsigned long tegra_bwmgr_round_rate(unsigned long bw);
  *			 Call tegra_bwmgr_set_emc() with same request type and
  *			 val = 0 to clear request.
  *
+ *			 Requests that can only lower the rate are coalesced
+ *			 over a short window into one clock change, unless
+ *			 TEGRA_BWMGR_SET_EMC_IMMEDIATE is set in @req.
+ *			 Requests that may raise the rate are always applied
+ *			 before returning.
+ *
  * @handle      handle acquired during tegra_bwmgr_register
  * @val         value to be set in Hz, 0 to clear old request of the same type
- * @req         chosen type from tegra_bwmgr_request_type
+ * @req         chosen type from tegra_bwmgr_request_type, optionally
+ *		OR'ed with TEGRA_BWMGR_SET_EMC_IMMEDIATE
  *
  * Returns success (0) or negative errno.
  */
@@ -263,6 +276,22 @@ void __exit bwmgr_exit(void);
  */
 int __init pmqos_bwmgr_init(void);
 
+/*
+ * tegra_bwmgr_get_client_name - get the name of a bwmgr client.
+ * @client	client id from tegra_bwmgr_client_id
+ *
+ * Returns the name, NULL for an invalid id.
+ */
+const char *tegra_bwmgr_get_client_name(enum tegra_bwmgr_client_id client);
+
+/* Accounts client bw requests, in Hz, for the mc perf PMU */
+#ifdef CONFIG_TEGRA_BWMGR_PMU
+void bwmgr_pmu_update(int client, unsigned long bw, unsigned long iso_bw);
+#else
+static inline void bwmgr_pmu_update(int client, unsigned long bw,
+		unsigned long iso_bw) {}
+#endif
+
 #else /* CONFIG_TEGRA_BWMGR */
 
 static inline struct tegra_bwmgr_client *tegra_bwmgr_register(
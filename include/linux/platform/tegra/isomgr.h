@@ -144,6 +144,11 @@ u32 tegra_isomgr_reserve(tegra_isomgr_handle handle,
 /* Realize client reservation - apply settings, rval is dvfs thresh usec */
 u32 tegra_isomgr_realize(tegra_isomgr_handle handle);
 
+/* Reserve and realize in one go, rval is dvfs thresh usec */
+u32 tegra_isomgr_reserve_realize(tegra_isomgr_handle handle,
+			 u32 bw,	/* KB/sec */
+			 u32 lt);	/* usec */
+
 /* This sets bw aside for the client specified. */
 int tegra_isomgr_set_margin(enum tegra_iso_client client, u32 bw, bool wait);
 
@@ -186,6 +191,12 @@ static inline u32 tegra_isomgr_realize(tegra_isomgr_handle handle)
 	return 1;
 }
 
+static inline u32 tegra_isomgr_reserve_realize(tegra_isomgr_handle handle,
+			 u32 bw, u32 lt)
+{
+	return 1;
+}
+
 static inline int tegra_isomgr_set_margin(enum tegra_iso_client client, u32 bw)
 {
 	return 0;
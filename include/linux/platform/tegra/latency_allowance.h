@@ -332,6 +332,9 @@ int tegra_enable_latency_scaling(enum tegra_la_id id,
 
 void tegra_disable_latency_scaling(enum tegra_la_id id);
 
+/* lowest FIFO fullness seen by an ISO client, in % of FIFO, 0 on underflow */
+int tegra_la_report_iso_margin(enum tegra_la_id id, unsigned int margin_pct);
+
 void mc_pcie_init(void);
 
 struct la_to_dc_params tegra_get_la_to_dc_params(void);
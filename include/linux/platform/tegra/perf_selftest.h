@@ -0,0 +1,51 @@
+/*
+ * Tegra performance self-tests
+ *
+ * Copyright (c) 2021, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ */
+
+#ifndef __TEGRA_PERF_SELFTEST_H
+#define __TEGRA_PERF_SELFTEST_H
+
+#include <linux/list.h>
+#include <linux/types.h>
+
+/*
+ * A micro-benchmark run from /sys/kernel/debug/tegra_perf. run() is one
+ * iteration, timed by the runner unless it sets *ns itself, e.g. to leave
+ * out its own setup. It adds the bytes it moved to *bytes. prepare() and
+ * finish() are optional, called around the iterations of a run. All of
+ * them can sleep.
+ */
+struct tegra_perf_test {
+	const char *name;
+	int (*prepare)(struct tegra_perf_test *test);
+	int (*run)(struct tegra_perf_test *test, u64 *ns, u64 *bytes);
+	void (*finish)(struct tegra_perf_test *test);
+	struct list_head node;
+};
+
+#ifdef CONFIG_TEGRA_PERF_SELFTEST
+int tegra_perf_test_register(struct tegra_perf_test *test);
+void tegra_perf_test_unregister(struct tegra_perf_test *test);
+#else
+static inline int tegra_perf_test_register(struct tegra_perf_test *test)
+{
+	return 0;
+}
+
+static inline void tegra_perf_test_unregister(struct tegra_perf_test *test)
+{
+}
+#endif
+
+#endif /* __TEGRA_PERF_SELFTEST_H */
@@ -35,6 +35,21 @@ int tegra_capture_ivc_control_submit(const void *control_desc, size_t len);
  */
 int tegra_capture_ivc_capture_submit(const void *capture_desc, size_t len);
 
+/*
+ * Submit several capture message binary blobs at once over the capture IVC
+ * channel, ringing the RTCPU doorbell once for the batch.
+ *
+ * @param[in] capture_descs: array of count capture message descriptors,
+ * opaque to KMDs.
+ * @param[in] len: size of each descriptor.
+ * @param[in] count: number of descriptors.
+ *
+ * Returns the number of descriptors sent, which is less than count if an
+ * error occurred after the first one, or a negative error code.
+ */
+int tegra_capture_ivc_capture_submit_batch(const void *capture_descs,
+		size_t len, unsigned int count);
+
 /*
  * Callback function to be registered by client to receive the rtcpu
  * notifications through control or capture IVC channel.
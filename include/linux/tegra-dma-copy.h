@@ -0,0 +1,73 @@
+/*
+ * Memory copy offload to GPC DMA memcpy channels
+ *
+ * Copyright (c) 2021, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ */
+
+#ifndef __TEGRA_DMA_COPY_H
+#define __TEGRA_DMA_COPY_H
+
+#include <linux/atomic.h>
+#include <linux/dmaengine.h>
+#include <linux/types.h>
+
+struct tegra_dma_copy_chan;
+
+/*
+ * Called once all copies of a batch are done, with 0 or -EIO. It runs from
+ * the DMA completion tasklet, or from tegra_dma_copy_submit() itself when
+ * the whole batch was copied by the CPU.
+ */
+typedef void (*tegra_dma_copy_done_t)(void *param, int err);
+
+/* Maximum copies in one batch, further ones are done by the CPU */
+#define TEGRA_DMA_COPY_BATCH_MAX	16
+
+/* Embedded in the user's request, the fields are private */
+struct tegra_dma_copy_batch {
+	struct tegra_dma_copy_chan *chan;
+	tegra_dma_copy_done_t done;
+	void *param;
+	atomic_t pending;
+	unsigned int n;
+	struct {
+		dma_addr_t dst;
+		dma_addr_t src;
+		size_t len;
+		dma_cookie_t cookie;
+	} map[TEGRA_DMA_COPY_BATCH_MAX];
+};
+
+/*
+ * Users take a reference on the channel pool from probe, and drop it once
+ * their batches are done. Both can sleep. Without channels, or while all
+ * of them are busy, copies are done by the CPU.
+ */
+int tegra_dma_copy_get(void);
+void tegra_dma_copy_put(void);
+
+/*
+ * Buffers must be in the kernel linear map. Copies smaller than the
+ * threshold, unaligned to 4 bytes or added once the batch is full are
+ * done right away by the CPU. The buffers of a DMA copy, and the batch,
+ * must not be touched until the done callback.
+ */
+void tegra_dma_copy_begin(struct tegra_dma_copy_batch *batch,
+			  tegra_dma_copy_done_t done, void *param);
+void tegra_dma_copy_add(struct tegra_dma_copy_batch *batch, void *dst,
+			const void *src, size_t len);
+void tegra_dma_copy_submit(struct tegra_dma_copy_batch *batch);
+
+/* Single copy, waits for it */
+int tegra_dma_copy_sync(void *dst, const void *src, size_t len);
+
+#endif /* __TEGRA_DMA_COPY_H */
@@ -80,6 +80,17 @@ int tegra_hsp_db_add_handler(int master, db_handler_t handler, void *data);
 
 int tegra_hsp_db_del_handler(int master);
 
+int tegra_hsp_db_add_threaded_handler(int master, db_handler_t handler,
+				      void *data, int cpu);
+
+struct tegra_hsp_db_latency {
+	u64 count;
+	u64 total_ns;
+	u64 max_ns;
+};
+
+int tegra_hsp_db_get_latency(int master, struct tegra_hsp_db_latency *lat);
+
 #define tegra_hsp_find_master(mask, master)	((mask) & (1 << (master)))
 
 struct tegra_hsp_sm_pair;
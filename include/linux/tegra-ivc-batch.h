@@ -0,0 +1,52 @@
+/*
+ * Copyright (c) 2021, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ */
+
+#ifndef _LINUX_TEGRA_IVC_BATCH_H
+#define _LINUX_TEGRA_IVC_BATCH_H
+
+#include <linux/tegra-ivc.h>
+#include <linux/types.h>
+
+/*
+ * Batched IVC frame access. Up to count frames are moved with a single
+ * barrier pair, counter update and notification. The calls return the
+ * number of frames moved, or the error of the single frame version
+ * (-ECONNRESET, -ENOMEM when empty or full, -E2BIG) if none can be.
+ *
+ * The _get_frames variants fill frames[] with pointers to the shared
+ * frames, in order; they are released to the peer by the matching
+ * _advance_batch call with the number of frames consumed or filled in.
+ */
+int tegra_ivc_read_batch(struct ivc *ivc, void *buf, size_t size,
+		unsigned count);
+int tegra_ivc_write_batch(struct ivc *ivc, const void *buf, size_t size,
+		unsigned count);
+int tegra_ivc_read_get_frames(struct ivc *ivc, void **frames, unsigned count);
+int tegra_ivc_read_advance_batch(struct ivc *ivc, unsigned count);
+int tegra_ivc_write_get_frames(struct ivc *ivc, void **frames, unsigned count);
+int tegra_ivc_write_advance_batch(struct ivc *ivc, unsigned count);
+
+int tegra_hv_ivc_read_batch(struct tegra_hv_ivc_cookie *ivck, void *buf,
+		int size, unsigned count);
+int tegra_hv_ivc_write_batch(struct tegra_hv_ivc_cookie *ivck,
+		const void *buf, int size, unsigned count);
+int tegra_hv_ivc_read_get_frames(struct tegra_hv_ivc_cookie *ivck,
+		void **frames, unsigned count);
+int tegra_hv_ivc_read_advance_batch(struct tegra_hv_ivc_cookie *ivck,
+		unsigned count);
+int tegra_hv_ivc_write_get_frames(struct tegra_hv_ivc_cookie *ivck,
+		void **frames, unsigned count);
+int tegra_hv_ivc_write_advance_batch(struct tegra_hv_ivc_cookie *ivck,
+		unsigned count);
+
+#endif
@@ -0,0 +1,31 @@
+/*
+ * Copyright (c) 2021, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ */
+
+#ifndef _LINUX_TEGRA_IVC_POLL_H
+#define _LINUX_TEGRA_IVC_POLL_H
+
+#include <linux/tegra-ivc.h>
+#include <linux/types.h>
+
+/*
+ * Receiver busy-polling. Between start and stop the transmitting end
+ * does not notify frames it writes, stop returns true if the channel has
+ * to be read again before waiting for the next notification.
+ */
+void tegra_ivc_rx_poll_start(struct ivc *ivc);
+bool tegra_ivc_rx_poll_stop(struct ivc *ivc);
+
+void tegra_hv_ivc_rx_poll_start(struct tegra_hv_ivc_cookie *ivck);
+bool tegra_hv_ivc_rx_poll_stop(struct tegra_hv_ivc_cookie *ivck);
+
+#endif
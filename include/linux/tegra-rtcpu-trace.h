@@ -24,6 +24,7 @@ struct tegra_rtcpu_trace *tegra_rtcpu_trace_create(
 	struct camrtc_device_group *camera_devices);
 int tegra_rtcpu_trace_boot_sync(struct tegra_rtcpu_trace *tracer);
 void tegra_rtcpu_trace_flush(struct tegra_rtcpu_trace *tracer);
+void tegra_rtcpu_trace_kick(struct tegra_rtcpu_trace *tracer);
 void tegra_rtcpu_trace_destroy(struct tegra_rtcpu_trace *tracer);
 
 #endif
@@ -149,9 +149,17 @@ typedef struct _msgq_t {
 
 void msgq_init(msgq_t *msgq, int32_t size);
 int32_t msgq_queue_message(msgq_t *msgq, const msgq_message_t *message);
+int32_t msgq_queue_messages(msgq_t *msgq, const msgq_message_t **messages,
+			    int32_t count);
 int32_t msgq_dequeue_message(msgq_t *msgq, msgq_message_t *message);
 #define msgq_discard_message(msgq) msgq_dequeue_message(msgq, NULL)
 
+/* lets receivers drain a queue without an error on the last dequeue */
+static inline bool msgq_is_empty(msgq_t *msgq)
+{
+	return READ_ONCE(msgq->read_index) == READ_ONCE(msgq->write_index);
+}
+
 /*
  * DRAM Sharing
  */
@@ -306,6 +314,7 @@ int nvadsp_app_stop(nvadsp_app_info_t *);
 int nvadsp_app_deinit(nvadsp_app_info_t *);
 void *nvadsp_alloc_coherent(size_t, dma_addr_t *, gfp_t);
 void nvadsp_free_coherent(size_t, void *, dma_addr_t);
+int nvadsp_mmap_coherent(struct vm_area_struct *, void *, dma_addr_t, size_t);
 nvadsp_app_info_t __must_check *nvadsp_run_app(nvadsp_os_handle_t, const char *,
 	nvadsp_app_args_t *, app_complete_status_notifier, uint32_t, bool);
 void nvadsp_exit_app(nvadsp_app_info_t *app, bool terminate);
@@ -374,6 +383,10 @@ void nvadsp_set_adma_dump_reg(void (*cb_adma_regdump)(void));
 unsigned long adsp_override_freq(unsigned long freq);
 void adsp_update_dfs_min_rate(unsigned long freq);
 
+/* Workload hints of running streams, load in KHz (MCPS * 1000) */
+void adsp_dfs_add_load(unsigned long freq);
+void adsp_dfs_remove_load(unsigned long freq);
+
 /* Enable / disable dynamic freq scaling */
 void adsp_update_dfs(bool enable);
 #else
@@ -387,6 +400,16 @@ static inline void adsp_update_dfs_min_rate(unsigned long freq)
 	return;
 }
 
+static inline void adsp_dfs_add_load(unsigned long freq)
+{
+	return;
+}
+
+static inline void adsp_dfs_remove_load(unsigned long freq)
+{
+	return;
+}
+
 static inline void adsp_update_dfs(bool enable)
 {
 	return;
@@ -0,0 +1,75 @@
+/*
+ * Copyright (c) 2021, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ */
+
+#ifndef TEGRA_PCIE_DMA_TEST_H
+#define TEGRA_PCIE_DMA_TEST_H
+
+#include <linux/sizes.h>
+#include <linux/types.h>
+
+/*
+ * Interface between the pci_epf_dma_test endpoint function and the
+ * tegra_pcie_dma_test host driver. BAR0 starts with the mailbox, the
+ * endpoint test buffer follows it. The host driver programs a test in
+ * the mailbox and the endpoint runs it on its eDMA channels.
+ */
+
+#define PCIE_DMA_TEST_MAGIC		0x54414d44 /* "DMAT" */
+
+#define PCIE_DMA_TEST_BAR0_SIZE		SZ_4M
+#define PCIE_DMA_TEST_MBOX_SIZE		SZ_4K
+
+/* Link list descriptors per channel in a test round */
+#define PCIE_DMA_TEST_MAX_DEPTH		64
+
+enum pcie_dma_test_cmd {
+	PCIE_DMA_TEST_CMD_NONE,
+	/* EP to host, over the eDMA write channels */
+	PCIE_DMA_TEST_CMD_WRITE,
+	/* host to EP, over the eDMA read channels */
+	PCIE_DMA_TEST_CMD_READ,
+};
+
+enum pcie_dma_test_status {
+	PCIE_DMA_TEST_STATUS_IDLE,
+	PCIE_DMA_TEST_STATUS_BUSY,
+	PCIE_DMA_TEST_STATUS_DONE,
+	PCIE_DMA_TEST_STATUS_ERROR,
+};
+
+struct pcie_dma_test_mbox {
+	/* Set by EP */
+	u32 magic;
+	u32 buf_offset;
+	u32 buf_size;
+	u32 rsvd;
+
+	/* Set by host */
+	u64 host_buf_addr;
+	u32 host_buf_size;
+	u32 size;
+	u32 depth;
+	u32 channels;
+	u32 iterations;
+	/* written last, cleared by EP when the test is picked up */
+	u32 cmd;
+
+	/* Set by EP */
+	u32 status;
+	s32 error;
+	u64 total_ns;
+	u64 min_ns;
+	u64 max_ns;
+};
+
+#endif
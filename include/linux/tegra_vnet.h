@@ -31,6 +31,13 @@
 
 #define TVNET_NAPI_WEIGHT	64
 
+/*
+ * Data queue pairs. Each one has its own rings in BAR0, its own host to EP
+ * syncpoint irq and its own EP to host MSI-X vector. MSI-X vector 0 is for
+ * control messages, so EP has to provide 1 + TVNET_NUM_QUEUES vectors.
+ */
+#define TVNET_NUM_QUEUES	4
+
 #define RING_COUNT 256
 
 /* Allocate 100% extra desc to handle the drift between empty & full buffer */
@@ -206,15 +213,15 @@ struct ring_buf_md {
 struct bar_md {
 	/* IRQ generation for control packets */
 	struct irq_md irq_ctrl;
-	/* IRQ generation for data packets */
-	struct irq_md irq_data;
+	/* IRQ generation for data packets, one per queue */
+	struct irq_md irq_data[TVNET_NUM_QUEUES];
 	/* Ring buffers counter offset */
 	u32 ep_own_cnt_offset;
 	u32 host_own_cnt_offset;
 	/* Ring buffers location offset */
 	struct ring_buf_md ctrl_md;
-	struct ring_buf_md ep2h_md;
-	struct ring_buf_md h2ep_md;
+	struct ring_buf_md ep2h_md[TVNET_NUM_QUEUES];
+	struct ring_buf_md h2ep_md[TVNET_NUM_QUEUES];
 	/* RAM region for use by host when programming EP DMA controller */
 	u32 host_dma_offset;
 	u32 host_dma_size;
@@ -264,38 +271,50 @@ struct tvnet_counter {
 	u32 *wr;
 };
 
-struct ep_own_cnt {
-	u32 h2ep_ctrl_rd_cnt;
-	u32 ep2h_ctrl_wr_cnt;
+struct ep_own_data_cnt {
 	u32 ep2h_empty_rd_cnt;
 	u32 ep2h_full_wr_cnt;
 	u32 h2ep_full_rd_cnt;
 	u32 h2ep_empty_wr_cnt;
+	/* H2EP full rd_cnt at which EP wants the next data irq */
+	u32 h2ep_full_event;
+};
+
+struct ep_own_cnt {
+	u32 h2ep_ctrl_rd_cnt;
+	u32 ep2h_ctrl_wr_cnt;
+	struct ep_own_data_cnt data[TVNET_NUM_QUEUES];
 };
 
 struct ep_ring_buf {
 	struct ep_own_cnt *ep_cnt;
 	/* Endpoint written message buffers */
 	struct ctrl_msg *ep2h_ctrl_msgs;
-	struct data_msg *ep2h_full_msgs;
-	struct data_msg *h2ep_empty_msgs;
+	struct data_msg *ep2h_full_msgs[TVNET_NUM_QUEUES];
+	struct data_msg *h2ep_empty_msgs[TVNET_NUM_QUEUES];
 };
 
-struct host_own_cnt {
-	u32 h2ep_ctrl_wr_cnt;
-	u32 ep2h_ctrl_rd_cnt;
+struct host_own_data_cnt {
 	u32 ep2h_empty_wr_cnt;
 	u32 ep2h_full_rd_cnt;
 	u32 h2ep_full_wr_cnt;
 	u32 h2ep_empty_rd_cnt;
+	/* EP2H full rd_cnt at which host wants the next data irq */
+	u32 ep2h_full_event;
+};
+
+struct host_own_cnt {
+	u32 h2ep_ctrl_wr_cnt;
+	u32 ep2h_ctrl_rd_cnt;
+	struct host_own_data_cnt data[TVNET_NUM_QUEUES];
 };
 
 struct host_ring_buf {
 	struct host_own_cnt *host_cnt;
 	/* Host written message buffers */
 	struct ctrl_msg *h2ep_ctrl_msgs;
-	struct data_msg *ep2h_empty_msgs;
-	struct data_msg *h2ep_full_msgs;
+	struct data_msg *ep2h_empty_msgs[TVNET_NUM_QUEUES];
+	struct data_msg *h2ep_full_msgs[TVNET_NUM_QUEUES];
 };
 
 struct ep2h_empty_list {
@@ -333,6 +352,56 @@ struct dma_desc_cnt {
 	u32 rd_cnt;
 	u32 wr_cnt;
 };
+
+/* Packets up to this size are cheaper to copy by CPU than to DMA */
+#define TVNET_DMA_COPYBREAK	256
+
+/* skb head and frags, one DMA desc each */
+#define TVNET_MAX_DMA_SEGS	(MAX_SKB_FRAGS + 1)
+
+struct tvnet_dma_seg {
+	dma_addr_t iova;
+	u32 len;
+};
+
+static inline void tvnet_dma_unmap_skb(struct device *d,
+				       struct tvnet_dma_seg *segs, int nsegs)
+{
+	int i;
+
+	dma_unmap_single(d, segs[0].iova, segs[0].len, DMA_TO_DEVICE);
+	for (i = 1; i < nsegs; i++)
+		dma_unmap_page(d, segs[i].iova, segs[i].len, DMA_TO_DEVICE);
+}
+
+/* Map skb head and frags for DMA, returns number of segments */
+static inline int tvnet_dma_map_skb(struct device *d, struct sk_buff *skb,
+				    struct tvnet_dma_seg *segs)
+{
+	struct skb_shared_info *info = skb_shinfo(skb);
+	int i;
+
+	segs[0].len = skb_headlen(skb);
+	segs[0].iova = dma_map_single(d, skb->data, segs[0].len,
+				      DMA_TO_DEVICE);
+	if (dma_mapping_error(d, segs[0].iova))
+		return -ENOMEM;
+
+	for (i = 0; i < info->nr_frags; i++) {
+		skb_frag_t *frag = &info->frags[i];
+
+		segs[i + 1].len = skb_frag_size(frag);
+		segs[i + 1].iova = skb_frag_dma_map(d, frag, 0,
+						    segs[i + 1].len,
+						    DMA_TO_DEVICE);
+		if (dma_mapping_error(d, segs[i + 1].iova)) {
+			tvnet_dma_unmap_skb(d, segs, i + 1);
+			return -ENOMEM;
+		}
+	}
+
+	return i + 1;
+}
 #endif
 
 static inline bool tvnet_ivc_empty(struct tvnet_counter *counter)
@@ -420,5 +489,28 @@ static inline u32 tvnet_ivc_get_rd_cnt(struct tvnet_counter *counter)
 	return READ_ONCE(*counter->rd);
 }
 
+/*
+ * Data irq suppression, as with the virtio event index: the consumer
+ * publishes its rd_cnt before going idle and the producer only raises an
+ * irq if the messages written since its last irq moved past that count.
+ */
+static inline bool tvnet_ivc_need_event(u32 event, u32 new_wr, u32 old_wr)
+{
+	return (u32)(new_wr - event - 1) < (u32)(new_wr - old_wr);
+}
+
+/* Consumer side: ask for an irq on the next message */
+static inline void tvnet_ivc_arm_event(struct tvnet_counter *counter,
+				       u32 *event)
+{
+	WRITE_ONCE(*event, READ_ONCE(*counter->rd));
+
+	/* Pairs with smp_mb() in tvnet_ivc_advance_wr() of the producer */
+	smp_mb();
+}
+
+/* Empty buffers left in the ring when the peer is asked to refill it */
+#define TVNET_REFILL_THRESH	(RING_COUNT / 2)
+
 
 #endif
@@ -135,4 +135,16 @@
 #define SMC_SC_VDEV_KICK_VQ	SMC_STDCALL_NR(SMC_ENTITY_TRUSTED_OS, 24)
 #define SMC_NC_VDEV_KICK_VQ	SMC_STDCALL_NR(SMC_ENTITY_TRUSTED_OS, 25)
 
+/**
+ * SMC_SC_BATCH - Run several standard calls with one world switch.
+ *
+ * @r1: Lower 32 bits of the encoded page of struct trusty_batch_cmd.
+ * @r2: Upper 32 bits of the encoded page.
+ * @r3: Size of the commands in bytes.
+ *
+ * Runs the commands in order and stores each result in its ret field.
+ * Returns the number of commands run, later ones are left to the caller.
+ */
+#define SMC_SC_BATCH		SMC_STDCALL_NR(SMC_ENTITY_TRUSTED_OS, 26)
+
 #endif /* __LINUX_TRUSTY_SMCALL_H */
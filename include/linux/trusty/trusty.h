@@ -90,6 +90,10 @@ int trusty_call32_mem_buf(struct device *dev, u32 smcnr,
 			  struct page *page,  u32 size,
 			  pgprot_t pgprot);
 
+int trusty_encode_page_list(struct ns_mem_page_info *inf,
+			    struct page **pages, unsigned int n,
+			    pgprot_t pgprot);
+
 struct trusty_nop {
 	struct list_head node;
 	u32 args[3];
@@ -107,4 +111,24 @@ void trusty_enqueue_nop(struct device *dev, struct trusty_nop *nop);
 void trusty_dequeue_nop(struct device *dev, struct trusty_nop *nop);
 int is_trusty_dev_enabled(void);
 
+/* one slot of the SMC_SC_BATCH command page, shared with trusty */
+struct trusty_batch_cmd {
+	u32 smcnr;
+	u32 args[3];
+	s32 ret;
+	u32 reserved;
+} __packed;
+
+#define TRUSTY_BATCH_MAX	(PAGE_SIZE / sizeof(struct trusty_batch_cmd))
+
+struct trusty_batch;
+
+struct trusty_batch *trusty_batch_alloc(struct device *dev);
+void trusty_batch_free(struct trusty_batch *batch);
+int trusty_batch_add(struct trusty_batch *batch, u32 smcnr,
+		     u32 a0, u32 a1, u32 a2);
+int trusty_batch_submit(struct trusty_batch *batch);
+s32 trusty_batch_result(struct trusty_batch *batch, unsigned int i);
+void trusty_account_batch(struct device *dev, unsigned int n);
+
 #endif
@@ -68,6 +68,27 @@ tipc_chan_get_txbuf_timeout(struct tipc_chan *chan, long timeout);
 
 void tipc_chan_put_txbuf(struct tipc_chan *chan, struct tipc_msg_buf *mb);
 
+/*
+ * Memory shared with the service of a channel. It is registered once and
+ * then referred to in messages with a struct tipc_shm_ref, so bulk data does
+ * not have to be copied into message buffers.
+ */
+struct tipc_shm {
+	void *va;
+	size_t size;
+	u64 handle;	/* from the secure side, valid once created */
+};
+
+struct tipc_shm_ref {
+	u64 handle;
+	u64 offset;
+	u64 len;
+} __packed;
+
+struct tipc_shm *tipc_shm_create(struct tipc_chan *chan, size_t size);
+
+int tipc_shm_destroy(struct tipc_shm *shm);
+
 static inline size_t mb_avail_space(struct tipc_msg_buf *mb)
 {
 	return mb->buf_sz - mb->wpos;
@@ -94,6 +115,22 @@ static inline void *mb_get_data(struct tipc_msg_buf *mb, size_t len)
 	return pos;
 }
 
+static inline int mb_put_shm_ref(struct tipc_msg_buf *mb,
+				 struct tipc_shm *shm, u64 offset, u64 len)
+{
+	struct tipc_shm_ref *ref;
+
+	if (offset > shm->size || len > shm->size - offset ||
+	    mb_avail_space(mb) < sizeof(*ref))
+		return -EINVAL;
+
+	ref = mb_put_data(mb, sizeof(*ref));
+	ref->handle = shm->handle;
+	ref->offset = offset;
+	ref->len = len;
+	return 0;
+}
+
 /* OTE-TIPC wrapper APIs*/
 /*
  * te_open_trusted_session - Establishes the session with TA
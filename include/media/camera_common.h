@@ -238,6 +238,8 @@ struct camera_common_data {
 	/* TODO: cleanup neeeded once all the sensors adapt new framework */
 	struct tegracam_ctrl_handler		*tegracam_ctrl_hdl;
 	struct regmap				*regmap;
+	/* optional, routes blob writes through the RTCPU when set */
+	struct camera_common_i2c		*i2c;
 	struct camera_common_pdata		*pdata;
 	/* TODO: cleanup needed for priv once all the sensors adapt new framework */
 	void	*priv;
@@ -410,4 +412,9 @@ int camera_common_i2c_write_table_8(
 	const struct reg_8 override_list[],
 	int num_override_regs, u16 wait_ms_addr, u16 end_addr);
 
+int camera_common_i2c_write_blob(
+	struct camera_common_i2c *sensor,
+	struct sensor_blob *blob,
+	int frame_id);
+
 #endif /* __camera_common__ */
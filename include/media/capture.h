@@ -71,6 +71,10 @@ struct vi_capture {
 	struct capture_common_unpins *unpins_list;
 
 	uint64_t vi_channel_mask;
+
+	void (*status_notify)(void *data);
+		/**< called after each capture status completion */
+	void *status_notify_data;
 };
 
 struct vi_capture_setup {
@@ -116,6 +120,33 @@ struct vi_capture_req {
 	uint64_t reloc_relatives;
 } __VI_CAPTURE_ALIGN;
 
+/* Upper bound of the requests of a VI_CAPTURE_REQUEST_LIST call */
+#define VI_CAPTURE_MAX_REQUEST_LIST	64U
+
+/*
+ * A list of capture requests queued to RTCPU with a single IVC batch.
+ * requests points to num_requests struct vi_capture_req. The list is
+ * processed in order and stops at the first request that fails,
+ * num_queued returns the number of requests queued before it.
+ */
+struct vi_capture_req_list {
+	uint32_t num_requests;
+	uint32_t num_queued;
+	uint64_t requests;
+} __VI_CAPTURE_ALIGN;
+
+/*
+ * Wait up to timeout_ms for a capture completion, then consume the ones
+ * already signalled as well, up to max_done. num_done returns the number
+ * of completions consumed.
+ */
+struct vi_capture_status_list {
+	int32_t timeout_ms;
+	uint32_t max_done;
+	uint32_t num_done;
+	uint32_t __pad;
+} __VI_CAPTURE_ALIGN;
+
 struct vi_capture_progress_status_req {
 	uint32_t mem;
 	uint32_t mem_offset;
@@ -154,8 +185,15 @@ int vi_capture_control_message(struct tegra_vi_channel *chan,
 		struct vi_capture_control_msg *msg);
 int vi_capture_request(struct tegra_vi_channel *chan,
 		struct vi_capture_req *req);
+int vi_capture_request_list(struct tegra_vi_channel *chan,
+		struct vi_capture_req *reqs, uint32_t num_requests);
 int vi_capture_status(struct tegra_vi_channel *chan,
 		int32_t timeout_ms);
+int vi_capture_status_list(struct tegra_vi_channel *chan,
+		struct vi_capture_status_list *req);
+bool vi_capture_status_poll(struct tegra_vi_channel *chan);
+int vi_capture_set_status_notify(struct tegra_vi_channel *chan,
+		void (*notify)(void *data), void *data);
 int vi_capture_set_compand(struct tegra_vi_channel *chan,
 		struct vi_capture_compand *compand);
 long vi_capture_ioctl(struct file *file, void *fh,
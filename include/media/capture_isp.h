@@ -94,6 +94,32 @@ struct isp_buffer_req {
 	uint32_t flag;
 } __ISP_CAPTURE_ALIGN;
 
+/* Number of buffer sets which can be registered on an ISP channel */
+#define ISP_CAPTURE_MAX_BUFFER_SETS	16U
+
+#define ISP_BUFFER_SET_REGISTER		0U
+#define ISP_BUFFER_SET_UNREGISTER	1U
+
+/*
+ * Register the surfaces referenced by the capture descriptor at
+ * buffer_index as buffer set set_index. The surfaces stay pinned until
+ * the set is unregistered or the channel is released, and requests
+ * submitted with ISP_CAPTURE_REQUEST_SET reuse the pinned memory info
+ * instead of pinning the descriptor surfaces again.
+ */
+struct isp_buffer_set_req {
+	uint32_t set_index;
+	uint32_t buffer_index;
+	uint32_t flag;
+	uint32_t __pad;
+} __ISP_CAPTURE_ALIGN;
+
+struct isp_capture_req_set {
+	struct isp_capture_req capture_req;
+	uint32_t set_index;
+	uint32_t __pad[3];
+} __ISP_CAPTURE_ALIGN;
+
 int isp_capture_init(struct tegra_isp_channel *chan);
 void isp_capture_shutdown(struct tegra_isp_channel *chan);
 int isp_capture_setup(struct tegra_isp_channel *chan,
@@ -117,4 +143,8 @@ int isp_capture_set_progress_status_notifier(struct tegra_isp_channel *chan,
 		struct isp_capture_progress_status_req *req);
 int isp_capture_buffer_request(
 	struct tegra_isp_channel *chan, struct isp_buffer_req *req);
+int isp_capture_buffer_set(struct tegra_isp_channel *chan,
+		struct isp_buffer_set_req *req);
+int isp_capture_request_set(struct tegra_isp_channel *chan,
+		struct isp_capture_req_set *req);
 #endif
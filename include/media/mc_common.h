@@ -73,6 +73,7 @@ enum interlaced_type {
  * @chan: channel that uses the buffer
  * @vb2_state: V4L2 buffer state (active, done, error)
  * @capture_descr_index: Index into the VI capture descriptor queue
+ * @capture_ports_done: Mask of the ports which reported the capture status
  * @addr: Tegra IOVA buffer address for VI output
  */
 struct tegra_channel_buffer {
@@ -82,17 +83,75 @@ struct tegra_channel_buffer {
 
 	unsigned int vb2_state;
 	unsigned int capture_descr_index[TEGRA_CSI_BLOCKS];
+	unsigned int capture_ports_done;
 
 	dma_addr_t addr;
 
 	u32 thresh[TEGRA_CSI_BLOCKS];
 	int version;
 	int state;
+
+	/* frame timeline, see tegra_channel_frame_timeline */
+	u32 frame_id;
+	u64 sof_ts;
+	u64 eof_ts;
+	u64 done_ts;
 };
 
 #define to_tegra_channel_buffer(vb) \
 	container_of(vb, struct tegra_channel_buffer, buf)
 
+/**
+ * struct tegra_channel_frame - completed frame handed to a channel sink
+ * @buf: channel buffer holding the frame
+ * @addr: IOVA of the frame for the VI device
+ * @size: size of the frame in bytes
+ * @sequence: V4L2 sequence number of the frame
+ */
+struct tegra_channel_frame {
+	struct tegra_channel_buffer *buf;
+	dma_addr_t addr;
+	unsigned int size;
+	unsigned int sequence;
+};
+
+/**
+ * struct tegra_channel_sink_ops - in-kernel consumer of a video channel
+ * @frame_done: called from the capture completion path for every frame
+ *              captured without error. Returning true keeps the buffer
+ *              away from videobuf2 until the consumer hands it back with
+ *              tegra_channel_sink_release(). Must not sleep for long.
+ */
+struct tegra_channel_sink_ops {
+	bool (*frame_done)(void *priv, const struct tegra_channel_frame *frame);
+};
+
+/**
+ * struct tegra_channel_stats - capture statistics of a streaming session
+ * @lock: protects the counters
+ * @frames: frames captured without error
+ * @errors: frames completed with an uncorrectable error
+ * @discarded: frames dropped for a correctable error
+ * @missed: frames skipped by the capture engine, from frame id gaps
+ * @last_frame_id: frame id of the last good frame
+ * @first_sof_ts: start of frame of the first good frame, in ns
+ * @last_sof_ts: start of frame of the last good frame, in ns
+ * @latency_sum: sum of end of frame to buffer done latencies, in ns
+ * @latency_max: largest end of frame to buffer done latency, in ns
+ */
+struct tegra_channel_stats {
+	spinlock_t lock;
+	u64 frames;
+	u64 errors;
+	u64 discarded;
+	u64 missed;
+	u32 last_frame_id;
+	u64 first_sof_ts;
+	u64 last_sof_ts;
+	u64 latency_sum;
+	u64 latency_max;
+};
+
 /**
  * struct tegra_vi_graph_entity - Entity in the video graph
  * @list: list entry in a graph entities list
@@ -149,6 +208,17 @@ struct tegra_vi_graph_entity {
  *                   processed by the receive thread.
  * @capture_version: thread-local copy of @restart_version created when the
  *                   capture thread resets the VI.
+ * @capture_enqueue_work: submits queued buffers to the capture channel
+ * @capture_dequeue_work: completes buffers, run on capture status events
+ * @capture_timeout_work: flags an error when no status arrives in time
+ * @capture_work_active: the capture works may be queued, protected by
+ *                       @capture_state_lock
+ * @sink_ops: in-kernel consumer linked to the channel, only changed while
+ *            the channel is not streaming
+ * @sink_priv: context of @sink_ops
+ * @sink_held: buffers held by the consumer
+ * @sink_wait: wait queue for buffers released by the consumer
+ * @stats: capture statistics, reset when streaming starts
  */
 struct tegra_channel {
 	int id;
@@ -195,6 +265,15 @@ struct tegra_channel {
 	wait_queue_head_t release_wait;
 	struct task_struct *kthread_capture_dequeue;
 	wait_queue_head_t dequeue_wait;
+	struct work_struct capture_enqueue_work;
+	struct work_struct capture_dequeue_work;
+	struct delayed_work capture_timeout_work;
+	bool capture_work_active;
+	const struct tegra_channel_sink_ops *sink_ops;
+	void *sink_priv;
+	atomic_t sink_held;
+	wait_queue_head_t sink_wait;
+	struct tegra_channel_stats stats;
 	struct vb2_queue queue;
 	void *alloc_ctx;
 	bool init_done;
@@ -386,6 +465,17 @@ struct tegra_channel_buffer *dequeue_buffer(struct tegra_channel *chan,
 	bool requeue);
 struct tegra_channel_buffer *dequeue_dequeue_buffer(struct tegra_channel *chan);
 int tegra_channel_error_recover(struct tegra_channel *chan, bool queue_error);
+struct tegra_channel *tegra_channel_from_file(struct file *file);
+int tegra_channel_link_sink(struct tegra_channel *chan,
+		const struct tegra_channel_sink_ops *ops, void *priv);
+int tegra_channel_unlink_sink(struct tegra_channel *chan);
+bool tegra_channel_sink_frame_done(struct tegra_channel *chan,
+		struct tegra_channel_buffer *buf);
+void tegra_channel_sink_release(struct tegra_channel_buffer *buf);
+void tegra_channel_sink_drain(struct tegra_channel *chan);
+void tegra_channel_stats_reset(struct tegra_channel *chan);
+void tegra_channel_stats_update(struct tegra_channel *chan,
+		struct tegra_channel_buffer *buf);
 int tegra_channel_alloc_buffer_queue(struct tegra_channel *chan,
 					unsigned int num_buffers);
 void tegra_channel_dealloc_buffer_queue(struct tegra_channel *chan);
@@ -411,6 +501,7 @@ struct tegra_vi_fops {
 	int (*vi_setup_queue)(struct tegra_channel *chan,
 			unsigned int *nbuffers);
 	int (*vi_error_recover)(struct tegra_channel *chan, bool queue_error);
+	void (*vi_buffer_queued)(struct tegra_channel *chan);
 	int (*vi_add_ctrls)(struct tegra_channel *chan);
 	void (*vi_init_video_formats)(struct tegra_channel *chan);
 	long (*vi_default_ioctl)(struct file *file, void *fh,
@@ -50,6 +50,42 @@ TRACE_EVENT(tegra_bwmgr_set_emc,
 	)
 );
 
+TRACE_EVENT(tegra_bwmgr_emc_transition,
+	TP_PROTO(
+		unsigned long old_rate,
+		unsigned long new_rate,
+		const char *client,
+		const char *req,
+		s64 latency_ns
+	),
+
+	TP_ARGS(old_rate, new_rate, client, req, latency_ns),
+
+	TP_STRUCT__entry(
+		__field(unsigned long, old_rate)
+		__field(unsigned long, new_rate)
+		__field(const char *, client)
+		__field(const char *, req)
+		__field(s64, latency_ns)
+	),
+
+	TP_fast_assign(
+		__entry->old_rate = old_rate;
+		__entry->new_rate = new_rate;
+		__entry->client = client;
+		__entry->req = req;
+		__entry->latency_ns = latency_ns;
+	),
+
+	TP_printk("emc rate %lu -> %lu, set by %s %s, took %lld ns",
+		__entry->old_rate,
+		__entry->new_rate,
+		__entry->client,
+		__entry->req,
+		__entry->latency_ns
+	)
+);
+
 TRACE_EVENT(tegra_bwmgr_update_efficiency,
 	TP_PROTO(
 		unsigned long cur_state,
@@ -136,6 +136,41 @@ DEFINE_EVENT(frame, tegra_channel_capture_done,
 	TP_PROTO(const char *str, struct timespec ts),
 	TP_ARGS(str, ts)
 );
+
+/*
+ * One record per frame dequeued by userspace, all times in ns of the
+ * capture timestamp clock: start and end of frame from the capture
+ * status, buffer done in the kernel and dequeue by the application.
+ */
+TRACE_EVENT(tegra_channel_frame_timeline,
+	TP_PROTO(const char *name, u32 sequence, u32 frame_id,
+		u64 sof_ts, u64 eof_ts, u64 done_ts, u64 dqbuf_ts),
+	TP_ARGS(name, sequence, frame_id, sof_ts, eof_ts, done_ts, dqbuf_ts),
+	TP_STRUCT__entry(
+		__string(name,		name)
+		__field(u32,		sequence)
+		__field(u32,		frame_id)
+		__field(u64,		sof_ts)
+		__field(u64,		eof_ts)
+		__field(u64,		done_ts)
+		__field(u64,		dqbuf_ts)
+	),
+	TP_fast_assign(
+		__assign_str(name, name);
+		__entry->sequence = sequence;
+		__entry->frame_id = frame_id;
+		__entry->sof_ts = sof_ts;
+		__entry->eof_ts = eof_ts;
+		__entry->done_ts = done_ts;
+		__entry->dqbuf_ts = dqbuf_ts;
+	),
+	TP_printk("%s seq %u frame %u sof %llu eof +%lld done +%lld dqbuf +%lld",
+		  __get_str(name), __entry->sequence, __entry->frame_id,
+		  __entry->sof_ts,
+		  (s64)(__entry->eof_ts - __entry->sof_ts),
+		  (s64)(__entry->done_ts - __entry->eof_ts),
+		  (s64)(__entry->dqbuf_ts - __entry->done_ts))
+);
 #endif
 
 /* This part must be outside protection */
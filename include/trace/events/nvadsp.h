@@ -0,0 +1,84 @@
+/*
+ * include/trace/events/nvadsp.h
+ *
+ * ADSP app load accounting logging to ftrace.
+ *
+ * Copyright (c) 2021, NVIDIA CORPORATION, All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ */
+
+#undef TRACE_SYSTEM
+#define TRACE_SYSTEM nvadsp
+
+#if !defined(_TRACE_NVADSP_H) || defined(TRACE_HEADER_MULTI_READ)
+#define _TRACE_NVADSP_H
+
+#include <linux/tracepoint.h>
+
+TRACE_EVENT(nvadsp_app_stats,
+	TP_PROTO(const char *name,
+		 u64 cycles,
+		 u32 mcps,
+		 u32 peak_mcps,
+		 u32 msgq_lat_us,
+		 u32 msgq_lat_max_us),
+
+	TP_ARGS(name, cycles, mcps, peak_mcps, msgq_lat_us, msgq_lat_max_us),
+
+	TP_STRUCT__entry(
+		__string(name, name)
+		__field(u64, cycles)
+		__field(u32, mcps)
+		__field(u32, peak_mcps)
+		__field(u32, msgq_lat_us)
+		__field(u32, msgq_lat_max_us)
+	),
+
+	TP_fast_assign(
+		__assign_str(name, name);
+		__entry->cycles = cycles;
+		__entry->mcps = mcps;
+		__entry->peak_mcps = peak_mcps;
+		__entry->msgq_lat_us = msgq_lat_us;
+		__entry->msgq_lat_max_us = msgq_lat_max_us;
+	),
+
+	TP_printk("app=%s cycles=%llu mcps=%u peak_mcps=%u msgq_lat=%uus msgq_lat_max=%uus",
+		__get_str(name), __entry->cycles, __entry->mcps,
+		__entry->peak_mcps, __entry->msgq_lat_us,
+		__entry->msgq_lat_max_us)
+);
+
+TRACE_EVENT(nvadsp_load,
+	TP_PROTO(u32 mcps, u32 peak_mcps, u32 freq_mhz),
+
+	TP_ARGS(mcps, peak_mcps, freq_mhz),
+
+	TP_STRUCT__entry(
+		__field(u32, mcps)
+		__field(u32, peak_mcps)
+		__field(u32, freq_mhz)
+	),
+
+	TP_fast_assign(
+		__entry->mcps = mcps;
+		__entry->peak_mcps = peak_mcps;
+		__entry->freq_mhz = freq_mhz;
+	),
+
+	TP_printk("mcps=%u peak_mcps=%u freq=%uMHz",
+		__entry->mcps, __entry->peak_mcps, __entry->freq_mhz)
+);
+
+#endif /* _TRACE_NVADSP_H */
+
+/* This part must be outside protection */
+#include <trace/define_trace.h>
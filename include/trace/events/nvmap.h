@@ -792,6 +792,54 @@ TRACE_EVENT(nvmap_pp_fill_zero_lots,
 		__entry->nr - __entry->ret)
 );
 
+TRACE_EVENT(nvmap_alloc_latency,
+	TP_PROTO(size_t size, u32 src, u64 ns),
+
+	TP_ARGS(size, src, ns),
+
+	TP_STRUCT__entry(
+		__field(size_t, size)
+		__field(u32, src)
+		__field(u64, ns)
+	),
+
+	TP_fast_assign(
+		__entry->size = size;
+		__entry->src = src;
+		__entry->ns = ns;
+	),
+
+	TP_printk("size=%zu src=%s latency=%lluns",
+		__entry->size,
+		__print_symbolic(__entry->src,
+			{0, "pool"}, {1, "page"}, {2, "carveout"}),
+		__entry->ns)
+);
+
+TRACE_EVENT(nvmap_carveout_frag,
+	TP_PROTO(const char *name, size_t free, size_t largest, u32 holes),
+
+	TP_ARGS(name, free, largest, holes),
+
+	TP_STRUCT__entry(
+		__string(name, name)
+		__field(size_t, free)
+		__field(size_t, largest)
+		__field(u32, holes)
+	),
+
+	TP_fast_assign(
+		__assign_str(name, name);
+		__entry->free = free;
+		__entry->largest = largest;
+		__entry->holes = holes;
+	),
+
+	TP_printk("heap=%s free=%zu largest_free=%zu holes=%u",
+		__get_str(name), __entry->free, __entry->largest,
+		__entry->holes)
+);
+
 #endif /* _TRACE_NVMAP_H */
 
 /* This part must be outside protection */
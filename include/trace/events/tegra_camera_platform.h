@@ -0,0 +1,76 @@
+/*
+ * include/trace/events/tegra_camera_platform.h
+ *
+ * tegra camera platform bandwidth logging to ftrace.
+ *
+ * Copyright (c) 2021, NVIDIA CORPORATION, All rights reserved.
+ *
+ * This software is licensed under the terms of the GNU General Public
+ * License version 2, as published by the Free Software Foundation, and
+ * may be copied, distributed, and modified under those terms.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ */
+
+#undef TRACE_SYSTEM
+#define TRACE_SYSTEM tegra_camera_platform
+
+#if !defined(_TRACE_TEGRA_CAMERA_PLATFORM_H) || \
+	defined(TRACE_HEADER_MULTI_READ)
+#define _TRACE_TEGRA_CAMERA_PLATFORM_H
+
+#include <linux/tracepoint.h>
+
+TRACE_EVENT(tegra_camera_isobw_request,
+	TP_PROTO(u64 bw, u64 cur_bw, bool deferred),
+
+	TP_ARGS(bw, cur_bw, deferred),
+
+	TP_STRUCT__entry(
+		__field(u64, bw)
+		__field(u64, cur_bw)
+		__field(bool, deferred)
+	),
+
+	TP_fast_assign(
+		__entry->bw = bw;
+		__entry->cur_bw = cur_bw;
+		__entry->deferred = deferred;
+	),
+
+	TP_printk("bw=%lluKB cur_bw=%lluKB%s",
+		__entry->bw, __entry->cur_bw,
+		__entry->deferred ? " deferred" : "")
+);
+
+TRACE_EVENT(tegra_camera_isobw_set,
+	TP_PROTO(u64 old_bw, u64 bw, unsigned int lt, int ret),
+
+	TP_ARGS(old_bw, bw, lt, ret),
+
+	TP_STRUCT__entry(
+		__field(u64, old_bw)
+		__field(u64, bw)
+		__field(unsigned int, lt)
+		__field(int, ret)
+	),
+
+	TP_fast_assign(
+		__entry->old_bw = old_bw;
+		__entry->bw = bw;
+		__entry->lt = lt;
+		__entry->ret = ret;
+	),
+
+	TP_printk("old_bw=%lluKB bw=%lluKB lt=%uus ret=%d",
+		__entry->old_bw, __entry->bw, __entry->lt, __entry->ret)
+);
+
+#endif /* _TRACE_TEGRA_CAMERA_PLATFORM_H */
+
+/* This part must be outside protection */
+#include <trace/define_trace.h>
@@ -30,6 +30,7 @@ extern "C" {
 #define DRM_TEGRA_UDRM_DROP_MASTER_NOTIFY       0x04
 #define DRM_TEGRA_UDRM_SET_MASTER_NOTIFY        0x05
 #define DRM_TEGRA_UDRM_SEND_CONNECTOR_STATUS_EVENT 0x06
+#define DRM_TEGRA_UDRM_QUEUE_VBLANK_EVENT       0x07
 
 struct drm_tegra_udrm_dmabuf_mmap {
 	int fd;
@@ -64,6 +65,12 @@ struct drm_tegra_udrm_connector_status_event {
 	uint32_t prop_id;
 };
 
+struct drm_tegra_udrm_queue_vblank_event {
+	uint32_t head;
+	uint32_t reserved;
+	uint64_t user_data;
+};
+
 #define TEGRA_UDRM_IOCTL(dir, name, str) \
 	DRM_##dir(DRM_COMMAND_BASE + DRM_TEGRA_UDRM_##name, \
 		struct drm_tegra_udrm_##str)
@@ -138,6 +145,21 @@ struct drm_tegra_udrm_connector_status_event {
 	TEGRA_UDRM_IOCTL(IOW, SEND_CONNECTOR_STATUS_EVENT, \
 		connector_status_event)
 
+/* DRM clients issue this ioctl to get a DRM_EVENT_VBLANK at the next
+ * vblank of a display head, straight from the display interrupt rather
+ * than relayed by UMD with DRM_IOCTL_TEGRA_UDRM_SEND_VBLANK_EVENT. All
+ * the events queued for a vblank are delivered together. sequence
+ * counts the vblanks seen by the driver on that head, tv_sec/tv_usec
+ * are the CLOCK_MONOTONIC start of vblank.
+ *
+ * In parameters -
+ *    head: display head, i.e. 0 for fb0, 1 for fb1 etc.
+ *    reserved: must be 0.
+ *    user_data: returned in the event.
+ */
+#define DRM_IOCTL_TEGRA_UDRM_QUEUE_VBLANK_EVENT \
+	TEGRA_UDRM_IOCTL(IOW, QUEUE_VBLANK_EVENT, queue_vblank_event)
+
 #if defined(__cplusplus)
 }
 #endif
@@ -133,6 +133,39 @@ struct nvhost_pva_task_state {
 	__u32 operation;
 } __packed;
 
+/* Per-task performance record, emitted on task completion */
+struct nvhost_task_perf {
+	/* Engine class ID */
+	__u32 class_id;
+
+	/* Syncpoint ID */
+	__u32 syncpt_id;
+
+	/* Threshold for task completion */
+	__u32 syncpt_thresh;
+
+	/* Reserved */
+	__u32 reserved;
+
+	/* Submit time in TSC ticks */
+	__u64 submit_time;
+
+	/* Firmware start time in TSC ticks */
+	__u64 start_time;
+
+	/* Firmware end time in TSC ticks */
+	__u64 end_time;
+
+	/* Ticks between submit and start */
+	__u64 queue_wait;
+
+	/* Engine clock cycles spent on the task */
+	__u64 engine_cycles;
+
+	/* Bytes moved by the engine DMA, 0 if unknown */
+	__u64 dma_bytes;
+} __packed;
+
 enum {
 	/* struct nvhost_task_submit */
 	NVHOST_TASK_SUBMIT = 0,
@@ -161,11 +194,55 @@ enum {
 	NVHOST_PVA_POST_BEGIN = 14,
 	NVHOST_PVA_POST_END = 15,
 
-	NVHOST_NUM_EVENT_TYPES = 16
+	/* struct nvhost_task_perf */
+	NVHOST_TASK_PERF = 16,
+
+	NVHOST_NUM_EVENT_TYPES = 17
 };
 
 enum {
 	NVHOST_NUM_CUSTOM_FILTER_FLAGS = 0
 };
 
+/*
+ * The same records are also kept in a per-engine ring that user space maps
+ * from the task_perf debugfs file of the engine. The ring starts with this
+ * header followed by num_entries struct nvhost_task_perf_record. Record n is
+ * stored at index n % num_entries; its seq reads n + 1 once complete and 0
+ * while it is being written.
+ */
+#define NVHOST_TASK_PERF_RING_MAGIC	0x50455246	/* "PERF" */
+
+struct nvhost_task_perf_ring_header {
+	__u32 magic;
+	__u32 num_entries;
+	__u32 entry_size;
+	__u32 reserved;
+
+	/* Number of records written so far */
+	__u64 write_seq;
+} __packed;
+
+struct nvhost_task_perf_record {
+	__u64 seq;
+	struct nvhost_task_perf perf;
+} __packed;
+
+/*
+ * Firmware trace streams are byte rings that can be read or mapped from the
+ * firmware trace_stream debugfs file of an engine. The mapping starts with
+ * this header followed by size bytes of data. Byte n of the stream is
+ * stored at offset n % size of the data; write_pos is the number of bytes
+ * written so far.
+ */
+#define NVHOST_TRACE_STREAM_MAGIC	0x54525354	/* "TSRT" */
+
+struct nvhost_trace_stream_header {
+	__u32 magic;
+	__u32 size;
+	__u64 write_pos;
+	__u64 dropped;
+	__u64 reserved;
+} __packed;
+
 #endif /* NVHOST_EVENTS_H */
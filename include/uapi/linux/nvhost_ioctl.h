@@ -231,6 +231,33 @@ struct nvhost_submit_args {
 	__u64 fences;
 };
 
+#define NVHOST_SUBMIT_BATCH_MAX		16
+
+/*
+ * Submit num_submits jobs to a channel in one call. depends, if set, points
+ * to an array of num_submits indices: entry i names an earlier submit in the
+ * batch whose syncpoint increments submit i waits for, or -1 for none.
+ * Fences are returned in each submit's own arguments.
+ */
+struct nvhost_submit_batch_args {
+	__u64 submits;		/* Ptr to nvhost_submit_args array */
+	__u64 depends;		/* Ptr to __s32 array, or 0 */
+	__u32 num_submits;
+	__u32 reserved;
+};
+
+#define NVHOST_RECORD_CMDBUF_FLAG_REMOVE	(1 << 0)
+
+/*
+ * Register a command buffer whose relocation words are only written by the
+ * kernel. The values patched into a recorded buffer are remembered, and
+ * later submits leave words alone that already hold the right address.
+ */
+struct nvhost_record_cmdbuf_args {
+	__u32 mem;		/* dmabuf fd of the command buffer */
+	__u32 flags;		/* NVHOST_RECORD_CMDBUF_FLAG_* */
+};
+
 struct nvhost_set_ctxswitch_args {
 	__u32 num_cmdbufs_save;
 	__u32 num_save_incrs;
@@ -320,6 +347,10 @@ struct nvhost_channel_map_buffer_args {
 
 #define NVHOST_IOCTL_CHANNEL_SET_SYNCPOINT_NAME	\
 	_IOW(NVHOST_IOCTL_MAGIC, 30, struct nvhost_set_syncpt_name_args)
+#define NVHOST_IOCTL_CHANNEL_SUBMIT_BATCH	\
+	_IOW(NVHOST_IOCTL_MAGIC, 31, struct nvhost_submit_batch_args)
+#define NVHOST_IOCTL_CHANNEL_RECORD_CMDBUF	\
+	_IOW(NVHOST_IOCTL_MAGIC, 32, struct nvhost_record_cmdbuf_args)
 
 #define NVHOST_IOCTL_CHANNEL_SET_ERROR_NOTIFIER  \
 	_IOWR(NVHOST_IOCTL_MAGIC, 111, struct nvhost_set_error_notifier)
@@ -352,6 +383,9 @@ struct nvhost_ctrl_syncpt_waitex_args {
 	__u32 value;
 };
 
+/* busy-wait briefly before sleeping, for waits expected to be short */
+#define NVHOST_SYNCPT_WAIT_FLAG_LOW_LATENCY	(1 << 0)
+
 struct nvhost_ctrl_syncpt_waitmex_args {
 	__u32 id;
 	__u32 thresh;
@@ -360,7 +394,10 @@ struct nvhost_ctrl_syncpt_waitmex_args {
 	__u32 tv_sec;
 	__u32 tv_nsec;
 	__u32 clock_id;
-	__u32 reserved;
+	union {
+		__u32 reserved;
+		__u32 flags;		/* NVHOST_SYNCPT_WAIT_FLAG_* */
+	};
 };
 
 struct nvhost_ctrl_sync_fence_info {
@@ -416,6 +453,11 @@ struct nvhost_characteristics {
 #define NVHOST_CHARACTERISTICS_GFILTER (1 << 0)
 #define NVHOST_CHARACTERISTICS_RESOURCE_PER_CHANNEL_INSTANCE (1 << 1)
 #define NVHOST_CHARACTERISTICS_SUPPORT_PREFENCES (1 << 2)
+/*
+ * Syncpoint values can be read from a read only mmap of the ctrl node,
+ * at offset id * syncpt_shim_stride
+ */
+#define NVHOST_CHARACTERISTICS_SYNCPT_SHIM_MMAP (1 << 3)
 	__u64 flags;
 
 	__u32 num_mlocks;
@@ -426,6 +468,10 @@ struct nvhost_characteristics {
 
 	__u32 num_hw_pts;
 	__u32 padding;
+
+	__u64 syncpt_shim_size;
+	__u32 syncpt_shim_stride;
+	__u32 padding2;
 };
 
 struct nvhost_ctrl_get_characteristics {
@@ -40,6 +40,29 @@ struct nvdla_queue_status_args {
 	__u64 status;
 };
 
+/**
+ * struct nvdla_queue_priority_args strcture
+ *
+ * @priority		scheduling priority of the queue
+ * @reserved		reserved for future use, must be 0
+ *
+ * When a task of a queue is submitted, the busy queues of lower priority on
+ * the same engine are suspended, so the engine picks the task up as soon as
+ * the running task completes. They are resumed once no task of a higher
+ * priority is outstanding. Queues the task waits on through a syncpoint
+ * prefence are never suspended. Only CAP_SYS_NICE may select
+ * NVDLA_QUEUE_PRIORITY_HIGH.
+ *
+ */
+struct nvdla_queue_priority_args {
+#define NVDLA_QUEUE_PRIORITY_LOW	0
+#define NVDLA_QUEUE_PRIORITY_NORMAL	1
+#define NVDLA_QUEUE_PRIORITY_HIGH	2
+#define NVDLA_QUEUE_PRIORITY_NUM	3
+	__u32 priority;
+	__u32 reserved;
+};
+
 /**
  * struct nvdla_ping_args structure for ping data
  *
@@ -90,6 +113,8 @@ struct nvdla_pin_unpin_args {
  * @flags		flags for task submit, like atomic
  * @version		version of task structure
  *
+ * With NVDLA_IOCTL_SUBMIT_BATCH all tasks are prepared before any of them is
+ * submitted, and a failure while preparing one drops the whole list.
  */
 struct nvdla_submit_args {
 	__u64 tasks;
@@ -134,6 +159,40 @@ struct nvdla_mem_handle {
 	__u32 offset;
 };
 
+/**
+ * struct nvdla_mem_patch structure for overriding a template address
+ *
+ * @index		index in the template address list
+ * @handle		handle to buffer allocated in userspace
+ * @offset		offset in buffer
+ * @reserved		reserved for future use
+ *
+ */
+struct nvdla_mem_patch {
+	__u32 index;
+	__u32 handle;
+	__u32 offset;
+	__u32 reserved;
+};
+
+/**
+ * struct nvdla_task_template_args structure for registering a task template
+ *
+ * @address_list	pointer to struct nvdla_mem_handle list of the network
+ * @num_addresses	number of entries in the address list
+ * @flags		NVDLA_TASK_TEMPLATE_FLAGS_REMOVE drops the template
+ *
+ * The buffers of the list must already be pinned with NVDLA_IOCTL_PIN. They
+ * stay referenced until the template is replaced, removed or the queue is
+ * released.
+ */
+struct nvdla_task_template_args {
+	__u64 address_list;
+	__u32 num_addresses;
+#define NVDLA_TASK_TEMPLATE_FLAGS_REMOVE	(1 << 0)
+	__u32 flags;
+};
+
 /**
  * struct nvdla_ioctl_submit_task structure for single task information
  *
@@ -157,6 +216,16 @@ struct nvdla_mem_handle {
  * @address_list		pointer to address list
  * @timeout			task timeout
  *
+ * With NVDLA_TASK_FLAGS_USE_TEMPLATE set in @flags, the address list is taken
+ * from the template registered on the queue and @address_list instead points
+ * to @num_addresses struct nvdla_mem_patch entries overriding single slots of
+ * it; @num_addresses may then be zero.
+ *
+ * With NVDLA_TASK_FLAGS_ANY_INSTANCE set in @flags, the task may run on any
+ * DLA instance and is dispatched to the least loaded one. Its fences then
+ * refer to the syncpoint of that instance. Tasks without the flag, and
+ * template based tasks, always run on the instance the file was opened on.
+ *
  */
 struct nvdla_ioctl_submit_task {
 	__u8 num_prefences;
@@ -169,6 +238,8 @@ struct nvdla_ioctl_submit_task {
 	__u8 reserved0[1];
 #define NVDLA_MAX_BUFFERS_PER_TASK (6144)
 	__u32 num_addresses;
+#define NVDLA_TASK_FLAGS_USE_TEMPLATE	(1 << 0)
+#define NVDLA_TASK_FLAGS_ANY_INSTANCE	(1 << 1)
 	__u16 flags;
 	__u16 reserved1;
 
@@ -258,8 +329,14 @@ struct nvdla_status_notify {
 	_IO(NVHOST_NVDLA_IOCTL_MAGIC, 9)
 #define NVDLA_IOCTL_RELEASE_QUEUE \
 	_IO(NVHOST_NVDLA_IOCTL_MAGIC, 10)
+#define NVDLA_IOCTL_SET_TASK_TEMPLATE \
+	_IOW(NVHOST_NVDLA_IOCTL_MAGIC, 11, struct nvdla_task_template_args)
+#define NVDLA_IOCTL_SUBMIT_BATCH \
+	_IOW(NVHOST_NVDLA_IOCTL_MAGIC, 12, struct nvdla_submit_args)
+#define NVDLA_IOCTL_SET_QUEUE_PRIORITY \
+	_IOW(NVHOST_NVDLA_IOCTL_MAGIC, 13, struct nvdla_queue_priority_args)
 #define NVDLA_IOCTL_LAST		\
-		_IOC_NR(NVDLA_IOCTL_RELEASE_QUEUE)
+		_IOC_NR(NVDLA_IOCTL_SET_QUEUE_PRIORITY)
 
 #define NVDLA_IOCTL_MAX_ARG_SIZE  \
 		sizeof(struct nvdla_pin_unpin_args)
@@ -89,6 +89,14 @@ struct pva_pin_unpin_args {
 
 #define PVA_MAX_PIN_BUFFERS	64
 
+/*
+ * PVA_IOCTL_REGISTER pins the dmabuf fds of the table once and replaces them
+ * in place by registered handles, which have PVA_REGISTERED_HANDLE set. Such
+ * a handle can be used wherever a task takes a buffer handle and is released
+ * with PVA_IOCTL_UNREGISTER.
+ */
+#define PVA_REGISTERED_HANDLE	(1U << 31)
+
 /**
  * struct pva_memory_handle - A handle to PVA pointer
  *
@@ -344,6 +352,68 @@ struct pva_ioctl_rate {
 	__u32 reserved;
 };
 
+/*
+ * Submit ring: instead of passing tasks through PVA_IOCTL_SUBMIT, user space
+ * may write them into a ring that is shared with the kernel. The ring is
+ * created with PVA_IOCTL_SET_SUBMIT_RING and mapped by calling mmap() on the
+ * PVA file at offset 0. It starts with struct pva_submit_ring_header followed
+ * by num_entries struct pva_submit_ring_entry.
+ *
+ * In an entry, the array fields of the task (pointers, prefences,
+ * input_surfaces, primary_payload, output_surfaces, num_pva_ts_buffers,
+ * num_pvafences, pvafences, input_task_status and output_task_status) hold
+ * byte offsets into data[] rather than user pointers. Post-fences are
+ * written back to the pvafences area of the entry.
+ *
+ * Entries are produced at free running indices; entry n is stored at index
+ * n % num_entries. PVA_IOCTL_RING_DOORBELL hands the entries up to the given
+ * head over to the kernel, which validates and submits them in order and
+ * advances tail past every entry it has processed. The result of each
+ * entry is stored in its status field.
+ */
+#define PVA_SUBMIT_RING_MAGIC		0x50565152	/* "PVQR" */
+#define PVA_SUBMIT_RING_MAX_ENTRIES	64
+#define PVA_SUBMIT_RING_ENTRY_SIZE	8192
+
+struct pva_submit_ring_header {
+	__u32 magic;
+	__u32 num_entries;
+	__u32 entry_size;
+	__u32 tail;
+	__u32 reserved[4];
+};
+
+struct pva_submit_ring_entry {
+	struct pva_ioctl_submit_task task;
+	__s32 status;
+	__u32 reserved;
+	__u8 data[PVA_SUBMIT_RING_ENTRY_SIZE -
+		  sizeof(struct pva_ioctl_submit_task) - 8];
+};
+
+/**
+ * struct pva_ioctl_submit_ring - create or destroy the submit ring
+ *
+ * @num_entries: Number of ring entries, a power of two no larger than
+ *		 PVA_SUBMIT_RING_MAX_ENTRIES. 0 destroys the ring.
+ * @reserved: Reserved for future usage. Must be 0.
+ */
+struct pva_ioctl_submit_ring {
+	__u32 num_entries;
+	__u32 reserved;
+};
+
+/**
+ * struct pva_ioctl_ring_doorbell - submit the pending ring entries
+ *
+ * @head: Index one past the last entry written by user space
+ * @tail: Returns the index of the first entry not yet consumed
+ */
+struct pva_ioctl_ring_doorbell {
+	__u32 head;
+	__u32 tail;
+};
+
 #define PVA_IOCTL_CHARACTERISTICS	\
 	_IOWR(NVHOST_PVA_IOCTL_MAGIC, 1, struct pva_characteristics_req)
 #define PVA_IOCTL_PIN	\
@@ -362,7 +432,17 @@ struct pva_ioctl_rate {
 	_IOWR(NVHOST_PVA_IOCTL_MAGIC, 8, struct pva_ioctl_rate)
 
 
-#define NVHOST_PVA_IOCTL_LAST _IOC_NR(PVA_IOCTL_GET_RATE)
+#define PVA_IOCTL_REGISTER	\
+	_IOW(NVHOST_PVA_IOCTL_MAGIC, 9, struct pva_pin_unpin_args)
+#define PVA_IOCTL_UNREGISTER	\
+	_IOW(NVHOST_PVA_IOCTL_MAGIC, 10, struct pva_pin_unpin_args)
+
+#define PVA_IOCTL_SET_SUBMIT_RING	\
+	_IOW(NVHOST_PVA_IOCTL_MAGIC, 11, struct pva_ioctl_submit_ring)
+#define PVA_IOCTL_RING_DOORBELL	\
+	_IOWR(NVHOST_PVA_IOCTL_MAGIC, 12, struct pva_ioctl_ring_doorbell)
+
+#define NVHOST_PVA_IOCTL_LAST _IOC_NR(PVA_IOCTL_RING_DOORBELL)
 #define NVHOST_PVA_IOCTL_MAX_ARG_SIZE sizeof(struct pva_characteristics_req)
 
 #endif /* __LINUX_NVHOST_PVA_IOCTL_H */
@@ -0,0 +1,73 @@
+/*
+ * include/uapi/linux/nvhvivc_cdev_ioctl.h
+ *
+ * Declarations for Tegra Hypervisor ivc character device ioctls
+ *
+ * Copyright (c) 2021 NVIDIA CORPORATION.  All rights reserved.
+ *
+ * This file is licensed under the terms of the GNU General Public License
+ * version 2.  This program is licensed "as is" without any warranty of any
+ * kind, whether express or implied.
+ *
+ */
+#ifndef __UAPI_NVHVIVC_CDEV_IOCTL_H__
+#define __UAPI_NVHVIVC_CDEV_IOCTL_H__
+
+#include <linux/ioctl.h>
+#include <linux/types.h>
+
+/* ivc cdev IOCTL magic number */
+#define TEGRA_IVC_IOCTL_MAGIC 0xA7
+
+/*
+ * Layout of the queue area as seen through mmap() of the ivc device.
+ * All offsets are relative to the start of the mapping.
+ */
+struct ivc_cdev_info {
+	__u32 nframes;
+	__u32 frame_size;
+	/* length to pass to mmap() */
+	__u32 mmap_size;
+	/* first frame of the rx and tx queues */
+	__u32 rx_frames_offset;
+	__u32 tx_frames_offset;
+	__u32 rsvd;
+};
+
+/*
+ * Frames that can be accessed in place. The frames, in order, are
+ * nr[0] frames at offset[0] followed by nr[1] frames at offset[1] when
+ * the ring wraps around.
+ */
+struct ivc_cdev_frames {
+	/* in: max frames wanted, out: frames owned by the caller */
+	__u32 count;
+	__u32 nr[2];
+	__u32 offset[2];
+};
+
+/* IOCTL definitions */
+
+/* query the queue layout */
+#define TEGRA_IVC_IOCTL_GET_INFO \
+	_IOR(TEGRA_IVC_IOCTL_MAGIC, 1, struct ivc_cdev_info)
+
+/* get frames received, fails with EAGAIN when there are none */
+#define TEGRA_IVC_IOCTL_READ_GET_FRAMES \
+	_IOWR(TEGRA_IVC_IOCTL_MAGIC, 2, struct ivc_cdev_frames)
+
+/* release the given number of frames read, notifies the peer */
+#define TEGRA_IVC_IOCTL_READ_ADVANCE \
+	_IOW(TEGRA_IVC_IOCTL_MAGIC, 3, __u32)
+
+/* get free frames to transmit, fails with EAGAIN when there are none */
+#define TEGRA_IVC_IOCTL_WRITE_GET_FRAMES \
+	_IOWR(TEGRA_IVC_IOCTL_MAGIC, 4, struct ivc_cdev_frames)
+
+/* send the given number of frames written, notifies the peer */
+#define TEGRA_IVC_IOCTL_WRITE_ADVANCE \
+	_IOW(TEGRA_IVC_IOCTL_MAGIC, 5, __u32)
+
+#define TEGRA_IVC_IOCTL_NUMBER_MAX 5
+
+#endif /* __UAPI_NVHVIVC_CDEV_IOCTL_H__ */
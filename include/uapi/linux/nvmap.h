@@ -235,6 +235,48 @@ struct nvmap_cache_op_list {
 	__s32 op;		/* wb/wb_inv/inv */
 };
 
+/*
+ * Asynchronous variant of nvmap_cache_op_list. offsets and sizes always
+ * point to __u64 arrays. Maintenance starts once in_fence (a sync_file fd,
+ * or -1) has signalled; out_fence returns a sync_file fd which signals on
+ * completion.
+ */
+struct nvmap_cache_op_list_async {
+	__u64 handles;		/* Ptr to u32 type array, holding handles */
+	__u64 offsets;		/* Ptr to u64 type array, holding offsets
+				 * into handle mem */
+	__u64 sizes;		/* Ptr to u64 type array, holding sizes of
+				 * memory regions within each handle */
+	__u32 nr;		/* Number of handles */
+	__s32 op;		/* wb/wb_inv/inv */
+	__s32 in_fence;		/* fence to wait for before starting */
+	__s32 out_fence;	/* returns fence signalled when done */
+};
+
+/*
+ * One entry of NVMAP_IOC_ALLOC_BULK. size, heap_mask, flags and align have
+ * the same meaning as for NVMAP_IOC_CREATE_64 followed by NVMAP_IOC_ALLOC;
+ * handle returns the dma-buf fd of the new allocation.
+ */
+struct nvmap_alloc_bulk_entry {
+	__u64 size;
+	__u32 heap_mask;
+	__u32 flags;
+	__u32 align;
+	__s32 handle;		/* out: dmabuf fd */
+};
+
+/*
+ * Creates and allocates nr handles in one call. entries points to an array
+ * of struct nvmap_alloc_bulk_entry. Either every handle is created and its
+ * fd returned, or none are.
+ */
+struct nvmap_alloc_bulk {
+	__u64 entries;		/* Ptr to nvmap_alloc_bulk_entry array */
+	__u32 nr;		/* Number of entries */
+	__u32 reserved;
+};
+
 struct nvmap_debugfs_handles_header {
 	__u8 version;
 };
@@ -387,6 +429,11 @@ struct nvmap_handle_parameters {
 
 #define NVMAP_IOC_PARAMETERS \
 	_IOR(NVMAP_IOC_MAGIC, 27, struct nvmap_handle_parameters)
+#define NVMAP_IOC_CACHE_LIST_ASYNC \
+	_IOWR(NVMAP_IOC_MAGIC, 28, struct nvmap_cache_op_list_async)
+#define NVMAP_IOC_ALLOC_BULK \
+	_IOW(NVMAP_IOC_MAGIC, 29, struct nvmap_alloc_bulk)
+
 /* START of T124 IOCTLS */
 /* Actually allocates memory for the specified handle, with kind */
 #define NVMAP_IOC_ALLOC_KIND _IOW(NVMAP_IOC_MAGIC, 100, struct nvmap_alloc_kind_handle)
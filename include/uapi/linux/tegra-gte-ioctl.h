@@ -51,6 +51,22 @@ struct tegra_gte_hts_event_data {
 	int dir;
 };
 
+/**
+ * struct tegra_gte_hts_ring - event ring, mmap'd from the event fd
+ * @head: index of the next event the kernel writes, free running
+ * @tail: index of the next event to read, free running, updated by the reader
+ * @overflow: number of events dropped because the ring was full
+ * @entries: number of events the ring holds, set by the mapping size
+ * @events: event with index i is at events[i % entries]
+ */
+struct tegra_gte_hts_ring {
+	__u32 head;
+	__u32 tail;
+	__u32 overflow;
+	__u32 entries;
+	struct tegra_gte_hts_event_data events[];
+};
+
 /**
  * Event request IOCTL command
  */
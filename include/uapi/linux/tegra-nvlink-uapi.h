@@ -491,6 +491,29 @@ struct tegra_nvlink_set_topology_info {
 	__u32 remote_link_id;
 };
 
+/* TEGRA_CTRL_CMD_NVLINK_BW_TEST */
+#define TEGRA_CTRL_NVLINK_BW_TEST_MAX_SIZES		8U
+#define TEGRA_CTRL_NVLINK_BW_TEST_MAX_BYTES		(4U << 20)
+#define TEGRA_CTRL_NVLINK_BW_TEST_MAX_ITERATIONS	10000U
+
+/*
+ * Loopback read bandwidth, in MB/s, for each transfer size. The packet
+ * counts are the TL TX/RX packets seen during the whole test, to check the
+ * traffic did go over the link.
+ */
+struct tegra_nvlink_bw_test {
+	/* input fields */
+	__u32 num_sizes;
+	__u32 iterations;
+	__u32 sizes[TEGRA_CTRL_NVLINK_BW_TEST_MAX_SIZES];
+
+	/* output fields */
+	__u32 mbps[TEGRA_CTRL_NVLINK_BW_TEST_MAX_SIZES];
+	__u32 reserved;
+	__u64 tx_packets;
+	__u64 rx_packets;
+};
+
 /* Enum to represent IOCTLs inside the Tegra NVLINK driver */
 enum tnvlink_ioctl_num {
 	TNVLINK_IOCTL_GET_NVLINK_CAPS,
@@ -520,6 +543,7 @@ enum tnvlink_ioctl_num {
 	TNVLINK_IOCTL_SET_TOPOLOGY_INFO,
 	TNVLINK_IOCTL_INTERFACE_DISABLE,
 	TNVLINK_IOCTL_FINALIZE_SHUTDOWN,
+	TNVLINK_IOCTL_BW_TEST,
 	TNVLINK_IOCTL_NUM_IOCTLS
 };
 
@@ -630,5 +654,9 @@ enum tnvlink_ioctl_num {
 #define TEGRA_CTRL_CMD_NVLINK_FINALIZE_SHUTDOWN				\
 			_IO(TEGRA_NVLINK_IOC_MAGIC,			\
 				TNVLINK_IOCTL_FINALIZE_SHUTDOWN)
+#define TEGRA_CTRL_CMD_NVLINK_BW_TEST					\
+			_IOWR(TEGRA_NVLINK_IOC_MAGIC,			\
+				TNVLINK_IOCTL_BW_TEST,			\
+				struct tegra_nvlink_bw_test)
 
 #endif /* TEGRA_NVLINK_UAPI_H */
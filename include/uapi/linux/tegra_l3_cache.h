@@ -37,8 +37,11 @@ struct tegra_l3_ioctl_data {
 
 #define TEGRA_L3_CACHE_GET_IOCTL_DATA    \
 		_IOR(TEGRA_L3_CACHE_IOC_MAGIC, 1, struct tegra_l3_ioctl_data)
+/* sets igpu_cpu_ways and igpu_only_ways, needs CAP_SYS_ADMIN */
+#define TEGRA_L3_CACHE_SET_WAYS    \
+		_IOW(TEGRA_L3_CACHE_IOC_MAGIC, 2, struct tegra_l3_ioctl_data)
 
-#define TEGRA_L3_CACHE_IOCTL_IOC_MAXNR _IOC_NR(TEGRA_L3_CACHE_GET_IOCTL_DATA)
+#define TEGRA_L3_CACHE_IOCTL_IOC_MAXNR _IOC_NR(TEGRA_L3_CACHE_SET_WAYS)
 #define TEGRA_L3_CACHE_IOCTL_MAX_ARG_SIZE  \
 		sizeof(struct tegra_l3_ioctl_data)
 
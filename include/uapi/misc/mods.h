@@ -25,7 +25,7 @@
 
 /* Driver version */
 #define MODS_DRIVER_VERSION_MAJOR 3
-#define MODS_DRIVER_VERSION_MINOR 96
+#define MODS_DRIVER_VERSION_MINOR 97
 #define MODS_DRIVER_VERSION ((MODS_DRIVER_VERSION_MAJOR << 8) | \
 			     ((MODS_DRIVER_VERSION_MINOR/10) << 4) | \
 			     (MODS_DRIVER_VERSION_MINOR%10))
@@ -172,6 +172,22 @@ struct MODS_GET_PHYSICAL_ADDRESS_3 {
 	__u64                 physical_address;
 };
 
+#define MODS_GET_ADDR_RANGE_MAX 64
+
+/* MODS_ESC_GET_DMA_ADDRESSES */
+struct MODS_GET_ADDRESS_RANGE {
+	/* IN */
+	__u64                 memory_handle;
+	__u64                 offset;      /* of the first address */
+	__u64                 stride;      /* between addresses */
+	struct mods_pci_dev_2 pci_device;  /* 0 for physical addresses */
+	__u32                 num_entries; /* up to MODS_GET_ADDR_RANGE_MAX */
+	__u8                  reserved[4]; /* Alignment */
+
+	/* OUT */
+	__u64                 physical_addresses[MODS_GET_ADDR_RANGE_MAX];
+};
+
 /* MODS_ESC_VIRTUAL_TO_PHYSICAL */
 struct MODS_VIRTUAL_TO_PHYSICAL {
 	/* IN */
@@ -1490,5 +1506,8 @@ struct MODS_MSR {
 #define MODS_ESC_MAP_GPIO                  \
 		   _IOWR(MODS_IOC_MAGIC, 128,            \
 		   struct MODS_GPIO_INFO)
+#define MODS_ESC_GET_DMA_ADDRESSES		\
+		   _IOWR(MODS_IOC_MAGIC, 129,            \
+		   struct MODS_GET_ADDRESS_RANGE)
 
 #endif /* _UAPI_MODS_H_ */
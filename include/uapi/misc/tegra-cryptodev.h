@@ -148,6 +148,8 @@ struct tegra_pka1_rsa_request {
 		_IOWR(0x98, 106, struct tegra_pka1_rsa_request)
 
 int tegra_se_pka1_ecc_op(struct tegra_se_pka1_ecc_request *req);
+int tegra_se_pka1_ecc_op_batch(struct tegra_se_pka1_ecc_request *reqs,
+			       unsigned int nreqs);
 int tegra_se_rng1_op(struct tegra_se_rng1_request *req);
 
 /* a pointer to this struct needs to be passed to:
@@ -170,6 +172,60 @@ struct tegra_crypt_req {
 #define TEGRA_CRYPTO_IOCTL_PROCESS_REQ	\
 		_IOWR(0x98, 101, struct tegra_crypt_req)
 
+/*
+ * Asynchronous AES on user memory, without bounce buffers. The pages of
+ * src and dst are pinned and handed to the SE as they are.
+ *
+ * TEGRA_CRYPTO_IOCTL_ASYNC_SETUP selects the mode and key for the
+ * following operations of the file. It fails with -EBUSY while
+ * operations are in flight.
+ * TEGRA_CRYPTO_IOCTL_ASYNC_SUBMIT queues one operation and returns
+ * without waiting, or fails with -EAGAIN when
+ * TEGRA_CRYPTO_ASYNC_MAX_INFLIGHT operations are not reaped yet.
+ * TEGRA_CRYPTO_IOCTL_ASYNC_REAP fills completions with up to max
+ * finished operations, waiting for one unless TEGRA_CRYPTO_ASYNC_NONBLOCK
+ * is set. poll() reports POLLIN when completions are pending.
+ */
+#define TEGRA_CRYPTO_ASYNC_MAX_INFLIGHT	64
+#define TEGRA_CRYPTO_ASYNC_MAX_SIZE	(1024 * 1024)
+#define TEGRA_CRYPTO_ASYNC_NONBLOCK	(1 << 0)
+
+struct tegra_crypt_async_setup {
+	__u32 op; /* e.g. TEGRA_CRYPTO_CBC */
+	__u32 keylen;
+	__u8 key[TEGRA_CRYPTO_MAX_KEY_SIZE];
+};
+#define TEGRA_CRYPTO_IOCTL_ASYNC_SETUP	\
+		_IOW(0x98, 111, struct tegra_crypt_async_setup)
+
+struct tegra_crypt_async_op {
+	__u64 user_data; /* returned as is in the completion */
+	__u64 src;
+	__u64 dst; /* may be equal to src */
+	__u32 size;
+	__u8 encrypt;
+	__u8 reserved[3];
+	__u8 iv[TEGRA_CRYPTO_IV_SIZE];
+};
+#define TEGRA_CRYPTO_IOCTL_ASYNC_SUBMIT	\
+		_IOW(0x98, 112, struct tegra_crypt_async_op)
+
+struct tegra_crypt_async_completion {
+	__u64 user_data;
+	__s32 status; /* 0 or a negative errno */
+	__u32 reserved;
+};
+
+struct tegra_crypt_async_reap {
+	__u64 completions; /* array of struct tegra_crypt_async_completion */
+	__u32 max;
+	__u32 flags;
+	__u32 count; /* returned */
+	__u32 reserved;
+};
+#define TEGRA_CRYPTO_IOCTL_ASYNC_REAP	\
+		_IOWR(0x98, 113, struct tegra_crypt_async_reap)
+
 #ifdef CONFIG_COMPAT
 struct tegra_crypt_req_32 {
 	int op; /* e.g. TEGRA_CRYPTO_ECB */
@@ -1193,6 +1193,26 @@ struct tegra_dc_ext_scrncapt_dup_fbuf  {
 	__u32 reserved[16];
 };
 
+/*
+ * Export the buffers currently scanned out by a window as dma-bufs, without
+ * pausing the display, so that they can be composited by a hardware engine
+ * such as VIC. The buffers must have been read once release_fence_fd
+ * signals, which happens when a later flip of the window replaces them and
+ * their producer may reuse them.
+ */
+struct tegra_dc_ext_scrncapt_export_fbuf {
+	__u32 win;      /* window ID */
+	__u32 flags;    /* unused - must be 0 */
+	/* returns a dma-buf fd for each plane, -1 for plane not available */
+	__s32 plane_fds[TEGRA_DC_SCRNCAPT_DUP_FBUF_IDX_NUM];
+	/* returns a fence fd signalled when the display releases the buffers */
+	__s32 release_fence_fd;
+	__u32 reserved0;
+	/* returns the window attributes, buff_id* hold the plane sizes */
+	struct tegra_dc_ext_flip_windowattr winattr;
+	__u32 reserved[8];
+};
+
 /* Scanline sync ioctl */
 #define TEGRA_DC_EXT_SCANLINE_FLAG_ENABLE (1U << 0)
 #define TEGRA_DC_EXT_SCANLINE_FLAG_DISABLE (0U << 0)
@@ -1215,6 +1235,29 @@ struct tegra_dc_ext_scanline_info {
 	};
 };
 
+/*
+ * Late latch: the output position (and optionally the source crop origin) of
+ * a window, or the cursor position, set through TEGRA_DC_EXT_SET_LATE_LATCH
+ * is sampled when the raster reaches the line set with
+ * TEGRA_DC_EXT_SET_LATE_LATCH_LINE and committed at the following vblank,
+ * without a flip. Only the last value set before the latch line is used, and
+ * a later flip of the window replaces it.
+ */
+#define TEGRA_DC_EXT_LATE_LATCH_CURSOR (~0U)
+
+#define TEGRA_DC_EXT_LATE_LATCH_FLAG_CROP (1U << 0)
+/* unused flags are reserved and must be 0 */
+
+struct tegra_dc_ext_late_latch {
+	__u32 win_index; /* window index or TEGRA_DC_EXT_LATE_LATCH_CURSOR */
+	__u32 flags;
+	__s32 out_x; /* output position of the window or cursor */
+	__s32 out_y;
+	__u32 x; /* source crop origin in 20.12 fixed point, if FLAG_CROP */
+	__u32 y;
+	__u32 reserved[2]; /* unused - must be 0 */
+};
+
 #define TEGRA_DC_EXT_SET_NVMAP_FD \
 	_IOW('D', 0x00, __s32)
 
@@ -1380,6 +1423,17 @@ struct tegra_dc_ext_scanline_info {
 #define TEGRA_DC_EXT_CRC_GET \
 	_IOWR('D', 0x28, struct tegra_dc_ext_crc_arg)
 
+/* Set the scanline in which late latched values are sampled, -1 disables */
+#define TEGRA_DC_EXT_SET_LATE_LATCH_LINE \
+	_IOW('D', 0x29, __s32)
+
+/* Queue a late latched window or cursor position update */
+#define TEGRA_DC_EXT_SET_LATE_LATCH \
+	_IOW('D', 0x2A, struct tegra_dc_ext_late_latch)
+
+#define TEGRA_DC_EXT_SCRNCAPT_EXPORT_FBUF \
+	_IOWR('D', 0x2B, struct tegra_dc_ext_scrncapt_export_fbuf)
+
 enum tegra_dc_ext_control_output_type {
 	TEGRA_DC_EXT_DSI,
 	TEGRA_DC_EXT_LVDS,
@@ -1455,6 +1509,31 @@ struct tegra_dc_ext_control_event_bandwidth {
 	__u32 resvd_bw;
 };
 
+/*
+ * Query whether a proposed ISO bandwidth fits, without going through the IMP
+ * PROPOSE flow. All bandwidths are in KB/s and include the catchup factor,
+ * like total_iso_bw_with_catchup_kBps of the IMP global entries.
+ *
+ * iso_bw (in): proposed ISO bandwidth, 0 to only read the current state
+ * flags (out): TEGRA_DC_EXT_BW_QUERY_FLAG_*
+ * avail_bw (out): ISO bandwidth display may reserve at most
+ * resvd_bw (out): ISO bandwidth display has currently reserved
+ * cur_bw (out): ISO bandwidth of the configuration currently on screen
+ * max_bw (out): ISO bandwidth of the max display configuration
+ */
+#define TEGRA_DC_EXT_BW_QUERY_FLAG_FITS		(1 << 0)
+#define TEGRA_DC_EXT_BW_QUERY_FLAG_RESERVED	(1 << 1)
+
+struct tegra_dc_ext_control_bw_query {
+	__u32 iso_bw;
+	__u32 flags;
+	__u32 avail_bw;
+	__u32 resvd_bw;
+	__u32 cur_bw;
+	__u32 max_bw;
+	__u32 reserved[2]; /* unused - must be 0 */
+};
+
 #define TEGRA_DC_EXT_EVENT_MODECHANGE      (1 << 4)
 struct tegra_dc_ext_control_event_modechange {
 	__u32 handle;
@@ -1667,6 +1746,50 @@ struct tegra_dc_ext_crc_arg {
 	__u8 reserved[32]; /* unused - must be 0 */
 } __attribute__((__packed__));
 
+/* CRC stream - per frame CRCs shared with userspace through mmap() of the
+ *              head device. Every frame end for which CRCs are collected
+ *              (see TEGRA_DC_EXT_CRC_ENABLE) appends an entry, whether or
+ *              not a flip happened in that frame. The kernel never waits
+ *              for the reader: the entry for count @n goes to slot
+ *              n % @entries and overwrites older ones.
+ * @magic     - TEGRA_DC_EXT_CRC_STREAM_MAGIC
+ * @entries   - Number of entries following the header, a power of two
+ * @head      - Count of entries written so far, written by the kernel
+ * @tail      - Written by userspace, poll() on the head device reports
+ *              POLLIN while it differs from @head
+ *
+ * An entry is valid if its @seq reads as its count plus one both before and
+ * after reading the rest of it; a different @seq means it was overwritten.
+ * @valid has TEGRA_DC_EXT_CRC_STREAM_VALID_* bits set for the CRCs present.
+ */
+#define TEGRA_DC_EXT_CRC_STREAM_MAGIC		0x43524353 /* "CRCS" */
+
+#define TEGRA_DC_EXT_CRC_STREAM_VALID_RG	(1 << 0)
+#define TEGRA_DC_EXT_CRC_STREAM_VALID_COMP	(1 << 1)
+#define TEGRA_DC_EXT_CRC_STREAM_VALID_OR	(1 << 2)
+#define TEGRA_DC_EXT_CRC_STREAM_VALID_REGION(id) (1 << (8 + (id)))
+
+struct tegra_dc_ext_crc_stream_header {
+	__u32 magic;
+	__u32 entries;
+	__u32 head;
+	__u32 reserved0[13];
+	__u32 tail;
+	__u32 reserved1[15];
+};
+
+struct tegra_dc_ext_crc_stream_entry {
+	__u32 seq;
+	__u32 frame_cnt;
+	__u64 timestamp_ns; /* CLOCK_MONOTONIC at collection */
+	__u32 valid;
+	__u32 rg;
+	__u32 comp;
+	__u32 sor;
+	__u32 regional[TEGRA_DC_EXT_MAX_REGIONS];
+	__u32 reserved[3];
+};
+
 #define TEGRA_DC_EXT_CONTROL_GET_NUM_OUTPUTS \
 	_IOR('C', 0x00, __u32)
 #define TEGRA_DC_EXT_CONTROL_GET_OUTPUT_PROPERTIES \
@@ -1687,5 +1810,7 @@ struct tegra_dc_ext_crc_arg {
 	_IOW('C', 0x08, struct tegra_dc_ext_control_scrncapt_resume)
 #define TEGRA_DC_EXT_CONTROL_GET_CAP_INFO \
 	_IOWR('C', 0x09, struct tegra_dc_ext_get_cap_info)
+#define TEGRA_DC_EXT_CONTROL_QUERY_BW \
+	_IOWR('C', 0x0A, struct tegra_dc_ext_control_bw_query)
 
 #endif /* __UAPI_TEGRA_DC_EXT_H */
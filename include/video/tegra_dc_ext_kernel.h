@@ -228,6 +228,19 @@ typedef void (*tegra_dc_notify_dc_disabled_event)(int disp_id, void *usr_ctx);
  */
 typedef void (*tegra_dc_notify_modeset_event)(int disp_id, void *usr_ctx);
 
+/*
+ * tegra_dc_notify_vblank_event - callback function to notify the client
+ * of each vblank, once enabled with tegra_dc_client_vblank_enable().
+ * Called from the dc interrupt thread with the dc lock held, so it must
+ * not call back into the dc driver.
+ * @disp_id: logical id represented by suffix to fb device, i.e. 0 for
+ * fb0, 1 for fb1 etc.
+ * @timestamp: CLOCK_MONOTONIC time in ns of the start of vblank.
+ * @usr_ctx: Any user context if present.
+ */
+typedef void (*tegra_dc_notify_vblank_event)(int disp_id, u64 timestamp,
+						void *usr_ctx);
+
 /*
  * tegra_dc_get_max_lines() - Get the base address of a head
  * @disp_id: logical id represented by suffix to fb device, i.e. 0 for
@@ -263,18 +276,34 @@ int tegra_dc_register_client(struct tegra_dc_client *client);
  */
 int tegra_dc_unregister_client(struct tegra_dc_client *client);
 
+/*
+ * tegra_dc_client_vblank_enable() - used by clients registered for
+ * NOTIFY_VBLANK_EVENT to turn the vblank interrupt on or off.
+ * @client : pointer to client's data
+ * @enable : true while the client needs vblank notifications.
+ *
+ * The interrupt is shared by all clients of the head, and is re-enabled
+ * along with the head.
+ *
+ * Return: 0 if no errors else corresponding error value.
+ */
+int tegra_dc_client_vblank_enable(struct tegra_dc_client *client,
+				  bool enable);
+
 /*
  * enum tegra_dc_client_cllbck_event_type - defines all the supported events
  * on which a dc_client can request a callback
  * @NOTIFY_DC_ENABLED_EVENT : when dc is enabled
  * @NOTIFY_DC_DISABLED_EVENT : when dc is disabled
  * @NOTIFY_MODESET_EVENT : when a modeset occurs
+ * @NOTIFY_VBLANK_EVENT : at each vblank, see tegra_dc_client_vblank_enable()
  * @MAX_EVENT : max no. of supported events.
  */
 enum tegra_dc_client_cllbck_event_type {
 	NOTIFY_DC_ENABLED_EVENT,
 	NOTIFY_DC_DISABLED_EVENT,
 	NOTIFY_MODESET_EVENT,
+	NOTIFY_VBLANK_EVENT,
 	MAX_EVENT
 };
 
@@ -100,8 +100,32 @@
 #define TEGRA186_ARAD_LANE_RATIO_INTEGER_PART_MASK		0xFFFFFFFF
 #define TEGRA186_ARAD_LANE_RATIO_FRAC_PART_MASK			0xFFFFFFFF
 
+/* interval of the drift tracking when a lane is in auto track mode */
+#define TEGRA186_ARAD_TRACK_PERIOD_MS		100
+
+enum {
+	ARAD_STAT_RATIO_UPDATES,
+	ARAD_STAT_RELOCKS,
+	ARAD_STAT_DRIFT_PPM,
+};
+
+struct tegra186_arad_lane_stats {
+	/* 32.32 fixed point ratios */
+	u64 ratio;
+	u64 ratio_min;
+	u64 ratio_max;
+	unsigned int updates;
+	unsigned int relocks;
+};
+
 struct tegra186_arad {
 	struct regmap *regmap;
+	struct device *dev;
+	struct delayed_work track_work;
+	/* protects track_lanes and stats */
+	struct mutex track_lock;
+	unsigned int track_lanes;
+	struct tegra186_arad_lane_stats stats[TEGRA186_ARAD_LANE_MAX];
 #if defined CONFIG_SND_SOC_TEGRA186_ARAD_WAR
 	unsigned int int_status;
 	spinlock_t status_lock;
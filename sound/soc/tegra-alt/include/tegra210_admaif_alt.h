@@ -62,6 +62,16 @@
 #define TEGRA_ADMAIF_XBAR_TX_FIFO_CTRL		0x28
 #define TEGRA_ADMAIF_XBAR_TX_FIFO_WRITE		0x2c
 
+/* FIFO_CTRL fields, the FIFO is allocated in 64 byte buffers */
+#define TEGRA_ADMAIF_FIFO_BUF_WORDS				16
+#define TEGRA_ADMAIF_FIFO_START_ADDR_MASK			0xff
+#define TEGRA_ADMAIF_FIFO_SIZE_SHIFT				8
+#define TEGRA_ADMAIF_FIFO_SIZE_MASK				\
+			(0x1f << TEGRA_ADMAIF_FIFO_SIZE_SHIFT)
+#define TEGRA_ADMAIF_FIFO_THRESHOLD_SHIFT			20
+#define TEGRA_ADMAIF_FIFO_THRESHOLD_MASK			\
+			(0xfff << TEGRA_ADMAIF_FIFO_THRESHOLD_SHIFT)
+
 #define TEGRA_ADMAIF_CHAN_ACIF_CTRL_PACK8_EN_SHIFT		31
 #define TEGRA_ADMAIF_CHAN_ACIF_CTRL_PACK8_EN_MASK		\
 			(1 << TEGRA_ADMAIF_CHAN_ACIF_CTRL_PACK8_EN_SHIFT)
@@ -162,6 +172,8 @@ struct tegra_admaif_soc_data {
 	struct snd_soc_codec_driver *admaif_codec;
 	const struct regmap_config *regmap_conf;
 	bool is_isomgr_client;
+	/* FIFO buffers shared by the RX, resp. TX, channels */
+	unsigned int fifo_bufs;
 	unsigned int global_base;
 	unsigned int tx_base;
 	unsigned int rx_base;
@@ -20,6 +20,7 @@
 #define __TEGRA210_OPE_ALT_H__
 
 #include "tegra210_peq_alt.h"
+#include "tegra210_mbdrc_alt.h"
 
 /* Register offsets from TEGRA210_OPE*_BASE */
 /*
@@ -74,14 +75,20 @@ struct tegra210_ope {
 	struct regmap *regmap;
 	struct regmap *peq_regmap;
 	struct regmap *mbdrc_regmap;
-	u32 peq_biquad_gains[TEGRA210_PEQ_GAIN_PARAM_SIZE_PER_CH];
-	u32 peq_biquad_shifts[TEGRA210_PEQ_SHIFT_PARAM_SIZE_PER_CH];
+	/* shadows of the PEQ and MBDRC AHUB RAMs, kept by the controls */
+	u32 peq_biquad_gains[TEGRA210_PEQ_MAX_CHANNELS]
+			    [TEGRA210_PEQ_GAIN_PARAM_SIZE_PER_CH];
+	u32 peq_biquad_shifts[TEGRA210_PEQ_MAX_CHANNELS]
+			     [TEGRA210_PEQ_SHIFT_PARAM_SIZE_PER_CH];
+	u32 mbdrc_biquad_coeffs[MBDRC_NUM_BAND]
+			       [TEGRA210_MBDRC_MAX_BIQUAD_STAGES * 5];
+	/* MBDRC RAM no longer matches its shadow */
+	bool mbdrc_ram_dirty;
 };
 
 extern int tegra210_peq_init(struct platform_device *pdev, int id);
 extern int tegra210_peq_codec_init(struct snd_soc_codec *codec);
 extern void tegra210_peq_restore(struct tegra210_ope *ope);
-extern void tegra210_peq_save(struct tegra210_ope *ope);
 extern int tegra210_mbdrc_init(struct platform_device *pdev, int id);
 extern int tegra210_mbdrc_codec_init(struct snd_soc_codec *codec);
 extern int tegra210_mbdrc_hw_params(struct snd_soc_codec *codec);
@@ -92,6 +92,8 @@ struct tegra210_sfc {
 	int stereo_conv_input;
 	int mono_conv_output;
 	unsigned int channels_via_control;
+	/* coefficients in the SFC RAM, NULL when unknown */
+	u32 *coeff_ram_loaded;
 };
 
 #endif
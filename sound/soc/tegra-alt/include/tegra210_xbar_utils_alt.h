@@ -84,6 +84,17 @@
 
 #define MUX_VALUE(npart, nbit) (1 + nbit + npart * 32)
 
+/* longest route followed by the route hops controls */
+#define TEGRA_XBAR_MAX_ROUTE_HOPS	16
+
+#define ROUTE_HOPS_CTRL(sname) \
+	{ .iface = SNDRV_CTL_ELEM_IFACE_MIXER, .name = sname " Route Hops", \
+	  .access = SNDRV_CTL_ELEM_ACCESS_READ | \
+		    SNDRV_CTL_ELEM_ACCESS_VOLATILE, \
+	  .info = tegra_xbar_route_hops_info, \
+	  .get = tegra_xbar_get_route_hops, \
+	  .private_value = (unsigned long)sname }
+
 #define IN_OUT_ROUTES(name)				\
 	{ name " RX",       NULL,	name " Receive" },	\
 	{ name " Transmit", NULL,	name " TX" },
@@ -93,6 +104,10 @@ int tegra_xbar_get_value_enum(struct snd_kcontrol *kcontrol,
 			struct snd_ctl_elem_value *ucontrol);
 int tegra_xbar_put_value_enum(struct snd_kcontrol *kcontrol,
 			struct snd_ctl_elem_value *ucontrol);
+int tegra_xbar_route_hops_info(struct snd_kcontrol *kcontrol,
+			       struct snd_ctl_elem_info *uinfo);
+int tegra_xbar_get_route_hops(struct snd_kcontrol *kcontrol,
+			      struct snd_ctl_elem_value *ucontrol);
 bool tegra_xbar_volatile_reg(struct device *dev, unsigned int reg);
 int tegra_xbar_remove(struct platform_device *pdev);
 int tegra_xbar_runtime_resume(struct device *dev);
@@ -19,11 +19,13 @@
 #include <linux/clk.h>
 #include <linux/device.h>
 #include <linux/io.h>
+#include <linux/math64.h>
 #include <linux/module.h>
 #include <linux/of.h>
 #include <linux/platform_device.h>
 #include <linux/pm_runtime.h>
 #include <linux/regmap.h>
+#include <linux/workqueue.h>
 #include <sound/core.h>
 #include <sound/pcm.h>
 #include <sound/pcm_params.h>
@@ -456,6 +458,24 @@ static ARAD_MUX_ENUM_CTRL_DECL(denominator6,
 		TEGRA186_ARAD_LANE##id##_RATIO_FRACTIONAL_PART, 0, \
 		TEGRA186_ARAD_LANE_RATIO_FRAC_PART_MASK, 0, 0) }
 
+#define ARAD_LANE_TRACK(id) \
+	SOC_SINGLE_EXT("Lane"#id" Auto Track", SND_SOC_NOPM, id - 1, 1, 0, \
+		tegra186_arad_get_track, tegra186_arad_put_track)
+
+#define ARAD_LANE_STAT(id, xname, stat, xmax) { \
+	.iface = SNDRV_CTL_ELEM_IFACE_MIXER, \
+	.name = "Lane"#id" "xname, \
+	.access = SNDRV_CTL_ELEM_ACCESS_READ | SNDRV_CTL_ELEM_ACCESS_VOLATILE, \
+	.info = tegra186_arad_get_info, \
+	.get = tegra186_arad_get_stats, \
+	.private_value = SOC_SINGLE_VALUE(stat, id - 1, xmax, 0, 0) }
+
+#define ARAD_LANE_TRACK_CTRLS(id) \
+	ARAD_LANE_TRACK(id), \
+	ARAD_LANE_STAT(id, "Ratio Updates", ARAD_STAT_RATIO_UPDATES, INT_MAX), \
+	ARAD_LANE_STAT(id, "Relocks", ARAD_STAT_RELOCKS, INT_MAX), \
+	ARAD_LANE_STAT(id, "Drift PPM", ARAD_STAT_DRIFT_PPM, 1000000)
+
 static const struct snd_kcontrol_new tegra186_arad_controls[] = {
 	SOC_SINGLE_EXT("Lane1 enable", TEGRA186_ARAD_LANE_ENABLE, 0, 1, 0,
 		tegra186_arad_get_enable_lane, tegra186_arad_put_enable_lane),
@@ -523,8 +543,172 @@ static const struct snd_kcontrol_new tegra186_arad_controls[] = {
 	ARAD_DENOMINATOR_PRESCALAR(4),
 	ARAD_DENOMINATOR_PRESCALAR(5),
 	ARAD_DENOMINATOR_PRESCALAR(6),
+
+	ARAD_LANE_TRACK_CTRLS(1),
+	ARAD_LANE_TRACK_CTRLS(2),
+	ARAD_LANE_TRACK_CTRLS(3),
+	ARAD_LANE_TRACK_CTRLS(4),
+	ARAD_LANE_TRACK_CTRLS(5),
+	ARAD_LANE_TRACK_CTRLS(6),
 };
 
+/*
+ * Drift tracking: while a lane is in auto track mode its ratio and lock
+ * state are sampled every TEGRA186_ARAD_TRACK_PERIOD_MS. New ratios are
+ * sent to the ASRC streams using ARAD as their ratio source, and a lane
+ * that lost lock, e.g. after a clock glitch on one of its inputs, is
+ * reset and enabled again instead of leaving the ASRC on a stale ratio.
+ */
+static void tegra186_arad_relock_lane(struct tegra186_arad *arad,
+				      unsigned int lane_id)
+{
+	regmap_write(arad->regmap, TEGRA186_ARAD_LANE_INT_CLEAR,
+		1 << lane_id);
+	regmap_update_bits(arad->regmap, TEGRA186_ARAD_LANE_SOFT_RESET,
+		1 << lane_id, 1 << lane_id);
+	regmap_update_bits(arad->regmap, TEGRA186_ARAD_LANE_ENABLE,
+		1 << lane_id, 1 << lane_id);
+}
+
+static void tegra186_arad_track_work(struct work_struct *work)
+{
+	struct tegra186_arad *arad = container_of(to_delayed_work(work),
+					struct tegra186_arad, track_work);
+	unsigned int lane_id, enable, inte, frac;
+	bool send = false;
+	u64 ratio;
+
+	mutex_lock(&arad->track_lock);
+	if (!arad->track_lanes) {
+		mutex_unlock(&arad->track_lock);
+		return;
+	}
+
+	pm_runtime_get_sync(arad->dev);
+	regmap_read(arad->regmap, TEGRA186_ARAD_LANE_ENABLE, &enable);
+
+	for (lane_id = 0; lane_id < TEGRA186_ARAD_LANE_MAX; lane_id++) {
+		struct tegra186_arad_lane_stats *stats = &arad->stats[lane_id];
+
+		if (!(arad->track_lanes & enable & (1 << lane_id)))
+			continue;
+
+		if (!tegra186_arad_get_lane_lock_status(arad, lane_id)) {
+			tegra186_arad_relock_lane(arad, lane_id);
+			stats->relocks++;
+			continue;
+		}
+
+		regmap_read(arad->regmap, ARAD_LANE_REG(
+			TEGRA186_ARAD_LANE1_RATIO_INTEGER_PART, lane_id), &inte);
+		regmap_read(arad->regmap, ARAD_LANE_REG(
+			TEGRA186_ARAD_LANE1_RATIO_FRACTIONAL_PART, lane_id),
+			&frac);
+		ratio = ((u64)inte << 32) | frac;
+
+		if (ratio == stats->ratio)
+			continue;
+
+		if (!stats->updates || ratio < stats->ratio_min)
+			stats->ratio_min = ratio;
+		if (!stats->updates || ratio > stats->ratio_max)
+			stats->ratio_max = ratio;
+		stats->ratio = ratio;
+		stats->updates++;
+		send = true;
+	}
+
+	if (send)
+		regmap_write(arad->regmap, TEGRA186_ARAD_SEND_RATIO, 0x1);
+	pm_runtime_put(arad->dev);
+
+	schedule_delayed_work(&arad->track_work,
+		msecs_to_jiffies(TEGRA186_ARAD_TRACK_PERIOD_MS));
+	mutex_unlock(&arad->track_lock);
+}
+
+static int tegra186_arad_get_track(struct snd_kcontrol *kcontrol,
+	struct snd_ctl_elem_value *ucontrol)
+{
+	struct soc_mixer_control *arad_private =
+		(struct soc_mixer_control *)kcontrol->private_value;
+	struct snd_soc_codec *codec = snd_soc_kcontrol_codec(kcontrol);
+	struct tegra186_arad *arad = snd_soc_codec_get_drvdata(codec);
+
+	ucontrol->value.integer.value[0] =
+		!!(arad->track_lanes & (1 << arad_private->shift));
+
+	return 0;
+}
+
+static int tegra186_arad_put_track(struct snd_kcontrol *kcontrol,
+	struct snd_ctl_elem_value *ucontrol)
+{
+	struct soc_mixer_control *arad_private =
+		(struct soc_mixer_control *)kcontrol->private_value;
+	struct snd_soc_codec *codec = snd_soc_kcontrol_codec(kcontrol);
+	struct tegra186_arad *arad = snd_soc_codec_get_drvdata(codec);
+	unsigned int lane_id = arad_private->shift;
+	bool enable = !!ucontrol->value.integer.value[0];
+
+	mutex_lock(&arad->track_lock);
+	if (enable == !!(arad->track_lanes & (1 << lane_id))) {
+		mutex_unlock(&arad->track_lock);
+		return 0;
+	}
+
+	if (enable) {
+		memset(&arad->stats[lane_id], 0, sizeof(arad->stats[lane_id]));
+		if (!arad->track_lanes)
+			schedule_delayed_work(&arad->track_work, 0);
+		arad->track_lanes |= 1 << lane_id;
+	} else {
+		arad->track_lanes &= ~(1 << lane_id);
+	}
+	mutex_unlock(&arad->track_lock);
+
+	return 1;
+}
+
+static int tegra186_arad_get_stats(struct snd_kcontrol *kcontrol,
+	struct snd_ctl_elem_value *ucontrol)
+{
+	struct soc_mixer_control *arad_private =
+		(struct soc_mixer_control *)kcontrol->private_value;
+	struct snd_soc_codec *codec = snd_soc_kcontrol_codec(kcontrol);
+	struct tegra186_arad *arad = snd_soc_codec_get_drvdata(codec);
+	struct tegra186_arad_lane_stats *stats =
+		&arad->stats[arad_private->shift];
+	u64 span;
+	long val = 0;
+
+	mutex_lock(&arad->track_lock);
+	switch (arad_private->reg) {
+	case ARAD_STAT_RATIO_UPDATES:
+		val = stats->updates;
+		break;
+	case ARAD_STAT_RELOCKS:
+		val = stats->relocks;
+		break;
+	case ARAD_STAT_DRIFT_PPM:
+		/* spread of the measured ratio since tracking started */
+		span = stats->ratio_max - stats->ratio_min;
+		if (!stats->ratio)
+			val = 0;
+		else if (span > div64_u64(U64_MAX, 1000000))
+			val = arad_private->max;
+		else
+			val = min_t(u64, div64_u64(span * 1000000,
+				stats->ratio), arad_private->max);
+		break;
+	}
+	mutex_unlock(&arad->track_lock);
+
+	ucontrol->value.integer.value[0] = val;
+
+	return 0;
+}
+
 void tegra186_arad_send_ratio(void)
 {
 	struct tegra186_arad *arad = dev_get_drvdata(arad_dev);
@@ -758,6 +942,9 @@ static int tegra186_arad_platform_probe(struct platform_device *pdev)
 		return -ENOMEM;
 
 	arad_dev = &pdev->dev;
+	arad->dev = &pdev->dev;
+	mutex_init(&arad->track_lock);
+	INIT_DELAYED_WORK(&arad->track_work, tegra186_arad_track_work);
 	dev_set_drvdata(&pdev->dev, arad);
 
 	mem = platform_get_resource(pdev, IORESOURCE_MEM, 0);
@@ -805,8 +992,15 @@ static int tegra186_arad_platform_probe(struct platform_device *pdev)
 
 static int tegra186_arad_platform_remove(struct platform_device *pdev)
 {
+	struct tegra186_arad *arad = dev_get_drvdata(&pdev->dev);
+
 	snd_soc_unregister_codec(&pdev->dev);
 
+	mutex_lock(&arad->track_lock);
+	arad->track_lanes = 0;
+	mutex_unlock(&arad->track_lock);
+	cancel_delayed_work_sync(&arad->track_work);
+
 	pm_runtime_disable(&pdev->dev);
 	if (!pm_runtime_status_suspended(&pdev->dev))
 		tegra186_arad_runtime_suspend(&pdev->dev);
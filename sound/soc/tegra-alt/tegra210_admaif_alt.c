@@ -24,6 +24,7 @@
 #include <linux/platform_device.h>
 #include <linux/pm_runtime.h>
 #include <linux/regmap.h>
+#include <linux/slab.h>
 #include <sound/soc.h>
 #include <sound/pcm_params.h>
 
@@ -1091,6 +1092,7 @@ static struct tegra_admaif_soc_data soc_data_tegra210 = {
 	.tx_base = TEGRA210_ADMAIF_XBAR_TX_BASE,
 	.rx_base = TEGRA210_ADMAIF_XBAR_RX_BASE,
 	.is_isomgr_client = false,
+	.fifo_bufs = 32,
 };
 
 static struct tegra_admaif_soc_data soc_data_tegra186 = {
@@ -1102,6 +1104,7 @@ static struct tegra_admaif_soc_data soc_data_tegra186 = {
 	.tx_base = TEGRA186_ADMAIF_XBAR_TX_BASE,
 	.rx_base = TEGRA186_ADMAIF_XBAR_RX_BASE,
 	.is_isomgr_client = true,
+	.fifo_bufs = 64,
 };
 
 
@@ -1111,6 +1114,87 @@ static const struct of_device_id tegra_admaif_of_match[] = {
 	{},
 };
 
+/*
+ * Repartitions the RX or TX FIFO from the optional per channel sizes (in
+ * 64 byte buffers) and thresholds (in words) of the device tree. Deeper
+ * FIFOs let the ADMA move larger bursts, for many channel streams.
+ */
+static int tegra_admaif_config_fifo(struct tegra_admaif *admaif,
+				    unsigned int base, const char *size_prop,
+				    const char *thres_prop)
+{
+	struct device *dev = admaif->dev;
+	unsigned int num_ch = admaif->soc_data->num_ch;
+	unsigned int start = 0, reg, val, i;
+	u32 *size, *thres;
+	bool has_size, has_thres;
+	int ret = 0;
+
+	has_size = of_property_count_u32_elems(dev->of_node, size_prop) ==
+		   num_ch;
+	has_thres = thres_prop &&
+		    of_property_count_u32_elems(dev->of_node, thres_prop) ==
+		    num_ch;
+	if (!has_size && !has_thres)
+		return 0;
+
+	size = kcalloc(num_ch * 2, sizeof(u32), GFP_KERNEL);
+	if (!size)
+		return -ENOMEM;
+	thres = size + num_ch;
+
+	if (has_size)
+		of_property_read_u32_array(dev->of_node, size_prop, size,
+					   num_ch);
+	if (has_thres)
+		of_property_read_u32_array(dev->of_node, thres_prop, thres,
+					   num_ch);
+
+	for (i = 0; i < num_ch; i++) {
+		reg = base + (i * TEGRA_ADMAIF_CHANNEL_REG_STRIDE);
+		regmap_read(admaif->regmap, reg, &val);
+
+		if (has_size) {
+			if (!size[i] || start + size[i] >
+					admaif->soc_data->fifo_bufs) {
+				dev_err(dev, "Invalid %s of ADMAIF%d\n",
+					size_prop, i + 1);
+				ret = -EINVAL;
+				goto out;
+			}
+			val &= ~(TEGRA_ADMAIF_FIFO_START_ADDR_MASK |
+				 TEGRA_ADMAIF_FIFO_SIZE_MASK);
+			val |= start | ((size[i] - 1) <<
+					TEGRA_ADMAIF_FIFO_SIZE_SHIFT);
+			start += size[i];
+
+			/* keep the default of half the FIFO */
+			if (thres_prop && !has_thres)
+				thres[i] = size[i] *
+					   TEGRA_ADMAIF_FIFO_BUF_WORDS / 2;
+		}
+
+		if (thres_prop) {
+			if (thres[i] > (((val & TEGRA_ADMAIF_FIFO_SIZE_MASK) >>
+					 TEGRA_ADMAIF_FIFO_SIZE_SHIFT) + 1) *
+					TEGRA_ADMAIF_FIFO_BUF_WORDS) {
+				dev_err(dev, "Invalid %s of ADMAIF%d\n",
+					thres_prop, i + 1);
+				ret = -EINVAL;
+				goto out;
+			}
+			val &= ~TEGRA_ADMAIF_FIFO_THRESHOLD_MASK;
+			val |= thres[i] << TEGRA_ADMAIF_FIFO_THRESHOLD_SHIFT;
+		}
+
+		regmap_write(admaif->regmap, reg, val);
+	}
+out:
+	kfree(size);
+
+	return ret;
+}
+
 static int tegra_admaif_probe(struct platform_device *pdev)
 {
 	int ret, i;
@@ -1236,6 +1320,19 @@ static int tegra_admaif_probe(struct platform_device *pdev)
 		admaif->capture_dma_data[i].buffer_size = buffer_size;
 	}
 
+	ret = tegra_admaif_config_fifo(admaif,
+				       TEGRA_ADMAIF_XBAR_RX_FIFO_CTRL,
+				       "nvidia,rx-fifo-size", NULL);
+	if (ret)
+		return ret;
+
+	ret = tegra_admaif_config_fifo(admaif, admaif->soc_data->tx_base +
+				       TEGRA_ADMAIF_XBAR_TX_FIFO_CTRL,
+				       "nvidia,tx-fifo-size",
+				       "nvidia,tx-fifo-threshold");
+	if (ret)
+		return ret;
+
 	regmap_update_bits(admaif->regmap, admaif->soc_data->global_base +
 			   TEGRA_ADMAIF_GLOBAL_ENABLE, 1, 1);
 
@@ -131,6 +131,7 @@ struct tegra210_adsp_app {
 	uint32_t connect:1; /* if app is connected to a source */
 	uint32_t priority; /* Valid for only APM app */
 	uint32_t min_adsp_clock; /* Min ADSP clock required in MHz */
+	unsigned long dfs_load; /* Load hinted to ADSP DFS in KHz */
 	uint32_t input_mode; /* APM input mode */
 	struct tegra210_adsp_app_read_data read_data;
 	spinlock_t lock;
@@ -711,10 +712,27 @@ static int tegra210_adsp_send_state_msg(struct tegra210_adsp_app *app,
 	apm_msg.msg.call_params.method = nvfx_method_set_state;
 	apm_msg.msg.state_params.state = state;
 
-	/* Spike ADSP freq to max when app transitions to active */
-	/* state; DFS will thereafter find appropriate rate      */
-	if ((state == nvfx_state_active) && (app->override_freq_work != NULL))
-		schedule_work(app->override_freq_work);
+	/*
+	 * Hint the known load of the APM graph to DFS when the app goes
+	 * active, or spike ADSP freq to max when it is not known; DFS
+	 * will thereafter find appropriate rate. Hints of concurrent
+	 * streams add up.
+	 */
+	if (state == nvfx_state_active) {
+		unsigned long load = app->min_adsp_clock * 1000;
+
+		if (load) {
+			if (!cmpxchg(&app->dfs_load, 0, load))
+				adsp_dfs_add_load(load);
+		} else if (app->override_freq_work != NULL) {
+			schedule_work(app->override_freq_work);
+		}
+	} else if (state == nvfx_state_inactive) {
+		unsigned long load = xchg(&app->dfs_load, 0);
+
+		if (load)
+			adsp_dfs_remove_load(load);
+	}
 
 	return tegra210_adsp_send_msg(app, &apm_msg, flags);
 }
@@ -932,10 +950,12 @@ static int tegra210_adsp_connect_apm(struct tegra210_adsp *adsp,
 }
 
 /* Recursive function to connect plugins under a APM
-   Returns BE/FE on the pcm path */
+   Returns BE/FE on the pcm path. The connect messages of the plugins
+   inside one APM are queued with hold, and sent to the ADSP together by
+   the last one, which is the only one waiting for an ACK. */
 static int tegra210_adsp_connect_plugin(struct tegra210_adsp *adsp,
 					struct tegra210_adsp_app *app,
-					uint32_t *apm_in_src)
+					uint32_t *apm_in_src, bool hold)
 {
 	struct tegra210_adsp_app *src;
 	uint32_t source;
@@ -947,7 +967,8 @@ static int tegra210_adsp_connect_plugin(struct tegra210_adsp *adsp,
 
 	src = &adsp->apps[source];
 	if (!IS_APM_IN(src->reg)) {
-		ret = tegra210_adsp_connect_plugin(adsp, src, apm_in_src);
+		ret = tegra210_adsp_connect_plugin(adsp, src, apm_in_src,
+						   true);
 		if (ret < 0)
 			return ret;
 	} else {
@@ -955,7 +976,7 @@ static int tegra210_adsp_connect_plugin(struct tegra210_adsp *adsp,
 		if (IS_APM_OUT(source)) {
 			/* connect plugins inside next APM */
 			ret = tegra210_adsp_connect_plugin(adsp,
-				&adsp->apps[source], apm_in_src);
+				&adsp->apps[source], apm_in_src, false);
 			if (ret < 0)
 				return ret;
 			/* connect APM_IN to APM_OUT */
@@ -983,7 +1004,8 @@ static int tegra210_adsp_connect_plugin(struct tegra210_adsp *adsp,
 	dev_vdbg(adsp->dev, "Connecting plugin 0x%x -> 0x%x",
 		src->reg, app->reg);
 
-	ret = tegra210_adsp_send_connect_msg(src, app,
+	ret = tegra210_adsp_send_connect_msg(src, app, hold ?
+		TEGRA210_ADSP_MSG_FLAG_HOLD :
 		TEGRA210_ADSP_MSG_FLAG_SEND | TEGRA210_ADSP_MSG_FLAG_NEED_ACK);
 	if (ret < 0) {
 		dev_err(adsp->dev, "Connect msg failed. err %d.", ret);
@@ -1061,7 +1083,8 @@ static int tegra210_adsp_update_connection(struct tegra210_adsp *adsp)
 	uint32_t end_reg;
 
 	for (i = APM_OUT_START; i <= APM_OUT_END; i++) {
-		ret = tegra210_adsp_connect_plugin(adsp, &adsp->apps[i], &end_reg);
+		ret = tegra210_adsp_connect_plugin(adsp, &adsp->apps[i],
+						   &end_reg, false);
 		if (ret >= 0) {
 			/* Record FE/BE pair for every successful connection */
 			tegra210_adsp_manage_plugin(adsp, end_reg, i, NULL);
@@ -1791,9 +1814,10 @@ static int tegra210_adsp_pcm_hw_params(struct snd_pcm_substream *substream,
 		 params_period_size(params),
 		 params_buffer_bytes(params));
 
+	/* sent together with the period size */
 	ret = tegra210_adsp_send_io_buffer_msg(prtd->fe_apm, buf->addr,
 					params_buffer_bytes(params),
-					TEGRA210_ADSP_MSG_FLAG_SEND);
+					TEGRA210_ADSP_MSG_FLAG_HOLD);
 	if (ret < 0)
 		return ret;
 
@@ -1813,6 +1837,19 @@ static int tegra210_adsp_pcm_hw_free(struct snd_pcm_substream *substream)
 	return 0;
 }
 
+/*
+ * The buffer is in ADSP shared DRAM, the ADSP reads and writes it in place.
+ * It is mapped through the ADSP device that allocated it.
+ */
+static int tegra210_adsp_pcm_mmap(struct snd_pcm_substream *substream,
+				  struct vm_area_struct *vma)
+{
+	struct snd_pcm_runtime *runtime = substream->runtime;
+
+	return nvadsp_mmap_coherent(vma, runtime->dma_area,
+				    runtime->dma_addr, runtime->dma_bytes);
+}
+
 
 static int tegra210_adsp_pcm_trigger(struct snd_pcm_substream *substream,
 				     int cmd)
@@ -1917,6 +1954,7 @@ static struct snd_pcm_ops tegra210_adsp_pcm_ops = {
 	.trigger	= tegra210_adsp_pcm_trigger,
 	.pointer	= tegra210_adsp_pcm_pointer,
 	.ack		= tegra210_adsp_pcm_ack,
+	.mmap		= tegra210_adsp_pcm_mmap,
 };
 
 static int tegra210_adsp_pcm_new(struct snd_soc_pcm_runtime *rtd)
@@ -2680,17 +2718,12 @@ static int tegra210_adsp_widget_event(struct snd_soc_dapm_widget *w,
 
 	if (SND_SOC_DAPM_EVENT_ON(event)) {
 		if (IS_APM_IN(w->reg)) {
-			/* Request higher ADSP clock when starting stream.
-			 * Actmon takes care of adjusting frequency later. */
 			ret = pm_runtime_get_sync(adsp->dev);
 			if (ret < 0) {
 				dev_err(adsp->dev, "%s pm_runtime_get_sync error 0x%x\n",
 					__func__, ret);
 				return ret;
 			}
-			if (app->min_adsp_clock)
-				adsp_update_dfs_min_rate(app->min_adsp_clock * 1000);
-
 			ret = tegra210_adsp_send_state_msg(app, nvfx_state_active,
 				TEGRA210_ADSP_MSG_FLAG_SEND);
 			if (ret < 0)
@@ -2717,8 +2750,6 @@ static int tegra210_adsp_widget_event(struct snd_soc_dapm_widget *w,
 				TEGRA210_ADSP_MSG_FLAG_NEED_ACK));
 			if (ret < 0)
 				dev_err(adsp->dev, "Failed to reset.");
-			if (app->min_adsp_clock)
-				adsp_update_dfs_min_rate(0);
 
 			pm_runtime_put(adsp->dev);
 		}
@@ -316,14 +316,45 @@ static int tegra210_mbdrc_threshold_put(struct snd_kcontrol *kcontrol,
 	return 0;
 }
 
+/* loads the biquad RAM of every band from its shadow, if stale */
+static void tegra210_mbdrc_flush_biquad_coeffs(struct tegra210_ope *ope)
+{
+	int i;
+
+	if (!ope->mbdrc_ram_dirty)
+		return;
+
+	for (i = 0; i < MBDRC_NUM_BAND; i++) {
+		u32 reg_off = i * TEGRA210_MBDRC_FILTER_PARAM_STRIDE;
+
+		tegra210_xbar_write_ahubram(ope->mbdrc_regmap,
+			reg_off + TEGRA210_MBDRC_AHUBRAMCTL_CONFIG_RAM_CTRL,
+			reg_off + TEGRA210_MBDRC_AHUBRAMCTL_CONFIG_RAM_DATA, 0,
+			ope->mbdrc_biquad_coeffs[i],
+			TEGRA210_MBDRC_MAX_BIQUAD_STAGES * 5);
+	}
+
+	ope->mbdrc_ram_dirty = false;
+}
+
+static u32 *tegra210_mbdrc_biquad_shadow(struct tegra210_ope *ope,
+					 struct tegra_soc_bytes *params)
+{
+	return ope->mbdrc_biquad_coeffs[(params->soc.base -
+		TEGRA210_MBDRC_AHUBRAMCTL_CONFIG_RAM_CTRL) /
+		TEGRA210_MBDRC_FILTER_PARAM_STRIDE];
+}
+
 static int tegra210_mbdrc_biquad_coeffs_get(struct snd_kcontrol *kcontrol,
 	struct snd_ctl_elem_value *ucontrol)
 {
 	struct tegra_soc_bytes *params = (void *)kcontrol->private_value;
 	struct snd_soc_codec *codec = snd_soc_kcontrol_codec(kcontrol);
+	struct tegra210_ope *ope = snd_soc_codec_get_drvdata(codec);
 	u32 *data = (u32 *)ucontrol->value.bytes.data;
 
-	memset(data, 0, params->soc.num_regs * codec->component.val_bytes);
+	memcpy(data, tegra210_mbdrc_biquad_shadow(ope, params),
+		params->soc.num_regs * codec->component.val_bytes);
 	return 0;
 }
 
@@ -333,14 +364,23 @@ static int tegra210_mbdrc_biquad_coeffs_put(struct snd_kcontrol *kcontrol,
 	struct tegra_soc_bytes *params = (void *)kcontrol->private_value;
 	struct snd_soc_codec *codec = snd_soc_kcontrol_codec(kcontrol);
 	struct tegra210_ope *ope = snd_soc_codec_get_drvdata(codec);
-	u32 reg_ctrl = params->soc.base;
-	u32 reg_data = reg_ctrl + codec->component.val_bytes;
+	u32 *shadow = tegra210_mbdrc_biquad_shadow(ope, params);
 	u32 *data = (u32 *)ucontrol->value.bytes.data;
+	size_t size = params->soc.num_regs * codec->component.val_bytes;
 
-	tegra210_xbar_write_ahubram(ope->mbdrc_regmap, reg_ctrl, reg_data,
-				    params->shift, data, params->soc.num_regs);
+	if (!memcmp(shadow, data, size))
+		return 0;
 
-	return 0;
+	memcpy(shadow, data, size);
+	ope->mbdrc_ram_dirty = true;
+
+	/* otherwise loaded at the next hw_params */
+	if (pm_runtime_get_if_in_use(codec->dev) > 0) {
+		tegra210_mbdrc_flush_biquad_coeffs(ope);
+		pm_runtime_put(codec->dev);
+	}
+
+	return 1;
 }
 
 static int tegra210_mbdrc_param_info(struct snd_kcontrol *kcontrol,
@@ -653,25 +693,14 @@ static const struct regmap_config tegra210_mbdrc_regmap_config = {
 int tegra210_mbdrc_hw_params(struct snd_soc_codec *codec)
 {
 	struct tegra210_ope *ope = snd_soc_codec_get_drvdata(codec);
-	const struct tegra210_mbdrc_config *conf = &mbdrc_init_config;
 	u32 val = 0;
-	int i;
 
 	regmap_read(ope->mbdrc_regmap, TEGRA210_MBDRC_CONFIG, &val);
 	if (val & TEGRA210_MBDRC_CONFIG_MBDRC_MODE_BYPASS)
 		return 0;
 
-	for (i = 0; i < MBDRC_NUM_BAND; i++) {
-		const struct tegra210_mbdrc_band_params *params =
-		&conf->band_params[i];
-		u32 reg_off = i * TEGRA210_MBDRC_FILTER_PARAM_STRIDE;
+	tegra210_mbdrc_flush_biquad_coeffs(ope);
 
-		tegra210_xbar_write_ahubram(ope->mbdrc_regmap,
-			reg_off + TEGRA210_MBDRC_AHUBRAMCTL_CONFIG_RAM_CTRL,
-			reg_off + TEGRA210_MBDRC_AHUBRAMCTL_CONFIG_RAM_DATA, 0,
-			(u32 *)&params->biquad_params[0],
-			TEGRA210_MBDRC_MAX_BIQUAD_STAGES * 5);
-	}
 	return 0;
 }
 EXPORT_SYMBOL_GPL(tegra210_mbdrc_hw_params);
@@ -819,12 +848,11 @@ int tegra210_mbdrc_codec_init(struct snd_soc_codec *codec)
 			params->fast_release_tc <<
 			TEGRA210_MBDRC_FAST_RELEASE_SHIFT);
 
-		tegra210_xbar_write_ahubram(ope->mbdrc_regmap,
-			reg_off + TEGRA210_MBDRC_AHUBRAMCTL_CONFIG_RAM_CTRL,
-			reg_off + TEGRA210_MBDRC_AHUBRAMCTL_CONFIG_RAM_DATA, 0,
-			(u32 *)&params->biquad_params[0],
-			TEGRA210_MBDRC_MAX_BIQUAD_STAGES * 5);
+		memcpy(ope->mbdrc_biquad_coeffs[i], params->biquad_params,
+			sizeof(ope->mbdrc_biquad_coeffs[i]));
 	}
+	ope->mbdrc_ram_dirty = true;
+	tegra210_mbdrc_flush_biquad_coeffs(ope);
 	pm_runtime_put_sync(codec->dev);
 
 	snd_soc_add_codec_controls(codec, tegra210_mbdrc_controls,
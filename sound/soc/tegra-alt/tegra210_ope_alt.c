@@ -47,7 +47,8 @@ static int tegra210_ope_runtime_suspend(struct device *dev)
 {
 	struct tegra210_ope *ope = dev_get_drvdata(dev);
 
-	tegra210_peq_save(ope);
+	/* the AHUB RAMs are not retained, reload them from the shadows */
+	ope->mbdrc_ram_dirty = true;
 
 	regcache_cache_only(ope->mbdrc_regmap, true);
 	regcache_cache_only(ope->peq_regmap, true);
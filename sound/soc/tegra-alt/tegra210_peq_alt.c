@@ -66,8 +66,6 @@ static const u32 biquad_init_shifts[TEGRA210_PEQ_SHIFT_PARAM_SIZE_PER_CH] = {
 	28, /* post-shift */
 };
 
-static s32 biquad_coeff_buffer[TEGRA210_PEQ_GAIN_PARAM_SIZE_PER_CH];
-
 static int tegra210_peq_get(struct snd_kcontrol *kcontrol,
 	struct snd_ctl_elem_value *ucontrol)
 {
@@ -106,20 +104,25 @@ static int tegra210_peq_put(struct snd_kcontrol *kcontrol,
 				(mask << mc->shift), val);
 }
 
+static u32 *tegra210_peq_ram_shadow(struct tegra210_ope *ope,
+				    struct tegra_soc_bytes *params)
+{
+	if (params->soc.base == TEGRA210_PEQ_AHUBRAMCTL_CONFIG_RAM_SHIFT_CTRL)
+		return ope->peq_biquad_shifts[params->shift /
+			TEGRA210_PEQ_SHIFT_PARAM_SIZE_PER_CH];
+
+	return ope->peq_biquad_gains[params->shift /
+		TEGRA210_PEQ_GAIN_PARAM_SIZE_PER_CH];
+}
+
 static int tegra210_peq_ahub_ram_get(struct snd_kcontrol *kcontrol,
 	struct snd_ctl_elem_value *ucontrol)
 {
 	struct tegra_soc_bytes *params = (void *)kcontrol->private_value;
 	struct snd_soc_codec *codec = snd_soc_kcontrol_codec(kcontrol);
 	struct tegra210_ope *ope = snd_soc_codec_get_drvdata(codec);
-	u32 i, reg_ctrl = params->soc.base;
-	u32 reg_data = reg_ctrl + codec->component.val_bytes;
-	s32 *data = (s32 *)biquad_coeff_buffer;
-
-	pm_runtime_get_sync(codec->dev);
-	tegra210_xbar_read_ahubram(ope->peq_regmap, reg_ctrl, reg_data,
-				    params->shift, data, params->soc.num_regs);
-	pm_runtime_put_sync(codec->dev);
+	s32 *data = (s32 *)tegra210_peq_ram_shadow(ope, params);
+	u32 i;
 
 	for (i = 0; i < params->soc.num_regs; i++)
 		ucontrol->value.integer.value[i] = (long)data[i];
@@ -135,17 +138,28 @@ static int tegra210_peq_ahub_ram_put(struct snd_kcontrol *kcontrol,
 	struct tegra210_ope *ope = snd_soc_codec_get_drvdata(codec);
 	u32 i, reg_ctrl = params->soc.base;
 	u32 reg_data = reg_ctrl + codec->component.val_bytes;
-	s32 *data = (s32 *)biquad_coeff_buffer;
+	s32 *data = (s32 *)tegra210_peq_ram_shadow(ope, params);
+	bool changed = false;
+
+	for (i = 0; i < params->soc.num_regs; i++) {
+		if (data[i] != (s32)ucontrol->value.integer.value[i]) {
+			data[i] = (s32)ucontrol->value.integer.value[i];
+			changed = true;
+		}
+	}
 
-	for (i = 0; i < params->soc.num_regs; i++)
-		data[i] = (s32)ucontrol->value.integer.value[i];
+	if (!changed)
+		return 0;
 
-	pm_runtime_get_sync(codec->dev);
-	tegra210_xbar_write_ahubram(ope->peq_regmap, reg_ctrl, reg_data,
-				    params->shift, data, params->soc.num_regs);
-	pm_runtime_put_sync(codec->dev);
+	/* a suspended OPE gets its RAM loaded from the shadow on resume */
+	if (pm_runtime_get_if_in_use(codec->dev) > 0) {
+		tegra210_xbar_write_ahubram(ope->peq_regmap, reg_ctrl,
+			reg_data, params->shift, (u32 *)data,
+			params->soc.num_regs);
+		pm_runtime_put(codec->dev);
+	}
 
-	return 0;
+	return 1;
 }
 
 static int tegra210_peq_param_info(struct snd_kcontrol *kcontrol,
@@ -279,52 +293,28 @@ static const struct regmap_config tegra210_peq_regmap_config = {
 	.cache_type = REGCACHE_FLAT,
 };
 
+/*
+ * The channels are contiguous in both RAMs, so each of them is loaded
+ * from its shadow with a single sequential access.
+ */
 void tegra210_peq_restore(struct tegra210_ope *ope)
 {
-	unsigned int i;
-
-	for (i = 0; i < TEGRA210_PEQ_MAX_CHANNELS; i++) {
-		tegra210_xbar_write_ahubram(ope->peq_regmap,
-			TEGRA210_PEQ_AHUBRAMCTL_CONFIG_RAM_CTRL,
-			TEGRA210_PEQ_AHUBRAMCTL_CONFIG_RAM_DATA,
-			(i * TEGRA210_PEQ_GAIN_PARAM_SIZE_PER_CH),
-			(u32 *)&ope->peq_biquad_gains,
-			TEGRA210_PEQ_GAIN_PARAM_SIZE_PER_CH);
-
-		tegra210_xbar_write_ahubram(ope->peq_regmap,
-			TEGRA210_PEQ_AHUBRAMCTL_CONFIG_RAM_SHIFT_CTRL,
-			TEGRA210_PEQ_AHUBRAMCTL_CONFIG_RAM_SHIFT_DATA,
-			(i * TEGRA210_PEQ_SHIFT_PARAM_SIZE_PER_CH),
-			(u32 *)&ope->peq_biquad_shifts,
-			TEGRA210_PEQ_SHIFT_PARAM_SIZE_PER_CH);
-
-	}
+	tegra210_xbar_write_ahubram(ope->peq_regmap,
+		TEGRA210_PEQ_AHUBRAMCTL_CONFIG_RAM_CTRL,
+		TEGRA210_PEQ_AHUBRAMCTL_CONFIG_RAM_DATA, 0,
+		&ope->peq_biquad_gains[0][0],
+		TEGRA210_PEQ_MAX_CHANNELS *
+		TEGRA210_PEQ_GAIN_PARAM_SIZE_PER_CH);
+
+	tegra210_xbar_write_ahubram(ope->peq_regmap,
+		TEGRA210_PEQ_AHUBRAMCTL_CONFIG_RAM_SHIFT_CTRL,
+		TEGRA210_PEQ_AHUBRAMCTL_CONFIG_RAM_SHIFT_DATA, 0,
+		&ope->peq_biquad_shifts[0][0],
+		TEGRA210_PEQ_MAX_CHANNELS *
+		TEGRA210_PEQ_SHIFT_PARAM_SIZE_PER_CH);
 }
 EXPORT_SYMBOL_GPL(tegra210_peq_restore);
 
-void tegra210_peq_save(struct tegra210_ope *ope)
-{
-	unsigned int i;
-
-	for (i = 0; i < TEGRA210_PEQ_MAX_CHANNELS; i++) {
-		tegra210_xbar_read_ahubram(ope->peq_regmap,
-			TEGRA210_PEQ_AHUBRAMCTL_CONFIG_RAM_CTRL,
-			TEGRA210_PEQ_AHUBRAMCTL_CONFIG_RAM_DATA,
-			(i * TEGRA210_PEQ_GAIN_PARAM_SIZE_PER_CH),
-			(u32 *)&ope->peq_biquad_gains,
-			TEGRA210_PEQ_GAIN_PARAM_SIZE_PER_CH);
-
-		tegra210_xbar_read_ahubram(ope->peq_regmap,
-			TEGRA210_PEQ_AHUBRAMCTL_CONFIG_RAM_SHIFT_CTRL,
-			TEGRA210_PEQ_AHUBRAMCTL_CONFIG_RAM_SHIFT_DATA,
-			(i * TEGRA210_PEQ_SHIFT_PARAM_SIZE_PER_CH),
-			(u32 *)&ope->peq_biquad_shifts,
-			TEGRA210_PEQ_SHIFT_PARAM_SIZE_PER_CH);
-
-	}
-}
-EXPORT_SYMBOL_GPL(tegra210_peq_save);
-
 int tegra210_peq_codec_init(struct snd_soc_codec *codec)
 {
 	struct tegra210_ope *ope = snd_soc_codec_get_drvdata(codec);
@@ -341,22 +331,12 @@ int tegra210_peq_codec_init(struct snd_soc_codec *codec)
 
 	/* Initialize PEQ AHUB RAM with default params */
 	for (i = 0; i < TEGRA210_PEQ_MAX_CHANNELS; i++) {
-		/* Set default gain params */
-		tegra210_xbar_write_ahubram(ope->peq_regmap,
-			TEGRA210_PEQ_AHUBRAMCTL_CONFIG_RAM_CTRL,
-			TEGRA210_PEQ_AHUBRAMCTL_CONFIG_RAM_DATA,
-			(i * TEGRA210_PEQ_GAIN_PARAM_SIZE_PER_CH),
-			(u32 *)&biquad_init_gains,
-			TEGRA210_PEQ_GAIN_PARAM_SIZE_PER_CH);
-
-		/* Set default shift params */
-		tegra210_xbar_write_ahubram(ope->peq_regmap,
-			TEGRA210_PEQ_AHUBRAMCTL_CONFIG_RAM_SHIFT_CTRL,
-			TEGRA210_PEQ_AHUBRAMCTL_CONFIG_RAM_SHIFT_DATA,
-			(i * TEGRA210_PEQ_SHIFT_PARAM_SIZE_PER_CH),
-			(u32 *)&biquad_init_shifts,
-			TEGRA210_PEQ_SHIFT_PARAM_SIZE_PER_CH);
+		memcpy(ope->peq_biquad_gains[i], biquad_init_gains,
+			sizeof(ope->peq_biquad_gains[i]));
+		memcpy(ope->peq_biquad_shifts[i], biquad_init_shifts,
+			sizeof(ope->peq_biquad_shifts[i]));
 	}
+	tegra210_peq_restore(ope);
 	pm_runtime_put_sync(codec->dev);
 
 	snd_soc_add_codec_controls(codec, tegra210_peq_controls,
@@ -2919,6 +2919,8 @@ static int tegra210_sfc_runtime_suspend(struct device *dev)
 
 	regcache_cache_only(sfc->regmap, true);
 	regcache_mark_dirty(sfc->regmap);
+	/* the coefficient RAM is not retained */
+	sfc->coeff_ram_loaded = NULL;
 
 	return 0;
 }
@@ -2942,10 +2944,14 @@ static int tegra210_sfc_write_coeff_ram(struct tegra210_sfc *sfc)
 		return -EINVAL;
 
 	if (coeff_ram) {
-		tegra210_xbar_write_ahubram(sfc->regmap,
-			TEGRA210_SFC_AHUBRAMCTL_SFC_CTRL,
-			TEGRA210_SFC_AHUBRAMCTL_SFC_DATA,
-			0, coeff_ram, TEGRA210_SFC_COEF_RAM_DEPTH);
+		/* same conversion as the last stream, skip the reload */
+		if (coeff_ram != sfc->coeff_ram_loaded) {
+			tegra210_xbar_write_ahubram(sfc->regmap,
+				TEGRA210_SFC_AHUBRAMCTL_SFC_CTRL,
+				TEGRA210_SFC_AHUBRAMCTL_SFC_DATA,
+				0, coeff_ram, TEGRA210_SFC_COEF_RAM_DEPTH);
+			sfc->coeff_ram_loaded = coeff_ram;
+		}
 
 		regmap_update_bits(sfc->regmap,
 			TEGRA210_SFC_COEF_RAM,
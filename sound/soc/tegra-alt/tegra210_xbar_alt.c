@@ -1244,9 +1244,61 @@ static struct of_dev_auxdata tegra186_xbar_auxdata[] = {
 	{}
 };
 
+/* modules between each endpoint and the source feeding it */
+static const struct snd_kcontrol_new tegra210_xbar_controls[] = {
+	ROUTE_HOPS_CTRL("ADMAIF1"),
+	ROUTE_HOPS_CTRL("ADMAIF2"),
+	ROUTE_HOPS_CTRL("ADMAIF3"),
+	ROUTE_HOPS_CTRL("ADMAIF4"),
+	ROUTE_HOPS_CTRL("ADMAIF5"),
+	ROUTE_HOPS_CTRL("ADMAIF6"),
+	ROUTE_HOPS_CTRL("ADMAIF7"),
+	ROUTE_HOPS_CTRL("ADMAIF8"),
+	ROUTE_HOPS_CTRL("ADMAIF9"),
+	ROUTE_HOPS_CTRL("ADMAIF10"),
+	ROUTE_HOPS_CTRL("I2S1"),
+	ROUTE_HOPS_CTRL("I2S2"),
+	ROUTE_HOPS_CTRL("I2S3"),
+	ROUTE_HOPS_CTRL("I2S4"),
+	ROUTE_HOPS_CTRL("I2S5"),
+};
+
+static const struct snd_kcontrol_new tegra186_xbar_controls[] = {
+	ROUTE_HOPS_CTRL("ADMAIF1"),
+	ROUTE_HOPS_CTRL("ADMAIF2"),
+	ROUTE_HOPS_CTRL("ADMAIF3"),
+	ROUTE_HOPS_CTRL("ADMAIF4"),
+	ROUTE_HOPS_CTRL("ADMAIF5"),
+	ROUTE_HOPS_CTRL("ADMAIF6"),
+	ROUTE_HOPS_CTRL("ADMAIF7"),
+	ROUTE_HOPS_CTRL("ADMAIF8"),
+	ROUTE_HOPS_CTRL("ADMAIF9"),
+	ROUTE_HOPS_CTRL("ADMAIF10"),
+	ROUTE_HOPS_CTRL("ADMAIF11"),
+	ROUTE_HOPS_CTRL("ADMAIF12"),
+	ROUTE_HOPS_CTRL("ADMAIF13"),
+	ROUTE_HOPS_CTRL("ADMAIF14"),
+	ROUTE_HOPS_CTRL("ADMAIF15"),
+	ROUTE_HOPS_CTRL("ADMAIF16"),
+	ROUTE_HOPS_CTRL("ADMAIF17"),
+	ROUTE_HOPS_CTRL("ADMAIF18"),
+	ROUTE_HOPS_CTRL("ADMAIF19"),
+	ROUTE_HOPS_CTRL("ADMAIF20"),
+	ROUTE_HOPS_CTRL("I2S1"),
+	ROUTE_HOPS_CTRL("I2S2"),
+	ROUTE_HOPS_CTRL("I2S3"),
+	ROUTE_HOPS_CTRL("I2S4"),
+	ROUTE_HOPS_CTRL("I2S5"),
+	ROUTE_HOPS_CTRL("I2S6"),
+	ROUTE_HOPS_CTRL("DSPK1"),
+	ROUTE_HOPS_CTRL("DSPK2"),
+};
+
 static struct snd_soc_codec_driver tegra210_xbar_codec = {
 	.idle_bias_off = 1,
 	.component_driver = {
+		.controls = tegra210_xbar_controls,
+		.num_controls = ARRAY_SIZE(tegra210_xbar_controls),
 		.dapm_widgets = tegra210_xbar_widgets,
 		.dapm_routes = tegra210_xbar_routes,
 		.num_dapm_widgets = ARRAY_SIZE(tegra210_xbar_widgets),
@@ -1257,6 +1309,8 @@ static struct snd_soc_codec_driver tegra210_xbar_codec = {
 static struct snd_soc_codec_driver tegra186_xbar_codec = {
 	.idle_bias_off = 1,
 	.component_driver = {
+		.controls = tegra186_xbar_controls,
+		.num_controls = ARRAY_SIZE(tegra186_xbar_controls),
 		.dapm_widgets = tegra186_xbar_widgets,
 		.dapm_routes = tegra186_xbar_routes,
 		.num_dapm_widgets = ARRAY_SIZE(tegra186_xbar_widgets),
@@ -113,23 +113,15 @@ int tegra210_xbar_read_reg (unsigned int reg, unsigned int *val)
 }
 EXPORT_SYMBOL_GPL(tegra210_xbar_read_reg);
 
-int tegra_xbar_get_value_enum(struct snd_kcontrol *kcontrol,
-			struct snd_ctl_elem_value *ucontrol)
+/* returns the enum item of the source selected in a mux, 0 is "None" */
+static unsigned int tegra_xbar_mux_item(struct snd_soc_codec *codec,
+					struct soc_enum *e)
 {
-	struct snd_soc_codec *codec = snd_soc_dapm_kcontrol_codec(kcontrol);
-	struct soc_enum *e = (struct soc_enum *)kcontrol->private_value;
-	unsigned int reg_count, reg_val, val, bit_pos = 0, i;
-	unsigned int reg[TEGRA_XBAR_UPDATE_MAX_REG];
+	unsigned int reg_val, val, bit_pos = 0, i;
 
-	reg_count = xbar->soc_data->reg_count;
-
-	if (reg_count > TEGRA_XBAR_UPDATE_MAX_REG)
-		return -EINVAL;
-
-	for (i = 0; i < reg_count; i++) {
-		reg[i] = (e->reg +
-			xbar->soc_data->reg_offset * i);
-		reg_val = snd_soc_read(codec, reg[i]);
+	for (i = 0; i < xbar->soc_data->reg_count; i++) {
+		reg_val = snd_soc_read(codec,
+				e->reg + xbar->soc_data->reg_offset * i);
 		val = reg_val & xbar->soc_data->mask[i];
 		if (val != 0) {
 			bit_pos = ffs(val) +
@@ -139,14 +131,26 @@ int tegra_xbar_get_value_enum(struct snd_kcontrol *kcontrol,
 	}
 
 	for (i = 0; i < e->items; i++) {
-		if (bit_pos == e->values[i]) {
-			ucontrol->value.enumerated.item[0] = i;
-			break;
-		}
+		if (bit_pos == e->values[i])
+			return i;
 	}
 
 	return 0;
 }
+
+int tegra_xbar_get_value_enum(struct snd_kcontrol *kcontrol,
+			struct snd_ctl_elem_value *ucontrol)
+{
+	struct snd_soc_codec *codec = snd_soc_dapm_kcontrol_codec(kcontrol);
+	struct soc_enum *e = (struct soc_enum *)kcontrol->private_value;
+
+	if (xbar->soc_data->reg_count > TEGRA_XBAR_UPDATE_MAX_REG)
+		return -EINVAL;
+
+	ucontrol->value.enumerated.item[0] = tegra_xbar_mux_item(codec, e);
+
+	return 0;
+}
 EXPORT_SYMBOL_GPL(tegra_xbar_get_value_enum);
 
 int tegra_xbar_put_value_enum(struct snd_kcontrol *kcontrol,
@@ -214,6 +218,90 @@ int tegra_xbar_put_value_enum(struct snd_kcontrol *kcontrol,
 }
 EXPORT_SYMBOL_GPL(tegra_xbar_put_value_enum);
 
+/*
+ * Number of XBAR hops from the source of a route to 'sink', following the
+ * muxes upstream. The inputs of a module are
+ * the muxes named after it, "SFC1 Mux" for SFC1 or "AMX1-1 Mux" ..
+ * "AMX1-4 Mux" for AMX1, and the longest of them is taken. Every module
+ * on the route adds the depth of its CIF FIFOs to the latency.
+ */
+static int tegra_xbar_route_hops(struct snd_soc_codec *codec,
+				 const char *sink, int depth)
+{
+	struct snd_soc_dapm_context *dapm = snd_soc_codec_get_dapm(codec);
+	struct snd_soc_dapm_widget *w;
+	int hops = 0, len;
+
+	if (depth >= TEGRA_XBAR_MAX_ROUTE_HOPS)
+		return depth;
+
+	/* the inputs of a multi stream module share its base name */
+	len = strcspn(sink, "-");
+
+	list_for_each_entry(w, &dapm->card->widgets, list) {
+		const char *source, *suffix;
+		unsigned int item;
+
+		if (w->dapm != dapm || w->id != snd_soc_dapm_mux ||
+		    !w->num_kcontrols || strncmp(w->name, sink, len))
+			continue;
+
+		suffix = w->name + len;
+		if (*suffix == '-')
+			suffix += strspn(suffix + 1, "0123456789") + 1;
+		if (strcmp(suffix, " Mux"))
+			continue;
+
+		item = tegra_xbar_mux_item(codec,
+			(struct soc_enum *)w->kcontrol_news[0].private_value);
+		if (!item)
+			continue;
+
+		source = ((struct soc_enum *)
+			  w->kcontrol_news[0].private_value)->texts[item];
+
+		/* ADMAIF and I2S outputs come from memory or the pins */
+		if (!strncmp(source, "ADMAIF", 6) || !strncmp(source, "I2S", 3))
+			hops = max(hops, 1);
+		else
+			hops = max(hops, 1 + tegra_xbar_route_hops(codec,
+							source, depth + 1));
+	}
+
+	return hops;
+}
+
+int tegra_xbar_route_hops_info(struct snd_kcontrol *kcontrol,
+			       struct snd_ctl_elem_info *uinfo)
+{
+	uinfo->type = SNDRV_CTL_ELEM_TYPE_INTEGER;
+	uinfo->count = 1;
+	uinfo->value.integer.min = 0;
+	uinfo->value.integer.max = TEGRA_XBAR_MAX_ROUTE_HOPS;
+
+	return 0;
+}
+EXPORT_SYMBOL_GPL(tegra_xbar_route_hops_info);
+
+int tegra_xbar_get_route_hops(struct snd_kcontrol *kcontrol,
+			      struct snd_ctl_elem_value *ucontrol)
+{
+	struct snd_soc_codec *codec = snd_soc_kcontrol_codec(kcontrol);
+	struct snd_soc_card *card = codec->component.card;
+	int hops;
+
+	mutex_lock_nested(&card->dapm_mutex, SND_SOC_DAPM_CLASS_RUNTIME);
+	/* the sink itself is not a hop */
+	hops = tegra_xbar_route_hops(codec,
+			(const char *)kcontrol->private_value, 0);
+	mutex_unlock(&card->dapm_mutex);
+
+	ucontrol->value.integer.value[0] = hops ? hops - 1 : 0;
+
+	return 0;
+}
+EXPORT_SYMBOL_GPL(tegra_xbar_get_route_hops);
+
 bool tegra_xbar_volatile_reg(struct device *dev, unsigned int reg)
 {
 	return false;
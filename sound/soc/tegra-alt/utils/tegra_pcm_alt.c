@@ -30,6 +30,7 @@
  */
 #include <linux/dma-mapping.h>
 #include <linux/module.h>
+#include <linux/platform/tegra/ptp-notifier.h>
 #include <sound/pcm.h>
 #include <sound/pcm_params.h>
 #include <sound/soc.h>
@@ -42,7 +43,9 @@ static const struct snd_pcm_hardware tegra_alt_pcm_hardware = {
 				  SNDRV_PCM_INFO_MMAP_VALID |
 				  SNDRV_PCM_INFO_PAUSE |
 				  SNDRV_PCM_INFO_RESUME |
-				  SNDRV_PCM_INFO_INTERLEAVED,
+				  SNDRV_PCM_INFO_INTERLEAVED |
+				  SNDRV_PCM_INFO_NO_PERIOD_WAKEUP |
+				  SNDRV_PCM_INFO_HAS_LINK_ABSOLUTE_ATIME,
 	.formats		= SNDRV_PCM_FMTBIT_S8 |
 				  SNDRV_PCM_FMTBIT_S16_LE |
 				  SNDRV_PCM_FMTBIT_S24_LE |
@@ -71,10 +74,17 @@ static int tegra_alt_pcm_open(struct snd_pcm_substream *substream)
 	/* Set HW params now that initialization is complete */
 	snd_soc_set_runtime_hwparams(substream, &tegra_alt_pcm_hardware);
 
-	/* Update buffer size from device tree */
+	/*
+	 * Update buffer size from device tree. Periods can then be as large
+	 * as half the buffer, with fewer interrupts for long captures.
+	 */
 	if (dmap->buffer_size > substream->runtime->hw.buffer_bytes_max) {
 		substream->runtime->hw.buffer_bytes_max = dmap->buffer_size;
 		substream->runtime->hw.period_bytes_max = dmap->buffer_size / 2;
+		substream->runtime->hw.periods_max =
+			max_t(unsigned int, tegra_alt_pcm_hardware.periods_max,
+			      dmap->buffer_size /
+			      tegra_alt_pcm_hardware.period_bytes_max);
 	}
 
 	/* Ensure period size is multiple of 8 */
@@ -213,6 +223,39 @@ static snd_pcm_uframes_t tegra_alt_pcm_pointer
 	return pos;
 }
 
+/*
+ * The link absolute audio timestamp is the PTP time at which hw_ptr was
+ * sampled, i.e. at DMA completion for the period updates. Together with
+ * the system timestamp taken next to it, this places every period in
+ * the PTP timebase used by the network and video capture paths.
+ */
+static int tegra_alt_pcm_get_time_info(struct snd_pcm_substream *substream,
+			struct timespec *system_ts, struct timespec *audio_ts,
+			struct snd_pcm_audio_tstamp_config *audio_tstamp_config,
+			struct snd_pcm_audio_tstamp_report *audio_tstamp_report)
+{
+	struct snd_pcm_runtime *runtime = substream->runtime;
+	u64 ns;
+
+	if (audio_tstamp_config->type_requested ==
+			SNDRV_PCM_AUDIO_TSTAMP_TYPE_LINK_ABSOLUTE &&
+	    !get_ptp_hwtime(&ns)) {
+		snd_pcm_gettime(runtime, system_ts);
+		*audio_ts = ns_to_timespec(ns);
+
+		audio_tstamp_report->actual_type =
+			SNDRV_PCM_AUDIO_TSTAMP_TYPE_LINK_ABSOLUTE;
+		audio_tstamp_report->accuracy_report = 0;
+		audio_tstamp_report->accuracy = 0;
+		return 0;
+	}
+
+	/* no PTP time source, let the core derive it from hw_ptr */
+	audio_tstamp_report->actual_type = SNDRV_PCM_AUDIO_TSTAMP_TYPE_DEFAULT;
+
+	return 0;
+}
+
 static struct snd_pcm_ops tegra_alt_pcm_ops = {
 	.open		= tegra_alt_pcm_open,
 	.close		= tegra_alt_pcm_close,
@@ -222,6 +265,7 @@ static struct snd_pcm_ops tegra_alt_pcm_ops = {
 	.trigger	= snd_dmaengine_pcm_trigger,
 	.pointer	= tegra_alt_pcm_pointer,
 	.mmap		= tegra_alt_pcm_mmap,
+	.get_time_info	= tegra_alt_pcm_get_time_info,
 };
 
 static int tegra_alt_pcm_preallocate_dma_buffer(struct snd_pcm *pcm,
@@ -1,7 +1,7 @@
 /*
  * IVC based library for AUDIO server
  *
- * Copyright (c) 2015-2019, NVIDIA CORPORATION.  All rights reserved.
+ * Copyright (c) 2015-2021, NVIDIA CORPORATION.  All rights reserved.
  *
  * This program is free software; you can redistribute it and/or modify it
  * under the terms and conditions of the GNU General Public License,
@@ -20,6 +20,7 @@
 #include <linux/sched.h>
 #include <linux/delay.h>
 #include <linux/tegra-ivc.h>
+#include <linux/tegra-ivc-batch.h>
 #include <linux/spinlock.h>
 #include <linux/hardirq.h>
 #include <linux/interrupt.h>
@@ -33,44 +34,142 @@ static struct nvaudio_ivc_ctxt *saved_ivc_ctxt;
 static void nvaudio_ivc_deinit(struct nvaudio_ivc_ctxt *ictxt);
 static int nvaudio_ivc_init(struct nvaudio_ivc_ctxt *ictxt);
 
+static int nvaudio_ivc_channel_ready(struct nvaudio_ivc_ctxt *ictxt)
+{
+	int dcnt = 50;
+
+	while (tegra_hv_ivc_channel_notified(ictxt->ivck) != 0) {
+		dev_err(ictxt->dev, "channel notified returns non zero\n");
+		dcnt--;
+		udelay(100);
+		if (!dcnt)
+			return -EIO;
+	}
+
+	return 0;
+}
+
+/*
+ * PCM triggers run under the stream lock with interrupts disabled, control
+ * updates from user space can sleep.
+ */
+static bool nvaudio_ivc_can_sleep(void)
+{
+	return !irqs_disabled() && !in_atomic();
+}
+
+/*
+ * Wait for room in the tx queue. The server notifies when a full queue
+ * gets a free frame again, atomic callers spin a bounded time instead.
+ */
+static int nvaudio_ivc_wait_tx(struct nvaudio_ivc_ctxt *ictxt)
+{
+	int dcnt = 50;
+
+	if (nvaudio_ivc_can_sleep()) {
+		if (!wait_event_timeout(ictxt->wait,
+				tegra_hv_ivc_can_write(ictxt->ivck),
+				msecs_to_jiffies(ictxt->timeout)))
+			return -ETIMEDOUT;
+		return 0;
+	}
+
+	while (!tegra_hv_ivc_can_write(ictxt->ivck)) {
+		if (!dcnt--)
+			return -ETIMEDOUT;
+		udelay(100);
+	}
+
+	return 0;
+}
+
+static irqreturn_t nvaudio_ivc_irq(int irq, void *data)
+{
+	struct nvaudio_ivc_ctxt *ictxt = data;
+
+	wake_up_all(&ictxt->wait);
+
+	return IRQ_HANDLED;
+}
+
 int nvaudio_ivc_send_retry(struct nvaudio_ivc_ctxt *ictxt,
 		struct nvaudio_ivc_msg *msg, int size)
 {
 	int err = 0;
-	int dcnt = 50;
 
 	if (!ictxt || !ictxt->ivck || !msg || !size)
 		return -EINVAL;
 
 	err = nvaudio_ivc_send(ictxt, msg, size);
 
-	while (err < 0 && dcnt--) {
-		udelay(100);
+	while (err == -EBUSY) {
+		err = nvaudio_ivc_wait_tx(ictxt);
+		if (err < 0)
+			return err;
 		err = nvaudio_ivc_send(ictxt, msg, size);
 	}
-	return (dcnt < 0) ? -ETIMEDOUT : err;
+	return err;
 
 }
 EXPORT_SYMBOL_GPL(nvaudio_ivc_send_retry);
 
+/*
+ * Send messages that need no reply. They are written to the queue in as
+ * few batches as there is room for, each one raising a single notification
+ * to the server. Returns the number of messages sent.
+ */
+int nvaudio_ivc_send_batch(struct nvaudio_ivc_ctxt *ictxt,
+		struct nvaudio_ivc_msg *msgs, int count)
+{
+	unsigned long flags = 0;
+	int sent = 0;
+	int err;
+
+	if (!ictxt || !ictxt->ivck || !msgs || count <= 0)
+		return -EINVAL;
+
+	err = nvaudio_ivc_channel_ready(ictxt);
+	if (err < 0)
+		return err;
+
+	while (sent < count) {
+		spin_lock_irqsave(&ictxt->ivck_tx_lock, flags);
+		err = tegra_hv_ivc_write_batch(ictxt->ivck, msgs + sent,
+				sizeof(*msgs), count - sent);
+		spin_unlock_irqrestore(&ictxt->ivck_tx_lock, flags);
+
+		if (err == -ENOMEM) {
+			/* queue full */
+			err = nvaudio_ivc_wait_tx(ictxt);
+			if (err < 0)
+				return err;
+			continue;
+		}
+		if (err < 0) {
+			pr_err("%s: write Error\n", __func__);
+			return err;
+		}
+
+		sent += err;
+	}
+
+	return sent;
+}
+EXPORT_SYMBOL_GPL(nvaudio_ivc_send_batch);
+
 int nvaudio_ivc_send(struct nvaudio_ivc_ctxt *ictxt,
 		struct nvaudio_ivc_msg *msg, int size)
 {
 	int len = 0;
 	unsigned long flags = 0;
 	int err = 0;
-	int dcnt = 50;
 
 	if (!ictxt || !ictxt->ivck || !msg || !size)
 		return -EINVAL;
 
-	while (tegra_hv_ivc_channel_notified(ictxt->ivck) != 0) {
-		dev_err(ictxt->dev, "channel notified returns non zero\n");
-		dcnt--;
-		udelay(100);
-		if (!dcnt)
-			return -EIO;
-	}
+	err = nvaudio_ivc_channel_ready(ictxt);
+	if (err < 0)
+		return err;
 
 	spin_lock_irqsave(&ictxt->ivck_tx_lock, flags);
 
@@ -101,20 +200,15 @@ int nvaudio_ivc_send_receive(struct nvaudio_ivc_ctxt *ictxt,
 	int len = 0;
 	unsigned long flags = 0, flags1 = 0;
 	int err = 0;
-	int dcnt = 50;
 	int status = -1;
 	struct nvaudio_ivc_msg *msg = rx_msg;
 
 	if (!ictxt || !ictxt->ivck || !msg || !size)
 		return -EINVAL;
 
-	while (tegra_hv_ivc_channel_notified(ictxt->ivck) != 0) {
-		dev_err(ictxt->dev, "channel notified returns non zero\n");
-		dcnt--;
-		udelay(100);
-		if (!dcnt)
-			return -EIO;
-	}
+	err = nvaudio_ivc_channel_ready(ictxt);
+	if (err < 0)
+		return err;
 
 	spin_lock_irqsave(&ictxt->ivck_rx_lock, flags);
 	spin_lock_irqsave(&ictxt->ivck_tx_lock, flags1);
@@ -183,15 +277,16 @@ struct nvaudio_ivc_ctxt *nvaudio_ivc_alloc_ctxt(struct device *dev)
 
 	saved_ivc_ctxt = ictxt;
 	ictxt->dev = dev;
-	ictxt->timeout = 250; /* Not used in polling */
+	ictxt->timeout = 250; /* msecs, when waiting for a notification */
+	init_waitqueue_head(&ictxt->wait);
+	spin_lock_init(&ictxt->ivck_rx_lock);
+	spin_lock_init(&ictxt->ivck_tx_lock);
+
 	if (nvaudio_ivc_init(ictxt) != 0) {
 		dev_err(dev, "nvaudio_ivc_init failed\n");
 		goto fail;
 	}
 
-	spin_lock_init(&ictxt->ivck_rx_lock);
-	spin_lock_init(&ictxt->ivck_tx_lock);
-
 	tegra_hv_ivc_channel_reset(ictxt->ivck);
 
 	return ictxt;
@@ -214,8 +309,10 @@ EXPORT_SYMBOL_GPL(nvaudio_ivc_free_ctxt);
 
 static void nvaudio_ivc_deinit(struct nvaudio_ivc_ctxt *ictxt)
 {
-	if (ictxt)
+	if (ictxt && ictxt->ivck) {
+		free_irq(ictxt->ivck->irq, ictxt);
 		tegra_hv_ivc_unreserve(ictxt->ivck);
+	}
 }
 
 static int nvaudio_ivc_init(struct nvaudio_ivc_ctxt *ictxt)
@@ -256,6 +353,15 @@ static int nvaudio_ivc_init(struct nvaudio_ivc_ctxt *ictxt)
 
 	of_node_put(hv_dn);
 
+	/* only used to wake up senders waiting for room in the queue */
+	err = request_irq(ivck->irq, nvaudio_ivc_irq, 0, dev_name(dev),
+			ictxt);
+	if (err != 0) {
+		dev_err(dev, "Failed to request irq %d\n", ivck->irq);
+		tegra_hv_ivc_unreserve(ivck);
+		return err;
+	}
+
 	ictxt->ivc_queue = ivc_queue;
 	ictxt->ivck = ivck;
 
@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2015-2019 NVIDIA CORPORATION.  All rights reserved.
+ * Copyright (c) 2015-2021 NVIDIA CORPORATION.  All rights reserved.
  *
  * This program is free software; you can redistribute it and/or modify it
  * under the terms and conditions of the GNU General Public License,
@@ -49,6 +49,10 @@ int nvaudio_ivc_send_retry(struct nvaudio_ivc_ctxt *ictxt,
 				struct nvaudio_ivc_msg *msg,
 				int size);
 
+int nvaudio_ivc_send_batch(struct nvaudio_ivc_ctxt *ictxt,
+				struct nvaudio_ivc_msg *msgs,
+				int count);
+
 int nvaudio_ivc_send_receive(struct nvaudio_ivc_ctxt *ictxt,
 				struct nvaudio_ivc_msg *msg,
 				int size);
@@ -10,6 +10,7 @@
  *
  * Example Usage:
  *	tegra_gte_mon -d <device> -g <global gpio pin> -r -f
+ *	tegra_gte_mon -d <device> -g <global gpio pin> -b -c 100000
  */
 
 #include <unistd.h>
@@ -23,14 +24,110 @@
 #include <fcntl.h>
 #include <getopt.h>
 #include <inttypes.h>
+#include <time.h>
 #include <sys/ioctl.h>
+#include <sys/mman.h>
 #include <sys/types.h>
 #include <linux/tegra-gte-ioctl.h>
 
+/* events ring mapped in benchmark mode */
+#define RING_SIZE	(64 * 1024)
+
+static uint64_t now_ns(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC_RAW, &ts);
+	return ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+/*
+ * Drain the mmap'd event ring as it fills. GTE timestamps and
+ * CLOCK_MONOTONIC_RAW count the same system counter from different origins,
+ * so delivery latency is reported above the lowest one seen.
+ */
+int benchmark_event(int fd, unsigned int loops)
+{
+	struct tegra_gte_hts_ring *ring;
+	struct pollfd pfd = { .fd = fd, .events = POLLIN };
+	uint64_t start = 0, end = 0, offset = UINT64_MAX;
+	uint64_t events = 0, wakeups = 0, lat_sum = 0;
+	int64_t *lat;
+	uint32_t head, tail;
+	unsigned int n = loops ? loops : 100000;
+	unsigned int i;
+	uint64_t lat_max = 0;
+	int ret = 0;
+
+	lat = calloc(n, sizeof(*lat));
+	if (!lat)
+		return -ENOMEM;
+
+	ring = mmap(NULL, RING_SIZE, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	if (ring == MAP_FAILED) {
+		ret = -errno;
+		perror("Failed to map event ring");
+		free(lat);
+		return ret;
+	}
+
+	fprintf(stdout, "Benchmarking %u events, ring of %u\n", n,
+		ring->entries);
+
+	tail = ring->tail;
+	while (events < n) {
+		if (poll(&pfd, 1, -1) == -1) {
+			if (errno == EINTR)
+				continue;
+			ret = -errno;
+			perror("Failed to poll event");
+			break;
+		}
+
+		end = now_ns();
+		if (!start)
+			start = end;
+		wakeups++;
+
+		head = __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE);
+		for (; tail != head && events < n; tail++, events++) {
+			lat[events] = end - ring->events[tail %
+						ring->entries].timestamp;
+			if ((uint64_t)lat[events] < offset)
+				offset = lat[events];
+		}
+		__atomic_store_n(&ring->tail, tail, __ATOMIC_RELEASE);
+	}
+
+	for (i = 0; i < events; i++) {
+		lat[i] -= offset;
+		lat_sum += lat[i];
+		if ((uint64_t)lat[i] > lat_max)
+			lat_max = lat[i];
+	}
+
+	if (events > 1 && end > start)
+		fprintf(stdout, "%" PRIu64 " events in %" PRIu64 " us, "
+			"%" PRIu64 " events/s\n", events, (end - start) / 1000,
+			events * UINT64_C(1000000000) / (end - start));
+	if (events) {
+		fprintf(stdout, "%" PRIu64 " wakeups, %.1f events/wakeup\n",
+			wakeups, (double)events / wakeups);
+		fprintf(stdout, "latency above best: avg %" PRIu64
+			" ns, max %" PRIu64 " ns\n", lat_sum / events, lat_max);
+	}
+	fprintf(stdout, "overflow: %u\n", ring->overflow);
+
+	munmap(ring, RING_SIZE);
+	free(lat);
+	return ret;
+}
+
 int monitor_device(const char *device_name,
 		   unsigned int gnum,
 		   unsigned int eventflags,
-		   unsigned int loops)
+		   unsigned int loops,
+		   bool benchmark)
 {
 	struct tegra_gte_hts_event_req req = {0};
 	struct tegra_gte_hts_event_data event;
@@ -64,6 +161,12 @@ int monitor_device(const char *device_name,
 
 	fprintf(stdout, "Monitoring line %d on %s\n", gnum, device_name);
 
+	if (benchmark) {
+		ret = benchmark_event(req.fd, loops);
+		close(req.fd);
+		goto exit_close_error;
+	}
+
 	while (1) {
 		ret = read(req.fd, &event, sizeof(event));
 		if (ret == -1) {
@@ -108,6 +211,8 @@ void print_usage(char *bin_name)
 		"  -r         Listen for rising edges\n"
 		"  -f         Listen for falling edges\n"
 		" [-c <n>]    Do <n> loops (optional, infinite loop if not stated)\n"
+		" [-b]        Benchmark the mmap'd event ring, over <n> events\n"
+		"             (100000 if not stated)\n"
 		"  -h         This helptext\n"
 		"\n"
 		"Example:\n"
@@ -123,10 +228,14 @@ int main(int argc, char **argv)
 	unsigned int gnum = -1;
 	unsigned int loops = 0;
 	unsigned int eventflags = 0;
+	bool benchmark = false;
 	int c;
 
-	while ((c = getopt(argc, argv, "c:g:d:rfh")) != -1) {
+	while ((c = getopt(argc, argv, "c:g:d:rfbh")) != -1) {
 		switch (c) {
+		case 'b':
+			benchmark = true;
+			break;
 		case 'c':
 			loops = strtoul(optarg, NULL, 10);
 			break;
@@ -158,5 +267,5 @@ int main(int argc, char **argv)
 		       "falling edges\n");
 		eventflags = TEGRA_GTE_EVENT_REQ_BOTH_EDGES;
 	}
-	return monitor_device(device_name, gnum, eventflags, loops);
+	return monitor_device(device_name, gnum, eventflags, loops, benchmark);
 }